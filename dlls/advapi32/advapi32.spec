@@ -289,7 +289,7 @@
 # @ stub EventAccessRemove
 @ stdcall EventActivityIdControl(long ptr)
 @ stdcall EventEnabled(int64 ptr) ntdll.EtwEventEnabled
-@ stdcall EventProviderEnabled(int64 long int64)
+@ stdcall EventProviderEnabled(int64 long int64) ntdll.EtwEventProviderEnabled
 @ stdcall EventRegister(ptr ptr ptr ptr) ntdll.EtwEventRegister
 @ stdcall EventSetInformation(int64 long ptr long) ntdll.EtwEventSetInformation
 @ stdcall EventUnregister(int64) ntdll.EtwEventUnregister
@@ -298,7 +298,7 @@
 # @ stub EventWriteEx
 # @ stub EventWriteStartScenario
 # @ stub EventWriteString
-@ stdcall EventWriteTransfer(int64 ptr ptr ptr long ptr)
+@ stdcall EventWriteTransfer(int64 ptr ptr ptr long ptr) ntdll.EtwEventWriteTransfer
 @ stdcall FileEncryptionStatusA(str ptr)
 @ stdcall FileEncryptionStatusW(wstr ptr)
 @ stdcall FindFirstFreeAce(ptr ptr)
@@ -20,6 +20,8 @@
 /* Based on public domain implementation from
    https://git.musl-libc.org/cgit/musl/tree/src/crypt/crypt_sha256.c */
 
+#include "config.h"
+
 #include "bcrypt_internal.h"
 
 static DWORD ror(DWORD n, int k) { return (n >> k) | (n << (32-k)); }
@@ -30,7 +32,7 @@ static DWORD ror(DWORD n, int k) { return (n >> k) | (n << (32-k)); }
 #define R0(x)      (ror(x,7) ^ ror(x,18) ^ (x>>3))
 #define R1(x)      (ror(x,17) ^ ror(x,19) ^ (x>>10))
 
-static const DWORD K[64] =
+static const DWORD DECLSPEC_ALIGN(16) K[64] =
 {
   0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
   0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
@@ -91,6 +93,244 @@ static void processblock(SHA256_CTX *ctx, const UCHAR *buffer)
     ctx->h[7] += h;
 }
 
+#ifdef __x86_64__
+
+extern void CDECL sha256_ni_blocks( DWORD *h, const UCHAR *buffer, ULONG count, const DWORD *k );
+__ASM_GLOBAL_FUNC( sha256_ni_blocks,
+                   "subq $0x58,%rsp\n\t"
+                   __ASM_CFI(".cfi_adjust_cfa_offset 0x58\n\t")
+                   "movdqa %xmm6,0x00(%rsp)\n\t"
+                   "movdqa %xmm7,0x10(%rsp)\n\t"
+                   "movdqa %xmm8,0x20(%rsp)\n\t"
+                   "movdqa %xmm9,0x30(%rsp)\n\t"
+                   "movdqa %xmm10,0x40(%rsp)\n\t"
+                   /* rearrange the state into the ABEF/CDGH layout used by sha256rnds2 */
+                   "movdqu 0(%rcx),%xmm1\n\t"
+                   "movdqu 16(%rcx),%xmm2\n\t"
+                   "pshufd $0xb1,%xmm1,%xmm1\n\t"
+                   "pshufd $0x1b,%xmm2,%xmm2\n\t"
+                   "movdqa %xmm1,%xmm7\n\t"
+                   "palignr $8,%xmm2,%xmm1\n\t"
+                   "pblendw $0xf0,%xmm7,%xmm2\n\t"
+                   /* byte swap mask for the big-endian message words */
+                   "movabsq $0x0405060700010203,%rax\n\t"
+                   "movq %rax,%xmm8\n\t"
+                   "movabsq $0x0c0d0e0f08090a0b,%rax\n\t"
+                   "pinsrq $1,%rax,%xmm8\n"
+                   "1:\tmovdqa %xmm1,%xmm9\n\t"
+                   "movdqa %xmm2,%xmm10\n\t"
+                   "movdqu 0(%rdx),%xmm0\n\t"
+                   "pshufb %xmm8,%xmm0\n\t"
+                   "movdqa %xmm0,%xmm3\n\t"
+                   "paddd 0(%r9),%xmm0\n\t"
+                   "sha256rnds2 %xmm1,%xmm2\n\t"
+                   "pshufd $0x0e,%xmm0,%xmm0\n\t"
+                   "sha256rnds2 %xmm2,%xmm1\n\t"
+                   "movdqu 16(%rdx),%xmm0\n\t"
+                   "pshufb %xmm8,%xmm0\n\t"
+                   "movdqa %xmm0,%xmm4\n\t"
+                   "paddd 16(%r9),%xmm0\n\t"
+                   "sha256rnds2 %xmm1,%xmm2\n\t"
+                   "pshufd $0x0e,%xmm0,%xmm0\n\t"
+                   "sha256rnds2 %xmm2,%xmm1\n\t"
+                   "sha256msg1 %xmm4,%xmm3\n\t"
+                   "movdqu 32(%rdx),%xmm0\n\t"
+                   "pshufb %xmm8,%xmm0\n\t"
+                   "movdqa %xmm0,%xmm5\n\t"
+                   "paddd 32(%r9),%xmm0\n\t"
+                   "sha256rnds2 %xmm1,%xmm2\n\t"
+                   "pshufd $0x0e,%xmm0,%xmm0\n\t"
+                   "sha256rnds2 %xmm2,%xmm1\n\t"
+                   "sha256msg1 %xmm5,%xmm4\n\t"
+                   "movdqu 48(%rdx),%xmm0\n\t"
+                   "pshufb %xmm8,%xmm0\n\t"
+                   "movdqa %xmm0,%xmm6\n\t"
+                   "paddd 48(%r9),%xmm0\n\t"
+                   "sha256rnds2 %xmm1,%xmm2\n\t"
+                   "movdqa %xmm6,%xmm7\n\t"
+                   "palignr $4,%xmm5,%xmm7\n\t"
+                   "paddd %xmm7,%xmm3\n\t"
+                   "sha256msg2 %xmm6,%xmm3\n\t"
+                   "pshufd $0x0e,%xmm0,%xmm0\n\t"
+                   "sha256rnds2 %xmm2,%xmm1\n\t"
+                   "sha256msg1 %xmm6,%xmm5\n\t"
+                   "movdqa %xmm3,%xmm0\n\t"
+                   "paddd 64(%r9),%xmm0\n\t"
+                   "sha256rnds2 %xmm1,%xmm2\n\t"
+                   "movdqa %xmm3,%xmm7\n\t"
+                   "palignr $4,%xmm6,%xmm7\n\t"
+                   "paddd %xmm7,%xmm4\n\t"
+                   "sha256msg2 %xmm3,%xmm4\n\t"
+                   "pshufd $0x0e,%xmm0,%xmm0\n\t"
+                   "sha256rnds2 %xmm2,%xmm1\n\t"
+                   "sha256msg1 %xmm3,%xmm6\n\t"
+                   "movdqa %xmm4,%xmm0\n\t"
+                   "paddd 80(%r9),%xmm0\n\t"
+                   "sha256rnds2 %xmm1,%xmm2\n\t"
+                   "movdqa %xmm4,%xmm7\n\t"
+                   "palignr $4,%xmm3,%xmm7\n\t"
+                   "paddd %xmm7,%xmm5\n\t"
+                   "sha256msg2 %xmm4,%xmm5\n\t"
+                   "pshufd $0x0e,%xmm0,%xmm0\n\t"
+                   "sha256rnds2 %xmm2,%xmm1\n\t"
+                   "sha256msg1 %xmm4,%xmm3\n\t"
+                   "movdqa %xmm5,%xmm0\n\t"
+                   "paddd 96(%r9),%xmm0\n\t"
+                   "sha256rnds2 %xmm1,%xmm2\n\t"
+                   "movdqa %xmm5,%xmm7\n\t"
+                   "palignr $4,%xmm4,%xmm7\n\t"
+                   "paddd %xmm7,%xmm6\n\t"
+                   "sha256msg2 %xmm5,%xmm6\n\t"
+                   "pshufd $0x0e,%xmm0,%xmm0\n\t"
+                   "sha256rnds2 %xmm2,%xmm1\n\t"
+                   "sha256msg1 %xmm5,%xmm4\n\t"
+                   "movdqa %xmm6,%xmm0\n\t"
+                   "paddd 112(%r9),%xmm0\n\t"
+                   "sha256rnds2 %xmm1,%xmm2\n\t"
+                   "movdqa %xmm6,%xmm7\n\t"
+                   "palignr $4,%xmm5,%xmm7\n\t"
+                   "paddd %xmm7,%xmm3\n\t"
+                   "sha256msg2 %xmm6,%xmm3\n\t"
+                   "pshufd $0x0e,%xmm0,%xmm0\n\t"
+                   "sha256rnds2 %xmm2,%xmm1\n\t"
+                   "sha256msg1 %xmm6,%xmm5\n\t"
+                   "movdqa %xmm3,%xmm0\n\t"
+                   "paddd 128(%r9),%xmm0\n\t"
+                   "sha256rnds2 %xmm1,%xmm2\n\t"
+                   "movdqa %xmm3,%xmm7\n\t"
+                   "palignr $4,%xmm6,%xmm7\n\t"
+                   "paddd %xmm7,%xmm4\n\t"
+                   "sha256msg2 %xmm3,%xmm4\n\t"
+                   "pshufd $0x0e,%xmm0,%xmm0\n\t"
+                   "sha256rnds2 %xmm2,%xmm1\n\t"
+                   "sha256msg1 %xmm3,%xmm6\n\t"
+                   "movdqa %xmm4,%xmm0\n\t"
+                   "paddd 144(%r9),%xmm0\n\t"
+                   "sha256rnds2 %xmm1,%xmm2\n\t"
+                   "movdqa %xmm4,%xmm7\n\t"
+                   "palignr $4,%xmm3,%xmm7\n\t"
+                   "paddd %xmm7,%xmm5\n\t"
+                   "sha256msg2 %xmm4,%xmm5\n\t"
+                   "pshufd $0x0e,%xmm0,%xmm0\n\t"
+                   "sha256rnds2 %xmm2,%xmm1\n\t"
+                   "sha256msg1 %xmm4,%xmm3\n\t"
+                   "movdqa %xmm5,%xmm0\n\t"
+                   "paddd 160(%r9),%xmm0\n\t"
+                   "sha256rnds2 %xmm1,%xmm2\n\t"
+                   "movdqa %xmm5,%xmm7\n\t"
+                   "palignr $4,%xmm4,%xmm7\n\t"
+                   "paddd %xmm7,%xmm6\n\t"
+                   "sha256msg2 %xmm5,%xmm6\n\t"
+                   "pshufd $0x0e,%xmm0,%xmm0\n\t"
+                   "sha256rnds2 %xmm2,%xmm1\n\t"
+                   "sha256msg1 %xmm5,%xmm4\n\t"
+                   "movdqa %xmm6,%xmm0\n\t"
+                   "paddd 176(%r9),%xmm0\n\t"
+                   "sha256rnds2 %xmm1,%xmm2\n\t"
+                   "movdqa %xmm6,%xmm7\n\t"
+                   "palignr $4,%xmm5,%xmm7\n\t"
+                   "paddd %xmm7,%xmm3\n\t"
+                   "sha256msg2 %xmm6,%xmm3\n\t"
+                   "pshufd $0x0e,%xmm0,%xmm0\n\t"
+                   "sha256rnds2 %xmm2,%xmm1\n\t"
+                   "sha256msg1 %xmm6,%xmm5\n\t"
+                   "movdqa %xmm3,%xmm0\n\t"
+                   "paddd 192(%r9),%xmm0\n\t"
+                   "sha256rnds2 %xmm1,%xmm2\n\t"
+                   "movdqa %xmm3,%xmm7\n\t"
+                   "palignr $4,%xmm6,%xmm7\n\t"
+                   "paddd %xmm7,%xmm4\n\t"
+                   "sha256msg2 %xmm3,%xmm4\n\t"
+                   "pshufd $0x0e,%xmm0,%xmm0\n\t"
+                   "sha256rnds2 %xmm2,%xmm1\n\t"
+                   "sha256msg1 %xmm3,%xmm6\n\t"
+                   "movdqa %xmm4,%xmm0\n\t"
+                   "paddd 208(%r9),%xmm0\n\t"
+                   "sha256rnds2 %xmm1,%xmm2\n\t"
+                   "movdqa %xmm4,%xmm7\n\t"
+                   "palignr $4,%xmm3,%xmm7\n\t"
+                   "paddd %xmm7,%xmm5\n\t"
+                   "sha256msg2 %xmm4,%xmm5\n\t"
+                   "pshufd $0x0e,%xmm0,%xmm0\n\t"
+                   "sha256rnds2 %xmm2,%xmm1\n\t"
+                   "movdqa %xmm5,%xmm0\n\t"
+                   "paddd 224(%r9),%xmm0\n\t"
+                   "sha256rnds2 %xmm1,%xmm2\n\t"
+                   "movdqa %xmm5,%xmm7\n\t"
+                   "palignr $4,%xmm4,%xmm7\n\t"
+                   "paddd %xmm7,%xmm6\n\t"
+                   "sha256msg2 %xmm5,%xmm6\n\t"
+                   "pshufd $0x0e,%xmm0,%xmm0\n\t"
+                   "sha256rnds2 %xmm2,%xmm1\n\t"
+                   "movdqa %xmm6,%xmm0\n\t"
+                   "paddd 240(%r9),%xmm0\n\t"
+                   "sha256rnds2 %xmm1,%xmm2\n\t"
+                   "pshufd $0x0e,%xmm0,%xmm0\n\t"
+                   "sha256rnds2 %xmm2,%xmm1\n\t"
+                   "paddd %xmm9,%xmm1\n\t"
+                   "paddd %xmm10,%xmm2\n\t"
+                   "addq $64,%rdx\n\t"
+                   "decl %r8d\n\t"
+                   "jnz 1b\n\t"
+                   "pshufd $0x1b,%xmm1,%xmm1\n\t"
+                   "pshufd $0xb1,%xmm2,%xmm2\n\t"
+                   "movdqa %xmm1,%xmm7\n\t"
+                   "pblendw $0xf0,%xmm2,%xmm1\n\t"
+                   "palignr $8,%xmm7,%xmm2\n\t"
+                   "movdqu %xmm1,0(%rcx)\n\t"
+                   "movdqu %xmm2,16(%rcx)\n\t"
+                   "movdqa 0x00(%rsp),%xmm6\n\t"
+                   "movdqa 0x10(%rsp),%xmm7\n\t"
+                   "movdqa 0x20(%rsp),%xmm8\n\t"
+                   "movdqa 0x30(%rsp),%xmm9\n\t"
+                   "movdqa 0x40(%rsp),%xmm10\n\t"
+                   "addq $0x58,%rsp\n\t"
+                   __ASM_CFI(".cfi_adjust_cfa_offset -0x58\n\t")
+                   "ret" )
+
+static inline void do_cpuid( unsigned int ax, unsigned int cx, unsigned int *p )
+{
+    __asm__( "cpuid" : "=a" (p[0]), "=b" (p[1]), "=c" (p[2]), "=d" (p[3]) : "a" (ax), "c" (cx) );
+}
+
+static BOOL use_sha_ni(void)
+{
+    static int supported = -1;
+    unsigned int regs[4];
+
+    if (supported == -1)
+    {
+        supported = 0;
+        do_cpuid( 0, 0, regs );
+        if (regs[0] >= 7)
+        {
+            do_cpuid( 1, 0, regs );
+            /* SSSE3 and SSE4.1 are needed for the shuffles around the sha256 instructions */
+            if ((regs[2] & (1 << 9)) && (regs[2] & (1 << 19)))
+            {
+                do_cpuid( 7, 0, regs );
+                supported = (regs[1] >> 29) & 1;
+            }
+        }
+    }
+    return supported;
+}
+
+#endif  /* __x86_64__ */
+
+static void processblocks(SHA256_CTX *ctx, const UCHAR *buffer, ULONG count)
+{
+#ifdef __x86_64__
+    if (use_sha_ni())
+    {
+        sha256_ni_blocks(ctx->h, buffer, count, K);
+        return;
+    }
+#endif
+    for (; count; count--, buffer += 64)
+        processblock(ctx, buffer);
+}
+
 static void pad(SHA256_CTX *ctx)
 {
     ULONG64 r = ctx->len % 64;
@@ -101,7 +341,7 @@ static void pad(SHA256_CTX *ctx)
     {
         memset(ctx->buf + r, 0, 64 - r);
         r = 0;
-        processblock(ctx, ctx->buf);
+        processblocks(ctx, ctx->buf, 1);
     }
 
     memset(ctx->buf + r, 0, 56 - r);
@@ -115,7 +355,7 @@ static void pad(SHA256_CTX *ctx)
     ctx->buf[62] = ctx->len >> 8;
     ctx->buf[63] = ctx->len;
 
-    processblock(ctx, ctx->buf);
+    processblocks(ctx, ctx->buf, 1);
 }
 
 void sha256_init(SHA256_CTX *ctx)
@@ -147,10 +387,14 @@ void sha256_update(SHA256_CTX *ctx, const UCHAR *buffer, ULONG len)
         memcpy(ctx->buf + r, p, 64 - r);
         len -= 64 - r;
         p += 64 - r;
-        processblock(ctx, ctx->buf);
+        processblocks(ctx, ctx->buf, 1);
+    }
+    if (len >= 64)
+    {
+        processblocks(ctx, p, len / 64);
+        p += len & ~63;
+        len &= 63;
     }
-    for (; len >= 64; len -= 64, p += 64)
-        processblock(ctx, p);
     memcpy(ctx->buf, p, len);
 }
 
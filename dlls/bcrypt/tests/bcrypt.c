@@ -353,6 +353,51 @@ static void test_hashes(void)
         test_hash(tests+i);
 }
 
+static void test_hash_multiblock(void)
+{
+    static const char expected[] = "1e9bc38cbf860b9ec31918b065f9b52476c549a782e0e7990bed8ce3868d2371";
+    static const ULONG chunk_sizes[] = { 1000, 13, 64, 200 };
+    BCRYPT_ALG_HANDLE alg;
+    BCRYPT_HASH_HANDLE hash;
+    UCHAR buf[512], data[1000], hash_buf[32];
+    char str[65];
+    NTSTATUS ret;
+    ULONG i, j, size;
+
+    for (i = 0; i < sizeof(data); i++) data[i] = i * 7 + 3;
+
+    alg = NULL;
+    ret = pBCryptOpenAlgorithmProvider(&alg, BCRYPT_SHA256_ALGORITHM, MS_PRIMITIVE_PROVIDER, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(alg != NULL, "alg not set\n");
+
+    for (i = 0; i < sizeof(chunk_sizes)/sizeof(chunk_sizes[0]); i++)
+    {
+        hash = NULL;
+        ret = pBCryptCreateHash(alg, &hash, buf, sizeof(buf), NULL, 0, 0);
+        ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+        for (j = 0; j < sizeof(data); j += size)
+        {
+            size = min(chunk_sizes[i], sizeof(data) - j);
+            ret = pBCryptHashData(hash, data + j, size, 0);
+            ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+        }
+
+        memset(hash_buf, 0, sizeof(hash_buf));
+        ret = pBCryptFinishHash(hash, hash_buf, sizeof(hash_buf), 0);
+        ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+        format_hash(hash_buf, sizeof(hash_buf), str);
+        ok(!strcmp(str, expected), "%u: got %s\n", chunk_sizes[i], str);
+
+        ret = pBCryptDestroyHash(hash);
+        ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    }
+
+    ret = pBCryptCloseAlgorithmProvider(alg, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+}
+
 static void test_BcryptHash(void)
 {
     static const char expected[] =
@@ -1646,6 +1691,7 @@ START_TEST(bcrypt)
     test_BCryptGenRandom();
     test_BCryptGetFipsAlgorithmMode();
     test_hashes();
+    test_hash_multiblock();
     test_rng();
     test_aes();
     test_BCryptGenerateSymmetricKey();
@@ -253,6 +253,7 @@ typedef struct tagLISTVIEW_INFO
   /* sorting */
   PFNLVCOMPARE pfnCompare;      /* sorting callback pointer */
   LPARAM lParamSort;
+  DWORD dwSortedStyle;          /* LVS_SORT* style the items are known to be ordered by, 0 if unknown */
 
   /* style */
   DWORD dwStyle;		/* the cached window GWL_STYLE */
@@ -4281,7 +4282,10 @@ static BOOL set_main_item(LISTVIEW_INFO *infoPtr, const LVITEMW *lpLVItem, BOOL
 
     /* copy information */
     if (lpLVItem->mask & LVIF_TEXT)
+    {
         textsetptrT(&lpItem->hdr.pszText, lpLVItem->pszText, isW);
+        infoPtr->dwSortedStyle = 0;
+    }
 
     if (lpLVItem->mask & LVIF_IMAGE)
 	lpItem->hdr.iImage = lpLVItem->iImage;
@@ -7784,7 +7788,8 @@ static INT LISTVIEW_InsertItemT(LISTVIEW_INFO *infoPtr, const LVITEMW *lpLVItem,
     NMLISTVIEW nmlv;
     ITEM_INFO *lpItem;
     ITEM_ID *lpID;
-    BOOL is_sorted, has_changed;
+    BOOL is_sorted, has_changed, is_ordered = FALSE;
+    DWORD sort_style = infoPtr->dwStyle & (LVS_SORTASCENDING | LVS_SORTDESCENDING);
     LVITEMW item;
     HWND hwndSelf = infoPtr->hwndSelf;
 
@@ -7825,7 +7830,27 @@ static INT LISTVIEW_InsertItemT(LISTVIEW_INFO *infoPtr, const LVITEMW *lpLVItem,
 
         textW = textdupTtoW(lpLVItem->pszText, isW);
 
-        while (i < infoPtr->nItemCount)
+        /* if the items are still in order, a binary search finds the same position */
+        is_ordered = !infoPtr->nItemCount || infoPtr->dwSortedStyle == sort_style;
+        if (is_ordered)
+        {
+            INT high = infoPtr->nItemCount;
+
+            while (i < high)
+            {
+                INT mid = i + (high - i) / 2;
+
+                hItem  = DPA_GetPtr( infoPtr->hdpaItems, mid);
+                item_s = DPA_GetPtr(hItem, 0);
+
+                cmpv = textcmpWT(item_s->hdr.pszText, textW, TRUE);
+                if (infoPtr->dwStyle & LVS_SORTDESCENDING) cmpv *= -1;
+
+                if (cmpv >= 0) high = mid;
+                else i = mid + 1;
+            }
+        }
+        else while (i < infoPtr->nItemCount)
         {
             hItem  = DPA_GetPtr( infoPtr->hdpaItems, i);
             item_s = DPA_GetPtr(hItem, 0);
@@ -7886,6 +7911,7 @@ static INT LISTVIEW_InsertItemT(LISTVIEW_INFO *infoPtr, const LVITEMW *lpLVItem,
     }
 
     if (!set_main_item(infoPtr, &item, TRUE, isW, &has_changed)) goto undo;
+    infoPtr->dwSortedStyle = is_ordered ? sort_style : 0;
 
     /* make room for the position, if we are in the right mode */
     if ((infoPtr->uView == LV_VIEW_SMALLICON) || (infoPtr->uView == LV_VIEW_ICON))
@@ -9315,6 +9341,7 @@ static BOOL LISTVIEW_SortItems(LISTVIEW_INFO *infoPtr, PFNLVCOMPARE pfnCompare,
 
     infoPtr->pfnCompare = pfnCompare;
     infoPtr->lParamSort = lParamSort;
+    infoPtr->dwSortedStyle = 0;
     if (IsEx)
         DPA_Sort(infoPtr->hdpaItems, LISTVIEW_CallBackCompareEx, (LPARAM)infoPtr);
     else
@@ -2861,7 +2861,8 @@ static void test_sorting(void)
     INT r;
     LONG_PTR style;
     static CHAR names[][5] = {"A", "B", "C", "D", "0"};
-    CHAR buff[10];
+    CHAR buff[10], text[10];
+    int i;
 
     hwnd = create_listview_control(LVS_REPORT);
     ok(hwnd != NULL, "failed to create a listview window\n");
@@ -3030,6 +3031,36 @@ static void test_sorting(void)
     ok(lstrcmpA(buff, names[3]) == 0, "Expected '%s', got '%s'\n", names[3], buff);
 
     DestroyWindow(hwnd);
+
+    /* items inserted in any order are kept sorted */
+    hwnd = create_listview_control(LVS_REPORT | LVS_SORTASCENDING);
+    ok(hwnd != NULL, "failed to create a listview window\n");
+
+    for (i = 0; i < 50; i++)
+    {
+        sprintf(text, "%02d", (i * 7) % 50);
+        item.mask = LVIF_TEXT;
+        item.iItem = 0;
+        item.iSubItem = 0;
+        item.pszText = text;
+        r = SendMessageA(hwnd, LVM_INSERTITEMA, 0, (LPARAM) &item);
+        ok(r != -1, "Failed to insert item %s\n", text);
+    }
+
+    for (i = 0; i < 50; i++)
+    {
+        sprintf(text, "%02d", i);
+        item.mask = LVIF_TEXT;
+        item.iItem = i;
+        item.iSubItem = 0;
+        item.pszText = buff;
+        item.cchTextMax = sizeof(buff);
+        r = SendMessageA(hwnd, LVM_GETITEMA, 0, (LPARAM) &item);
+        expect(TRUE, r);
+        ok(lstrcmpA(buff, text) == 0, "Expected '%s', got '%s'\n", text, buff);
+    }
+
+    DestroyWindow(hwnd);
 }
 
 static void test_ownerdata(void)
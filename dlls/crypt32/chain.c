@@ -33,6 +33,22 @@ WINE_DECLARE_DEBUG_CHANNEL(chain);
 
 #define DEFAULT_CYCLE_MODULUS 7
 
+/* Chains built from the system stores alone are cached per engine for a
+ * short while, so repeated validation of the same certificate (as done by
+ * e.g. TLS clients) doesn't rebuild and re-verify the whole chain.
+ */
+#define CHAIN_CACHE_SIZE    16
+#define CHAIN_CACHE_TIMEOUT 60000 /* ms */
+
+struct chain_cache_entry
+{
+    struct _CertificateChain *chain;
+    BYTE  *key;
+    DWORD  key_size;
+    DWORD  time;
+    DWORD  timeout;
+};
+
 /* This represents a subset of a certificate chain engine:  it doesn't include
  * the "hOther" store described by MSDN, because I'm not sure how that's used.
  * It also doesn't include the "hTrust" store, because I don't yet implement
@@ -47,6 +63,10 @@ typedef struct _CertificateChainEngine
     DWORD      dwUrlRetrievalTimeout;
     DWORD      MaximumCachedCertificates;
     DWORD      CycleDetectionModulus;
+    BOOL       cache_chains;
+    CRITICAL_SECTION cs;
+    struct chain_cache_entry cache[CHAIN_CACHE_SIZE];
+    DWORD      cache_next;
 } CertificateChainEngine;
 
 static inline void CRYPT_AddStoresToCollection(HCERTSTORE collection,
@@ -116,6 +136,7 @@ HCERTCHAINENGINE CRYPT_CreateChainEngine(HCERTSTORE root, DWORD system_store, co
 {
     CertificateChainEngine *engine;
     HCERTSTORE worldStores[4];
+    BOOL system_root = !root;
 
     static const WCHAR caW[] = { 'C','A',0 };
     static const WCHAR myW[] = { 'M','y',0 };
@@ -158,6 +179,14 @@ HCERTCHAINENGINE CRYPT_CreateChainEngine(HCERTSTORE root, DWORD system_store, co
     else
         engine->CycleDetectionModulus = DEFAULT_CYCLE_MODULUS;
 
+    /* Only chains depending on nothing but the system stores may be cached. */
+    engine->cache_chains = system_root && !config->hRestrictedRoot && !config->cAdditionalStore
+     && !(config->cbSize >= sizeof(CERT_CHAIN_ENGINE_CONFIG) && config->hExclusiveRoot);
+    memset(engine->cache, 0, sizeof(engine->cache));
+    engine->cache_next = 0;
+    InitializeCriticalSection(&engine->cs);
+    engine->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": CertificateChainEngine.cs");
+
     return engine;
 }
 
@@ -200,9 +229,19 @@ static CertificateChainEngine *get_chain_engine(HCERTCHAINENGINE handle, BOOL al
 
 static void free_chain_engine(CertificateChainEngine *engine)
 {
+    DWORD i;
+
     if(!engine || InterlockedDecrement(&engine->ref))
         return;
 
+    for (i = 0; i < CHAIN_CACHE_SIZE; i++)
+    {
+        if (!engine->cache[i].chain) continue;
+        CertFreeCertificateChain((PCCERT_CHAIN_CONTEXT)engine->cache[i].chain);
+        CryptMemFree(engine->cache[i].key);
+    }
+    engine->cs.DebugInfo->Spare[0] = 0;
+    DeleteCriticalSection(&engine->cs);
     CertCloseStore(engine->hWorld, 0);
     CertCloseStore(engine->hRoot, 0);
     CryptMemFree(engine);
@@ -2889,6 +2928,124 @@ static void dump_chain_para(const CERT_CHAIN_PARA *pChainPara)
     }
 }
 
+static DWORD usage_match_key(BYTE *key, const CERT_USAGE_MATCH *match)
+{
+    DWORD i, size = 2 * sizeof(DWORD), len;
+
+    if (key)
+    {
+        memcpy(key, &match->dwType, sizeof(DWORD));
+        memcpy(key + sizeof(DWORD), &match->Usage.cUsageIdentifier, sizeof(DWORD));
+    }
+    for (i = 0; i < match->Usage.cUsageIdentifier; i++)
+    {
+        len = strlen(match->Usage.rgpszUsageIdentifier[i]) + 1;
+        if (key) memcpy(key + size, match->Usage.rgpszUsageIdentifier[i], len);
+        size += len;
+    }
+    return size;
+}
+
+/* Serializes everything the resulting chain depends on, besides the state of
+ * the engine's stores, into a blob usable as a cache key.
+ */
+static DWORD chain_cache_key(BYTE *key, PCCERT_CONTEXT cert, const FILETIME *time,
+ const CERT_CHAIN_PARA *para, DWORD flags)
+{
+    DWORD size = 0, values[4];
+
+    values[0] = flags;
+    values[1] = para->cbSize;
+    values[2] = time != NULL;
+    values[3] = cert->cbCertEncoded;
+    if (key) memcpy(key, values, sizeof(values));
+    size += sizeof(values);
+    if (time)
+    {
+        if (key) memcpy(key + size, time, sizeof(*time));
+        size += sizeof(*time);
+    }
+    if (para->cbSize >= sizeof(CERT_CHAIN_PARA_NO_EXTRA_FIELDS))
+        size += usage_match_key(key ? key + size : NULL, &para->RequestedUsage);
+    if (para->cbSize >= sizeof(CERT_CHAIN_PARA))
+    {
+        size += usage_match_key(key ? key + size : NULL, &para->RequestedIssuancePolicy);
+        values[0] = para->dwUrlRetrievalTimeout;
+        values[1] = para->fCheckRevocationFreshnessTime;
+        values[2] = para->dwRevocationFreshnessTime;
+        if (key) memcpy(key + size, values, 3 * sizeof(DWORD));
+        size += 3 * sizeof(DWORD);
+    }
+    if (key) memcpy(key + size, cert->pbCertEncoded, cert->cbCertEncoded);
+    size += cert->cbCertEncoded;
+    return size;
+}
+
+static CertificateChain *chain_cache_lookup(CertificateChainEngine *engine,
+ const BYTE *key, DWORD key_size)
+{
+    CertificateChain *chain = NULL;
+    DWORD i, now = GetTickCount();
+
+    EnterCriticalSection(&engine->cs);
+    for (i = 0; i < CHAIN_CACHE_SIZE; i++)
+    {
+        struct chain_cache_entry *entry = &engine->cache[i];
+
+        if (!entry->chain || entry->key_size != key_size || memcmp(entry->key, key, key_size))
+            continue;
+        if (now - entry->time < entry->timeout)
+            chain = (CertificateChain *)CertDuplicateCertificateChain(&entry->chain->context);
+        break;
+    }
+    LeaveCriticalSection(&engine->cs);
+    return chain;
+}
+
+static void chain_cache_add(CertificateChainEngine *engine, BYTE *key, DWORD key_size,
+ CertificateChain *chain, const CERT_CHAIN_PARA *para)
+{
+    struct chain_cache_entry *entry = NULL;
+    DWORD i, timeout = CHAIN_CACHE_TIMEOUT;
+
+    /* don't keep revocation results longer than the caller allows */
+    if (para->cbSize >= sizeof(CERT_CHAIN_PARA) && para->fCheckRevocationFreshnessTime
+     && para->dwRevocationFreshnessTime < CHAIN_CACHE_TIMEOUT / 1000)
+        timeout = para->dwRevocationFreshnessTime * 1000;
+    if (!timeout)
+    {
+        CryptMemFree(key);
+        return;
+    }
+
+    EnterCriticalSection(&engine->cs);
+    for (i = 0; i < CHAIN_CACHE_SIZE; i++)
+    {
+        if (engine->cache[i].chain && engine->cache[i].key_size == key_size
+         && !memcmp(engine->cache[i].key, key, key_size))
+        {
+            entry = &engine->cache[i];
+            break;
+        }
+    }
+    if (!entry)
+    {
+        entry = &engine->cache[engine->cache_next];
+        engine->cache_next = (engine->cache_next + 1) % CHAIN_CACHE_SIZE;
+    }
+    if (entry->chain)
+    {
+        CertFreeCertificateChain(&entry->chain->context);
+        CryptMemFree(entry->key);
+    }
+    entry->chain = (CertificateChain *)CertDuplicateCertificateChain(&chain->context);
+    entry->key = key;
+    entry->key_size = key_size;
+    entry->time = GetTickCount();
+    entry->timeout = timeout;
+    LeaveCriticalSection(&engine->cs);
+}
+
 BOOL WINAPI CertGetCertificateChain(HCERTCHAINENGINE hChainEngine,
  PCCERT_CONTEXT pCertContext, LPFILETIME pTime, HCERTSTORE hAdditionalStore,
  PCERT_CHAIN_PARA pChainPara, DWORD dwFlags, LPVOID pvReserved,
@@ -2897,6 +3054,8 @@ BOOL WINAPI CertGetCertificateChain(HCERTCHAINENGINE hChainEngine,
     CertificateChainEngine *engine;
     BOOL ret;
     CertificateChain *chain = NULL;
+    BYTE *key = NULL;
+    DWORD key_size = 0;
 
     TRACE("(%p, %p, %s, %p, %p, %08x, %p, %p)\n", hChainEngine, pCertContext,
      debugstr_filetime(pTime), hAdditionalStore, pChainPara, dwFlags,
@@ -2921,6 +3080,26 @@ BOOL WINAPI CertGetCertificateChain(HCERTCHAINENGINE hChainEngine,
 
     if (TRACE_ON(chain))
         dump_chain_para(pChainPara);
+
+    if (engine->cache_chains && !hAdditionalStore)
+    {
+        key_size = chain_cache_key(NULL, pCertContext, pTime, pChainPara, dwFlags);
+        if ((key = CryptMemAlloc(key_size)))
+        {
+            chain_cache_key(key, pCertContext, pTime, pChainPara, dwFlags);
+            if ((chain = chain_cache_lookup(engine, key, key_size)))
+            {
+                TRACE("using cached chain %p\n", chain);
+                CryptMemFree(key);
+                if (ppChainContext)
+                    *ppChainContext = &chain->context;
+                else
+                    CertFreeCertificateChain(&chain->context);
+                return TRUE;
+            }
+        }
+    }
+
     /* FIXME: what about HCCE_LOCAL_MACHINE? */
     ret = CRYPT_BuildCandidateChainFromCert(engine, pCertContext, pTime,
      hAdditionalStore, dwFlags, &chain);
@@ -2949,11 +3128,17 @@ BOOL WINAPI CertGetCertificateChain(HCERTCHAINENGINE hChainEngine,
         CRYPT_CheckUsages(pChain, pChainPara);
         TRACE_(chain)("error status: %08x\n",
          pChain->TrustStatus.dwErrorStatus);
+        if (key)
+        {
+            chain_cache_add(engine, key, key_size, chain, pChainPara);
+            key = NULL;
+        }
         if (ppChainContext)
             *ppChainContext = pChain;
         else
             CertFreeCertificateChain(pChain);
     }
+    CryptMemFree(key);
     TRACE("returning %d\n", ret);
     return ret;
 }
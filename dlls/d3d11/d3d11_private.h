@@ -75,6 +75,7 @@ struct wined3d_resource *wined3d_resource_from_d3d10_resource(ID3D10Resource *re
 DWORD wined3d_map_flags_from_d3d11_map_type(D3D11_MAP map_type) DECLSPEC_HIDDEN;
 DWORD wined3d_clear_flags_from_d3d11_clear_flags(UINT clear_flags) DECLSPEC_HIDDEN;
 unsigned int wined3d_access_from_d3d11(D3D11_USAGE usage, UINT cpu_access) DECLSPEC_HIDDEN;
+BOOL d3d_array_reserve(void **elements, SIZE_T *capacity, SIZE_T count, SIZE_T size) DECLSPEC_HIDDEN;
 
 enum D3D11_USAGE d3d11_usage_from_d3d10_usage(enum D3D10_USAGE usage) DECLSPEC_HIDDEN;
 enum D3D10_USAGE d3d10_usage_from_d3d11_usage(enum D3D11_USAGE usage) DECLSPEC_HIDDEN;
@@ -520,6 +521,11 @@ struct d3d11_immediate_context
     struct wined3d_private_store private_store;
 };
 
+HRESULT d3d11_deferred_context_create(struct d3d_device *device,
+        ID3D11DeviceContext **context) DECLSPEC_HIDDEN;
+void d3d11_command_list_execute(ID3D11CommandList *iface, ID3D11DeviceContext *context,
+        BOOL restore_state) DECLSPEC_HIDDEN;
+
 /* ID3D11Device, ID3D10Device1 */
 struct d3d_device
 {
@@ -0,0 +1,2797 @@
+/*
+ * Copyright 2018 Wine project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "config.h"
+#include "wine/port.h"
+
+#include "d3d11_private.h"
+
+WINE_DEFAULT_DEBUG_CHANNEL(d3d11);
+
+/* Deferred contexts record the calls made on them into a flat buffer of
+ * variable sized records, without touching wined3d (or taking the wined3d
+ * mutex) at all. ExecuteCommandList() then replays the records through the
+ * methods of the immediate context. Every object referenced by the recorded
+ * calls is kept alive by the command list until it is destroyed. */
+
+enum deferred_stage
+{
+    DEFERRED_STAGE_VS,
+    DEFERRED_STAGE_HS,
+    DEFERRED_STAGE_DS,
+    DEFERRED_STAGE_GS,
+    DEFERRED_STAGE_PS,
+    DEFERRED_STAGE_CS,
+    DEFERRED_STAGE_COUNT,
+};
+
+enum deferred_call_type
+{
+    DEFERRED_SET_CONSTANT_BUFFERS,
+    DEFERRED_SET_SHADER_RESOURCES,
+    DEFERRED_SET_SAMPLERS,
+    DEFERRED_SET_SHADER,
+    DEFERRED_CS_SET_UNORDERED_ACCESS_VIEWS,
+    DEFERRED_IA_SET_INPUT_LAYOUT,
+    DEFERRED_IA_SET_VERTEX_BUFFERS,
+    DEFERRED_IA_SET_INDEX_BUFFER,
+    DEFERRED_IA_SET_PRIMITIVE_TOPOLOGY,
+    DEFERRED_OM_SET_RENDER_TARGETS_AND_UAVS,
+    DEFERRED_OM_SET_BLEND_STATE,
+    DEFERRED_OM_SET_DEPTH_STENCIL_STATE,
+    DEFERRED_SO_SET_TARGETS,
+    DEFERRED_RS_SET_STATE,
+    DEFERRED_RS_SET_VIEWPORTS,
+    DEFERRED_RS_SET_SCISSOR_RECTS,
+    DEFERRED_SET_PREDICATION,
+    DEFERRED_BEGIN,
+    DEFERRED_END,
+    DEFERRED_DRAW,
+    DEFERRED_DRAW_INDEXED,
+    DEFERRED_DRAW_INSTANCED,
+    DEFERRED_DRAW_INDEXED_INSTANCED,
+    DEFERRED_DRAW_AUTO,
+    DEFERRED_DRAW_INSTANCED_INDIRECT,
+    DEFERRED_DRAW_INDEXED_INSTANCED_INDIRECT,
+    DEFERRED_DISPATCH,
+    DEFERRED_DISPATCH_INDIRECT,
+    DEFERRED_MAP,
+    DEFERRED_UPDATE_SUBRESOURCE,
+    DEFERRED_COPY_SUBRESOURCE_REGION,
+    DEFERRED_COPY_RESOURCE,
+    DEFERRED_RESOLVE_SUBRESOURCE,
+    DEFERRED_COPY_STRUCTURE_COUNT,
+    DEFERRED_CLEAR_RENDER_TARGET_VIEW,
+    DEFERRED_CLEAR_UNORDERED_ACCESS_VIEW_UINT,
+    DEFERRED_CLEAR_UNORDERED_ACCESS_VIEW_FLOAT,
+    DEFERRED_CLEAR_DEPTH_STENCIL_VIEW,
+    DEFERRED_GENERATE_MIPS,
+    DEFERRED_SET_RESOURCE_MIN_LOD,
+    DEFERRED_EXECUTE_COMMAND_LIST,
+    DEFERRED_CLEAR_STATE,
+};
+
+struct deferred_call
+{
+    enum deferred_call_type type;
+    unsigned int size;
+};
+
+struct deferred_call_set_views
+{
+    struct deferred_call call;
+    enum deferred_stage stage;
+    UINT start_slot;
+    UINT count;
+    IUnknown *views[1];
+};
+
+struct deferred_call_set_shader
+{
+    struct deferred_call call;
+    enum deferred_stage stage;
+    IUnknown *shader;
+};
+
+/* Used for OMSetRenderTargets(), OMSetRenderTargetsAndUnorderedAccessViews()
+ * and CSSetUnorderedAccessViews(). The render target views are followed by
+ * the unordered access views, and then by the initial counts. */
+struct deferred_call_set_targets
+{
+    struct deferred_call call;
+    UINT rtv_count;
+    IUnknown *dsv;
+    UINT uav_start_slot;
+    UINT uav_count;
+    BOOL has_initial_counts;
+    IUnknown *views[1];
+};
+
+/* Used for IASetVertexBuffers() and SOSetTargets(). The buffers are followed
+ * by the strides and the offsets. */
+struct deferred_call_set_buffers
+{
+    struct deferred_call call;
+    UINT start_slot;
+    UINT count;
+    IUnknown *buffers[1];
+};
+
+struct deferred_call_object
+{
+    struct deferred_call call;
+    IUnknown *object;
+    UINT value;
+    DXGI_FORMAT format;
+    float min_lod;
+};
+
+struct deferred_call_blend_state
+{
+    struct deferred_call call;
+    IUnknown *state;
+    float blend_factor[4];
+    UINT sample_mask;
+};
+
+struct deferred_call_rs_set_viewports
+{
+    struct deferred_call call;
+    UINT count;
+    D3D11_VIEWPORT viewports[1];
+};
+
+struct deferred_call_rs_set_scissor_rects
+{
+    struct deferred_call call;
+    UINT count;
+    D3D11_RECT rects[1];
+};
+
+struct deferred_call_draw
+{
+    struct deferred_call call;
+    UINT count;
+    UINT instance_count;
+    UINT start;
+    INT base_vertex;
+    UINT start_instance;
+};
+
+struct deferred_call_dispatch
+{
+    struct deferred_call call;
+    UINT x, y, z;
+};
+
+struct deferred_call_map
+{
+    struct deferred_call call;
+    IUnknown *resource;
+    UINT subresource_idx;
+    SIZE_T size;
+    void *data;
+};
+
+struct deferred_call_update_subresource
+{
+    struct deferred_call call;
+    IUnknown *resource;
+    UINT subresource_idx;
+    BOOL has_box;
+    D3D11_BOX box;
+    UINT row_pitch;
+    UINT depth_pitch;
+    BYTE data[1];
+};
+
+struct deferred_call_copy
+{
+    struct deferred_call call;
+    IUnknown *dst;
+    UINT dst_subresource_idx;
+    UINT dst_x, dst_y, dst_z;
+    IUnknown *src;
+    UINT src_subresource_idx;
+    BOOL has_box;
+    D3D11_BOX box;
+    DXGI_FORMAT format;
+};
+
+struct deferred_call_clear
+{
+    struct deferred_call call;
+    IUnknown *view;
+    float color[4];
+    UINT values[4];
+    UINT flags;
+    float depth;
+    UINT8 stencil;
+};
+
+struct deferred_call_execute_command_list
+{
+    struct deferred_call call;
+    IUnknown *command_list;
+    BOOL restore_state;
+};
+
+/* The last discard map of a subresource, for D3D11_MAP_WRITE_NO_OVERWRITE. */
+struct deferred_map_info
+{
+    IUnknown *resource;
+    UINT subresource_idx;
+    void *data;
+};
+
+/* The recorded calls and the references they hold. */
+struct deferred_calls
+{
+    BYTE *data;
+    SIZE_T data_size;
+    SIZE_T data_capacity;
+
+    IUnknown **objects;
+    SIZE_T object_count;
+    SIZE_T objects_capacity;
+};
+
+/* ID3D11CommandList */
+struct d3d11_command_list
+{
+    ID3D11CommandList ID3D11CommandList_iface;
+    LONG refcount;
+
+    struct wined3d_private_store private_store;
+    struct deferred_calls calls;
+    ID3D11Device *device;
+};
+
+/* ID3D11DeviceContext - deferred context */
+struct d3d11_deferred_context
+{
+    ID3D11DeviceContext ID3D11DeviceContext_iface;
+    LONG refcount;
+
+    struct wined3d_private_store private_store;
+    struct deferred_calls calls;
+    struct d3d_device *device;
+
+    struct deferred_map_info *maps;
+    SIZE_T map_count;
+    SIZE_T maps_capacity;
+};
+
+static void deferred_calls_cleanup(struct deferred_calls *calls)
+{
+    const struct deferred_call *call;
+    SIZE_T offset, i;
+
+    for (offset = 0; offset < calls->data_size; offset += call->size)
+    {
+        call = (const struct deferred_call *)(calls->data + offset);
+        if (call->type == DEFERRED_MAP)
+            heap_free(((const struct deferred_call_map *)call)->data);
+    }
+    heap_free(calls->data);
+
+    for (i = 0; i < calls->object_count; ++i)
+        IUnknown_Release(calls->objects[i]);
+    heap_free(calls->objects);
+
+    memset(calls, 0, sizeof(*calls));
+}
+
+static void *deferred_calls_add(struct deferred_calls *calls, enum deferred_call_type type, SIZE_T size)
+{
+    struct deferred_call *call;
+
+    size = (size + 7) & ~(SIZE_T)7;
+    if (!d3d_array_reserve((void **)&calls->data, &calls->data_capacity, calls->data_size + size, 1))
+    {
+        ERR("Failed to record call %#x.\n", type);
+        return NULL;
+    }
+
+    call = (struct deferred_call *)(calls->data + calls->data_size);
+    memset(call, 0, size);
+    call->type = type;
+    call->size = size;
+    calls->data_size += size;
+
+    return call;
+}
+
+static IUnknown *deferred_calls_add_object(struct deferred_calls *calls, void *object)
+{
+    IUnknown *unknown = object;
+
+    if (!unknown)
+        return NULL;
+
+    if (!d3d_array_reserve((void **)&calls->objects, &calls->objects_capacity,
+            calls->object_count + 1, sizeof(*calls->objects)))
+    {
+        ERR("Failed to allocate object array.\n");
+        return unknown;
+    }
+
+    IUnknown_AddRef(unknown);
+    calls->objects[calls->object_count++] = unknown;
+
+    return unknown;
+}
+
+static void context_set_constant_buffers(ID3D11DeviceContext *context, enum deferred_stage stage,
+        UINT start_slot, UINT count, ID3D11Buffer *const *buffers)
+{
+    switch (stage)
+    {
+        case DEFERRED_STAGE_VS: ID3D11DeviceContext_VSSetConstantBuffers(context, start_slot, count, buffers); break;
+        case DEFERRED_STAGE_HS: ID3D11DeviceContext_HSSetConstantBuffers(context, start_slot, count, buffers); break;
+        case DEFERRED_STAGE_DS: ID3D11DeviceContext_DSSetConstantBuffers(context, start_slot, count, buffers); break;
+        case DEFERRED_STAGE_GS: ID3D11DeviceContext_GSSetConstantBuffers(context, start_slot, count, buffers); break;
+        case DEFERRED_STAGE_PS: ID3D11DeviceContext_PSSetConstantBuffers(context, start_slot, count, buffers); break;
+        case DEFERRED_STAGE_CS: ID3D11DeviceContext_CSSetConstantBuffers(context, start_slot, count, buffers); break;
+        default: ERR("Invalid stage %#x.\n", stage); break;
+    }
+}
+
+static void context_set_shader_resources(ID3D11DeviceContext *context, enum deferred_stage stage,
+        UINT start_slot, UINT count, ID3D11ShaderResourceView *const *views)
+{
+    switch (stage)
+    {
+        case DEFERRED_STAGE_VS: ID3D11DeviceContext_VSSetShaderResources(context, start_slot, count, views); break;
+        case DEFERRED_STAGE_HS: ID3D11DeviceContext_HSSetShaderResources(context, start_slot, count, views); break;
+        case DEFERRED_STAGE_DS: ID3D11DeviceContext_DSSetShaderResources(context, start_slot, count, views); break;
+        case DEFERRED_STAGE_GS: ID3D11DeviceContext_GSSetShaderResources(context, start_slot, count, views); break;
+        case DEFERRED_STAGE_PS: ID3D11DeviceContext_PSSetShaderResources(context, start_slot, count, views); break;
+        case DEFERRED_STAGE_CS: ID3D11DeviceContext_CSSetShaderResources(context, start_slot, count, views); break;
+        default: ERR("Invalid stage %#x.\n", stage); break;
+    }
+}
+
+static void context_set_samplers(ID3D11DeviceContext *context, enum deferred_stage stage,
+        UINT start_slot, UINT count, ID3D11SamplerState *const *samplers)
+{
+    switch (stage)
+    {
+        case DEFERRED_STAGE_VS: ID3D11DeviceContext_VSSetSamplers(context, start_slot, count, samplers); break;
+        case DEFERRED_STAGE_HS: ID3D11DeviceContext_HSSetSamplers(context, start_slot, count, samplers); break;
+        case DEFERRED_STAGE_DS: ID3D11DeviceContext_DSSetSamplers(context, start_slot, count, samplers); break;
+        case DEFERRED_STAGE_GS: ID3D11DeviceContext_GSSetSamplers(context, start_slot, count, samplers); break;
+        case DEFERRED_STAGE_PS: ID3D11DeviceContext_PSSetSamplers(context, start_slot, count, samplers); break;
+        case DEFERRED_STAGE_CS: ID3D11DeviceContext_CSSetSamplers(context, start_slot, count, samplers); break;
+        default: ERR("Invalid stage %#x.\n", stage); break;
+    }
+}
+
+static void context_set_shader(ID3D11DeviceContext *context, enum deferred_stage stage, IUnknown *shader)
+{
+    switch (stage)
+    {
+        case DEFERRED_STAGE_VS:
+            ID3D11DeviceContext_VSSetShader(context, (ID3D11VertexShader *)shader, NULL, 0);
+            break;
+        case DEFERRED_STAGE_HS:
+            ID3D11DeviceContext_HSSetShader(context, (ID3D11HullShader *)shader, NULL, 0);
+            break;
+        case DEFERRED_STAGE_DS:
+            ID3D11DeviceContext_DSSetShader(context, (ID3D11DomainShader *)shader, NULL, 0);
+            break;
+        case DEFERRED_STAGE_GS:
+            ID3D11DeviceContext_GSSetShader(context, (ID3D11GeometryShader *)shader, NULL, 0);
+            break;
+        case DEFERRED_STAGE_PS:
+            ID3D11DeviceContext_PSSetShader(context, (ID3D11PixelShader *)shader, NULL, 0);
+            break;
+        case DEFERRED_STAGE_CS:
+            ID3D11DeviceContext_CSSetShader(context, (ID3D11ComputeShader *)shader, NULL, 0);
+            break;
+        default:
+            ERR("Invalid stage %#x.\n", stage);
+            break;
+    }
+}
+
+static void deferred_calls_execute(const struct deferred_calls *calls, ID3D11DeviceContext *context)
+{
+    const struct deferred_call *call;
+    SIZE_T offset;
+
+    for (offset = 0; offset < calls->data_size; offset += call->size)
+    {
+        call = (const struct deferred_call *)(calls->data + offset);
+
+        switch (call->type)
+        {
+            case DEFERRED_SET_CONSTANT_BUFFERS:
+            {
+                const struct deferred_call_set_views *c = (const struct deferred_call_set_views *)call;
+                context_set_constant_buffers(context, c->stage, c->start_slot, c->count,
+                        (ID3D11Buffer *const *)c->views);
+                break;
+            }
+
+            case DEFERRED_SET_SHADER_RESOURCES:
+            {
+                const struct deferred_call_set_views *c = (const struct deferred_call_set_views *)call;
+                context_set_shader_resources(context, c->stage, c->start_slot, c->count,
+                        (ID3D11ShaderResourceView *const *)c->views);
+                break;
+            }
+
+            case DEFERRED_SET_SAMPLERS:
+            {
+                const struct deferred_call_set_views *c = (const struct deferred_call_set_views *)call;
+                context_set_samplers(context, c->stage, c->start_slot, c->count,
+                        (ID3D11SamplerState *const *)c->views);
+                break;
+            }
+
+            case DEFERRED_SET_SHADER:
+            {
+                const struct deferred_call_set_shader *c = (const struct deferred_call_set_shader *)call;
+                context_set_shader(context, c->stage, c->shader);
+                break;
+            }
+
+            case DEFERRED_CS_SET_UNORDERED_ACCESS_VIEWS:
+            {
+                const struct deferred_call_set_targets *c = (const struct deferred_call_set_targets *)call;
+                ID3D11DeviceContext_CSSetUnorderedAccessViews(context, c->uav_start_slot, c->uav_count,
+                        (ID3D11UnorderedAccessView *const *)c->views,
+                        c->has_initial_counts ? (const UINT *)&c->views[c->uav_count] : NULL);
+                break;
+            }
+
+            case DEFERRED_OM_SET_RENDER_TARGETS_AND_UAVS:
+            {
+                const struct deferred_call_set_targets *c = (const struct deferred_call_set_targets *)call;
+                unsigned int rtv_count, uav_count;
+
+                rtv_count = c->rtv_count != D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL ? c->rtv_count : 0;
+                uav_count = c->uav_count != D3D11_KEEP_UNORDERED_ACCESS_VIEWS ? c->uav_count : 0;
+                ID3D11DeviceContext_OMSetRenderTargetsAndUnorderedAccessViews(context,
+                        c->rtv_count, (ID3D11RenderTargetView *const *)c->views,
+                        (ID3D11DepthStencilView *)c->dsv, c->uav_start_slot, c->uav_count,
+                        (ID3D11UnorderedAccessView *const *)&c->views[rtv_count],
+                        c->has_initial_counts ? (const UINT *)&c->views[rtv_count + uav_count] : NULL);
+                break;
+            }
+
+            case DEFERRED_IA_SET_INPUT_LAYOUT:
+            {
+                const struct deferred_call_object *c = (const struct deferred_call_object *)call;
+                ID3D11DeviceContext_IASetInputLayout(context, (ID3D11InputLayout *)c->object);
+                break;
+            }
+
+            case DEFERRED_IA_SET_VERTEX_BUFFERS:
+            {
+                const struct deferred_call_set_buffers *c = (const struct deferred_call_set_buffers *)call;
+                const UINT *strides = (const UINT *)&c->buffers[c->count];
+                ID3D11DeviceContext_IASetVertexBuffers(context, c->start_slot, c->count,
+                        (ID3D11Buffer *const *)c->buffers, strides, strides + c->count);
+                break;
+            }
+
+            case DEFERRED_IA_SET_INDEX_BUFFER:
+            {
+                const struct deferred_call_object *c = (const struct deferred_call_object *)call;
+                ID3D11DeviceContext_IASetIndexBuffer(context, (ID3D11Buffer *)c->object, c->format, c->value);
+                break;
+            }
+
+            case DEFERRED_IA_SET_PRIMITIVE_TOPOLOGY:
+            {
+                const struct deferred_call_object *c = (const struct deferred_call_object *)call;
+                ID3D11DeviceContext_IASetPrimitiveTopology(context, c->value);
+                break;
+            }
+
+            case DEFERRED_OM_SET_BLEND_STATE:
+            {
+                const struct deferred_call_blend_state *c = (const struct deferred_call_blend_state *)call;
+                ID3D11DeviceContext_OMSetBlendState(context, (ID3D11BlendState *)c->state,
+                        c->blend_factor, c->sample_mask);
+                break;
+            }
+
+            case DEFERRED_OM_SET_DEPTH_STENCIL_STATE:
+            {
+                const struct deferred_call_object *c = (const struct deferred_call_object *)call;
+                ID3D11DeviceContext_OMSetDepthStencilState(context, (ID3D11DepthStencilState *)c->object, c->value);
+                break;
+            }
+
+            case DEFERRED_SO_SET_TARGETS:
+            {
+                const struct deferred_call_set_buffers *c = (const struct deferred_call_set_buffers *)call;
+                ID3D11DeviceContext_SOSetTargets(context, c->count,
+                        (ID3D11Buffer *const *)c->buffers, (const UINT *)&c->buffers[c->count]);
+                break;
+            }
+
+            case DEFERRED_RS_SET_STATE:
+            {
+                const struct deferred_call_object *c = (const struct deferred_call_object *)call;
+                ID3D11DeviceContext_RSSetState(context, (ID3D11RasterizerState *)c->object);
+                break;
+            }
+
+            case DEFERRED_RS_SET_VIEWPORTS:
+            {
+                const struct deferred_call_rs_set_viewports *c = (const struct deferred_call_rs_set_viewports *)call;
+                ID3D11DeviceContext_RSSetViewports(context, c->count, c->viewports);
+                break;
+            }
+
+            case DEFERRED_RS_SET_SCISSOR_RECTS:
+            {
+                const struct deferred_call_rs_set_scissor_rects *c
+                        = (const struct deferred_call_rs_set_scissor_rects *)call;
+                ID3D11DeviceContext_RSSetScissorRects(context, c->count, c->rects);
+                break;
+            }
+
+            case DEFERRED_SET_PREDICATION:
+            {
+                const struct deferred_call_object *c = (const struct deferred_call_object *)call;
+                ID3D11DeviceContext_SetPredication(context, (ID3D11Predicate *)c->object, c->value);
+                break;
+            }
+
+            case DEFERRED_BEGIN:
+            {
+                const struct deferred_call_object *c = (const struct deferred_call_object *)call;
+                ID3D11DeviceContext_Begin(context, (ID3D11Asynchronous *)c->object);
+                break;
+            }
+
+            case DEFERRED_END:
+            {
+                const struct deferred_call_object *c = (const struct deferred_call_object *)call;
+                ID3D11DeviceContext_End(context, (ID3D11Asynchronous *)c->object);
+                break;
+            }
+
+            case DEFERRED_DRAW:
+            {
+                const struct deferred_call_draw *c = (const struct deferred_call_draw *)call;
+                ID3D11DeviceContext_Draw(context, c->count, c->start);
+                break;
+            }
+
+            case DEFERRED_DRAW_INDEXED:
+            {
+                const struct deferred_call_draw *c = (const struct deferred_call_draw *)call;
+                ID3D11DeviceContext_DrawIndexed(context, c->count, c->start, c->base_vertex);
+                break;
+            }
+
+            case DEFERRED_DRAW_INSTANCED:
+            {
+                const struct deferred_call_draw *c = (const struct deferred_call_draw *)call;
+                ID3D11DeviceContext_DrawInstanced(context, c->count, c->instance_count,
+                        c->start, c->start_instance);
+                break;
+            }
+
+            case DEFERRED_DRAW_INDEXED_INSTANCED:
+            {
+                const struct deferred_call_draw *c = (const struct deferred_call_draw *)call;
+                ID3D11DeviceContext_DrawIndexedInstanced(context, c->count, c->instance_count,
+                        c->start, c->base_vertex, c->start_instance);
+                break;
+            }
+
+            case DEFERRED_DRAW_AUTO:
+                ID3D11DeviceContext_DrawAuto(context);
+                break;
+
+            case DEFERRED_DRAW_INSTANCED_INDIRECT:
+            {
+                const struct deferred_call_object *c = (const struct deferred_call_object *)call;
+                ID3D11DeviceContext_DrawInstancedIndirect(context, (ID3D11Buffer *)c->object, c->value);
+                break;
+            }
+
+            case DEFERRED_DRAW_INDEXED_INSTANCED_INDIRECT:
+            {
+                const struct deferred_call_object *c = (const struct deferred_call_object *)call;
+                ID3D11DeviceContext_DrawIndexedInstancedIndirect(context, (ID3D11Buffer *)c->object, c->value);
+                break;
+            }
+
+            case DEFERRED_DISPATCH:
+            {
+                const struct deferred_call_dispatch *c = (const struct deferred_call_dispatch *)call;
+                ID3D11DeviceContext_Dispatch(context, c->x, c->y, c->z);
+                break;
+            }
+
+            case DEFERRED_DISPATCH_INDIRECT:
+            {
+                const struct deferred_call_object *c = (const struct deferred_call_object *)call;
+                ID3D11DeviceContext_DispatchIndirect(context, (ID3D11Buffer *)c->object, c->value);
+                break;
+            }
+
+            case DEFERRED_MAP:
+            {
+                const struct deferred_call_map *c = (const struct deferred_call_map *)call;
+                D3D11_MAPPED_SUBRESOURCE map_desc;
+                HRESULT hr;
+
+                if (FAILED(hr = ID3D11DeviceContext_Map(context, (ID3D11Resource *)c->resource,
+                        c->subresource_idx, D3D11_MAP_WRITE_DISCARD, 0, &map_desc)))
+                {
+                    ERR("Failed to map resource %p, hr %#x.\n", c->resource, hr);
+                    break;
+                }
+                memcpy(map_desc.pData, c->data, c->size);
+                ID3D11DeviceContext_Unmap(context, (ID3D11Resource *)c->resource, c->subresource_idx);
+                break;
+            }
+
+            case DEFERRED_UPDATE_SUBRESOURCE:
+            {
+                const struct deferred_call_update_subresource *c
+                        = (const struct deferred_call_update_subresource *)call;
+                ID3D11DeviceContext_UpdateSubresource(context, (ID3D11Resource *)c->resource,
+                        c->subresource_idx, c->has_box ? &c->box : NULL, c->data, c->row_pitch, c->depth_pitch);
+                break;
+            }
+
+            case DEFERRED_COPY_SUBRESOURCE_REGION:
+            {
+                const struct deferred_call_copy *c = (const struct deferred_call_copy *)call;
+                ID3D11DeviceContext_CopySubresourceRegion(context, (ID3D11Resource *)c->dst,
+                        c->dst_subresource_idx, c->dst_x, c->dst_y, c->dst_z, (ID3D11Resource *)c->src,
+                        c->src_subresource_idx, c->has_box ? &c->box : NULL);
+                break;
+            }
+
+            case DEFERRED_COPY_RESOURCE:
+            {
+                const struct deferred_call_copy *c = (const struct deferred_call_copy *)call;
+                ID3D11DeviceContext_CopyResource(context, (ID3D11Resource *)c->dst, (ID3D11Resource *)c->src);
+                break;
+            }
+
+            case DEFERRED_RESOLVE_SUBRESOURCE:
+            {
+                const struct deferred_call_copy *c = (const struct deferred_call_copy *)call;
+                ID3D11DeviceContext_ResolveSubresource(context, (ID3D11Resource *)c->dst, c->dst_subresource_idx,
+                        (ID3D11Resource *)c->src, c->src_subresource_idx, c->format);
+                break;
+            }
+
+            case DEFERRED_COPY_STRUCTURE_COUNT:
+            {
+                const struct deferred_call_copy *c = (const struct deferred_call_copy *)call;
+                ID3D11DeviceContext_CopyStructureCount(context, (ID3D11Buffer *)c->dst,
+                        c->dst_x, (ID3D11UnorderedAccessView *)c->src);
+                break;
+            }
+
+            case DEFERRED_CLEAR_RENDER_TARGET_VIEW:
+            {
+                const struct deferred_call_clear *c = (const struct deferred_call_clear *)call;
+                ID3D11DeviceContext_ClearRenderTargetView(context, (ID3D11RenderTargetView *)c->view, c->color);
+                break;
+            }
+
+            case DEFERRED_CLEAR_UNORDERED_ACCESS_VIEW_UINT:
+            {
+                const struct deferred_call_clear *c = (const struct deferred_call_clear *)call;
+                ID3D11DeviceContext_ClearUnorderedAccessViewUint(context,
+                        (ID3D11UnorderedAccessView *)c->view, c->values);
+                break;
+            }
+
+            case DEFERRED_CLEAR_UNORDERED_ACCESS_VIEW_FLOAT:
+            {
+                const struct deferred_call_clear *c = (const struct deferred_call_clear *)call;
+                ID3D11DeviceContext_ClearUnorderedAccessViewFloat(context,
+                        (ID3D11UnorderedAccessView *)c->view, c->color);
+                break;
+            }
+
+            case DEFERRED_CLEAR_DEPTH_STENCIL_VIEW:
+            {
+                const struct deferred_call_clear *c = (const struct deferred_call_clear *)call;
+                ID3D11DeviceContext_ClearDepthStencilView(context, (ID3D11DepthStencilView *)c->view,
+                        c->flags, c->depth, c->stencil);
+                break;
+            }
+
+            case DEFERRED_GENERATE_MIPS:
+            {
+                const struct deferred_call_object *c = (const struct deferred_call_object *)call;
+                ID3D11DeviceContext_GenerateMips(context, (ID3D11ShaderResourceView *)c->object);
+                break;
+            }
+
+            case DEFERRED_SET_RESOURCE_MIN_LOD:
+            {
+                const struct deferred_call_object *c = (const struct deferred_call_object *)call;
+                ID3D11DeviceContext_SetResourceMinLOD(context, (ID3D11Resource *)c->object, c->min_lod);
+                break;
+            }
+
+            case DEFERRED_EXECUTE_COMMAND_LIST:
+            {
+                const struct deferred_call_execute_command_list *c
+                        = (const struct deferred_call_execute_command_list *)call;
+                struct d3d11_command_list *list = CONTAINING_RECORD(c->command_list,
+                        struct d3d11_command_list, ID3D11CommandList_iface);
+
+                /* Nested command lists inherit the state of the parent list. */
+                deferred_calls_execute(&list->calls, context);
+                break;
+            }
+
+            case DEFERRED_CLEAR_STATE:
+                ID3D11DeviceContext_ClearState(context);
+                break;
+
+            default:
+                ERR("Unhandled call type %#x.\n", call->type);
+                break;
+        }
+    }
+}
+
+/* Saved immediate context state, for ExecuteCommandList() with
+ * "restore_state" set. */
+struct d3d11_context_state
+{
+    ID3D11Buffer *constant_buffers[DEFERRED_STAGE_COUNT][D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+    ID3D11ShaderResourceView *views[DEFERRED_STAGE_COUNT][D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT];
+    ID3D11SamplerState *samplers[DEFERRED_STAGE_COUNT][D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT];
+    IUnknown *shaders[DEFERRED_STAGE_COUNT];
+    ID3D11UnorderedAccessView *cs_uavs[D3D11_PS_CS_UAV_REGISTER_COUNT];
+
+    ID3D11InputLayout *input_layout;
+    ID3D11Buffer *vertex_buffers[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+    UINT vertex_strides[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+    UINT vertex_offsets[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+    ID3D11Buffer *index_buffer;
+    DXGI_FORMAT index_format;
+    UINT index_offset;
+    D3D11_PRIMITIVE_TOPOLOGY topology;
+
+    ID3D11RenderTargetView *rtvs[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT];
+    ID3D11DepthStencilView *dsv;
+    ID3D11UnorderedAccessView *uavs[D3D11_PS_CS_UAV_REGISTER_COUNT];
+    ID3D11BlendState *blend_state;
+    float blend_factor[4];
+    UINT sample_mask;
+    ID3D11DepthStencilState *depth_stencil_state;
+    UINT stencil_ref;
+
+    ID3D11Buffer *so_buffers[D3D11_SO_BUFFER_SLOT_COUNT];
+
+    ID3D11RasterizerState *rasterizer_state;
+    UINT viewport_count;
+    D3D11_VIEWPORT viewports[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
+    UINT scissor_rect_count;
+    D3D11_RECT scissor_rects[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
+
+    ID3D11Predicate *predicate;
+    BOOL predicate_value;
+};
+
+static void d3d11_context_state_capture(struct d3d11_context_state *state, ID3D11DeviceContext *context)
+{
+    D3D11_PRIMITIVE_TOPOLOGY topology;
+
+#define GET_STAGE(stage, prefix, type) \
+    ID3D11DeviceContext_##prefix##GetConstantBuffers(context, 0, \
+            D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT, state->constant_buffers[stage]); \
+    ID3D11DeviceContext_##prefix##GetShaderResources(context, 0, \
+            D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT, state->views[stage]); \
+    ID3D11DeviceContext_##prefix##GetSamplers(context, 0, \
+            D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT, state->samplers[stage]); \
+    ID3D11DeviceContext_##prefix##GetShader(context, (type **)&state->shaders[stage], NULL, NULL);
+    GET_STAGE(DEFERRED_STAGE_VS, VS, ID3D11VertexShader)
+    GET_STAGE(DEFERRED_STAGE_HS, HS, ID3D11HullShader)
+    GET_STAGE(DEFERRED_STAGE_DS, DS, ID3D11DomainShader)
+    GET_STAGE(DEFERRED_STAGE_GS, GS, ID3D11GeometryShader)
+    GET_STAGE(DEFERRED_STAGE_PS, PS, ID3D11PixelShader)
+    GET_STAGE(DEFERRED_STAGE_CS, CS, ID3D11ComputeShader)
+#undef GET_STAGE
+    ID3D11DeviceContext_CSGetUnorderedAccessViews(context, 0, D3D11_PS_CS_UAV_REGISTER_COUNT, state->cs_uavs);
+
+    ID3D11DeviceContext_IAGetInputLayout(context, &state->input_layout);
+    ID3D11DeviceContext_IAGetVertexBuffers(context, 0, D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT,
+            state->vertex_buffers, state->vertex_strides, state->vertex_offsets);
+    ID3D11DeviceContext_IAGetIndexBuffer(context, &state->index_buffer, &state->index_format, &state->index_offset);
+    ID3D11DeviceContext_IAGetPrimitiveTopology(context, &topology);
+    state->topology = topology;
+
+    ID3D11DeviceContext_OMGetRenderTargetsAndUnorderedAccessViews(context,
+            D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, state->rtvs, &state->dsv,
+            0, D3D11_PS_CS_UAV_REGISTER_COUNT, state->uavs);
+    ID3D11DeviceContext_OMGetBlendState(context, &state->blend_state, state->blend_factor, &state->sample_mask);
+    ID3D11DeviceContext_OMGetDepthStencilState(context, &state->depth_stencil_state, &state->stencil_ref);
+
+    ID3D11DeviceContext_SOGetTargets(context, D3D11_SO_BUFFER_SLOT_COUNT, state->so_buffers);
+
+    ID3D11DeviceContext_RSGetState(context, &state->rasterizer_state);
+    ID3D11DeviceContext_RSGetViewports(context, &state->viewport_count, NULL);
+    state->viewport_count = min(state->viewport_count, ARRAY_SIZE(state->viewports));
+    ID3D11DeviceContext_RSGetViewports(context, &state->viewport_count, state->viewports);
+    ID3D11DeviceContext_RSGetScissorRects(context, &state->scissor_rect_count, NULL);
+    state->scissor_rect_count = min(state->scissor_rect_count, ARRAY_SIZE(state->scissor_rects));
+    ID3D11DeviceContext_RSGetScissorRects(context, &state->scissor_rect_count, state->scissor_rects);
+
+    ID3D11DeviceContext_GetPredication(context, &state->predicate, &state->predicate_value);
+}
+
+static void release_objects(void *objects, unsigned int count)
+{
+    IUnknown **unknowns = objects;
+    unsigned int i;
+
+    for (i = 0; i < count; ++i)
+    {
+        if (unknowns[i])
+            IUnknown_Release(unknowns[i]);
+    }
+}
+
+static void d3d11_context_state_apply(struct d3d11_context_state *state, ID3D11DeviceContext *context)
+{
+    static const UINT so_offsets[D3D11_SO_BUFFER_SLOT_COUNT] = {~0u, ~0u, ~0u, ~0u};
+    unsigned int i;
+
+    for (i = 0; i < DEFERRED_STAGE_COUNT; ++i)
+    {
+        context_set_constant_buffers(context, i, 0,
+                D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT, state->constant_buffers[i]);
+        context_set_shader_resources(context, i, 0,
+                D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT, state->views[i]);
+        context_set_samplers(context, i, 0, D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT, state->samplers[i]);
+        context_set_shader(context, i, state->shaders[i]);
+    }
+    ID3D11DeviceContext_CSSetUnorderedAccessViews(context, 0, D3D11_PS_CS_UAV_REGISTER_COUNT, state->cs_uavs, NULL);
+
+    ID3D11DeviceContext_IASetInputLayout(context, state->input_layout);
+    ID3D11DeviceContext_IASetVertexBuffers(context, 0, D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT,
+            state->vertex_buffers, state->vertex_strides, state->vertex_offsets);
+    ID3D11DeviceContext_IASetIndexBuffer(context, state->index_buffer, state->index_format, state->index_offset);
+    ID3D11DeviceContext_IASetPrimitiveTopology(context, state->topology);
+
+    ID3D11DeviceContext_OMSetRenderTargetsAndUnorderedAccessViews(context,
+            D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, state->rtvs, state->dsv,
+            0, D3D11_PS_CS_UAV_REGISTER_COUNT, state->uavs, NULL);
+    ID3D11DeviceContext_OMSetBlendState(context, state->blend_state, state->blend_factor, state->sample_mask);
+    ID3D11DeviceContext_OMSetDepthStencilState(context, state->depth_stencil_state, state->stencil_ref);
+
+    ID3D11DeviceContext_SOSetTargets(context, D3D11_SO_BUFFER_SLOT_COUNT, state->so_buffers, so_offsets);
+
+    ID3D11DeviceContext_RSSetState(context, state->rasterizer_state);
+    ID3D11DeviceContext_RSSetViewports(context, state->viewport_count, state->viewports);
+    ID3D11DeviceContext_RSSetScissorRects(context, state->scissor_rect_count, state->scissor_rects);
+
+    ID3D11DeviceContext_SetPredication(context, state->predicate, state->predicate_value);
+
+    for (i = 0; i < DEFERRED_STAGE_COUNT; ++i)
+    {
+        release_objects(state->constant_buffers[i], ARRAY_SIZE(state->constant_buffers[i]));
+        release_objects(state->views[i], ARRAY_SIZE(state->views[i]));
+        release_objects(state->samplers[i], ARRAY_SIZE(state->samplers[i]));
+    }
+    release_objects(state->shaders, ARRAY_SIZE(state->shaders));
+    release_objects(state->cs_uavs, ARRAY_SIZE(state->cs_uavs));
+    release_objects(&state->input_layout, 1);
+    release_objects(state->vertex_buffers, ARRAY_SIZE(state->vertex_buffers));
+    release_objects(&state->index_buffer, 1);
+    release_objects(state->rtvs, ARRAY_SIZE(state->rtvs));
+    release_objects(&state->dsv, 1);
+    release_objects(state->uavs, ARRAY_SIZE(state->uavs));
+    release_objects(&state->blend_state, 1);
+    release_objects(&state->depth_stencil_state, 1);
+    release_objects(state->so_buffers, ARRAY_SIZE(state->so_buffers));
+    release_objects(&state->rasterizer_state, 1);
+    release_objects(&state->predicate, 1);
+}
+
+/* ID3D11CommandList methods */
+
+static inline struct d3d11_command_list *impl_from_ID3D11CommandList(ID3D11CommandList *iface)
+{
+    return CONTAINING_RECORD(iface, struct d3d11_command_list, ID3D11CommandList_iface);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_command_list_QueryInterface(ID3D11CommandList *iface,
+        REFIID riid, void **out)
+{
+    TRACE("iface %p, riid %s, out %p.\n", iface, debugstr_guid(riid), out);
+
+    if (IsEqualGUID(riid, &IID_ID3D11CommandList)
+            || IsEqualGUID(riid, &IID_ID3D11DeviceChild)
+            || IsEqualGUID(riid, &IID_IUnknown))
+    {
+        ID3D11CommandList_AddRef(iface);
+        *out = iface;
+        return S_OK;
+    }
+
+    WARN("%s not implemented, returning E_NOINTERFACE.\n", debugstr_guid(riid));
+    *out = NULL;
+    return E_NOINTERFACE;
+}
+
+static ULONG STDMETHODCALLTYPE d3d11_command_list_AddRef(ID3D11CommandList *iface)
+{
+    struct d3d11_command_list *list = impl_from_ID3D11CommandList(iface);
+    ULONG refcount = InterlockedIncrement(&list->refcount);
+
+    TRACE("%p increasing refcount to %u.\n", list, refcount);
+
+    return refcount;
+}
+
+static ULONG STDMETHODCALLTYPE d3d11_command_list_Release(ID3D11CommandList *iface)
+{
+    struct d3d11_command_list *list = impl_from_ID3D11CommandList(iface);
+    ULONG refcount = InterlockedDecrement(&list->refcount);
+
+    TRACE("%p decreasing refcount to %u.\n", list, refcount);
+
+    if (!refcount)
+    {
+        ID3D11Device *device = list->device;
+
+        deferred_calls_cleanup(&list->calls);
+        wined3d_private_store_cleanup(&list->private_store);
+        heap_free(list);
+
+        ID3D11Device_Release(device);
+    }
+
+    return refcount;
+}
+
+static void STDMETHODCALLTYPE d3d11_command_list_GetDevice(ID3D11CommandList *iface, ID3D11Device **device)
+{
+    struct d3d11_command_list *list = impl_from_ID3D11CommandList(iface);
+
+    TRACE("iface %p, device %p.\n", iface, device);
+
+    *device = list->device;
+    ID3D11Device_AddRef(*device);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_command_list_GetPrivateData(ID3D11CommandList *iface,
+        REFGUID guid, UINT *data_size, void *data)
+{
+    struct d3d11_command_list *list = impl_from_ID3D11CommandList(iface);
+
+    TRACE("iface %p, guid %s, data_size %p, data %p.\n", iface, debugstr_guid(guid), data_size, data);
+
+    return d3d_get_private_data(&list->private_store, guid, data_size, data);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_command_list_SetPrivateData(ID3D11CommandList *iface,
+        REFGUID guid, UINT data_size, const void *data)
+{
+    struct d3d11_command_list *list = impl_from_ID3D11CommandList(iface);
+
+    TRACE("iface %p, guid %s, data_size %u, data %p.\n", iface, debugstr_guid(guid), data_size, data);
+
+    return d3d_set_private_data(&list->private_store, guid, data_size, data);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_command_list_SetPrivateDataInterface(ID3D11CommandList *iface,
+        REFGUID guid, const IUnknown *data)
+{
+    struct d3d11_command_list *list = impl_from_ID3D11CommandList(iface);
+
+    TRACE("iface %p, guid %s, data %p.\n", iface, debugstr_guid(guid), data);
+
+    return d3d_set_private_data_interface(&list->private_store, guid, data);
+}
+
+static UINT STDMETHODCALLTYPE d3d11_command_list_GetContextFlags(ID3D11CommandList *iface)
+{
+    TRACE("iface %p.\n", iface);
+
+    return 0;
+}
+
+static const struct ID3D11CommandListVtbl d3d11_command_list_vtbl =
+{
+    /* IUnknown methods */
+    d3d11_command_list_QueryInterface,
+    d3d11_command_list_AddRef,
+    d3d11_command_list_Release,
+    /* ID3D11DeviceChild methods */
+    d3d11_command_list_GetDevice,
+    d3d11_command_list_GetPrivateData,
+    d3d11_command_list_SetPrivateData,
+    d3d11_command_list_SetPrivateDataInterface,
+    /* ID3D11CommandList methods */
+    d3d11_command_list_GetContextFlags,
+};
+
+static struct d3d11_command_list *unsafe_impl_from_ID3D11CommandList(ID3D11CommandList *iface)
+{
+    if (!iface)
+        return NULL;
+    assert(iface->lpVtbl == &d3d11_command_list_vtbl);
+
+    return impl_from_ID3D11CommandList(iface);
+}
+
+void d3d11_command_list_execute(ID3D11CommandList *iface, ID3D11DeviceContext *context, BOOL restore_state)
+{
+    struct d3d11_command_list *list = unsafe_impl_from_ID3D11CommandList(iface);
+    struct d3d11_context_state *state = NULL;
+
+    if (!list)
+    {
+        WARN("NULL command list.\n");
+        return;
+    }
+
+    if (restore_state && !(state = heap_alloc_zero(sizeof(*state))))
+        ERR("Failed to allocate context state.\n");
+
+    /* Replay the whole list under the wined3d mutex, so that it isn't
+     * interleaved with calls made from other threads. */
+    wined3d_mutex_lock();
+    if (state)
+        d3d11_context_state_capture(state, context);
+    ID3D11DeviceContext_ClearState(context);
+
+    deferred_calls_execute(&list->calls, context);
+
+    if (state)
+        d3d11_context_state_apply(state, context);
+    else
+        ID3D11DeviceContext_ClearState(context);
+    wined3d_mutex_unlock();
+
+    heap_free(state);
+}
+
+/* ID3D11DeviceContext - deferred context methods */
+
+static inline struct d3d11_deferred_context *impl_from_deferred_ID3D11DeviceContext(ID3D11DeviceContext *iface)
+{
+    return CONTAINING_RECORD(iface, struct d3d11_deferred_context, ID3D11DeviceContext_iface);
+}
+
+static void deferred_context_set_views(struct d3d11_deferred_context *context, enum deferred_call_type type,
+        enum deferred_stage stage, UINT start_slot, UINT count, void *const *views)
+{
+    struct deferred_call_set_views *call;
+    unsigned int i;
+
+    if (!(call = deferred_calls_add(&context->calls, type, FIELD_OFFSET(struct deferred_call_set_views, views[count]))))
+        return;
+
+    call->stage = stage;
+    call->start_slot = start_slot;
+    call->count = count;
+    for (i = 0; i < count; ++i)
+        call->views[i] = deferred_calls_add_object(&context->calls, views[i]);
+}
+
+static void deferred_context_set_shader(struct d3d11_deferred_context *context,
+        enum deferred_stage stage, void *shader, UINT class_instance_count)
+{
+    struct deferred_call_set_shader *call;
+
+    if (class_instance_count)
+        FIXME("Dynamic linking is not implemented yet.\n");
+
+    if (!(call = deferred_calls_add(&context->calls, DEFERRED_SET_SHADER, sizeof(*call))))
+        return;
+
+    call->stage = stage;
+    call->shader = deferred_calls_add_object(&context->calls, shader);
+}
+
+static void deferred_context_set_targets(struct d3d11_deferred_context *context, enum deferred_call_type type,
+        UINT rtv_count, ID3D11RenderTargetView *const *rtvs, ID3D11DepthStencilView *dsv,
+        UINT uav_start_slot, UINT uav_count, ID3D11UnorderedAccessView *const *uavs, const UINT *initial_counts)
+{
+    struct deferred_call_set_targets *call;
+    unsigned int real_rtv_count, real_uav_count, i;
+    SIZE_T size;
+
+    real_rtv_count = rtv_count != D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL ? rtv_count : 0;
+    real_uav_count = uav_count != D3D11_KEEP_UNORDERED_ACCESS_VIEWS ? uav_count : 0;
+    if (!uavs || !initial_counts)
+        initial_counts = NULL;
+
+    size = FIELD_OFFSET(struct deferred_call_set_targets, views[real_rtv_count + real_uav_count]);
+    if (initial_counts)
+        size += real_uav_count * sizeof(*initial_counts);
+    if (!(call = deferred_calls_add(&context->calls, type, size)))
+        return;
+
+    call->rtv_count = rtv_count;
+    call->uav_start_slot = uav_start_slot;
+    call->uav_count = uav_count;
+    call->has_initial_counts = !!initial_counts;
+    if (rtv_count != D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL)
+        call->dsv = deferred_calls_add_object(&context->calls, dsv);
+    for (i = 0; i < real_rtv_count; ++i)
+        call->views[i] = deferred_calls_add_object(&context->calls, rtvs ? rtvs[i] : NULL);
+    for (i = 0; i < real_uav_count; ++i)
+        call->views[real_rtv_count + i] = deferred_calls_add_object(&context->calls, uavs ? uavs[i] : NULL);
+    if (initial_counts)
+        memcpy(&call->views[real_rtv_count + real_uav_count], initial_counts, real_uav_count * sizeof(*initial_counts));
+}
+
+static void deferred_context_add_object_call(struct d3d11_deferred_context *context,
+        enum deferred_call_type type, void *object, UINT value)
+{
+    struct deferred_call_object *call;
+
+    if (!(call = deferred_calls_add(&context->calls, type, sizeof(*call))))
+        return;
+
+    call->object = deferred_calls_add_object(&context->calls, object);
+    call->value = value;
+}
+
+static void deferred_context_add_draw(struct d3d11_deferred_context *context, enum deferred_call_type type,
+        UINT count, UINT instance_count, UINT start, INT base_vertex, UINT start_instance)
+{
+    struct deferred_call_draw *call;
+
+    if (!(call = deferred_calls_add(&context->calls, type, sizeof(*call))))
+        return;
+
+    call->count = count;
+    call->instance_count = instance_count;
+    call->start = start;
+    call->base_vertex = base_vertex;
+    call->start_instance = start_instance;
+}
+
+static struct deferred_call_clear *deferred_context_add_clear(struct d3d11_deferred_context *context,
+        enum deferred_call_type type, void *view)
+{
+    struct deferred_call_clear *call;
+
+    if (!(call = deferred_calls_add(&context->calls, type, sizeof(*call))))
+        return NULL;
+
+    call->view = deferred_calls_add_object(&context->calls, view);
+
+    return call;
+}
+
+static struct deferred_call_copy *deferred_context_add_copy(struct d3d11_deferred_context *context,
+        enum deferred_call_type type, void *dst, void *src)
+{
+    struct deferred_call_copy *call;
+
+    if (!(call = deferred_calls_add(&context->calls, type, sizeof(*call))))
+        return NULL;
+
+    call->dst = deferred_calls_add_object(&context->calls, dst);
+    call->src = deferred_calls_add_object(&context->calls, src);
+
+    return call;
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_deferred_context_QueryInterface(ID3D11DeviceContext *iface,
+        REFIID riid, void **out)
+{
+    TRACE("iface %p, riid %s, out %p.\n", iface, debugstr_guid(riid), out);
+
+    if (IsEqualGUID(riid, &IID_ID3D11DeviceContext)
+            || IsEqualGUID(riid, &IID_ID3D11DeviceChild)
+            || IsEqualGUID(riid, &IID_IUnknown))
+    {
+        ID3D11DeviceContext_AddRef(iface);
+        *out = iface;
+        return S_OK;
+    }
+
+    WARN("%s not implemented, returning E_NOINTERFACE.\n", debugstr_guid(riid));
+    *out = NULL;
+    return E_NOINTERFACE;
+}
+
+static ULONG STDMETHODCALLTYPE d3d11_deferred_context_AddRef(ID3D11DeviceContext *iface)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    ULONG refcount = InterlockedIncrement(&context->refcount);
+
+    TRACE("%p increasing refcount to %u.\n", context, refcount);
+
+    return refcount;
+}
+
+static ULONG STDMETHODCALLTYPE d3d11_deferred_context_Release(ID3D11DeviceContext *iface)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    ULONG refcount = InterlockedDecrement(&context->refcount);
+
+    TRACE("%p decreasing refcount to %u.\n", context, refcount);
+
+    if (!refcount)
+    {
+        struct d3d_device *device = context->device;
+
+        deferred_calls_cleanup(&context->calls);
+        heap_free(context->maps);
+        wined3d_private_store_cleanup(&context->private_store);
+        heap_free(context);
+
+        ID3D11Device_Release(&device->ID3D11Device_iface);
+    }
+
+    return refcount;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GetDevice(ID3D11DeviceContext *iface, ID3D11Device **device)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, device %p.\n", iface, device);
+
+    *device = &context->device->ID3D11Device_iface;
+    ID3D11Device_AddRef(*device);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_deferred_context_GetPrivateData(ID3D11DeviceContext *iface, REFGUID guid,
+        UINT *data_size, void *data)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, guid %s, data_size %p, data %p.\n", iface, debugstr_guid(guid), data_size, data);
+
+    return d3d_get_private_data(&context->private_store, guid, data_size, data);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_deferred_context_SetPrivateData(ID3D11DeviceContext *iface, REFGUID guid,
+        UINT data_size, const void *data)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, guid %s, data_size %u, data %p.\n", iface, debugstr_guid(guid), data_size, data);
+
+    return d3d_set_private_data(&context->private_store, guid, data_size, data);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_deferred_context_SetPrivateDataInterface(ID3D11DeviceContext *iface,
+        REFGUID guid, const IUnknown *data)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, guid %s, data %p.\n", iface, debugstr_guid(guid), data);
+
+    return d3d_set_private_data_interface(&context->private_store, guid, data);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSSetConstantBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n", iface, start_slot, buffer_count, buffers);
+
+    deferred_context_set_views(impl_from_deferred_ID3D11DeviceContext(iface), DEFERRED_SET_CONSTANT_BUFFERS,
+            DEFERRED_STAGE_VS, start_slot, buffer_count, (void *const *)buffers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSSetShaderResources(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+{
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    deferred_context_set_views(impl_from_deferred_ID3D11DeviceContext(iface), DEFERRED_SET_SHADER_RESOURCES,
+            DEFERRED_STAGE_PS, start_slot, view_count, (void *const *)views);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSSetShader(ID3D11DeviceContext *iface,
+        ID3D11PixelShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+{
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    deferred_context_set_shader(impl_from_deferred_ID3D11DeviceContext(iface),
+            DEFERRED_STAGE_PS, shader, class_instance_count);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSSetSamplers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+{
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n", iface, start_slot, sampler_count, samplers);
+
+    deferred_context_set_views(impl_from_deferred_ID3D11DeviceContext(iface), DEFERRED_SET_SAMPLERS,
+            DEFERRED_STAGE_PS, start_slot, sampler_count, (void *const *)samplers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSSetShader(ID3D11DeviceContext *iface,
+        ID3D11VertexShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+{
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    deferred_context_set_shader(impl_from_deferred_ID3D11DeviceContext(iface),
+            DEFERRED_STAGE_VS, shader, class_instance_count);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DrawIndexed(ID3D11DeviceContext *iface,
+        UINT index_count, UINT start_index_location, INT base_vertex_location)
+{
+    TRACE("iface %p, index_count %u, start_index_location %u, base_vertex_location %d.\n",
+            iface, index_count, start_index_location, base_vertex_location);
+
+    deferred_context_add_draw(impl_from_deferred_ID3D11DeviceContext(iface), DEFERRED_DRAW_INDEXED,
+            index_count, 0, start_index_location, base_vertex_location, 0);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_Draw(ID3D11DeviceContext *iface,
+        UINT vertex_count, UINT start_vertex_location)
+{
+    TRACE("iface %p, vertex_count %u, start_vertex_location %u.\n",
+            iface, vertex_count, start_vertex_location);
+
+    deferred_context_add_draw(impl_from_deferred_ID3D11DeviceContext(iface), DEFERRED_DRAW,
+            vertex_count, 0, start_vertex_location, 0, 0);
+}
+
+static HRESULT deferred_context_get_map_size(ID3D11Resource *resource, UINT subresource_idx,
+        SIZE_T *size, UINT *row_pitch, UINT *depth_pitch)
+{
+    struct wined3d_sub_resource_desc sub_resource_desc;
+    struct wined3d_resource *wined3d_resource;
+    struct wined3d_resource_desc desc;
+    struct wined3d_texture *texture;
+    unsigned int level;
+    HRESULT hr = S_OK;
+
+    wined3d_resource = wined3d_resource_from_d3d11_resource(resource);
+
+    wined3d_mutex_lock();
+    wined3d_resource_get_desc(wined3d_resource, &desc);
+    if (desc.resource_type == WINED3D_RTYPE_BUFFER)
+    {
+        *size = desc.size;
+        *row_pitch = *depth_pitch = desc.size;
+    }
+    else
+    {
+        texture = wined3d_texture_from_resource(wined3d_resource);
+        if (SUCCEEDED(hr = wined3d_texture_get_sub_resource_desc(texture, subresource_idx, &sub_resource_desc)))
+        {
+            level = subresource_idx % wined3d_texture_get_level_count(texture);
+            wined3d_texture_get_pitch(texture, level, row_pitch, depth_pitch);
+            *size = sub_resource_desc.size;
+        }
+    }
+    wined3d_mutex_unlock();
+
+    return hr;
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_deferred_context_Map(ID3D11DeviceContext *iface, ID3D11Resource *resource,
+        UINT subresource_idx, D3D11_MAP map_type, UINT map_flags, D3D11_MAPPED_SUBRESOURCE *mapped_subresource)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct deferred_call_map *call;
+    struct deferred_map_info *map;
+    UINT row_pitch, depth_pitch;
+    void *data;
+    SIZE_T size, i;
+    HRESULT hr;
+
+    TRACE("iface %p, resource %p, subresource_idx %u, map_type %u, map_flags %#x, mapped_subresource %p.\n",
+            iface, resource, subresource_idx, map_type, map_flags, mapped_subresource);
+
+    if (map_type != D3D11_MAP_WRITE_DISCARD && map_type != D3D11_MAP_WRITE_NO_OVERWRITE)
+    {
+        WARN("Invalid map type %#x on a deferred context.\n", map_type);
+        return E_INVALIDARG;
+    }
+
+    if (map_flags)
+        FIXME("Ignoring map_flags %#x.\n", map_flags);
+
+    if (FAILED(hr = deferred_context_get_map_size(resource, subresource_idx, &size, &row_pitch, &depth_pitch)))
+        return hr;
+
+    for (i = 0, map = NULL; i < context->map_count; ++i)
+    {
+        if (context->maps[i].resource == (IUnknown *)resource
+                && context->maps[i].subresource_idx == subresource_idx)
+        {
+            map = &context->maps[i];
+            break;
+        }
+    }
+
+    if (map_type == D3D11_MAP_WRITE_NO_OVERWRITE)
+    {
+        /* The data is shared with the last discard map in this list. */
+        if (!map)
+        {
+            WARN("Resource %p was not mapped with D3D11_MAP_WRITE_DISCARD before.\n", resource);
+            return E_INVALIDARG;
+        }
+        data = map->data;
+    }
+    else
+    {
+        if (!map && !d3d_array_reserve((void **)&context->maps, &context->maps_capacity,
+                context->map_count + 1, sizeof(*context->maps)))
+            return E_OUTOFMEMORY;
+
+        if (!(call = deferred_calls_add(&context->calls, DEFERRED_MAP, sizeof(*call))))
+            return E_OUTOFMEMORY;
+        if (!(call->data = heap_alloc(size)))
+        {
+            context->calls.data_size -= call->call.size;
+            return E_OUTOFMEMORY;
+        }
+        call->resource = deferred_calls_add_object(&context->calls, resource);
+        call->subresource_idx = subresource_idx;
+        call->size = size;
+
+        if (!map)
+        {
+            map = &context->maps[context->map_count++];
+            map->resource = (IUnknown *)resource;
+            map->subresource_idx = subresource_idx;
+        }
+        map->data = data = call->data;
+    }
+
+    mapped_subresource->pData = data;
+    mapped_subresource->RowPitch = row_pitch;
+    mapped_subresource->DepthPitch = depth_pitch;
+
+    return S_OK;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_Unmap(ID3D11DeviceContext *iface, ID3D11Resource *resource,
+        UINT subresource_idx)
+{
+    TRACE("iface %p, resource %p, subresource_idx %u.\n", iface, resource, subresource_idx);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSSetConstantBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n", iface, start_slot, buffer_count, buffers);
+
+    deferred_context_set_views(impl_from_deferred_ID3D11DeviceContext(iface), DEFERRED_SET_CONSTANT_BUFFERS,
+            DEFERRED_STAGE_PS, start_slot, buffer_count, (void *const *)buffers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_IASetInputLayout(ID3D11DeviceContext *iface,
+        ID3D11InputLayout *input_layout)
+{
+    TRACE("iface %p, input_layout %p.\n", iface, input_layout);
+
+    deferred_context_add_object_call(impl_from_deferred_ID3D11DeviceContext(iface),
+            DEFERRED_IA_SET_INPUT_LAYOUT, input_layout, 0);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_IASetVertexBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers, const UINT *strides, const UINT *offsets)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct deferred_call_set_buffers *call;
+    unsigned int i;
+    UINT *data;
+
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p, strides %p, offsets %p.\n",
+            iface, start_slot, buffer_count, buffers, strides, offsets);
+
+    if (!(call = deferred_calls_add(&context->calls, DEFERRED_IA_SET_VERTEX_BUFFERS,
+            FIELD_OFFSET(struct deferred_call_set_buffers, buffers[buffer_count])
+            + 2 * buffer_count * sizeof(*data))))
+        return;
+
+    call->start_slot = start_slot;
+    call->count = buffer_count;
+    data = (UINT *)&call->buffers[buffer_count];
+    for (i = 0; i < buffer_count; ++i)
+    {
+        call->buffers[i] = deferred_calls_add_object(&context->calls, buffers[i]);
+        data[i] = strides[i];
+        data[buffer_count + i] = offsets[i];
+    }
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_IASetIndexBuffer(ID3D11DeviceContext *iface,
+        ID3D11Buffer *buffer, DXGI_FORMAT format, UINT offset)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct deferred_call_object *call;
+
+    TRACE("iface %p, buffer %p, format %s, offset %u.\n", iface, buffer, debug_dxgi_format(format), offset);
+
+    if (!(call = deferred_calls_add(&context->calls, DEFERRED_IA_SET_INDEX_BUFFER, sizeof(*call))))
+        return;
+
+    call->object = deferred_calls_add_object(&context->calls, buffer);
+    call->format = format;
+    call->value = offset;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DrawIndexedInstanced(ID3D11DeviceContext *iface,
+        UINT instance_index_count, UINT instance_count, UINT start_index_location, INT base_vertex_location,
+        UINT start_instance_location)
+{
+    TRACE("iface %p, instance_index_count %u, instance_count %u, start_index_location %u, "
+            "base_vertex_location %d, start_instance_location %u.\n",
+            iface, instance_index_count, instance_count, start_index_location,
+            base_vertex_location, start_instance_location);
+
+    deferred_context_add_draw(impl_from_deferred_ID3D11DeviceContext(iface), DEFERRED_DRAW_INDEXED_INSTANCED,
+            instance_index_count, instance_count, start_index_location, base_vertex_location,
+            start_instance_location);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DrawInstanced(ID3D11DeviceContext *iface,
+        UINT instance_vertex_count, UINT instance_count, UINT start_vertex_location, UINT start_instance_location)
+{
+    TRACE("iface %p, instance_vertex_count %u, instance_count %u, start_vertex_location %u, "
+            "start_instance_location %u.\n",
+            iface, instance_vertex_count, instance_count, start_vertex_location,
+            start_instance_location);
+
+    deferred_context_add_draw(impl_from_deferred_ID3D11DeviceContext(iface), DEFERRED_DRAW_INSTANCED,
+            instance_vertex_count, instance_count, start_vertex_location, 0, start_instance_location);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSSetConstantBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n", iface, start_slot, buffer_count, buffers);
+
+    deferred_context_set_views(impl_from_deferred_ID3D11DeviceContext(iface), DEFERRED_SET_CONSTANT_BUFFERS,
+            DEFERRED_STAGE_GS, start_slot, buffer_count, (void *const *)buffers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSSetShader(ID3D11DeviceContext *iface,
+        ID3D11GeometryShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+{
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    deferred_context_set_shader(impl_from_deferred_ID3D11DeviceContext(iface),
+            DEFERRED_STAGE_GS, shader, class_instance_count);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_IASetPrimitiveTopology(ID3D11DeviceContext *iface,
+        D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+    TRACE("iface %p, topology %#x.\n", iface, topology);
+
+    deferred_context_add_object_call(impl_from_deferred_ID3D11DeviceContext(iface),
+            DEFERRED_IA_SET_PRIMITIVE_TOPOLOGY, NULL, topology);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSSetShaderResources(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+{
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    deferred_context_set_views(impl_from_deferred_ID3D11DeviceContext(iface), DEFERRED_SET_SHADER_RESOURCES,
+            DEFERRED_STAGE_VS, start_slot, view_count, (void *const *)views);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSSetSamplers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+{
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n", iface, start_slot, sampler_count, samplers);
+
+    deferred_context_set_views(impl_from_deferred_ID3D11DeviceContext(iface), DEFERRED_SET_SAMPLERS,
+            DEFERRED_STAGE_VS, start_slot, sampler_count, (void *const *)samplers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_Begin(ID3D11DeviceContext *iface,
+        ID3D11Asynchronous *asynchronous)
+{
+    TRACE("iface %p, asynchronous %p.\n", iface, asynchronous);
+
+    deferred_context_add_object_call(impl_from_deferred_ID3D11DeviceContext(iface),
+            DEFERRED_BEGIN, asynchronous, 0);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_End(ID3D11DeviceContext *iface,
+        ID3D11Asynchronous *asynchronous)
+{
+    TRACE("iface %p, asynchronous %p.\n", iface, asynchronous);
+
+    deferred_context_add_object_call(impl_from_deferred_ID3D11DeviceContext(iface),
+            DEFERRED_END, asynchronous, 0);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_deferred_context_GetData(ID3D11DeviceContext *iface,
+        ID3D11Asynchronous *asynchronous, void *data, UINT data_size, UINT data_flags)
+{
+    WARN("iface %p, asynchronous %p, data %p, data_size %u, data_flags %#x, invalid call.\n",
+            iface, asynchronous, data, data_size, data_flags);
+
+    return DXGI_ERROR_INVALID_CALL;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_SetPredication(ID3D11DeviceContext *iface,
+        ID3D11Predicate *predicate, BOOL value)
+{
+    TRACE("iface %p, predicate %p, value %#x.\n", iface, predicate, value);
+
+    deferred_context_add_object_call(impl_from_deferred_ID3D11DeviceContext(iface),
+            DEFERRED_SET_PREDICATION, predicate, value);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSSetShaderResources(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+{
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    deferred_context_set_views(impl_from_deferred_ID3D11DeviceContext(iface), DEFERRED_SET_SHADER_RESOURCES,
+            DEFERRED_STAGE_GS, start_slot, view_count, (void *const *)views);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSSetSamplers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+{
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n", iface, start_slot, sampler_count, samplers);
+
+    deferred_context_set_views(impl_from_deferred_ID3D11DeviceContext(iface), DEFERRED_SET_SAMPLERS,
+            DEFERRED_STAGE_GS, start_slot, sampler_count, (void *const *)samplers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_OMSetRenderTargets(ID3D11DeviceContext *iface,
+        UINT render_target_view_count, ID3D11RenderTargetView *const *render_target_views,
+        ID3D11DepthStencilView *depth_stencil_view)
+{
+    TRACE("iface %p, render_target_view_count %u, render_target_views %p, depth_stencil_view %p.\n",
+            iface, render_target_view_count, render_target_views, depth_stencil_view);
+
+    deferred_context_set_targets(impl_from_deferred_ID3D11DeviceContext(iface),
+            DEFERRED_OM_SET_RENDER_TARGETS_AND_UAVS, render_target_view_count, render_target_views,
+            depth_stencil_view, 0, D3D11_KEEP_UNORDERED_ACCESS_VIEWS, NULL, NULL);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_OMSetRenderTargetsAndUnorderedAccessViews(
+        ID3D11DeviceContext *iface, UINT render_target_view_count,
+        ID3D11RenderTargetView *const *render_target_views, ID3D11DepthStencilView *depth_stencil_view,
+        UINT unordered_access_view_start_slot, UINT unordered_access_view_count,
+        ID3D11UnorderedAccessView *const *unordered_access_views, const UINT *initial_counts)
+{
+    TRACE("iface %p, render_target_view_count %u, render_target_views %p, depth_stencil_view %p, "
+            "unordered_access_view_start_slot %u, unordered_access_view_count %u, unordered_access_views %p, "
+            "initial_counts %p.\n",
+            iface, render_target_view_count, render_target_views, depth_stencil_view,
+            unordered_access_view_start_slot, unordered_access_view_count, unordered_access_views,
+            initial_counts);
+
+    deferred_context_set_targets(impl_from_deferred_ID3D11DeviceContext(iface),
+            DEFERRED_OM_SET_RENDER_TARGETS_AND_UAVS, render_target_view_count, render_target_views,
+            depth_stencil_view, unordered_access_view_start_slot, unordered_access_view_count,
+            unordered_access_views, initial_counts);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_OMSetBlendState(ID3D11DeviceContext *iface,
+        ID3D11BlendState *blend_state, const float blend_factor[4], UINT sample_mask)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    static const float default_blend_factor[] = {1.0f, 1.0f, 1.0f, 1.0f};
+    struct deferred_call_blend_state *call;
+
+    TRACE("iface %p, blend_state %p, blend_factor %s, sample_mask 0x%08x.\n",
+            iface, blend_state, debug_float4(blend_factor), sample_mask);
+
+    if (!blend_factor)
+        blend_factor = default_blend_factor;
+
+    if (!(call = deferred_calls_add(&context->calls, DEFERRED_OM_SET_BLEND_STATE, sizeof(*call))))
+        return;
+
+    call->state = deferred_calls_add_object(&context->calls, blend_state);
+    memcpy(call->blend_factor, blend_factor, sizeof(call->blend_factor));
+    call->sample_mask = sample_mask;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_OMSetDepthStencilState(ID3D11DeviceContext *iface,
+        ID3D11DepthStencilState *depth_stencil_state, UINT stencil_ref)
+{
+    TRACE("iface %p, depth_stencil_state %p, stencil_ref %u.\n",
+            iface, depth_stencil_state, stencil_ref);
+
+    deferred_context_add_object_call(impl_from_deferred_ID3D11DeviceContext(iface),
+            DEFERRED_OM_SET_DEPTH_STENCIL_STATE, depth_stencil_state, stencil_ref);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_SOSetTargets(ID3D11DeviceContext *iface, UINT buffer_count,
+        ID3D11Buffer *const *buffers, const UINT *offsets)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct deferred_call_set_buffers *call;
+    unsigned int i;
+    UINT *data;
+
+    TRACE("iface %p, buffer_count %u, buffers %p, offsets %p.\n", iface, buffer_count, buffers, offsets);
+
+    if (!(call = deferred_calls_add(&context->calls, DEFERRED_SO_SET_TARGETS,
+            FIELD_OFFSET(struct deferred_call_set_buffers, buffers[buffer_count])
+            + buffer_count * sizeof(*data))))
+        return;
+
+    call->count = buffer_count;
+    data = (UINT *)&call->buffers[buffer_count];
+    for (i = 0; i < buffer_count; ++i)
+    {
+        call->buffers[i] = deferred_calls_add_object(&context->calls, buffers[i]);
+        data[i] = offsets ? offsets[i] : 0;
+    }
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DrawAuto(ID3D11DeviceContext *iface)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p.\n", iface);
+
+    deferred_calls_add(&context->calls, DEFERRED_DRAW_AUTO, sizeof(struct deferred_call));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DrawIndexedInstancedIndirect(ID3D11DeviceContext *iface,
+        ID3D11Buffer *buffer, UINT offset)
+{
+    TRACE("iface %p, buffer %p, offset %u.\n", iface, buffer, offset);
+
+    deferred_context_add_object_call(impl_from_deferred_ID3D11DeviceContext(iface),
+            DEFERRED_DRAW_INDEXED_INSTANCED_INDIRECT, buffer, offset);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DrawInstancedIndirect(ID3D11DeviceContext *iface,
+        ID3D11Buffer *buffer, UINT offset)
+{
+    TRACE("iface %p, buffer %p, offset %u.\n", iface, buffer, offset);
+
+    deferred_context_add_object_call(impl_from_deferred_ID3D11DeviceContext(iface),
+            DEFERRED_DRAW_INSTANCED_INDIRECT, buffer, offset);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_Dispatch(ID3D11DeviceContext *iface,
+        UINT thread_group_count_x, UINT thread_group_count_y, UINT thread_group_count_z)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct deferred_call_dispatch *call;
+
+    TRACE("iface %p, thread_group_count_x %u, thread_group_count_y %u, thread_group_count_z %u.\n",
+            iface, thread_group_count_x, thread_group_count_y, thread_group_count_z);
+
+    if (!(call = deferred_calls_add(&context->calls, DEFERRED_DISPATCH, sizeof(*call))))
+        return;
+
+    call->x = thread_group_count_x;
+    call->y = thread_group_count_y;
+    call->z = thread_group_count_z;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DispatchIndirect(ID3D11DeviceContext *iface,
+        ID3D11Buffer *buffer, UINT offset)
+{
+    TRACE("iface %p, buffer %p, offset %u.\n", iface, buffer, offset);
+
+    deferred_context_add_object_call(impl_from_deferred_ID3D11DeviceContext(iface),
+            DEFERRED_DISPATCH_INDIRECT, buffer, offset);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_RSSetState(ID3D11DeviceContext *iface,
+        ID3D11RasterizerState *rasterizer_state)
+{
+    TRACE("iface %p, rasterizer_state %p.\n", iface, rasterizer_state);
+
+    deferred_context_add_object_call(impl_from_deferred_ID3D11DeviceContext(iface),
+            DEFERRED_RS_SET_STATE, rasterizer_state, 0);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_RSSetViewports(ID3D11DeviceContext *iface,
+        UINT viewport_count, const D3D11_VIEWPORT *viewports)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct deferred_call_rs_set_viewports *call;
+
+    TRACE("iface %p, viewport_count %u, viewports %p.\n", iface, viewport_count, viewports);
+
+    if (!(call = deferred_calls_add(&context->calls, DEFERRED_RS_SET_VIEWPORTS,
+            FIELD_OFFSET(struct deferred_call_rs_set_viewports, viewports[viewport_count]))))
+        return;
+
+    call->count = viewport_count;
+    if (viewport_count)
+        memcpy(call->viewports, viewports, viewport_count * sizeof(*viewports));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_RSSetScissorRects(ID3D11DeviceContext *iface,
+        UINT rect_count, const D3D11_RECT *rects)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct deferred_call_rs_set_scissor_rects *call;
+
+    TRACE("iface %p, rect_count %u, rects %p.\n", iface, rect_count, rects);
+
+    if (!(call = deferred_calls_add(&context->calls, DEFERRED_RS_SET_SCISSOR_RECTS,
+            FIELD_OFFSET(struct deferred_call_rs_set_scissor_rects, rects[rect_count]))))
+        return;
+
+    call->count = rect_count;
+    if (rect_count)
+        memcpy(call->rects, rects, rect_count * sizeof(*rects));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CopySubresourceRegion(ID3D11DeviceContext *iface,
+        ID3D11Resource *dst_resource, UINT dst_subresource_idx, UINT dst_x, UINT dst_y, UINT dst_z,
+        ID3D11Resource *src_resource, UINT src_subresource_idx, const D3D11_BOX *src_box)
+{
+    struct deferred_call_copy *call;
+
+    TRACE("iface %p, dst_resource %p, dst_subresource_idx %u, dst_x %u, dst_y %u, dst_z %u, "
+            "src_resource %p, src_subresource_idx %u, src_box %p.\n",
+            iface, dst_resource, dst_subresource_idx, dst_x, dst_y, dst_z,
+            src_resource, src_subresource_idx, src_box);
+
+    if (!(call = deferred_context_add_copy(impl_from_deferred_ID3D11DeviceContext(iface),
+            DEFERRED_COPY_SUBRESOURCE_REGION, dst_resource, src_resource)))
+        return;
+
+    call->dst_subresource_idx = dst_subresource_idx;
+    call->dst_x = dst_x;
+    call->dst_y = dst_y;
+    call->dst_z = dst_z;
+    call->src_subresource_idx = src_subresource_idx;
+    if ((call->has_box = !!src_box))
+        call->box = *src_box;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CopyResource(ID3D11DeviceContext *iface,
+        ID3D11Resource *dst_resource, ID3D11Resource *src_resource)
+{
+    TRACE("iface %p, dst_resource %p, src_resource %p.\n", iface, dst_resource, src_resource);
+
+    deferred_context_add_copy(impl_from_deferred_ID3D11DeviceContext(iface),
+            DEFERRED_COPY_RESOURCE, dst_resource, src_resource);
+}
+
+static BOOL format_is_block_compressed(enum wined3d_format_id format)
+{
+    return (format >= WINED3DFMT_BC1_TYPELESS && format <= WINED3DFMT_BC5_SNORM)
+            || (format >= WINED3DFMT_BC6H_TYPELESS && format <= WINED3DFMT_BC7_UNORM_SRGB);
+}
+
+/* Returns the number of bytes UpdateSubresource() reads from "data". */
+static SIZE_T deferred_context_get_update_size(struct d3d11_deferred_context *context,
+        ID3D11Resource *resource, UINT subresource_idx, const D3D11_BOX *box, UINT row_pitch, UINT depth_pitch)
+{
+    struct wined3d_device_creation_parameters params;
+    struct wined3d_sub_resource_desc sub_resource_desc;
+    struct wined3d_resource *wined3d_resource;
+    unsigned int width, height, depth;
+    struct wined3d_resource_desc desc;
+    SIZE_T size = 0;
+
+    wined3d_resource = wined3d_resource_from_d3d11_resource(resource);
+
+    wined3d_mutex_lock();
+    wined3d_resource_get_desc(wined3d_resource, &desc);
+    if (desc.resource_type == WINED3D_RTYPE_BUFFER)
+    {
+        size = box ? (box->right > box->left ? box->right - box->left : 0) : desc.size;
+    }
+    else if (SUCCEEDED(wined3d_texture_get_sub_resource_desc(wined3d_texture_from_resource(wined3d_resource),
+            subresource_idx, &sub_resource_desc)))
+    {
+        width = box ? (box->right > box->left ? box->right - box->left : 0) : sub_resource_desc.width;
+        height = box ? (box->bottom > box->top ? box->bottom - box->top : 0) : sub_resource_desc.height;
+        depth = box ? (box->back > box->front ? box->back - box->front : 0) : sub_resource_desc.depth;
+        if (format_is_block_compressed(sub_resource_desc.format))
+            height = (height + 3) / 4;
+
+        if (width && height && depth)
+        {
+            wined3d_device_get_creation_parameters(context->device->wined3d_device, &params);
+            size = (SIZE_T)(depth - 1) * depth_pitch + (SIZE_T)(height - 1) * row_pitch
+                    + wined3d_calculate_format_pitch(wined3d_device_get_wined3d(context->device->wined3d_device),
+                    params.adapter_idx, sub_resource_desc.format, width);
+        }
+    }
+    wined3d_mutex_unlock();
+
+    return size;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_UpdateSubresource(ID3D11DeviceContext *iface,
+        ID3D11Resource *resource, UINT subresource_idx, const D3D11_BOX *box,
+        const void *data, UINT row_pitch, UINT depth_pitch)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct deferred_call_update_subresource *call;
+    SIZE_T size;
+
+    TRACE("iface %p, resource %p, subresource_idx %u, box %p, data %p, row_pitch %u, depth_pitch %u.\n",
+            iface, resource, subresource_idx, box, data, row_pitch, depth_pitch);
+
+    size = deferred_context_get_update_size(context, resource, subresource_idx, box, row_pitch, depth_pitch);
+    if (!(call = deferred_calls_add(&context->calls, DEFERRED_UPDATE_SUBRESOURCE,
+            FIELD_OFFSET(struct deferred_call_update_subresource, data[size]))))
+        return;
+
+    call->resource = deferred_calls_add_object(&context->calls, resource);
+    call->subresource_idx = subresource_idx;
+    if ((call->has_box = !!box))
+        call->box = *box;
+    call->row_pitch = row_pitch;
+    call->depth_pitch = depth_pitch;
+    memcpy(call->data, data, size);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CopyStructureCount(ID3D11DeviceContext *iface,
+        ID3D11Buffer *dst_buffer, UINT dst_offset, ID3D11UnorderedAccessView *src_view)
+{
+    struct deferred_call_copy *call;
+
+    TRACE("iface %p, dst_buffer %p, dst_offset %u, src_view %p.\n",
+            iface, dst_buffer, dst_offset, src_view);
+
+    if (!(call = deferred_context_add_copy(impl_from_deferred_ID3D11DeviceContext(iface),
+            DEFERRED_COPY_STRUCTURE_COUNT, dst_buffer, src_view)))
+        return;
+
+    call->dst_x = dst_offset;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_ClearRenderTargetView(ID3D11DeviceContext *iface,
+        ID3D11RenderTargetView *render_target_view, const float color_rgba[4])
+{
+    struct deferred_call_clear *call;
+
+    TRACE("iface %p, render_target_view %p, color_rgba %s.\n",
+            iface, render_target_view, debug_float4(color_rgba));
+
+    if (!(call = deferred_context_add_clear(impl_from_deferred_ID3D11DeviceContext(iface),
+            DEFERRED_CLEAR_RENDER_TARGET_VIEW, render_target_view)))
+        return;
+
+    memcpy(call->color, color_rgba, sizeof(call->color));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_ClearUnorderedAccessViewUint(ID3D11DeviceContext *iface,
+        ID3D11UnorderedAccessView *unordered_access_view, const UINT values[4])
+{
+    struct deferred_call_clear *call;
+
+    TRACE("iface %p, unordered_access_view %p, values {%u, %u, %u, %u}.\n",
+            iface, unordered_access_view, values[0], values[1], values[2], values[3]);
+
+    if (!(call = deferred_context_add_clear(impl_from_deferred_ID3D11DeviceContext(iface),
+            DEFERRED_CLEAR_UNORDERED_ACCESS_VIEW_UINT, unordered_access_view)))
+        return;
+
+    memcpy(call->values, values, sizeof(call->values));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_ClearUnorderedAccessViewFloat(ID3D11DeviceContext *iface,
+        ID3D11UnorderedAccessView *unordered_access_view, const float values[4])
+{
+    struct deferred_call_clear *call;
+
+    TRACE("iface %p, unordered_access_view %p, values %s.\n",
+            iface, unordered_access_view, debug_float4(values));
+
+    if (!(call = deferred_context_add_clear(impl_from_deferred_ID3D11DeviceContext(iface),
+            DEFERRED_CLEAR_UNORDERED_ACCESS_VIEW_FLOAT, unordered_access_view)))
+        return;
+
+    memcpy(call->color, values, sizeof(call->color));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_ClearDepthStencilView(ID3D11DeviceContext *iface,
+        ID3D11DepthStencilView *depth_stencil_view, UINT flags, FLOAT depth, UINT8 stencil)
+{
+    struct deferred_call_clear *call;
+
+    TRACE("iface %p, depth_stencil_view %p, flags %#x, depth %.8e, stencil %u.\n",
+            iface, depth_stencil_view, flags, depth, stencil);
+
+    if (!(call = deferred_context_add_clear(impl_from_deferred_ID3D11DeviceContext(iface),
+            DEFERRED_CLEAR_DEPTH_STENCIL_VIEW, depth_stencil_view)))
+        return;
+
+    call->flags = flags;
+    call->depth = depth;
+    call->stencil = stencil;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GenerateMips(ID3D11DeviceContext *iface,
+        ID3D11ShaderResourceView *view)
+{
+    TRACE("iface %p, view %p.\n", iface, view);
+
+    deferred_context_add_object_call(impl_from_deferred_ID3D11DeviceContext(iface),
+            DEFERRED_GENERATE_MIPS, view, 0);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_SetResourceMinLOD(ID3D11DeviceContext *iface,
+        ID3D11Resource *resource, FLOAT min_lod)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct deferred_call_object *call;
+
+    TRACE("iface %p, resource %p, min_lod %.8e.\n", iface, resource, min_lod);
+
+    if (!(call = deferred_calls_add(&context->calls, DEFERRED_SET_RESOURCE_MIN_LOD, sizeof(*call))))
+        return;
+
+    call->object = deferred_calls_add_object(&context->calls, resource);
+    call->min_lod = min_lod;
+}
+
+static FLOAT STDMETHODCALLTYPE d3d11_deferred_context_GetResourceMinLOD(ID3D11DeviceContext *iface,
+        ID3D11Resource *resource)
+{
+    FIXME("iface %p, resource %p stub!\n", iface, resource);
+
+    return 0.0f;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_ResolveSubresource(ID3D11DeviceContext *iface,
+        ID3D11Resource *dst_resource, UINT dst_subresource_idx,
+        ID3D11Resource *src_resource, UINT src_subresource_idx,
+        DXGI_FORMAT format)
+{
+    struct deferred_call_copy *call;
+
+    TRACE("iface %p, dst_resource %p, dst_subresource_idx %u, src_resource %p, src_subresource_idx %u, "
+            "format %s.\n",
+            iface, dst_resource, dst_subresource_idx, src_resource, src_subresource_idx,
+            debug_dxgi_format(format));
+
+    if (!(call = deferred_context_add_copy(impl_from_deferred_ID3D11DeviceContext(iface),
+            DEFERRED_RESOLVE_SUBRESOURCE, dst_resource, src_resource)))
+        return;
+
+    call->dst_subresource_idx = dst_subresource_idx;
+    call->src_subresource_idx = src_subresource_idx;
+    call->format = format;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_ExecuteCommandList(ID3D11DeviceContext *iface,
+        ID3D11CommandList *command_list, BOOL restore_state)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct deferred_call_execute_command_list *call;
+
+    TRACE("iface %p, command_list %p, restore_state %#x.\n", iface, command_list, restore_state);
+
+    if (!unsafe_impl_from_ID3D11CommandList(command_list))
+        return;
+
+    if (!(call = deferred_calls_add(&context->calls, DEFERRED_EXECUTE_COMMAND_LIST, sizeof(*call))))
+        return;
+
+    call->command_list = deferred_calls_add_object(&context->calls, command_list);
+    call->restore_state = restore_state;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSSetShaderResources(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+{
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    deferred_context_set_views(impl_from_deferred_ID3D11DeviceContext(iface), DEFERRED_SET_SHADER_RESOURCES,
+            DEFERRED_STAGE_HS, start_slot, view_count, (void *const *)views);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSSetShader(ID3D11DeviceContext *iface,
+        ID3D11HullShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+{
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    deferred_context_set_shader(impl_from_deferred_ID3D11DeviceContext(iface),
+            DEFERRED_STAGE_HS, shader, class_instance_count);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSSetSamplers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+{
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n", iface, start_slot, sampler_count, samplers);
+
+    deferred_context_set_views(impl_from_deferred_ID3D11DeviceContext(iface), DEFERRED_SET_SAMPLERS,
+            DEFERRED_STAGE_HS, start_slot, sampler_count, (void *const *)samplers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSSetConstantBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n", iface, start_slot, buffer_count, buffers);
+
+    deferred_context_set_views(impl_from_deferred_ID3D11DeviceContext(iface), DEFERRED_SET_CONSTANT_BUFFERS,
+            DEFERRED_STAGE_HS, start_slot, buffer_count, (void *const *)buffers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSSetShaderResources(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+{
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    deferred_context_set_views(impl_from_deferred_ID3D11DeviceContext(iface), DEFERRED_SET_SHADER_RESOURCES,
+            DEFERRED_STAGE_DS, start_slot, view_count, (void *const *)views);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSSetShader(ID3D11DeviceContext *iface,
+        ID3D11DomainShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+{
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    deferred_context_set_shader(impl_from_deferred_ID3D11DeviceContext(iface),
+            DEFERRED_STAGE_DS, shader, class_instance_count);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSSetSamplers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+{
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n", iface, start_slot, sampler_count, samplers);
+
+    deferred_context_set_views(impl_from_deferred_ID3D11DeviceContext(iface), DEFERRED_SET_SAMPLERS,
+            DEFERRED_STAGE_DS, start_slot, sampler_count, (void *const *)samplers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSSetConstantBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n", iface, start_slot, buffer_count, buffers);
+
+    deferred_context_set_views(impl_from_deferred_ID3D11DeviceContext(iface), DEFERRED_SET_CONSTANT_BUFFERS,
+            DEFERRED_STAGE_DS, start_slot, buffer_count, (void *const *)buffers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSSetShaderResources(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+{
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    deferred_context_set_views(impl_from_deferred_ID3D11DeviceContext(iface), DEFERRED_SET_SHADER_RESOURCES,
+            DEFERRED_STAGE_CS, start_slot, view_count, (void *const *)views);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSSetUnorderedAccessViews(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT view_count, ID3D11UnorderedAccessView *const *views, const UINT *initial_counts)
+{
+    TRACE("iface %p, start_slot %u, view_count %u, views %p, initial_counts %p.\n",
+            iface, start_slot, view_count, views, initial_counts);
+
+    deferred_context_set_targets(impl_from_deferred_ID3D11DeviceContext(iface),
+            DEFERRED_CS_SET_UNORDERED_ACCESS_VIEWS, 0, NULL, NULL,
+            start_slot, view_count, views, initial_counts);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSSetShader(ID3D11DeviceContext *iface,
+        ID3D11ComputeShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+{
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    deferred_context_set_shader(impl_from_deferred_ID3D11DeviceContext(iface),
+            DEFERRED_STAGE_CS, shader, class_instance_count);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSSetSamplers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+{
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n", iface, start_slot, sampler_count, samplers);
+
+    deferred_context_set_views(impl_from_deferred_ID3D11DeviceContext(iface), DEFERRED_SET_SAMPLERS,
+            DEFERRED_STAGE_CS, start_slot, sampler_count, (void *const *)samplers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSSetConstantBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n", iface, start_slot, buffer_count, buffers);
+
+    deferred_context_set_views(impl_from_deferred_ID3D11DeviceContext(iface), DEFERRED_SET_CONSTANT_BUFFERS,
+            DEFERRED_STAGE_CS, start_slot, buffer_count, (void *const *)buffers);
+}
+
+/* The state of deferred contexts isn't tracked, the getters below only
+ * return empty state. */
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSGetConstantBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
+{
+    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p stub!\n", iface, start_slot, buffer_count, buffers);
+
+    memset(buffers, 0, buffer_count * sizeof(*buffers));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSGetShaderResources(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
+{
+    FIXME("iface %p, start_slot %u, view_count %u, views %p stub!\n", iface, start_slot, view_count, views);
+
+    memset(views, 0, view_count * sizeof(*views));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSGetShader(ID3D11DeviceContext *iface,
+        ID3D11PixelShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
+{
+    FIXME("iface %p, shader %p, class_instances %p, class_instance_count %p stub!\n",
+            iface, shader, class_instances, class_instance_count);
+
+    *shader = NULL;
+    if (class_instance_count)
+        *class_instance_count = 0;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSGetSamplers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
+{
+    FIXME("iface %p, start_slot %u, sampler_count %u, samplers %p stub!\n",
+            iface, start_slot, sampler_count, samplers);
+
+    memset(samplers, 0, sampler_count * sizeof(*samplers));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSGetShader(ID3D11DeviceContext *iface,
+        ID3D11VertexShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
+{
+    FIXME("iface %p, shader %p, class_instances %p, class_instance_count %p stub!\n",
+            iface, shader, class_instances, class_instance_count);
+
+    *shader = NULL;
+    if (class_instance_count)
+        *class_instance_count = 0;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSGetConstantBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
+{
+    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p stub!\n", iface, start_slot, buffer_count, buffers);
+
+    memset(buffers, 0, buffer_count * sizeof(*buffers));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_IAGetInputLayout(ID3D11DeviceContext *iface,
+        ID3D11InputLayout **input_layout)
+{
+    FIXME("iface %p, input_layout %p stub!\n", iface, input_layout);
+
+    *input_layout = NULL;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_IAGetVertexBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers, UINT *strides, UINT *offsets)
+{
+    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p, strides %p, offsets %p stub!\n",
+            iface, start_slot, buffer_count, buffers, strides, offsets);
+
+    if (buffers)
+        memset(buffers, 0, buffer_count * sizeof(*buffers));
+    if (strides)
+        memset(strides, 0, buffer_count * sizeof(*strides));
+    if (offsets)
+        memset(offsets, 0, buffer_count * sizeof(*offsets));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_IAGetIndexBuffer(ID3D11DeviceContext *iface,
+        ID3D11Buffer **buffer, DXGI_FORMAT *format, UINT *offset)
+{
+    FIXME("iface %p, buffer %p, format %p, offset %p stub!\n", iface, buffer, format, offset);
+
+    if (buffer)
+        *buffer = NULL;
+    if (format)
+        *format = DXGI_FORMAT_UNKNOWN;
+    if (offset)
+        *offset = 0;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSGetConstantBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
+{
+    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p stub!\n", iface, start_slot, buffer_count, buffers);
+
+    memset(buffers, 0, buffer_count * sizeof(*buffers));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSGetShader(ID3D11DeviceContext *iface,
+        ID3D11GeometryShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
+{
+    FIXME("iface %p, shader %p, class_instances %p, class_instance_count %p stub!\n",
+            iface, shader, class_instances, class_instance_count);
+
+    *shader = NULL;
+    if (class_instance_count)
+        *class_instance_count = 0;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_IAGetPrimitiveTopology(ID3D11DeviceContext *iface,
+        D3D11_PRIMITIVE_TOPOLOGY *topology)
+{
+    FIXME("iface %p, topology %p stub!\n", iface, topology);
+
+    *topology = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSGetShaderResources(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
+{
+    FIXME("iface %p, start_slot %u, view_count %u, views %p stub!\n", iface, start_slot, view_count, views);
+
+    memset(views, 0, view_count * sizeof(*views));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSGetSamplers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
+{
+    FIXME("iface %p, start_slot %u, sampler_count %u, samplers %p stub!\n",
+            iface, start_slot, sampler_count, samplers);
+
+    memset(samplers, 0, sampler_count * sizeof(*samplers));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GetPredication(ID3D11DeviceContext *iface,
+        ID3D11Predicate **predicate, BOOL *value)
+{
+    FIXME("iface %p, predicate %p, value %p stub!\n", iface, predicate, value);
+
+    if (predicate)
+        *predicate = NULL;
+    if (value)
+        *value = FALSE;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSGetShaderResources(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
+{
+    FIXME("iface %p, start_slot %u, view_count %u, views %p stub!\n", iface, start_slot, view_count, views);
+
+    memset(views, 0, view_count * sizeof(*views));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSGetSamplers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
+{
+    FIXME("iface %p, start_slot %u, sampler_count %u, samplers %p stub!\n",
+            iface, start_slot, sampler_count, samplers);
+
+    memset(samplers, 0, sampler_count * sizeof(*samplers));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_OMGetRenderTargets(ID3D11DeviceContext *iface,
+        UINT render_target_view_count, ID3D11RenderTargetView **render_target_views,
+        ID3D11DepthStencilView **depth_stencil_view)
+{
+    FIXME("iface %p, render_target_view_count %u, render_target_views %p, depth_stencil_view %p stub!\n",
+            iface, render_target_view_count, render_target_views, depth_stencil_view);
+
+    if (render_target_views)
+        memset(render_target_views, 0, render_target_view_count * sizeof(*render_target_views));
+    if (depth_stencil_view)
+        *depth_stencil_view = NULL;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_OMGetRenderTargetsAndUnorderedAccessViews(
+        ID3D11DeviceContext *iface,
+        UINT render_target_view_count, ID3D11RenderTargetView **render_target_views,
+        ID3D11DepthStencilView **depth_stencil_view,
+        UINT unordered_access_view_start_slot, UINT unordered_access_view_count,
+        ID3D11UnorderedAccessView **unordered_access_views)
+{
+    FIXME("iface %p, render_target_view_count %u, render_target_views %p, depth_stencil_view %p, "
+            "unordered_access_view_start_slot %u, unordered_access_view_count %u, "
+            "unordered_access_views %p stub!\n",
+            iface, render_target_view_count, render_target_views, depth_stencil_view,
+            unordered_access_view_start_slot, unordered_access_view_count, unordered_access_views);
+
+    if (render_target_views)
+        memset(render_target_views, 0, render_target_view_count * sizeof(*render_target_views));
+    if (depth_stencil_view)
+        *depth_stencil_view = NULL;
+    if (unordered_access_views)
+        memset(unordered_access_views, 0, unordered_access_view_count * sizeof(*unordered_access_views));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_OMGetBlendState(ID3D11DeviceContext *iface,
+        ID3D11BlendState **blend_state, FLOAT blend_factor[4], UINT *sample_mask)
+{
+    FIXME("iface %p, blend_state %p, blend_factor %p, sample_mask %p stub!\n",
+            iface, blend_state, blend_factor, sample_mask);
+
+    if (blend_state)
+        *blend_state = NULL;
+    if (blend_factor)
+        blend_factor[0] = blend_factor[1] = blend_factor[2] = blend_factor[3] = 1.0f;
+    if (sample_mask)
+        *sample_mask = D3D11_DEFAULT_SAMPLE_MASK;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_OMGetDepthStencilState(ID3D11DeviceContext *iface,
+        ID3D11DepthStencilState **depth_stencil_state, UINT *stencil_ref)
+{
+    FIXME("iface %p, depth_stencil_state %p, stencil_ref %p stub!\n",
+            iface, depth_stencil_state, stencil_ref);
+
+    if (depth_stencil_state)
+        *depth_stencil_state = NULL;
+    if (stencil_ref)
+        *stencil_ref = 0;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_SOGetTargets(ID3D11DeviceContext *iface,
+        UINT buffer_count, ID3D11Buffer **buffers)
+{
+    FIXME("iface %p, buffer_count %u, buffers %p stub!\n", iface, buffer_count, buffers);
+
+    memset(buffers, 0, buffer_count * sizeof(*buffers));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_RSGetState(ID3D11DeviceContext *iface,
+        ID3D11RasterizerState **rasterizer_state)
+{
+    FIXME("iface %p, rasterizer_state %p stub!\n", iface, rasterizer_state);
+
+    *rasterizer_state = NULL;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_RSGetViewports(ID3D11DeviceContext *iface,
+        UINT *viewport_count, D3D11_VIEWPORT *viewports)
+{
+    FIXME("iface %p, viewport_count %p, viewports %p stub!\n", iface, viewport_count, viewports);
+
+    if (viewport_count)
+        *viewport_count = 0;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_RSGetScissorRects(ID3D11DeviceContext *iface,
+        UINT *rect_count, D3D11_RECT *rects)
+{
+    FIXME("iface %p, rect_count %p, rects %p stub!\n", iface, rect_count, rects);
+
+    if (rect_count)
+        *rect_count = 0;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSGetShaderResources(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
+{
+    FIXME("iface %p, start_slot %u, view_count %u, views %p stub!\n", iface, start_slot, view_count, views);
+
+    memset(views, 0, view_count * sizeof(*views));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSGetShader(ID3D11DeviceContext *iface,
+        ID3D11HullShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
+{
+    FIXME("iface %p, shader %p, class_instances %p, class_instance_count %p stub!\n",
+            iface, shader, class_instances, class_instance_count);
+
+    *shader = NULL;
+    if (class_instance_count)
+        *class_instance_count = 0;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSGetSamplers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
+{
+    FIXME("iface %p, start_slot %u, sampler_count %u, samplers %p stub!\n",
+            iface, start_slot, sampler_count, samplers);
+
+    memset(samplers, 0, sampler_count * sizeof(*samplers));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSGetConstantBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
+{
+    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p stub!\n", iface, start_slot, buffer_count, buffers);
+
+    memset(buffers, 0, buffer_count * sizeof(*buffers));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSGetShaderResources(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
+{
+    FIXME("iface %p, start_slot %u, view_count %u, views %p stub!\n", iface, start_slot, view_count, views);
+
+    memset(views, 0, view_count * sizeof(*views));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSGetShader(ID3D11DeviceContext *iface,
+        ID3D11DomainShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
+{
+    FIXME("iface %p, shader %p, class_instances %p, class_instance_count %p stub!\n",
+            iface, shader, class_instances, class_instance_count);
+
+    *shader = NULL;
+    if (class_instance_count)
+        *class_instance_count = 0;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSGetSamplers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
+{
+    FIXME("iface %p, start_slot %u, sampler_count %u, samplers %p stub!\n",
+            iface, start_slot, sampler_count, samplers);
+
+    memset(samplers, 0, sampler_count * sizeof(*samplers));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSGetConstantBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
+{
+    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p stub!\n", iface, start_slot, buffer_count, buffers);
+
+    memset(buffers, 0, buffer_count * sizeof(*buffers));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSGetShaderResources(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
+{
+    FIXME("iface %p, start_slot %u, view_count %u, views %p stub!\n", iface, start_slot, view_count, views);
+
+    memset(views, 0, view_count * sizeof(*views));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSGetUnorderedAccessViews(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT view_count, ID3D11UnorderedAccessView **views)
+{
+    FIXME("iface %p, start_slot %u, view_count %u, views %p stub!\n", iface, start_slot, view_count, views);
+
+    memset(views, 0, view_count * sizeof(*views));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSGetShader(ID3D11DeviceContext *iface,
+        ID3D11ComputeShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
+{
+    FIXME("iface %p, shader %p, class_instances %p, class_instance_count %p stub!\n",
+            iface, shader, class_instances, class_instance_count);
+
+    *shader = NULL;
+    if (class_instance_count)
+        *class_instance_count = 0;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSGetSamplers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
+{
+    FIXME("iface %p, start_slot %u, sampler_count %u, samplers %p stub!\n",
+            iface, start_slot, sampler_count, samplers);
+
+    memset(samplers, 0, sampler_count * sizeof(*samplers));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSGetConstantBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
+{
+    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p stub!\n", iface, start_slot, buffer_count, buffers);
+
+    memset(buffers, 0, buffer_count * sizeof(*buffers));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_ClearState(ID3D11DeviceContext *iface)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p.\n", iface);
+
+    deferred_calls_add(&context->calls, DEFERRED_CLEAR_STATE, sizeof(struct deferred_call));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_Flush(ID3D11DeviceContext *iface)
+{
+    TRACE("iface %p.\n", iface);
+}
+
+static D3D11_DEVICE_CONTEXT_TYPE STDMETHODCALLTYPE d3d11_deferred_context_GetType(ID3D11DeviceContext *iface)
+{
+    TRACE("iface %p.\n", iface);
+
+    return D3D11_DEVICE_CONTEXT_DEFERRED;
+}
+
+static UINT STDMETHODCALLTYPE d3d11_deferred_context_GetContextFlags(ID3D11DeviceContext *iface)
+{
+    TRACE("iface %p.\n", iface);
+
+    return 0;
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_deferred_context_FinishCommandList(ID3D11DeviceContext *iface,
+        BOOL restore, ID3D11CommandList **command_list)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct d3d11_command_list *object;
+
+    TRACE("iface %p, restore %#x, command_list %p.\n", iface, restore, command_list);
+
+    if (restore)
+        FIXME("Restoring the deferred context state is not implemented.\n");
+
+    if (!(object = heap_alloc_zero(sizeof(*object))))
+        return E_OUTOFMEMORY;
+
+    object->ID3D11CommandList_iface.lpVtbl = &d3d11_command_list_vtbl;
+    object->refcount = 1;
+    wined3d_private_store_init(&object->private_store);
+    object->calls = context->calls;
+    object->device = &context->device->ID3D11Device_iface;
+    ID3D11Device_AddRef(object->device);
+
+    memset(&context->calls, 0, sizeof(context->calls));
+    context->map_count = 0;
+
+    TRACE("Created command list %p.\n", object);
+    *command_list = &object->ID3D11CommandList_iface;
+
+    return S_OK;
+}
+
+static const struct ID3D11DeviceContextVtbl d3d11_deferred_context_vtbl =
+{
+    /* IUnknown methods */
+    d3d11_deferred_context_QueryInterface,
+    d3d11_deferred_context_AddRef,
+    d3d11_deferred_context_Release,
+    /* ID3D11DeviceChild methods */
+    d3d11_deferred_context_GetDevice,
+    d3d11_deferred_context_GetPrivateData,
+    d3d11_deferred_context_SetPrivateData,
+    d3d11_deferred_context_SetPrivateDataInterface,
+    /* ID3D11DeviceContext methods */
+    d3d11_deferred_context_VSSetConstantBuffers,
+    d3d11_deferred_context_PSSetShaderResources,
+    d3d11_deferred_context_PSSetShader,
+    d3d11_deferred_context_PSSetSamplers,
+    d3d11_deferred_context_VSSetShader,
+    d3d11_deferred_context_DrawIndexed,
+    d3d11_deferred_context_Draw,
+    d3d11_deferred_context_Map,
+    d3d11_deferred_context_Unmap,
+    d3d11_deferred_context_PSSetConstantBuffers,
+    d3d11_deferred_context_IASetInputLayout,
+    d3d11_deferred_context_IASetVertexBuffers,
+    d3d11_deferred_context_IASetIndexBuffer,
+    d3d11_deferred_context_DrawIndexedInstanced,
+    d3d11_deferred_context_DrawInstanced,
+    d3d11_deferred_context_GSSetConstantBuffers,
+    d3d11_deferred_context_GSSetShader,
+    d3d11_deferred_context_IASetPrimitiveTopology,
+    d3d11_deferred_context_VSSetShaderResources,
+    d3d11_deferred_context_VSSetSamplers,
+    d3d11_deferred_context_Begin,
+    d3d11_deferred_context_End,
+    d3d11_deferred_context_GetData,
+    d3d11_deferred_context_SetPredication,
+    d3d11_deferred_context_GSSetShaderResources,
+    d3d11_deferred_context_GSSetSamplers,
+    d3d11_deferred_context_OMSetRenderTargets,
+    d3d11_deferred_context_OMSetRenderTargetsAndUnorderedAccessViews,
+    d3d11_deferred_context_OMSetBlendState,
+    d3d11_deferred_context_OMSetDepthStencilState,
+    d3d11_deferred_context_SOSetTargets,
+    d3d11_deferred_context_DrawAuto,
+    d3d11_deferred_context_DrawIndexedInstancedIndirect,
+    d3d11_deferred_context_DrawInstancedIndirect,
+    d3d11_deferred_context_Dispatch,
+    d3d11_deferred_context_DispatchIndirect,
+    d3d11_deferred_context_RSSetState,
+    d3d11_deferred_context_RSSetViewports,
+    d3d11_deferred_context_RSSetScissorRects,
+    d3d11_deferred_context_CopySubresourceRegion,
+    d3d11_deferred_context_CopyResource,
+    d3d11_deferred_context_UpdateSubresource,
+    d3d11_deferred_context_CopyStructureCount,
+    d3d11_deferred_context_ClearRenderTargetView,
+    d3d11_deferred_context_ClearUnorderedAccessViewUint,
+    d3d11_deferred_context_ClearUnorderedAccessViewFloat,
+    d3d11_deferred_context_ClearDepthStencilView,
+    d3d11_deferred_context_GenerateMips,
+    d3d11_deferred_context_SetResourceMinLOD,
+    d3d11_deferred_context_GetResourceMinLOD,
+    d3d11_deferred_context_ResolveSubresource,
+    d3d11_deferred_context_ExecuteCommandList,
+    d3d11_deferred_context_HSSetShaderResources,
+    d3d11_deferred_context_HSSetShader,
+    d3d11_deferred_context_HSSetSamplers,
+    d3d11_deferred_context_HSSetConstantBuffers,
+    d3d11_deferred_context_DSSetShaderResources,
+    d3d11_deferred_context_DSSetShader,
+    d3d11_deferred_context_DSSetSamplers,
+    d3d11_deferred_context_DSSetConstantBuffers,
+    d3d11_deferred_context_CSSetShaderResources,
+    d3d11_deferred_context_CSSetUnorderedAccessViews,
+    d3d11_deferred_context_CSSetShader,
+    d3d11_deferred_context_CSSetSamplers,
+    d3d11_deferred_context_CSSetConstantBuffers,
+    d3d11_deferred_context_VSGetConstantBuffers,
+    d3d11_deferred_context_PSGetShaderResources,
+    d3d11_deferred_context_PSGetShader,
+    d3d11_deferred_context_PSGetSamplers,
+    d3d11_deferred_context_VSGetShader,
+    d3d11_deferred_context_PSGetConstantBuffers,
+    d3d11_deferred_context_IAGetInputLayout,
+    d3d11_deferred_context_IAGetVertexBuffers,
+    d3d11_deferred_context_IAGetIndexBuffer,
+    d3d11_deferred_context_GSGetConstantBuffers,
+    d3d11_deferred_context_GSGetShader,
+    d3d11_deferred_context_IAGetPrimitiveTopology,
+    d3d11_deferred_context_VSGetShaderResources,
+    d3d11_deferred_context_VSGetSamplers,
+    d3d11_deferred_context_GetPredication,
+    d3d11_deferred_context_GSGetShaderResources,
+    d3d11_deferred_context_GSGetSamplers,
+    d3d11_deferred_context_OMGetRenderTargets,
+    d3d11_deferred_context_OMGetRenderTargetsAndUnorderedAccessViews,
+    d3d11_deferred_context_OMGetBlendState,
+    d3d11_deferred_context_OMGetDepthStencilState,
+    d3d11_deferred_context_SOGetTargets,
+    d3d11_deferred_context_RSGetState,
+    d3d11_deferred_context_RSGetViewports,
+    d3d11_deferred_context_RSGetScissorRects,
+    d3d11_deferred_context_HSGetShaderResources,
+    d3d11_deferred_context_HSGetShader,
+    d3d11_deferred_context_HSGetSamplers,
+    d3d11_deferred_context_HSGetConstantBuffers,
+    d3d11_deferred_context_DSGetShaderResources,
+    d3d11_deferred_context_DSGetShader,
+    d3d11_deferred_context_DSGetSamplers,
+    d3d11_deferred_context_DSGetConstantBuffers,
+    d3d11_deferred_context_CSGetShaderResources,
+    d3d11_deferred_context_CSGetUnorderedAccessViews,
+    d3d11_deferred_context_CSGetShader,
+    d3d11_deferred_context_CSGetSamplers,
+    d3d11_deferred_context_CSGetConstantBuffers,
+    d3d11_deferred_context_ClearState,
+    d3d11_deferred_context_Flush,
+    d3d11_deferred_context_GetType,
+    d3d11_deferred_context_GetContextFlags,
+    d3d11_deferred_context_FinishCommandList,
+};
+
+HRESULT d3d11_deferred_context_create(struct d3d_device *device, ID3D11DeviceContext **context)
+{
+    struct d3d11_deferred_context *object;
+
+    if (!(object = heap_alloc_zero(sizeof(*object))))
+        return E_OUTOFMEMORY;
+
+    object->ID3D11DeviceContext_iface.lpVtbl = &d3d11_deferred_context_vtbl;
+    object->refcount = 1;
+    wined3d_private_store_init(&object->private_store);
+    object->device = device;
+    ID3D11Device_AddRef(&device->ID3D11Device_iface);
+
+    TRACE("Created deferred context %p.\n", object);
+    *context = &object->ID3D11DeviceContext_iface;
+
+    return S_OK;
+}
@@ -26549,6 +26549,97 @@ static void test_multisample_resolve(void)
     release_test_context(&test_context);
 }
 
+static void test_deferred_context(void)
+{
+    static const float green[] = {0.0f, 1.0f, 0.0f, 1.0f};
+    static const float red[] = {1.0f, 0.0f, 0.0f, 1.0f};
+    static const DWORD data[] = {0x01020304, 0x05060708, 0x090a0b0c, 0x0d0e0f10};
+
+    struct d3d11_test_context test_context;
+    ID3D11DeviceContext *context, *deferred;
+    D3D11_MAPPED_SUBRESOURCE map_desc;
+    ID3D11Buffer *buffer, *dst_buffer;
+    ID3D11CommandList *command_list;
+    D3D11_BUFFER_DESC buffer_desc;
+    ID3D11RenderTargetView *rtv;
+    struct resource_readback rb;
+    ID3D11Device *device;
+    unsigned int i;
+    HRESULT hr;
+
+    if (!init_test_context(&test_context, NULL))
+        return;
+
+    device = test_context.device;
+    context = test_context.immediate_context;
+
+    hr = ID3D11Device_CreateDeferredContext(device, 0, &deferred);
+    ok(SUCCEEDED(hr), "Failed to create deferred context, hr %#x.\n", hr);
+    ok(ID3D11DeviceContext_GetType(deferred) == D3D11_DEVICE_CONTEXT_DEFERRED,
+            "Got unexpected context type %#x.\n", ID3D11DeviceContext_GetType(deferred));
+
+    ID3D11DeviceContext_OMSetRenderTargets(deferred, 1, &test_context.backbuffer_rtv, NULL);
+    ID3D11DeviceContext_ClearRenderTargetView(deferred, test_context.backbuffer_rtv, green);
+    hr = ID3D11DeviceContext_FinishCommandList(deferred, FALSE, &command_list);
+    ok(SUCCEEDED(hr), "Failed to finish command list, hr %#x.\n", hr);
+
+    /* Nothing is executed before ExecuteCommandList(). */
+    ID3D11DeviceContext_ClearRenderTargetView(context, test_context.backbuffer_rtv, red);
+    check_texture_color(test_context.backbuffer, 0xff0000ff, 0);
+
+    ID3D11DeviceContext_OMSetRenderTargets(context, 0, NULL, NULL);
+    ID3D11DeviceContext_ExecuteCommandList(context, command_list, TRUE);
+    check_texture_color(test_context.backbuffer, 0xff00ff00, 0);
+    ID3D11DeviceContext_OMGetRenderTargets(context, 1, &rtv, NULL);
+    ok(!rtv, "Got unexpected render target view %p.\n", rtv);
+
+    ID3D11DeviceContext_OMSetRenderTargets(context, 1, &test_context.backbuffer_rtv, NULL);
+    ID3D11DeviceContext_ExecuteCommandList(context, command_list, TRUE);
+    ID3D11DeviceContext_OMGetRenderTargets(context, 1, &rtv, NULL);
+    ok(rtv == test_context.backbuffer_rtv, "Got unexpected render target view %p.\n", rtv);
+    ID3D11RenderTargetView_Release(rtv);
+
+    ID3D11DeviceContext_ExecuteCommandList(context, command_list, FALSE);
+    ID3D11DeviceContext_OMGetRenderTargets(context, 1, &rtv, NULL);
+    ok(!rtv, "Got unexpected render target view %p.\n", rtv);
+    ID3D11CommandList_Release(command_list);
+
+    buffer_desc.ByteWidth = sizeof(data);
+    buffer_desc.Usage = D3D11_USAGE_DYNAMIC;
+    buffer_desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    buffer_desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    buffer_desc.MiscFlags = 0;
+    buffer_desc.StructureByteStride = 0;
+    hr = ID3D11Device_CreateBuffer(device, &buffer_desc, NULL, &buffer);
+    ok(SUCCEEDED(hr), "Failed to create buffer, hr %#x.\n", hr);
+    dst_buffer = create_buffer(device, D3D11_BIND_VERTEX_BUFFER, sizeof(data), NULL);
+
+    hr = ID3D11DeviceContext_Map(deferred, (ID3D11Resource *)buffer, 0, D3D11_MAP_WRITE, 0, &map_desc);
+    ok(hr == E_INVALIDARG, "Got unexpected hr %#x.\n", hr);
+    hr = ID3D11DeviceContext_Map(deferred, (ID3D11Resource *)buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &map_desc);
+    ok(SUCCEEDED(hr), "Failed to map buffer, hr %#x.\n", hr);
+    memcpy(map_desc.pData, data, sizeof(data));
+    ID3D11DeviceContext_Unmap(deferred, (ID3D11Resource *)buffer, 0);
+    ID3D11DeviceContext_CopyResource(deferred, (ID3D11Resource *)dst_buffer, (ID3D11Resource *)buffer);
+    hr = ID3D11DeviceContext_FinishCommandList(deferred, FALSE, &command_list);
+    ok(SUCCEEDED(hr), "Failed to finish command list, hr %#x.\n", hr);
+
+    ID3D11DeviceContext_ExecuteCommandList(context, command_list, FALSE);
+    get_buffer_readback(dst_buffer, &rb);
+    for (i = 0; i < ARRAY_SIZE(data); ++i)
+    {
+        DWORD color = get_readback_color(&rb, i, 0);
+        ok(color == data[i], "Got unexpected value 0x%08x at %u.\n", color, i);
+    }
+    release_resource_readback(&rb);
+
+    ID3D11CommandList_Release(command_list);
+    ID3D11Buffer_Release(dst_buffer);
+    ID3D11Buffer_Release(buffer);
+    ID3D11DeviceContext_Release(deferred);
+    release_test_context(&test_context);
+}
+
 START_TEST(d3d11)
 {
     unsigned int argc, i;
@@ -26686,4 +26777,5 @@ START_TEST(d3d11)
     test_unbound_multisample_texture();
     test_multiple_viewports();
     test_multisample_resolve();
+    test_deferred_context();
 }
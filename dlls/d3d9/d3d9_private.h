@@ -42,6 +42,7 @@
 
 #define D3D9_MAX_VERTEX_SHADER_CONSTANTF 256
 #define D3D9_MAX_TEXTURE_UNITS 20
+#define D3D9_UP_BUFFER_MIN_SIZE (512 * 1024)
 
 #define D3DPRESENTFLAGS_MASK 0x00000fffu
 
@@ -98,6 +99,7 @@ struct d3d9_device
     struct wined3d_buffer *index_buffer;
     UINT index_buffer_size;
     UINT index_buffer_pos;
+    BOOL up_vertex_buffer_bound;
 
     struct d3d9_surface *render_targets[D3D_MAX_SIMULTANEOUS_RENDERTARGETS];
 
@@ -115,6 +117,7 @@ struct d3d9_device
 HRESULT device_init(struct d3d9_device *device, struct d3d9 *parent, struct wined3d *wined3d,
         UINT adapter, D3DDEVTYPE device_type, HWND focus_window, DWORD flags,
         D3DPRESENT_PARAMETERS *parameters, D3DDISPLAYMODEEX *mode) DECLSPEC_HIDDEN;
+void d3d9_device_unbind_up_vertex_buffer(struct d3d9_device *device) DECLSPEC_HIDDEN;
 
 struct d3d9_resource
 {
@@ -579,6 +579,7 @@ static ULONG WINAPI DECLSPEC_HOTPATCH d3d9_device_Release(IDirect3DDevice9Ex *if
         }
         heap_free(device->fvf_decls);
 
+        d3d9_device_unbind_up_vertex_buffer(device);
         if (device->vertex_buffer)
             wined3d_buffer_decref(device->vertex_buffer);
         if (device->index_buffer)
@@ -939,6 +940,7 @@ static HRESULT d3d9_device_reset(struct d3d9_device *device,
 
     wined3d_mutex_lock();
 
+    d3d9_device_unbind_up_vertex_buffer(device);
     if (device->vertex_buffer)
     {
         wined3d_buffer_decref(device->vertex_buffer);
@@ -2281,6 +2283,7 @@ static HRESULT WINAPI d3d9_device_BeginStateBlock(IDirect3DDevice9Ex *iface)
     TRACE("iface %p.\n", iface);
 
     wined3d_mutex_lock();
+    d3d9_device_unbind_up_vertex_buffer(device);
     hr = wined3d_device_begin_stateblock(device->wined3d_device);
     wined3d_mutex_unlock();
 
@@ -2297,6 +2300,7 @@ static HRESULT WINAPI d3d9_device_EndStateBlock(IDirect3DDevice9Ex *iface, IDire
     TRACE("iface %p, stateblock %p.\n", iface, stateblock);
 
     wined3d_mutex_lock();
+    d3d9_device_unbind_up_vertex_buffer(device);
     hr = wined3d_device_end_stateblock(device->wined3d_device, &wined3d_stateblock);
     wined3d_mutex_unlock();
     if (FAILED(hr))
@@ -2668,6 +2672,7 @@ static HRESULT WINAPI d3d9_device_DrawPrimitive(IDirect3DDevice9Ex *iface,
         WARN("Called without a valid vertex declaration set.\n");
         return D3DERR_INVALIDCALL;
     }
+    d3d9_device_unbind_up_vertex_buffer(device);
     d3d9_generate_auto_mipmaps(device);
     wined3d_device_set_primitive_type(device->wined3d_device, primitive_type, 0);
     hr = wined3d_device_draw_primitive(device->wined3d_device, start_vertex,
@@ -2698,6 +2703,7 @@ static HRESULT WINAPI d3d9_device_DrawIndexedPrimitive(IDirect3DDevice9Ex *iface
         WARN("Called without a valid vertex declaration set.\n");
         return D3DERR_INVALIDCALL;
     }
+    d3d9_device_unbind_up_vertex_buffer(device);
     d3d9_generate_auto_mipmaps(device);
     wined3d_device_set_base_vertex_index(device->wined3d_device, base_vertex_idx);
     wined3d_device_set_primitive_type(device->wined3d_device, primitive_type, 0);
@@ -2710,6 +2716,18 @@ static HRESULT WINAPI d3d9_device_DrawIndexedPrimitive(IDirect3DDevice9Ex *iface
     return hr;
 }
 
+/* DrawPrimitiveUP() leaves its vertex buffer bound to stream 0, so that
+ * consecutive calls don't need to rebind it and wined3d can merge their
+ * draws. The caller is responsible for wined3d locking. */
+void d3d9_device_unbind_up_vertex_buffer(struct d3d9_device *device)
+{
+    if (!device->up_vertex_buffer_bound)
+        return;
+
+    device->up_vertex_buffer_bound = FALSE;
+    wined3d_device_set_stream_source(device->wined3d_device, 0, NULL, 0, 0);
+}
+
 /* The caller is responsible for wined3d locking */
 static HRESULT d3d9_device_prepare_vertex_buffer(struct d3d9_device *device, UINT min_size)
 {
@@ -2717,7 +2735,7 @@ static HRESULT d3d9_device_prepare_vertex_buffer(struct d3d9_device *device, UIN
 
     if (device->vertex_buffer_size < min_size || !device->vertex_buffer)
     {
-        UINT size = max(device->vertex_buffer_size * 2, min_size);
+        UINT size = max(max(device->vertex_buffer_size * 2, min_size), D3D9_UP_BUFFER_MIN_SIZE);
         struct wined3d_buffer_desc desc;
         struct wined3d_buffer *buffer;
 
@@ -2803,10 +2821,12 @@ static HRESULT WINAPI d3d9_device_DrawPrimitiveUP(IDirect3DDevice9Ex *iface,
     if (FAILED(hr))
         goto done;
 
+    /* Stream 0 is unbound lazily, see d3d9_device_unbind_up_vertex_buffer(). */
+    device->up_vertex_buffer_bound = TRUE;
+
     d3d9_generate_auto_mipmaps(device);
     wined3d_device_set_primitive_type(device->wined3d_device, primitive_type, 0);
     hr = wined3d_device_draw_primitive(device->wined3d_device, vb_pos / stride, vtx_count);
-    wined3d_device_set_stream_source(device->wined3d_device, 0, NULL, 0, 0);
     if (SUCCEEDED(hr))
         d3d9_rts_flag_auto_gen_mipmap(device);
 
@@ -2822,7 +2842,7 @@ static HRESULT d3d9_device_prepare_index_buffer(struct d3d9_device *device, UINT
 
     if (device->index_buffer_size < min_size || !device->index_buffer)
     {
-        UINT size = max(device->index_buffer_size * 2, min_size);
+        UINT size = max(max(device->index_buffer_size * 2, min_size), D3D9_UP_BUFFER_MIN_SIZE);
         struct wined3d_buffer_desc desc;
         struct wined3d_buffer *buffer;
 
@@ -2888,6 +2908,7 @@ static HRESULT WINAPI d3d9_device_DrawIndexedPrimitiveUP(IDirect3DDevice9Ex *ifa
         return D3DERR_INVALIDCALL;
     }
 
+    d3d9_device_unbind_up_vertex_buffer(device);
     hr = d3d9_device_prepare_vertex_buffer(device, vtx_size);
     if (FAILED(hr))
         goto done;
@@ -2969,6 +2990,7 @@ static HRESULT WINAPI d3d9_device_ProcessVertices(IDirect3DDevice9Ex *iface,
             iface, src_start_idx, dst_idx, vertex_count, dst_buffer, declaration, flags);
 
     wined3d_mutex_lock();
+    d3d9_device_unbind_up_vertex_buffer(device);
     hr = wined3d_device_process_vertices(device->wined3d_device, src_start_idx, dst_idx, vertex_count,
             dst_impl->wined3d_buffer, decl_impl ? decl_impl->wined3d_declaration : NULL,
             flags, dst_impl->fvf);
@@ -3349,6 +3371,7 @@ static HRESULT WINAPI d3d9_device_SetStreamSource(IDirect3DDevice9Ex *iface,
             iface, stream_idx, buffer, offset, stride);
 
     wined3d_mutex_lock();
+    d3d9_device_unbind_up_vertex_buffer(device);
     hr = wined3d_device_set_stream_source(device->wined3d_device, stream_idx,
             buffer_impl ? buffer_impl->wined3d_buffer : NULL, offset, stride);
     wined3d_mutex_unlock();
@@ -3371,6 +3394,7 @@ static HRESULT WINAPI d3d9_device_GetStreamSource(IDirect3DDevice9Ex *iface,
         return D3DERR_INVALIDCALL;
 
     wined3d_mutex_lock();
+    d3d9_device_unbind_up_vertex_buffer(device);
     hr = wined3d_device_get_stream_source(device->wined3d_device, stream_idx, &wined3d_buffer, offset, stride);
     if (SUCCEEDED(hr) && wined3d_buffer)
     {
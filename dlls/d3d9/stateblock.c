@@ -99,6 +99,7 @@ static HRESULT WINAPI d3d9_stateblock_Capture(IDirect3DStateBlock9 *iface)
     TRACE("iface %p.\n", iface);
 
     wined3d_mutex_lock();
+    d3d9_device_unbind_up_vertex_buffer(impl_from_IDirect3DDevice9Ex(stateblock->parent_device));
     wined3d_stateblock_capture(stateblock->wined3d_stateblock);
     wined3d_mutex_unlock();
 
@@ -112,6 +113,7 @@ static HRESULT WINAPI d3d9_stateblock_Apply(IDirect3DStateBlock9 *iface)
     TRACE("iface %p.\n", iface);
 
     wined3d_mutex_lock();
+    d3d9_device_unbind_up_vertex_buffer(impl_from_IDirect3DDevice9Ex(stateblock->parent_device));
     wined3d_stateblock_apply(stateblock->wined3d_stateblock);
     wined3d_mutex_unlock();
 
@@ -146,6 +148,7 @@ HRESULT stateblock_init(struct d3d9_stateblock *stateblock, struct d3d9_device *
     else
     {
         wined3d_mutex_lock();
+        d3d9_device_unbind_up_vertex_buffer(device);
         hr = wined3d_stateblock_create(device->wined3d_device,
                 (enum wined3d_stateblock_type)type, &stateblock->wined3d_stateblock);
         wined3d_mutex_unlock();
@@ -74,6 +74,130 @@ static CRITICAL_SECTION_DEBUG wpp_mutex_debug =
 };
 static CRITICAL_SECTION wpp_mutex = { &wpp_mutex_debug, -1, 0, 0, 0, 0 };
 
+/* Bytecode of previously compiled or assembled shaders, keyed by their
+ * preprocessed source, so that defines and includes are accounted for. */
+#define SHADER_CACHE_MAX_ENTRIES 256
+
+struct shader_cache_entry
+{
+    struct list entry;
+    unsigned int hash;
+    const char *source;
+    const char *target;      /* NULL for assembled shaders */
+    const char *entrypoint;
+    DWORD size;
+    DWORD *bytecode;
+};
+
+static struct list shader_cache = LIST_INIT(shader_cache);   /* most recently used first */
+static unsigned int shader_cache_count;
+
+static unsigned int shader_cache_hash_string(unsigned int hash, const char *str)
+{
+    if (!str) return hash;
+    while (*str) hash = (hash ^ (unsigned char)*str++) * 0x01000193;
+    return (hash ^ 0xff) * 0x01000193;
+}
+
+static unsigned int shader_cache_hash(const char *source, const char *target, const char *entrypoint)
+{
+    unsigned int hash = 0x811c9dc5;
+
+    hash = shader_cache_hash_string(hash, source);
+    hash = shader_cache_hash_string(hash, target);
+    return shader_cache_hash_string(hash, entrypoint);
+}
+
+static BOOL shader_cache_string_equal(const char *a, const char *b)
+{
+    if (!a || !b) return a == b;
+    return !strcmp(a, b);
+}
+
+static char *shader_cache_strdup(const char *str)
+{
+    char *ret;
+
+    if (!str) return NULL;
+    if ((ret = HeapAlloc(GetProcessHeap(), 0, strlen(str) + 1))) strcpy(ret, str);
+    return ret;
+}
+
+static void shader_cache_free_entry(struct shader_cache_entry *entry)
+{
+    HeapFree(GetProcessHeap(), 0, (char *)entry->source);
+    HeapFree(GetProcessHeap(), 0, (char *)entry->target);
+    HeapFree(GetProcessHeap(), 0, (char *)entry->entrypoint);
+    HeapFree(GetProcessHeap(), 0, entry->bytecode);
+    HeapFree(GetProcessHeap(), 0, entry);
+}
+
+/* Must be called with wpp_mutex held. */
+static BOOL shader_cache_lookup(const char *source, const char *target, const char *entrypoint,
+        ID3DBlob **shader_blob, HRESULT *hr)
+{
+    unsigned int hash = shader_cache_hash(source, target, entrypoint);
+    struct shader_cache_entry *entry;
+    ID3DBlob *buffer;
+
+    LIST_FOR_EACH_ENTRY(entry, &shader_cache, struct shader_cache_entry, entry)
+    {
+        if (entry->hash != hash || !shader_cache_string_equal(entry->target, target)
+                || !shader_cache_string_equal(entry->entrypoint, entrypoint)
+                || strcmp(entry->source, source))
+            continue;
+
+        TRACE("Using cached bytecode %p, size %u.\n", entry->bytecode, entry->size);
+
+        list_remove(&entry->entry);
+        list_add_head(&shader_cache, &entry->entry);
+
+        *hr = S_OK;
+        if (shader_blob)
+        {
+            if (SUCCEEDED(*hr = D3DCreateBlob(entry->size, &buffer)))
+            {
+                memcpy(ID3D10Blob_GetBufferPointer(buffer), entry->bytecode, entry->size);
+                *shader_blob = buffer;
+            }
+        }
+        return TRUE;
+    }
+    return FALSE;
+}
+
+/* Must be called with wpp_mutex held. */
+static void shader_cache_store(const char *source, const char *target, const char *entrypoint,
+        const DWORD *bytecode, DWORD size)
+{
+    struct shader_cache_entry *entry;
+
+    if (!(entry = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*entry))))
+        return;
+    entry->hash = shader_cache_hash(source, target, entrypoint);
+    entry->source = shader_cache_strdup(source);
+    entry->target = shader_cache_strdup(target);
+    entry->entrypoint = shader_cache_strdup(entrypoint);
+    entry->size = size;
+    entry->bytecode = HeapAlloc(GetProcessHeap(), 0, size);
+    if (!entry->source || (target && !entry->target) || (entrypoint && !entry->entrypoint)
+            || !entry->bytecode)
+    {
+        shader_cache_free_entry(entry);
+        return;
+    }
+    memcpy(entry->bytecode, bytecode, size);
+
+    list_add_head(&shader_cache, &entry->entry);
+    if (++shader_cache_count > SHADER_CACHE_MAX_ENTRIES)
+    {
+        entry = LIST_ENTRY(list_tail(&shader_cache), struct shader_cache_entry, entry);
+        list_remove(&entry->entry);
+        shader_cache_free_entry(entry);
+        --shader_cache_count;
+    }
+}
+
 /* Preprocessor error reporting functions */
 static void wpp_write_message(const char *fmt, va_list args)
 {
@@ -392,16 +516,22 @@ static HRESULT assemble_shader(const char *preproc_shader,
         ID3DBlob **shader_blob, ID3DBlob **error_messages)
 {
     struct bwriter_shader *shader;
+    BOOL cacheable = TRUE;
     char *messages = NULL;
     HRESULT hr;
     DWORD *res, size;
     ID3DBlob *buffer;
     char *pos;
 
+    if (shader_cache_lookup(preproc_shader, NULL, NULL, shader_blob, &hr))
+        return hr;
+
     shader = SlAssembleShader(preproc_shader, &messages);
 
     if (messages)
     {
+        cacheable = FALSE;
+
         TRACE("Assembler messages:\n");
         TRACE("%s\n", debugstr_a(messages));
 
@@ -448,6 +578,10 @@ static HRESULT assemble_shader(const char *preproc_shader,
         return D3DXERR_INVALIDDATA;
     }
 
+    /* Only cache shaders without messages, cached hits don't report any. */
+    if (cacheable)
+        shader_cache_store(preproc_shader, NULL, NULL, res, size);
+
     if (shader_blob)
     {
         hr = D3DCreateBlob(size, &buffer);
@@ -593,6 +727,7 @@ static HRESULT compile_shader(const char *preproc_shader, const char *target, co
         ID3DBlob **shader_blob, ID3DBlob **error_messages)
 {
     struct bwriter_shader *shader;
+    BOOL cacheable = TRUE;
     char *messages = NULL;
     HRESULT hr;
     DWORD *res, size, major, minor;
@@ -625,10 +760,15 @@ static HRESULT compile_shader(const char *preproc_shader, const char *target, co
         }
     }
 
+    if (shader_cache_lookup(preproc_shader, target, entrypoint, shader_blob, &hr))
+        return hr;
+
     shader = parse_hlsl_shader(preproc_shader, shader_type, major, minor, entrypoint, &messages);
 
     if (messages)
     {
+        cacheable = FALSE;
+
         TRACE("Compiler messages:\n");
         TRACE("%s\n", debugstr_a(messages));
 
@@ -675,6 +815,9 @@ static HRESULT compile_shader(const char *preproc_shader, const char *target, co
         return D3DXERR_INVALIDDATA;
     }
 
+    if (cacheable)
+        shader_cache_store(preproc_shader, target, entrypoint, res, size);
+
     if (shader_blob)
     {
         hr = D3DCreateBlob(size, &buffer);
@@ -1640,6 +1640,309 @@ static HRESULT remap_faces_for_attrsort(struct d3dx9_mesh *This, const DWORD *in
     return D3D_OK;
 }
 
+/* Vertex cache optimization, following Tom Forsyth's "Linear-Speed Vertex
+ * Cache Optimisation". Faces are greedily emitted by a score favouring
+ * vertices that are in a simulated LRU cache and vertices with few
+ * remaining faces. */
+#define VCACHE_SIZE 32
+
+struct vcache_vertex
+{
+    int cache_pos;
+    DWORD face_start;
+    DWORD face_count;   /* faces not emitted yet */
+    float score;
+};
+
+struct vcache_optimizer
+{
+    struct vcache_vertex *vertices;
+    DWORD *vertex_faces;
+    float *face_scores;
+    DWORD *faces_out;
+};
+
+static float vcache_vertex_score(const struct vcache_vertex *vertex)
+{
+    float score = 0.0f;
+
+    if (!vertex->face_count)
+        return -1.0f;
+
+    if (vertex->cache_pos >= 0)
+    {
+        /* The last face's vertices get a fixed score, so that the next face
+         * doesn't just reuse them in a strip-like pattern. */
+        if (vertex->cache_pos < 3)
+            score = 0.75f;
+        else
+            score = powf(1.0f - (vertex->cache_pos - 3) * (1.0f / (VCACHE_SIZE - 3)), 1.5f);
+    }
+
+    /* Favour vertices with few faces left, to avoid leaving lone faces behind. */
+    return score + 2.0f / sqrtf(vertex->face_count);
+}
+
+static void vcache_optimizer_cleanup(struct vcache_optimizer *opt)
+{
+    HeapFree(GetProcessHeap(), 0, opt->vertices);
+    HeapFree(GetProcessHeap(), 0, opt->vertex_faces);
+    HeapFree(GetProcessHeap(), 0, opt->face_scores);
+    HeapFree(GetProcessHeap(), 0, opt->faces_out);
+}
+
+static HRESULT vcache_optimizer_init(struct vcache_optimizer *opt, DWORD num_vertices, DWORD num_faces)
+{
+    opt->vertices = HeapAlloc(GetProcessHeap(), 0, num_vertices * sizeof(*opt->vertices));
+    opt->vertex_faces = HeapAlloc(GetProcessHeap(), 0, num_faces * 3 * sizeof(*opt->vertex_faces));
+    opt->face_scores = HeapAlloc(GetProcessHeap(), 0, num_faces * sizeof(*opt->face_scores));
+    opt->faces_out = HeapAlloc(GetProcessHeap(), 0, num_faces * sizeof(*opt->faces_out));
+    if (!opt->vertices || !opt->vertex_faces || !opt->face_scores || !opt->faces_out)
+    {
+        vcache_optimizer_cleanup(opt);
+        return E_OUTOFMEMORY;
+    }
+    return D3D_OK;
+}
+
+/* Reorder faces[0..count - 1], a list of face indices into indices. */
+static void vcache_optimize_faces(struct vcache_optimizer *opt, const DWORD *indices, DWORD *faces, DWORD count)
+{
+    DWORD cache[VCACHE_SIZE + 3], new_cache[VCACHE_SIZE + 3];
+    DWORD cache_size = 0, new_cache_size;
+    DWORD i, j, k, offset, out, cursor = 0;
+    int best = -1;
+    float best_score;
+
+    for (i = 0; i < count; ++i)
+    {
+        for (j = 0; j < 3; ++j)
+        {
+            struct vcache_vertex *vertex = &opt->vertices[indices[faces[i] * 3 + j]];
+
+            vertex->cache_pos = -1;
+            vertex->face_start = ~0u;
+            vertex->face_count = 0;
+        }
+    }
+    for (i = 0, offset = 0; i < count; ++i)
+    {
+        for (j = 0; j < 3; ++j)
+            ++opt->vertices[indices[faces[i] * 3 + j]].face_count;
+    }
+    for (i = 0; i < count; ++i)
+    {
+        for (j = 0; j < 3; ++j)
+        {
+            struct vcache_vertex *vertex = &opt->vertices[indices[faces[i] * 3 + j]];
+
+            if (vertex->face_start == ~0u)
+            {
+                vertex->face_start = offset;
+                offset += vertex->face_count;
+                vertex->face_count = 0;
+            }
+            opt->vertex_faces[vertex->face_start + vertex->face_count++] = i;
+        }
+    }
+    for (i = 0; i < count; ++i)
+    {
+        for (j = 0; j < 3; ++j)
+        {
+            struct vcache_vertex *vertex = &opt->vertices[indices[faces[i] * 3 + j]];
+            vertex->score = vcache_vertex_score(vertex);
+        }
+    }
+    for (i = 0; i < count; ++i)
+    {
+        opt->face_scores[i] = 0.0f;
+        for (j = 0; j < 3; ++j)
+            opt->face_scores[i] += opt->vertices[indices[faces[i] * 3 + j]].score;
+    }
+
+    for (out = 0; out < count; ++out)
+    {
+        const DWORD *face;
+
+        if (best < 0)
+        {
+            /* Nothing useful in the cache, take the next face in input order. */
+            while (opt->face_scores[cursor] < 0.0f)
+                ++cursor;
+            best = cursor;
+        }
+
+        opt->faces_out[out] = faces[best];
+        opt->face_scores[best] = -1.0f;
+        face = &indices[faces[best] * 3];
+
+        new_cache_size = 0;
+        for (j = 0; j < 3; ++j)
+        {
+            struct vcache_vertex *vertex = &opt->vertices[face[j]];
+
+            for (k = 0; k < vertex->face_count; ++k)
+            {
+                if (opt->vertex_faces[vertex->face_start + k] == best)
+                {
+                    opt->vertex_faces[vertex->face_start + k]
+                            = opt->vertex_faces[vertex->face_start + --vertex->face_count];
+                    break;
+                }
+            }
+
+            for (k = 0; k < new_cache_size; ++k)
+            {
+                if (new_cache[k] == face[j])
+                    break;
+            }
+            if (k == new_cache_size)
+                new_cache[new_cache_size++] = face[j];
+        }
+        for (i = 0; i < cache_size; ++i)
+        {
+            if (cache[i] != face[0] && cache[i] != face[1] && cache[i] != face[2])
+                new_cache[new_cache_size++] = cache[i];
+        }
+
+        for (i = 0; i < new_cache_size; ++i)
+        {
+            struct vcache_vertex *vertex = &opt->vertices[new_cache[i]];
+
+            vertex->cache_pos = i < VCACHE_SIZE ? i : -1;
+            vertex->score = vcache_vertex_score(vertex);
+        }
+
+        best = -1;
+        best_score = -1.0f;
+        for (i = 0; i < new_cache_size; ++i)
+        {
+            struct vcache_vertex *vertex = &opt->vertices[new_cache[i]];
+
+            for (k = 0; k < vertex->face_count; ++k)
+            {
+                DWORD f = opt->vertex_faces[vertex->face_start + k];
+                const DWORD *idx = &indices[faces[f] * 3];
+                float score = opt->vertices[idx[0]].score + opt->vertices[idx[1]].score
+                        + opt->vertices[idx[2]].score;
+
+                opt->face_scores[f] = score;
+                if (score > best_score)
+                {
+                    best_score = score;
+                    best = f;
+                }
+            }
+        }
+
+        cache_size = min(new_cache_size, VCACHE_SIZE);
+        memcpy(cache, new_cache, cache_size * sizeof(*cache));
+    }
+
+    memcpy(faces, opt->faces_out, count * sizeof(*faces));
+}
+
+/* Reorder the faces of each attribute group for the vertex cache, updating
+ * the old -> new face_remap produced by the attribute sort. */
+static HRESULT remap_faces_for_vertex_cache(struct d3dx9_mesh *This, const DWORD *indices,
+        const DWORD *sorted_attrib_buffer, DWORD *face_remap)
+{
+    struct vcache_optimizer opt;
+    DWORD *faces, i, start;
+    HRESULT hr;
+
+    if (!(faces = HeapAlloc(GetProcessHeap(), 0, This->numfaces * sizeof(*faces))))
+        return E_OUTOFMEMORY;
+    if (FAILED(hr = vcache_optimizer_init(&opt, This->numvertices, This->numfaces)))
+    {
+        HeapFree(GetProcessHeap(), 0, faces);
+        return hr;
+    }
+
+    /* new -> old */
+    for (i = 0; i < This->numfaces; i++)
+        faces[face_remap[i]] = i;
+
+    for (start = 0, i = 1; i <= This->numfaces; i++)
+    {
+        if (i < This->numfaces && sorted_attrib_buffer[i] == sorted_attrib_buffer[start])
+            continue;
+        vcache_optimize_faces(&opt, indices, faces + start, i - start);
+        start = i;
+    }
+
+    for (i = 0; i < This->numfaces; i++)
+        face_remap[faces[i]] = i;
+
+    vcache_optimizer_cleanup(&opt);
+    HeapFree(GetProcessHeap(), 0, faces);
+    return D3D_OK;
+}
+
+/* Number the vertices in the order the reordered faces use them, so that
+ * vertex fetches stay local and each attribute's vertex range is tight. */
+static HRESULT remap_vertices_for_faces(struct d3dx9_mesh *This, DWORD *indices, const DWORD *face_remap,
+        BOOL compact, DWORD *new_num_vertices, ID3DXBuffer **vertex_remap)
+{
+    DWORD *vertex_remap_ptr, *faces, *old_to_new;
+    DWORD i, j, count = 0;
+    HRESULT hr;
+
+    if (FAILED(hr = D3DXCreateBuffer(This->numvertices * sizeof(DWORD), vertex_remap)))
+        return hr;
+    vertex_remap_ptr = ID3DXBuffer_GetBufferPointer(*vertex_remap);
+
+    faces = HeapAlloc(GetProcessHeap(), 0, This->numfaces * sizeof(*faces));
+    old_to_new = HeapAlloc(GetProcessHeap(), 0, This->numvertices * sizeof(*old_to_new));
+    if (!faces || !old_to_new)
+    {
+        HeapFree(GetProcessHeap(), 0, faces);
+        HeapFree(GetProcessHeap(), 0, old_to_new);
+        ID3DXBuffer_Release(*vertex_remap);
+        *vertex_remap = NULL;
+        return E_OUTOFMEMORY;
+    }
+
+    for (i = 0; i < This->numfaces; i++)
+        faces[face_remap[i]] = i;
+    for (i = 0; i < This->numvertices; i++)
+        old_to_new[i] = -1;
+
+    for (i = 0; i < This->numfaces; i++)
+    {
+        for (j = 0; j < 3; j++)
+        {
+            DWORD vertex = indices[faces[i] * 3 + j];
+
+            if (old_to_new[vertex] == -1)
+            {
+                old_to_new[vertex] = count;
+                vertex_remap_ptr[count++] = vertex;
+            }
+        }
+    }
+    *new_num_vertices = count;
+    if (!compact)
+    {
+        /* unreferenced vertices go last */
+        for (i = 0; i < This->numvertices; i++)
+        {
+            if (old_to_new[i] == -1)
+                vertex_remap_ptr[count++] = i;
+        }
+        *new_num_vertices = count;
+    }
+    for (i = count; i < This->numvertices; i++)
+        vertex_remap_ptr[i] = -1;
+
+    for (i = 0; i < This->numfaces * 3; i++)
+        indices[i] = old_to_new[indices[i]];
+
+    HeapFree(GetProcessHeap(), 0, faces);
+    HeapFree(GetProcessHeap(), 0, old_to_new);
+    return D3D_OK;
+}
+
 static HRESULT WINAPI d3dx9_mesh_OptimizeInplace(ID3DXMesh *iface, DWORD flags, const DWORD *adjacency_in,
         DWORD *adjacency_out, DWORD *face_remap_out, ID3DXBuffer **vertex_remap_out)
 {
@@ -1666,14 +1969,11 @@ static HRESULT WINAPI d3dx9_mesh_OptimizeInplace(ID3DXMesh *iface, DWORD flags,
     if ((flags & (D3DXMESHOPT_VERTEXCACHE | D3DXMESHOPT_STRIPREORDER)) == (D3DXMESHOPT_VERTEXCACHE | D3DXMESHOPT_STRIPREORDER))
         return D3DERR_INVALIDCALL;
 
+    if (flags & D3DXMESHOPT_STRIPREORDER)
+        FIXME("D3DXMESHOPT_STRIPREORDER not implemented, optimizing for the vertex cache instead.\n");
+    /* Reordering faces for the vertex cache implies sorting them by attribute. */
     if (flags & (D3DXMESHOPT_VERTEXCACHE | D3DXMESHOPT_STRIPREORDER))
-    {
-        if (flags & D3DXMESHOPT_VERTEXCACHE)
-            FIXME("D3DXMESHOPT_VERTEXCACHE not implemented.\n");
-        if (flags & D3DXMESHOPT_STRIPREORDER)
-            FIXME("D3DXMESHOPT_STRIPREORDER not implemented.\n");
-        return E_NOTIMPL;
-    }
+        flags |= D3DXMESHOPT_ATTRSORT;
 
     hr = iface->lpVtbl->LockIndexBuffer(iface, 0, &indices);
     if (FAILED(hr)) goto cleanup;
@@ -1694,18 +1994,25 @@ static HRESULT WINAPI d3dx9_mesh_OptimizeInplace(ID3DXMesh *iface, DWORD flags,
         hr = compact_mesh(This, dword_indices, &new_num_vertices, &vertex_remap);
         if (FAILED(hr)) goto cleanup;
     } else if (flags & D3DXMESHOPT_ATTRSORT) {
-        if (!(flags & D3DXMESHOPT_IGNOREVERTS))
-        {
-            FIXME("D3DXMESHOPT_ATTRSORT vertex reordering not implemented.\n");
-            hr = E_NOTIMPL;
-            goto cleanup;
-        }
-
         hr = iface->lpVtbl->LockAttributeBuffer(iface, 0, &attrib_buffer);
         if (FAILED(hr)) goto cleanup;
 
         hr = remap_faces_for_attrsort(This, dword_indices, attrib_buffer, &sorted_attrib_buffer, &face_remap);
         if (FAILED(hr)) goto cleanup;
+
+        if (flags & (D3DXMESHOPT_VERTEXCACHE | D3DXMESHOPT_STRIPREORDER))
+        {
+            hr = remap_faces_for_vertex_cache(This, dword_indices, sorted_attrib_buffer, face_remap);
+            if (FAILED(hr)) goto cleanup;
+        }
+
+        if (!(flags & D3DXMESHOPT_IGNOREVERTS))
+        {
+            new_num_alloc_vertices = This->numvertices;
+            hr = remap_vertices_for_faces(This, dword_indices, face_remap, !!(flags & D3DXMESHOPT_COMPACT),
+                    &new_num_vertices, &vertex_remap);
+            if (FAILED(hr)) goto cleanup;
+        }
     }
 
     if (vertex_remap)
@@ -1650,6 +1650,58 @@ static void exec_set_arg(struct d3dx_regstore *rs, const struct d3dx_pres_reg *r
     regstore_set_double(rs, reg->table, reg->offset + comp, res);
 }
 
+/* Fetch components [0, count) of an operand at once, resolving the index
+ * register and the table bounds only once for the whole operand. */
+static void exec_get_args(struct d3dx_regstore *rs, const struct d3dx_pres_operand *opr,
+        unsigned int count, double *args)
+{
+    unsigned int offset, base_index, table, j;
+
+    table = opr->reg.table;
+
+    if (opr->index_reg.table == PRES_REGTAB_COUNT)
+        base_index = 0;
+    else
+        base_index = lrint(exec_get_reg_value(rs, opr->index_reg.table, opr->index_reg.offset));
+
+    offset = get_offset_reg(table, base_index) + opr->reg.offset;
+    if (get_reg_offset(table, offset + count - 1) >= rs->table_sizes[table])
+    {
+        /* Let exec_get_arg() handle wrapping. */
+        for (j = 0; j < count; ++j)
+            args[j] = exec_get_arg(rs, opr, j);
+        return;
+    }
+
+    for (j = 0; j < count; ++j)
+        args[j] = exec_get_reg_value(rs, table, offset + j);
+}
+
+/* Whether all the inputs can be read before any output component is written,
+ * preserving the results of the component by component evaluation. */
+static BOOL exec_can_prefetch_args(const struct d3dx_pres_ins *ins, unsigned int input_count)
+{
+    const struct d3dx_pres_reg *out = &ins->output.reg;
+    unsigned int k, count;
+
+    if (ins->component_count > 4)
+        return FALSE;
+
+    for (k = 0; k < input_count; ++k)
+    {
+        const struct d3dx_pres_operand *opr = &ins->inputs[k];
+
+        if (opr->reg.table != out->table && opr->index_reg.table != out->table)
+            continue;
+        if (opr->index_reg.table != PRES_REGTAB_COUNT)
+            return FALSE;
+        count = ins->scalar_op && !k ? 1 : ins->component_count;
+        if (opr->reg.offset < out->offset + ins->component_count && out->offset < opr->reg.offset + count)
+            return FALSE;
+    }
+    return TRUE;
+}
+
 #define ARGS_ARRAY_SIZE 8
 static HRESULT execute_preshader(struct d3dx_preshader *pres)
 {
@@ -1680,6 +1732,22 @@ static HRESULT execute_preshader(struct d3dx_preshader *pres)
             /* only 'dot' instruction currently falls here */
             exec_set_arg(&pres->regs, &ins->output.reg, 0, res);
         }
+        else if (exec_can_prefetch_args(ins, oi->input_count))
+        {
+            double inputs[MAX_INPUTS_COUNT][4];
+
+            for (k = 0; k < oi->input_count; ++k)
+                exec_get_args(&pres->regs, &ins->inputs[k], ins->scalar_op && !k ? 1 : ins->component_count,
+                        inputs[k]);
+
+            for (j = 0; j < ins->component_count; ++j)
+            {
+                for (k = 0; k < oi->input_count; ++k)
+                    args[k] = inputs[k][ins->scalar_op && !k ? 0 : j];
+                res = oi->func(args, ins->component_count);
+                exec_set_arg(&pres->regs, &ins->output.reg, j, res);
+            }
+        }
         else
         {
             for (j = 0; j < ins->component_count; ++j)
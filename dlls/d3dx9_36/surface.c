@@ -1413,6 +1413,60 @@ static DWORD make_argb_color(const struct argb_conversion_info *info, const DWOR
     return val;
 }
 
+/* Formats whose channels are all either missing or 8 bits wide and byte aligned. */
+static BOOL is_argb8888_format(const struct pixel_format_desc *format)
+{
+    unsigned int c;
+
+    if (format->type != FORMAT_ARGB || format->bytes_per_pixel != 4 || format->to_rgba || format->from_rgba)
+        return FALSE;
+
+    for (c = 0; c < 4; ++c)
+    {
+        if (format->bits[c] && (format->bits[c] != 8 || format->shift[c] % 8))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/* Same as make_argb_color(get_relevant_argb_components()) for is_argb8888_format() formats. */
+static inline DWORD convert_argb8888_pixel(const struct argb_conversion_info *info, DWORD pixel)
+{
+    DWORD val = info->channelmask;
+    unsigned int c;
+
+    for (c = 0; c < 4; ++c)
+    {
+        if (info->process_channel[c])
+            val |= ((pixel >> info->srcformat->shift[c]) & 0xff) << info->destformat->shift[c];
+    }
+    return val;
+}
+
+static void convert_argb8888_row(const struct argb_conversion_info *info, const BYTE *src, BYTE *dst,
+        unsigned int width, const struct argb_conversion_info *ck_info, D3DCOLOR color_key)
+{
+    DWORD pixel, val;
+    unsigned int x;
+
+    if (info->srcformat == info->destformat && !ck_info && !info->channelmask
+            && info->srcformat->bits[0] && info->srcformat->bits[1]
+            && info->srcformat->bits[2] && info->srcformat->bits[3])
+    {
+        memcpy(dst, src, width * sizeof(pixel));
+        return;
+    }
+
+    for (x = 0; x < width; ++x)
+    {
+        memcpy(&pixel, src + x * sizeof(pixel), sizeof(pixel));
+        val = convert_argb8888_pixel(info, pixel);
+        if (ck_info && convert_argb8888_pixel(ck_info, pixel) == color_key)
+            val &= ~info->destmask[0];
+        memcpy(dst + x * sizeof(val), &val, sizeof(val));
+    }
+}
+
 /* It doesn't work for components bigger than 32 bits (or somewhat smaller but unaligned). */
 static void format_to_vec4(const struct pixel_format_desc *format, const BYTE *src, struct vec4 *dst)
 {
@@ -1535,10 +1589,15 @@ void convert_argb_pixels(const BYTE *src, UINT src_row_pitch, UINT src_slice_pit
     DWORD channels[4];
     UINT min_width, min_height, min_depth;
     UINT x, y, z;
+    BOOL simple, argb8888;
 
     ZeroMemory(channels, sizeof(channels));
     init_argb_conversion_info(src_format, dst_format, &conv_info);
 
+    simple = !src_format->to_rgba && !dst_format->from_rgba && src_format->type == dst_format->type
+            && src_format->bytes_per_pixel <= 4 && dst_format->bytes_per_pixel <= 4;
+    argb8888 = is_argb8888_format(src_format) && is_argb8888_format(dst_format);
+
     min_width = min(src_size->width, dst_size->width);
     min_height = min(src_size->height, dst_size->height);
     min_depth = min(src_size->depth, dst_size->depth);
@@ -1558,10 +1617,14 @@ void convert_argb_pixels(const BYTE *src, UINT src_row_pitch, UINT src_slice_pit
             const BYTE *src_ptr = src_slice_ptr + y * src_row_pitch;
             BYTE *dst_ptr = dst_slice_ptr + y * dst_row_pitch;
 
-            for (x = 0; x < min_width; x++) {
-                if (!src_format->to_rgba && !dst_format->from_rgba
-                        && src_format->type == dst_format->type
-                        && src_format->bytes_per_pixel <= 4 && dst_format->bytes_per_pixel <= 4)
+            if (argb8888)
+            {
+                convert_argb8888_row(&conv_info, src_ptr, dst_ptr, min_width,
+                        color_key ? &ck_conv_info : NULL, color_key);
+                dst_ptr += min_width * dst_format->bytes_per_pixel;
+            }
+            else for (x = 0; x < min_width; x++) {
+                if (simple)
                 {
                     DWORD val;
 
@@ -1637,10 +1700,15 @@ void point_filter_argb_pixels(const BYTE *src, UINT src_row_pitch, UINT src_slic
     const struct pixel_format_desc *ck_format = NULL;
     DWORD channels[4];
     UINT x, y, z;
+    BOOL simple, argb8888;
 
     ZeroMemory(channels, sizeof(channels));
     init_argb_conversion_info(src_format, dst_format, &conv_info);
 
+    simple = !src_format->to_rgba && !dst_format->from_rgba && src_format->type == dst_format->type
+            && src_format->bytes_per_pixel <= 4 && dst_format->bytes_per_pixel <= 4;
+    argb8888 = is_argb8888_format(src_format) && is_argb8888_format(dst_format);
+
     if (color_key)
     {
         /* Color keys are always represented in D3DFMT_A8R8G8B8 format. */
@@ -1662,9 +1730,17 @@ void point_filter_argb_pixels(const BYTE *src, UINT src_row_pitch, UINT src_slic
             {
                 const BYTE *src_ptr = src_row_ptr + (x * src_size->width / dst_size->width) * src_format->bytes_per_pixel;
 
-                if (!src_format->to_rgba && !dst_format->from_rgba
-                        && src_format->type == dst_format->type
-                        && src_format->bytes_per_pixel <= 4 && dst_format->bytes_per_pixel <= 4)
+                if (argb8888)
+                {
+                    DWORD pixel, val;
+
+                    memcpy(&pixel, src_ptr, sizeof(pixel));
+                    val = convert_argb8888_pixel(&conv_info, pixel);
+                    if (color_key && convert_argb8888_pixel(&ck_conv_info, pixel) == color_key)
+                        val &= ~conv_info.destmask[0];
+                    memcpy(dst_ptr, &val, sizeof(val));
+                }
+                else if (simple)
                 {
                     DWORD val;
 
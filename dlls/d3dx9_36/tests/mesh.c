@@ -10485,6 +10485,73 @@ static void test_optimize_faces(void)
     "faces when using 16-bit indices. Got %x\n, expected D3DERR_INVALIDCALL\n", hr);
 }
 
+static void test_optimize_inplace(void)
+{
+    struct test_context *test_context;
+    ID3DXBuffer *adjacency, *vertex_remap;
+    DWORD face_remap[12], *remap, num_entries;
+    D3DXATTRIBUTERANGE attrib_table[2];
+    BOOL seen[24];
+    ID3DXMesh *mesh;
+    HRESULT hr;
+    UINT i;
+
+    if (!(test_context = new_test_context()))
+    {
+        skip("Couldn't create test context\n");
+        return;
+    }
+
+    hr = D3DXCreateBox(test_context->device, 1.0f, 1.0f, 1.0f, &mesh, &adjacency);
+    ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+    ok(mesh->lpVtbl->GetNumFaces(mesh) == ARRAY_SIZE(face_remap), "Got unexpected face count %u.\n",
+            mesh->lpVtbl->GetNumFaces(mesh));
+    ok(mesh->lpVtbl->GetNumVertices(mesh) == ARRAY_SIZE(seen), "Got unexpected vertex count %u.\n",
+            mesh->lpVtbl->GetNumVertices(mesh));
+
+    hr = mesh->lpVtbl->OptimizeInplace(mesh, D3DXMESHOPT_VERTEXCACHE,
+            ID3DXBuffer_GetBufferPointer(adjacency), NULL, face_remap, &vertex_remap);
+    ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+
+    memset(seen, 0, sizeof(seen));
+    for (i = 0; i < ARRAY_SIZE(face_remap); ++i)
+    {
+        ok(face_remap[i] < ARRAY_SIZE(face_remap) && !seen[face_remap[i]],
+                "Got unexpected face_remap[%u] %u.\n", i, face_remap[i]);
+        if (face_remap[i] < ARRAY_SIZE(face_remap))
+            seen[face_remap[i]] = TRUE;
+    }
+
+    ok(ID3DXBuffer_GetBufferSize(vertex_remap) >= ARRAY_SIZE(seen) * sizeof(DWORD),
+            "Got unexpected vertex remap size %u.\n", ID3DXBuffer_GetBufferSize(vertex_remap));
+    remap = ID3DXBuffer_GetBufferPointer(vertex_remap);
+    memset(seen, 0, sizeof(seen));
+    for (i = 0; i < ARRAY_SIZE(seen); ++i)
+    {
+        ok(remap[i] < ARRAY_SIZE(seen) && !seen[remap[i]], "Got unexpected vertex_remap[%u] %u.\n", i, remap[i]);
+        if (remap[i] < ARRAY_SIZE(seen))
+            seen[remap[i]] = TRUE;
+    }
+    ID3DXBuffer_Release(vertex_remap);
+
+    hr = mesh->lpVtbl->GetAttributeTable(mesh, NULL, &num_entries);
+    ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+    ok(num_entries == 1, "Got unexpected attribute table size %u.\n", num_entries);
+    hr = mesh->lpVtbl->GetAttributeTable(mesh, attrib_table, NULL);
+    ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+    ok(!attrib_table[0].FaceStart && attrib_table[0].FaceCount == ARRAY_SIZE(face_remap),
+            "Got unexpected face range %u, %u.\n", attrib_table[0].FaceStart, attrib_table[0].FaceCount);
+
+    /* Attribute sorting alone no longer requires D3DXMESHOPT_IGNOREVERTS. */
+    hr = mesh->lpVtbl->OptimizeInplace(mesh, D3DXMESHOPT_ATTRSORT,
+            ID3DXBuffer_GetBufferPointer(adjacency), NULL, NULL, NULL);
+    ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+
+    ID3DXBuffer_Release(adjacency);
+    mesh->lpVtbl->Release(mesh);
+    free_test_context(test_context);
+}
+
 static HRESULT clear_normals(ID3DXMesh *mesh)
 {
     HRESULT hr;
@@ -11220,6 +11287,7 @@ START_TEST(mesh)
     test_clone_mesh();
     test_valid_mesh();
     test_optimize_faces();
+    test_optimize_inplace();
     test_compute_normals();
     test_D3DXFrameFind();
 }
@@ -469,6 +469,12 @@ struct dump_memory
     ULONG                               rva;
 };
 
+struct dump_memory64
+{
+    ULONG64                             base;
+    ULONG64                             size;
+};
+
 struct dump_module
 {
     unsigned                            is_elf;
@@ -507,6 +513,9 @@ struct dump_context
     struct dump_memory*                 mem;
     unsigned                            num_mem;
     unsigned                            alloc_mem;
+    struct dump_memory64*               mem64;
+    unsigned                            num_mem64;
+    unsigned                            alloc_mem64;
     /* callback information */
     MINIDUMP_CALLBACK_INFORMATION*      cb;
 };
@@ -618,6 +627,7 @@ extern struct module*
                     module_is_already_loaded(const struct process* pcs,
                                              const WCHAR* imgname) DECLSPEC_HIDDEN;
 extern BOOL         module_get_debug(struct module_pair*) DECLSPEC_HIDDEN;
+extern BOOL         module_get_debug_addr(struct module_pair*, DWORD64 addr) DECLSPEC_HIDDEN;
 extern struct module*
                     module_new(struct process* pcs, const WCHAR* name,
                                enum module_type type, BOOL virtual,
@@ -684,6 +694,7 @@ extern BOOL         stabs_parse(struct module* module, unsigned long load_offset
 extern BOOL         dwarf2_parse(struct module* module, unsigned long load_offset,
                                  const struct elf_thunk_area* thunks,
                                  struct image_file_map* fmap) DECLSPEC_HIDDEN;
+extern void         dwarf2_load_deferred(struct module* module, DWORD64 addr) DECLSPEC_HIDDEN;
 extern BOOL         dwarf2_virtual_unwind(struct cpu_stack_walk* csw, DWORD_PTR ip,
                                           CONTEXT* context, ULONG_PTR* cfa) DECLSPEC_HIDDEN;
 
@@ -200,6 +200,15 @@ typedef struct dwarf2_parse_context_s
     char*                       cpp_name;
 } dwarf2_parse_context_t;
 
+/* address range covered by a compilation unit, as listed in .debug_aranges */
+struct dwarf2_cu_range
+{
+    unsigned long               start;
+    unsigned long               end;
+    unsigned long               cu_offset;  /* offset of the CU header in .debug_info */
+    unsigned                    cu;         /* index in the deferred CU table */
+};
+
 /* stored in the dbghelp's module internal structure for later reuse */
 struct dwarf2_module_info_s
 {
@@ -207,6 +216,14 @@ struct dwarf2_module_info_s
     dwarf2_section_t            debug_frame;
     dwarf2_section_t            eh_frame;
     unsigned char               word_size;
+    /* compilation units whose parsing is deferred until an address inside them is queried */
+    dwarf2_section_t            sections[section_max];
+    unsigned long               load_offset;
+    const unsigned char**       deferred_cus;   /* NULL once a CU has been parsed */
+    unsigned                    num_deferred;
+    unsigned                    num_pending;
+    struct dwarf2_cu_range*     cu_ranges;      /* sorted by start address */
+    unsigned                    num_cu_ranges;
 };
 
 #define loc_dwarf2_location_list        (loc_user + 0)
@@ -3250,7 +3267,7 @@ BOOL dwarf2_virtual_unwind(struct cpu_stack_walk* csw, ULONG_PTR ip, CONTEXT* co
 
     if (!(pair.pcs = process_find_by_handle(csw->hProcess)) ||
         !(pair.requested = module_find_by_addr(pair.pcs, ip, DMT_UNKNOWN)) ||
-        !module_get_debug(&pair))
+        !module_get_debug_addr(&pair, ip))
         return FALSE;
     modfmt = pair.effective->format_info[DFI_DWARF];
     if (!modfmt) return FALSE;
@@ -3491,19 +3508,240 @@ static inline void dwarf2_fini_section(dwarf2_section_t* section)
 
 static void dwarf2_module_remove(struct process* pcs, struct module_format* modfmt)
 {
-    dwarf2_fini_section(&modfmt->u.dwarf2_info->debug_loc);
-    dwarf2_fini_section(&modfmt->u.dwarf2_info->debug_frame);
+    struct dwarf2_module_info_s* info = modfmt->u.dwarf2_info;
+    unsigned i;
+
+    dwarf2_fini_section(&info->debug_loc);
+    dwarf2_fini_section(&info->debug_frame);
+    if (info->deferred_cus)
+    {
+        /* the sections themselves are unmapped along with the image file */
+        for (i = 0; i < section_max; i++)
+            dwarf2_fini_section(&info->sections[i]);
+        HeapFree(GetProcessHeap(), 0, info->deferred_cus);
+        HeapFree(GetProcessHeap(), 0, info->cu_ranges);
+    }
     HeapFree(GetProcessHeap(), 0, modfmt);
 }
 
+static int cu_range_offset_cmp(const void* p1, const void* p2)
+{
+    const struct dwarf2_cu_range* r1 = p1;
+    const struct dwarf2_cu_range* r2 = p2;
+
+    if (r1->cu_offset != r2->cu_offset) return r1->cu_offset < r2->cu_offset ? -1 : 1;
+    if (r1->start != r2->start) return r1->start < r2->start ? -1 : 1;
+    return 0;
+}
+
+static int cu_range_start_cmp(const void* p1, const void* p2)
+{
+    const struct dwarf2_cu_range* r1 = p1;
+    const struct dwarf2_cu_range* r2 = p2;
+
+    if (r1->start != r2->start) return r1->start < r2->start ? -1 : 1;
+    return 0;
+}
+
+/******************************************************************
+ *		dwarf2_parse_aranges
+ *
+ * Reads the address ranges of every compilation unit from .debug_aranges.
+ * Returns the number of ranges found (0 if the section can't be used).
+ */
+static unsigned dwarf2_parse_aranges(const dwarf2_section_t* aranges,
+                                     struct dwarf2_cu_range** ranges)
+{
+    dwarf2_traverse_context_t   ctx, set_ctx;
+    struct dwarf2_cu_range*     new;
+    unsigned                    num = 0, size = 0;
+    unsigned long               length, cu_offset, start, len;
+    unsigned short              version;
+    unsigned char               seg_size;
+
+    *ranges = NULL;
+    if (!aranges->address || aranges->address == IMAGE_NO_MAP) return 0;
+
+    ctx.data = aranges->address;
+    ctx.end_data = ctx.data + aranges->size;
+    while (ctx.data + 4 <= ctx.end_data)
+    {
+        set_ctx.data = ctx.data;
+        length = dwarf2_parse_u4(&ctx);
+        /* 64-bit DWARF is not supported by the rest of the parser either */
+        if (length == 0xffffffff || length > ctx.end_data - ctx.data) goto error;
+        set_ctx.end_data = ctx.data + length;
+        ctx.data += length;
+
+        set_ctx.data += 4;
+        if (set_ctx.data + 8 > set_ctx.end_data) goto error;
+        version = dwarf2_parse_u2(&set_ctx);
+        cu_offset = dwarf2_parse_u4(&set_ctx);
+        set_ctx.word_size = dwarf2_parse_byte(&set_ctx);
+        seg_size = dwarf2_parse_byte(&set_ctx);
+        if (version != 2 || seg_size ||
+            (set_ctx.word_size != 4 && set_ctx.word_size != 8))
+            goto error;
+        /* tuples are aligned on twice the address size from the start of the set */
+        set_ctx.data += (2 * set_ctx.word_size - 12 % (2 * set_ctx.word_size)) % (2 * set_ctx.word_size);
+
+        while (set_ctx.data + 2 * set_ctx.word_size <= set_ctx.end_data)
+        {
+            start = dwarf2_parse_addr(&set_ctx);
+            len = dwarf2_parse_addr(&set_ctx);
+            if (!start && !len) break;
+            if (!len) continue;
+            if (num == size)
+            {
+                size = size ? size * 2 : 64;
+                new = *ranges ? HeapReAlloc(GetProcessHeap(), 0, *ranges, size * sizeof(**ranges))
+                              : HeapAlloc(GetProcessHeap(), 0, size * sizeof(**ranges));
+                if (!new) goto error;
+                *ranges = new;
+            }
+            (*ranges)[num].start = start;
+            (*ranges)[num].end = start + len;
+            (*ranges)[num].cu_offset = cu_offset;
+            num++;
+        }
+    }
+    return num;
+
+error:
+    WARN("Unsupported .debug_aranges content, loading all compilation units\n");
+    HeapFree(GetProcessHeap(), 0, *ranges);
+    *ranges = NULL;
+    return 0;
+}
+
+/******************************************************************
+ *		dwarf2_parse_compilation_units
+ *
+ * Parses all compilation units of .debug_info, except the ones listed in
+ * .debug_aranges which are only recorded in the module's deferred table.
+ */
+static void dwarf2_parse_compilation_units(struct module_format* modfmt,
+                                           const struct elf_thunk_area* thunks,
+                                           const dwarf2_section_t* aranges)
+{
+    struct dwarf2_module_info_s* info = modfmt->u.dwarf2_info;
+    const dwarf2_section_t*     sections = info->sections;
+    dwarf2_traverse_context_t   mod_ctx;
+    struct dwarf2_cu_range*     ranges = NULL;
+    unsigned                    num_ranges = 0, i = 0, j = 0;
+    unsigned long               cu_offset;
+
+    mod_ctx.data = sections[section_debug].address;
+    mod_ctx.end_data = mod_ctx.data + sections[section_debug].size;
+    mod_ctx.word_size = 0; /* will be correctly set later on */
+
+    /* the thunk areas don't outlive our caller, so we can't defer when there are some */
+    if (!thunks && (num_ranges = dwarf2_parse_aranges(aranges, &ranges)))
+    {
+        if ((info->deferred_cus = HeapAlloc(GetProcessHeap(), 0, num_ranges * sizeof(*info->deferred_cus))))
+            qsort(ranges, num_ranges, sizeof(*ranges), cu_range_offset_cmp);
+        else
+            num_ranges = 0;
+    }
+
+    while (mod_ctx.data + 4 <= mod_ctx.end_data)
+    {
+        cu_offset = mod_ctx.data - sections[section_debug].address;
+        /* drop the ranges that don't point to a CU header */
+        while (i < num_ranges && ranges[i].cu_offset < cu_offset) i++;
+        if (i < num_ranges && ranges[i].cu_offset == cu_offset)
+        {
+            for (; i < num_ranges && ranges[i].cu_offset == cu_offset; i++)
+            {
+                ranges[j] = ranges[i];
+                ranges[j++].cu = info->num_deferred;
+            }
+            info->deferred_cus[info->num_deferred++] = mod_ctx.data;
+            mod_ctx.data += 4 + dwarf2_get_u4(mod_ctx.data);
+        }
+        else dwarf2_parse_compilation_unit(sections, modfmt->module, thunks, &mod_ctx, info->load_offset);
+    }
+
+    if (!info->num_deferred)
+    {
+        HeapFree(GetProcessHeap(), 0, ranges);
+        HeapFree(GetProcessHeap(), 0, info->deferred_cus);
+        info->deferred_cus = NULL;
+        return;
+    }
+    TRACE("Deferring %u compilation units of %s\n",
+          info->num_deferred, debugstr_w(modfmt->module->module.ModuleName));
+    qsort(ranges, j, sizeof(*ranges), cu_range_start_cmp);
+    info->cu_ranges = ranges;
+    info->num_cu_ranges = j;
+    info->num_pending = info->num_deferred;
+}
+
+static void dwarf2_parse_deferred_cu(struct module_format* modfmt, unsigned cu)
+{
+    struct dwarf2_module_info_s* info = modfmt->u.dwarf2_info;
+    dwarf2_traverse_context_t   mod_ctx;
+    unsigned char               word_size;
+
+    if (!info->deferred_cus[cu]) return;
+    mod_ctx.data = info->deferred_cus[cu];
+    mod_ctx.end_data = info->sections[section_debug].address + info->sections[section_debug].size;
+    mod_ctx.word_size = 0;
+    info->deferred_cus[cu] = NULL;
+    info->num_pending--;
+    /* keep the word_size used for eh_frame parsing */
+    word_size = info->word_size;
+    dwarf2_parse_compilation_unit(info->sections, modfmt->module, NULL, &mod_ctx, info->load_offset);
+    info->word_size = word_size;
+}
+
+/******************************************************************
+ *		dwarf2_load_deferred
+ *
+ * Parses the compilation units of a module whose loading has been deferred.
+ * If addr is 0, all of them are parsed, otherwise only the one covering addr
+ * (or all of them if none covers it, as .debug_aranges only lists code).
+ */
+void dwarf2_load_deferred(struct module* module, DWORD64 addr)
+{
+    struct module_format*       modfmt = module->format_info[DFI_DWARF];
+    struct dwarf2_module_info_s* info;
+    unsigned long               rva;
+    unsigned                    low, high, mid, i;
+
+    if (!modfmt || !(info = modfmt->u.dwarf2_info)->num_pending) return;
+
+    if (addr)
+    {
+        rva = addr - info->load_offset;
+        low = 0;
+        high = info->num_cu_ranges;
+        while (low < high)
+        {
+            mid = (low + high) / 2;
+            if (info->cu_ranges[mid].start <= rva) low = mid + 1;
+            else high = mid;
+        }
+        if (low && rva < info->cu_ranges[low - 1].end)
+        {
+            dwarf2_parse_deferred_cu(modfmt, info->cu_ranges[low - 1].cu);
+            module->module.NumSyms = module->ht_symbols.num_elts;
+            return;
+        }
+    }
+    for (i = 0; i < info->num_deferred; i++)
+        dwarf2_parse_deferred_cu(modfmt, i);
+    module->module.NumSyms = module->ht_symbols.num_elts;
+}
+
 BOOL dwarf2_parse(struct module* module, unsigned long load_offset,
                   const struct elf_thunk_area* thunks,
                   struct image_file_map* fmap)
 {
-    dwarf2_section_t    eh_frame, section[section_max];
-    dwarf2_traverse_context_t   mod_ctx;
+    dwarf2_section_t    eh_frame, aranges, section[section_max];
     struct image_section_map    debug_sect, debug_str_sect, debug_abbrev_sect,
-                                debug_line_sect, debug_ranges_sect, eh_frame_sect;
+                                debug_line_sect, debug_ranges_sect, debug_aranges_sect,
+                                eh_frame_sect;
     BOOL                ret = TRUE;
     struct module_format* dwarf2_modfmt;
 
@@ -3513,6 +3751,7 @@ BOOL dwarf2_parse(struct module* module, unsigned long load_offset,
     dwarf2_init_section(&section[section_string], fmap, ".debug_str",    ".zdebug_str",    &debug_str_sect);
     dwarf2_init_section(&section[section_line],   fmap, ".debug_line",   ".zdebug_line",   &debug_line_sect);
     dwarf2_init_section(&section[section_ranges], fmap, ".debug_ranges", ".zdebug_ranges", &debug_ranges_sect);
+    dwarf2_init_section(&aranges,                 fmap, ".debug_aranges", ".zdebug_aranges", &debug_aranges_sect);
 
     /* to do anything useful we need either .eh_frame or .debug_info */
     if ((!eh_frame.address || eh_frame.address == IMAGE_NO_MAP) &&
@@ -3533,11 +3772,7 @@ BOOL dwarf2_parse(struct module* module, unsigned long load_offset,
 
     TRACE("Loading Dwarf2 information for %s\n", debugstr_w(module->module.ModuleName));
 
-    mod_ctx.data = section[section_debug].address;
-    mod_ctx.end_data = mod_ctx.data + section[section_debug].size;
-    mod_ctx.word_size = 0; /* will be correctly set later on */
-
-    dwarf2_modfmt = HeapAlloc(GetProcessHeap(), 0,
+    dwarf2_modfmt = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY,
                               sizeof(*dwarf2_modfmt) + sizeof(*dwarf2_modfmt->u.dwarf2_info));
     if (!dwarf2_modfmt)
     {
@@ -3557,11 +3792,11 @@ BOOL dwarf2_parse(struct module* module, unsigned long load_offset,
     dwarf2_init_section(&dwarf2_modfmt->u.dwarf2_info->debug_loc,   fmap, ".debug_loc",   ".zdebug_loc",   NULL);
     dwarf2_init_section(&dwarf2_modfmt->u.dwarf2_info->debug_frame, fmap, ".debug_frame", ".zdebug_frame", NULL);
     dwarf2_modfmt->u.dwarf2_info->eh_frame = eh_frame;
+    memcpy(dwarf2_modfmt->u.dwarf2_info->sections, section, sizeof(section));
+    dwarf2_modfmt->u.dwarf2_info->load_offset = load_offset;
+
+    dwarf2_parse_compilation_units(dwarf2_modfmt, thunks, &aranges);
 
-    while (mod_ctx.data < mod_ctx.end_data)
-    {
-        dwarf2_parse_compilation_unit(section, dwarf2_modfmt->module, thunks, &mod_ctx, load_offset);
-    }
     dwarf2_modfmt->module->module.SymType = SymDia;
     dwarf2_modfmt->module->module.CVSig = 'D' | ('W' << 8) | ('A' << 16) | ('R' << 24);
     /* FIXME: we could have a finer grain here */
@@ -3573,6 +3808,9 @@ BOOL dwarf2_parse(struct module* module, unsigned long load_offset,
     /* set the word_size for eh_frame parsing */
     dwarf2_modfmt->u.dwarf2_info->word_size = fmap->addr_size / 8;
 
+    /* the remaining compilation units will be parsed out of these sections */
+    if (dwarf2_modfmt->u.dwarf2_info->num_pending) goto leave_aranges;
+
 leave:
     dwarf2_fini_section(&section[section_debug]);
     dwarf2_fini_section(&section[section_abbrev]);
@@ -3587,5 +3825,9 @@ leave:
     image_unmap_section(&debug_ranges_sect);
     if (!ret) image_unmap_section(&eh_frame_sect);
 
+leave_aranges:
+    dwarf2_fini_section(&aranges);
+    image_unmap_section(&debug_aranges_sect);
+
     return ret;
 }
@@ -1180,7 +1180,7 @@ static BOOL elf_load_debug_info_from_map(struct module* module,
                                          struct pool* pool,
                                          struct hash_table* ht_symtab)
 {
-    BOOL                ret = FALSE, lret;
+    BOOL                ret = FALSE, lret, builtin;
     struct elf_thunk_area thunks[] = 
     {
         {"__wine_spec_import_thunks",           THUNK_ORDINAL_NOTYPE, 0, 0},    /* inter DLL calls */
@@ -1194,6 +1194,9 @@ static BOOL elf_load_debug_info_from_map(struct module* module,
 
     module->module.SymType = SymExport;
 
+    builtin = strstrW(module->module.ModuleName, S_ElfW) ||
+        !strcmpW(module->module.ModuleName, S_WineLoaderW);
+
     /* create a hash table for the symtab */
     elf_hash_symtab(module, pool, ht_symtab, fmap, thunks);
 
@@ -1229,11 +1232,14 @@ static BOOL elf_load_debug_info_from_map(struct module* module,
             image_unmap_section(&stab_sect);
             image_unmap_section(&stabstr_sect);
         }
-        lret = dwarf2_parse(module, module->reloc_delta, thunks, fmap);
+        /* only Wine's own modules have thunk areas; as they also get symbols
+         * for the functions without debug information below, their DWARF
+         * compilation units can't be deferred
+         */
+        lret = dwarf2_parse(module, module->reloc_delta, builtin ? thunks : NULL, fmap);
         ret = ret || lret;
     }
-    if (strstrW(module->module.ModuleName, S_ElfW) ||
-        !strcmpW(module->module.ModuleName, S_WineLoaderW))
+    if (builtin)
     {
         /* add the thunks for native libraries */
         if (!(dbghelp_options & SYMOPT_PUBLICS_ONLY))
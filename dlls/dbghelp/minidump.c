@@ -358,6 +358,60 @@ void minidump_add_memory_block(struct dump_context* dc, ULONG64 base, ULONG size
     else dc->num_mem = dc->alloc_mem = 0;
 }
 
+/******************************************************************
+ *		minidump_add_memory64_block
+ *
+ * Add a memory block to be dumped in the Memory64 list of a full
+ * memory minidump. Contiguous blocks are merged.
+ */
+static void minidump_add_memory64_block(struct dump_context* dc, ULONG64 base, ULONG64 size)
+{
+    struct dump_memory64*       new;
+
+    if (dc->num_mem64 && dc->mem64[dc->num_mem64 - 1].base + dc->mem64[dc->num_mem64 - 1].size == base)
+    {
+        dc->mem64[dc->num_mem64 - 1].size += size;
+        return;
+    }
+    if (dc->num_mem64 >= dc->alloc_mem64)
+    {
+        if (!dc->mem64)
+        {
+            dc->alloc_mem64 = 32;
+            new = HeapAlloc(GetProcessHeap(), 0, dc->alloc_mem64 * sizeof(*dc->mem64));
+        }
+        else
+        {
+            dc->alloc_mem64 *= 2;
+            new = HeapReAlloc(GetProcessHeap(), 0, dc->mem64, dc->alloc_mem64 * sizeof(*dc->mem64));
+        }
+        if (!new) return;
+        dc->mem64 = new;
+    }
+    dc->mem64[dc->num_mem64].base = base;
+    dc->mem64[dc->num_mem64].size = size;
+    dc->num_mem64++;
+}
+
+/******************************************************************
+ *		fetch_memory64_info
+ *
+ * lists all the committed and readable memory of the process
+ */
+static void fetch_memory64_info(struct dump_context* dc)
+{
+    MEMORY_BASIC_INFORMATION    mbi;
+    ULONG_PTR                   addr = 0;
+
+    while (VirtualQueryEx(dc->hProcess, (const void*)addr, &mbi, sizeof(mbi)))
+    {
+        if (mbi.State == MEM_COMMIT && !(mbi.Protect & (PAGE_NOACCESS | PAGE_GUARD)))
+            minidump_add_memory64_block(dc, (ULONG_PTR)mbi.BaseAddress, mbi.RegionSize);
+        if ((ULONG_PTR)mbi.BaseAddress + mbi.RegionSize <= addr) break;
+        addr = (ULONG_PTR)mbi.BaseAddress + mbi.RegionSize;
+    }
+}
+
 /******************************************************************
  *		writeat
  *
@@ -383,6 +437,38 @@ static void append(struct dump_context* dc, const void* data, unsigned size)
     dc->rva += size;
 }
 
+/******************************************************************
+ *		write_memory
+ *
+ * copies a range of the target's memory at the current position in the
+ * minidump, going through buffer in chunks as large as possible.
+ * Unreadable pages are written as zeros, so that the layout of the file
+ * doesn't depend on the target's memory state.
+ */
+static void write_memory(struct dump_context* dc, ULONG64 base, ULONG64 size,
+                         char* buffer, DWORD buffer_size)
+{
+    DWORD       written, len, pos, step;
+
+    while (size)
+    {
+        len = min(size, buffer_size);
+        if (!ReadProcessMemory(dc->hProcess, (void*)(DWORD_PTR)base, buffer, len, NULL))
+        {
+            for (pos = 0; pos < len; pos += step)
+            {
+                step = min(len - pos, 0x1000 - ((base + pos) & 0xfff));
+                if (!ReadProcessMemory(dc->hProcess, (void*)(DWORD_PTR)(base + pos),
+                                       buffer + pos, step, NULL))
+                    memset(buffer + pos, 0, step);
+            }
+        }
+        WriteFile(dc->hFile, buffer, len, &written, NULL);
+        base += len;
+        size -= len;
+    }
+}
+
 /******************************************************************
  *		dump_exception_info
  *
@@ -791,10 +877,16 @@ static unsigned         dump_memory_info(struct dump_context* dc)
 {
     MINIDUMP_MEMORY_LIST        mdMemList;
     MINIDUMP_MEMORY_DESCRIPTOR  mdMem;
-    DWORD                       written;
-    unsigned                    i, pos, len, sz;
+    unsigned                    i, sz;
     RVA                         rva_base;
-    char                        tmp[1024];
+    char                        tmp[1024], *buffer;
+    DWORD                       buffer_size = 0x10000;
+
+    if (!(buffer = HeapAlloc(GetProcessHeap(), 0, buffer_size)))
+    {
+        buffer = tmp;
+        buffer_size = sizeof(tmp);
+    }
 
     mdMemList.NumberOfMemoryRanges = dc->num_mem;
     append(dc, &mdMemList.NumberOfMemoryRanges,
@@ -810,14 +902,7 @@ static unsigned         dump_memory_info(struct dump_context* dc)
         mdMem.Memory.Rva = dc->rva;
         mdMem.Memory.DataSize = dc->mem[i].size;
         SetFilePointer(dc->hFile, dc->rva, NULL, FILE_BEGIN);
-        for (pos = 0; pos < dc->mem[i].size; pos += sizeof(tmp))
-        {
-            len = min(dc->mem[i].size - pos, sizeof(tmp));
-            if (ReadProcessMemory(dc->hProcess, 
-                                  (void*)(DWORD_PTR)(dc->mem[i].base + pos),
-                                  tmp, len, NULL))
-                WriteFile(dc->hFile, tmp, len, &written, NULL);
-        }
+        write_memory(dc, dc->mem[i].base, dc->mem[i].size, buffer, buffer_size);
         dc->rva += mdMem.Memory.DataSize;
         writeat(dc, rva_base + i * sizeof(mdMem), &mdMem, sizeof(mdMem));
         if (dc->mem[i].rva)
@@ -825,6 +910,48 @@ static unsigned         dump_memory_info(struct dump_context* dc)
             writeat(dc, dc->mem[i].rva, &mdMem.Memory.Rva, sizeof(mdMem.Memory.Rva));
         }
     }
+    if (buffer != tmp) HeapFree(GetProcessHeap(), 0, buffer);
+
+    return sz;
+}
+
+/******************************************************************
+ *		dump_memory64_info
+ *
+ * dumps the whole memory of the process.
+ * As the memory content may not fit below 4GB, it's written after all the
+ * other streams (hence dc->rva isn't updated past it).
+ */
+static unsigned         dump_memory64_info(struct dump_context* dc)
+{
+    MINIDUMP_MEMORY64_LIST      mdMem64List;
+    MINIDUMP_MEMORY_DESCRIPTOR64 mdMem64;
+    unsigned                    i, sz;
+    char                        tmp[1024], *buffer;
+    DWORD                       buffer_size = 0x100000;
+
+    fetch_memory64_info(dc);
+
+    sz = FIELD_OFFSET(MINIDUMP_MEMORY64_LIST, MemoryRanges[dc->num_mem64]);
+    mdMem64List.NumberOfMemoryRanges = dc->num_mem64;
+    mdMem64List.BaseRva = dc->rva + sz;
+    append(dc, &mdMem64List, FIELD_OFFSET(MINIDUMP_MEMORY64_LIST, MemoryRanges));
+    for (i = 0; i < dc->num_mem64; i++)
+    {
+        mdMem64.StartOfMemoryRange = dc->mem64[i].base;
+        mdMem64.DataSize = dc->mem64[i].size;
+        append(dc, &mdMem64, sizeof(mdMem64));
+    }
+
+    if (!(buffer = HeapAlloc(GetProcessHeap(), 0, buffer_size)))
+    {
+        buffer = tmp;
+        buffer_size = sizeof(tmp);
+    }
+    /* the memory content is written sequentially from BaseRva */
+    for (i = 0; i < dc->num_mem64; i++)
+        write_memory(dc, dc->mem64[i].base, dc->mem64[i].size, buffer, buffer_size);
+    if (buffer != tmp) HeapFree(GetProcessHeap(), 0, buffer);
 
     return sz;
 }
@@ -874,6 +1001,9 @@ BOOL WINAPI MiniDumpWriteDump(HANDLE hProcess, DWORD pid, HANDLE hFile,
     dc.mem = NULL;
     dc.num_mem = 0;
     dc.alloc_mem = 0;
+    dc.mem64 = NULL;
+    dc.num_mem64 = 0;
+    dc.alloc_mem64 = 0;
     dc.rva = 0;
 
     if (!fetch_process_info(&dc)) return FALSE;
@@ -881,15 +1011,14 @@ BOOL WINAPI MiniDumpWriteDump(HANDLE hProcess, DWORD pid, HANDLE hFile,
 
     /* 1) init */
     nStreams = 6 + (ExceptionParam ? 1 : 0) +
-        (UserStreamParam ? UserStreamParam->UserStreamCount : 0);
+        (UserStreamParam ? UserStreamParam->UserStreamCount : 0) +
+        ((DumpType & MiniDumpWithFullMemory) ? 1 : 0);
 
     /* pad the directory size to a multiple of 4 for alignment purposes */
     nStreams = (nStreams + 3) & ~3;
 
     if (DumpType & MiniDumpWithDataSegs)
         FIXME("NIY MiniDumpWithDataSegs\n");
-    if (DumpType & MiniDumpWithFullMemory)
-        FIXME("NIY MiniDumpWithFullMemory\n");
     if (DumpType & MiniDumpWithHandleData)
         FIXME("NIY MiniDumpWithHandleData\n");
     if (DumpType & MiniDumpFilterMemory)
@@ -975,12 +1104,23 @@ BOOL WINAPI MiniDumpWriteDump(HANDLE hProcess, DWORD pid, HANDLE hFile,
         }
     }
 
+    /* 3.4) write the full memory content (if requested), must be the last stream */
+    if (DumpType & MiniDumpWithFullMemory)
+    {
+        mdDir.StreamType = Memory64ListStream;
+        mdDir.Location.Rva = dc.rva;
+        mdDir.Location.DataSize = dump_memory64_info(&dc);
+        writeat(&dc, mdHead.StreamDirectoryRva + idx_stream++ * sizeof(mdDir),
+                &mdDir, sizeof(mdDir));
+    }
+
     /* fill the remaining directory entries with 0's (unused stream types) */
     /* NOTE: this should always come last in the dump! */
     for (i = idx_stream; i < nStreams; i++)
         writeat(&dc, mdHead.StreamDirectoryRva + i * sizeof(emptyDir), &emptyDir, sizeof(emptyDir));
 
     HeapFree(GetProcessHeap(), 0, dc.mem);
+    HeapFree(GetProcessHeap(), 0, dc.mem64);
     HeapFree(GetProcessHeap(), 0, dc.modules);
     HeapFree(GetProcessHeap(), 0, dc.threads);
 
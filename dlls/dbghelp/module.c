@@ -352,7 +352,7 @@ struct module* module_get_containee(const struct process* pcs,
 }
 
 /******************************************************************
- *		module_get_debug
+ *		module_load_debug
  *
  * get the debug information from a module:
  * - if the module's type is deferred, then force loading of debug info (and return
@@ -361,7 +361,7 @@ struct module* module_get_containee(const struct process* pcs,
  *   container (and also force the ELF container's debug info loading if deferred)
  * - otherwise return the module itself if it has some debug info
  */
-BOOL module_get_debug(struct module_pair* pair)
+static BOOL module_load_debug(struct module_pair* pair)
 {
     IMAGEHLP_DEFERRED_SYMBOL_LOADW64    idslW64;
 
@@ -410,6 +410,32 @@ BOOL module_get_debug(struct module_pair* pair)
     return pair->effective->module.SymType != SymNone;
 }
 
+/***********************************************************************
+ *			module_get_debug
+ *
+ * same as module_load_debug, also loading all the debug information
+ * whose parsing has been deferred
+ */
+BOOL module_get_debug(struct module_pair* pair)
+{
+    if (!module_load_debug(pair)) return FALSE;
+    dwarf2_load_deferred(pair->effective, 0);
+    return TRUE;
+}
+
+/***********************************************************************
+ *			module_get_debug_addr
+ *
+ * same as module_load_debug, but only requires the debug information
+ * covering addr to be loaded
+ */
+BOOL module_get_debug_addr(struct module_pair* pair, DWORD64 addr)
+{
+    if (!module_load_debug(pair)) return FALSE;
+    dwarf2_load_deferred(pair->effective, addr);
+    return TRUE;
+}
+
 /***********************************************************************
  *	module_find_by_addr
  *
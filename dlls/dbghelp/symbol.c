@@ -755,26 +755,6 @@ static BOOL symt_enum_module(struct module_pair* pair, const WCHAR* match,
     return FALSE;
 }
 
-static inline unsigned where_to_insert(struct module* module, unsigned high, const struct symt_ht* elt)
-{
-    unsigned    low = 0, mid = high / 2;
-    ULONG64     addr;
-
-    if (!high) return 0;
-    symt_get_address(&elt->symt, &addr);
-    do
-    {
-        switch (cmp_sorttab_addr(module, mid, addr))
-        {
-        case 0: return mid;
-        case -1: low = mid + 1; break;
-        case 1: high = mid; break;
-        }
-        mid = low + (high - low) / 2;
-    } while (low < high);
-    return mid;
-}
-
 /***********************************************************************
  *              resort_symbols
  *
@@ -789,43 +769,40 @@ static BOOL resort_symbols(struct module* module)
 
     /* we know that set from 0 up to num_sorttab is already sorted
      * so sort the remaining (new) symbols, and merge the two sets
-     * (unless the first set is empty)
+     * (unless the first set is empty), starting from the end
      */
     delta = module->num_symbols - module->num_sorttab;
     qsort(&module->addr_sorttab[module->num_sorttab], delta, sizeof(struct symt_ht*), symt_cmp_addr);
-    if (module->num_sorttab)
+    if (module->num_sorttab && delta)
     {
-        int     i, ins_idx = module->num_sorttab, prev_ins_idx;
-        static struct symt_ht** tmp;
-        static unsigned num_tmp;
+        int     i = module->num_sorttab - 1, j = delta - 1, k = module->num_symbols - 1;
+        struct symt_ht** tmp;
+        ULONG64 addr_old, addr_new;
 
-        if (num_tmp < delta)
+        if (!(tmp = HeapAlloc(GetProcessHeap(), 0, delta * sizeof(struct symt_ht*))))
         {
-            static struct symt_ht** new;
-            if (tmp)
-                new = HeapReAlloc(GetProcessHeap(), 0, tmp, delta * sizeof(struct symt_ht*));
-            else
-                new = HeapAlloc(GetProcessHeap(), 0, delta * sizeof(struct symt_ht*));
-            if (!new)
-            {
-                module->num_sorttab = 0;
-                return resort_symbols(module);
-            }
-            tmp = new;
-            num_tmp = delta;
+            qsort(module->addr_sorttab, module->num_symbols, sizeof(struct symt_ht*), symt_cmp_addr);
+            module->num_sorttab = module->num_symbols;
+            return module->sortlist_valid = TRUE;
         }
         memcpy(tmp, &module->addr_sorttab[module->num_sorttab], delta * sizeof(struct symt_ht*));
-        qsort(tmp, delta, sizeof(struct symt_ht*), symt_cmp_addr);
 
-        for (i = delta - 1; i >= 0; i--)
+        symt_get_address(&module->addr_sorttab[i]->symt, &addr_old);
+        symt_get_address(&tmp[j]->symt, &addr_new);
+        while (j >= 0)
         {
-            prev_ins_idx = ins_idx;
-            ins_idx = where_to_insert(module, ins_idx, tmp[i]);
-            memmove(&module->addr_sorttab[ins_idx + i + 1],
-                    &module->addr_sorttab[ins_idx],
-                    (prev_ins_idx - ins_idx) * sizeof(struct symt_ht*));
-            module->addr_sorttab[ins_idx + i] = tmp[i];
+            if (i >= 0 && addr_old > addr_new)
+            {
+                module->addr_sorttab[k--] = module->addr_sorttab[i--];
+                if (i >= 0) symt_get_address(&module->addr_sorttab[i]->symt, &addr_old);
+            }
+            else
+            {
+                module->addr_sorttab[k--] = tmp[j--];
+                if (j >= 0) symt_get_address(&tmp[j]->symt, &addr_new);
+            }
         }
+        HeapFree(GetProcessHeap(), 0, tmp);
     }
     module->num_sorttab = module->num_symbols;
     return module->sortlist_valid = TRUE;
@@ -964,7 +941,7 @@ static BOOL symt_enum_locals(struct process* pcs, const WCHAR* mask,
 
     pair.pcs = pcs;
     pair.requested = module_find_by_addr(pair.pcs, pc, DMT_UNKNOWN);
-    if (!module_get_debug(&pair)) return FALSE;
+    if (!module_get_debug_addr(&pair, pc)) return FALSE;
     if ((sym = symt_find_nearest(pair.effective, pc)) == NULL) return FALSE;
 
     if (sym->symt.tag == SymTagFunction)
@@ -1224,7 +1201,7 @@ BOOL WINAPI SymFromAddr(HANDLE hProcess, DWORD64 Address,
     pair.pcs = process_find_by_handle(hProcess);
     if (!pair.pcs) return FALSE;
     pair.requested = module_find_by_addr(pair.pcs, Address, DMT_UNKNOWN);
-    if (!module_get_debug(&pair)) return FALSE;
+    if (!module_get_debug_addr(&pair, Address)) return FALSE;
     if ((sym = symt_find_nearest(pair.effective, Address)) == NULL) return FALSE;
 
     symt_fill_sym_info(&pair, NULL, &sym->symt, Symbol);
@@ -1583,7 +1560,7 @@ BOOL WINAPI SymGetLineFromAddr64(HANDLE hProcess, DWORD64 dwAddr,
     pair.pcs = process_find_by_handle(hProcess);
     if (!pair.pcs) return FALSE;
     pair.requested = module_find_by_addr(pair.pcs, dwAddr, DMT_UNKNOWN);
-    if (!module_get_debug(&pair)) return FALSE;
+    if (!module_get_debug_addr(&pair, dwAddr)) return FALSE;
     if ((symt = symt_find_nearest(pair.effective, dwAddr)) == NULL) return FALSE;
 
     if (symt->symt.tag != SymTagFunction) return FALSE;
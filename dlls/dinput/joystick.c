@@ -749,7 +749,9 @@ HRESULT WINAPI JoystickWGenericImpl_GetDeviceState(LPDIRECTINPUTDEVICE8W iface,
     This->joy_polldev(IDirectInputDevice8A_from_impl(This));
 
     /* convert and copy data to user supplied buffer */
+    EnterCriticalSection(&This->base.crit);
     fill_DataFormat(ptr, len, &This->js, &This->base.data_format);
+    LeaveCriticalSection(&This->base.crit);
 
     return DI_OK;
 }
@@ -93,6 +93,10 @@ const WCHAR wine_vxd_drv[] = { 'w','i','n','e','m','m','.','v','x','d', 0 };
 
 /* All default settings, you most likely don't want to touch these, see wiki on UsefulRegistryKeys */
 int ds_hel_buflen = 32768 * 2;
+/* Mixing period and device buffer duration in 100-nanosecond units, a zero
+ * period means the audio engine default */
+int ds_mix_period = 0;
+int ds_mix_buffer_duration = 800000;
 static HINSTANCE instance;
 
 /*
@@ -145,10 +149,18 @@ void setup_dsound_options(void)
     if (!get_config_key( hkey, appkey, "HelBuflen", buffer, MAX_PATH ))
         ds_hel_buflen = atoi(buffer);
 
+    if (!get_config_key( hkey, appkey, "MixPeriod", buffer, MAX_PATH ))
+        ds_mix_period = max(atoi(buffer), 0);
+
+    if (!get_config_key( hkey, appkey, "MixBufferDuration", buffer, MAX_PATH ))
+        ds_mix_buffer_duration = max(atoi(buffer), 0);
+
     if (appkey) RegCloseKey( appkey );
     if (hkey) RegCloseKey( hkey );
 
     TRACE("ds_hel_buflen = %d\n", ds_hel_buflen);
+    TRACE("ds_mix_period = %d\n", ds_mix_period);
+    TRACE("ds_mix_buffer_duration = %d\n", ds_mix_buffer_duration);
 }
 
 static const char * get_device_id(LPCGUID pGuid)
@@ -36,6 +36,8 @@
 #define DS_MAX_CHANNELS 6
 
 extern int ds_hel_buflen DECLSPEC_HIDDEN;
+extern int ds_mix_period DECLSPEC_HIDDEN;
+extern int ds_mix_buffer_duration DECLSPEC_HIDDEN;
 
 /*****************************************************************************
  * Predeclare the interface implementation structures
@@ -278,12 +278,25 @@ static inline float get_current_sample(const IDirectSoundBufferImpl *dsb,
     return dsb->get(dsb, mixpos % dsb->buflen, channel);
 }
 
+/* number of frames that can be read from the mix position without wrapping around */
+static inline UINT get_contiguous_frames(const IDirectSoundBufferImpl *dsb, UINT count)
+{
+    if (dsb->sec_mixpos >= dsb->buflen) return 0;
+    return min(count, (dsb->buflen - dsb->sec_mixpos) / dsb->pwfx->nBlockAlign);
+}
+
 static UINT cp_fields_noresample(IDirectSoundBufferImpl *dsb, UINT count)
 {
     UINT istride = dsb->pwfx->nBlockAlign;
     UINT ostride = dsb->device->pwfx->nChannels * sizeof(float);
+    UINT contiguous = get_contiguous_frames(dsb, count);
     DWORD channel, i;
-    for (i = 0; i < count; i++)
+
+    for (i = 0; i < contiguous; i++)
+        for (channel = 0; channel < dsb->mix_channels; channel++)
+            dsb->put(dsb, i * ostride, channel, dsb->get(dsb,
+                    dsb->sec_mixpos + i * istride, channel));
+    for (; i < count; i++)
         for (channel = 0; channel < dsb->mix_channels; channel++)
             dsb->put(dsb, i * ostride, channel, get_current_sample(dsb,
                     dsb->sec_mixpos + i * istride, channel));
@@ -305,6 +318,7 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *
     UINT fir_cachesize = (fir_len + dsbfirstep - 2) / dsbfirstep;
     UINT required_input = max_ipos + fir_cachesize;
     float *intermediate, *fir_copy, *itmp;
+    UINT contiguous;
 
     DWORD len = required_input * channels;
     len += fir_cachesize;
@@ -327,10 +341,15 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *
      * This is good for CPU cache effects, too.
      */
     itmp = intermediate;
+    contiguous = get_contiguous_frames(dsb, required_input);
     for (channel = 0; channel < channels; channel++)
-        for (i = 0; i < required_input; i++)
+    {
+        for (i = 0; i < contiguous; i++)
+            *(itmp++) = dsb->get(dsb, dsb->sec_mixpos + i * istride, channel);
+        for (; i < required_input; i++)
             *(itmp++) = get_current_sample(dsb,
                     dsb->sec_mixpos + i * istride, channel);
+    }
 
     for(i = 0; i < count; ++i) {
         UINT int_fir_steps = (freqAcc_start + i * dsb->freqAdjustNum) * dsbfirstep / dsb->freqAdjustDen;
@@ -338,11 +357,11 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *
         UINT ipos = int_fir_steps / dsbfirstep;
 
         UINT idx = (ipos + 1) * dsbfirstep - int_fir_steps - 1;
-        float rem = int_fir_steps + 1.0 - total_fir_steps;
+        float rem = int_fir_steps + 1.0f - total_fir_steps;
 
         int fir_used = 0;
         while (idx < fir_len - 1) {
-            fir_copy[fir_used++] = fir[idx] * (1.0 - rem) + fir[idx + 1] * rem;
+            fir_copy[fir_used++] = fir[idx] * (1.0f - rem) + fir[idx + 1] * rem;
             idx += dsb->firstep;
         }
 
@@ -351,11 +370,21 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *
 
         for (channel = 0; channel < dsb->mix_channels; channel++) {
             int j;
-            float sum = 0.0;
+            float sum[4] = {0.0f};
             float* cache = &intermediate[channel * required_input + ipos];
-            for (j = 0; j < fir_used; j++)
-                sum += fir_copy[j] * cache[j];
-            dsb->put(dsb, i * ostride, channel, sum * dsb->firgain);
+
+            /* independent partial sums, so that the multiply-adds can
+             * be pipelined or turned into vector operations */
+            for (j = 0; j + 4 <= fir_used; j += 4) {
+                sum[0] += fir_copy[j] * cache[j];
+                sum[1] += fir_copy[j + 1] * cache[j + 1];
+                sum[2] += fir_copy[j + 2] * cache[j + 2];
+                sum[3] += fir_copy[j + 3] * cache[j + 3];
+            }
+            for (; j < fir_used; j++)
+                sum[0] += fir_copy[j] * cache[j];
+            dsb->put(dsb, i * ostride, channel,
+                    ((sum[0] + sum[1]) + (sum[2] + sum[3])) * dsb->firgain);
         }
     }
 
@@ -446,11 +475,16 @@ static void DSOUND_MixToTemporary(IDirectSoundBufferImpl *dsb, DWORD frames)
 	}
 }
 
-static void DSOUND_MixerVol(const IDirectSoundBufferImpl *dsb, INT frames)
+/**
+ * Mix the temporary buffer into the mix buffer, applying the volume of
+ * the secondary buffer on the fly.
+ */
+static void DSOUND_MixerVol(const IDirectSoundBufferImpl *dsb, float *mix_buffer, INT frames)
 {
 	INT	i;
 	float vols[DS_MAX_CHANNELS];
 	UINT channels = dsb->device->pwfx->nChannels, chan;
+	const float *ibuf = dsb->device->tmp_buffer;
 
 	TRACE("(%p,%d)\n",dsb,frames);
 	TRACE("left = %x, right = %x\n", dsb->volpan.dwTotalAmpFactor[0],
@@ -459,20 +493,37 @@ static void DSOUND_MixerVol(const IDirectSoundBufferImpl *dsb, INT frames)
 	if ((!(dsb->dsbd.dwFlags & DSBCAPS_CTRLPAN) || (dsb->volpan.lPan == 0)) &&
 	    (!(dsb->dsbd.dwFlags & DSBCAPS_CTRLVOLUME) || (dsb->volpan.lVolume == 0)) &&
 	     !(dsb->dsbd.dwFlags & DSBCAPS_CTRL3D))
-		return; /* Nothing to do */
+	{
+		/* No volume to apply */
+		mixieee32(dsb->device->tmp_buffer, mix_buffer, frames * channels);
+		return;
+	}
 
 	if (channels > DS_MAX_CHANNELS)
 	{
 		FIXME("There is no support for %u channels\n", channels);
+		mixieee32(dsb->device->tmp_buffer, mix_buffer, frames * channels);
 		return;
 	}
 
 	for (i = 0; i < channels; ++i)
 		vols[i] = dsb->volpan.dwTotalAmpFactor[i] / ((float)0xFFFF);
 
+	if (channels == 2)
+	{
+		float left = vols[0], right = vols[1];
+
+		for (i = 0; i < frames; ++i)
+		{
+			mix_buffer[2 * i] += ibuf[2 * i] * left;
+			mix_buffer[2 * i + 1] += ibuf[2 * i + 1] * right;
+		}
+		return;
+	}
+
 	for(i = 0; i < frames; ++i){
 		for(chan = 0; chan < channels; ++chan){
-			dsb->device->tmp_buffer[i * channels + chan] *= vols[chan];
+			mix_buffer[i * channels + chan] += ibuf[i * channels + chan] * vols[chan];
 		}
 	}
 }
@@ -491,7 +542,6 @@ static void DSOUND_MixerVol(const IDirectSoundBufferImpl *dsb, INT frames)
  */
 static DWORD DSOUND_MixInBuffer(IDirectSoundBufferImpl *dsb, float *mix_buffer, DWORD frames)
 {
-	float *ibuf;
 	DWORD oldpos;
 
 	TRACE("sec_mixpos=%d/%d\n", dsb->sec_mixpos, dsb->buflen);
@@ -500,12 +550,9 @@ static DWORD DSOUND_MixInBuffer(IDirectSoundBufferImpl *dsb, float *mix_buffer,
 	/* Resample buffer to temporary buffer specifically allocated for this purpose, if needed */
 	oldpos = dsb->sec_mixpos;
 	DSOUND_MixToTemporary(dsb, frames);
-	ibuf = dsb->device->tmp_buffer;
-
-	/* Apply volume if needed */
-	DSOUND_MixerVol(dsb, frames);
 
-	mixieee32(ibuf, mix_buffer, frames * dsb->device->pwfx->nChannels);
+	/* Apply volume if needed, and mix into the device buffer */
+	DSOUND_MixerVol(dsb, mix_buffer, frames);
 
 	/* check for notification positions */
 	if (dsb->dsbd.dwFlags & DSBCAPS_CTRLPOSITIONNOTIFY &&
@@ -282,6 +282,42 @@ static HRESULT DSOUND_PrimaryOpen(DirectSoundDevice *device, WAVEFORMATEX *wfx,
     return DS_OK;
 }
 
+/* Shared mode streams always run at the engine period, unless the client
+ * asks for a specific one through IAudioClient3. */
+static HRESULT DSOUND_InitializeLowLatency(IAudioClient *client, const WAVEFORMATEX *wfx)
+{
+    UINT32 def_frames, unit_frames, min_frames, max_frames, frames;
+    IAudioClient3 *client3;
+    HRESULT hres;
+
+    hres = IAudioClient_QueryInterface(client, &IID_IAudioClient3, (void **)&client3);
+    if (FAILED(hres)) {
+        TRACE("IAudioClient3 not supported, using the default period\n");
+        return hres;
+    }
+
+    hres = IAudioClient3_GetSharedModeEnginePeriod(client3, wfx, &def_frames,
+            &unit_frames, &min_frames, &max_frames);
+    if (SUCCEEDED(hres)) {
+        frames = MulDiv(wfx->nSamplesPerSec, ds_mix_period, 10000000);
+        frames = max(min_frames, min(frames, max_frames));
+        if (unit_frames)
+            frames = min_frames + (frames - min_frames) / unit_frames * unit_frames;
+
+        TRACE("period %u frames (engine default %u, min %u, max %u)\n",
+                frames, def_frames, min_frames, max_frames);
+
+        hres = IAudioClient3_InitializeSharedAudioStream(client3,
+                AUDCLNT_STREAMFLAGS_NOPERSIST | AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
+                frames, wfx, NULL);
+    }
+    if (FAILED(hres))
+        WARN("Low latency initialization failed: %08x\n", hres);
+
+    IAudioClient3_Release(client3);
+    return hres;
+}
+
 HRESULT DSOUND_ReopenDevice(DirectSoundDevice *device, BOOL forcewave)
 {
     HRESULT hres;
@@ -310,9 +346,13 @@ HRESULT DSOUND_ReopenDevice(DirectSoundDevice *device, BOOL forcewave)
         return hres;
     }
 
-    hres = IAudioClient_Initialize(client,
-            AUDCLNT_SHAREMODE_SHARED, AUDCLNT_STREAMFLAGS_NOPERSIST |
-            AUDCLNT_STREAMFLAGS_EVENTCALLBACK, 800000, 0, wfx, NULL);
+    hres = E_FAIL;
+    if (ds_mix_period)
+        hres = DSOUND_InitializeLowLatency(client, wfx);
+    if (FAILED(hres))
+        hres = IAudioClient_Initialize(client,
+                AUDCLNT_SHAREMODE_SHARED, AUDCLNT_STREAMFLAGS_NOPERSIST |
+                AUDCLNT_STREAMFLAGS_EVENTCALLBACK, ds_mix_buffer_duration, 0, wfx, NULL);
     if(FAILED(hres)){
         IAudioClient_Release(client);
         ERR("Initialize failed: %08x\n", hres);
@@ -187,6 +187,16 @@ extern HRESULT create_gdiinterop(IDWriteFactory5*,IDWriteGdiInterop1**) DECLSPEC
 extern void fontface_detach_from_cache(IDWriteFontFace4*) DECLSPEC_HIDDEN;
 extern void factory_lock(IDWriteFactory5*) DECLSPEC_HIDDEN;
 extern void factory_unlock(IDWriteFactory5*) DECLSPEC_HIDDEN;
+
+struct shaping_cache
+{
+    struct list entries; /* ordered by last use, most recent first */
+    SIZE_T size;         /* total size of cached entries */
+};
+
+extern struct shaping_cache *factory_get_shaping_cache(IDWriteFactory5*) DECLSPEC_HIDDEN;
+extern void release_shaping_cache(struct shaping_cache*) DECLSPEC_HIDDEN;
+extern void shaping_cache_detach_fontface(struct shaping_cache*,IDWriteFontFace*) DECLSPEC_HIDDEN;
 extern HRESULT create_inmemory_fileloader(IDWriteFontFileLoader**) DECLSPEC_HIDDEN;
 
 /* Opentype font table functions */
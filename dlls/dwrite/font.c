@@ -497,12 +497,12 @@ static ULONG WINAPI dwritefontface_Release(IDWriteFontFace4 *iface)
     if (!ref) {
         UINT32 i;
 
-        if (This->cached) {
-            factory_lock(This->factory);
+        factory_lock(This->factory);
+        shaping_cache_detach_fontface(factory_get_shaping_cache(This->factory), (IDWriteFontFace *)iface);
+        if (This->cached)
             list_remove(&This->cached->entry);
-            factory_unlock(This->factory);
-            heap_free(This->cached);
-        }
+        factory_unlock(This->factory);
+        heap_free(This->cached);
 
         if (This->cmap.context)
             IDWriteFontFace4_ReleaseFontTable(iface, This->cmap.context);
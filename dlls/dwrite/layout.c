@@ -921,10 +921,214 @@ fatal:
     return hr;
 }
 
+/* Shaping results are cached per factory, so that layouts created for the same text reuse them. */
+#define SHAPING_CACHE_MAX_SIZE (1024 * 1024)
+
+struct shaping_cache_entry {
+    struct list entry;
+    SIZE_T size;               /* total allocation size, including the arrays below */
+    UINT32 hash;
+
+    /* key */
+    IDWriteFontFace *fontface; /* not referenced, entries are removed when the face is destroyed */
+    const WCHAR *string;
+    UINT32 length;
+    const WCHAR *locale;
+    FLOAT emsize;
+    BOOL is_sideways;
+    BOOL is_rtl;
+    DWRITE_SCRIPT_ANALYSIS sa;
+    DWRITE_MEASURING_MODE measuringmode;
+    /* only meaningful for gdi-compatible measuring modes */
+    FLOAT ppdip;
+    DWRITE_MATRIX transform;
+
+    /* shaping results */
+    UINT32 glyphcount;
+    FLOAT *advances;
+    DWRITE_GLYPH_OFFSET *offsets;
+    UINT16 *glyphs;
+    UINT16 *clustermap;
+};
+
+static UINT32 hash_data(UINT32 hash, const void *data, SIZE_T size)
+{
+    const BYTE *ptr = data;
+
+    while (size--)
+        hash = (hash ^ *ptr++) * 16777619;
+    return hash;
+}
+
+static void shaping_cache_init_key(struct dwrite_textlayout *layout, const struct regular_layout_run *run,
+        struct shaping_cache_entry *key)
+{
+    memset(key, 0, sizeof(*key));
+    key->fontface = run->run.fontFace;
+    key->string = run->descr.string;
+    key->length = run->descr.stringLength;
+    key->locale = run->descr.localeName;
+    key->emsize = run->run.fontEmSize;
+    key->is_sideways = run->run.isSideways;
+    key->is_rtl = run->run.bidiLevel & 1;
+    key->sa = run->sa;
+    key->measuringmode = layout->measuringmode;
+    if (is_layout_gdi_compatible(layout)) {
+        key->ppdip = layout->ppdip;
+        key->transform = layout->transform;
+    }
+
+    key->hash = hash_data(2166136261, key->string, key->length * sizeof(WCHAR));
+    key->hash = hash_data(key->hash, key->locale, strlenW(key->locale) * sizeof(WCHAR));
+    key->hash = hash_data(key->hash, &key->fontface, sizeof(key->fontface));
+    key->hash = hash_data(key->hash, &key->emsize, sizeof(key->emsize));
+    key->hash = hash_data(key->hash, &key->sa, sizeof(key->sa));
+}
+
+static BOOL shaping_cache_key_equal(const struct shaping_cache_entry *key, const struct shaping_cache_entry *entry)
+{
+    return key->hash == entry->hash &&
+            key->fontface == entry->fontface &&
+            key->length == entry->length &&
+            key->emsize == entry->emsize &&
+            key->is_sideways == entry->is_sideways &&
+            key->is_rtl == entry->is_rtl &&
+            key->sa.script == entry->sa.script &&
+            key->sa.shapes == entry->sa.shapes &&
+            key->measuringmode == entry->measuringmode &&
+            key->ppdip == entry->ppdip &&
+            !memcmp(&key->transform, &entry->transform, sizeof(key->transform)) &&
+            !memcmp(key->string, entry->string, key->length * sizeof(WCHAR)) &&
+            !strcmpW(key->locale, entry->locale);
+}
+
+static void shaping_cache_remove_entry(struct shaping_cache *cache, struct shaping_cache_entry *entry)
+{
+    list_remove(&entry->entry);
+    cache->size -= entry->size;
+    heap_free(entry);
+}
+
+void release_shaping_cache(struct shaping_cache *cache)
+{
+    struct shaping_cache_entry *entry, *entry2;
+
+    LIST_FOR_EACH_ENTRY_SAFE(entry, entry2, &cache->entries, struct shaping_cache_entry, entry)
+        shaping_cache_remove_entry(cache, entry);
+}
+
+/* Called with factory lock held. */
+void shaping_cache_detach_fontface(struct shaping_cache *cache, IDWriteFontFace *fontface)
+{
+    struct shaping_cache_entry *entry, *entry2;
+
+    LIST_FOR_EACH_ENTRY_SAFE(entry, entry2, &cache->entries, struct shaping_cache_entry, entry) {
+        if (entry->fontface == fontface)
+            shaping_cache_remove_entry(cache, entry);
+    }
+}
+
+/* Fills run arrays from cached results, returns FALSE if the key is not in the cache. */
+static BOOL layout_get_cached_shaping(struct dwrite_textlayout *layout, const struct shaping_cache_entry *key,
+        struct regular_layout_run *run)
+{
+    struct shaping_cache *cache = factory_get_shaping_cache(layout->factory);
+    struct shaping_cache_entry *entry;
+    BOOL found = FALSE;
+
+    factory_lock(layout->factory);
+    LIST_FOR_EACH_ENTRY(entry, &cache->entries, struct shaping_cache_entry, entry) {
+        if (!shaping_cache_key_equal(key, entry))
+            continue;
+
+        run->glyphs = heap_alloc(entry->glyphcount * sizeof(*run->glyphs));
+        run->clustermap = heap_alloc(entry->length * sizeof(*run->clustermap));
+        run->advances = heap_alloc(entry->glyphcount * sizeof(*run->advances));
+        run->offsets = heap_alloc(entry->glyphcount * sizeof(*run->offsets));
+        if (run->glyphs && run->clustermap && run->advances && run->offsets) {
+            run->glyphcount = entry->glyphcount;
+            memcpy(run->glyphs, entry->glyphs, entry->glyphcount * sizeof(*run->glyphs));
+            memcpy(run->clustermap, entry->clustermap, entry->length * sizeof(*run->clustermap));
+            memcpy(run->advances, entry->advances, entry->glyphcount * sizeof(*run->advances));
+            memcpy(run->offsets, entry->offsets, entry->glyphcount * sizeof(*run->offsets));
+            found = TRUE;
+        }
+        else {
+            heap_free(run->glyphs);
+            heap_free(run->clustermap);
+            heap_free(run->advances);
+            heap_free(run->offsets);
+            run->glyphs = run->clustermap = NULL;
+            run->advances = NULL;
+            run->offsets = NULL;
+        }
+
+        /* move to the front, the list is ordered by last use */
+        list_remove(&entry->entry);
+        list_add_head(&cache->entries, &entry->entry);
+        break;
+    }
+    factory_unlock(layout->factory);
+
+    return found;
+}
+
+static void layout_cache_shaping(struct dwrite_textlayout *layout, const struct shaping_cache_entry *key,
+        const struct regular_layout_run *run)
+{
+    struct shaping_cache *cache = factory_get_shaping_cache(layout->factory);
+    struct shaping_cache_entry *entry;
+    UINT32 locale_len = strlenW(key->locale) + 1;
+    SIZE_T size;
+    BYTE *ptr;
+
+    size = sizeof(*entry) + run->glyphcount * (sizeof(*entry->advances) + sizeof(*entry->offsets) +
+            sizeof(*entry->glyphs)) + key->length * (sizeof(*entry->clustermap) + sizeof(WCHAR)) +
+            locale_len * sizeof(WCHAR);
+    if (size > SHAPING_CACHE_MAX_SIZE / 16)
+        return;
+
+    if (!(entry = heap_alloc(size)))
+        return;
+
+    *entry = *key;
+    entry->size = size;
+    entry->glyphcount = run->glyphcount;
+
+    ptr = (BYTE *)(entry + 1);
+    entry->advances = (FLOAT *)ptr;
+    memcpy(entry->advances, run->advances, run->glyphcount * sizeof(*entry->advances));
+    ptr += run->glyphcount * sizeof(*entry->advances);
+    entry->offsets = (DWRITE_GLYPH_OFFSET *)ptr;
+    memcpy(entry->offsets, run->offsets, run->glyphcount * sizeof(*entry->offsets));
+    ptr += run->glyphcount * sizeof(*entry->offsets);
+    entry->glyphs = (UINT16 *)ptr;
+    memcpy(entry->glyphs, run->glyphs, run->glyphcount * sizeof(*entry->glyphs));
+    ptr += run->glyphcount * sizeof(*entry->glyphs);
+    entry->clustermap = (UINT16 *)ptr;
+    memcpy(entry->clustermap, run->clustermap, key->length * sizeof(*entry->clustermap));
+    ptr += key->length * sizeof(*entry->clustermap);
+    entry->string = (WCHAR *)ptr;
+    memcpy((WCHAR *)entry->string, key->string, key->length * sizeof(WCHAR));
+    ptr += key->length * sizeof(WCHAR);
+    entry->locale = (WCHAR *)ptr;
+    memcpy((WCHAR *)entry->locale, key->locale, locale_len * sizeof(WCHAR));
+
+    factory_lock(layout->factory);
+    list_add_head(&cache->entries, &entry->entry);
+    cache->size += size;
+    while (cache->size > SHAPING_CACHE_MAX_SIZE) {
+        struct shaping_cache_entry *oldest = LIST_ENTRY(list_tail(&cache->entries), struct shaping_cache_entry, entry);
+        shaping_cache_remove_entry(cache, oldest);
+    }
+    factory_unlock(layout->factory);
+}
+
 static HRESULT layout_shape_run(struct dwrite_textlayout *layout, struct regular_layout_run *run)
 {
     DWRITE_SHAPING_GLYPH_PROPERTIES *glyph_props;
     DWRITE_SHAPING_TEXT_PROPERTIES *text_props;
+    struct shaping_cache_entry key;
     IDWriteTextAnalyzer *analyzer;
     struct layout_range *range;
     UINT32 max_count;
@@ -932,6 +1136,11 @@ static HRESULT layout_shape_run(struct dwrite_textlayout *layout, struct regular
 
     range = get_layout_range_by_pos(layout, run->descr.textPosition);
     run->descr.localeName = range->locale;
+
+    shaping_cache_init_key(layout, run, &key);
+    if (layout_get_cached_shaping(layout, &key, run))
+        goto done;
+
     run->clustermap = heap_alloc(run->descr.stringLength * sizeof(*run->clustermap));
 
     max_count = 3 * run->descr.stringLength / 2 + 16;
@@ -979,9 +1188,6 @@ static HRESULT layout_shape_run(struct dwrite_textlayout *layout, struct regular
         return hr;
     }
 
-    run->run.glyphIndices = run->glyphs;
-    run->descr.clusterMap = run->clustermap;
-
     run->advances = heap_alloc(run->glyphcount * sizeof(*run->advances));
     run->offsets = heap_alloc(run->glyphcount * sizeof(*run->offsets));
     if (!run->advances || !run->offsets)
@@ -989,14 +1195,14 @@ static HRESULT layout_shape_run(struct dwrite_textlayout *layout, struct regular
 
     /* Get advances and offsets. */
     if (is_layout_gdi_compatible(layout))
-        hr = IDWriteTextAnalyzer_GetGdiCompatibleGlyphPlacements(analyzer, run->descr.string, run->descr.clusterMap,
-                text_props, run->descr.stringLength, run->run.glyphIndices, glyph_props, run->glyphcount,
+        hr = IDWriteTextAnalyzer_GetGdiCompatibleGlyphPlacements(analyzer, run->descr.string, run->clustermap,
+                text_props, run->descr.stringLength, run->glyphs, glyph_props, run->glyphcount,
                 run->run.fontFace, run->run.fontEmSize, layout->ppdip, &layout->transform,
                 layout->measuringmode == DWRITE_MEASURING_MODE_GDI_NATURAL, run->run.isSideways, run->run.bidiLevel & 1,
                 &run->sa, run->descr.localeName, NULL, NULL, 0, run->advances, run->offsets);
     else
-        hr = IDWriteTextAnalyzer_GetGlyphPlacements(analyzer, run->descr.string, run->descr.clusterMap, text_props,
-                run->descr.stringLength, run->run.glyphIndices, glyph_props, run->glyphcount, run->run.fontFace,
+        hr = IDWriteTextAnalyzer_GetGlyphPlacements(analyzer, run->descr.string, run->clustermap, text_props,
+                run->descr.stringLength, run->glyphs, glyph_props, run->glyphcount, run->run.fontFace,
                 run->run.fontEmSize, run->run.isSideways, run->run.bidiLevel & 1, &run->sa, run->descr.localeName,
                 NULL, NULL, 0, run->advances, run->offsets);
 
@@ -1007,7 +1213,12 @@ static HRESULT layout_shape_run(struct dwrite_textlayout *layout, struct regular
         memset(run->offsets, 0, run->glyphcount * sizeof(*run->offsets));
         WARN("%s: failed to get glyph placement info, hr %#x.\n", debugstr_rundescr(&run->descr), hr);
     }
+    else
+        layout_cache_shaping(layout, &key, run);
 
+done:
+    run->run.glyphIndices = run->glyphs;
+    run->descr.clusterMap = run->clustermap;
     run->run.glyphAdvances = run->advances;
     run->run.glyphOffsets = run->offsets;
 
@@ -549,6 +549,8 @@ struct dwritefactory {
     struct list collection_loaders;
     struct list file_loaders;
 
+    struct shaping_cache shaping_cache;
+
     CRITICAL_SECTION cs;
 };
 
@@ -583,6 +585,7 @@ static void release_dwritefactory(struct dwritefactory *factory)
 
     EnterCriticalSection(&factory->cs);
     release_fontface_cache(&factory->localfontfaces);
+    release_shaping_cache(&factory->shaping_cache);
     LeaveCriticalSection(&factory->cs);
 
     LIST_FOR_EACH_ENTRY_SAFE(loader, loader2, &factory->collection_loaders, struct collectionloader, entry) {
@@ -842,6 +845,12 @@ void factory_unlock(IDWriteFactory5 *iface)
     LeaveCriticalSection(&factory->cs);
 }
 
+struct shaping_cache *factory_get_shaping_cache(IDWriteFactory5 *iface)
+{
+    struct dwritefactory *factory = impl_from_IDWriteFactory5(iface);
+    return &factory->shaping_cache;
+}
+
 HRESULT factory_get_cached_fontface(IDWriteFactory5 *iface, IDWriteFontFile * const *font_files, UINT32 index,
         DWRITE_FONT_SIMULATIONS simulations, struct list **cached_list, REFIID riid, void **obj)
 {
@@ -1794,6 +1803,8 @@ static void init_dwritefactory(struct dwritefactory *factory, DWRITE_FACTORY_TYP
     list_init(&factory->collection_loaders);
     list_init(&factory->file_loaders);
     list_init(&factory->localfontfaces);
+    list_init(&factory->shaping_cache.entries);
+    factory->shaping_cache.size = 0;
 
     InitializeCriticalSection(&factory->cs);
     factory->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": dwritefactory.lock");
@@ -5514,6 +5514,58 @@ static void test_GetOverhangMetrics(void)
     IDWriteFactory_Release(factory);
 }
 
+static void test_repeated_layouts(void)
+{
+    static const WCHAR strW[] = {'a','b','c',' ','d','e','f',0};
+    DWRITE_TEXT_METRICS metrics, metrics2;
+    DWRITE_CLUSTER_METRICS clusters[7], clusters2[7];
+    IDWriteTextFormat *format;
+    IDWriteTextLayout *layout;
+    DWRITE_TEXT_RANGE range;
+    IDWriteFactory *factory;
+    UINT32 count;
+    HRESULT hr;
+
+    factory = create_factory();
+
+    hr = IDWriteFactory_CreateTextFormat(factory, tahomaW, NULL, DWRITE_FONT_WEIGHT_NORMAL, DWRITE_FONT_STYLE_NORMAL,
+            DWRITE_FONT_STRETCH_NORMAL, 10.0f, enusW, &format);
+    ok(hr == S_OK, "Failed to create text format, hr %#x.\n", hr);
+
+    hr = IDWriteFactory_CreateTextLayout(factory, strW, 7, format, 1000.0f, 1000.0f, &layout);
+    ok(hr == S_OK, "Failed to create text layout, hr %#x.\n", hr);
+    hr = IDWriteTextLayout_GetMetrics(layout, &metrics);
+    ok(hr == S_OK, "Failed to get layout metrics, hr %#x.\n", hr);
+    hr = IDWriteTextLayout_GetClusterMetrics(layout, clusters, 7, &count);
+    ok(hr == S_OK, "Failed to get cluster metrics, hr %#x.\n", hr);
+    ok(count == 7, "Unexpected cluster count %u.\n", count);
+    IDWriteTextLayout_Release(layout);
+
+    /* identical layout gives identical results */
+    hr = IDWriteFactory_CreateTextLayout(factory, strW, 7, format, 1000.0f, 1000.0f, &layout);
+    ok(hr == S_OK, "Failed to create text layout, hr %#x.\n", hr);
+    hr = IDWriteTextLayout_GetMetrics(layout, &metrics2);
+    ok(hr == S_OK, "Failed to get layout metrics, hr %#x.\n", hr);
+    ok(!memcmp(&metrics, &metrics2, sizeof(metrics)), "Unexpected layout metrics.\n");
+    hr = IDWriteTextLayout_GetClusterMetrics(layout, clusters2, 7, &count);
+    ok(hr == S_OK, "Failed to get cluster metrics, hr %#x.\n", hr);
+    ok(count == 7, "Unexpected cluster count %u.\n", count);
+    ok(!memcmp(clusters, clusters2, sizeof(clusters)), "Unexpected cluster metrics.\n");
+
+    /* same text with a different size */
+    range.startPosition = 0;
+    range.length = 7;
+    hr = IDWriteTextLayout_SetFontSize(layout, 20.0f, range);
+    ok(hr == S_OK, "Failed to set font size, hr %#x.\n", hr);
+    hr = IDWriteTextLayout_GetClusterMetrics(layout, clusters2, 7, &count);
+    ok(hr == S_OK, "Failed to get cluster metrics, hr %#x.\n", hr);
+    ok(clusters2[0].width > clusters[0].width, "Unexpected cluster width %f.\n", clusters2[0].width);
+    IDWriteTextLayout_Release(layout);
+
+    IDWriteTextFormat_Release(format);
+    IDWriteFactory_Release(factory);
+}
+
 START_TEST(layout)
 {
     IDWriteFactory *factory;
@@ -5564,6 +5616,7 @@ START_TEST(layout)
     test_InvalidateLayout();
     test_line_spacing();
     test_GetOverhangMetrics();
+    test_repeated_layouts();
 
     IDWriteFactory_Release(factory);
 }
@@ -24,14 +24,14 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(dxgi);
 
-static inline struct dxgi_swapchain *impl_from_IDXGISwapChain1(IDXGISwapChain1 *iface)
+static inline struct dxgi_swapchain *impl_from_IDXGISwapChain2(IDXGISwapChain2 *iface)
 {
-    return CONTAINING_RECORD(iface, struct dxgi_swapchain, IDXGISwapChain1_iface);
+    return CONTAINING_RECORD(iface, struct dxgi_swapchain, IDXGISwapChain2_iface);
 }
 
 /* IUnknown methods */
 
-static HRESULT STDMETHODCALLTYPE dxgi_swapchain_QueryInterface(IDXGISwapChain1 *iface, REFIID riid, void **object)
+static HRESULT STDMETHODCALLTYPE dxgi_swapchain_QueryInterface(IDXGISwapChain2 *iface, REFIID riid, void **object)
 {
     TRACE("iface %p, riid %s, object %p\n", iface, debugstr_guid(riid), object);
 
@@ -39,7 +39,8 @@ static HRESULT STDMETHODCALLTYPE dxgi_swapchain_QueryInterface(IDXGISwapChain1 *
             || IsEqualGUID(riid, &IID_IDXGIObject)
             || IsEqualGUID(riid, &IID_IDXGIDeviceSubObject)
             || IsEqualGUID(riid, &IID_IDXGISwapChain)
-            || IsEqualGUID(riid, &IID_IDXGISwapChain1))
+            || IsEqualGUID(riid, &IID_IDXGISwapChain1)
+            || IsEqualGUID(riid, &IID_IDXGISwapChain2))
     {
         IUnknown_AddRef(iface);
         *object = iface;
@@ -52,9 +53,9 @@ static HRESULT STDMETHODCALLTYPE dxgi_swapchain_QueryInterface(IDXGISwapChain1 *
     return E_NOINTERFACE;
 }
 
-static ULONG STDMETHODCALLTYPE dxgi_swapchain_AddRef(IDXGISwapChain1 *iface)
+static ULONG STDMETHODCALLTYPE dxgi_swapchain_AddRef(IDXGISwapChain2 *iface)
 {
-    struct dxgi_swapchain *This = impl_from_IDXGISwapChain1(iface);
+    struct dxgi_swapchain *This = impl_from_IDXGISwapChain2(iface);
     ULONG refcount = InterlockedIncrement(&This->refcount);
 
     TRACE("%p increasing refcount to %u\n", This, refcount);
@@ -69,9 +70,9 @@ static ULONG STDMETHODCALLTYPE dxgi_swapchain_AddRef(IDXGISwapChain1 *iface)
     return refcount;
 }
 
-static ULONG STDMETHODCALLTYPE dxgi_swapchain_Release(IDXGISwapChain1 *iface)
+static ULONG STDMETHODCALLTYPE dxgi_swapchain_Release(IDXGISwapChain2 *iface)
 {
-    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain1(iface);
+    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain2(iface);
     ULONG refcount = InterlockedDecrement(&swapchain->refcount);
 
     TRACE("%p decreasing refcount to %u.\n", swapchain, refcount);
@@ -98,39 +99,39 @@ static ULONG STDMETHODCALLTYPE dxgi_swapchain_Release(IDXGISwapChain1 *iface)
 
 /* IDXGIObject methods */
 
-static HRESULT STDMETHODCALLTYPE dxgi_swapchain_SetPrivateData(IDXGISwapChain1 *iface,
+static HRESULT STDMETHODCALLTYPE dxgi_swapchain_SetPrivateData(IDXGISwapChain2 *iface,
         REFGUID guid, UINT data_size, const void *data)
 {
-    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain1(iface);
+    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain2(iface);
 
     TRACE("iface %p, guid %s, data_size %u, data %p.\n", iface, debugstr_guid(guid), data_size, data);
 
     return dxgi_set_private_data(&swapchain->private_store, guid, data_size, data);
 }
 
-static HRESULT STDMETHODCALLTYPE dxgi_swapchain_SetPrivateDataInterface(IDXGISwapChain1 *iface,
+static HRESULT STDMETHODCALLTYPE dxgi_swapchain_SetPrivateDataInterface(IDXGISwapChain2 *iface,
         REFGUID guid, const IUnknown *object)
 {
-    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain1(iface);
+    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain2(iface);
 
     TRACE("iface %p, guid %s, object %p.\n", iface, debugstr_guid(guid), object);
 
     return dxgi_set_private_data_interface(&swapchain->private_store, guid, object);
 }
 
-static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetPrivateData(IDXGISwapChain1 *iface,
+static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetPrivateData(IDXGISwapChain2 *iface,
         REFGUID guid, UINT *data_size, void *data)
 {
-    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain1(iface);
+    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain2(iface);
 
     TRACE("iface %p, guid %s, data_size %p, data %p.\n", iface, debugstr_guid(guid), data_size, data);
 
     return dxgi_get_private_data(&swapchain->private_store, guid, data_size, data);
 }
 
-static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetParent(IDXGISwapChain1 *iface, REFIID riid, void **parent)
+static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetParent(IDXGISwapChain2 *iface, REFIID riid, void **parent)
 {
-    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain1(iface);
+    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain2(iface);
 
     TRACE("iface %p, riid %s, parent %p.\n", iface, debugstr_guid(riid), parent);
 
@@ -146,9 +147,9 @@ static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetParent(IDXGISwapChain1 *iface
 
 /* IDXGIDeviceSubObject methods */
 
-static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetDevice(IDXGISwapChain1 *iface, REFIID riid, void **device)
+static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetDevice(IDXGISwapChain2 *iface, REFIID riid, void **device)
 {
-    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain1(iface);
+    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain2(iface);
 
     TRACE("iface %p, riid %s, device %p.\n", iface, debugstr_guid(riid), device);
 
@@ -164,19 +165,19 @@ static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetDevice(IDXGISwapChain1 *iface
 
 /* IDXGISwapChain1 methods */
 
-static HRESULT STDMETHODCALLTYPE dxgi_swapchain_Present(IDXGISwapChain1 *iface, UINT sync_interval, UINT flags)
+static HRESULT STDMETHODCALLTYPE dxgi_swapchain_Present(IDXGISwapChain2 *iface, UINT sync_interval, UINT flags)
 {
-    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain1(iface);
+    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain2(iface);
 
     TRACE("iface %p, sync_interval %u, flags %#x.\n", iface, sync_interval, flags);
 
-    return IDXGISwapChain1_Present1(&swapchain->IDXGISwapChain1_iface, sync_interval, flags, NULL);
+    return IDXGISwapChain2_Present1(&swapchain->IDXGISwapChain2_iface, sync_interval, flags, NULL);
 }
 
-static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetBuffer(IDXGISwapChain1 *iface,
+static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetBuffer(IDXGISwapChain2 *iface,
         UINT buffer_idx, REFIID riid, void **surface)
 {
-    struct dxgi_swapchain *This = impl_from_IDXGISwapChain1(iface);
+    struct dxgi_swapchain *This = impl_from_IDXGISwapChain2(iface);
     struct wined3d_texture *texture;
     IUnknown *parent;
     HRESULT hr;
@@ -199,10 +200,10 @@ static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetBuffer(IDXGISwapChain1 *iface
     return hr;
 }
 
-static HRESULT STDMETHODCALLTYPE DECLSPEC_HOTPATCH dxgi_swapchain_SetFullscreenState(IDXGISwapChain1 *iface,
+static HRESULT STDMETHODCALLTYPE DECLSPEC_HOTPATCH dxgi_swapchain_SetFullscreenState(IDXGISwapChain2 *iface,
         BOOL fullscreen, IDXGIOutput *target)
 {
-    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain1(iface);
+    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain2(iface);
     struct wined3d_swapchain_desc swapchain_desc;
     HRESULT hr;
 
@@ -220,7 +221,7 @@ static HRESULT STDMETHODCALLTYPE DECLSPEC_HOTPATCH dxgi_swapchain_SetFullscreenS
         {
             IDXGIOutput_AddRef(target);
         }
-        else if (FAILED(hr = IDXGISwapChain1_GetContainingOutput(iface, &target)))
+        else if (FAILED(hr = IDXGISwapChain2_GetContainingOutput(iface, &target)))
         {
             WARN("Failed to get default target output for swapchain, hr %#x.\n", hr);
             return hr;
@@ -248,10 +249,10 @@ static HRESULT STDMETHODCALLTYPE DECLSPEC_HOTPATCH dxgi_swapchain_SetFullscreenS
     return hr;
 }
 
-static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetFullscreenState(IDXGISwapChain1 *iface,
+static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetFullscreenState(IDXGISwapChain2 *iface,
         BOOL *fullscreen, IDXGIOutput **target)
 {
-    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain1(iface);
+    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain2(iface);
 
     TRACE("iface %p, fullscreen %p, target %p.\n", iface, fullscreen, target);
 
@@ -268,9 +269,9 @@ static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetFullscreenState(IDXGISwapChai
     return S_OK;
 }
 
-static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetDesc(IDXGISwapChain1 *iface, DXGI_SWAP_CHAIN_DESC *desc)
+static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetDesc(IDXGISwapChain2 *iface, DXGI_SWAP_CHAIN_DESC *desc)
 {
-    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain1(iface);
+    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain2(iface);
     struct wined3d_swapchain_desc wined3d_desc;
 
     TRACE("iface %p, desc %p.\n", iface, desc);
@@ -306,10 +307,10 @@ static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetDesc(IDXGISwapChain1 *iface,
     return S_OK;
 }
 
-static HRESULT STDMETHODCALLTYPE dxgi_swapchain_ResizeBuffers(IDXGISwapChain1 *iface,
+static HRESULT STDMETHODCALLTYPE dxgi_swapchain_ResizeBuffers(IDXGISwapChain2 *iface,
         UINT buffer_count, UINT width, UINT height, DXGI_FORMAT format, UINT flags)
 {
-    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain1(iface);
+    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain2(iface);
     struct wined3d_swapchain_desc wined3d_desc;
     struct wined3d_texture *texture;
     IUnknown *parent;
@@ -344,10 +345,10 @@ static HRESULT STDMETHODCALLTYPE dxgi_swapchain_ResizeBuffers(IDXGISwapChain1 *i
     return hr;
 }
 
-static HRESULT STDMETHODCALLTYPE dxgi_swapchain_ResizeTarget(IDXGISwapChain1 *iface,
+static HRESULT STDMETHODCALLTYPE dxgi_swapchain_ResizeTarget(IDXGISwapChain2 *iface,
         const DXGI_MODE_DESC *target_mode_desc)
 {
-    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain1(iface);
+    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain2(iface);
     struct wined3d_display_mode mode;
     HRESULT hr;
 
@@ -373,9 +374,9 @@ static HRESULT STDMETHODCALLTYPE dxgi_swapchain_ResizeTarget(IDXGISwapChain1 *if
     return hr;
 }
 
-static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetContainingOutput(IDXGISwapChain1 *iface, IDXGIOutput **output)
+static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetContainingOutput(IDXGISwapChain2 *iface, IDXGIOutput **output)
 {
-    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain1(iface);
+    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain2(iface);
     IDXGIAdapter *adapter;
     IDXGIDevice *device;
     HRESULT hr;
@@ -410,7 +411,7 @@ static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetContainingOutput(IDXGISwapCha
     return hr;
 }
 
-static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetFrameStatistics(IDXGISwapChain1 *iface,
+static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetFrameStatistics(IDXGISwapChain2 *iface,
         DXGI_FRAME_STATISTICS *stats)
 {
     FIXME("iface %p, stats %p stub!\n", iface, stats);
@@ -418,7 +419,7 @@ static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetFrameStatistics(IDXGISwapChai
     return E_NOTIMPL;
 }
 
-static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetLastPresentCount(IDXGISwapChain1 *iface,
+static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetLastPresentCount(IDXGISwapChain2 *iface,
         UINT *last_present_count)
 {
     FIXME("iface %p, last_present_count %p stub!\n", iface, last_present_count);
@@ -428,9 +429,9 @@ static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetLastPresentCount(IDXGISwapCha
 
 /* IDXGISwapChain1 methods */
 
-static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetDesc1(IDXGISwapChain1 *iface, DXGI_SWAP_CHAIN_DESC1 *desc)
+static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetDesc1(IDXGISwapChain2 *iface, DXGI_SWAP_CHAIN_DESC1 *desc)
 {
-    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain1(iface);
+    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain2(iface);
     struct wined3d_swapchain_desc wined3d_desc;
 
     TRACE("iface %p, desc %p.\n", iface, desc);
@@ -463,10 +464,10 @@ static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetDesc1(IDXGISwapChain1 *iface,
     return S_OK;
 }
 
-static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetFullscreenDesc(IDXGISwapChain1 *iface,
+static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetFullscreenDesc(IDXGISwapChain2 *iface,
         DXGI_SWAP_CHAIN_FULLSCREEN_DESC *desc)
 {
-    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain1(iface);
+    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain2(iface);
     struct wined3d_swapchain_desc wined3d_desc;
 
     TRACE("iface %p, desc %p.\n", iface, desc);
@@ -492,9 +493,9 @@ static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetFullscreenDesc(IDXGISwapChain
     return S_OK;
 }
 
-static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetHwnd(IDXGISwapChain1 *iface, HWND *hwnd)
+static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetHwnd(IDXGISwapChain2 *iface, HWND *hwnd)
 {
-    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain1(iface);
+    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain2(iface);
     struct wined3d_swapchain_desc wined3d_desc;
 
     TRACE("iface %p, hwnd %p.\n", iface, hwnd);
@@ -513,7 +514,7 @@ static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetHwnd(IDXGISwapChain1 *iface,
     return S_OK;
 }
 
-static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetCoreWindow(IDXGISwapChain1 *iface,
+static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetCoreWindow(IDXGISwapChain2 *iface,
         REFIID iid, void **core_window)
 {
     FIXME("iface %p, iid %s, core_window %p stub!\n", iface, debugstr_guid(iid), core_window);
@@ -524,10 +525,10 @@ static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetCoreWindow(IDXGISwapChain1 *i
     return DXGI_ERROR_INVALID_CALL;
 }
 
-static HRESULT STDMETHODCALLTYPE dxgi_swapchain_Present1(IDXGISwapChain1 *iface,
+static HRESULT STDMETHODCALLTYPE dxgi_swapchain_Present1(IDXGISwapChain2 *iface,
         UINT sync_interval, UINT flags, const DXGI_PRESENT_PARAMETERS *present_parameters)
 {
-    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain1(iface);
+    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain2(iface);
     HRESULT hr;
 
     TRACE("iface %p, sync_interval %u, flags %#x, present_parameters %p.\n",
@@ -557,14 +558,14 @@ static HRESULT STDMETHODCALLTYPE dxgi_swapchain_Present1(IDXGISwapChain1 *iface,
     return hr;
 }
 
-static BOOL STDMETHODCALLTYPE dxgi_swapchain_IsTemporaryMonoSupported(IDXGISwapChain1 *iface)
+static BOOL STDMETHODCALLTYPE dxgi_swapchain_IsTemporaryMonoSupported(IDXGISwapChain2 *iface)
 {
     FIXME("iface %p stub!\n", iface);
 
     return FALSE;
 }
 
-static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetRestrictToOutput(IDXGISwapChain1 *iface, IDXGIOutput **output)
+static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetRestrictToOutput(IDXGISwapChain2 *iface, IDXGIOutput **output)
 {
     FIXME("iface %p, output %p stub!\n", iface, output);
 
@@ -578,35 +579,137 @@ static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetRestrictToOutput(IDXGISwapCha
     return E_NOTIMPL;
 }
 
-static HRESULT STDMETHODCALLTYPE dxgi_swapchain_SetBackgroundColor(IDXGISwapChain1 *iface, const DXGI_RGBA *color)
+static HRESULT STDMETHODCALLTYPE dxgi_swapchain_SetBackgroundColor(IDXGISwapChain2 *iface, const DXGI_RGBA *color)
 {
     FIXME("iface %p, color %p stub!\n", iface, color);
 
     return E_NOTIMPL;
 }
 
-static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetBackgroundColor(IDXGISwapChain1 *iface, DXGI_RGBA *color)
+static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetBackgroundColor(IDXGISwapChain2 *iface, DXGI_RGBA *color)
 {
     FIXME("iface %p, color %p stub!\n", iface, color);
 
     return E_NOTIMPL;
 }
 
-static HRESULT STDMETHODCALLTYPE dxgi_swapchain_SetRotation(IDXGISwapChain1 *iface, DXGI_MODE_ROTATION rotation)
+static HRESULT STDMETHODCALLTYPE dxgi_swapchain_SetRotation(IDXGISwapChain2 *iface, DXGI_MODE_ROTATION rotation)
 {
     FIXME("iface %p, rotation %#x stub!\n", iface, rotation);
 
     return E_NOTIMPL;
 }
 
-static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetRotation(IDXGISwapChain1 *iface, DXGI_MODE_ROTATION *rotation)
+static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetRotation(IDXGISwapChain2 *iface, DXGI_MODE_ROTATION *rotation)
 {
     FIXME("iface %p, rotation %p stub!\n", iface, rotation);
 
     return E_NOTIMPL;
 }
 
-static const struct IDXGISwapChain1Vtbl dxgi_swapchain_vtbl =
+/* IDXGISwapChain2 methods */
+
+static HRESULT STDMETHODCALLTYPE dxgi_swapchain_SetSourceSize(IDXGISwapChain2 *iface, UINT width, UINT height)
+{
+    FIXME("iface %p, width %u, height %u stub!\n", iface, width, height);
+
+    return E_NOTIMPL;
+}
+
+static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetSourceSize(IDXGISwapChain2 *iface, UINT *width, UINT *height)
+{
+    FIXME("iface %p, width %p, height %p stub!\n", iface, width, height);
+
+    return E_NOTIMPL;
+}
+
+static HRESULT STDMETHODCALLTYPE dxgi_swapchain_SetMaximumFrameLatency(IDXGISwapChain2 *iface, UINT max_latency)
+{
+    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain2(iface);
+    HANDLE semaphore;
+
+    TRACE("iface %p, max_latency %u.\n", iface, max_latency);
+
+    if (!max_latency || max_latency > DXGI_FRAME_LATENCY_MAX)
+        return DXGI_ERROR_INVALID_CALL;
+
+    wined3d_mutex_lock();
+    if (!(semaphore = wined3d_swapchain_get_frame_latency_object(swapchain->wined3d_swapchain)))
+    {
+        wined3d_mutex_unlock();
+        WARN("Swapchain was not created with DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT.\n");
+        return DXGI_ERROR_INVALID_CALL;
+    }
+
+    /* The semaphore count tracks the number of frames the application may
+     * still queue; raising the limit hands out the difference right away. */
+    if (max_latency > swapchain->max_frame_latency)
+        ReleaseSemaphore(semaphore, max_latency - swapchain->max_frame_latency, NULL);
+    swapchain->max_frame_latency = max_latency;
+    wined3d_mutex_unlock();
+
+    return S_OK;
+}
+
+static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetMaximumFrameLatency(IDXGISwapChain2 *iface, UINT *max_latency)
+{
+    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain2(iface);
+
+    TRACE("iface %p, max_latency %p.\n", iface, max_latency);
+
+    if (!max_latency)
+        return DXGI_ERROR_INVALID_CALL;
+
+    wined3d_mutex_lock();
+    if (!wined3d_swapchain_get_frame_latency_object(swapchain->wined3d_swapchain))
+    {
+        wined3d_mutex_unlock();
+        WARN("Swapchain was not created with DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT.\n");
+        return DXGI_ERROR_INVALID_CALL;
+    }
+    *max_latency = swapchain->max_frame_latency;
+    wined3d_mutex_unlock();
+
+    return S_OK;
+}
+
+static HANDLE STDMETHODCALLTYPE dxgi_swapchain_GetFrameLatencyWaitableObject(IDXGISwapChain2 *iface)
+{
+    struct dxgi_swapchain *swapchain = impl_from_IDXGISwapChain2(iface);
+    HANDLE semaphore, dup = NULL;
+
+    TRACE("iface %p.\n", iface);
+
+    wined3d_mutex_lock();
+    if ((semaphore = wined3d_swapchain_get_frame_latency_object(swapchain->wined3d_swapchain))
+            && !DuplicateHandle(GetCurrentProcess(), semaphore, GetCurrentProcess(), &dup,
+            0, FALSE, DUPLICATE_SAME_ACCESS))
+    {
+        ERR("Failed to duplicate frame latency object, error %u.\n", GetLastError());
+        dup = NULL;
+    }
+    wined3d_mutex_unlock();
+
+    return dup;
+}
+
+static HRESULT STDMETHODCALLTYPE dxgi_swapchain_SetMatrixTransform(IDXGISwapChain2 *iface,
+        const DXGI_MATRIX_3X2_F *matrix)
+{
+    FIXME("iface %p, matrix %p stub!\n", iface, matrix);
+
+    return E_NOTIMPL;
+}
+
+static HRESULT STDMETHODCALLTYPE dxgi_swapchain_GetMatrixTransform(IDXGISwapChain2 *iface,
+        DXGI_MATRIX_3X2_F *matrix)
+{
+    FIXME("iface %p, matrix %p stub!\n", iface, matrix);
+
+    return E_NOTIMPL;
+}
+
+static const struct IDXGISwapChain2Vtbl dxgi_swapchain_vtbl =
 {
     /* IUnknown methods */
     dxgi_swapchain_QueryInterface,
@@ -642,6 +745,14 @@ static const struct IDXGISwapChain1Vtbl dxgi_swapchain_vtbl =
     dxgi_swapchain_GetBackgroundColor,
     dxgi_swapchain_SetRotation,
     dxgi_swapchain_GetRotation,
+    /* IDXGISwapChain2 methods */
+    dxgi_swapchain_SetSourceSize,
+    dxgi_swapchain_GetSourceSize,
+    dxgi_swapchain_SetMaximumFrameLatency,
+    dxgi_swapchain_GetMaximumFrameLatency,
+    dxgi_swapchain_GetFrameLatencyWaitableObject,
+    dxgi_swapchain_SetMatrixTransform,
+    dxgi_swapchain_GetMatrixTransform,
 };
 
 static void STDMETHODCALLTYPE dxgi_swapchain_wined3d_object_released(void *parent)
@@ -683,8 +794,9 @@ HRESULT dxgi_swapchain_init(struct dxgi_swapchain *swapchain, struct dxgi_device
         swapchain->factory = NULL;
     }
 
-    swapchain->IDXGISwapChain1_iface.lpVtbl = &dxgi_swapchain_vtbl;
+    swapchain->IDXGISwapChain2_iface.lpVtbl = &dxgi_swapchain_vtbl;
     swapchain->refcount = 1;
+    swapchain->max_frame_latency = 1;
     wined3d_mutex_lock();
     wined3d_private_store_init(&swapchain->private_store);
 
@@ -712,7 +824,7 @@ HRESULT dxgi_swapchain_init(struct dxgi_swapchain *swapchain, struct dxgi_device
             goto cleanup;
         }
 
-        if (FAILED(hr = IDXGISwapChain1_GetContainingOutput(&swapchain->IDXGISwapChain1_iface,
+        if (FAILED(hr = IDXGISwapChain2_GetContainingOutput(&swapchain->IDXGISwapChain2_iface,
                 &swapchain->target)))
         {
             WARN("Failed to get target output for fullscreen swapchain, hr %#x.\n", hr);
@@ -21,8 +21,10 @@
 #include <assert.h>
 
 #include "gdi_private.h"
+#include "winreg.h"
 #include "dibdrv.h"
 
+#include "wine/exception.h"
 #include "wine/debug.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(dib);
@@ -466,6 +468,178 @@ static int get_overlap( const dib_info *dst, const RECT *dst_rect,
     return ret;
 }
 
+/* Large rectangles can optionally be split in bands of rows that are processed
+ * in parallel in the thread pool. The band boundaries only depend on the size
+ * of the rectangle, and bands never overlap, so the result is the same as when
+ * processing the whole rectangle at once. */
+
+#define BAND_MIN_PIXELS (512 * 1024)  /* don't bother splitting smaller rectangles */
+#define BAND_MIN_ROWS   16
+#define BAND_MAX_COUNT  16
+
+struct band_params
+{
+    RECT   rect;                                   /* full rectangle */
+    int    count;                                  /* number of bands */
+    LONG   next;                                   /* next band to process */
+    LONG   refs;                                   /* number of threads using the structure */
+    HANDLE event;                                  /* signaled when the last thread is done */
+    void (*func)( const RECT *band, void *arg );   /* function processing a band */
+    void  *arg;                                    /* function argument */
+};
+
+static int max_bands = -1;
+
+static int get_max_bands(void)
+{
+    char buffer[16];
+    DWORD size = sizeof(buffer);
+    SYSTEM_INFO info;
+    HKEY hkey;
+    int bands = 1;
+
+    if (max_bands != -1) return max_bands;
+
+    /* HKCU\Software\Wine\GDI\ParallelBlits */
+    if (!RegOpenKeyA( HKEY_CURRENT_USER, "Software\\Wine\\GDI", &hkey ))
+    {
+        if (!RegQueryValueExA( hkey, "ParallelBlits", NULL, NULL, (BYTE *)buffer, &size ) &&
+            buffer[0] && strchr( "yYtT1", buffer[0] ))
+        {
+            GetSystemInfo( &info );
+            bands = min( info.dwNumberOfProcessors, BAND_MAX_COUNT );
+        }
+        RegCloseKey( hkey );
+    }
+    TRACE( "using up to %d bands\n", bands );
+    return max_bands = bands;
+}
+
+static void process_bands( struct band_params *params )
+{
+    int height = params->rect.bottom - params->rect.top;
+    RECT band = params->rect;
+    LONG i;
+
+    while ((i = InterlockedIncrement( &params->next ) - 1) < params->count)
+    {
+        band.top    = params->rect.top + MulDiv( i, height, params->count );
+        band.bottom = params->rect.top + MulDiv( i + 1, height, params->count );
+        params->func( &band, params->arg );
+    }
+    if (!InterlockedDecrement( &params->refs )) SetEvent( params->event );
+}
+
+static void CALLBACK band_callback( TP_CALLBACK_INSTANCE *instance, void *context )
+{
+    process_bands( context );
+}
+
+/* call func on the rectangle, splitting it in bands of rows if it's big enough */
+static void process_rect( const RECT *rc, void (*func)( const RECT *band, void *arg ), void *arg )
+{
+    int i, width = rc->right - rc->left, height = rc->bottom - rc->top;
+    struct band_params params;
+
+    params.count = min( get_max_bands(), height / BAND_MIN_ROWS );
+    if (params.count <= 1 || (LONGLONG)width * height < BAND_MIN_PIXELS ||
+        !(params.event = CreateEventW( NULL, TRUE, FALSE, NULL )))
+    {
+        func( rc, arg );
+        return;
+    }
+
+    params.rect = *rc;
+    params.next = 0;
+    params.refs = params.count;
+    params.func = func;
+    params.arg  = arg;
+
+    /* the current thread processes bands too */
+    for (i = 1; i < params.count; i++)
+        if (!TrySubmitThreadpoolCallback( band_callback, &params, NULL )) InterlockedDecrement( &params.refs );
+    process_bands( &params );
+
+    WaitForSingleObject( params.event, INFINITE );
+    CloseHandle( params.event );
+}
+
+struct copy_rect_args
+{
+    const dib_info *dst;
+    const RECT     *rc;
+    const dib_info *src;
+    const POINT    *origin;
+    int             rop2;
+};
+
+static void copy_rect_band( const RECT *band, void *arg )
+{
+    const struct copy_rect_args *args = arg;
+    POINT origin = *args->origin;
+
+    origin.y += band->top - args->rc->top;
+    args->dst->funcs->copy_rect( args->dst, band, args->src, &origin, args->rop2, 0 );
+}
+
+struct blend_rect_args
+{
+    const dib_info *dst;
+    const RECT     *rc;
+    const dib_info *src;
+    const POINT    *origin;
+    BLENDFUNCTION   blend;
+};
+
+static void blend_rect_band( const RECT *band, void *arg )
+{
+    const struct blend_rect_args *args = arg;
+    POINT origin = *args->origin;
+
+    origin.y += band->top - args->rc->top;
+    args->dst->funcs->blend_rect( args->dst, band, args->src, &origin, args->blend );
+}
+
+struct convert_args
+{
+    dib_info       *dst;
+    const dib_info *src;
+    const RECT     *src_rect;
+    LONG            failed;
+};
+
+static void convert_band( const RECT *band, void *arg )
+{
+    struct convert_args *args = arg;
+    dib_info dst = *args->dst;
+
+    /* the destination is stored at 0,0 */
+    dst.rect.top += band->top - args->src_rect->top;
+    dst.height = band->bottom - band->top;
+    __TRY
+    {
+        dst.funcs->convert_to( &dst, args->src, band, FALSE );
+    }
+    __EXCEPT_PAGE_FAULT
+    {
+        InterlockedExchange( &args->failed, TRUE );
+    }
+    __ENDTRY
+}
+
+/* convert the source rectangle to the destination format, return FALSE on invalid source bits */
+BOOL convert_dib_rect( dib_info *dst, const dib_info *src, const RECT *src_rect )
+{
+    struct convert_args args;
+
+    args.dst = dst;
+    args.src = src;
+    args.src_rect = src_rect;
+    args.failed = FALSE;
+    process_rect( src_rect, convert_band, &args );
+    return !args.failed;
+}
+
 static void copy_rect( dib_info *dst, const RECT *dst_rect, const dib_info *src, const RECT *src_rect,
                         const struct clipped_rects *clipped_rects, INT rop2 )
 {
@@ -541,6 +715,18 @@ static void copy_rect( dib_info *dst, const RECT *dst_rect, const dib_info *src,
             }
         }
     }
+    else if (!overlap)  /* the order doesn't matter, rectangles can be split */
+    {
+        struct copy_rect_args args = { dst, NULL, src, &origin, rop2 };
+
+        for (i = 0; i < count; i++)
+        {
+            origin.x = src_rect->left + rects[i].left - dst_rect->left;
+            origin.y = src_rect->top  + rects[i].top  - dst_rect->top;
+            args.rc = &rects[i];
+            process_rect( &rects[i], copy_rect_band, &args );
+        }
+    }
     else  /* left to right, top to bottom */
     {
         for (i = 0; i < count; i++)
@@ -586,6 +772,7 @@ static DWORD blend_rect( dib_info *dst, const RECT *dst_rect, const dib_info *sr
 {
     POINT origin;
     struct clipped_rects clipped_rects;
+    struct blend_rect_args args = { dst, NULL, src, &origin, blend };
     int i;
 
     if (!get_clipped_rects( dst, dst_rect, clip, &clipped_rects )) return ERROR_SUCCESS;
@@ -593,7 +780,11 @@ static DWORD blend_rect( dib_info *dst, const RECT *dst_rect, const dib_info *sr
     {
         origin.x = src_rect->left + clipped_rects.rects[i].left - dst_rect->left;
         origin.y = src_rect->top  + clipped_rects.rects[i].top  - dst_rect->top;
-        dst->funcs->blend_rect( dst, &clipped_rects.rects[i], src, &origin, blend );
+        args.rc = &clipped_rects.rects[i];
+        if (dst->bits.ptr == src->bits.ptr)  /* overlapping blends must be done in order */
+            dst->funcs->blend_rect( dst, args.rc, src, &origin, blend );
+        else
+            process_rect( args.rc, blend_rect_band, &args );
     }
     free_clipped_rects( &clipped_rects );
     return ERROR_SUCCESS;
@@ -1217,6 +1408,10 @@ DWORD stretch_bitmapinfo( const BITMAPINFO *src_info, void *src_bits, struct bit
     init_dib_info_from_bitmapinfo( &src_dib, src_info, src_bits );
     init_dib_info_from_bitmapinfo( &dst_dib, dst_info, dst_bits );
 
+    if (mode == STRETCH_HALFTONE && src_dib.funcs == dst_dib.funcs &&
+        dst_dib.funcs->halftone_rect( &dst_dib, dst, &src_dib, src ))
+        goto done;
+
     /* v */
     ret = calc_1d_stretch_params( dst->y, dst->height, dst->visrect.top, dst->visrect.bottom,
                                   src->y, src->height, src->visrect.top, src->visrect.bottom,
@@ -1301,6 +1496,7 @@ DWORD stretch_bitmapinfo( const BITMAPINFO *src_info, void *src_bits, struct bit
         }
     }
 
+done:
     /* update coordinates, the destination rectangle is always stored at 0,0 */
     *src = *dst;
     src->x -= src->visrect.left;
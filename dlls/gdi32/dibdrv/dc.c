@@ -23,7 +23,6 @@
 #include "gdi_private.h"
 #include "dibdrv.h"
 
-#include "wine/exception.h"
 #include "wine/debug.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(dib);
@@ -214,24 +213,15 @@ DWORD convert_bitmapinfo( const BITMAPINFO *src_info, void *src_bits, struct bit
                           const BITMAPINFO *dst_info, void *dst_bits )
 {
     dib_info src_dib, dst_dib;
-    DWORD ret;
 
     init_dib_info_from_bitmapinfo( &src_dib, src_info, src_bits );
     init_dib_info_from_bitmapinfo( &dst_dib, dst_info, dst_bits );
 
-    __TRY
-    {
-        dst_dib.funcs->convert_to( &dst_dib, &src_dib, &src->visrect, FALSE );
-        ret = TRUE;
-    }
-    __EXCEPT_PAGE_FAULT
+    if (!convert_dib_rect( &dst_dib, &src_dib, &src->visrect ))
     {
         WARN( "invalid bits pointer %p\n", src_bits );
-        ret = FALSE;
+        return ERROR_BAD_FORMAT;
     }
-    __ENDTRY
-
-    if(!ret) return ERROR_BAD_FORMAT;
 
     /* update coordinates, the destination rectangle is always stored at 0,0 */
     src->x -= src->visrect.left;
@@ -4593,44 +4593,40 @@ static inline BYTE blend_color(BYTE dst, BYTE src, DWORD alpha)
     return (src * alpha + dst * (255 - alpha) + 127) / 255;
 }
 
+/* divide two 16-bit values packed in the low bytes of each word by 255, rounding down;
+ * this matches the plain division as long as each value is below 65535 */
+static inline DWORD div255_pairs( DWORD val )
+{
+    return ((val + 0x00010001 + ((val >> 8) & 0x00ff00ff)) >> 8) & 0x00ff00ff;
+}
+
+/* the helpers below blend two channels at a time (blue and red, then green and alpha),
+ * with the exact same rounding as blend_color() */
 static inline DWORD blend_argb_constant_alpha( DWORD dst, DWORD src, DWORD alpha )
 {
-    return (blend_color( dst, src, alpha ) |
-            blend_color( dst >> 8, src >> 8, alpha ) << 8 |
-            blend_color( dst >> 16, src >> 16, alpha ) << 16 |
-            blend_color( dst >> 24, src >> 24, alpha ) << 24);
+    DWORD rb = (src & 0x00ff00ff) * alpha + (dst & 0x00ff00ff) * (255 - alpha) + 0x007f007f;
+    DWORD ag = ((src >> 8) & 0x00ff00ff) * alpha + ((dst >> 8) & 0x00ff00ff) * (255 - alpha) + 0x007f007f;
+    return div255_pairs( rb ) | div255_pairs( ag ) << 8;
 }
 
 static inline DWORD blend_argb_no_src_alpha( DWORD dst, DWORD src, DWORD alpha )
 {
-    return (blend_color( dst, src, alpha ) |
-            blend_color( dst >> 8, src >> 8, alpha ) << 8 |
-            blend_color( dst >> 16, src >> 16, alpha ) << 16 |
-            blend_color( dst >> 24, 255, alpha ) << 24);
+    return blend_argb_constant_alpha( dst, src | 0xff000000, alpha );
 }
 
 static inline DWORD blend_argb( DWORD dst, DWORD src )
 {
-    BYTE b = (BYTE)src;
-    BYTE g = (BYTE)(src >> 8);
-    BYTE r = (BYTE)(src >> 16);
-    DWORD alpha  = (BYTE)(src >> 24);
-    return ((b     + ((BYTE)dst         * (255 - alpha) + 127) / 255) |
-            (g     + ((BYTE)(dst >> 8)  * (255 - alpha) + 127) / 255) << 8 |
-            (r     + ((BYTE)(dst >> 16) * (255 - alpha) + 127) / 255) << 16 |
-            (alpha + ((BYTE)(dst >> 24) * (255 - alpha) + 127) / 255) << 24);
+    DWORD alpha = 255 - (src >> 24);
+    DWORD rb = div255_pairs( (dst & 0x00ff00ff) * alpha + 0x007f007f ) + (src & 0x00ff00ff);
+    DWORD ag = div255_pairs( ((dst >> 8) & 0x00ff00ff) * alpha + 0x007f007f ) + ((src >> 8) & 0x00ff00ff);
+    return rb | ag << 8;
 }
 
 static inline DWORD blend_argb_alpha( DWORD dst, DWORD src, DWORD alpha )
 {
-    BYTE b = ((BYTE)src         * alpha + 127) / 255;
-    BYTE g = ((BYTE)(src >> 8)  * alpha + 127) / 255;
-    BYTE r = ((BYTE)(src >> 16) * alpha + 127) / 255;
-    alpha  = ((BYTE)(src >> 24) * alpha + 127) / 255;
-    return ((b     + ((BYTE)dst         * (255 - alpha) + 127) / 255) |
-            (g     + ((BYTE)(dst >> 8)  * (255 - alpha) + 127) / 255) << 8 |
-            (r     + ((BYTE)(dst >> 16) * (255 - alpha) + 127) / 255) << 16 |
-            (alpha + ((BYTE)(dst >> 24) * (255 - alpha) + 127) / 255) << 24);
+    DWORD rb = div255_pairs( (src & 0x00ff00ff) * alpha + 0x007f007f );
+    DWORD ag = div255_pairs( ((src >> 8) & 0x00ff00ff) * alpha + 0x007f007f );
+    return blend_argb( dst, rb | ag << 8 );
 }
 
 static inline DWORD blend_rgb( BYTE dst_r, BYTE dst_g, BYTE dst_b, DWORD src, BLENDFUNCTION blend )
@@ -7342,6 +7338,170 @@ static void shrink_row_null(const dib_info *dst_dib, const POINT *dst_start,
     return;
 }
 
+#define HALFTONE_WEIGHT_BITS 14
+#define HALFTONE_WEIGHT_ONE  (1 << HALFTONE_WEIGHT_BITS)
+
+/* source pixels contributing to a given destination column or row */
+struct halftone_tap
+{
+    int  first;    /* first source coordinate */
+    int  count;    /* number of consecutive source pixels */
+    int *weights;  /* weight of each source pixel, they add up to HALFTONE_WEIGHT_ONE */
+};
+
+/* add the weight of a source pixel to a tap, clipping it to the visible source area */
+static inline void add_halftone_weight( struct halftone_tap *tap, int pos, int weight, int start, int end )
+{
+    if (pos < start) pos = start;
+    if (pos >= end) pos = end - 1;
+    if (!tap->count) tap->first = pos;
+    if (pos - tap->first == tap->count) tap->weights[tap->count++] = 0;
+    tap->weights[pos - tap->first] += weight;
+}
+
+/* compute the taps along one axis, using a box filter when shrinking and a bilinear one otherwise */
+static struct halftone_tap *get_halftone_taps( int dst_pos, int dst_len, int vis_start, int vis_end,
+                                               int src_pos, int src_len, int src_start, int src_end )
+{
+    int i, count = vis_end - vis_start;
+    int max_taps = src_len > dst_len ? (src_len + dst_len - 1) / dst_len + 1 : 2;
+    struct halftone_tap *taps;
+    int *weights;
+
+    if (!(taps = HeapAlloc( GetProcessHeap(), 0, count * (sizeof(*taps) + max_taps * sizeof(int) ))))
+        return NULL;
+    weights = (int *)(taps + count);
+
+    for (i = 0; i < count; i++)
+    {
+        struct halftone_tap *tap = &taps[i];
+        LONGLONG pos = vis_start + i - dst_pos;
+
+        tap->count = 0;
+        tap->weights = weights + i * max_taps;
+
+        if (src_len > dst_len)
+        {
+            /* source interval covered by the destination pixel, in 1 / dst_len units */
+            LONGLONG start = pos * src_len, end = start + src_len, cur = start, next;
+            int s = start / dst_len, prev_weight = 0, weight;
+
+            for ( ; cur < end; s++, cur = next)
+            {
+                next = min( end, (LONGLONG)(s + 1) * dst_len );
+                weight = (next - start) * HALFTONE_WEIGHT_ONE / src_len;
+                add_halftone_weight( tap, src_pos + s, weight - prev_weight, src_start, src_end );
+                prev_weight = weight;
+            }
+        }
+        else
+        {
+            /* center of the destination pixel, in source pixels scaled by 2 * dst_len */
+            LONGLONG num = (2 * pos + 1) * src_len - dst_len, den = 2 * dst_len;
+            int s = num < 0 ? -1 : num / den;
+            int weight = (num - s * den) * HALFTONE_WEIGHT_ONE / den;
+
+            add_halftone_weight( tap, src_pos + s, HALFTONE_WEIGHT_ONE - weight, src_start, src_end );
+            add_halftone_weight( tap, src_pos + s + 1, weight, src_start, src_end );
+        }
+    }
+    return taps;
+}
+
+/* filter an image whose channels are each stored in a full byte, in two separable passes */
+static BOOL halftone_rect_bytes( const dib_info *dst_dib, const struct bitblt_coords *dst,
+                                 const dib_info *src_dib, const struct bitblt_coords *src, int bpp )
+{
+    int width = dst->visrect.right - dst->visrect.left, height = dst->visrect.bottom - dst->visrect.top;
+    struct halftone_tap *h_taps = NULL, *v_taps = NULL;
+    int x, y, c, i, src_left, src_width, *row = NULL;
+    BOOL ret = FALSE;
+
+    if (src->width <= 0 || src->height <= 0 || dst->width <= 0 || dst->height <= 0) return FALSE;
+    if (dst->visrect.left < dst->x || dst->visrect.right > dst->x + dst->width) return FALSE;
+    if (dst->visrect.top < dst->y || dst->visrect.bottom > dst->y + dst->height) return FALSE;
+    if (is_rect_empty( &src->visrect ) || !width || !height) return FALSE;
+
+    if (!(h_taps = get_halftone_taps( dst->x, dst->width, dst->visrect.left, dst->visrect.right,
+                                      src->x, src->width, src->visrect.left, src->visrect.right )))
+        goto done;
+    if (!(v_taps = get_halftone_taps( dst->y, dst->height, dst->visrect.top, dst->visrect.bottom,
+                                      src->y, src->height, src->visrect.top, src->visrect.bottom )))
+        goto done;
+
+    src_left = h_taps[0].first;
+    src_width = h_taps[width - 1].first + h_taps[width - 1].count - src_left;
+    if (!(row = HeapAlloc( GetProcessHeap(), 0, src_width * bpp * sizeof(*row) ))) goto done;
+
+    for (y = 0; y < height; y++)
+    {
+        const struct halftone_tap *tap = &v_taps[y];
+        BYTE *dst_ptr = (BYTE *)dst_dib->bits.ptr + (dst_dib->rect.top + y) * dst_dib->stride +
+                        dst_dib->rect.left * bpp;
+
+        memset( row, 0, src_width * bpp * sizeof(*row) );
+        for (i = 0; i < tap->count; i++)
+        {
+            const BYTE *src_ptr = (const BYTE *)src_dib->bits.ptr +
+                                  (src_dib->rect.top + tap->first + i) * src_dib->stride +
+                                  (src_dib->rect.left + src_left) * bpp;
+            int weight = tap->weights[i];
+
+            for (x = 0; x < src_width * bpp; x++) row[x] += src_ptr[x] * weight;
+        }
+        /* keep 8 bits of fraction so that the horizontal pass can't overflow */
+        for (x = 0; x < src_width * bpp; x++) row[x] = (row[x] + (1 << 5)) >> 6;
+
+        for (x = 0; x < width; x++)
+        {
+            const int *ptr = row + (h_taps[x].first - src_left) * bpp;
+
+            for (c = 0; c < bpp; c++)
+            {
+                int val = 0;
+
+                for (i = 0; i < h_taps[x].count; i++) val += ptr[i * bpp + c] * h_taps[x].weights[i];
+                dst_ptr[x * bpp + c] = (val + (1 << 21)) >> 22;
+            }
+        }
+    }
+    ret = TRUE;
+
+done:
+    HeapFree( GetProcessHeap(), 0, row );
+    HeapFree( GetProcessHeap(), 0, v_taps );
+    HeapFree( GetProcessHeap(), 0, h_taps );
+    return ret;
+}
+
+static BOOL halftone_rect_8888( const dib_info *dst_dib, const struct bitblt_coords *dst,
+                                const dib_info *src_dib, const struct bitblt_coords *src )
+{
+    return halftone_rect_bytes( dst_dib, dst, src_dib, src, 4 );
+}
+
+static BOOL halftone_rect_32( const dib_info *dst_dib, const struct bitblt_coords *dst,
+                              const dib_info *src_dib, const struct bitblt_coords *src )
+{
+    if (dst_dib->red_len != 8 || dst_dib->green_len != 8 || dst_dib->blue_len != 8) return FALSE;
+    if ((dst_dib->red_shift | dst_dib->green_shift | dst_dib->blue_shift) & 7) return FALSE;
+    if (src_dib->red_mask != dst_dib->red_mask || src_dib->green_mask != dst_dib->green_mask ||
+        src_dib->blue_mask != dst_dib->blue_mask) return FALSE;
+    return halftone_rect_bytes( dst_dib, dst, src_dib, src, 4 );
+}
+
+static BOOL halftone_rect_24( const dib_info *dst_dib, const struct bitblt_coords *dst,
+                              const dib_info *src_dib, const struct bitblt_coords *src )
+{
+    return halftone_rect_bytes( dst_dib, dst, src_dib, src, 3 );
+}
+
+static BOOL halftone_rect_null( const dib_info *dst_dib, const struct bitblt_coords *dst,
+                                const dib_info *src_dib, const struct bitblt_coords *src )
+{
+    return FALSE;
+}
+
 const primitive_funcs funcs_8888 =
 {
     solid_rects_32,
@@ -7360,7 +7520,8 @@ const primitive_funcs funcs_8888 =
     create_rop_masks_32,
     create_dither_masks_null,
     stretch_row_32,
-    shrink_row_32
+    shrink_row_32,
+    halftone_rect_8888
 };
 
 const primitive_funcs funcs_32 =
@@ -7381,7 +7542,8 @@ const primitive_funcs funcs_32 =
     create_rop_masks_32,
     create_dither_masks_null,
     stretch_row_32,
-    shrink_row_32
+    shrink_row_32,
+    halftone_rect_32
 };
 
 const primitive_funcs funcs_24 =
@@ -7402,7 +7564,8 @@ const primitive_funcs funcs_24 =
     create_rop_masks_24,
     create_dither_masks_null,
     stretch_row_24,
-    shrink_row_24
+    shrink_row_24,
+    halftone_rect_24
 };
 
 const primitive_funcs funcs_555 =
@@ -7423,7 +7586,8 @@ const primitive_funcs funcs_555 =
     create_rop_masks_16,
     create_dither_masks_null,
     stretch_row_16,
-    shrink_row_16
+    shrink_row_16,
+    halftone_rect_null
 };
 
 const primitive_funcs funcs_16 =
@@ -7444,7 +7608,8 @@ const primitive_funcs funcs_16 =
     create_rop_masks_16,
     create_dither_masks_null,
     stretch_row_16,
-    shrink_row_16
+    shrink_row_16,
+    halftone_rect_null
 };
 
 const primitive_funcs funcs_8 =
@@ -7465,7 +7630,8 @@ const primitive_funcs funcs_8 =
     create_rop_masks_8,
     create_dither_masks_8,
     stretch_row_8,
-    shrink_row_8
+    shrink_row_8,
+    halftone_rect_null
 };
 
 const primitive_funcs funcs_4 =
@@ -7486,7 +7652,8 @@ const primitive_funcs funcs_4 =
     create_rop_masks_4,
     create_dither_masks_4,
     stretch_row_4,
-    shrink_row_4
+    shrink_row_4,
+    halftone_rect_null
 };
 
 const primitive_funcs funcs_1 =
@@ -7507,7 +7674,8 @@ const primitive_funcs funcs_1 =
     create_rop_masks_1,
     create_dither_masks_1,
     stretch_row_1,
-    shrink_row_1
+    shrink_row_1,
+    halftone_rect_null
 };
 
 const primitive_funcs funcs_null =
@@ -7528,5 +7696,6 @@ const primitive_funcs funcs_null =
     create_rop_masks_null,
     create_dither_masks_null,
     stretch_row_null,
-    shrink_row_null
+    shrink_row_null,
+    halftone_rect_null
 };
@@ -580,6 +580,8 @@ static const WCHAR face_internal_leading_value[] = {'I','n','t','e','r','n','a',
 static const WCHAR face_font_sig_value[] = {'F','o','n','t',' ','S','i','g','n','a','t','u','r','e',0};
 static const WCHAR face_file_name_value[] = {'F','i','l','e',' ','N','a','m','e','\0'};
 static const WCHAR face_full_name_value[] = {'F','u','l','l',' ','N','a','m','e','\0'};
+static const WCHAR font_cache_data_value[] = {'D','a','t','a',0};
+static const WCHAR font_snapshot_value[] = {'C','a','c','h','e',' ','S','n','a','p','s','h','o','t',0};
 
 
 struct font_mapping
@@ -1734,6 +1736,219 @@ static void reorder_vertical_fonts(void)
     list_move_tail( &font_list, &vertical_families );
 }
 
+/* The whole font list is also stored in a single binary value of the cache key,
+ * so that it can be loaded without enumerating every single key. The value is
+ * deleted whenever the cache keys are modified. All the fields are stored as
+ * DWORDs so that the format doesn't depend on the architecture. */
+
+#define FONT_CACHE_DATA_VERSION 1
+
+struct font_cache_data
+{
+    BYTE       *ptr;   /* current position, NULL when only computing the size */
+    const BYTE *end;   /* end of the data when reading */
+    DWORD       size;  /* size of the data written so far */
+};
+
+static void put_cache_dword( struct font_cache_data *data, DWORD val )
+{
+    if (data->ptr)
+    {
+        memcpy( data->ptr, &val, sizeof(val) );
+        data->ptr += sizeof(val);
+    }
+    data->size += sizeof(val);
+}
+
+static void put_cache_string( struct font_cache_data *data, const WCHAR *str )
+{
+    DWORD len = str ? strlenW( str ) + 1 : 0;
+
+    put_cache_dword( data, len );
+    if (data->ptr)
+    {
+        memcpy( data->ptr, str, len * sizeof(WCHAR) );
+        data->ptr += len * sizeof(WCHAR);
+    }
+    data->size += len * sizeof(WCHAR);
+}
+
+static BOOL get_cache_dword( struct font_cache_data *data, DWORD *val )
+{
+    if (data->end - data->ptr < sizeof(*val)) return FALSE;
+    memcpy( val, data->ptr, sizeof(*val) );
+    data->ptr += sizeof(*val);
+    return TRUE;
+}
+
+/* read a string, or only skip it if str is NULL */
+static BOOL get_cache_string( struct font_cache_data *data, WCHAR **str, BOOL required )
+{
+    DWORD len;
+
+    if (str) *str = NULL;
+    if (!get_cache_dword( data, &len )) return FALSE;
+    if (!len) return !required;
+    if ((data->end - data->ptr) / sizeof(WCHAR) < len) return FALSE;
+    if (str)
+    {
+        if (!(*str = HeapAlloc( GetProcessHeap(), 0, len * sizeof(WCHAR) ))) return FALSE;
+        memcpy( *str, data->ptr, len * sizeof(WCHAR) );
+        (*str)[len - 1] = 0;
+    }
+    data->ptr += len * sizeof(WCHAR);
+    return TRUE;
+}
+
+static void put_font_list_data( struct font_cache_data *data )
+{
+    Family *family;
+    Face *face;
+    int i;
+
+    put_cache_dword( data, FONT_CACHE_DATA_VERSION );
+    put_cache_dword( data, list_count( &font_list ));
+    LIST_FOR_EACH_ENTRY( family, &font_list, Family, entry )
+    {
+        put_cache_string( data, family->FamilyName );
+        put_cache_string( data, family->EnglishName );
+        put_cache_dword( data, list_count( &family->faces ));
+        LIST_FOR_EACH_ENTRY( face, &family->faces, Face, entry )
+        {
+            put_cache_string( data, face->StyleName );
+            put_cache_string( data, face->FullName );
+            put_cache_string( data, face->file );
+            put_cache_dword( data, face->face_index );
+            put_cache_dword( data, face->ntmFlags );
+            put_cache_dword( data, face->font_version );
+            put_cache_dword( data, face->flags );
+            for (i = 0; i < 4; i++) put_cache_dword( data, face->fs.fsUsb[i] );
+            for (i = 0; i < 2; i++) put_cache_dword( data, face->fs.fsCsb[i] );
+            put_cache_dword( data, face->scalable );
+            put_cache_dword( data, face->size.height );
+            put_cache_dword( data, face->size.width );
+            put_cache_dword( data, face->size.size );
+            put_cache_dword( data, face->size.x_ppem );
+            put_cache_dword( data, face->size.y_ppem );
+            put_cache_dword( data, face->size.internal_leading );
+        }
+    }
+}
+
+static void save_font_list_data( HKEY hkey_font_cache )
+{
+    struct font_cache_data data = { NULL, NULL, 0 };
+    BYTE *buffer;
+
+    put_font_list_data( &data );
+    if (!(buffer = HeapAlloc( GetProcessHeap(), 0, data.size ))) return;
+    data.ptr = buffer;
+    data.size = 0;
+    put_font_list_data( &data );
+    RegSetValueExW( hkey_font_cache, font_cache_data_value, 0, REG_BINARY, buffer, data.size );
+    HeapFree( GetProcessHeap(), 0, buffer );
+}
+
+/* parse the font list data; first called with create set to FALSE to validate it */
+static BOOL parse_font_list_data( struct font_cache_data *data, BOOL create )
+{
+    DWORD i, j, k, version, family_count, face_count, val[17];
+    WCHAR *family_name = NULL, *english_family = NULL;
+    Family *family = NULL;
+    Face *face;
+
+    if (!get_cache_dword( data, &version ) || version != FONT_CACHE_DATA_VERSION) return FALSE;
+    if (!get_cache_dword( data, &family_count )) return FALSE;
+
+    for (i = 0; i < family_count; i++)
+    {
+        if (!get_cache_string( data, create ? &family_name : NULL, TRUE )) return FALSE;
+        if (!get_cache_string( data, create ? &english_family : NULL, FALSE )) return FALSE;
+        if (!get_cache_dword( data, &face_count )) return FALSE;
+
+        if (create)
+        {
+            family = create_family( family_name, english_family );
+            if (english_family)
+            {
+                FontSubst *subst = HeapAlloc( GetProcessHeap(), 0, sizeof(*subst) );
+                subst->from.name = strdupW( english_family );
+                subst->from.charset = -1;
+                subst->to.name = strdupW( family_name );
+                subst->to.charset = -1;
+                add_font_subst( &font_subst_list, subst, 0 );
+            }
+        }
+
+        for (j = 0; j < face_count; j++)
+        {
+            if (!create)
+            {
+                if (!get_cache_string( data, NULL, TRUE ) || !get_cache_string( data, NULL, FALSE ) ||
+                    !get_cache_string( data, NULL, TRUE ))
+                    return FALSE;
+                for (k = 0; k < ARRAY_SIZE(val); k++) if (!get_cache_dword( data, &val[k] )) return FALSE;
+                continue;
+            }
+
+            face = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*face) );
+            get_cache_string( data, &face->StyleName, TRUE );
+            get_cache_string( data, &face->FullName, FALSE );
+            get_cache_string( data, &face->file, TRUE );
+            for (k = 0; k < ARRAY_SIZE(val); k++) get_cache_dword( data, &val[k] );
+
+            face->refcount              = 1;
+            face->face_index            = val[0];
+            face->ntmFlags              = val[1];
+            face->font_version          = val[2];
+            face->flags                 = val[3];
+            for (k = 0; k < 4; k++) face->fs.fsUsb[k] = val[4 + k];
+            for (k = 0; k < 2; k++) face->fs.fsCsb[k] = val[8 + k];
+            face->scalable              = val[10];
+            face->size.height           = val[11];
+            face->size.width            = val[12];
+            face->size.size             = val[13];
+            face->size.x_ppem           = val[14];
+            face->size.y_ppem           = val[15];
+            face->size.internal_leading = val[16];
+
+            /* the faces are stored in their final order, no need to sort them again */
+            list_add_tail( &family->faces, &face->entry );
+            face->family = family;
+            family->refcount++;
+            TRACE( "Added font %s %s\n", debugstr_w(family->FamilyName), debugstr_w(face->StyleName) );
+        }
+        if (create) release_family( family );
+    }
+    return TRUE;
+}
+
+static BOOL load_font_list_data( HKEY hkey_font_cache )
+{
+    struct font_cache_data data;
+    DWORD type, size;
+    BYTE *buffer;
+    BOOL ret = FALSE;
+
+    if (RegQueryValueExW( hkey_font_cache, font_cache_data_value, NULL, &type, NULL, &size ) ||
+        type != REG_BINARY)
+        return FALSE;
+    if (!(buffer = HeapAlloc( GetProcessHeap(), 0, size ))) return FALSE;
+    if (!RegQueryValueExW( hkey_font_cache, font_cache_data_value, NULL, NULL, buffer, &size ))
+    {
+        data.ptr = buffer;
+        data.end = buffer + size;
+        if ((ret = parse_font_list_data( &data, FALSE )))
+        {
+            data.ptr = buffer;
+            parse_font_list_data( &data, TRUE );
+        }
+        else WARN( "invalid font cache data, ignoring it\n" );
+    }
+    HeapFree( GetProcessHeap(), 0, buffer );
+    return ret;
+}
+
 static void load_font_list_from_cache(HKEY hkey_font_cache)
 {
     DWORD size, family_index = 0;
@@ -1741,6 +1956,8 @@ static void load_font_list_from_cache(HKEY hkey_font_cache)
     HKEY hkey_family;
     WCHAR buffer[4096];
 
+    if (load_font_list_data( hkey_font_cache )) return;
+
     size = sizeof(buffer);
     while (!RegEnumKeyExW(hkey_font_cache, family_index++, buffer, &size, NULL, NULL, NULL, NULL))
     {
@@ -1786,6 +2003,7 @@ static void load_font_list_from_cache(HKEY hkey_font_cache)
     }
 
     reorder_vertical_fonts();
+    save_font_list_data( hkey_font_cache );
 }
 
 static LONG create_font_cache_key(HKEY *hkey, DWORD *disposition)
@@ -1813,6 +2031,7 @@ static void add_face_to_cache(Face *face)
     HKEY hkey_family, hkey_face;
     WCHAR *face_key_name;
 
+    RegDeleteValueW(hkey_font_cache, font_cache_data_value);
     RegCreateKeyExW(hkey_font_cache, face->family->FamilyName, 0,
                     NULL, REG_OPTION_VOLATILE, KEY_ALL_ACCESS, NULL, &hkey_family, NULL);
     if(face->family->EnglishName)
@@ -1862,6 +2081,7 @@ static void remove_face_from_cache( Face *face )
 {
     HKEY hkey_family;
 
+    RegDeleteValueW( hkey_font_cache, font_cache_data_value );
     RegOpenKeyExW( hkey_font_cache, face->family->FamilyName, 0, KEY_ALL_ACCESS, &hkey_family );
 
     if (face->scalable)
@@ -4308,6 +4528,226 @@ static void init_font_list(void)
     }
 }
 
+/* The font list can also be saved as a snapshot in the non-volatile fonts key, so that
+ * the first process of a new session doesn't have to scan all the fonts again. The
+ * snapshot is only maintained once the value has been created by wineboot --warm-up.
+ * It's discarded when Wine has been updated or when one of the directories containing
+ * the fonts has been modified since it was saved. */
+
+#define FONT_SNAPSHOT_VERSION 1
+
+struct font_dirs
+{
+    WCHAR      **names;
+    unsigned int count;
+    unsigned int size;
+};
+
+static BOOL add_font_dir( struct font_dirs *dirs, const WCHAR *name, unsigned int len )
+{
+    WCHAR **new_names;
+    unsigned int i, new_size;
+
+    for (i = 0; i < dirs->count; i++)
+        if (!strncmpW( dirs->names[i], name, len ) && !dirs->names[i][len]) return TRUE;
+
+    if (dirs->count == dirs->size)
+    {
+        new_size = max( 16, dirs->size * 2 );
+        if (dirs->names)
+            new_names = HeapReAlloc( GetProcessHeap(), 0, dirs->names, new_size * sizeof(*new_names) );
+        else
+            new_names = HeapAlloc( GetProcessHeap(), 0, new_size * sizeof(*new_names) );
+        if (!new_names) return FALSE;
+        dirs->names = new_names;
+        dirs->size = new_size;
+    }
+    if (!(dirs->names[dirs->count] = HeapAlloc( GetProcessHeap(), 0, (len + 1) * sizeof(WCHAR) )))
+        return FALSE;
+    memcpy( dirs->names[dirs->count], name, len * sizeof(WCHAR) );
+    dirs->names[dirs->count++][len] = 0;
+    return TRUE;
+}
+
+static BOOL add_unix_font_dir( struct font_dirs *dirs, char *unixname )
+{
+    WCHAR *name;
+    BOOL ret;
+
+    if (!unixname) return TRUE;
+    name = towstr( CP_UNIXCP, unixname );
+    ret = add_font_dir( dirs, name, strlenW( name ));
+    HeapFree( GetProcessHeap(), 0, name );
+    HeapFree( GetProcessHeap(), 0, unixname );
+    return ret;
+}
+
+static void free_font_dirs( struct font_dirs *dirs )
+{
+    unsigned int i;
+
+    for (i = 0; i < dirs->count; i++) HeapFree( GetProcessHeap(), 0, dirs->names[i] );
+    HeapFree( GetProcessHeap(), 0, dirs->names );
+}
+
+/* the directories of all the fonts, plus the ones that are scanned even when empty */
+static BOOL get_font_dirs( struct font_dirs *dirs )
+{
+    WCHAR windowsdir[MAX_PATH], *p;
+    Family *family;
+    Face *face;
+
+    GetWindowsDirectoryW( windowsdir, sizeof(windowsdir) / sizeof(WCHAR) );
+    strcatW( windowsdir, fontsW );
+    if (!add_unix_font_dir( dirs, wine_get_unix_file_name( windowsdir ))) return FALSE;
+    if (!add_unix_font_dir( dirs, get_font_dir() )) return FALSE;
+
+    LIST_FOR_EACH_ENTRY( family, &font_list, Family, entry )
+    {
+        LIST_FOR_EACH_ENTRY( face, &family->faces, Face, entry )
+        {
+            if (!face->file || !(p = strrchrW( face->file, '/' ))) continue;
+            if (!add_font_dir( dirs, face->file, p - face->file )) return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static ULONGLONG get_font_dir_mtime( const WCHAR *name )
+{
+    char *unixname = strWtoA( CP_UNIXCP, name );
+    struct stat st;
+    ULONGLONG ret = ~(ULONGLONG)0;
+
+    if (!stat( unixname, &st )) ret = st.st_mtime;
+    HeapFree( GetProcessHeap(), 0, unixname );
+    return ret;
+}
+
+static void put_font_list_snapshot( struct font_cache_data *data, const struct font_dirs *dirs,
+                                    const WCHAR *build_id )
+{
+    ULONGLONG mtime;
+    unsigned int i;
+
+    put_cache_dword( data, FONT_SNAPSHOT_VERSION );
+    put_cache_string( data, build_id );
+    put_cache_dword( data, dirs->count );
+    for (i = 0; i < dirs->count; i++)
+    {
+        mtime = get_font_dir_mtime( dirs->names[i] );
+        put_cache_string( data, dirs->names[i] );
+        put_cache_dword( data, (DWORD)mtime );
+        put_cache_dword( data, (DWORD)(mtime >> 32) );
+    }
+    put_font_list_data( data );
+}
+
+static void save_font_list_snapshot(void)
+{
+    struct font_cache_data data = { NULL, NULL, 0 };
+    struct font_dirs dirs = { NULL, 0, 0 };
+    WCHAR *build_id;
+    BYTE *buffer;
+    HKEY hkey;
+
+    if (RegOpenKeyExW( HKEY_CURRENT_USER, wine_fonts_key, 0, KEY_ALL_ACCESS, &hkey )) return;
+
+    if (!RegQueryValueExW( hkey, font_snapshot_value, NULL, NULL, NULL, NULL ) && get_font_dirs( &dirs ))
+    {
+        build_id = towstr( CP_ACP, wine_get_build_id() );
+        put_font_list_snapshot( &data, &dirs, build_id );
+        if ((buffer = HeapAlloc( GetProcessHeap(), 0, data.size )))
+        {
+            data.ptr = buffer;
+            data.size = 0;
+            put_font_list_snapshot( &data, &dirs, build_id );
+            RegSetValueExW( hkey, font_snapshot_value, 0, REG_BINARY, buffer, data.size );
+            TRACE( "saved snapshot of %u bytes with %u directories\n", data.size, dirs.count );
+            HeapFree( GetProcessHeap(), 0, buffer );
+        }
+        HeapFree( GetProcessHeap(), 0, build_id );
+    }
+    free_font_dirs( &dirs );
+    RegCloseKey( hkey );
+}
+
+static BOOL check_font_list_snapshot( struct font_cache_data *data )
+{
+    DWORD i, version, count, low, high;
+    WCHAR *str;
+    char *build_id;
+    BOOL ret;
+
+    if (!get_cache_dword( data, &version ) || version != FONT_SNAPSHOT_VERSION) return FALSE;
+
+    if (!get_cache_string( data, &str, TRUE )) return FALSE;
+    build_id = strWtoA( CP_ACP, str );
+    ret = !strcmp( build_id, wine_get_build_id() );
+    HeapFree( GetProcessHeap(), 0, build_id );
+    HeapFree( GetProcessHeap(), 0, str );
+    if (!ret)
+    {
+        TRACE( "snapshot saved by a different Wine version\n" );
+        return FALSE;
+    }
+
+    if (!get_cache_dword( data, &count )) return FALSE;
+    for (i = 0; i < count; i++)
+    {
+        if (!get_cache_string( data, &str, TRUE )) return FALSE;
+        ret = get_cache_dword( data, &low ) && get_cache_dword( data, &high ) &&
+              get_font_dir_mtime( str ) == (((ULONGLONG)high << 32) | low);
+        if (!ret) TRACE( "%s has been modified\n", debugstr_w(str) );
+        HeapFree( GetProcessHeap(), 0, str );
+        if (!ret) return FALSE;
+    }
+    return TRUE;
+}
+
+static BOOL load_font_list_snapshot(void)
+{
+    struct font_cache_data data;
+    DWORD type, size;
+    BYTE *buffer = NULL, *list;
+    BOOL ret = FALSE;
+    Family *family;
+    Face *face;
+    HKEY hkey;
+
+    if (RegOpenKeyExW( HKEY_CURRENT_USER, wine_fonts_key, 0, KEY_ALL_ACCESS, &hkey )) return FALSE;
+
+    if (!RegQueryValueExW( hkey, font_snapshot_value, NULL, &type, NULL, &size ) &&
+        type == REG_BINARY && size &&
+        (buffer = HeapAlloc( GetProcessHeap(), 0, size )) &&
+        !RegQueryValueExW( hkey, font_snapshot_value, NULL, NULL, buffer, &size ))
+    {
+        data.ptr = buffer;
+        data.end = buffer + size;
+        if (check_font_list_snapshot( &data ))
+        {
+            list = data.ptr;
+            if ((ret = parse_font_list_data( &data, FALSE )))
+            {
+                data.ptr = list;
+                parse_font_list_data( &data, TRUE );
+            }
+            else WARN( "invalid font list snapshot, ignoring it\n" );
+        }
+    }
+    HeapFree( GetProcessHeap(), 0, buffer );
+    RegCloseKey( hkey );
+    if (!ret) return FALSE;
+
+    /* fill the volatile cache for the other processes of the session */
+    LIST_FOR_EACH_ENTRY( family, &font_list, Family, entry )
+        LIST_FOR_EACH_ENTRY( face, &family->faces, Face, entry )
+            if (face->flags & ADDFONT_ADD_TO_CACHE) add_face_to_cache( face );
+
+    TRACE( "loaded font list from the snapshot\n" );
+    return TRUE;
+}
+
 static BOOL move_to_front(const WCHAR *name)
 {
     Family *family, *cursor2;
@@ -4388,7 +4828,13 @@ BOOL WineEngInit(void)
     create_font_cache_key(&hkey_font_cache, &disposition);
 
     if(disposition == REG_CREATED_NEW_KEY)
-        init_font_list();
+    {
+        if (!load_font_list_snapshot())
+        {
+            init_font_list();
+            save_font_list_snapshot();
+        }
+    }
     else
         load_font_list_from_cache(hkey_font_cache);
 
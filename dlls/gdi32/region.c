@@ -168,6 +168,14 @@ static inline void empty_region( WINEREGION *reg )
     reg->extents.left = reg->extents.top = reg->extents.right = reg->extents.bottom = 0;
 }
 
+static inline void set_rect( RECT *rect, INT left, INT top, INT right, INT bottom )
+{
+    rect->left   = left;
+    rect->top    = top;
+    rect->right  = right;
+    rect->bottom = bottom;
+}
+
 static inline BOOL is_in_rect( const RECT *rect, int x, int y )
 {
     return (rect->right > x && rect->left <= x && rect->bottom > y && rect->top <= y);
@@ -1153,6 +1161,24 @@ static BOOL REGION_UnionRectWithRegion(const RECT *rect, WINEREGION *rgn)
 {
     WINEREGION region;
 
+    /* fast path for regions built from the top down, the rectangle can simply be appended */
+    if (rgn->numRects && rect->top >= rgn->extents.bottom &&
+        rect->left < rect->right && rect->top < rect->bottom)
+    {
+        RECT *last = &rgn->rects[rgn->numRects - 1];
+
+        if (rect->top == last->bottom && rect->left == last->left && rect->right == last->right &&
+            (rgn->numRects == 1 || last[-1].top != last->top))
+            last->bottom = rect->bottom;  /* coalesce with the last band */
+        else if (!add_rect( rgn, rect->left, rect->top, rect->right, rect->bottom ))
+            return FALSE;
+
+        rgn->extents.left   = min( rgn->extents.left, rect->left );
+        rgn->extents.right  = max( rgn->extents.right, rect->right );
+        rgn->extents.bottom = rect->bottom;
+        return TRUE;
+    }
+
     init_region( &region, 1 );
     region.numRects = 1;
     region.extents = *region.rects = *rect;
@@ -1930,6 +1956,12 @@ static BOOL REGION_IntersectRegion(WINEREGION *newReg, WINEREGION *reg1,
     if ( (!(reg1->numRects)) || (!(reg2->numRects))  ||
 	(!overlapping(&reg1->extents, &reg2->extents)))
 	newReg->numRects = 0;
+    else if (reg1->numRects == 1 && reg2->numRects == 1)
+    {
+        /* two overlapping rectangles, don't bother with bands */
+        intersect_rect( &newReg->rects[0], &reg1->extents, &reg2->extents );
+        newReg->numRects = 1;
+    }
     else
 	if (!REGION_RegionOp (newReg, reg1, reg2, REGION_IntersectO, NULL, NULL)) return FALSE;
 
@@ -2249,11 +2281,41 @@ static BOOL REGION_SubtractO (WINEREGION *pReg, RECT *r1, RECT *r1End,
  */
 static BOOL REGION_SubtractRegion(WINEREGION *regD, WINEREGION *regM, WINEREGION *regS )
 {
+    RECT rects[4];
+    INT count = 0;
+
    /* check for trivial reject */
     if ( (!(regM->numRects)) || (!(regS->numRects))  ||
 	(!overlapping(&regM->extents, &regS->extents)) )
 	return REGION_CopyRegion(regD, regM);
 
+    if (regS->numRects == 1 &&
+        regS->extents.left <= regM->extents.left && regS->extents.right >= regM->extents.right &&
+        regS->extents.top <= regM->extents.top && regS->extents.bottom >= regM->extents.bottom)
+    {
+        /* the subtrahend covers everything */
+        empty_region( regD );
+        return TRUE;
+    }
+
+    if (regM->numRects == 1 && regS->numRects == 1)
+    {
+        /* rectangle minus rectangle: at most one band above, one in the middle and one below */
+        const RECT *m = &regM->extents, *r = &regS->extents;
+        INT top = max( m->top, r->top ), bottom = min( m->bottom, r->bottom );
+
+        if (m->top < r->top) set_rect( &rects[count++], m->left, m->top, m->right, r->top );
+        if (m->left < r->left) set_rect( &rects[count++], m->left, top, r->left, bottom );
+        if (m->right > r->right) set_rect( &rects[count++], r->right, top, m->right, bottom );
+        if (m->bottom > r->bottom) set_rect( &rects[count++], m->left, r->bottom, m->right, m->bottom );
+
+        /* regD may be one of the sources, and always has room for the default number of rects */
+        memcpy( regD->rects, rects, count * sizeof(RECT) );
+        regD->numRects = count;
+        REGION_SetExtents( regD );
+        return TRUE;
+    }
+
     if (!REGION_RegionOp (regD, regM, regS, REGION_SubtractO, REGION_SubtractNonO1, NULL))
         return FALSE;
 
@@ -3595,6 +3595,44 @@ static void test_StretchDIBits(void)
     DeleteDC(hdcScreen);
 }
 
+static void test_StretchBlt_halftone(void)
+{
+    static const UINT32 src_bits[4] = { 0x000000, 0xffffff, 0xffffff, 0x000000 };
+    HBITMAP bmp, old_bmp;
+    BITMAPINFO bmi;
+    UINT32 *bits;
+    HDC hdc;
+    int i;
+
+    memset( &bmi, 0, sizeof(bmi) );
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = 1;
+    bmi.bmiHeader.biHeight = -1;
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+
+    hdc = CreateCompatibleDC( 0 );
+    bmp = CreateDIBSection( hdc, &bmi, DIB_RGB_COLORS, (void **)&bits, NULL, 0 );
+    old_bmp = SelectObject( hdc, bmp );
+    SetStretchBltMode( hdc, HALFTONE );
+
+    /* shrinking a checkerboard should give a shade of grey */
+    bmi.bmiHeader.biWidth = 2;
+    bmi.bmiHeader.biHeight = -2;
+    *bits = 0;
+    StretchDIBits( hdc, 0, 0, 1, 1, 0, 0, 2, 2, src_bits, &bmi, DIB_RGB_COLORS, SRCCOPY );
+    for (i = 0; i < 24; i += 8)
+    {
+        BYTE val = *bits >> i;
+        ok( val >= 0x60 && val <= 0xa0, "got %06x\n", *bits & 0xffffff );
+    }
+
+    SelectObject( hdc, old_bmp );
+    DeleteObject( bmp );
+    DeleteDC( hdc );
+}
+
 static void test_GdiAlphaBlend(void)
 {
     HDC hdcNull;
@@ -5954,6 +5992,7 @@ START_TEST(bitmap)
     test_BitBlt();
     test_StretchBlt();
     test_StretchDIBits();
+    test_StretchBlt_halftone();
     test_GdiAlphaBlend();
     test_GdiGradientFill();
     test_32bit_ddb();
@@ -534,6 +534,71 @@ static void test_window_dc_clipping(void)
 }
 
 
+static void check_region_rects(HRGN hrgn, const RECT *rects, DWORD count, int line)
+{
+    union
+    {
+        RGNDATA data;
+        char buf[sizeof(RGNDATAHEADER) + 8 * sizeof(RECT)];
+    } rgn;
+    const RECT *rect = (const RECT *)rgn.data.Buffer;
+    DWORD ret, i;
+
+    ret = GetRegionData(hrgn, sizeof(rgn), &rgn.data);
+    ok_(__FILE__, line)(ret == sizeof(rgn.data.rdh) + count * sizeof(RECT), "got size %u\n", ret);
+    ok_(__FILE__, line)(rgn.data.rdh.nCount == count, "expected %u rects, got %u\n", count, rgn.data.rdh.nCount);
+    for (i = 0; i < min(count, rgn.data.rdh.nCount); i++)
+        ok_(__FILE__, line)(EqualRect(&rect[i], &rects[i]), "rect %u: expected %s, got %s\n",
+                            i, wine_dbgstr_rect(&rects[i]), wine_dbgstr_rect(&rect[i]));
+}
+
+static void test_CombineRgn(void)
+{
+    static const RECT hole[] =
+    {
+        {  0,  0, 100, 10 },
+        {  0, 10,  10, 20 },
+        { 90, 10, 100, 20 },
+        {  0, 20, 100, 30 },
+    };
+    static const RECT notch[] =
+    {
+        {  0,  0,  50, 30 },
+    };
+    static const RECT inter[] =
+    {
+        { 10, 10, 90, 20 },
+    };
+    HRGN rgn1, rgn2, dst;
+    INT ret;
+
+    rgn1 = CreateRectRgn(0, 0, 100, 30);
+    rgn2 = CreateRectRgn(10, 10, 90, 20);
+    dst = CreateRectRgn(0, 0, 0, 0);
+
+    ret = CombineRgn(dst, rgn1, rgn2, RGN_DIFF);
+    ok(ret == COMPLEXREGION, "got %d\n", ret);
+    check_region_rects(dst, hole, ARRAY_SIZE(hole), __LINE__);
+
+    ret = CombineRgn(dst, rgn1, rgn2, RGN_AND);
+    ok(ret == SIMPLEREGION, "got %d\n", ret);
+    check_region_rects(dst, inter, ARRAY_SIZE(inter), __LINE__);
+
+    ret = CombineRgn(dst, rgn2, rgn1, RGN_DIFF);
+    ok(ret == NULLREGION, "got %d\n", ret);
+    check_region_rects(dst, NULL, 0, __LINE__);
+
+    /* the destination can be one of the sources */
+    SetRectRgn(rgn2, 50, -10, 200, 40);
+    ret = CombineRgn(rgn1, rgn1, rgn2, RGN_DIFF);
+    ok(ret == SIMPLEREGION, "got %d\n", ret);
+    check_region_rects(rgn1, notch, ARRAY_SIZE(notch), __LINE__);
+
+    DeleteObject(rgn1);
+    DeleteObject(rgn2);
+    DeleteObject(dst);
+}
+
 START_TEST(clipping)
 {
     test_GetRandomRgn();
@@ -541,4 +606,5 @@ START_TEST(clipping)
     test_GetClipRgn();
     test_memory_dc_clipping();
     test_window_dc_clipping();
+    test_CombineRgn();
 }
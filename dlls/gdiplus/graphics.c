@@ -374,6 +374,35 @@ static GpStatus alpha_blend_bmp_pixels(GpGraphics *graphics, INT dst_x, INT dst_
     GpBitmap *dst_bitmap = (GpBitmap*)graphics->image;
     INT x, y;
 
+    if (dst_bitmap->format == PixelFormat32bppARGB && dst_bitmap->bits)
+    {
+        /* blend the spans directly into the bitmap bits */
+        INT left = max(dst_x, 0), top = max(dst_y, 0);
+        INT right = min(dst_x + src_width, dst_bitmap->width);
+        INT bottom = min(dst_y + src_height, dst_bitmap->height);
+
+        for (y=top; y<bottom; y++)
+        {
+            const ARGB *src_row = (const ARGB*)(src + src_stride * (y - dst_y)) - dst_x;
+            ARGB *dst_row = (ARGB*)(dst_bitmap->bits + dst_bitmap->stride * y);
+
+            for (x=left; x<right; x++)
+            {
+                ARGB src_color = src_row[x];
+
+                if (!(src_color & 0xff000000))
+                    continue;
+
+                if (fmt & PixelFormatPAlpha)
+                    dst_row[x] = color_over_fgpremult(dst_row[x], src_color);
+                else
+                    dst_row[x] = color_over(dst_row[x], src_color);
+            }
+        }
+
+        return Ok;
+    }
+
     for (y=0; y<src_height; y++)
     {
         for (x=0; x<src_width; x++)
@@ -4206,6 +4235,254 @@ end:
     return retval;
 }
 
+/* Accumulate the signed area covered by a line in a coverage buffer holding
+ * width + 2 cells per row. X coordinates must already be in [0, width]; the
+ * running sum of a row gives the winding-weighted coverage of each pixel. */
+static void rasterize_line(float *cells, INT width, INT height, REAL x0, REAL y0, REAL x1, REAL y1)
+{
+    INT stride = width + 2, y, y_end;
+    REAL dir = 1.0, dxdy, x, tmp;
+
+    if (y0 == y1) return;
+
+    if (y0 > y1)
+    {
+        tmp = x0; x0 = x1; x1 = tmp;
+        tmp = y0; y0 = y1; y1 = tmp;
+        dir = -1.0;
+    }
+
+    if (y1 <= 0.0 || y0 >= height) return;
+
+    dxdy = (x1 - x0) / (y1 - y0);
+    x = x0;
+    if (y0 < 0.0)
+    {
+        x = max(0.0, min(width, x - y0 * dxdy));
+        y = 0;
+    }
+    else
+        y = floorf(y0);
+    y_end = min(height, ceilr(y1));
+
+    for (; y < y_end; y++)
+    {
+        float *row = cells + y * stride;
+        REAL dy = min(y + 1, y1) - max(y, y0);
+        REAL x_next = x + dxdy * dy, d = dy * dir;
+        REAL left, right;
+        INT left_i, right_i;
+
+        /* rounding errors may push us slightly out of the buffer */
+        x_next = max(0.0, min(width, x_next));
+        left = min(x, x_next);
+        right = max(x, x_next);
+        left_i = floorf(left);
+        right_i = ceilr(right);
+
+        if (right_i <= left_i + 1)
+        {
+            /* the line stays within a single pixel */
+            REAL mid = 0.5 * (x + x_next) - left_i;
+            row[left_i] += d - d * mid;
+            row[left_i + 1] += d * mid;
+        }
+        else
+        {
+            REAL s = 1.0 / (right - left);
+            REAL left_f = left - left_i;
+            REAL right_f = right - right_i + 1;
+            REAL a0 = 0.5 * s * (1.0 - left_f) * (1.0 - left_f);
+            REAL am = 0.5 * s * right_f * right_f;
+            INT i;
+
+            row[left_i] += d * a0;
+            if (right_i == left_i + 2)
+                row[left_i + 1] += d * (1.0 - a0 - am);
+            else
+            {
+                REAL a1 = s * (1.5 - left_f);
+                REAL a2 = a1 + (right_i - left_i - 3) * s;
+
+                row[left_i + 1] += d * (a1 - a0);
+                for (i = left_i + 2; i < right_i - 1; i++)
+                    row[i] += d * s;
+                row[right_i - 1] += d * (1.0 - a2 - am);
+            }
+            row[right_i] += d * am;
+        }
+
+        x = x_next;
+    }
+}
+
+/* Split a line at the left and right edges of the coverage buffer. The parts
+ * outside are projected on the edges, which doesn't change the coverage of
+ * the pixels inside. */
+static void rasterize_clipped_line(float *cells, INT width, INT height, const GpPointF *p0, const GpPointF *p1)
+{
+    REAL t[4], dx = p1->X - p0->X, tmp;
+    INT count = 0, i;
+
+    t[count++] = 0.0;
+    if ((p0->X < 0.0) != (p1->X < 0.0))
+        t[count++] = -p0->X / dx;
+    if ((p0->X < width) != (p1->X < width))
+        t[count++] = (width - p0->X) / dx;
+    if (count == 3 && t[1] > t[2])
+    {
+        tmp = t[1]; t[1] = t[2]; t[2] = tmp;
+    }
+    t[count++] = 1.0;
+
+    for (i = 0; i < count - 1; i++)
+    {
+        REAL x0 = p0->X + dx * t[i], x1 = p0->X + dx * t[i + 1];
+        REAL y0 = p0->Y + (p1->Y - p0->Y) * t[i], y1 = p0->Y + (p1->Y - p0->Y) * t[i + 1];
+
+        x0 = max(0.0, min(width, x0));
+        x1 = max(0.0, min(width, x1));
+        rasterize_line(cells, width, height, x0, y0, x1, y1);
+    }
+}
+
+/* Fill a path with antialiasing by computing the exact area coverage of each
+ * pixel, and blend the brush pixels weighted by that coverage. */
+static GpStatus SOFTWARE_GdipFillPathAntialias(GpGraphics *graphics, GpBrush *brush, GpPath *path)
+{
+    GpStatus stat;
+    GpPath *flat_path;
+    GpMatrix world_to_device;
+    GpRectF graphics_bounds;
+    GpRect rect;
+    GpPointF *points, origin;
+    REAL min_x, min_y, max_x, max_y, offset;
+    DWORD *pixel_data = NULL;
+    float *cells = NULL;
+    INT i, x, y, start, count, right, bottom;
+
+    stat = gdi_transform_acquire(graphics);
+    if (stat != Ok)
+        return stat;
+
+    stat = get_graphics_device_bounds(graphics, &graphics_bounds);
+
+    if (stat == Ok)
+        stat = get_graphics_transform(graphics, WineCoordinateSpaceGdiDevice,
+            CoordinateSpaceWorld, &world_to_device);
+
+    if (stat == Ok)
+        stat = GdipClonePath(path, &flat_path);
+
+    if (stat != Ok)
+    {
+        gdi_transform_release(graphics);
+        return stat;
+    }
+
+    stat = GdipFlattenPath(flat_path, &world_to_device, FlatnessDefault);
+
+    count = flat_path->pathdata.Count;
+    points = flat_path->pathdata.Points;
+
+    if (stat != Ok || !count)
+        goto end;
+
+    /* pixel centers are on integer coordinates unless the pixels are offset by half */
+    if (graphics->pixeloffset == PixelOffsetModeHalf || graphics->pixeloffset == PixelOffsetModeHighQuality)
+        offset = 0.0;
+    else
+        offset = 0.5;
+
+    min_x = max_x = points[0].X;
+    min_y = max_y = points[0].Y;
+    for (i = 1; i < count; i++)
+    {
+        min_x = min(min_x, points[i].X);
+        max_x = max(max_x, points[i].X);
+        min_y = min(min_y, points[i].Y);
+        max_y = max(max_y, points[i].Y);
+    }
+
+    rect.X = max(floorf(min_x + offset), graphics_bounds.X);
+    rect.Y = max(floorf(min_y + offset), graphics_bounds.Y);
+    right = min(ceilr(max_x + offset), graphics_bounds.X + graphics_bounds.Width);
+    bottom = min(ceilr(max_y + offset), graphics_bounds.Y + graphics_bounds.Height);
+    if (right <= rect.X || bottom <= rect.Y)
+        goto end;
+    rect.Width = right - rect.X;
+    rect.Height = bottom - rect.Y;
+
+    cells = heap_alloc_zero(sizeof(*cells) * (rect.Width + 2) * rect.Height);
+    pixel_data = heap_alloc_zero(sizeof(*pixel_data) * rect.Width * rect.Height);
+    if (!cells || !pixel_data)
+    {
+        stat = OutOfMemory;
+        goto end;
+    }
+
+    origin.X = rect.X - offset;
+    origin.Y = rect.Y - offset;
+    for (i = 0; i < count; i++)
+    {
+        points[i].X -= origin.X;
+        points[i].Y -= origin.Y;
+    }
+
+    /* every figure is implicitly closed */
+    for (start = 0, i = 1; i <= count; i++)
+    {
+        if (i == count || (flat_path->pathdata.Types[i] & PathPointTypePathTypeMask) == PathPointTypeStart)
+        {
+            rasterize_clipped_line(cells, rect.Width, rect.Height, &points[i - 1], &points[start]);
+            start = i;
+        }
+        else
+            rasterize_clipped_line(cells, rect.Width, rect.Height, &points[i - 1], &points[i]);
+    }
+
+    stat = brush_fill_pixels(graphics, brush, pixel_data, &rect, rect.Width);
+
+    if (stat == Ok)
+    {
+        for (y = 0; y < rect.Height; y++)
+        {
+            const float *row = cells + y * (rect.Width + 2);
+            DWORD *pixels = pixel_data + y * rect.Width;
+            REAL acc = 0.0, coverage;
+
+            for (x = 0; x < rect.Width; x++)
+            {
+                acc += row[x];
+                coverage = fabsf(acc);
+                if (path->fill == FillModeAlternate)
+                {
+                    coverage = fmodf(coverage, 2.0);
+                    if (coverage > 1.0) coverage = 2.0 - coverage;
+                }
+                else if (coverage > 1.0) coverage = 1.0;
+
+                if (coverage < 1.0)
+                {
+                    DWORD alpha = (pixels[x] >> 24) * gdip_round(coverage * 255.0) / 255;
+                    pixels[x] = (pixels[x] & 0xffffff) | (alpha << 24);
+                }
+            }
+        }
+
+        stat = alpha_blend_pixels(graphics, rect.X, rect.Y, (BYTE *)pixel_data,
+            rect.Width, rect.Height, rect.Width * 4, PixelFormat32bppARGB);
+    }
+
+end:
+    heap_free(pixel_data);
+    heap_free(cells);
+    GdipDeletePath(flat_path);
+    gdi_transform_release(graphics);
+
+    return stat;
+}
+
 static GpStatus SOFTWARE_GdipFillPath(GpGraphics *graphics, GpBrush *brush, GpPath *path)
 {
     GpStatus stat;
@@ -4214,6 +4491,9 @@ static GpStatus SOFTWARE_GdipFillPath(GpGraphics *graphics, GpBrush *brush, GpPa
     if (!brush_can_fill_pixels(brush))
         return NotImplemented;
 
+    if (graphics->smoothing == SmoothingModeAntiAlias || graphics->smoothing == SmoothingModeHighQuality)
+        return SOFTWARE_GdipFillPathAntialias(graphics, brush, path);
+
     /* FIXME: This could probably be done more efficiently without regions. */
 
     stat = GdipCreateRegionPath(path, &rgn);
@@ -6733,6 +6733,66 @@ static void test_hdc_caching(void)
     DeleteObject(hbm);
 }
 
+static void test_fill_path_antialias(void)
+{
+    GpStatus status;
+    GpBitmap *bitmap;
+    GpGraphics *graphics;
+    GpSolidFill *brush;
+    GpPath *path;
+    ARGB color;
+
+    status = GdipCreateBitmapFromScan0(20, 10, 80, PixelFormat32bppARGB, NULL, &bitmap);
+    expect(Ok, status);
+    status = GdipGetImageGraphicsContext((GpImage *)bitmap, &graphics);
+    expect(Ok, status);
+    status = GdipCreateSolidFill(0xff0000ff, &brush);
+    expect(Ok, status);
+    status = GdipCreatePath(FillModeAlternate, &path);
+    expect(Ok, status);
+    status = GdipAddPathRectangle(path, 2.0, 2.0, 4.0, 4.0);
+    expect(Ok, status);
+
+    status = GdipSetSmoothingMode(graphics, SmoothingModeAntiAlias);
+    expect(Ok, status);
+    status = GdipFillPath(graphics, (GpBrush *)brush, path);
+    expect(Ok, status);
+
+    /* pixel centers lie on the edges of the rectangle */
+    GdipBitmapGetPixel(bitmap, 4, 4, &color);
+    expect(0xff0000ff, color);
+    GdipBitmapGetPixel(bitmap, 2, 4, &color);
+    ok((color & 0xffffff) == 0xff && (color >> 24) >= 0x70 && (color >> 24) <= 0x90,
+       "got %08x\n", color);
+    GdipBitmapGetPixel(bitmap, 6, 2, &color);
+    ok((color & 0xffffff) == 0xff && (color >> 24) >= 0x30 && (color >> 24) <= 0x50,
+       "got %08x\n", color);
+    GdipBitmapGetPixel(bitmap, 7, 4, &color);
+    expect(0, color);
+
+    /* half pixel offset aligns the edges with the pixel grid */
+    status = GdipTranslateWorldTransform(graphics, 10.0, 0.0, MatrixOrderAppend);
+    expect(Ok, status);
+    status = GdipSetPixelOffsetMode(graphics, PixelOffsetModeHalf);
+    expect(Ok, status);
+    status = GdipFillPath(graphics, (GpBrush *)brush, path);
+    expect(Ok, status);
+
+    GdipBitmapGetPixel(bitmap, 12, 2, &color);
+    expect(0xff0000ff, color);
+    GdipBitmapGetPixel(bitmap, 15, 5, &color);
+    expect(0xff0000ff, color);
+    GdipBitmapGetPixel(bitmap, 11, 4, &color);
+    expect(0, color);
+    GdipBitmapGetPixel(bitmap, 16, 4, &color);
+    expect(0, color);
+
+    GdipDeletePath(path);
+    GdipDeleteBrush((GpBrush *)brush);
+    GdipDeleteGraphics(graphics);
+    GdipDisposeImage((GpImage *)bitmap);
+}
+
 START_TEST(graphics)
 {
     struct GdiplusStartupInput gdiplusStartupInput;
@@ -6825,6 +6885,7 @@ START_TEST(graphics)
     test_GdipGraphicsSetAbort();
     test_cliphrgn_transform();
     test_hdc_caching();
+    test_fill_path_antialias();
 
     GdiplusShutdown(gdiplusToken);
     DestroyWindow( hwnd );
@@ -17,6 +17,7 @@
 
 #include "config.h"
 
+#include <errno.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -166,7 +167,7 @@ BOOL isIfIndexLoopback(ULONG idx)
 }
 
 #ifdef HAVE_IF_NAMEINDEX
-DWORD get_interface_indices( BOOL skip_loopback, InterfaceIndexTable **table )
+static DWORD enum_interface_indices( BOOL skip_loopback, InterfaceIndexTable **table )
 {
     DWORD count = 0, i;
     struct if_nameindex *p, *indices = if_nameindex();
@@ -352,7 +353,7 @@ static DWORD get_indices_from_reply( struct netlink_reply *reply, int pid, int s
     return count;
 }
 
-DWORD get_interface_indices( BOOL skip_loopback, InterfaceIndexTable **table )
+static DWORD enum_interface_indices( BOOL skip_loopback, InterfaceIndexTable **table )
 {
     int fd, pid, seq;
     struct netlink_reply *reply = NULL;
@@ -391,13 +392,163 @@ end:
 }
 
 #else
-DWORD get_interface_indices( BOOL skip_loopback, InterfaceIndexTable **table )
+static DWORD enum_interface_indices( BOOL skip_loopback, InterfaceIndexTable **table )
 {
     if (table) *table = NULL;
     return 0;
 }
 #endif
 
+static LONG change_serial;     /* incremented on every interface or address change */
+static BOOL monitor_running;   /* whether changes are being monitored */
+
+#ifdef HAVE_LINUX_RTNETLINK_H
+static DWORD WINAPI interface_monitor_thread( void *arg )
+{
+    int fd = PtrToLong( arg ), len;
+    struct nlmsghdr *hdr;
+    char buf[8192];
+
+    for (;;)
+    {
+        if ((len = recv( fd, buf, sizeof(buf), 0 )) < 0)
+        {
+            if (errno == EINTR) continue;
+            if (errno != ENOBUFS) break;
+            /* the socket buffer overflowed and some events were lost,
+             * report a change on all the interfaces */
+            InterlockedIncrement( &change_serial );
+            notify_interface_change( WS_AF_UNSPEC, 0, FALSE );
+            continue;
+        }
+
+        InterlockedIncrement( &change_serial );
+        for (hdr = (struct nlmsghdr *)buf; NLMSG_OK(hdr, len); hdr = NLMSG_NEXT(hdr, len))
+        {
+            switch (hdr->nlmsg_type)
+            {
+            case RTM_NEWLINK:
+            case RTM_DELLINK:
+            {
+                struct ifinfomsg *info = NLMSG_DATA(hdr);
+                notify_interface_change( WS_AF_UNSPEC, info->ifi_index, hdr->nlmsg_type == RTM_DELLINK );
+                break;
+            }
+            case RTM_NEWADDR:
+            case RTM_DELADDR:
+            {
+                struct ifaddrmsg *addr = NLMSG_DATA(hdr);
+                notify_interface_change( addr->ifa_family == AF_INET6 ? WS_AF_INET6 : WS_AF_INET,
+                                         addr->ifa_index, hdr->nlmsg_type == RTM_DELADDR );
+                break;
+            }
+            }
+        }
+    }
+
+    /* stop trusting the cached tables */
+    monitor_running = FALSE;
+    close( fd );
+    return 0;
+}
+
+static BOOL WINAPI init_interface_monitor( INIT_ONCE *once, void *param, void **context )
+{
+    struct sockaddr_nl addr;
+    HMODULE module;
+    HANDLE thread;
+    int fd;
+
+    if ((fd = socket( AF_NETLINK, SOCK_RAW, NETLINK_ROUTE )) < 0) return TRUE;
+
+    memset( &addr, 0, sizeof(addr) );
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+    if (bind( fd, (struct sockaddr *)&addr, sizeof(addr) ) < 0)
+    {
+        close( fd );
+        return TRUE;
+    }
+
+    /* the thread runs until the process exits */
+    GetModuleHandleExW( GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_PIN,
+                        (const WCHAR *)init_interface_monitor, &module );
+
+    monitor_running = TRUE;
+    if (!(thread = CreateThread( NULL, 0, interface_monitor_thread, LongToPtr( fd ), 0, NULL )))
+    {
+        monitor_running = FALSE;
+        close( fd );
+        return TRUE;
+    }
+    CloseHandle( thread );
+    return TRUE;
+}
+#else
+static BOOL WINAPI init_interface_monitor( INIT_ONCE *once, void *param, void **context )
+{
+    return TRUE;
+}
+#endif
+
+BOOL start_interface_monitor(void)
+{
+    static INIT_ONCE init_once = INIT_ONCE_STATIC_INIT;
+
+    InitOnceExecuteOnce( &init_once, init_interface_monitor, NULL, NULL );
+    return monitor_running;
+}
+
+/* snapshots of the interface indexes, valid as long as change_serial doesn't move */
+struct index_cache
+{
+    LONG                 serial;
+    InterfaceIndexTable *table;
+};
+
+static struct index_cache index_cache[2];  /* with and without the loopback interfaces */
+
+static CRITICAL_SECTION index_cache_cs;
+static CRITICAL_SECTION_DEBUG index_cache_cs_debug =
+{
+    0, 0, &index_cache_cs,
+    { &index_cache_cs_debug.ProcessLocksList, &index_cache_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": index_cache_cs") }
+};
+static CRITICAL_SECTION index_cache_cs = { &index_cache_cs_debug, -1, 0, 0, 0, 0 };
+
+DWORD get_interface_indices( BOOL skip_loopback, InterfaceIndexTable **table )
+{
+    struct index_cache *cache = &index_cache[skip_loopback ? 0 : 1];
+    LONG serial = change_serial;
+    DWORD count = 0, size;
+
+    if (!start_interface_monitor()) return enum_interface_indices( skip_loopback, table );
+
+    if (table) *table = NULL;
+
+    EnterCriticalSection( &index_cache_cs );
+    if (!cache->table || cache->serial != serial)
+    {
+        HeapFree( GetProcessHeap(), 0, cache->table );
+        cache->table = NULL;
+        enum_interface_indices( skip_loopback, &cache->table );
+        cache->serial = serial;
+    }
+    if (cache->table)
+    {
+        count = cache->table->numIndexes;
+        if (table)
+        {
+            size = FIELD_OFFSET(InterfaceIndexTable, indexes[count]);
+            if ((*table = HeapAlloc( GetProcessHeap(), 0, size ))) memcpy( *table, cache->table, size );
+            else count = 0;
+        }
+    }
+    LeaveCriticalSection( &index_cache_cs );
+    return count;
+}
+
 static DWORD getInterfaceBCastAddrByName(const char *name)
 {
   DWORD ret = INADDR_ANY;
@@ -57,6 +57,19 @@ typedef struct _InterfaceIndexTable {
  */
 DWORD get_interface_indices( BOOL skip_loopback, InterfaceIndexTable **table ) DECLSPEC_HIDDEN;
 
+/* Starts watching the system for interface and address changes, if not
+ * already done.  While it's running, indexes returned by
+ * get_interface_indices() come from a snapshot that is refreshed on change.
+ * Returns FALSE if changes can't be monitored.
+ */
+BOOL start_interface_monitor(void) DECLSPEC_HIDDEN;
+
+/* Called from the monitor thread on every change, implemented in
+ * iphlpapi_main.c.  family is WS_AF_UNSPEC for changes to the interface
+ * itself, and index is 0 if the changed interface isn't known.
+ */
+void notify_interface_change( ADDRESS_FAMILY family, IF_INDEX index, BOOL deleted ) DECLSPEC_HIDDEN;
+
 /* ByName/ByIndex versions of various getter functions. */
 
 /* can be used as quick check to see if you've got a valid index, returns NULL
@@ -37,6 +37,8 @@
 # include <resolv.h>
 #endif
 
+#include "ntstatus.h"
+#define WIN32_NO_STATUS
 #define NONAMELESSUNION
 #define NONAMELESSSTRUCT
 #include "windef.h"
@@ -56,6 +58,7 @@
 #include "tcpestats.h"
 
 #include "wine/debug.h"
+#include "wine/list.h"
 #include "wine/unicode.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(iphlpapi);
@@ -68,6 +71,79 @@ WINE_DEFAULT_DEBUG_CHANNEL(iphlpapi);
 #define INADDR_NONE ~0UL
 #endif
 
+/* pending NotifyAddrChange request */
+struct addr_change_request
+{
+    struct list  entry;
+    OVERLAPPED  *overlapped;
+};
+
+/* NotifyIpInterfaceChange registration, the handle returned to the caller */
+struct interface_change_callback
+{
+    struct list                   entry;
+    ADDRESS_FAMILY                family;
+    PIPINTERFACE_CHANGE_CALLBACK  callback;
+    void                         *context;
+};
+
+static struct list addr_change_requests = LIST_INIT( addr_change_requests );
+static struct list interface_change_callbacks = LIST_INIT( interface_change_callbacks );
+static HANDLE addr_change_event;   /* signaled when the pending requests complete */
+
+static CRITICAL_SECTION change_cs;
+static CRITICAL_SECTION_DEBUG change_cs_debug =
+{
+    0, 0, &change_cs,
+    { &change_cs_debug.ProcessLocksList, &change_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": change_cs") }
+};
+static CRITICAL_SECTION change_cs = { &change_cs_debug, -1, 0, 0, 0, 0 };
+
+/* called from the monitor thread, see ifenum.c */
+void notify_interface_change( ADDRESS_FAMILY family, IF_INDEX index, BOOL deleted )
+{
+    struct addr_change_request *request, *next_request;
+    struct interface_change_callback *cb, *next_cb;
+    MIB_IPINTERFACE_ROW row;
+
+    TRACE( "family %u index %u deleted %d\n", family, index, deleted );
+
+    EnterCriticalSection( &change_cs );
+
+    /* NotifyAddrChange only reports changes to the IPv4 address table */
+    if (family != WS_AF_INET6)
+    {
+        LIST_FOR_EACH_ENTRY_SAFE( request, next_request, &addr_change_requests,
+                                  struct addr_change_request, entry )
+        {
+            request->overlapped->InternalHigh = 0;
+            request->overlapped->Internal = STATUS_SUCCESS;
+            if (request->overlapped->hEvent) SetEvent( request->overlapped->hEvent );
+            list_remove( &request->entry );
+            HeapFree( GetProcessHeap(), 0, request );
+        }
+        if (addr_change_event) SetEvent( addr_change_event );
+    }
+
+    LIST_FOR_EACH_ENTRY_SAFE( cb, next_cb, &interface_change_callbacks,
+                              struct interface_change_callback, entry )
+    {
+        if (family != WS_AF_UNSPEC && cb->family != WS_AF_UNSPEC && cb->family != family) continue;
+
+        memset( &row, 0, sizeof(row) );
+        if (family != WS_AF_UNSPEC) row.Family = family;
+        else row.Family = cb->family != WS_AF_UNSPEC ? cb->family : WS_AF_INET;
+        row.InterfaceIndex = index;
+        if (index) ConvertInterfaceIndexToLuid( index, &row.InterfaceLuid );
+
+        cb->callback( cb->context, index ? &row : NULL,
+                      deleted ? MibDeleteInstance : MibParameterNotification );
+    }
+
+    LeaveCriticalSection( &change_cs );
+}
+
 /******************************************************************
  *    AddIPAddress (IPHLPAPI.@)
  *
@@ -201,14 +277,27 @@ DWORD WINAPI AllocateAndGetIpAddrTableFromStack(PMIB_IPADDRTABLE *ppIpAddrTable,
  * RETURNS
  *  Success: TRUE
  *  Failure: FALSE
- *
- * FIXME
- *  Stub, returns FALSE.
  */
 BOOL WINAPI CancelIPChangeNotify(LPOVERLAPPED overlapped)
 {
-  FIXME("(overlapped %p): stub\n", overlapped);
-  return FALSE;
+  struct addr_change_request *request;
+  BOOL ret = FALSE;
+
+  TRACE("(overlapped %p)\n", overlapped);
+
+  EnterCriticalSection(&change_cs);
+  LIST_FOR_EACH_ENTRY(request, &addr_change_requests, struct addr_change_request, entry)
+  {
+    if (request->overlapped != overlapped) continue;
+    overlapped->Internal = STATUS_CANCELLED;
+    if (overlapped->hEvent) SetEvent(overlapped->hEvent);
+    list_remove(&request->entry);
+    HeapFree(GetProcessHeap(), 0, request);
+    ret = TRUE;
+    break;
+  }
+  LeaveCriticalSection(&change_cs);
+  return ret;
 }
 
 
@@ -217,7 +306,19 @@ BOOL WINAPI CancelIPChangeNotify(LPOVERLAPPED overlapped)
  */
 DWORD WINAPI CancelMibChangeNotify2(HANDLE handle)
 {
-    FIXME("(handle %p): stub\n", handle);
+    struct interface_change_callback *cb;
+
+    TRACE("(handle %p)\n", handle);
+
+    EnterCriticalSection(&change_cs);
+    LIST_FOR_EACH_ENTRY(cb, &interface_change_callbacks, struct interface_change_callback, entry)
+    {
+        if (cb != handle) continue;
+        list_remove(&cb->entry);
+        HeapFree(GetProcessHeap(), 0, cb);
+        break;
+    }
+    LeaveCriticalSection(&change_cs);
     return NO_ERROR;
 }
 
@@ -2717,28 +2818,104 @@ DWORD WINAPI IpRenewAddress(PIP_ADAPTER_INDEX_MAP AdapterInfo)
  *  Success: NO_ERROR
  *  Failure: error code from winerror.h
  *
- * FIXME
- *  Stub, returns ERROR_NOT_SUPPORTED.
+ * NOTES
+ *  Without an overlapped structure, the call blocks until the next change.
+ *  Changes are never reported on platforms where they can't be monitored.
  */
 DWORD WINAPI NotifyAddrChange(PHANDLE Handle, LPOVERLAPPED overlapped)
 {
-  FIXME("(Handle %p, overlapped %p): stub\n", Handle, overlapped);
-  if (Handle) *Handle = INVALID_HANDLE_VALUE;
-  if (overlapped) ((IO_STATUS_BLOCK *) overlapped)->u.Status = STATUS_PENDING;
+  struct addr_change_request *request;
+
+  TRACE("(Handle %p, overlapped %p)\n", Handle, overlapped);
+
+  if (!overlapped)
+  {
+    OVERLAPPED ov;
+    DWORD ret;
+
+    memset(&ov, 0, sizeof(ov));
+    if (!(ov.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL))) return GetLastError();
+    ret = NotifyAddrChange(NULL, &ov);
+    if (ret == ERROR_IO_PENDING)
+    {
+      WaitForSingleObject(ov.hEvent, INFINITE);
+      ret = RtlNtStatusToDosError(ov.Internal);
+    }
+    CloseHandle(ov.hEvent);
+    return ret;
+  }
+
+  if (!start_interface_monitor())
+    FIXME("address changes can't be monitored on this platform\n");
+
+  if (!(request = HeapAlloc(GetProcessHeap(), 0, sizeof(*request))))
+    return ERROR_NOT_ENOUGH_MEMORY;
+  request->overlapped = overlapped;
+  overlapped->Internal = STATUS_PENDING;
+  overlapped->InternalHigh = 0;
+
+  EnterCriticalSection(&change_cs);
+  if (!addr_change_event) addr_change_event = CreateEventW(NULL, TRUE, FALSE, NULL);
+  else if (list_empty(&addr_change_requests)) ResetEvent(addr_change_event);
+  list_add_tail(&addr_change_requests, &request->entry);
+  LeaveCriticalSection(&change_cs);
+
+  if (Handle) *Handle = addr_change_event;
+  SetLastError(ERROR_IO_PENDING);
   return ERROR_IO_PENDING;
 }
 
 
+static DWORD WINAPI interface_change_init_proc(void *arg)
+{
+    struct interface_change_callback *cb;
+
+    EnterCriticalSection(&change_cs);
+    LIST_FOR_EACH_ENTRY(cb, &interface_change_callbacks, struct interface_change_callback, entry)
+    {
+        if (cb != arg) continue;
+        cb->callback(cb->context, NULL, MibInitialNotification);
+        break;
+    }
+    LeaveCriticalSection(&change_cs);
+    return 0;
+}
+
 /******************************************************************
  *    NotifyIpInterfaceChange (IPHLPAPI.@)
  */
 DWORD WINAPI NotifyIpInterfaceChange(ADDRESS_FAMILY family, PIPINTERFACE_CHANGE_CALLBACK callback,
                                      PVOID context, BOOLEAN init_notify, PHANDLE handle)
 {
-    FIXME("(family %d, callback %p, context %p, init_notify %d, handle %p): stub\n",
+    struct interface_change_callback *cb;
+
+    TRACE("(family %d, callback %p, context %p, init_notify %d, handle %p)\n",
           family, callback, context, init_notify, handle);
-    if (handle) *handle = NULL;
-    return ERROR_NOT_SUPPORTED;
+
+    if (!callback || !handle) return ERROR_INVALID_PARAMETER;
+    if (family != WS_AF_UNSPEC && family != WS_AF_INET && family != WS_AF_INET6)
+        return ERROR_INVALID_PARAMETER;
+    *handle = NULL;
+
+    if (!start_interface_monitor())
+    {
+        FIXME("interface changes can't be monitored on this platform\n");
+        return ERROR_NOT_SUPPORTED;
+    }
+
+    if (!(cb = HeapAlloc(GetProcessHeap(), 0, sizeof(*cb)))) return ERROR_NOT_ENOUGH_MEMORY;
+    cb->family   = family;
+    cb->callback = callback;
+    cb->context  = context;
+
+    EnterCriticalSection(&change_cs);
+    list_add_tail(&interface_change_callbacks, &cb->entry);
+    LeaveCriticalSection(&change_cs);
+
+    if (init_notify) QueueUserWorkItem(interface_change_init_proc, cb, WT_EXECUTEDEFAULT);
+
+    *handle = cb;
+    return NO_ERROR;
 }
 
 
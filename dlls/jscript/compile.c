@@ -279,6 +279,55 @@ static HRESULT push_instr_bstr(compiler_ctx_t *ctx, jsop_t op, const WCHAR *arg)
     return S_OK;
 }
 
+static unsigned alloc_prop_cache(compiler_ctx_t *ctx, const WCHAR *name)
+{
+    prop_cache_t *cache;
+
+    if(!ctx->code->prop_cache_size) {
+        ctx->code->prop_caches = heap_alloc(8 * sizeof(*ctx->code->prop_caches));
+        if(!ctx->code->prop_caches)
+            return -1;
+        ctx->code->prop_cache_size = 8;
+    }else if(ctx->code->prop_cache_size == ctx->code->prop_cache_cnt) {
+        prop_cache_t *new_caches;
+
+        new_caches = heap_realloc(ctx->code->prop_caches, ctx->code->prop_cache_size*2*sizeof(*new_caches));
+        if(!new_caches)
+            return -1;
+
+        ctx->code->prop_caches = new_caches;
+        ctx->code->prop_cache_size *= 2;
+    }
+
+    cache = ctx->code->prop_caches + ctx->code->prop_cache_cnt;
+    cache->hash = string_hash(name);
+    cache->id = 0;
+    return ctx->code->prop_cache_cnt++;
+}
+
+/* Pushes an instruction taking a property name and its lookup cache slot. */
+static HRESULT push_instr_bstr_cache(compiler_ctx_t *ctx, jsop_t op, const WCHAR *arg)
+{
+    unsigned instr, cache;
+    WCHAR *str;
+
+    str = compiler_alloc_bstr(ctx, arg);
+    if(!str)
+        return E_OUTOFMEMORY;
+
+    cache = alloc_prop_cache(ctx, arg);
+    if(cache == -1)
+        return E_OUTOFMEMORY;
+
+    instr = push_instr(ctx, op);
+    if(!instr)
+        return E_OUTOFMEMORY;
+
+    instr_ptr(ctx, instr)->u.arg[0].bstr = str;
+    instr_ptr(ctx, instr)->u.arg[1].uint = cache;
+    return S_OK;
+}
+
 static HRESULT push_instr_bstr_uint(compiler_ctx_t *ctx, jsop_t op, const WCHAR *arg1, unsigned arg2)
 {
     unsigned instr;
@@ -379,7 +428,7 @@ static HRESULT compile_member_expression(compiler_ctx_t *ctx, member_expression_
     if(FAILED(hres))
         return hres;
 
-    return push_instr_bstr(ctx, OP_member, expr->identifier);
+    return push_instr_bstr_cache(ctx, OP_member, expr->identifier);
 }
 
 #define LABEL_FLAG 0x80000000
@@ -447,7 +496,7 @@ static HRESULT emit_identifier(compiler_ctx_t *ctx, const WCHAR *identifier)
     int local_ref;
     if(bind_local(ctx, identifier, &local_ref))
         return push_instr_int(ctx, OP_local, local_ref);
-    return push_instr_bstr(ctx, OP_ident, identifier);
+    return push_instr_bstr_cache(ctx, OP_ident, identifier);
 }
 
 static HRESULT compile_memberid_expression(compiler_ctx_t *ctx, expression_t *expr, unsigned flags)
@@ -2239,6 +2288,7 @@ void release_bytecode(bytecode_t *code)
     heap_pool_free(&code->heap);
     heap_free(code->bstr_pool);
     heap_free(code->str_pool);
+    heap_free(code->prop_caches);
     heap_free(code->instrs);
     heap_free(code);
 }
@@ -113,14 +113,6 @@ static const builtin_prop_t *find_builtin_prop(jsdisp_t *This, const WCHAR *name
     return NULL;
 }
 
-static inline unsigned string_hash(const WCHAR *name)
-{
-    unsigned h = 0;
-    for(; *name; name++)
-        h = (h>>(sizeof(unsigned)*8-4)) ^ (h<<4) ^ tolowerW(*name);
-    return h;
-}
-
 static inline unsigned get_props_idx(jsdisp_t *This, unsigned hash)
 {
     return (hash*GOLDEN_RATIO) & (This->buf_size-1);
@@ -1050,6 +1042,39 @@ HRESULT jsdisp_get_id(jsdisp_t *jsdisp, const WCHAR *name, DWORD flags, DISPID *
     return DISP_E_UNKNOWNNAME;
 }
 
+/*
+ * Same as jsdisp_get_id(), but first checks the slot remembered by the calling
+ * site. Objects built by the same code tend to store the same properties in the
+ * same order, so the slot is usually right even for a different object. The
+ * slot is only trusted if it still holds a live property of the given name,
+ * so a wrong guess just costs one string comparison.
+ */
+HRESULT jsdisp_get_cached_id(jsdisp_t *jsdisp, const WCHAR *name, prop_cache_t *cache, DISPID *id)
+{
+    dispex_prop_t *prop;
+    HRESULT hres;
+
+    if(cache->id > 0 && cache->id < jsdisp->prop_cnt) {
+        prop = jsdisp->props + cache->id;
+        if(prop->hash == cache->hash && prop->type != PROP_DELETED && !strcmpW(prop->name, name)) {
+            *id = cache->id;
+            return S_OK;
+        }
+    }
+
+    hres = find_prop_name_prot(jsdisp, cache->hash, name, &prop);
+    if(FAILED(hres))
+        return hres;
+
+    if(prop && prop->type!=PROP_DELETED) {
+        *id = cache->id = prop_to_id(jsdisp, prop);
+        return S_OK;
+    }
+
+    TRACE("not found %s\n", debugstr_w(name));
+    return DISP_E_UNKNOWNNAME;
+}
+
 HRESULT jsdisp_call_value(jsdisp_t *jsfunc, IDispatch *jsthis, WORD flags, unsigned argc, jsval_t *argv, jsval_t *r)
 {
     HRESULT hres;
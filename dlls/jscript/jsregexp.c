@@ -34,6 +34,19 @@ typedef struct {
     jsval_t last_index_val;
 } RegExpInstance;
 
+/*
+ * Scripts tend to evaluate the same regexp literals over and over in loops,
+ * so compiled programs are kept per script context and shared between
+ * RegExp instances with the same source and flags.
+ */
+#define REGEXP_CACHE_SIZE 32
+
+struct regexp_cache_entry_t {
+    jsstr_t *src;
+    DWORD flags;
+    regexp_t *regexp;
+};
+
 static const WCHAR sourceW[] = {'s','o','u','r','c','e',0};
 static const WCHAR globalW[] = {'g','l','o','b','a','l',0};
 static const WCHAR ignoreCaseW[] = {'i','g','n','o','r','e','C','a','s','e',0};
@@ -599,7 +612,7 @@ static void RegExp_destructor(jsdisp_t *dispex)
     RegExpInstance *This = regexp_from_jsdisp(dispex);
 
     if(This->jsregexp)
-        regexp_destroy(This->jsregexp);
+        regexp_release(This->jsregexp);
     jsval_release(This->last_index_val);
     jsstr_release(This->str);
     heap_free(This);
@@ -665,8 +678,65 @@ static HRESULT alloc_regexp(script_ctx_t *ctx, jsdisp_t *object_prototype, RegEx
     return S_OK;
 }
 
+static struct regexp_cache_entry_t *find_regexp_cache(script_ctx_t *ctx, jsstr_t *src, DWORD flags)
+{
+    struct regexp_cache_entry_t *entry;
+
+    if(!ctx->regexp_cache)
+        return NULL;
+
+    for(entry = ctx->regexp_cache; entry < ctx->regexp_cache + REGEXP_CACHE_SIZE; entry++) {
+        if(entry->regexp && entry->flags == flags && jsstr_eq(entry->src, src))
+            return entry;
+    }
+
+    return NULL;
+}
+
+static void add_regexp_cache(script_ctx_t *ctx, jsstr_t *src, DWORD flags, regexp_t *regexp)
+{
+    struct regexp_cache_entry_t *entry;
+
+    if(!ctx->regexp_cache) {
+        ctx->regexp_cache = heap_alloc_zero(REGEXP_CACHE_SIZE * sizeof(*ctx->regexp_cache));
+        if(!ctx->regexp_cache)
+            return;
+    }
+
+    entry = ctx->regexp_cache + ctx->regexp_cache_next;
+    ctx->regexp_cache_next = (ctx->regexp_cache_next + 1) % REGEXP_CACHE_SIZE;
+
+    if(entry->regexp) {
+        regexp_release(entry->regexp);
+        jsstr_release(entry->src);
+    }
+
+    entry->src = jsstr_addref(src);
+    entry->flags = flags;
+    entry->regexp = regexp_addref(regexp);
+}
+
+void release_regexp_cache(script_ctx_t *ctx)
+{
+    unsigned i;
+
+    if(!ctx->regexp_cache)
+        return;
+
+    for(i = 0; i < REGEXP_CACHE_SIZE; i++) {
+        if(ctx->regexp_cache[i].regexp) {
+            regexp_release(ctx->regexp_cache[i].regexp);
+            jsstr_release(ctx->regexp_cache[i].src);
+        }
+    }
+
+    heap_free(ctx->regexp_cache);
+    ctx->regexp_cache = NULL;
+}
+
 HRESULT create_regexp(script_ctx_t *ctx, jsstr_t *src, DWORD flags, jsdisp_t **ret)
 {
+    struct regexp_cache_entry_t *cache;
     RegExpInstance *regexp;
     const WCHAR *str;
     HRESULT hres;
@@ -681,14 +751,23 @@ HRESULT create_regexp(script_ctx_t *ctx, jsstr_t *src, DWORD flags, jsdisp_t **r
     if(FAILED(hres))
         return hres;
 
-    regexp->str = jsstr_addref(src);
     regexp->last_index_val = jsval_number(0);
 
-    regexp->jsregexp = regexp_new(ctx, &ctx->tmp_heap, str, jsstr_length(regexp->str), flags, FALSE);
-    if(!regexp->jsregexp) {
-        WARN("regexp_new failed\n");
-        jsdisp_release(&regexp->dispex);
-        return E_FAIL;
+    cache = find_regexp_cache(ctx, src, flags);
+    if(cache) {
+        /* The program points into the cached source, so share that string too. */
+        regexp->str = jsstr_addref(cache->src);
+        regexp->jsregexp = regexp_addref(cache->regexp);
+    }else {
+        regexp->str = jsstr_addref(src);
+        regexp->jsregexp = regexp_new(ctx, &ctx->tmp_heap, str, jsstr_length(regexp->str), flags, FALSE);
+        if(!regexp->jsregexp) {
+            WARN("regexp_new failed\n");
+            jsdisp_release(&regexp->dispex);
+            return E_FAIL;
+        }
+
+        add_regexp_cache(ctx, regexp->str, flags, regexp->jsregexp);
     }
 
     *ret = &regexp->dispex;
@@ -2318,6 +2318,31 @@ ReallocStateStack(REGlobalData *gData)
         }                                                                     \
     }while(0)
 
+/*
+ * Advance to the next position where the leading literal of the regexp can
+ * match, without going through SimpleMatch for every character. Return false
+ * if there is no such position.
+ */
+static inline BOOL
+SkipToFirstChar(REGlobalData *gData, match_state_t *x)
+{
+    const WCHAR *cp = x->cp;
+    WCHAR ch = gData->regexp->first_char;
+
+    if (gData->regexp->first_char_fold) {
+        ch = toupperW(ch);
+        while (cp < gData->cpend && toupperW(*cp) != ch)
+            cp++;
+    } else {
+        while (cp < gData->cpend && *cp != ch)
+            cp++;
+    }
+
+    gData->skipped += cp - x->cp;
+    x->cp = cp;
+    return cp != gData->cpend;
+}
+
 /*
  * Apply the current op against the given input to see if it's going to match
  * or fail. Return false if we don't get a match, true if we do. If updatecp is
@@ -2559,6 +2584,8 @@ ExecuteREBytecode(REGlobalData *gData, match_state_t *x)
     if (REOP_IS_SIMPLE(op) && !(gData->regexp->flags & REG_STICKY)) {
         anchor = FALSE;
         while (x->cp <= gData->cpend) {
+            if (gData->regexp->has_first_char && !SkipToFirstChar(gData, x))
+                break;
             nextpc = pc;    /* reset back to start each time */
             result = SimpleMatch(gData, x, op, &nextpc, TRUE);
             if (result) {
@@ -3178,6 +3205,46 @@ HRESULT regexp_execute(regexp_t *regexp, void *cx, heap_pool_t *pool,
     return S_OK;
 }
 
+/*
+ * If the program starts with a literal, remember its first character so
+ * that matching can quickly skip positions where it can't start.
+ */
+static void
+InitFirstChar(regexp_t *re)
+{
+    jsbytecode *pc = re->program;
+    REOp op = (REOp) *pc++;
+    size_t offset;
+
+    re->has_first_char = TRUE;
+    re->first_char_fold = FALSE;
+
+    switch (op) {
+      case REOP_FLATi:
+        re->first_char_fold = TRUE;
+        /* fall through */
+      case REOP_FLAT:
+        ReadCompactIndex(pc, &offset);
+        re->first_char = re->source[offset];
+        break;
+      case REOP_FLAT1i:
+        re->first_char_fold = TRUE;
+        /* fall through */
+      case REOP_FLAT1:
+        re->first_char = *pc;
+        break;
+      case REOP_UCFLAT1i:
+        re->first_char_fold = TRUE;
+        /* fall through */
+      case REOP_UCFLAT1:
+        re->first_char = GET_ARG(pc);
+        break;
+      default:
+        re->has_first_char = FALSE;
+        break;
+    }
+}
+
 void regexp_destroy(regexp_t *re)
 {
     if (re->classList) {
@@ -3277,10 +3344,12 @@ regexp_t* regexp_new(void *cx, heap_pool_t *pool, const WCHAR *str,
             re = tmp;
     }
 
+    re->ref = 1;
     re->flags = flags;
     re->parenCount = state.parenCount;
     re->source = str;
     re->source_len = str_len;
+    InitFirstChar(re);
 
 out:
     heap_pool_clear(mark);
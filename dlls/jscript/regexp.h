@@ -52,12 +52,16 @@ typedef struct match_state_t {
 typedef BYTE jsbytecode;
 
 typedef struct regexp_t {
+    LONG                ref;
     WORD                flags;         /* flags, see jsapi.h's REG_* defines */
     size_t              parenCount;    /* number of parenthesized submatches */
     size_t              classCount;    /* count [...] bitmaps */
     struct RECharSet    *classList;    /* list of [...] bitmaps */
     const WCHAR         *source;       /* locked source string, sans // */
     DWORD               source_len;
+    BOOL                has_first_char; /* every match starts with first_char */
+    BOOL                first_char_fold;
+    WCHAR               first_char;
     jsbytecode          program[1];    /* regular expression bytecode */
 } regexp_t;
 
@@ -66,6 +70,18 @@ void regexp_destroy(regexp_t*) DECLSPEC_HIDDEN;
 HRESULT regexp_execute(regexp_t*, void*, heap_pool_t*, const WCHAR*,
         DWORD, match_state_t*) DECLSPEC_HIDDEN;
 
+static inline regexp_t *regexp_addref(regexp_t *re)
+{
+    re->ref++;
+    return re;
+}
+
+static inline void regexp_release(regexp_t *re)
+{
+    if(!--re->ref)
+        regexp_destroy(re);
+}
+
 static inline match_state_t* alloc_match_state(regexp_t *regexp,
         heap_pool_t *pool, const WCHAR *pos)
 {
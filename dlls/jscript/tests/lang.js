@@ -1839,6 +1839,25 @@ ok(Object === 1, "Object = " + Object);
 Array = 1;
 ok(Array === 1, "Array = " + Array);
 
+(function() {
+    /* member and global lookups remember property slots per call site */
+    var a = {x: 1, y: 2}, b = {y: 3, x: 4}, c = {x: 5}, objs = [a, b, c, a, {}], i, r = "";
+
+    function get_x(o) { return o.x; }
+
+    for(i = 0; i < objs.length; i++)
+        r += get_x(objs[i]) + ",";
+    ok(r === "1,4,5,1,undefined,", "r = " + r);
+
+    delete a.x;
+    ok(get_x(a) === undefined, "get_x(a) = " + get_x(a));
+    Object.prototype.x = 6;
+    ok(get_x(a) === 6, "get_x(a) = " + get_x(a));
+    delete Object.prototype.x;
+    a.x = 7;
+    ok(get_x(a) === 7, "get_x(a) = " + get_x(a));
+})();
+
 Date = 1;
 ok(Date === 1, "Date = " + Date);
 
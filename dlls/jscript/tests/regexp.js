@@ -677,4 +677,20 @@ ok(re.ignoreCase === false, "re.ignoreCase = " + re.ignoreCase);
 ok(re.multiline === true, "re.multiline = " + re.multiline);
 ok(re.global === true, "re.global = " + re.global);
 
+for(i = 0; i < 3; i++) {
+    re = /ab+c/g;
+    ok(re.lastIndex === 0, "re.lastIndex = " + re.lastIndex);
+    m = re.exec("xxabbcabc");
+    ok(m[0] === "abbc", "m[0] = " + m[0]);
+    ok(re.lastIndex === 6, "re.lastIndex = " + re.lastIndex);
+}
+
+m = "xyzABCabc".match(/abc/gi);
+ok(m.length === 2, "m.length = " + m.length);
+ok(m[0] === "ABC", "m[0] = " + m[0]);
+m = "xyzABCabc".match(/abc/g);
+ok(m.length === 1, "m.length = " + m.length);
+ok(/q/.exec("abc") === null, "/q/.exec(\"abc\") is not null");
+ok("a,b,,c".split(/,/).length === 4, "split length = " + "a,b,,c".split(/,/).length);
+
 reportSuccess();
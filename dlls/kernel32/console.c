@@ -2257,7 +2257,7 @@ BOOL WINAPI SetConsoleMode(HANDLE hcon, DWORD mode)
  * WriteConsoleOutput helper: hides server call semantics
  * writes a string at a given pos with standard attribute
  */
-static int CONSOLE_WriteChars(HANDLE hCon, LPCWSTR lpBuffer, int nc, COORD* pos)
+static int CONSOLE_WriteChars(HANDLE hCon, LPCWSTR lpBuffer, int nc, COORD* pos, BOOL wrap)
 {
     int written = -1;
 
@@ -2269,7 +2269,7 @@ static int CONSOLE_WriteChars(HANDLE hCon, LPCWSTR lpBuffer, int nc, COORD* pos)
         req->x      = pos->X;
         req->y      = pos->Y;
         req->mode   = CHAR_INFO_MODE_TEXTSTDATTR;
-        req->wrap   = FALSE;
+        req->wrap   = wrap;
         wine_server_add_data( req, lpBuffer, nc * sizeof(WCHAR) );
         if (!wine_server_call_err( req )) written = reply->written;
     }
@@ -2335,7 +2335,7 @@ static BOOL write_block(HANDLE hCon, CONSOLE_SCREEN_BUFFER_INFO* csbi,
         {
             blk = min(len - done, csbi->dwSize.X - csbi->dwCursorPosition.X);
 
-            if (CONSOLE_WriteChars(hCon, ptr + done, blk, &csbi->dwCursorPosition) != blk)
+            if (CONSOLE_WriteChars(hCon, ptr + done, blk, &csbi->dwCursorPosition, FALSE) != blk)
                 return FALSE;
             if (csbi->dwCursorPosition.X == csbi->dwSize.X && !next_line(hCon, csbi))
                 return FALSE;
@@ -2354,7 +2354,7 @@ static BOOL write_block(HANDLE hCon, CONSOLE_SCREEN_BUFFER_INFO* csbi,
             blk = min(len - done, csbi->dwSize.X - csbi->dwCursorPosition.X);
 
             csbi->dwCursorPosition.X = pos;
-            if (CONSOLE_WriteChars(hCon, ptr + done, blk, &csbi->dwCursorPosition) != blk)
+            if (CONSOLE_WriteChars(hCon, ptr + done, blk, &csbi->dwCursorPosition, FALSE) != blk)
                 return FALSE;
         }
     }
@@ -2362,6 +2362,200 @@ static BOOL write_block(HANDLE hCon, CONSOLE_SCREEN_BUFFER_INFO* csbi,
     return TRUE;
 }
 
+/* WriteConsoleW helper: the output is laid out in a local copy of the rows it
+ * touches, and sent to the screen buffer with a single scroll and a few writes
+ * instead of a write and a scroll for each line.
+ */
+#define WRITE_BATCH_MAX_ROWS 256
+
+struct write_batch
+{
+    HANDLE                      handle;
+    CONSOLE_SCREEN_BUFFER_INFO *csbi;
+    int                         x;        /* cursor position */
+    int                         y;        /* rows past the end of the buffer are scrolled in on flush */
+    int                         top;      /* first row of the batch */
+    int                         max_rows;
+    WCHAR                      *text;     /* contents of rows [top, y] */
+    BYTE                       *dirty;    /* cells written to */
+};
+
+/******************************************************************
+ *		batch_new_row
+ *
+ * write_batch helper: clears the row at the cursor position.
+ * Rows already in the screen buffer are left unknown, the scrolled in ones are blank.
+ */
+static void batch_new_row(struct write_batch *batch)
+{
+    int width = batch->csbi->dwSize.X, i;
+    int pos = (batch->y - batch->top) * width;
+
+    memset(batch->dirty + pos, 0, width);
+    if (batch->y < batch->csbi->dwSize.Y) return;
+    for (i = 0; i < width; i++) batch->text[pos + i] = ' ';
+}
+
+/******************************************************************
+ *		batch_init
+ */
+static BOOL batch_init(struct write_batch *batch, HANDLE hCon, CONSOLE_SCREEN_BUFFER_INFO *csbi, DWORD len)
+{
+    int cells;
+
+    /* a character moves the cursor by one row at most */
+    batch->max_rows = min(min(csbi->dwSize.Y, WRITE_BATCH_MAX_ROWS), len + 1);
+    cells = batch->max_rows * csbi->dwSize.X;
+    if (!(batch->text = HeapAlloc(GetProcessHeap(), 0, cells * (sizeof(WCHAR) + 1)))) return FALSE;
+    batch->dirty = (BYTE *)(batch->text + cells);
+    batch->handle = hCon;
+    batch->csbi = csbi;
+    batch->x = csbi->dwCursorPosition.X;
+    batch->y = batch->top = csbi->dwCursorPosition.Y;
+    batch_new_row(batch);
+    return TRUE;
+}
+
+/******************************************************************
+ *		batch_flush
+ *
+ * write_batch helper: scrolls the screen buffer for the rows added past its
+ * end, then writes the runs of modified cells.
+ */
+static BOOL batch_flush(struct write_batch *batch)
+{
+    CONSOLE_SCREEN_BUFFER_INFO *csbi = batch->csbi;
+    int width = csbi->dwSize.X, height = csbi->dwSize.Y;
+    int scroll = max(0, batch->y - (height - 1));
+    int count = (batch->y - batch->top + 1) * width;
+    int i, start, end;
+    COORD pos;
+
+    if (scroll)
+    {
+        SMALL_RECT src;
+        CHAR_INFO  ci;
+        COORD      dst;
+
+        src.Top    = scroll;
+        src.Bottom = height - 1;
+        src.Left   = 0;
+        src.Right  = width - 1;
+        dst.X      = 0;
+        dst.Y      = 0;
+        ci.Attributes = csbi->wAttributes;
+        ci.Char.UnicodeChar = ' ';
+        if (!ScrollConsoleScreenBufferW(batch->handle, &src, NULL, dst, &ci))
+            return FALSE;
+    }
+
+    /* rows scrolled out of the buffer don't need to be written */
+    i = max(0, scroll - batch->top) * width;
+    while (i < count)
+    {
+        while (i < count && !batch->dirty[i]) i++;
+        if (i == count) break;
+
+        /* a run can span the unmodified cells of scrolled in rows, as they are blank */
+        for (start = end = i; i < count; i++)
+        {
+            if (batch->dirty[i]) end = i + 1;
+            else if (batch->top + i / width < height) break;
+        }
+        pos.X = start % width;
+        pos.Y = batch->top + start / width - scroll;
+        if (CONSOLE_WriteChars(batch->handle, batch->text + start, end - start, &pos, TRUE) != end - start)
+            return FALSE;
+    }
+
+    csbi->dwCursorPosition.X = batch->x;
+    csbi->dwCursorPosition.Y = batch->y - scroll;
+    batch->y = batch->top = csbi->dwCursorPosition.Y;
+    batch_new_row(batch);
+    return TRUE;
+}
+
+/******************************************************************
+ *		batch_next_line
+ */
+static BOOL batch_next_line(struct write_batch *batch)
+{
+    if (batch->y - batch->top + 1 == batch->max_rows && !batch_flush(batch))
+        return FALSE;
+    batch->x = 0;
+    batch->y++;
+    batch_new_row(batch);
+    return TRUE;
+}
+
+/******************************************************************
+ *		batch_write
+ *
+ * write_batch helper: writes a block of non special characters, wrapping at
+ * the end of the line.
+ */
+static BOOL batch_write(struct write_batch *batch, LPCWSTR ptr, int len)
+{
+    int width = batch->csbi->dwSize.X, pos;
+
+    while (len-- > 0)
+    {
+        pos = (batch->y - batch->top) * width + batch->x;
+        batch->text[pos] = *ptr++;
+        batch->dirty[pos] = TRUE;
+        if (++batch->x == width && !batch_next_line(batch))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/******************************************************************
+ *		write_console_batched
+ *
+ * WriteConsoleW helper for wrapping output.
+ */
+static DWORD write_console_batched(struct write_batch *batch, DWORD mode, LPCWSTR psz, DWORD len)
+{
+    DWORD i, nw = 0;
+
+    for (i = 0; i < len; i++)
+    {
+        if (!(mode & ENABLE_PROCESSED_OUTPUT))
+        {
+            if (!batch_write(batch, psz + i, 1)) break;
+            nw++;
+            continue;
+        }
+        switch (psz[i])
+        {
+        case '\b':
+            if (batch->x > 0) batch->x--;
+            break;
+        case '\t':
+            {
+                static const WCHAR tmp[] = {' ',' ',' ',' ',' ',' ',' ',' '};
+                if (!batch_write(batch, tmp, ((batch->x + 8) & ~7) - batch->x))
+                    return nw;
+            }
+            break;
+        case '\n':
+            if (!batch_next_line(batch)) return nw;
+            break;
+        case '\a':
+            Beep(400, 300);
+            break;
+        case '\r':
+            batch->x = 0;
+            break;
+        default:
+            if (!batch_write(batch, psz + i, 1)) return nw;
+            break;
+        }
+        nw++;
+    }
+    return nw;
+}
+
 /***********************************************************************
  *            WriteConsoleW   (KERNEL32.@)
  */
@@ -2372,6 +2566,7 @@ BOOL WINAPI WriteConsoleW(HANDLE hConsoleOutput, LPCVOID lpBuffer, DWORD nNumber
     DWORD			nw = 0;
     const WCHAR*		psz = lpBuffer;
     CONSOLE_SCREEN_BUFFER_INFO	csbi;
+    struct write_batch		batch;
     int				k, first = 0, fd;
 
     TRACE("%p %s %d %p %p\n",
@@ -2426,6 +2621,15 @@ BOOL WINAPI WriteConsoleW(HANDLE hConsoleOutput, LPCVOID lpBuffer, DWORD nNumber
 
     if (!nNumberOfCharsToWrite) return TRUE;
 
+    if ((mode & ENABLE_WRAP_AT_EOL_OUTPUT) &&
+        batch_init(&batch, hConsoleOutput, &csbi, nNumberOfCharsToWrite))
+    {
+        nw = write_console_batched(&batch, mode, psz, nNumberOfCharsToWrite);
+        if (!batch_flush(&batch)) nw = 0;
+        HeapFree(GetProcessHeap(), 0, batch.text);
+        goto the_end;
+    }
+
     if (mode & ENABLE_PROCESSED_OUTPUT)
     {
 	unsigned int	i;
@@ -27,6 +27,21 @@
 #include <errno.h>
 #include <stdio.h>
 #include <stdarg.h>
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#ifdef HAVE_SYS_IOCTL_H
+# include <sys/ioctl.h>
+#endif
+#ifdef HAVE_SYS_SENDFILE_H
+# include <sys/sendfile.h>
+#endif
+#ifdef HAVE_SYS_SYSCALL_H
+# include <sys/syscall.h>
+#endif
+#ifdef HAVE_LINUX_FS_H
+# include <linux/fs.h>
+#endif
 
 #include "winerror.h"
 #include "ntstatus.h"
@@ -1149,6 +1164,115 @@ BOOL WINAPI CopyFileA( LPCSTR source, LPCSTR dest, BOOL fail_if_exists)
 }
 
 
+#define COPY_CHUNK_SIZE (8 * 1024 * 1024)
+
+enum copy_method
+{
+    COPY_METHOD_COPY_FILE_RANGE,
+    COPY_METHOD_SENDFILE,
+    COPY_METHOD_BUFFER
+};
+
+/* copy the whole file at once by sharing its extents, on filesystems that support it */
+static BOOL clone_file_data( int fd1, int fd2 )
+{
+#ifdef FICLONE
+    return !ioctl( fd2, FICLONE, fd1 );
+#else
+    return FALSE;
+#endif
+}
+
+/* copy up to count bytes directly between the unix fds, starting at their current positions;
+ * return the number of bytes copied, or -1 if the caller needs to copy the data itself */
+static LONGLONG copy_unix_data( int fd1, int fd2, ULONGLONG count, enum copy_method *method )
+{
+    ULONGLONG total = 0;
+    ssize_t ret = -1;
+
+    while (total < count)
+    {
+        size_t size = min( count - total, 0x40000000 );
+
+        switch (*method)
+        {
+        case COPY_METHOD_COPY_FILE_RANGE:
+#ifdef __NR_copy_file_range
+            ret = syscall( __NR_copy_file_range, fd1, NULL, fd2, NULL, size, 0 );
+            break;
+#endif
+            /* fall through */
+        case COPY_METHOD_SENDFILE:
+#ifdef HAVE_SYS_SENDFILE_H
+            *method = COPY_METHOD_SENDFILE;
+            ret = sendfile( fd2, fd1, NULL, size );
+            break;
+#endif
+            /* fall through */
+        case COPY_METHOD_BUFFER:
+            *method = COPY_METHOD_BUFFER;
+            return total ? total : -1;
+        }
+
+        if (ret > 0) total += ret;
+        else if (!ret) break;  /* end of file */
+        else if (errno != EINTR)
+        {
+            /* nothing has been written for this call, let the next method retry it */
+            TRACE( "method %u failed, errno %d\n", *method, errno );
+            (*method)++;
+        }
+    }
+    return total;
+}
+
+/* copy up to count bytes through a user space buffer; return FALSE on error */
+static BOOL copy_buffer_data( HANDLE h1, HANDLE h2, char *buffer, DWORD buffer_size,
+                              ULONGLONG count, ULONGLONG *copied )
+{
+    DWORD size, res;
+    char *p;
+
+    *copied = 0;
+    while (*copied < count)
+    {
+        if (!ReadFile( h1, buffer, min( count - *copied, buffer_size ), &size, NULL )) return FALSE;
+        if (!size) break;
+        for (p = buffer; size; p += res, size -= res, *copied += res)
+            if (!WriteFile( h2, p, size, &res, NULL ) || !res) return FALSE;
+    }
+    return TRUE;
+}
+
+/* report the copy progress; return FALSE if the copy is to be aborted */
+static BOOL report_copy_progress( LPPROGRESS_ROUTINE *progress, LPVOID param, LPBOOL cancel_ptr,
+                                  LARGE_INTEGER size, LARGE_INTEGER transferred, DWORD reason,
+                                  HANDLE h1, HANDLE h2, BOOL *remove )
+{
+    if (cancel_ptr && *cancel_ptr)
+    {
+        *remove = TRUE;
+        SetLastError( ERROR_REQUEST_ABORTED );
+        return FALSE;
+    }
+    if (!*progress) return TRUE;
+
+    switch ((*progress)( size, transferred, size, transferred, 1, reason, h1, h2, param ))
+    {
+    case PROGRESS_QUIET:
+        *progress = NULL;
+        return TRUE;
+    case PROGRESS_CANCEL:
+        *remove = TRUE;
+        /* fall through */
+    case PROGRESS_STOP:
+        SetLastError( ERROR_REQUEST_ABORTED );
+        return FALSE;
+    default:
+        return TRUE;
+    }
+}
+
 /**************************************************************************
  *           CopyFileExW   (KERNEL32.@)
  */
@@ -1159,20 +1283,19 @@ BOOL WINAPI CopyFileExW(LPCWSTR source, LPCWSTR dest,
     static const int buffer_size = 65536;
     HANDLE h1, h2;
     BY_HANDLE_FILE_INFORMATION info;
-    DWORD count;
-    BOOL ret = FALSE;
-    char *buffer;
+    LARGE_INTEGER size, transferred;
+    enum copy_method method = COPY_METHOD_COPY_FILE_RANGE;
+    ULONGLONG count;
+    LONGLONG res;
+    int fd1 = -1, fd2 = -1;
+    BOOL ret = FALSE, remove = FALSE;
+    char *buffer = NULL;
 
     if (!source || !dest)
     {
         SetLastError(ERROR_INVALID_PARAMETER);
         return FALSE;
     }
-    if (!(buffer = HeapAlloc( GetProcessHeap(), 0, buffer_size )))
-    {
-        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
-        return FALSE;
-    }
 
     TRACE("%s -> %s, %x\n", debugstr_w(source), debugstr_w(dest), flags);
 
@@ -1181,14 +1304,12 @@ BOOL WINAPI CopyFileExW(LPCWSTR source, LPCWSTR dest,
                      NULL, OPEN_EXISTING, 0, 0)) == INVALID_HANDLE_VALUE)
     {
         WARN("Unable to open source %s\n", debugstr_w(source));
-        HeapFree( GetProcessHeap(), 0, buffer );
         return FALSE;
     }
 
     if (!GetFileInformationByHandle( h1, &info ))
     {
         WARN("GetFileInformationByHandle returned error for %s\n", debugstr_w(source));
-        HeapFree( GetProcessHeap(), 0, buffer );
         CloseHandle( h1 );
         return FALSE;
     }
@@ -1205,38 +1326,78 @@ BOOL WINAPI CopyFileExW(LPCWSTR source, LPCWSTR dest,
         }
         if (same_file)
         {
-            HeapFree( GetProcessHeap(), 0, buffer );
             CloseHandle( h1 );
             SetLastError( ERROR_SHARING_VIOLATION );
             return FALSE;
         }
     }
 
-    if ((h2 = CreateFileW( dest, GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
-                             (flags & COPY_FILE_FAIL_IF_EXISTS) ? CREATE_NEW : CREATE_ALWAYS,
-                             info.dwFileAttributes, h1 )) == INVALID_HANDLE_VALUE)
+    /* the destination is deleted if the copy is cancelled, when sharing allows it */
+    if ((h2 = CreateFileW( dest, GENERIC_WRITE | DELETE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                           (flags & COPY_FILE_FAIL_IF_EXISTS) ? CREATE_NEW : CREATE_ALWAYS,
+                           info.dwFileAttributes, h1 )) == INVALID_HANDLE_VALUE &&
+        GetLastError() == ERROR_SHARING_VIOLATION)
+        h2 = CreateFileW( dest, GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                          (flags & COPY_FILE_FAIL_IF_EXISTS) ? CREATE_NEW : CREATE_ALWAYS,
+                          info.dwFileAttributes, h1 );
+    if (h2 == INVALID_HANDLE_VALUE)
     {
         WARN("Unable to open dest %s\n", debugstr_w(dest));
-        HeapFree( GetProcessHeap(), 0, buffer );
         CloseHandle( h1 );
         return FALSE;
     }
 
-    while (ReadFile( h1, buffer, buffer_size, &count, NULL ) && count)
+    size.u.LowPart = info.nFileSizeLow;
+    size.u.HighPart = info.nFileSizeHigh;
+    transferred.QuadPart = 0;
+    if (!report_copy_progress( &progress, param, cancel_ptr, size, transferred,
+                               CALLBACK_STREAM_SWITCH, h1, h2, &remove ))
+        goto done;
+
+    if (wine_server_handle_to_fd( h1, FILE_READ_DATA, &fd1, NULL ) ||
+        wine_server_handle_to_fd( h2, FILE_WRITE_DATA, &fd2, NULL ))
+        method = COPY_METHOD_BUFFER;
+    else if (size.QuadPart && clone_file_data( fd1, fd2 ))
+    {
+        TRACE("cloned %s bytes\n", wine_dbgstr_longlong(size.QuadPart));
+        ret = report_copy_progress( &progress, param, cancel_ptr, size, size,
+                                    CALLBACK_CHUNK_FINISHED, h1, h2, &remove );
+        goto done;
+    }
+
+    for (;;)
     {
-        char *p = buffer;
-        while (count != 0)
+        if (method == COPY_METHOD_BUFFER || (res = copy_unix_data( fd1, fd2, COPY_CHUNK_SIZE, &method )) == -1)
         {
-            DWORD res;
-            if (!WriteFile( h2, p, count, &res, NULL ) || !res) goto done;
-            p += res;
-            count -= res;
+            if (!buffer && !(buffer = HeapAlloc( GetProcessHeap(), 0, buffer_size )))
+            {
+                SetLastError( ERROR_NOT_ENOUGH_MEMORY );
+                goto done;
+            }
+            if (!copy_buffer_data( h1, h2, buffer, buffer_size, COPY_CHUNK_SIZE, &count )) goto done;
+            res = count;
         }
+        if (!res) break;
+        transferred.QuadPart += res;
+        if (transferred.QuadPart > size.QuadPart) size = transferred;
+        if (!report_copy_progress( &progress, param, cancel_ptr, size, transferred,
+                                   CALLBACK_CHUNK_FINISHED, h1, h2, &remove ))
+            goto done;
     }
     ret =  TRUE;
 done:
+    if (fd1 != -1) wine_server_release_fd( h1, fd1 );
+    if (fd2 != -1) wine_server_release_fd( h2, fd2 );
+    if (remove)
+    {
+        FILE_DISPOSITION_INFORMATION disp;
+        IO_STATUS_BLOCK io;
+
+        disp.DoDeleteFile = TRUE;
+        NtSetInformationFile( h2, &io, &disp, sizeof(disp), FileDispositionInformation );
+    }
     /* Maintain the timestamp of source file to destination file */
-    SetFileTime(h2, NULL, NULL, &info.ftLastWriteTime);
+    else SetFileTime(h2, NULL, NULL, &info.ftLastWriteTime);
     HeapFree( GetProcessHeap(), 0, buffer );
     CloseHandle( h1 );
     CloseHandle( h2 );
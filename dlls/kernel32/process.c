@@ -24,6 +24,7 @@
 #include <assert.h>
 #include <ctype.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <signal.h>
 #include <stdarg.h>
 #include <stdio.h>
@@ -1864,6 +1865,205 @@ static int get_process_cpu( const WCHAR *filename, const struct binary_info *bin
     return -1;
 }
 
+/* pre-started loader waiting to be handed the next process, enabled with WINEPROCESSPOOL */
+static int process_pool = -1;
+static int process_stub_fd = -1;
+static char *process_stub_winedebug;
+
+static CRITICAL_SECTION process_stub_section;
+static CRITICAL_SECTION_DEBUG process_stub_debug =
+{
+    0, 0, &process_stub_section,
+    { &process_stub_debug.ProcessLocksList, &process_stub_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": process_stub_section") }
+};
+static CRITICAL_SECTION process_stub_section = { &process_stub_debug, -1, 0, 0, 0, 0 };
+
+/***********************************************************************
+ *           start_process_stub
+ *
+ * Start a new loader that waits until a process is handed over to it.
+ * The process_stub_section must be held.
+ */
+static void start_process_stub( const char *winedebug )
+{
+    char *argv[3], stub_env[64], stub_arg[] = "--process-stub";
+    int fd[2];
+    pid_t pid;
+
+    if (socketpair( PF_UNIX, SOCK_STREAM, 0, fd ) == -1) return;
+
+    if (!(pid = fork()))  /* child */
+    {
+        if (!(pid = fork()))  /* grandchild */
+        {
+            close( fd[0] );
+            signal( SIGPIPE, SIG_DFL );
+            sprintf( stub_env, "WINEPROCESSSTUB=%u", fd[1] );
+            putenv( stub_env );
+            unsetenv( "WINEPRELOADRESERVE" );
+            if (winedebug) putenv( (char *)winedebug );
+            argv[0] = NULL;  /* replaced by the loader */
+            argv[1] = stub_arg;
+            argv[2] = NULL;
+            wine_exec_wine_binary( NULL, argv, getenv("WINELOADER") );
+            _exit(1);
+        }
+        _exit(pid == -1);
+    }
+
+    close( fd[1] );
+    if (pid != -1)
+    {
+        /* reap child */
+        pid_t wret;
+        do {
+            wret = waitpid(pid, NULL, 0);
+        } while (wret < 0 && errno == EINTR);
+    }
+    if (pid == -1)
+    {
+        close( fd[0] );
+        return;
+    }
+    fcntl( fd[0], F_SETFD, FD_CLOEXEC );
+    process_stub_fd = fd[0];
+    HeapFree( GetProcessHeap(), 0, process_stub_winedebug );
+    process_stub_winedebug = NULL;
+    if (winedebug && (process_stub_winedebug = HeapAlloc( GetProcessHeap(), 0, strlen(winedebug) + 1 )))
+        strcpy( process_stub_winedebug, winedebug );
+}
+
+/***********************************************************************
+ *           send_process_stub_data
+ */
+static BOOL send_process_stub_data( int fd, const void *data, size_t size )
+{
+    const char *ptr = data;
+    ssize_t ret;
+
+    while (size)
+    {
+        if ((ret = write( fd, ptr, size )) > 0)
+        {
+            ptr += ret;
+            size -= ret;
+            continue;
+        }
+        if (ret == -1 && errno == EINTR) continue;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/***********************************************************************
+ *           send_process_stub_fd
+ *
+ * Send a file descriptor to the process stub, along with the fd number it should use.
+ */
+static BOOL send_process_stub_fd( int socket, int target, int fd )
+{
+    struct msghdr msghdr;
+    struct iovec vec;
+    int ret;
+
+#ifdef HAVE_STRUCT_MSGHDR_MSG_ACCRIGHTS
+    msghdr.msg_accrights    = (void *)&fd;
+    msghdr.msg_accrightslen = sizeof(fd);
+#else  /* HAVE_STRUCT_MSGHDR_MSG_ACCRIGHTS */
+    char cmsg_buffer[256];
+    struct cmsghdr *cmsg;
+    msghdr.msg_control    = cmsg_buffer;
+    msghdr.msg_controllen = sizeof(cmsg_buffer);
+    msghdr.msg_flags      = 0;
+    cmsg = CMSG_FIRSTHDR( &msghdr );
+    cmsg->cmsg_len   = CMSG_LEN( sizeof(fd) );
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type  = SCM_RIGHTS;
+    *(int *)CMSG_DATA(cmsg) = fd;
+    msghdr.msg_controllen = cmsg->cmsg_len;
+#endif  /* HAVE_STRUCT_MSGHDR_MSG_ACCRIGHTS */
+
+    msghdr.msg_name    = NULL;
+    msghdr.msg_namelen = 0;
+    msghdr.msg_iov     = &vec;
+    msghdr.msg_iovlen  = 1;
+    vec.iov_base = (void *)&target;
+    vec.iov_len  = sizeof(target);
+
+    while ((ret = sendmsg( socket, &msghdr, 0 )) == -1 && errno == EINTR) ;
+    return ret == sizeof(target);
+}
+
+/***********************************************************************
+ *           hand_over_process_stub
+ *
+ * Hand the new process over to the pre-started loader, and start another
+ * one for the next time. Returns FALSE if the loader has to be started normally.
+ */
+static BOOL hand_over_process_stub( char **argv, unsigned int flags, int socketfd, int stdin_fd,
+                                    int stdout_fd, const char *unixdir, const char *winedebug )
+{
+    struct process_stub_info info;
+    char *data = NULL, *ptr;
+    unsigned int i;
+    BOOL ret = FALSE;
+
+    if (process_pool == -1)
+    {
+        const char *env = getenv( "WINEPROCESSPOOL" );
+        process_pool = env && atoi( env );
+    }
+    if (!process_pool || !argv) return FALSE;
+
+    EnterCriticalSection( &process_stub_section );
+
+    /* the debug channels are set up before the stub waits for a process */
+    if (process_stub_fd != -1 &&
+        (!winedebug != !process_stub_winedebug ||
+         (winedebug && strcmp( winedebug, process_stub_winedebug ))))
+    {
+        close( process_stub_fd );
+        process_stub_fd = -1;
+    }
+    if (process_stub_fd == -1) goto done;
+
+    info.flags  = (flags & (CREATE_NEW_PROCESS_GROUP | CREATE_NEW_CONSOLE | DETACHED_PROCESS)) ?
+                  PROCESS_STUB_DETACH : 0;
+    info.nb_fds = 1;
+    info.argc   = 0;
+    info.size   = (unixdir ? strlen( unixdir ) : 0) + 1;
+    for (i = 1; argv[i]; i++)
+    {
+        info.argc++;
+        info.size += strlen( argv[i] ) + 1;
+    }
+    if (!info.flags)
+    {
+        if (stdin_fd != -1) info.nb_fds++;
+        if (stdout_fd != -1) info.nb_fds++;
+    }
+    if (!(data = HeapAlloc( GetProcessHeap(), 0, info.size ))) goto done;
+    strcpy( data, unixdir ? unixdir : "" );
+    for (i = 1, ptr = data + strlen( data ) + 1; argv[i]; i++, ptr += strlen( ptr ) + 1)
+        strcpy( ptr, argv[i] );
+
+    ret = send_process_stub_data( process_stub_fd, &info, sizeof(info) ) &&
+          send_process_stub_fd( process_stub_fd, PROCESS_STUB_SERVER, socketfd ) &&
+          (info.flags || stdin_fd == -1 || send_process_stub_fd( process_stub_fd, 0, stdin_fd )) &&
+          (info.flags || stdout_fd == -1 || send_process_stub_fd( process_stub_fd, 1, stdout_fd )) &&
+          send_process_stub_data( process_stub_fd, data, info.size );
+    if (!ret) WARN( "failed to hand over the process, starting a new loader\n" );
+    close( process_stub_fd );
+    process_stub_fd = -1;
+
+done:
+    start_process_stub( winedebug );
+    LeaveCriticalSection( &process_stub_section );
+    HeapFree( GetProcessHeap(), 0, data );
+    return ret;
+}
+
 /***********************************************************************
  *           exec_loader
  */
@@ -1880,6 +2080,12 @@ static pid_t exec_loader( LPCWSTR cmd_line, unsigned int flags, int socketfd,
 
     if (!is_win64 ^ !(binary_info->flags & BINARY_FLAG_64BIT))
         loader = get_alternate_loader( &wineloader );
+    else if (!exec_only && binary_info->res_start == binary_info->res_end &&
+             hand_over_process_stub( argv, flags, socketfd, stdin_fd, stdout_fd, unixdir, winedebug ))
+    {
+        HeapFree( GetProcessHeap(), 0, argv );
+        return 0;
+    }
 
     if (exec_only || !(pid = fork()))  /* child */
     {
@@ -4014,13 +4220,71 @@ HRESULT WINAPI RegisterApplicationRecoveryCallback(APPLICATION_RECOVERY_CALLBACK
     return E_FAIL;
 }
 
+/* retrieve the NUMA node entries of the processor topology, to be freed by the caller */
+static SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *get_numa_nodes( DWORD *len )
+{
+    LOGICAL_PROCESSOR_RELATIONSHIP relationship = RelationNumaNode;
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *info;
+    NTSTATUS status;
+
+    *len = 0;
+    status = NtQuerySystemInformationEx( SystemLogicalProcessorInformationEx, &relationship,
+                                         sizeof(relationship), NULL, 0, len );
+    if (status != STATUS_INFO_LENGTH_MISMATCH || !*len) return NULL;
+    if (!(info = HeapAlloc( GetProcessHeap(), 0, *len ))) return NULL;
+    status = NtQuerySystemInformationEx( SystemLogicalProcessorInformationEx, &relationship,
+                                         sizeof(relationship), info, *len, len );
+    if (status)
+    {
+        HeapFree( GetProcessHeap(), 0, info );
+        return NULL;
+    }
+    return info;
+}
+
+/* find the processor mask of a NUMA node, and optionally the highest node number */
+static BOOL get_numa_node_mask( ULONG node, GROUP_AFFINITY *mask, ULONG *highest )
+{
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *info, *entry;
+    DWORD len, ofs;
+    BOOL found = FALSE;
+
+    if (highest) *highest = 0;
+    if (!(info = get_numa_nodes( &len )))
+    {
+        /* assume a single node with all the processors */
+        if (node) return FALSE;
+        if (mask)
+        {
+            SYSTEM_INFO si;
+
+            GetSystemInfo( &si );
+            memset( mask, 0, sizeof(*mask) );
+            mask->Mask = si.dwActiveProcessorMask;
+        }
+        return TRUE;
+    }
+
+    for (ofs = 0; ofs < len; ofs += entry->Size)
+    {
+        entry = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *)((char *)info + ofs);
+        if (highest && entry->NumaNode.NodeNumber > *highest) *highest = entry->NumaNode.NodeNumber;
+        if (entry->NumaNode.NodeNumber != node) continue;
+        if (mask) *mask = entry->NumaNode.GroupMask;
+        found = TRUE;
+    }
+    HeapFree( GetProcessHeap(), 0, info );
+    return found;
+}
+
 /**********************************************************************
  *           GetNumaHighestNodeNumber     (KERNEL32.@)
  */
 BOOL WINAPI GetNumaHighestNodeNumber(PULONG highestnode)
 {
-    *highestnode = 0;
-    FIXME("(%p): semi-stub\n", highestnode);
+    TRACE("(%p)\n", highestnode);
+
+    get_numa_node_mask( 0, NULL, highestnode );
     return TRUE;
 }
 
@@ -4029,9 +4293,17 @@ BOOL WINAPI GetNumaHighestNodeNumber(PULONG highestnode)
  */
 BOOL WINAPI GetNumaNodeProcessorMask(UCHAR node, PULONGLONG mask)
 {
-    FIXME("(%c %p): stub\n", node, mask);
-    SetLastError(ERROR_CALL_NOT_IMPLEMENTED);
-    return FALSE;
+    GROUP_AFFINITY affinity;
+
+    TRACE("(%u %p)\n", node, mask);
+
+    if (!get_numa_node_mask( node, &affinity, NULL ))
+    {
+        SetLastError( ERROR_INVALID_PARAMETER );
+        return FALSE;
+    }
+    *mask = affinity.Mask;
+    return TRUE;
 }
 
 /**********************************************************************
@@ -4039,9 +4311,14 @@ BOOL WINAPI GetNumaNodeProcessorMask(UCHAR node, PULONGLONG mask)
  */
 BOOL WINAPI GetNumaNodeProcessorMaskEx(USHORT node, PGROUP_AFFINITY mask)
 {
-    FIXME("(%hu %p): stub\n", node, mask);
-    SetLastError(ERROR_CALL_NOT_IMPLEMENTED);
-    return FALSE;
+    TRACE("(%hu %p)\n", node, mask);
+
+    if (!get_numa_node_mask( node, mask, NULL ))
+    {
+        SetLastError( ERROR_INVALID_PARAMETER );
+        return FALSE;
+    }
+    return TRUE;
 }
 
 /**********************************************************************
@@ -4059,7 +4336,9 @@ BOOL WINAPI GetNumaAvailableMemoryNode(UCHAR node, PULONGLONG available_bytes)
  */
 BOOL WINAPI GetNumaProcessorNode(UCHAR processor, PUCHAR node)
 {
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *info, *entry;
     SYSTEM_INFO si;
+    DWORD len, ofs;
 
     TRACE("(%d, %p)\n", processor, node);
 
@@ -4067,6 +4346,19 @@ BOOL WINAPI GetNumaProcessorNode(UCHAR processor, PUCHAR node)
     if (processor < si.dwNumberOfProcessors)
     {
         *node = 0;
+        if (processor < 8 * sizeof(KAFFINITY) && (info = get_numa_nodes( &len )))
+        {
+            for (ofs = 0; ofs < len; ofs += entry->Size)
+            {
+                entry = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *)((char *)info + ofs);
+                if (entry->NumaNode.GroupMask.Mask & ((KAFFINITY)1 << processor))
+                {
+                    *node = entry->NumaNode.NodeNumber;
+                    break;
+                }
+            }
+            HeapFree( GetProcessHeap(), 0, info );
+        }
         return TRUE;
     }
 
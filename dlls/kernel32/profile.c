@@ -50,13 +50,19 @@ typedef struct tagPROFILEKEY
 {
     WCHAR                 *value;
     struct tagPROFILEKEY  *next;
+    struct tagPROFILEKEY  *hash_next;  /* next key in the same hash bucket */
+    struct tagPROFILESECTION *section; /* section containing the key */
+    ULONG                  hash;
     WCHAR                  name[1];
 } PROFILEKEY;
 
 typedef struct tagPROFILESECTION
 {
     struct tagPROFILEKEY       *key;
+    struct tagPROFILEKEY       *last_key;
     struct tagPROFILESECTION   *next;
+    struct tagPROFILESECTION   *hash_next;  /* next section in the same hash bucket */
+    ULONG                       hash;
     WCHAR                       name[1];
 } PROFILESECTION;
 
@@ -68,13 +74,23 @@ typedef struct
     WCHAR           *filename;
     FILETIME LastWriteTime;
     ENCODING encoding;
+    PROFILESECTION **section_hash;  /* index of the sections by name */
+    PROFILEKEY     **key_hash;      /* index of the keys by section and name */
+    unsigned int     hash_size;     /* number of buckets of both indexes, a power of 2 */
+    unsigned int     nb_entries;    /* number of sections and keys in the indexes */
 } PROFILE;
 
 
-#define N_CACHED_PROFILES 10
+#define N_CACHED_PROFILES   64
+#define MAX_CACHED_PROFILES 1024
+#define MIN_HASH_SIZE       16
 
 /* Cached profile files */
-static PROFILE *MRUProfile[N_CACHED_PROFILES]={NULL};
+static PROFILE *MRUProfile[MAX_CACHED_PROFILES]={NULL};
+static unsigned int nb_cached_profiles = N_CACHED_PROFILES;
+
+/* Only write the changes back when the file is flushed or evicted from the cache */
+static BOOL lazy_flush;
 
 #define CurProfile (MRUProfile[0])
 
@@ -492,25 +508,244 @@ static PROFILESECTION *PROFILE_Load(HANDLE hFile, ENCODING * pEncoding)
 
 
 /***********************************************************************
- *           PROFILE_DeleteSection
+ *           PROFILE_Hash
  *
- * Delete a section from a profile tree.
+ * Case-insensitive hash of a section or key name.
+ */
+static inline ULONG PROFILE_Hash( LPCWSTR name, int len )
+{
+    ULONG hash = 0;
+
+    while (len--) hash = hash * 31 + tolowerW( *name++ );
+    return hash;
+}
+
+
+static inline PROFILESECTION **PROFILE_SectionBucket( const PROFILE *profile, ULONG hash )
+{
+    return &profile->section_hash[hash & (profile->hash_size - 1)];
+}
+
+
+static inline PROFILEKEY **PROFILE_KeyBucket( const PROFILE *profile,
+                                              const PROFILESECTION *section, ULONG hash )
+{
+    return &profile->key_hash[(hash + section->hash * 31) & (profile->hash_size - 1)];
+}
+
+
+/***********************************************************************
+ *           PROFILE_HashSection
+ *
+ * Add a section to the index. The buckets are kept in file order, so
+ * that the first one of several sections with the same name is found.
+ */
+static void PROFILE_HashSection( PROFILE *profile, PROFILESECTION *section )
+{
+    PROFILESECTION **entry;
+
+    section->hash = PROFILE_Hash( section->name, strlenW(section->name) );
+    section->hash_next = NULL;
+    if (!section->name[0]) return;  /* keys before the first section */
+
+    for (entry = PROFILE_SectionBucket( profile, section->hash ); *entry; entry = &(*entry)->hash_next) ;
+    *entry = section;
+    profile->nb_entries++;
+}
+
+
+/***********************************************************************
+ *           PROFILE_HashKey
+ *
+ * Add a key to the index, see PROFILE_HashSection.
  */
-static BOOL PROFILE_DeleteSection( PROFILESECTION **section, LPCWSTR name )
+static void PROFILE_HashKey( PROFILE *profile, PROFILESECTION *section, PROFILEKEY *key )
 {
-    while (*section)
+    PROFILEKEY **entry;
+
+    key->section = section;
+    key->hash = PROFILE_Hash( key->name, strlenW(key->name) );
+    key->hash_next = NULL;
+
+    for (entry = PROFILE_KeyBucket( profile, section, key->hash ); *entry; entry = &(*entry)->hash_next) ;
+    *entry = key;
+    profile->nb_entries++;
+}
+
+
+/***********************************************************************
+ *           PROFILE_FreeIndex
+ */
+static void PROFILE_FreeIndex( PROFILE *profile )
+{
+    HeapFree( GetProcessHeap(), 0, profile->section_hash );
+    HeapFree( GetProcessHeap(), 0, profile->key_hash );
+    profile->section_hash = NULL;
+    profile->key_hash = NULL;
+    profile->hash_size = 0;
+    profile->nb_entries = 0;
+}
+
+
+/***********************************************************************
+ *           PROFILE_BuildIndex
+ *
+ * (Re)build the section and key indexes of a profile tree. A size of 0
+ * picks one from the number of entries.
+ */
+static BOOL PROFILE_BuildIndex( PROFILE *profile, unsigned int size )
+{
+    PROFILESECTION **section_hash, *section;
+    PROFILEKEY **key_hash, *key;
+
+    if (!size)
     {
-        if ((*section)->name[0] && !strcmpiW( (*section)->name, name ))
+        unsigned int count = 0;
+
+        for (section = profile->section; section; section = section->next)
+            for (count++, key = section->key; key; key = key->next) count++;
+        for (size = MIN_HASH_SIZE; size < count; size *= 2) ;
+    }
+
+    section_hash = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, size * sizeof(*section_hash) );
+    key_hash = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, size * sizeof(*key_hash) );
+    if (!section_hash || !key_hash)
+    {
+        HeapFree( GetProcessHeap(), 0, section_hash );
+        HeapFree( GetProcessHeap(), 0, key_hash );
+        return FALSE;
+    }
+
+    PROFILE_FreeIndex( profile );
+    profile->section_hash = section_hash;
+    profile->key_hash = key_hash;
+    profile->hash_size = size;
+
+    for (section = profile->section; section; section = section->next)
+    {
+        PROFILE_HashSection( profile, section );
+        section->last_key = NULL;
+        for (key = section->key; key; key = key->next)
         {
-            PROFILESECTION *to_del = *section;
-            *section = to_del->next;
-            to_del->next = NULL;
-            PROFILE_Free( to_del );
-            return TRUE;
+            PROFILE_HashKey( profile, section, key );
+            section->last_key = key;
         }
-        section = &(*section)->next;
     }
-    return FALSE;
+    TRACE( "%u entries, %u buckets\n", profile->nb_entries, size );
+    return TRUE;
+}
+
+
+/* grow the indexes once they get too crowded */
+static inline void PROFILE_GrowIndex( PROFILE *profile )
+{
+    if (profile->nb_entries > 2 * profile->hash_size)
+        PROFILE_BuildIndex( profile, 2 * profile->hash_size );
+}
+
+
+/***********************************************************************
+ *           PROFILE_FindSection
+ *
+ * Find the first section named name[0..len-1] after prev, or from the
+ * start if prev is NULL.
+ */
+static PROFILESECTION *PROFILE_FindSection( const PROFILE *profile, const PROFILESECTION *prev,
+                                            LPCWSTR name, int len )
+{
+    ULONG hash = PROFILE_Hash( name, len );
+    PROFILESECTION *section = prev ? prev->hash_next : *PROFILE_SectionBucket( profile, hash );
+
+    for ( ; section; section = section->hash_next)
+    {
+        if (section->hash == hash && !strncmpiW( section->name, name, len ) && !section->name[len])
+            return section;
+    }
+    return NULL;
+}
+
+
+/***********************************************************************
+ *           PROFILE_FindKey
+ *
+ * Find the first key named name[0..len-1] in a section.
+ */
+static PROFILEKEY *PROFILE_FindKey( const PROFILE *profile, const PROFILESECTION *section,
+                                    LPCWSTR name, int len )
+{
+    ULONG hash = PROFILE_Hash( name, len );
+    PROFILEKEY *key = *PROFILE_KeyBucket( profile, section, hash );
+
+    for ( ; key; key = key->hash_next)
+    {
+        if (key->section == section && key->hash == hash &&
+            !strncmpiW( key->name, name, len ) && !key->name[len])
+            return key;
+    }
+    return NULL;
+}
+
+
+/***********************************************************************
+ *           PROFILE_RemoveKey
+ *
+ * Remove a key from its section and from the index, and free it.
+ */
+static void PROFILE_RemoveKey( PROFILE *profile, PROFILEKEY *key )
+{
+    PROFILESECTION *section = key->section;
+    PROFILEKEY **entry, *prev = NULL;
+
+    for (entry = &section->key; *entry != key; entry = &(*entry)->next) prev = *entry;
+    *entry = key->next;
+    if (section->last_key == key) section->last_key = prev;
+
+    for (entry = PROFILE_KeyBucket( profile, section, key->hash ); *entry != key; entry = &(*entry)->hash_next) ;
+    *entry = key->hash_next;
+    profile->nb_entries--;
+
+    HeapFree( GetProcessHeap(), 0, key->value );
+    HeapFree( GetProcessHeap(), 0, key );
+}
+
+
+/***********************************************************************
+ *           PROFILE_RemoveSection
+ *
+ * Remove a named section from the profile tree and the index, and free it.
+ */
+static void PROFILE_RemoveSection( PROFILE *profile, PROFILESECTION *section )
+{
+    PROFILESECTION **entry;
+
+    while (section->key) PROFILE_RemoveKey( profile, section->key );
+
+    for (entry = &profile->section; *entry != section; entry = &(*entry)->next) ;
+    *entry = section->next;
+    if (section->name[0])
+    {
+        for (entry = PROFILE_SectionBucket( profile, section->hash ); *entry != section; entry = &(*entry)->hash_next) ;
+        *entry = section->hash_next;
+        profile->nb_entries--;
+    }
+
+    section->next = NULL;
+    PROFILE_Free( section );
+}
+
+
+/***********************************************************************
+ *           PROFILE_DeleteSection
+ *
+ * Delete a section from a profile tree.
+ */
+static BOOL PROFILE_DeleteSection( PROFILE *profile, LPCWSTR name )
+{
+    PROFILESECTION *section;
+
+    if (!(section = PROFILE_FindSection( profile, NULL, name, strlenW(name) ))) return FALSE;
+    PROFILE_RemoveSection( profile, section );
+    return TRUE;
 }
 
 
@@ -519,28 +754,19 @@ static BOOL PROFILE_DeleteSection( PROFILESECTION **section, LPCWSTR name )
  *
  * Delete a key from a profile tree.
  */
-static BOOL PROFILE_DeleteKey( PROFILESECTION **section,
-			       LPCWSTR section_name, LPCWSTR key_name )
+static BOOL PROFILE_DeleteKey( PROFILE *profile, LPCWSTR section_name, LPCWSTR key_name )
 {
-    while (*section)
+    int seclen = strlenW( section_name ), keylen = strlenW( key_name );
+    PROFILESECTION *section = NULL;
+    PROFILEKEY *key;
+
+    while ((section = PROFILE_FindSection( profile, section, section_name, seclen )))
     {
-        if ((*section)->name[0] && !strcmpiW( (*section)->name, section_name ))
+        if ((key = PROFILE_FindKey( profile, section, key_name, keylen )))
         {
-            PROFILEKEY **key = &(*section)->key;
-            while (*key)
-            {
-                if (!strcmpiW( (*key)->name, key_name ))
-                {
-                    PROFILEKEY *to_del = *key;
-                    *key = to_del->next;
-                    HeapFree( GetProcessHeap(), 0, to_del->value);
-                    HeapFree( GetProcessHeap(), 0, to_del );
-                    return TRUE;
-                }
-                key = &(*key)->next;
-            }
+            PROFILE_RemoveKey( profile, key );
+            return TRUE;
         }
-        section = &(*section)->next;
     }
     return FALSE;
 }
@@ -553,34 +779,53 @@ static BOOL PROFILE_DeleteKey( PROFILESECTION **section,
  */
 static void PROFILE_DeleteAllKeys( LPCWSTR section_name)
 {
-    PROFILESECTION **section= &CurProfile->section;
-    while (*section)
+    int seclen = strlenW( section_name );
+    PROFILESECTION *section = NULL;
+
+    while ((section = PROFILE_FindSection( CurProfile, section, section_name, seclen )))
     {
-        if ((*section)->name[0] && !strcmpiW( (*section)->name, section_name ))
+        while (section->key)
         {
-            PROFILEKEY **key = &(*section)->key;
-            while (*key)
-            {
-                PROFILEKEY *to_del = *key;
-		*key = to_del->next;
-                HeapFree( GetProcessHeap(), 0, to_del->value);
-		HeapFree( GetProcessHeap(), 0, to_del );
-		CurProfile->changed =TRUE;
-            }
+            PROFILE_RemoveKey( CurProfile, section->key );
+            CurProfile->changed = TRUE;
         }
-        section = &(*section)->next;
     }
 }
 
 
+/***********************************************************************
+ *           PROFILE_NewKey
+ *
+ * Append a new key without value to a section.
+ */
+static PROFILEKEY *PROFILE_NewKey( PROFILE *profile, PROFILESECTION *section, LPCWSTR key_name )
+{
+    PROFILEKEY *key;
+
+    if (!(key = HeapAlloc( GetProcessHeap(), 0, sizeof(PROFILEKEY) + strlenW(key_name) * sizeof(WCHAR) )))
+        return NULL;
+    strcpyW( key->name, key_name );
+    key->value = NULL;
+    key->next  = NULL;
+    if (section->last_key) section->last_key->next = key;
+    else section->key = key;
+    section->last_key = key;
+    PROFILE_HashKey( profile, section, key );
+    PROFILE_GrowIndex( profile );
+    return key;
+}
+
+
 /***********************************************************************
  *           PROFILE_Find
  *
  * Find a key in a profile tree, optionally creating it.
  */
-static PROFILEKEY *PROFILE_Find( PROFILESECTION **section, LPCWSTR section_name,
+static PROFILEKEY *PROFILE_Find( PROFILE *profile, LPCWSTR section_name,
                                  LPCWSTR key_name, BOOL create, BOOL create_always )
 {
+    PROFILESECTION *section, **next;
+    PROFILEKEY *key;
     LPCWSTR p;
     int seclen, keylen;
 
@@ -602,94 +847,97 @@ static PROFILEKEY *PROFILE_Find( PROFILESECTION **section, LPCWSTR section_name,
     while ((p > key_name) && PROFILE_isspaceW(*p)) p--;
     keylen = p - key_name + 1;
 
-    while (*section)
+    if ((section = PROFILE_FindSection( profile, NULL, section_name, seclen )))
     {
-        if ( ((*section)->name[0])
-             && (!(strncmpiW( (*section)->name, section_name, seclen )))
-             && (((*section)->name)[seclen] == '\0') )
-        {
-            PROFILEKEY **key = &(*section)->key;
-
-            while (*key)
-            {
-                /* If create_always is FALSE then we check if the keyname
-                 * already exists. Otherwise we add it regardless of its
-                 * existence, to allow keys to be added more than once in
-                 * some cases.
-                 */
-                if(!create_always)
-                {
-                    if ( (!(strncmpiW( (*key)->name, key_name, keylen )))
-                         && (((*key)->name)[keylen] == '\0') )
-                        return *key;
-                }
-                key = &(*key)->next;
-            }
-            if (!create) return NULL;
-            if (!(*key = HeapAlloc( GetProcessHeap(), 0, sizeof(PROFILEKEY) + strlenW(key_name) * sizeof(WCHAR) )))
-                return NULL;
-            strcpyW( (*key)->name, key_name );
-            (*key)->value = NULL;
-            (*key)->next  = NULL;
-            return *key;
-        }
-        section = &(*section)->next;
+        /* If create_always is FALSE then we check if the keyname
+         * already exists. Otherwise we add it regardless of its
+         * existence, to allow keys to be added more than once in
+         * some cases.
+         */
+        if (!create_always && (key = PROFILE_FindKey( profile, section, key_name, keylen )))
+            return key;
+        if (!create) return NULL;
+        return PROFILE_NewKey( profile, section, key_name );
     }
     if (!create) return NULL;
-    *section = HeapAlloc( GetProcessHeap(), 0, sizeof(PROFILESECTION) + strlenW(section_name) * sizeof(WCHAR) );
-    if(*section == NULL) return NULL;
-    strcpyW( (*section)->name, section_name );
-    (*section)->next = NULL;
-    if (!((*section)->key  = HeapAlloc( GetProcessHeap(), 0,
-                                        sizeof(PROFILEKEY) + strlenW(key_name) * sizeof(WCHAR) )))
-    {
-        HeapFree(GetProcessHeap(), 0, *section);
-        return NULL;
-    }
-    strcpyW( (*section)->key->name, key_name );
-    (*section)->key->value = NULL;
-    (*section)->key->next  = NULL;
-    return (*section)->key;
+
+    section = HeapAlloc( GetProcessHeap(), 0, sizeof(PROFILESECTION) + strlenW(section_name) * sizeof(WCHAR) );
+    if(section == NULL) return NULL;
+    strcpyW( section->name, section_name );
+    section->key = section->last_key = NULL;
+    section->next = NULL;
+    for (next = &profile->section; *next; next = &(*next)->next) ;
+    *next = section;
+    PROFILE_HashSection( profile, section );
+
+    if (!(key = PROFILE_NewKey( profile, section, key_name )))
+        PROFILE_RemoveSection( profile, section );
+    return key;
 }
 
 
 /***********************************************************************
- *           PROFILE_FlushFile
+ *           PROFILE_FlushProfile
  *
- * Flush the current profile to disk if changed.
+ * Flush a profile to disk if changed.
  */
-static BOOL PROFILE_FlushFile(void)
+static BOOL PROFILE_FlushProfile( PROFILE *profile )
 {
     HANDLE hFile = NULL;
     FILETIME LastWriteTime;
 
-    if(!CurProfile)
-    {
-        WARN("No current profile!\n");
-        return FALSE;
-    }
+    if (!profile->changed) return TRUE;
 
-    if (!CurProfile->changed) return TRUE;
-
-    hFile = CreateFileW(CurProfile->filename, GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+    hFile = CreateFileW(profile->filename, GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
                         NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
 
     if (hFile == INVALID_HANDLE_VALUE)
     {
-        WARN("could not save profile file %s (error was %d)\n", debugstr_w(CurProfile->filename), GetLastError());
+        WARN("could not save profile file %s (error was %d)\n", debugstr_w(profile->filename), GetLastError());
         return FALSE;
     }
 
-    TRACE("Saving %s\n", debugstr_w(CurProfile->filename));
-    PROFILE_Save( hFile, CurProfile->section, CurProfile->encoding );
+    TRACE("Saving %s\n", debugstr_w(profile->filename));
+    PROFILE_Save( hFile, profile->section, profile->encoding );
     if(GetFileTime(hFile, NULL, NULL, &LastWriteTime))
-       CurProfile->LastWriteTime=LastWriteTime;
+       profile->LastWriteTime=LastWriteTime;
     CloseHandle( hFile );
-    CurProfile->changed = FALSE;
+    profile->changed = FALSE;
     return TRUE;
 }
 
 
+/***********************************************************************
+ *           PROFILE_FlushFile
+ *
+ * Flush the current profile to disk if changed.
+ */
+static BOOL PROFILE_FlushFile(void)
+{
+    if(!CurProfile)
+    {
+        WARN("No current profile!\n");
+        return FALSE;
+    }
+    return PROFILE_FlushProfile( CurProfile );
+}
+
+
+/***********************************************************************
+ *           PROFILE_FlushAll
+ *
+ * Flush all the cached profiles to disk, for the changes kept back
+ * with lazy flushing.
+ */
+static void PROFILE_FlushAll(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < nb_cached_profiles; i++)
+        if (MRUProfile[i] && MRUProfile[i]->filename) PROFILE_FlushProfile( MRUProfile[i] );
+}
+
+
 /***********************************************************************
  *           PROFILE_ReleaseFile
  *
@@ -699,6 +947,7 @@ static void PROFILE_ReleaseFile(void)
 {
     PROFILE_FlushFile();
     PROFILE_Free( CurProfile->section );
+    PROFILE_FreeIndex( CurProfile );
     HeapFree( GetProcessHeap(), 0, CurProfile->filename );
     CurProfile->changed = FALSE;
     CurProfile->section = NULL;
@@ -727,6 +976,56 @@ static BOOL is_not_current(FILETIME * ft)
     return ftll + 21000000 < nowll;
 }
 
+/***********************************************************************
+ *           PROFILE_GetOptions
+ *
+ * Read the cache settings from the registry.
+ */
+static void PROFILE_GetOptions(void)
+{
+    static const WCHAR profileW[] = {'S','o','f','t','w','a','r','e','\\',
+                                     'W','i','n','e','\\','P','r','o','f','i','l','e',0};
+    static const WCHAR cachesizeW[] = {'C','a','c','h','e','S','i','z','e',0};
+    static const WCHAR lazyflushW[] = {'L','a','z','y','F','l','u','s','h',0};
+    char tmp[80];
+    KEY_VALUE_PARTIAL_INFORMATION *info = (KEY_VALUE_PARTIAL_INFORMATION *)tmp;
+    HANDLE root, hkey;
+    DWORD dummy;
+    OBJECT_ATTRIBUTES attr;
+    UNICODE_STRING nameW;
+
+    RtlOpenCurrentUser( KEY_READ, &root );
+    InitializeObjectAttributes( &attr, &nameW, 0, root, NULL );
+    RtlInitUnicodeString( &nameW, profileW );
+
+    /* @@ Wine registry key: HKCU\Software\Wine\Profile */
+    if (!NtOpenKey( &hkey, KEY_READ, &attr ))
+    {
+        RtlInitUnicodeString( &nameW, cachesizeW );
+        if (!NtQueryValueKey( hkey, &nameW, KeyValuePartialInformation, tmp, sizeof(tmp) - sizeof(WCHAR), &dummy ))
+        {
+            DWORD size;
+
+            if (info->Type == REG_DWORD) size = *(DWORD *)info->Data;
+            else
+            {
+                ((WCHAR *)info->Data)[info->DataLength / sizeof(WCHAR)] = 0;
+                size = atoiW( (WCHAR *)info->Data );
+            }
+            nb_cached_profiles = max( 1, min( size, MAX_CACHED_PROFILES ));
+        }
+        RtlInitUnicodeString( &nameW, lazyflushW );
+        if (!NtQueryValueKey( hkey, &nameW, KeyValuePartialInformation, tmp, sizeof(tmp), &dummy ))
+        {
+            WCHAR ch = *(WCHAR *)info->Data;
+            lazy_flush = (ch == 'y' || ch == 'Y' || ch == 't' || ch == 'T' || ch == '1');
+        }
+        NtClose( hkey );
+    }
+    NtClose( root );
+    TRACE( "caching %u files, lazy flush %u\n", nb_cached_profiles, lazy_flush );
+}
+
 /***********************************************************************
  *           PROFILE_Open
  *
@@ -745,16 +1044,16 @@ static BOOL PROFILE_Open( LPCWSTR filename, BOOL write_access )
     /* First time around */
 
     if(!CurProfile)
-       for(i=0;i<N_CACHED_PROFILES;i++)
+    {
+       PROFILE_GetOptions();
+       for(i=0;i<nb_cached_profiles;i++)
        {
-          MRUProfile[i]=HeapAlloc( GetProcessHeap(), 0, sizeof(PROFILE) );
+          MRUProfile[i]=HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(PROFILE) );
           if(MRUProfile[i] == NULL) break;
-          MRUProfile[i]->changed=FALSE;
-          MRUProfile[i]->section=NULL;
-          MRUProfile[i]->filename=NULL;
           MRUProfile[i]->encoding=ENCODING_ANSI;
-          ZeroMemory(&MRUProfile[i]->LastWriteTime, sizeof(FILETIME));
        }
+       if (i) nb_cached_profiles = i;
+    }
 
     if (!filename)
 	filename = wininiW;
@@ -787,14 +1086,14 @@ static BOOL PROFILE_Open( LPCWSTR filename, BOOL write_access )
         return FALSE;
     }
 
-    for(i=0;i<N_CACHED_PROFILES;i++)
+    for(i=0;i<nb_cached_profiles;i++)
     {
         if ((MRUProfile[i]->filename && !strcmpiW( buffer, MRUProfile[i]->filename )))
         {
             TRACE("MRU Filename: %s, new filename: %s\n", debugstr_w(MRUProfile[i]->filename), debugstr_w(buffer));
             if(i)
             {
-                PROFILE_FlushFile();
+                if (!lazy_flush) PROFILE_FlushFile();
                 tempProfile=MRUProfile[i];
                 for(j=i;j>0;j--)
                     MRUProfile[j]=MRUProfile[j-1];
@@ -804,7 +1103,10 @@ static BOOL PROFILE_Open( LPCWSTR filename, BOOL write_access )
             if (hFile != INVALID_HANDLE_VALUE)
             {
                 GetFileTime(hFile, NULL, NULL, &LastWriteTime);
-                if (!memcmp( &CurProfile->LastWriteTime, &LastWriteTime, sizeof(FILETIME) ) &&
+                if (lazy_flush && CurProfile->changed)
+                    TRACE("(%s): already opened, not flushed yet (mru=%d)\n",
+                          debugstr_w(buffer), i);
+                else if (!memcmp( &CurProfile->LastWriteTime, &LastWriteTime, sizeof(FILETIME) ) &&
                     is_not_current(&LastWriteTime))
                     TRACE("(%s): already opened (mru=%d)\n",
                           debugstr_w(buffer), i);
@@ -815,6 +1117,12 @@ static BOOL PROFILE_Open( LPCWSTR filename, BOOL write_access )
                     PROFILE_Free(CurProfile->section);
                     CurProfile->section = PROFILE_Load(hFile, &CurProfile->encoding);
                     CurProfile->LastWriteTime = LastWriteTime;
+                    if (!PROFILE_BuildIndex( CurProfile, 0 ))
+                    {
+                        CloseHandle(hFile);
+                        PROFILE_ReleaseFile();
+                        return FALSE;
+                    }
                 }
                 CloseHandle(hFile);
                 return TRUE;
@@ -825,13 +1133,13 @@ static BOOL PROFILE_Open( LPCWSTR filename, BOOL write_access )
     }
 
     /* Flush the old current profile */
-    PROFILE_FlushFile();
+    if (!lazy_flush) PROFILE_FlushFile();
 
     /* Make the oldest profile the current one only in order to get rid of it */
-    if(i==N_CACHED_PROFILES)
+    if(i==nb_cached_profiles)
       {
-       tempProfile=MRUProfile[N_CACHED_PROFILES-1];
-       for(i=N_CACHED_PROFILES-1;i>0;i--)
+       tempProfile=MRUProfile[nb_cached_profiles-1];
+       for(i=nb_cached_profiles-1;i>0;i--)
           MRUProfile[i]=MRUProfile[i-1];
        CurProfile=tempProfile;
       }
@@ -852,6 +1160,11 @@ static BOOL PROFILE_Open( LPCWSTR filename, BOOL write_access )
         /* Does not exist yet, we will create it in PROFILE_FlushFile */
         WARN("profile file %s not found\n", debugstr_w(buffer) );
     }
+    if (!PROFILE_BuildIndex( CurProfile, 0 ))
+    {
+        PROFILE_ReleaseFile();
+        return FALSE;
+    }
     return TRUE;
 }
 
@@ -862,55 +1175,53 @@ static BOOL PROFILE_Open( LPCWSTR filename, BOOL write_access )
  * Returns all keys of a section.
  * If return_values is TRUE, also include the corresponding values.
  */
-static INT PROFILE_GetSection( PROFILESECTION *section, LPCWSTR section_name,
+static INT PROFILE_GetSection( const PROFILE *profile, LPCWSTR section_name,
 			       LPWSTR buffer, UINT len, BOOL return_values )
 {
+    PROFILESECTION *section;
     PROFILEKEY *key;
+    UINT oldlen = len;
 
     if(!buffer) return 0;
 
     TRACE("%s,%p,%u\n", debugstr_w(section_name), buffer, len);
 
-    while (section)
+    if (!(section = PROFILE_FindSection( profile, NULL, section_name, strlenW(section_name) )))
     {
-        if (section->name[0] && !strcmpiW( section->name, section_name ))
-        {
-            UINT oldlen = len;
-            for (key = section->key; key; key = key->next)
-            {
-                if (len <= 2) break;
-                if (!*key->name && !key->value) continue;  /* Skip empty lines */
-                if (IS_ENTRY_COMMENT(key->name)) continue;  /* Skip comments */
-                if (!return_values && !key->value) continue;  /* Skip lines w.o. '=' */
-                PROFILE_CopyEntry( buffer, key->name, len - 1, 0 );
-                len -= strlenW(buffer) + 1;
-                buffer += strlenW(buffer) + 1;
-		if (len < 2)
-		    break;
-		if (return_values && key->value) {
-			buffer[-1] = '=';
-			PROFILE_CopyEntry ( buffer, key->value, len - 1, 0 );
-			len -= strlenW(buffer) + 1;
-			buffer += strlenW(buffer) + 1;
-                }
-            }
-            *buffer = '\0';
-            if (len <= 1)
-                /*If either lpszSection or lpszKey is NULL and the supplied
-                  destination buffer is too small to hold all the strings,
-                  the last string is truncated and followed by two null characters.
-                  In this case, the return value is equal to cchReturnBuffer
-                  minus two. */
-            {
-		buffer[-1] = '\0';
-                return oldlen - 2;
-            }
-            return oldlen - len;
+        buffer[0] = buffer[1] = '\0';
+        return 0;
+    }
+
+    for (key = section->key; key; key = key->next)
+    {
+        if (len <= 2) break;
+        if (!*key->name && !key->value) continue;  /* Skip empty lines */
+        if (IS_ENTRY_COMMENT(key->name)) continue;  /* Skip comments */
+        if (!return_values && !key->value) continue;  /* Skip lines w.o. '=' */
+        PROFILE_CopyEntry( buffer, key->name, len - 1, 0 );
+        len -= strlenW(buffer) + 1;
+        buffer += strlenW(buffer) + 1;
+        if (len < 2)
+            break;
+        if (return_values && key->value) {
+            buffer[-1] = '=';
+            PROFILE_CopyEntry ( buffer, key->value, len - 1, 0 );
+            len -= strlenW(buffer) + 1;
+            buffer += strlenW(buffer) + 1;
         }
-        section = section->next;
     }
-    buffer[0] = buffer[1] = '\0';
-    return 0;
+    *buffer = '\0';
+    if (len <= 1)
+        /*If either lpszSection or lpszKey is NULL and the supplied
+          destination buffer is too small to hold all the strings,
+          the last string is truncated and followed by two null characters.
+          In this case, the return value is equal to cchReturnBuffer
+          minus two. */
+    {
+        buffer[-1] = '\0';
+        return oldlen - 2;
+    }
+    return oldlen - len;
 }
 
 /* See GetPrivateProfileSectionNamesA for documentation */
@@ -993,7 +1304,7 @@ static INT PROFILE_GetString( LPCWSTR section, LPCWSTR key_name,
             PROFILE_CopyEntry(buffer, def_val, len, TRUE);
             return strlenW(buffer);
         }
-        key = PROFILE_Find( &CurProfile->section, section, key_name, FALSE, FALSE);
+        key = PROFILE_Find( CurProfile, section, key_name, FALSE, FALSE);
         PROFILE_CopyEntry( buffer, (key && key->value) ? key->value : def_val,
                            len, TRUE );
         TRACE("(%s,%s,%s): returning %s\n",
@@ -1004,7 +1315,7 @@ static INT PROFILE_GetString( LPCWSTR section, LPCWSTR key_name,
     /* no "else" here ! */
     if (section && section[0])
     {
-        INT ret = PROFILE_GetSection(CurProfile->section, section, buffer, len, FALSE);
+        INT ret = PROFILE_GetSection(CurProfile, section, buffer, len, FALSE);
         if (!buffer[0]) /* no luck -> def_val */
         {
             PROFILE_CopyEntry(buffer, def_val, len, TRUE);
@@ -1028,21 +1339,19 @@ static BOOL PROFILE_SetString( LPCWSTR section_name, LPCWSTR key_name,
     if (!key_name)  /* Delete a whole section */
     {
         TRACE("(%s)\n", debugstr_w(section_name));
-        CurProfile->changed |= PROFILE_DeleteSection( &CurProfile->section,
-                                                      section_name );
+        CurProfile->changed |= PROFILE_DeleteSection( CurProfile, section_name );
         return TRUE;         /* Even if PROFILE_DeleteSection() has failed,
                                 this is not an error on application's level.*/
     }
     else if (!value)  /* Delete a key */
     {
         TRACE("(%s,%s)\n", debugstr_w(section_name), debugstr_w(key_name) );
-        CurProfile->changed |= PROFILE_DeleteKey( &CurProfile->section,
-                                                  section_name, key_name );
+        CurProfile->changed |= PROFILE_DeleteKey( CurProfile, section_name, key_name );
         return TRUE;          /* same error handling as above */
     }
     else  /* Set the key value */
     {
-        PROFILEKEY *key = PROFILE_Find(&CurProfile->section, section_name,
+        PROFILEKEY *key = PROFILE_Find(CurProfile, section_name,
                                         key_name, TRUE, create_always );
         TRACE("(%s,%s,%s):\n",
               debugstr_w(section_name), debugstr_w(key_name), debugstr_w(value) );
@@ -1298,7 +1607,7 @@ INT WINAPI GetPrivateProfileSectionW( LPCWSTR section, LPWSTR buffer,
     RtlEnterCriticalSection( &PROFILE_CritSect );
 
     if (PROFILE_Open( filename, FALSE ))
-        ret = PROFILE_GetSection(CurProfile->section, section, buffer, len, TRUE);
+        ret = PROFILE_GetSection(CurProfile, section, buffer, len, TRUE);
 
     RtlLeaveCriticalSection( &PROFILE_CritSect );
 
@@ -1380,6 +1689,7 @@ BOOL WINAPI WritePrivateProfileStringW( LPCWSTR section, LPCWSTR entry,
 
     if (!section && !entry && !string) /* documented "file flush" case */
     {
+        if (!filename) PROFILE_FlushAll();
         if (!filename || PROFILE_Open( filename, TRUE ))
         {
             if (CurProfile) PROFILE_ReleaseFile();  /* always return FALSE in this case */
@@ -1391,7 +1701,7 @@ BOOL WINAPI WritePrivateProfileStringW( LPCWSTR section, LPCWSTR entry,
             SetLastError(ERROR_FILE_NOT_FOUND);
         } else {
             ret = PROFILE_SetString( section, entry, string, FALSE);
-            if (ret) ret = PROFILE_FlushFile();
+            if (ret && !lazy_flush) ret = PROFILE_FlushFile();
         }
     }
 
@@ -1439,6 +1749,7 @@ BOOL WINAPI WritePrivateProfileSectionW( LPCWSTR section,
 
     if (!section && !string)
     {
+        if (!filename) PROFILE_FlushAll();
         if (!filename || PROFILE_Open( filename, TRUE ))
         {
             if (CurProfile) PROFILE_ReleaseFile();  /* always return FALSE in this case */
@@ -1461,7 +1772,7 @@ BOOL WINAPI WritePrivateProfileSectionW( LPCWSTR section,
                 string += strlenW(string)+1;
             }
         }
-        if (ret) ret = PROFILE_FlushFile();
+        if (ret && !lazy_flush) ret = PROFILE_FlushFile();
     }
 
     RtlLeaveCriticalSection( &PROFILE_CritSect );
@@ -1622,7 +1933,7 @@ BOOL WINAPI GetPrivateProfileStructW (LPCWSTR section, LPCWSTR key,
     RtlEnterCriticalSection( &PROFILE_CritSect );
 
     if (PROFILE_Open( filename, FALSE )) {
-        PROFILEKEY *k = PROFILE_Find ( &CurProfile->section, section, key, FALSE, FALSE);
+        PROFILEKEY *k = PROFILE_Find ( CurProfile, section, key, FALSE, FALSE);
 	if (k) {
 	    TRACE("value (at %p): %s\n", k->value, debugstr_w(k->value));
 	    if (((strlenW(k->value) - 2) / 2) == len)
@@ -1743,7 +2054,7 @@ BOOL WINAPI WritePrivateProfileStructW (LPCWSTR section, LPCWSTR key,
 
     if (PROFILE_Open( filename, TRUE )) {
         ret = PROFILE_SetString( section, key, outstring, FALSE);
-        if (ret) ret = PROFILE_FlushFile();
+        if (ret && !lazy_flush) ret = PROFILE_FlushFile();
     }
 
     RtlLeaveCriticalSection( &PROFILE_CritSect );
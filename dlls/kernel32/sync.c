@@ -2380,6 +2380,43 @@ BOOL WINAPI GetQueuedCompletionStatus( HANDLE CompletionPort, LPDWORD lpNumberOf
 }
 
 
+/******************************************************************************
+ *		GetQueuedCompletionStatusEx (KERNEL32.@)
+ */
+BOOL WINAPI GetQueuedCompletionStatusEx( HANDLE port, OVERLAPPED_ENTRY *entries, ULONG count,
+                                         ULONG *written, DWORD timeout, BOOL alertable )
+{
+    FILE_IO_COMPLETION_INFORMATION *info = (FILE_IO_COMPLETION_INFORMATION *)entries;
+    LARGE_INTEGER time;
+    NTSTATUS status;
+    ULONG i;
+
+    TRACE("%p %p %u %p %u %u\n", port, entries, count, written, timeout, alertable);
+
+    /* both structures have the same size, convert the entries in place */
+    status = NtRemoveIoCompletionEx( port, info, count, written,
+                                     get_nt_timeout( &time, timeout ), alertable );
+    if (status == STATUS_SUCCESS)
+    {
+        for (i = 0; i < *written; i++)
+        {
+            FILE_IO_COMPLETION_INFORMATION msg = info[i];
+
+            entries[i].lpCompletionKey            = msg.CompletionKey;
+            entries[i].lpOverlapped               = (LPOVERLAPPED)msg.CompletionValue;
+            entries[i].Internal                   = msg.IoStatusBlock.u.Status;
+            entries[i].dwNumberOfBytesTransferred = msg.IoStatusBlock.Information;
+        }
+        return TRUE;
+    }
+
+    if (status == STATUS_TIMEOUT) SetLastError( WAIT_TIMEOUT );
+    else if (status == STATUS_USER_APC) SetLastError( WAIT_IO_COMPLETION );
+    else SetLastError( RtlNtStatusToDosError(status) );
+    return FALSE;
+}
+
+
 /******************************************************************************
  *		PostQueuedCompletionStatus (KERNEL32.@)
  */
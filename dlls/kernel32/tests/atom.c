@@ -318,6 +318,34 @@ static void test_error_handling(void)
     }
 }
 
+static void test_delete_atom(void)
+{
+    char buffer[32];
+    ATOM atom, atom2;
+    UINT len;
+
+    atom = GlobalAddAtomA( "foobar_delete" );
+    ok( atom >= 0xc000, "bad atom id %x\n", atom );
+    ok( GlobalFindAtomA( "foobar_delete" ) == atom, "could not find atom\n" );
+    ok( GlobalFindAtomA( "FOOBAR_DELETE" ) == atom, "could not find atom\n" );
+    len = GlobalGetAtomNameA( atom, buffer, sizeof(buffer) );
+    ok( len == strlen("foobar_delete") && !strcmp( buffer, "foobar_delete" ), "wrong name %s\n", buffer );
+
+    /* deleting the atom must not leave stale lookups behind */
+    ok( !GlobalDeleteAtom( atom ), "failed to delete atom\n" );
+    SetLastError( 0xdeadbeef );
+    ok( !GlobalFindAtomA( "foobar_delete" ), "found deleted atom\n" );
+    ok( GetLastError() == ERROR_FILE_NOT_FOUND, "wrong error %u\n", GetLastError() );
+    ok( !GlobalGetAtomNameA( atom, buffer, sizeof(buffer) ), "got name of deleted atom\n" );
+
+    atom2 = GlobalAddAtomA( "FOOBAR_delete" );
+    ok( atom2 >= 0xc000, "bad atom id %x\n", atom2 );
+    ok( GlobalFindAtomA( "foobar_delete" ) == atom2, "could not find atom\n" );
+    len = GlobalGetAtomNameA( atom2, buffer, sizeof(buffer) );
+    ok( len == strlen("FOOBAR_delete") && !strcmp( buffer, "FOOBAR_delete" ), "wrong name %s\n", buffer );
+    ok( !GlobalDeleteAtom( atom2 ), "failed to delete atom\n" );
+}
+
 static void test_local_add_atom(void)
 {
     ATOM atom, w_atom;
@@ -593,6 +621,7 @@ START_TEST(atom)
     test_add_atom();
     test_get_atom_name();
     test_error_handling();
+    test_delete_atom();
     test_local_add_atom();
     test_local_get_atom_name();
     test_local_error_handling();
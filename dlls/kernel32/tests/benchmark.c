@@ -0,0 +1,337 @@
+/*
+ * Microbenchmarks for core primitives
+ *
+ * Copyright 2018 Wine project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/*
+ * The benchmarks only run when WINETEST_BENCHMARK is set in the environment.
+ * Each one is reported on a single line of key=value pairs, with the
+ * per-operation cost of every sample in nanoseconds:
+ *
+ *   benchmark=<name> iterations=<n> samples=<n> min_ns=<x> median_ns=<x>
+ *   mean_ns=<x> max_ns=<x> stddev_ns=<x>
+ *
+ * WINETEST_BENCHMARK=1 runs all of them, any other value only runs the
+ * benchmarks whose name starts with it, e.g. WINETEST_BENCHMARK=wait.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "ntstatus.h"
+#define WIN32_NO_STATUS
+#include "windef.h"
+#include "winbase.h"
+#include "wingdi.h"
+#include "winuser.h"
+#include "winternl.h"
+#include "wine/test.h"
+
+#define SAMPLE_COUNT     15
+#define SAMPLE_TIME_MS   10
+#define CONTENTION_THREADS 3
+
+static NTSTATUS (WINAPI *pNtWaitForSingleObject)(HANDLE, BOOLEAN, const LARGE_INTEGER *);
+
+struct benchmark
+{
+    const char *name;
+    BOOL (*init)(void);
+    void (*run)(unsigned int count);
+    void (*cleanup)(void);
+};
+
+static HANDLE signaled_event, nonsignaled_event;
+static char temp_file[MAX_PATH];
+static HWND hwnd;
+static HDC src_dc, dst_dc;
+static HBITMAP src_bitmap, dst_bitmap;
+static HANDLE heap_threads[CONTENTION_THREADS];
+static volatile LONG heap_stop;
+
+static BOOL init_events(void)
+{
+    signaled_event = CreateEventA( NULL, TRUE, TRUE, NULL );
+    nonsignaled_event = CreateEventA( NULL, TRUE, FALSE, NULL );
+    return signaled_event && nonsignaled_event;
+}
+
+static void cleanup_events(void)
+{
+    CloseHandle( signaled_event );
+    CloseHandle( nonsignaled_event );
+}
+
+/* ResetEvent on an already reset event is a plain server round trip */
+static void bench_server_call( unsigned int count )
+{
+    while (count--) ResetEvent( nonsignaled_event );
+}
+
+static void bench_wait_signaled( unsigned int count )
+{
+    LARGE_INTEGER timeout;
+
+    timeout.QuadPart = 0;
+    while (count--) pNtWaitForSingleObject( signaled_event, FALSE, &timeout );
+}
+
+static void bench_wait_nonsignaled( unsigned int count )
+{
+    LARGE_INTEGER timeout;
+
+    timeout.QuadPart = 0;
+    while (count--) pNtWaitForSingleObject( nonsignaled_event, FALSE, &timeout );
+}
+
+static BOOL init_file(void)
+{
+    char temp_path[MAX_PATH];
+    HANDLE file;
+
+    GetTempPathA( sizeof(temp_path), temp_path );
+    GetTempFileNameA( temp_path, "wtb", 0, temp_file );
+    file = CreateFileA( temp_file, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL );
+    if (file == INVALID_HANDLE_VALUE) return FALSE;
+    CloseHandle( file );
+    return TRUE;
+}
+
+static void cleanup_file(void)
+{
+    DeleteFileA( temp_file );
+}
+
+static void bench_create_file( unsigned int count )
+{
+    HANDLE file;
+
+    while (count--)
+    {
+        file = CreateFileA( temp_file, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL );
+        CloseHandle( file );
+    }
+}
+
+static BOOL init_window(void)
+{
+    hwnd = CreateWindowA( "static", NULL, WS_POPUP, 0, 0, 10, 10, NULL, NULL, NULL, NULL );
+    return hwnd != NULL;
+}
+
+static void cleanup_window(void)
+{
+    DestroyWindow( hwnd );
+}
+
+static void bench_post_message( unsigned int count )
+{
+    MSG msg;
+
+    while (count--)
+    {
+        PostMessageA( hwnd, WM_USER, 0, 0 );
+        PeekMessageA( &msg, hwnd, WM_USER, WM_USER, PM_REMOVE );
+    }
+}
+
+static void bench_load_library( unsigned int count )
+{
+    HMODULE module;
+
+    while (count--)
+    {
+        module = LoadLibraryA( "version.dll" );
+        FreeLibrary( module );
+    }
+}
+
+static void bench_heap_alloc( unsigned int count )
+{
+    HANDLE heap = GetProcessHeap();
+    void *ptr;
+
+    while (count--)
+    {
+        ptr = HeapAlloc( heap, 0, 64 );
+        HeapFree( heap, 0, ptr );
+    }
+}
+
+static DWORD WINAPI heap_thread( void *arg )
+{
+    while (!heap_stop) bench_heap_alloc( 256 );
+    return 0;
+}
+
+static BOOL init_heap_threads(void)
+{
+    unsigned int i;
+
+    heap_stop = FALSE;
+    for (i = 0; i < CONTENTION_THREADS; i++)
+        if (!(heap_threads[i] = CreateThread( NULL, 0, heap_thread, NULL, 0, NULL ))) return FALSE;
+    return TRUE;
+}
+
+static void cleanup_heap_threads(void)
+{
+    unsigned int i;
+
+    heap_stop = TRUE;
+    for (i = 0; i < CONTENTION_THREADS; i++)
+    {
+        if (!heap_threads[i]) continue;
+        WaitForSingleObject( heap_threads[i], INFINITE );
+        CloseHandle( heap_threads[i] );
+        heap_threads[i] = NULL;
+    }
+}
+
+static BOOL init_dcs(void)
+{
+    HDC hdc = GetDC( 0 );
+
+    src_dc = CreateCompatibleDC( hdc );
+    dst_dc = CreateCompatibleDC( hdc );
+    src_bitmap = CreateCompatibleBitmap( hdc, 256, 256 );
+    dst_bitmap = CreateCompatibleBitmap( hdc, 256, 256 );
+    ReleaseDC( 0, hdc );
+    if (!src_dc || !dst_dc || !src_bitmap || !dst_bitmap) return FALSE;
+
+    SelectObject( src_dc, src_bitmap );
+    SelectObject( dst_dc, dst_bitmap );
+    PatBlt( src_dc, 0, 0, 256, 256, WHITENESS );
+    return TRUE;
+}
+
+static void cleanup_dcs(void)
+{
+    DeleteDC( src_dc );
+    DeleteDC( dst_dc );
+    DeleteObject( src_bitmap );
+    DeleteObject( dst_bitmap );
+}
+
+static void bench_bitblt( unsigned int count )
+{
+    while (count--) BitBlt( dst_dc, 0, 0, 256, 256, src_dc, 0, 0, SRCCOPY );
+}
+
+static void bench_ext_text_out( unsigned int count )
+{
+    static const char text[] = "The quick brown fox jumps over the lazy dog";
+
+    while (count--) ExtTextOutA( dst_dc, 0, 0, 0, NULL, text, sizeof(text) - 1, NULL );
+}
+
+static const struct benchmark benchmarks[] =
+{
+    { "server_call",              init_events,       bench_server_call,      cleanup_events },
+    { "wait_signaled",            init_events,       bench_wait_signaled,    cleanup_events },
+    { "wait_nonsignaled",         init_events,       bench_wait_nonsignaled, cleanup_events },
+    { "create_file_close_handle", init_file,         bench_create_file,      cleanup_file },
+    { "post_peek_message",        init_window,       bench_post_message,     cleanup_window },
+    { "load_free_library",        NULL,              bench_load_library,     NULL },
+    { "heap_alloc_free",          NULL,              bench_heap_alloc,       NULL },
+    { "heap_alloc_free_contended", init_heap_threads, bench_heap_alloc,      cleanup_heap_threads },
+    { "bitblt",                   init_dcs,          bench_bitblt,           cleanup_dcs },
+    { "ext_text_out",             init_dcs,          bench_ext_text_out,     cleanup_dcs },
+};
+
+static LONGLONG get_time_ns( const struct benchmark *bench, unsigned int count )
+{
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER start, end;
+
+    if (!frequency.QuadPart) QueryPerformanceFrequency( &frequency );
+
+    QueryPerformanceCounter( &start );
+    bench->run( count );
+    QueryPerformanceCounter( &end );
+    return (end.QuadPart - start.QuadPart) * 1000000000 / frequency.QuadPart;
+}
+
+static int compare_samples( const void *a, const void *b )
+{
+    const double *x = a, *y = b;
+    return *x < *y ? -1 : *x > *y;
+}
+
+static void run_benchmark( const struct benchmark *bench )
+{
+    double samples[SAMPLE_COUNT], mean = 0.0, variance = 0.0;
+    unsigned int i, count = 1;
+
+    if (bench->init && !bench->init())
+    {
+        skip( "%s: setup failed, error %u\n", bench->name, GetLastError() );
+        if (bench->cleanup) bench->cleanup();
+        return;
+    }
+
+    /* warm up, then grow the batch until one takes long enough to be timed reliably */
+    bench->run( 1 );
+    while (count < (1 << 24) && get_time_ns( bench, count ) < SAMPLE_TIME_MS * 1000000) count *= 2;
+
+    for (i = 0; i < SAMPLE_COUNT; i++)
+    {
+        samples[i] = (double)get_time_ns( bench, count ) / count;
+        mean += samples[i];
+    }
+    mean /= SAMPLE_COUNT;
+    for (i = 0; i < SAMPLE_COUNT; i++) variance += (samples[i] - mean) * (samples[i] - mean);
+    variance /= SAMPLE_COUNT;
+    qsort( samples, SAMPLE_COUNT, sizeof(samples[0]), compare_samples );
+
+    trace( "benchmark=%s iterations=%u samples=%u min_ns=%.1f median_ns=%.1f mean_ns=%.1f max_ns=%.1f stddev_ns=%.1f\n",
+           bench->name, count, SAMPLE_COUNT, samples[0], samples[SAMPLE_COUNT / 2], mean,
+           samples[SAMPLE_COUNT - 1], sqrt( variance ) );
+
+    if (bench->cleanup) bench->cleanup();
+}
+
+START_TEST(benchmark)
+{
+    const char *filter = getenv( "WINETEST_BENCHMARK" );
+    unsigned int i;
+
+    if (!filter)
+    {
+        skip( "set WINETEST_BENCHMARK to run the benchmarks\n" );
+        return;
+    }
+    if (!strcmp( filter, "1" ) || !strcmp( filter, "all" )) filter = "";
+
+    pNtWaitForSingleObject = (void *)GetProcAddress( GetModuleHandleA( "ntdll.dll" ), "NtWaitForSingleObject" );
+
+    for (i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++)
+    {
+        if (strncmp( benchmarks[i].name, filter, strlen( filter ) )) continue;
+        if (!pNtWaitForSingleObject &&
+            (benchmarks[i].run == bench_wait_signaled || benchmarks[i].run == bench_wait_nonsignaled))
+        {
+            win_skip( "NtWaitForSingleObject is not available\n" );
+            continue;
+        }
+        run_benchmark( &benchmarks[i] );
+    }
+}
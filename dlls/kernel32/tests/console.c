@@ -456,6 +456,45 @@ static void testWriteWrappedProcessed(HANDLE hCon, COORD sbSize)
     okCURSOR(hCon, c);
 }
 
+static void testWriteWrappedScroll(HANDLE hCon, COORD sbSize)
+{
+    COORD		c, tc;
+    DWORD		len, mode;
+    const char*		mytest = "abcd\nxy";
+    const int	mylen = strlen(mytest);
+
+    ok(GetConsoleMode(hCon, &mode) && SetConsoleMode(hCon, mode | (ENABLE_WRAP_AT_EOL_OUTPUT|ENABLE_PROCESSED_OUTPUT)),
+       "setting wrap at EOL & processed output\n");
+
+    /* write lines past the bottom of the sb, wrapping and scrolling it twice */
+    c.X = sbSize.X - 2; c.Y = sbSize.Y - 1;
+    ok(SetConsoleCursorPosition(hCon, c) != 0, "Cursor in lower-right-2\n");
+
+    ok(WriteConsoleA(hCon, mytest, mylen, &len, NULL) != 0 && len == mylen, "WriteConsole\n");
+    c.Y = 0; tc.Y = 2;
+    for (c.X = tc.X = 0; c.X < sbSize.X; c.X++, tc.X++)
+        okCHAR(hCon, c, CONTENT(tc), DEFAULT_ATTRIB);
+    c.Y = sbSize.Y - 3; tc.Y = sbSize.Y - 1;
+    for (c.X = tc.X = 0; c.X < sbSize.X - 2; c.X++, tc.X++)
+        okCHAR(hCon, c, CONTENT(tc), DEFAULT_ATTRIB);
+    okCHAR(hCon, c, mytest[0], TEST_ATTRIB);
+    c.X++;
+    okCHAR(hCon, c, mytest[1], TEST_ATTRIB);
+    c.X = 0; c.Y++;
+    okCHAR(hCon, c, mytest[2], TEST_ATTRIB);
+    c.X++;
+    okCHAR(hCon, c, mytest[3], TEST_ATTRIB);
+    c.X++;
+    okCHAR(hCon, c, ' ', TEST_ATTRIB);
+    c.X = 0; c.Y++;
+    okCHAR(hCon, c, mytest[5], TEST_ATTRIB);
+    c.X++;
+    okCHAR(hCon, c, mytest[6], TEST_ATTRIB);
+    c.X++;
+    okCHAR(hCon, c, ' ', TEST_ATTRIB);
+    okCURSOR(hCon, c);
+}
+
 static void testWrite(HANDLE hCon, COORD sbSize)
 {
     /* FIXME: should in fact ensure that the sb is at least 10 characters wide */
@@ -472,6 +511,8 @@ static void testWrite(HANDLE hCon, COORD sbSize)
     testWriteWrappedNotProcessed(hCon, sbSize);
     resetContent(hCon, sbSize, FALSE);
     testWriteWrappedProcessed(hCon, sbSize);
+    resetContent(hCon, sbSize, TRUE);
+    testWriteWrappedScroll(hCon, sbSize);
 }
 
 static void testScroll(HANDLE hCon, COORD sbSize)
@@ -39,6 +39,7 @@
 #define HEAP_VALIDATE_PARAMS  0x40000000
 
 static BOOL (WINAPI *pHeapQueryInformation)(HANDLE, HEAP_INFORMATION_CLASS, PVOID, SIZE_T, PSIZE_T);
+static BOOL (WINAPI *pHeapSetInformation)(HANDLE, HEAP_INFORMATION_CLASS, PVOID, SIZE_T);
 static BOOL (WINAPI *pGetPhysicallyInstalledSystemMemory)(ULONGLONG *);
 static ULONG (WINAPI *pRtlGetNtGlobalFlags)(void);
 
@@ -892,6 +893,72 @@ static void test_HeapQueryInformation(void)
     ok(info == 0 || info == 1 || info == 2, "expected 0, 1 or 2, got %u\n", info);
 }
 
+static void test_low_fragmentation_heap(void)
+{
+    BYTE *ptrs[64], *ptr;
+    ULONG info;
+    HANDLE heap;
+    SIZE_T size;
+    BOOL ret;
+    int i, j;
+
+    pHeapSetInformation = (void *)GetProcAddress(GetModuleHandleA("kernel32.dll"), "HeapSetInformation");
+    if (!pHeapQueryInformation || !pHeapSetInformation)
+    {
+        win_skip("HeapSetInformation is not available\n");
+        return;
+    }
+
+    heap = HeapCreate( 0, 0, 0 );
+    ok(heap != NULL, "HeapCreate failed %u\n", GetLastError());
+
+    info = 2;
+    ret = pHeapSetInformation( heap, HeapCompatibilityInformation, &info, sizeof(info) );
+    ok(ret, "HeapSetInformation error %u\n", GetLastError());
+
+    info = 0xdeadbeef;
+    ret = pHeapQueryInformation( heap, HeapCompatibilityInformation, &info, sizeof(info), NULL );
+    ok(ret, "HeapQueryInformation error %u\n", GetLastError());
+    ok(info == 2, "expected 2, got %u\n", info);
+
+    for (i = 0; i < ARRAY_SIZE(ptrs); i++)
+    {
+        size = 1 + i * 273;
+        ptrs[i] = HeapAlloc( heap, HEAP_ZERO_MEMORY, size );
+        ok(ptrs[i] != NULL, "%u: HeapAlloc failed\n", i);
+        ok(!((ULONG_PTR)ptrs[i] & (2 * sizeof(void *) - 1)), "%u: got unaligned pointer %p\n", i, ptrs[i]);
+        ok(HeapSize( heap, 0, ptrs[i] ) == size, "%u: got size %lu\n", i, HeapSize( heap, 0, ptrs[i] ));
+        for (j = 0; j < size; j++) if (ptrs[i][j]) break;
+        ok(j == size, "%u: memory not zeroed at %u\n", i, j);
+        memset( ptrs[i], i, size );
+    }
+    ok(HeapValidate( heap, 0, NULL ), "HeapValidate failed\n");
+
+    for (i = 0; i < ARRAY_SIZE(ptrs); i++)
+    {
+        size = 1 + i * 273;
+        ok(HeapValidate( heap, 0, ptrs[i] ), "%u: HeapValidate failed\n", i);
+        ptr = HeapReAlloc( heap, HEAP_ZERO_MEMORY, ptrs[i], size + 100 );
+        ok(ptr != NULL, "%u: HeapReAlloc failed\n", i);
+        ok(HeapSize( heap, 0, ptr ) == size + 100, "%u: got size %lu\n", i, HeapSize( heap, 0, ptr ));
+        for (j = 0; j < size; j++) if (ptr[j] != (BYTE)i) break;
+        ok(j == size, "%u: memory not preserved at %u\n", i, j);
+        for (; j < size + 100; j++) if (ptr[j]) break;
+        ok(j == size + 100, "%u: memory not zeroed at %u\n", i, j);
+        ptrs[i] = ptr;
+    }
+
+    for (i = 0; i < ARRAY_SIZE(ptrs); i++)
+    {
+        ret = HeapFree( heap, 0, ptrs[i] );
+        ok(ret, "%u: HeapFree failed %u\n", i, GetLastError());
+    }
+    ok(HeapValidate( heap, 0, NULL ), "HeapValidate failed\n");
+
+    ret = HeapDestroy( heap );
+    ok(ret, "HeapDestroy failed %u\n", GetLastError());
+}
+
 static void test_heap_checks( DWORD flags )
 {
     BYTE old, *p, *p2;
@@ -1245,6 +1312,7 @@ START_TEST(heap)
     test_sized_HeapReAlloc((1 << 20), 1);
 
     test_HeapQueryInformation();
+    test_low_fragmentation_heap();
     test_GetPhysicallyInstalledSystemMemory();
 
     if (pRtlGetNtGlobalFlags)
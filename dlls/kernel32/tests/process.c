@@ -3618,8 +3618,8 @@ todo_wine
 
 static void test_GetLogicalProcessorInformationEx(void)
 {
-    SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *info;
-    DWORD len;
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *info, *entry;
+    DWORD len, ofs;
     BOOL ret;
 
     if (!pGetLogicalProcessorInformationEx)
@@ -3646,6 +3646,21 @@ static void test_GetLogicalProcessorInformationEx(void)
     ok(ret, "got %d, error %d\n", ret, GetLastError());
     ok(info->Size > 0, "got %u\n", info->Size);
     HeapFree(GetProcessHeap(), 0, info);
+
+    len = 0;
+    ret = pGetLogicalProcessorInformationEx(RelationNumaNode, NULL, &len);
+    ok(!ret && GetLastError() == ERROR_INSUFFICIENT_BUFFER, "got %d, error %d\n", ret, GetLastError());
+
+    info = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, len);
+    ret = pGetLogicalProcessorInformationEx(RelationNumaNode, info, &len);
+    ok(ret, "got %d, error %d\n", ret, GetLastError());
+    for (ofs = 0; ret && ofs < len; ofs += entry->Size)
+    {
+        entry = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *)((char *)info + ofs);
+        ok(entry->Relationship == RelationNumaNode, "got relationship %u\n", entry->Relationship);
+        if (!entry->Size) break;
+    }
+    HeapFree(GetProcessHeap(), 0, info);
 }
 
 static void test_largepages(void)
@@ -1175,6 +1175,65 @@ static void test_WritePrivateProfileString(void)
     DeleteFileA(path);
 }
 
+static void test_profile_many_keys(void)
+{
+    char section[16], key[16], value[16], buf[64];
+    int i, j;
+    DWORD ret;
+
+    DeleteFileA( TESTFILE );
+
+    for (i = 0; i < 4; i++)
+    {
+        sprintf( section, "section%d", i );
+        for (j = 0; j < 200; j++)
+        {
+            sprintf( key, "key%d", j );
+            sprintf( value, "%d.%d", i, j );
+            ret = WritePrivateProfileStringA( section, key, value, TESTFILE );
+            ok( ret, "%d.%d: WritePrivateProfileString failed\n", i, j );
+        }
+    }
+
+    /* lookups are case-insensitive and ignore surrounding spaces */
+    ret = GetPrivateProfileStringA( "SECTION2", " KEY150 ", "", buf, sizeof(buf), TESTFILE );
+    ok( ret == 5 && !strcmp( buf, "2.150" ), "got %u %s\n", ret, buf );
+
+    for (i = 0; i < 4; i++)
+    {
+        sprintf( section, "section%d", i );
+        for (j = 0; j < 200; j += 7)
+        {
+            sprintf( key, "key%d", j );
+            sprintf( value, "%d.%d", i, j );
+            GetPrivateProfileStringA( section, key, "", buf, sizeof(buf), TESTFILE );
+            ok( !strcmp( buf, value ), "%s %s: got %s\n", section, key, buf );
+        }
+    }
+
+    ret = WritePrivateProfileStringA( "section1", "key42", NULL, TESTFILE );
+    ok( ret, "WritePrivateProfileString failed\n" );
+    ret = GetPrivateProfileStringA( "section1", "key42", "none", buf, sizeof(buf), TESTFILE );
+    ok( ret == 4 && !strcmp( buf, "none" ), "got %u %s\n", ret, buf );
+    ret = GetPrivateProfileStringA( "section1", "key43", "none", buf, sizeof(buf), TESTFILE );
+    ok( ret == 4 && !strcmp( buf, "1.43" ), "got %u %s\n", ret, buf );
+
+    ret = WritePrivateProfileStringA( "section0", NULL, NULL, TESTFILE );
+    ok( ret, "WritePrivateProfileString failed\n" );
+    ret = GetPrivateProfileStringA( "section0", "key0", "none", buf, sizeof(buf), TESTFILE );
+    ok( ret == 4 && !strcmp( buf, "none" ), "got %u %s\n", ret, buf );
+    ret = GetPrivateProfileSectionNamesA( buf, sizeof(buf), TESTFILE );
+    ok( ret == 27 && !memcmp( buf, "section1\0section2\0section3\0", 28 ), "got %u %s\n", ret, buf );
+
+    /* keys can still be added once the index has grown */
+    ret = WritePrivateProfileStringA( "section3", "newkey", "new", TESTFILE );
+    ok( ret, "WritePrivateProfileString failed\n" );
+    ret = GetPrivateProfileStringA( "section3", "newkey", "", buf, sizeof(buf), TESTFILE );
+    ok( ret == 3 && !strcmp( buf, "new" ), "got %u %s\n", ret, buf );
+
+    DeleteFileA( TESTFILE );
+}
+
 START_TEST(profile)
 {
     test_profile_int();
@@ -1182,6 +1241,7 @@ START_TEST(profile)
     test_profile_sections();
     test_profile_sections_names();
     test_profile_existing();
+    test_profile_many_keys();
     test_profile_delete_on_close();
     test_profile_refresh();
     test_profile_directory_readonly();
@@ -931,6 +931,10 @@ static VOID test_thread_processor(void)
 
             error=pSetThreadIdealProcessor(curthread,MAXIMUM_PROCESSORS);
             ok(error!=-1, "SetThreadIdealProcessor failed\n");
+
+            pSetThreadIdealProcessor(curthread,0);
+            error=pSetThreadIdealProcessor(curthread,MAXIMUM_PROCESSORS);
+            ok(error==0, "expected previous ideal processor 0, got %d\n", error);
         }
         else
             win_skip("SetThreadIdealProcessor is not implemented\n");
@@ -38,6 +38,7 @@
 static HINSTANCE hkernel32, hntdll;
 static SYSTEM_INFO si;
 static LPVOID (WINAPI *pVirtualAllocEx)(HANDLE, LPVOID, SIZE_T, DWORD, DWORD);
+static LPVOID (WINAPI *pVirtualAllocExNuma)(HANDLE, LPVOID, SIZE_T, DWORD, DWORD, DWORD);
 static BOOL   (WINAPI *pVirtualFreeEx)(HANDLE, LPVOID, SIZE_T, DWORD);
 static UINT   (WINAPI *pGetWriteWatch)(DWORD,LPVOID,SIZE_T,LPVOID*,ULONG_PTR*,ULONG*);
 static UINT   (WINAPI *pResetWriteWatch)(LPVOID,SIZE_T);
@@ -490,6 +491,106 @@ static void test_VirtualAlloc(void)
     ok(VirtualFree(addr1, 0, MEM_RELEASE), "VirtualFree failed\n");
 }
 
+static void test_VirtualAllocExNuma(void)
+{
+    ULONG highest = 0;
+    char *mem;
+
+    if (!pVirtualAllocExNuma)
+    {
+        win_skip("VirtualAllocExNuma is not available\n");
+        return;
+    }
+
+    ok(GetNumaHighestNodeNumber(&highest), "GetNumaHighestNodeNumber failed\n");
+
+    mem = pVirtualAllocExNuma(GetCurrentProcess(), NULL, 0x10000, MEM_RESERVE | MEM_COMMIT,
+                              PAGE_READWRITE, highest);
+    ok(mem != NULL, "VirtualAllocExNuma failed, error %u\n", GetLastError());
+    if (mem)
+    {
+        memset(mem, 0x55, 0x10000);
+        ok(VirtualFree(mem, 0, MEM_RELEASE), "VirtualFree failed\n");
+    }
+
+    mem = pVirtualAllocExNuma(GetCurrentProcess(), NULL, 0x10000, MEM_RESERVE, PAGE_READWRITE,
+                              NUMA_NO_PREFERRED_NODE);
+    ok(mem != NULL, "VirtualAllocExNuma failed, error %u\n", GetLastError());
+    if (mem)
+    {
+        ok(pVirtualAllocExNuma(GetCurrentProcess(), mem, 0x1000, MEM_COMMIT, PAGE_READWRITE, 0) == mem,
+           "VirtualAllocExNuma failed, error %u\n", GetLastError());
+        mem[0] = 1;
+        ok(VirtualFree(mem, 0, MEM_RELEASE), "VirtualFree failed\n");
+    }
+}
+
+static void test_large_pages(void)
+{
+    SIZE_T size = GetLargePageMinimum();
+    TOKEN_PRIVILEGES privs;
+    HANDLE token;
+    void *mem;
+    DWORD error;
+    BOOL ret;
+
+    if (!size)
+    {
+        skip("large pages are not supported\n");
+        return;
+    }
+
+    SetLastError(0xdeadbeef);
+    mem = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+    error = GetLastError();
+    if (mem)
+    {
+        win_skip("SE_LOCK_MEMORY_NAME privilege is already enabled\n");
+        VirtualFree(mem, 0, MEM_RELEASE);
+        return;
+    }
+    ok(error == ERROR_PRIVILEGE_NOT_HELD, "got %u\n", error);
+
+    privs.PrivilegeCount = 1;
+    privs.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES, &token) ||
+        !LookupPrivilegeValueA(NULL, SE_LOCK_MEMORY_NAME, &privs.Privileges[0].Luid) ||
+        !AdjustTokenPrivileges(token, FALSE, &privs, sizeof(privs), NULL, NULL) ||
+        GetLastError() == ERROR_NOT_ALL_ASSIGNED)
+    {
+        win_skip("cannot enable SE_LOCK_MEMORY_NAME privilege\n");
+        CloseHandle(token);
+        return;
+    }
+
+    SetLastError(0xdeadbeef);
+    mem = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE);
+    ok(!mem, "VirtualAlloc succeeded\n");
+    ok(GetLastError() == ERROR_INVALID_PARAMETER, "got %u\n", GetLastError());
+
+    SetLastError(0xdeadbeef);
+    mem = VirtualAlloc(NULL, size / 2, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+    ok(!mem, "VirtualAlloc succeeded\n");
+    ok(GetLastError() == ERROR_INVALID_PARAMETER, "got %u\n", GetLastError());
+
+    SetLastError(0xdeadbeef);
+    mem = VirtualAlloc(NULL, 2 * size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+    /* Windows fails if it can't find enough contiguous physical memory */
+    ok(mem != NULL || broken(GetLastError() == ERROR_NO_SYSTEM_RESOURCES), "got %u\n", GetLastError());
+    if (mem)
+    {
+        ok(!((ULONG_PTR)mem & (size - 1)), "got unaligned address %p\n", mem);
+        memset(mem, 0x55, 2 * size);
+        ret = VirtualFree(mem, 0, MEM_RELEASE);
+        ok(ret, "VirtualFree failed %u\n", GetLastError());
+    }
+
+    privs.Privileges[0].Attributes = 0;
+    AdjustTokenPrivileges(token, FALSE, &privs, sizeof(privs), NULL, NULL);
+    CloseHandle(token);
+}
+
 static void test_MapViewOfFile(void)
 {
     static const char testfile[] = "testfile.xxx";
@@ -4376,6 +4477,7 @@ START_TEST(virtual)
 
     pVirtualAllocEx = (void *) GetProcAddress(hkernel32, "VirtualAllocEx");
     pVirtualFreeEx = (void *) GetProcAddress(hkernel32, "VirtualFreeEx");
+    pVirtualAllocExNuma = (void *) GetProcAddress(hkernel32, "VirtualAllocExNuma");
     pGetWriteWatch = (void *) GetProcAddress(hkernel32, "GetWriteWatch");
     pResetWriteWatch = (void *) GetProcAddress(hkernel32, "ResetWriteWatch");
     pGetProcessDEPPolicy = (void *)GetProcAddress( hkernel32, "GetProcessDEPPolicy" );
@@ -4404,6 +4506,8 @@ START_TEST(virtual)
     test_VirtualProtect();
     test_VirtualAllocEx();
     test_VirtualAlloc();
+    test_VirtualAllocExNuma();
+    test_large_pages();
     test_MapViewOfFile();
     test_NtMapViewOfSection();
     test_NtAreMappedFilesTheSame();
@@ -605,13 +605,17 @@ DWORD WINAPI SetThreadIdealProcessor(
     HANDLE hThread,          /* [in] Specifies the thread of interest */
     DWORD dwIdealProcessor)  /* [in] Specifies the new preferred processor */
 {
-    FIXME("(%p): stub\n",hThread);
-    if (dwIdealProcessor > MAXIMUM_PROCESSORS)
+    NTSTATUS status;
+
+    TRACE("(%p %u)\n", hThread, dwIdealProcessor);
+
+    status = NtSetInformationThread( hThread, ThreadIdealProcessor, &dwIdealProcessor, sizeof(dwIdealProcessor) );
+    if ((LONG)status < 0)
     {
-        SetLastError(ERROR_INVALID_PARAMETER);
+        SetLastError( RtlNtStatusToDosError(status) );
         return ~0u;
     }
-    return 0;
+    return status;
 }
 
 /***********************************************************************
@@ -619,9 +623,23 @@ DWORD WINAPI SetThreadIdealProcessor(
  */
 BOOL WINAPI SetThreadIdealProcessorEx( HANDLE thread, PROCESSOR_NUMBER *ideal, PROCESSOR_NUMBER *previous )
 {
-    FIXME("(%p %p %p): stub\n", thread, ideal, previous);
-    SetLastError(ERROR_CALL_NOT_IMPLEMENTED);
-    return FALSE;
+    DWORD prev;
+
+    TRACE("(%p %p %p)\n", thread, ideal, previous);
+
+    if (!ideal || ideal->Group || ideal->Reserved)
+    {
+        SetLastError( ERROR_INVALID_PARAMETER );
+        return FALSE;
+    }
+    if ((prev = SetThreadIdealProcessor( thread, ideal->Number )) == ~0u) return FALSE;
+    if (previous)
+    {
+        previous->Group = 0;
+        previous->Number = prev;
+        previous->Reserved = 0;
+    }
+    return TRUE;
 }
 
 /***********************************************************************
@@ -1146,11 +1164,32 @@ PTP_CLEANUP_GROUP WINAPI CreateThreadpoolCleanupGroup( void )
 /***********************************************************************
  *              CreateThreadpoolIo (KERNEL32.@)
  */
+static void CALLBACK tp_io_callback( TP_CALLBACK_INSTANCE *instance, void *userdata, void *cvalue,
+                                     IO_STATUS_BLOCK *iosb, TP_IO *io )
+{
+    PTP_WIN32_IO_CALLBACK callback = *(void **)io;
+
+    callback( instance, userdata, cvalue, RtlNtStatusToDosError( iosb->Status ), iosb->Information, io );
+}
+
 PTP_IO WINAPI CreateThreadpoolIo( HANDLE handle, PTP_WIN32_IO_CALLBACK callback,
                                   PVOID userdata, TP_CALLBACK_ENVIRON *environment )
 {
-    FIXME("(%p, %p, %p, %p): stub\n", handle, callback, userdata, environment);
-    return FALSE;
+    TP_IO *io;
+    NTSTATUS status;
+
+    TRACE( "%p, %p, %p, %p\n", handle, callback, userdata, environment );
+
+    status = TpAllocIoCompletion( &io, handle, tp_io_callback, userdata, environment );
+    if (status)
+    {
+        SetLastError( RtlNtStatusToDosError(status) );
+        return NULL;
+    }
+
+    /* ntdll leaves space for the win32 callback at the start of the object */
+    *(void **)io = callback;
+    return io;
 }
 
 /***********************************************************************
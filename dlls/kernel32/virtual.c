@@ -101,6 +101,44 @@ LPVOID WINAPI VirtualAllocEx( HANDLE hProcess, LPVOID addr, SIZE_T size,
 }
 
 
+/***********************************************************************
+ *             VirtualAllocExNuma   (KERNEL32.@)
+ *
+ * Same as VirtualAllocEx, but the pages preferably come from a NUMA node.
+ *
+ * PARAMS
+ *  process [I] Handle to process to do mem operation.
+ *  addr    [I] Address of region to reserve or commit.
+ *  size    [I] Size of region.
+ *  type    [I] Type of allocation.
+ *  protect [I] Type of access protection.
+ *  node    [I] Preferred NUMA node, or NUMA_NO_PREFERRED_NODE.
+ *
+ * RETURNS
+ *	Success: Base address of allocated region of pages.
+ *	Failure: NULL.
+ */
+LPVOID WINAPI VirtualAllocExNuma( HANDLE process, LPVOID addr, SIZE_T size,
+    DWORD type, DWORD protect, DWORD node )
+{
+    MEM_EXTENDED_PARAMETER param;
+    LPVOID ret = addr;
+    NTSTATUS status;
+
+    if (node == NUMA_NO_PREFERRED_NODE) return VirtualAllocEx( process, addr, size, type, protect );
+
+    memset( &param, 0, sizeof(param) );
+    param.Type = MemExtendedParameterNumaNode;
+    param.u.ULong = node;
+    if ((status = NtAllocateVirtualMemoryEx( process, &ret, &size, type, protect, &param, 1 )))
+    {
+        SetLastError( RtlNtStatusToDosError(status) );
+        ret = NULL;
+    }
+    return ret;
+}
+
+
 /***********************************************************************
  *             VirtualFree   (KERNEL32.@)
  *
@@ -32,6 +32,8 @@
 #include "mfidl.h"
 #include "mferror.h"
 
+#include "mfplat_private.h"
+
 #include "wine/debug.h"
 #include "wine/unicode.h"
 
@@ -404,8 +406,14 @@ HRESULT WINAPI MFTUnregister(CLSID clsid)
  */
 HRESULT WINAPI MFStartup(ULONG version, DWORD flags)
 {
-    FIXME("(%u, %u): stub\n", version, flags);
-    return MF_E_BAD_STARTUP_VERSION;
+    TRACE("(%#x, %#x)\n", version, flags);
+
+    if ((HIWORD(version) != 1 && HIWORD(version) != 2) || LOWORD(version) != MF_API_VERSION)
+        return MF_E_BAD_STARTUP_VERSION;
+
+    init_system_queues();
+
+    return S_OK;
 }
 
 /***********************************************************************
@@ -413,7 +421,10 @@ HRESULT WINAPI MFStartup(ULONG version, DWORD flags)
  */
 HRESULT WINAPI MFShutdown(void)
 {
-    FIXME("(): stub\n");
+    TRACE("()\n");
+
+    shutdown_system_queues();
+
     return S_OK;
 }
 
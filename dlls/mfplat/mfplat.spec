@@ -16,19 +16,19 @@
 @ stub GetD3DFormatFromMFSubtype
 @ stub LFGetGlobalPool
 @ stub MFAddPeriodicCallback
-@ stub MFAllocateWorkQueue
-@ stub MFAllocateWorkQueueEx
+@ stdcall MFAllocateWorkQueue(ptr)
+@ stdcall MFAllocateWorkQueueEx(long ptr)
 @ stub MFAppendCollection
 @ stub MFAverageTimePerFrameToFrameRate
 @ stub MFBeginCreateFile
 @ stub MFBeginGetHostByName
-@ stub MFBeginRegisterWorkQueueWithMMCSS
-@ stub MFBeginUnregisterWorkQueueWithMMCSS
+@ stdcall MFBeginRegisterWorkQueueWithMMCSS(long wstr long ptr ptr)
+@ stdcall MFBeginUnregisterWorkQueueWithMMCSS(long ptr ptr)
 @ stub MFBlockThread
 @ stub MFCalculateBitmapImageSize
 @ stub MFCalculateImageSize
 @ stub MFCancelCreateFile
-@ stub MFCancelWorkItem
+@ stdcall MFCancelWorkItem(int64)
 @ stub MFCompareFullToPartialMediaType
 @ stub MFCompareSockaddrAddresses
 @ stub MFConvertColorInfoFromDXVA
@@ -38,7 +38,7 @@
 @ stub MFCopyImage
 @ stub MFCreateAMMediaTypeFromMFMediaType
 @ stub MFCreateAlignedMemoryBuffer
-@ stub MFCreateAsyncResult
+@ stdcall MFCreateAsyncResult(ptr ptr ptr ptr)
 @ stdcall MFCreateAttributes(ptr long)
 @ stub MFCreateAudioMediaType
 @ stub MFCreateCollection
@@ -79,8 +79,8 @@
 @ stub MFDeserializePresentationDescriptor
 @ stub MFEndCreateFile
 @ stub MFEndGetHostByName
-@ stub MFEndRegisterWorkQueueWithMMCSS
-@ stub MFEndUnregisterWorkQueueWithMMCSS
+@ stdcall MFEndRegisterWorkQueueWithMMCSS(ptr ptr)
+@ stdcall MFEndUnregisterWorkQueueWithMMCSS(ptr)
 @ stub MFFrameRateToAverageTimePerFrame
 @ stub MFFreeAdaptersAddresses
 @ stub MFGetAdaptersAddresses
@@ -99,10 +99,10 @@
 @ stub MFGetSockaddrFromNumericName
 @ stub MFGetStrideForBitmapInfoHeader
 @ stub MFGetSystemTime
-@ stub MFGetTimerPeriodicity
+@ stdcall MFGetTimerPeriodicity(ptr)
 @ stub MFGetUncompressedVideoFormat
-@ stub MFGetWorkQueueMMCSSClass
-@ stub MFGetWorkQueueMMCSSTaskId
+@ stdcall MFGetWorkQueueMMCSSClass(long ptr ptr)
+@ stdcall MFGetWorkQueueMMCSSTaskId(long ptr)
 @ stub MFHeapAlloc
 @ stub MFHeapFree
 @ stub MFInitAMMediaTypeFromMFMediaType
@@ -116,16 +116,17 @@
 @ stub MFInitMediaTypeFromWaveFormatEx
 @ stub MFInitVideoFormat
 @ stub MFInitVideoFormat_RGB
-@ stub MFInvokeCallback
+@ stdcall MFInvokeCallback(ptr)
 @ stub MFJoinIoPort
-@ stub MFLockPlatform
-@ stub MFLockWorkQueue
-@ stub MFPutWorkItem
-@ stub MFPutWorkItemEx
+@ stdcall MFLockPlatform()
+@ stdcall MFLockWorkQueue(long)
+@ stdcall MFPutWaitingWorkItem(long long ptr ptr)
+@ stdcall MFPutWorkItem(long ptr ptr)
+@ stdcall MFPutWorkItemEx(long ptr)
 @ stub MFRecordError
 @ stub MFRemovePeriodicCallback
-@ stub MFScheduleWorkItem
-@ stub MFScheduleWorkItemEx
+@ stdcall MFScheduleWorkItem(ptr ptr int64 ptr)
+@ stdcall MFScheduleWorkItemEx(ptr int64 ptr)
 @ stub MFSerializeAttributesToStream
 @ stub MFSerializeEvent
 @ stub MFSerializeMediaTypeToStream
@@ -146,8 +147,8 @@
 @ stub MFTraceError
 @ stub MFTraceFuncEnter
 @ stub MFUnblockThread
-@ stub MFUnlockPlatform
-@ stub MFUnlockWorkQueue
+@ stdcall MFUnlockPlatform()
+@ stdcall MFUnlockWorkQueue(long)
 @ stub MFUnwrapMediaType
 @ stub MFValidateMediaTypeSize
 @ stub MFWrapMediaType
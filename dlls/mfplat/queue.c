@@ -0,0 +1,1214 @@
+/*
+ * Media Foundation work queues
+ *
+ * Copyright 2018 Wine project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include <stdarg.h>
+
+#define COBJMACROS
+
+#include "windef.h"
+#include "winbase.h"
+
+#include "mfapi.h"
+#include "mferror.h"
+
+#include "mfplat_private.h"
+
+#include "wine/debug.h"
+#include "wine/list.h"
+#include "wine/unicode.h"
+
+WINE_DEFAULT_DEBUG_CHANNEL(mfplat);
+
+#define SYS_QUEUE_COUNT        (MFASYNC_CALLBACK_QUEUE_LONG_FUNCTION + 1)
+#define MAX_USER_QUEUE_HANDLES 124
+#define MMCSS_CLASS_LENGTH     64
+
+/* Every queue runs on its own thread pool. Standard queues are limited to a
+ * single thread, which makes them serial; multithreaded queues may run as
+ * many items at once as there are processors. Work, timer and wait items
+ * all become callbacks of that pool, so a serial queue stays serial no
+ * matter how an item was queued. */
+struct queue
+{
+    TP_POOL *pool;
+    TP_CALLBACK_ENVIRON_V1 env;
+    CRITICAL_SECTION cs;
+    struct list pending_items;
+    int priority;
+    WCHAR mmcss_class[MMCSS_CLASS_LENGTH];
+    DWORD mmcss_taskid;
+};
+
+struct queue_handle
+{
+    struct queue *queue;
+    LONG refcount;
+    WORD generation;
+};
+
+enum work_item_type
+{
+    WORK_ITEM_WORK,
+    WORK_ITEM_TIMER,
+    WORK_ITEM_WAIT,
+};
+
+struct work_item
+{
+    struct list entry;
+    struct queue *queue;
+    IMFAsyncResult *result;
+    enum work_item_type type;
+    BOOL claimed;
+    MFWORKITEM_KEY key;
+    union
+    {
+        TP_WORK *work;
+        TP_TIMER *timer;
+        TP_WAIT *wait;
+    } u;
+};
+
+struct async_result
+{
+    MFASYNCRESULT result;
+    LONG refcount;
+    IUnknown *object;
+    IUnknown *state;
+};
+
+static CRITICAL_SECTION queues_section;
+static CRITICAL_SECTION_DEBUG queues_critsect_debug =
+{
+    0, 0, &queues_section,
+    { &queues_critsect_debug.ProcessLocksList, &queues_critsect_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": queues_section") }
+};
+static CRITICAL_SECTION queues_section = { &queues_critsect_debug, -1, 0, 0, 0, 0 };
+
+/* serializes platform startup and shutdown, never taken by queue users */
+static CRITICAL_SECTION platform_section;
+static CRITICAL_SECTION_DEBUG platform_critsect_debug =
+{
+    0, 0, &platform_section,
+    { &platform_critsect_debug.ProcessLocksList, &platform_critsect_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": platform_section") }
+};
+static CRITICAL_SECTION platform_section = { &platform_critsect_debug, -1, 0, 0, 0, 0 };
+
+static LONG platform_lock;
+static struct queue system_queues[SYS_QUEUE_COUNT];
+static struct queue_handle user_queues[MAX_USER_QUEUE_HANDLES];
+static LONG next_item_key;
+static LONG next_mmcss_taskid;
+
+static const WCHAR pro_audioW[] = {'P','r','o',' ','A','u','d','i','o',0};
+static const WCHAR audioW[] = {'A','u','d','i','o',0};
+static const WCHAR captureW[] = {'C','a','p','t','u','r','e',0};
+static const WCHAR playbackW[] = {'P','l','a','y','b','a','c','k',0};
+static const WCHAR gamesW[] = {'G','a','m','e','s',0};
+static const WCHAR distributionW[] = {'D','i','s','t','r','i','b','u','t','i','o','n',0};
+
+static const struct
+{
+    const WCHAR *name;
+    int priority;
+}
+mmcss_classes[] =
+{
+    { pro_audioW,    THREAD_PRIORITY_TIME_CRITICAL },
+    { audioW,        THREAD_PRIORITY_HIGHEST },
+    { captureW,      THREAD_PRIORITY_ABOVE_NORMAL },
+    { playbackW,     THREAD_PRIORITY_ABOVE_NORMAL },
+    { gamesW,        THREAD_PRIORITY_ABOVE_NORMAL },
+    { distributionW, THREAD_PRIORITY_ABOVE_NORMAL },
+};
+
+static int get_mmcss_class_priority(const WCHAR *usage_class)
+{
+    unsigned int i;
+
+    for (i = 0; i < sizeof(mmcss_classes) / sizeof(mmcss_classes[0]); i++)
+        if (!strcmpiW(usage_class, mmcss_classes[i].name))
+            return mmcss_classes[i].priority;
+
+    FIXME("Unknown MMCSS class %s.\n", debugstr_w(usage_class));
+    return THREAD_PRIORITY_ABOVE_NORMAL;
+}
+
+static HRESULT init_work_queue(MFASYNC_WORKQUEUE_TYPE type, struct queue *queue)
+{
+    SYSTEM_INFO si;
+
+    if (type == MF_WINDOW_WORKQUEUE)
+        FIXME("Window queues are not supported, creating a standard queue.\n");
+
+    if (!(queue->pool = CreateThreadpool(NULL)))
+        return HRESULT_FROM_WIN32(GetLastError());
+
+    if (type == MF_MULTITHREADED_WORKQUEUE)
+    {
+        GetSystemInfo(&si);
+        SetThreadpoolThreadMaximum(queue->pool, max(si.dwNumberOfProcessors, 2));
+    }
+    else
+        SetThreadpoolThreadMaximum(queue->pool, 1);
+    SetThreadpoolThreadMinimum(queue->pool, 1);
+
+    memset(&queue->env, 0, sizeof(queue->env));
+    queue->env.Version = 1;
+    queue->env.Pool = queue->pool;
+    if (!(queue->env.CleanupGroup = CreateThreadpoolCleanupGroup()))
+    {
+        CloseThreadpool(queue->pool);
+        queue->pool = NULL;
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    InitializeCriticalSection(&queue->cs);
+    list_init(&queue->pending_items);
+    queue->priority = THREAD_PRIORITY_NORMAL;
+    queue->mmcss_class[0] = 0;
+    queue->mmcss_taskid = 0;
+
+    return S_OK;
+}
+
+static void free_work_item(struct work_item *item)
+{
+    IMFAsyncResult_Release(item->result);
+    HeapFree(GetProcessHeap(), 0, item);
+}
+
+/* Pending items are owned by whoever takes them off the queue list first:
+ * the pool callback running them, or MFCancelWorkItem() and queue shutdown
+ * cancelling them. */
+static BOOL claim_work_item(struct work_item *item)
+{
+    struct queue *queue = item->queue;
+    BOOL ret;
+
+    EnterCriticalSection(&queue->cs);
+    if ((ret = !item->claimed))
+    {
+        item->claimed = TRUE;
+        list_remove(&item->entry);
+    }
+    LeaveCriticalSection(&queue->cs);
+
+    return ret;
+}
+
+static void cancel_work_item(struct work_item *item)
+{
+    switch (item->type)
+    {
+    case WORK_ITEM_WORK:
+        WaitForThreadpoolWorkCallbacks(item->u.work, TRUE);
+        CloseThreadpoolWork(item->u.work);
+        break;
+    case WORK_ITEM_TIMER:
+        SetThreadpoolTimer(item->u.timer, NULL, 0, 0);
+        WaitForThreadpoolTimerCallbacks(item->u.timer, TRUE);
+        CloseThreadpoolTimer(item->u.timer);
+        break;
+    case WORK_ITEM_WAIT:
+        SetThreadpoolWait(item->u.wait, NULL, NULL);
+        WaitForThreadpoolWaitCallbacks(item->u.wait, TRUE);
+        CloseThreadpoolWait(item->u.wait);
+        break;
+    }
+
+    free_work_item(item);
+}
+
+static void shutdown_queue(struct queue *queue)
+{
+    struct work_item *item, *next;
+    struct list items;
+
+    if (!queue->pool)
+        return;
+
+    list_init(&items);
+
+    EnterCriticalSection(&queue->cs);
+    LIST_FOR_EACH_ENTRY_SAFE(item, next, &queue->pending_items, struct work_item, entry)
+    {
+        item->claimed = TRUE;
+        list_remove(&item->entry);
+        list_add_tail(&items, &item->entry);
+    }
+    LeaveCriticalSection(&queue->cs);
+
+    LIST_FOR_EACH_ENTRY_SAFE(item, next, &items, struct work_item, entry)
+        cancel_work_item(item);
+
+    /* wait for the callbacks that are still running */
+    CloseThreadpoolCleanupGroupMembers(queue->env.CleanupGroup, FALSE, NULL);
+    CloseThreadpoolCleanupGroup(queue->env.CleanupGroup);
+    CloseThreadpool(queue->pool);
+    DeleteCriticalSection(&queue->cs);
+
+    memset(queue, 0, sizeof(*queue));
+}
+
+static void invoke_async_callback(IMFAsyncResult *result)
+{
+    MFASYNCRESULT *async = (MFASYNCRESULT *)result;
+
+    if (async->pCallback)
+        IMFAsyncCallback_Invoke(async->pCallback, result);
+    else if (async->hEvent)
+        SetEvent(async->hEvent);
+}
+
+static void invoke_work_item(struct work_item *item)
+{
+    int priority = item->queue->priority, old_priority = THREAD_PRIORITY_NORMAL;
+
+    TRACE("Invoking result %p from queue %p.\n", item->result, item->queue);
+
+    if (priority != THREAD_PRIORITY_NORMAL)
+    {
+        old_priority = GetThreadPriority(GetCurrentThread());
+        SetThreadPriority(GetCurrentThread(), priority);
+    }
+
+    invoke_async_callback(item->result);
+
+    if (priority != THREAD_PRIORITY_NORMAL)
+        SetThreadPriority(GetCurrentThread(), old_priority);
+}
+
+static void CALLBACK work_item_cb(TP_CALLBACK_INSTANCE *instance, void *context, TP_WORK *work)
+{
+    struct work_item *item = context;
+
+    if (!claim_work_item(item))
+        return;
+
+    invoke_work_item(item);
+    CloseThreadpoolWork(work);
+    free_work_item(item);
+}
+
+static void CALLBACK timer_item_cb(TP_CALLBACK_INSTANCE *instance, void *context, TP_TIMER *timer)
+{
+    struct work_item *item = context;
+
+    if (!claim_work_item(item))
+        return;
+
+    invoke_work_item(item);
+    CloseThreadpoolTimer(timer);
+    free_work_item(item);
+}
+
+static void CALLBACK wait_item_cb(TP_CALLBACK_INSTANCE *instance, void *context, TP_WAIT *wait,
+        TP_WAIT_RESULT wait_result)
+{
+    struct work_item *item = context;
+
+    if (!claim_work_item(item))
+        return;
+
+    if (wait_result != WAIT_OBJECT_0)
+        IMFAsyncResult_SetStatus(item->result, HRESULT_FROM_WIN32(wait_result));
+
+    invoke_work_item(item);
+    CloseThreadpoolWait(wait);
+    free_work_item(item);
+}
+
+static struct work_item *alloc_work_item(struct queue *queue, IMFAsyncResult *result, enum work_item_type type)
+{
+    struct work_item *item;
+
+    if (!(item = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*item))))
+        return NULL;
+
+    item->queue = queue;
+    item->result = result;
+    IMFAsyncResult_AddRef(result);
+    item->type = type;
+    item->key = ((MFWORKITEM_KEY)(type + 1) << 32) | (DWORD)InterlockedIncrement(&next_item_key);
+
+    return item;
+}
+
+static void add_pending_item(struct work_item *item)
+{
+    struct queue *queue = item->queue;
+
+    EnterCriticalSection(&queue->cs);
+    list_add_tail(&queue->pending_items, &item->entry);
+    LeaveCriticalSection(&queue->cs);
+}
+
+static HRESULT queue_submit_item(struct queue *queue, IMFAsyncResult *result)
+{
+    struct work_item *item;
+
+    if (!(item = alloc_work_item(queue, result, WORK_ITEM_WORK)))
+        return E_OUTOFMEMORY;
+
+    if (!(item->u.work = CreateThreadpoolWork(work_item_cb, item, &queue->env)))
+    {
+        free_work_item(item);
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    add_pending_item(item);
+    SubmitThreadpoolWork(item->u.work);
+
+    return S_OK;
+}
+
+static HRESULT queue_submit_timer(struct queue *queue, IMFAsyncResult *result, INT64 timeout,
+        MFWORKITEM_KEY *key)
+{
+    struct work_item *item;
+    LARGE_INTEGER due;
+    FILETIME ft;
+
+    if (!(item = alloc_work_item(queue, result, WORK_ITEM_TIMER)))
+        return E_OUTOFMEMORY;
+
+    if (!(item->u.timer = CreateThreadpoolTimer(timer_item_cb, item, &queue->env)))
+    {
+        free_work_item(item);
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    /* timeouts are given in milliseconds, and meant to be negative */
+    due.QuadPart = (timeout > 0 ? -timeout : timeout) * 10000;
+    ft.dwLowDateTime = due.u.LowPart;
+    ft.dwHighDateTime = due.u.HighPart;
+
+    if (key)
+        *key = item->key;
+
+    add_pending_item(item);
+    SetThreadpoolTimer(item->u.timer, &ft, 0, 0);
+
+    return S_OK;
+}
+
+static HRESULT queue_submit_wait(struct queue *queue, HANDLE event, IMFAsyncResult *result,
+        MFWORKITEM_KEY *key)
+{
+    struct work_item *item;
+
+    if (!(item = alloc_work_item(queue, result, WORK_ITEM_WAIT)))
+        return E_OUTOFMEMORY;
+
+    if (!(item->u.wait = CreateThreadpoolWait(wait_item_cb, item, &queue->env)))
+    {
+        free_work_item(item);
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    if (key)
+        *key = item->key;
+
+    add_pending_item(item);
+    SetThreadpoolWait(item->u.wait, event, NULL);
+
+    return S_OK;
+}
+
+static struct queue_handle *get_user_queue_handle(DWORD queue_id)
+{
+    unsigned int index = (queue_id >> 16) - 1;
+
+    if (index >= MAX_USER_QUEUE_HANDLES || !user_queues[index].refcount ||
+            user_queues[index].generation != LOWORD(queue_id))
+        return NULL;
+
+    return &user_queues[index];
+}
+
+static HRESULT lock_user_queue(DWORD queue_id)
+{
+    struct queue_handle *handle;
+    HRESULT hr = MF_E_INVALID_WORKQUEUE;
+
+    EnterCriticalSection(&queues_section);
+    if ((handle = get_user_queue_handle(queue_id)))
+    {
+        handle->refcount++;
+        hr = S_OK;
+    }
+    LeaveCriticalSection(&queues_section);
+
+    return hr;
+}
+
+static HRESULT unlock_user_queue(DWORD queue_id)
+{
+    struct queue_handle *handle;
+    struct queue *queue = NULL;
+    HRESULT hr = MF_E_INVALID_WORKQUEUE;
+
+    EnterCriticalSection(&queues_section);
+    if ((handle = get_user_queue_handle(queue_id)))
+    {
+        if (!--handle->refcount)
+        {
+            queue = handle->queue;
+            handle->queue = NULL;
+            handle->generation++;
+        }
+        hr = S_OK;
+    }
+    LeaveCriticalSection(&queues_section);
+
+    if (queue)
+    {
+        shutdown_queue(queue);
+        HeapFree(GetProcessHeap(), 0, queue);
+    }
+
+    return hr;
+}
+
+/* Looks up a queue, keeping private queues alive until release_queue(). */
+static HRESULT grab_queue(DWORD queue_id, struct queue **ret)
+{
+    struct queue_handle *handle;
+    HRESULT hr = MF_E_INVALID_WORKQUEUE;
+
+    EnterCriticalSection(&queues_section);
+    if (!platform_lock)
+        hr = MF_E_SHUTDOWN;
+    else if (queue_id & MFASYNC_CALLBACK_QUEUE_PRIVATE_MASK)
+    {
+        if ((handle = get_user_queue_handle(queue_id)))
+        {
+            handle->refcount++;
+            *ret = handle->queue;
+            hr = S_OK;
+        }
+    }
+    else
+    {
+        if (queue_id == MFASYNC_CALLBACK_QUEUE_UNDEFINED)
+            queue_id = MFASYNC_CALLBACK_QUEUE_STANDARD;
+        if (queue_id < SYS_QUEUE_COUNT && system_queues[queue_id].pool)
+        {
+            *ret = &system_queues[queue_id];
+            hr = S_OK;
+        }
+    }
+    LeaveCriticalSection(&queues_section);
+
+    if (FAILED(hr))
+        WARN("Invalid queue %#x.\n", queue_id);
+
+    return hr;
+}
+
+static void release_queue(DWORD queue_id)
+{
+    if (queue_id & MFASYNC_CALLBACK_QUEUE_PRIVATE_MASK)
+        unlock_user_queue(queue_id);
+}
+
+static DWORD get_callback_queue(IMFAsyncResult *result, DWORD default_queue)
+{
+    MFASYNCRESULT *async = (MFASYNCRESULT *)result;
+    DWORD flags, queue_id;
+
+    if (!async->pCallback || FAILED(IMFAsyncCallback_GetParameters(async->pCallback, &flags, &queue_id)))
+        return default_queue;
+
+    return queue_id;
+}
+
+void init_system_queues(void)
+{
+    EnterCriticalSection(&platform_section);
+    EnterCriticalSection(&queues_section);
+
+    if (!platform_lock)
+    {
+        init_work_queue(MF_STANDARD_WORKQUEUE, &system_queues[MFASYNC_CALLBACK_QUEUE_STANDARD]);
+        init_work_queue(MF_STANDARD_WORKQUEUE, &system_queues[MFASYNC_CALLBACK_QUEUE_RT]);
+        system_queues[MFASYNC_CALLBACK_QUEUE_RT].priority = THREAD_PRIORITY_HIGHEST;
+        init_work_queue(MF_MULTITHREADED_WORKQUEUE, &system_queues[MFASYNC_CALLBACK_QUEUE_IO]);
+        init_work_queue(MF_STANDARD_WORKQUEUE, &system_queues[MFASYNC_CALLBACK_QUEUE_TIMER]);
+        init_work_queue(MF_MULTITHREADED_WORKQUEUE, &system_queues[MFASYNC_CALLBACK_QUEUE_MULTITHREADED]);
+        if (SUCCEEDED(init_work_queue(MF_MULTITHREADED_WORKQUEUE, &system_queues[MFASYNC_CALLBACK_QUEUE_LONG_FUNCTION])))
+            system_queues[MFASYNC_CALLBACK_QUEUE_LONG_FUNCTION].env.u.s.LongFunction = 1;
+    }
+    platform_lock++;
+
+    LeaveCriticalSection(&queues_section);
+    LeaveCriticalSection(&platform_section);
+}
+
+void shutdown_system_queues(void)
+{
+    BOOL last;
+    int i;
+
+    EnterCriticalSection(&platform_section);
+
+    EnterCriticalSection(&queues_section);
+    if ((last = platform_lock == 1))
+        platform_lock = 0;
+    else if (platform_lock)
+        platform_lock--;
+    LeaveCriticalSection(&queues_section);
+
+    /* Queue users see MF_E_SHUTDOWN from now on, wait for what is already queued. */
+    if (last)
+    {
+        for (i = 0; i < SYS_QUEUE_COUNT; i++)
+            shutdown_queue(&system_queues[i]);
+    }
+
+    LeaveCriticalSection(&platform_section);
+}
+
+/***********************************************************************
+ *      MFLockPlatform (mfplat.@)
+ */
+HRESULT WINAPI MFLockPlatform(void)
+{
+    TRACE("()\n");
+
+    EnterCriticalSection(&queues_section);
+    platform_lock++;
+    LeaveCriticalSection(&queues_section);
+
+    return S_OK;
+}
+
+/***********************************************************************
+ *      MFUnlockPlatform (mfplat.@)
+ */
+HRESULT WINAPI MFUnlockPlatform(void)
+{
+    TRACE("()\n");
+
+    shutdown_system_queues();
+
+    return S_OK;
+}
+
+/***********************************************************************
+ *      MFAllocateWorkQueueEx (mfplat.@)
+ */
+HRESULT WINAPI MFAllocateWorkQueueEx(MFASYNC_WORKQUEUE_TYPE type, DWORD *queue_id)
+{
+    struct queue *queue;
+    unsigned int i;
+    HRESULT hr;
+
+    TRACE("(%d, %p)\n", type, queue_id);
+
+    if (!queue_id)
+        return E_INVALIDARG;
+
+    if (!(queue = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*queue))))
+        return E_OUTOFMEMORY;
+
+    if (FAILED(hr = init_work_queue(type, queue)))
+    {
+        HeapFree(GetProcessHeap(), 0, queue);
+        return hr;
+    }
+
+    EnterCriticalSection(&queues_section);
+    if (!platform_lock)
+        hr = MF_E_SHUTDOWN;
+    else
+    {
+        hr = E_OUTOFMEMORY;
+        for (i = 0; i < MAX_USER_QUEUE_HANDLES; i++)
+        {
+            if (user_queues[i].refcount)
+                continue;
+
+            user_queues[i].queue = queue;
+            user_queues[i].refcount = 1;
+            *queue_id = ((i + 1) << 16) | user_queues[i].generation;
+            hr = S_OK;
+            break;
+        }
+    }
+    LeaveCriticalSection(&queues_section);
+
+    if (FAILED(hr))
+    {
+        shutdown_queue(queue);
+        HeapFree(GetProcessHeap(), 0, queue);
+    }
+    else
+        TRACE("Allocated queue %#x.\n", *queue_id);
+
+    return hr;
+}
+
+/***********************************************************************
+ *      MFAllocateWorkQueue (mfplat.@)
+ */
+HRESULT WINAPI MFAllocateWorkQueue(DWORD *queue)
+{
+    TRACE("(%p)\n", queue);
+
+    return MFAllocateWorkQueueEx(MF_STANDARD_WORKQUEUE, queue);
+}
+
+/***********************************************************************
+ *      MFLockWorkQueue (mfplat.@)
+ */
+HRESULT WINAPI MFLockWorkQueue(DWORD queue)
+{
+    TRACE("(%#x)\n", queue);
+
+    if (!(queue & MFASYNC_CALLBACK_QUEUE_PRIVATE_MASK))
+        return S_OK;
+
+    return lock_user_queue(queue);
+}
+
+/***********************************************************************
+ *      MFUnlockWorkQueue (mfplat.@)
+ */
+HRESULT WINAPI MFUnlockWorkQueue(DWORD queue)
+{
+    TRACE("(%#x)\n", queue);
+
+    if (!(queue & MFASYNC_CALLBACK_QUEUE_PRIVATE_MASK))
+        return S_OK;
+
+    return unlock_user_queue(queue);
+}
+
+/***********************************************************************
+ *      MFPutWorkItemEx (mfplat.@)
+ */
+HRESULT WINAPI MFPutWorkItemEx(DWORD queue_id, IMFAsyncResult *result)
+{
+    struct queue *queue;
+    HRESULT hr;
+
+    TRACE("(%#x, %p)\n", queue_id, result);
+
+    if (!result)
+        return E_INVALIDARG;
+
+    if (FAILED(hr = grab_queue(queue_id, &queue)))
+        return hr;
+
+    hr = queue_submit_item(queue, result);
+
+    release_queue(queue_id);
+
+    return hr;
+}
+
+/***********************************************************************
+ *      MFPutWorkItem (mfplat.@)
+ */
+HRESULT WINAPI MFPutWorkItem(DWORD queue, IMFAsyncCallback *callback, IUnknown *state)
+{
+    IMFAsyncResult *result;
+    HRESULT hr;
+
+    TRACE("(%#x, %p, %p)\n", queue, callback, state);
+
+    if (FAILED(hr = MFCreateAsyncResult(NULL, callback, state, &result)))
+        return hr;
+
+    hr = MFPutWorkItemEx(queue, result);
+
+    IMFAsyncResult_Release(result);
+
+    return hr;
+}
+
+/***********************************************************************
+ *      MFInvokeCallback (mfplat.@)
+ */
+HRESULT WINAPI MFInvokeCallback(IMFAsyncResult *result)
+{
+    TRACE("(%p)\n", result);
+
+    if (!result)
+        return E_INVALIDARG;
+
+    return MFPutWorkItemEx(get_callback_queue(result, MFASYNC_CALLBACK_QUEUE_STANDARD), result);
+}
+
+/***********************************************************************
+ *      MFScheduleWorkItemEx (mfplat.@)
+ */
+HRESULT WINAPI MFScheduleWorkItemEx(IMFAsyncResult *result, INT64 timeout, MFWORKITEM_KEY *key)
+{
+    struct queue *queue;
+    HRESULT hr;
+
+    TRACE("(%p, %s, %p)\n", result, wine_dbgstr_longlong(timeout), key);
+
+    if (!result)
+        return E_INVALIDARG;
+
+    if (FAILED(hr = grab_queue(MFASYNC_CALLBACK_QUEUE_TIMER, &queue)))
+        return hr;
+
+    hr = queue_submit_timer(queue, result, timeout, key);
+
+    release_queue(MFASYNC_CALLBACK_QUEUE_TIMER);
+
+    return hr;
+}
+
+/***********************************************************************
+ *      MFScheduleWorkItem (mfplat.@)
+ */
+HRESULT WINAPI MFScheduleWorkItem(IMFAsyncCallback *callback, IUnknown *state, INT64 timeout, MFWORKITEM_KEY *key)
+{
+    IMFAsyncResult *result;
+    HRESULT hr;
+
+    TRACE("(%p, %p, %s, %p)\n", callback, state, wine_dbgstr_longlong(timeout), key);
+
+    if (FAILED(hr = MFCreateAsyncResult(NULL, callback, state, &result)))
+        return hr;
+
+    hr = MFScheduleWorkItemEx(result, timeout, key);
+
+    IMFAsyncResult_Release(result);
+
+    return hr;
+}
+
+/***********************************************************************
+ *      MFPutWaitingWorkItem (mfplat.@)
+ */
+HRESULT WINAPI MFPutWaitingWorkItem(HANDLE event, LONG priority, IMFAsyncResult *result, MFWORKITEM_KEY *key)
+{
+    struct queue *queue;
+    DWORD queue_id;
+    HRESULT hr;
+
+    TRACE("(%p, %d, %p, %p)\n", event, priority, result, key);
+
+    if (!result)
+        return E_INVALIDARG;
+
+    queue_id = get_callback_queue(result, MFASYNC_CALLBACK_QUEUE_STANDARD);
+    if (FAILED(hr = grab_queue(queue_id, &queue)))
+        return hr;
+
+    hr = queue_submit_wait(queue, event, result, key);
+
+    release_queue(queue_id);
+
+    return hr;
+}
+
+static struct work_item *claim_item_by_key(struct queue *queue, MFWORKITEM_KEY key)
+{
+    struct work_item *item, *ret = NULL;
+
+    EnterCriticalSection(&queue->cs);
+    LIST_FOR_EACH_ENTRY(item, &queue->pending_items, struct work_item, entry)
+    {
+        if (item->key == key && item->type != WORK_ITEM_WORK)
+        {
+            item->claimed = TRUE;
+            list_remove(&item->entry);
+            ret = item;
+            break;
+        }
+    }
+    LeaveCriticalSection(&queue->cs);
+
+    return ret;
+}
+
+/***********************************************************************
+ *      MFCancelWorkItem (mfplat.@)
+ */
+HRESULT WINAPI MFCancelWorkItem(MFWORKITEM_KEY key)
+{
+    struct work_item *item = NULL;
+    unsigned int i;
+
+    TRACE("(%s)\n", wine_dbgstr_longlong(key));
+
+    EnterCriticalSection(&queues_section);
+    for (i = 0; i < SYS_QUEUE_COUNT && !item; i++)
+    {
+        if (system_queues[i].pool)
+            item = claim_item_by_key(&system_queues[i], key);
+    }
+    for (i = 0; i < MAX_USER_QUEUE_HANDLES && !item; i++)
+    {
+        if (user_queues[i].refcount)
+            item = claim_item_by_key(user_queues[i].queue, key);
+    }
+    LeaveCriticalSection(&queues_section);
+
+    if (!item)
+        return MF_E_NOT_FOUND;
+
+    cancel_work_item(item);
+
+    return S_OK;
+}
+
+/***********************************************************************
+ *      MFGetTimerPeriodicity (mfplat.@)
+ */
+HRESULT WINAPI MFGetTimerPeriodicity(DWORD *periodicity)
+{
+    TRACE("(%p)\n", periodicity);
+
+    if (!periodicity)
+        return E_POINTER;
+
+    *periodicity = 10;
+    return S_OK;
+}
+
+/***********************************************************************
+ *      MFBeginRegisterWorkQueueWithMMCSS (mfplat.@)
+ */
+HRESULT WINAPI MFBeginRegisterWorkQueueWithMMCSS(DWORD queue_id, const WCHAR *usage_class, DWORD taskid,
+        IMFAsyncCallback *callback, IUnknown *state)
+{
+    IMFAsyncResult *result;
+    struct queue *queue;
+    HRESULT hr;
+
+    TRACE("(%#x, %s, %u, %p, %p)\n", queue_id, debugstr_w(usage_class), taskid, callback, state);
+
+    if (FAILED(hr = grab_queue(queue_id, &queue)))
+        return hr;
+
+    EnterCriticalSection(&queue->cs);
+    if (usage_class && *usage_class)
+    {
+        lstrcpynW(queue->mmcss_class, usage_class, MMCSS_CLASS_LENGTH);
+        queue->priority = get_mmcss_class_priority(usage_class);
+        queue->mmcss_taskid = taskid ? taskid : InterlockedIncrement(&next_mmcss_taskid);
+    }
+    else
+    {
+        queue->mmcss_class[0] = 0;
+        queue->priority = THREAD_PRIORITY_NORMAL;
+        queue->mmcss_taskid = 0;
+    }
+    taskid = queue->mmcss_taskid;
+    LeaveCriticalSection(&queue->cs);
+
+    release_queue(queue_id);
+
+    if (FAILED(hr = MFCreateAsyncResult(NULL, callback, state, &result)))
+        return hr;
+
+    /* handed back by MFEndRegisterWorkQueueWithMMCSS() */
+    ((MFASYNCRESULT *)result)->dwBytesTransferred = taskid;
+
+    hr = MFInvokeCallback(result);
+    IMFAsyncResult_Release(result);
+
+    return hr;
+}
+
+/***********************************************************************
+ *      MFEndRegisterWorkQueueWithMMCSS (mfplat.@)
+ */
+HRESULT WINAPI MFEndRegisterWorkQueueWithMMCSS(IMFAsyncResult *result, DWORD *taskid)
+{
+    TRACE("(%p, %p)\n", result, taskid);
+
+    if (!result || !taskid)
+        return E_INVALIDARG;
+
+    *taskid = ((MFASYNCRESULT *)result)->dwBytesTransferred;
+
+    return IMFAsyncResult_GetStatus(result);
+}
+
+/***********************************************************************
+ *      MFBeginUnregisterWorkQueueWithMMCSS (mfplat.@)
+ */
+HRESULT WINAPI MFBeginUnregisterWorkQueueWithMMCSS(DWORD queue_id, IMFAsyncCallback *callback, IUnknown *state)
+{
+    IMFAsyncResult *result;
+    struct queue *queue;
+    HRESULT hr;
+
+    TRACE("(%#x, %p, %p)\n", queue_id, callback, state);
+
+    if (FAILED(hr = grab_queue(queue_id, &queue)))
+        return hr;
+
+    EnterCriticalSection(&queue->cs);
+    queue->mmcss_class[0] = 0;
+    queue->priority = THREAD_PRIORITY_NORMAL;
+    queue->mmcss_taskid = 0;
+    LeaveCriticalSection(&queue->cs);
+
+    release_queue(queue_id);
+
+    if (FAILED(hr = MFCreateAsyncResult(NULL, callback, state, &result)))
+        return hr;
+
+    hr = MFInvokeCallback(result);
+    IMFAsyncResult_Release(result);
+
+    return hr;
+}
+
+/***********************************************************************
+ *      MFEndUnregisterWorkQueueWithMMCSS (mfplat.@)
+ */
+HRESULT WINAPI MFEndUnregisterWorkQueueWithMMCSS(IMFAsyncResult *result)
+{
+    TRACE("(%p)\n", result);
+
+    if (!result)
+        return E_INVALIDARG;
+
+    return IMFAsyncResult_GetStatus(result);
+}
+
+/***********************************************************************
+ *      MFGetWorkQueueMMCSSClass (mfplat.@)
+ */
+HRESULT WINAPI MFGetWorkQueueMMCSSClass(DWORD queue_id, WCHAR *usage_class, DWORD *length)
+{
+    struct queue *queue;
+    DWORD len;
+    HRESULT hr;
+
+    TRACE("(%#x, %p, %p)\n", queue_id, usage_class, length);
+
+    if (!length)
+        return E_INVALIDARG;
+
+    if (FAILED(hr = grab_queue(queue_id, &queue)))
+        return hr;
+
+    EnterCriticalSection(&queue->cs);
+    len = strlenW(queue->mmcss_class) + 1;
+    if (usage_class)
+    {
+        if (*length < len)
+            hr = MF_E_BUFFERTOOSMALL;
+        else
+            memcpy(usage_class, queue->mmcss_class, len * sizeof(WCHAR));
+    }
+    *length = len;
+    LeaveCriticalSection(&queue->cs);
+
+    release_queue(queue_id);
+
+    return hr;
+}
+
+/***********************************************************************
+ *      MFGetWorkQueueMMCSSTaskId (mfplat.@)
+ */
+HRESULT WINAPI MFGetWorkQueueMMCSSTaskId(DWORD queue_id, DWORD *taskid)
+{
+    struct queue *queue;
+    HRESULT hr;
+
+    TRACE("(%#x, %p)\n", queue_id, taskid);
+
+    if (!taskid)
+        return E_INVALIDARG;
+
+    if (FAILED(hr = grab_queue(queue_id, &queue)))
+        return hr;
+
+    EnterCriticalSection(&queue->cs);
+    *taskid = queue->mmcss_taskid;
+    LeaveCriticalSection(&queue->cs);
+
+    release_queue(queue_id);
+
+    return S_OK;
+}
+
+static struct async_result *impl_from_IMFAsyncResult(IMFAsyncResult *iface)
+{
+    return CONTAINING_RECORD(iface, struct async_result, result.AsyncResult);
+}
+
+static HRESULT WINAPI async_result_QueryInterface(IMFAsyncResult *iface, REFIID riid, void **obj)
+{
+    TRACE("(%p, %s, %p)\n", iface, debugstr_guid(riid), obj);
+
+    if (IsEqualIID(riid, &IID_IMFAsyncResult) ||
+            IsEqualIID(riid, &IID_IUnknown))
+    {
+        *obj = iface;
+        IMFAsyncResult_AddRef(iface);
+        return S_OK;
+    }
+
+    *obj = NULL;
+    WARN("Unsupported interface %s.\n", debugstr_guid(riid));
+    return E_NOINTERFACE;
+}
+
+static ULONG WINAPI async_result_AddRef(IMFAsyncResult *iface)
+{
+    struct async_result *result = impl_from_IMFAsyncResult(iface);
+    ULONG refcount = InterlockedIncrement(&result->refcount);
+
+    TRACE("(%p) refcount=%u\n", iface, refcount);
+
+    return refcount;
+}
+
+static ULONG WINAPI async_result_Release(IMFAsyncResult *iface)
+{
+    struct async_result *result = impl_from_IMFAsyncResult(iface);
+    ULONG refcount = InterlockedDecrement(&result->refcount);
+
+    TRACE("(%p) refcount=%u\n", iface, refcount);
+
+    if (!refcount)
+    {
+        if (result->result.pCallback)
+            IMFAsyncCallback_Release(result->result.pCallback);
+        if (result->object)
+            IUnknown_Release(result->object);
+        if (result->state)
+            IUnknown_Release(result->state);
+        HeapFree(GetProcessHeap(), 0, result);
+    }
+
+    return refcount;
+}
+
+static HRESULT WINAPI async_result_GetState(IMFAsyncResult *iface, IUnknown **state)
+{
+    struct async_result *result = impl_from_IMFAsyncResult(iface);
+
+    TRACE("(%p, %p)\n", iface, state);
+
+    if (!result->state)
+        return E_POINTER;
+
+    *state = result->state;
+    IUnknown_AddRef(*state);
+
+    return S_OK;
+}
+
+static HRESULT WINAPI async_result_GetStatus(IMFAsyncResult *iface)
+{
+    struct async_result *result = impl_from_IMFAsyncResult(iface);
+
+    TRACE("(%p)\n", iface);
+
+    return result->result.hrStatusResult;
+}
+
+static HRESULT WINAPI async_result_SetStatus(IMFAsyncResult *iface, HRESULT status)
+{
+    struct async_result *result = impl_from_IMFAsyncResult(iface);
+
+    TRACE("(%p, %#x)\n", iface, status);
+
+    result->result.hrStatusResult = status;
+
+    return S_OK;
+}
+
+static HRESULT WINAPI async_result_GetObject(IMFAsyncResult *iface, IUnknown **object)
+{
+    struct async_result *result = impl_from_IMFAsyncResult(iface);
+
+    TRACE("(%p, %p)\n", iface, object);
+
+    if (!result->object)
+        return E_POINTER;
+
+    *object = result->object;
+    IUnknown_AddRef(*object);
+
+    return S_OK;
+}
+
+static IUnknown * WINAPI async_result_GetStateNoAddRef(IMFAsyncResult *iface)
+{
+    struct async_result *result = impl_from_IMFAsyncResult(iface);
+
+    TRACE("(%p)\n", iface);
+
+    return result->state;
+}
+
+static const IMFAsyncResultVtbl async_result_vtbl =
+{
+    async_result_QueryInterface,
+    async_result_AddRef,
+    async_result_Release,
+    async_result_GetState,
+    async_result_GetStatus,
+    async_result_SetStatus,
+    async_result_GetObject,
+    async_result_GetStateNoAddRef,
+};
+
+/***********************************************************************
+ *      MFCreateAsyncResult (mfplat.@)
+ */
+HRESULT WINAPI MFCreateAsyncResult(IUnknown *object, IMFAsyncCallback *callback, IUnknown *state, IMFAsyncResult **out)
+{
+    struct async_result *result;
+
+    TRACE("(%p, %p, %p, %p)\n", object, callback, state, out);
+
+    if (!out)
+        return E_INVALIDARG;
+
+    if (!(result = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*result))))
+        return E_OUTOFMEMORY;
+
+    result->result.AsyncResult.lpVtbl = &async_result_vtbl;
+    result->refcount = 1;
+    result->object = object;
+    if (result->object)
+        IUnknown_AddRef(result->object);
+    result->result.pCallback = callback;
+    if (result->result.pCallback)
+        IMFAsyncCallback_AddRef(result->result.pCallback);
+    result->state = state;
+    if (result->state)
+        IUnknown_AddRef(result->state);
+
+    *out = &result->result.AsyncResult;
+
+    return S_OK;
+}
@@ -203,7 +203,7 @@ static void test_MFCreateMediaType(void)
     IMFMediaType *mediatype;
 
     hr = MFStartup(MF_VERSION, MFSTARTUP_FULL);
-    todo_wine ok(hr == S_OK, "got 0x%08x\n", hr);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
 
 if(0)
 {
@@ -248,6 +248,136 @@ static void test_MFCreateAttributes(void)
 }
 
 
+struct test_callback
+{
+    IMFAsyncCallback IMFAsyncCallback_iface;
+    HANDLE event;
+};
+
+static struct test_callback *impl_from_IMFAsyncCallback(IMFAsyncCallback *iface)
+{
+    return CONTAINING_RECORD(iface, struct test_callback, IMFAsyncCallback_iface);
+}
+
+static HRESULT WINAPI testcallback_QueryInterface(IMFAsyncCallback *iface, REFIID riid, void **obj)
+{
+    if (IsEqualIID(riid, &IID_IMFAsyncCallback) ||
+            IsEqualIID(riid, &IID_IUnknown))
+    {
+        *obj = iface;
+        IMFAsyncCallback_AddRef(iface);
+        return S_OK;
+    }
+
+    *obj = NULL;
+    return E_NOINTERFACE;
+}
+
+static ULONG WINAPI testcallback_AddRef(IMFAsyncCallback *iface)
+{
+    return 2;
+}
+
+static ULONG WINAPI testcallback_Release(IMFAsyncCallback *iface)
+{
+    return 1;
+}
+
+static HRESULT WINAPI testcallback_GetParameters(IMFAsyncCallback *iface, DWORD *flags, DWORD *queue)
+{
+    return E_NOTIMPL;
+}
+
+static HRESULT WINAPI testcallback_Invoke(IMFAsyncCallback *iface, IMFAsyncResult *result)
+{
+    struct test_callback *callback = impl_from_IMFAsyncCallback(iface);
+
+    ok(result != NULL, "Unexpected result object.\n");
+    SetEvent(callback->event);
+
+    return S_OK;
+}
+
+static const IMFAsyncCallbackVtbl testcallbackvtbl =
+{
+    testcallback_QueryInterface,
+    testcallback_AddRef,
+    testcallback_Release,
+    testcallback_GetParameters,
+    testcallback_Invoke,
+};
+
+static void test_work_queue(void)
+{
+    struct test_callback callback = { { &testcallbackvtbl } };
+    IMFAsyncResult *result;
+    IUnknown *object;
+    MFWORKITEM_KEY key;
+    DWORD queue, res;
+    HRESULT hr;
+
+    hr = MFCreateAsyncResult(NULL, &callback.IMFAsyncCallback_iface, NULL, &result);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    hr = IMFAsyncResult_GetObject(result, &object);
+    ok(hr == E_POINTER, "got 0x%08x\n", hr);
+    hr = IMFAsyncResult_GetStatus(result);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    IMFAsyncResult_Release(result);
+
+    hr = MFAllocateWorkQueue(&queue);
+    ok(hr == MF_E_SHUTDOWN, "got 0x%08x\n", hr);
+
+    hr = MFStartup(MF_VERSION, MFSTARTUP_FULL);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+
+    callback.event = CreateEventA(NULL, FALSE, FALSE, NULL);
+
+    hr = MFPutWorkItem(MFASYNC_CALLBACK_QUEUE_STANDARD, &callback.IMFAsyncCallback_iface, NULL);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    res = WaitForSingleObject(callback.event, 1000);
+    ok(res == WAIT_OBJECT_0, "got %u\n", res);
+
+    hr = MFAllocateWorkQueue(&queue);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    ok(queue & MFASYNC_CALLBACK_QUEUE_PRIVATE_MASK, "got queue %#x\n", queue);
+
+    hr = MFLockWorkQueue(queue);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    hr = MFUnlockWorkQueue(queue);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+
+    hr = MFPutWorkItem(queue, &callback.IMFAsyncCallback_iface, NULL);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    res = WaitForSingleObject(callback.event, 1000);
+    ok(res == WAIT_OBJECT_0, "got %u\n", res);
+
+    hr = MFUnlockWorkQueue(queue);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    hr = MFUnlockWorkQueue(queue);
+    ok(hr == MF_E_INVALID_WORKQUEUE, "got 0x%08x\n", hr);
+    hr = MFPutWorkItem(queue, &callback.IMFAsyncCallback_iface, NULL);
+    ok(hr == MF_E_INVALID_WORKQUEUE, "got 0x%08x\n", hr);
+
+    hr = MFScheduleWorkItem(&callback.IMFAsyncCallback_iface, NULL, -10, &key);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    res = WaitForSingleObject(callback.event, 1000);
+    ok(res == WAIT_OBJECT_0, "got %u\n", res);
+    hr = MFCancelWorkItem(key);
+    ok(hr == MF_E_NOT_FOUND, "got 0x%08x\n", hr);
+
+    hr = MFScheduleWorkItem(&callback.IMFAsyncCallback_iface, NULL, -5000, &key);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    hr = MFCancelWorkItem(key);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    res = WaitForSingleObject(callback.event, 100);
+    ok(res == WAIT_TIMEOUT, "got %u\n", res);
+
+    CloseHandle(callback.event);
+
+    hr = MFShutdown();
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+}
+
 START_TEST(mfplat)
 {
     CoInitialize(NULL);
@@ -258,6 +388,7 @@ START_TEST(mfplat)
     test_source_resolver();
     test_MFCreateMediaType();
     test_MFCreateAttributes();
+    test_work_queue();
 
     CoUninitialize();
 }
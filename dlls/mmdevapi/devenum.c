@@ -596,6 +596,15 @@ static HRESULT WINAPI MMDevice_Activate(IMMDevice *iface, REFIID riid, DWORD cls
 
     if (IsEqualIID(riid, &IID_IAudioClient)){
         hr = drvs.pGetAudioEndpoint(&This->devguid, iface, (IAudioClient**)ppv);
+    }else if (IsEqualIID(riid, &IID_IAudioClient2) ||
+            IsEqualIID(riid, &IID_IAudioClient3)){
+        IAudioClient *client;
+
+        hr = drvs.pGetAudioEndpoint(&This->devguid, iface, &client);
+        if (SUCCEEDED(hr)){
+            hr = IAudioClient_QueryInterface(client, riid, ppv);
+            IAudioClient_Release(client);
+        }
     }else if (IsEqualIID(riid, &IID_IAudioEndpointVolume) ||
             IsEqualIID(riid, &IID_IAudioEndpointVolumeEx))
         hr = AudioEndpointVolume_Create(This, (IAudioEndpointVolumeEx**)ppv);
@@ -683,6 +683,72 @@ static void test_event(void)
     CloseHandle(event);
 }
 
+static void test_audioclient3(void)
+{
+    UINT32 def_period, unit_period, min_period, max_period, cur_period;
+    IAudioClient3 *ac3;
+    WAVEFORMATEX *pwfx, *cur_fmt;
+    HANDLE event;
+    HRESULT hr;
+    DWORD r;
+
+    hr = IMMDevice_Activate(dev, &IID_IAudioClient3, CLSCTX_INPROC_SERVER,
+            NULL, (void**)&ac3);
+    if(hr == E_NOINTERFACE){
+        win_skip("IAudioClient3 not supported\n");
+        return;
+    }
+    ok(hr == S_OK, "Activation failed with %08x\n", hr);
+    if(hr != S_OK)
+        return;
+
+    hr = IAudioClient3_GetMixFormat(ac3, &pwfx);
+    ok(hr == S_OK, "GetMixFormat failed: %08x\n", hr);
+
+    hr = IAudioClient3_GetSharedModeEnginePeriod(ac3, pwfx, NULL, &unit_period,
+            &min_period, &max_period);
+    ok(hr == E_POINTER, "GetSharedModeEnginePeriod gave wrong error: %08x\n", hr);
+
+    hr = IAudioClient3_GetSharedModeEnginePeriod(ac3, pwfx, &def_period, &unit_period,
+            &min_period, &max_period);
+    ok(hr == S_OK, "GetSharedModeEnginePeriod failed: %08x\n", hr);
+    trace("engine periods: default %u, unit %u, min %u, max %u\n",
+            def_period, unit_period, min_period, max_period);
+    ok(unit_period != 0, "Got zero fundamental period\n");
+    ok(min_period <= def_period, "Got min period %u > default %u\n", min_period, def_period);
+    ok(def_period <= max_period, "Got default period %u > max %u\n", def_period, max_period);
+
+    hr = IAudioClient3_InitializeSharedAudioStream(ac3, AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
+            min_period, pwfx, NULL);
+    ok(hr == S_OK, "InitializeSharedAudioStream failed: %08x\n", hr);
+
+    hr = IAudioClient3_GetCurrentSharedModeEnginePeriod(ac3, &cur_fmt, &cur_period);
+    ok(hr == S_OK, "GetCurrentSharedModeEnginePeriod failed: %08x\n", hr);
+    if(hr == S_OK){
+        ok(cur_period == min_period, "Got current period %u, expected %u\n", cur_period, min_period);
+        CoTaskMemFree(cur_fmt);
+    }
+
+    event = CreateEventW(NULL, FALSE, FALSE, NULL);
+    ok(event != NULL, "CreateEvent failed\n");
+
+    hr = IAudioClient3_SetEventHandle(ac3, event);
+    ok(hr == S_OK, "SetEventHandle failed: %08x\n", hr);
+
+    hr = IAudioClient3_Start(ac3);
+    ok(hr == S_OK, "Start failed: %08x\n", hr);
+
+    r = WaitForSingleObject(event, 20);
+    ok(r == WAIT_OBJECT_0, "Wait(event) after Start gave %x\n", r);
+
+    hr = IAudioClient3_Stop(ac3);
+    ok(hr == S_OK, "Stop failed: %08x\n", hr);
+
+    CoTaskMemFree(pwfx);
+    IAudioClient3_Release(ac3);
+    CloseHandle(event);
+}
+
 static void test_padding(void)
 {
     HRESULT hr;
@@ -2308,6 +2374,7 @@ START_TEST(render)
     trace("Output to a MS-DOS console is particularly slow and disturbs timing.\n");
     trace("Please redirect output to a file.\n");
     test_event();
+    test_audioclient3();
     test_padding();
     test_clock(1);
     test_clock(0);
@@ -111,6 +111,153 @@ static MSICABINETSTREAM *msi_get_cabinet_stream( MSIPACKAGE *package, UINT disk_
     return NULL;
 }
 
+/* Extracted data is written to the target files by a separate thread, so
+ * that decompression of the next blocks goes on while the previous ones
+ * are written. Blocks are written in order, and the queue is drained before
+ * a file gets closed.
+ */
+struct write_block
+{
+    struct list entry;
+    HANDLE      handle;
+    UINT        size;
+    BYTE        data[1];
+};
+
+#define MAX_QUEUED_WRITES (4 * 1024 * 1024)
+
+struct cabinet_writer
+{
+    CRITICAL_SECTION cs;
+    struct list      queue;
+    UINT             queued_size;
+    BOOL             failed;
+    BOOL             quit;
+    HANDLE           queued;    /* signaled when blocks are added to the queue */
+    HANDLE           drained;   /* signaled when all queued blocks have been written */
+    HANDLE           thread;
+};
+
+static struct cabinet_writer *cabinet_writer;
+
+static DWORD WINAPI cabinet_writer_proc( void *arg )
+{
+    struct cabinet_writer *writer = arg;
+    struct write_block *block;
+    struct list *entry;
+    DWORD written;
+    BOOL ret;
+
+    for (;;)
+    {
+        EnterCriticalSection( &writer->cs );
+        while (!(entry = list_head( &writer->queue )) && !writer->quit)
+        {
+            SetEvent( writer->drained );
+            LeaveCriticalSection( &writer->cs );
+            WaitForSingleObject( writer->queued, INFINITE );
+            EnterCriticalSection( &writer->cs );
+        }
+        if (!entry)
+        {
+            LeaveCriticalSection( &writer->cs );
+            return 0;
+        }
+        list_remove( entry );
+        LeaveCriticalSection( &writer->cs );
+
+        block = LIST_ENTRY( entry, struct write_block, entry );
+        ret = WriteFile( block->handle, block->data, block->size, &written, NULL ) && written == block->size;
+
+        EnterCriticalSection( &writer->cs );
+        if (!ret) writer->failed = TRUE;
+        writer->queued_size -= block->size;
+        LeaveCriticalSection( &writer->cs );
+        msi_free( block );
+    }
+}
+
+static struct cabinet_writer *create_cabinet_writer(void)
+{
+    struct cabinet_writer *writer;
+
+    if (!(writer = msi_alloc_zero( sizeof(*writer) ))) return NULL;
+
+    InitializeCriticalSection( &writer->cs );
+    writer->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": cabinet_writer.cs");
+    list_init( &writer->queue );
+    writer->queued = CreateEventW( NULL, FALSE, FALSE, NULL );
+    writer->drained = CreateEventW( NULL, TRUE, TRUE, NULL );
+    if (writer->queued && writer->drained &&
+        (writer->thread = CreateThread( NULL, 0, cabinet_writer_proc, writer, 0, NULL )))
+        return writer;
+
+    if (writer->queued) CloseHandle( writer->queued );
+    if (writer->drained) CloseHandle( writer->drained );
+    writer->cs.DebugInfo->Spare[0] = 0;
+    DeleteCriticalSection( &writer->cs );
+    msi_free( writer );
+    return NULL;
+}
+
+static void destroy_cabinet_writer( struct cabinet_writer *writer )
+{
+    EnterCriticalSection( &writer->cs );
+    writer->quit = TRUE;
+    LeaveCriticalSection( &writer->cs );
+    SetEvent( writer->queued );
+    WaitForSingleObject( writer->thread, INFINITE );
+
+    CloseHandle( writer->thread );
+    CloseHandle( writer->queued );
+    CloseHandle( writer->drained );
+    writer->cs.DebugInfo->Spare[0] = 0;
+    DeleteCriticalSection( &writer->cs );
+    msi_free( writer );
+}
+
+/* waits for all the queued blocks to be written, returns FALSE if a write failed */
+static BOOL flush_cabinet_writer( struct cabinet_writer *writer )
+{
+    BOOL ret;
+
+    WaitForSingleObject( writer->drained, INFINITE );
+    EnterCriticalSection( &writer->cs );
+    ret = !writer->failed;
+    writer->failed = FALSE;
+    LeaveCriticalSection( &writer->cs );
+    return ret;
+}
+
+static BOOL queue_cabinet_write( struct cabinet_writer *writer, HANDLE handle, const void *data, UINT size )
+{
+    struct write_block *block;
+    BOOL full;
+
+    EnterCriticalSection( &writer->cs );
+    full = writer->queued_size >= MAX_QUEUED_WRITES;
+    LeaveCriticalSection( &writer->cs );
+    if (full) WaitForSingleObject( writer->drained, INFINITE );
+
+    if (!(block = msi_alloc( FIELD_OFFSET(struct write_block, data[size]) )))
+    {
+        /* write synchronously, after the data already queued */
+        WaitForSingleObject( writer->drained, INFINITE );
+        return FALSE;
+    }
+    block->handle = handle;
+    block->size = size;
+    memcpy( block->data, data, size );
+
+    EnterCriticalSection( &writer->cs );
+    list_add_tail( &writer->queue, &block->entry );
+    writer->queued_size += size;
+    ResetEvent( writer->drained );
+    LeaveCriticalSection( &writer->cs );
+    SetEvent( writer->queued );
+    return TRUE;
+}
+
 static void * CDECL cabinet_alloc(ULONG cb)
 {
     return msi_alloc(cb);
@@ -168,6 +315,9 @@ static UINT CDECL cabinet_write(INT_PTR hf, void *pv, UINT cb)
     HANDLE handle = (HANDLE)hf;
     DWORD written;
 
+    if (cabinet_writer && queue_cabinet_write(cabinet_writer, handle, pv, cb))
+        return cb;
+
     if (WriteFile(handle, pv, cb, &written, NULL))
         return written;
 
@@ -177,6 +327,8 @@ static UINT CDECL cabinet_write(INT_PTR hf, void *pv, UINT cb)
 static int CDECL cabinet_close(INT_PTR hf)
 {
     HANDLE handle = (HANDLE)hf;
+
+    if (cabinet_writer) flush_cabinet_writer(cabinet_writer);
     return CloseHandle(handle) ? 0 : -1;
 }
 
@@ -513,6 +665,13 @@ static INT_PTR cabinet_close_file_info(FDINOTIFICATIONTYPE fdint,
 
     data->mi->is_continuous = FALSE;
 
+    if (cabinet_writer && !flush_cabinet_writer(cabinet_writer))
+    {
+        ERR("failed to write %s\n", debugstr_w(data->curfile));
+        CloseHandle(handle);
+        return -1;
+    }
+
     if (!DosDateTimeToFileTime(pfdin->date, pfdin->time, &ft))
         return -1;
     if (!LocalFileTimeToFileTime(&ft, &ftLocal))
@@ -602,9 +761,15 @@ static BOOL extract_cabinet( MSIPACKAGE* package, MSIMEDIAINFO *mi, LPVOID data
     if (!cab_path)
         goto done;
 
+    cabinet_writer = create_cabinet_writer();
     ret = FDICopy( hfdi, cabinet, cab_path, 0, cabinet_notify, NULL, data );
     if (!ret)
         ERR("FDICopy failed\n");
+    if (cabinet_writer)
+    {
+        destroy_cabinet_writer( cabinet_writer );
+        cabinet_writer = NULL;
+    }
 
 done:
     FDIDestroy( hfdi );
@@ -637,8 +802,14 @@ static BOOL extract_cabinet_stream( MSIPACKAGE *package, MSIMEDIAINFO *mi, LPVOI
     package_disk.package = package;
     package_disk.id      = mi->disk_id;
 
+    cabinet_writer = create_cabinet_writer();
     ret = FDICopy( hfdi, filename, NULL, 0, cabinet_notify_stream, NULL, data );
     if (!ret) ERR("FDICopy failed\n");
+    if (cabinet_writer)
+    {
+        destroy_cabinet_writer( cabinet_writer );
+        cabinet_writer = NULL;
+    }
 
     FDIDestroy( hfdi );
     if (ret) mi->is_extracted = TRUE;
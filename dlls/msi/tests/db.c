@@ -9741,6 +9741,129 @@ static void test_primary_keys(void)
     DeleteFileA(msifile);
 }
 
+static void test_where_index(void)
+{
+    MSIHANDLE hdb, hview, hrec, hparam;
+    char query[MAX_PATH], buffer[32];
+    DWORD size;
+    UINT r, i, count;
+
+    DeleteFileA(msifile);
+
+    r = MsiOpenDatabaseW(msifileW, MSIDBOPEN_CREATE, &hdb);
+    ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %u\n", r);
+
+    r = run_query(hdb, 0, "CREATE TABLE `One` ( `Key` CHAR(72) NOT NULL, `Value` INT PRIMARY KEY `Key` )");
+    ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %u\n", r);
+    r = run_query(hdb, 0, "CREATE TABLE `Two` ( `Id` INT NOT NULL, `Ref` CHAR(72) PRIMARY KEY `Id` )");
+    ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %u\n", r);
+
+    /* enough rows to need more than one entry per hash bucket */
+    for (i = 0; i < 100; i++)
+    {
+        sprintf(query, "INSERT INTO `One` ( `Key`, `Value` ) VALUES ( 'key%u', %u )", i, i % 10);
+        r = run_query(hdb, 0, query);
+        ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %u\n", r);
+        sprintf(query, "INSERT INTO `Two` ( `Id`, `Ref` ) VALUES ( %u, 'key%u' )", i, 99 - i);
+        r = run_query(hdb, 0, query);
+        ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %u\n", r);
+    }
+
+    r = MsiDatabaseOpenViewA(hdb, "SELECT `Value` FROM `One` WHERE `Key` = ?", &hview);
+    ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %u\n", r);
+    hparam = MsiCreateRecord(1);
+    for (i = 0; i < 100; i += 7)
+    {
+        sprintf(buffer, "key%u", i);
+        MsiRecordSetStringA(hparam, 1, buffer);
+        r = MsiViewExecute(hview, hparam);
+        ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %u\n", r);
+        r = MsiViewFetch(hview, &hrec);
+        ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %u\n", r);
+        r = MsiRecordGetInteger(hrec, 1);
+        ok(r == i % 10, "Expected %u, got %u\n", i % 10, r);
+        MsiCloseHandle(hrec);
+        r = MsiViewFetch(hview, &hrec);
+        ok(r == ERROR_NO_MORE_ITEMS, "Expected ERROR_NO_MORE_ITEMS, got %u\n", r);
+        MsiViewClose(hview);
+    }
+    MsiRecordSetStringA(hparam, 1, "nokey");
+    r = MsiViewExecute(hview, hparam);
+    ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %u\n", r);
+    r = MsiViewFetch(hview, &hrec);
+    ok(r == ERROR_NO_MORE_ITEMS, "Expected ERROR_NO_MORE_ITEMS, got %u\n", r);
+    MsiViewClose(hview);
+    MsiCloseHandle(hview);
+    MsiCloseHandle(hparam);
+
+    r = MsiDatabaseOpenViewA(hdb, "SELECT `Key` FROM `One` WHERE `Value` = 3", &hview);
+    ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %u\n", r);
+    r = MsiViewExecute(hview, 0);
+    ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %u\n", r);
+    count = 0;
+    while (MsiViewFetch(hview, &hrec) == ERROR_SUCCESS)
+    {
+        size = sizeof(buffer);
+        MsiRecordGetStringA(hrec, 1, buffer, &size);
+        ok(sscanf(buffer, "key%u", &i) == 1 && i % 10 == 3, "unexpected key %s\n", buffer);
+        MsiCloseHandle(hrec);
+        count++;
+    }
+    ok(count == 10, "Expected 10 rows, got %u\n", count);
+    MsiViewClose(hview);
+    MsiCloseHandle(hview);
+
+    r = MsiDatabaseOpenViewA(hdb, "SELECT `Id`, `Value` FROM `One`, `Two` "
+                             "WHERE `Ref` = `Key` AND `Value` = 5", &hview);
+    ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %u\n", r);
+    r = MsiViewExecute(hview, 0);
+    ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %u\n", r);
+    count = 0;
+    while (MsiViewFetch(hview, &hrec) == ERROR_SUCCESS)
+    {
+        r = MsiRecordGetInteger(hrec, 1);
+        ok((99 - r) % 10 == 5, "unexpected id %u\n", r);
+        r = MsiRecordGetInteger(hrec, 2);
+        ok(r == 5, "Expected 5, got %u\n", r);
+        MsiCloseHandle(hrec);
+        count++;
+    }
+    ok(count == 10, "Expected 10 rows, got %u\n", count);
+    MsiViewClose(hview);
+    MsiCloseHandle(hview);
+
+    /* the indexes must follow modifications */
+    r = run_query(hdb, 0, "DELETE FROM `One` WHERE `Key` = 'key3'");
+    ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %u\n", r);
+    r = do_query(hdb, "SELECT `Value` FROM `One` WHERE `Key` = 'key3'", &hrec);
+    ok(r == ERROR_NO_MORE_ITEMS, "Expected ERROR_NO_MORE_ITEMS, got %u\n", r);
+    r = do_query(hdb, "SELECT `Value` FROM `One` WHERE `Key` = 'key4'", &hrec);
+    ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %u\n", r);
+    r = MsiRecordGetInteger(hrec, 1);
+    ok(r == 4, "Expected 4, got %u\n", r);
+    MsiCloseHandle(hrec);
+
+    r = run_query(hdb, 0, "INSERT INTO `One` ( `Key`, `Value` ) VALUES ( 'key100', 42 )");
+    ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %u\n", r);
+    r = do_query(hdb, "SELECT `Key` FROM `One` WHERE `Value` = 42", &hrec);
+    ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %u\n", r);
+    size = sizeof(buffer);
+    MsiRecordGetStringA(hrec, 1, buffer, &size);
+    ok(!strcmp(buffer, "key100"), "Expected key100, got %s\n", buffer);
+    MsiCloseHandle(hrec);
+
+    r = run_query(hdb, 0, "UPDATE `One` SET `Value` = 43 WHERE `Key` = 'key100'");
+    ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %u\n", r);
+    r = do_query(hdb, "SELECT `Key` FROM `One` WHERE `Value` = 42", &hrec);
+    ok(r == ERROR_NO_MORE_ITEMS, "Expected ERROR_NO_MORE_ITEMS, got %u\n", r);
+    r = do_query(hdb, "SELECT `Key` FROM `One` WHERE `Value` = 43", &hrec);
+    ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %u\n", r);
+    MsiCloseHandle(hrec);
+
+    MsiCloseHandle(hdb);
+    DeleteFileA(msifile);
+}
+
 START_TEST(db)
 {
     test_msidatabase();
@@ -9797,4 +9920,5 @@ START_TEST(db)
     test_embedded_nulls();
     test_select_column_names();
     test_primary_keys();
+    test_where_index();
 }
@@ -599,15 +599,165 @@ static UINT WHERE_evaluate( MSIWHEREVIEW *wv, const UINT rows[],
     return ERROR_SUCCESS;
 }
 
+/* number of wildcards consumed when evaluating expr */
+static UINT count_wildcards( const struct expr *expr )
+{
+    switch (expr->type)
+    {
+    case EXPR_WILDCARD:
+        return 1;
+    case EXPR_COMPLEX:
+    case EXPR_STRCMP:
+        return count_wildcards( expr->u.expr.left ) + count_wildcards( expr->u.expr.right );
+    default:
+        return 0;
+    }
+}
+
+enum index_key
+{
+    KEY_NONE,       /* the expression can't be looked up in an index */
+    KEY_VALUE,      /* only the rows holding the key can match */
+    KEY_NO_MATCH,   /* no row can match */
+};
+
+/* computes the value the column must hold for 'column = value' to be true */
+static enum index_key get_equality_key( MSIWHEREVIEW *wv, const struct expr *column,
+                                        const struct expr *value, MSIRECORD *record,
+                                        const UINT rows[], UINT wildcard, UINT *key )
+{
+    const WCHAR *str;
+    UINT val, offset;
+
+    if (column->type == EXPR_COL_NUMBER_STRING)
+    {
+        switch (value->type)
+        {
+        case EXPR_COL_NUMBER_STRING:
+            if (expr_fetch_value( &value->u.column, rows, &val ) != ERROR_SUCCESS || !val)
+                return KEY_NONE;
+            *key = val;
+            return KEY_VALUE;
+        case EXPR_SVAL:
+            str = value->u.sval;
+            break;
+        case EXPR_WILDCARD:
+            if (!record)
+                return KEY_NONE;
+            str = MSI_RecordGetString( record, wildcard );
+            break;
+        default:
+            return KEY_NONE;
+        }
+        /* empty strings also match null values */
+        if (!str || !*str)
+            return KEY_NONE;
+        if (msi_string2id( wv->db->strings, str, -1, key ) != ERROR_SUCCESS)
+            return KEY_NO_MATCH;
+        return KEY_VALUE;
+    }
+
+    offset = column->type == EXPR_COL_NUMBER32 ? 0x80000000 : 0x8000;
+    switch (value->type)
+    {
+    case EXPR_COL_NUMBER:
+        if (expr_fetch_value( &value->u.column, rows, &val ) != ERROR_SUCCESS)
+            return KEY_NONE;
+        *key = val - 0x8000 + offset;
+        return KEY_VALUE;
+    case EXPR_COL_NUMBER32:
+        if (expr_fetch_value( &value->u.column, rows, &val ) != ERROR_SUCCESS)
+            return KEY_NONE;
+        *key = val - 0x80000000 + offset;
+        return KEY_VALUE;
+    case EXPR_UVAL:
+        *key = value->u.uval + offset;
+        return KEY_VALUE;
+    case EXPR_WILDCARD:
+        if (!record)
+            return KEY_NONE;
+        *key = MSI_RecordGetInteger( record, wildcard ) + offset;
+        return KEY_VALUE;
+    default:
+        return KEY_NONE;
+    }
+}
+
+/* looks for an equality between a column of table and a value known at this
+ * point of the join, in one of the terms of the top level AND chain */
+static enum index_key find_index_key( MSIWHEREVIEW *wv, const struct expr *cond,
+                                      MSIRECORD *record, const JOINTABLE *table,
+                                      const UINT rows[], UINT *wildcards, UINT *col, UINT *key )
+{
+    const struct expr *left, *right;
+    enum index_key ret = KEY_NONE;
+    UINT wildcard;
+
+    if (cond->type == EXPR_COMPLEX && cond->u.expr.op == OP_AND)
+    {
+        ret = find_index_key( wv, cond->u.expr.left, record, table, rows, wildcards, col, key );
+        if (ret != KEY_NONE)
+            return ret;
+        return find_index_key( wv, cond->u.expr.right, record, table, rows, wildcards, col, key );
+    }
+
+    if ((cond->type == EXPR_COMPLEX || cond->type == EXPR_STRCMP) && cond->u.expr.op == OP_EQ)
+    {
+        left = cond->u.expr.left;
+        right = cond->u.expr.right;
+        /* a column on one side, so a wildcard would be the first one of the term */
+        wildcard = *wildcards + 1;
+
+        if ((left->type == EXPR_COL_NUMBER || left->type == EXPR_COL_NUMBER32 ||
+             left->type == EXPR_COL_NUMBER_STRING) && left->u.column.parsed.table == table)
+        {
+            *col = left->u.column.parsed.column;
+            ret = get_equality_key( wv, left, right, record, rows, wildcard, key );
+        }
+        else if ((right->type == EXPR_COL_NUMBER || right->type == EXPR_COL_NUMBER32 ||
+                  right->type == EXPR_COL_NUMBER_STRING) && right->u.column.parsed.table == table)
+        {
+            *col = right->u.column.parsed.column;
+            ret = get_equality_key( wv, right, left, record, rows, wildcard, key );
+        }
+    }
+    *wildcards += count_wildcards( cond );
+    return ret;
+}
+
 static UINT check_condition( MSIWHEREVIEW *wv, MSIRECORD *record, JOINTABLE **tables,
                              UINT table_rows[] )
 {
     UINT r = ERROR_FUNCTION_FAILED;
+    UINT *row = &table_rows[(*tables)->table_index];
+    MSIITERHANDLE handle = NULL;
+    UINT col, key, wildcards = 0;
+    enum index_key index = KEY_NONE;
     INT val;
 
-    for (table_rows[(*tables)->table_index] = 0;
-         table_rows[(*tables)->table_index] < (*tables)->row_count;
-         table_rows[(*tables)->table_index]++)
+    if (wv->cond)
+        index = find_index_key( wv, wv->cond, record, *tables, table_rows, &wildcards, &col, &key );
+    if (index == KEY_NO_MATCH)
+        return ERROR_SUCCESS;
+    if (index == KEY_VALUE)
+    {
+        r = (*tables)->view->ops->find_matching_rows( (*tables)->view, col, key, row, &handle );
+        if (r == ERROR_NO_MORE_ITEMS)
+        {
+            *row = INVALID_ROW_INDEX;
+            return ERROR_SUCCESS;
+        }
+        if (r != ERROR_SUCCESS)
+        {
+            /* fall back to scanning the whole table */
+            index = KEY_NONE;
+            r = ERROR_FUNCTION_FAILED;
+        }
+    }
+    if (index == KEY_NONE)
+        *row = 0;
+
+    while (*row < (*tables)->row_count)
     {
         val = 0;
         wv->rec_index = 0;
@@ -629,8 +779,14 @@ static UINT check_condition( MSIWHEREVIEW *wv, MSIRECORD *record, JOINTABLE **ta
                 add_row (wv, table_rows);
             }
         }
+
+        if (index == KEY_NONE)
+            (*row)++;
+        else if ((*tables)->view->ops->find_matching_rows( (*tables)->view, col, key,
+                                                            row, &handle ) != ERROR_SUCCESS)
+            break;
     }
-    table_rows[(*tables)->table_index] = INVALID_ROW_INDEX;
+    *row = INVALID_ROW_INDEX;
     return r;
 }
 
@@ -1083,13 +1083,11 @@ static collate* collate_char_use_facet(const locale *loc)
     _Lockit lock;
     const locale_facet *fac;
 
-    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     fac = locale__Getfacet(loc, locale_id_operator_size_t(&collate_char_id));
-    if(fac) {
-        _Lockit_dtor(&lock);
+    if(fac)
         return (collate*)fac;
-    }
 
+    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     if(obj) {
         _Lockit_dtor(&lock);
         return obj;
@@ -1375,13 +1373,11 @@ static collate* collate_wchar_use_facet(const locale *loc)
     _Lockit lock;
     const locale_facet *fac;
 
-    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     fac = locale__Getfacet(loc, locale_id_operator_size_t(&collate_wchar_id));
-    if(fac) {
-        _Lockit_dtor(&lock);
+    if(fac)
         return (collate*)fac;
-    }
 
+    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     if(obj) {
         _Lockit_dtor(&lock);
         return obj;
@@ -1422,13 +1418,11 @@ static collate* collate_short_use_facet(const locale *loc)
     _Lockit lock;
     const locale_facet *fac;
 
-    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     fac = locale__Getfacet(loc, locale_id_operator_size_t(&collate_short_id));
-    if(fac) {
-        _Lockit_dtor(&lock);
+    if(fac)
         return (collate*)fac;
-    }
 
+    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     if(obj) {
         _Lockit_dtor(&lock);
         return obj;
@@ -1941,13 +1935,11 @@ ctype_char* ctype_char_use_facet(const locale *loc)
     _Lockit lock;
     const locale_facet *fac;
 
-    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     fac = locale__Getfacet(loc, locale_id_operator_size_t(&ctype_char_id));
-    if(fac) {
-        _Lockit_dtor(&lock);
+    if(fac)
         return (ctype_char*)fac;
-    }
 
+    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     if(obj) {
         _Lockit_dtor(&lock);
         return obj;
@@ -2772,13 +2764,11 @@ ctype_wchar* ctype_wchar_use_facet(const locale *loc)
     _Lockit lock;
     const locale_facet *fac;
 
-    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     fac = locale__Getfacet(loc, locale_id_operator_size_t(&ctype_wchar_id));
-    if(fac) {
-        _Lockit_dtor(&lock);
+    if(fac)
         return (ctype_wchar*)fac;
-    }
 
+    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     if(obj) {
         _Lockit_dtor(&lock);
         return obj;
@@ -2800,13 +2790,11 @@ ctype_wchar* ctype_short_use_facet(const locale *loc)
     _Lockit lock;
     const locale_facet *fac;
 
-    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     fac = locale__Getfacet(loc, locale_id_operator_size_t(&ctype_short_id));
-    if(fac) {
-        _Lockit_dtor(&lock);
+    if(fac)
         return (ctype_wchar*)fac;
-    }
 
+    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     if(obj) {
         _Lockit_dtor(&lock);
         return obj;
@@ -3336,13 +3324,11 @@ codecvt_char* codecvt_char_use_facet(const locale *loc)
     _Lockit lock;
     const locale_facet *fac;
 
-    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     fac = locale__Getfacet(loc, locale_id_operator_size_t(&codecvt_char_id));
-    if(fac) {
-        _Lockit_dtor(&lock);
+    if(fac)
         return (codecvt_char*)fac;
-    }
 
+    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     if(obj) {
         _Lockit_dtor(&lock);
         return obj;
@@ -3678,13 +3664,11 @@ codecvt_wchar* codecvt_wchar_use_facet(const locale *loc)
     _Lockit lock;
     const locale_facet *fac;
 
-    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     fac = locale__Getfacet(loc, locale_id_operator_size_t(&codecvt_wchar_id));
-    if(fac) {
-        _Lockit_dtor(&lock);
+    if(fac)
         return (codecvt_wchar*)fac;
-    }
 
+    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     if(obj) {
         _Lockit_dtor(&lock);
         return obj;
@@ -3737,13 +3721,11 @@ codecvt_wchar* codecvt_short_use_facet(const locale *loc)
     _Lockit lock;
     const locale_facet *fac;
 
-    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     fac = locale__Getfacet(loc, locale_id_operator_size_t(&codecvt_short_id));
-    if(fac) {
-        _Lockit_dtor(&lock);
+    if(fac)
         return (codecvt_wchar*)fac;
-    }
 
+    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     if(obj) {
         _Lockit_dtor(&lock);
         return obj;
@@ -4198,13 +4180,11 @@ static numpunct_char* numpunct_char_use_facet(const locale *loc)
     _Lockit lock;
     const locale_facet *fac;
 
-    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     fac = locale__Getfacet(loc, locale_id_operator_size_t(&numpunct_char_id));
-    if(fac) {
-        _Lockit_dtor(&lock);
+    if(fac)
         return (numpunct_char*)fac;
-    }
 
+    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     if(obj) {
         _Lockit_dtor(&lock);
         return obj;
@@ -4585,13 +4565,11 @@ static numpunct_wchar* numpunct_wchar_use_facet(const locale *loc)
     _Lockit lock;
     const locale_facet *fac;
 
-    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     fac = locale__Getfacet(loc, locale_id_operator_size_t(&numpunct_wchar_id));
-    if(fac) {
-        _Lockit_dtor(&lock);
+    if(fac)
         return (numpunct_wchar*)fac;
-    }
 
+    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     if(obj) {
         _Lockit_dtor(&lock);
         return obj;
@@ -4640,13 +4618,11 @@ static numpunct_wchar* numpunct_short_use_facet(const locale *loc)
     _Lockit lock;
     const locale_facet *fac;
 
-    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     fac = locale__Getfacet(loc, locale_id_operator_size_t(&numpunct_short_id));
-    if(fac) {
-        _Lockit_dtor(&lock);
+    if(fac)
         return (numpunct_wchar*)fac;
-    }
 
+    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     if(obj) {
         _Lockit_dtor(&lock);
         return obj;
@@ -5069,13 +5045,11 @@ num_get* num_get_wchar_use_facet(const locale *loc)
         _Lockit lock;
         const locale_facet *fac;
 
-        _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
         fac = locale__Getfacet(loc, locale_id_operator_size_t(&num_get_wchar_id));
-        if(fac) {
-            _Lockit_dtor(&lock);
+        if(fac)
             return (num_get*)fac;
-        }
 
+        _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
         if(obj) {
             _Lockit_dtor(&lock);
             return obj;
@@ -5116,13 +5090,11 @@ num_get* num_get_short_use_facet(const locale *loc)
     _Lockit lock;
     const locale_facet *fac;
 
-    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     fac = locale__Getfacet(loc, locale_id_operator_size_t(&num_get_short_id));
-    if(fac) {
-        _Lockit_dtor(&lock);
+    if(fac)
         return (num_get*)fac;
-    }
 
+    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     if(obj) {
         _Lockit_dtor(&lock);
         return obj;
@@ -6319,13 +6291,11 @@ num_get* num_get_char_use_facet(const locale *loc)
     _Lockit lock;
     const locale_facet *fac;
 
-    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     fac = locale__Getfacet(loc, locale_id_operator_size_t(&num_get_char_id));
-    if(fac) {
-        _Lockit_dtor(&lock);
+    if(fac)
         return (num_get*)fac;
-    }
 
+    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     if(obj) {
         _Lockit_dtor(&lock);
         return obj;
@@ -7270,13 +7240,11 @@ num_put* num_put_char_use_facet(const locale *loc)
     _Lockit lock;
     const locale_facet *fac;
 
-    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     fac = locale__Getfacet(loc, locale_id_operator_size_t(&num_put_char_id));
-    if(fac) {
-        _Lockit_dtor(&lock);
+    if(fac)
         return (num_put*)fac;
-    }
 
+    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     if(obj) {
         _Lockit_dtor(&lock);
         return obj;
@@ -8078,13 +8046,11 @@ num_put* num_put_wchar_use_facet(const locale *loc)
     _Lockit lock;
     const locale_facet *fac;
 
-    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     fac = locale__Getfacet(loc, locale_id_operator_size_t(&num_put_wchar_id));
-    if(fac) {
-        _Lockit_dtor(&lock);
+    if(fac)
         return (num_put*)fac;
-    }
 
+    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     if(obj) {
         _Lockit_dtor(&lock);
         return obj;
@@ -8106,13 +8072,11 @@ num_put* num_put_short_use_facet(const locale *loc)
     _Lockit lock;
     const locale_facet *fac;
 
-    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     fac = locale__Getfacet(loc, locale_id_operator_size_t(&num_put_short_id));
-    if(fac) {
-        _Lockit_dtor(&lock);
+    if(fac)
         return (num_put*)fac;
-    }
 
+    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     if(obj) {
         _Lockit_dtor(&lock);
         return obj;
@@ -9100,13 +9064,11 @@ static time_put* time_put_char_use_facet(const locale *loc)
     _Lockit lock;
     const locale_facet *fac;
 
-    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     fac = locale__Getfacet(loc, locale_id_operator_size_t(&time_put_char_id));
-    if(fac) {
-        _Lockit_dtor(&lock);
+    if(fac)
         return (time_put*)fac;
-    }
 
+    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     if(obj) {
         _Lockit_dtor(&lock);
         return obj;
@@ -9468,13 +9430,11 @@ static time_put* time_put_wchar_use_facet(const locale *loc)
     _Lockit lock;
     const locale_facet *fac;
 
-    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     fac = locale__Getfacet(loc, locale_id_operator_size_t(&time_put_wchar_id));
-    if(fac) {
-        _Lockit_dtor(&lock);
+    if(fac)
         return (time_put*)fac;
-    }
 
+    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     if(obj) {
         _Lockit_dtor(&lock);
         return obj;
@@ -9523,13 +9483,11 @@ static time_put* time_put_short_use_facet(const locale *loc)
     _Lockit lock;
     const locale_facet *fac;
 
-    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     fac = locale__Getfacet(loc, locale_id_operator_size_t(&time_put_short_id));
-    if(fac) {
-        _Lockit_dtor(&lock);
+    if(fac)
         return (time_put*)fac;
-    }
 
+    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     if(obj) {
         _Lockit_dtor(&lock);
         return obj;
@@ -9921,13 +9879,11 @@ static time_get_char* time_get_char_use_facet(const locale *loc)
     _Lockit lock;
     const locale_facet *fac;
 
-    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     fac = locale__Getfacet(loc, locale_id_operator_size_t(&time_get_char_id));
-    if(fac) {
-        _Lockit_dtor(&lock);
+    if(fac)
         return (time_get_char*)fac;
-    }
 
+    _Lockit_ctor_locktype(&lock, _LOCK_LOCALE);
     if(obj) {
         _Lockit_dtor(&lock);
         return obj;
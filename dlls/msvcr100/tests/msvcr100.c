@@ -168,8 +168,8 @@ struct SchedulerVtbl {
     unsigned int (__thiscall *Release)(Scheduler*);
     void (__thiscall *RegisterShutdownEvent)(Scheduler*,HANDLE);
     void (__thiscall *Attach)(Scheduler*);
-    /* CreateScheduleGroup */
-    /* ScheduleTask */
+    void* (__thiscall *CreateScheduleGroup)(Scheduler*);
+    void (__thiscall *ScheduleTask)(Scheduler*,void (__cdecl*)(void*),void*);
 };
 
 static int* (__cdecl *p_errno)(void);
@@ -939,11 +939,21 @@ static void test_ExternalContextBase(void)
     CloseHandle(thread);
 }
 
+static LONG scheduled_tasks;
+static HANDLE scheduled_tasks_done;
+
+static void __cdecl scheduled_task(void *data)
+{
+    if(!InterlockedDecrement(&scheduled_tasks))
+        SetEvent(scheduled_tasks_done);
+}
+
 static void test_Scheduler(void)
 {
     Scheduler *scheduler, *current_scheduler;
     SchedulerPolicy policy;
     unsigned int i;
+    DWORD ret;
 
     call_func1(p_SchedulerPolicy_ctor, &policy);
     scheduler = p_Scheduler_Create(&policy);
@@ -969,6 +979,23 @@ static void test_Scheduler(void)
     i = call_func1(scheduler->vtable->GetNumberOfVirtualProcessors, scheduler);
     ok(i == 1, "Scheduler::GetNumberOfVirtualProcessors() = %u\n", i);
     call_func1(scheduler->vtable->Release, scheduler);
+
+    call_func3(p_SchedulerPolicy_SetConcurrencyLimits, &policy, 2, 4);
+    scheduler = p_Scheduler_Create(&policy);
+    ok(scheduler != NULL, "Scheduler::Create() = NULL\n");
+
+    i = call_func1(scheduler->vtable->GetNumberOfVirtualProcessors, scheduler);
+    ok(i >= 2 && i <= 4, "Scheduler::GetNumberOfVirtualProcessors() = %u\n", i);
+
+    scheduled_tasks = 100;
+    scheduled_tasks_done = CreateEventW(NULL, TRUE, FALSE, NULL);
+    for(i=0; i<100; i++)
+        call_func3(scheduler->vtable->ScheduleTask, scheduler, scheduled_task, NULL);
+    ret = WaitForSingleObject(scheduled_tasks_done, 5000);
+    ok(ret == WAIT_OBJECT_0, "WaitForSingleObject returned %u\n", ret);
+    ok(!scheduled_tasks, "%d tasks were not run\n", scheduled_tasks);
+    CloseHandle(scheduled_tasks_done);
+    call_func1(scheduler->vtable->Release, scheduler);
     call_func1(p_SchedulerPolicy_dtor, &policy);
 }
 
@@ -2746,6 +2746,16 @@ static int read_utf8(ioinfo *fdinfo, MSVCRT_wchar_t *buf, unsigned int count)
  * the file pointer on the \r character while getc() goes on to
  * the following \n
  */
+/* returns the length of the leading run of str without \r or ^Z characters */
+static inline DWORD text_run_len(const char *str, DWORD len)
+{
+    const char *p;
+
+    if ((p = memchr(str, '\r', len))) len = p - str;
+    if ((p = memchr(str, 0x1a, len))) len = p - str;
+    return len;
+}
+
 static int read_i(int fd, ioinfo *fdinfo, void *buf, unsigned int count)
 {
     DWORD num_read, utf16;
@@ -2820,6 +2830,17 @@ static int read_i(int fd, ioinfo *fdinfo, void *buf, unsigned int count)
 
             for (i=0, j=0; i<num_read; i+=1+utf16)
             {
+                /* copy plain runs at once */
+                if (!utf16)
+                {
+                    DWORD run = text_run_len(bufstart + i, num_read - i);
+
+                    if (i != j) memmove(bufstart + j, bufstart + i, run);
+                    i += run;
+                    j += run;
+                    if (i == num_read) break;
+                }
+
                 /* in text mode, a ctrl-z signals EOF */
                 if (bufstart[i]==0x1a && (!utf16 || bufstart[i+1]==0))
                 {
@@ -3472,20 +3493,27 @@ int CDECL MSVCRT__write(int fd, const void* buf, unsigned int count)
 
         if (!(info->exflag & (EF_UTF8|EF_UTF16)))
         {
+            const char *nl;
+
             /* find number of \n */
-            for (nr_lf=0, i=0; i<count; i++)
-                if (s[i] == '\n')
-                    nr_lf++;
+            for (nr_lf=0, i=0; i<count && (nl = memchr(s+i, '\n', count-i)); i = nl-s+1)
+                nr_lf++;
             if (nr_lf)
             {
                 size = count+nr_lf;
                 if ((q = p = MSVCRT_malloc(size)))
                 {
-                    for (s = buf, i = 0, j = 0; i < count; i++)
+                    for (s = buf, i = 0, j = 0; i < count; i = nl-s+1)
                     {
-                        if (s[i] == '\n')
-                            p[j++] = '\r';
-                        p[j++] = s[i];
+                        if (!(nl = memchr(s+i, '\n', count-i)))
+                        {
+                            memcpy(p+j, s+i, count-i);
+                            break;
+                        }
+                        memcpy(p+j, s+i, nl-s-i);
+                        j += nl-s-i;
+                        p[j++] = '\r';
+                        p[j++] = '\n';
                     }
                 }
                 else
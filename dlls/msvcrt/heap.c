@@ -52,8 +52,284 @@ static unsigned int MSVCRT_amblksiz = 16;
 /* FIXME - According to documentation it should be 480 bytes, at runtime default is 0 */
 static MSVCRT_size_t MSVCRT_sbh_threshold = 0;
 
+static void* msvcrt_heap_alloc(DWORD flags, MSVCRT_size_t size);
+
+/* Small blocks are carved from 64k slabs and recycled through per-thread
+ * caches, so that the common malloc/free patterns of threaded programs
+ * don't serialize on the heap lock. Blocks move between the thread caches
+ * and the global free lists in batches. The slab header keeps the requested
+ * size of each block, for _msize and _heapwalk.
+ */
+#define SLAB_SIZE        0x10000
+#define SLAB_CLASSES     16          /* 16-byte size classes */
+#define SLAB_MAX_BLOCK   (SLAB_CLASSES * 16)
+#define SLAB_TABLE_SIZE  8192
+#define SLAB_CACHE_MAX   64          /* blocks cached per class and thread */
+#define SLAB_BATCH       32
+
+struct slab
+{
+    unsigned int class;
+    unsigned int count;
+    char        *data;
+    WORD         sizes[1];  /* requested size + 1 of each block, 0 if free */
+};
+
+struct slab_class
+{
+    void        *free_list;
+    struct slab *current;
+    unsigned int carved;
+};
+
+struct slab_cache
+{
+    void        *list[SLAB_CLASSES];
+    unsigned int count[SLAB_CLASSES];
+};
+
+static struct slab * volatile slab_table[SLAB_TABLE_SIZE];
+static unsigned int slab_count;
+static struct slab_class slab_classes[SLAB_CLASSES];
+static DWORD slab_tls = TLS_OUT_OF_INDEXES;
+
+static CRITICAL_SECTION slab_cs;
+static CRITICAL_SECTION_DEBUG slab_cs_debug =
+{
+    0, 0, &slab_cs,
+    { &slab_cs_debug.ProcessLocksList, &slab_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": slab_cs") }
+};
+static CRITICAL_SECTION slab_cs = { &slab_cs_debug, -1, 0, 0, 0, 0 };
+
+static inline unsigned int slab_block_size(const struct slab *slab)
+{
+    return (slab->class + 1) * 16;
+}
+
+static inline unsigned int slab_hash(const void *base)
+{
+    return (unsigned int)(((ULONG_PTR)base / SLAB_SIZE) * 2654435761u) % SLAB_TABLE_SIZE;
+}
+
+/* Slabs are never removed from the table while the heap exists, so lookups
+ * don't need the lock. */
+static struct slab *slab_find(const void *ptr)
+{
+    struct slab *base = (struct slab *)((ULONG_PTR)ptr & ~(ULONG_PTR)(SLAB_SIZE - 1));
+    unsigned int i = slab_hash(base);
+    struct slab *slab;
+
+    if (!slab_count) return NULL;
+    while ((slab = slab_table[i]))
+    {
+        if (slab == base) return slab;
+        i = (i + 1) % SLAB_TABLE_SIZE;
+    }
+    return NULL;
+}
+
+static int slab_index(const struct slab *slab, const void *ptr)
+{
+    unsigned int offset = (const char *)ptr - slab->data, size = slab_block_size(slab);
+
+    if ((const char *)ptr < slab->data || offset % size || offset / size >= slab->count)
+        return -1;
+    return offset / size;
+}
+
+/* called with slab_cs held */
+static struct slab *slab_create(unsigned int class)
+{
+    unsigned int size = (class + 1) * 16, i;
+    struct slab *slab;
+
+    if (slab_count >= SLAB_TABLE_SIZE / 2) return NULL;
+    if (!(slab = VirtualAlloc(NULL, SLAB_SIZE, MEM_COMMIT, PAGE_READWRITE))) return NULL;
+
+    slab->class = class;
+    slab->count = (SLAB_SIZE - FIELD_OFFSET(struct slab, sizes) - 15) / (size + sizeof(WORD));
+    slab->data = (char *)(((ULONG_PTR)&slab->sizes[slab->count] + 15) & ~(ULONG_PTR)15);
+
+    i = slab_hash(slab);
+    while (slab_table[i]) i = (i + 1) % SLAB_TABLE_SIZE;
+    slab_table[i] = slab;
+    slab_count++;
+    return slab;
+}
+
+static struct slab_cache *slab_get_cache(void)
+{
+    struct slab_cache *cache;
+
+    if (slab_tls == TLS_OUT_OF_INDEXES) return NULL;
+    if (!(cache = TlsGetValue(slab_tls)))
+    {
+        cache = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*cache));
+        if (cache) TlsSetValue(slab_tls, cache);
+    }
+    return cache;
+}
+
+static BOOL slab_refill(struct slab_cache *cache, unsigned int class)
+{
+    struct slab_class *sc = &slab_classes[class];
+    unsigned int n;
+    void *block;
+
+    EnterCriticalSection(&slab_cs);
+    for (n = 0; n < SLAB_BATCH; n++)
+    {
+        if ((block = sc->free_list))
+            sc->free_list = *(void **)block;
+        else
+        {
+            if (!sc->current || sc->carved == sc->current->count)
+            {
+                if (!(sc->current = slab_create(class))) break;
+                sc->carved = 0;
+            }
+            block = sc->current->data + sc->carved++ * slab_block_size(sc->current);
+        }
+        *(void **)block = cache->list[class];
+        cache->list[class] = block;
+        cache->count[class]++;
+    }
+    LeaveCriticalSection(&slab_cs);
+    return cache->list[class] != NULL;
+}
+
+static void slab_release(struct slab_cache *cache, unsigned int class, unsigned int count)
+{
+    struct slab_class *sc = &slab_classes[class];
+    void *block;
+
+    EnterCriticalSection(&slab_cs);
+    while (count-- && (block = cache->list[class]))
+    {
+        cache->list[class] = *(void **)block;
+        cache->count[class]--;
+        *(void **)block = sc->free_list;
+        sc->free_list = block;
+    }
+    LeaveCriticalSection(&slab_cs);
+}
+
+static void slab_flush_cache(void)
+{
+    struct slab_cache *cache;
+    unsigned int i;
+
+    if (slab_tls == TLS_OUT_OF_INDEXES || !(cache = TlsGetValue(slab_tls))) return;
+    for (i = 0; i < SLAB_CLASSES; i++)
+        slab_release(cache, i, ~0u);
+}
+
+static void *slab_alloc(DWORD flags, MSVCRT_size_t size)
+{
+    unsigned int class = size ? (size - 1) / 16 : 0;
+    struct slab_cache *cache;
+    struct slab *slab;
+    void *block;
+
+    if (!(cache = slab_get_cache())) return NULL;
+    if (!cache->list[class] && !slab_refill(cache, class)) return NULL;
+
+    block = cache->list[class];
+    cache->list[class] = *(void **)block;
+    cache->count[class]--;
+
+    slab = (struct slab *)((ULONG_PTR)block & ~(ULONG_PTR)(SLAB_SIZE - 1));
+    slab->sizes[slab_index(slab, block)] = size + 1;
+    if (flags & HEAP_ZERO_MEMORY) memset(block, 0, size);
+    return block;
+}
+
+static BOOL slab_free(struct slab *slab, void *ptr)
+{
+    struct slab_cache *cache;
+    int idx = slab_index(slab, ptr);
+
+    if (idx == -1 || !slab->sizes[idx])
+    {
+        WARN("invalid or freed block %p\n", ptr);
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return FALSE;
+    }
+    slab->sizes[idx] = 0;
+
+    if (!(cache = slab_get_cache()))
+    {
+        EnterCriticalSection(&slab_cs);
+        *(void **)ptr = slab_classes[slab->class].free_list;
+        slab_classes[slab->class].free_list = ptr;
+        LeaveCriticalSection(&slab_cs);
+        return TRUE;
+    }
+
+    *(void **)ptr = cache->list[slab->class];
+    cache->list[slab->class] = ptr;
+    if (++cache->count[slab->class] > SLAB_CACHE_MAX)
+        slab_release(cache, slab->class, SLAB_BATCH);
+    return TRUE;
+}
+
+static void *slab_realloc(struct slab *slab, DWORD flags, void *ptr, MSVCRT_size_t size)
+{
+    int idx = slab_index(slab, ptr);
+    MSVCRT_size_t old_size;
+    void *ret;
+
+    if (idx == -1 || !slab->sizes[idx]) return NULL;
+    old_size = slab->sizes[idx] - 1;
+
+    if (size <= slab_block_size(slab))
+    {
+        if ((flags & HEAP_ZERO_MEMORY) && size > old_size)
+            memset((char *)ptr + old_size, 0, size - old_size);
+        slab->sizes[idx] = size + 1;
+        return ptr;
+    }
+    if (flags & HEAP_REALLOC_IN_PLACE_ONLY) return NULL;
+
+    if (!(ret = msvcrt_heap_alloc(flags, size))) return NULL;
+    memcpy(ret, ptr, old_size);
+    slab_free(slab, ptr);
+    return ret;
+}
+
+/* continues a heap walk into the used blocks of the slabs */
+static int slab_walk(struct MSVCRT__heapinfo *next)
+{
+    struct slab *slab = next->_pentry ? slab_find(next->_pentry) : NULL;
+    unsigned int i = 0, idx = 0;
+
+    if (slab)
+    {
+        i = slab_hash(slab);
+        while (slab_table[i] != slab) i = (i + 1) % SLAB_TABLE_SIZE;
+        idx = ((char *)next->_pentry - slab->data) / slab_block_size(slab) + 1;
+    }
+
+    for (; i < SLAB_TABLE_SIZE; i++, idx = 0)
+    {
+        if (!(slab = slab_table[i])) continue;
+        for (; idx < slab->count; idx++)
+        {
+            if (!slab->sizes[idx]) continue;
+            next->_pentry = (int *)(slab->data + idx * slab_block_size(slab));
+            next->_size = slab->sizes[idx] - 1;
+            next->_useflag = MSVCRT__USEDENTRY;
+            return MSVCRT__HEAPOK;
+        }
+    }
+    return MSVCRT__HEAPEND;
+}
+
 static void* msvcrt_heap_alloc(DWORD flags, MSVCRT_size_t size)
 {
+    void *ret;
+
     if(size < MSVCRT_sbh_threshold)
     {
         void *memblock, *temp, **saved;
@@ -67,11 +343,19 @@ static void* msvcrt_heap_alloc(DWORD flags, MSVCRT_size_t size)
         return memblock;
     }
 
+    if(size <= SLAB_MAX_BLOCK && (ret = slab_alloc(flags, size)))
+        return ret;
+
     return HeapAlloc(heap, flags, size);
 }
 
 static void* msvcrt_heap_realloc(DWORD flags, void *ptr, MSVCRT_size_t size)
 {
+    struct slab *slab;
+
+    if((slab = slab_find(ptr)))
+        return slab_realloc(slab, flags, ptr, size);
+
     if(sb_heap && ptr && !HeapValidate(heap, 0, ptr))
     {
         /* TODO: move data to normal heap if it exceeds sbh_threshold limit */
@@ -104,6 +388,11 @@ static void* msvcrt_heap_realloc(DWORD flags, void *ptr, MSVCRT_size_t size)
 
 static BOOL msvcrt_heap_free(void *ptr)
 {
+    struct slab *slab;
+
+    if((slab = slab_find(ptr)))
+        return slab_free(slab, ptr);
+
     if(sb_heap && ptr && !HeapValidate(heap, 0, ptr))
     {
         void **saved = SAVED_PTR(ptr);
@@ -115,6 +404,16 @@ static BOOL msvcrt_heap_free(void *ptr)
 
 static MSVCRT_size_t msvcrt_heap_size(void *ptr)
 {
+    struct slab *slab;
+    int idx;
+
+    if((slab = slab_find(ptr)))
+    {
+        if((idx = slab_index(slab, ptr)) == -1 || !slab->sizes[idx])
+            return ~(MSVCRT_size_t)0;
+        return slab->sizes[idx] - 1;
+    }
+
     if(sb_heap && ptr && !HeapValidate(heap, 0, ptr))
     {
         void **saved = SAVED_PTR(ptr);
@@ -268,6 +567,7 @@ int CDECL _heapchk(void)
  */
 int CDECL _heapmin(void)
 {
+  slab_flush_cache();
   if (!HeapCompact( heap, 0 ) ||
           (sb_heap && !HeapCompact( sb_heap, 0 )))
   {
@@ -288,6 +588,9 @@ int CDECL _heapwalk(struct MSVCRT__heapinfo* next)
   if (sb_heap)
       FIXME("small blocks heap not supported\n");
 
+  if (next->_pentry && slab_find(next->_pentry))
+      return slab_walk(next);
+
   LOCK_HEAP;
   phe.lpData = next->_pentry;
   phe.cbData = next->_size;
@@ -307,7 +610,10 @@ int CDECL _heapwalk(struct MSVCRT__heapinfo* next)
     {
       UNLOCK_HEAP;
       if (GetLastError() == ERROR_NO_MORE_ITEMS)
-         return MSVCRT__HEAPEND;
+      {
+         next->_pentry = NULL;
+         return slab_walk(next);
+      }
       msvcrt_set_errno(GetLastError());
       if (!phe.lpData)
         return MSVCRT__HEAPBADBEGIN;
@@ -871,11 +1177,29 @@ int CDECL MSVCRT_strncpy_s(char *dest, MSVCRT_size_t numberOfElements,
 BOOL msvcrt_init_heap(void)
 {
     heap = HeapCreate(0, 0, 0);
+    slab_tls = TlsAlloc();
     return heap != NULL;
 }
 
+void msvcrt_free_heap_cache(void)
+{
+    struct slab_cache *cache;
+
+    if (slab_tls == TLS_OUT_OF_INDEXES || !(cache = TlsGetValue(slab_tls))) return;
+    slab_flush_cache();
+    TlsSetValue(slab_tls, NULL);
+    HeapFree(GetProcessHeap(), 0, cache);
+}
+
 void msvcrt_destroy_heap(void)
 {
+    unsigned int i;
+
+    msvcrt_free_heap_cache();
+    if (slab_tls != TLS_OUT_OF_INDEXES)
+        TlsFree(slab_tls);
+    for (i = 0; i < SLAB_TABLE_SIZE; i++)
+        if (slab_table[i]) VirtualFree(slab_table[i], 0, MEM_RELEASE);
     HeapDestroy(heap);
     if(sb_heap)
         HeapDestroy(sb_heap);
@@ -263,16 +263,11 @@ static inline void FUNC_NAME(pf_rebuild_format_string)(char *p, FUNC_NAME(pf_fla
 static inline void FUNC_NAME(pf_integer_conv)(APICHAR *buf, int buf_len,
         FUNC_NAME(pf_flags) *flags, LONGLONG x)
 {
-    unsigned int base;
+    char number[24], *end = number + sizeof(number), *p = end;
+    ULONGLONG v = x;
+    unsigned int v32;
     const char *digits;
-    int i, j, k;
-
-    if(flags->Format == 'o')
-        base = 8;
-    else if(flags->Format=='x' || flags->Format=='X')
-        base = 16;
-    else
-        base = 10;
+    int i, k;
 
     if(flags->Format == 'X')
         digits = "0123456789ABCDEFX";
@@ -280,44 +275,48 @@ static inline void FUNC_NAME(pf_integer_conv)(APICHAR *buf, int buf_len,
         digits = "0123456789abcdefx";
 
     if(x<0 && (flags->Format=='d' || flags->Format=='i')) {
-        x = -x;
+        v = -(ULONGLONG)x;
         flags->Sign = '-';
     }
 
-    i = 0;
-    if(x == 0) {
+    /* digits are generated backwards, so no reversing is needed afterwards */
+    if(flags->Format == 'o') {
+        for(; v; v >>= 3)
+            *--p = '0' + (v & 7);
+    } else if(flags->Format=='x' || flags->Format=='X') {
+        for(; v; v >>= 4)
+            *--p = digits[v & 15];
+    } else {
+        /* avoid 64-bit divisions once the value fits in 32 bits */
+        for(; v > 0xffffffff; v /= 10)
+            *--p = '0' + v % 10;
+        for(v32 = v; v32; v32 /= 10)
+            *--p = '0' + v32 % 10;
+    }
+
+    if(p == end) {
         flags->Alternate = 0;
         if(flags->Precision)
-            buf[i++] = '0';
-    } else {
-        while(x != 0) {
-            j = (ULONGLONG)x%base;
-            x = (ULONGLONG)x/base;
-            buf[i++] = digits[j];
-        }
+            *--p = '0';
     }
-    k = flags->Precision-i;
-    while(k-- > 0)
-        buf[i++] = '0';
+
+    i = 0;
+    k = flags->Precision - (end - p);
     if(flags->Alternate) {
-        if(base == 16) {
-            buf[i++] = digits[16];
+        if(flags->Format=='x' || flags->Format=='X') {
             buf[i++] = '0';
-        } else if(base==8 && buf[i-1]!='0')
+            buf[i++] = digits[16];
+        } else if(flags->Format=='o' && k<=0)
             buf[i++] = '0';
     }
+    while(k-- > 0)
+        buf[i++] = '0';
+    while(p < end)
+        buf[i++] = *p++;
 
     /* Adjust precision so pf_fill won't truncate the number later */
     flags->Precision = i;
-
     buf[i] = '\0';
-    j = 0;
-    while(--i > j) {
-        APICHAR tmp = buf[j];
-        buf[j] = buf[i];
-        buf[i] = tmp;
-        j++;
-    }
 }
 
 static inline void FUNC_NAME(pf_fixup_exponent)(char *buf, BOOL three_digit_exp)
@@ -379,10 +378,9 @@ int FUNC_NAME(pf_printf)(FUNC_NAME(puts_clbk) pf_puts, void *puts_ctx, const API
     if (!MSVCRT_CHECK_PMT(fmt != NULL))
         return -1;
 
-    if(!locale)
-        locinfo = get_locinfo();
-    else
-        locinfo = locale->locinfo;
+    /* The thread locale is only needed for string and floating point
+     * conversions, look it up lazily. */
+    locinfo = locale ? locale->locinfo : NULL;
 
     while(*p) {
         /* output characters before '%' */
@@ -505,6 +503,9 @@ int FUNC_NAME(pf_printf)(FUNC_NAME(puts_clbk) pf_puts, void *puts_ctx, const API
 
         flags.Format = *p;
 
+        if(!locinfo && flags.Format && strchr("sScCaeEfFgG", flags.Format))
+            locinfo = get_locinfo();
+
         if(flags.Format == 's' || flags.Format == 'S') {
             i = FUNC_NAME(pf_handle_string)(pf_puts, puts_ctx,
                     pf_args(args_ctx, pos, VT_PTR, valist).get_ptr,
@@ -550,7 +551,7 @@ int FUNC_NAME(pf_printf)(FUNC_NAME(puts_clbk) pf_puts, void *puts_ctx, const API
 
             max_len = (flags.FieldLength>flags.Precision ? flags.FieldLength : flags.Precision) + 10;
             if(max_len > sizeof(buf)/sizeof(APICHAR))
-                tmp = HeapAlloc(GetProcessHeap(), 0, max_len);
+                tmp = HeapAlloc(GetProcessHeap(), 0, max_len*sizeof(APICHAR));
             if(!tmp)
                 return -1;
 
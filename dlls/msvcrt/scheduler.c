@@ -110,11 +110,16 @@ struct scheduler_list {
     struct scheduler_list *next;
 };
 
+struct scheduler_pool;
+
 typedef struct {
     Context context;
     struct scheduler_list scheduler;
     unsigned int id;
     union allocator_cache_entry *allocator_cache[8];
+    struct scheduler_pool *pool;
+    int queue;
+    int oversubscribe;
 } ExternalContextBase;
 extern const vtable_ptr MSVCRT_ExternalContextBase_vtable;
 static void ExternalContextBase_ctor(ExternalContextBase*);
@@ -156,9 +161,47 @@ typedef struct {
     int shutdown_size;
     HANDLE *shutdown_events;
     CRITICAL_SECTION cs;
+    struct scheduler_pool *pool;
 } ThreadScheduler;
 extern const vtable_ptr MSVCRT_ThreadScheduler_vtable;
 
+struct scheduler_task {
+    void (__cdecl *proc)(void*);
+    void *data;
+};
+
+/* Every virtual processor owns a task queue. The worker running on it
+ * pushes and pops tasks at the tail, idle workers steal from the head. */
+struct scheduler_queue {
+    CRITICAL_SECTION cs;
+    struct scheduler_task *tasks;
+    unsigned int head;
+    unsigned int count;
+    unsigned int size;
+};
+
+struct scheduler_pool {
+    LONG ref;
+    ThreadScheduler *scheduler;
+    CRITICAL_SECTION cs;
+    HANDLE wake;
+    unsigned int queue_count;
+    struct scheduler_queue *queues;
+    unsigned int min_workers;
+    unsigned int stack_size;
+    LONG workers;
+    LONG idle;
+    LONG next_queue;
+    LONG oversubscribed;
+    LONG extra_workers;
+    BOOL shutdown;
+};
+
+struct scheduler_worker {
+    struct scheduler_pool *pool;
+    int queue;
+};
+
 typedef struct {
     Scheduler *scheduler;
 } _Scheduler;
@@ -181,6 +224,7 @@ static SchedulerPolicy default_scheduler_policy;
 static ThreadScheduler *default_scheduler;
 
 static void create_default_scheduler(void);
+static BOOL scheduler_pool_start_worker(struct scheduler_pool*, int);
 
 static Context* try_get_current_context(void)
 {
@@ -284,7 +328,39 @@ MSVCRT_bool __cdecl Context_IsCurrentTaskCollectionCanceling(void)
 /* ?Oversubscribe@Context@Concurrency@@SAX_N@Z */
 void __cdecl Context_Oversubscribe(MSVCRT_bool begin)
 {
-    FIXME("(%x)\n", begin);
+    ExternalContextBase *context = (ExternalContextBase*)try_get_current_context();
+    struct scheduler_pool *pool;
+
+    TRACE("(%x)\n", begin);
+
+    /* only contexts running on a virtual processor can be oversubscribed */
+    if(!context || context->context.vtable != &MSVCRT_ExternalContextBase_vtable
+            || !(pool = context->pool))
+        return;
+
+    if(begin) {
+        if(context->oversubscribe++)
+            return;
+
+        EnterCriticalSection(&pool->cs);
+        pool->oversubscribed++;
+        if(pool->extra_workers < pool->oversubscribed && scheduler_pool_start_worker(pool, -1))
+            pool->extra_workers++;
+        LeaveCriticalSection(&pool->cs);
+    } else {
+        if(!context->oversubscribe) {
+            WARN("context is not oversubscribed\n");
+            return;
+        }
+        if(--context->oversubscribe)
+            return;
+
+        EnterCriticalSection(&pool->cs);
+        pool->oversubscribed--;
+        LeaveCriticalSection(&pool->cs);
+        /* let the additional worker notice it's no longer needed */
+        ReleaseSemaphore(pool->wake, 1, NULL);
+    }
 }
 
 /* ?ScheduleGroupId@Context@Concurrency@@SAIXZ */
@@ -313,8 +389,8 @@ unsigned int __thiscall ExternalContextBase_GetId(const ExternalContextBase *thi
 DEFINE_THISCALL_WRAPPER(ExternalContextBase_GetVirtualProcessorId, 4)
 unsigned int __thiscall ExternalContextBase_GetVirtualProcessorId(const ExternalContextBase *this)
 {
-    FIXME("(%p)->() stub\n", this);
-    return -1;
+    TRACE("(%p)->()\n", this);
+    return this->pool && this->queue >= 0 ? this->queue : -1;
 }
 
 DEFINE_THISCALL_WRAPPER(ExternalContextBase_GetScheduleGroupId, 4)
@@ -623,6 +699,269 @@ void __thiscall SchedulerPolicy_dtor(SchedulerPolicy *this)
     MSVCRT_operator_delete(this->policy_container);
 }
 
+static BOOL scheduler_queue_push(struct scheduler_queue *queue, const struct scheduler_task *task)
+{
+    EnterCriticalSection(&queue->cs);
+    if(queue->count == queue->size) {
+        unsigned int i, size = queue->size ? queue->size * 2 : 32;
+        struct scheduler_task *tasks = MSVCRT_malloc(size * sizeof(*tasks));
+
+        if(!tasks) {
+            LeaveCriticalSection(&queue->cs);
+            return FALSE;
+        }
+
+        for(i=0; i<queue->count; i++)
+            tasks[i] = queue->tasks[(queue->head + i) % queue->size];
+        MSVCRT_free(queue->tasks);
+        queue->tasks = tasks;
+        queue->head = 0;
+        queue->size = size;
+    }
+    queue->tasks[(queue->head + queue->count++) % queue->size] = *task;
+    LeaveCriticalSection(&queue->cs);
+    return TRUE;
+}
+
+static BOOL scheduler_queue_pop(struct scheduler_queue *queue, BOOL steal, struct scheduler_task *task)
+{
+    BOOL ret = FALSE;
+
+    if(!queue->count)
+        return FALSE;
+
+    EnterCriticalSection(&queue->cs);
+    if(queue->count) {
+        if(steal) {
+            *task = queue->tasks[queue->head];
+            queue->head = (queue->head + 1) % queue->size;
+        } else {
+            *task = queue->tasks[(queue->head + queue->count - 1) % queue->size];
+        }
+        queue->count--;
+        ret = TRUE;
+    }
+    LeaveCriticalSection(&queue->cs);
+    return ret;
+}
+
+static struct scheduler_pool* scheduler_pool_create(ThreadScheduler *scheduler)
+{
+    struct scheduler_pool *pool;
+    unsigned int i;
+
+    pool = MSVCRT_operator_new(sizeof(*pool));
+    memset(pool, 0, sizeof(*pool));
+    pool->ref = 1;
+    pool->scheduler = scheduler;
+    pool->queue_count = scheduler->virt_proc_no;
+    pool->min_workers = SchedulerPolicy_GetPolicyValue(&scheduler->policy, MinConcurrency);
+    if(pool->min_workers > pool->queue_count)
+        pool->min_workers = pool->queue_count;
+    pool->stack_size = SchedulerPolicy_GetPolicyValue(&scheduler->policy, ContextStackSize) * 1024;
+
+    pool->wake = CreateSemaphoreW(NULL, 0, MAXLONG, NULL);
+    if(!pool->wake) {
+        MSVCRT_operator_delete(pool);
+        throw_exception(EXCEPTION_SCHEDULER_RESOURCE_ALLOCATION_ERROR,
+                HRESULT_FROM_WIN32(GetLastError()), NULL);
+        return NULL;
+    }
+
+    pool->queues = MSVCRT_malloc(pool->queue_count * sizeof(*pool->queues));
+    if(!pool->queues) {
+        CloseHandle(pool->wake);
+        MSVCRT_operator_delete(pool);
+        throw_exception(EXCEPTION_BAD_ALLOC, 0, "bad allocation");
+        return NULL;
+    }
+    memset(pool->queues, 0, pool->queue_count * sizeof(*pool->queues));
+    for(i=0; i<pool->queue_count; i++) {
+        InitializeCriticalSection(&pool->queues[i].cs);
+        pool->queues[i].cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": scheduler_queue");
+    }
+
+    InitializeCriticalSection(&pool->cs);
+    pool->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": scheduler_pool");
+    return pool;
+}
+
+static void scheduler_pool_release(struct scheduler_pool *pool)
+{
+    unsigned int i;
+
+    if(InterlockedDecrement(&pool->ref))
+        return;
+
+    for(i=0; i<pool->queue_count; i++) {
+        pool->queues[i].cs.DebugInfo->Spare[0] = 0;
+        DeleteCriticalSection(&pool->queues[i].cs);
+        MSVCRT_free(pool->queues[i].tasks);
+    }
+    MSVCRT_free(pool->queues);
+    CloseHandle(pool->wake);
+    pool->cs.DebugInfo->Spare[0] = 0;
+    DeleteCriticalSection(&pool->cs);
+    MSVCRT_operator_delete(pool);
+}
+
+/* Pops a task from the worker's own queue, or steals one from the others.
+ * Workers without a queue (queue == -1) only steal. */
+static BOOL scheduler_pool_get_task(struct scheduler_pool *pool, int queue, struct scheduler_task *task)
+{
+    unsigned int i, idx, start;
+
+    if(queue >= 0 && scheduler_queue_pop(&pool->queues[queue], FALSE, task))
+        return TRUE;
+
+    start = queue >= 0 ? queue + 1 : 0;
+    for(i=0; i<pool->queue_count; i++) {
+        idx = (start + i) % pool->queue_count;
+        if(idx == queue)
+            continue;
+        if(scheduler_queue_pop(&pool->queues[idx], TRUE, task))
+            return TRUE;
+    }
+    return FALSE;
+}
+
+/* Called by additional workers started by Context::Oversubscribe, returns
+ * TRUE if the worker is no longer needed. */
+static BOOL scheduler_pool_retire_worker(struct scheduler_pool *pool)
+{
+    BOOL ret;
+
+    EnterCriticalSection(&pool->cs);
+    ret = pool->extra_workers > pool->oversubscribed;
+    if(ret)
+        pool->extra_workers--;
+    LeaveCriticalSection(&pool->cs);
+    return ret;
+}
+
+static DWORD WINAPI scheduler_worker_proc(void *arg)
+{
+    struct scheduler_worker *worker = arg;
+    struct scheduler_pool *pool = worker->pool;
+    int queue = worker->queue;
+    ExternalContextBase *context;
+    struct scheduler_task task;
+
+    MSVCRT_free(worker);
+
+    context = (ExternalContextBase*)get_current_context();
+    context->pool = pool;
+    context->queue = queue;
+
+    for(;;) {
+        if(scheduler_pool_get_task(pool, queue, &task)) {
+            Scheduler *scheduler = context->scheduler.scheduler;
+
+            /* every queued task holds a reference to the scheduler */
+            context->scheduler.scheduler = &pool->scheduler->scheduler;
+            task.proc(task.data);
+            context->scheduler.scheduler = scheduler;
+            call_Scheduler_Release(&pool->scheduler->scheduler);
+            continue;
+        }
+
+        if(pool->shutdown || (queue < 0 && scheduler_pool_retire_worker(pool)))
+            break;
+
+        InterlockedIncrement(&pool->idle);
+        WaitForSingleObject(pool->wake, INFINITE);
+        InterlockedDecrement(&pool->idle);
+    }
+
+    context->pool = NULL;
+    scheduler_pool_release(pool);
+    return 0;
+}
+
+static BOOL scheduler_pool_start_worker(struct scheduler_pool *pool, int queue)
+{
+    struct scheduler_worker *worker;
+    HANDLE thread;
+
+    worker = MSVCRT_malloc(sizeof(*worker));
+    if(!worker)
+        return FALSE;
+    worker->pool = pool;
+    worker->queue = queue;
+
+    InterlockedIncrement(&pool->ref);
+    thread = CreateThread(NULL, pool->stack_size, scheduler_worker_proc, worker, 0, NULL);
+    if(!thread) {
+        WARN("failed to create worker thread, error %u\n", GetLastError());
+        InterlockedDecrement(&pool->ref);
+        MSVCRT_free(worker);
+        return FALSE;
+    }
+    CloseHandle(thread);
+    return TRUE;
+}
+
+/* Starts one more worker, or enough of them to satisfy MinConcurrency. */
+static void scheduler_pool_add_workers(struct scheduler_pool *pool)
+{
+    EnterCriticalSection(&pool->cs);
+    do {
+        if(pool->workers >= pool->queue_count)
+            break;
+        if(!scheduler_pool_start_worker(pool, pool->workers))
+            break;
+        pool->workers++;
+    } while(pool->workers < pool->min_workers);
+    LeaveCriticalSection(&pool->cs);
+
+    if(!pool->workers)
+        throw_exception(EXCEPTION_SCHEDULER_RESOURCE_ALLOCATION_ERROR,
+                HRESULT_FROM_WIN32(GetLastError()), NULL);
+}
+
+static void scheduler_pool_schedule(struct scheduler_pool *pool,
+        void (__cdecl *proc)(void*), void *data)
+{
+    ExternalContextBase *context = (ExternalContextBase*)try_get_current_context();
+    struct scheduler_task task;
+    unsigned int queue;
+
+    if(pool->workers < pool->queue_count
+            && (pool->workers < pool->min_workers || !pool->idle))
+        scheduler_pool_add_workers(pool);
+
+    /* tasks created on a virtual processor stay on its queue,
+     * others are distributed between the running workers */
+    if(context && context->context.vtable == &MSVCRT_ExternalContextBase_vtable
+            && context->pool == pool && context->queue >= 0)
+        queue = context->queue;
+    else
+        queue = (unsigned int)InterlockedIncrement(&pool->next_queue) % pool->workers;
+
+    task.proc = proc;
+    task.data = data;
+    call_Scheduler_Reference(&pool->scheduler->scheduler);
+    if(!scheduler_queue_push(&pool->queues[queue], &task)) {
+        call_Scheduler_Release(&pool->scheduler->scheduler);
+        throw_exception(EXCEPTION_BAD_ALLOC, 0, "bad allocation");
+        return;
+    }
+    ReleaseSemaphore(pool->wake, 1, NULL);
+}
+
+static struct scheduler_pool* ThreadScheduler_get_pool(ThreadScheduler *this)
+{
+    struct scheduler_pool *pool;
+
+    if(this->pool)
+        return this->pool;
+
+    pool = scheduler_pool_create(this);
+    if(InterlockedCompareExchangePointer((void**)&this->pool, pool, NULL))
+        scheduler_pool_release(pool);
+    return this->pool;
+}
+
 static void ThreadScheduler_dtor(ThreadScheduler *this)
 {
     int i;
@@ -630,6 +969,13 @@ static void ThreadScheduler_dtor(ThreadScheduler *this)
     if(this->ref != 0) WARN("ref = %d\n", this->ref);
     SchedulerPolicy_dtor(&this->policy);
 
+    if(this->pool) {
+        /* no tasks are left, let the workers exit */
+        this->pool->shutdown = TRUE;
+        ReleaseSemaphore(this->pool->wake, this->pool->workers + this->pool->extra_workers, NULL);
+        scheduler_pool_release(this->pool);
+    }
+
     for(i=0; i<this->shutdown_count; i++)
         SetEvent(this->shutdown_events[i]);
     MSVCRT_operator_delete(this->shutdown_events);
@@ -746,14 +1092,16 @@ DEFINE_THISCALL_WRAPPER(ThreadScheduler_ScheduleTask_loc, 16)
 void __thiscall ThreadScheduler_ScheduleTask_loc(ThreadScheduler *this,
         void (__cdecl *proc)(void*), void* data, /*location*/void *placement)
 {
-    FIXME("(%p %p %p %p) stub\n", this, proc, data, placement);
+    FIXME("(%p %p %p %p) placement ignored\n", this, proc, data, placement);
+    scheduler_pool_schedule(ThreadScheduler_get_pool(this), proc, data);
 }
 
 DEFINE_THISCALL_WRAPPER(ThreadScheduler_ScheduleTask, 12)
 void __thiscall ThreadScheduler_ScheduleTask(ThreadScheduler *this,
         void (__cdecl *proc)(void*), void* data)
 {
-    FIXME("(%p %p %p) stub\n", this, proc, data);
+    TRACE("(%p %p %p)\n", this, proc, data);
+    scheduler_pool_schedule(ThreadScheduler_get_pool(this), proc, data);
 }
 
 DEFINE_THISCALL_WRAPPER(ThreadScheduler_IsAvailableLocation, 8)
@@ -800,9 +1148,12 @@ static ThreadScheduler* ThreadScheduler_ctor(ThreadScheduler *this,
     this->virt_proc_no = SchedulerPolicy_GetPolicyValue(&this->policy, MaxConcurrency);
     if(this->virt_proc_no > si.dwNumberOfProcessors)
         this->virt_proc_no = si.dwNumberOfProcessors;
+    if(this->virt_proc_no < SchedulerPolicy_GetPolicyValue(&this->policy, MinConcurrency))
+        this->virt_proc_no = SchedulerPolicy_GetPolicyValue(&this->policy, MinConcurrency);
 
     this->shutdown_count = this->shutdown_size = 0;
     this->shutdown_events = NULL;
+    this->pool = NULL;
 
     InitializeCriticalSection(&this->cs);
     this->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": ThreadScheduler");
@@ -708,13 +708,11 @@ int CDECL MSVCRT__strnicoll( const char* str1, const char* str2, MSVCRT_size_t c
  */
 char* __cdecl MSVCRT_strncpy(char *dst, const char *src, MSVCRT_size_t len)
 {
-    MSVCRT_size_t i;
-
-    for(i=0; i<len; i++)
-        if((dst[i] = src[i]) == '\0') break;
-
-    while (i < len) dst[i++] = 0;
+    const char *end = memchr(src, 0, len);
+    MSVCRT_size_t i = end ? end - src : len;
 
+    memmove(dst, src, i);
+    memset(dst + i, 0, len - i);
     return dst;
 }
 
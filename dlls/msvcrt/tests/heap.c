@@ -21,6 +21,7 @@
 #include <stdlib.h>
 #include <malloc.h>
 #include <errno.h>
+#include <string.h>
 #include "wine/test.h"
 
 static void (__cdecl *p_aligned_free)(void*) = NULL;
@@ -479,6 +480,33 @@ static void test_calloc(void)
     free(ptr);
 }
 
+static void test_small_blocks(void)
+{
+    unsigned char *mem[300];
+    size_t size, i;
+
+    for (size = 0; size < 300; size++)
+    {
+        mem[size] = malloc(size);
+        ok(mem[size] != NULL, "malloc(%u) failed\n", (int)size);
+        ok(_msize(mem[size]) == size, "_msize = %u, expected %u\n", (int)_msize(mem[size]), (int)size);
+        memset(mem[size], size, size);
+    }
+
+    for (size = 0; size < 300; size++)
+    {
+        mem[size] = realloc(mem[size], size + 40);
+        ok(mem[size] != NULL, "realloc(%u) failed\n", (int)size + 40);
+        ok(_msize(mem[size]) == size + 40, "_msize = %u, expected %u\n", (int)_msize(mem[size]), (int)size + 40);
+        for (i = 0; i < size; i++) if (mem[size][i] != (unsigned char)size) break;
+        ok(i == size, "%u: data not preserved at %u\n", (int)size, (int)i);
+
+        ok(_expand(mem[size], size) == mem[size], "_expand failed\n");
+        ok(_msize(mem[size]) == size, "_msize = %u, expected %u\n", (int)_msize(mem[size]), (int)size);
+        free(mem[size]);
+    }
+}
+
 START_TEST(heap)
 {
     void *mem;
@@ -504,4 +532,5 @@ START_TEST(heap)
     test_aligned();
     test_sbheap();
     test_calloc();
+    test_small_blocks();
 }
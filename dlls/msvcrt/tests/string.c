@@ -3084,6 +3084,29 @@ static void test_strncpy(void)
     ok(!strncmp(dst, "0123456789", TEST_STRNCPY_LEN), "dst != 0123456789\n");
 }
 
+static void test_wcslen_wcschr(void)
+{
+    wchar_t buf[64];
+    size_t off, len;
+
+    for (off = 0; off < 8; off++)
+    {
+        for (len = 0; len < 40; len++)
+        {
+            wchar_t *str = buf + off;
+            size_t i;
+
+            for (i = 0; i < len; i++) str[i] = 'a' + i % 20;
+            str[len] = 0;
+            ok(wcslen(str) == len, "%u/%u: wcslen returned %u\n", (int)off, (int)len, (int)wcslen(str));
+            ok(wcschr(str, 0) == str + len, "%u/%u: wcschr(0) returned %p\n", (int)off, (int)len, wcschr(str, 0));
+            ok(wcschr(str, 'a' + 19) == (len > 19 ? str + 19 : NULL), "%u/%u: wcschr returned %p\n",
+               (int)off, (int)len, wcschr(str, 'a' + 19));
+            ok(!wcschr(str, 'z'), "%u/%u: wcschr returned %p\n", (int)off, (int)len, wcschr(str, 'z'));
+        }
+    }
+}
+
 static void test_strxfrm(void)
 {
     char dest[256];
@@ -3504,6 +3527,7 @@ START_TEST(string)
     test_atoi();
     test_atof();
     test_strncpy();
+    test_wcslen_wcschr();
     test_strxfrm();
     test__strnset_s();
     test__wcsset_s();
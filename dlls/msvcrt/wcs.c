@@ -25,6 +25,9 @@
 #include <stdio.h>
 #include <math.h>
 #include <assert.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "msvcrt.h"
 #include "winnls.h"
 #include "wtypes.h"
@@ -2425,6 +2428,32 @@ int CDECL MSVCRT_towlower(MSVCRT_wint_t c)
  */
 MSVCRT_wchar_t* CDECL MSVCRT_wcschr(const MSVCRT_wchar_t *str, MSVCRT_wchar_t ch)
 {
+#ifdef __SSE2__
+    /* Aligned 16-byte loads never cross a page boundary, so reading past
+     * the terminator can't fault. */
+    if (!((ULONG_PTR)str & 1))
+    {
+        const __m128i zero = _mm_setzero_si128(), chr = _mm_set1_epi16(ch);
+        unsigned int mask;
+        __m128i v;
+
+        while ((ULONG_PTR)str & 15)
+        {
+            if (*str == ch) return (MSVCRT_wchar_t *)str;
+            if (!*str) return NULL;
+            str++;
+        }
+        for (;;)
+        {
+            v = _mm_load_si128((const __m128i *)str);
+            mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi16(v, zero), _mm_cmpeq_epi16(v, chr)));
+            if (mask) break;
+            str += 8;
+        }
+        str += __builtin_ctz(mask) / 2;
+        return *str == ch ? (MSVCRT_wchar_t *)str : NULL;
+    }
+#endif
     return strchrW(str, ch);
 }
 
@@ -2433,6 +2462,23 @@ MSVCRT_wchar_t* CDECL MSVCRT_wcschr(const MSVCRT_wchar_t *str, MSVCRT_wchar_t ch
  */
 int CDECL MSVCRT_wcslen(const MSVCRT_wchar_t *str)
 {
+#ifdef __SSE2__
+    if (!((ULONG_PTR)str & 1))
+    {
+        const MSVCRT_wchar_t *s = str;
+        const __m128i zero = _mm_setzero_si128();
+        unsigned int mask;
+
+        while ((ULONG_PTR)s & 15)
+        {
+            if (!*s) return s - str;
+            s++;
+        }
+        while (!(mask = _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_load_si128((const __m128i *)s), zero))))
+            s += 8;
+        return s - str + __builtin_ctz(mask) / 2;
+    }
+#endif
     return strlenW(str);
 }
 
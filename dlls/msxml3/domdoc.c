@@ -87,6 +87,8 @@ typedef struct {
     LONG selectNsStr_len;
     BOOL XPath;
     IUri *uri;
+    struct list xpathCache;
+    int xpathCache_cnt;
 } domdoc_properties;
 
 typedef struct ConnectionPoint ConnectionPoint;
@@ -214,6 +216,18 @@ typedef struct _orphan_entry {
     xmlNode * node;
 } orphan_entry;
 
+/* Compiled selectNodes() queries, most recently used first. XSLPattern
+ * translation depends on selection namespaces, so the cache is flushed
+ * whenever they change. */
+#define XPATH_CACHE_SIZE 16
+
+typedef struct _xpath_cache_entry {
+    struct list entry;
+    BOOL XPath;
+    xmlChar *query;
+    xmlXPathCompExprPtr expr;
+} xpath_cache_entry;
+
 typedef struct _select_ns_entry {
     struct list entry;
     xmlChar const* prefix;
@@ -269,6 +283,74 @@ static inline void clear_selectNsList(struct list* pNsList)
     list_init(pNsList);
 }
 
+static void clear_xpath_cache(domdoc_properties *properties)
+{
+    xpath_cache_entry *entry, *entry2;
+    LIST_FOR_EACH_ENTRY_SAFE( entry, entry2, &properties->xpathCache, xpath_cache_entry, entry )
+    {
+        xmlXPathFreeCompExpr( entry->expr );
+        heap_free( entry->query );
+        heap_free( entry );
+    }
+    list_init(&properties->xpathCache);
+    properties->xpathCache_cnt = 0;
+}
+
+xmlXPathCompExprPtr xmldoc_get_xpath(xmlDocPtr doc, xmlChar const* query)
+{
+    domdoc_properties *properties = properties_from_xmlDocPtr(doc);
+    xpath_cache_entry *entry;
+
+    LIST_FOR_EACH_ENTRY( entry, &properties->xpathCache, xpath_cache_entry, entry )
+    {
+        if (entry->XPath == properties->XPath && xmlStrEqual(entry->query, query))
+        {
+            list_remove( &entry->entry );
+            list_add_head( &properties->xpathCache, &entry->entry );
+            return entry->expr;
+        }
+    }
+
+    return NULL;
+}
+
+/* On success the cache takes ownership of expr. */
+HRESULT xmldoc_add_xpath(xmlDocPtr doc, xmlChar const* query, xmlXPathCompExprPtr expr)
+{
+    domdoc_properties *properties = properties_from_xmlDocPtr(doc);
+    xpath_cache_entry *entry;
+    int len = xmlStrlen(query) + 1;
+
+    if (properties->xpathCache_cnt == XPATH_CACHE_SIZE)
+    {
+        entry = LIST_ENTRY( list_tail(&properties->xpathCache), xpath_cache_entry, entry );
+        list_remove( &entry->entry );
+        xmlXPathFreeCompExpr( entry->expr );
+        heap_free( entry->query );
+    }
+    else
+    {
+        entry = heap_alloc( sizeof (*entry) );
+        if (!entry)
+            return E_OUTOFMEMORY;
+        properties->xpathCache_cnt++;
+    }
+
+    entry->query = heap_alloc( len );
+    if (!entry->query)
+    {
+        heap_free( entry );
+        properties->xpathCache_cnt--;
+        return E_OUTOFMEMORY;
+    }
+
+    memcpy( entry->query, query, len );
+    entry->XPath = properties->XPath;
+    entry->expr = expr;
+    list_add_head( &properties->xpathCache, &entry->entry );
+    return S_OK;
+}
+
 static xmldoc_priv * create_priv(void)
 {
     xmldoc_priv *priv;
@@ -301,6 +383,9 @@ static domdoc_properties *create_properties(MSXML_VERSION version)
     /* document uri */
     properties->uri = NULL;
 
+    list_init(&properties->xpathCache);
+    properties->xpathCache_cnt = 0;
+
     return properties;
 }
 
@@ -338,6 +423,9 @@ static domdoc_properties* copy_properties(domdoc_properties const* properties)
         pcopy->uri = properties->uri;
         if (pcopy->uri)
             IUri_AddRef(pcopy->uri);
+
+        list_init( &pcopy->xpathCache );
+        pcopy->xpathCache_cnt = 0;
     }
 
     return pcopy;
@@ -350,6 +438,7 @@ static void free_properties(domdoc_properties* properties)
         if (properties->schemaCache)
             IXMLDOMSchemaCollection2_Release(properties->schemaCache);
         clear_selectNsList(&properties->selectNsList);
+        clear_xpath_cache(properties);
         heap_free((xmlChar*)properties->selectNsStr);
         if (properties->uri)
             IUri_Release(properties->uri);
@@ -2994,6 +3083,7 @@ static HRESULT WINAPI domdoc_setProperty(
 
         pNsList = &(This->properties->selectNsList);
         clear_selectNsList(pNsList);
+        clear_xpath_cache(This->properties);
         heap_free(nsStr);
         nsStr = xmlchar_from_wchar(bstr);
 
@@ -306,6 +306,8 @@ extern void wineXmlCallbackError(char const* caller, xmlErrorPtr err) DECLSPEC_H
 extern BOOL is_preserving_whitespace(xmlNodePtr node) DECLSPEC_HIDDEN;
 extern BOOL is_xpathmode(const xmlDocPtr doc) DECLSPEC_HIDDEN;
 extern void set_xpathmode(xmlDocPtr doc, BOOL xpath) DECLSPEC_HIDDEN;
+extern struct _xmlXPathCompExpr *xmldoc_get_xpath(xmlDocPtr doc, xmlChar const* query) DECLSPEC_HIDDEN;
+extern HRESULT xmldoc_add_xpath(xmlDocPtr doc, xmlChar const* query, struct _xmlXPathCompExpr *expr) DECLSPEC_HIDDEN;
 
 extern void init_xmlnode(xmlnode*,xmlNodePtr,IXMLDOMNode*,dispex_static_data_t*) DECLSPEC_HIDDEN;
 extern void destroy_xmlnode(xmlnode*) DECLSPEC_HIDDEN;
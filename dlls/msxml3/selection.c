@@ -769,6 +769,8 @@ HRESULT create_selection(xmlNodePtr node, xmlChar* query, IXMLDOMNodeList **out)
 {
     domselection *This = heap_alloc(sizeof(domselection));
     xmlXPathContextPtr ctxt = xmlXPathNewContext(node->doc);
+    xmlXPathCompExprPtr expr;
+    BOOL new_expr = FALSE;
     HRESULT hr;
 
     TRACE("(%p, %s, %p)\n", node, debugstr_a((char const*)query), out);
@@ -793,15 +795,19 @@ HRESULT create_selection(xmlNodePtr node, xmlChar* query, IXMLDOMNodeList **out)
     ctxt->node = node;
     registerNamespaces(ctxt);
 
+    expr = xmldoc_get_xpath(node->doc, query);
+
     if (is_xpathmode(This->node->doc))
     {
         xmlXPathRegisterAllFunctions(ctxt);
-        This->result = xmlXPathEvalExpression(query, ctxt);
+        if (!expr)
+        {
+            expr = xmlXPathCtxtCompile(ctxt, query);
+            new_expr = TRUE;
+        }
     }
     else
     {
-        xmlChar* pattern_query = XSLPattern_to_XPath(ctxt, query);
-
         xmlXPathRegisterFunc(ctxt, (xmlChar const*)"not", xmlXPathNotFunction);
         xmlXPathRegisterFunc(ctxt, (xmlChar const*)"boolean", xmlXPathBooleanFunction);
 
@@ -816,10 +822,22 @@ HRESULT create_selection(xmlNodePtr node, xmlChar* query, IXMLDOMNodeList **out)
         xmlXPathRegisterFunc(ctxt, (xmlChar const*)"OP_IGt", XSLPattern_OP_IGt);
         xmlXPathRegisterFunc(ctxt, (xmlChar const*)"OP_IGEq", XSLPattern_OP_IGEq);
 
-        This->result = xmlXPathEvalExpression(pattern_query, ctxt);
-        xmlFree(pattern_query);
+        if (!expr)
+        {
+            xmlChar* pattern_query = XSLPattern_to_XPath(ctxt, query);
+
+            if (pattern_query)
+                expr = xmlXPathCtxtCompile(ctxt, pattern_query);
+            xmlFree(pattern_query);
+            new_expr = TRUE;
+        }
     }
 
+    This->result = expr ? xmlXPathCompiledEval(expr, ctxt) : NULL;
+
+    if (new_expr && expr && FAILED(xmldoc_add_xpath(node->doc, query, expr)))
+        xmlXPathFreeCompExpr(expr);
+
     if (!This->result || This->result->type != XPATH_NODESET)
     {
         hr = E_FAIL;
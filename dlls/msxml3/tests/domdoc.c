@@ -4970,6 +4970,8 @@ if (0)
     /* now the namespace can be used */
     ole_check(IXMLDOMDocument2_selectNodes(doc, _bstr_("root//test:c"), &list));
     expect_list_and_release(list, "E3.E3.E2.D1 E3.E4.E2.D1");
+    ole_check(IXMLDOMDocument2_selectNodes(doc, _bstr_("root//test:c"), &list));
+    expect_list_and_release(list, "E3.E3.E2.D1 E3.E4.E2.D1");
     ole_check(IXMLDOMNode_selectNodes(rootNode, _bstr_(".//test:c"), &list));
     expect_list_and_release(list, "E3.E3.E2.D1 E3.E4.E2.D1");
     ole_check(IXMLDOMNode_selectNodes(elem1Node, _bstr_("//test:c"), &list));
@@ -156,11 +156,24 @@ struct strsection_header
     DWORD unk1[3];
     ULONG count;
     ULONG index_offset;
-    DWORD unk2[2];
+    ULONG hash_alg;      /* string hash algorithm */
+    ULONG search_offset; /* hash table offset, 0 if none */
     ULONG global_offset;
     ULONG global_len;
 };
 
+struct strsection_hash_table
+{
+    ULONG bucket_count;
+    ULONG bucket_offset; /* offset of the bucket array, relative to the section */
+};
+
+struct strsection_hash_bucket
+{
+    ULONG chain_count;
+    ULONG chain_offset;  /* offset of the array of string_index offsets */
+};
+
 struct string_index
 {
     ULONG hash;        /* key string hash */
@@ -3378,6 +3391,54 @@ static NTSTATUS find_query_actctx( HANDLE *handle, DWORD flags, ULONG class )
     return status;
 }
 
+/* append the hash table used to look up string keys, in the same format as Windows */
+static void add_strsection_hash_table(struct strsection_header **section)
+{
+    struct strsection_header *header = *section;
+    struct strsection_hash_table *table;
+    struct strsection_hash_bucket *buckets;
+    struct string_index *index;
+    ULONG *chains, *pos;
+    ULONG i, size, offset, bucket_count;
+
+    if (!header->count) return;
+
+    bucket_count = header->count | 1;
+    offset = aligned_string_len(RtlSizeHeap(GetProcessHeap(), 0, header));
+    size = sizeof(*table) + bucket_count * sizeof(*buckets) + header->count * sizeof(*chains);
+    if (!(header = RtlReAllocateHeap(GetProcessHeap(), 0, header, offset + size))) return;
+    *section = header;
+
+    table = (struct strsection_hash_table *)((BYTE *)header + offset);
+    buckets = (struct strsection_hash_bucket *)(table + 1);
+    chains = (ULONG *)(buckets + bucket_count);
+    table->bucket_count = bucket_count;
+    table->bucket_offset = (BYTE *)buckets - (BYTE *)header;
+    memset(buckets, 0, bucket_count * sizeof(*buckets));
+
+    index = (struct string_index *)((BYTE *)header + header->index_offset);
+    for (i = 0; i < header->count; i++) buckets[index[i].hash % bucket_count].chain_count++;
+
+    pos = chains;
+    for (i = 0; i < bucket_count; i++)
+    {
+        buckets[i].chain_offset = (BYTE *)pos - (BYTE *)header;
+        pos += buckets[i].chain_count;
+        buckets[i].chain_count = 0;
+    }
+
+    /* keep the index order within each chain, so that the first matching entry wins */
+    for (i = 0; i < header->count; i++)
+    {
+        struct strsection_hash_bucket *bucket = &buckets[index[i].hash % bucket_count];
+        pos = (ULONG *)((BYTE *)header + bucket->chain_offset);
+        pos[bucket->chain_count++] = (BYTE *)&index[i] - (BYTE *)header;
+    }
+
+    header->hash_alg = HASH_STRING_ALGORITHM_X65599;
+    header->search_offset = offset;
+}
+
 static NTSTATUS build_dllredirect_section(ACTIVATION_CONTEXT* actctx, struct strsection_header **section)
 {
     unsigned int i, j, total_len = 0, dll_count = 0;
@@ -3456,6 +3517,7 @@ static NTSTATUS build_dllredirect_section(ACTIVATION_CONTEXT* actctx, struct str
     }
 
     *section = header;
+    add_strsection_hash_table(section);
 
     return STATUS_SUCCESS;
 }
@@ -3466,6 +3528,24 @@ static struct string_index *find_string_index(const struct strsection_header *se
     ULONG hash = 0, i;
 
     RtlHashUnicodeString(name, TRUE, HASH_STRING_ALGORITHM_X65599, &hash);
+
+    if (section->search_offset)
+    {
+        const struct strsection_hash_table *table = (struct strsection_hash_table*)((BYTE*)section + section->search_offset);
+        const struct strsection_hash_bucket *bucket = (struct strsection_hash_bucket*)((BYTE*)section + table->bucket_offset);
+        const ULONG *chain;
+
+        bucket += hash % table->bucket_count;
+        chain = (const ULONG*)((BYTE*)section + bucket->chain_offset);
+        for (i = 0; i < bucket->chain_count; i++)
+        {
+            iter = (struct string_index*)((BYTE*)section + chain[i]);
+            if (iter->hash == hash && !strcmpiW((WCHAR*)((BYTE*)section + iter->name_offset), name->Buffer))
+                return iter;
+        }
+        return NULL;
+    }
+
     iter = (struct string_index*)((BYTE*)section + section->index_offset);
 
     for (i = 0; i < section->count; i++)
@@ -3555,11 +3635,6 @@ static NTSTATUS find_dll_redirection(ACTIVATION_CONTEXT* actctx, const UNICODE_S
     return STATUS_SUCCESS;
 }
 
-static inline struct string_index *get_wndclass_first_index(ACTIVATION_CONTEXT *actctx)
-{
-    return (struct string_index*)((BYTE*)actctx->wndclass_section + actctx->wndclass_section->index_offset);
-}
-
 static inline struct wndclass_redirect_data *get_wndclass_data(ACTIVATION_CONTEXT *ctxt, struct string_index *index)
 {
     return (struct wndclass_redirect_data*)((BYTE*)ctxt->wndclass_section + index->data_offset);
@@ -3699,6 +3774,7 @@ static NTSTATUS build_wndclass_section(ACTIVATION_CONTEXT* actctx, struct strsec
     }
 
     *section = header;
+    add_strsection_hash_table(section);
 
     return STATUS_SUCCESS;
 }
@@ -3706,10 +3782,8 @@ static NTSTATUS build_wndclass_section(ACTIVATION_CONTEXT* actctx, struct strsec
 static NTSTATUS find_window_class(ACTIVATION_CONTEXT* actctx, const UNICODE_STRING *name,
                                   PACTCTX_SECTION_KEYED_DATA data)
 {
-    struct string_index *iter, *index = NULL;
     struct wndclass_redirect_data *class;
-    ULONG hash;
-    int i;
+    struct string_index *index;
 
     if (!(actctx->sections & WINDOWCLASS_SECTION)) return STATUS_SXS_KEY_NOT_FOUND;
 
@@ -3724,27 +3798,7 @@ static NTSTATUS find_window_class(ACTIVATION_CONTEXT* actctx, const UNICODE_STRI
             RtlFreeHeap(GetProcessHeap(), 0, section);
     }
 
-    hash = 0;
-    RtlHashUnicodeString(name, TRUE, HASH_STRING_ALGORITHM_X65599, &hash);
-    iter = get_wndclass_first_index(actctx);
-
-    for (i = 0; i < actctx->wndclass_section->count; i++)
-    {
-        if (iter->hash == hash)
-        {
-            const WCHAR *nameW = (WCHAR*)((BYTE*)actctx->wndclass_section + iter->name_offset);
-
-            if (!strcmpiW(nameW, name->Buffer))
-            {
-                index = iter;
-                break;
-            }
-            else
-                WARN("hash collision 0x%08x, %s, %s\n", hash, debugstr_us(name), debugstr_w(nameW));
-        }
-        iter++;
-    }
-
+    index = find_string_index(actctx->wndclass_section, name);
     if (!index) return STATUS_SXS_KEY_NOT_FOUND;
 
     if (data)
@@ -4763,6 +4817,7 @@ static NTSTATUS build_progid_section(ACTIVATION_CONTEXT* actctx, struct strsecti
     }
 
     *section = header;
+    add_strsection_hash_table(section);
 
     return STATUS_SUCCESS;
 }
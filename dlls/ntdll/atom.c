@@ -27,6 +27,10 @@
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
+#include <unistd.h>
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -34,6 +38,7 @@
 
 #include "wine/server.h"
 #include "wine/unicode.h"
+#include "ntdll_misc.h"
 
 #include "wine/debug.h"
 
@@ -308,16 +313,184 @@ NTSTATUS WINAPI RtlPinAtomInAtomTable( RTL_ATOM_TABLE table, RTL_ATOM atom )
  *        Global handle table management
  *************************************************/
 
+/* Global atoms are only freed or pinned by explicit requests, so lookups can be
+ * cached in the process as long as the server generation counter doesn't change.
+ * Reference counts changed by other processes are not tracked, they are only
+ * refreshed when this process adds or deletes the atom itself. */
+
+#define ATOM_CACHE_SIZE     64
+#define ATOM_CACHE_MAX_NAME 64
+
+struct cached_atom_name
+{
+    unsigned int generation;  /* generation when the atom was retrieved */
+    RTL_ATOM     atom;        /* atom, 0 if the entry is unused */
+    USHORT       len;         /* length of the name in bytes */
+    WCHAR        name[ATOM_CACHE_MAX_NAME];
+};
+
+struct cached_atom_info
+{
+    unsigned int generation;  /* generation when the information was retrieved */
+    RTL_ATOM     atom;        /* atom, 0 if the entry is unused */
+    USHORT       len;         /* length of the name in bytes */
+    ULONG        count;       /* reference count */
+    BOOLEAN      pinned;      /* whether the atom is pinned */
+    WCHAR        name[ATOM_CACHE_MAX_NAME];
+};
+
+static struct cached_atom_name atom_name_cache[ATOM_CACHE_SIZE];
+static struct cached_atom_info atom_info_cache[ATOM_CACHE_SIZE];
+static const volatile unsigned int *atom_generation;
+static BOOL atom_generation_failed;
+
+static RTL_CRITICAL_SECTION atom_cache_section;
+static RTL_CRITICAL_SECTION_DEBUG atom_cache_debug =
+{
+    0, 0, &atom_cache_section,
+    { &atom_cache_debug.ProcessLocksList, &atom_cache_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": atom_cache_section") }
+};
+static RTL_CRITICAL_SECTION atom_cache_section = { &atom_cache_debug, -1, 0, 0, 0, 0 };
+
+static inline unsigned int atom_name_bucket( const WCHAR *name, ULONG len )
+{
+    unsigned int i, hash = 0;
+
+    for (i = 0; i < len / sizeof(WCHAR); i++) hash = hash * 31 + toupperW( name[i] );
+    return hash % ATOM_CACHE_SIZE;
+}
+
+/* map the generation counter shared by the server, return FALSE if not available */
+static BOOL map_atom_generation(void)
+{
+    obj_handle_t fd_handle;
+    sigset_t sigset;
+    void *ptr;
+    int fd = -1;
+
+    if (atom_generation) return TRUE;
+    if (atom_generation_failed) return FALSE;
+
+    server_enter_uninterrupted_section( &fd_cache_section, &sigset );
+    if (!atom_generation && !atom_generation_failed)
+    {
+        SERVER_START_REQ( get_atom_generation )
+        {
+            if (!wine_server_call( req )) fd = receive_fd( &fd_handle );
+        }
+        SERVER_END_REQ;
+
+        if (fd != -1)
+        {
+            ptr = mmap( NULL, sizeof(*atom_generation), PROT_READ, MAP_SHARED, fd, 0 );
+            close( fd );
+            if (ptr != MAP_FAILED) atom_generation = ptr;
+        }
+        if (!atom_generation)
+        {
+            WARN( "global atom cache disabled\n" );
+            atom_generation_failed = TRUE;
+        }
+    }
+    server_leave_uninterrupted_section( &fd_cache_section, &sigset );
+    return atom_generation != NULL;
+}
+
+/* find the atom matching a name in the cache, return FALSE if not found */
+static BOOL get_cached_atom( const WCHAR *name, ULONG len, unsigned int generation, RTL_ATOM *atom )
+{
+    struct cached_atom_name *entry = &atom_name_cache[atom_name_bucket( name, len )];
+    BOOL ret = FALSE;
+
+    RtlEnterCriticalSection( &atom_cache_section );
+    if (entry->atom && entry->generation == generation && entry->len == len &&
+        !memicmpW( entry->name, name, len / sizeof(WCHAR) ))
+    {
+        *atom = entry->atom;
+        ret = TRUE;
+    }
+    RtlLeaveCriticalSection( &atom_cache_section );
+    return ret;
+}
+
+/* store an atom returned by the server for a name */
+static void add_cached_atom( const WCHAR *name, ULONG len, unsigned int generation, RTL_ATOM atom )
+{
+    struct cached_atom_name *entry = &atom_name_cache[atom_name_bucket( name, len )];
+
+    RtlEnterCriticalSection( &atom_cache_section );
+    entry->generation = generation;
+    entry->atom       = atom;
+    entry->len        = len;
+    memcpy( entry->name, name, len );
+    RtlLeaveCriticalSection( &atom_cache_section );
+}
+
+/* retrieve the information of an atom from the cache, return FALSE if not found */
+static BOOL get_cached_atom_info( RTL_ATOM atom, unsigned int generation, ATOM_BASIC_INFORMATION *abi,
+                                  ULONG *name_len )
+{
+    struct cached_atom_info *entry = &atom_info_cache[atom % ATOM_CACHE_SIZE];
+    BOOL ret = FALSE;
+
+    RtlEnterCriticalSection( &atom_cache_section );
+    if (entry->atom == atom && entry->generation == generation)
+    {
+        /* same results as the get_atom_information request */
+        *name_len = min( *name_len, entry->len );
+        memcpy( abi->Name, entry->name, *name_len );
+        abi->NameLength = entry->len;
+        abi->ReferenceCount = entry->count;
+        abi->Pinned = entry->pinned;
+        ret = TRUE;
+    }
+    RtlLeaveCriticalSection( &atom_cache_section );
+    return ret;
+}
+
+/* store the information of an atom returned by the server */
+static void add_cached_atom_info( RTL_ATOM atom, unsigned int generation, const ATOM_BASIC_INFORMATION *abi )
+{
+    struct cached_atom_info *entry = &atom_info_cache[atom % ATOM_CACHE_SIZE];
+
+    if (abi->NameLength > sizeof(entry->name)) return;
+
+    RtlEnterCriticalSection( &atom_cache_section );
+    entry->generation = generation;
+    entry->atom       = atom;
+    entry->len        = abi->NameLength;
+    entry->count      = abi->ReferenceCount;
+    entry->pinned     = abi->Pinned;
+    memcpy( entry->name, abi->Name, abi->NameLength );
+    RtlLeaveCriticalSection( &atom_cache_section );
+}
+
+/* forget the cached information of an atom whose reference count changed */
+static void invalidate_cached_atom_info( RTL_ATOM atom )
+{
+    struct cached_atom_info *entry = &atom_info_cache[atom % ATOM_CACHE_SIZE];
+
+    RtlEnterCriticalSection( &atom_cache_section );
+    if (entry->atom == atom) entry->atom = 0;
+    RtlLeaveCriticalSection( &atom_cache_section );
+}
+
 /******************************************************************
  *		NtAddAtom (NTDLL.@)
  */
 NTSTATUS WINAPI NtAddAtom( const WCHAR* name, ULONG length, RTL_ATOM* atom )
 {
     NTSTATUS    status;
+    unsigned int generation = 0;
+    BOOL use_cache;
 
     status = is_integral_atom( name, length / sizeof(WCHAR), atom );
     if (status == STATUS_MORE_ENTRIES)
     {
+        use_cache = length <= sizeof(atom_name_cache[0].name) && map_atom_generation();
+        if (use_cache) generation = *atom_generation;
+
         SERVER_START_REQ( add_atom )
         {
             wine_server_add_data( req, name, length );
@@ -326,6 +499,12 @@ NTSTATUS WINAPI NtAddAtom( const WCHAR* name, ULONG length, RTL_ATOM* atom )
             *atom = reply->atom;
         }
         SERVER_END_REQ;
+
+        if (!status)
+        {
+            invalidate_cached_atom_info( *atom );
+            if (use_cache) add_cached_atom( name, length, generation, *atom );
+        }
     }
     TRACE( "%s -> %x\n",
            debugstr_wn(name, length/sizeof(WCHAR)), status == STATUS_SUCCESS ? *atom : 0 );
@@ -346,6 +525,7 @@ NTSTATUS WINAPI NtDeleteAtom(RTL_ATOM atom)
         status = wine_server_call( req );
     }
     SERVER_END_REQ;
+    invalidate_cached_atom_info( atom );
     return status;
 }
 
@@ -355,18 +535,29 @@ NTSTATUS WINAPI NtDeleteAtom(RTL_ATOM atom)
 NTSTATUS WINAPI NtFindAtom( const WCHAR* name, ULONG length, RTL_ATOM* atom )
 {
     NTSTATUS    status;
+    unsigned int generation = 0;
+    BOOL use_cache;
 
     status = is_integral_atom( name, length / sizeof(WCHAR), atom );
     if (status == STATUS_MORE_ENTRIES)
     {
-        SERVER_START_REQ( find_atom )
+        use_cache = length <= sizeof(atom_name_cache[0].name) && map_atom_generation();
+        if (use_cache) generation = *atom_generation;
+        if (use_cache && get_cached_atom( name, length, generation, atom ))
+            status = STATUS_SUCCESS;
+        else
         {
-            wine_server_add_data( req, name, length );
-            req->table = 0;
-            status = wine_server_call( req );
-            *atom = reply->atom;
+            SERVER_START_REQ( find_atom )
+            {
+                wine_server_add_data( req, name, length );
+                req->table = 0;
+                status = wine_server_call( req );
+                *atom = reply->atom;
+            }
+            SERVER_END_REQ;
+
+            if (!status && use_cache) add_cached_atom( name, length, generation, *atom );
         }
-        SERVER_END_REQ;
     }
     TRACE( "%s -> %x\n",
            debugstr_wn(name, length/sizeof(WCHAR)), status == STATUS_SUCCESS ? *atom : 0 );
@@ -405,32 +596,47 @@ NTSTATUS WINAPI NtQueryInformationAtom( RTL_ATOM atom, ATOM_INFORMATION_CLASS cl
             }
             else
             {
-                SERVER_START_REQ( get_atom_information )
+                unsigned int generation = 0;
+                BOOL use_cache = map_atom_generation();
+
+                if (use_cache) generation = *atom_generation;
+                if (use_cache && get_cached_atom_info( atom, generation, abi, &name_len ))
+                    status = STATUS_SUCCESS;
+                else
                 {
-                    req->atom = atom;
-                    req->table = 0;
-                    if (name_len) wine_server_set_reply( req, abi->Name, name_len );
-                    status = wine_server_call( req );
-                    if (status == STATUS_SUCCESS)
+                    SERVER_START_REQ( get_atom_information )
                     {
-                        name_len = wine_server_reply_size( reply );
-                        if (name_len)
+                        req->atom = atom;
+                        req->table = 0;
+                        if (name_len) wine_server_set_reply( req, abi->Name, name_len );
+                        status = wine_server_call( req );
+                        if (status == STATUS_SUCCESS)
                         {
-                            abi->NameLength = name_len;
-                            abi->Name[name_len / sizeof(WCHAR)] = '\0';
+                            name_len = wine_server_reply_size( reply );
+                            abi->NameLength = reply->total;
+                            abi->ReferenceCount = reply->count;
+                            abi->Pinned = reply->pinned;
                         }
-                        else
-                        {
-                            name_len = reply->total;
-                            abi->NameLength = name_len;
-                            status = STATUS_BUFFER_TOO_SMALL;
-                        }
-                        abi->ReferenceCount = reply->count;
-                        abi->Pinned = reply->pinned;
+                        else name_len = 0;
+                    }
+                    SERVER_END_REQ;
+
+                    if (use_cache && !status && name_len == abi->NameLength)
+                        add_cached_atom_info( atom, generation, abi );
+                }
+                if (status == STATUS_SUCCESS)
+                {
+                    if (name_len)
+                    {
+                        abi->NameLength = name_len;
+                        abi->Name[name_len / sizeof(WCHAR)] = '\0';
+                    }
+                    else
+                    {
+                        name_len = abi->NameLength;
+                        status = STATUS_BUFFER_TOO_SMALL;
                     }
-                    else name_len = 0;
                 }
-                SERVER_END_REQ;
             }
             TRACE( "%x -> %s (%u)\n", 
                    atom, debugstr_wn(abi->Name, abi->NameLength / sizeof(WCHAR)),
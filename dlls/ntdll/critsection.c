@@ -25,6 +25,7 @@
 #include <errno.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 #include <sys/types.h>
 #ifdef HAVE_SYS_SYSCALL_H
 #include <sys/syscall.h>
@@ -39,6 +40,7 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(ntdll);
 WINE_DECLARE_DEBUG_CHANNEL(relay);
+WINE_DECLARE_DEBUG_CHANNEL(csprof);
 
 static inline LONG interlocked_inc( PLONG dest )
 {
@@ -237,6 +239,191 @@ static inline NTSTATUS wait_semaphore( RTL_CRITICAL_SECTION *crit, int timeout )
     return ret;
 }
 
+/* Contention profiling, enabled with WINEDEBUG=+csprof
+ *
+ * Every acquisition is timestamped, and the statistics are kept in a fixed
+ * size hash table indexed by the section address. All the counters of a
+ * section are only updated while holding it, so they don't need interlocked
+ * operations. The report is printed at process exit, or whenever
+ * __wine_dump_critsection_profile() is called. */
+
+#define CS_PROFILE_SIZE 1024  /* must be a power of 2 */
+#define CS_PROFILE_TOP  20
+
+struct cs_profile
+{
+    RTL_CRITICAL_SECTION *crit;
+    char                  name[64];
+    unsigned int          enters;        /* number of acquisitions */
+    unsigned int          waits;         /* number of times we had to sleep */
+    unsigned int          spin_success;  /* acquired while spinning */
+    unsigned int          spin_failed;   /* had to sleep after spinning */
+    LONGLONG              wait_time;     /* total time spent waiting */
+    LONGLONG              max_wait;
+    LONGLONG              hold_time;     /* total time spent inside the section */
+    LONGLONG              max_hold;
+    LONGLONG              acquired;      /* time of the current acquisition */
+};
+
+static struct cs_profile cs_profiles[CS_PROFILE_SIZE];
+static int cs_profiling = -1;
+
+static inline BOOL profiling(void)
+{
+    if (cs_profiling == -1) cs_profiling = TRACE_ON(csprof);
+    return cs_profiling;
+}
+
+static inline LONGLONG monotonic_time(void)
+{
+    LARGE_INTEGER counter;
+    NtQueryPerformanceCounter( &counter, NULL );
+    return counter.QuadPart;
+}
+
+static struct cs_profile *get_profile( RTL_CRITICAL_SECTION *crit )
+{
+    unsigned int i, hash = ((ULONG_PTR)crit >> 3) & (CS_PROFILE_SIZE - 1);
+    RTL_CRITICAL_SECTION *prev;
+
+    for (i = 0; i < CS_PROFILE_SIZE; i++)
+    {
+        struct cs_profile *profile = &cs_profiles[(hash + i) & (CS_PROFILE_SIZE - 1)];
+
+        if (profile->crit == crit) return profile;
+        if (profile->crit) continue;
+        prev = interlocked_cmpxchg_ptr( (void **)&profile->crit, crit, NULL );
+        if (!prev || prev == crit) return profile;
+    }
+    return NULL;  /* table is full */
+}
+
+static void profile_acquired( RTL_CRITICAL_SECTION *crit, LONGLONG start, BOOL spun, BOOL waited )
+{
+    struct cs_profile *profile = get_profile( crit );
+    LONGLONG now = monotonic_time();
+
+    if (!profile) return;
+    if (!profile->name[0] && crit->DebugInfo && crit->DebugInfo->Spare[0])
+    {
+        const char *name = (const char *)crit->DebugInfo->Spare[0];
+        unsigned int len = min( strlen(name), sizeof(profile->name) - 1 );
+        memcpy( profile->name, name, len );
+    }
+
+    profile->enters++;
+    if (spun && !waited) profile->spin_success++;
+    if (spun && waited) profile->spin_failed++;
+    if (waited)
+    {
+        profile->waits++;
+        profile->wait_time += now - start;
+        if (now - start > profile->max_wait) profile->max_wait = now - start;
+    }
+    profile->acquired = now;
+}
+
+static void profile_released( RTL_CRITICAL_SECTION *crit )
+{
+    struct cs_profile *profile = get_profile( crit );
+    LONGLONG hold;
+
+    if (!profile || !profile->acquired) return;
+    hold = monotonic_time() - profile->acquired;
+    profile->hold_time += hold;
+    if (hold > profile->max_hold) profile->max_hold = hold;
+    profile->acquired = 0;
+}
+
+/* times are in 100ns units, print them in microseconds */
+static const char *debugstr_time( LONGLONG time )
+{
+    return wine_dbgstr_longlong( time / 10 );
+}
+
+/***********************************************************************
+ *           __wine_dump_critsection_profile   (NTDLL.@)
+ *
+ * Print the most contended critical sections, ranked by total wait time.
+ */
+void CDECL __wine_dump_critsection_profile(void)
+{
+    struct cs_profile *top[CS_PROFILE_TOP];
+    unsigned int i, j, count = 0;
+
+    if (!profiling()) return;
+
+    for (i = 0; i < CS_PROFILE_SIZE; i++)
+    {
+        struct cs_profile *profile = &cs_profiles[i];
+
+        if (!profile->crit || !profile->waits) continue;
+        for (j = count; j > 0 && top[j - 1]->wait_time < profile->wait_time; j--)
+            if (j < CS_PROFILE_TOP) top[j] = top[j - 1];
+        if (j < CS_PROFILE_TOP)
+        {
+            top[j] = profile;
+            if (count < CS_PROFILE_TOP) count++;
+        }
+    }
+
+    TRACE_(csprof)( "%u most contended critical sections (times in us):\n", count );
+    for (i = 0; i < count; i++)
+    {
+        struct cs_profile *profile = top[i];
+
+        TRACE_(csprof)( "%p %s: enters %u waits %u spin %u/%u wait %s max %s",
+                        profile->crit, debugstr_a(profile->name[0] ? profile->name : "?"),
+                        profile->enters, profile->waits, profile->spin_success,
+                        profile->spin_success + profile->spin_failed,
+                        debugstr_time( profile->wait_time ), debugstr_time( profile->max_wait ) );
+        TRACE_(csprof)( " hold %s max %s\n",
+                        debugstr_time( profile->hold_time ), debugstr_time( profile->max_hold ) );
+    }
+}
+
+/* Adaptive spinning
+ *
+ * The spin count given by the application is only used as an upper bound.
+ * The debug info keeps an estimate of how many iterations it takes for the
+ * owner to release the section (in Spare[1], Spare[0] being the name), and
+ * we spin for about twice that. When spinning fails, we look at how long we
+ * then had to sleep: if the owner released the section soon after we gave up
+ * we spin a bit longer next time, but if it took longer than the spin itself,
+ * the owner is most likely holding it for a long time or has been preempted,
+ * and spinning again would only burn cycles, so we spin less. */
+
+#define MIN_SPIN_COUNT 64
+
+static inline ULONG get_spin_limit( RTL_CRITICAL_SECTION *crit )
+{
+    ULONG limit = crit->SpinCount;
+
+    if (crit->DebugInfo) limit = min( limit, crit->DebugInfo->Spare[1] * 2 + MIN_SPIN_COUNT );
+    return limit;
+}
+
+static inline void spin_succeeded( RTL_CRITICAL_SECTION *crit, ULONG count )
+{
+    DWORD_PTR estimate;
+
+    if (!crit->DebugInfo) return;
+    estimate = crit->DebugInfo->Spare[1];
+    crit->DebugInfo->Spare[1] = estimate + ((LONG_PTR)count - (LONG_PTR)estimate) / 8;
+}
+
+static inline void spin_failed( RTL_CRITICAL_SECTION *crit, ULONG limit, LONGLONG spin_time, LONGLONG wait_time )
+{
+    DWORD_PTR estimate;
+
+    if (!crit->DebugInfo) return;
+    estimate = crit->DebugInfo->Spare[1];
+    if (wait_time <= spin_time)
+        crit->DebugInfo->Spare[1] = estimate + (limit - estimate + 7) / 8;
+    else
+        crit->DebugInfo->Spare[1] = estimate - (estimate + 7) / 8;
+}
+
 /***********************************************************************
  *           RtlInitializeCriticalSection   (NTDLL.@)
  *
@@ -308,7 +495,7 @@ NTSTATUS WINAPI RtlInitializeCriticalSectionAndSpinCount( RTL_CRITICAL_SECTION *
  */
 NTSTATUS WINAPI RtlInitializeCriticalSectionEx( RTL_CRITICAL_SECTION *crit, ULONG spincount, ULONG flags )
 {
-    if (flags & (RTL_CRITICAL_SECTION_FLAG_DYNAMIC_SPIN|RTL_CRITICAL_SECTION_FLAG_STATIC_INIT))
+    if (flags & RTL_CRITICAL_SECTION_FLAG_STATIC_INIT)
         FIXME("(%p,%u,0x%08x) semi-stub\n", crit, spincount, flags);
 
     /* FIXME: if RTL_CRITICAL_SECTION_FLAG_STATIC_INIT is given, we should use
@@ -535,17 +722,28 @@ NTSTATUS WINAPI RtlpUnWaitCriticalSection( RTL_CRITICAL_SECTION *crit )
  */
 NTSTATUS WINAPI RtlEnterCriticalSection( RTL_CRITICAL_SECTION *crit )
 {
+    BOOL spun = FALSE, waited = FALSE;
+    LONGLONG start = 0, spin_start = 0, spin_end;
+    ULONG limit = 0;
+
     if (crit->SpinCount)
     {
         ULONG count;
 
         if (RtlTryEnterCriticalSection( crit )) return STATUS_SUCCESS;
-        for (count = crit->SpinCount; count > 0; count--)
+        start = spin_start = monotonic_time();
+        spun = TRUE;
+        limit = get_spin_limit( crit );
+        for (count = 0; count < limit; count++)
         {
             if (crit->LockCount > 0) break;  /* more than one waiter, don't bother spinning */
             if (crit->LockCount == -1)       /* try again */
             {
-                if (interlocked_cmpxchg( &crit->LockCount, 0, -1 ) == -1) goto done;
+                if (interlocked_cmpxchg( &crit->LockCount, 0, -1 ) == -1)
+                {
+                    spin_succeeded( crit, count );
+                    goto done;
+                }
             }
             small_pause();
         }
@@ -560,11 +758,16 @@ NTSTATUS WINAPI RtlEnterCriticalSection( RTL_CRITICAL_SECTION *crit )
         }
 
         /* Now wait for it */
+        if (profiling() && !start) start = monotonic_time();
+        spin_end = spun ? monotonic_time() : 0;
         RtlpWaitForCriticalSection( crit );
+        waited = TRUE;
+        if (spun) spin_failed( crit, limit, spin_end - spin_start, monotonic_time() - spin_end );
     }
 done:
     crit->OwningThread   = ULongToHandle(GetCurrentThreadId());
     crit->RecursionCount = 1;
+    if (profiling()) profile_acquired( crit, start, spun, waited );
     return STATUS_SUCCESS;
 }
 
@@ -594,6 +797,7 @@ BOOL WINAPI RtlTryEnterCriticalSection( RTL_CRITICAL_SECTION *crit )
     {
         crit->OwningThread   = ULongToHandle(GetCurrentThreadId());
         crit->RecursionCount = 1;
+        if (profiling()) profile_acquired( crit, 0, FALSE, FALSE );
         ret = TRUE;
     }
     else if (crit->OwningThread == ULongToHandle(GetCurrentThreadId()))
@@ -669,6 +873,7 @@ NTSTATUS WINAPI RtlLeaveCriticalSection( RTL_CRITICAL_SECTION *crit )
     }
     else
     {
+        if (profiling()) profile_released( crit );
         crit->OwningThread = 0;
         if (interlocked_dec( &crit->LockCount ) >= 0)
         {
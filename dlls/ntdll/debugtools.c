@@ -22,13 +22,25 @@
 #include "wine/port.h"
 
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #ifdef HAVE_UNISTD_H
 # include <unistd.h>
 #endif
 #include <ctype.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+# include <sys/stat.h>
+#endif
 
 #include "wine/debug.h"
 #include "wine/exception.h"
@@ -69,6 +81,252 @@ static void release_temp_buffer( char *ptr, size_t size )
     info->str_pos = ptr + size;
 }
 
+/* asynchronous output, enabled with WINEDEBUGLOG=<file>
+ *
+ * Every thread appends its complete lines to its own ring buffer, and a
+ * background pthread drains all the rings into the log file, so that
+ * the threads never block on the output.  The file is rotated to
+ * <file>.old once it grows beyond WINEDEBUGLOGSIZE megabytes.
+ * A '-' file name sends the output to stderr.
+ */
+
+#define DEBUG_RING_SIZE 0x10000  /* must be a power of 2 */
+
+struct debug_ring
+{
+    struct debug_ring *next;      /* next ring in the writer list */
+    int                head;      /* write position, only updated by the owning thread */
+    int                tail;      /* read position, only updated by the writer */
+    int                detached;  /* owning thread has exited */
+    char               data[DEBUG_RING_SIZE];
+};
+
+#define DEBUG_RING_DETACHED ((struct debug_ring *)~(ULONG_PTR)0)
+
+static int debug_log_fd = -1;
+static char *debug_log_name;
+static ULONGLONG debug_log_size;
+static ULONGLONG debug_log_max_size;
+static struct debug_ring *debug_rings;
+static int debug_writer_started;
+static pthread_mutex_t debug_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t debug_cond = PTHREAD_COND_INITIALIZER;
+
+/* open the log file; called with the writer mutex held */
+static void open_log_file(void)
+{
+    struct stat st;
+
+    if ((debug_log_fd = open( debug_log_name, O_WRONLY | O_CREAT | O_APPEND, 0666 )) == -1)
+    {
+        fprintf( stderr, "wine: cannot open debug log %s, using stderr\n", debug_log_name );
+        debug_log_fd = 2;
+        debug_log_max_size = 0;
+    }
+    debug_log_size = fstat( debug_log_fd, &st ) ? 0 : st.st_size;
+}
+
+/* write out some data, rotating the log file if needed; called with the writer mutex held */
+static void write_log_data( const char *data, int len )
+{
+    int ret;
+
+    if (debug_log_max_size && debug_log_size + len > debug_log_max_size)
+    {
+        char *old_name = malloc( strlen(debug_log_name) + sizeof(".old") );
+
+        if (old_name)
+        {
+            strcpy( old_name, debug_log_name );
+            strcat( old_name, ".old" );
+            close( debug_log_fd );
+            rename( debug_log_name, old_name );
+            free( old_name );
+            open_log_file();
+        }
+    }
+    while (len > 0)
+    {
+        if ((ret = write( debug_log_fd, data, len )) < 0)
+        {
+            if (errno == EINTR) continue;
+            break;
+        }
+        data += ret;
+        len -= ret;
+        debug_log_size += ret;
+    }
+}
+
+/* write out the contents of all the rings; called with the writer mutex held */
+static void drain_debug_rings(void)
+{
+    struct debug_ring *ring, **prev = &debug_rings;
+
+    while ((ring = *prev))
+    {
+        int head = interlocked_xchg_add( &ring->head, 0 );
+        int tail = ring->tail;
+
+        while (tail != head)
+        {
+            int pos = tail & (DEBUG_RING_SIZE - 1);
+            int len = min( head - tail, DEBUG_RING_SIZE - pos );
+
+            write_log_data( ring->data + pos, len );
+            tail += len;
+        }
+        interlocked_xchg( &ring->tail, tail );
+
+        if (ring->detached && tail == interlocked_xchg_add( &ring->head, 0 ))
+        {
+            *prev = ring->next;
+            munmap( ring, sizeof(*ring) );
+        }
+        else prev = &ring->next;
+    }
+}
+
+static void *debug_writer_thread( void *arg )
+{
+    struct timespec timeout;
+    sigset_t set;
+
+    /* signals are handled by the Wine threads */
+    sigfillset( &set );
+    pthread_sigmask( SIG_BLOCK, &set, NULL );
+
+    pthread_mutex_lock( &debug_mutex );
+    for (;;)
+    {
+        drain_debug_rings();
+        clock_gettime( CLOCK_REALTIME, &timeout );
+        timeout.tv_nsec += 20000000;  /* 20 ms */
+        if (timeout.tv_nsec >= 1000000000)
+        {
+            timeout.tv_sec++;
+            timeout.tv_nsec -= 1000000000;
+        }
+        pthread_cond_timedwait( &debug_cond, &debug_mutex, &timeout );
+    }
+    return NULL;
+}
+
+/* flush all the pending output, at process exit */
+static void flush_debug_output(void)
+{
+    pthread_mutex_lock( &debug_mutex );
+    drain_debug_rings();
+    pthread_mutex_unlock( &debug_mutex );
+}
+
+/* create the ring of the current thread */
+static struct debug_ring *create_debug_ring(void)
+{
+    struct debug_ring *ring;
+    pthread_t thread;
+
+    ring = mmap( NULL, sizeof(*ring), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0 );
+    if (ring == MAP_FAILED) return DEBUG_RING_DETACHED;
+
+    pthread_mutex_lock( &debug_mutex );
+    if (!debug_writer_started)
+    {
+        if (!pthread_create( &thread, NULL, debug_writer_thread, NULL ))
+        {
+            pthread_detach( thread );
+            debug_writer_started = 1;
+        }
+    }
+    if (debug_writer_started)
+    {
+        ring->next = debug_rings;
+        debug_rings = ring;
+    }
+    pthread_mutex_unlock( &debug_mutex );
+
+    if (debug_writer_started) return ring;
+    munmap( ring, sizeof(*ring) );
+    return DEBUG_RING_DETACHED;
+}
+
+/* queue some output to the current thread ring */
+static void write_debug_output( const char *data, int len )
+{
+    struct ntdll_thread_data *thread_data = ntdll_get_thread_data();
+    struct debug_ring *ring = thread_data->debug_ring;
+    int pos, count;
+
+    if (debug_log_fd == -1)
+    {
+        write( 2, data, len );
+        return;
+    }
+    if (!ring) ring = thread_data->debug_ring = create_debug_ring();
+    if (ring == DEBUG_RING_DETACHED)
+    {
+        pthread_mutex_lock( &debug_mutex );
+        drain_debug_rings();  /* keep the previous output of the thread in order */
+        write_log_data( data, len );
+        pthread_mutex_unlock( &debug_mutex );
+        return;
+    }
+
+    /* wait for the writer if the ring is full */
+    while (ring->head - interlocked_xchg_add( &ring->tail, 0 ) > DEBUG_RING_SIZE - len)
+    {
+        pthread_cond_signal( &debug_cond );
+        sched_yield();
+    }
+
+    while (len)
+    {
+        pos = ring->head & (DEBUG_RING_SIZE - 1);
+        count = min( len, DEBUG_RING_SIZE - pos );
+        memcpy( ring->data + pos, data, count );
+        interlocked_xchg( &ring->head, ring->head + count );
+        data += count;
+        len -= count;
+    }
+    if (ring->head - ring->tail > DEBUG_RING_SIZE / 2) pthread_cond_signal( &debug_cond );
+}
+
+/***********************************************************************
+ *		debug_thread_detach
+ *
+ * Hand the ring of an exiting thread over to the writer.
+ */
+void debug_thread_detach(void)
+{
+    struct ntdll_thread_data *thread_data = ntdll_get_thread_data();
+    struct debug_ring *ring = thread_data->debug_ring;
+
+    thread_data->debug_ring = DEBUG_RING_DETACHED;
+    if (!ring || ring == DEBUG_RING_DETACHED) return;
+    interlocked_xchg( &ring->detached, 1 );
+    pthread_cond_signal( &debug_cond );
+}
+
+/* check whether the output should go through the writer thread */
+static void init_debug_output(void)
+{
+    const char *name = getenv( "WINEDEBUGLOG" );
+    const char *size = getenv( "WINEDEBUGLOGSIZE" );
+
+    if (!name || !name[0]) return;
+    if (!strcmp( name, "-" ))
+    {
+        debug_log_fd = 2;
+    }
+    else
+    {
+        if (!(debug_log_name = strdup( name ))) return;
+        if (size) debug_log_max_size = (ULONGLONG)atoi( size ) * 1024 * 1024;
+        open_log_file();
+    }
+    atexit( flush_debug_output );
+}
+
 /***********************************************************************
  *		NTDLL_dbgstr_an
  */
@@ -135,6 +393,7 @@ static int NTDLL_dbg_vprintf( const char *format, va_list args )
        fprintf( stderr, "wine_dbg_vprintf: debugstr buffer overflow (contents: '%s')\n",
                 info->output);
        info->out_pos = info->output;
+       if (debug_log_fd != -1) flush_debug_output();
        abort();
     }
 
@@ -144,7 +403,7 @@ static int NTDLL_dbg_vprintf( const char *format, va_list args )
     else
     {
         char *pos = info->output;
-        write( 2, pos, info->out_pos + end - pos );
+        write_debug_output( pos, info->out_pos + end - pos );
         /* move beginning of next line to start of buffer */
         memmove( pos, info->out_pos + end, ret - end );
         info->out_pos = pos + ret - end;
@@ -199,5 +458,6 @@ static const struct __wine_debug_functions funcs =
  */
 void debug_init(void)
 {
+    init_debug_output();
     __wine_dbg_set_functions( &funcs, &default_funcs, sizeof(funcs) );
 }
@@ -190,8 +190,27 @@ struct dir_data
     struct file_identity    id;      /* directory file identity */
     struct dir_data_names  *names;   /* directory file names */
     struct dir_data_buffer *buffer;  /* head of data buffers list */
+    struct dir_data        *snapshot;/* shared snapshot owning the names, if any */
+    unsigned int            ref;     /* reference count, for shared snapshots */
 };
 
+/* recent directory scans, shared between handles listing the same directory with the same mask */
+struct dir_snapshot
+{
+    struct dir_data        *data;    /* snapshot data, NULL if unused */
+    dev_t                   dev;     /* device and inode of the directory */
+    ino_t                   ino;
+    time_t                  mtime;   /* modification time of the directory when it was read */
+    BOOL                    has_mask;
+    UNICODE_STRING          mask;    /* mask used for the scan */
+};
+
+#define DIR_SNAPSHOT_MAX    8        /* number of shared snapshots */
+#define DIR_CACHE_MIN_AGE   2        /* directories modified more recently than this are not cached */
+
+static struct dir_snapshot dir_snapshots[DIR_SNAPSHOT_MAX];
+static unsigned int dir_snapshot_next;
+
 static const unsigned int dir_data_buffer_initial_size = 4096;
 static const unsigned int dir_data_cache_initial_size  = 256;
 static const unsigned int dir_data_names_initial_size  = 64;
@@ -374,6 +393,14 @@ static void free_dir_data( struct dir_data *data )
 
     if (!data) return;
 
+    if (data->snapshot)  /* names belong to the snapshot */
+    {
+        free_dir_data( data->snapshot );
+        RtlFreeHeap( GetProcessHeap(), 0, data );
+        return;
+    }
+    if (data->ref && --data->ref) return;
+
     for (buffer = data->buffer; buffer; buffer = next)
     {
         next = buffer->next;
@@ -1499,15 +1526,19 @@ static NTSTATUS get_dir_data_entry( struct dir_data *dir_data, void *info_ptr, I
     struct stat st;
     ULONG name_len, start, dir_size, attributes;
 
-    if (get_file_info( names->unix_name, &st, &attributes ) == -1)
+    /* names alone don't need the file attributes, unless we have to check for ignored files */
+    if (class != FileNamesInformation || ignored_files_count)
     {
-        TRACE( "file no longer exists %s\n", names->unix_name );
-        return STATUS_SUCCESS;
-    }
-    if (is_ignored_file( &st ))
-    {
-        TRACE( "ignoring file %s\n", names->unix_name );
-        return STATUS_SUCCESS;
+        if (get_file_info( names->unix_name, &st, &attributes ) == -1)
+        {
+            TRACE( "file no longer exists %s\n", names->unix_name );
+            return STATUS_SUCCESS;
+        }
+        if (is_ignored_file( &st ))
+        {
+            TRACE( "ignoring file %s\n", names->unix_name );
+            return STATUS_SUCCESS;
+        }
     }
     start = dir_info_align( io->Information );
     dir_size = dir_info_size( class, 0 );
@@ -1819,6 +1850,87 @@ static int name_compare( const void *a, const void *b )
 }
 
 
+static BOOL is_same_mask( const struct dir_snapshot *snapshot, const UNICODE_STRING *mask )
+{
+    if (!mask) return !snapshot->has_mask;
+    return snapshot->has_mask && snapshot->mask.Length == mask->Length &&
+           !memcmp( snapshot->mask.Buffer, mask->Buffer, mask->Length );
+}
+
+/* create a per-handle copy of a snapshot; dir_section must be held by caller */
+static struct dir_data *clone_dir_snapshot( struct dir_data *snapshot )
+{
+    struct dir_data *data;
+
+    if (!(data = RtlAllocateHeap( GetProcessHeap(), 0, sizeof(*data) ))) return NULL;
+    *data = *snapshot;
+    data->pos = 0;
+    data->ref = 0;
+    data->snapshot = snapshot;
+    snapshot->ref++;
+    return data;
+}
+
+/* find a recent scan of the same directory; dir_section must be held by caller */
+static struct dir_data *find_dir_snapshot( const struct stat *st, const UNICODE_STRING *mask )
+{
+    unsigned int i;
+
+    for (i = 0; i < DIR_SNAPSHOT_MAX; i++)
+    {
+        struct dir_snapshot *snapshot = &dir_snapshots[i];
+
+        if (!snapshot->data) continue;
+        if (snapshot->dev != st->st_dev || snapshot->ino != st->st_ino) continue;
+        if (snapshot->mtime != st->st_mtime)  /* directory has been modified */
+        {
+            free_dir_data( snapshot->data );
+            RtlFreeHeap( GetProcessHeap(), 0, snapshot->mask.Buffer );
+            memset( snapshot, 0, sizeof(*snapshot) );
+            continue;
+        }
+        if (is_same_mask( snapshot, mask )) return clone_dir_snapshot( snapshot->data );
+    }
+    return NULL;
+}
+
+/* share a new directory scan with the other handles; dir_section must be held by caller */
+static struct dir_data *add_dir_snapshot( struct dir_data *data, const struct stat *st,
+                                          const UNICODE_STRING *mask )
+{
+    struct dir_snapshot *snapshot = &dir_snapshots[dir_snapshot_next];
+    struct dir_data *clone;
+    WCHAR *mask_buffer = NULL;
+
+    /* a directory modified just now may be modified again without its mtime changing */
+    if (st->st_mtime + DIR_CACHE_MIN_AGE > time( NULL )) return data;
+
+    if (mask && !(mask_buffer = RtlAllocateHeap( GetProcessHeap(), 0, max( mask->Length, 1 ) ))) return data;
+    data->ref = 1;
+    if (!(clone = clone_dir_snapshot( data )))
+    {
+        data->ref = 0;
+        RtlFreeHeap( GetProcessHeap(), 0, mask_buffer );
+        return data;
+    }
+
+    if (snapshot->data)
+    {
+        free_dir_data( snapshot->data );
+        RtlFreeHeap( GetProcessHeap(), 0, snapshot->mask.Buffer );
+    }
+    snapshot->data = data;
+    snapshot->dev = st->st_dev;
+    snapshot->ino = st->st_ino;
+    snapshot->mtime = st->st_mtime;
+    snapshot->has_mask = (mask != NULL);
+    snapshot->mask.Buffer = mask_buffer;
+    snapshot->mask.Length = snapshot->mask.MaximumLength = mask ? mask->Length : 0;
+    if (mask) memcpy( mask_buffer, mask->Buffer, mask->Length );
+    dir_snapshot_next = (dir_snapshot_next + 1) % DIR_SNAPSHOT_MAX;
+    return clone;
+}
+
 /***********************************************************************
  *           init_cached_dir_data
  *
@@ -1830,6 +1942,14 @@ static NTSTATUS init_cached_dir_data( struct dir_data **data_ret, int fd, const
     struct stat st;
     NTSTATUS status;
     unsigned int i;
+    BOOL has_stat = !fstat( fd, &st );
+
+    if (has_stat && has_wildcard( mask ) && (data = find_dir_snapshot( &st, mask )))
+    {
+        TRACE( "mask %s reusing %u files\n", debugstr_us( mask ), data->count );
+        *data_ret = data;
+        return data->count ? STATUS_SUCCESS : STATUS_NO_SUCH_FILE;
+    }
 
     if (!(data = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*data) )))
         return STATUS_NO_MEMORY;
@@ -1855,7 +1975,7 @@ static NTSTATUS init_cached_dir_data( struct dir_data **data_ret, int fd, const
         if (data->count < data->size)
             RtlReAllocateHeap( GetProcessHeap(), HEAP_REALLOC_IN_PLACE_ONLY, data->names,
                                data->count * sizeof(*data->names) );
-        if (!fstat( fd, &st ))
+        if (has_stat)
         {
             data->id.dev = st.st_dev;
             data->id.ino = st.st_ino;
@@ -1866,6 +1986,8 @@ static NTSTATUS init_cached_dir_data( struct dir_data **data_ret, int fd, const
     for (i = 0; i < data->count; i++)
         TRACE( "%s %s\n", debugstr_w(data->names[i].long_name), debugstr_w(data->names[i].short_name) );
 
+    if (has_stat && has_wildcard( mask )) data = add_dir_snapshot( data, &st, mask );
+
     *data_ret = data;
     return data->count ? STATUS_SUCCESS : STATUS_NO_SUCH_FILE;
 }
@@ -2024,6 +2146,224 @@ NTSTATUS WINAPI NtQueryDirectoryFile( HANDLE handle, HANDLE event,
 }
 
 
+/* cache of the names of the directories we had to scan for a case-insensitive match */
+
+#define DIR_CACHE_MAX_DIRS  32       /* number of cached directories */
+
+struct dir_cache_name
+{
+    struct dir_cache_name *next;        /* next name in the long name hash bucket */
+    struct dir_cache_name *next_short;  /* next name in the short name hash bucket */
+    unsigned short         len;         /* length of the long name */
+    unsigned short         short_len;   /* length of the short name, 0 if the long name is 8.3 */
+    WCHAR                  short_name[12];
+    char                  *unix_name;   /* name of the directory entry */
+    WCHAR                  name[1];     /* Unicode name of the directory entry */
+};
+
+struct dir_cache
+{
+    struct list            entry;       /* entry in LRU list */
+    dev_t                  dev;         /* device and inode of the directory */
+    ino_t                  ino;
+    time_t                 mtime;       /* modification time when the names were read */
+    unsigned int           hash_size;
+    struct dir_cache_name **hash;       /* long names hash table */
+    struct dir_cache_name **short_hash; /* short names hash table */
+};
+
+static struct list dir_cache_list = LIST_INIT( dir_cache_list );
+static unsigned int dir_cache_count;
+
+static RTL_CRITICAL_SECTION dir_cache_section;
+static RTL_CRITICAL_SECTION_DEBUG dir_cache_critsect_debug =
+{
+    0, 0, &dir_cache_section,
+    { &dir_cache_critsect_debug.ProcessLocksList, &dir_cache_critsect_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": dir_cache_section") }
+};
+static RTL_CRITICAL_SECTION dir_cache_section = { &dir_cache_critsect_debug, -1, 0, 0, 0, 0 };
+
+static unsigned int hash_dir_cache_name( const WCHAR *name, int len )
+{
+    unsigned int hash = 0;
+    while (len--) hash = hash * 65599 + toupperW( *name++ );
+    return hash;
+}
+
+static void free_dir_cache( struct dir_cache *cache )
+{
+    unsigned int i;
+    struct dir_cache_name *name, *next;
+
+    for (i = 0; i < cache->hash_size; i++)
+    {
+        for (name = cache->hash[i]; name; name = next)
+        {
+            next = name->next;
+            RtlFreeHeap( GetProcessHeap(), 0, name );
+        }
+    }
+    RtlFreeHeap( GetProcessHeap(), 0, cache->hash );
+    RtlFreeHeap( GetProcessHeap(), 0, cache );
+}
+
+/* read all the names of a directory; unix_name is the directory name */
+static struct dir_cache *create_dir_cache( const char *unix_name, const struct stat *st )
+{
+    WCHAR buffer[MAX_DIR_ENTRY_LEN];
+    struct dir_cache *cache;
+    struct dir_cache_name *name, *names = NULL;
+    UNICODE_STRING str;
+    BOOLEAN spaces;
+    unsigned int hash, count = 0;
+    struct dirent *de;
+    DIR *dir;
+    int ret;
+
+    if (!(dir = opendir( unix_name ))) return NULL;
+
+    str.Buffer = buffer;
+    str.MaximumLength = sizeof(buffer);
+    while ((de = readdir( dir )))
+    {
+        ret = ntdll_umbstowcs( 0, de->d_name, strlen(de->d_name), buffer, MAX_DIR_ENTRY_LEN );
+        if (ret < 0) continue;
+        if (!(name = RtlAllocateHeap( GetProcessHeap(), 0, FIELD_OFFSET( struct dir_cache_name, name[ret] ) +
+                                      strlen(de->d_name) + 1 ))) break;
+        name->len = ret;
+        memcpy( name->name, buffer, ret * sizeof(WCHAR) );
+        name->unix_name = (char *)&name->name[ret];
+        strcpy( name->unix_name, de->d_name );
+
+        str.Length = ret * sizeof(WCHAR);
+        if (!RtlIsNameLegalDOS8Dot3( &str, NULL, &spaces ) || spaces)
+            name->short_len = hash_short_file_name( &str, name->short_name );
+        else
+            name->short_len = 0;
+
+        name->next = names;
+        names = name;
+        count++;
+    }
+    closedir( dir );
+    if (de) goto failed;  /* out of memory */
+
+    if (!(cache = RtlAllocateHeap( GetProcessHeap(), 0, sizeof(*cache) ))) goto failed;
+    cache->dev = st->st_dev;
+    cache->ino = st->st_ino;
+    cache->mtime = st->st_mtime;
+    cache->hash_size = max( 16, count | 1 );
+    if (!(cache->hash = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                         2 * cache->hash_size * sizeof(*cache->hash) )))
+    {
+        RtlFreeHeap( GetProcessHeap(), 0, cache );
+        goto failed;
+    }
+    cache->short_hash = cache->hash + cache->hash_size;
+
+    /* names were read in reverse order, so the first entry of the directory ends up first in the chain */
+    while ((name = names))
+    {
+        names = name->next;
+        hash = hash_dir_cache_name( name->name, name->len ) % cache->hash_size;
+        name->next = cache->hash[hash];
+        cache->hash[hash] = name;
+        name->next_short = NULL;
+        if (!name->short_len) continue;
+        hash = hash_dir_cache_name( name->short_name, name->short_len ) % cache->hash_size;
+        name->next_short = cache->short_hash[hash];
+        cache->short_hash[hash] = name;
+    }
+    return cache;
+
+failed:
+    while ((name = names))
+    {
+        names = name->next;
+        RtlFreeHeap( GetProcessHeap(), 0, name );
+    }
+    return NULL;
+}
+
+/* find the cached names of a directory, reading them if needed; called with dir_cache_section held */
+static struct dir_cache *get_dir_cache( const char *unix_name )
+{
+    struct dir_cache *cache;
+    struct stat st;
+
+    if (stat( unix_name, &st ) == -1) return NULL;
+
+    LIST_FOR_EACH_ENTRY( cache, &dir_cache_list, struct dir_cache, entry )
+    {
+        if (cache->dev != st.st_dev || cache->ino != st.st_ino) continue;
+        list_remove( &cache->entry );
+        if (cache->mtime == st.st_mtime)
+        {
+            list_add_head( &dir_cache_list, &cache->entry );
+            return cache;
+        }
+        /* directory has been modified */
+        free_dir_cache( cache );
+        dir_cache_count--;
+        break;
+    }
+
+    /* a directory modified just now may be modified again without its mtime changing */
+    if (st.st_mtime + DIR_CACHE_MIN_AGE > time( NULL )) return NULL;
+
+    if (!(cache = create_dir_cache( unix_name, &st ))) return NULL;
+    if (dir_cache_count >= DIR_CACHE_MAX_DIRS)
+    {
+        struct dir_cache *old = LIST_ENTRY( list_tail( &dir_cache_list ), struct dir_cache, entry );
+        list_remove( &old->entry );
+        free_dir_cache( old );
+        dir_cache_count--;
+    }
+    list_add_head( &dir_cache_list, &cache->entry );
+    dir_cache_count++;
+    return cache;
+}
+
+/* look up a name case-insensitively in the cached names of a directory */
+/* returns 1 if found, 0 if not found, -1 if the directory could not be cached */
+static int find_file_in_dir_cache( char *unix_name, int pos, const WCHAR *name, int length,
+                                   BOOLEAN is_name_8_dot_3 )
+{
+    struct dir_cache *cache;
+    struct dir_cache_name *entry;
+    unsigned int hash;
+    int ret = 0;
+
+    RtlEnterCriticalSection( &dir_cache_section );
+
+    if (!(cache = get_dir_cache( unix_name )))
+    {
+        RtlLeaveCriticalSection( &dir_cache_section );
+        return -1;
+    }
+
+    hash = hash_dir_cache_name( name, length ) % cache->hash_size;
+    for (entry = cache->hash[hash]; entry; entry = entry->next)
+        if (entry->len == length && !memicmpW( entry->name, name, length )) break;
+
+    if (!entry && is_name_8_dot_3)
+    {
+        for (entry = cache->short_hash[hash]; entry; entry = entry->next_short)
+            if (entry->short_len == length && !memicmpW( entry->short_name, name, length )) break;
+    }
+
+    if (entry)
+    {
+        unix_name[pos - 1] = '/';
+        strcpy( unix_name + pos, entry->unix_name );
+        ret = 1;
+    }
+    RtlLeaveCriticalSection( &dir_cache_section );
+    return ret;
+}
+
+
 /***********************************************************************
  *           find_file_in_dir
  *
@@ -2134,6 +2474,12 @@ static NTSTATUS find_file_in_dir( char *unix_name, int pos, const WCHAR *name, i
     }
 #endif /* VFAT_IOCTL_READDIR_BOTH */
 
+    switch (find_file_in_dir_cache( unix_name, pos, name, length, is_name_8_dot_3 ))
+    {
+    case 1: goto success;
+    case 0: goto not_found;
+    }
+
     if (!(dir = opendir( unix_name )))
     {
         if (errno == ENOENT) return STATUS_OBJECT_PATH_NOT_FOUND;
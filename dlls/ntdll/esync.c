@@ -23,6 +23,7 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <limits.h>
 #ifdef HAVE_POLL_H
 #include <poll.h>
 #endif
@@ -35,9 +36,16 @@
 #ifdef HAVE_SYS_EVENTFD_H
 # include <sys/eventfd.h>
 #endif
+#if defined(HAVE_SYS_EPOLL_H) && defined(HAVE_EPOLL_CREATE)
+# include <sys/epoll.h>
+#endif
 #ifdef HAVE_SYS_MMAN_H
 # include <sys/mman.h>
 #endif
+#ifdef HAVE_SYS_SYSCALL_H
+# include <sys/syscall.h>
+#endif
+#include <time.h>
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -74,6 +82,52 @@ int do_esync(void)
 #endif
 }
 
+/* WINEFSYNC makes single-object waits sleep on the shared object state with a
+ * futex instead of polling the eventfd. The eventfd stays the authoritative
+ * way to grab an object, so this can be mixed freely with the poll() path, but
+ * every process signaling the objects must have it set so they issue the
+ * futex wakeups. */
+int do_fsync(void)
+{
+#if defined(__linux__) && defined(__NR_futex)
+    static int do_fsync_cached = -1;
+
+    if (do_fsync_cached == -1)
+        do_fsync_cached = do_esync() && getenv("WINEFSYNC") != NULL;
+
+    return do_fsync_cached;
+#else
+    return 0;
+#endif
+}
+
+#if defined(__linux__) && defined(__NR_futex)
+
+/* the shm state is shared between processes, so we can't use private futexes */
+static inline int futex_wait( int *addr, int val, struct timespec *timeout )
+{
+    return syscall( __NR_futex, addr, 0 /* FUTEX_WAIT */, val, timeout, 0, 0 );
+}
+
+static inline void futex_wake( int *addr )
+{
+    if (do_fsync()) syscall( __NR_futex, addr, 1 /* FUTEX_WAKE */, INT_MAX, NULL, 0, 0 );
+}
+
+#else
+
+static inline int futex_wait( int *addr, int val, struct timespec *timeout )
+{
+    errno = ENOSYS;
+    return -1;
+}
+
+static inline void futex_wake( int *addr )
+{
+}
+
+#endif
+
 /* Entry point for drivers to set queue fd. */
 void __wine_esync_set_queue_fd( int fd )
 {
@@ -307,6 +361,8 @@ static NTSTATUS get_object( HANDLE handle, struct esync **obj )
     return ret;
 }
 
+static int fd_generation;  /* incremented every time we close an fd */
+
 NTSTATUS esync_close( HANDLE handle )
 {
     UINT_PTR entry, idx = handle_to_index( handle, &entry );
@@ -318,6 +374,8 @@ NTSTATUS esync_close( HANDLE handle )
         if (interlocked_xchg((int *)&esync_list[entry][idx].type, 0))
         {
             close( esync_list[entry][idx].fd );
+            /* the fd number may be reused, so the cached epoll sets are no longer valid */
+            interlocked_xchg_add( &fd_generation, 1 );
             return STATUS_SUCCESS;
         }
     }
@@ -496,6 +554,7 @@ NTSTATUS esync_release_semaphore( HANDLE handle, ULONG count, ULONG *prev )
 
     if (write( obj->fd, &count64, sizeof(count64) ) == -1)
         return FILE_GetNtStatus();
+    futex_wake( &semaphore->count );
 
     return STATUS_SUCCESS;
 }
@@ -641,6 +700,7 @@ NTSTATUS esync_set_event( HANDLE handle )
     {
         if (write( obj->fd, &value, sizeof(value) ) == -1)
             return FILE_GetNtStatus();
+        futex_wake( &event->signaled );
     }
 
     /* Release the spinlock. */
@@ -792,6 +852,7 @@ NTSTATUS esync_release_mutex( HANDLE *handle, LONG *prev )
 
         if (write( obj->fd, &value, sizeof(value) ) == -1)
             return FILE_GetNtStatus();
+        futex_wake( &mutex->count );
     }
 
     return STATUS_SUCCESS;
@@ -868,6 +929,147 @@ static int do_poll( struct pollfd *fds, nfds_t nfds, ULONGLONG *end )
     return ret;
 }
 
+#if defined(HAVE_SYS_EPOLL_H) && defined(HAVE_EPOLL_CREATE)
+
+/* Threads which repeatedly wait on the same large set of objects (like the
+ * threadpool wait threads) would make poll() check every fd on every wait.
+ * Instead, each thread keeps an epoll set matching its last wait, and only
+ * updates what changed. */
+
+#define EPOLL_MIN_FDS 8  /* poll() is fine for small waits */
+
+struct esync_epoll
+{
+    int epoll_fd;
+    int generation;                           /* fd_generation when the set was built */
+    DWORD count;
+    int fds[MAXIMUM_WAIT_OBJECTS + 2];
+};
+
+static BOOL update_epoll_set( struct esync_epoll *epoll, const struct pollfd *fds, nfds_t nfds )
+{
+    struct epoll_event event;
+    DWORD i, j;
+
+    if (epoll->generation != fd_generation)
+    {
+        /* some fd we registered may have been closed and reused, start over */
+        close( epoll->epoll_fd );
+        if ((epoll->epoll_fd = epoll_create( MAXIMUM_WAIT_OBJECTS + 2 )) == -1) return FALSE;
+        epoll->generation = fd_generation;
+        epoll->count = 0;
+    }
+    else if (epoll->count == nfds)
+    {
+        for (i = 0; i < nfds; i++) if (epoll->fds[i] != fds[i].fd) break;
+        if (i == nfds) return TRUE;
+    }
+
+    for (i = 0; i < epoll->count; i++)
+    {
+        for (j = 0; j < nfds; j++) if (fds[j].fd == epoll->fds[i]) break;
+        if (j == nfds && epoll->fds[i] != -1)
+            epoll_ctl( epoll->epoll_fd, EPOLL_CTL_DEL, epoll->fds[i], &event );
+    }
+
+    for (i = 0; i < nfds; i++)
+    {
+        for (j = 0; j < epoll->count; j++) if (epoll->fds[j] == fds[i].fd) break;
+        if (j == epoll->count && fds[i].fd != -1)
+        {
+            event.events = EPOLLIN;
+            event.data.fd = fds[i].fd;
+            if (epoll_ctl( epoll->epoll_fd, EPOLL_CTL_ADD, fds[i].fd, &event ) == -1 && errno != EEXIST)
+            {
+                epoll->count = 0;
+                epoll->generation = fd_generation - 1;  /* rebuild next time */
+                return FALSE;
+            }
+        }
+    }
+
+    for (i = 0; i < nfds; i++) epoll->fds[i] = fds[i].fd;
+    epoll->count = nfds;
+    return TRUE;
+}
+
+/* same as do_poll(), but using the thread's cached epoll set */
+static int do_epoll( struct pollfd *fds, nfds_t nfds, ULONGLONG *end )
+{
+    struct esync_epoll *epoll = ntdll_get_thread_data()->esync_epoll;
+    struct epoll_event events[MAXIMUM_WAIT_OBJECTS + 2];
+    int i, j, ret, timeout;
+
+    if (!epoll)
+    {
+        if (!(epoll = RtlAllocateHeap( GetProcessHeap(), 0, sizeof(*epoll) ))) return do_poll( fds, nfds, end );
+        if ((epoll->epoll_fd = epoll_create( MAXIMUM_WAIT_OBJECTS + 2 )) == -1)
+        {
+            RtlFreeHeap( GetProcessHeap(), 0, epoll );
+            return do_poll( fds, nfds, end );
+        }
+        epoll->generation = fd_generation;
+        epoll->count = 0;
+        ntdll_get_thread_data()->esync_epoll = epoll;
+    }
+
+    if (!update_epoll_set( epoll, fds, nfds )) return do_poll( fds, nfds, end );
+
+    do
+    {
+        if (end)
+        {
+            /* round up, we'd rather be late than return early */
+            LONGLONG timeleft = update_timeout( *end );
+            timeout = (timeleft + TICKSPERMSEC - 1) / TICKSPERMSEC;
+        }
+        else
+            timeout = -1;
+
+        ret = epoll_wait( epoll->epoll_fd, events, nfds, timeout );
+    } while (ret < 0 && errno == EINTR);
+
+    if (ret <= 0) return ret;
+
+    for (i = 0; i < nfds; i++) fds[i].revents = 0;
+    for (i = 0; i < ret; i++)
+    {
+        short revents = 0;
+
+        if (events[i].events & EPOLLIN) revents |= POLLIN;
+        if (events[i].events & EPOLLERR) revents |= POLLERR;
+        if (events[i].events & EPOLLHUP) revents |= POLLHUP;
+        for (j = 0; j < nfds; j++)
+            if (fds[j].fd == events[i].data.fd) fds[j].revents = revents;
+    }
+    return ret;
+}
+
+void esync_exit_thread(void)
+{
+    struct esync_epoll *epoll = ntdll_get_thread_data()->esync_epoll;
+
+    if (!epoll) return;
+    close( epoll->epoll_fd );
+    RtlFreeHeap( GetProcessHeap(), 0, epoll );
+    ntdll_get_thread_data()->esync_epoll = NULL;
+}
+
+#else
+
+#define EPOLL_MIN_FDS (MAXIMUM_WAIT_OBJECTS + 3)
+
+static int do_epoll( struct pollfd *fds, nfds_t nfds, ULONGLONG *end )
+{
+    return do_poll( fds, nfds, end );
+}
+
+void esync_exit_thread(void)
+{
+}
+
+#endif
+
 static void update_grabbed_object( struct esync *obj )
 {
     if (obj->type == ESYNC_MUTEX)
@@ -897,6 +1099,78 @@ static void update_grabbed_object( struct esync *obj )
     }
 }
 
+/* Return the shm word that changes when the object becomes signaled, or NULL
+ * if we can't wait on it with a futex. */
+static int *get_futex_addr( struct esync *obj )
+{
+    switch (obj->type)
+    {
+    case ESYNC_SEMAPHORE:
+        return &((struct semaphore *)obj->shm)->count;
+    case ESYNC_MUTEX:
+        return &((struct mutex *)obj->shm)->count;
+    case ESYNC_AUTO_EVENT:
+    case ESYNC_MANUAL_EVENT:
+        return &((struct event *)obj->shm)->signaled;
+    default:
+        return NULL;
+    }
+}
+
+static void wake_object( struct esync *obj )
+{
+    int *addr = get_futex_addr( obj );
+    if (addr) futex_wake( addr );
+}
+
+/* Wait on a single object by sleeping on its shm state. We still have to
+ * read() the eventfd to grab the object, so the state is only a hint; if
+ * someone else wins the race we go back to sleep on the value we saw, and the
+ * next release will wake us up. Returns STATUS_NOT_IMPLEMENTED if the caller
+ * should fall back to poll(). */
+static NTSTATUS fsync_wait_object( struct esync *obj, HANDLE handle, ULONGLONG *end )
+{
+    struct timespec tmo_p;
+    LONGLONG timeleft;
+    int64_t value;
+    int *addr, val;
+
+    if (!(addr = get_futex_addr( obj ))) return STATUS_NOT_IMPLEMENTED;
+
+    for (;;)
+    {
+        val = *addr;
+        if (obj->type == ESYNC_MUTEX ? !val : val)
+        {
+            if (obj->type == ESYNC_MANUAL_EVENT ||
+                read( obj->fd, &value, sizeof(value) ) == sizeof(value))
+            {
+                TRACE("Woken up by handle %p [0].\n", handle);
+                update_grabbed_object( obj );
+                return 0;
+            }
+        }
+
+        if (end)
+        {
+            if (!(timeleft = update_timeout( *end )))
+            {
+                TRACE("Wait timed out.\n");
+                return STATUS_TIMEOUT;
+            }
+            tmo_p.tv_sec = timeleft / (ULONGLONG)TICKSPERSEC;
+            tmo_p.tv_nsec = (timeleft % TICKSPERSEC) * 100;
+        }
+
+        if (futex_wait( addr, val, end ? &tmo_p : NULL ) == -1 &&
+            errno != EAGAIN && errno != EINTR && errno != ETIMEDOUT)
+        {
+            WARN("futex wait failed: %s\n", strerror(errno));
+            return STATUS_NOT_IMPLEMENTED;
+        }
+    }
+}
+
 /* A value of STATUS_NOT_IMPLEMENTED returned from this function means that we
  * need to delegate to server_select(). */
 NTSTATUS esync_wait_objects( DWORD count, const HANDLE *handles, BOOLEAN wait_any,
@@ -1100,6 +1374,11 @@ NTSTATUS esync_wait_objects( DWORD count, const HANDLE *handles, BOOLEAN wait_an
             fds[i].fd = obj ? obj->fd : -1;
             fds[i].events = POLLIN;
         }
+        if (count == 1 && !alertable && objs[0] && do_fsync())
+        {
+            ret = fsync_wait_object( objs[0], handles[0], timeout ? &end : NULL );
+            if (ret != STATUS_NOT_IMPLEMENTED) return ret;
+        }
         if (msgwait)
         {
             fds[i].fd = ntdll_get_thread_data()->esync_queue_fd;
@@ -1116,7 +1395,10 @@ NTSTATUS esync_wait_objects( DWORD count, const HANDLE *handles, BOOLEAN wait_an
 
         while (1)
         {
-            ret = do_poll( fds, pollcount, timeout ? &end : NULL );
+            if (pollcount >= EPOLL_MIN_FDS)
+                ret = do_epoll( fds, pollcount, timeout ? &end : NULL );
+            else
+                ret = do_poll( fds, pollcount, timeout ? &end : NULL );
             if (ret > 0)
             {
                 /* Find out which object triggered the wait. */
@@ -1295,6 +1577,7 @@ tryagain:
                             {
                                 if (write( obj->fd, &value, sizeof(value) ) == -1)
                                     return FILE_GetNtStatus();
+                                wake_object( obj );
                             }
 
                             goto tryagain;  /* break out of two loops and a switch */
@@ -19,8 +19,10 @@
  */
 
 extern int do_esync(void) DECLSPEC_HIDDEN;
+extern int do_fsync(void) DECLSPEC_HIDDEN;
 extern void esync_init(void) DECLSPEC_HIDDEN;
 extern NTSTATUS esync_close( HANDLE handle ) DECLSPEC_HIDDEN;
+extern void esync_exit_thread(void) DECLSPEC_HIDDEN;
 
 extern NTSTATUS esync_create_semaphore(HANDLE *handle, ACCESS_MASK access,
     const OBJECT_ATTRIBUTES *attr, LONG initial, LONG max) DECLSPEC_HIDDEN;
@@ -0,0 +1,364 @@
+/*
+ * Event Tracing for Windows providers
+ *
+ * Copyright 2018 Wine project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "config.h"
+#include "wine/port.h"
+
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+
+#include "ntstatus.h"
+#define WIN32_NO_STATUS
+#include "windef.h"
+#include "winternl.h"
+#include "wine/debug.h"
+#include "wine/list.h"
+#include "ntdll_misc.h"
+#include "wmistr.h"
+#include "evntrace.h"
+#include "evntprov.h"
+
+WINE_DEFAULT_DEBUG_CHANNEL(etw);
+
+/* event log, enabled with WINEETWLOG=<file prefix>
+ *
+ * Events of the enabled providers are recorded into a ring buffer mapped
+ * from <prefix>.<pid>; tools/decode-etw-log turns it into text. Slots are
+ * reserved with an interlocked increment, so writing an event doesn't take
+ * any lock. The providers are selected with
+ * WINEETWPROVIDERS=<guid>[:<level>[:<keyword mask>]],... or * for all of
+ * them, at the verbose level by default.
+ */
+
+#define ETW_LOG_MAGIC    0x57544557  /* "WETW" */
+#define ETW_LOG_VERSION  1
+#define ETW_LOG_RECORDS  65536       /* must be a power of 2 */
+#define ETW_LOG_RECORD_SIZE 512
+
+struct etw_log_header
+{
+    unsigned int   magic;        /* ETW_LOG_MAGIC */
+    unsigned int   version;      /* ETW_LOG_VERSION */
+    unsigned int   pid;          /* process id */
+    unsigned int   nb_records;   /* size of the ring buffer */
+    unsigned int   record_size;  /* size of a record */
+    int            count;        /* total number of records written, modulo 2^32 */
+    unsigned int   reserved[10];
+};
+
+struct etw_log_record
+{
+    ULONGLONG        timestamp;  /* 100ns units */
+    unsigned int     tid;        /* thread id */
+    unsigned int     nb_data;    /* number of event data items */
+    GUID             provider;
+    EVENT_DESCRIPTOR descriptor;
+    GUID             activity;
+    GUID             related;
+    unsigned int     data_size;  /* size of the event data, before truncation */
+    unsigned int     reserved;
+    /* items follow, each as a 32-bit size followed by the data, truncated to the record size */
+    unsigned char    data[ETW_LOG_RECORD_SIZE - 88];
+};
+
+C_ASSERT( sizeof(struct etw_log_header) == 64 );
+C_ASSERT( sizeof(struct etw_log_record) == ETW_LOG_RECORD_SIZE );
+
+#define ETW_LOG_SIZE (sizeof(struct etw_log_header) + ETW_LOG_RECORDS * sizeof(struct etw_log_record))
+
+struct etw_provider
+{
+    struct list     entry;
+    GUID            guid;
+    PENABLECALLBACK callback;
+    void           *context;
+    UCHAR           level;        /* enabled level, 0 if the provider is disabled */
+    ULONGLONG       any_keyword;  /* events must match one of these keywords */
+    ULONGLONG       all_keyword;  /* events must match all of these keywords */
+};
+
+static struct list providers = LIST_INIT( providers );
+static struct etw_log_header *etw_log;
+static const char *etw_config;
+static BOOL etw_init_done;
+
+static RTL_CRITICAL_SECTION etw_section;
+static RTL_CRITICAL_SECTION_DEBUG etw_section_debug =
+{
+    0, 0, &etw_section,
+    { &etw_section_debug.ProcessLocksList, &etw_section_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": etw_section") }
+};
+static RTL_CRITICAL_SECTION etw_section = { &etw_section_debug, -1, 0, 0, 0, 0 };
+
+/* map the event log; called with etw_section held */
+static void init_etw_log(void)
+{
+    const char *prefix = getenv( "WINEETWLOG" );
+    char *name;
+    void *ptr;
+    int fd;
+
+    etw_init_done = TRUE;
+    if (!prefix || !prefix[0]) return;
+    if (!(etw_config = getenv( "WINEETWPROVIDERS" )) || !etw_config[0])
+    {
+        WARN( "WINEETWLOG is set but no providers are enabled\n" );
+        etw_config = NULL;
+        return;
+    }
+
+    if (!(name = RtlAllocateHeap( GetProcessHeap(), 0, strlen(prefix) + 16 ))) return;
+    sprintf( name, "%s.%04x", prefix, GetCurrentProcessId() );
+    if ((fd = open( name, O_RDWR | O_CREAT | O_TRUNC, 0666 )) != -1)
+    {
+        if (!ftruncate( fd, ETW_LOG_SIZE ))
+        {
+            ptr = mmap( NULL, ETW_LOG_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+            if (ptr != MAP_FAILED) etw_log = ptr;
+        }
+        close( fd );
+    }
+    if (etw_log)
+    {
+        etw_log->magic       = ETW_LOG_MAGIC;
+        etw_log->version     = ETW_LOG_VERSION;
+        etw_log->pid         = GetCurrentProcessId();
+        etw_log->nb_records  = ETW_LOG_RECORDS;
+        etw_log->record_size = ETW_LOG_RECORD_SIZE;
+    }
+    else ERR( "failed to create event log %s\n", debugstr_a(name) );
+    RtlFreeHeap( GetProcessHeap(), 0, name );
+}
+
+/* parse a GUID in the registry format, without braces */
+static BOOL parse_guid( const char *str, GUID *guid )
+{
+    unsigned int data[11], i;
+
+    if (sscanf( str, "%8x-%4x-%4x-%2x%2x-%2x%2x%2x%2x%2x%2x", &data[0], &data[1], &data[2],
+                &data[3], &data[4], &data[5], &data[6], &data[7], &data[8], &data[9], &data[10] ) != 11)
+        return FALSE;
+    guid->Data1 = data[0];
+    guid->Data2 = data[1];
+    guid->Data3 = data[2];
+    for (i = 0; i < 8; i++) guid->Data4[i] = data[3 + i];
+    return TRUE;
+}
+
+/* look up the provider in WINEETWPROVIDERS; called with etw_section held */
+static void configure_provider( struct etw_provider *provider )
+{
+    const char *p = etw_config;
+    unsigned int level;
+    ULONGLONG keyword;
+    GUID guid;
+
+    while (p && *p)
+    {
+        if (*p == '{') p++;
+        if ((*p == '*' && (p[1] == ':' || p[1] == ',' || !p[1])) ||
+            (parse_guid( p, &guid ) && IsEqualGUID( &guid, &provider->guid )))
+        {
+            provider->level = TRACE_LEVEL_VERBOSE;
+            provider->any_keyword = provider->all_keyword = 0;
+
+            p += strcspn( p, ":," );
+            if (*p != ':') return;
+            level = strtoul( p + 1, (char **)&p, 0 );
+            if (level) provider->level = min( level, 255 );
+            if (*p != ':') return;
+            keyword = strtoull( p + 1, NULL, 16 );
+            provider->any_keyword = keyword;
+            return;
+        }
+        if ((p = strchr( p, ',' ))) p++;
+    }
+}
+
+static inline BOOL is_event_enabled( const struct etw_provider *provider, UCHAR level, ULONGLONG keyword )
+{
+    if (!provider->level) return FALSE;
+    if (level && level > provider->level) return FALSE;
+    if (!keyword || !provider->any_keyword) return TRUE;
+    return (keyword & provider->any_keyword) &&
+           (keyword & provider->all_keyword) == provider->all_keyword;
+}
+
+static void log_event( const struct etw_provider *provider, const EVENT_DESCRIPTOR *descriptor,
+                       const GUID *activity, const GUID *related, ULONG count,
+                       const EVENT_DATA_DESCRIPTOR *data )
+{
+    struct etw_log_record *rec;
+    LARGE_INTEGER now;
+    unsigned int i, index, pos = 0, size;
+
+    if (!etw_log) return;
+
+    index = interlocked_xchg_add( &etw_log->count, 1 );
+    rec = (struct etw_log_record *)(etw_log + 1) + (index & (ETW_LOG_RECORDS - 1));
+
+    NtQueryPerformanceCounter( &now, NULL );
+    rec->timestamp  = now.QuadPart;
+    rec->tid        = GetCurrentThreadId();
+    rec->nb_data    = count;
+    rec->provider   = provider->guid;
+    rec->descriptor = *descriptor;
+    if (activity) rec->activity = *activity;
+    else memset( &rec->activity, 0, sizeof(rec->activity) );
+    if (related) rec->related = *related;
+    else memset( &rec->related, 0, sizeof(rec->related) );
+    rec->data_size  = 0;
+
+    for (i = 0; i < count; i++)
+    {
+        rec->data_size += data[i].Size;
+        if (pos + sizeof(DWORD) > sizeof(rec->data)) continue;
+        memcpy( rec->data + pos, &data[i].Size, sizeof(DWORD) );
+        pos += sizeof(DWORD);
+        size = min( data[i].Size, sizeof(rec->data) - pos );
+        memcpy( rec->data + pos, (const void *)(ULONG_PTR)data[i].Ptr, size );
+        pos += size;
+    }
+}
+
+/******************************************************************************
+ *                  EtwEventRegister (NTDLL.@)
+ */
+ULONG WINAPI EtwEventRegister( LPCGUID guid, PENABLECALLBACK callback, PVOID context,
+                               PREGHANDLE handle )
+{
+    static const GUID session_guid;
+    struct etw_provider *provider;
+
+    TRACE( "(%s, %p, %p, %p)\n", debugstr_guid(guid), callback, context, handle );
+
+    if (!guid || !handle) return ERROR_INVALID_PARAMETER;
+    if (!(provider = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*provider) )))
+        return ERROR_NOT_ENOUGH_MEMORY;
+
+    provider->guid     = *guid;
+    provider->callback = callback;
+    provider->context  = context;
+
+    RtlEnterCriticalSection( &etw_section );
+    if (!etw_init_done) init_etw_log();
+    if (etw_log) configure_provider( provider );
+    list_add_tail( &providers, &provider->entry );
+    RtlLeaveCriticalSection( &etw_section );
+
+    if (provider->level)
+    {
+        TRACE( "enabling %s at level %u\n", debugstr_guid(guid), provider->level );
+        if (callback)
+            callback( &session_guid, EVENT_CONTROL_CODE_ENABLE_PROVIDER, provider->level,
+                      provider->any_keyword, provider->all_keyword, NULL, context );
+    }
+
+    *handle = (ULONG_PTR)provider;
+    return ERROR_SUCCESS;
+}
+
+/******************************************************************************
+ *                  EtwEventUnregister (NTDLL.@)
+ */
+ULONG WINAPI EtwEventUnregister( REGHANDLE handle )
+{
+    struct etw_provider *provider = (struct etw_provider *)(ULONG_PTR)handle;
+
+    TRACE( "(%s)\n", wine_dbgstr_longlong(handle) );
+
+    if (!provider) return ERROR_INVALID_HANDLE;
+
+    RtlEnterCriticalSection( &etw_section );
+    list_remove( &provider->entry );
+    RtlLeaveCriticalSection( &etw_section );
+
+    RtlFreeHeap( GetProcessHeap(), 0, provider );
+    return ERROR_SUCCESS;
+}
+
+/*********************************************************************
+ *                  EtwEventSetInformation   (NTDLL.@)
+ */
+ULONG WINAPI EtwEventSetInformation( REGHANDLE handle, EVENT_INFO_CLASS class, void *info,
+                                     ULONG length )
+{
+    FIXME("(%s, %u, %p, %u) stub\n", wine_dbgstr_longlong(handle), class, info, length);
+    return ERROR_SUCCESS;
+}
+
+/******************************************************************************
+ *                  EtwEventEnabled (NTDLL.@)
+ */
+BOOLEAN WINAPI EtwEventEnabled( REGHANDLE handle, const EVENT_DESCRIPTOR *descriptor )
+{
+    const struct etw_provider *provider = (const struct etw_provider *)(ULONG_PTR)handle;
+
+    if (!provider || !descriptor) return FALSE;
+    return is_event_enabled( provider, descriptor->Level, descriptor->Keyword );
+}
+
+/******************************************************************************
+ *                  EtwEventProviderEnabled (NTDLL.@)
+ */
+BOOLEAN WINAPI EtwEventProviderEnabled( REGHANDLE handle, UCHAR level, ULONGLONG keyword )
+{
+    const struct etw_provider *provider = (const struct etw_provider *)(ULONG_PTR)handle;
+
+    if (!provider) return FALSE;
+    return is_event_enabled( provider, level, keyword );
+}
+
+/******************************************************************************
+ *                  EtwEventWriteTransfer (NTDLL.@)
+ */
+ULONG WINAPI EtwEventWriteTransfer( REGHANDLE handle, const EVENT_DESCRIPTOR *descriptor,
+                                    const GUID *activity, const GUID *related, ULONG count,
+                                    EVENT_DATA_DESCRIPTOR *data )
+{
+    const struct etw_provider *provider = (const struct etw_provider *)(ULONG_PTR)handle;
+
+    if (!provider) return ERROR_INVALID_HANDLE;
+    if (!descriptor || (count && !data)) return ERROR_INVALID_PARAMETER;
+    if (count > MAX_EVENT_DATA_DESCRIPTORS) return ERROR_ARITHMETIC_OVERFLOW;
+
+    if (is_event_enabled( provider, descriptor->Level, descriptor->Keyword ))
+        log_event( provider, descriptor, activity, related, count, data );
+    return ERROR_SUCCESS;
+}
+
+/******************************************************************************
+ *                  EtwEventWrite (NTDLL.@)
+ */
+ULONG WINAPI EtwEventWrite( REGHANDLE handle, const EVENT_DESCRIPTOR *descriptor, ULONG count,
+                            EVENT_DATA_DESCRIPTOR *data )
+{
+    return EtwEventWriteTransfer( handle, descriptor, NULL, NULL, count, data );
+}
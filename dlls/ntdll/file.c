@@ -24,6 +24,7 @@
 #include <stdio.h>
 #include <errno.h>
 #include <assert.h>
+#include <fcntl.h>
 #ifdef HAVE_UNISTD_H
 # include <unistd.h>
 #endif
@@ -57,6 +58,12 @@
 #ifdef HAVE_SYS_SOCKET_H
 #include <sys/socket.h>
 #endif
+#ifdef HAVE_SYS_INOTIFY_H
+#include <sys/inotify.h>
+#endif
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
 #ifdef MAJOR_IN_MKDEV
 # include <sys/mkdev.h>
 #elif defined(MAJOR_IN_SYSMACROS)
@@ -255,7 +262,12 @@ static NTSTATUS FILE_CreateFile( PHANDLE handle, ACCESS_MASK access, POBJECT_ATT
 
     if (io->u.Status == STATUS_SUCCESS)
     {
-        if (created) io->Information = FILE_CREATED;
+        if (created)
+        {
+            io->Information = FILE_CREATED;
+            /* the dll search cache may hold a failed lookup for this file */
+            interlocked_xchg_add( &dll_search_serial, 1 );
+        }
         else switch(disposition)
         {
         case FILE_SUPERSEDE:
@@ -580,7 +592,8 @@ static NTSTATUS server_read_file( HANDLE handle, HANDLE event, PIO_APC_ROUTINE a
         status = virtual_locked_server_call( req );
         wait_handle = wine_server_ptr_handle( reply->wait );
         options     = reply->options;
-        if (wait_handle && status != STATUS_PENDING)
+        /* a successful synchronous call may have been completed without a wait handle */
+        if (wait_handle ? status != STATUS_PENDING : status == STATUS_SUCCESS)
         {
             io->u.Status    = status;
             io->Information = wine_server_reply_size( reply );
@@ -624,7 +637,8 @@ static NTSTATUS server_write_file( HANDLE handle, HANDLE event, PIO_APC_ROUTINE
         status = wine_server_call( req );
         wait_handle = wine_server_ptr_handle( reply->wait );
         options     = reply->options;
-        if (wait_handle && status != STATUS_PENDING)
+        /* a successful synchronous call may have been completed without a wait handle */
+        if (wait_handle ? status != STATUS_PENDING : status == STATUS_SUCCESS)
         {
             io->u.Status    = status;
             io->Information = reply->size;
@@ -804,6 +818,22 @@ static NTSTATUS register_async_file_read( HANDLE handle, HANDLE event,
 }
 
 
+/* direct I/O may need a stricter alignment than the one the app follows, retry without it */
+static BOOL clear_direct_io( int fd, ULONG options )
+{
+#ifdef O_DIRECT
+    int flags;
+
+    if (errno != EINVAL || !(options & FILE_NO_INTERMEDIATE_BUFFERING)) return FALSE;
+    if ((flags = fcntl( fd, F_GETFL )) == -1 || !(flags & O_DIRECT)) return FALSE;
+    WARN( "unaligned access, disabling direct I/O on fd %d\n", fd );
+    return !fcntl( fd, F_SETFL, flags & ~O_DIRECT );
+#else
+    return FALSE;
+#endif
+}
+
+
 /******************************************************************************
  *  NtReadFile					[NTDLL.@]
  *  ZwReadFile					[NTDLL.@]
@@ -866,10 +896,15 @@ NTSTATUS WINAPI NtReadFile(HANDLE hFile, HANDLE hEvent,
 
         if (offset && offset->QuadPart != FILE_USE_FILE_POINTER_POSITION)
         {
+            if (async_read && !apc &&
+                (status = iouring_read( unix_handle, hFile, hEvent, io_status, buffer, length,
+                                        offset->QuadPart, cvalue )) != STATUS_NOT_SUPPORTED)
+                goto err;
+
             /* async I/O doesn't make sense on regular files */
             while ((result = virtual_locked_pread( unix_handle, buffer, length, offset->QuadPart )) == -1)
             {
-                if (errno != EINTR)
+                if (errno != EINTR && !clear_direct_io( unix_handle, options ))
                 {
                     status = FILE_GetNtStatus();
                     goto done;
@@ -943,6 +978,7 @@ NTSTATUS WINAPI NtReadFile(HANDLE hFile, HANDLE hEvent,
         else if (errno != EAGAIN)
         {
             if (errno == EINTR) continue;
+            if (type == FD_TYPE_FILE && clear_direct_io( unix_handle, options )) continue;
             if (!total) status = FILE_GetNtStatus();
             goto err;
         }
@@ -1016,12 +1052,51 @@ err:
         if (status != STATUS_PENDING && hEvent) NtResetEvent( hEvent, NULL );
     }
 
-    if (send_completion) NTDLL_AddCompletion( hFile, cvalue, status, total );
+    if (send_completion) NTDLL_AddCompletion( hFile, cvalue, status, total, status == STATUS_PENDING );
 
     return status;
 }
 
 
+#define MAX_SEGMENT_IOVECS 256
+
+/* build the iovecs for the page-sized segments of a scatter/gather request, starting at pos */
+static int get_segment_iovecs( struct iovec *iov, int max, const FILE_SEGMENT_ELEMENT *segments,
+                               ULONG pos, ULONG length )
+{
+    ULONG offset = pos % page_size;
+    int count;
+
+    segments += pos / page_size;
+    for (count = 0; count < max && pos < length; count++, segments++)
+    {
+        iov[count].iov_base = (char *)segments->Buffer + offset;
+        iov[count].iov_len  = min( length - pos, page_size - offset );
+        pos += iov[count].iov_len;
+        offset = 0;
+    }
+    return count;
+}
+
+static ssize_t segments_pread( int fd, const struct iovec *iov, int count, off_t offset )
+{
+#ifdef HAVE_PREADV
+    return preadv( fd, iov, count, offset );
+#else
+    return pread( fd, iov[0].iov_base, iov[0].iov_len, offset );
+#endif
+}
+
+static ssize_t segments_pwrite( int fd, const struct iovec *iov, int count, off_t offset )
+{
+#ifdef HAVE_PWRITEV
+    return pwritev( fd, iov, count, offset );
+#else
+    return pwrite( fd, iov[0].iov_base, iov[0].iov_len, offset );
+#endif
+}
+
+
 /******************************************************************************
  *  NtReadFileScatter   [NTDLL.@]
  *  ZwReadFileScatter   [NTDLL.@]
@@ -1033,10 +1108,11 @@ NTSTATUS WINAPI NtReadFileScatter( HANDLE file, HANDLE event, PIO_APC_ROUTINE ap
     int result, unix_handle, needs_close;
     unsigned int options;
     NTSTATUS status;
-    ULONG pos = 0, total = 0;
+    ULONG total = 0;
     enum server_fd_type type;
     ULONG_PTR cvalue = apc ? 0 : (ULONG_PTR)apc_user;
     BOOL send_completion = FALSE;
+    struct iovec iov[MAX_SEGMENT_IOVECS];
 
     TRACE( "(%p,%p,%p,%p,%p,%p,0x%08x,%p,%p),partial stub!\n",
            file, event, apc, apc_user, io_status, segments, length, offset, key);
@@ -1055,28 +1131,31 @@ NTSTATUS WINAPI NtReadFileScatter( HANDLE file, HANDLE event, PIO_APC_ROUTINE ap
         goto error;
     }
 
-    while (length)
+    if (offset && offset->QuadPart != FILE_USE_FILE_POINTER_POSITION && !apc &&
+        (status = iouring_read_scatter( unix_handle, file, event, io_status, segments, length,
+                                        offset->QuadPart, cvalue )) != STATUS_NOT_SUPPORTED)
     {
+        if (needs_close) close( unix_handle );
+        return status;
+    }
+
+    while (total < length)
+    {
+        int count = get_segment_iovecs( iov, MAX_SEGMENT_IOVECS, segments, total, length );
+
         if (offset && offset->QuadPart != FILE_USE_FILE_POINTER_POSITION)
-            result = pread( unix_handle, (char *)segments->Buffer + pos,
-                            min( length - pos, page_size - pos ), offset->QuadPart + total );
+            result = segments_pread( unix_handle, iov, count, offset->QuadPart + total );
         else
-            result = read( unix_handle, (char *)segments->Buffer + pos, min( length - pos, page_size - pos ) );
+            result = readv( unix_handle, iov, count );
 
         if (result == -1)
         {
-            if (errno == EINTR) continue;
+            if (errno == EINTR || clear_direct_io( unix_handle, options )) continue;
             status = FILE_GetNtStatus();
             break;
         }
         if (!result) break;
         total += result;
-        length -= result;
-        if ((pos += result) == page_size)
-        {
-            pos = 0;
-            segments++;
-        }
     }
 
     if (total == 0) status = STATUS_END_OF_FILE;
@@ -1091,7 +1170,7 @@ NTSTATUS WINAPI NtReadFileScatter( HANDLE file, HANDLE event, PIO_APC_ROUTINE ap
     if (event) NtSetEvent( event, NULL );
     if (apc) NtQueueApcThread( GetCurrentThread(), (PNTAPCFUNC)apc,
                                (ULONG_PTR)apc_user, (ULONG_PTR)io_status, 0 );
-    if (send_completion) NTDLL_AddCompletion( file, cvalue, status, total );
+    if (send_completion) NTDLL_AddCompletion( file, cvalue, status, total, TRUE );
 
     return STATUS_PENDING;
 
@@ -1269,10 +1348,15 @@ NTSTATUS WINAPI NtWriteFile(HANDLE hFile, HANDLE hEvent,
                 goto done;
             }
 
+            if (async_write && !apc &&
+                (status = iouring_write( unix_handle, hFile, hEvent, io_status, buffer, length,
+                                         off, cvalue )) != STATUS_NOT_SUPPORTED)
+                goto err;
+
             /* async I/O doesn't make sense on regular files */
             while ((result = pwrite( unix_handle, buffer, length, off )) == -1)
             {
-                if (errno != EINTR)
+                if (errno != EINTR && !clear_direct_io( unix_handle, options ))
                 {
                     if (errno == EFAULT) status = STATUS_INVALID_USER_BUFFER;
                     else status = FILE_GetNtStatus();
@@ -1320,6 +1404,7 @@ NTSTATUS WINAPI NtWriteFile(HANDLE hFile, HANDLE hEvent,
         else if (errno != EAGAIN)
         {
             if (errno == EINTR) continue;
+            if (type == FD_TYPE_FILE && clear_direct_io( unix_handle, options )) continue;
             if (!total)
             {
                 if (errno == EFAULT) status = STATUS_INVALID_USER_BUFFER;
@@ -1410,7 +1495,7 @@ err:
         if (status != STATUS_PENDING && hEvent) NtResetEvent( hEvent, NULL );
     }
 
-    if (send_completion) NTDLL_AddCompletion( hFile, cvalue, status, total );
+    if (send_completion) NTDLL_AddCompletion( hFile, cvalue, status, total, status == STATUS_PENDING );
 
     return status;
 }
@@ -1427,10 +1512,11 @@ NTSTATUS WINAPI NtWriteFileGather( HANDLE file, HANDLE event, PIO_APC_ROUTINE ap
     int result, unix_handle, needs_close;
     unsigned int options;
     NTSTATUS status;
-    ULONG pos = 0, total = 0;
+    ULONG total = 0;
     enum server_fd_type type;
     ULONG_PTR cvalue = apc ? 0 : (ULONG_PTR)apc_user;
     BOOL send_completion = FALSE;
+    struct iovec iov[MAX_SEGMENT_IOVECS];
 
     TRACE( "(%p,%p,%p,%p,%p,%p,0x%08x,%p,%p),partial stub!\n",
            file, event, apc, apc_user, io_status, segments, length, offset, key);
@@ -1450,17 +1536,26 @@ NTSTATUS WINAPI NtWriteFileGather( HANDLE file, HANDLE event, PIO_APC_ROUTINE ap
         goto error;
     }
 
-    while (length)
+    if (offset && offset->QuadPart != FILE_USE_FILE_POINTER_POSITION && !apc &&
+        (status = iouring_write_gather( unix_handle, file, event, io_status, segments, length,
+                                        offset->QuadPart, cvalue )) != STATUS_NOT_SUPPORTED)
     {
+        if (needs_close) close( unix_handle );
+        return status;
+    }
+
+    while (total < length)
+    {
+        int count = get_segment_iovecs( iov, MAX_SEGMENT_IOVECS, segments, total, length );
+
         if (offset && offset->QuadPart != FILE_USE_FILE_POINTER_POSITION)
-            result = pwrite( unix_handle, (char *)segments->Buffer + pos,
-                             page_size - pos, offset->QuadPart + total );
+            result = segments_pwrite( unix_handle, iov, count, offset->QuadPart + total );
         else
-            result = write( unix_handle, (char *)segments->Buffer + pos, page_size - pos );
+            result = writev( unix_handle, iov, count );
 
         if (result == -1)
         {
-            if (errno == EINTR) continue;
+            if (errno == EINTR || clear_direct_io( unix_handle, options )) continue;
             if (errno == EFAULT)
             {
                 status = STATUS_INVALID_USER_BUFFER;
@@ -1475,12 +1570,6 @@ NTSTATUS WINAPI NtWriteFileGather( HANDLE file, HANDLE event, PIO_APC_ROUTINE ap
             break;
         }
         total += result;
-        length -= result;
-        if ((pos += result) == page_size)
-        {
-            pos = 0;
-            segments++;
-        }
     }
 
     send_completion = cvalue != 0;
@@ -1502,7 +1591,7 @@ NTSTATUS WINAPI NtWriteFileGather( HANDLE file, HANDLE event, PIO_APC_ROUTINE ap
         if (status != STATUS_PENDING && event) NtResetEvent( event, NULL );
     }
 
-    if (send_completion) NTDLL_AddCompletion( file, cvalue, status, total );
+    if (send_completion) NTDLL_AddCompletion( file, cvalue, status, total, status == STATUS_PENDING );
 
     return status;
 }
@@ -1537,7 +1626,8 @@ static NTSTATUS server_ioctl_file( HANDLE handle, HANDLE event,
         status = virtual_locked_server_call( req );
         wait_handle = wine_server_ptr_handle( reply->wait );
         options     = reply->options;
-        if (wait_handle && status != STATUS_PENDING)
+        /* a successful synchronous call may have been completed without a wait handle */
+        if (wait_handle ? status != STATUS_PENDING : status == STATUS_SUCCESS)
         {
             io->u.Status    = status;
             io->Information = wine_server_reply_size( reply );
@@ -2277,7 +2367,7 @@ NTSTATUS WINAPI NtQueryInformationFile( HANDLE hFile, PIO_STATUS_BLOCK io,
         0,                                             /* FileIdFullDirectoryInformation */
         0,                                             /* FileValidDataLengthInformation */
         0,                                             /* FileShortNameInformation */
-        0,                                             /* FileIoCompletionNotificationInformation, */
+        sizeof(FILE_IO_COMPLETION_NOTIFICATION_INFORMATION), /* FileIoCompletionNotificationInformation */
         0,                                             /* FileIoStatusBlockRangeInformation */
         0,                                             /* FileIoPriorityHintInformation */
         0,                                             /* FileSfioReserveInformation */
@@ -2359,6 +2449,14 @@ NTSTATUS WINAPI NtQueryInformationFile( HANDLE hFile, PIO_STATUS_BLOCK io,
             else info->CurrentByteOffset.QuadPart = res;
         }
         break;
+    case FileIoCompletionNotificationInformation:
+        {
+            FILE_IO_COMPLETION_NOTIFICATION_INFORMATION *info = ptr;
+            unsigned int flags;
+
+            if (!(io->u.Status = server_set_completion_mode( hFile, 0, &flags ))) info->Flags = flags;
+        }
+        break;
     case FileInternalInformation:
         if (fd_get_file_info( fd, &st, &attr ) == -1) io->u.Status = FILE_GetNtStatus();
         else fill_file_info( &st, attr, ptr, class );
@@ -2742,6 +2840,18 @@ NTSTATUS WINAPI NtSetInformationFile(HANDLE handle, PIO_STATUS_BLOCK io,
         io->u.Status = STATUS_INVALID_INFO_CLASS;
         break;
 
+    case FileIoCompletionNotificationInformation:
+        if (len >= sizeof(FILE_IO_COMPLETION_NOTIFICATION_INFORMATION))
+        {
+            FILE_IO_COMPLETION_NOTIFICATION_INFORMATION *info = ptr;
+            unsigned int flags;
+
+            io->u.Status = server_set_completion_mode( handle, info->Flags, &flags );
+        }
+        else
+            io->u.Status = STATUS_INFO_LENGTH_MISMATCH;
+        break;
+
     case FileValidDataLengthInformation:
         if (len >= sizeof(FILE_VALID_DATA_LENGTH_INFORMATION))
         {
@@ -2825,6 +2935,7 @@ NTSTATUS WINAPI NtSetInformationFile(HANDLE handle, PIO_STATUS_BLOCK io,
                 io->u.Status = wine_server_call( req );
             }
             SERVER_END_REQ;
+            if (!io->u.Status) interlocked_xchg_add( &dll_search_serial, 1 );
 
             RtlFreeAnsiString( &unix_name );
         }
@@ -2868,6 +2979,7 @@ NTSTATUS WINAPI NtSetInformationFile(HANDLE handle, PIO_STATUS_BLOCK io,
                 io->u.Status  = wine_server_call( req );
             }
             SERVER_END_REQ;
+            if (!io->u.Status) interlocked_xchg_add( &dll_search_serial, 1 );
 
             RtlFreeAnsiString( &unix_name );
         }
@@ -2884,45 +2996,258 @@ NTSTATUS WINAPI NtSetInformationFile(HANDLE handle, PIO_STATUS_BLOCK io,
 }
 
 
+#ifdef HAVE_SYS_INOTIFY_H
+
+/* Cache of the NtQuery(Full)AttributesFile results, enabled by setting
+ * WINEATTRCACHE to the lifetime of an entry in milliseconds.  The parent
+ * directory of every cached file is watched with inotify, so changes made
+ * by any process, including our own writes (the event is queued before
+ * the syscall returns), invalidate the entry before the next lookup.  The
+ * lifetime only bounds what isn't reported that way, like renames of
+ * further parent directories or changes through other hard links. */
+
+#define ATTR_CACHE_SIZE 256  /* must be a power of 2 */
+
+struct attr_cache_entry
+{
+    WCHAR      *name;        /* NT name, NULL if the entry is free */
+    USHORT      len;         /* name length in bytes */
+    BOOLEAN     check_case;  /* whether the lookup was case sensitive */
+    int         wd;          /* inotify watch of the parent directory */
+    ULONG       time;        /* tick count when the entry was filled */
+    ULONG       attributes;
+    struct stat st;
+};
+
+static struct attr_cache_entry *attr_cache;
+static int attr_cache_fd = -1;
+static ULONG attr_cache_ttl;
+static unsigned int attr_cache_serial;  /* incremented for every change event */
+
+static RTL_CRITICAL_SECTION attr_cache_section;
+static RTL_CRITICAL_SECTION_DEBUG attr_cache_critsect_debug =
+{
+    0, 0, &attr_cache_section,
+    { &attr_cache_critsect_debug.ProcessLocksList, &attr_cache_critsect_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": attr_cache_section") }
+};
+static RTL_CRITICAL_SECTION attr_cache_section = { &attr_cache_critsect_debug, -1, 0, 0, 0, 0 };
+
+/* check if the cache is enabled, and create it the first time */
+static BOOL init_attr_cache(void)
+{
+    static int enabled = -1;
+    const char *env;
+    int fd;
+
+    if (enabled != -1) return enabled;
+
+    RtlEnterCriticalSection( &attr_cache_section );
+    if (enabled == -1)
+    {
+        enabled = FALSE;
+        if ((env = getenv( "WINEATTRCACHE" )) && (attr_cache_ttl = atoi( env )) > 0 &&
+            (attr_cache = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                           ATTR_CACHE_SIZE * sizeof(*attr_cache) )))
+        {
+            if ((fd = inotify_init()) != -1)
+            {
+                fcntl( fd, F_SETFL, O_NONBLOCK );
+                fcntl( fd, F_SETFD, FD_CLOEXEC );
+                attr_cache_fd = fd;
+                enabled = TRUE;
+            }
+            else RtlFreeHeap( GetProcessHeap(), 0, attr_cache );
+        }
+    }
+    RtlLeaveCriticalSection( &attr_cache_section );
+    return enabled;
+}
+
+static inline unsigned int hash_attr_cache_name( const WCHAR *name, USHORT len )
+{
+    unsigned int i, hash = 0;
+
+    for (i = 0; i < len / sizeof(WCHAR); i++) hash = hash * 31 + name[i];
+    return hash & (ATTR_CACHE_SIZE - 1);
+}
+
+static void free_attr_cache_entry( struct attr_cache_entry *entry )
+{
+    RtlFreeHeap( GetProcessHeap(), 0, entry->name );
+    entry->name = NULL;
+}
+
+/* invalidate the entries of all the directories that changed; cache section must be held */
+static void read_attr_cache_events(void)
+{
+    char buffer[4096] DECLSPEC_ALIGN(8);
+    const struct inotify_event *event;
+    unsigned int i;
+    ssize_t len;
+    char *ptr;
+
+    while ((len = read( attr_cache_fd, buffer, sizeof(buffer) )) > 0)
+    {
+        for (ptr = buffer; ptr < buffer + len; ptr += sizeof(*event) + event->len)
+        {
+            event = (const struct inotify_event *)ptr;
+            attr_cache_serial++;
+            for (i = 0; i < ATTR_CACHE_SIZE; i++)
+            {
+                if (!attr_cache[i].name) continue;
+                if (attr_cache[i].wd == event->wd || (event->mask & IN_Q_OVERFLOW))
+                    free_attr_cache_entry( &attr_cache[i] );
+            }
+        }
+    }
+}
+
+static BOOL get_cached_file_info( const OBJECT_ATTRIBUTES *attr, struct stat *st, ULONG *attributes )
+{
+    const UNICODE_STRING *name = attr->ObjectName;
+    struct attr_cache_entry *entry;
+    BOOL ret = FALSE;
+
+    if (attr->RootDirectory || !name->Length) return FALSE;
+
+    entry = &attr_cache[hash_attr_cache_name( name->Buffer, name->Length )];
+    RtlEnterCriticalSection( &attr_cache_section );
+    read_attr_cache_events();
+    if (entry->name && entry->len == name->Length &&
+        entry->check_case == !(attr->Attributes & OBJ_CASE_INSENSITIVE) &&
+        !memcmp( entry->name, name->Buffer, name->Length ))
+    {
+        if (NtGetTickCount() - entry->time < attr_cache_ttl)
+        {
+            *st = entry->st;
+            *attributes = entry->attributes;
+            ret = TRUE;
+        }
+        else free_attr_cache_entry( entry );
+    }
+    RtlLeaveCriticalSection( &attr_cache_section );
+    return ret;
+}
+
+static void add_cached_file_info( const OBJECT_ATTRIBUTES *attr, int wd, unsigned int serial,
+                                  const struct stat *st, ULONG attributes )
+{
+    const UNICODE_STRING *name = attr->ObjectName;
+    struct attr_cache_entry *entry;
+    WCHAR *buffer;
+
+    if (!(buffer = RtlAllocateHeap( GetProcessHeap(), 0, name->Length ))) return;
+    memcpy( buffer, name->Buffer, name->Length );
+
+    entry = &attr_cache[hash_attr_cache_name( name->Buffer, name->Length )];
+    RtlEnterCriticalSection( &attr_cache_section );
+    read_attr_cache_events();
+    /* something changed since the file was stat'ed, don't cache a stale result */
+    if (serial != attr_cache_serial)
+    {
+        RtlLeaveCriticalSection( &attr_cache_section );
+        RtlFreeHeap( GetProcessHeap(), 0, buffer );
+        return;
+    }
+    if (entry->name) free_attr_cache_entry( entry );
+    entry->name       = buffer;
+    entry->len        = name->Length;
+    entry->check_case = !(attr->Attributes & OBJ_CASE_INSENSITIVE);
+    entry->wd         = wd;
+    entry->time       = NtGetTickCount();
+    entry->attributes = attributes;
+    entry->st         = *st;
+    RtlLeaveCriticalSection( &attr_cache_section );
+}
+
+/* start watching the parent directory; return the watch descriptor, or -1 on failure */
+static int watch_attr_cache_dir( char *unix_name, unsigned int *serial )
+{
+    char *p = strrchr( unix_name, '/' );
+    int wd;
+
+    if (!p || p == unix_name) return -1;
+    *p = 0;
+    wd = inotify_add_watch( attr_cache_fd, unix_name, IN_ATTRIB | IN_MODIFY | IN_CREATE | IN_DELETE |
+                            IN_DELETE_SELF | IN_MOVE | IN_MOVE_SELF | IN_CLOSE_WRITE );
+    *p = '/';
+
+    /* fetch the serial after setting the watch, so that no change can be missed */
+    RtlEnterCriticalSection( &attr_cache_section );
+    read_attr_cache_events();
+    *serial = attr_cache_serial;
+    RtlLeaveCriticalSection( &attr_cache_section );
+    return wd;
+}
+
+#endif  /* HAVE_SYS_INOTIFY_H */
+
+/* get the stat info and file attributes for a file (by NT name) */
+static NTSTATUS get_nt_file_info( const OBJECT_ATTRIBUTES *attr, struct stat *st, ULONG *attributes )
+{
+    ANSI_STRING unix_name;
+    NTSTATUS status;
+#ifdef HAVE_SYS_INOTIFY_H
+    BOOL use_cache = init_attr_cache();
+    unsigned int serial = 0;
+    int wd = -1;
+
+    if (use_cache && get_cached_file_info( attr, st, attributes )) return STATUS_SUCCESS;
+#endif
+
+    if ((status = nt_to_unix_file_name_attr( attr, &unix_name, FILE_OPEN )))
+    {
+        WARN("%s not found (%x)\n", debugstr_us(attr->ObjectName), status );
+        return status;
+    }
+
+#ifdef HAVE_SYS_INOTIFY_H
+    if (use_cache && !attr->RootDirectory) wd = watch_attr_cache_dir( unix_name.Buffer, &serial );
+#endif
+
+    if (get_file_info( unix_name.Buffer, st, attributes ) == -1)
+        status = FILE_GetNtStatus();
+    else if (!S_ISREG(st->st_mode) && !S_ISDIR(st->st_mode))
+        status = STATUS_INVALID_INFO_CLASS;
+#ifdef HAVE_SYS_INOTIFY_H
+    else if (wd != -1)
+        add_cached_file_info( attr, wd, serial, st, *attributes );
+#endif
+
+    RtlFreeAnsiString( &unix_name );
+    return status;
+}
+
+
 /******************************************************************************
  *              NtQueryFullAttributesFile   (NTDLL.@)
  */
 NTSTATUS WINAPI NtQueryFullAttributesFile( const OBJECT_ATTRIBUTES *attr,
                                            FILE_NETWORK_OPEN_INFORMATION *info )
 {
-    ANSI_STRING unix_name;
+    ULONG attributes;
+    struct stat st;
     NTSTATUS status;
 
-    if (!(status = nt_to_unix_file_name_attr( attr, &unix_name, FILE_OPEN )))
+    if (!(status = get_nt_file_info( attr, &st, &attributes )))
     {
-        ULONG attributes;
-        struct stat st;
-
-        if (get_file_info( unix_name.Buffer, &st, &attributes ) == -1)
-            status = FILE_GetNtStatus();
-        else if (!S_ISREG(st.st_mode) && !S_ISDIR(st.st_mode))
-            status = STATUS_INVALID_INFO_CLASS;
-        else
-        {
-            FILE_BASIC_INFORMATION basic;
-            FILE_STANDARD_INFORMATION std;
+        FILE_BASIC_INFORMATION basic;
+        FILE_STANDARD_INFORMATION std;
 
-            fill_file_info( &st, attributes, &basic, FileBasicInformation );
-            fill_file_info( &st, attributes, &std, FileStandardInformation );
+        fill_file_info( &st, attributes, &basic, FileBasicInformation );
+        fill_file_info( &st, attributes, &std, FileStandardInformation );
 
-            info->CreationTime   = basic.CreationTime;
-            info->LastAccessTime = basic.LastAccessTime;
-            info->LastWriteTime  = basic.LastWriteTime;
-            info->ChangeTime     = basic.ChangeTime;
-            info->AllocationSize = std.AllocationSize;
-            info->EndOfFile      = std.EndOfFile;
-            info->FileAttributes = basic.FileAttributes;
-            if (DIR_is_hidden_file( attr->ObjectName ))
-                info->FileAttributes |= FILE_ATTRIBUTE_HIDDEN;
-        }
-        RtlFreeAnsiString( &unix_name );
+        info->CreationTime   = basic.CreationTime;
+        info->LastAccessTime = basic.LastAccessTime;
+        info->LastWriteTime  = basic.LastWriteTime;
+        info->ChangeTime     = basic.ChangeTime;
+        info->AllocationSize = std.AllocationSize;
+        info->EndOfFile      = std.EndOfFile;
+        info->FileAttributes = basic.FileAttributes;
+        if (DIR_is_hidden_file( attr->ObjectName ))
+            info->FileAttributes |= FILE_ATTRIBUTE_HIDDEN;
     }
-    else WARN("%s not found (%x)\n", debugstr_us(attr->ObjectName), status );
     return status;
 }
 
@@ -2933,27 +3258,16 @@ NTSTATUS WINAPI NtQueryFullAttributesFile( const OBJECT_ATTRIBUTES *attr,
  */
 NTSTATUS WINAPI NtQueryAttributesFile( const OBJECT_ATTRIBUTES *attr, FILE_BASIC_INFORMATION *info )
 {
-    ANSI_STRING unix_name;
+    ULONG attributes;
+    struct stat st;
     NTSTATUS status;
 
-    if (!(status = nt_to_unix_file_name_attr( attr, &unix_name, FILE_OPEN )))
+    if (!(status = get_nt_file_info( attr, &st, &attributes )))
     {
-        ULONG attributes;
-        struct stat st;
-
-        if (get_file_info( unix_name.Buffer, &st, &attributes ) == -1)
-            status = FILE_GetNtStatus();
-        else if (!S_ISREG(st.st_mode) && !S_ISDIR(st.st_mode))
-            status = STATUS_INVALID_INFO_CLASS;
-        else
-        {
-            status = fill_file_info( &st, attributes, info, FileBasicInformation );
-            if (DIR_is_hidden_file( attr->ObjectName ))
-                info->FileAttributes |= FILE_ATTRIBUTE_HIDDEN;
-        }
-        RtlFreeAnsiString( &unix_name );
+        status = fill_file_info( &st, attributes, info, FileBasicInformation );
+        if (DIR_is_hidden_file( attr->ObjectName ))
+            info->FileAttributes |= FILE_ATTRIBUTE_HIDDEN;
     }
-    else WARN("%s not found (%x)\n", debugstr_us(attr->ObjectName), status );
     return status;
 }
 
@@ -45,6 +45,7 @@
 #include "wine/server.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(heap);
+WINE_DECLARE_DEBUG_CHANNEL(heapstats);
 
 /* Note: the heap data structures are loosely based on what Pietrek describes in his
  * book 'Windows 95 System Programming Secrets', with some adaptations for
@@ -164,6 +165,11 @@ typedef struct tagHEAP
     ARENA_INUSE    **pending_free;  /* Ring buffer for pending free requests */
     RTL_CRITICAL_SECTION critSection; /* Critical section for serialization */
     FREE_LIST_ENTRY *freeList;      /* Free lists */
+    struct lfh_heap *lfh;           /* Low-fragmentation heap data, if enabled */
+    struct heap_stats *stats;       /* Allocation statistics, if enabled */
+    struct list      large_cache;   /* Recently freed large blocks, most recent first */
+    SIZE_T           large_cache_size; /* Total size of the cached large blocks */
+    DWORD            large_cache_count; /* Number of cached large blocks */
 } HEAP;
 
 #define HEAP_MAGIC       ((DWORD)('H' | ('E'<<8) | ('A'<<16) | ('P'<<24)))
@@ -171,6 +177,9 @@ typedef struct tagHEAP
 #define HEAP_DEF_SIZE        0x110000   /* Default heap size = 1Mb + 64Kb */
 #define COMMIT_MASK          0xffff  /* bitmask for commit/decommit granularity */
 #define MAX_FREE_PENDING     1024    /* max number of free requests to delay */
+#define LARGE_CACHE_BLOCKS   8       /* max number of freed large blocks kept for reuse */
+#define LARGE_CACHE_SIZE     0x4000000  /* max total size of the freed large blocks kept for reuse */
+#define LARGE_CACHE_TIMEOUT  2000    /* time in ms after which an unused large block is released */
 
 /* some undocumented flags (names are made up) */
 #define HEAP_PAGE_ALLOCS      0x01000000
@@ -178,9 +187,145 @@ typedef struct tagHEAP
 #define HEAP_VALIDATE_ALL     0x20000000
 #define HEAP_VALIDATE_PARAMS  0x40000000
 
+/* Low-fragmentation heap: small blocks are carved out of slabs of a single
+ * size class, and each thread keeps a magazine of free blocks per class so
+ * that the common allocation and free paths don't need the heap lock.
+ */
+
+typedef struct tagARENA_LFH
+{
+    WORD   data_size;               /* Size of user data */
+    WORD   slab_offset;             /* Offset of the user data from its slab, in ALIGNMENT units */
+    DWORD  magic;                   /* Magic number */
+} ARENA_LFH;
+
+C_ASSERT( sizeof(ARENA_LFH) == sizeof(ARENA_INUSE) );
+
+#define ARENA_LFH_MAGIC        0x4846434c
+#define ARENA_LFH_FREE_MAGIC   0x4846464c
+
+typedef struct tagLFH_SLAB
+{
+    struct list      entry;         /* Entry in the size class partial slabs list */
+    HEAP            *heap;          /* Heap owning the slab */
+    ARENA_LFH       *free;          /* List of free blocks */
+    DWORD            magic;         /* Magic number */
+    WORD             class;         /* Size class index */
+    WORD             count;         /* Total number of blocks in the slab */
+    WORD             carved;        /* Number of blocks carved out so far */
+    WORD             used;          /* Number of blocks not on the free list */
+} LFH_SLAB;
+
+#define LFH_SLAB_MAGIC   ((DWORD)('L' | ('F'<<8) | ('H'<<16) | ('S'<<24)))
+
+#define LFH_MAX_DATA_SIZE     0x4000  /* largest allocation served by the LFH */
+#define LFH_NB_CLASSES        40      /* 16 classes of 16 bytes, then 4 classes per power of two */
+#define LFH_SLAB_SIZE         0x8000  /* preferred size of a slab */
+#define LFH_MIN_SLAB_BLOCKS   8       /* minimum number of blocks in a slab */
+#define LFH_MAGAZINE_BYTES    0x8000  /* max bytes cached per thread and size class */
+#define LFH_MAGAZINE_MAX      64      /* max blocks cached per thread and size class */
+#define LFH_MAGAZINE_MIN      4       /* min blocks cached per thread and size class */
+#define LFH_THREAD_HEAPS      8       /* number of heaps a thread keeps caches for */
+
+struct lfh_class
+{
+    struct list      partial;       /* Slabs with free blocks */
+    DWORD            block_size;    /* Size of the blocks user data */
+    DWORD            magazine_size; /* Max number of blocks in a thread magazine */
+};
+
+struct lfh_heap
+{
+    DWORD            id;            /* Unique id, to detect stale thread caches */
+    ARENA_LFH       *remote;        /* Blocks returned by exiting threads, not locked */
+    struct lfh_class classes[LFH_NB_CLASSES];
+};
+
+struct lfh_magazine
+{
+    ARENA_LFH       *blocks;        /* List of cached free blocks */
+    DWORD            count;         /* Number of cached blocks */
+};
+
+struct lfh_cache
+{
+    HEAP            *heap;          /* Heap the cached blocks belong to */
+    DWORD            id;            /* Id of the heap LFH data */
+    struct lfh_magazine magazines[LFH_NB_CLASSES];
+};
+
+struct lfh_thread_data
+{
+    struct lfh_cache caches[LFH_THREAD_HEAPS];
+    unsigned int     next_evict;    /* Next cache to evict when all are in use */
+};
+
+static LONG lfh_last_id;
+
+/* Allocation statistics, enabled with WINEDEBUG=+heapstats
+ *
+ * Every allocation and free updates the byte counts and the size histogram,
+ * and one allocation out of HEAP_STATS_SAMPLE_RATE records the stack it comes
+ * from. Sampled blocks are tracked until they are freed, so the report shows
+ * which call sites are holding on to the memory. The report is printed when a
+ * heap is destroyed, at process exit, or whenever __wine_dump_heap_stats() is
+ * called.
+ */
+
+#define HEAP_STATS_SAMPLE_RATE  64
+#define HEAP_STATS_FRAMES       8
+#define HEAP_STATS_STACKS       256   /* must be a power of 2 */
+#define HEAP_STATS_SAMPLES      4096  /* must be a power of 2 */
+#define HEAP_STATS_BUCKETS      (sizeof(SIZE_T) * 8)
+#define HEAP_STATS_TOP          10
+
+struct heap_stack
+{
+    void              *frames[HEAP_STATS_FRAMES];
+    ULONG              hash;
+    USHORT             count;        /* number of frames, 0 if the entry is unused */
+    SIZE_T             blocks;       /* number of live sampled blocks */
+    SIZE_T             bytes;        /* size of the live sampled blocks */
+};
+
+struct heap_sample
+{
+    const void        *ptr;
+    struct heap_stack *stack;
+    SIZE_T             size;
+};
+
+struct heap_stats
+{
+    RTL_CRITICAL_SECTION cs;
+    SIZE_T             in_use;       /* bytes currently allocated */
+    SIZE_T             peak;         /* maximum value of in_use */
+    SIZE_T             allocs;       /* total number of allocations */
+    SIZE_T             frees;        /* total number of frees */
+    SIZE_T             nb_samples;   /* number of live sampled blocks */
+    SIZE_T             histogram[HEAP_STATS_BUCKETS];  /* allocations by power of 2 size */
+    struct heap_stack  stacks[HEAP_STATS_STACKS];
+    struct heap_sample samples[HEAP_STATS_SAMPLES];
+};
+
+struct heap_usage
+{
+    SIZE_T             committed;
+    SIZE_T             in_use;
+    SIZE_T             free;
+    SIZE_T             largest_free;
+};
+
+#ifdef __GNUC__
+#define get_caller() __builtin_return_address(0)
+#else
+#define get_caller() NULL
+#endif
+
 static HEAP *processHeap;  /* main process heap */
 
 static BOOL HEAP_IsRealArena( HEAP *heapPtr, DWORD flags, LPCVOID block, BOOL quiet );
+static void *heap_allocate( HEAP *heap, DWORD flags, SIZE_T size );
 
 /* mark a block of memory as free for debugging purposes */
 static inline void mark_block_free( void *ptr, SIZE_T size, DWORD flags )
@@ -716,6 +861,70 @@ static void HEAP_ShrinkBlock(SUBHEAP *subheap, ARENA_INUSE *pArena, SIZE_T size)
 }
 
 
+/***********************************************************************
+ *           release_large_block
+ */
+static void release_large_block( HEAP *heap, ARENA_LARGE *arena )
+{
+    LPVOID address = arena;
+    SIZE_T size = 0;
+
+    list_remove( &arena->entry );
+    heap->large_cache_size -= arena->block_size;
+    heap->large_cache_count--;
+    NtFreeVirtualMemory( NtCurrentProcess(), &address, &size, MEM_RELEASE );
+}
+
+
+/***********************************************************************
+ *           flush_large_cache
+ *
+ * Release the cached large blocks that have not been reused for a while.
+ * The time at which a cached block was freed is stored in its pad[0] field.
+ */
+static void flush_large_cache( HEAP *heap )
+{
+    ARENA_LARGE *arena;
+    ULONG now;
+    struct list *ptr;
+
+    if (!heap->large_cache_count) return;
+
+    now = NtGetTickCount();
+    while ((ptr = list_tail( &heap->large_cache )))
+    {
+        arena = LIST_ENTRY( ptr, ARENA_LARGE, entry );
+        if (now - arena->pad[0] < LARGE_CACHE_TIMEOUT) break;
+        release_large_block( heap, arena );
+    }
+}
+
+
+/***********************************************************************
+ *           find_cached_large_block
+ *
+ * Find a cached block that can hold block_size bytes without wasting too much memory.
+ */
+static ARENA_LARGE *find_cached_large_block( HEAP *heap, SIZE_T block_size )
+{
+    ARENA_LARGE *arena, *best = NULL;
+
+    LIST_FOR_EACH_ENTRY( arena, &heap->large_cache, ARENA_LARGE, entry )
+    {
+        if (arena->block_size < block_size) continue;
+        if (arena->block_size - block_size > block_size / 4) continue;
+        if (!best || arena->block_size < best->block_size) best = arena;
+    }
+    if (best)
+    {
+        list_remove( &best->entry );
+        heap->large_cache_size -= best->block_size;
+        heap->large_cache_count--;
+    }
+    return best;
+}
+
+
 /***********************************************************************
  *           allocate_large_block
  */
@@ -726,6 +935,18 @@ static void *allocate_large_block( HEAP *heap, DWORD flags, SIZE_T size )
     LPVOID address = NULL;
 
     if (block_size < size) return NULL;  /* overflow */
+
+    flush_large_cache( heap );
+    if ((arena = find_cached_large_block( heap, block_size )))
+    {
+        arena->data_size = size;
+        arena->pad[0] = 0;
+        list_add_tail( &heap->large_list, &arena->entry );
+        notify_alloc( arena + 1, size, flags & HEAP_ZERO_MEMORY );
+        initialize_block( arena + 1, size, arena->block_size - sizeof(*arena) - size, flags );
+        return arena + 1;
+    }
+
     if (NtAllocateVirtualMemory( NtCurrentProcess(), &address, 5,
                                  &block_size, MEM_COMMIT, get_protection_type( flags ) ))
     {
@@ -746,6 +967,9 @@ static void *allocate_large_block( HEAP *heap, DWORD flags, SIZE_T size )
 
 /***********************************************************************
  *           free_large_block
+ *
+ * Keep the block around for reuse if there is room in the cache, so that
+ * programs repeatedly allocating big buffers don't have to remap them each time.
  */
 static void free_large_block( HEAP *heap, DWORD flags, void *ptr )
 {
@@ -754,6 +978,21 @@ static void free_large_block( HEAP *heap, DWORD flags, void *ptr )
     SIZE_T size = 0;
 
     list_remove( &arena->entry );
+
+    if (arena->block_size <= LARGE_CACHE_SIZE)
+    {
+        flush_large_cache( heap );
+        while (heap->large_cache_count >= LARGE_CACHE_BLOCKS ||
+               heap->large_cache_size + arena->block_size > LARGE_CACHE_SIZE)
+            release_large_block( heap, LIST_ENTRY( list_tail( &heap->large_cache ), ARENA_LARGE, entry ));
+
+        mark_block_free( arena + 1, arena->block_size - sizeof(*arena), flags );
+        arena->pad[0] = NtGetTickCount();
+        list_add_head( &heap->large_cache, &arena->entry );
+        heap->large_cache_size += arena->block_size;
+        heap->large_cache_count++;
+        return;
+    }
     NtFreeVirtualMemory( NtCurrentProcess(), &address, &size, MEM_RELEASE );
 }
 
@@ -927,6 +1166,7 @@ static SUBHEAP *HEAP_CreateSubHeap( HEAP *heap, LPVOID address, DWORD flags,
         heap->grow_size     = max( HEAP_DEF_SIZE, totalSize );
         list_init( &heap->subheap_list );
         list_init( &heap->large_list );
+        list_init( &heap->large_cache );
 
         subheap = &heap->subheap;
         subheap->base       = address;
@@ -1447,6 +1687,317 @@ static BOOL validate_block_pointer( HEAP *heap, SUBHEAP **ret_subheap, const ARE
 }
 
 
+/***********************************************************************
+ *           heap_get_usage
+ *
+ * Compute the memory usage of a heap by walking its blocks. Heap must be locked.
+ */
+static void heap_get_usage( HEAP *heap, struct heap_usage *usage )
+{
+    SUBHEAP *subheap;
+    ARENA_LARGE *large;
+
+    memset( usage, 0, sizeof(*usage) );
+
+    LIST_FOR_EACH_ENTRY( subheap, &heap->subheap_list, SUBHEAP, entry )
+    {
+        char *ptr = (char *)subheap->base + subheap->headerSize;
+
+        usage->committed += subheap->commitSize;
+        while (ptr < (char *)subheap->base + subheap->size)
+        {
+            if (*(DWORD *)ptr & ARENA_FLAG_FREE)
+            {
+                ARENA_FREE *arena = (ARENA_FREE *)ptr;
+                SIZE_T size = arena->size & ARENA_SIZE_MASK;
+
+                usage->free += size;
+                if (size > usage->largest_free) usage->largest_free = size;
+                ptr += sizeof(*arena) + size;
+            }
+            else
+            {
+                ARENA_INUSE *arena = (ARENA_INUSE *)ptr;
+                SIZE_T size = arena->size & ARENA_SIZE_MASK;
+
+                if (arena->magic == ARENA_PENDING_MAGIC) usage->free += size;
+                else usage->in_use += size - arena->unused_bytes;
+                ptr += sizeof(*arena) + size;
+            }
+        }
+    }
+
+    LIST_FOR_EACH_ENTRY( large, &heap->large_list, ARENA_LARGE, entry )
+    {
+        usage->committed += large->block_size;
+        usage->in_use += large->data_size;
+    }
+    usage->committed += heap->large_cache_size;
+}
+
+
+/***********************************************************************
+ *           heap_stats_init
+ */
+static void heap_stats_init( HEAP *heap )
+{
+    struct heap_stats *stats = NULL;
+    struct heap_usage usage;
+    SIZE_T size = sizeof(*stats);
+
+    if (NtAllocateVirtualMemory( NtCurrentProcess(), (void **)&stats, 4, &size, MEM_COMMIT, PAGE_READWRITE ))
+        return;
+    RtlInitializeCriticalSection( &stats->cs );
+    if (stats->cs.DebugInfo) stats->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": heap_stats.cs");
+
+    /* account for the blocks allocated before we started recording */
+    RtlEnterCriticalSection( &heap->critSection );
+    heap_get_usage( heap, &usage );
+    stats->in_use = stats->peak = usage.in_use;
+    heap->stats = stats;
+    RtlLeaveCriticalSection( &heap->critSection );
+}
+
+
+/***********************************************************************
+ *           heap_stats_get_stack
+ *
+ * Find or create the entry for a stack trace. Stats must be locked.
+ */
+static struct heap_stack *heap_stats_get_stack( struct heap_stats *stats, void **frames, USHORT count )
+{
+    unsigned int i;
+    ULONG hash = 0;
+
+    for (i = 0; i < count; i++) hash = hash * 31 + (ULONG_PTR)frames[i];
+
+    for (i = 0; i < HEAP_STATS_STACKS; i++)
+    {
+        struct heap_stack *stack = &stats->stacks[(hash + i) & (HEAP_STATS_STACKS - 1)];
+
+        if (!stack->count)
+        {
+            memcpy( stack->frames, frames, count * sizeof(*frames) );
+            stack->hash = hash;
+            stack->count = count;
+            return stack;
+        }
+        if (stack->hash == hash && stack->count == count &&
+            !memcmp( stack->frames, frames, count * sizeof(*frames) ))
+            return stack;
+    }
+    return NULL;  /* table is full */
+}
+
+static inline unsigned int heap_stats_hash( const void *ptr )
+{
+    return (((ULONG_PTR)ptr / ALIGNMENT) * 0x9e3779b1) & (HEAP_STATS_SAMPLES - 1);
+}
+
+static int heap_stats_find_sample( struct heap_stats *stats, const void *ptr )
+{
+    unsigned int i = heap_stats_hash( ptr );
+
+    while (stats->samples[i].ptr)
+    {
+        if (stats->samples[i].ptr == ptr) return i;
+        i = (i + 1) & (HEAP_STATS_SAMPLES - 1);
+    }
+    return -1;
+}
+
+/* remove a sample from the table, moving back the entries that follow it */
+static void heap_stats_remove_sample( struct heap_stats *stats, unsigned int i )
+{
+    struct heap_sample *samples = stats->samples;
+    unsigned int j = i, home;
+
+    samples[i].stack->blocks--;
+    samples[i].stack->bytes -= samples[i].size;
+    stats->nb_samples--;
+
+    for (;;)
+    {
+        j = (j + 1) & (HEAP_STATS_SAMPLES - 1);
+        if (!samples[j].ptr) break;
+        home = heap_stats_hash( samples[j].ptr );
+        if (((j - home) & (HEAP_STATS_SAMPLES - 1)) < ((j - i) & (HEAP_STATS_SAMPLES - 1))) continue;
+        samples[i] = samples[j];
+        i = j;
+    }
+    samples[i].ptr = NULL;
+}
+
+
+/***********************************************************************
+ *           heap_stats_alloc
+ *
+ * Record an allocation in the heap statistics.
+ */
+static void heap_stats_alloc( HEAP *heap, const void *ptr, SIZE_T size, void *caller )
+{
+    struct heap_stats *stats = heap->stats;
+    void *frames[HEAP_STATS_FRAMES];
+    struct heap_stack *stack;
+    unsigned int bucket = 0;
+    USHORT count = 0;
+    BOOL sample;
+    int i;
+
+    while (size >> (bucket + 1)) bucket++;
+
+    RtlEnterCriticalSection( &stats->cs );
+    stats->in_use += size;
+    if (stats->in_use > stats->peak) stats->peak = stats->in_use;
+    stats->histogram[bucket]++;
+    sample = !(++stats->allocs % HEAP_STATS_SAMPLE_RATE) && stats->nb_samples < HEAP_STATS_SAMPLES / 2;
+    RtlLeaveCriticalSection( &stats->cs );
+
+    if (!sample) return;
+
+    /* capture the stack outside of the lock, unwinding may need the loader lock */
+#ifdef __i386__
+    count = RtlCaptureStackBackTrace( 2, HEAP_STATS_FRAMES, frames, NULL );
+#endif
+    if (!count)
+    {
+        frames[0] = caller;
+        count = 1;
+    }
+
+    RtlEnterCriticalSection( &stats->cs );
+    if ((stack = heap_stats_get_stack( stats, frames, count )))
+    {
+        if ((i = heap_stats_find_sample( stats, ptr )) != -1) heap_stats_remove_sample( stats, i );
+        i = heap_stats_hash( ptr );
+        while (stats->samples[i].ptr) i = (i + 1) & (HEAP_STATS_SAMPLES - 1);
+        stats->samples[i].ptr   = ptr;
+        stats->samples[i].stack = stack;
+        stats->samples[i].size  = size;
+        stats->nb_samples++;
+        stack->blocks++;
+        stack->bytes += size;
+    }
+    RtlLeaveCriticalSection( &stats->cs );
+}
+
+
+/***********************************************************************
+ *           heap_stats_free
+ *
+ * Record a free in the heap statistics.
+ */
+static void heap_stats_free( HEAP *heap, const void *ptr, SIZE_T size )
+{
+    struct heap_stats *stats = heap->stats;
+    int i;
+
+    RtlEnterCriticalSection( &stats->cs );
+    stats->in_use -= min( stats->in_use, size );
+    stats->frees++;
+    if (stats->nb_samples && (i = heap_stats_find_sample( stats, ptr )) != -1)
+        heap_stats_remove_sample( stats, i );
+    RtlLeaveCriticalSection( &stats->cs );
+}
+
+
+/* print a return address along with the module it belongs to */
+static const char *debugstr_frame( void *addr, BOOL loader_locked )
+{
+    LDR_MODULE *mod;
+
+    if (loader_locked && !LdrFindEntryForAddress( addr, &mod ))
+        return wine_dbg_sprintf( "%p %s+0x%lx", addr, debugstr_w(mod->BaseDllName.Buffer),
+                                 (ULONG_PTR)addr - (ULONG_PTR)mod->BaseAddress );
+    return wine_dbg_sprintf( "%p", addr );
+}
+
+
+/***********************************************************************
+ *           heap_stats_dump
+ *
+ * Print the statistics of a heap, along with the stacks holding the most memory.
+ */
+static void heap_stats_dump( HEAP *heap )
+{
+    struct heap_stats *stats = heap->stats;
+    struct heap_stack top[HEAP_STATS_TOP];
+    SIZE_T histogram[HEAP_STATS_BUCKETS];
+    SIZE_T in_use, peak, allocs, frees;
+    struct heap_usage usage;
+    unsigned int i, j, count = 0;
+    ULONG_PTR magic;
+    ULONG locked;
+
+    RtlEnterCriticalSection( &heap->critSection );
+    heap_get_usage( heap, &usage );
+    RtlLeaveCriticalSection( &heap->critSection );
+
+    RtlEnterCriticalSection( &stats->cs );
+    in_use = stats->in_use;
+    peak   = stats->peak;
+    allocs = stats->allocs;
+    frees  = stats->frees;
+    memcpy( histogram, stats->histogram, sizeof(histogram) );
+    for (i = 0; i < HEAP_STATS_STACKS; i++)
+    {
+        struct heap_stack *stack = &stats->stacks[i];
+
+        if (!stack->blocks) continue;
+        for (j = count; j > 0 && top[j - 1].bytes < stack->bytes; j--)
+            if (j < HEAP_STATS_TOP) top[j] = top[j - 1];
+        if (j < HEAP_STATS_TOP)
+        {
+            top[j] = *stack;
+            if (count < HEAP_STATS_TOP) count++;
+        }
+    }
+    RtlLeaveCriticalSection( &stats->cs );
+
+    TRACE_(heapstats)( "heap %p: in use %lu peak %lu allocs %lu frees %lu\n",
+                       heap, in_use, peak, allocs, frees );
+    TRACE_(heapstats)( "heap %p: committed %lu free %lu largest free block %lu fragmentation %lu%%\n",
+                       heap, usage.committed, usage.free, usage.largest_free,
+                       usage.free ? 100 - usage.largest_free * 100 / usage.free : 0 );
+    for (i = 0; i < HEAP_STATS_BUCKETS; i++)
+    {
+        if (!histogram[i]) continue;
+        TRACE_(heapstats)( "  size %lu-%lu: %lu allocs\n", i ? (SIZE_T)1 << i : 0,
+                           ((SIZE_T)2 << i) - 1, histogram[i] );
+    }
+
+    /* don't wait for the loader lock, we may be called from anywhere */
+    LdrLockLoaderLock( 0x2, &locked, &magic );
+    for (i = 0; i < count; i++)
+    {
+        TRACE_(heapstats)( "  %lu bytes in %lu sampled blocks (about %lu bytes in total) from:\n",
+                           top[i].bytes, top[i].blocks, top[i].bytes * HEAP_STATS_SAMPLE_RATE );
+        for (j = 0; j < top[i].count; j++)
+            TRACE_(heapstats)( "    %s\n", debugstr_frame( top[i].frames[j], locked == 1 ));
+    }
+    LdrUnlockLoaderLock( 0, magic );
+}
+
+
+/***********************************************************************
+ *           __wine_dump_heap_stats   (NTDLL.@)
+ *
+ * Print the allocation statistics of all the heaps.
+ */
+void CDECL __wine_dump_heap_stats(void)
+{
+    HEAP *heap;
+
+    if (!TRACE_ON(heapstats) || !processHeap) return;
+
+    RtlEnterCriticalSection( &processHeap->critSection );
+    if (processHeap->stats) heap_stats_dump( processHeap );
+    LIST_FOR_EACH_ENTRY( heap, &processHeap->entry, HEAP, entry )
+        if (heap->stats) heap_stats_dump( heap );
+    RtlLeaveCriticalSection( &processHeap->critSection );
+}
+
+
 /***********************************************************************
  *           heap_set_debug_flags
  */
@@ -1527,6 +2078,418 @@ void heap_set_debug_flags( HANDLE handle )
             heap->pending_pos = 0;
         }
     }
+
+    if (TRACE_ON(heapstats) && !heap->stats) heap_stats_init( heap );
+}
+
+
+
+/***********************************************************************
+ *           lfh_get_class
+ *
+ * Get the size class index for a given user data size.
+ */
+static inline unsigned int lfh_get_class( SIZE_T size )
+{
+    unsigned int bits = 8;
+
+    if (size <= 0x100) return size ? (size - 1) / 16 : 0;
+    while ((size - 1) >> (bits + 1)) bits++;
+    return 16 + (bits - 8) * 4 + (((size - 1) >> (bits - 2)) & 3);
+}
+
+
+/***********************************************************************
+ *           lfh_get_slab
+ *
+ * Return the slab containing a block, or NULL if it's not a LFH block of this heap.
+ */
+static inline LFH_SLAB *lfh_get_slab( const HEAP *heap, const void *ptr )
+{
+    const ARENA_LFH *arena = (const ARENA_LFH *)ptr - 1;
+    LFH_SLAB *slab;
+
+    if ((ULONG_PTR)ptr % ALIGNMENT) return NULL;
+    if (arena->magic != ARENA_LFH_MAGIC && arena->magic != ARENA_LFH_FREE_MAGIC) return NULL;
+    slab = (LFH_SLAB *)((const char *)ptr - arena->slab_offset * ALIGNMENT);
+    if (slab->magic != LFH_SLAB_MAGIC || slab->heap != heap) return NULL;
+    return slab;
+}
+
+static inline ARENA_LFH **lfh_next_block( ARENA_LFH *arena )
+{
+    return (ARENA_LFH **)(arena + 1);
+}
+
+
+/***********************************************************************
+ *           lfh_alloc_block
+ *
+ * Take a block of the given size class from its slabs. Heap must be locked.
+ */
+static ARENA_LFH *lfh_alloc_block( HEAP *heap, unsigned int index )
+{
+    struct lfh_class *class = &heap->lfh->classes[index];
+    SIZE_T stride = class->block_size + ALIGNMENT;
+    ARENA_LFH *arena;
+    struct list *ptr;
+    LFH_SLAB *slab;
+
+    if ((ptr = list_head( &class->partial ))) slab = LIST_ENTRY( ptr, LFH_SLAB, entry );
+    else
+    {
+        SIZE_T count = max( LFH_MIN_SLAB_BLOCKS, LFH_SLAB_SIZE / stride );
+
+        if (!(slab = heap_allocate( heap, heap->flags, ROUND_SIZE(sizeof(*slab)) + count * stride )))
+            return NULL;
+        slab->heap   = heap;
+        slab->free   = NULL;
+        slab->magic  = LFH_SLAB_MAGIC;
+        slab->class  = index;
+        slab->count  = count;
+        slab->carved = 0;
+        slab->used   = 0;
+        list_add_head( &class->partial, &slab->entry );
+    }
+
+    if ((arena = slab->free)) slab->free = *lfh_next_block( arena );
+    else
+    {
+        arena = (ARENA_LFH *)((char *)slab + ROUND_SIZE(sizeof(*slab)) + slab->carved++ * stride);
+        arena->slab_offset = ((char *)(arena + 1) - (char *)slab) / ALIGNMENT;
+    }
+    if (++slab->used == slab->count) list_remove( &slab->entry );
+    return arena;
+}
+
+
+/***********************************************************************
+ *           lfh_release_block
+ *
+ * Give a block back to its slab, and free the slab once it's empty. Heap must be locked.
+ */
+static void lfh_release_block( HEAP *heap, ARENA_LFH *arena )
+{
+    LFH_SLAB *slab = (LFH_SLAB *)((char *)(arena + 1) - arena->slab_offset * ALIGNMENT);
+    struct lfh_class *class = &heap->lfh->classes[slab->class];
+
+    *lfh_next_block( arena ) = slab->free;
+    slab->free = arena;
+    if (slab->used-- == slab->count) list_add_head( &class->partial, &slab->entry );
+
+    /* keep the last slab around to avoid thrashing */
+    if (!slab->used && (list_prev( &class->partial, &slab->entry ) || list_next( &class->partial, &slab->entry )))
+    {
+        list_remove( &slab->entry );
+        slab->magic = 0;
+        RtlFreeHeap( heap, 0, slab );
+    }
+}
+
+
+/***********************************************************************
+ *           lfh_release_remote
+ *
+ * Give back the blocks released by other threads. Heap must be locked.
+ */
+static void lfh_release_remote( HEAP *heap )
+{
+    ARENA_LFH *arena, *next;
+
+    if (!heap->lfh->remote) return;
+    for (arena = interlocked_xchg_ptr( (void **)&heap->lfh->remote, NULL ); arena; arena = next)
+    {
+        next = *lfh_next_block( arena );
+        lfh_release_block( heap, arena );
+    }
+}
+
+
+/***********************************************************************
+ *           lfh_flush_cache
+ *
+ * Give back all the blocks of a thread cache to its heap, without taking the
+ * heap lock. The process heap lock must be held to make sure the heap is alive.
+ */
+static void lfh_flush_cache( struct lfh_cache *cache )
+{
+    HEAP *heap = cache->heap, *ptr;
+    ARENA_LFH *head, *tail, *next;
+    unsigned int i;
+
+    if (!heap) return;
+    cache->heap = NULL;
+
+    if (heap != processHeap)
+    {
+        LIST_FOR_EACH_ENTRY( ptr, &processHeap->entry, HEAP, entry )
+            if (ptr == heap) break;
+        if (ptr != heap) return;  /* heap has been destroyed */
+    }
+    if (!heap->lfh || heap->lfh->id != cache->id) return;
+
+    for (i = 0; i < LFH_NB_CLASSES; i++)
+    {
+        if (!(head = cache->magazines[i].blocks)) continue;
+        for (tail = head; *lfh_next_block( tail ); tail = *lfh_next_block( tail )) /* nothing */;
+        do
+        {
+            next = heap->lfh->remote;
+            *lfh_next_block( tail ) = next;
+        } while (interlocked_cmpxchg_ptr( (void **)&heap->lfh->remote, head, next ) != next);
+    }
+}
+
+
+/***********************************************************************
+ *           lfh_get_cache
+ *
+ * Get the current thread cache for a heap, creating it if needed.
+ */
+static struct lfh_cache *lfh_get_cache( HEAP *heap )
+{
+    struct lfh_thread_data *data = ntdll_get_thread_data()->heap_lfh;
+    struct lfh_cache *cache, *unused = NULL;
+    DWORD id = heap->lfh->id;
+    unsigned int i;
+
+    if (!data)
+    {
+        if (!(data = heap_allocate( processHeap, processHeap->flags | HEAP_ZERO_MEMORY, sizeof(*data) )))
+            return NULL;
+        ntdll_get_thread_data()->heap_lfh = data;
+    }
+
+    for (i = 0; i < LFH_THREAD_HEAPS; i++)
+    {
+        cache = &data->caches[i];
+        if (cache->heap == heap && cache->id == id) return cache;
+        /* a different id means that the previous heap at that address is gone */
+        if (!unused && (!cache->heap || cache->heap == heap)) unused = cache;
+    }
+
+    if (!unused)
+    {
+        unused = &data->caches[data->next_evict++ % LFH_THREAD_HEAPS];
+        RtlEnterCriticalSection( &processHeap->critSection );
+        lfh_flush_cache( unused );
+        RtlLeaveCriticalSection( &processHeap->critSection );
+    }
+
+    memset( unused, 0, sizeof(*unused) );
+    unused->heap = heap;
+    unused->id   = id;
+    return unused;
+}
+
+
+/***********************************************************************
+ *           lfh_allocate
+ *
+ * Allocate a small block from the low-fragmentation heap.
+ */
+static void *lfh_allocate( HEAP *heap, DWORD flags, SIZE_T size )
+{
+    unsigned int i, index = lfh_get_class( size );
+    struct lfh_class *class = &heap->lfh->classes[index];
+    struct lfh_magazine *magazine;
+    struct lfh_cache *cache;
+    ARENA_LFH *arena;
+
+    if (!(cache = lfh_get_cache( heap )))
+    {
+        RtlEnterCriticalSection( &heap->critSection );
+        arena = lfh_alloc_block( heap, index );
+        RtlLeaveCriticalSection( &heap->critSection );
+        if (!arena) return NULL;
+    }
+    else
+    {
+        magazine = &cache->magazines[index];
+        if (!magazine->count)
+        {
+            /* refill half of the magazine at once */
+            RtlEnterCriticalSection( &heap->critSection );
+            lfh_release_remote( heap );
+            for (i = 0; i < class->magazine_size / 2; i++)
+            {
+                if (!(arena = lfh_alloc_block( heap, index ))) break;
+                *lfh_next_block( arena ) = magazine->blocks;
+                magazine->blocks = arena;
+                magazine->count++;
+            }
+            RtlLeaveCriticalSection( &heap->critSection );
+            if (!magazine->count) return NULL;
+        }
+        arena = magazine->blocks;
+        magazine->blocks = *lfh_next_block( arena );
+        magazine->count--;
+    }
+
+    arena->data_size = size;
+    arena->magic = ARENA_LFH_MAGIC;
+    notify_alloc( arena + 1, size, flags & HEAP_ZERO_MEMORY );
+    initialize_block( arena + 1, size, class->block_size - size, flags );
+    return arena + 1;
+}
+
+
+/***********************************************************************
+ *           lfh_free
+ *
+ * Free a block allocated from the low-fragmentation heap.
+ */
+static BOOLEAN lfh_free( HEAP *heap, LFH_SLAB *slab, void *ptr )
+{
+    ARENA_LFH *arena = (ARENA_LFH *)ptr - 1, *block;
+    struct lfh_class *class = &heap->lfh->classes[slab->class];
+    struct lfh_magazine *magazine;
+    struct lfh_cache *cache;
+
+    if (arena->magic != ARENA_LFH_MAGIC)
+    {
+        WARN( "Heap %p: block %p used after free\n", heap, ptr );
+        RtlSetLastWin32ErrorAndNtStatusFromNtStatus( STATUS_INVALID_PARAMETER );
+        return FALSE;
+    }
+    arena->magic = ARENA_LFH_FREE_MAGIC;
+    notify_free( ptr );
+
+    if (!(cache = lfh_get_cache( heap )))
+    {
+        RtlEnterCriticalSection( &heap->critSection );
+        lfh_release_block( heap, arena );
+        RtlLeaveCriticalSection( &heap->critSection );
+        return TRUE;
+    }
+
+    magazine = &cache->magazines[slab->class];
+    if (magazine->count >= class->magazine_size)
+    {
+        /* give back half of the magazine to the slabs */
+        RtlEnterCriticalSection( &heap->critSection );
+        while (magazine->count > class->magazine_size / 2)
+        {
+            block = magazine->blocks;
+            magazine->blocks = *lfh_next_block( block );
+            magazine->count--;
+            lfh_release_block( heap, block );
+        }
+        RtlLeaveCriticalSection( &heap->critSection );
+    }
+    *lfh_next_block( arena ) = magazine->blocks;
+    magazine->blocks = arena;
+    magazine->count++;
+    return TRUE;
+}
+
+
+/***********************************************************************
+ *           lfh_reallocate
+ *
+ * Resize a block allocated from the low-fragmentation heap.
+ */
+static void *lfh_reallocate( HEAP *heap, DWORD flags, LFH_SLAB *slab, void *ptr, SIZE_T size )
+{
+    ARENA_LFH *arena = (ARENA_LFH *)ptr - 1;
+    SIZE_T block_size = heap->lfh->classes[slab->class].block_size;
+    SIZE_T old_size = arena->data_size;
+    void *ret;
+
+    if (arena->magic != ARENA_LFH_MAGIC)
+    {
+        WARN( "Heap %p: block %p used after free\n", heap, ptr );
+        RtlSetLastWin32ErrorAndNtStatusFromNtStatus( STATUS_INVALID_PARAMETER );
+        return NULL;
+    }
+
+    if (size <= block_size && (lfh_get_class( size ) == slab->class || (flags & HEAP_REALLOC_IN_PLACE_ONLY)))
+    {
+        notify_realloc( ptr, old_size, size );
+        arena->data_size = size;
+        if (size > old_size)
+            initialize_block( (char *)ptr + old_size, size - old_size, block_size - size, flags );
+        else
+            mark_block_tail( (char *)ptr + size, block_size - size, flags );
+        return ptr;
+    }
+
+    if ((flags & HEAP_REALLOC_IN_PLACE_ONLY) ||
+        !(ret = RtlAllocateHeap( heap, flags & ~(HEAP_ZERO_MEMORY | HEAP_GENERATE_EXCEPTIONS), size )))
+    {
+        if (flags & HEAP_GENERATE_EXCEPTIONS) RtlRaiseStatus( STATUS_NO_MEMORY );
+        RtlSetLastWin32ErrorAndNtStatusFromNtStatus( STATUS_NO_MEMORY );
+        return NULL;
+    }
+
+    memcpy( ret, ptr, min( size, old_size ));
+    if (size > old_size && (flags & HEAP_ZERO_MEMORY)) memset( (char *)ret + old_size, 0, size - old_size );
+    lfh_free( heap, slab, ptr );
+    return ret;
+}
+
+
+/***********************************************************************
+ *           lfh_enable
+ *
+ * Enable the low-fragmentation heap.
+ */
+static NTSTATUS lfh_enable( HEAP *heap )
+{
+    struct lfh_heap *lfh;
+    unsigned int i, bits;
+
+    if (heap->lfh) return STATUS_SUCCESS;
+
+    /* the LFH is not compatible with the debugging features */
+    if ((heap->flags & (HEAP_NO_SERIALIZE | HEAP_VALIDATE | HEAP_TAIL_CHECKING_ENABLED |
+                        HEAP_FREE_CHECKING_ENABLED)) || !(heap->flags & HEAP_GROWABLE) ||
+        RUNNING_ON_VALGRIND)
+        return STATUS_UNSUCCESSFUL;
+
+    if (!(lfh = RtlAllocateHeap( heap, 0, sizeof(*lfh) ))) return STATUS_NO_MEMORY;
+
+    lfh->id = interlocked_xchg_add( &lfh_last_id, 1 ) + 1;
+    lfh->remote = NULL;
+    for (i = 0; i < LFH_NB_CLASSES; i++)
+    {
+        struct lfh_class *class = &lfh->classes[i];
+
+        list_init( &class->partial );
+        if (i < 16) class->block_size = (i + 1) * 16;
+        else
+        {
+            bits = 8 + (i - 16) / 4;
+            class->block_size = (5 + (i - 16) % 4) << (bits - 2);
+        }
+        class->magazine_size = min( LFH_MAGAZINE_MAX, max( LFH_MAGAZINE_MIN,
+                                                            LFH_MAGAZINE_BYTES / class->block_size ));
+    }
+
+    RtlEnterCriticalSection( &heap->critSection );
+    if (heap->lfh) RtlFreeHeap( heap, 0, lfh );
+    else interlocked_xchg_ptr( (void **)&heap->lfh, lfh );
+    RtlLeaveCriticalSection( &heap->critSection );
+    return STATUS_SUCCESS;
+}
+
+
+/***********************************************************************
+ *           heap_thread_detach
+ *
+ * Give back the blocks cached by the current thread on thread exit.
+ */
+void heap_thread_detach(void)
+{
+    struct lfh_thread_data *data = ntdll_get_thread_data()->heap_lfh;
+    unsigned int i;
+
+    if (!data) return;
+    RtlEnterCriticalSection( &processHeap->critSection );
+    for (i = 0; i < LFH_THREAD_HEAPS; i++) lfh_flush_cache( &data->caches[i] );
+    RtlLeaveCriticalSection( &processHeap->critSection );
+    ntdll_get_thread_data()->heap_lfh = NULL;
+    RtlFreeHeap( processHeap, 0, data );
 }
 
 
@@ -1612,6 +2575,16 @@ HANDLE WINAPI RtlDestroyHeap( HANDLE heap )
     list_remove( &heapPtr->entry );
     RtlLeaveCriticalSection( &processHeap->critSection );
 
+    if (heapPtr->stats)
+    {
+        heap_stats_dump( heapPtr );
+        if (heapPtr->stats->cs.DebugInfo) heapPtr->stats->cs.DebugInfo->Spare[0] = 0;
+        RtlDeleteCriticalSection( &heapPtr->stats->cs );
+        size = 0;
+        addr = heapPtr->stats;
+        NtFreeVirtualMemory( NtCurrentProcess(), &addr, &size, MEM_RELEASE );
+    }
+
     heapPtr->critSection.DebugInfo->Spare[0] = 0;
     RtlDeleteCriticalSection( &heapPtr->critSection );
 
@@ -1622,6 +2595,8 @@ HANDLE WINAPI RtlDestroyHeap( HANDLE heap )
         addr = arena;
         NtFreeVirtualMemory( NtCurrentProcess(), &addr, &size, MEM_RELEASE );
     }
+    LIST_FOR_EACH_ENTRY_SAFE( arena, arena_next, &heapPtr->large_cache, ARENA_LARGE, entry )
+        release_large_block( heapPtr, arena );
     LIST_FOR_EACH_ENTRY_SAFE( subheap, next, &heapPtr->subheap_list, SUBHEAP, entry )
     {
         if (subheap == &heapPtr->subheap) continue;  /* do this one last */
@@ -1646,35 +2621,17 @@ HANDLE WINAPI RtlDestroyHeap( HANDLE heap )
 
 
 /***********************************************************************
- *           RtlAllocateHeap   (NTDLL.@)
- *
- * Allocate a memory block from a Heap.
- *
- * PARAMS
- *  heap  [I] Heap to allocate block from
- *  flags [I] HEAP_ flags from "winnt.h"
- *  size  [I] Size of the memory block to allocate
- *
- * RETURNS
- *  Success: A pointer to the newly allocated block
- *  Failure: NULL.
+ *           heap_allocate
  *
- * NOTES
- *  This call does not SetLastError().
+ * Allocate a block from the regular heap, flags already include the heap flags.
  */
-PVOID WINAPI RtlAllocateHeap( HANDLE heap, ULONG flags, SIZE_T size )
+static void *heap_allocate( HEAP *heap, DWORD flags, SIZE_T size )
 {
     ARENA_FREE *pArena;
     ARENA_INUSE *pInUse;
     SUBHEAP *subheap;
-    HEAP *heapPtr = HEAP_GetPtr( heap );
     SIZE_T rounded_size;
 
-    /* Validate the parameters */
-
-    if (!heapPtr) return NULL;
-    flags &= HEAP_GENERATE_EXCEPTIONS | HEAP_NO_SERIALIZE | HEAP_ZERO_MEMORY;
-    flags |= heapPtr->flags;
     rounded_size = ROUND_SIZE(size) + HEAP_TAIL_EXTRA_SIZE( flags );
     if (rounded_size < size)  /* overflow */
     {
@@ -1683,12 +2640,12 @@ PVOID WINAPI RtlAllocateHeap( HANDLE heap, ULONG flags, SIZE_T size )
     }
     if (rounded_size < HEAP_MIN_DATA_SIZE) rounded_size = HEAP_MIN_DATA_SIZE;
 
-    if (!(flags & HEAP_NO_SERIALIZE)) RtlEnterCriticalSection( &heapPtr->critSection );
+    if (!(flags & HEAP_NO_SERIALIZE)) RtlEnterCriticalSection( &heap->critSection );
 
     if (rounded_size >= HEAP_MIN_LARGE_BLOCK_SIZE && (flags & HEAP_GROWABLE))
     {
         void *ret = allocate_large_block( heap, flags, size );
-        if (!(flags & HEAP_NO_SERIALIZE)) RtlLeaveCriticalSection( &heapPtr->critSection );
+        if (!(flags & HEAP_NO_SERIALIZE)) RtlLeaveCriticalSection( &heap->critSection );
         if (!ret && (flags & HEAP_GENERATE_EXCEPTIONS)) RtlRaiseStatus( STATUS_NO_MEMORY );
         TRACE("(%p,%08x,%08lx): returning %p\n", heap, flags, size, ret );
         return ret;
@@ -1696,11 +2653,11 @@ PVOID WINAPI RtlAllocateHeap( HANDLE heap, ULONG flags, SIZE_T size )
 
     /* Locate a suitable free block */
 
-    if (!(pArena = HEAP_FindFreeBlock( heapPtr, rounded_size, &subheap )))
+    if (!(pArena = HEAP_FindFreeBlock( heap, rounded_size, &subheap )))
     {
         TRACE("(%p,%08x,%08lx): returning NULL\n",
                   heap, flags, size  );
-        if (!(flags & HEAP_NO_SERIALIZE)) RtlLeaveCriticalSection( &heapPtr->critSection );
+        if (!(flags & HEAP_NO_SERIALIZE)) RtlLeaveCriticalSection( &heap->critSection );
         if (flags & HEAP_GENERATE_EXCEPTIONS) RtlRaiseStatus( STATUS_NO_MEMORY );
         return NULL;
     }
@@ -1726,13 +2683,51 @@ PVOID WINAPI RtlAllocateHeap( HANDLE heap, ULONG flags, SIZE_T size )
     notify_alloc( pInUse + 1, size, flags & HEAP_ZERO_MEMORY );
     initialize_block( pInUse + 1, size, pInUse->unused_bytes, flags );
 
-    if (!(flags & HEAP_NO_SERIALIZE)) RtlLeaveCriticalSection( &heapPtr->critSection );
+    if (!(flags & HEAP_NO_SERIALIZE)) RtlLeaveCriticalSection( &heap->critSection );
 
     TRACE("(%p,%08x,%08lx): returning %p\n", heap, flags, size, pInUse + 1 );
     return pInUse + 1;
 }
 
 
+/***********************************************************************
+ *           RtlAllocateHeap   (NTDLL.@)
+ *
+ * Allocate a memory block from a Heap.
+ *
+ * PARAMS
+ *  heap  [I] Heap to allocate block from
+ *  flags [I] HEAP_ flags from "winnt.h"
+ *  size  [I] Size of the memory block to allocate
+ *
+ * RETURNS
+ *  Success: A pointer to the newly allocated block
+ *  Failure: NULL.
+ *
+ * NOTES
+ *  This call does not SetLastError().
+ */
+PVOID WINAPI RtlAllocateHeap( HANDLE heap, ULONG flags, SIZE_T size )
+{
+    HEAP *heapPtr = HEAP_GetPtr( heap );
+    void *ret;
+
+    /* Validate the parameters */
+
+    if (!heapPtr) return NULL;
+    flags &= HEAP_GENERATE_EXCEPTIONS | HEAP_NO_SERIALIZE | HEAP_ZERO_MEMORY;
+    flags |= heapPtr->flags;
+
+    if (heapPtr->lfh && size <= LFH_MAX_DATA_SIZE && (ret = lfh_allocate( heapPtr, flags, size )))
+        TRACE("(%p,%08x,%08lx): returning %p\n", heap, flags, size, ret );
+    else
+        ret = heap_allocate( heapPtr, flags, size );
+
+    if (ret && heapPtr->stats) heap_stats_alloc( heapPtr, ret, size, get_caller() );
+    return ret;
+}
+
+
 /***********************************************************************
  *           RtlFreeHeap   (NTDLL.@)
  *
@@ -1751,6 +2746,7 @@ BOOLEAN WINAPI RtlFreeHeap( HANDLE heap, ULONG flags, PVOID ptr )
 {
     ARENA_INUSE *pInUse;
     SUBHEAP *subheap;
+    LFH_SLAB *slab;
     HEAP *heapPtr;
 
     /* Validate the parameters */
@@ -1764,6 +2760,19 @@ BOOLEAN WINAPI RtlFreeHeap( HANDLE heap, ULONG flags, PVOID ptr )
         return FALSE;
     }
 
+    if (heapPtr->stats)
+    {
+        SIZE_T size = RtlSizeHeap( heap, flags & HEAP_NO_SERIALIZE, ptr );
+        if (size != ~0UL) heap_stats_free( heapPtr, ptr, size );
+    }
+
+    if (heapPtr->lfh && (slab = lfh_get_slab( heapPtr, ptr )))
+    {
+        BOOLEAN ret = lfh_free( heapPtr, slab, ptr );
+        TRACE("(%p,%08x,%p): returning %u\n", heap, flags, ptr, ret );
+        return ret;
+    }
+
     flags &= HEAP_NO_SERIALIZE;
     flags |= heapPtr->flags;
     if (!(flags & HEAP_NO_SERIALIZE)) RtlEnterCriticalSection( &heapPtr->critSection );
@@ -1812,7 +2821,8 @@ PVOID WINAPI RtlReAllocateHeap( HANDLE heap, ULONG flags, PVOID ptr, SIZE_T size
     ARENA_INUSE *pArena;
     HEAP *heapPtr;
     SUBHEAP *subheap;
-    SIZE_T oldBlockSize, oldActualSize, rounded_size;
+    LFH_SLAB *slab;
+    SIZE_T oldBlockSize, oldActualSize, rounded_size, stats_size = ~0UL;
     void *ret;
 
     if (!ptr) return NULL;
@@ -1827,6 +2837,16 @@ PVOID WINAPI RtlReAllocateHeap( HANDLE heap, ULONG flags, PVOID ptr, SIZE_T size
     flags &= HEAP_GENERATE_EXCEPTIONS | HEAP_NO_SERIALIZE | HEAP_ZERO_MEMORY |
              HEAP_REALLOC_IN_PLACE_ONLY;
     flags |= heapPtr->flags;
+
+    if (heapPtr->stats) stats_size = RtlSizeHeap( heap, flags & HEAP_NO_SERIALIZE, ptr );
+
+    if (heapPtr->lfh && (slab = lfh_get_slab( heapPtr, ptr )))
+    {
+        ret = lfh_reallocate( heapPtr, flags, slab, ptr, size );
+        TRACE("(%p,%08x,%p,%08lx): returning %p\n", heap, flags, ptr, size, ret );
+        goto stats;
+    }
+
     if (!(flags & HEAP_NO_SERIALIZE)) RtlEnterCriticalSection( &heapPtr->critSection );
 
     rounded_size = ROUND_SIZE(size) + HEAP_TAIL_EXTRA_SIZE(flags);
@@ -1923,6 +2943,12 @@ PVOID WINAPI RtlReAllocateHeap( HANDLE heap, ULONG flags, PVOID ptr, SIZE_T size
 done:
     if (!(flags & HEAP_NO_SERIALIZE)) RtlLeaveCriticalSection( &heapPtr->critSection );
     TRACE("(%p,%08x,%p,%08lx): returning %p\n", heap, flags, ptr, size, ret );
+stats:
+    if (ret && stats_size != ~0UL)
+    {
+        heap_stats_free( heapPtr, ptr, stats_size );
+        heap_stats_alloc( heapPtr, ret, size, get_caller() );
+    }
     return ret;
 
 oom:
@@ -2034,6 +3060,14 @@ SIZE_T WINAPI RtlSizeHeap( HANDLE heap, ULONG flags, const void *ptr )
         RtlSetLastWin32ErrorAndNtStatusFromNtStatus( STATUS_INVALID_HANDLE );
         return ~0UL;
     }
+
+    if (heapPtr->lfh && lfh_get_slab( heapPtr, ptr ) && ((const ARENA_LFH *)ptr - 1)->magic == ARENA_LFH_MAGIC)
+    {
+        ret = ((const ARENA_LFH *)ptr - 1)->data_size;
+        TRACE("(%p,%08x,%p): returning %08lx\n", heap, flags, ptr, ret );
+        return ret;
+    }
+
     flags &= HEAP_NO_SERIALIZE;
     flags |= heapPtr->flags;
     if (!(flags & HEAP_NO_SERIALIZE)) RtlEnterCriticalSection( &heapPtr->critSection );
@@ -2078,6 +3112,8 @@ BOOLEAN WINAPI RtlValidateHeap( HANDLE heap, ULONG flags, LPCVOID ptr )
 {
     HEAP *heapPtr = HEAP_GetPtr( heap );
     if (!heapPtr) return FALSE;
+    if (ptr && heapPtr->lfh && lfh_get_slab( heapPtr, ptr ))
+        return ((const ARENA_LFH *)ptr - 1)->magic == ARENA_LFH_MAGIC;
     return HEAP_IsRealArena( heapPtr, flags, ptr, QUIET );
 }
 
@@ -2246,6 +3282,8 @@ ULONG WINAPI RtlGetProcessHeaps( ULONG count, HANDLE *heaps )
 NTSTATUS WINAPI RtlQueryHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS info_class,
                                          PVOID info, SIZE_T size_in, PSIZE_T size_out)
 {
+    HEAP *heapPtr;
+
     switch (info_class)
     {
     case HeapCompatibilityInformation:
@@ -2254,7 +3292,8 @@ NTSTATUS WINAPI RtlQueryHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS inf
         if (size_in < sizeof(ULONG))
             return STATUS_BUFFER_TOO_SMALL;
 
-        *(ULONG *)info = 0; /* standard heap */
+        if (!(heapPtr = HEAP_GetPtr( heap ))) return STATUS_INVALID_PARAMETER;
+        *(ULONG *)info = heapPtr->lfh ? 2 : 0;  /* low-fragmentation or standard heap */
         return STATUS_SUCCESS;
 
     default:
@@ -2268,6 +3307,28 @@ NTSTATUS WINAPI RtlQueryHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS inf
  */
 NTSTATUS WINAPI RtlSetHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS info_class, PVOID info, SIZE_T size)
 {
-    FIXME("%p %d %p %ld stub\n", heap, info_class, info, size);
-    return STATUS_SUCCESS;
+    HEAP *heapPtr;
+
+    switch (info_class)
+    {
+    case HeapCompatibilityInformation:
+        if (size < sizeof(ULONG)) return STATUS_BUFFER_TOO_SMALL;
+        if (!(heapPtr = HEAP_GetPtr( heap ))) return STATUS_INVALID_PARAMETER;
+
+        switch (*(ULONG *)info)
+        {
+        case 0:  /* the LFH can't be disabled once enabled */
+            return heapPtr->lfh ? STATUS_UNSUCCESSFUL : STATUS_SUCCESS;
+        case 2:
+            TRACE( "enabling the low-fragmentation heap for %p\n", heap );
+            return lfh_enable( heapPtr );
+        default:
+            FIXME( "%p: unsupported heap compatibility mode %u\n", heap, *(ULONG *)info );
+            return STATUS_SUCCESS;
+        }
+
+    default:
+        FIXME("%p %d %p %ld stub\n", heap, info_class, info, size);
+        return STATUS_SUCCESS;
+    }
 }
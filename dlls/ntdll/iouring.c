@@ -0,0 +1,456 @@
+/*
+ * io_uring support for overlapped file I/O
+ *
+ * Copyright 2018 Wine project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/*
+ * Overlapped reads and writes on regular files are otherwise done
+ * synchronously by the calling thread.  When WINEIOURING is set, they
+ * are instead queued to a per-process io_uring and return
+ * STATUS_PENDING; a dedicated thread reaps the completions and signals
+ * the event and the completion port directly, without going through
+ * the server for the I/O itself.  Requests with an APC routine are not
+ * handled here, since the APC must be queued to the calling thread.
+ */
+
+#include "config.h"
+#include "wine/port.h"
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
+#ifdef HAVE_SYS_SYSCALL_H
+# include <sys/syscall.h>
+#endif
+#ifdef HAVE_SYS_UIO_H
+# include <sys/uio.h>
+#endif
+#ifdef HAVE_LINUX_IO_URING_H
+# include <linux/io_uring.h>
+#endif
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+
+#include "ntstatus.h"
+#define WIN32_NO_STATUS
+#define NONAMELESSUNION
+#include "windef.h"
+#include "winternl.h"
+#include "wine/debug.h"
+
+#include "ntdll_misc.h"
+
+WINE_DEFAULT_DEBUG_CHANNEL(file);
+
+#if defined(HAVE_LINUX_IO_URING_H) && defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+
+#define IOURING_ENTRIES 256
+
+struct iouring_request
+{
+    IO_STATUS_BLOCK *io;          /* I/O status block to fill on completion */
+    HANDLE           file;        /* file handle, for the completion port */
+    HANDLE           event;       /* event to signal on completion */
+    ULONG_PTR        cvalue;      /* completion value, 0 if none */
+    int              fd;          /* unix fd, only used for the EFAULT fallback */
+    BOOL             write;       /* write request */
+    ULONGLONG        offset;      /* file offset */
+    ULONG            length;      /* total length of the buffers */
+    unsigned int     count;       /* number of buffers */
+    struct iovec     iov[1];      /* data buffers */
+};
+
+struct iouring_sq
+{
+    unsigned int *head;
+    unsigned int *tail;
+    unsigned int *mask;
+    unsigned int *array;
+    struct io_uring_sqe *sqes;
+};
+
+struct iouring_cq
+{
+    unsigned int *head;
+    unsigned int *tail;
+    unsigned int *mask;
+    struct io_uring_cqe *cqes;
+};
+
+static int iouring_fd = -1;
+static struct iouring_sq sq;
+static struct iouring_cq cq;
+static unsigned int iouring_pending;  /* number of requests in flight */
+static HANDLE iouring_thread;
+
+static RTL_CRITICAL_SECTION iouring_section;
+static RTL_CRITICAL_SECTION_DEBUG critsect_debug =
+{
+    0, 0, &iouring_section,
+    { &critsect_debug.ProcessLocksList, &critsect_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": iouring_section") }
+};
+static RTL_CRITICAL_SECTION iouring_section = { &critsect_debug, -1, 0, 0, 0, 0 };
+
+static int io_uring_setup( unsigned int entries, struct io_uring_params *params )
+{
+    return syscall( __NR_io_uring_setup, entries, params );
+}
+
+static int io_uring_enter( int fd, unsigned int to_submit, unsigned int min_complete, unsigned int flags )
+{
+    return syscall( __NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0 );
+}
+
+/* map the rings; return FALSE if io_uring is not available */
+static BOOL init_iouring(void)
+{
+    struct io_uring_params params;
+    char *sq_ring, *cq_ring;
+    int fd;
+
+    memset( &params, 0, sizeof(params) );
+    if ((fd = io_uring_setup( IOURING_ENTRIES, &params )) == -1)
+    {
+        WARN( "io_uring not available (errno %d)\n", errno );
+        return FALSE;
+    }
+
+    sq_ring = mmap( NULL, params.sq_off.array + params.sq_entries * sizeof(unsigned int),
+                    PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING );
+    cq_ring = mmap( NULL, params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe),
+                    PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING );
+    sq.sqes = mmap( NULL, params.sq_entries * sizeof(struct io_uring_sqe),
+                    PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES );
+    if (sq_ring == MAP_FAILED || cq_ring == MAP_FAILED || sq.sqes == MAP_FAILED)
+    {
+        WARN( "failed to map io_uring rings\n" );
+        close( fd );
+        return FALSE;
+    }
+
+    sq.head  = (unsigned int *)(sq_ring + params.sq_off.head);
+    sq.tail  = (unsigned int *)(sq_ring + params.sq_off.tail);
+    sq.mask  = (unsigned int *)(sq_ring + params.sq_off.ring_mask);
+    sq.array = (unsigned int *)(sq_ring + params.sq_off.array);
+    cq.head  = (unsigned int *)(cq_ring + params.cq_off.head);
+    cq.tail  = (unsigned int *)(cq_ring + params.cq_off.tail);
+    cq.mask  = (unsigned int *)(cq_ring + params.cq_off.ring_mask);
+    cq.cqes  = (struct io_uring_cqe *)(cq_ring + params.cq_off.cqes);
+    iouring_fd = fd;
+    return TRUE;
+}
+
+/* retry a request the slow way, one buffer at a time */
+static int fallback_request( struct iouring_request *req )
+{
+    unsigned int i;
+    ssize_t ret;
+    int total = 0;
+
+    for (i = 0; i < req->count; i++)
+    {
+        if (req->write)
+            ret = pwrite( req->fd, req->iov[i].iov_base, req->iov[i].iov_len, req->offset + total );
+        else
+            ret = virtual_locked_pread( req->fd, req->iov[i].iov_base, req->iov[i].iov_len, req->offset + total );
+        if (ret == -1) return total ? total : -errno;
+        total += ret;
+        if (ret < req->iov[i].iov_len) break;
+    }
+    return total;
+}
+
+/* complete a request once the kernel is done with it */
+static void complete_request( struct iouring_request *req, int res )
+{
+    NTSTATUS status;
+
+    /* the buffers may be write-watched */
+    if (res == -EFAULT) res = fallback_request( req );
+
+    if (res >= 0)
+        status = (res || req->write || !req->length) ? STATUS_SUCCESS : STATUS_END_OF_FILE;
+    else if (res == -EFAULT && req->write)
+        status = STATUS_INVALID_USER_BUFFER;
+    else
+    {
+        errno = -res;
+        status = FILE_GetNtStatus();
+    }
+    if (res < 0) res = 0;
+
+    TRACE( "io %p status %08x size %u\n", req->io, status, res );
+
+    req->io->Information = res;
+    req->io->u.Status = status;
+    if (req->event) NtSetEvent( req->event, NULL );
+    if (req->cvalue) NTDLL_AddCompletion( req->file, req->cvalue, status, res, TRUE );
+    close( req->fd );
+    RtlFreeHeap( GetProcessHeap(), 0, req );
+}
+
+static void WINAPI iouring_thread_proc( LPVOID arg )
+{
+    for (;;)
+    {
+        unsigned int head = *cq.head;
+
+        if (head == __atomic_load_n( cq.tail, __ATOMIC_ACQUIRE ))
+        {
+            if (io_uring_enter( iouring_fd, 0, 1, IORING_ENTER_GETEVENTS ) == -1 && errno != EINTR)
+            {
+                ERR( "io_uring_enter failed (errno %d)\n", errno );
+                return;
+            }
+            continue;
+        }
+
+        while (head != __atomic_load_n( cq.tail, __ATOMIC_ACQUIRE ))
+        {
+            struct io_uring_cqe *cqe = &cq.cqes[head & *cq.mask];
+            struct iouring_request *req = (struct iouring_request *)(ULONG_PTR)cqe->user_data;
+            int res = cqe->res;
+
+            head++;
+            __atomic_store_n( cq.head, head, __ATOMIC_RELEASE );
+            interlocked_xchg_add( (int *)&iouring_pending, -1 );
+            complete_request( req, res );
+        }
+    }
+}
+
+/* check whether io_uring should be used, and set it up the first time */
+static BOOL use_iouring(void)
+{
+    static int enabled = -1;
+
+    if (enabled != -1) return enabled;
+
+    RtlEnterCriticalSection( &iouring_section );
+    if (enabled == -1)
+    {
+        const char *env = getenv( "WINEIOURING" );
+        int ret = FALSE;
+
+        if (env && atoi( env ) && init_iouring())
+        {
+            if (!RtlCreateUserThread( NtCurrentProcess(), NULL, FALSE, NULL, 0, 0,
+                                      iouring_thread_proc, NULL, &iouring_thread, NULL ))
+                ret = TRUE;
+            else
+                ERR( "failed to create io_uring thread\n" );
+        }
+        enabled = ret;
+    }
+    RtlLeaveCriticalSection( &iouring_section );
+    return enabled;
+}
+
+static struct iouring_request *alloc_request( unsigned int count )
+{
+    struct iouring_request *req;
+
+    if (!use_iouring()) return NULL;
+    if (!(req = RtlAllocateHeap( GetProcessHeap(), 0, offsetof( struct iouring_request, iov[count] ))))
+        return NULL;
+    req->count = count;
+    return req;
+}
+
+/* queue a request for the buffers that have been set in it */
+static NTSTATUS submit_request( struct iouring_request *req, int fd, HANDLE file, HANDLE event,
+                                IO_STATUS_BLOCK *io, ULONG length, ULONGLONG offset, ULONG_PTR cvalue,
+                                BOOL write )
+{
+    struct io_uring_sqe *sqe;
+    unsigned int tail;
+    int ret;
+
+    req->io     = io;
+    req->file   = file;
+    req->event  = event;
+    req->cvalue = cvalue;
+    req->write  = write;
+    req->offset = offset;
+    req->length = length;
+    /* keep our own fd for the fallback path, the handle may be closed before completion */
+    if ((req->fd = dup( fd )) == -1)
+    {
+        RtlFreeHeap( GetProcessHeap(), 0, req );
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    if (event) NtResetEvent( event, NULL );
+    io->u.Status = STATUS_PENDING;
+    io->Information = 0;
+
+    RtlEnterCriticalSection( &iouring_section );
+
+    /* don't overflow the completion ring, do the I/O synchronously instead */
+    if (iouring_pending >= IOURING_ENTRIES)
+    {
+        RtlLeaveCriticalSection( &iouring_section );
+        close( req->fd );
+        RtlFreeHeap( GetProcessHeap(), 0, req );
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    tail = *sq.tail;
+    sqe = &sq.sqes[tail & *sq.mask];
+    memset( sqe, 0, sizeof(*sqe) );
+    sqe->opcode    = write ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd        = req->fd;
+    sqe->off       = offset;
+    sqe->addr      = (ULONG_PTR)req->iov;
+    sqe->len       = req->count;
+    sqe->user_data = (ULONG_PTR)req;
+    sq.array[tail & *sq.mask] = tail & *sq.mask;
+    __atomic_store_n( sq.tail, tail + 1, __ATOMIC_RELEASE );
+    interlocked_xchg_add( (int *)&iouring_pending, 1 );
+
+    /* this also submits any entry left over by a failed submission */
+    while ((ret = io_uring_enter( iouring_fd, tail + 1 - __atomic_load_n( sq.head, __ATOMIC_ACQUIRE ),
+                                  0, 0 )) == -1 && errno == EINTR);
+
+    RtlLeaveCriticalSection( &iouring_section );
+
+    if (ret == -1)
+    {
+        /* the entry is still queued and will be submitted with the next one */
+        WARN( "io_uring_enter failed (errno %d)\n", errno );
+    }
+    TRACE( "queued %s of %u bytes at %s io %p\n", write ? "write" : "read",
+           length, wine_dbgstr_longlong(offset), io );
+    return STATUS_PENDING;
+}
+
+/***********************************************************************
+ *           iouring_read
+ *
+ * Queue an overlapped read on a regular file.
+ * Returns STATUS_NOT_SUPPORTED if the caller needs to do the I/O itself.
+ */
+NTSTATUS iouring_read( int fd, HANDLE file, HANDLE event, IO_STATUS_BLOCK *io,
+                       void *buffer, ULONG length, ULONGLONG offset, ULONG_PTR cvalue )
+{
+    struct iouring_request *req;
+
+    if (!(req = alloc_request( 1 ))) return STATUS_NOT_SUPPORTED;
+    req->iov[0].iov_base = buffer;
+    req->iov[0].iov_len  = length;
+    return submit_request( req, fd, file, event, io, length, offset, cvalue, FALSE );
+}
+
+/***********************************************************************
+ *           iouring_write
+ *
+ * Queue an overlapped write on a regular file.
+ * Returns STATUS_NOT_SUPPORTED if the caller needs to do the I/O itself.
+ */
+NTSTATUS iouring_write( int fd, HANDLE file, HANDLE event, IO_STATUS_BLOCK *io,
+                        const void *buffer, ULONG length, ULONGLONG offset, ULONG_PTR cvalue )
+{
+    struct iouring_request *req;
+
+    if (!(req = alloc_request( 1 ))) return STATUS_NOT_SUPPORTED;
+    req->iov[0].iov_base = (void *)buffer;
+    req->iov[0].iov_len  = length;
+    return submit_request( req, fd, file, event, io, length, offset, cvalue, TRUE );
+}
+
+/* queue a request on page-sized segments, as used by NtReadFileScatter and NtWriteFileGather */
+static NTSTATUS submit_segments( int fd, HANDLE file, HANDLE event, IO_STATUS_BLOCK *io,
+                                 FILE_SEGMENT_ELEMENT *segments, ULONG length, ULONGLONG offset,
+                                 ULONG_PTR cvalue, BOOL write )
+{
+    struct iouring_request *req;
+    unsigned int i, count = (length + page_size - 1) / page_size;
+    ULONG pos = 0;
+
+    if (!count || count > 1024 /* UIO_MAXIOV */) return STATUS_NOT_SUPPORTED;
+    if (!(req = alloc_request( count ))) return STATUS_NOT_SUPPORTED;
+    for (i = 0; i < count; i++, pos += page_size)
+    {
+        req->iov[i].iov_base = segments[i].Buffer;
+        req->iov[i].iov_len  = min( length - pos, page_size );
+    }
+    return submit_request( req, fd, file, event, io, length, offset, cvalue, write );
+}
+
+/***********************************************************************
+ *           iouring_read_scatter
+ *
+ * Queue an overlapped scatter read on a regular file.
+ * Returns STATUS_NOT_SUPPORTED if the caller needs to do the I/O itself.
+ */
+NTSTATUS iouring_read_scatter( int fd, HANDLE file, HANDLE event, IO_STATUS_BLOCK *io,
+                               FILE_SEGMENT_ELEMENT *segments, ULONG length, ULONGLONG offset,
+                               ULONG_PTR cvalue )
+{
+    return submit_segments( fd, file, event, io, segments, length, offset, cvalue, FALSE );
+}
+
+/***********************************************************************
+ *           iouring_write_gather
+ *
+ * Queue an overlapped gather write on a regular file.
+ * Returns STATUS_NOT_SUPPORTED if the caller needs to do the I/O itself.
+ */
+NTSTATUS iouring_write_gather( int fd, HANDLE file, HANDLE event, IO_STATUS_BLOCK *io,
+                               FILE_SEGMENT_ELEMENT *segments, ULONG length, ULONGLONG offset,
+                               ULONG_PTR cvalue )
+{
+    return submit_segments( fd, file, event, io, segments, length, offset, cvalue, TRUE );
+}
+
+#else  /* HAVE_LINUX_IO_URING_H */
+
+NTSTATUS iouring_read( int fd, HANDLE file, HANDLE event, IO_STATUS_BLOCK *io,
+                       void *buffer, ULONG length, ULONGLONG offset, ULONG_PTR cvalue )
+{
+    return STATUS_NOT_SUPPORTED;
+}
+
+NTSTATUS iouring_write( int fd, HANDLE file, HANDLE event, IO_STATUS_BLOCK *io,
+                        const void *buffer, ULONG length, ULONGLONG offset, ULONG_PTR cvalue )
+{
+    return STATUS_NOT_SUPPORTED;
+}
+
+NTSTATUS iouring_read_scatter( int fd, HANDLE file, HANDLE event, IO_STATUS_BLOCK *io,
+                               FILE_SEGMENT_ELEMENT *segments, ULONG length, ULONGLONG offset,
+                               ULONG_PTR cvalue )
+{
+    return STATUS_NOT_SUPPORTED;
+}
+
+NTSTATUS iouring_write_gather( int fd, HANDLE file, HANDLE event, IO_STATUS_BLOCK *io,
+                               FILE_SEGMENT_ELEMENT *segments, ULONG length, ULONGLONG offset,
+                               ULONG_PTR cvalue )
+{
+    return STATUS_NOT_SUPPORTED;
+}
+
+#endif  /* HAVE_LINUX_IO_URING_H */
@@ -23,10 +23,15 @@
 #include "wine/port.h"
 
 #include <assert.h>
+#include <fcntl.h>
 #include <stdarg.h>
+#include <stdio.h>
 #ifdef HAVE_SYS_MMAN_H
 # include <sys/mman.h>
 #endif
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -38,6 +43,7 @@
 
 #include "wine/exception.h"
 #include "wine/library.h"
+#include "wine/list.h"
 #include "wine/unicode.h"
 #include "wine/debug.h"
 #include "wine/server.h"
@@ -49,6 +55,7 @@ WINE_DECLARE_DEBUG_CHANNEL(relay);
 WINE_DECLARE_DEBUG_CHANNEL(snoop);
 WINE_DECLARE_DEBUG_CHANNEL(loaddll);
 WINE_DECLARE_DEBUG_CHANNEL(imports);
+WINE_DECLARE_DEBUG_CHANNEL(loadtime);
 
 #ifdef _WIN64
 #define DEFAULT_SECURITY_COOKIE_64  (((ULONGLONG)0x00002b99 << 32) | 0x2ddfa232)
@@ -83,6 +90,16 @@ static const char * const reason_names[] =
 
 static const WCHAR dllW[] = {'.','d','l','l',0};
 
+/* phases of a module load, timed with WINEDEBUG=+loadtime */
+enum load_phase
+{
+    LOAD_PHASE_MAP,       /* loading the native or builtin module */
+    LOAD_PHASE_RELOC,     /* applying base relocations */
+    LOAD_PHASE_IMPORTS,   /* resolving the imports */
+    LOAD_PHASE_INIT,      /* running the TLS callbacks and DllMain */
+    LOAD_PHASE_COUNT
+};
+
 /* internal representation of 32bit modules. per process. */
 typedef struct _wine_modref
 {
@@ -92,6 +109,9 @@ typedef struct _wine_modref
     int                   alloc_deps;
     int                   nDeps;
     struct _wine_modref **deps;
+    DWORD                *export_hash;      /* hash table of export name indices + 1 */
+    DWORD                 export_hash_mask; /* size of the hash table - 1 */
+    ULONGLONG             load_time[LOAD_PHASE_COUNT];  /* time spent in each load phase */
 } WINE_MODREF;
 
 /* info about the current builtin dll load */
@@ -121,6 +141,38 @@ static RTL_CRITICAL_SECTION_DEBUG critsect_debug =
 };
 static RTL_CRITICAL_SECTION loader_section = { &critsect_debug, -1, 0, 0, 0, 0 };
 
+/* cache of dll search path lookups, including failed ones */
+struct dll_search_entry
+{
+    struct list  entry;
+    WCHAR       *load_path;
+    WCHAR       *cur_dir;
+    WCHAR       *libname;
+    WCHAR       *filename;     /* full path name, NULL if not found */
+};
+
+/* directory of a load path, watched to invalidate the cache */
+struct dll_search_dir
+{
+    struct list     entry;
+    HANDLE          handle;    /* 0 if the directory can't be watched */
+    HANDLE          event;
+    IO_STATUS_BLOCK io;
+    WCHAR           path[1];
+};
+
+#define DLL_SEARCH_CACHE_MAX 256
+
+static struct list dll_search_cache = LIST_INIT( dll_search_cache );
+static struct list dll_search_dirs = LIST_INIT( dll_search_dirs );
+static unsigned int dll_search_count;
+static HANDLE dll_search_events[MAXIMUM_WAIT_OBJECTS];
+static struct dll_search_dir *dll_search_watched[MAXIMUM_WAIT_OBJECTS];
+static unsigned int dll_search_nb_watched;
+static LONG dll_search_last_serial;
+LONG dll_search_serial;  /* incremented when the process creates or renames a file */
+LONG module_unload_serial;  /* incremented when a module is unloaded */
+
 static WINE_MODREF *cached_modref;
 static WINE_MODREF *current_modref;
 static WINE_MODREF *last_failed_modref;
@@ -132,6 +184,34 @@ static FARPROC find_ordinal_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY
 static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
                                   DWORD exp_size, const char *name, int hint, LPCWSTR load_path );
 
+static ULONGLONG load_time_nested;  /* time spent in the phases nested in the current one */
+
+/* start timing a load phase; the previous nested time is saved in *nested */
+static inline ULONGLONG load_time_start( ULONGLONG *nested )
+{
+    LARGE_INTEGER counter;
+
+    if (!TRACE_ON(loadtime)) return 0;
+    *nested = load_time_nested;
+    load_time_nested = 0;
+    NtQueryPerformanceCounter( &counter, NULL );
+    return counter.QuadPart;
+}
+
+/* stop timing a load phase, and return the time spent in the phase itself */
+static inline ULONGLONG load_time_end( ULONGLONG start, ULONGLONG nested )
+{
+    LARGE_INTEGER counter;
+    ULONGLONG elapsed, self;
+
+    if (!TRACE_ON(loadtime)) return 0;
+    NtQueryPerformanceCounter( &counter, NULL );
+    elapsed = counter.QuadPart - start;
+    self = elapsed > load_time_nested ? elapsed - load_time_nested : 0;
+    load_time_nested = nested + elapsed;
+    return self;
+}
+
 /* convert PE image VirtualAddress to Real Address */
 static inline void *get_rva( HMODULE module, DWORD va )
 {
@@ -563,7 +643,7 @@ static FARPROC find_ordinal_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY
         const WCHAR *user = current_modref ? current_modref->ldr.BaseDllName.Buffer : NULL;
         proc = SNOOP_GetProcAddress( module, exports, exp_size, proc, ordinal, user );
     }
-    if (TRACE_ON(relay))
+    if (TRACE_ON(relay) || RELAY_LogEnabled())
     {
         const WCHAR *user = current_modref ? current_modref->ldr.BaseDllName.Buffer : NULL;
         proc = RELAY_GetProcAddress( module, exports, exp_size, proc, ordinal, user );
@@ -572,6 +652,54 @@ static FARPROC find_ordinal_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY
 }
 
 
+/*************************************************************************
+ *		hash_export_name
+ */
+static inline DWORD hash_export_name( const char *name )
+{
+    DWORD hash = 0;
+
+    while (*name) hash = hash * 65599 + (unsigned char)*name++;
+    return hash;
+}
+
+
+/*************************************************************************
+ *		get_export_hash
+ *
+ * Return the hash table of the export names of a module, building it on first use.
+ * The loader_section must be locked while calling this function.
+ */
+static const DWORD *get_export_hash( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
+                                     DWORD *mask )
+{
+    const DWORD *names = get_rva( module, exports->AddressOfNames );
+    WINE_MODREF *wm;
+    DWORD i, pos, size;
+
+    /* not worth it for small export tables */
+    if (exports->NumberOfNames < 32) return NULL;
+    if (!(wm = get_modref( module ))) return NULL;
+
+    if (!wm->export_hash)
+    {
+        for (size = 64; size < exports->NumberOfNames * 2; size *= 2) ;
+        if (!(wm->export_hash = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                                 size * sizeof(*wm->export_hash) )))
+            return NULL;
+        wm->export_hash_mask = size - 1;
+        for (i = 0; i < exports->NumberOfNames; i++)
+        {
+            pos = hash_export_name( get_rva( module, names[i] )) & wm->export_hash_mask;
+            while (wm->export_hash[pos]) pos = (pos + 1) & wm->export_hash_mask;
+            wm->export_hash[pos] = i + 1;
+        }
+    }
+    *mask = wm->export_hash_mask;
+    return wm->export_hash;
+}
+
+
 /*************************************************************************
  *		find_named_export
  *
@@ -584,6 +712,8 @@ static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *
     const WORD *ordinals = get_rva( module, exports->AddressOfNameOrdinals );
     const DWORD *names = get_rva( module, exports->AddressOfNames );
     int min = 0, max = exports->NumberOfNames - 1;
+    const DWORD *hash;
+    DWORD mask, pos;
 
     /* first check the hint */
     if (hint >= 0 && hint <= max)
@@ -593,7 +723,19 @@ static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *
             return find_ordinal_export( module, exports, exp_size, ordinals[hint], load_path );
     }
 
-    /* then do a binary search */
+    /* then look it up in the hash table */
+    if ((hash = get_export_hash( module, exports, &mask )))
+    {
+        for (pos = hash_export_name( name ) & mask; hash[pos]; pos = (pos + 1) & mask)
+        {
+            char *ename = get_rva( module, names[hash[pos] - 1] );
+            if (!strcmp( ename, name ))
+                return find_ordinal_export( module, exports, exp_size, ordinals[hash[pos] - 1], load_path );
+        }
+        return NULL;
+    }
+
+    /* or do a binary search */
     while (min <= max)
     {
         int res, pos = (min + max) / 2;
@@ -980,6 +1122,7 @@ static NTSTATUS fixup_imports( WINE_MODREF *wm, LPCWSTR load_path )
     DWORD size;
     NTSTATUS status;
     ULONG_PTR cookie;
+    ULONGLONG start, nested;
 
     if (!(wm->ldr.Flags & LDR_DONT_RESOLVE_REFS)) return STATUS_SUCCESS;  /* already done */
     wm->ldr.Flags &= ~LDR_DONT_RESOLVE_REFS;
@@ -1008,6 +1151,7 @@ static NTSTATUS fixup_imports( WINE_MODREF *wm, LPCWSTR load_path )
     prev = current_modref;
     current_modref = wm;
     status = STATUS_SUCCESS;
+    start = load_time_start( &nested );
     for (i = 0; i < nb_imports; i++)
     {
         dep = wm->nDeps++;
@@ -1019,6 +1163,7 @@ static NTSTATUS fixup_imports( WINE_MODREF *wm, LPCWSTR load_path )
         }
         wm->deps[dep] = imp;
     }
+    wm->load_time[LOAD_PHASE_IMPORTS] += load_time_end( start, nested );
     current_modref = prev;
     if (wm->ldr.ActivationContext) RtlDeactivateActivationContext( 0, cookie );
     return status;
@@ -1274,8 +1419,12 @@ static NTSTATUS process_attach( WINE_MODREF *wm, LPVOID lpReserved )
     if (status == STATUS_SUCCESS)
     {
         WINE_MODREF *prev = current_modref;
+        ULONGLONG start, nested;
+
         current_modref = wm;
+        start = load_time_start( &nested );
         status = MODULE_InitDLL( wm, DLL_PROCESS_ATTACH, lpReserved );
+        wm->load_time[LOAD_PHASE_INIT] += load_time_end( start, nested );
         if (status == STATUS_SUCCESS)
             wm->ldr.Flags |= LDR_PROCESS_ATTACHED;
         else
@@ -1704,7 +1853,7 @@ static void load_builtin_callback( void *module, const char *filename )
     SERVER_END_REQ;
 
     /* setup relay debugging entry points */
-    if (TRACE_ON(relay)) RELAY_SetupDLL( module );
+    if (TRACE_ON(relay) || RELAY_LogEnabled()) RELAY_SetupDLL( module );
 }
 
 
@@ -1864,6 +2013,139 @@ static BOOL is_valid_binary( HMODULE module, const pe_image_info_t *info )
 }
 
 
+/* an exported symbol for the perf map */
+struct perf_symbol
+{
+    DWORD       rva;
+    const char *name;
+    DWORD       ordinal;
+};
+
+static int perf_symbol_compare( const void *a, const void *b )
+{
+    const struct perf_symbol *sym1 = a, *sym2 = b;
+    return sym1->rva < sym2->rva ? -1 : sym1->rva > sym2->rva;
+}
+
+/***********************************************************************
+ *           get_perf_map_fd
+ *
+ * Open the /tmp/perf-<pid>.map file used by Linux perf to symbolize
+ * code that it can't find in an ELF file, if WINEPERFMAP is set.
+ * The loader lock must be held.
+ */
+static int get_perf_map_fd(void)
+{
+    static int fd = -2;
+    char name[32];
+
+    if (fd == -2)
+    {
+        fd = -1;
+        if (getenv( "WINEPERFMAP" ))
+        {
+            sprintf( name, "/tmp/perf-%d.map", (int)getpid() );
+            if ((fd = open( name, O_WRONLY | O_CREAT | O_APPEND, 0644 )) == -1)
+                WARN( "failed to open %s\n", name );
+        }
+    }
+    return fd;
+}
+
+/***********************************************************************
+ *           perf_map_module
+ *
+ * Write the perf map records of a native module: one per export, each
+ * extending to the next export or to the end of its section, and one
+ * for the code before the first export. The loader lock must be held.
+ */
+static void perf_map_module( WINE_MODREF *wm )
+{
+    const IMAGE_NT_HEADERS *nt = RtlImageNtHeader( wm->ldr.BaseAddress );
+    const IMAGE_SECTION_HEADER *sec = (const IMAGE_SECTION_HEADER *)((const char *)&nt->OptionalHeader +
+                                                                     nt->FileHeader.SizeOfOptionalHeader);
+    const IMAGE_EXPORT_DIRECTORY *exports;
+    const DWORD *functions, *names;
+    const WORD *ordinals;
+    struct perf_symbol *symbols = NULL;
+    char module[MAX_PATH], line[MAX_PATH + 64];
+    char *base = wm->ldr.BaseAddress;
+    DWORD i, j, count = 0, end, code_start = 0, code_end = 0;
+    ULONG exports_size;
+    int fd, len;
+
+    if ((fd = get_perf_map_fd()) == -1) return;
+
+    len = ntdll_wcstoumbs( 0, wm->ldr.BaseDllName.Buffer, wm->ldr.BaseDllName.Length / sizeof(WCHAR),
+                           module, sizeof(module) - 1, NULL, NULL );
+    module[max( len, 0 )] = 0;
+
+    for (i = 0; i < nt->FileHeader.NumberOfSections; i++)
+    {
+        if (!(sec[i].Characteristics & IMAGE_SCN_MEM_EXECUTE)) continue;
+        if (!code_end) code_start = sec[i].VirtualAddress;
+        code_end = max( code_end, sec[i].VirtualAddress + sec[i].Misc.VirtualSize );
+    }
+    if (!code_end) return;
+
+    exports = RtlImageDirectoryEntryToData( wm->ldr.BaseAddress, TRUE, IMAGE_DIRECTORY_ENTRY_EXPORT, &exports_size );
+    if (exports && exports->NumberOfFunctions &&
+        (symbols = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                    exports->NumberOfFunctions * sizeof(*symbols) )))
+    {
+        functions = (const DWORD *)(base + exports->AddressOfFunctions);
+        names = (const DWORD *)(base + exports->AddressOfNames);
+        ordinals = (const WORD *)(base + exports->AddressOfNameOrdinals);
+
+        for (i = 0; i < exports->NumberOfNames; i++)
+            if (ordinals[i] < exports->NumberOfFunctions) symbols[ordinals[i]].name = base + names[i];
+
+        for (i = 0; i < exports->NumberOfFunctions; i++)
+        {
+            /* skip empty slots, forwarders and data */
+            if (functions[i] < code_start || functions[i] >= code_end) continue;
+            if (functions[i] >= (const char *)exports - base &&
+                functions[i] < (const char *)exports - base + exports_size) continue;
+            symbols[count].rva = functions[i];
+            symbols[count].ordinal = exports->Base + i;
+            symbols[count].name = symbols[i].name;
+            count++;
+        }
+        qsort( symbols, count, sizeof(*symbols), perf_symbol_compare );
+    }
+
+    end = count ? symbols[0].rva : code_end;
+    if (end > code_start)
+    {
+        len = snprintf( line, sizeof(line), "%lx %x %s\n", (ULONG_PTR)base + code_start, end - code_start, module );
+        write( fd, line, min( len, sizeof(line) - 1 ) );
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        if (i + 1 < count && symbols[i + 1].rva == symbols[i].rva) continue;  /* aliases */
+        for (j = 0, end = code_end; j < nt->FileHeader.NumberOfSections; j++)
+        {
+            if (symbols[i].rva < sec[j].VirtualAddress ||
+                symbols[i].rva >= sec[j].VirtualAddress + sec[j].Misc.VirtualSize) continue;
+            end = sec[j].VirtualAddress + sec[j].Misc.VirtualSize;
+            break;
+        }
+        if (i + 1 < count) end = min( end, symbols[i + 1].rva );
+
+        if (symbols[i].name)
+            len = snprintf( line, sizeof(line), "%lx %x %s!%s\n", (ULONG_PTR)base + symbols[i].rva,
+                            end - symbols[i].rva, module, symbols[i].name );
+        else
+            len = snprintf( line, sizeof(line), "%lx %x %s!#%u\n", (ULONG_PTR)base + symbols[i].rva,
+                            end - symbols[i].rva, module, symbols[i].ordinal );
+        write( fd, line, min( len, sizeof(line) - 1 ) );
+    }
+
+    RtlFreeHeap( GetProcessHeap(), 0, symbols );
+}
+
+
 /******************************************************************************
  *	load_native_dll  (internal)
  */
@@ -1878,6 +2160,7 @@ static NTSTATUS load_native_dll( LPCWSTR load_path, LPCWSTR name, HANDLE file,
     WINE_MODREF *wm;
     NTSTATUS status;
     pe_image_info_t image_info;
+    ULONGLONG start, nested, reloc_time = 0;
 
     TRACE("Trying native dll %s\n", debugstr_w(name));
 
@@ -1901,7 +2184,11 @@ static NTSTATUS load_native_dll( LPCWSTR load_path, LPCWSTR name, HANDLE file,
     /* perform base relocation, if necessary */
 
     if (status == STATUS_IMAGE_NOT_AT_BASE)
+    {
+        start = load_time_start( &nested );
         status = perform_relocations( module, len );
+        reloc_time = load_time_end( start, nested );
+    }
 
     if (status != STATUS_SUCCESS)
     {
@@ -1919,6 +2206,7 @@ static NTSTATUS load_native_dll( LPCWSTR load_path, LPCWSTR name, HANDLE file,
 
     wm->dev = st->st_dev;
     wm->ino = st->st_ino;
+    wm->load_time[LOAD_PHASE_RELOC] = reloc_time;
     if (image_info.loader_flags) wm->ldr.Flags |= LDR_COR_IMAGE;
     if (image_info.image_flags & IMAGE_FLAGS_ComPlusILOnly) wm->ldr.Flags |= LDR_COR_ILONLY;
 
@@ -1968,6 +2256,8 @@ static NTSTATUS load_native_dll( LPCWSTR load_path, LPCWSTR name, HANDLE file,
 
     if ((wm->ldr.Flags & LDR_IMAGE_IS_DLL) && TRACE_ON(snoop)) SNOOP_SetupDLL( module );
 
+    perf_map_module( wm );
+
     TRACE_(loaddll)( "Loaded %s at %p: native\n", debugstr_w(wm->ldr.FullDllName.Buffer), module );
 
     wm->ldr.LoadCount = 1;
@@ -2199,6 +2489,241 @@ done:
 }
 
 
+/***********************************************************************
+ *	watch_dll_search_dir
+ *
+ * Start or restart the change notification on a load path directory.
+ */
+static BOOL watch_dll_search_dir( struct dll_search_dir *dir )
+{
+    NTSTATUS status;
+
+    status = NtNotifyChangeDirectoryFile( dir->handle, dir->event, NULL, NULL, &dir->io, NULL, 0,
+                                          FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME,
+                                          FALSE );
+    return status == STATUS_PENDING;
+}
+
+
+/***********************************************************************
+ *	free_dll_search_entry
+ */
+static void free_dll_search_entry( struct dll_search_entry *entry )
+{
+    RtlFreeHeap( GetProcessHeap(), 0, entry->load_path );
+    RtlFreeHeap( GetProcessHeap(), 0, entry->cur_dir );
+    RtlFreeHeap( GetProcessHeap(), 0, entry->libname );
+    RtlFreeHeap( GetProcessHeap(), 0, entry->filename );
+    RtlFreeHeap( GetProcessHeap(), 0, entry );
+}
+
+
+/***********************************************************************
+ *	flush_dll_search_cache
+ */
+static void flush_dll_search_cache(void)
+{
+    struct dll_search_entry *entry, *next;
+
+    LIST_FOR_EACH_ENTRY_SAFE( entry, next, &dll_search_cache, struct dll_search_entry, entry )
+    {
+        list_remove( &entry->entry );
+        free_dll_search_entry( entry );
+    }
+    dll_search_count = 0;
+}
+
+
+/***********************************************************************
+ *	check_dll_search_cache
+ *
+ * Flush the cache if one of the watched directories has changed,
+ * or if the process created or renamed a file itself.
+ */
+static void check_dll_search_cache(void)
+{
+    static const LARGE_INTEGER zero;
+    BOOL changed = FALSE;
+    LONG serial = dll_search_serial;
+    NTSTATUS status;
+
+    if (serial != dll_search_last_serial)
+    {
+        dll_search_last_serial = serial;
+        changed = TRUE;
+    }
+    while (dll_search_nb_watched)
+    {
+        status = NtWaitForMultipleObjects( dll_search_nb_watched, dll_search_events,
+                                           WaitAny, FALSE, &zero );
+        if (status >= dll_search_nb_watched) break;
+        if (!watch_dll_search_dir( dll_search_watched[status] ))
+        {
+            /* stop caching anything that depends on this directory */
+            struct dll_search_dir *dir = dll_search_watched[status];
+
+            NtClose( dir->handle );
+            NtClose( dir->event );
+            dir->handle = dir->event = 0;
+            dll_search_nb_watched--;
+            dll_search_events[status] = dll_search_events[dll_search_nb_watched];
+            dll_search_watched[status] = dll_search_watched[dll_search_nb_watched];
+        }
+        changed = TRUE;
+    }
+    if (changed) flush_dll_search_cache();
+}
+
+
+/***********************************************************************
+ *	get_dll_search_dir
+ *
+ * Find or create the watched directory for a load path entry.
+ */
+static struct dll_search_dir *get_dll_search_dir( const WCHAR *path )
+{
+    struct dll_search_dir *dir;
+    UNICODE_STRING nt_name;
+    OBJECT_ATTRIBUTES attr;
+    IO_STATUS_BLOCK io;
+
+    LIST_FOR_EACH_ENTRY( dir, &dll_search_dirs, struct dll_search_dir, entry )
+        if (!strcmpiW( dir->path, path )) return dir;
+
+    if (!(dir = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                 offsetof( struct dll_search_dir, path[strlenW(path) + 1] ))))
+        return NULL;
+    strcpyW( dir->path, path );
+    list_add_tail( &dll_search_dirs, &dir->entry );
+
+    if (dll_search_nb_watched >= MAXIMUM_WAIT_OBJECTS) return dir;
+    if (!RtlDosPathNameToNtPathName_U( path, &nt_name, NULL, NULL )) return dir;
+
+    attr.Length = sizeof(attr);
+    attr.RootDirectory = 0;
+    attr.Attributes = OBJ_CASE_INSENSITIVE;
+    attr.ObjectName = &nt_name;
+    attr.SecurityDescriptor = NULL;
+    attr.SecurityQualityOfService = NULL;
+    if (!NtOpenFile( &dir->handle, FILE_LIST_DIRECTORY | SYNCHRONIZE, &attr, &io,
+                     FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, FILE_DIRECTORY_FILE ))
+    {
+        if (!NtCreateEvent( &dir->event, EVENT_ALL_ACCESS, NULL, SynchronizationEvent, FALSE ) &&
+            watch_dll_search_dir( dir ))
+        {
+            dll_search_events[dll_search_nb_watched] = dir->event;
+            dll_search_watched[dll_search_nb_watched++] = dir;
+        }
+        else
+        {
+            if (dir->event) NtClose( dir->event );
+            NtClose( dir->handle );
+            dir->handle = dir->event = 0;
+        }
+    }
+    RtlFreeUnicodeString( &nt_name );
+    return dir;
+}
+
+
+/***********************************************************************
+ *	watch_load_path
+ *
+ * Make sure that all the directories of a load path are watched for changes.
+ * Returns FALSE if some of them can't be, in which case nothing is cached.
+ */
+static BOOL watch_load_path( const WCHAR *load_path )
+{
+    static const WCHAR dotW[] = {'.',0};
+    struct dll_search_dir *dir;
+    WCHAR buffer[MAX_PATH], path[MAX_PATH];
+    const WCHAR *p, *end;
+    ULONG len;
+
+    for (p = load_path; *p; p = end)
+    {
+        for (end = p; *end && *end != ';'; end++) ;
+        len = end - p;
+        if (*end) end++;
+        if (len >= MAX_PATH) return FALSE;
+        memcpy( buffer, p, len * sizeof(WCHAR) );
+        buffer[len] = 0;
+
+        len = RtlGetFullPathName_U( len ? buffer : dotW, sizeof(path), path, NULL );
+        if (!len || len >= sizeof(path)) return FALSE;
+        if (!(dir = get_dll_search_dir( path )) || !dir->handle) return FALSE;
+    }
+    return TRUE;
+}
+
+
+/***********************************************************************
+ *	search_dll_path
+ *
+ * Search a relative dll name in the load path, using the search cache
+ * when possible. Same semantics as RtlDosSearchPath_U.
+ * The loader_section must be locked while calling this function.
+ */
+static ULONG search_dll_path( const WCHAR *load_path, const WCHAR *libname,
+                              ULONG size, WCHAR *filename )
+{
+    struct dll_search_entry *entry;
+    WCHAR cur_dir[MAX_PATH], *file_part;
+    ULONG len;
+
+    len = RtlGetCurrentDirectory_U( sizeof(cur_dir), cur_dir );
+    if (!len || len >= sizeof(cur_dir))
+        return RtlDosSearchPath_U( load_path, libname, NULL, size, filename, &file_part );
+
+    check_dll_search_cache();
+
+    LIST_FOR_EACH_ENTRY( entry, &dll_search_cache, struct dll_search_entry, entry )
+    {
+        if (strcmpW( entry->load_path, load_path )) continue;
+        if (strcmpiW( entry->libname, libname )) continue;
+        if (strcmpiW( entry->cur_dir, cur_dir )) continue;
+
+        /* move it to the front of the list */
+        list_remove( &entry->entry );
+        list_add_head( &dll_search_cache, &entry->entry );
+        if (!entry->filename) return 0;
+        len = strlenW( entry->filename ) * sizeof(WCHAR);
+        if (len < size) memcpy( filename, entry->filename, len + sizeof(WCHAR) );
+        return len;
+    }
+
+    len = RtlDosSearchPath_U( load_path, libname, NULL, size, filename, &file_part );
+    if (len >= size) return len;  /* don't bother caching it */
+    if (!watch_load_path( load_path )) return len;
+
+    if (dll_search_count >= DLL_SEARCH_CACHE_MAX)
+    {
+        entry = LIST_ENTRY( list_tail( &dll_search_cache ), struct dll_search_entry, entry );
+        list_remove( &entry->entry );
+        free_dll_search_entry( entry );
+        dll_search_count--;
+    }
+
+    if (!(entry = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*entry) ))) return len;
+    entry->load_path = RtlAllocateHeap( GetProcessHeap(), 0, (strlenW(load_path) + 1) * sizeof(WCHAR) );
+    entry->cur_dir = RtlAllocateHeap( GetProcessHeap(), 0, (strlenW(cur_dir) + 1) * sizeof(WCHAR) );
+    entry->libname = RtlAllocateHeap( GetProcessHeap(), 0, (strlenW(libname) + 1) * sizeof(WCHAR) );
+    if (len) entry->filename = RtlAllocateHeap( GetProcessHeap(), 0, len + sizeof(WCHAR) );
+    if (!entry->load_path || !entry->cur_dir || !entry->libname || (len && !entry->filename))
+    {
+        free_dll_search_entry( entry );
+        return len;
+    }
+    strcpyW( entry->load_path, load_path );
+    strcpyW( entry->cur_dir, cur_dir );
+    strcpyW( entry->libname, libname );
+    if (len) memcpy( entry->filename, filename, len + sizeof(WCHAR) );
+    list_add_head( &dll_search_cache, &entry->entry );
+    dll_search_count++;
+    return len;
+}
+
+
 /***********************************************************************
  *	open_dll_file
  *
@@ -2290,7 +2815,7 @@ static NTSTATUS find_dll_file( const WCHAR *load_path, const WCHAR *libname,
     if (RtlDetermineDosPathNameType_U( libname ) == RELATIVE_PATH)
     {
         /* we need to search for it */
-        len = RtlDosSearchPath_U( load_path, libname, NULL, *size, filename, &file_part );
+        len = search_dll_path( load_path, libname, *size, filename );
         if (len)
         {
             if (len >= *size) goto overflow;
@@ -2360,6 +2885,7 @@ static NTSTATUS load_dll( LPCWSTR load_path, LPCWSTR libname, DWORD flags, WINE_
     struct stat st;
     HANDLE handle;
     NTSTATUS nts;
+    ULONGLONG start, nested, time;
 
     TRACE( "looking for %s in %s\n", debugstr_w(libname), debugstr_w(load_path) );
 
@@ -2397,6 +2923,7 @@ static NTSTATUS load_dll( LPCWSTR load_path, LPCWSTR libname, DWORD flags, WINE_
         handle = 0;
     }
 
+    start = load_time_start( &nested );
     switch(loadorder)
     {
     case LO_INVALID:
@@ -2438,9 +2965,11 @@ static NTSTATUS load_dll( LPCWSTR load_path, LPCWSTR libname, DWORD flags, WINE_
             nts = load_native_dll( load_path, filename, handle, flags, pwm, &st );
         break;
     }
+    time = load_time_end( start, nested );
 
     if (nts == STATUS_SUCCESS)
     {
+        (*pwm)->load_time[LOAD_PHASE_MAP] += time;
         /* Initialize DLL just loaded */
         TRACE("Loaded module %s (%s) at %p\n", debugstr_w(filename),
               ((*pwm)->ldr.Flags & LDR_WINE_INTERNAL) ? "builtin" : "native",
@@ -2870,6 +3399,8 @@ fail:
 void WINAPI LdrShutdownProcess(void)
 {
     TRACE("()\n");
+    __wine_dump_critsection_profile();
+    __wine_dump_heap_stats();
     process_detaching = TRUE;
     process_detach();
 }
@@ -2962,10 +3493,12 @@ static void free_modref( WINE_MODREF *wm )
     free_tls_slot( &wm->ldr );
     RtlReleaseActivationContext( wm->ldr.ActivationContext );
     if (wm->ldr.Flags & LDR_WINE_INTERNAL) wine_dll_unload( wm->ldr.SectionHandle );
+    interlocked_xchg_add( &module_unload_serial, 1 );
     NtUnmapViewOfSection( NtCurrentProcess(), wm->ldr.BaseAddress );
     if (cached_modref == wm) cached_modref = NULL;
     RtlFreeUnicodeString( &wm->ldr.FullDllName );
     RtlFreeHeap( GetProcessHeap(), 0, wm->deps );
+    RtlFreeHeap( GetProcessHeap(), 0, wm->export_hash );
     RtlFreeHeap( GetProcessHeap(), 0, wm );
 }
 
@@ -3103,6 +3636,83 @@ PIMAGE_NT_HEADERS WINAPI RtlImageNtHeader(HMODULE hModule)
 }
 
 
+static int load_time_compare( const void *a, const void *b )
+{
+    const WINE_MODREF *wm1 = *(const WINE_MODREF * const *)a;
+    const WINE_MODREF *wm2 = *(const WINE_MODREF * const *)b;
+    ULONGLONG time1 = 0, time2 = 0;
+    unsigned int i;
+
+    for (i = 0; i < LOAD_PHASE_COUNT; i++)
+    {
+        time1 += wm1->load_time[i];
+        time2 += wm2->load_time[i];
+    }
+    if (time1 == time2) return 0;
+    return time1 < time2 ? 1 : -1;
+}
+
+/* convert a performance counter value to microseconds */
+static inline ULONG load_time_us( ULONGLONG time, ULONGLONG freq )
+{
+    return time * 1000000 / freq;
+}
+
+/***********************************************************************
+ *           dump_load_times
+ *
+ * Print the time spent loading each module, slowest first.
+ * The loader_section must be locked while calling this function.
+ */
+static void dump_load_times(void)
+{
+    PLIST_ENTRY mark, entry;
+    WINE_MODREF **modules, *wm;
+    LARGE_INTEGER counter, freq;
+    ULONGLONG total[LOAD_PHASE_COUNT + 1] = { 0 }, time;
+    unsigned int i, j, count = 0;
+
+    if (!TRACE_ON(loadtime)) return;
+
+    mark = &NtCurrentTeb()->Peb->LdrData->InLoadOrderModuleList;
+    for (entry = mark->Flink; entry != mark; entry = entry->Flink) count++;
+    if (!(modules = RtlAllocateHeap( GetProcessHeap(), 0, count * sizeof(*modules) ))) return;
+
+    count = 0;
+    for (entry = mark->Flink; entry != mark; entry = entry->Flink)
+        modules[count++] = CONTAINING_RECORD( entry, WINE_MODREF, ldr.InLoadOrderModuleList );
+    qsort( modules, count, sizeof(*modules), load_time_compare );
+
+    NtQueryPerformanceCounter( &counter, &freq );
+    TRACE_(loadtime)( "%-32s %10s %10s %10s %10s %10s\n", "module (times in us)",
+                      "load", "reloc", "imports", "init", "total" );
+    for (i = 0; i < count; i++)
+    {
+        wm = modules[i];
+        for (j = 0, time = 0; j < LOAD_PHASE_COUNT; j++)
+        {
+            time += wm->load_time[j];
+            total[j] += wm->load_time[j];
+        }
+        total[LOAD_PHASE_COUNT] += time;
+        TRACE_(loadtime)( "%-32s %10u %10u %10u %10u %10u\n",
+                          debugstr_w(wm->ldr.BaseDllName.Buffer),
+                          load_time_us( wm->load_time[LOAD_PHASE_MAP], freq.QuadPart ),
+                          load_time_us( wm->load_time[LOAD_PHASE_RELOC], freq.QuadPart ),
+                          load_time_us( wm->load_time[LOAD_PHASE_IMPORTS], freq.QuadPart ),
+                          load_time_us( wm->load_time[LOAD_PHASE_INIT], freq.QuadPart ),
+                          load_time_us( time, freq.QuadPart ));
+    }
+    TRACE_(loadtime)( "%-32s %10u %10u %10u %10u %10u\n", "total",
+                      load_time_us( total[LOAD_PHASE_MAP], freq.QuadPart ),
+                      load_time_us( total[LOAD_PHASE_RELOC], freq.QuadPart ),
+                      load_time_us( total[LOAD_PHASE_IMPORTS], freq.QuadPart ),
+                      load_time_us( total[LOAD_PHASE_INIT], freq.QuadPart ),
+                      load_time_us( total[LOAD_PHASE_COUNT], freq.QuadPart ));
+    RtlFreeHeap( GetProcessHeap(), 0, modules );
+}
+
+
 /***********************************************************************
  *           attach_dlls
  *
@@ -3164,6 +3774,7 @@ NTSTATUS attach_dlls( CONTEXT *context, void **entry )
         }
         attach_implicitly_loaded_dlls( context );
         virtual_release_address_space();
+        dump_load_times();
     }
     else
     {
@@ -359,37 +359,6 @@ HANDLE WINAPI WinSqmStartSession(GUID *sessionguid, DWORD sessionid, DWORD unkno
     return INVALID_HANDLE_VALUE;
 }
 
-/******************************************************************************
- *                  EtwEventRegister (NTDLL.@)
- */
-ULONG WINAPI EtwEventRegister( LPCGUID provider, PENABLECALLBACK callback, PVOID context,
-                PREGHANDLE handle )
-{
-    FIXME("(%s, %p, %p, %p) stub.\n", debugstr_guid(provider), callback, context, handle);
-
-    *handle = 0xdeadbeef;
-    return ERROR_SUCCESS;
-}
-
-/******************************************************************************
- *                  EtwEventUnregister (NTDLL.@)
- */
-ULONG WINAPI EtwEventUnregister( REGHANDLE handle )
-{
-    FIXME("(%s) stub.\n", wine_dbgstr_longlong(handle));
-    return ERROR_SUCCESS;
-}
-
-/*********************************************************************
- *                  EtwEventSetInformation   (NTDLL.@)
- */
-ULONG WINAPI EtwEventSetInformation( REGHANDLE handle, EVENT_INFO_CLASS class, void *info,
-                                     ULONG length )
-{
-    FIXME("(%s, %u, %p, %u) stub\n", wine_dbgstr_longlong(handle), class, info, length);
-    return ERROR_SUCCESS;
-}
-
 /******************************************************************************
  *                  EtwRegisterTraceGuidsW (NTDLL.@)
  *
@@ -458,25 +427,6 @@ ULONG WINAPI EtwUnregisterTraceGuids( TRACEHANDLE RegistrationHandle )
     return ERROR_SUCCESS;
 }
 
-/******************************************************************************
- *                  EtwEventEnabled (NTDLL.@)
- */
-BOOLEAN WINAPI EtwEventEnabled( REGHANDLE handle, const EVENT_DESCRIPTOR *descriptor )
-{
-    FIXME("(%s, %p): stub\n", wine_dbgstr_longlong(handle), descriptor);
-    return FALSE;
-}
-
-/******************************************************************************
- *                  EtwEventWrite (NTDLL.@)
- */
-ULONG WINAPI EtwEventWrite( REGHANDLE handle, const EVENT_DESCRIPTOR *descriptor, ULONG count,
-    EVENT_DATA_DESCRIPTOR *data )
-{
-    FIXME("(%s, %p, %u, %p): stub\n", wine_dbgstr_longlong(handle), descriptor, count, data);
-    return ERROR_SUCCESS;
-}
-
 /***********************************************************************
  *		    DbgUiRemoteBreakin (NTDLL.@)
  */
@@ -1517,6 +1517,25 @@ static inline BOOL logical_proc_info_add_group(SYSTEM_LOGICAL_PROCESSOR_INFORMAT
 }
 
 #ifdef linux
+/* read a sysfs cpu mask, which is made of comma-separated 32-bit hex words */
+static BOOL sysfs_read_cpu_mask(const char *name, ULONG_PTR *mask)
+{
+    FILE *f;
+    DWORD r;
+    char op;
+
+    if (!(f = fopen(name, "r"))) return FALSE;
+    *mask = 0;
+    while (!feof(f))
+    {
+        if (fscanf(f, "%x%c ", &r, &op) < 1)
+            break;
+        *mask = (sizeof(ULONG_PTR)>sizeof(int) ? *mask<<(8*sizeof(DWORD)) : 0) + r;
+    }
+    fclose(f);
+    return TRUE;
+}
+
 /* for 'data', max_len is the array count. for 'dataex', max_len is in bytes */
 static NTSTATUS create_logical_proc_info(SYSTEM_LOGICAL_PROCESSOR_INFORMATION **data,
         SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX **dataex, DWORD *max_len)
@@ -1546,7 +1565,7 @@ static NTSTATUS create_logical_proc_info(SYSTEM_LOGICAL_PROCESSOR_INFORMATION **
             DWORD phys_core = 0;
             ULONG_PTR thread_mask = 0;
 
-            if(i > 8*sizeof(ULONG_PTR))
+            if(i >= 8*sizeof(ULONG_PTR))
             {
                 FIXME("skipping logical processor %d\n", i);
                 continue;
@@ -1587,13 +1606,8 @@ static NTSTATUS create_logical_proc_info(SYSTEM_LOGICAL_PROCESSOR_INFORMATION **
 
             /* Mask of logical threads sharing same physical core in kernel core numbering. */
             sprintf(name, core_info, i, "thread_siblings");
-            f = fopen(name, "r");
-            if(f)
-            {
-                fscanf(f, "%lx", &thread_mask);
-                fclose(f);
-            }
-            else thread_mask = 1<<i;
+            if(!sysfs_read_cpu_mask(name, &thread_mask))
+                thread_mask = (ULONG_PTR)1 << i;
             if(!logical_proc_info_add_by_id(data, dataex, &len, max_len, RelationProcessorCore, phys_core, thread_mask))
             {
                 fclose(fcpu_list);
@@ -1606,15 +1620,7 @@ static NTSTATUS create_logical_proc_info(SYSTEM_LOGICAL_PROCESSOR_INFORMATION **
                 ULONG_PTR mask = 0;
 
                 sprintf(name, cache_info, i, j, "shared_cpu_map");
-                f = fopen(name, "r");
-                if(!f) continue;
-                while(!feof(f))
-                {
-                    if(!fscanf(f, "%x%c ", &r, &op))
-                        break;
-                    mask = (sizeof(ULONG_PTR)>sizeof(int) ? mask<<(8*sizeof(DWORD)) : 0) + r;
-                }
-                fclose(f);
+                if(!sysfs_read_cpu_mask(name, &mask)) continue;
 
                 sprintf(name, cache_info, i, j, "level");
                 f = fopen(name, "r");
@@ -1642,9 +1648,15 @@ static NTSTATUS create_logical_proc_info(SYSTEM_LOGICAL_PROCESSOR_INFORMATION **
                 if(!f) continue;
                 fscanf(f, "%u%c", &r, &op);
                 fclose(f);
-                if(op != 'K')
+                if(op == 'K')
+                    cache.Size = r * 1024;
+                else if(op == 'M')
+                    cache.Size = r * 1024 * 1024;
+                else
+                {
                     WARN("unknown cache size %u%c\n", r, op);
-                cache.Size = (op=='K' ? r*1024 : r);
+                    cache.Size = r;
+                }
 
                 sprintf(name, cache_info, i, j, "type");
                 f = fopen(name, "r");
@@ -1705,15 +1717,7 @@ static NTSTATUS create_logical_proc_info(SYSTEM_LOGICAL_PROCESSOR_INFORMATION **
                 ULONG_PTR mask = 0;
 
                 sprintf(name, numa_info, i);
-                f = fopen(name, "r");
-                if(!f) continue;
-                while(!feof(f))
-                {
-                    if(!fscanf(f, "%x%c ", &r, &op))
-                        break;
-                    mask = (sizeof(ULONG_PTR)>sizeof(int) ? mask<<(8*sizeof(DWORD)) : 0) + r;
-                }
-                fclose(f);
+                if(!sysfs_read_cpu_mask(name, &mask)) continue;
 
                 if(!logical_proc_info_add_numa_node(data, dataex, &len, max_len, mask, i))
                 {
@@ -1994,125 +1998,99 @@ NTSTATUS WINAPI NtQuerySystemInformation(
         break;
     case SystemProcessInformation:
         {
-            SYSTEM_PROCESS_INFORMATION* spi = SystemInformation;
-            SYSTEM_PROCESS_INFORMATION* last = NULL;
-            HANDLE hSnap = 0;
-            WCHAR procname[1024];
-            WCHAR* exename;
-            DWORD wlen = 0;
-            DWORD procstructlen = 0;
-
-            SERVER_START_REQ( create_snapshot )
-            {
-                req->flags      = SNAP_PROCESS | SNAP_THREAD;
-                req->attributes = 0;
-                if (!(ret = wine_server_call( req )))
-                    hSnap = wine_server_ptr_handle( reply->handle );
-            }
-            SERVER_END_REQ;
-            len = 0;
-            while (ret == STATUS_SUCCESS)
+            SYSTEM_PROCESS_INFORMATION *spi = SystemInformation, *last = NULL;
+            data_size_t info_size = 0x10000, pos = 0;
+            unsigned int process_count = 0, i, j;
+            const WCHAR *exename;
+            char *buffer = NULL;
+            DWORD wlen, procstructlen;
+
+            /* retrieve all the processes at once, retrying if the buffer is too small */
+            for (;;)
             {
-                SERVER_START_REQ( next_process )
+                if (!(buffer = RtlAllocateHeap( GetProcessHeap(), 0, info_size )))
                 {
-                    req->handle = wine_server_obj_handle( hSnap );
-                    req->reset = (len == 0);
-                    wine_server_set_reply( req, procname, sizeof(procname)-sizeof(WCHAR) );
-                    if (!(ret = wine_server_call( req )))
-                    {
-                        /* Make sure procname is 0 terminated */
-                        procname[wine_server_reply_size(reply) / sizeof(WCHAR)] = 0;
-
-                        /* Get only the executable name, not the path */
-                        if ((exename = strrchrW(procname, '\\')) != NULL) exename++;
-                        else exename = procname;
-
-                        wlen = (strlenW(exename) + 1) * sizeof(WCHAR);
-
-                        procstructlen = sizeof(*spi) + wlen + ((reply->threads - 1) * sizeof(SYSTEM_THREAD_INFORMATION));
-
-                        if (Length >= len + procstructlen)
-                        {
-                            /* ftCreationTime, ftUserTime, ftKernelTime;
-                             * vmCounters, ioCounters
-                             */
- 
-                            memset(spi, 0, sizeof(*spi));
-
-                            spi->NextEntryOffset = procstructlen - wlen;
-                            spi->dwThreadCount = reply->threads;
-
-                            /* spi->pszProcessName will be set later on */
-
-                            spi->dwBasePriority = reply->priority;
-                            spi->UniqueProcessId = UlongToHandle(reply->pid);
-                            spi->ParentProcessId = UlongToHandle(reply->ppid);
-                            spi->HandleCount = reply->handles;
-
-                            /* spi->ti will be set later on */
-
-                        }
-                        len += procstructlen;
-                    }
+                    ret = STATUS_NO_MEMORY;
+                    break;
                 }
-                SERVER_END_REQ;
- 
-                if (ret != STATUS_SUCCESS)
+                SERVER_START_REQ( list_processes )
                 {
-                    if (ret == STATUS_NO_MORE_FILES) ret = STATUS_SUCCESS;
-                    break;
+                    wine_server_set_reply( req, buffer, info_size );
+                    ret = wine_server_call( req );
+                    info_size = reply->info_size;
+                    process_count = reply->process_count;
                 }
+                SERVER_END_REQ;
+                if (ret != STATUS_INFO_LENGTH_MISMATCH) break;
+                RtlFreeHeap( GetProcessHeap(), 0, buffer );
+                buffer = NULL;
+            }
 
-                if (Length >= len)
+            len = 0;
+            for (i = 0; !ret && i < process_count; i++)
+            {
+                const process_info_t *info = (const process_info_t *)(buffer + pos);
+                const thread_info_t *thread_info;
+                const WCHAR *name = (const WCHAR *)(buffer + pos + sizeof(*info));
+                data_size_t name_len = info->name_len / sizeof(WCHAR);
+
+                pos += sizeof(*info) + ((info->name_len + 7) & ~7);
+                thread_info = (const thread_info_t *)(buffer + pos);
+                pos += info->thread_count * sizeof(*thread_info);
+                if (!info->thread_count) continue;
+
+                /* Get only the executable name, not the path */
+                for (exename = name + name_len; exename > name; exename--)
+                    if (exename[-1] == '\\') break;
+                wlen = (name + name_len - exename + 1) * sizeof(WCHAR);
+
+                procstructlen = sizeof(*spi) + wlen + ((info->thread_count - 1) * sizeof(SYSTEM_THREAD_INFORMATION));
+                len += procstructlen;
+                if (Length < len) continue;
+
+                memset(spi, 0, sizeof(*spi));
+
+                spi->NextEntryOffset = procstructlen - wlen;
+                spi->dwThreadCount = info->thread_count;
+                spi->CreationTime.QuadPart = info->start_time;
+                spi->UserTime.QuadPart = info->user_time;
+                spi->KernelTime.QuadPart = info->kernel_time;
+                spi->dwBasePriority = info->priority;
+                spi->UniqueProcessId = UlongToHandle(info->pid);
+                spi->ParentProcessId = UlongToHandle(info->parent_pid);
+                spi->HandleCount = info->handle_count;
+                spi->vmCounters.PeakVirtualSize = info->peak_virtual_size;
+                spi->vmCounters.VirtualSize = info->virtual_size;
+                spi->vmCounters.PeakWorkingSetSize = info->peak_working_set_size;
+                spi->vmCounters.WorkingSetSize = info->working_set_size;
+                spi->vmCounters.PagefileUsage = info->pagefile_usage;
+                spi->vmCounters.PeakPagefileUsage = info->pagefile_usage;
+                spi->vmCounters.PrivatePageCount = info->pagefile_usage;
+
+                for (j = 0; j < info->thread_count; j++)
                 {
-                    int     i, j;
-
-                    /* set thread info */
-                    i = j = 0;
-                    while (ret == STATUS_SUCCESS)
-                    {
-                        SERVER_START_REQ( next_thread )
-                        {
-                            req->handle = wine_server_obj_handle( hSnap );
-                            req->reset = (j == 0);
-                            if (!(ret = wine_server_call( req )))
-                            {
-                                j++;
-                                if (UlongToHandle(reply->pid) == spi->UniqueProcessId)
-                                {
-                                    /* ftKernelTime, ftUserTime, ftCreateTime;
-                                     * dwTickCount, dwStartAddress
-                                     */
-
-                                    memset(&spi->ti[i], 0, sizeof(spi->ti));
-
-                                    spi->ti[i].CreateTime.QuadPart = 0xdeadbeef;
-                                    spi->ti[i].ClientId.UniqueProcess = UlongToHandle(reply->pid);
-                                    spi->ti[i].ClientId.UniqueThread  = UlongToHandle(reply->tid);
-                                    spi->ti[i].dwCurrentPriority = reply->base_pri + reply->delta_pri;
-                                    spi->ti[i].dwBasePriority = reply->base_pri;
-                                    i++;
-                                }
-                            }
-                        }
-                        SERVER_END_REQ;
-                    }
-                    if (ret == STATUS_NO_MORE_FILES) ret = STATUS_SUCCESS;
+                    memset(&spi->ti[j], 0, sizeof(spi->ti[j]));
+                    spi->ti[j].CreateTime.QuadPart = thread_info[j].start_time;
+                    spi->ti[j].ClientId.UniqueProcess = UlongToHandle(info->pid);
+                    spi->ti[j].ClientId.UniqueThread  = UlongToHandle(thread_info[j].tid);
+                    spi->ti[j].dwCurrentPriority = thread_info[j].current_priority;
+                    spi->ti[j].dwBasePriority = thread_info[j].base_priority;
+                }
 
-                    /* now append process name */
-                    spi->ProcessName.Buffer = (WCHAR*)((char*)spi + spi->NextEntryOffset);
-                    spi->ProcessName.Length = wlen - sizeof(WCHAR);
-                    spi->ProcessName.MaximumLength = wlen;
-                    memcpy( spi->ProcessName.Buffer, exename, wlen );
-                    spi->NextEntryOffset += wlen;
+                /* now append process name */
+                spi->ProcessName.Buffer = (WCHAR*)((char*)spi + spi->NextEntryOffset);
+                spi->ProcessName.Length = wlen - sizeof(WCHAR);
+                spi->ProcessName.MaximumLength = wlen;
+                memcpy( spi->ProcessName.Buffer, exename, wlen - sizeof(WCHAR) );
+                spi->ProcessName.Buffer[wlen / sizeof(WCHAR) - 1] = 0;
+                spi->NextEntryOffset += wlen;
 
-                    last = spi;
-                    spi = (SYSTEM_PROCESS_INFORMATION*)((char*)spi + spi->NextEntryOffset);
-                }
+                last = spi;
+                spi = (SYSTEM_PROCESS_INFORMATION*)((char*)spi + spi->NextEntryOffset);
             }
             if (ret == STATUS_SUCCESS && last) last->NextEntryOffset = 0;
-            if (len > Length) ret = STATUS_INFO_LENGTH_MISMATCH;
-            if (hSnap) NtClose(hSnap);
+            if (!ret && len > Length) ret = STATUS_INFO_LENGTH_MISMATCH;
+            RtlFreeHeap( GetProcessHeap(), 0, buffer );
         }
         break;
     case SystemProcessorPerformanceInformation:
@@ -2405,6 +2383,24 @@ NTSTATUS WINAPI NtQuerySystemInformation(
     return ret;
 }
 
+/* only keep the entries of the requested relationship, returns the new length */
+static DWORD filter_logical_proc_info_ex(SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *data, DWORD len,
+        LOGICAL_PROCESSOR_RELATIONSHIP rel)
+{
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *info;
+    DWORD ofs, size, new_len = 0;
+
+    for (ofs = 0; ofs < len; ofs += size)
+    {
+        info = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *)((char *)data + ofs);
+        size = info->Size;
+        if (info->Relationship != rel) continue;
+        if (new_len != ofs) memmove((char *)data + new_len, info, size);
+        new_len += size;
+    }
+    return new_len;
+}
+
 /******************************************************************************
  * NtQuerySystemInformationEx [NTDLL.@]
  * ZwQuerySystemInformationEx [NTDLL.@]
@@ -2429,9 +2425,6 @@ NTSTATUS WINAPI NtQuerySystemInformationEx(SYSTEM_INFORMATION_CLASS SystemInform
                 break;
             }
 
-            if (*(DWORD*)Query != RelationAll)
-                FIXME("Relationship filtering not implemented: 0x%x\n", *(DWORD*)Query);
-
             len = 3 * sizeof(*buf);
             buf = RtlAllocateHeap(GetProcessHeap(), 0, len);
             if (!buf)
@@ -2446,6 +2439,8 @@ NTSTATUS WINAPI NtQuerySystemInformationEx(SYSTEM_INFORMATION_CLASS SystemInform
                 RtlFreeHeap(GetProcessHeap(), 0, buf);
                 break;
             }
+            if (*(DWORD *)Query != RelationAll)
+                len = filter_logical_proc_info_ex(buf, len, *(DWORD *)Query);
 
             if (Length >= len)
             {
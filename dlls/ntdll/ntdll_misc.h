@@ -46,6 +46,10 @@ struct drive_info
 };
 
 extern NTSTATUS close_handle( HANDLE ) DECLSPEC_HIDDEN;
+extern void invalidate_cached_values( HANDLE handle ) DECLSPEC_HIDDEN;
+extern void update_private_keyed_event( HANDLE handle, HANDLE dup, BOOL closed, BOOL self ) DECLSPEC_HIDDEN;
+extern void CDECL __wine_dump_critsection_profile(void);
+extern void CDECL __wine_dump_heap_stats(void);
 extern ULONG_PTR get_system_affinity_mask(void) DECLSPEC_HIDDEN;
 
 /* exceptions */
@@ -73,12 +77,15 @@ extern void DECLSPEC_NORETURN signal_exit_thread( int status ) DECLSPEC_HIDDEN;
 extern void DECLSPEC_NORETURN signal_exit_process( int status ) DECLSPEC_HIDDEN;
 extern void version_init( const WCHAR *appname ) DECLSPEC_HIDDEN;
 extern void debug_init(void) DECLSPEC_HIDDEN;
+extern void debug_thread_detach(void) DECLSPEC_HIDDEN;
 extern HANDLE thread_init(void) DECLSPEC_HIDDEN;
 extern void actctx_init(void) DECLSPEC_HIDDEN;
 extern void virtual_init(void) DECLSPEC_HIDDEN;
 extern void virtual_init_threading(void) DECLSPEC_HIDDEN;
 extern void fill_cpu_info(void) DECLSPEC_HIDDEN;
+extern void init_shared_time(void) DECLSPEC_HIDDEN;
 extern void heap_set_debug_flags( HANDLE handle ) DECLSPEC_HIDDEN;
+extern void heap_thread_detach(void) DECLSPEC_HIDDEN;
 
 /* server support */
 extern timeout_t server_start_time DECLSPEC_HIDDEN;
@@ -97,9 +104,12 @@ extern unsigned int server_select( const select_op_t *select_op, data_size_t siz
                                    UINT flags, const LARGE_INTEGER *timeout ) DECLSPEC_HIDDEN;
 extern unsigned int server_queue_process_apc( HANDLE process, const apc_call_t *call, apc_result_t *result ) DECLSPEC_HIDDEN;
 extern int server_remove_fd_from_cache( HANDLE handle ) DECLSPEC_HIDDEN;
+extern NTSTATUS server_set_completion_mode( HANDLE handle, unsigned int add_flags,
+                                            unsigned int *flags ) DECLSPEC_HIDDEN;
 extern int server_get_unix_fd( HANDLE handle, unsigned int access, int *unix_fd,
                                int *needs_close, enum server_fd_type *type, unsigned int *options ) DECLSPEC_HIDDEN;
 extern int receive_fd( obj_handle_t *handle ) DECLSPEC_HIDDEN;
+extern RTL_CRITICAL_SECTION fd_cache_section;
 extern int server_pipe( int fd[2] ) DECLSPEC_HIDDEN;
 extern NTSTATUS alloc_object_attributes( const OBJECT_ATTRIBUTES *attr, struct object_attributes **ret,
                                          data_size_t *ret_len ) DECLSPEC_HIDDEN;
@@ -107,12 +117,15 @@ extern NTSTATUS validate_open_object_attributes( const OBJECT_ATTRIBUTES *attr )
 
 /* module handling */
 extern LIST_ENTRY tls_links DECLSPEC_HIDDEN;
+extern LONG module_unload_serial DECLSPEC_HIDDEN;
 extern NTSTATUS attach_dlls( CONTEXT *context, void **entry ) DECLSPEC_HIDDEN;
 extern FARPROC RELAY_GetProcAddress( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
                                      DWORD exp_size, FARPROC proc, DWORD ordinal, const WCHAR *user ) DECLSPEC_HIDDEN;
 extern FARPROC SNOOP_GetProcAddress( HMODULE hmod, const IMAGE_EXPORT_DIRECTORY *exports, DWORD exp_size,
                                      FARPROC origfun, DWORD ordinal, const WCHAR *user ) DECLSPEC_HIDDEN;
 extern void RELAY_SetupDLL( HMODULE hmod ) DECLSPEC_HIDDEN;
+extern BOOL RELAY_LogEnabled(void) DECLSPEC_HIDDEN;
+extern void relay_thread_detach(void) DECLSPEC_HIDDEN;
 extern void SNOOP_SetupDLL( HMODULE hmod ) DECLSPEC_HIDDEN;
 extern const WCHAR system_dir[] DECLSPEC_HIDDEN;
 
@@ -164,12 +177,15 @@ extern unsigned int DIR_get_drives_info( struct drive_info info[MAX_DOS_DRIVES]
 extern NTSTATUS file_id_to_unix_file_name( const OBJECT_ATTRIBUTES *attr, ANSI_STRING *unix_name_ret ) DECLSPEC_HIDDEN;
 extern NTSTATUS nt_to_unix_file_name_attr( const OBJECT_ATTRIBUTES *attr, ANSI_STRING *unix_name_ret,
                                            UINT disposition ) DECLSPEC_HIDDEN;
+extern LONG dll_search_serial DECLSPEC_HIDDEN;
 
 /* virtual memory */
 extern NTSTATUS virtual_map_section( HANDLE handle, PVOID *addr_ptr, ULONG zero_bits, SIZE_T commit_size,
                                      const LARGE_INTEGER *offset_ptr, SIZE_T *size_ptr, ULONG protect,
                                      pe_image_info_t *image_info ) DECLSPEC_HIDDEN;
 extern void virtual_get_system_info( SYSTEM_BASIC_INFORMATION *info ) DECLSPEC_HIDDEN;
+extern NTSTATUS virtual_alloc_node( HANDLE process, PVOID *ret, ULONG zero_bits, SIZE_T *size_ptr,
+                                    ULONG type, ULONG protect, ULONG node ) DECLSPEC_HIDDEN;
 extern NTSTATUS virtual_create_builtin_view( void *base ) DECLSPEC_HIDDEN;
 extern NTSTATUS virtual_alloc_thread_stack( TEB *teb, SIZE_T reserve_size,
                                             SIZE_T commit_size, SIZE_T *pthread_size ) DECLSPEC_HIDDEN;
@@ -191,7 +207,17 @@ extern struct _KUSER_SHARED_DATA *user_shared_data DECLSPEC_HIDDEN;
 
 /* completion */
 extern NTSTATUS NTDLL_AddCompletion( HANDLE hFile, ULONG_PTR CompletionValue,
-                                     NTSTATUS CompletionStatus, ULONG Information ) DECLSPEC_HIDDEN;
+                                     NTSTATUS CompletionStatus, ULONG Information, BOOL async ) DECLSPEC_HIDDEN;
+extern NTSTATUS iouring_read( int fd, HANDLE file, HANDLE event, IO_STATUS_BLOCK *io, void *buffer,
+                              ULONG length, ULONGLONG offset, ULONG_PTR cvalue ) DECLSPEC_HIDDEN;
+extern NTSTATUS iouring_write( int fd, HANDLE file, HANDLE event, IO_STATUS_BLOCK *io, const void *buffer,
+                               ULONG length, ULONGLONG offset, ULONG_PTR cvalue ) DECLSPEC_HIDDEN;
+extern NTSTATUS iouring_read_scatter( int fd, HANDLE file, HANDLE event, IO_STATUS_BLOCK *io,
+                                      FILE_SEGMENT_ELEMENT *segments, ULONG length, ULONGLONG offset,
+                                      ULONG_PTR cvalue ) DECLSPEC_HIDDEN;
+extern NTSTATUS iouring_write_gather( int fd, HANDLE file, HANDLE event, IO_STATUS_BLOCK *io,
+                                      FILE_SEGMENT_ELEMENT *segments, ULONG length, ULONGLONG offset,
+                                      ULONG_PTR cvalue ) DECLSPEC_HIDDEN;
 
 /* code pages */
 extern int ntdll_umbstowcs(DWORD flags, const char* src, int srclen, WCHAR* dst, int dstlen) DECLSPEC_HIDDEN;
@@ -225,6 +251,20 @@ struct debug_info
 };
 
 /* thread private data, stored in NtCurrentTeb()->GdiTebBatch */
+#ifdef __x86_64__
+#define UNWIND_CACHE_SIZE 16
+
+/* recently looked up function table entries, see lookup_function_info */
+struct unwind_cache_entry
+{
+    ULONG64           pc;
+    ULONG64           base;
+    RUNTIME_FUNCTION *func;
+    LDR_MODULE       *module;
+    LONG              serial;      /* value of module_unload_serial when cached */
+};
+#endif
+
 struct ntdll_thread_data
 {
     struct debug_info *debug_info;    /* info for debugstr functions */
@@ -236,6 +276,15 @@ struct ntdll_thread_data
     pthread_t          pthread_id;    /* pthread thread id */
     int                esync_queue_fd;/* fd to wait on for driver events */
     int                esync_apc_fd;  /* fd to wait on for user APCs */
+    struct esync_epoll *esync_epoll;  /* epoll set of the last large esync wait */
+    int                timer_slack_generation; /* timer resolution the slack was set for */
+    struct lfh_thread_data *heap_lfh; /* per-thread low-fragmentation heap caches */
+    int                virtual_shared; /* nesting level of the shared virtual memory lock */
+    struct relay_log_header *relay_log; /* binary relay log ring buffer */
+    struct debug_ring *debug_ring;    /* ring buffer for asynchronous debug output */
+#ifdef __x86_64__
+    struct unwind_cache_entry unwind_cache[UNWIND_CACHE_SIZE]; /* per-thread function table lookup cache */
+#endif
 };
 
 C_ASSERT( sizeof(struct ntdll_thread_data) <= sizeof(((TEB *)0)->GdiTebBatch) );
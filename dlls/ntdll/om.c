@@ -372,7 +372,11 @@ NTSTATUS WINAPI NtDuplicateObject( HANDLE source_process, HANDLE source,
             {
                 int fd = server_remove_fd_from_cache( source );
                 if (fd != -1) close( fd );
+                invalidate_cached_values( source );
             }
+            if (reply->self)
+                update_private_keyed_event( source, wine_server_ptr_handle( reply->handle ), reply->closed,
+                                            dest_process == NtCurrentProcess() );
         }
     }
     SERVER_END_REQ;
@@ -391,6 +395,9 @@ NTSTATUS close_handle( HANDLE handle )
     NTSTATUS ret;
     int fd = server_remove_fd_from_cache( handle );
 
+    invalidate_cached_values( handle );
+    update_private_keyed_event( handle, 0, TRUE, TRUE );
+
     if (do_esync())
         esync_close( handle );
 
@@ -32,6 +32,10 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
+#include <unistd.h>
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -523,6 +527,138 @@ NTSTATUS WINAPI NtEnumerateValueKey( HANDLE handle, ULONG index,
 }
 
 
+/* Small cache of recently queried values, indexed by handle and name.  An entry
+ * is only valid as long as the generation counter it was stored with still
+ * matches; the counter shared by the server is incremented on every registry
+ * change, and the local one on every close of a handle of the same bucket. */
+
+#define VALUE_CACHE_SIZE     64
+#define VALUE_CACHE_MAX_NAME 64    /* max. length of a cached value name in WCHARs */
+#define VALUE_CACHE_MAX_DATA 256   /* max. size of cached value data in bytes */
+
+struct cached_value
+{
+    HANDLE       key;        /* key handle */
+    unsigned int generation; /* generation when the value was retrieved */
+    int          type;       /* value type, -1 if the value doesn't exist */
+    DWORD        total;      /* size of the value data */
+    USHORT       name_len;   /* length of the value name in bytes */
+    WCHAR        name[VALUE_CACHE_MAX_NAME];
+    BYTE         data[VALUE_CACHE_MAX_DATA];
+};
+
+static struct cached_value value_cache[VALUE_CACHE_SIZE];
+static int handle_generation[VALUE_CACHE_SIZE];
+static const volatile unsigned int *registry_generation;
+static BOOL registry_generation_failed;
+
+static RTL_CRITICAL_SECTION value_cache_section;
+static RTL_CRITICAL_SECTION_DEBUG value_cache_debug =
+{
+    0, 0, &value_cache_section,
+    { &value_cache_debug.ProcessLocksList, &value_cache_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": value_cache_section") }
+};
+static RTL_CRITICAL_SECTION value_cache_section = { &value_cache_debug, -1, 0, 0, 0, 0 };
+
+static inline unsigned int handle_bucket( HANDLE handle )
+{
+    return ((ULONG_PTR)handle >> 2) % VALUE_CACHE_SIZE;
+}
+
+static inline unsigned int value_bucket( HANDLE handle, const UNICODE_STRING *name )
+{
+    unsigned int i, hash = (ULONG_PTR)handle >> 2;
+
+    for (i = 0; i < name->Length / sizeof(WCHAR); i++) hash = hash * 31 + name->Buffer[i];
+    return hash % VALUE_CACHE_SIZE;
+}
+
+/* map the generation counter shared by the server, return FALSE if not available */
+static BOOL map_registry_generation(void)
+{
+    obj_handle_t fd_handle;
+    sigset_t sigset;
+    void *ptr;
+    int fd = -1;
+
+    if (registry_generation) return TRUE;
+    if (registry_generation_failed) return FALSE;
+
+    server_enter_uninterrupted_section( &fd_cache_section, &sigset );
+    if (!registry_generation && !registry_generation_failed)
+    {
+        SERVER_START_REQ( get_registry_generation )
+        {
+            if (!wine_server_call( req )) fd = receive_fd( &fd_handle );
+        }
+        SERVER_END_REQ;
+
+        if (fd != -1)
+        {
+            ptr = mmap( NULL, sizeof(*registry_generation), PROT_READ, MAP_SHARED, fd, 0 );
+            close( fd );
+            if (ptr != MAP_FAILED) registry_generation = ptr;
+        }
+        if (!registry_generation)
+        {
+            WARN( "registry value cache disabled\n" );
+            registry_generation_failed = TRUE;
+        }
+    }
+    server_leave_uninterrupted_section( &fd_cache_section, &sigset );
+    return registry_generation != NULL;
+}
+
+static inline unsigned int get_generation( HANDLE handle )
+{
+    return *registry_generation + handle_generation[handle_bucket( handle )];
+}
+
+/* invalidate the cached values of a handle that is being closed */
+void invalidate_cached_values( HANDLE handle )
+{
+    interlocked_xchg_add( &handle_generation[handle_bucket( handle )], 1 );
+}
+
+/* retrieve a value from the cache, return FALSE if not found */
+static BOOL get_cached_value( HANDLE handle, const UNICODE_STRING *name, unsigned int generation,
+                              int *type, void *data, DWORD size, DWORD *total )
+{
+    struct cached_value *value = &value_cache[value_bucket( handle, name )];
+    BOOL ret = FALSE;
+
+    RtlEnterCriticalSection( &value_cache_section );
+    if (value->key == handle && value->generation == generation &&
+        value->name_len == name->Length && !memcmp( value->name, name->Buffer, name->Length ))
+    {
+        *type  = value->type;
+        *total = value->total;
+        if (data) memcpy( data, value->data, min( size, value->total ));
+        ret = TRUE;
+    }
+    RtlLeaveCriticalSection( &value_cache_section );
+    return ret;
+}
+
+/* store a value retrieved from the server, type is -1 if it doesn't exist */
+static void add_cached_value( HANDLE handle, const UNICODE_STRING *name, unsigned int generation,
+                              int type, const void *data, DWORD total )
+{
+    struct cached_value *value = &value_cache[value_bucket( handle, name )];
+
+    RtlEnterCriticalSection( &value_cache_section );
+    value->key        = handle;
+    value->generation = generation;
+    value->type       = type;
+    value->total      = total;
+    value->name_len   = name->Length;
+    memcpy( value->name, name->Buffer, name->Length );
+    memcpy( value->data, data, total );
+    RtlLeaveCriticalSection( &value_cache_section );
+}
+
+
 /******************************************************************************
  * NtQueryValueKey [NTDLL.@]
  * ZwQueryValueKey [NTDLL.@]
@@ -534,9 +670,12 @@ NTSTATUS WINAPI NtQueryValueKey( HANDLE handle, const UNICODE_STRING *name,
                                  KEY_VALUE_INFORMATION_CLASS info_class,
                                  void *info, DWORD length, DWORD *result_len )
 {
-    NTSTATUS ret;
+    NTSTATUS ret = STATUS_SUCCESS;
     UCHAR *data_ptr;
-    unsigned int fixed_size, min_size;
+    unsigned int fixed_size, min_size, data_size, generation = 0;
+    DWORD total;
+    BOOL use_cache = FALSE;
+    int type;
 
     TRACE( "(%p,%s,%d,%p,%d)\n", handle, debugstr_us(name), info_class, info, length );
 
@@ -573,22 +712,44 @@ NTSTATUS WINAPI NtQueryValueKey( HANDLE handle, const UNICODE_STRING *name,
         FIXME( "Information class %d not implemented\n", info_class );
         return STATUS_INVALID_PARAMETER;
     }
+    data_size = (length > fixed_size && data_ptr) ? length - fixed_size : 0;
+
+    if (name->Length <= sizeof(value_cache[0].name) && map_registry_generation())
+    {
+        generation = get_generation( handle );
+        if (get_cached_value( handle, name, generation, &type, data_ptr, data_size, &total ))
+        {
+            if (type == -1) return STATUS_OBJECT_NAME_NOT_FOUND;
+            goto done;
+        }
+        use_cache = TRUE;
+    }
 
     SERVER_START_REQ( get_key_value )
     {
         req->hkey = wine_server_obj_handle( handle );
         wine_server_add_data( req, name->Buffer, name->Length );
-        if (length > fixed_size && data_ptr) wine_server_set_reply( req, data_ptr, length - fixed_size );
-        if (!(ret = wine_server_call( req )))
-        {
-            copy_key_value_info( info_class, info, length, reply->type,
-                                 name->Length, reply->total );
-            *result_len = fixed_size + (info_class == KeyValueBasicInformation ? 0 : reply->total);
-            if (length < min_size) ret = STATUS_BUFFER_TOO_SMALL;
-            else if (length < *result_len) ret = STATUS_BUFFER_OVERFLOW;
-        }
+        if (data_size) wine_server_set_reply( req, data_ptr, data_size );
+        ret = wine_server_call( req );
+        type = reply->type;
+        total = reply->total;
     }
     SERVER_END_REQ;
+
+    if (use_cache)
+    {
+        if (ret == STATUS_OBJECT_NAME_NOT_FOUND)
+            add_cached_value( handle, name, generation, -1, NULL, 0 );
+        else if (!ret && total <= data_size && total <= sizeof(value_cache[0].data))
+            add_cached_value( handle, name, generation, type, data_ptr, total );
+    }
+    if (ret) return ret;
+
+done:
+    copy_key_value_info( info_class, info, length, type, name->Length, total );
+    *result_len = fixed_size + (info_class == KeyValueBasicInformation ? 0 : total);
+    if (length < min_size) ret = STATUS_BUFFER_TOO_SMALL;
+    else if (length < *result_len) ret = STATUS_BUFFER_OVERFLOW;
     return ret;
 }
 
@@ -26,6 +26,14 @@
 #include <string.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -66,6 +74,7 @@ struct relay_private_data
     HMODULE                  module;            /* module handle of this dll */
     unsigned int             base;              /* ordinal base */
     char                     dllname[40];       /* dll name (without .dll extension) */
+    unsigned int             log_index;         /* module index in the binary relay log */
     struct relay_entry_point entry_points[1];   /* list of dll entry points */
 };
 
@@ -322,6 +331,207 @@ static void trace_string_w( INT_PTR ptr )
     else TRACE( "%08lx", ptr );
 }
 
+/* binary relay log, enabled with WINERELAYLOG=<file prefix>
+ *
+ * Each thread records its calls into its own ring buffer mapped from
+ * <prefix>.<pid>.<tid>, and the module and function names are written
+ * once to <prefix>.<pid>.names; tools/decode-relay-log turns them into
+ * text.  Since a ring buffer is only ever written by its own thread,
+ * recording a call doesn't take any lock.
+ */
+
+#define RELAY_LOG_MAGIC    0x474c5257  /* "WRLG" */
+#define RELAY_LOG_VERSION  1
+#define RELAY_LOG_RECORDS  65536       /* must be a power of 2 */
+#define RELAY_LOG_ARGS     5
+
+#define RELAY_LOG_TSC      0x01        /* timestamps are cpu cycles, otherwise 100ns units */
+
+#define RELAY_LOG_CALL     1
+#define RELAY_LOG_RET      2
+
+struct relay_log_header
+{
+    unsigned int   magic;        /* RELAY_LOG_MAGIC */
+    unsigned int   version;      /* RELAY_LOG_VERSION */
+    unsigned int   pid;          /* process id */
+    unsigned int   tid;          /* thread id */
+    unsigned int   nb_records;   /* size of the ring buffer */
+    unsigned int   flags;        /* RELAY_LOG_* flags */
+    ULONGLONG      count;        /* total number of records written */
+    ULONGLONG      reserved[4];
+};
+
+struct relay_log_record
+{
+    ULONGLONG      timestamp;
+    unsigned int   module;       /* module index in the names file */
+    unsigned short ordinal;      /* ordinal, without the ordinal base */
+    unsigned char  type;         /* RELAY_LOG_CALL or RELAY_LOG_RET */
+    unsigned char  nb_args;      /* number of argument slots of the call */
+    ULONGLONG      retaddr;      /* return address */
+    ULONGLONG      args[RELAY_LOG_ARGS]; /* first argument slots, or return value */
+};
+
+C_ASSERT( sizeof(struct relay_log_header) == 64 );
+C_ASSERT( sizeof(struct relay_log_record) == 64 );
+
+#define RELAY_LOG_SIZE (sizeof(struct relay_log_header) + RELAY_LOG_RECORDS * sizeof(struct relay_log_record))
+#define RELAY_LOG_FAILED ((struct relay_log_header *)~(ULONG_PTR)0)
+
+static const char *relay_log_prefix;
+static int relay_log_names = -1;
+static unsigned int relay_log_modules;
+
+/***********************************************************************
+ *           RELAY_LogEnabled
+ *
+ * Check whether the binary relay log is enabled.
+ */
+BOOL RELAY_LogEnabled(void)
+{
+    static int enabled = -1;
+
+    if (enabled == -1)
+    {
+        const char *prefix = getenv( "WINERELAYLOG" );
+        if (prefix && prefix[0]) relay_log_prefix = prefix;
+        enabled = (relay_log_prefix != NULL);
+    }
+    return enabled;
+}
+
+static inline ULONGLONG relay_log_timestamp(void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+    unsigned int low, high;
+    __asm__ __volatile__ ( "rdtsc" : "=a" (low), "=d" (high) );
+    return ((ULONGLONG)high << 32) | low;
+#else
+    LARGE_INTEGER counter;
+    NtQueryPerformanceCounter( &counter, NULL );
+    return counter.QuadPart;
+#endif
+}
+
+/* map the ring buffer of the current thread */
+static struct relay_log_header *create_relay_log(void)
+{
+    struct relay_log_header *log = RELAY_LOG_FAILED;
+    char *name;
+    int fd;
+
+    if (!(name = RtlAllocateHeap( GetProcessHeap(), 0, strlen(relay_log_prefix) + 24 ))) return log;
+    sprintf( name, "%s.%04x.%04x", relay_log_prefix, GetCurrentProcessId(), GetCurrentThreadId() );
+    if ((fd = open( name, O_RDWR | O_CREAT | O_TRUNC, 0666 )) != -1)
+    {
+        if (!ftruncate( fd, RELAY_LOG_SIZE ))
+        {
+            log = mmap( NULL, RELAY_LOG_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+            if (log == MAP_FAILED) log = RELAY_LOG_FAILED;
+        }
+        close( fd );
+    }
+    if (log != RELAY_LOG_FAILED)
+    {
+        log->magic      = RELAY_LOG_MAGIC;
+        log->version    = RELAY_LOG_VERSION;
+        log->pid        = GetCurrentProcessId();
+        log->tid        = GetCurrentThreadId();
+        log->nb_records = RELAY_LOG_RECORDS;
+#if defined(__i386__) || defined(__x86_64__)
+        log->flags      = RELAY_LOG_TSC;
+#endif
+    }
+    else ERR( "failed to create relay log %s\n", debugstr_a(name) );
+    RtlFreeHeap( GetProcessHeap(), 0, name );
+    return log;
+}
+
+static struct relay_log_record *get_relay_log_record(void)
+{
+    struct ntdll_thread_data *thread_data = ntdll_get_thread_data();
+    struct relay_log_header *log = thread_data->relay_log;
+
+    if (!log) log = thread_data->relay_log = create_relay_log();
+    if (log == RELAY_LOG_FAILED) return NULL;
+    return (struct relay_log_record *)(log + 1) + (log->count++ & (RELAY_LOG_RECORDS - 1));
+}
+
+static void relay_log_call( struct relay_private_data *data, WORD ordinal, const ULONG_PTR *stack,
+                            unsigned int nb_args, ULONG_PTR retaddr )
+{
+    struct relay_log_record *rec;
+    unsigned int i;
+
+    if (!(rec = get_relay_log_record())) return;
+    rec->timestamp = relay_log_timestamp();
+    rec->module    = data->log_index;
+    rec->ordinal   = ordinal;
+    rec->type      = RELAY_LOG_CALL;
+    rec->nb_args   = min( nb_args, 255 );
+    rec->retaddr   = retaddr;
+    for (i = 0; i < RELAY_LOG_ARGS; i++) rec->args[i] = i < nb_args ? stack[i] : 0;
+}
+
+static void relay_log_ret( struct relay_private_data *data, WORD ordinal, ULONGLONG retval,
+                           ULONG_PTR retaddr )
+{
+    struct relay_log_record *rec;
+
+    if (!(rec = get_relay_log_record())) return;
+    rec->timestamp = relay_log_timestamp();
+    rec->module    = data->log_index;
+    rec->ordinal   = ordinal;
+    rec->type      = RELAY_LOG_RET;
+    rec->nb_args   = 0;
+    rec->retaddr   = retaddr;
+    rec->args[0]   = retval;
+}
+
+/* add the names of a module to the names file; called with the loader lock held */
+static void relay_log_module( struct relay_private_data *data, unsigned int count )
+{
+    char buffer[256];
+    unsigned int i;
+
+    if (relay_log_names == -1)
+    {
+        char *name = RtlAllocateHeap( GetProcessHeap(), 0, strlen(relay_log_prefix) + 16 );
+
+        if (!name) return;
+        sprintf( name, "%s.%04x.names", relay_log_prefix, GetCurrentProcessId() );
+        relay_log_names = open( name, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0666 );
+        if (relay_log_names == -1) ERR( "failed to create relay log %s\n", debugstr_a(name) );
+        RtlFreeHeap( GetProcessHeap(), 0, name );
+    }
+    if (relay_log_names == -1) return;
+
+    data->log_index = relay_log_modules++;
+    write( relay_log_names, buffer,
+           sprintf( buffer, "module %u %s %u %p\n", data->log_index, data->dllname, data->base, data->module ));
+    for (i = 0; i < count; i++)
+    {
+        if (!data->entry_points[i].orig_func || !data->entry_points[i].name) continue;
+        write( relay_log_names, buffer, snprintf( buffer, sizeof(buffer), "func %u %u %.200s\n",
+                                                  data->log_index, i, data->entry_points[i].name ));
+    }
+}
+
+/***********************************************************************
+ *           relay_thread_detach
+ *
+ * Unmap the ring buffer of an exiting thread.
+ */
+void relay_thread_detach(void)
+{
+    struct ntdll_thread_data *thread_data = ntdll_get_thread_data();
+
+    if (thread_data->relay_log && thread_data->relay_log != RELAY_LOG_FAILED)
+        munmap( thread_data->relay_log, RELAY_LOG_SIZE );
+    thread_data->relay_log = NULL;
+}
+
 #ifdef __i386__
 
 /***********************************************************************
@@ -372,6 +582,7 @@ DECLSPEC_HIDDEN void * WINAPI relay_trace_entry( struct relay_descr *descr, unsi
     }
     *nb_args = pos;
     if (arg_types[0] == 't') *nb_args |= 0x80000000;  /* thiscall */
+    if (relay_log_prefix) relay_log_call( data, ordinal, (const ULONG_PTR *)stack, pos, stack[-1] );
     TRACE( ") ret=%08x\n", stack[-1] );
     return entry_point->orig_func;
 }
@@ -384,6 +595,8 @@ DECLSPEC_HIDDEN void WINAPI relay_trace_exit( struct relay_descr *descr, unsigne
 {
     const char *arg_types = descr->args_string + HIWORD(idx);
 
+    if (relay_log_prefix) relay_log_ret( descr->private, LOWORD(idx), retval, (ULONG_PTR)retaddr );
+
     TRACE( "\1Ret  %s()", func_name( descr->private, LOWORD(idx) ));
 
     while (!is_ret_val( *arg_types )) arg_types++;
@@ -467,6 +680,7 @@ DECLSPEC_HIDDEN void * WINAPI relay_trace_entry( struct relay_descr *descr, unsi
     const char *arg_types = descr->args_string + HIWORD(idx);
     struct relay_private_data *data = descr->private;
     struct relay_entry_point *entry_point = data->entry_points + ordinal;
+    const DWORD *args = stack;
     unsigned int i, pos;
 #ifndef __SOFTFP__
     unsigned int float_pos = 0, double_pos = 0;
@@ -534,6 +748,7 @@ DECLSPEC_HIDDEN void * WINAPI relay_trace_entry( struct relay_descr *descr, unsi
     }
 #endif
     *nb_args = pos;
+    if (relay_log_prefix) relay_log_call( data, ordinal, (const ULONG_PTR *)args, *nb_args & ~0x80000000, stack[-1] );
     TRACE( ") ret=%08x\n", stack[-1] );
     return entry_point->orig_func;
 }
@@ -546,6 +761,8 @@ DECLSPEC_HIDDEN void WINAPI relay_trace_exit( struct relay_descr *descr, unsigne
 {
     const char *arg_types = descr->args_string + HIWORD(idx);
 
+    if (relay_log_prefix) relay_log_ret( descr->private, LOWORD(idx), retval, retaddr );
+
     TRACE( "\1Ret  %s()", func_name( descr->private, LOWORD(idx) ));
 
     while (!is_ret_val( *arg_types )) arg_types++;
@@ -642,6 +859,7 @@ DECLSPEC_HIDDEN void * WINAPI relay_trace_entry( struct relay_descr *descr, unsi
         if (!is_ret_val( arg_types[i + 1] )) TRACE( "," );
     }
     *nb_args = i;
+    if (relay_log_prefix) relay_log_call( data, ordinal, (const ULONG_PTR *)stack, i, stack[-1] );
     TRACE( ") ret=%08lx\n", stack[-1] );
     return entry_point->orig_func;
 }
@@ -652,6 +870,8 @@ DECLSPEC_HIDDEN void * WINAPI relay_trace_entry( struct relay_descr *descr, unsi
 DECLSPEC_HIDDEN void WINAPI relay_trace_exit( struct relay_descr *descr, unsigned int idx,
                                               INT_PTR retaddr, INT_PTR retval )
 {
+    if (relay_log_prefix) relay_log_ret( descr->private, LOWORD(idx), retval, retaddr );
+
     TRACE( "\1Ret  %s() retval=%08lx ret=%08lx\n",
            func_name( descr->private, LOWORD(idx) ), retval, retaddr );
 }
@@ -748,6 +968,7 @@ DECLSPEC_HIDDEN void * WINAPI relay_trace_entry( struct relay_descr *descr, unsi
         if (!is_ret_val( arg_types[i+1] )) TRACE( "," );
     }
     *nb_args = i;
+    if (relay_log_prefix) relay_log_call( data, ordinal, (const ULONG_PTR *)stack, i, stack[-1] );
     TRACE( ") ret=%08lx\n", stack[-1] );
     return entry_point->orig_func;
 }
@@ -758,6 +979,8 @@ DECLSPEC_HIDDEN void * WINAPI relay_trace_entry( struct relay_descr *descr, unsi
 DECLSPEC_HIDDEN void WINAPI relay_trace_exit( struct relay_descr *descr, unsigned int idx,
                                               INT_PTR retaddr, INT_PTR retval )
 {
+    if (relay_log_prefix) relay_log_ret( descr->private, LOWORD(idx), retval, retaddr );
+
     TRACE( "\1Ret  %s() retval=%08lx ret=%08lx\n",
            func_name( descr->private, LOWORD(idx) ), retval, retaddr );
 }
@@ -910,6 +1133,7 @@ void RELAY_SetupDLL( HMODULE module )
         data->entry_points[i].orig_func = (char *)module + *funcs;
         *funcs = entry_point_rva + descr->entry_point_offsets[i];
     }
+    if (RELAY_LogEnabled()) relay_log_module( data, exports->NumberOfFunctions );
 }
 
 #else  /* __i386__ || __x86_64__ || __arm__ || __aarch64__ */
@@ -924,6 +1148,15 @@ void RELAY_SetupDLL( HMODULE module )
 {
 }
 
+BOOL RELAY_LogEnabled(void)
+{
+    return FALSE;
+}
+
+void relay_thread_detach(void)
+{
+}
+
 #endif  /* __i386__ || __x86_64__ || __arm__ || __aarch64__ */
 
 
@@ -26,6 +26,9 @@
 #include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -452,6 +455,16 @@ LONG WINAPI RtlCompareString( const STRING *s1, const STRING *s2, BOOLEAN CaseIn
 }
 
 
+#ifdef __SSE2__
+/* convert ASCII uppercase letters to lowercase, leave everything else alone */
+static inline __m128i ascii_tolower8( __m128i v )
+{
+    __m128i upper = _mm_and_si128( _mm_cmpgt_epi16( v, _mm_set1_epi16( 'A' - 1 )),
+                                   _mm_cmplt_epi16( v, _mm_set1_epi16( 'Z' + 1 )));
+    return _mm_add_epi16( v, _mm_and_si128( upper, _mm_set1_epi16( 0x20 )));
+}
+#endif
+
 /******************************************************************************
  *	RtlCompareUnicodeStrings   (NTDLL.@)
  */
@@ -461,6 +474,25 @@ LONG WINAPI RtlCompareUnicodeStrings( const WCHAR *s1, SIZE_T len1, const WCHAR
     LONG ret = 0;
     SIZE_T len = min( len1, len2 );
 
+#ifdef __SSE2__
+    /* skip blocks that are identical, or only differ in the case of ASCII letters */
+    while (len >= 8)
+    {
+        __m128i a = _mm_loadu_si128( (const __m128i *)s1 );
+        __m128i b = _mm_loadu_si128( (const __m128i *)s2 );
+
+        if (case_insensitive)
+        {
+            a = ascii_tolower8( a );
+            b = ascii_tolower8( b );
+        }
+        if (_mm_movemask_epi8( _mm_cmpeq_epi16( a, b )) != 0xffff) break;
+        s1 += 8;
+        s2 += 8;
+        len -= 8;
+    }
+#endif
+
     if (case_insensitive)
     {
         while (!ret && len--) ret = toupperW(*s1++) - toupperW(*s2++);
@@ -2151,7 +2183,8 @@ NTSTATUS WINAPI RtlStringFromGUID(const GUID* guid, UNICODE_STRING *str)
  */
 NTSTATUS WINAPI RtlHashUnicodeString(PCUNICODE_STRING string, BOOLEAN case_insensitive, ULONG alg, ULONG *hash)
 {
-    unsigned int i;
+    unsigned int i, len;
+    ULONG h = 0;
 
     if (!string || !hash) return STATUS_INVALID_PARAMETER;
 
@@ -2164,9 +2197,25 @@ NTSTATUS WINAPI RtlHashUnicodeString(PCUNICODE_STRING string, BOOLEAN case_insen
         return STATUS_INVALID_PARAMETER;
     }
 
-    *hash = 0;
-    for (i = 0; i < string->Length/sizeof(WCHAR); i++)
-        *hash = *hash*65599 + (case_insensitive ? toupperW(string->Buffer[i]) : string->Buffer[i]);
+    len = string->Length / sizeof(WCHAR);
+    if (case_insensitive)
+    {
+        for (i = 0; i < len; i++)
+        {
+            WCHAR ch = string->Buffer[i];
+
+            /* ASCII characters don't need the case mapping tables */
+            if (ch < 0x80) ch -= (ch >= 'a' && ch <= 'z') ? 0x20 : 0;
+            else ch = toupperW( ch );
+            h = h * 65599 + ch;
+        }
+    }
+    else
+    {
+        for (i = 0; i < len; i++) h = h * 65599 + string->Buffer[i];
+    }
+
+    *hash = h;
 
     return STATUS_SUCCESS;
 }
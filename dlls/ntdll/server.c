@@ -271,9 +271,32 @@ static void read_reply_data( void *buffer, size_t size )
  */
 static inline unsigned int wait_reply( struct __server_request_info *req )
 {
-    read_reply_data( &req->u.reply, sizeof(req->u.reply) );
-    if (req->u.reply.reply_header.reply_size)
-        read_reply_data( req->reply_data, req->u.reply.reply_header.reply_size );
+    data_size_t max_size = req->u.req.request_header.reply_size;
+    data_size_t size;
+    struct iovec vec[2];
+    int ret;
+
+    /* fetch the reply header and as much of the variable data as possible with a single syscall */
+    vec[0].iov_base = &req->u.reply;
+    vec[0].iov_len  = sizeof(req->u.reply);
+    vec[1].iov_base = req->reply_data;
+    vec[1].iov_len  = max_size;
+    while ((ret = readv( ntdll_get_thread_data()->reply_fd, vec, max_size ? 2 : 1 )) == -1)
+    {
+        if (errno == EINTR) continue;
+        if (errno == EPIPE) abort_thread(0);
+        server_protocol_perror("read");
+    }
+    if (!ret) abort_thread(0);  /* the server closed the connection; time to die... */
+
+    if (ret < sizeof(req->u.reply))
+    {
+        read_reply_data( (char *)&req->u.reply + ret, sizeof(req->u.reply) - ret );
+        ret = sizeof(req->u.reply);
+    }
+    size = ret - sizeof(req->u.reply);
+    if (req->u.reply.reply_header.reply_size > size)
+        read_reply_data( (char *)req->reply_data + size, req->u.reply.reply_header.reply_size - size );
     return req->u.reply.reply_header.error;
 }
 
@@ -430,10 +453,11 @@ static BOOL invoke_apc( const apc_call_t *call, apc_result_t *result )
         size = call->virtual_alloc.size;
         if ((ULONG_PTR)addr == call->virtual_alloc.addr && size == call->virtual_alloc.size)
         {
-            result->virtual_alloc.status = NtAllocateVirtualMemory( NtCurrentProcess(), &addr,
-                                                                    call->virtual_alloc.zero_bits, &size,
-                                                                    call->virtual_alloc.op_type,
-                                                                    call->virtual_alloc.prot );
+            result->virtual_alloc.status = virtual_alloc_node( NtCurrentProcess(), &addr,
+                                                               call->virtual_alloc.zero_bits, &size,
+                                                               call->virtual_alloc.op_type,
+                                                               call->virtual_alloc.prot,
+                                                               call->virtual_alloc.node );
             result->virtual_alloc.addr = wine_server_client_ptr( addr );
             result->virtual_alloc.size = size;
         }
@@ -817,7 +841,8 @@ union fd_cache_entry
         int fd;
         enum server_fd_type type : 5;
         unsigned int        access : 3;
-        unsigned int        options : 24;
+        unsigned int        options : 20;    /* the higher option bits only matter at open time */
+        unsigned int        comp_flags : 4;
     } s;
 };
 
@@ -843,7 +868,7 @@ static inline unsigned int handle_to_index( HANDLE handle, unsigned int *entry )
  * Caller must hold fd_cache_section.
  */
 static BOOL add_fd_to_cache( HANDLE handle, int fd, enum server_fd_type type,
-                            unsigned int access, unsigned int options )
+                            unsigned int access, unsigned int options, unsigned int comp_flags )
 {
     unsigned int entry, idx = handle_to_index( handle, &entry );
     union fd_cache_entry cache;
@@ -871,6 +896,7 @@ static BOOL add_fd_to_cache( HANDLE handle, int fd, enum server_fd_type type,
     cache.s.type = type;
     cache.s.access = access;
     cache.s.options = options;
+    cache.s.comp_flags = comp_flags;
     cache.data = interlocked_xchg64( &fd_cache[entry][idx].data, cache.data );
     assert( !cache.s.fd );
     return TRUE;
@@ -957,14 +983,14 @@ int server_get_unix_fd( HANDLE handle, unsigned int wanted_access, int *unix_fd,
                 {
                     assert( wine_server_ptr_handle(fd_handle) == handle );
                     *needs_close = (!reply->cacheable ||
-                                    !add_fd_to_cache( handle, fd, reply->type,
-                                                      reply->access, reply->options ));
+                                    !add_fd_to_cache( handle, fd, reply->type, reply->access,
+                                                      reply->options, reply->comp_flags ));
                 }
                 else ret = STATUS_TOO_MANY_OPENED_FILES;
             }
             else if (reply->cacheable)
             {
-                add_fd_to_cache( handle, ret, FD_TYPE_INVALID, 0, 0 );
+                add_fd_to_cache( handle, ret, FD_TYPE_INVALID, 0, 0, 0 );
             }
         }
         SERVER_END_REQ;
@@ -982,6 +1008,52 @@ done:
 }
 
 
+/***********************************************************************
+ *           server_set_completion_mode
+ *
+ * Add completion notification flags to a file, and return the resulting flags.
+ * Only querying the flags is done from the fd cache when possible.
+ */
+NTSTATUS server_set_completion_mode( HANDLE handle, unsigned int add_flags, unsigned int *flags )
+{
+    unsigned int entry, idx = handle_to_index( handle, &entry );
+    union fd_cache_entry cache, new_cache;
+    NTSTATUS ret;
+
+    if (entry >= FD_CACHE_ENTRIES || !fd_cache[entry]) entry = FD_CACHE_ENTRIES;
+
+    if (!add_flags && entry < FD_CACHE_ENTRIES)
+    {
+        cache.data = interlocked_cmpxchg64( &fd_cache[entry][idx].data, 0, 0 );
+        if (cache.data && cache.s.type != FD_TYPE_INVALID)
+        {
+            *flags = cache.s.comp_flags;
+            return STATUS_SUCCESS;
+        }
+    }
+
+    SERVER_START_REQ( set_fd_completion_mode )
+    {
+        req->handle = wine_server_obj_handle( handle );
+        req->flags  = add_flags;
+        if (!(ret = wine_server_call( req ))) *flags = reply->flags;
+    }
+    SERVER_END_REQ;
+
+    if (ret || entry >= FD_CACHE_ENTRIES) return ret;
+
+    /* update the cached copy */
+    do
+    {
+        cache.data = interlocked_cmpxchg64( &fd_cache[entry][idx].data, 0, 0 );
+        if (!cache.data || cache.s.type == FD_TYPE_INVALID) break;
+        new_cache = cache;
+        new_cache.s.comp_flags = *flags;
+    } while (interlocked_cmpxchg64( &fd_cache[entry][idx].data, new_cache.data, cache.data ) != cache.data);
+    return ret;
+}
+
+
 /***********************************************************************
  *           wine_server_fd_to_handle   (NTDLL.@)
  *
@@ -1361,6 +1433,134 @@ static int get_unix_tid(void)
 }
 
 
+/***********************************************************************
+ *           read_stub_data
+ */
+static BOOL read_stub_data( int fd, void *data, size_t size )
+{
+    char *ptr = data;
+    ssize_t ret;
+
+    while (size)
+    {
+        if ((ret = read( fd, ptr, size )) > 0)
+        {
+            ptr += ret;
+            size -= ret;
+            continue;
+        }
+        if (ret == -1 && errno == EINTR) continue;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+
+/***********************************************************************
+ *           receive_stub_fd
+ *
+ * Receive a file descriptor from the process that owns the stub.
+ */
+static int receive_stub_fd( int socket, int *target )
+{
+    struct iovec vec;
+    struct msghdr msghdr;
+    int ret, fd = -1;
+
+#ifdef HAVE_STRUCT_MSGHDR_MSG_ACCRIGHTS
+    msghdr.msg_accrights    = (void *)&fd;
+    msghdr.msg_accrightslen = sizeof(fd);
+#else  /* HAVE_STRUCT_MSGHDR_MSG_ACCRIGHTS */
+    char cmsg_buffer[256];
+    msghdr.msg_control    = cmsg_buffer;
+    msghdr.msg_controllen = sizeof(cmsg_buffer);
+    msghdr.msg_flags      = 0;
+#endif  /* HAVE_STRUCT_MSGHDR_MSG_ACCRIGHTS */
+
+    msghdr.msg_name    = NULL;
+    msghdr.msg_namelen = 0;
+    msghdr.msg_iov     = &vec;
+    msghdr.msg_iovlen  = 1;
+    vec.iov_base = (void *)target;
+    vec.iov_len  = sizeof(*target);
+
+    while ((ret = recvmsg( socket, &msghdr, 0 )) == -1 && errno == EINTR) ;
+    if (ret != sizeof(*target)) return -1;
+
+#ifndef HAVE_STRUCT_MSGHDR_MSG_ACCRIGHTS
+    {
+        struct cmsghdr *cmsg;
+        for (cmsg = CMSG_FIRSTHDR( &msghdr ); cmsg; cmsg = CMSG_NXTHDR( &msghdr, cmsg ))
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+                fd = *(int *)CMSG_DATA(cmsg);
+    }
+#endif  /* HAVE_STRUCT_MSGHDR_MSG_ACCRIGHTS */
+    return fd;
+}
+
+
+/***********************************************************************
+ *           wait_process_stub
+ *
+ * Wait until CreateProcess hands a new process to this pre-started stub,
+ * and set up the unix side of the process the same way the loader would
+ * have been started for it. Exits if the owner of the stub goes away.
+ */
+static void wait_process_stub( int socket )
+{
+    struct process_stub_info info;
+    char buffer[16], *data, *ptr, **argv;
+    int fd, target, server_fd = -1;
+    unsigned int i;
+
+    if (!read_stub_data( socket, &info, sizeof(info) )) exit(0);
+    for (i = 0; i < info.nb_fds; i++)
+    {
+        if ((fd = receive_stub_fd( socket, &target )) == -1) exit(0);
+        if (target == PROCESS_STUB_SERVER) server_fd = fd;
+        else
+        {
+            dup2( fd, target );
+            close( fd );
+        }
+    }
+    if (server_fd == -1) exit(0);
+    if (!(data = malloc( info.size + 1 )) || !read_stub_data( socket, data, info.size )) exit(0);
+    data[info.size] = 0;
+    close( socket );
+
+    if (info.flags & PROCESS_STUB_DETACH)
+    {
+        fd = open( "/dev/null", O_RDWR );
+        setsid();
+        /* close stdin and stdout */
+        if (fd != -1)
+        {
+            dup2( fd, 0 );
+            dup2( fd, 1 );
+            close( fd );
+        }
+    }
+    if (*data) chdir( data );
+
+    /* keep our loader as argv[0] */
+    if (!(argv = malloc( (info.argc + 2) * sizeof(*argv) ))) exit(1);
+    argv[0] = __wine_main_argv[0];
+    ptr = data + strlen( data ) + 1;
+    for (i = 0; i < info.argc && ptr < data + info.size; i++)
+    {
+        argv[i + 1] = ptr;
+        ptr += strlen( ptr ) + 1;
+    }
+    argv[i + 1] = NULL;
+    __wine_main_argc = i + 1;
+    __wine_main_argv = argv;
+
+    sprintf( buffer, "%d", server_fd );
+    setenv( "WINESERVERSOCKET", buffer, 1 );
+}
+
+
 /***********************************************************************
  *           server_init_process
  *
@@ -1369,7 +1569,15 @@ static int get_unix_tid(void)
 void server_init_process(void)
 {
     obj_handle_t version;
-    const char *env_socket = getenv( "WINESERVERSOCKET" );
+    const char *env_socket, *env_stub;
+
+    if ((env_stub = getenv( "WINEPROCESSSTUB" )))
+    {
+        int socket = atoi( env_stub );
+        unsetenv( "WINEPROCESSSTUB" );
+        wait_process_stub( socket );
+    }
+    env_socket = getenv( "WINESERVERSOCKET" );
 
     server_pid = -1;
     if (env_socket)
@@ -2532,13 +2532,28 @@ static RUNTIME_FUNCTION *find_function_info( ULONG64 pc, HMODULE module,
 
 /**********************************************************************
  *           lookup_function_info
+ *
+ * The results are cached per thread, since unwinding keeps going through the
+ * same return addresses. The entries are dropped when any module is unloaded
+ * or function table deleted. Callback results aren't cached, as the code
+ * they describe can be replaced at any time.
  */
 static RUNTIME_FUNCTION *lookup_function_info( ULONG64 pc, ULONG64 *base, LDR_MODULE **module )
 {
+    struct unwind_cache_entry *cache = &ntdll_get_thread_data()->unwind_cache[(pc ^ (pc >> 6)) % UNWIND_CACHE_SIZE];
+    LONG serial = module_unload_serial;
     RUNTIME_FUNCTION *func = NULL;
     struct dynamic_unwind_entry *entry;
+    BOOL cacheable = TRUE;
     ULONG size;
 
+    if (cache->func && cache->pc == pc && cache->serial == serial)
+    {
+        *base = cache->base;
+        *module = cache->module;
+        return cache->func;
+    }
+
     /* PE module or wine module */
     if (!LdrFindEntryForAddress( (void *)pc, module ))
     {
@@ -2563,7 +2578,10 @@ static RUNTIME_FUNCTION *lookup_function_info( ULONG64 pc, ULONG64 *base, LDR_MO
 
                 /* use callback or lookup in function table */
                 if (entry->callback)
+                {
                     func = entry->callback( pc, entry->context );
+                    cacheable = FALSE;
+                }
                 else
                     func = find_function_info( pc, (HMODULE)entry->base, entry->table, entry->table_size );
                 break;
@@ -2572,6 +2590,18 @@ static RUNTIME_FUNCTION *lookup_function_info( ULONG64 pc, ULONG64 *base, LDR_MO
         RtlLeaveCriticalSection( &dynamic_unwind_section );
     }
 
+    if (func && cacheable)
+    {
+        /* func is set last, so that an entry is never used while being updated */
+        cache->func   = NULL;
+        __asm__ __volatile__( "" : : : "memory" );
+        cache->pc     = pc;
+        cache->base   = *base;
+        cache->module = *module;
+        cache->serial = serial;
+        __asm__ __volatile__( "" : : : "memory" );
+        cache->func   = func;
+    }
     return func;
 }
 
@@ -3518,6 +3548,7 @@ BOOLEAN CDECL RtlDeleteFunctionTable( RUNTIME_FUNCTION *table )
         {
             to_free = entry;
             list_remove( &entry->entry );
+            interlocked_xchg_add( &module_unload_serial, 1 );
             break;
         }
     }
@@ -26,6 +26,7 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <limits.h>
 #include <signal.h>
 #ifdef HAVE_SYS_TIME_H
 # include <sys/time.h>
@@ -42,6 +43,12 @@
 #ifdef HAVE_SCHED_H
 # include <sched.h>
 #endif
+#ifdef HAVE_SYS_SYSCALL_H
+# include <sys/syscall.h>
+#endif
+#ifdef HAVE_SYS_PRCTL_H
+# include <sys/prctl.h>
+#endif
 #include <string.h>
 #include <stdarg.h>
 #include <stdio.h>
@@ -55,6 +62,7 @@
 #include "winternl.h"
 #include "wine/server.h"
 #include "wine/debug.h"
+#include "wine/list.h"
 
 #include "ntdll_misc.h"
 #include "esync.h"
@@ -63,6 +71,82 @@ WINE_DEFAULT_DEBUG_CHANNEL(ntdll);
 
 HANDLE keyed_event = NULL;
 
+#define TICKSPERSEC 10000000
+
+#ifdef __linux__
+
+static int wait_op = 128; /*FUTEX_WAIT|FUTEX_PRIVATE_FLAG*/
+static int wake_op = 129; /*FUTEX_WAKE|FUTEX_PRIVATE_FLAG*/
+static int wait_bitset_op = 137; /*FUTEX_WAIT_BITSET|FUTEX_PRIVATE_FLAG*/
+static int wake_bitset_op = 138; /*FUTEX_WAKE_BITSET|FUTEX_PRIVATE_FLAG*/
+
+static inline int futex_wait( int *addr, int val, struct timespec *timeout )
+{
+    return syscall( __NR_futex, addr, wait_op, val, timeout, 0, 0 );
+}
+
+static inline int futex_wake( int *addr, int val )
+{
+    return syscall( __NR_futex, addr, wake_op, val, NULL, 0, 0 );
+}
+
+static inline int futex_wait_bitset( int *addr, int val, int mask )
+{
+    return syscall( __NR_futex, addr, wait_bitset_op, val, NULL, 0, mask );
+}
+
+static inline int futex_wake_bitset( int *addr, int val, int mask )
+{
+    return syscall( __NR_futex, addr, wake_bitset_op, val, NULL, 0, mask );
+}
+
+static inline int use_futexes(void)
+{
+    static int supported = -1;
+
+    if (supported == -1)
+    {
+        futex_wait( &supported, 10, NULL );
+        if (errno == ENOSYS)
+        {
+            wait_op = 0; /*FUTEX_WAIT*/
+            wake_op = 1; /*FUTEX_WAKE*/
+            wait_bitset_op = 9; /*FUTEX_WAIT_BITSET*/
+            wake_bitset_op = 10; /*FUTEX_WAKE_BITSET*/
+            futex_wait( &supported, 10, NULL );
+        }
+        supported = (errno != ENOSYS);
+    }
+    return supported;
+}
+
+/* convert an NT timeout to the relative timeout expected by futex_wait() */
+static void timespec_from_timeout( struct timespec *timespec, const LARGE_INTEGER *timeout )
+{
+    LARGE_INTEGER now;
+    LONGLONG diff;
+
+    if (timeout->QuadPart >= 0)
+    {
+        NtQuerySystemTime( &now );
+        diff = timeout->QuadPart - now.QuadPart;
+        if (diff < 0) diff = 0;
+    }
+    else diff = -timeout->QuadPart;
+
+    timespec->tv_sec  = diff / TICKSPERSEC;
+    timespec->tv_nsec = (diff % TICKSPERSEC) * 100;
+}
+
+#else
+
+static inline int use_futexes(void)
+{
+    return 0;
+}
+
+#endif
+
 static inline int interlocked_dec_if_nonzero( int *dest )
 {
     int val, tmp;
@@ -1031,6 +1115,36 @@ NTSTATUS WINAPI NtQueryTimer(
 }
 
 
+/* The timer resolution is only a hint on Unix, where sleeps have a much better
+ * granularity anyway. We use it to set the timer slack of the threads, so that
+ * the kernel doesn't delay wakeups by up to 50us (the default) to coalesce
+ * them when the application asked for precise timing. The slack is per
+ * thread, so it gets updated lazily before each timed wait. */
+
+#ifndef PR_SET_TIMERSLACK
+#define PR_SET_TIMERSLACK 29
+#endif
+
+#define MIN_TIMER_RESOLUTION 156250  /* 15.625 ms, the coarsest */
+#define MAX_TIMER_RESOLUTION 5000    /* 0.5 ms, the finest */
+
+static ULONG timer_resolution = MIN_TIMER_RESOLUTION;
+static BOOL timer_resolution_set;
+static int timer_slack_generation;
+
+static void update_timer_slack(void)
+{
+#if defined(__linux__) && defined(HAVE_PRCTL)
+    struct ntdll_thread_data *thread_data = ntdll_get_thread_data();
+    int generation = timer_slack_generation;
+
+    if (thread_data->timer_slack_generation == generation) return;
+    thread_data->timer_slack_generation = generation;
+    /* allow 1% of the period in ns, or go back to the default slack */
+    prctl( PR_SET_TIMERSLACK, timer_resolution < MIN_TIMER_RESOLUTION ? timer_resolution : 0 );
+#endif
+}
+
 /******************************************************************************
  * NtQueryTimerResolution [NTDLL.@]
  */
@@ -1038,10 +1152,15 @@ NTSTATUS WINAPI NtQueryTimerResolution(OUT ULONG* min_resolution,
                                        OUT ULONG* max_resolution,
                                        OUT ULONG* current_resolution)
 {
-    FIXME("(%p,%p,%p), stub!\n",
-          min_resolution, max_resolution, current_resolution);
+    TRACE("(%p,%p,%p)\n", min_resolution, max_resolution, current_resolution);
 
-    return STATUS_NOT_IMPLEMENTED;
+    if (!min_resolution || !max_resolution || !current_resolution)
+        return STATUS_ACCESS_VIOLATION;
+
+    *min_resolution = MIN_TIMER_RESOLUTION;
+    *max_resolution = MAX_TIMER_RESOLUTION;
+    *current_resolution = timer_resolution;
+    return STATUS_SUCCESS;
 }
 
 /******************************************************************************
@@ -1051,12 +1170,29 @@ NTSTATUS WINAPI NtSetTimerResolution(IN ULONG resolution,
                                      IN BOOLEAN set_resolution,
                                      OUT ULONG* current_resolution )
 {
-    FIXME("(%u,%u,%p), stub!\n",
-          resolution, set_resolution, current_resolution);
+    NTSTATUS ret = STATUS_SUCCESS;
 
-    return STATUS_NOT_IMPLEMENTED;
-}
+    TRACE("(%u,%u,%p)\n", resolution, set_resolution, current_resolution);
+
+    if (!current_resolution) return STATUS_ACCESS_VIOLATION;
+
+    if (set_resolution)
+    {
+        timer_resolution = max( MAX_TIMER_RESOLUTION, min( resolution, MIN_TIMER_RESOLUTION ));
+        timer_resolution_set = TRUE;
+    }
+    else if (timer_resolution_set)
+    {
+        timer_resolution = MIN_TIMER_RESOLUTION;
+        timer_resolution_set = FALSE;
+    }
+    else ret = STATUS_TIMER_RESOLUTION_NOT_SET;
 
+    interlocked_xchg_add( &timer_slack_generation, 1 );
+    update_timer_slack();
+    *current_resolution = timer_resolution;
+    return ret;
+}
 
 
 /* wait operations */
@@ -1070,6 +1206,8 @@ static NTSTATUS wait_objects( DWORD count, const HANDLE *handles,
 
     if (!count || count > MAXIMUM_WAIT_OBJECTS) return STATUS_INVALID_PARAMETER_1;
 
+    if (timeout) update_timer_slack();
+
     if (do_esync())
     {
         NTSTATUS ret = esync_wait_objects( count, handles, wait_any, alertable, timeout );
@@ -1145,6 +1283,8 @@ NTSTATUS WINAPI NtYieldExecution(void)
  */
 NTSTATUS WINAPI NtDelayExecution( BOOLEAN alertable, const LARGE_INTEGER *timeout )
 {
+    if (timeout) update_timer_slack();
+
     /* if alertable, we need to query the server */
     if (alertable)
         return server_select( NULL, 0, SELECT_INTERRUPTIBLE | SELECT_ALERTABLE, timeout );
@@ -1170,19 +1310,249 @@ NTSTATUS WINAPI NtDelayExecution( BOOLEAN alertable, const LARGE_INTEGER *timeou
 
         for (;;)
         {
-            struct timeval tv;
+            struct timespec ts;
             NtQuerySystemTime( &now );
-            diff = (when - now.QuadPart + 9) / 10;
+            diff = when - now.QuadPart;
             if (diff <= 0) break;
-            tv.tv_sec  = diff / 1000000;
-            tv.tv_usec = diff % 1000000;
-            if (select( 0, NULL, NULL, NULL, &tv ) != -1) break;
+            ts.tv_sec  = diff / TICKSPERSEC;
+            ts.tv_nsec = (diff % TICKSPERSEC) * 100;
+            /* nanosleep uses high resolution timers, unlike select() on some systems */
+            if (nanosleep( &ts, NULL ) != -1) break;
         }
     }
     return STATUS_SUCCESS;
 }
 
 
+#ifdef __linux__
+
+/* Unnamed keyed events can't be opened from other processes, so waits and
+ * releases on them are matched entirely in the client, using a hash table of
+ * waiting threads. Each waiter sleeps on a futex on its own stack.
+ *
+ * The server object still exists, so that the handle behaves normally; we
+ * only remember which handles refer to such an event (duplicates share the
+ * same id). If the handle is duplicated into another process, we stop using
+ * the client side implementation for it. */
+
+#define MAX_PRIVATE_KEYED_EVENTS 64
+#define KEYED_EVENT_BUCKETS      64
+
+struct private_keyed_event
+{
+    HANDLE       handle;
+    unsigned int id;
+};
+
+struct keyed_waiter
+{
+    struct list  entry;
+    unsigned int id;       /* id of the keyed event */
+    const void  *key;
+    BOOL         release;  /* is this thread releasing instead of waiting */
+    int          state;    /* set to 1 once matched */
+};
+
+struct keyed_bucket
+{
+    int          lock;
+    struct list  waiters;
+};
+
+static struct private_keyed_event private_keyed_events[MAX_PRIVATE_KEYED_EVENTS];
+static struct keyed_bucket keyed_buckets[KEYED_EVENT_BUCKETS];
+static RTL_CRITICAL_SECTION private_keyed_section;
+static RTL_CRITICAL_SECTION_DEBUG private_keyed_debug =
+{
+    0, 0, &private_keyed_section,
+    { &private_keyed_debug.ProcessLocksList, &private_keyed_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": private_keyed_section") }
+};
+static RTL_CRITICAL_SECTION private_keyed_section = { &private_keyed_debug, -1, 0, 0, 0, 0 };
+
+static unsigned int get_private_keyed_event( HANDLE handle )
+{
+    unsigned int i;
+
+    if (!handle) return 0;
+    for (i = 0; i < MAX_PRIVATE_KEYED_EVENTS; i++)
+        if (private_keyed_events[i].handle == handle) return private_keyed_events[i].id;
+    return 0;
+}
+
+/* add a handle to an existing event, or to a new one if id is 0 */
+static void add_private_keyed_event( HANDLE handle, unsigned int id )
+{
+    static unsigned int last_id;
+    unsigned int i;
+
+    RtlEnterCriticalSection( &private_keyed_section );
+    if (!id && !(id = ++last_id)) id = ++last_id;
+    for (i = 0; i < MAX_PRIVATE_KEYED_EVENTS; i++)
+    {
+        if (private_keyed_events[i].handle) continue;
+        private_keyed_events[i].id = id;
+        private_keyed_events[i].handle = handle;
+        break;
+    }
+    RtlLeaveCriticalSection( &private_keyed_section );
+}
+
+/* remove a handle, or all handles to the event if handle is NULL */
+static void remove_private_keyed_event( HANDLE handle, unsigned int id )
+{
+    unsigned int i;
+
+    RtlEnterCriticalSection( &private_keyed_section );
+    for (i = 0; i < MAX_PRIVATE_KEYED_EVENTS; i++)
+    {
+        if (private_keyed_events[i].id != id) continue;
+        if (handle && private_keyed_events[i].handle != handle) continue;
+        private_keyed_events[i].handle = 0;
+        private_keyed_events[i].id = 0;
+    }
+    RtlLeaveCriticalSection( &private_keyed_section );
+}
+
+static void lock_bucket( struct keyed_bucket *bucket )
+{
+    int val;
+
+    if (!(val = interlocked_cmpxchg( &bucket->lock, 1, 0 ))) return;
+    if (val != 2) val = interlocked_xchg( &bucket->lock, 2 );
+    while (val)
+    {
+        futex_wait( &bucket->lock, 2, NULL );
+        val = interlocked_xchg( &bucket->lock, 2 );
+    }
+}
+
+static void unlock_bucket( struct keyed_bucket *bucket )
+{
+    if (interlocked_xchg_add( &bucket->lock, -1 ) != 1)
+    {
+        bucket->lock = 0;
+        futex_wake( &bucket->lock, 1 );
+    }
+}
+
+/* match a wait with a release, or queue ourselves until the other side shows up */
+static NTSTATUS fast_keyed_event( unsigned int id, const void *key, BOOL release,
+                                  BOOLEAN alertable, const LARGE_INTEGER *timeout )
+{
+    static const LARGE_INTEGER zero;
+    struct keyed_bucket *bucket;
+    struct keyed_waiter self, *waiter;
+    struct timespec timespec;
+    LARGE_INTEGER end, now;
+    NTSTATUS ret;
+
+    /* We can't be woken up by user APCs while sleeping on the futex, but at
+     * least run the ones which are already pending. */
+    if (alertable)
+    {
+        ret = server_select( NULL, 0, SELECT_INTERRUPTIBLE | SELECT_ALERTABLE, &zero );
+        if (ret == STATUS_USER_APC) return ret;
+    }
+
+    if (timeout && timeout->QuadPart == TIMEOUT_INFINITE) timeout = NULL;
+    if (timeout)
+    {
+        end = *timeout;
+        if (end.QuadPart < 0)
+        {
+            NtQuerySystemTime( &now );
+            end.QuadPart = now.QuadPart - end.QuadPart;
+        }
+    }
+
+    bucket = &keyed_buckets[(((ULONG_PTR)key >> 2) ^ id) % KEYED_EVENT_BUCKETS];
+    lock_bucket( bucket );
+    if (!bucket->waiters.next) list_init( &bucket->waiters );
+
+    LIST_FOR_EACH_ENTRY( waiter, &bucket->waiters, struct keyed_waiter, entry )
+    {
+        if (waiter->id != id || waiter->key != key || waiter->release == release) continue;
+        list_remove( &waiter->entry );
+        waiter->state = 1;
+        unlock_bucket( bucket );
+        /* the waiter may already be gone if it saw the state change first;
+         * a spurious wakeup on its old stack address is harmless */
+        futex_wake( &waiter->state, 1 );
+        return STATUS_SUCCESS;
+    }
+
+    if (timeout && !timeout->QuadPart)
+    {
+        unlock_bucket( bucket );
+        return STATUS_TIMEOUT;
+    }
+
+    self.id      = id;
+    self.key     = key;
+    self.release = release;
+    self.state   = 0;
+    list_add_tail( &bucket->waiters, &self.entry );
+    unlock_bucket( bucket );
+
+    while (!*(volatile int *)&self.state)
+    {
+        if (timeout)
+        {
+            timespec_from_timeout( &timespec, &end );
+            if (!timespec.tv_sec && !timespec.tv_nsec) break;
+        }
+        futex_wait( &self.state, 0, timeout ? &timespec : NULL );
+    }
+
+    if (*(volatile int *)&self.state) return STATUS_SUCCESS;
+
+    lock_bucket( bucket );
+    if (!self.state)
+    {
+        list_remove( &self.entry );
+        ret = STATUS_TIMEOUT;
+    }
+    else ret = STATUS_SUCCESS;
+    unlock_bucket( bucket );
+    return ret;
+}
+
+#else
+
+static unsigned int get_private_keyed_event( HANDLE handle )
+{
+    return 0;
+}
+
+static void add_private_keyed_event( HANDLE handle, unsigned int id )
+{
+}
+
+static void remove_private_keyed_event( HANDLE handle, unsigned int id )
+{
+}
+
+static NTSTATUS fast_keyed_event( unsigned int id, const void *key, BOOL release,
+                                  BOOLEAN alertable, const LARGE_INTEGER *timeout )
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+
+#endif
+
+/* called when a handle is closed or duplicated, to keep track of private keyed events */
+void update_private_keyed_event( HANDLE handle, HANDLE dup, BOOL closed, BOOL self )
+{
+    unsigned int id;
+
+    if (!(id = get_private_keyed_event( handle ))) return;
+
+    if (dup && self) add_private_keyed_event( dup, id );
+    else if (dup) remove_private_keyed_event( NULL, id );
+    if (closed) remove_private_keyed_event( handle, id );
+}
+
 /******************************************************************************
  *              NtCreateKeyedEvent (NTDLL.@)
  */
@@ -1204,6 +1574,9 @@ NTSTATUS WINAPI NtCreateKeyedEvent( HANDLE *handle, ACCESS_MASK access,
     }
     SERVER_END_REQ;
 
+    if (!ret && (!attr || !attr->ObjectName) && use_futexes())
+        add_private_keyed_event( *handle, 0 );
+
     RtlFreeHeap( GetProcessHeap(), 0, objattr );
     return ret;
 }
@@ -1239,8 +1612,11 @@ NTSTATUS WINAPI NtWaitForKeyedEvent( HANDLE handle, const void *key,
 {
     select_op_t select_op;
     UINT flags = SELECT_INTERRUPTIBLE;
+    unsigned int id;
 
     if ((ULONG_PTR)key & 1) return STATUS_INVALID_PARAMETER_1;
+    if ((id = get_private_keyed_event( handle )))
+        return fast_keyed_event( id, key, FALSE, alertable, timeout );
     if (alertable) flags |= SELECT_ALERTABLE;
     select_op.keyed_event.op     = SELECT_KEYED_EVENT_WAIT;
     select_op.keyed_event.handle = wine_server_obj_handle( handle );
@@ -1256,8 +1632,11 @@ NTSTATUS WINAPI NtReleaseKeyedEvent( HANDLE handle, const void *key,
 {
     select_op_t select_op;
     UINT flags = SELECT_INTERRUPTIBLE;
+    unsigned int id;
 
     if ((ULONG_PTR)key & 1) return STATUS_INVALID_PARAMETER_1;
+    if ((id = get_private_keyed_event( handle )))
+        return fast_keyed_event( id, key, TRUE, alertable, timeout );
     if (alertable) flags |= SELECT_ALERTABLE;
     select_op.keyed_event.op     = SELECT_KEYED_EVENT_RELEASE;
     select_op.keyed_event.handle = wine_server_obj_handle( handle );
@@ -1386,6 +1765,66 @@ NTSTATUS WINAPI NtRemoveIoCompletion( HANDLE CompletionPort, PULONG_PTR Completi
     return status;
 }
 
+/******************************************************************
+ *              NtRemoveIoCompletionEx (NTDLL.@)
+ *              ZwRemoveIoCompletionEx (NTDLL.@)
+ *
+ * (Wait for and) retrieve several completion messages from completion object's queue
+ *
+ * PARAMS
+ *      port      [I] HANDLE to I/O completion object
+ *      info      [O] array receiving the completion messages
+ *      count     [I] size of the info array
+ *      written   [O] number of completion messages retrieved
+ *      timeout   [I] optional wait time in NTDLL format
+ *      alertable [I] whether the wait is alertable
+ *
+ */
+NTSTATUS WINAPI NtRemoveIoCompletionEx( HANDLE port, FILE_IO_COMPLETION_INFORMATION *info, ULONG count,
+                                        ULONG *written, LARGE_INTEGER *timeout, BOOLEAN alertable )
+{
+    completion_msg_t msgs[64];
+    NTSTATUS status;
+    ULONG i = 0, j, size, ret = 0;
+
+    TRACE("(%p, %p, %u, %p, %p, %u)\n", port, info, count, written, timeout, alertable);
+
+    if (!count) return STATUS_INVALID_PARAMETER;
+
+    for (;;)
+    {
+        /* fetch as many queued packets as fit, several per server call */
+        while (i < count)
+        {
+            size = min( count - i, ARRAY_SIZE(msgs) );
+            SERVER_START_REQ( remove_completions )
+            {
+                req->handle = wine_server_obj_handle( port );
+                wine_server_set_reply( req, msgs, size * sizeof(msgs[0]) );
+                if (!(status = wine_server_call( req ))) ret = reply->count;
+            }
+            SERVER_END_REQ;
+            if (status) break;
+
+            for (j = 0; j < ret; j++, i++)
+            {
+                info[i].CompletionKey             = msgs[j].ckey;
+                info[i].CompletionValue           = msgs[j].cvalue;
+                info[i].IoStatusBlock.Information = msgs[j].information;
+                info[i].IoStatusBlock.u.Status    = msgs[j].status;
+            }
+            if (ret < size) break;
+        }
+        if (i || status != STATUS_PENDING) break;
+
+        status = NtWaitForSingleObject( port, alertable, timeout );
+        if (status != WAIT_OBJECT_0) break;
+    }
+
+    *written = i;
+    return i ? STATUS_SUCCESS : status;
+}
+
 /******************************************************************
  *              NtOpenIoCompletion (NTDLL.@)
  *              ZwOpenIoCompletion (NTDLL.@)
@@ -1471,7 +1910,7 @@ NTSTATUS WINAPI NtQueryIoCompletion( HANDLE CompletionPort, IO_COMPLETION_INFORM
 }
 
 NTSTATUS NTDLL_AddCompletion( HANDLE hFile, ULONG_PTR CompletionValue,
-                              NTSTATUS CompletionStatus, ULONG Information )
+                              NTSTATUS CompletionStatus, ULONG Information, BOOL async )
 {
     NTSTATUS status;
 
@@ -1481,6 +1920,7 @@ NTSTATUS NTDLL_AddCompletion( HANDLE hFile, ULONG_PTR CompletionValue,
         req->cvalue      = CompletionValue;
         req->status      = CompletionStatus;
         req->information = Information;
+        req->async       = async;
         status = wine_server_call( req );
     }
     SERVER_END_REQ;
@@ -1641,6 +2081,341 @@ DWORD WINAPI RtlRunOnceExecuteOnce( RTL_RUN_ONCE *once, PRTL_RUN_ONCE_INIT_FN fu
  * are all ready the shared access threads are processed.
  */
 
+#ifdef __linux__
+
+/* Futex-based SRW lock implementation
+ *
+ * The kernel takes care of queuing the waiters, so we don't need to count
+ * them in the shared half of the lock. The layout is:
+ *
+ *     31 - set if the lock is owned exclusively
+ *  30-16 - number of threads waiting for exclusive access
+ *     15 - set if there are threads waiting for shared access
+ *   14-0 - number of shared owners
+ *
+ * Exclusive and shared waiters sleep on the same word, but with different
+ * futex bitsets, so that we can wake them separately. The keyed event layout
+ * above is never used once the futex path has been selected, since that
+ * decision is made once per process.
+ */
+
+#define SRWLOCK_FUTEX_EXCLUSIVE_LOCK_BIT        0x80000000
+#define SRWLOCK_FUTEX_EXCLUSIVE_WAITERS_MASK    0x7fff0000
+#define SRWLOCK_FUTEX_EXCLUSIVE_WAITERS_INC     0x00010000
+#define SRWLOCK_FUTEX_SHARED_WAITERS_BIT        0x00008000
+#define SRWLOCK_FUTEX_SHARED_OWNERS_MASK        0x00007fff
+#define SRWLOCK_FUTEX_SHARED_OWNERS_INC         0x00000001
+
+#define SRWLOCK_FUTEX_BITSET_EXCLUSIVE  1
+#define SRWLOCK_FUTEX_BITSET_SHARED     2
+
+static inline void small_pause(void)
+{
+#ifdef __i386__
+    __asm__ __volatile__( "rep;nop" : : : "memory" );
+#else
+    __asm__ __volatile__( "" : : : "memory" );
+#endif
+}
+
+/* SRW locks have no room for per-lock statistics, so we keep a single
+ * estimate of how long it takes for a lock to change state. Spinning that
+ * fails makes us spin less next time, so that long hold times or preempted
+ * owners quickly make us go straight to sleep. */
+
+#define SRWLOCK_MIN_SPIN  16
+#define SRWLOCK_MAX_SPIN  1024
+
+static int srwlock_spin_estimate;
+
+/* spin while the lock is in the given state, return TRUE if it changed */
+static BOOL srwlock_spin( RTL_SRWLOCK *lock, int val )
+{
+    int count, limit, estimate = srwlock_spin_estimate;
+
+    if (NtCurrentTeb()->Peb->NumberOfProcessors <= 1) return FALSE;
+
+    limit = min( estimate * 2 + SRWLOCK_MIN_SPIN, SRWLOCK_MAX_SPIN );
+    for (count = 0; count < limit; count++)
+    {
+        if (*(volatile int *)lock != val)
+        {
+            srwlock_spin_estimate = estimate + (count - estimate) / 8;
+            return TRUE;
+        }
+        small_pause();
+    }
+    srwlock_spin_estimate = estimate - (estimate + 7) / 8;
+    return FALSE;
+}
+
+static NTSTATUS fast_try_acquire_srw_exclusive( RTL_SRWLOCK *lock )
+{
+    int old, new;
+    NTSTATUS ret;
+
+    if (!use_futexes()) return STATUS_NOT_IMPLEMENTED;
+
+    do
+    {
+        old = *(int *)lock;
+
+        if (!(old & SRWLOCK_FUTEX_EXCLUSIVE_LOCK_BIT) && !(old & SRWLOCK_FUTEX_SHARED_OWNERS_MASK))
+        {
+            new = old | SRWLOCK_FUTEX_EXCLUSIVE_LOCK_BIT;
+            ret = STATUS_SUCCESS;
+        }
+        else
+        {
+            new = old;
+            ret = STATUS_TIMEOUT;
+        }
+    } while (interlocked_cmpxchg( (int *)lock, new, old ) != old);
+
+    return ret;
+}
+
+static NTSTATUS fast_acquire_srw_exclusive( RTL_SRWLOCK *lock )
+{
+    BOOLEAN wait;
+    int old, new;
+
+    if (!use_futexes()) return STATUS_NOT_IMPLEMENTED;
+
+    /* Atomically increment the exclusive waiter count. */
+    do
+    {
+        old = *(int *)lock;
+        new = old + SRWLOCK_FUTEX_EXCLUSIVE_WAITERS_INC;
+        if (!(new & SRWLOCK_FUTEX_EXCLUSIVE_WAITERS_MASK))
+            RtlRaiseStatus( STATUS_RESOURCE_NOT_OWNED );
+    } while (interlocked_cmpxchg( (int *)lock, new, old ) != old);
+
+    for (;;)
+    {
+        do
+        {
+            old = *(int *)lock;
+
+            if (!(old & SRWLOCK_FUTEX_EXCLUSIVE_LOCK_BIT) && !(old & SRWLOCK_FUTEX_SHARED_OWNERS_MASK))
+            {
+                /* Not locked exclusive or shared. We can try to grab it. */
+                new = (old | SRWLOCK_FUTEX_EXCLUSIVE_LOCK_BIT) - SRWLOCK_FUTEX_EXCLUSIVE_WAITERS_INC;
+                wait = FALSE;
+            }
+            else
+            {
+                new = old;
+                wait = TRUE;
+            }
+        } while (interlocked_cmpxchg( (int *)lock, new, old ) != old);
+
+        if (!wait) return STATUS_SUCCESS;
+
+        if (!srwlock_spin( lock, new ))
+            futex_wait_bitset( (int *)lock, new, SRWLOCK_FUTEX_BITSET_EXCLUSIVE );
+    }
+}
+
+static NTSTATUS fast_try_acquire_srw_shared( RTL_SRWLOCK *lock )
+{
+    int old, new;
+    NTSTATUS ret;
+
+    if (!use_futexes()) return STATUS_NOT_IMPLEMENTED;
+
+    do
+    {
+        old = *(int *)lock;
+
+        if (!(old & SRWLOCK_FUTEX_EXCLUSIVE_LOCK_BIT) && !(old & SRWLOCK_FUTEX_EXCLUSIVE_WAITERS_MASK))
+        {
+            new = old + SRWLOCK_FUTEX_SHARED_OWNERS_INC;
+            if (!(new & SRWLOCK_FUTEX_SHARED_OWNERS_MASK))
+                RtlRaiseStatus( STATUS_RESOURCE_NOT_OWNED );
+            ret = STATUS_SUCCESS;
+        }
+        else
+        {
+            new = old;
+            ret = STATUS_TIMEOUT;
+        }
+    } while (interlocked_cmpxchg( (int *)lock, new, old ) != old);
+
+    return ret;
+}
+
+static NTSTATUS fast_acquire_srw_shared( RTL_SRWLOCK *lock )
+{
+    BOOLEAN wait;
+    int old, new;
+
+    if (!use_futexes()) return STATUS_NOT_IMPLEMENTED;
+
+    for (;;)
+    {
+        do
+        {
+            old = *(int *)lock;
+
+            /* Exclusive waiters have priority, like in the keyed event
+             * implementation. */
+            if (!(old & SRWLOCK_FUTEX_EXCLUSIVE_LOCK_BIT) && !(old & SRWLOCK_FUTEX_EXCLUSIVE_WAITERS_MASK))
+            {
+                new = old + SRWLOCK_FUTEX_SHARED_OWNERS_INC;
+                if (!(new & SRWLOCK_FUTEX_SHARED_OWNERS_MASK))
+                    RtlRaiseStatus( STATUS_RESOURCE_NOT_OWNED );
+                wait = FALSE;
+            }
+            else
+            {
+                new = old | SRWLOCK_FUTEX_SHARED_WAITERS_BIT;
+                wait = TRUE;
+            }
+        } while (interlocked_cmpxchg( (int *)lock, new, old ) != old);
+
+        if (!wait) return STATUS_SUCCESS;
+
+        if (!srwlock_spin( lock, new ))
+            futex_wait_bitset( (int *)lock, new, SRWLOCK_FUTEX_BITSET_SHARED );
+    }
+}
+
+static NTSTATUS fast_release_srw_exclusive( RTL_SRWLOCK *lock )
+{
+    int old, new;
+
+    if (!use_futexes()) return STATUS_NOT_IMPLEMENTED;
+
+    do
+    {
+        old = *(int *)lock;
+
+        if (!(old & SRWLOCK_FUTEX_EXCLUSIVE_LOCK_BIT))
+        {
+            ERR("Lock %p is not owned exclusive! (%#x)\n", lock, old);
+            return STATUS_RESOURCE_NOT_OWNED;
+        }
+
+        new = old & ~SRWLOCK_FUTEX_EXCLUSIVE_LOCK_BIT;
+
+        if (!(new & SRWLOCK_FUTEX_EXCLUSIVE_WAITERS_MASK))
+            new &= ~SRWLOCK_FUTEX_SHARED_WAITERS_BIT;
+    } while (interlocked_cmpxchg( (int *)lock, new, old ) != old);
+
+    if (new & SRWLOCK_FUTEX_EXCLUSIVE_WAITERS_MASK)
+        futex_wake_bitset( (int *)lock, 1, SRWLOCK_FUTEX_BITSET_EXCLUSIVE );
+    else if (old & SRWLOCK_FUTEX_SHARED_WAITERS_BIT)
+        futex_wake_bitset( (int *)lock, INT_MAX, SRWLOCK_FUTEX_BITSET_SHARED );
+
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS fast_release_srw_shared( RTL_SRWLOCK *lock )
+{
+    int old, new;
+
+    if (!use_futexes()) return STATUS_NOT_IMPLEMENTED;
+
+    do
+    {
+        old = *(int *)lock;
+
+        if (old & SRWLOCK_FUTEX_EXCLUSIVE_LOCK_BIT)
+        {
+            ERR("Lock %p is owned exclusive! (%#x)\n", lock, old);
+            return STATUS_RESOURCE_NOT_OWNED;
+        }
+        else if (!(old & SRWLOCK_FUTEX_SHARED_OWNERS_MASK))
+        {
+            ERR("Lock %p is not owned shared! (%#x)\n", lock, old);
+            return STATUS_RESOURCE_NOT_OWNED;
+        }
+
+        new = old - SRWLOCK_FUTEX_SHARED_OWNERS_INC;
+    } while (interlocked_cmpxchg( (int *)lock, new, old ) != old);
+
+    /* Only the last shared owner needs to wake up an exclusive waiter. */
+    if (!(new & SRWLOCK_FUTEX_SHARED_OWNERS_MASK) && (new & SRWLOCK_FUTEX_EXCLUSIVE_WAITERS_MASK))
+        futex_wake_bitset( (int *)lock, 1, SRWLOCK_FUTEX_BITSET_EXCLUSIVE );
+
+    return STATUS_SUCCESS;
+}
+
+/* Futex-based condition variables just use the variable as a sequence
+ * number; waking increments it, so that a thread which read the old value
+ * before releasing the lock can't miss the wakeup. */
+
+static NTSTATUS fast_wait_cv( RTL_CONDITION_VARIABLE *variable, int val, const LARGE_INTEGER *timeout )
+{
+    struct timespec timespec;
+    int ret;
+
+    if (timeout && timeout->QuadPart != TIMEOUT_INFINITE)
+    {
+        timespec_from_timeout( &timespec, timeout );
+        ret = futex_wait( (int *)&variable->Ptr, val, &timespec );
+    }
+    else
+        ret = futex_wait( (int *)&variable->Ptr, val, NULL );
+
+    if (ret == -1 && errno == ETIMEDOUT) return STATUS_TIMEOUT;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS fast_wake_cv( RTL_CONDITION_VARIABLE *variable, int count )
+{
+    if (!use_futexes()) return STATUS_NOT_IMPLEMENTED;
+
+    interlocked_xchg_add( (int *)&variable->Ptr, 1 );
+    futex_wake( (int *)&variable->Ptr, count );
+    return STATUS_SUCCESS;
+}
+
+#else
+
+static NTSTATUS fast_try_acquire_srw_exclusive( RTL_SRWLOCK *lock )
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+
+static NTSTATUS fast_acquire_srw_exclusive( RTL_SRWLOCK *lock )
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+
+static NTSTATUS fast_try_acquire_srw_shared( RTL_SRWLOCK *lock )
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+
+static NTSTATUS fast_acquire_srw_shared( RTL_SRWLOCK *lock )
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+
+static NTSTATUS fast_release_srw_exclusive( RTL_SRWLOCK *lock )
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+
+static NTSTATUS fast_release_srw_shared( RTL_SRWLOCK *lock )
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+
+static NTSTATUS fast_wait_cv( RTL_CONDITION_VARIABLE *variable, int val, const LARGE_INTEGER *timeout )
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+
+static NTSTATUS fast_wake_cv( RTL_CONDITION_VARIABLE *variable, int count )
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+
+#endif
+
 #define SRWLOCK_MASK_IN_EXCLUSIVE     0x80000000
 #define SRWLOCK_MASK_EXCLUSIVE_QUEUE  0x7fff0000
 #define SRWLOCK_MASK_SHARED_QUEUE     0x0000ffff
@@ -1732,7 +2507,8 @@ static inline void srwlock_leave_shared( RTL_SRWLOCK *lock, unsigned int val )
  *  It doesn't make any difference which thread for example unlocks an
  *  SRWLock (see corresponding tests). This implementation uses two
  *  keyed events (one for the exclusive waiters and one for the shared
- *  waiters) and is limited to 2^15-1 waiting threads.
+ *  waiters) and is limited to 2^15-1 waiting threads. On Linux futexes
+ *  are used instead, if available.
  */
 void WINAPI RtlInitializeSRWLock( RTL_SRWLOCK *lock )
 {
@@ -1749,6 +2525,9 @@ void WINAPI RtlInitializeSRWLock( RTL_SRWLOCK *lock )
  */
 void WINAPI RtlAcquireSRWLockExclusive( RTL_SRWLOCK *lock )
 {
+    if (fast_acquire_srw_exclusive( lock ) != STATUS_NOT_IMPLEMENTED)
+        return;
+
     if (srwlock_lock_exclusive( (unsigned int *)&lock->Ptr, SRWLOCK_RES_EXCLUSIVE ))
         NtWaitForKeyedEvent( keyed_event, srwlock_key_exclusive(lock), FALSE, NULL );
 }
@@ -1763,6 +2542,10 @@ void WINAPI RtlAcquireSRWLockExclusive( RTL_SRWLOCK *lock )
 void WINAPI RtlAcquireSRWLockShared( RTL_SRWLOCK *lock )
 {
     unsigned int val, tmp;
+
+    if (fast_acquire_srw_shared( lock ) != STATUS_NOT_IMPLEMENTED)
+        return;
+
     /* Acquires a shared lock. If it's currently not possible to add elements to
      * the shared queue, then request exclusive access instead. */
     for (val = *(unsigned int *)&lock->Ptr;; val = tmp)
@@ -1793,6 +2576,9 @@ void WINAPI RtlAcquireSRWLockShared( RTL_SRWLOCK *lock )
  */
 void WINAPI RtlReleaseSRWLockExclusive( RTL_SRWLOCK *lock )
 {
+    if (fast_release_srw_exclusive( lock ) != STATUS_NOT_IMPLEMENTED)
+        return;
+
     srwlock_leave_exclusive( lock, srwlock_unlock_exclusive( (unsigned int *)&lock->Ptr,
                              - SRWLOCK_RES_EXCLUSIVE ) - SRWLOCK_RES_EXCLUSIVE );
 }
@@ -1802,6 +2588,9 @@ void WINAPI RtlReleaseSRWLockExclusive( RTL_SRWLOCK *lock )
  */
 void WINAPI RtlReleaseSRWLockShared( RTL_SRWLOCK *lock )
 {
+    if (fast_release_srw_shared( lock ) != STATUS_NOT_IMPLEMENTED)
+        return;
+
     srwlock_leave_shared( lock, srwlock_lock_exclusive( (unsigned int *)&lock->Ptr,
                           - SRWLOCK_RES_SHARED ) - SRWLOCK_RES_SHARED );
 }
@@ -1815,6 +2604,11 @@ void WINAPI RtlReleaseSRWLockShared( RTL_SRWLOCK *lock )
  */
 BOOLEAN WINAPI RtlTryAcquireSRWLockExclusive( RTL_SRWLOCK *lock )
 {
+    NTSTATUS ret;
+
+    if ((ret = fast_try_acquire_srw_exclusive( lock )) != STATUS_NOT_IMPLEMENTED)
+        return (ret == STATUS_SUCCESS);
+
     return interlocked_cmpxchg( (int *)&lock->Ptr, SRWLOCK_MASK_IN_EXCLUSIVE |
                                 SRWLOCK_RES_EXCLUSIVE, 0 ) == 0;
 }
@@ -1825,6 +2619,11 @@ BOOLEAN WINAPI RtlTryAcquireSRWLockExclusive( RTL_SRWLOCK *lock )
 BOOLEAN WINAPI RtlTryAcquireSRWLockShared( RTL_SRWLOCK *lock )
 {
     unsigned int val, tmp;
+    NTSTATUS ret;
+
+    if ((ret = fast_try_acquire_srw_shared( lock )) != STATUS_NOT_IMPLEMENTED)
+        return (ret == STATUS_SUCCESS);
+
     for (val = *(unsigned int *)&lock->Ptr;; val = tmp)
     {
         if (val & SRWLOCK_MASK_EXCLUSIVE_QUEUE)
@@ -1868,6 +2667,9 @@ void WINAPI RtlInitializeConditionVariable( RTL_CONDITION_VARIABLE *variable )
  */
 void WINAPI RtlWakeConditionVariable( RTL_CONDITION_VARIABLE *variable )
 {
+    if (fast_wake_cv( variable, 1 ) != STATUS_NOT_IMPLEMENTED)
+        return;
+
     if (interlocked_dec_if_nonzero( (int *)&variable->Ptr ))
         NtReleaseKeyedEvent( keyed_event, &variable->Ptr, FALSE, NULL );
 }
@@ -1879,7 +2681,12 @@ void WINAPI RtlWakeConditionVariable( RTL_CONDITION_VARIABLE *variable )
  */
 void WINAPI RtlWakeAllConditionVariable( RTL_CONDITION_VARIABLE *variable )
 {
-    int val = interlocked_xchg( (int *)&variable->Ptr, 0 );
+    int val;
+
+    if (fast_wake_cv( variable, INT_MAX ) != STATUS_NOT_IMPLEMENTED)
+        return;
+
+    val = interlocked_xchg( (int *)&variable->Ptr, 0 );
     while (val-- > 0)
         NtReleaseKeyedEvent( keyed_event, &variable->Ptr, FALSE, NULL );
 }
@@ -1903,6 +2710,17 @@ NTSTATUS WINAPI RtlSleepConditionVariableCS( RTL_CONDITION_VARIABLE *variable, R
                                              const LARGE_INTEGER *timeout )
 {
     NTSTATUS status;
+
+    if (use_futexes())
+    {
+        int val = *(int *)&variable->Ptr;
+
+        RtlLeaveCriticalSection( crit );
+        status = fast_wait_cv( variable, val, timeout );
+        RtlEnterCriticalSection( crit );
+        return status;
+    }
+
     interlocked_xchg_add( (int *)&variable->Ptr, 1 );
     RtlLeaveCriticalSection( crit );
 
@@ -1940,15 +2758,18 @@ NTSTATUS WINAPI RtlSleepConditionVariableSRW( RTL_CONDITION_VARIABLE *variable,
                                               const LARGE_INTEGER *timeout, ULONG flags )
 {
     NTSTATUS status;
-    interlocked_xchg_add( (int *)&variable->Ptr, 1 );
+    int val = *(int *)&variable->Ptr;
+
+    if (!use_futexes()) interlocked_xchg_add( (int *)&variable->Ptr, 1 );
 
     if (flags & RTL_CONDITION_VARIABLE_LOCKMODE_SHARED)
         RtlReleaseSRWLockShared( lock );
     else
         RtlReleaseSRWLockExclusive( lock );
 
-    status = NtWaitForKeyedEvent( keyed_event, &variable->Ptr, FALSE, timeout );
-    if (status != STATUS_SUCCESS)
+    if (use_futexes())
+        status = fast_wait_cv( variable, val, timeout );
+    else if ((status = NtWaitForKeyedEvent( keyed_event, &variable->Ptr, FALSE, timeout )))
     {
         if (!interlocked_dec_if_nonzero( (int *)&variable->Ptr ))
             status = NtWaitForKeyedEvent( keyed_event, &variable->Ptr, FALSE, NULL );
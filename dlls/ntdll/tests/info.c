@@ -271,7 +271,7 @@ static void test_query_process(void)
     DWORD last_pid;
     ULONG ReturnLength;
     int i = 0, k = 0;
-    BOOL is_nt = FALSE;
+    BOOL is_nt = FALSE, found_self = FALSE;
     SYSTEM_BASIC_INFORMATION sbi;
 
     /* Copy of our winternl.h structure turned into a private one */
@@ -367,12 +367,27 @@ static void test_query_process(void)
             }
         }
 
+        if (!is_nt && spi->UniqueProcessId == ULongToHandle( GetCurrentProcessId() ))
+        {
+            DWORD j;
+
+            found_self = TRUE;
+            ok( spi->ftCreationTime.dwLowDateTime || spi->ftCreationTime.dwHighDateTime,
+                "Expected a creation time for the current process\n" );
+            ok( spi->vmCounters.WorkingSetSize > 0, "Expected a working set for the current process\n" );
+            ok( spi->vmCounters.VirtualSize > 0, "Expected virtual memory for the current process\n" );
+            for (j = 0; j < spi->dwThreadCount; j++)
+                if (spi->ti[j].ClientId.UniqueThread == ULongToHandle( GetCurrentThreadId() )) break;
+            ok( j < spi->dwThreadCount, "Current thread not found\n" );
+        }
+
         if (!spi->NextEntryOffset) break;
 
         one_before_last_pid = last_pid;
 
         spi = (SYSTEM_PROCESS_INFORMATION_PRIVATE*)((char*)spi + spi->NextEntryOffset);
     }
+    ok( found_self || is_nt, "Current process not found\n" );
     trace("Total number of running processes : %d\n", i);
     if (!is_nt) trace("Total number of running threads   : %d\n", k);
 
@@ -1979,6 +1979,39 @@ static void test_mutant(void)
     NtClose( mutant );
 }
 
+static void test_many_names(void)
+{
+    HANDLE handles[2000], h;
+    char name[64];
+    unsigned int i;
+
+    /* enough names to grow the directory hash table a few times */
+    for (i = 0; i < ARRAY_SIZE(handles); i++)
+    {
+        sprintf( name, "om.c-many-names-%u", i );
+        handles[i] = CreateEventA( NULL, FALSE, FALSE, name );
+        ok( handles[i] != 0, "%u: CreateEvent failed err %u\n", i, GetLastError() );
+    }
+    for (i = 0; i < ARRAY_SIZE(handles); i += 2) CloseHandle( handles[i] );
+    for (i = 0; i < ARRAY_SIZE(handles); i++)
+    {
+        sprintf( name, "om.c-many-names-%u", i );
+        SetLastError( 0xdeadbeef );
+        h = OpenEventA( EVENT_ALL_ACCESS, FALSE, name );
+        if (i % 2)
+        {
+            ok( h != 0, "%u: OpenEvent failed err %u\n", i, GetLastError() );
+            CloseHandle( h );
+            CloseHandle( handles[i] );
+        }
+        else
+        {
+            ok( !h, "%u: OpenEvent succeeded\n", i );
+            ok( GetLastError() == ERROR_FILE_NOT_FOUND, "%u: wrong error %u\n", i, GetLastError() );
+        }
+    }
+}
+
 START_TEST(om)
 {
     HMODULE hntdll = GetModuleHandleA("ntdll.dll");
@@ -2042,6 +2075,7 @@ START_TEST(om)
     test_type_mismatch();
     test_event();
     test_mutant();
+    test_many_names();
     test_keyed_events();
     test_null_device();
 }
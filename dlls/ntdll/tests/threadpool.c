@@ -22,6 +22,7 @@
 
 static HMODULE hntdll = 0;
 static NTSTATUS (WINAPI *pTpAllocCleanupGroup)(TP_CLEANUP_GROUP **);
+static NTSTATUS (WINAPI *pTpAllocIoCompletion)(TP_IO **,HANDLE,PTP_IO_CALLBACK,void *,TP_CALLBACK_ENVIRON *);
 static NTSTATUS (WINAPI *pTpAllocPool)(TP_POOL **,PVOID);
 static NTSTATUS (WINAPI *pTpAllocTimer)(TP_TIMER **,PTP_TIMER_CALLBACK,PVOID,TP_CALLBACK_ENVIRON *);
 static NTSTATUS (WINAPI *pTpAllocWait)(TP_WAIT **,PTP_WAIT_CALLBACK,PVOID,TP_CALLBACK_ENVIRON *);
@@ -33,6 +34,7 @@ static BOOL     (WINAPI *pTpIsTimerSet)(TP_TIMER *);
 static VOID     (WINAPI *pTpReleaseWait)(TP_WAIT *);
 static VOID     (WINAPI *pTpPostWork)(TP_WORK *);
 static VOID     (WINAPI *pTpReleaseCleanupGroup)(TP_CLEANUP_GROUP *);
+static VOID     (WINAPI *pTpReleaseIoCompletion)(TP_IO *);
 static VOID     (WINAPI *pTpReleaseCleanupGroupMembers)(TP_CLEANUP_GROUP *,BOOL,PVOID);
 static VOID     (WINAPI *pTpReleasePool)(TP_POOL *);
 static VOID     (WINAPI *pTpReleaseTimer)(TP_TIMER *);
@@ -41,6 +43,8 @@ static VOID     (WINAPI *pTpSetPoolMaxThreads)(TP_POOL *,DWORD);
 static VOID     (WINAPI *pTpSetTimer)(TP_TIMER *,LARGE_INTEGER *,LONG,LONG);
 static VOID     (WINAPI *pTpSetWait)(TP_WAIT *,HANDLE,LARGE_INTEGER *);
 static NTSTATUS (WINAPI *pTpSimpleTryPost)(PTP_SIMPLE_CALLBACK,PVOID,TP_CALLBACK_ENVIRON *);
+static VOID     (WINAPI *pTpStartAsyncIoOperation)(TP_IO *);
+static VOID     (WINAPI *pTpWaitForIoCompletion)(TP_IO *,BOOL);
 static VOID     (WINAPI *pTpWaitForTimer)(TP_TIMER *,BOOL);
 static VOID     (WINAPI *pTpWaitForWait)(TP_WAIT *,BOOL);
 static VOID     (WINAPI *pTpWaitForWork)(TP_WORK *,BOOL);
@@ -63,6 +67,7 @@ static BOOL init_threadpool(void)
     }
 
     NTDLL_GET_PROC(TpAllocCleanupGroup);
+    NTDLL_GET_PROC(TpAllocIoCompletion);
     NTDLL_GET_PROC(TpAllocPool);
     NTDLL_GET_PROC(TpAllocTimer);
     NTDLL_GET_PROC(TpAllocWait);
@@ -73,6 +78,7 @@ static BOOL init_threadpool(void)
     NTDLL_GET_PROC(TpIsTimerSet);
     NTDLL_GET_PROC(TpPostWork);
     NTDLL_GET_PROC(TpReleaseCleanupGroup);
+    NTDLL_GET_PROC(TpReleaseIoCompletion);
     NTDLL_GET_PROC(TpReleaseCleanupGroupMembers);
     NTDLL_GET_PROC(TpReleasePool);
     NTDLL_GET_PROC(TpReleaseTimer);
@@ -82,6 +88,8 @@ static BOOL init_threadpool(void)
     NTDLL_GET_PROC(TpSetTimer);
     NTDLL_GET_PROC(TpSetWait);
     NTDLL_GET_PROC(TpSimpleTryPost);
+    NTDLL_GET_PROC(TpStartAsyncIoOperation);
+    NTDLL_GET_PROC(TpWaitForIoCompletion);
     NTDLL_GET_PROC(TpWaitForTimer);
     NTDLL_GET_PROC(TpWaitForWait);
     NTDLL_GET_PROC(TpWaitForWork);
@@ -705,6 +713,80 @@ static void test_tp_work_scheduler(void)
     pTpReleasePool(pool);
 }
 
+static LONG priority_order;
+
+static void CALLBACK priority_block_cb(TP_CALLBACK_INSTANCE *instance, void *userdata)
+{
+    HANDLE event = userdata;
+    DWORD result;
+
+    trace("Running priority block callback\n");
+    result = WaitForSingleObject(event, 1000);
+    ok(result == WAIT_OBJECT_0, "WaitForSingleObject returned %u\n", result);
+}
+
+static void CALLBACK priority_cb(TP_CALLBACK_INSTANCE *instance, void *userdata)
+{
+    trace("Running priority callback %u\n", PtrToUlong(userdata));
+    priority_order = priority_order * 10 + PtrToUlong(userdata);
+}
+
+static void test_tp_work_priority(void)
+{
+    TP_CALLBACK_ENVIRON_V3 environment;
+    TP_CLEANUP_GROUP *group;
+    NTSTATUS status;
+    HANDLE event;
+    TP_POOL *pool;
+
+    event = CreateEventA(NULL, FALSE, FALSE, NULL);
+    ok(event != NULL, "CreateEventA failed %u\n", GetLastError());
+
+    /* allocate new threadpool with only one thread */
+    pool = NULL;
+    status = pTpAllocPool(&pool, NULL);
+    ok(!status, "TpAllocPool failed with status %x\n", status);
+    ok(pool != NULL, "expected pool != NULL\n");
+    pTpSetPoolMaxThreads(pool, 1);
+
+    group = NULL;
+    status = pTpAllocCleanupGroup(&group);
+    ok(!status, "TpAllocCleanupGroup failed with status %x\n", status);
+    ok(group != NULL, "expected group != NULL\n");
+
+    memset(&environment, 0, sizeof(environment));
+    environment.Version = 3;
+    environment.Pool = pool;
+    environment.CleanupGroup = group;
+    environment.CallbackPriority = TP_CALLBACK_PRIORITY_NORMAL;
+    environment.Size = sizeof(environment);
+
+    /* keep the only worker thread busy while the callbacks are queued */
+    status = pTpSimpleTryPost(priority_block_cb, event, (TP_CALLBACK_ENVIRON *)&environment);
+    ok(!status, "TpSimpleTryPost failed with status %x\n", status);
+    Sleep(100);
+
+    priority_order = 0;
+    environment.CallbackPriority = TP_CALLBACK_PRIORITY_LOW;
+    status = pTpSimpleTryPost(priority_cb, ULongToPtr(3), (TP_CALLBACK_ENVIRON *)&environment);
+    ok(!status, "TpSimpleTryPost failed with status %x\n", status);
+    environment.CallbackPriority = TP_CALLBACK_PRIORITY_NORMAL;
+    status = pTpSimpleTryPost(priority_cb, ULongToPtr(2), (TP_CALLBACK_ENVIRON *)&environment);
+    ok(!status, "TpSimpleTryPost failed with status %x\n", status);
+    environment.CallbackPriority = TP_CALLBACK_PRIORITY_HIGH;
+    status = pTpSimpleTryPost(priority_cb, ULongToPtr(1), (TP_CALLBACK_ENVIRON *)&environment);
+    ok(!status, "TpSimpleTryPost failed with status %x\n", status);
+
+    SetEvent(event);
+    pTpReleaseCleanupGroupMembers(group, FALSE, NULL);
+    ok(priority_order == 123, "expected order 123, got %u\n", priority_order);
+
+    /* cleanup */
+    pTpReleaseCleanupGroup(group);
+    pTpReleasePool(pool);
+    CloseHandle(event);
+}
+
 static void CALLBACK simple_release_cb(TP_CALLBACK_INSTANCE *instance, void *userdata)
 {
     HANDLE *semaphores = userdata;
@@ -1897,6 +1979,127 @@ static void test_tp_multi_wait(void)
     CloseHandle(semaphore);
 }
 
+static DWORD WINAPI io_wait_thread(void *arg)
+{
+    TP_IO *io = arg;
+    pTpWaitForIoCompletion(io, FALSE);
+    return 0;
+}
+
+struct io_cb_ctx
+{
+    unsigned int count;
+    void *ovl;
+    NTSTATUS status;
+    ULONG_PTR information;
+    TP_IO *io;
+};
+
+static void CALLBACK io_cb(TP_CALLBACK_INSTANCE *instance, void *userdata,
+                           void *cvalue, IO_STATUS_BLOCK *iosb, TP_IO *io)
+{
+    struct io_cb_ctx *ctx = userdata;
+    ++ctx->count;
+    ctx->ovl = cvalue;
+    ctx->status = iosb->Status;
+    ctx->information = iosb->Information;
+    ctx->io = io;
+}
+
+static void test_tp_io(void)
+{
+    static const char out[1] = {'x'};
+    TP_CALLBACK_ENVIRON environment;
+    OVERLAPPED ovl, ovl2;
+    HANDLE client, server, thread;
+    struct io_cb_ctx userdata;
+    char in[1], in2[1];
+    NTSTATUS status;
+    DWORD ret_size;
+    TP_POOL *pool;
+    TP_IO *io;
+    BOOL ret;
+
+    if (!pTpAllocIoCompletion)
+    {
+        win_skip("TpAllocIoCompletion is not available\n");
+        return;
+    }
+
+    memset(&ovl, 0, sizeof(ovl));
+    memset(&ovl2, 0, sizeof(ovl2));
+    ovl.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+
+    status = pTpAllocPool(&pool, NULL);
+    ok(!status, "failed to allocate pool, status %#x\n", status);
+
+    server = CreateNamedPipeA("\\\\.\\pipe\\wine_tp_test",
+            PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED, 0, 1, 1024, 1024, 0, NULL);
+    ok(server != INVALID_HANDLE_VALUE, "Failed to create server pipe, error %u.\n", GetLastError());
+    client = CreateFileA("\\\\.\\pipe\\wine_tp_test", GENERIC_READ | GENERIC_WRITE,
+            0, NULL, OPEN_EXISTING, 0, 0);
+    ok(client != INVALID_HANDLE_VALUE, "Failed to create client pipe, error %u.\n", GetLastError());
+
+    memset(&environment, 0, sizeof(environment));
+    environment.Version = 1;
+    environment.Pool = pool;
+    io = NULL;
+    status = pTpAllocIoCompletion(&io, server, io_cb, &userdata, &environment);
+    ok(!status, "got %#x\n", status);
+    ok(!!io, "expected non-NULL TP_IO\n");
+
+    pTpWaitForIoCompletion(io, FALSE);
+
+    userdata.count = 0;
+    pTpStartAsyncIoOperation(io);
+
+    thread = CreateThread(NULL, 0, io_wait_thread, io, 0, NULL);
+    ok(WaitForSingleObject(thread, 100) == WAIT_TIMEOUT, "TpWaitForIoCompletion() should not return\n");
+
+    ret = ReadFile(server, in, sizeof(in), NULL, &ovl);
+    ok(!ret, "wrong ret %d\n", ret);
+    ok(GetLastError() == ERROR_IO_PENDING, "wrong error %u\n", GetLastError());
+
+    ret = WriteFile(client, out, sizeof(out), &ret_size, NULL);
+    ok(ret, "WriteFile() failed, error %u\n", GetLastError());
+
+    pTpWaitForIoCompletion(io, FALSE);
+    ok(userdata.count == 1, "callback ran %u times\n", userdata.count);
+    ok(userdata.ovl == &ovl, "expected %p, got %p\n", &ovl, userdata.ovl);
+    ok(userdata.status == STATUS_SUCCESS, "got status %#x\n", userdata.status);
+    ok(userdata.information == 1, "got information %lu\n", userdata.information);
+    ok(userdata.io == io, "expected %p, got %p\n", io, userdata.io);
+
+    ok(!WaitForSingleObject(thread, 1000), "wait timed out\n");
+    CloseHandle(thread);
+
+    /* several completions are dispatched to the same object */
+    userdata.count = 0;
+    pTpStartAsyncIoOperation(io);
+    pTpStartAsyncIoOperation(io);
+
+    ret = ReadFile(server, in, sizeof(in), NULL, &ovl);
+    ok(!ret, "wrong ret %d\n", ret);
+    ret = ReadFile(server, in2, sizeof(in2), NULL, &ovl2);
+    ok(!ret, "wrong ret %d\n", ret);
+
+    ret = WriteFile(client, out, sizeof(out), &ret_size, NULL);
+    ok(ret, "WriteFile() failed, error %u\n", GetLastError());
+    ret = WriteFile(client, out, sizeof(out), &ret_size, NULL);
+    ok(ret, "WriteFile() failed, error %u\n", GetLastError());
+
+    pTpWaitForIoCompletion(io, FALSE);
+    ok(userdata.count == 2, "callback ran %u times\n", userdata.count);
+    ok(userdata.status == STATUS_SUCCESS, "got status %#x\n", userdata.status);
+    ok(userdata.information == 1, "got information %lu\n", userdata.information);
+
+    CloseHandle(client);
+    CloseHandle(server);
+    CloseHandle(ovl.hEvent);
+    pTpReleaseIoCompletion(io);
+    pTpReleasePool(pool);
+}
+
 START_TEST(threadpool)
 {
     test_RtlQueueWorkItem();
@@ -1908,6 +2111,7 @@ START_TEST(threadpool)
     test_tp_simple();
     test_tp_work();
     test_tp_work_scheduler();
+    test_tp_work_priority();
     test_tp_group_wait();
     test_tp_group_cancel();
     test_tp_instance();
@@ -1916,4 +2120,5 @@ START_TEST(threadpool)
     test_tp_window_length();
     test_tp_wait();
     test_tp_multi_wait();
+    test_tp_io();
 }
@@ -27,6 +27,8 @@
 static VOID (WINAPI *pRtlTimeToTimeFields)( const LARGE_INTEGER *liTime, PTIME_FIELDS TimeFields) ;
 static VOID (WINAPI *pRtlTimeFieldsToTime)(  PTIME_FIELDS TimeFields,  PLARGE_INTEGER Time) ;
 static NTSTATUS (WINAPI *pNtQueryPerformanceCounter)( LARGE_INTEGER *counter, LARGE_INTEGER *frequency );
+static NTSTATUS (WINAPI *pNtQueryTimerResolution)( ULONG *min_res, ULONG *max_res, ULONG *current_res );
+static NTSTATUS (WINAPI *pNtSetTimerResolution)( ULONG resolution, BOOLEAN set, ULONG *current_res );
 static NTSTATUS (WINAPI *pRtlQueryTimeZoneInformation)( RTL_TIME_ZONE_INFORMATION *);
 static NTSTATUS (WINAPI *pRtlQueryDynamicTimeZoneInformation)( RTL_DYNAMIC_TIME_ZONE_INFORMATION *);
 
@@ -117,6 +119,36 @@ static void test_NtQueryPerformanceCounter(void)
     ok(status == STATUS_SUCCESS, "expected STATUS_SUCCESS, got %08x\n", status);
 }
 
+static void test_TimerResolution(void)
+{
+    ULONG min_res, max_res, cur_res, res;
+    NTSTATUS status;
+
+    if (!pNtQueryTimerResolution || !pNtSetTimerResolution)
+    {
+        win_skip("NtQueryTimerResolution or NtSetTimerResolution not available\n");
+        return;
+    }
+
+    status = pNtQueryTimerResolution( &min_res, &max_res, &cur_res );
+    ok( status == STATUS_SUCCESS, "NtQueryTimerResolution failed %x\n", status );
+    ok( min_res >= max_res, "min %u max %u\n", min_res, max_res );
+    ok( cur_res <= min_res && cur_res >= max_res, "cur %u min %u max %u\n", cur_res, min_res, max_res );
+
+    status = pNtSetTimerResolution( 10000, TRUE, &res );
+    ok( status == STATUS_SUCCESS, "NtSetTimerResolution failed %x\n", status );
+    ok( res <= 10000 && res >= max_res, "got %u\n", res );
+
+    status = pNtQueryTimerResolution( &min_res, &max_res, &cur_res );
+    ok( status == STATUS_SUCCESS, "NtQueryTimerResolution failed %x\n", status );
+    ok( cur_res == res, "got %u, expected %u\n", cur_res, res );
+
+    status = pNtSetTimerResolution( 0, FALSE, &res );
+    ok( status == STATUS_SUCCESS, "NtSetTimerResolution failed %x\n", status );
+    status = pNtSetTimerResolution( 0, FALSE, &res );
+    ok( status == STATUS_TIMER_RESOLUTION_NOT_SET, "got %x\n", status );
+}
+
 static void test_RtlQueryTimeZoneInformation(void)
 {
     RTL_DYNAMIC_TIME_ZONE_INFORMATION tzinfo;
@@ -159,6 +191,8 @@ START_TEST(time)
     pRtlTimeToTimeFields = (void *)GetProcAddress(mod,"RtlTimeToTimeFields");
     pRtlTimeFieldsToTime = (void *)GetProcAddress(mod,"RtlTimeFieldsToTime");
     pNtQueryPerformanceCounter = (void *)GetProcAddress(mod, "NtQueryPerformanceCounter");
+    pNtQueryTimerResolution = (void *)GetProcAddress(mod, "NtQueryTimerResolution");
+    pNtSetTimerResolution = (void *)GetProcAddress(mod, "NtSetTimerResolution");
     pRtlQueryTimeZoneInformation =
         (void *)GetProcAddress(mod, "RtlQueryTimeZoneInformation");
     pRtlQueryDynamicTimeZoneInformation =
@@ -169,5 +203,6 @@ START_TEST(time)
     else
         win_skip("Required time conversion functions are not available\n");
     test_NtQueryPerformanceCounter();
+    test_TimerResolution();
     test_RtlQueryTimeZoneInformation();
 }
@@ -281,7 +281,6 @@ HANDLE thread_init(void)
     BOOL suspend;
     SIZE_T size, info_size;
     HANDLE exe_file = 0;
-    LARGE_INTEGER now;
     NTSTATUS status;
     struct ntdll_thread_data *thread_data;
     static struct debug_info debug_info;  /* debug info for initial thread */
@@ -359,6 +358,7 @@ HANDLE thread_init(void)
     thread_data->debug_info = &debug_info;
     thread_data->esync_queue_fd = -1;
     thread_data->esync_apc_fd = -1;
+    thread_data->esync_epoll = NULL;
 
     signal_init_thread( teb );
     virtual_init_threading();
@@ -395,14 +395,7 @@ HANDLE thread_init(void)
             wine_server_fd_to_handle( 2, GENERIC_WRITE|SYNCHRONIZE, OBJ_INHERIT, &params.hStdError );
     }
 
-    /* initialize time values in user_shared_data */
-    NtQuerySystemTime( &now );
-    user_shared_data->SystemTime.LowPart = now.u.LowPart;
-    user_shared_data->SystemTime.High1Time = user_shared_data->SystemTime.High2Time = now.u.HighPart;
-    user_shared_data->u.TickCountQuad = (now.QuadPart - server_start_time) / 10000;
-    user_shared_data->u.TickCount.High2Time = user_shared_data->u.TickCount.High1Time;
-    user_shared_data->TickCountLowDeprecated = user_shared_data->u.TickCount.LowPart;
-    user_shared_data->TickCountMultiplier = 1 << 24;
+    init_shared_time();
 
     fill_cpu_info();
 
@@ -452,6 +445,7 @@ void abort_thread( int status )
  */
 void exit_thread( int status )
 {
+    if (do_esync()) esync_exit_thread();
     close( ntdll_get_thread_data()->wait_fd[0] );
     close( ntdll_get_thread_data()->wait_fd[1] );
     close( ntdll_get_thread_data()->reply_fd );
@@ -488,6 +482,9 @@ void WINAPI RtlExitUserThread( ULONG status )
 
     LdrShutdownThread();
     RtlFreeThreadActivationContextStack();
+    heap_thread_detach();
+    relay_thread_detach();
+    debug_thread_detach();
 
     pthread_sigmask( SIG_BLOCK, &server_block_set, NULL );
 
@@ -655,6 +652,7 @@ NTSTATUS WINAPI RtlCreateUserThread( HANDLE process, const SECURITY_DESCRIPTOR *
     thread_data->start_stack = (char *)teb->Tib.StackBase;
     thread_data->esync_queue_fd = -1;
     thread_data->esync_apc_fd = -1;
+    thread_data->esync_epoll = NULL;
 
     pthread_attr_init( &attr );
     pthread_attr_setstack( &attr, teb->DeallocationStack,
@@ -1309,6 +1307,26 @@ NTSTATUS WINAPI NtSetInformationThread( HANDLE handle, THREADINFOCLASS class,
             SERVER_END_REQ;
         }
         return status;
+    case ThreadIdealProcessor:
+        {
+            ULONG ideal;
+
+            if (length != sizeof(ULONG)) return STATUS_INFO_LENGTH_MISMATCH;
+            ideal = *(const ULONG *)data;
+            if (ideal > MAXIMUM_PROCESSORS) return STATUS_INVALID_PARAMETER;
+            SERVER_START_REQ( set_thread_info )
+            {
+                req->handle = wine_server_obj_handle( handle );
+                req->ideal_processor = ideal;
+                /* MAXIMUM_PROCESSORS only queries the current value */
+                req->mask   = ideal == MAXIMUM_PROCESSORS ? 0 : SET_THREAD_INFO_IDEAL;
+                status = wine_server_call( req );
+                /* the previous ideal processor is returned as the status */
+                if (!status) status = reply->prev_ideal;
+            }
+            SERVER_END_REQ;
+        }
+        return status;
     case ThreadHideFromDebugger:
         /* pretend the call succeeded to satisfy some code protectors */
         return STATUS_SUCCESS;
@@ -1361,7 +1379,6 @@ NTSTATUS WINAPI NtSetInformationThread( HANDLE handle, THREADINFOCLASS class,
     case ThreadEventPair_Reusable:
     case ThreadPerformanceCount:
     case ThreadAmILastThread:
-    case ThreadIdealProcessor:
     case ThreadPriorityBoost:
     case ThreadSetTlsArrayAddress:
     case ThreadIsIoPending:
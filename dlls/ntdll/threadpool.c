@@ -84,11 +84,28 @@ struct wait_work_item
     BOOLEAN CallbackInProgress;
 };
 
+/* binary min-heap of pending timers, sorted by expiration time */
+#define HEAP_NOT_QUEUED (~0u)
+
+struct heap_entry
+{
+    ULONGLONG key;              /* expiration time */
+    unsigned int index;         /* position in the heap, or HEAP_NOT_QUEUED */
+};
+
+struct timer_heap
+{
+    struct heap_entry **entries;
+    unsigned int count;
+    unsigned int size;
+};
+
 struct timer_queue;
 struct queue_timer
 {
     struct timer_queue *q;
-    struct list entry;
+    struct list entry;          /* entry in the list of all timers */
+    struct heap_entry heap_entry; /* entry in the heap of pending timers */
     ULONG runcount;             /* number of callbacks pending execution */
     RTL_WAITORTIMERCALLBACKFUNC callback;
     PVOID param;
@@ -103,7 +120,8 @@ struct timer_queue
 {
     DWORD magic;
     RTL_CRITICAL_SECTION cs;
-    struct list timers;         /* sorted by expiration time */
+    struct list timers;         /* list of all timers */
+    struct timer_heap pending;  /* pending timers, sorted by expiration time */
     BOOL quit;                  /* queue should be deleted; once set, never unset */
     HANDLE event;
     HANDLE thread;
@@ -123,8 +141,8 @@ struct threadpool
     LONG                    objcount;
     BOOL                    shutdown;
     CRITICAL_SECTION        cs;
-    /* pool of work items, locked via .cs */
-    struct list             pool;
+    /* pools of work items, one per callback priority, locked via .cs */
+    struct list             pools[TP_CALLBACK_PRIORITY_COUNT];
     RTL_CONDITION_VARIABLE  update_event;
     /* information about worker threads, locked via .cs */
     int                     max_workers;
@@ -138,12 +156,20 @@ enum threadpool_objtype
     TP_OBJECT_TYPE_SIMPLE,
     TP_OBJECT_TYPE_WORK,
     TP_OBJECT_TYPE_TIMER,
-    TP_OBJECT_TYPE_WAIT
+    TP_OBJECT_TYPE_WAIT,
+    TP_OBJECT_TYPE_IO
+};
+
+struct io_completion
+{
+    IO_STATUS_BLOCK         iosb;
+    ULONG_PTR               cvalue;
 };
 
 /* internal threadpool object representation */
 struct threadpool_object
 {
+    void                   *win32_callback; /* leave space for kernel32 to store the win32 callback */
     LONG                    refcount;
     BOOL                    shutdown;
     /* read-only information */
@@ -155,6 +181,7 @@ struct threadpool_object
     PTP_SIMPLE_CALLBACK     finalization_callback;
     BOOL                    may_run_long;
     HMODULE                 race_dll;
+    TP_CALLBACK_PRIORITY    priority;
     /* information about the group, locked via .group->cs */
     struct list             group_entry;
     BOOL                    is_group_member;
@@ -182,7 +209,7 @@ struct threadpool_object
             /* information about the timer, locked via timerqueue.cs */
             BOOL            timer_initialized;
             BOOL            timer_pending;
-            struct list     timer_entry;
+            struct heap_entry timer_entry;
             BOOL            timer_set;
             ULONGLONG       timeout;
             LONG            period;
@@ -199,6 +226,15 @@ struct threadpool_object
             ULONGLONG       timeout;
             HANDLE          handle;
         } wait;
+        struct
+        {
+            PTP_IO_CALLBACK callback;
+            /* information about the I/O operations, locked via .pool->cs */
+            unsigned int    pending_count;
+            unsigned int    completion_count;
+            unsigned int    completion_max;
+            struct io_completion *completions;
+        } io;
     } u;
 };
 
@@ -238,7 +274,8 @@ static struct
     CRITICAL_SECTION        cs;
     LONG                    objcount;
     BOOL                    thread_running;
-    struct list             pending_timers;
+    struct timer_heap       pending_timers;
+    ULONGLONG               wakeup;
     RTL_CONDITION_VARIABLE  update_event;
 }
 timerqueue =
@@ -246,7 +283,8 @@ timerqueue =
     { &timerqueue_debug, -1, 0, 0, 0, 0 },      /* cs */
     0,                                          /* objcount */
     FALSE,                                      /* thread_running */
-    LIST_INIT( timerqueue.pending_timers ),     /* pending_timers */
+    { NULL, 0, 0 },                             /* pending_timers */
+    TIMEOUT_INFINITE,                           /* wakeup */
     RTL_CONDITION_VARIABLE_INIT                 /* update_event */
 };
 
@@ -280,6 +318,34 @@ static RTL_CRITICAL_SECTION_DEBUG waitqueue_debug =
       0, 0, { (DWORD_PTR)(__FILE__ ": waitqueue.cs") }
 };
 
+/* global I/O completion queue object */
+static RTL_CRITICAL_SECTION_DEBUG ioqueue_debug;
+
+static struct
+{
+    CRITICAL_SECTION        cs;
+    LONG                    objcount;
+    BOOL                    thread_running;
+    HANDLE                  port;
+}
+ioqueue =
+{
+    { &ioqueue_debug, -1, 0, 0, 0, 0 },         /* cs */
+    0,                                          /* objcount */
+    FALSE,                                      /* thread_running */
+    NULL                                        /* port */
+};
+
+static RTL_CRITICAL_SECTION_DEBUG ioqueue_debug =
+{
+    0, 0, &ioqueue.cs,
+    { &ioqueue_debug.ProcessLocksList, &ioqueue_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": ioqueue.cs") }
+};
+
+/* maximum number of completions dequeued at once by the I/O completion thread */
+#define IOQUEUE_BATCH_SIZE 16
+
 struct waitqueue_bucket
 {
     struct list             bucket_entry;
@@ -315,6 +381,13 @@ static inline struct threadpool_object *impl_from_TP_WAIT( TP_WAIT *wait )
     return object;
 }
 
+static inline struct threadpool_object *impl_from_TP_IO( TP_IO *io )
+{
+    struct threadpool_object *object = (struct threadpool_object *)io;
+    assert( object->type == TP_OBJECT_TYPE_IO );
+    return object;
+}
+
 static inline struct threadpool_group *impl_from_TP_CLEANUP_GROUP( TP_CLEANUP_GROUP *group )
 {
     return (struct threadpool_group *)group;
@@ -407,23 +480,26 @@ static DWORD CALLBACK iocp_poller(LPVOID Arg)
 
     while( TRUE )
     {
-        PRTL_OVERLAPPED_COMPLETION_ROUTINE callback;
-        LPVOID overlapped;
-        IO_STATUS_BLOCK iosb;
-        NTSTATUS res = NtRemoveIoCompletion( cport, (PULONG_PTR)&callback, (PULONG_PTR)&overlapped, &iosb, NULL );
+        FILE_IO_COMPLETION_INFORMATION info[IOQUEUE_BATCH_SIZE];
+        ULONG i, count;
+        NTSTATUS res = NtRemoveIoCompletionEx( cport, info, ARRAY_SIZE(info), &count, NULL, FALSE );
         if (res)
         {
-            ERR("NtRemoveIoCompletion failed: 0x%x\n", res);
+            ERR("NtRemoveIoCompletionEx failed: 0x%x\n", res);
+            continue;
         }
-        else
+
+        for (i = 0; i < count; i++)
         {
+            PRTL_OVERLAPPED_COMPLETION_ROUTINE callback = (void *)info[i].CompletionKey;
+            LPVOID overlapped = (void *)info[i].CompletionValue;
             DWORD transferred = 0;
             DWORD err = 0;
 
-            if (iosb.u.Status == STATUS_SUCCESS)
-                transferred = iosb.Information;
+            if (info[i].IoStatusBlock.u.Status == STATUS_SUCCESS)
+                transferred = info[i].IoStatusBlock.Information;
             else
-                err = RtlNtStatusToDosError(iosb.u.Status);
+                err = RtlNtStatusToDosError(info[i].IoStatusBlock.u.Status);
 
             callback( err, transferred, overlapped );
         }
@@ -699,6 +775,102 @@ NTSTATUS WINAPI RtlDeregisterWait(HANDLE WaitHandle)
 }
 
 
+/************************** Timer Heap Impl **************************/
+
+static inline BOOL heap_queued( const struct heap_entry *entry )
+{
+    return entry->index != HEAP_NOT_QUEUED;
+}
+
+static inline struct heap_entry *heap_top( const struct timer_heap *heap )
+{
+    return heap->count ? heap->entries[0] : NULL;
+}
+
+/* make sure that the heap can hold the given number of entries */
+static BOOL heap_reserve( struct timer_heap *heap, unsigned int count )
+{
+    struct heap_entry **entries;
+    unsigned int size;
+
+    if (count <= heap->size) return TRUE;
+
+    size = max( count, max( 16, heap->size * 2 ) );
+    if (heap->entries)
+        entries = RtlReAllocateHeap( GetProcessHeap(), 0, heap->entries, size * sizeof(*entries) );
+    else
+        entries = RtlAllocateHeap( GetProcessHeap(), 0, size * sizeof(*entries) );
+    if (!entries) return FALSE;
+
+    heap->entries = entries;
+    heap->size = size;
+    return TRUE;
+}
+
+static inline void heap_set( struct timer_heap *heap, unsigned int index, struct heap_entry *entry )
+{
+    heap->entries[index] = entry;
+    entry->index = index;
+}
+
+static void heap_sift_up( struct timer_heap *heap, unsigned int index, struct heap_entry *entry )
+{
+    unsigned int parent;
+
+    while (index)
+    {
+        parent = (index - 1) / 2;
+        if (heap->entries[parent]->key <= entry->key) break;
+        heap_set( heap, index, heap->entries[parent] );
+        index = parent;
+    }
+    heap_set( heap, index, entry );
+}
+
+static void heap_sift_down( struct timer_heap *heap, unsigned int index, struct heap_entry *entry )
+{
+    unsigned int child;
+
+    while ((child = 2 * index + 1) < heap->count)
+    {
+        if (child + 1 < heap->count && heap->entries[child + 1]->key < heap->entries[child]->key)
+            child++;
+        if (entry->key <= heap->entries[child]->key) break;
+        heap_set( heap, index, heap->entries[child] );
+        index = child;
+    }
+    heap_set( heap, index, entry );
+}
+
+/* insert an entry, space for it must have been reserved with heap_reserve */
+static void heap_insert( struct timer_heap *heap, struct heap_entry *entry, ULONGLONG key )
+{
+    assert( heap->count < heap->size );
+    assert( !heap_queued( entry ) );
+
+    entry->key = key;
+    heap_sift_up( heap, heap->count++, entry );
+}
+
+static void heap_remove( struct timer_heap *heap, struct heap_entry *entry )
+{
+    unsigned int index = entry->index;
+    struct heap_entry *last;
+
+    assert( heap_queued( entry ) );
+    entry->index = HEAP_NOT_QUEUED;
+
+    last = heap->entries[--heap->count];
+    if (last == entry) return;
+
+    /* move the last entry into the hole and restore the heap order */
+    if (index && heap->entries[(index - 1) / 2]->key > last->key)
+        heap_sift_up( heap, index, last );
+    else
+        heap_sift_down( heap, index, last );
+}
+
+
 /************************** Timer Queue Impl **************************/
 
 static void queue_remove_timer(struct queue_timer *t)
@@ -712,6 +884,8 @@ static void queue_remove_timer(struct queue_timer *t)
     assert(t->destroy);
 
     list_remove(&t->entry);
+    if (heap_queued(&t->heap_entry))
+        heap_remove(&q->pending, &t->heap_entry);
     if (t->event)
         NtSetEvent(t->event, NULL);
     RtlFreeHeap(GetProcessHeap(), 0, t);
@@ -752,26 +926,21 @@ static inline ULONGLONG queue_current_time(void)
 static void queue_add_timer(struct queue_timer *t, ULONGLONG time,
                             BOOL set_event)
 {
-    /* We MUST hold the queue cs while calling this function.  */
+    /* We MUST hold the queue cs while calling this function.  The heap
+       has room for every timer, it is grown when the timer is created.  */
     struct timer_queue *q = t->q;
-    struct list *ptr = &q->timers;
 
     assert(!q->quit || (t->destroy && time == EXPIRE_NEVER));
 
-    if (time != EXPIRE_NEVER)
-        LIST_FOR_EACH(ptr, &q->timers)
-        {
-            struct queue_timer *cur = LIST_ENTRY(ptr, struct queue_timer, entry);
-            if (time < cur->expire)
-                break;
-        }
-    list_add_before(ptr, &t->entry);
-
     t->expire = time;
+    if (time == EXPIRE_NEVER)
+        return;
+
+    heap_insert(&q->pending, &t->heap_entry, time);
 
-    /* If we insert at the head of the list, we need to expire sooner
+    /* If we insert at the top of the heap, we need to expire sooner
        than expected.  */
-    if (set_event && &t->entry == list_head(&q->timers))
+    if (set_event && heap_top(&q->pending) == &t->heap_entry)
         NtSetEvent(q->event, NULL);
 }
 
@@ -779,19 +948,21 @@ static inline void queue_move_timer(struct queue_timer *t, ULONGLONG time,
                                     BOOL set_event)
 {
     /* We MUST hold the queue cs while calling this function.  */
-    list_remove(&t->entry);
+    if (heap_queued(&t->heap_entry))
+        heap_remove(&t->q->pending, &t->heap_entry);
     queue_add_timer(t, time, set_event);
 }
 
 static void queue_timer_expire(struct timer_queue *q)
 {
     struct queue_timer *t = NULL;
+    struct heap_entry *entry;
 
     RtlEnterCriticalSection(&q->cs);
-    if (list_head(&q->timers))
+    if ((entry = heap_top(&q->pending)))
     {
         ULONGLONG now, next;
-        t = LIST_ENTRY(list_head(&q->timers), struct queue_timer, entry);
+        t = CONTAINING_RECORD(entry, struct queue_timer, heap_entry);
         if (!t->destroy && t->expire <= ((now = queue_current_time())))
         {
             ++t->runcount;
@@ -831,19 +1002,18 @@ static void queue_timer_expire(struct timer_queue *q)
 static ULONG queue_get_timeout(struct timer_queue *q)
 {
     struct queue_timer *t;
+    struct heap_entry *entry;
     ULONG timeout = INFINITE;
 
     RtlEnterCriticalSection(&q->cs);
-    if (list_head(&q->timers))
+    if ((entry = heap_top(&q->pending)))
     {
-        t = LIST_ENTRY(list_head(&q->timers), struct queue_timer, entry);
-        assert(!t->destroy || t->expire == EXPIRE_NEVER);
+        ULONGLONG time = queue_current_time();
 
-        if (t->expire != EXPIRE_NEVER)
-        {
-            ULONGLONG time = queue_current_time();
-            timeout = t->expire < time ? 0 : t->expire - time;
-        }
+        t = CONTAINING_RECORD(entry, struct queue_timer, heap_entry);
+        assert(!t->destroy && t->expire != EXPIRE_NEVER);
+
+        timeout = t->expire < time ? 0 : t->expire - time;
     }
     RtlLeaveCriticalSection(&q->cs);
 
@@ -888,6 +1058,7 @@ static void WINAPI timer_queue_thread_proc(LPVOID p)
     NtClose(q->event);
     RtlDeleteCriticalSection(&q->cs);
     q->magic = 0;
+    RtlFreeHeap(GetProcessHeap(), 0, q->pending.entries);
     RtlFreeHeap(GetProcessHeap(), 0, q);
     RtlExitUserThread( 0 );
 }
@@ -902,8 +1073,8 @@ static void queue_destroy_timer(struct queue_timer *t)
            cleanup wrapper.  */
         queue_remove_timer(t);
     else
-        /* Make sure no destroyed timer masks an active timer at the head
-           of the sorted list.  */
+        /* Make sure no destroyed timer masks an active timer at the top
+           of the heap.  */
         queue_move_timer(t, EXPIRE_NEVER, FALSE);
 }
 
@@ -928,6 +1099,9 @@ NTSTATUS WINAPI RtlCreateTimerQueue(PHANDLE NewTimerQueue)
 
     RtlInitializeCriticalSection(&q->cs);
     list_init(&q->timers);
+    q->pending.entries = NULL;
+    q->pending.count = 0;
+    q->pending.size = 0;
     q->quit = FALSE;
     q->magic = TIMER_QUEUE_MAGIC;
     status = NtCreateEvent(&q->event, EVENT_ALL_ACCESS, NULL, SynchronizationEvent, FALSE);
@@ -1083,13 +1257,19 @@ NTSTATUS WINAPI RtlCreateTimer(PHANDLE NewTimer, HANDLE TimerQueue,
     t->flags = Flags;
     t->destroy = FALSE;
     t->event = NULL;
+    t->heap_entry.index = HEAP_NOT_QUEUED;
 
     status = STATUS_SUCCESS;
     RtlEnterCriticalSection(&q->cs);
     if (q->quit)
         status = STATUS_INVALID_HANDLE;
+    else if (!heap_reserve(&q->pending, q->pending.count + 1))
+        status = STATUS_NO_MEMORY;
     else
+    {
+        list_add_tail(&q->timers, &t->entry);
         queue_add_timer(t, queue_current_time() + DueTime, TRUE);
+    }
     RtlLeaveCriticalSection(&q->cs);
 
     if (status == STATUS_SUCCESS)
@@ -1194,15 +1374,62 @@ NTSTATUS WINAPI RtlDeleteTimer(HANDLE TimerQueue, HANDLE Timer,
     return status;
 }
 
+/***********************************************************************
+ *           timerqueue_get_deadline    (internal)
+ *
+ * Returns the earliest time (timeout plus window length) at which one
+ * of the pending timers in the heap subtree has to be signaled. Only
+ * timers expiring before the current deadline need to be visited.
+ */
+static void timerqueue_get_deadline( unsigned int index, ULONGLONG *deadline )
+{
+    struct threadpool_object *timer;
+    struct heap_entry *entry;
+    ULONGLONG new_deadline;
+
+    if (index >= timerqueue.pending_timers.count) return;
+    entry = timerqueue.pending_timers.entries[index];
+    if (entry->key >= *deadline) return;
+
+    timer = CONTAINING_RECORD( entry, struct threadpool_object, u.timer.timer_entry );
+    assert( timer->type == TP_OBJECT_TYPE_TIMER );
+    new_deadline = entry->key + (ULONGLONG)timer->u.timer.window_length * 10000;
+    if (new_deadline < *deadline) *deadline = new_deadline;
+
+    timerqueue_get_deadline( 2 * index + 1, deadline );
+    timerqueue_get_deadline( 2 * index + 2, deadline );
+}
+
+/***********************************************************************
+ *           timerqueue_get_latest    (internal)
+ *
+ * Returns the latest timeout of the pending timers in the heap subtree
+ * that doesn't exceed the deadline, so that all of them can be handled
+ * with a single wakeup.
+ */
+static void timerqueue_get_latest( unsigned int index, ULONGLONG deadline, ULONGLONG *latest )
+{
+    struct heap_entry *entry;
+
+    if (index >= timerqueue.pending_timers.count) return;
+    entry = timerqueue.pending_timers.entries[index];
+    if (entry->key > deadline) return;
+
+    if (entry->key > *latest) *latest = entry->key;
+
+    timerqueue_get_latest( 2 * index + 1, deadline, latest );
+    timerqueue_get_latest( 2 * index + 2, deadline, latest );
+}
+
 /***********************************************************************
  *           timerqueue_thread_proc    (internal)
  */
 static void CALLBACK timerqueue_thread_proc( void *param )
 {
-    ULONGLONG timeout_lower, timeout_upper, new_timeout;
-    struct threadpool_object *other_timer;
+    ULONGLONG timeout_lower, timeout_upper;
+    struct threadpool_object *timer;
     LARGE_INTEGER now, timeout;
-    struct list *ptr;
+    struct heap_entry *entry;
 
     TRACE( "starting timer queue thread\n" );
 
@@ -1212,16 +1439,16 @@ static void CALLBACK timerqueue_thread_proc( void *param )
         NtQuerySystemTime( &now );
 
         /* Check for expired timers. */
-        while ((ptr = list_head( &timerqueue.pending_timers )))
+        while ((entry = heap_top( &timerqueue.pending_timers )))
         {
-            struct threadpool_object *timer = LIST_ENTRY( ptr, struct threadpool_object, u.timer.timer_entry );
+            timer = CONTAINING_RECORD( entry, struct threadpool_object, u.timer.timer_entry );
             assert( timer->type == TP_OBJECT_TYPE_TIMER );
             assert( timer->u.timer.timer_pending );
             if (timer->u.timer.timeout > now.QuadPart)
                 break;
 
             /* Queue a new callback in one of the worker threads. */
-            list_remove( &timer->u.timer.timer_entry );
+            heap_remove( &timerqueue.pending_timers, &timer->u.timer.timer_entry );
             timer->u.timer.timer_pending = FALSE;
             tp_object_submit( timer, FALSE );
 
@@ -1232,36 +1459,24 @@ static void CALLBACK timerqueue_thread_proc( void *param )
                 if (timer->u.timer.timeout <= now.QuadPart)
                     timer->u.timer.timeout = now.QuadPart + 1;
 
-                LIST_FOR_EACH_ENTRY( other_timer, &timerqueue.pending_timers,
-                                     struct threadpool_object, u.timer.timer_entry )
-                {
-                    assert( other_timer->type == TP_OBJECT_TYPE_TIMER );
-                    if (timer->u.timer.timeout < other_timer->u.timer.timeout)
-                        break;
-                }
-                list_add_before( &other_timer->u.timer.timer_entry, &timer->u.timer.timer_entry );
+                heap_insert( &timerqueue.pending_timers, &timer->u.timer.timer_entry,
+                             timer->u.timer.timeout );
                 timer->u.timer.timer_pending = TRUE;
             }
         }
 
+        /* Determine next timeout and use the window length to optimize wakeup times. */
         timeout_lower = TIMEOUT_INFINITE;
         timeout_upper = TIMEOUT_INFINITE;
-
-        /* Determine next timeout and use the window length to optimize wakeup times. */
-        LIST_FOR_EACH_ENTRY( other_timer, &timerqueue.pending_timers,
-                             struct threadpool_object, u.timer.timer_entry )
+        if (timerqueue.pending_timers.count)
         {
-            assert( other_timer->type == TP_OBJECT_TYPE_TIMER );
-            if (other_timer->u.timer.timeout >= timeout_upper)
-                break;
-
-            timeout_lower = other_timer->u.timer.timeout;
-            new_timeout   = timeout_lower + (ULONGLONG)other_timer->u.timer.window_length * 10000;
-            if (new_timeout < timeout_upper)
-                timeout_upper = new_timeout;
+            timerqueue_get_deadline( 0, &timeout_upper );
+            timeout_lower = 0;
+            timerqueue_get_latest( 0, timeout_upper, &timeout_lower );
         }
 
         /* Wait for timer update events or until the next timer expires. */
+        timerqueue.wakeup = timeout_lower;
         if (timerqueue.objcount)
         {
             timeout.QuadPart = timeout_lower;
@@ -1321,6 +1536,7 @@ static NTSTATUS tp_timerqueue_lock( struct threadpool_object *timer )
 
     timer->u.timer.timer_initialized    = FALSE;
     timer->u.timer.timer_pending        = FALSE;
+    timer->u.timer.timer_entry.index    = HEAP_NOT_QUEUED;
     timer->u.timer.timer_set            = FALSE;
     timer->u.timer.timeout              = 0;
     timer->u.timer.period               = 0;
@@ -1328,8 +1544,12 @@ static NTSTATUS tp_timerqueue_lock( struct threadpool_object *timer )
 
     RtlEnterCriticalSection( &timerqueue.cs );
 
+    /* Make sure that the timer can always be queued without allocations. */
+    if (!heap_reserve( &timerqueue.pending_timers, timerqueue.objcount + 1 ))
+        status = STATUS_NO_MEMORY;
+
     /* Make sure that the timerqueue thread is running. */
-    if (!timerqueue.thread_running)
+    if (!status && !timerqueue.thread_running)
     {
         HANDLE thread;
         status = RtlCreateUserThread( GetCurrentProcess(), NULL, FALSE, NULL, 0, 0,
@@ -1366,14 +1586,14 @@ static void tp_timerqueue_unlock( struct threadpool_object *timer )
         /* If timer was pending, remove it. */
         if (timer->u.timer.timer_pending)
         {
-            list_remove( &timer->u.timer.timer_entry );
+            heap_remove( &timerqueue.pending_timers, &timer->u.timer.timer_entry );
             timer->u.timer.timer_pending = FALSE;
         }
 
         /* If the last timer object was destroyed, then wake up the thread. */
         if (!--timerqueue.objcount)
         {
-            assert( list_empty( &timerqueue.pending_timers ) );
+            assert( !timerqueue.pending_timers.count );
             RtlWakeAllConditionVariable( &timerqueue.update_event );
         }
 
@@ -1631,6 +1851,208 @@ static void tp_waitqueue_unlock( struct threadpool_object *wait )
     RtlLeaveCriticalSection( &waitqueue.cs );
 }
 
+/***********************************************************************
+ *           object_is_finished    (internal)
+ *
+ * Returns TRUE if all callbacks of an object (or all running callbacks
+ * for a group wait) have finished. Must be called with pool->cs held.
+ */
+static BOOL object_is_finished( struct threadpool_object *object, BOOL group )
+{
+    if (object->num_pending_callbacks)
+        return FALSE;
+    if (object->type == TP_OBJECT_TYPE_IO && object->u.io.pending_count)
+        return FALSE;
+
+    if (group)
+        return !object->num_running_callbacks;
+    else
+        return !object->num_associated_callbacks;
+}
+
+/***********************************************************************
+ *           tp_io_complete    (internal)
+ *
+ * Queues a completion packet received for an I/O object and submits
+ * the callback to the threadpool.
+ */
+static void tp_io_complete( struct threadpool_object *io, const FILE_IO_COMPLETION_INFORMATION *info )
+{
+    struct threadpool *pool = io->pool;
+    struct io_completion *completion;
+    unsigned int new_max;
+    BOOL release = FALSE;
+
+    RtlEnterCriticalSection( &pool->cs );
+
+    if (!io->u.io.pending_count)
+    {
+        WARN( "unexpected completion for io %p\n", io );
+        RtlLeaveCriticalSection( &pool->cs );
+        return;
+    }
+
+    io->u.io.pending_count--;
+    release = TRUE;
+
+    if (io->shutdown)
+    {
+        TRACE( "io %p already released, dropping completion\n", io );
+        goto done;
+    }
+
+    if (io->u.io.completion_count == io->u.io.completion_max)
+    {
+        new_max = max( 4, io->u.io.completion_max * 2 );
+        if (io->u.io.completions)
+            completion = RtlReAllocateHeap( GetProcessHeap(), 0, io->u.io.completions,
+                                            new_max * sizeof(*completion) );
+        else
+            completion = RtlAllocateHeap( GetProcessHeap(), 0, new_max * sizeof(*completion) );
+        if (!completion)
+        {
+            ERR( "failed to allocate completion for io %p\n", io );
+            goto done;
+        }
+        io->u.io.completions    = completion;
+        io->u.io.completion_max = new_max;
+    }
+
+    completion = &io->u.io.completions[io->u.io.completion_count++];
+    completion->iosb   = info->IoStatusBlock;
+    completion->cvalue = info->CompletionValue;
+    tp_object_submit( io, FALSE );
+
+done:
+    if (object_is_finished( io, TRUE ))
+        RtlWakeAllConditionVariable( &io->group_finished_event );
+    if (object_is_finished( io, FALSE ))
+        RtlWakeAllConditionVariable( &io->finished_event );
+    RtlLeaveCriticalSection( &pool->cs );
+
+    /* drop the reference taken by TpStartAsyncIoOperation */
+    if (release) tp_object_release( io );
+}
+
+/***********************************************************************
+ *           ioqueue_thread_proc    (internal)
+ */
+static void CALLBACK ioqueue_thread_proc( void *param )
+{
+    FILE_IO_COMPLETION_INFORMATION info[IOQUEUE_BATCH_SIZE];
+    struct threadpool_object *io;
+    ULONG i, count;
+    NTSTATUS status;
+
+    TRACE( "starting I/O completion thread\n" );
+
+    for (;;)
+    {
+        /* Fetch a batch of completions at once; packets without key are
+         * only used to wake up the thread. */
+        status = NtRemoveIoCompletionEx( ioqueue.port, info, ARRAY_SIZE(info), &count, NULL, FALSE );
+        if (status)
+        {
+            ERR( "NtRemoveIoCompletionEx failed: %x\n", status );
+            count = 0;
+        }
+
+        for (i = 0; i < count; i++)
+        {
+            if ((io = (struct threadpool_object *)info[i].CompletionKey))
+                tp_io_complete( io, &info[i] );
+        }
+
+        RtlEnterCriticalSection( &ioqueue.cs );
+        if (!ioqueue.objcount)
+            break;
+        RtlLeaveCriticalSection( &ioqueue.cs );
+    }
+
+    /* All I/O objects have been destroyed, terminate the thread. */
+    NtClose( ioqueue.port );
+    ioqueue.port = NULL;
+    ioqueue.thread_running = FALSE;
+    RtlLeaveCriticalSection( &ioqueue.cs );
+
+    TRACE( "terminating I/O completion thread\n" );
+    RtlExitUserThread( 0 );
+}
+
+/***********************************************************************
+ *           tp_ioqueue_lock    (internal)
+ *
+ * Associates a file with the global I/O completion port. When the lock
+ * is acquired successfully, it is guaranteed that the I/O completion
+ * thread is running.
+ */
+static NTSTATUS tp_ioqueue_lock( struct threadpool_object *io, HANDLE file )
+{
+    FILE_COMPLETION_INFORMATION info;
+    IO_STATUS_BLOCK iosb;
+    NTSTATUS status = STATUS_SUCCESS;
+    HANDLE thread;
+    assert( io->type == TP_OBJECT_TYPE_IO );
+
+    RtlEnterCriticalSection( &ioqueue.cs );
+
+    if (!ioqueue.port)
+        status = NtCreateIoCompletion( &ioqueue.port, IO_COMPLETION_ALL_ACCESS, NULL, 0 );
+
+    /* Make sure that the I/O completion thread is running. */
+    if (!status && !ioqueue.thread_running)
+    {
+        status = RtlCreateUserThread( GetCurrentProcess(), NULL, FALSE, NULL, 0, 0,
+                                      ioqueue_thread_proc, NULL, &thread, NULL );
+        if (status == STATUS_SUCCESS)
+        {
+            ioqueue.thread_running = TRUE;
+            NtClose( thread );
+        }
+    }
+
+    if (!status)
+    {
+        info.CompletionPort = ioqueue.port;
+        info.CompletionKey  = (ULONG_PTR)io;
+        status = NtSetInformationFile( file, &iosb, &info, sizeof(info), FileCompletionInformation );
+    }
+
+    if (!status)
+        ioqueue.objcount++;
+    else if (!ioqueue.objcount && ioqueue.port)
+    {
+        /* nothing uses the completion port, shut it down again */
+        if (ioqueue.thread_running)
+            NtSetIoCompletion( ioqueue.port, 0, 0, STATUS_SUCCESS, 0 );
+        else
+        {
+            NtClose( ioqueue.port );
+            ioqueue.port = NULL;
+        }
+    }
+
+    RtlLeaveCriticalSection( &ioqueue.cs );
+    return status;
+}
+
+/***********************************************************************
+ *           tp_ioqueue_unlock    (internal)
+ *
+ * Releases a lock on the global I/O completion queue, the thread
+ * is woken up to terminate when the last object is gone.
+ */
+static void tp_ioqueue_unlock( struct threadpool_object *io )
+{
+    assert( io->type == TP_OBJECT_TYPE_IO );
+
+    RtlEnterCriticalSection( &ioqueue.cs );
+    assert( ioqueue.objcount > 0 );
+    if (!--ioqueue.objcount)
+        NtSetIoCompletion( ioqueue.port, 0, 0, STATUS_SUCCESS, 0 );
+    RtlLeaveCriticalSection( &ioqueue.cs );
+}
+
 /***********************************************************************
  *           tp_threadpool_alloc    (internal)
  *
@@ -1639,6 +2061,7 @@ static void tp_waitqueue_unlock( struct threadpool_object *wait )
 static NTSTATUS tp_threadpool_alloc( struct threadpool **out )
 {
     struct threadpool *pool;
+    unsigned int i;
 
     pool = RtlAllocateHeap( GetProcessHeap(), 0, sizeof(*pool) );
     if (!pool)
@@ -1651,7 +2074,8 @@ static NTSTATUS tp_threadpool_alloc( struct threadpool **out )
     RtlInitializeCriticalSection( &pool->cs );
     pool->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": threadpool.cs");
 
-    list_init( &pool->pool );
+    for (i = 0; i < ARRAY_SIZE(pool->pools); i++)
+        list_init( &pool->pools[i] );
     RtlInitializeConditionVariable( &pool->update_event );
 
     pool->max_workers           = 500;
@@ -1687,6 +2111,8 @@ static void tp_threadpool_shutdown( struct threadpool *pool )
  */
 static BOOL tp_threadpool_release( struct threadpool *pool )
 {
+    unsigned int i;
+
     if (interlocked_dec( &pool->refcount ))
         return FALSE;
 
@@ -1694,7 +2120,8 @@ static BOOL tp_threadpool_release( struct threadpool *pool )
 
     assert( pool->shutdown );
     assert( !pool->objcount );
-    assert( list_empty( &pool->pool ) );
+    for (i = 0; i < ARRAY_SIZE(pool->pools); i++)
+        assert( list_empty( &pool->pools[i] ) );
 
     pool->cs.DebugInfo->Spare[0] = 0;
     RtlDeleteCriticalSection( &pool->cs );
@@ -1851,6 +2278,7 @@ static void tp_object_initialize( struct threadpool_object *object, struct threa
     object->finalization_callback   = NULL;
     object->may_run_long            = 0;
     object->race_dll                = NULL;
+    object->priority                = TP_CALLBACK_PRIORITY_NORMAL;
 
     memset( &object->group_entry, 0, sizeof(object->group_entry) );
     object->is_group_member         = FALSE;
@@ -1878,6 +2306,16 @@ static void tp_object_initialize( struct threadpool_object *object, struct threa
 
         if (environment->u.s.Persistent)
             FIXME( "persistent threads not supported yet\n" );
+
+        if (environment->Version == 3)
+        {
+            TP_CALLBACK_ENVIRON_V3 *environment3 = (TP_CALLBACK_ENVIRON_V3 *)environment;
+
+            if (environment3->CallbackPriority < TP_CALLBACK_PRIORITY_COUNT)
+                object->priority = environment3->CallbackPriority;
+            else
+                FIXME( "invalid callback priority %u\n", environment3->CallbackPriority );
+        }
     }
 
     if (object->race_dll)
@@ -1917,6 +2355,7 @@ static void tp_object_submit( struct threadpool_object *object, BOOL signaled )
 {
     struct threadpool *pool = object->pool;
     NTSTATUS status = STATUS_UNSUCCESSFUL;
+    BOOL wake = FALSE;
 
     assert( !object->shutdown );
     assert( !pool->shutdown );
@@ -1931,20 +2370,25 @@ static void tp_object_submit( struct threadpool_object *object, BOOL signaled )
     /* Queue work item and increment refcount. */
     interlocked_inc( &object->refcount );
     if (!object->num_pending_callbacks++)
-        list_add_tail( &pool->pool, &object->pool_entry );
+        list_add_tail( &pool->pools[object->priority], &object->pool_entry );
 
     /* Count how often the object was signaled. */
     if (object->type == TP_OBJECT_TYPE_WAIT && signaled)
         object->u.wait.signaled++;
 
-    /* No new thread started - wake up one existing thread. */
+    /* No new thread started - wake up one existing thread, unless all of them
+     * are busy anyway and will pick up the work item when they are done. */
     if (status != STATUS_SUCCESS)
     {
         assert( pool->num_workers > 0 );
-        RtlWakeConditionVariable( &pool->update_event );
+        wake = pool->num_busy_workers < pool->num_workers;
     }
 
     RtlLeaveCriticalSection( &pool->cs );
+
+    /* Wake up outside of the lock, so that the worker doesn't block on it
+     * right away. The pool is kept alive by the reference of the object. */
+    if (wake) RtlWakeConditionVariable( &pool->update_event );
 }
 
 /***********************************************************************
@@ -1966,6 +2410,8 @@ static void tp_object_cancel( struct threadpool_object *object )
 
         if (object->type == TP_OBJECT_TYPE_WAIT)
             object->u.wait.signaled = 0;
+        if (object->type == TP_OBJECT_TYPE_IO)
+            object->u.io.completion_count = 0;
     }
     RtlLeaveCriticalSection( &pool->cs );
 
@@ -1986,12 +2432,12 @@ static void tp_object_wait( struct threadpool_object *object, BOOL group_wait )
     RtlEnterCriticalSection( &pool->cs );
     if (group_wait)
     {
-        while (object->num_pending_callbacks || object->num_running_callbacks)
+        while (!object_is_finished( object, TRUE ))
             RtlSleepConditionVariableCS( &object->group_finished_event, &pool->cs, NULL );
     }
     else
     {
-        while (object->num_pending_callbacks || object->num_associated_callbacks)
+        while (!object_is_finished( object, FALSE ))
             RtlSleepConditionVariableCS( &object->finished_event, &pool->cs, NULL );
     }
     RtlLeaveCriticalSection( &pool->cs );
@@ -2008,6 +2454,8 @@ static void tp_object_prepare_shutdown( struct threadpool_object *object )
         tp_timerqueue_unlock( object );
     else if (object->type == TP_OBJECT_TYPE_WAIT)
         tp_waitqueue_unlock( object );
+    else if (object->type == TP_OBJECT_TYPE_IO)
+        tp_ioqueue_unlock( object );
 }
 
 /***********************************************************************
@@ -2048,10 +2496,33 @@ static BOOL tp_object_release( struct threadpool_object *object )
     if (object->race_dll)
         LdrUnloadDll( object->race_dll );
 
+    if (object->type == TP_OBJECT_TYPE_IO)
+        RtlFreeHeap( GetProcessHeap(), 0, object->u.io.completions );
+
     RtlFreeHeap( GetProcessHeap(), 0, object );
     return TRUE;
 }
 
+/***********************************************************************
+ *           threadpool_get_next_item    (internal)
+ *
+ * Returns the next pending object with the highest callback priority.
+ * Must be called with pool->cs held.
+ */
+static struct threadpool_object *threadpool_get_next_item( const struct threadpool *pool )
+{
+    struct list *ptr;
+    unsigned int i;
+
+    for (i = 0; i < ARRAY_SIZE(pool->pools); i++)
+    {
+        if ((ptr = list_head( &pool->pools[i] )))
+            return LIST_ENTRY( ptr, struct threadpool_object, pool_entry );
+    }
+
+    return NULL;
+}
+
 /***********************************************************************
  *           threadpool_worker_proc    (internal)
  */
@@ -2059,10 +2530,11 @@ static void CALLBACK threadpool_worker_proc( void *param )
 {
     TP_CALLBACK_INSTANCE *callback_instance;
     struct threadpool_instance instance;
+    struct threadpool_object *object;
     struct threadpool *pool = param;
+    struct io_completion completion;
     TP_WAIT_RESULT wait_result = 0;
     LARGE_INTEGER timeout;
-    struct list *ptr;
     NTSTATUS status;
 
     TRACE( "starting worker thread for pool %p\n", pool );
@@ -2071,16 +2543,15 @@ static void CALLBACK threadpool_worker_proc( void *param )
     pool->num_busy_workers--;
     for (;;)
     {
-        while ((ptr = list_head( &pool->pool )))
+        while ((object = threadpool_get_next_item( pool )))
         {
-            struct threadpool_object *object = LIST_ENTRY( ptr, struct threadpool_object, pool_entry );
             assert( object->num_pending_callbacks > 0 );
 
             /* If further pending callbacks are queued, move the work item to
              * the end of the pool list. Otherwise remove it from the pool. */
             list_remove( &object->pool_entry );
             if (--object->num_pending_callbacks)
-                list_add_tail( &pool->pool, &object->pool_entry );
+                list_add_tail( &pool->pools[object->priority], &object->pool_entry );
 
             /* For wait objects check if they were signaled or have timed out. */
             if (object->type == TP_OBJECT_TYPE_WAIT)
@@ -2089,6 +2560,16 @@ static void CALLBACK threadpool_worker_proc( void *param )
                 if (wait_result == WAIT_OBJECT_0) object->u.wait.signaled--;
             }
 
+            /* For I/O objects fetch the oldest queued completion. */
+            if (object->type == TP_OBJECT_TYPE_IO)
+            {
+                assert( object->u.io.completion_count > 0 );
+                completion = object->u.io.completions[0];
+                if (--object->u.io.completion_count)
+                    memmove( object->u.io.completions, object->u.io.completions + 1,
+                             object->u.io.completion_count * sizeof(completion) );
+            }
+
             /* Leave critical section and do the actual callback. */
             object->num_associated_callbacks++;
             object->num_running_callbacks++;
@@ -2146,6 +2627,17 @@ static void CALLBACK threadpool_worker_proc( void *param )
                     break;
                 }
 
+                case TP_OBJECT_TYPE_IO:
+                {
+                    TRACE( "executing I/O callback %p(%p, %p, %#lx, %p, %p)\n",
+                           object->u.io.callback, callback_instance, object->userdata,
+                           completion.cvalue, &completion.iosb, object );
+                    object->u.io.callback( callback_instance, object->userdata,
+                                           (void *)completion.cvalue, &completion.iosb, (TP_IO *)object );
+                    TRACE( "callback %p returned\n", object->u.io.callback );
+                    break;
+                }
+
                 default:
                     assert(0);
                     break;
@@ -2197,13 +2689,13 @@ static void CALLBACK threadpool_worker_proc( void *param )
             }
 
             object->num_running_callbacks--;
-            if (!object->num_pending_callbacks && !object->num_running_callbacks)
+            if (object_is_finished( object, TRUE ))
                 RtlWakeAllConditionVariable( &object->group_finished_event );
 
             if (instance.associated)
             {
                 object->num_associated_callbacks--;
-                if (!object->num_pending_callbacks && !object->num_associated_callbacks)
+                if (object_is_finished( object, FALSE ))
                     RtlWakeAllConditionVariable( &object->finished_event );
             }
 
@@ -2221,7 +2713,7 @@ static void CALLBACK threadpool_worker_proc( void *param )
          * can be terminated. */
         timeout.QuadPart = (ULONGLONG)THREADPOOL_WORKER_TIMEOUT * -10000;
         if (RtlSleepConditionVariableCS( &pool->update_event, &pool->cs, &timeout ) == STATUS_TIMEOUT &&
-            !list_head( &pool->pool ) && (pool->num_workers > max( pool->min_workers, 1 ) ||
+            !threadpool_get_next_item( pool ) && (pool->num_workers > max( pool->min_workers, 1 ) ||
             (!pool->min_workers && !pool->objcount)))
         {
             break;
@@ -2245,6 +2737,50 @@ NTSTATUS WINAPI TpAllocCleanupGroup( TP_CLEANUP_GROUP **out )
     return tp_group_alloc( (struct threadpool_group **)out );
 }
 
+/***********************************************************************
+ *           TpAllocIoCompletion    (NTDLL.@)
+ */
+NTSTATUS WINAPI TpAllocIoCompletion( TP_IO **out, HANDLE file, PTP_IO_CALLBACK callback,
+                                     PVOID userdata, TP_CALLBACK_ENVIRON *environment )
+{
+    struct threadpool_object *object;
+    struct threadpool *pool;
+    NTSTATUS status;
+
+    TRACE( "%p %p %p %p %p\n", out, file, callback, userdata, environment );
+
+    object = RtlAllocateHeap( GetProcessHeap(), 0, sizeof(*object) );
+    if (!object)
+        return STATUS_NO_MEMORY;
+
+    status = tp_threadpool_lock( &pool, environment );
+    if (status)
+    {
+        RtlFreeHeap( GetProcessHeap(), 0, object );
+        return status;
+    }
+
+    object->type = TP_OBJECT_TYPE_IO;
+    object->u.io.callback           = callback;
+    object->u.io.pending_count      = 0;
+    object->u.io.completion_count   = 0;
+    object->u.io.completion_max     = 0;
+    object->u.io.completions        = NULL;
+
+    status = tp_ioqueue_lock( object, file );
+    if (status)
+    {
+        tp_threadpool_unlock( pool );
+        RtlFreeHeap( GetProcessHeap(), 0, object );
+        return status;
+    }
+
+    tp_object_initialize( object, pool, userdata, environment );
+
+    *out = (TP_IO *)object;
+    return STATUS_SUCCESS;
+}
+
 /***********************************************************************
  *           TpAllocPool    (NTDLL.@)
  */
@@ -2479,6 +3015,34 @@ VOID WINAPI TpCallbackUnloadDllOnCompletion( TP_CALLBACK_INSTANCE *instance, HMO
         this->cleanup.library = module;
 }
 
+/***********************************************************************
+ *           TpCancelAsyncIoOperation    (NTDLL.@)
+ */
+VOID WINAPI TpCancelAsyncIoOperation( TP_IO *io )
+{
+    struct threadpool_object *this = impl_from_TP_IO( io );
+    struct threadpool *pool = this->pool;
+
+    TRACE( "%p\n", io );
+
+    RtlEnterCriticalSection( &pool->cs );
+    if (!this->u.io.pending_count)
+    {
+        WARN( "no pending I/O operation for io %p\n", io );
+        RtlLeaveCriticalSection( &pool->cs );
+        return;
+    }
+
+    this->u.io.pending_count--;
+    if (object_is_finished( this, TRUE ))
+        RtlWakeAllConditionVariable( &this->group_finished_event );
+    if (object_is_finished( this, FALSE ))
+        RtlWakeAllConditionVariable( &this->finished_event );
+    RtlLeaveCriticalSection( &pool->cs );
+
+    tp_object_release( this );
+}
+
 /***********************************************************************
  *           TpDisassociateCallback    (NTDLL.@)
  */
@@ -2503,7 +3067,7 @@ VOID WINAPI TpDisassociateCallback( TP_CALLBACK_INSTANCE *instance )
     RtlEnterCriticalSection( &pool->cs );
 
     object->num_associated_callbacks--;
-    if (!object->num_pending_callbacks && !object->num_associated_callbacks)
+    if (object_is_finished( object, FALSE ))
         RtlWakeAllConditionVariable( &object->finished_event );
 
     RtlLeaveCriticalSection( &pool->cs );
@@ -2620,6 +3184,25 @@ VOID WINAPI TpReleaseCleanupGroupMembers( TP_CLEANUP_GROUP *group, BOOL cancel_p
     }
 }
 
+/***********************************************************************
+ *           TpReleaseIoCompletion    (NTDLL.@)
+ */
+VOID WINAPI TpReleaseIoCompletion( TP_IO *io )
+{
+    struct threadpool_object *this = impl_from_TP_IO( io );
+
+    TRACE( "%p\n", io );
+
+    tp_object_prepare_shutdown( this );
+
+    /* completions of still pending operations are checking this flag */
+    RtlEnterCriticalSection( &this->pool->cs );
+    this->shutdown = TRUE;
+    RtlLeaveCriticalSection( &this->pool->cs );
+
+    tp_object_release( this );
+}
+
 /***********************************************************************
  *           TpReleasePool    (NTDLL.@)
  */
@@ -2725,7 +3308,6 @@ BOOL WINAPI TpSetPoolMinThreads( TP_POOL *pool, DWORD minimum )
 VOID WINAPI TpSetTimer( TP_TIMER *timer, LARGE_INTEGER *timeout, LONG period, LONG window_length )
 {
     struct threadpool_object *this = impl_from_TP_TIMER( timer );
-    struct threadpool_object *other_timer;
     BOOL submit_timer = FALSE;
     ULONGLONG timestamp;
 
@@ -2764,7 +3346,7 @@ VOID WINAPI TpSetTimer( TP_TIMER *timer, LARGE_INTEGER *timeout, LONG period, LO
     /* First remove existing timeout. */
     if (this->u.timer.timer_pending)
     {
-        list_remove( &this->u.timer.timer_entry );
+        heap_remove( &timerqueue.pending_timers, &this->u.timer.timer_entry );
         this->u.timer.timer_pending = FALSE;
     }
 
@@ -2775,17 +3357,10 @@ VOID WINAPI TpSetTimer( TP_TIMER *timer, LARGE_INTEGER *timeout, LONG period, LO
         this->u.timer.period        = period;
         this->u.timer.window_length = window_length;
 
-        LIST_FOR_EACH_ENTRY( other_timer, &timerqueue.pending_timers,
-                             struct threadpool_object, u.timer.timer_entry )
-        {
-            assert( other_timer->type == TP_OBJECT_TYPE_TIMER );
-            if (this->u.timer.timeout < other_timer->u.timer.timeout)
-                break;
-        }
-        list_add_before( &other_timer->u.timer.timer_entry, &this->u.timer.timer_entry );
+        heap_insert( &timerqueue.pending_timers, &this->u.timer.timer_entry, timestamp );
 
         /* Wake up the timer thread when the timeout has to be updated. */
-        if (list_head( &timerqueue.pending_timers ) == &this->u.timer.timer_entry )
+        if (timestamp < timerqueue.wakeup)
             RtlWakeAllConditionVariable( &timerqueue.update_event );
 
         this->u.timer.timer_pending = TRUE;
@@ -2888,6 +3463,38 @@ NTSTATUS WINAPI TpSimpleTryPost( PTP_SIMPLE_CALLBACK callback, PVOID userdata,
     return STATUS_SUCCESS;
 }
 
+/***********************************************************************
+ *           TpStartAsyncIoOperation    (NTDLL.@)
+ */
+VOID WINAPI TpStartAsyncIoOperation( TP_IO *io )
+{
+    struct threadpool_object *this = impl_from_TP_IO( io );
+
+    TRACE( "%p\n", io );
+
+    /* each pending operation keeps a reference until its completion
+     * has been received or the operation has been cancelled */
+    interlocked_inc( &this->refcount );
+
+    RtlEnterCriticalSection( &this->pool->cs );
+    this->u.io.pending_count++;
+    RtlLeaveCriticalSection( &this->pool->cs );
+}
+
+/***********************************************************************
+ *           TpWaitForIoCompletion    (NTDLL.@)
+ */
+VOID WINAPI TpWaitForIoCompletion( TP_IO *io, BOOL cancel_pending )
+{
+    struct threadpool_object *this = impl_from_TP_IO( io );
+
+    TRACE( "%p %u\n", io, cancel_pending );
+
+    if (cancel_pending)
+        tp_object_cancel( this );
+    tp_object_wait( this, FALSE );
+}
+
 /***********************************************************************
  *           TpWaitForTimer    (NTDLL.@)
  */
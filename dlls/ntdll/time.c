@@ -32,6 +32,8 @@
 #include <string.h>
 #include <limits.h>
 #include <time.h>
+#include <signal.h>
+#include <pthread.h>
 #ifdef HAVE_SYS_TIME_H
 # include <sys/time.h>
 #endif
@@ -46,6 +48,7 @@
 #define WIN32_NO_STATUS
 #include "windef.h"
 #include "winternl.h"
+#include "ddk/wdm.h"
 #include "wine/exception.h"
 #include "wine/unicode.h"
 #include "wine/debug.h"
@@ -494,12 +497,89 @@ NTSTATUS WINAPI NtQueryPerformanceCounter( LARGE_INTEGER *counter, LARGE_INTEGER
 }
 
 
+/* the shared user data time fields are kept up to date */
+static BOOL shared_time_updated;
+
+/* store a time value, in the order that lets readers detect a torn value */
+static inline void set_ksystem_time( volatile KSYSTEM_TIME *time, ULONGLONG value )
+{
+    time->High2Time = value >> 32;
+    time->LowPart   = value;
+    time->High1Time = value >> 32;
+}
+
+static inline ULONGLONG get_ksystem_time( const volatile KSYSTEM_TIME *time )
+{
+    ULONG high, low;
+
+    do
+    {
+        high = time->High1Time;
+        low  = time->LowPart;
+    } while (high != time->High2Time);
+    return (ULONGLONG)high << 32 | low;
+}
+
+static void update_shared_time(void)
+{
+    ULONGLONG counter = monotonic_counter();
+    LARGE_INTEGER now;
+
+    NtQuerySystemTime( &now );
+    set_ksystem_time( &user_shared_data->SystemTime, now.QuadPart );
+    set_ksystem_time( &user_shared_data->InterruptTime, counter );
+    set_ksystem_time( &user_shared_data->TickCount, counter / TICKSPERMSEC );
+    user_shared_data->TickCountLowDeprecated = counter / TICKSPERMSEC;
+}
+
+static void *shared_time_thread( void *arg )
+{
+    struct timespec delay;
+
+    delay.tv_sec = 0;
+    delay.tv_nsec = 1000000;  /* 1 ms */
+    for (;;)
+    {
+        update_shared_time();
+        nanosleep( &delay, NULL );
+    }
+    return NULL;
+}
+
+/***********************************************************************
+ *           init_shared_time
+ *
+ * Initialize the time fields of the shared user data, and start a thread
+ * that keeps them current, so that reading the tick count or the
+ * interrupt time is a plain memory access.
+ */
+void init_shared_time(void)
+{
+    pthread_t thread;
+    sigset_t set, old_set;
+
+    user_shared_data->TickCountMultiplier = 1 << 24;
+    update_shared_time();
+
+    /* signals are handled by the Wine threads */
+    sigfillset( &set );
+    pthread_sigmask( SIG_BLOCK, &set, &old_set );
+    if (!pthread_create( &thread, NULL, shared_time_thread, NULL ))
+    {
+        pthread_detach( thread );
+        shared_time_updated = TRUE;
+    }
+    else WARN( "failed to start the shared time thread\n" );
+    pthread_sigmask( SIG_SETMASK, &old_set, NULL );
+}
+
 /******************************************************************************
  * NtGetTickCount   (NTDLL.@)
  * ZwGetTickCount   (NTDLL.@)
  */
 ULONG WINAPI NtGetTickCount(void)
 {
+    if (shared_time_updated) return user_shared_data->TickCount.LowPart;
     return monotonic_counter() / TICKSPERMSEC;
 }
 
@@ -1041,6 +1121,7 @@ NTSTATUS WINAPI NtSetSystemTime(const LARGE_INTEGER *NewTime, LARGE_INTEGER *Old
  */
 NTSTATUS WINAPI RtlQueryUnbiasedInterruptTime(ULONGLONG *time)
 {
-    *time = monotonic_counter();
+    if (shared_time_updated) *time = get_ksystem_time( &user_shared_data->InterruptTime );
+    else *time = monotonic_counter();
     return STATUS_SUCCESS;
 }
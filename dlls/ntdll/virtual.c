@@ -44,6 +44,12 @@
 #ifdef HAVE_SYS_SYSINFO_H
 # include <sys/sysinfo.h>
 #endif
+#ifdef HAVE_SYS_SYSCALL_H
+# include <sys/syscall.h>
+#endif
+#ifdef HAVE_SYS_UIO_H
+# include <sys/uio.h>
+#endif
 #ifdef HAVE_VALGRIND_VALGRIND_H
 # include <valgrind/valgrind.h>
 #endif
@@ -119,6 +125,15 @@ static RTL_CRITICAL_SECTION_DEBUG critsect_debug =
 };
 static RTL_CRITICAL_SECTION csVirtual = { &critsect_debug, -1, 0, 0, 0, 0 };
 
+/* The views tree and the page protections are protected by views_lock.
+ * Code changing them holds csVirtual, and owns views_lock exclusively
+ * at the outermost level of recursion; code that only looks at them,
+ * like queries and most page faults, takes views_lock shared and can
+ * run in parallel. A shared holder must not touch application memory,
+ * since the fault handler may need the lock again.
+ */
+static RTL_SRWLOCK views_lock = RTL_SRWLOCK_INIT;
+
 #ifdef __i386__
 static const UINT page_shift = 12;
 static const UINT_PTR page_mask = 0xfff;
@@ -168,7 +183,15 @@ static const size_t view_block_size = 0x100000;
 static void *preload_reserve_start;
 static void *preload_reserve_end;
 static BOOL use_locks;
+#if defined(__i386__) || defined(__x86_64__) || defined(__arm__) || defined(__aarch64__)
+static const SIZE_T large_page_size = 0x200000;
+#else
+static const SIZE_T large_page_size = 0;
+#endif
 static BOOL force_exec_prot;  /* whether to force PROT_EXEC on all PROT_READ mmaps */
+static BOOL use_soft_dirty;   /* whether write watches are tracked with the kernel soft-dirty bits */
+static int pagemap_fd = -1;   /* fd for /proc/self/pagemap */
+static int clear_refs_fd = -1; /* fd for /proc/self/clear_refs */
 
 static inline int is_view_valloc( const struct file_view *view )
 {
@@ -311,7 +334,7 @@ static int VIRTUAL_GetUnixProt( BYTE vprot )
         if (vprot & VPROT_WRITE) prot |= PROT_WRITE | PROT_READ;
         if (vprot & VPROT_WRITECOPY) prot |= PROT_WRITE | PROT_READ;
         if (vprot & VPROT_EXEC) prot |= PROT_EXEC | PROT_READ;
-        if (vprot & VPROT_WRITEWATCH) prot &= ~PROT_WRITE;
+        if ((vprot & VPROT_WRITEWATCH) && !use_soft_dirty) prot &= ~PROT_WRITE;
     }
     if (!prot) prot = PROT_NONE;
     return prot;
@@ -355,6 +378,53 @@ static void VIRTUAL_DumpView( struct file_view *view )
 }
 
 
+/***********************************************************************
+ *           lock_virtual
+ *
+ * Acquire the virtual memory lock for changing the views.
+ */
+static void lock_virtual( sigset_t *sigset )
+{
+    server_enter_uninterrupted_section( &csVirtual, sigset );
+    if (csVirtual.RecursionCount == 1) RtlAcquireSRWLockExclusive( &views_lock );
+}
+
+
+/***********************************************************************
+ *           unlock_virtual
+ */
+static void unlock_virtual( sigset_t *sigset )
+{
+    if (csVirtual.RecursionCount == 1) RtlReleaseSRWLockExclusive( &views_lock );
+    server_leave_uninterrupted_section( &csVirtual, sigset );
+}
+
+
+/***********************************************************************
+ *           lock_virtual_shared
+ *
+ * Acquire the virtual memory lock for looking at the views only.
+ */
+static void lock_virtual_shared( sigset_t *sigset )
+{
+    pthread_sigmask( SIG_BLOCK, &server_block_set, sigset );
+    /* the exclusive owner already has access */
+    if (csVirtual.OwningThread == ULongToHandle(GetCurrentThreadId())) RtlEnterCriticalSection( &csVirtual );
+    else if (!ntdll_get_thread_data()->virtual_shared++) RtlAcquireSRWLockShared( &views_lock );
+}
+
+
+/***********************************************************************
+ *           unlock_virtual_shared
+ */
+static void unlock_virtual_shared( sigset_t *sigset )
+{
+    if (csVirtual.OwningThread == ULongToHandle(GetCurrentThreadId())) RtlLeaveCriticalSection( &csVirtual );
+    else if (!--ntdll_get_thread_data()->virtual_shared) RtlReleaseSRWLockShared( &views_lock );
+    pthread_sigmask( SIG_SETMASK, sigset, NULL );
+}
+
+
 /***********************************************************************
  *           VIRTUAL_Dump
  */
@@ -365,12 +435,12 @@ static void VIRTUAL_Dump(void)
     struct file_view *view;
 
     TRACE( "Dump of all virtual memory views:\n" );
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual_shared( &sigset );
     WINE_RB_FOR_EACH_ENTRY( view, &views_tree, struct file_view, entry )
     {
         VIRTUAL_DumpView( view );
     }
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual_shared( &sigset );
 }
 #endif
 
@@ -939,6 +1009,90 @@ static void update_write_watches( void *base, size_t size, size_t accessed_size
 }
 
 
+/***********************************************************************
+ *           is_page_soft_dirty
+ */
+static BOOL is_page_soft_dirty( const void *addr )
+{
+    UINT64 entry;
+
+    if (pread( pagemap_fd, &entry, sizeof(entry), ((UINT_PTR)addr >> page_shift) * sizeof(entry) ) != sizeof(entry))
+        return TRUE;
+    return (entry >> 55) & 1;
+}
+
+
+/***********************************************************************
+ *           init_soft_dirty
+ *
+ * Check whether the kernel can tell us which pages have been written to, so
+ * that write watches don't need to write-protect pages and catch the faults.
+ * Must be called before the first write watch view is created.
+ */
+static void init_soft_dirty(void)
+{
+#ifdef __linux__
+    static BOOL initialized;
+    char *page;
+
+    if (initialized) return;
+    initialized = TRUE;
+
+    if ((pagemap_fd = open( "/proc/self/pagemap", O_RDONLY | O_CLOEXEC )) == -1) return;
+    if ((clear_refs_fd = open( "/proc/self/clear_refs", O_WRONLY | O_CLOEXEC )) == -1) goto failed;
+
+    /* make sure the bits are actually tracked, the kernel may be built without them */
+    if ((page = wine_anon_mmap( NULL, page_size, PROT_READ | PROT_WRITE, 0 )) == (char *)-1) goto failed;
+    *(volatile char *)page = 1;
+    if (write( clear_refs_fd, "4", 1 ) == 1 && !is_page_soft_dirty( page ))
+    {
+        *(volatile char *)page = 2;
+        use_soft_dirty = is_page_soft_dirty( page );
+    }
+    munmap( page, page_size );
+    if (use_soft_dirty)
+    {
+        TRACE( "using soft-dirty bits for write watches\n" );
+        return;
+    }
+
+failed:
+    if (clear_refs_fd != -1) close( clear_refs_fd );
+    close( pagemap_fd );
+    clear_refs_fd = pagemap_fd = -1;
+#endif
+}
+
+
+/***********************************************************************
+ *           update_soft_dirty_watches
+ *
+ * Clear the write watch flag on the pages the kernel has seen written to.
+ */
+static void update_soft_dirty_watches( char *base, SIZE_T size )
+{
+    UINT64 entries[512];
+    SIZE_T i, count, pages = size >> page_shift;
+    off_t offset = ((UINT_PTR)base >> page_shift) * sizeof(entries[0]);
+
+    while (pages)
+    {
+        count = min( pages, ARRAY_SIZE(entries) );
+        if (pread( pagemap_fd, entries, count * sizeof(entries[0]), offset ) != count * sizeof(entries[0]))
+        {
+            /* be conservative and report everything as written */
+            set_page_vprot_bits( base, pages << page_shift, 0, VPROT_WRITEWATCH );
+            return;
+        }
+        for (i = 0; i < count; i++)
+            if ((entries[i] >> 55) & 1) set_page_vprot_bits( base + (i << page_shift), page_size, 0, VPROT_WRITEWATCH );
+        base += count << page_shift;
+        offset += count * sizeof(entries[0]);
+        pages -= count;
+    }
+}
+
+
 /***********************************************************************
  *           reset_write_watches
  *
@@ -946,6 +1100,24 @@ static void update_write_watches( void *base, size_t size, size_t accessed_size
  */
 static void reset_write_watches( void *base, SIZE_T size )
 {
+    struct file_view *view;
+
+    if (use_soft_dirty)
+    {
+        /* the kernel can only reset the bits of the whole process, so we
+         * first need to save the state of all the other write watches */
+        WINE_RB_FOR_EACH_ENTRY( view, &views_tree, struct file_view, entry )
+            if (view->protect & VPROT_WRITEWATCH) update_soft_dirty_watches( view->base, view->size );
+        if (write( clear_refs_fd, "4", 1 ) == 1)
+        {
+            set_page_vprot_bits( base, size, VPROT_WRITEWATCH, 0 );
+            return;
+        }
+        ERR( "failed to reset soft-dirty bits, falling back to write protection\n" );
+        use_soft_dirty = FALSE;
+        WINE_RB_FOR_EACH_ENTRY( view, &views_tree, struct file_view, entry )
+            if (view->protect & VPROT_WRITEWATCH) mprotect_range( view->base, view->size, 0, 0 );
+    }
     set_page_vprot_bits( base, size, VPROT_WRITEWATCH, 0 );
     mprotect_range( base, size, 0, 0 );
 }
@@ -1358,7 +1530,8 @@ static NTSTATUS map_pe_header( void *ptr, size_t size, int fd, BOOL *removable )
  * Map an executable (PE format) image into memory.
  */
 static NTSTATUS map_image( HANDLE hmapping, ACCESS_MASK access, int fd, SIZE_T mask,
-                           pe_image_info_t *image_info, int shared_fd, BOOL removable, PVOID *addr_ptr )
+                           pe_image_info_t *image_info, int shared_fd, int copy_fd,
+                           BOOL removable, PVOID *addr_ptr )
 {
     IMAGE_DOS_HEADER *dos;
     IMAGE_NT_HEADERS *nt;
@@ -1384,7 +1557,7 @@ static NTSTATUS map_image( HANDLE hmapping, ACCESS_MASK access, int fd, SIZE_T m
 
     /* zero-map the whole range */
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
 
     if (base >= (char *)address_space_start)  /* make sure the DOS area remains free */
         status = map_view( &view, base, total_size, mask, FALSE, SEC_IMAGE | SEC_FILE |
@@ -1516,14 +1689,28 @@ static NTSTATUS map_image( HANDLE hmapping, ACCESS_MASK access, int fd, SIZE_T m
 
         if (!sec->PointerToRawData || !file_size) continue;
 
-        /* Note: if the section is not aligned properly map_file_into_view will magically
-         *       fall back to read(), so we don't need to check anything here.
-         */
         end = file_start + file_size;
         if (sec->PointerToRawData >= st.st_size ||
             end > ((st.st_size + sector_align) & ~sector_align) ||
-            end < file_start ||
-            map_file_into_view( view, fd, sec->VirtualAddress, file_size, file_start,
+            end < file_start)
+        {
+            ERR_(module)( "Could not map section %.8s, file probably truncated\n", sec->Name );
+            goto error;
+        }
+
+        /* the server keeps a page-aligned copy of unaligned sections, already zero-padded */
+        if (copy_fd != -1 && (file_start & page_mask))
+        {
+            if (map_file_into_view( view, copy_fd, sec->VirtualAddress, file_size, sec->VirtualAddress,
+                                    VPROT_COMMITTED | VPROT_READ | VPROT_WRITECOPY, FALSE ) == STATUS_SUCCESS)
+                continue;
+            WARN_(module)( "Could not map copy of section %.8s\n", sec->Name );
+        }
+
+        /* Note: if the section is not aligned properly map_file_into_view will magically
+         *       fall back to read(), so we don't need to check anything here.
+         */
+        if (map_file_into_view( view, fd, sec->VirtualAddress, file_size, file_start,
                                 VPROT_COMMITTED | VPROT_READ | VPROT_WRITECOPY,
                                 removable ) != STATUS_SUCCESS)
         {
@@ -1586,7 +1773,7 @@ static NTSTATUS map_image( HANDLE hmapping, ACCESS_MASK access, int fd, SIZE_T m
     if (status) goto error;
 
     VIRTUAL_DEBUG_DUMP_VIEW( view );
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
 
     *addr_ptr = ptr;
 #ifdef VALGRIND_LOAD_PDB_DEBUGINFO
@@ -1597,7 +1784,7 @@ static NTSTATUS map_image( HANDLE hmapping, ACCESS_MASK access, int fd, SIZE_T m
 
  error:
     if (view) delete_view( view );
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
     return status;
 }
 
@@ -1618,7 +1805,7 @@ NTSTATUS virtual_map_section( HANDLE handle, PVOID *addr_ptr, ULONG zero_bits, S
     int unix_handle = -1, needs_close;
     unsigned int vprot, sec_flags;
     struct file_view *view;
-    HANDLE shared_file;
+    HANDLE shared_file, copy_file;
     LARGE_INTEGER offset;
     sigset_t sigset;
 
@@ -1655,29 +1842,39 @@ NTSTATUS virtual_map_section( HANDLE handle, PVOID *addr_ptr, ULONG zero_bits, S
         sec_flags   = reply->flags;
         full_size   = reply->size;
         shared_file = wine_server_ptr_handle( reply->shared_file );
+        copy_file   = wine_server_ptr_handle( reply->copy_file );
     }
     SERVER_END_REQ;
     if (res) return res;
 
-    if ((res = server_get_unix_fd( handle, 0, &unix_handle, &needs_close, NULL, NULL ))) goto done;
+    if ((res = server_get_unix_fd( handle, 0, &unix_handle, &needs_close, NULL, NULL )))
+    {
+        if (shared_file) close_handle( shared_file );
+        if (copy_file) close_handle( copy_file );
+        goto done;
+    }
 
     if (sec_flags & SEC_IMAGE)
     {
+        int shared_fd = -1, copy_fd = -1, shared_needs_close = 0, copy_needs_close = 0;
+
         if (shared_file)
         {
-            int shared_fd, shared_needs_close;
-
-            if ((res = server_get_unix_fd( shared_file, FILE_READ_DATA|FILE_WRITE_DATA,
-                                           &shared_fd, &shared_needs_close, NULL, NULL ))) goto done;
-            res = map_image( handle, access, unix_handle, mask, image_info,
-                             shared_fd, needs_close, addr_ptr );
-            if (shared_needs_close) close( shared_fd );
+            res = server_get_unix_fd( shared_file, FILE_READ_DATA|FILE_WRITE_DATA,
+                                      &shared_fd, &shared_needs_close, NULL, NULL );
             close_handle( shared_file );
         }
-        else
+        if (copy_file)
         {
-            res = map_image( handle, access, unix_handle, mask, image_info, -1, needs_close, addr_ptr );
+            /* the copy is only an optimization, the sections can still be read from the file */
+            if (server_get_unix_fd( copy_file, FILE_READ_DATA, &copy_fd, &copy_needs_close, NULL, NULL ))
+                copy_fd = -1;
+            close_handle( copy_file );
         }
+        if (!res) res = map_image( handle, access, unix_handle, mask, image_info,
+                                   shared_fd, copy_fd, needs_close, addr_ptr );
+        if (shared_needs_close) close( shared_fd );
+        if (copy_needs_close) close( copy_fd );
         if (needs_close) close( unix_handle );
         if (res >= 0) *size_ptr = image_info->map_size;
         return res;
@@ -1708,7 +1905,7 @@ NTSTATUS virtual_map_section( HANDLE handle, PVOID *addr_ptr, ULONG zero_bits, S
 
     /* Reserve a properly aligned area */
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
 
     get_vprot_flags( protect, &vprot, sec_flags & SEC_IMAGE );
     vprot |= sec_flags;
@@ -1716,7 +1913,7 @@ NTSTATUS virtual_map_section( HANDLE handle, PVOID *addr_ptr, ULONG zero_bits, S
     res = map_view( &view, *addr_ptr, size, mask, FALSE, vprot );
     if (res)
     {
-        server_leave_uninterrupted_section( &csVirtual, &sigset );
+        unlock_virtual( &sigset );
         goto done;
     }
 
@@ -1751,7 +1948,7 @@ NTSTATUS virtual_map_section( HANDLE handle, PVOID *addr_ptr, ULONG zero_bits, S
         delete_view( view );
     }
 
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
 
 done:
     if (needs_close) close( unix_handle );
@@ -1894,7 +2091,7 @@ NTSTATUS virtual_create_builtin_view( void *module )
 
     size = ROUND_SIZE( module, size );
     base = ROUND_ADDR( module, page_mask );
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
     status = create_view( &view, base, size, SEC_IMAGE | SEC_FILE | VPROT_SYSTEM |
                           VPROT_COMMITTED | VPROT_READ | VPROT_WRITECOPY | VPROT_EXEC );
     if (!status)
@@ -1916,7 +2113,7 @@ NTSTATUS virtual_create_builtin_view( void *module )
         }
         VIRTUAL_DEBUG_DUMP_VIEW( view );
     }
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
     return status;
 }
 
@@ -1943,7 +2140,7 @@ NTSTATUS virtual_alloc_thread_stack( TEB *teb, SIZE_T reserve_size, SIZE_T commi
     size = (size + 0xffff) & ~0xffff;  /* round to 64K boundary */
     if (pthread_size) *pthread_size = extra_size = max( page_size, ROUND_SIZE( 0, *pthread_size ));
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
 
     if ((status = map_view( &view, NULL, size + extra_size, 0xffff, 0,
                             VPROT_READ | VPROT_WRITE | VPROT_COMMITTED )) != STATUS_SUCCESS)
@@ -1982,7 +2179,7 @@ NTSTATUS virtual_alloc_thread_stack( TEB *teb, SIZE_T reserve_size, SIZE_T commi
     teb->Tib.StackBase     = (char *)view->base + view->size;
     teb->Tib.StackLimit    = (char *)view->base + 2 * page_size;
 done:
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
     return status;
 }
 
@@ -2012,7 +2209,20 @@ NTSTATUS virtual_handle_fault( LPCVOID addr, DWORD err, BOOL on_signal_stack )
     sigset_t sigset;
     BYTE vprot;
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    /* faults that don't need to change the page protections are checked under the shared lock */
+    lock_virtual_shared( &sigset );
+    vprot = get_page_vprot( page );
+    if (!(vprot & (VPROT_GUARD | VPROT_WRITEWATCH)))
+    {
+        if ((err & EXCEPTION_WRITE_FAULT) && (VIRTUAL_GetUnixProt( vprot ) & PROT_WRITE) &&
+            is_write_watch_range( page, page_size ))
+            ret = STATUS_SUCCESS;
+        unlock_virtual_shared( &sigset );
+        return ret;
+    }
+    unlock_virtual_shared( &sigset );
+
+    lock_virtual( &sigset );
     vprot = get_page_vprot( page );
     if (!on_signal_stack && (vprot & VPROT_GUARD))
     {
@@ -2034,7 +2244,7 @@ NTSTATUS virtual_handle_fault( LPCVOID addr, DWORD err, BOOL on_signal_stack )
                 ret = STATUS_SUCCESS;
         }
     }
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
     return ret;
 }
 
@@ -2077,13 +2287,13 @@ unsigned int virtual_locked_server_call( void *req_ptr )
 
     if (!size) return wine_server_call( req_ptr );
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
     if (!(ret = check_write_access( addr, size, &has_write_watch )))
     {
         ret = server_call_unlocked( req );
         if (has_write_watch) update_write_watches( addr, size, wine_server_reply_size( req ));
     }
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
     return ret;
 }
 
@@ -2100,14 +2310,14 @@ ssize_t virtual_locked_read( int fd, void *addr, size_t size )
     ssize_t ret = read( fd, addr, size );
     if (ret != -1 || errno != EFAULT) return ret;
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
     if (!check_write_access( addr, size, &has_write_watch ))
     {
         ret = read( fd, addr, size );
         err = errno;
         if (has_write_watch) update_write_watches( addr, size, max( 0, ret ));
     }
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
     errno = err;
     return ret;
 }
@@ -2125,14 +2335,14 @@ ssize_t virtual_locked_pread( int fd, void *addr, size_t size, off_t offset )
     ssize_t ret = pread( fd, addr, size, offset );
     if (ret != -1 || errno != EFAULT) return ret;
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
     if (!check_write_access( addr, size, &has_write_watch ))
     {
         ret = pread( fd, addr, size, offset );
         err = errno;
         if (has_write_watch) update_write_watches( addr, size, max( 0, ret ));
     }
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
     errno = err;
     return ret;
 }
@@ -2151,7 +2361,7 @@ ssize_t CDECL __wine_locked_recvmsg( int fd, struct msghdr *hdr, int flags )
     ssize_t ret = recvmsg( fd, hdr, flags );
     if (ret != -1 || errno != EFAULT) return ret;
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
     for (i = 0; i < hdr->msg_iovlen; i++)
         if (check_write_access( hdr->msg_iov[i].iov_base, hdr->msg_iov[i].iov_len, &has_write_watch ))
             break;
@@ -2163,7 +2373,7 @@ ssize_t CDECL __wine_locked_recvmsg( int fd, struct msghdr *hdr, int flags )
     if (has_write_watch)
         while (i--) update_write_watches( hdr->msg_iov[i].iov_base, hdr->msg_iov[i].iov_len, 0 );
 
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
     errno = err;
     return ret;
 }
@@ -2178,10 +2388,10 @@ BOOL virtual_is_valid_code_address( const void *addr, SIZE_T size )
     BOOL ret = FALSE;
     sigset_t sigset;
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual_shared( &sigset );
     if ((view = VIRTUAL_FindView( addr, size )))
         ret = !(view->protect & VPROT_SYSTEM);  /* system views are not visible to the app */
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual_shared( &sigset );
     return ret;
 }
 
@@ -2194,9 +2404,16 @@ BOOL virtual_is_valid_code_address( const void *addr, SIZE_T size )
  */
 BOOL virtual_handle_stack_fault( void *addr )
 {
+    BOOL shared = ntdll_get_thread_data()->virtual_shared != 0;
     BOOL ret = FALSE;
 
-    RtlEnterCriticalSection( &csVirtual );  /* no need for signal masking inside signal handler */
+    /* the exclusive lock can't be taken while we hold it shared, but then the
+     * views can't change and nobody else touches the protections of our stack */
+    if (!shared)
+    {
+        RtlEnterCriticalSection( &csVirtual );  /* no need for signal masking inside signal handler */
+        if (csVirtual.RecursionCount == 1) RtlAcquireSRWLockExclusive( &views_lock );
+    }
     if (get_page_vprot( addr ) & VPROT_GUARD)
     {
         char *page = ROUND_ADDR( addr, page_mask );
@@ -2211,7 +2428,11 @@ BOOL virtual_handle_stack_fault( void *addr )
         }
         ret = TRUE;
     }
-    RtlLeaveCriticalSection( &csVirtual );
+    if (!shared)
+    {
+        if (csVirtual.RecursionCount == 1) RtlReleaseSRWLockExclusive( &views_lock );
+        RtlLeaveCriticalSection( &csVirtual );
+    }
     return ret;
 }
 
@@ -2298,7 +2519,7 @@ SIZE_T virtual_uninterrupted_read_memory( const void *addr, void *buffer, SIZE_T
 
     if (!size) return 0;
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
     if ((view = VIRTUAL_FindView( addr, size )))
     {
         if (!(view->protect & VPROT_SYSTEM))
@@ -2317,7 +2538,7 @@ SIZE_T virtual_uninterrupted_read_memory( const void *addr, void *buffer, SIZE_T
             }
         }
     }
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
     return bytes_read;
 }
 
@@ -2337,13 +2558,13 @@ NTSTATUS virtual_uninterrupted_write_memory( void *addr, const void *buffer, SIZ
 
     if (!size) return STATUS_SUCCESS;
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
     if (!(ret = check_write_access( addr, size, &has_write_watch )))
     {
         memcpy( addr, buffer, size );
         if (has_write_watch) update_write_watches( addr, size, size );
     }
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
     return ret;
 }
 
@@ -2358,7 +2579,7 @@ void VIRTUAL_SetForceExec( BOOL enable )
     struct file_view *view;
     sigset_t sigset;
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
     if (!force_exec_prot != !enable)  /* change all existing views */
     {
         force_exec_prot = enable;
@@ -2371,7 +2592,7 @@ void VIRTUAL_SetForceExec( BOOL enable )
             mprotect_range( view->base, view->size, commit, 0 );
         }
     }
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
 }
 
 struct free_range
@@ -2409,7 +2630,7 @@ void virtual_release_address_space(void)
 
     if (is_win64) return;
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
 
     range.base  = (char *)0x82000000;
     range.limit = user_space_limit;
@@ -2427,7 +2648,7 @@ void virtual_release_address_space(void)
 #endif
     }
 
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
 }
 
 
@@ -2449,11 +2670,60 @@ void virtual_set_large_address_space(void)
 
 
 /***********************************************************************
- *             NtAllocateVirtualMemory   (NTDLL.@)
- *             ZwAllocateVirtualMemory   (NTDLL.@)
+ *           has_lock_memory_privilege
+ *
+ * Check whether the caller may allocate large pages.
  */
-NTSTATUS WINAPI NtAllocateVirtualMemory( HANDLE process, PVOID *ret, ULONG zero_bits,
-                                         SIZE_T *size_ptr, ULONG type, ULONG protect )
+static BOOL has_lock_memory_privilege(void)
+{
+    PRIVILEGE_SET privs;
+    BOOLEAN ret = FALSE;
+    HANDLE token;
+
+    if (NtOpenThreadToken( GetCurrentThread(), TOKEN_QUERY, TRUE, &token ) &&
+        NtOpenProcessToken( NtCurrentProcess(), TOKEN_QUERY, &token ))
+        return FALSE;
+
+    privs.PrivilegeCount = 1;
+    privs.Control = PRIVILEGE_SET_ALL_NECESSARY;
+    privs.Privilege[0].Luid.LowPart = SE_LOCK_MEMORY_PRIVILEGE;
+    privs.Privilege[0].Luid.HighPart = 0;
+    privs.Privilege[0].Attributes = 0;
+    NtPrivilegeCheck( token, &privs, &ret );
+    NtClose( token );
+    return ret;
+}
+
+
+/***********************************************************************
+ *           set_numa_node
+ *
+ * Make the kernel prefer a NUMA node for the pages of a range.
+ * This is only a hint, failures are ignored.
+ */
+static void set_numa_node( void *base, SIZE_T size, ULONG node )
+{
+#if defined(__linux__) && defined(__NR_mbind)
+    static const int mpol_preferred = 1;  /* MPOL_PREFERRED from linux/mempolicy.h */
+    unsigned long nodemask = 1ul << node;
+
+    /* the kernel ignores the last bit of maxnode */
+    if (syscall( __NR_mbind, base, size, mpol_preferred, &nodemask, 8 * sizeof(nodemask) + 1, 0 ))
+        WARN( "failed to bind %p-%p to node %u: %s\n", base, (char *)base + size, node, strerror(errno) );
+#else
+    static int once;
+    if (!once++) FIXME( "NUMA node %u not supported on this platform\n", node );
+#endif
+}
+
+
+/***********************************************************************
+ *           virtual_alloc_node
+ *
+ * Allocate virtual memory, optionally preferring a NUMA node for its pages.
+ */
+NTSTATUS virtual_alloc_node( HANDLE process, PVOID *ret, ULONG zero_bits, SIZE_T *size_ptr,
+                             ULONG type, ULONG protect, ULONG node )
 {
     void *base;
     unsigned int vprot;
@@ -2482,6 +2752,7 @@ NTSTATUS WINAPI NtAllocateVirtualMemory( HANDLE process, PVOID *ret, ULONG zero_
         call.virtual_alloc.zero_bits = zero_bits;
         call.virtual_alloc.op_type   = type;
         call.virtual_alloc.prot      = protect;
+        call.virtual_alloc.node      = node;
         status = server_queue_process_apc( process, &call, &result );
         if (status != STATUS_SUCCESS) return status;
 
@@ -2524,22 +2795,36 @@ NTSTATUS WINAPI NtAllocateVirtualMemory( HANDLE process, PVOID *ret, ULONG zero_
     /* Compute the alloc type flags */
 
     if (!(type & (MEM_COMMIT | MEM_RESERVE | MEM_RESET)) ||
-        (type & ~(MEM_COMMIT | MEM_RESERVE | MEM_TOP_DOWN | MEM_WRITE_WATCH | MEM_RESET)))
+        (type & ~(MEM_COMMIT | MEM_RESERVE | MEM_TOP_DOWN | MEM_WRITE_WATCH | MEM_RESET | MEM_LARGE_PAGES)))
     {
         WARN("called with wrong alloc type flags (%08x) !\n", type);
         return STATUS_INVALID_PARAMETER;
     }
 
+    /* large pages must be reserved and committed at once, on a large page boundary */
+    if (type & MEM_LARGE_PAGES)
+    {
+        if (!large_page_size || (type & (MEM_RESERVE | MEM_COMMIT)) != (MEM_RESERVE | MEM_COMMIT) ||
+            (type & MEM_WRITE_WATCH) || ((UINT_PTR)base | size) & (large_page_size - 1))
+            return STATUS_INVALID_PARAMETER;
+        if (!has_lock_memory_privilege()) return STATUS_PRIVILEGE_NOT_HELD;
+        mask = max( mask, large_page_size - 1 );
+    }
+
     /* Reserve the memory */
 
-    if (use_locks) server_enter_uninterrupted_section( &csVirtual, &sigset );
+    if (use_locks) lock_virtual( &sigset );
 
     if ((type & MEM_RESERVE) || !base)
     {
         if (!(status = get_vprot_flags( protect, &vprot, FALSE )))
         {
             if (type & MEM_COMMIT) vprot |= VPROT_COMMITTED;
-            if (type & MEM_WRITE_WATCH) vprot |= VPROT_WRITEWATCH;
+            if (type & MEM_WRITE_WATCH)
+            {
+                init_soft_dirty();
+                vprot |= VPROT_WRITEWATCH;
+            }
             if (protect & PAGE_NOCACHE) vprot |= SEC_NOCACHE;
 
             if (vprot & VPROT_WRITECOPY) status = STATUS_INVALID_PAGE_PROTECTION;
@@ -2547,6 +2832,14 @@ NTSTATUS WINAPI NtAllocateVirtualMemory( HANDLE process, PVOID *ret, ULONG zero_
             else status = map_view( &view, base, size, mask, type & MEM_TOP_DOWN, vprot );
 
             if (status == STATUS_SUCCESS) base = view->base;
+            /* new mappings are reported as entirely written to until the bits are reset */
+            if (status == STATUS_SUCCESS && use_soft_dirty && (vprot & VPROT_WRITEWATCH))
+                reset_write_watches( base, size );
+#ifdef MADV_HUGEPAGE
+            /* let the kernel back the view with transparent huge pages */
+            if (status == STATUS_SUCCESS && (type & MEM_LARGE_PAGES))
+                madvise( base, size, MADV_HUGEPAGE );
+#endif
         }
     }
     else if (type & MEM_RESET)
@@ -2572,8 +2865,9 @@ NTSTATUS WINAPI NtAllocateVirtualMemory( HANDLE process, PVOID *ret, ULONG zero_
     }
 
     if (!status) VIRTUAL_DEBUG_DUMP_VIEW( view );
+    if (!status && node != NUMA_NO_PREFERRED_NODE && !(type & MEM_RESET)) set_numa_node( base, size, node );
 
-    if (use_locks) server_leave_uninterrupted_section( &csVirtual, &sigset );
+    if (use_locks) unlock_virtual( &sigset );
 
     if (status == STATUS_SUCCESS)
     {
@@ -2584,6 +2878,52 @@ NTSTATUS WINAPI NtAllocateVirtualMemory( HANDLE process, PVOID *ret, ULONG zero_
 }
 
 
+/***********************************************************************
+ *             NtAllocateVirtualMemory   (NTDLL.@)
+ *             ZwAllocateVirtualMemory   (NTDLL.@)
+ */
+NTSTATUS WINAPI NtAllocateVirtualMemory( HANDLE process, PVOID *ret, ULONG zero_bits,
+                                         SIZE_T *size_ptr, ULONG type, ULONG protect )
+{
+    return virtual_alloc_node( process, ret, zero_bits, size_ptr, type, protect, NUMA_NO_PREFERRED_NODE );
+}
+
+
+/***********************************************************************
+ *             NtAllocateVirtualMemoryEx   (NTDLL.@)
+ *             ZwAllocateVirtualMemoryEx   (NTDLL.@)
+ */
+NTSTATUS WINAPI NtAllocateVirtualMemoryEx( HANDLE process, PVOID *ret, SIZE_T *size_ptr, ULONG type,
+                                           ULONG protect, MEM_EXTENDED_PARAMETER *parameters,
+                                           ULONG count )
+{
+    ULONG i, node = NUMA_NO_PREFERRED_NODE;
+
+    TRACE("%p %p %08lx %x %08x %p %u\n", process, *ret, *size_ptr, type, protect, parameters, count );
+
+    if (count && !parameters) return STATUS_INVALID_PARAMETER;
+
+    for (i = 0; i < count; i++)
+    {
+        switch (parameters[i].Type)
+        {
+        case MemExtendedParameterNumaNode:
+            node = parameters[i].u.ULong;
+            /* the node masks of the processor topology are limited to 64 bits too */
+            if (node != NUMA_NO_PREFERRED_NODE && node >= 64) return STATUS_INVALID_PARAMETER;
+            break;
+        case MemExtendedParameterInvalidType:
+        case MemExtendedParameterMax:
+            return STATUS_INVALID_PARAMETER;
+        default:
+            FIXME( "unsupported parameter type %u\n", (int)parameters[i].Type );
+            break;
+        }
+    }
+    return virtual_alloc_node( process, ret, 0, size_ptr, type, protect, node );
+}
+
+
 /***********************************************************************
  *             NtFreeVirtualMemory   (NTDLL.@)
  *             ZwFreeVirtualMemory   (NTDLL.@)
@@ -2629,7 +2969,7 @@ NTSTATUS WINAPI NtFreeVirtualMemory( HANDLE process, PVOID *addr_ptr, SIZE_T *si
     /* avoid freeing the DOS area when a broken app passes a NULL pointer */
     if (!base) return STATUS_INVALID_PARAMETER;
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
 
     if (!(view = VIRTUAL_FindView( base, size )) || !is_view_valloc( view ))
     {
@@ -2662,7 +3002,7 @@ NTSTATUS WINAPI NtFreeVirtualMemory( HANDLE process, PVOID *addr_ptr, SIZE_T *si
         status = STATUS_INVALID_PARAMETER;
     }
 
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
     return status;
 }
 
@@ -2716,7 +3056,7 @@ NTSTATUS WINAPI NtProtectVirtualMemory( HANDLE process, PVOID *addr_ptr, SIZE_T
     size = ROUND_SIZE( addr, size );
     base = ROUND_ADDR( addr, page_mask );
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
 
     if ((view = VIRTUAL_FindView( base, size )))
     {
@@ -2732,7 +3072,7 @@ NTSTATUS WINAPI NtProtectVirtualMemory( HANDLE process, PVOID *addr_ptr, SIZE_T
 
     if (!status) VIRTUAL_DEBUG_DUMP_VIEW( view );
 
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
 
     if (status == STATUS_SUCCESS)
     {
@@ -2796,7 +3136,7 @@ NTSTATUS WINAPI NtQueryVirtualMemory( HANDLE process, LPCVOID addr,
     struct file_view *view;
     char *base, *alloc_base = 0, *alloc_end = working_set_limit;
     struct wine_rb_entry *ptr;
-    MEMORY_BASIC_INFORMATION *info = buffer;
+    MEMORY_BASIC_INFORMATION *info = buffer, basic_info;
     sigset_t sigset;
 
     if (info_class != MemoryBasicInformation)
@@ -2849,7 +3189,7 @@ NTSTATUS WINAPI NtQueryVirtualMemory( HANDLE process, LPCVOID addr,
 
     /* Find the view containing the address */
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual_shared( &sigset );
     ptr = views_tree.root;
     while (ptr)
     {
@@ -2874,31 +3214,31 @@ NTSTATUS WINAPI NtQueryVirtualMemory( HANDLE process, LPCVOID addr,
 
     /* Fill the info structure */
 
-    info->AllocationBase = alloc_base;
-    info->BaseAddress    = base;
-    info->RegionSize     = alloc_end - base;
+    basic_info.AllocationBase = alloc_base;
+    basic_info.BaseAddress    = base;
+    basic_info.RegionSize     = alloc_end - base;
 
     if (!ptr)
     {
-        if (!wine_mmap_enum_reserved_areas( get_free_mem_state_callback, info, 0 ))
+        if (!wine_mmap_enum_reserved_areas( get_free_mem_state_callback, &basic_info, 0 ))
         {
             /* not in a reserved area at all, pretend it's allocated */
 #ifdef __i386__
             if (base >= (char *)address_space_start)
             {
-                info->State             = MEM_RESERVE;
-                info->Protect           = PAGE_NOACCESS;
-                info->AllocationProtect = PAGE_NOACCESS;
-                info->Type              = MEM_PRIVATE;
+                basic_info.State             = MEM_RESERVE;
+                basic_info.Protect           = PAGE_NOACCESS;
+                basic_info.AllocationProtect = PAGE_NOACCESS;
+                basic_info.Type              = MEM_PRIVATE;
             }
             else
 #endif
             {
-                info->State             = MEM_FREE;
-                info->Protect           = PAGE_NOACCESS;
-                info->AllocationBase    = 0;
-                info->AllocationProtect = 0;
-                info->Type              = 0;
+                basic_info.State             = MEM_FREE;
+                basic_info.Protect           = PAGE_NOACCESS;
+                basic_info.AllocationBase    = 0;
+                basic_info.AllocationProtect = 0;
+                basic_info.Type              = 0;
             }
         }
     }
@@ -2908,17 +3248,20 @@ NTSTATUS WINAPI NtQueryVirtualMemory( HANDLE process, LPCVOID addr,
         char *ptr;
         SIZE_T range_size = get_committed_size( view, base, &vprot );
 
-        info->State = (vprot & VPROT_COMMITTED) ? MEM_COMMIT : MEM_RESERVE;
-        info->Protect = (vprot & VPROT_COMMITTED) ? VIRTUAL_GetWin32Prot( vprot, view->protect ) : 0;
-        info->AllocationProtect = VIRTUAL_GetWin32Prot( view->protect, view->protect );
-        if (view->protect & SEC_IMAGE) info->Type = MEM_IMAGE;
-        else if (view->protect & (SEC_FILE | SEC_RESERVE | SEC_COMMIT)) info->Type = MEM_MAPPED;
-        else info->Type = MEM_PRIVATE;
+        basic_info.State = (vprot & VPROT_COMMITTED) ? MEM_COMMIT : MEM_RESERVE;
+        basic_info.Protect = (vprot & VPROT_COMMITTED) ? VIRTUAL_GetWin32Prot( vprot, view->protect ) : 0;
+        basic_info.AllocationProtect = VIRTUAL_GetWin32Prot( view->protect, view->protect );
+        if (view->protect & SEC_IMAGE) basic_info.Type = MEM_IMAGE;
+        else if (view->protect & (SEC_FILE | SEC_RESERVE | SEC_COMMIT)) basic_info.Type = MEM_MAPPED;
+        else basic_info.Type = MEM_PRIVATE;
         for (ptr = base; ptr < base + range_size; ptr += page_size)
             if ((get_page_vprot( ptr ) ^ vprot) & ~VPROT_WRITEWATCH) break;
-        info->RegionSize = ptr - base;
+        basic_info.RegionSize = ptr - base;
     }
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual_shared( &sigset );
+
+    /* the buffer is only written once the lock is released, in case it faults */
+    *info = basic_info;
 
     if (res_len) *res_len = sizeof(*info);
     return STATUS_SUCCESS;
@@ -3150,7 +3493,7 @@ NTSTATUS WINAPI NtUnmapViewOfSection( HANDLE process, PVOID addr )
         return status;
     }
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
     if ((view = VIRTUAL_FindView( addr, 0 )) && !is_view_valloc( view ))
     {
         if (!(view->protect & VPROT_SYSTEM))
@@ -3170,7 +3513,7 @@ NTSTATUS WINAPI NtUnmapViewOfSection( HANDLE process, PVOID addr )
             status = STATUS_SUCCESS;
         }
     }
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
     return status;
 }
 
@@ -3264,6 +3607,7 @@ NTSTATUS WINAPI NtFlushVirtualMemory( HANDLE process, LPCVOID *addr_ptr,
     NTSTATUS status = STATUS_SUCCESS;
     sigset_t sigset;
     void *addr = ROUND_ADDR( *addr_ptr, page_mask );
+    SIZE_T size = *size_ptr;
 
     if (process != NtCurrentProcess())
     {
@@ -3286,17 +3630,21 @@ NTSTATUS WINAPI NtFlushVirtualMemory( HANDLE process, LPCVOID *addr_ptr,
         return result.virtual_flush.status;
     }
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
-    if (!(view = VIRTUAL_FindView( addr, *size_ptr ))) status = STATUS_INVALID_PARAMETER;
+    lock_virtual_shared( &sigset );
+    if (!(view = VIRTUAL_FindView( addr, size ))) status = STATUS_INVALID_PARAMETER;
     else
     {
-        if (!*size_ptr) *size_ptr = view->size;
-        *addr_ptr = addr;
+        if (!size) size = view->size;
 #ifdef MS_ASYNC
-        if (msync( addr, *size_ptr, MS_ASYNC )) status = STATUS_NOT_MAPPED_DATA;
+        if (msync( addr, size, MS_ASYNC )) status = STATUS_NOT_MAPPED_DATA;
 #endif
     }
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual_shared( &sigset );
+    if (status != STATUS_INVALID_PARAMETER)
+    {
+        *size_ptr = size;
+        *addr_ptr = addr;
+    }
     return status;
 }
 
@@ -3323,7 +3671,7 @@ NTSTATUS WINAPI NtGetWriteWatch( HANDLE process, ULONG flags, PVOID base, SIZE_T
     TRACE( "%p %x %p-%p %p %lu\n", process, flags, base, (char *)base + size,
            addresses, *count );
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
 
     if (is_write_watch_range( base, size ))
     {
@@ -3331,6 +3679,8 @@ NTSTATUS WINAPI NtGetWriteWatch( HANDLE process, ULONG flags, PVOID base, SIZE_T
         char *addr = base;
         char *end = addr + size;
 
+        if (use_soft_dirty) update_soft_dirty_watches( base, size );
+
         while (pos < *count && addr < end)
         {
             if (!(get_page_vprot( addr ) & VPROT_WRITEWATCH)) addresses[pos++] = addr;
@@ -3342,7 +3692,7 @@ NTSTATUS WINAPI NtGetWriteWatch( HANDLE process, ULONG flags, PVOID base, SIZE_T
     }
     else status = STATUS_INVALID_PARAMETER;
 
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
     return status;
 }
 
@@ -3363,18 +3713,61 @@ NTSTATUS WINAPI NtResetWriteWatch( HANDLE process, PVOID base, SIZE_T size )
 
     if (!size) return STATUS_INVALID_PARAMETER;
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
 
     if (is_write_watch_range( base, size ))
         reset_write_watches( base, size );
     else
         status = STATUS_INVALID_PARAMETER;
 
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
     return status;
 }
 
 
+/***********************************************************************
+ *           copy_process_memory
+ *
+ * Copy memory from or to another process with process_vm_readv/writev,
+ * so that the server only has to check the handle access instead of
+ * doing the copy itself. Returns STATUS_NOT_SUPPORTED when the server
+ * has to do it, e.g. for protected pages or when ptrace access is denied.
+ */
+static NTSTATUS copy_process_memory( HANDLE process, void *addr, void *buffer, SIZE_T size, BOOL write )
+{
+#if defined(HAVE_PROCESS_VM_READV) && defined(HAVE_PROCESS_VM_WRITEV)
+    struct iovec local, remote;
+    NTSTATUS status;
+    int unix_pid = -1;
+    ssize_t ret;
+
+    if (!size) return STATUS_NOT_SUPPORTED;
+
+    SERVER_START_REQ( get_process_vm_pid )
+    {
+        req->handle = wine_server_obj_handle( process );
+        req->access = write ? PROCESS_VM_WRITE : PROCESS_VM_READ;
+        if (!(status = wine_server_call( req ))) unix_pid = reply->unix_pid;
+    }
+    SERVER_END_REQ;
+    if (status) return status;
+    if (unix_pid == -1) return STATUS_NOT_SUPPORTED;
+
+    local.iov_base  = buffer;
+    local.iov_len   = size;
+    remote.iov_base = addr;
+    remote.iov_len  = size;
+    if (write) ret = process_vm_writev( unix_pid, &local, 1, &remote, 1, 0 );
+    else ret = process_vm_readv( unix_pid, &local, 1, &remote, 1, 0 );
+    if (ret == size) return STATUS_SUCCESS;
+
+    TRACE( "%p %p %lx: direct copy failed (%ld), using the server\n", process, addr, size,
+           ret == -1 ? (long)-errno : (long)ret );
+#endif
+    return STATUS_NOT_SUPPORTED;
+}
+
+
 /***********************************************************************
  *             NtReadVirtualMemory   (NTDLL.@)
  *             ZwReadVirtualMemory   (NTDLL.@)
@@ -3386,14 +3779,19 @@ NTSTATUS WINAPI NtReadVirtualMemory( HANDLE process, const void *addr, void *buf
 
     if (virtual_check_buffer_for_write( buffer, size ))
     {
-        SERVER_START_REQ( read_process_memory )
+        status = copy_process_memory( process, (void *)addr, buffer, size, FALSE );
+        if (status == STATUS_NOT_SUPPORTED)
         {
-            req->handle = wine_server_obj_handle( process );
-            req->addr   = wine_server_client_ptr( addr );
-            wine_server_set_reply( req, buffer, size );
-            if ((status = wine_server_call( req ))) size = 0;
+            SERVER_START_REQ( read_process_memory )
+            {
+                req->handle = wine_server_obj_handle( process );
+                req->addr   = wine_server_client_ptr( addr );
+                wine_server_set_reply( req, buffer, size );
+                status = wine_server_call( req );
+            }
+            SERVER_END_REQ;
         }
-        SERVER_END_REQ;
+        if (status) size = 0;
     }
     else
     {
@@ -3416,14 +3814,19 @@ NTSTATUS WINAPI NtWriteVirtualMemory( HANDLE process, void *addr, const void *bu
 
     if (virtual_check_buffer_for_read( buffer, size ))
     {
-        SERVER_START_REQ( write_process_memory )
+        status = copy_process_memory( process, addr, (void *)buffer, size, TRUE );
+        if (status == STATUS_NOT_SUPPORTED)
         {
-            req->handle     = wine_server_obj_handle( process );
-            req->addr       = wine_server_client_ptr( addr );
-            wine_server_add_data( req, buffer, size );
-            if ((status = wine_server_call( req ))) size = 0;
+            SERVER_START_REQ( write_process_memory )
+            {
+                req->handle     = wine_server_obj_handle( process );
+                req->addr       = wine_server_client_ptr( addr );
+                wine_server_add_data( req, buffer, size );
+                status = wine_server_call( req );
+            }
+            SERVER_END_REQ;
         }
-        SERVER_END_REQ;
+        if (status) size = 0;
     }
     else
     {
@@ -3447,7 +3850,7 @@ NTSTATUS WINAPI NtAreMappedFilesTheSame(PVOID addr1, PVOID addr2)
 
     TRACE("%p %p\n", addr1, addr2);
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual_shared( &sigset );
 
     view1 = VIRTUAL_FindView( addr1, 0 );
     view2 = VIRTUAL_FindView( addr2, 0 );
@@ -3471,6 +3874,6 @@ NTSTATUS WINAPI NtAreMappedFilesTheSame(PVOID addr1, PVOID addr2)
         SERVER_END_REQ;
     }
 
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual_shared( &sigset );
     return status;
 }
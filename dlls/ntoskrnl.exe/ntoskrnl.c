@@ -90,6 +90,19 @@ static DWORD request_thread;
 static DWORD client_tid;
 static DWORD client_pid;
 
+/* result of an irp completed while the request thread dispatches it; it is
+ * sent along with the request for the next irp to save a server round-trip */
+static struct
+{
+    HANDLE       irp;        /* irp being dispatched by the request thread */
+    BOOL         completed;
+    NTSTATUS     status;
+    ULONG        size;
+    FILE_OBJECT *file;
+    void        *data;
+    ULONG        data_size;
+} irp_result;
+
 struct wine_driver
 {
     struct wine_rb_entry entry;
@@ -176,6 +189,29 @@ static HANDLE get_device_manager(void)
     return ret;
 }
 
+/* keep the result of a synchronously completed IRP for the next get_next_device_request */
+static BOOL defer_irp_result( IRP *irp, FILE_OBJECT *file, void *out_buff )
+{
+    ULONG size = 0, data_size = 0;
+
+    if (irp->IoStatus.u.Status >= 0)
+    {
+        size = irp->IoStatus.Information;
+        if (out_buff) data_size = size;
+    }
+    if (data_size)
+    {
+        if (!(irp_result.data = HeapAlloc( GetProcessHeap(), 0, data_size ))) return FALSE;
+        memcpy( irp_result.data, out_buff, data_size );
+    }
+    irp_result.completed = TRUE;
+    irp_result.status    = irp->IoStatus.u.Status;
+    irp_result.size      = size;
+    irp_result.file      = file;
+    irp_result.data_size = data_size;
+    return TRUE;
+}
+
 /* transfer result of IRP back to wineserver */
 static NTSTATUS WINAPI dispatch_irp_completion( DEVICE_OBJECT *device, IRP *irp, void *context )
 {
@@ -186,19 +222,23 @@ static NTSTATUS WINAPI dispatch_irp_completion( DEVICE_OBJECT *device, IRP *irp,
     if (irp->Flags & IRP_WRITE_OPERATION)
         out_buff = NULL;  /* do not transfer back input buffer */
 
-    SERVER_START_REQ( set_irp_result )
+    if (irp_handle != irp_result.irp || GetCurrentThreadId() != request_thread ||
+        !defer_irp_result( irp, file, out_buff ))
     {
-        req->handle   = wine_server_obj_handle( irp_handle );
-        req->status   = irp->IoStatus.u.Status;
-        req->file_ptr = wine_server_client_ptr( file );
-        if (irp->IoStatus.u.Status >= 0)
+        SERVER_START_REQ( set_irp_result )
         {
-            req->size = irp->IoStatus.Information;
-            if (out_buff) wine_server_add_data( req, out_buff, irp->IoStatus.Information );
+            req->handle   = wine_server_obj_handle( irp_handle );
+            req->status   = irp->IoStatus.u.Status;
+            req->file_ptr = wine_server_client_ptr( file );
+            if (irp->IoStatus.u.Status >= 0)
+            {
+                req->size = irp->IoStatus.Information;
+                if (out_buff) wine_server_add_data( req, out_buff, irp->IoStatus.Information );
+            }
+            wine_server_call( req );
         }
-        wine_server_call( req );
+        SERVER_END_REQ;
     }
-    SERVER_END_REQ;
 
     if (irp->Flags & IRP_CLOSE_OPERATION)
     {
@@ -544,6 +584,12 @@ NTSTATUS CDECL wine_ntoskrnl_main_loop( HANDLE stop_event )
             req->manager = wine_server_obj_handle( manager );
             req->prev = wine_server_obj_handle( irp );
             req->status = status;
+            if (irp_result.completed)
+            {
+                req->result   = irp_result.size;
+                req->file_ptr = wine_server_client_ptr( irp_result.file );
+                wine_server_add_data( req, irp_result.data, irp_result.data_size );
+            }
             wine_server_set_reply( req, in_buff, in_size );
             if (!(status = wine_server_call( req )))
             {
@@ -563,6 +609,12 @@ NTSTATUS CDECL wine_ntoskrnl_main_loop( HANDLE stop_event )
         }
         SERVER_END_REQ;
 
+        if (irp_result.completed)
+        {
+            HeapFree( GetProcessHeap(), 0, irp_result.data );
+            memset( &irp_result, 0, sizeof(irp_result) );
+        }
+
         switch (status)
         {
         case STATUS_SUCCESS:
@@ -572,10 +624,15 @@ NTSTATUS CDECL wine_ntoskrnl_main_loop( HANDLE stop_event )
                 status = STATUS_NOT_SUPPORTED;
                 break;
             }
+            irp_result.irp = irp;
             status = dispatch_funcs[irp_params.major]( &irp_params, in_buff, in_size, out_size, irp );
+            irp_result.irp = 0;
             if (status == STATUS_SUCCESS)
             {
-                irp = 0;  /* status reported by IoCompleteRequest */
+                /* if the irp completed synchronously, the result is sent with the next request,
+                 * otherwise the status is reported by IoCompleteRequest */
+                if (irp_result.completed) status = irp_result.status;
+                else irp = 0;
                 in_size = 4096;
                 in_buff = NULL;
             }
@@ -688,25 +688,21 @@ static HRESULT WINAPI ClientRpcChannelBuffer_GetBuffer(LPRPCCHANNELBUFFER iface,
                                   &message_state->params.iface);
     if (hr == S_OK)
     {
-        /* stub, chan, iface and iid are unneeded in multi-threaded case as we go
-         * via the RPC runtime */
-        if (apt->multi_threaded)
-        {
-            IRpcStubBuffer_Release(message_state->params.stub);
-            message_state->params.stub = NULL;
-            IRpcChannelBuffer_Release(message_state->params.chan);
-            message_state->params.chan = NULL;
-            message_state->params.iface = NULL;
-        }
-        else
+        /* the object lives in this process, so the call can be handed to the
+         * target apartment directly instead of going through the RPC runtime */
+        message_state->params.bypass_rpcrt = TRUE;
+
+        if (!apt->multi_threaded)
         {
-            message_state->params.bypass_rpcrt = TRUE;
             message_state->target_hwnd = apartment_getwindow(apt);
             message_state->target_tid = apt->tid;
-            /* we assume later on that this being non-NULL is the indicator that
-             * means call directly instead of going through RPC runtime */
+            /* calls to single-threaded apartments are posted to the apartment
+             * window, a NULL window means calls to multi-threaded apartments */
             if (!message_state->target_hwnd)
+            {
                 ERR("window for apartment %s is NULL\n", wine_dbgstr_longlong(apt->oxid));
+                message_state->params.bypass_rpcrt = FALSE;
+            }
         }
     }
     if (apt) apartment_release(apt);
@@ -715,7 +711,7 @@ static HRESULT WINAPI ClientRpcChannelBuffer_GetBuffer(LPRPCCHANNELBUFFER iface,
      * ClientRpcChannelBuffer_SendReceive */
 
     /* shortcut the RPC runtime */
-    if (message_state->target_hwnd)
+    if (message_state->params.bypass_rpcrt)
     {
         msg->Buffer = HeapAlloc(GetProcessHeap(), 0, msg->BufferLength);
         if (msg->Buffer)
@@ -790,6 +786,25 @@ static HRESULT WINAPI ServerRpcChannelBuffer_SendReceive(LPRPCCHANNELBUFFER ifac
     return E_NOTIMPL;
 }
 
+/* this thread executes a call to an in-process multi-threaded apartment */
+static DWORD WINAPI rpc_execute_mta_thread(LPVOID param)
+{
+    struct dispatch_params *params = param;
+    struct oletls *info = COM_CurrentInfo();
+    BOOL joined = FALSE;
+
+    if (!info->apt)
+    {
+        enter_apartment(info, COINIT_MULTITHREADED);
+        joined = TRUE;
+    }
+    RPC_ExecuteCall(params);
+    if (joined)
+        leave_apartment(info);
+
+    return 0;
+}
+
 /* this thread runs an outgoing RPC */
 static DWORD WINAPI rpc_sendreceive_thread(LPVOID param)
 {
@@ -870,7 +885,22 @@ static HRESULT WINAPI ClientRpcChannelBuffer_SendReceive(LPRPCCHANNELBUFFER ifac
      * from DllMain */
 
     message_state->params.msg = olemsg;
-    if (message_state->params.bypass_rpcrt)
+    if (message_state->params.bypass_rpcrt && !message_state->target_hwnd)
+    {
+        TRACE("Calling multi-threaded apartment...\n");
+
+        msg->ProcNum &= ~RPC_FLAGS_VALID_BIT;
+
+        /* the calling thread has to keep pumping messages, see below */
+        if (!QueueUserWorkItem(rpc_execute_mta_thread, &message_state->params, WT_EXECUTEDEFAULT))
+        {
+            ERR("QueueUserWorkItem failed with error %u\n", GetLastError());
+            hr = E_UNEXPECTED;
+        }
+        else
+            hr = S_OK;
+    }
+    else if (message_state->params.bypass_rpcrt)
     {
         TRACE("Calling apartment thread 0x%08x...\n", message_state->target_tid);
 
@@ -1204,6 +1204,7 @@ typedef struct tagTLBFuncDesc
     const TLBString *HelpString;
     const TLBString *Entry;            /* if IS_INTRESOURCE true, it's numeric; if -1 it isn't present */
     struct list custdata_list;
+    VARTYPE *invoke_vts;    /* Invoke() argument types followed by the return type, computed on first use */
 } TLBFuncDesc;
 
 /* internal Variable data */
@@ -1301,6 +1302,13 @@ typedef struct tagTLBContext
 	void *mapping;        /* memory mapping */
 	MSFT_SegDir * pTblDir;
 	ITypeLibImpl* pLibInfo;
+	/* offset ordered lookup tables, only valid while loading */
+	TLBGuid **guids;
+	unsigned int guid_cnt;
+	TLBString **names;
+	unsigned int name_cnt;
+	TLBString **strings;
+	unsigned int string_cnt;
 } TLBContext;
 
 
@@ -2073,6 +2081,11 @@ static HRESULT MSFT_ReadAllGuids(TLBContext *pcx)
     MSFT_GuidEntry entry;
     int offs = 0;
 
+    pcx->guid_cnt = 0;
+    pcx->guids = heap_alloc((pcx->pTblDir->pGuidTab.length / sizeof(MSFT_GuidEntry) + 1) * sizeof(*pcx->guids));
+    if (!pcx->guids)
+        return E_OUTOFMEMORY;
+
     MSFT_Seek(pcx, pcx->pTblDir->pGuidTab.offset);
     while (1) {
         if (offs >= pcx->pTblDir->pGuidTab.length)
@@ -2087,6 +2100,7 @@ static HRESULT MSFT_ReadAllGuids(TLBContext *pcx)
         guid->hreftype = entry.hreftype;
 
         list_add_tail(&pcx->pLibInfo->guid_list, &guid->entry);
+        pcx->guids[pcx->guid_cnt++] = guid;
 
         offs += sizeof(MSFT_GuidEntry);
     }
@@ -2096,14 +2110,13 @@ static TLBGuid *MSFT_ReadGuid( int offset, TLBContext *pcx)
 {
     TLBGuid *ret;
 
-    LIST_FOR_EACH_ENTRY(ret, &pcx->pLibInfo->guid_list, TLBGuid, entry){
-        if(ret->offset == offset){
-            TRACE_(typelib)("%s\n", debugstr_guid(&ret->guid));
-            return ret;
-        }
-    }
+    /* guid entries have a fixed size, so the offset is a table index */
+    if (offset < 0 || offset % sizeof(MSFT_GuidEntry) || offset / sizeof(MSFT_GuidEntry) >= pcx->guid_cnt)
+        return NULL;
 
-    return NULL;
+    ret = pcx->guids[offset / sizeof(MSFT_GuidEntry)];
+    TRACE_(typelib)("%s\n", debugstr_guid(&ret->guid));
+    return ret;
 }
 
 static HREFTYPE MSFT_ReadHreftype( TLBContext *pcx, int offset )
@@ -2129,6 +2142,12 @@ static HRESULT MSFT_ReadAllNames(TLBContext *pcx)
     INT16 len_piece;
     int offs = 0, lengthInChars;
 
+    /* every name takes at least 8 bytes */
+    pcx->name_cnt = 0;
+    pcx->names = heap_alloc((pcx->pTblDir->pNametab.length / 8 + 1) * sizeof(*pcx->names));
+    if (!pcx->names)
+        return E_OUTOFMEMORY;
+
     MSFT_Seek(pcx, pcx->pTblDir->pNametab.offset);
     while (1) {
         TLBString *tlbstr;
@@ -2164,37 +2183,43 @@ static HRESULT MSFT_ReadAllNames(TLBContext *pcx)
         heap_free(string);
 
         list_add_tail(&pcx->pLibInfo->name_list, &tlbstr->entry);
+        pcx->names[pcx->name_cnt++] = tlbstr;
 
         offs += len_piece;
     }
 }
 
-static TLBString *MSFT_ReadName( TLBContext *pcx, int offset)
+static TLBString *MSFT_FindString( TLBString **table, unsigned int count, int offset )
 {
-    TLBString *tlbstr;
+    unsigned int min = 0, max = count;
 
-    LIST_FOR_EACH_ENTRY(tlbstr, &pcx->pLibInfo->name_list, TLBString, entry) {
-        if (tlbstr->offset == offset) {
-            TRACE_(typelib)("%s\n", debugstr_w(tlbstr->str));
-            return tlbstr;
+    while (min < max)
+    {
+        unsigned int i = (min + max) / 2;
+
+        if (table[i]->offset == offset)
+        {
+            TRACE_(typelib)("%s\n", debugstr_w(table[i]->str));
+            return table[i];
         }
+
+        if (table[i]->offset < offset)
+            min = i + 1;
+        else
+            max = i;
     }
 
     return NULL;
 }
 
-static TLBString *MSFT_ReadString( TLBContext *pcx, int offset)
+static TLBString *MSFT_ReadName( TLBContext *pcx, int offset)
 {
-    TLBString *tlbstr;
-
-    LIST_FOR_EACH_ENTRY(tlbstr, &pcx->pLibInfo->string_list, TLBString, entry) {
-        if (tlbstr->offset == offset) {
-            TRACE_(typelib)("%s\n", debugstr_w(tlbstr->str));
-            return tlbstr;
-        }
-    }
+    return MSFT_FindString(pcx->names, pcx->name_cnt, offset);
+}
 
-    return NULL;
+static TLBString *MSFT_ReadString( TLBContext *pcx, int offset)
+{
+    return MSFT_FindString(pcx->strings, pcx->string_cnt, offset);
 }
 
 /*
@@ -2755,6 +2780,12 @@ static HRESULT MSFT_ReadAllStrings(TLBContext *pcx)
     INT16 len_str, len_piece;
     int offs = 0, lengthInChars;
 
+    /* every string takes at least 8 bytes */
+    pcx->string_cnt = 0;
+    pcx->strings = heap_alloc((pcx->pTblDir->pStringtab.length / 8 + 1) * sizeof(*pcx->strings));
+    if (!pcx->strings)
+        return E_OUTOFMEMORY;
+
     MSFT_Seek(pcx, pcx->pTblDir->pStringtab.offset);
     while (1) {
         TLBString *tlbstr;
@@ -2789,6 +2820,7 @@ static HRESULT MSFT_ReadAllStrings(TLBContext *pcx)
         heap_free(string);
 
         list_add_tail(&pcx->pLibInfo->string_list, &tlbstr->entry);
+        pcx->strings[pcx->string_cnt++] = tlbstr;
 
         offs += len_piece;
     }
@@ -3464,6 +3496,12 @@ static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength)
     cx.mapping = pLib;
     cx.pLibInfo = pTypeLibImpl;
     cx.length = dwTLBLength;
+    cx.guids = NULL;
+    cx.guid_cnt = 0;
+    cx.names = NULL;
+    cx.name_cnt = 0;
+    cx.strings = NULL;
+    cx.string_cnt = 0;
 
     /* read header */
     MSFT_ReadLEDWords(&tlbHeader, sizeof(tlbHeader), &cx, 0);
@@ -3649,6 +3687,10 @@ static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength)
         }
     }
 
+    heap_free(cx.guids);
+    heap_free(cx.names);
+    heap_free(cx.strings);
+
 #ifdef _WIN64
     if(pTypeLibImpl->syskind == SYS_WIN32){
         for(i = 0; i < pTypeLibImpl->TypeInfoCount; ++i)
@@ -5608,6 +5650,7 @@ static void ITypeInfoImpl_Destroy(ITypeInfoImpl *This)
         }
         heap_free(pFInfo->funcdesc.lprgelemdescParam);
         heap_free(pFInfo->pParamDesc);
+        heap_free(pFInfo->invoke_vts);
         TLB_FreeCustData(&pFInfo->custdata_list);
     }
     heap_free(This->funcdescs);
@@ -6633,6 +6676,9 @@ static HRESULT get_iface_guid(ITypeInfo *tinfo, const TYPEDESC *tdesc, GUID *gui
     return hres;
 }
 
+/* calls with up to this many arguments are marshalled into a stack buffer */
+#define DISPCALL_STACK_ARGS 16
+
 /***********************************************************************
  *		DispCallFunc (OLEAUT32.@)
  *
@@ -6680,6 +6726,7 @@ DispCallFunc(
     int argspos, stack_offset;
     void *func;
     UINT i;
+    DWORD stack_args[2 + DISPCALL_STACK_ARGS * sizeof(VARIANT) / sizeof(DWORD)];
     DWORD *args;
 
     TRACE("(%p, %ld, %d, %d, %d, %p, %p, %p (vt=%d))\n",
@@ -6693,7 +6740,10 @@ DispCallFunc(
     }
 
     /* maximum size for an argument is sizeof(VARIANT) */
-    args = heap_alloc(sizeof(VARIANT) * cActuals + sizeof(DWORD) * 2 );
+    if (cActuals <= DISPCALL_STACK_ARGS)
+        args = stack_args;
+    else if (!(args = heap_alloc(sizeof(VARIANT) * cActuals + sizeof(DWORD) * 2 )))
+        return E_OUTOFMEMORY;
 
     /* start at 1 in case we need to pass a pointer to the return value as arg 0 */
     argspos = 1;
@@ -6760,13 +6810,13 @@ DispCallFunc(
         break;
     case VT_HRESULT:
         WARN("invalid return type %u\n", vtReturn);
-        heap_free( args );
+        if (args != stack_args) heap_free( args );
         return E_INVALIDARG;
     default:
         V_UI4(pvargResult) = call_method( func, argspos - 1, args + 1, &stack_offset );
         break;
     }
-    heap_free( args );
+    if (args != stack_args) heap_free( args );
     if (stack_offset && cc == CC_STDCALL)
     {
         WARN( "stack pointer off by %d\n", stack_offset );
@@ -6779,6 +6829,7 @@ DispCallFunc(
 #elif defined(__x86_64__)
     int argspos;
     UINT i;
+    DWORD_PTR stack_args[DISPCALL_STACK_ARGS + 2];
     DWORD_PTR *args;
     void *func;
 
@@ -6793,7 +6844,10 @@ DispCallFunc(
     }
 
     /* maximum size for an argument is sizeof(DWORD_PTR) */
-    args = heap_alloc( sizeof(DWORD_PTR) * (cActuals + 2) );
+    if (cActuals <= DISPCALL_STACK_ARGS)
+        args = stack_args;
+    else if (!(args = heap_alloc( sizeof(DWORD_PTR) * (cActuals + 2) )))
+        return E_OUTOFMEMORY;
 
     /* start at 1 in case we need to pass a pointer to the return value as arg 0 */
     argspos = 1;
@@ -6841,13 +6895,13 @@ DispCallFunc(
         break;
     case VT_HRESULT:
         WARN("invalid return type %u\n", vtReturn);
-        heap_free( args );
+        if (args != stack_args) heap_free( args );
         return E_INVALIDARG;
     default:
         V_UI8(pvargResult) = call_method( func, argspos - 1, args + 1 );
         break;
     }
-    heap_free( args );
+    if (args != stack_args) heap_free( args );
     if (vtReturn != VT_VARIANT) V_VT(pvargResult) = vtReturn;
     TRACE("retval: %s\n", debugstr_variant(pvargResult));
     return S_OK;
@@ -7050,6 +7104,60 @@ static inline BOOL func_restricted( const FUNCDESC *desc )
 #define INVBUF_GET_ARG_TYPE_ARRAY(buffer, params) \
     ((VARTYPE *)((char *)(buffer) + (sizeof(VARIANTARG) + sizeof(VARIANTARG) + sizeof(VARIANTARG *)) * (params)))
 
+/* calls with up to this many parameters don't need a heap allocated buffer */
+#define INVBUF_STACK_PARAMS 8
+
+/* Converting the parameter types requires resolving referenced type infos,
+ * which is expensive, so do it once per function. The last entry holds the
+ * return type. */
+static HRESULT get_invoke_vts(ITypeInfo *tinfo, TLBFuncDesc *func, const VARTYPE **ret)
+{
+    const FUNCDESC *func_desc = &func->funcdesc;
+    VARTYPE *vts;
+    HRESULT hres;
+    int i;
+
+    if (func->invoke_vts)
+    {
+        *ret = func->invoke_vts;
+        return S_OK;
+    }
+
+    vts = heap_alloc_zero((func_desc->cParams + 1) * sizeof(*vts));
+    if (!vts)
+        return E_OUTOFMEMORY;
+
+    for (i = 0; i < func_desc->cParams; i++)
+    {
+        hres = typedescvt_to_variantvt(tinfo, &func_desc->lprgelemdescParam[i].tdesc, &vts[i]);
+        if (FAILED(hres))
+        {
+            heap_free(vts);
+            return hres;
+        }
+    }
+
+    /* VT_VOID is a special case for return types, so it is not
+     * handled in the general function */
+    if (func_desc->elemdescFunc.tdesc.vt == VT_VOID)
+        vts[func_desc->cParams] = VT_EMPTY;
+    else
+    {
+        hres = typedescvt_to_variantvt(tinfo, &func_desc->elemdescFunc.tdesc, &vts[func_desc->cParams]);
+        if (FAILED(hres))
+        {
+            heap_free(vts);
+            return hres;
+        }
+    }
+
+    if (InterlockedCompareExchangePointer((void **)&func->invoke_vts, vts, NULL))
+        heap_free(vts);
+
+    *ret = func->invoke_vts;
+    return S_OK;
+}
+
 static HRESULT WINAPI ITypeInfo_fnInvoke(
     ITypeInfo2 *iface,
     VOID  *pIUnk,
@@ -7112,16 +7220,33 @@ static HRESULT WINAPI ITypeInfo_fnInvoke(
 	switch (func_desc->funckind) {
 	case FUNC_PUREVIRTUAL:
 	case FUNC_VIRTUAL: {
-            void *buffer = heap_alloc_zero(INVBUF_ELEMENT_SIZE * func_desc->cParams);
+            VARIANTARG stack_buffer[(INVBUF_ELEMENT_SIZE * INVBUF_STACK_PARAMS + sizeof(VARIANTARG) - 1) / sizeof(VARIANTARG)];
+            void *buffer;
             VARIANT varresult;
             VARIANT retval; /* pointer for storing byref retvals in */
-            VARIANTARG **prgpvarg = INVBUF_GET_ARG_PTR_ARRAY(buffer, func_desc->cParams);
-            VARIANTARG *rgvarg = INVBUF_GET_ARG_ARRAY(buffer, func_desc->cParams);
-            VARTYPE *rgvt = INVBUF_GET_ARG_TYPE_ARRAY(buffer, func_desc->cParams);
+            VARIANTARG **prgpvarg;
+            VARIANTARG *rgvarg;
+            VARTYPE *rgvt;
+            const VARTYPE *invoke_vts;
             UINT cNamedArgs = pDispParams->cNamedArgs;
             DISPID *rgdispidNamedArgs = pDispParams->rgdispidNamedArgs;
             UINT vargs_converted=0;
 
+            if (func_desc->cParams <= INVBUF_STACK_PARAMS)
+            {
+                buffer = stack_buffer;
+                memset(buffer, 0, INVBUF_ELEMENT_SIZE * func_desc->cParams);
+            }
+            else
+            {
+                buffer = heap_alloc_zero(INVBUF_ELEMENT_SIZE * func_desc->cParams);
+                if (!buffer)
+                    return E_OUTOFMEMORY;
+            }
+            prgpvarg = INVBUF_GET_ARG_PTR_ARRAY(buffer, func_desc->cParams);
+            rgvarg = INVBUF_GET_ARG_ARRAY(buffer, func_desc->cParams);
+            rgvt = INVBUF_GET_ARG_TYPE_ARRAY(buffer, func_desc->cParams);
+
             hres = S_OK;
 
             if (func_desc->invkind & (INVOKE_PROPERTYPUT|INVOKE_PROPERTYPUTREF))
@@ -7141,13 +7266,10 @@ static HRESULT WINAPI ITypeInfo_fnInvoke(
                 goto func_fail;
             }
 
-            for (i = 0; i < func_desc->cParams; i++)
-            {
-                TYPEDESC *tdesc = &func_desc->lprgelemdescParam[i].tdesc;
-                hres = typedescvt_to_variantvt((ITypeInfo *)iface, tdesc, &rgvt[i]);
-                if (FAILED(hres))
-                    goto func_fail;
-            }
+            hres = get_invoke_vts((ITypeInfo *)iface, (TLBFuncDesc *)pFuncInfo, &invoke_vts);
+            if (FAILED(hres))
+                goto func_fail;
+            memcpy(rgvt, invoke_vts, func_desc->cParams * sizeof(*rgvt));
 
             TRACE("changing args\n");
             for (i = 0; i < func_desc->cParams; i++)
@@ -7367,16 +7489,7 @@ static HRESULT WINAPI ITypeInfo_fnInvoke(
             }
             if (FAILED(hres)) goto func_fail; /* FIXME: we don't free changed types here */
 
-            /* VT_VOID is a special case for return types, so it is not
-             * handled in the general function */
-            if (func_desc->elemdescFunc.tdesc.vt == VT_VOID)
-                V_VT(&varresult) = VT_EMPTY;
-            else
-            {
-                V_VT(&varresult) = 0;
-                hres = typedescvt_to_variantvt((ITypeInfo *)iface, &func_desc->elemdescFunc.tdesc, &V_VT(&varresult));
-                if (FAILED(hres)) goto func_fail; /* FIXME: we don't free changed types here */
-            }
+            V_VT(&varresult) = invoke_vts[func_desc->cParams];
 
             hres = DispCallFunc(pIUnk, func_desc->oVft & 0xFFFC, func_desc->callconv,
                                 V_VT(&varresult), func_desc->cParams, rgvt,
@@ -7517,7 +7630,8 @@ static HRESULT WINAPI ITypeInfo_fnInvoke(
             }
 
 func_fail:
-            heap_free(buffer);
+            if (buffer != stack_buffer)
+                heap_free(buffer);
             break;
         }
 	case FUNC_DISPATCH:  {
@@ -24,8 +24,12 @@
 
 #define NONAMELESSUNION
 
+#include "ntstatus.h"
+#define WIN32_NO_STATUS
 #include "windef.h"
 #include "winbase.h"
+#include "winreg.h"
+#include "winternl.h"
 
 #include "pdh.h"
 #include "pdhmsg.h"
@@ -68,6 +72,26 @@ static inline WCHAR *pdh_strdup_aw( const char *src )
     return dst;
 }
 
+#define DEFAULT_REFRESH_INTERVAL 100
+
+/* system data shared by all counters, refreshed at most once per interval
+ * so that sampling many counters stays cheap; protected by pdh_handle_cs */
+static struct
+{
+    ULONGLONG stamp;        /* tick count of the last refresh */
+    DWORD     interval;     /* refresh interval in ms, 0 if not read yet */
+    ULONGLONG idle;         /* idle time of all processors */
+    ULONGLONG prev_idle;
+    ULONGLONG busy;         /* kernel and user time of all processors */
+    ULONGLONG prev_busy;
+    ULONGLONG avail_phys;   /* available physical memory */
+    ULONG     processes;    /* number of processes */
+    ULONG     threads;      /* number of threads of all processes */
+    ULONG     handles;      /* number of handles of all processes */
+    void     *buffer;       /* process information buffer */
+    ULONG     buffer_size;
+} snapshot;
+
 BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD fdwReason, LPVOID lpvReserved)
 {
     TRACE("(0x%p, %d, %p)\n",hinstDLL,fdwReason,lpvReserved);
@@ -80,6 +104,7 @@ BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD fdwReason, LPVOID lpvReserved)
         break;
     case DLL_PROCESS_DETACH:
         if (lpvReserved) break;
+        heap_free( snapshot.buffer );
         DeleteCriticalSection(&pdh_handle_cs);
         break;
     }
@@ -180,10 +205,141 @@ static const WCHAR path_processor_time[] =
      '\\','%',' ','P','r','o','c','e','s','s','o','r',' ','T','i','m','e',0};
 static const WCHAR path_uptime[] =
     {'\\','S','y','s','t','e','m', '\\', 'S','y','s','t','e','m',' ','U','p',' ','T','i','m','e',0};
+static const WCHAR path_processes[] =
+    {'\\','S','y','s','t','e','m','\\','P','r','o','c','e','s','s','e','s',0};
+static const WCHAR path_threads[] =
+    {'\\','S','y','s','t','e','m','\\','T','h','r','e','a','d','s',0};
+static const WCHAR path_available_bytes[] =
+    {'\\','M','e','m','o','r','y','\\','A','v','a','i','l','a','b','l','e',' ','B','y','t','e','s',0};
+static const WCHAR path_handle_count[] =
+    {'\\','P','r','o','c','e','s','s','(','_','T','o','t','a','l',')',
+     '\\','H','a','n','d','l','e',' ','C','o','u','n','t',0};
+static const WCHAR path_thread_count[] =
+    {'\\','P','r','o','c','e','s','s','(','_','T','o','t','a','l',')',
+     '\\','T','h','r','e','a','d',' ','C','o','u','n','t',0};
+
+static DWORD get_refresh_interval( void )
+{
+    static const WCHAR pdh_keyW[] =
+        {'S','o','f','t','w','a','r','e','\\','W','i','n','e','\\','P','d','h',0};
+    static const WCHAR refresh_intervalW[] =
+        {'R','e','f','r','e','s','h','I','n','t','e','r','v','a','l',0};
+    DWORD value = DEFAULT_REFRESH_INTERVAL, type, size = sizeof(value);
+    HKEY key;
+
+    /* @@ Wine registry key: HKCU\Software\Wine\Pdh */
+    if (!RegOpenKeyExW( HKEY_CURRENT_USER, pdh_keyW, 0, KEY_READ, &key ))
+    {
+        if (RegQueryValueExW( key, refresh_intervalW, NULL, &type, (BYTE *)&value, &size ) ||
+            type != REG_DWORD)
+            value = DEFAULT_REFRESH_INTERVAL;
+        RegCloseKey( key );
+    }
+    return max( value, 1 );
+}
+
+static void refresh_processes( void )
+{
+    SYSTEM_PROCESS_INFORMATION *spi;
+    NTSTATUS status;
+    ULONG size;
+    void *buffer;
+
+    if (!snapshot.buffer_size) snapshot.buffer_size = 0x10000;
+    for (;;)
+    {
+        if (!snapshot.buffer && !(snapshot.buffer = heap_alloc( snapshot.buffer_size ))) return;
+        status = NtQuerySystemInformation( SystemProcessInformation, snapshot.buffer,
+                                           snapshot.buffer_size, &size );
+        if (status != STATUS_INFO_LENGTH_MISMATCH) break;
+
+        size = max( size, snapshot.buffer_size * 2 );
+        if (!(buffer = heap_realloc( snapshot.buffer, size ))) return;
+        snapshot.buffer = buffer;
+        snapshot.buffer_size = size;
+    }
+    if (status) return;
+
+    snapshot.processes = snapshot.threads = snapshot.handles = 0;
+    spi = snapshot.buffer;
+    for (;;)
+    {
+        snapshot.processes++;
+        snapshot.threads += spi->dwThreadCount;
+        snapshot.handles += spi->HandleCount;
+        if (!spi->NextEntryOffset) break;
+        spi = (SYSTEM_PROCESS_INFORMATION *)((char *)spi + spi->NextEntryOffset);
+    }
+}
+
+static void refresh_snapshot( void )
+{
+    ULONGLONG now = GetTickCount64();
+    SYSTEM_PROCESSOR_PERFORMANCE_INFORMATION sppi[MAXIMUM_PROCESSORS];
+    MEMORYSTATUSEX status;
+    ULONG i, size;
+
+    if (!snapshot.interval) snapshot.interval = get_refresh_interval();
+    if (snapshot.stamp && now - snapshot.stamp < snapshot.interval) return;
+    snapshot.stamp = now;
+
+    if (!NtQuerySystemInformation( SystemProcessorPerformanceInformation, sppi, sizeof(sppi), &size ))
+    {
+        snapshot.prev_idle = snapshot.idle;
+        snapshot.prev_busy = snapshot.busy;
+        snapshot.idle = snapshot.busy = 0;
+        for (i = 0; i < size / sizeof(sppi[0]); i++)
+        {
+            snapshot.idle += sppi[i].IdleTime.QuadPart;
+            /* kernel time includes idle time */
+            snapshot.busy += sppi[i].KernelTime.QuadPart + sppi[i].UserTime.QuadPart - sppi[i].IdleTime.QuadPart;
+        }
+    }
+
+    status.dwLength = sizeof(status);
+    if (GlobalMemoryStatusEx( &status )) snapshot.avail_phys = status.ullAvailPhys;
+
+    refresh_processes();
+}
 
 static void CALLBACK collect_processor_time( struct counter *counter )
 {
-    counter->two.largevalue = 500000; /* FIXME */
+    ULONGLONG idle, busy;
+
+    refresh_snapshot();
+    idle = snapshot.idle - snapshot.prev_idle;
+    busy = snapshot.busy - snapshot.prev_busy;
+
+    /* percentage of the interval between the last two refreshes, scaled by the 10^-5 default */
+    counter->two.largevalue = idle + busy ? busy * 10000000 / (idle + busy) : 0;
+    counter->status = PDH_CSTATUS_VALID_DATA;
+}
+
+static void CALLBACK collect_processes( struct counter *counter )
+{
+    refresh_snapshot();
+    counter->two.largevalue = snapshot.processes;
+    counter->status = PDH_CSTATUS_VALID_DATA;
+}
+
+static void CALLBACK collect_threads( struct counter *counter )
+{
+    refresh_snapshot();
+    counter->two.largevalue = snapshot.threads;
+    counter->status = PDH_CSTATUS_VALID_DATA;
+}
+
+static void CALLBACK collect_handles( struct counter *counter )
+{
+    refresh_snapshot();
+    counter->two.largevalue = snapshot.handles;
+    counter->status = PDH_CSTATUS_VALID_DATA;
+}
+
+static void CALLBACK collect_available_bytes( struct counter *counter )
+{
+    refresh_snapshot();
+    counter->two.largevalue = snapshot.avail_phys;
     counter->status = PDH_CSTATUS_VALID_DATA;
 }
 
@@ -200,11 +356,22 @@ static void CALLBACK collect_uptime( struct counter *counter )
 #define TYPE_UPTIME \
     (PERF_SIZE_LARGE | PERF_TYPE_COUNTER | PERF_COUNTER_ELAPSED | PERF_OBJECT_TIMER | PERF_DISPLAY_SECONDS)
 
+#define TYPE_RAWCOUNT \
+    (PERF_SIZE_DWORD | PERF_TYPE_NUMBER | PERF_NUMBER_DECIMAL | PERF_DISPLAY_NO_SUFFIX)
+
+#define TYPE_LARGE_RAWCOUNT \
+    (PERF_SIZE_LARGE | PERF_TYPE_NUMBER | PERF_NUMBER_DECIMAL | PERF_DISPLAY_NO_SUFFIX)
+
 /* counter source registry */
 static const struct source counter_sources[] =
 {
     { 6,    path_processor_time,    collect_processor_time,     TYPE_PROCESSOR_TIME,    -5,     10000000 },
-    { 674,  path_uptime,            collect_uptime,             TYPE_UPTIME,            -3,     1000 }
+    { 24,   path_available_bytes,   collect_available_bytes,    TYPE_LARGE_RAWCOUNT,    0,      0 },
+    { 248,  path_processes,         collect_processes,          TYPE_RAWCOUNT,          0,      0 },
+    { 250,  path_threads,           collect_threads,            TYPE_RAWCOUNT,          0,      0 },
+    { 674,  path_uptime,            collect_uptime,             TYPE_UPTIME,            -3,     1000 },
+    { 680,  path_thread_count,      collect_threads,            TYPE_RAWCOUNT,          0,      0 },
+    { 952,  path_handle_count,      collect_handles,            TYPE_RAWCOUNT,          0,      0 }
 };
 
 static BOOL is_local_machine( const WCHAR *name, DWORD len )
@@ -428,6 +428,42 @@ static void test_PdhGetRawCounterValue( void )
     ok(ret == ERROR_SUCCESS, "PdhCloseQuery failed 0x%08x\n", ret);
 }
 
+static void test_system_counters( void )
+{
+    static const char * const paths[] =
+    {
+        "\\System\\Processes",
+        "\\System\\Threads",
+        "\\Memory\\Available Bytes",
+        "\\Process(_Total)\\Thread Count"
+    };
+    PDH_STATUS ret;
+    PDH_HQUERY query;
+    PDH_HCOUNTER counter;
+    PDH_FMT_COUNTERVALUE value;
+    unsigned int i;
+
+    for (i = 0; i < sizeof(paths) / sizeof(paths[0]); i++)
+    {
+        ret = PdhOpenQueryA( NULL, 0, &query );
+        ok(ret == ERROR_SUCCESS, "PdhOpenQueryA failed 0x%08x\n", ret);
+
+        ret = PdhAddCounterA( query, paths[i], 0, &counter );
+        ok(ret == ERROR_SUCCESS, "%s: PdhAddCounterA failed 0x%08x\n", paths[i], ret);
+
+        ret = PdhCollectQueryData( query );
+        ok(ret == ERROR_SUCCESS, "%s: PdhCollectQueryData failed 0x%08x\n", paths[i], ret);
+
+        ret = PdhGetFormattedCounterValue( counter, PDH_FMT_LARGE | PDH_FMT_NOSCALE, NULL, &value );
+        ok(ret == ERROR_SUCCESS, "%s: PdhGetFormattedCounterValue failed 0x%08x\n", paths[i], ret);
+        ok(value.CStatus == ERROR_SUCCESS, "%s: expected ERROR_SUCCESS got %x\n", paths[i], value.CStatus);
+        ok(U(value).largeValue > 0, "%s: got %s\n", paths[i], wine_dbgstr_longlong(U(value).largeValue));
+
+        ret = PdhCloseQuery( query );
+        ok(ret == ERROR_SUCCESS, "PdhCloseQuery failed 0x%08x\n", ret);
+    }
+}
+
 static void test_PdhSetCounterScaleFactor( void )
 {
     PDH_STATUS ret;
@@ -1005,6 +1041,7 @@ START_TEST(pdh)
 
     test_PdhGetFormattedCounterValue();
     test_PdhGetRawCounterValue();
+    test_system_counters();
     test_PdhSetCounterScaleFactor();
     test_PdhGetCounterTimeBase();
 
@@ -33,6 +33,7 @@ WINE_DEFAULT_DEBUG_CHANNEL(quartz);
 
 typedef struct StdMediaSample2
 {
+    SLIST_ENTRY freeentry;
     IMediaSample2 IMediaSample2_iface;
     LONG ref;
     AM_SAMPLE2_PROPERTIES props;
@@ -54,12 +55,17 @@ typedef struct BaseMemAllocator
     HRESULT (* fnBufferPrepare)(IMemAllocator *, StdMediaSample2 *, DWORD flags);
     HRESULT (* fnBufferReleased)(IMemAllocator *, StdMediaSample2 *);
     void (* fnDestroyed)(IMemAllocator *);
-    HANDLE hSemWaiting;
+    /* free samples, popped without taking pCritSect */
+    SLIST_HEADER free_list;
+    /* all samples, only changed while committing and decommitting */
+    struct list sample_list;
+    /* held shared by GetBuffer, exclusive (inside pCritSect) when committing or decommitting */
+    SRWLOCK state_lock;
+    CONDITION_VARIABLE free_cond;
     BOOL bDecommitQueued;
     BOOL bCommitted;
     LONG lWaiting;
-    struct list free_list;
-    struct list used_list;
+    LONG lOutstanding;
     CRITICAL_SECTION *pCritSect;
 } BaseMemAllocator;
 
@@ -76,6 +82,9 @@ static inline StdMediaSample2 *unsafe_impl_from_IMediaSample(IMediaSample * ifac
 
 #define INVALID_MEDIA_TIME (((ULONGLONG)0x7fffffff << 32) | 0xffffffff)
 
+/* minimum alignment of sample buffers, a cache line and wide enough for any SIMD load */
+#define SAMPLE_ALIGN 64
+
 static HRESULT BaseMemAllocator_Init(HRESULT (* fnAlloc)(IMemAllocator *),
                                      HRESULT (* fnFree)(IMemAllocator *),
                                      HRESULT (* fnVerify)(IMemAllocator *, ALLOCATOR_PROPERTIES *),
@@ -91,8 +100,10 @@ static HRESULT BaseMemAllocator_Init(HRESULT (* fnAlloc)(IMemAllocator *),
 
     pMemAlloc->ref = 1;
     ZeroMemory(&pMemAlloc->props, sizeof(pMemAlloc->props));
-    list_init(&pMemAlloc->free_list);
-    list_init(&pMemAlloc->used_list);
+    InitializeSListHead(&pMemAlloc->free_list);
+    list_init(&pMemAlloc->sample_list);
+    InitializeSRWLock(&pMemAlloc->state_lock);
+    InitializeConditionVariable(&pMemAlloc->free_cond);
     pMemAlloc->fnAlloc = fnAlloc;
     pMemAlloc->fnFree = fnFree;
     pMemAlloc->fnVerify = fnVerify;
@@ -101,8 +112,8 @@ static HRESULT BaseMemAllocator_Init(HRESULT (* fnAlloc)(IMemAllocator *),
     pMemAlloc->fnDestroyed = fnDestroyed;
     pMemAlloc->bDecommitQueued = FALSE;
     pMemAlloc->bCommitted = FALSE;
-    pMemAlloc->hSemWaiting = NULL;
     pMemAlloc->lWaiting = 0;
+    pMemAlloc->lOutstanding = 0;
     pMemAlloc->pCritSect = pCritSect;
 
     return S_OK;
@@ -150,7 +161,6 @@ static ULONG WINAPI BaseMemAllocator_Release(IMemAllocator * iface)
 
     if (!ref)
     {
-        CloseHandle(This->hSemWaiting);
         if (This->bCommitted)
             This->fnFree(iface);
 
@@ -169,7 +179,7 @@ static HRESULT WINAPI BaseMemAllocator_SetProperties(IMemAllocator * iface, ALLO
 
     EnterCriticalSection(This->pCritSect);
     {
-        if (!list_empty(&This->used_list))
+        if (This->lOutstanding)
             hr = VFW_E_BUFFERS_OUTSTANDING;
         else if (This->bCommitted)
             hr = VFW_E_ALREADY_COMMITTED;
@@ -217,6 +227,7 @@ static HRESULT WINAPI BaseMemAllocator_Commit(IMemAllocator * iface)
     TRACE("(%p)->()\n", This);
 
     EnterCriticalSection(This->pCritSect);
+    AcquireSRWLockExclusive(&This->state_lock);
     {
         if (!This->props.cbAlign)
             hr = VFW_E_BADALIGN;
@@ -233,21 +244,14 @@ static HRESULT WINAPI BaseMemAllocator_Commit(IMemAllocator * iface)
             hr = S_OK;
         else
         {
-            if (!(This->hSemWaiting = CreateSemaphoreW(NULL, This->props.cBuffers, This->props.cBuffers, NULL)))
-            {
-                ERR("Couldn't create semaphore (error was %u)\n", GetLastError());
-                hr = HRESULT_FROM_WIN32(GetLastError());
-            }
+            hr = This->fnAlloc(iface);
+            if (SUCCEEDED(hr))
+                This->bCommitted = TRUE;
             else
-            {
-                hr = This->fnAlloc(iface);
-                if (SUCCEEDED(hr))
-                    This->bCommitted = TRUE;
-                else
-                    ERR("fnAlloc failed with error 0x%x\n", hr);
-            }
+                ERR("fnAlloc failed with error 0x%x\n", hr);
         }
     }
+    ReleaseSRWLockExclusive(&This->state_lock);
     LeaveCriticalSection(This->pCritSect);
 
     return hr;
@@ -261,17 +265,18 @@ static HRESULT WINAPI BaseMemAllocator_Decommit(IMemAllocator * iface)
     TRACE("(%p)->()\n", This);
 
     EnterCriticalSection(This->pCritSect);
+    AcquireSRWLockExclusive(&This->state_lock);
     {
         if (!This->bCommitted)
             hr = S_OK;
         else
         {
-            if (!list_empty(&This->used_list))
+            if (This->lOutstanding)
             {
                 This->bDecommitQueued = TRUE;
                 /* notify ALL waiting threads that they cannot be allocated a buffer any more */
-                ReleaseSemaphore(This->hSemWaiting, This->lWaiting, NULL);
-                
+                WakeAllConditionVariable(&This->free_cond);
+
                 hr = S_OK;
             }
             else
@@ -280,8 +285,6 @@ static HRESULT WINAPI BaseMemAllocator_Decommit(IMemAllocator * iface)
                     ERR("Waiting: %d\n", This->lWaiting);
 
                 This->bCommitted = FALSE;
-                CloseHandle(This->hSemWaiting);
-                This->hSemWaiting = NULL;
 
                 hr = This->fnFree(iface);
                 if (FAILED(hr))
@@ -289,6 +292,7 @@ static HRESULT WINAPI BaseMemAllocator_Decommit(IMemAllocator * iface)
             }
         }
     }
+    ReleaseSRWLockExclusive(&This->state_lock);
     LeaveCriticalSection(This->pCritSect);
 
     return hr;
@@ -297,6 +301,7 @@ static HRESULT WINAPI BaseMemAllocator_Decommit(IMemAllocator * iface)
 static HRESULT WINAPI BaseMemAllocator_GetBuffer(IMemAllocator * iface, IMediaSample ** pSample, REFERENCE_TIME *pStartTime, REFERENCE_TIME *pEndTime, DWORD dwFlags)
 {
     BaseMemAllocator *This = impl_from_IMemAllocator(iface);
+    SLIST_ENTRY *entry = NULL;
     HRESULT hr = S_OK;
 
     /* NOTE: The pStartTime and pEndTime parameters are not applied to the sample. 
@@ -306,48 +311,62 @@ static HRESULT WINAPI BaseMemAllocator_GetBuffer(IMemAllocator * iface, IMediaSa
 
     *pSample = NULL;
 
-    EnterCriticalSection(This->pCritSect);
+    /* fast path: take a free sample without touching the critical section */
+    AcquireSRWLockShared(&This->state_lock);
     if (!This->bCommitted || This->bDecommitQueued)
-    {
-        WARN("Not committed\n");
         hr = VFW_E_NOT_COMMITTED;
-    }
-    else
-        ++This->lWaiting;
-    LeaveCriticalSection(This->pCritSect);
-    if (FAILED(hr))
-        return hr;
+    else if ((entry = InterlockedPopEntrySList(&This->free_list)))
+        InterlockedIncrement(&This->lOutstanding);
+    ReleaseSRWLockShared(&This->state_lock);
 
-    if (WaitForSingleObject(This->hSemWaiting, (dwFlags & AM_GBF_NOWAIT) ? 0 : INFINITE) != WAIT_OBJECT_0)
+    if (FAILED(hr))
     {
-        EnterCriticalSection(This->pCritSect);
-        --This->lWaiting;
-        LeaveCriticalSection(This->pCritSect);
-        WARN("Timed out\n");
-        return VFW_E_TIMEOUT;
+        WARN("Not committed\n");
+        return hr;
     }
 
-    EnterCriticalSection(This->pCritSect);
+    if (!entry)
     {
-        --This->lWaiting;
-        if (!This->bCommitted)
+        if (dwFlags & AM_GBF_NOWAIT)
+        {
+            WARN("Timed out\n");
+            return VFW_E_TIMEOUT;
+        }
+
+        EnterCriticalSection(This->pCritSect);
+        InterlockedIncrement(&This->lWaiting);
+        if (!This->bCommitted || This->bDecommitQueued)
             hr = VFW_E_NOT_COMMITTED;
-        else if (This->bDecommitQueued)
-            hr = VFW_E_TIMEOUT;
         else
         {
-            StdMediaSample2 *ms;
-            struct list * free = list_head(&This->free_list);
-            list_remove(free);
-            list_add_head(&This->used_list, free);
-
-            ms = LIST_ENTRY(free, StdMediaSample2, listentry);
-            assert(ms->ref == 0);
-            *pSample = (IMediaSample *)&ms->IMediaSample2_iface;
-            IMediaSample_AddRef(*pSample);
+            while (!(entry = InterlockedPopEntrySList(&This->free_list)))
+            {
+                SleepConditionVariableCS(&This->free_cond, This->pCritSect, INFINITE);
+                if (!This->bCommitted)
+                {
+                    hr = VFW_E_NOT_COMMITTED;
+                    break;
+                }
+                if (This->bDecommitQueued)
+                {
+                    hr = VFW_E_TIMEOUT;
+                    break;
+                }
+            }
+            if (entry)
+                InterlockedIncrement(&This->lOutstanding);
         }
+        InterlockedDecrement(&This->lWaiting);
+        LeaveCriticalSection(This->pCritSect);
+    }
+
+    if (entry)
+    {
+        StdMediaSample2 *ms = CONTAINING_RECORD(entry, StdMediaSample2, freeentry);
+        assert(ms->ref == 0);
+        *pSample = (IMediaSample *)&ms->IMediaSample2_iface;
+        IMediaSample_AddRef(*pSample);
     }
-    LeaveCriticalSection(This->pCritSect);
 
     if (hr != S_OK)
         WARN("%08x\n", hr);
@@ -358,25 +377,29 @@ static HRESULT WINAPI BaseMemAllocator_ReleaseBuffer(IMemAllocator * iface, IMed
 {
     BaseMemAllocator *This = impl_from_IMemAllocator(iface);
     StdMediaSample2 * pStdSample = unsafe_impl_from_IMediaSample(pSample);
-    HRESULT hr = S_OK;
 
     TRACE("(%p)->(%p)\n", This, pSample);
 
-    /* FIXME: make sure that sample is currently on the used list */
-
     /* FIXME: we should probably check the ref count on the sample before freeing
      * it to make sure that it is not still in use */
-    EnterCriticalSection(This->pCritSect);
-    {
-        if (!This->bCommitted)
-            ERR("Releasing a buffer when the allocator is not committed?!?\n");
+    if (!This->bCommitted)
+        ERR("Releasing a buffer when the allocator is not committed?!?\n");
 
-		/* remove from used_list */
-        list_remove(&pStdSample->listentry);
+    InterlockedPushEntrySList(&This->free_list, &pStdSample->freeentry);
 
-        list_add_head(&This->free_list, &pStdSample->listentry);
+    /* notify a waiting thread that there is now a free buffer */
+    if (This->lWaiting)
+    {
+        EnterCriticalSection(This->pCritSect);
+        WakeConditionVariable(&This->free_cond);
+        LeaveCriticalSection(This->pCritSect);
+    }
 
-        if (list_empty(&This->used_list) && This->bDecommitQueued && This->bCommitted)
+    if (!InterlockedDecrement(&This->lOutstanding))
+    {
+        EnterCriticalSection(This->pCritSect);
+        AcquireSRWLockExclusive(&This->state_lock);
+        if (!This->lOutstanding && This->bDecommitQueued && This->bCommitted)
         {
             HRESULT hrfree;
 
@@ -386,23 +409,14 @@ static HRESULT WINAPI BaseMemAllocator_ReleaseBuffer(IMemAllocator * iface, IMed
             This->bCommitted = FALSE;
             This->bDecommitQueued = FALSE;
 
-            CloseHandle(This->hSemWaiting);
-            This->hSemWaiting = NULL;
-            
             if (FAILED(hrfree = This->fnFree(iface)))
                 ERR("fnFree failed with error 0x%x\n", hrfree);
         }
-    }
-    LeaveCriticalSection(This->pCritSect);
-
-    /* notify a waiting thread that there is now a free buffer */
-    if (This->hSemWaiting && !ReleaseSemaphore(This->hSemWaiting, 1, NULL))
-    {
-        ERR("ReleaseSemaphore failed with error %u\n", GetLastError());
-        hr = HRESULT_FROM_WIN32(GetLastError());
+        ReleaseSRWLockExclusive(&This->state_lock);
+        LeaveCriticalSection(This->pCritSect);
     }
 
-    return hr;
+    return S_OK;
 }
 
 static const IMemAllocatorVtbl BaseMemAllocator_VTable = 
@@ -814,14 +828,17 @@ static inline StdMemAllocator *StdMemAllocator_from_IMemAllocator(IMemAllocator
     return CONTAINING_RECORD(iface, StdMemAllocator, base.IMemAllocator_iface);
 }
 
+static HRESULT StdMemAllocator_Free(IMemAllocator * iface);
+
 static HRESULT StdMemAllocator_Alloc(IMemAllocator * iface)
 {
     StdMemAllocator *This = StdMemAllocator_from_IMemAllocator(iface);
     StdMediaSample2 * pSample = NULL;
     SYSTEM_INFO si;
+    LONG align, prefix, stride;
     LONG i;
 
-    assert(list_empty(&This->base.free_list));
+    assert(list_empty(&This->base.sample_list));
 
     /* check alignment */
     GetSystemInfo(&si);
@@ -830,23 +847,31 @@ static HRESULT StdMemAllocator_Alloc(IMemAllocator * iface)
     if ((si.dwPageSize % This->base.props.cbAlign) != 0)
         return VFW_E_BADALIGN;
 
-    /* FIXME: each sample has to have its buffer start on the right alignment.
-     * We don't do this at the moment */
+    /* Every sample buffer starts on an aligned address; the prefix is placed
+     * right in front of it and each sample is padded to the alignment. */
+    align = max(This->base.props.cbAlign, SAMPLE_ALIGN);
+    prefix = (This->base.props.cbPrefix + align - 1) & ~(align - 1);
+    stride = (prefix + This->base.props.cbBuffer + align - 1) & ~(align - 1);
 
     /* allocate memory */
-    This->pMemory = VirtualAlloc(NULL, (This->base.props.cbBuffer + This->base.props.cbPrefix) * This->base.props.cBuffers, MEM_COMMIT, PAGE_READWRITE);
+    This->pMemory = VirtualAlloc(NULL, stride * This->base.props.cBuffers, MEM_COMMIT, PAGE_READWRITE);
 
     if (!This->pMemory)
         return E_OUTOFMEMORY;
 
     for (i = This->base.props.cBuffers - 1; i >= 0; i--)
     {
-        /* pbBuffer does not start at the base address, it starts at base + cbPrefix */
-        BYTE * pbBuffer = (BYTE *)This->pMemory + i * (This->base.props.cbBuffer + This->base.props.cbPrefix) + This->base.props.cbPrefix;
-        
-        StdMediaSample2_Construct(pbBuffer, This->base.props.cbBuffer, iface, &pSample);
+        /* pbBuffer does not start at the base address, it starts at base + prefix */
+        BYTE * pbBuffer = (BYTE *)This->pMemory + i * stride + prefix;
+
+        if (FAILED(StdMediaSample2_Construct(pbBuffer, This->base.props.cbBuffer, iface, &pSample)))
+        {
+            StdMemAllocator_Free(iface);
+            return E_OUTOFMEMORY;
+        }
 
-        list_add_head(&This->base.free_list, &pSample->listentry);
+        list_add_head(&This->base.sample_list, &pSample->listentry);
+        InterlockedPushEntrySList(&This->base.free_list, &pSample->freeentry);
     }
 
     return S_OK;
@@ -857,30 +882,29 @@ static HRESULT StdMemAllocator_Free(IMemAllocator * iface)
     StdMemAllocator *This = StdMemAllocator_from_IMemAllocator(iface);
     struct list * cursor;
 
-    if (!list_empty(&This->base.used_list))
+    InterlockedFlushSList(&This->base.free_list);
+
+    while ((cursor = list_head(&This->base.sample_list)) != NULL)
     {
-        WARN("Freeing allocator with outstanding samples!\n");
-        while ((cursor = list_head(&This->base.used_list)) != NULL)
+        StdMediaSample2 *pSample = LIST_ENTRY(cursor, StdMediaSample2, listentry);
+
+        list_remove(cursor);
+        if (pSample->ref)
         {
-            StdMediaSample2 *pSample;
-            list_remove(cursor);
-            pSample = LIST_ENTRY(cursor, StdMediaSample2, listentry);
+            WARN("Freeing allocator with outstanding sample %p!\n", pSample);
             pSample->pParent = NULL;
         }
+        else
+            StdMediaSample2_Delete(pSample);
     }
 
-    while ((cursor = list_head(&This->base.free_list)) != NULL)
-    {
-        list_remove(cursor);
-        StdMediaSample2_Delete(LIST_ENTRY(cursor, StdMediaSample2, listentry));
-    }
-    
     /* free memory */
     if (!VirtualFree(This->pMemory, 0, MEM_RELEASE))
     {
         ERR("Couldn't free memory. Error: %u\n", GetLastError());
         return HRESULT_FROM_WIN32(GetLastError());
     }
+    This->pMemory = NULL;
 
     return S_OK;
 }
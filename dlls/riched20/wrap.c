@@ -849,6 +849,44 @@ end:
 }
 
 
+/* Long runs are split at word boundaries before shaping, so that breaking
+ * a line only needs to reshape one chunk instead of the rest of the paragraph. */
+#define MAX_SHAPE_RUN_LEN 256
+
+static void split_long_runs( ME_Context *c, ME_DisplayItem *p )
+{
+    ME_DisplayItem *di;
+    ME_Run *run;
+    const WCHAR *text;
+    int i;
+
+    for (di = p->next; di != p->member.para.next_para; di = di->next)
+    {
+        if (di->type != diRun) continue;
+        run = &di->member.run;
+
+        if (run->nFlags & (MERF_NONTEXT | MERF_ENDPARA)) continue;
+        if (run->len <= MAX_SHAPE_RUN_LEN) continue;
+
+        /* split at the last word start within the limit, or at the first one after it */
+        text = get_text( run, 0 );
+        for (i = MAX_SHAPE_RUN_LEN; i > 0; i--)
+            if (ME_IsWSpace( text[i - 1] ) && !ME_IsWSpace( text[i] )) break;
+        if (!i)
+        {
+            for (i = MAX_SHAPE_RUN_LEN + 1; i < run->len; i++)
+                if (ME_IsWSpace( text[i - 1] ) && !ME_IsWSpace( text[i] )) break;
+            if (i == run->len) continue;
+        }
+
+        {
+            ME_Cursor cursor = {p, di, i};
+            ME_SplitRunSimple( c->editor, &cursor );
+            cursor.pRun->member.run.script_analysis = run->script_analysis;
+        }
+    }
+}
+
 static HRESULT shape_para( ME_Context *c, ME_DisplayItem *p )
 {
     ME_DisplayItem *di;
@@ -891,7 +929,10 @@ static void ME_WrapTextParagraph(ME_Context *c, ME_DisplayItem *tp) {
       ScriptIsComplex( tp->member.para.text->szData, tp->member.para.text->nLen, SIC_COMPLEX ) == S_OK */)
   {
       if (SUCCEEDED( itemize_para( c, tp ) ))
+      {
+          split_long_runs( c, tp );
           shape_para( c, tp );
+      }
   }
 
   pFmt = &tp->member.para.fmt;
@@ -2811,6 +2811,47 @@ static ULONG EmbeddedComplexMemorySize(PMIDL_STUB_MESSAGE pStubMsg,
 }
 
 
+/* Padding in complex structures is described explicitly in the format string,
+ * so a run of base types whose wire representation matches their memory
+ * representation is contiguous both in memory and in the buffer and can be
+ * transferred in one go. Returns the size of the run at pFormat and stores
+ * the number of format characters it covers in count. */
+static ULONG ComplexCopyRun(PFORMAT_STRING pFormat, unsigned int *count)
+{
+  PFORMAT_STRING start = pFormat;
+  ULONG size = 0;
+
+  for (;; pFormat++) {
+    switch (*pFormat) {
+    case RPC_FC_BYTE:
+    case RPC_FC_CHAR:
+    case RPC_FC_SMALL:
+    case RPC_FC_USMALL:
+      size += 1;
+      continue;
+    case RPC_FC_WCHAR:
+    case RPC_FC_SHORT:
+    case RPC_FC_USHORT:
+      size += 2;
+      continue;
+    case RPC_FC_LONG:
+    case RPC_FC_ULONG:
+    case RPC_FC_ENUM32:
+    case RPC_FC_FLOAT:
+      size += 4;
+      continue;
+    case RPC_FC_HYPER:
+    case RPC_FC_DOUBLE:
+      size += 8;
+      continue;
+    }
+    break;
+  }
+
+  *count = pFormat - start;
+  return size;
+}
+
 static unsigned char * ComplexMarshall(PMIDL_STUB_MESSAGE pStubMsg,
                                        unsigned char *pMemory,
                                        PFORMAT_STRING pFormat,
@@ -2818,9 +2859,19 @@ static unsigned char * ComplexMarshall(PMIDL_STUB_MESSAGE pStubMsg,
 {
   PFORMAT_STRING desc;
   NDR_MARSHALL m;
+  unsigned int count;
   ULONG size;
 
   while (*pFormat != RPC_FC_END) {
+    size = ComplexCopyRun(pFormat, &count);
+    if (count > 1) {
+      TRACE("%u base types (size=%d) <= %p\n", count, size, pMemory);
+      safe_copy_to_buffer(pStubMsg, pMemory, size);
+      pMemory += size;
+      pFormat += count;
+      continue;
+    }
+
     switch (*pFormat) {
     case RPC_FC_BYTE:
     case RPC_FC_CHAR:
@@ -2977,9 +3028,19 @@ static unsigned char * ComplexUnmarshall(PMIDL_STUB_MESSAGE pStubMsg,
 {
   PFORMAT_STRING desc;
   NDR_UNMARSHALL m;
+  unsigned int count;
   ULONG size;
 
   while (*pFormat != RPC_FC_END) {
+    size = ComplexCopyRun(pFormat, &count);
+    if (count > 1) {
+      safe_copy_from_buffer(pStubMsg, pMemory, size);
+      TRACE("%u base types (size=%d) => %p\n", count, size, pMemory);
+      pMemory += size;
+      pFormat += count;
+      continue;
+    }
+
     switch (*pFormat) {
     case RPC_FC_BYTE:
     case RPC_FC_CHAR:
@@ -3152,9 +3213,18 @@ static unsigned char * ComplexBufferSize(PMIDL_STUB_MESSAGE pStubMsg,
 {
   PFORMAT_STRING desc;
   NDR_BUFFERSIZE m;
+  unsigned int count;
   ULONG size;
 
   while (*pFormat != RPC_FC_END) {
+    size = ComplexCopyRun(pFormat, &count);
+    if (count > 1) {
+      safe_buffer_length_increment(pStubMsg, size);
+      pMemory += size;
+      pFormat += count;
+      continue;
+    }
+
     switch (*pFormat) {
     case RPC_FC_BYTE:
     case RPC_FC_CHAR:
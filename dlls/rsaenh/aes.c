@@ -28,6 +28,11 @@
  * original version.
  */
 
+#include "config.h"
+
+#include <stdarg.h>
+
+#include "windef.h"
 #include "tomcrypt.h"
 
 static const ulong32 TE0[256] = {
@@ -934,6 +939,57 @@ static ulong32 setup_mix(ulong32 temp)
           (Te4_0[byte(temp, 3)]);
 }
 
+#ifdef __x86_64__
+
+extern void CDECL aes_ni_encrypt_block( const unsigned char *in, unsigned char *out,
+                                        const unsigned char *keys, int rounds );
+__ASM_GLOBAL_FUNC( aes_ni_encrypt_block,
+                   "movdqu (%rcx),%xmm0\n\t"
+                   "movdqu (%r8),%xmm1\n\t"
+                   "pxor %xmm1,%xmm0\n\t"
+                   "decl %r9d\n"
+                   "1:\taddq $16,%r8\n\t"
+                   "movdqu (%r8),%xmm1\n\t"
+                   "aesenc %xmm1,%xmm0\n\t"
+                   "decl %r9d\n\t"
+                   "jnz 1b\n\t"
+                   "movdqu 16(%r8),%xmm1\n\t"
+                   "aesenclast %xmm1,%xmm0\n\t"
+                   "movdqu %xmm0,(%rdx)\n\t"
+                   "ret" )
+
+extern void CDECL aes_ni_decrypt_block( const unsigned char *in, unsigned char *out,
+                                        const unsigned char *keys, int rounds );
+__ASM_GLOBAL_FUNC( aes_ni_decrypt_block,
+                   "movdqu (%rcx),%xmm0\n\t"
+                   "movdqu (%r8),%xmm1\n\t"
+                   "pxor %xmm1,%xmm0\n\t"
+                   "decl %r9d\n"
+                   "1:\taddq $16,%r8\n\t"
+                   "movdqu (%r8),%xmm1\n\t"
+                   "aesdec %xmm1,%xmm0\n\t"
+                   "decl %r9d\n\t"
+                   "jnz 1b\n\t"
+                   "movdqu 16(%r8),%xmm1\n\t"
+                   "aesdeclast %xmm1,%xmm0\n\t"
+                   "movdqu %xmm0,(%rdx)\n\t"
+                   "ret" )
+
+static int have_aes_ni(void)
+{
+    static int supported = -1;
+    unsigned int eax, ebx, ecx, edx;
+
+    if (supported == -1)
+    {
+        __asm__( "cpuid" : "=a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx) : "a" (1), "c" (0) );
+        supported = (ecx >> 25) & 1;
+    }
+    return supported;
+}
+
+#endif  /* __x86_64__ */
+
 int aes_setup(const unsigned char *key, int keylen, int rounds, aes_key *skey)
 {
     int i, j;
@@ -1058,6 +1114,18 @@ int aes_setup(const unsigned char *key, int keylen, int rounds, aes_key *skey)
     *rk++ = *rrk++;
     *rk   = *rrk;
 
+    /* the AES instructions take the round keys in byte order */
+    skey->ni = 0;
+#ifdef __x86_64__
+    if (have_aes_ni()) {
+        for (i = 0; i < 4 * (skey->Nr + 1); i++) {
+            STORE32H(skey->eK[i], skey->ni_eK + 4 * i);
+            STORE32H(skey->dK[i], skey->ni_dK + 4 * i);
+        }
+        skey->ni = 1;
+    }
+#endif
+
     return CRYPT_OK;
 }
 
@@ -1066,6 +1134,13 @@ void aes_ecb_encrypt(const unsigned char *pt, unsigned char *ct, aes_key *skey)
     ulong32 s0, s1, s2, s3, t0, t1, t2, t3, *rk;
     int Nr, r;
 
+#ifdef __x86_64__
+    if (skey->ni) {
+        aes_ni_encrypt_block(pt, ct, skey->ni_eK, skey->Nr);
+        return;
+    }
+#endif
+
     Nr = skey->Nr;
     rk = skey->eK;
 
@@ -1167,6 +1242,13 @@ void aes_ecb_decrypt(const unsigned char *ct, unsigned char *pt, aes_key *skey)
     ulong32 s0, s1, s2, s3, t0, t1, t2, t3, *rk;
     int Nr, r;
 
+#ifdef __x86_64__
+    if (skey->ni) {
+        aes_ni_decrypt_block(ct, pt, skey->ni_dK, skey->Nr);
+        return;
+    }
+#endif
+
     Nr = skey->Nr;
     rk = skey->dK;
 
@@ -30,11 +30,13 @@
 
 #include "windef.h"
 #include "winbase.h"
+#include "winreg.h"
 #include "sspi.h"
 #include "schannel.h"
 #include "secur32_priv.h"
 #include "wine/debug.h"
 #include "wine/library.h"
+#include "wine/list.h"
 
 #if defined(SONAME_LIBGNUTLS) && !defined(HAVE_SECURITY_SECURITY_H)
 
@@ -71,6 +73,11 @@ MAKE_FUNCPTR(gnutls_record_get_max_size);
 MAKE_FUNCPTR(gnutls_record_recv);
 MAKE_FUNCPTR(gnutls_record_send);
 MAKE_FUNCPTR(gnutls_server_name_set);
+MAKE_FUNCPTR(gnutls_session_get_data);
+MAKE_FUNCPTR(gnutls_session_get_ptr);
+MAKE_FUNCPTR(gnutls_session_is_resumed);
+MAKE_FUNCPTR(gnutls_session_set_data);
+MAKE_FUNCPTR(gnutls_session_set_ptr);
 MAKE_FUNCPTR(gnutls_transport_get_ptr);
 MAKE_FUNCPTR(gnutls_transport_set_errno);
 MAKE_FUNCPTR(gnutls_transport_set_ptr);
@@ -146,6 +153,166 @@ static ssize_t schan_push_adapter(gnutls_transport_ptr_t transport,
     return buff_len;
 }
 
+/* Client session resumption cache, shared by all the contexts of the process.
+ * Entries are keyed by target name and credentials handle, the most recently
+ * used ones are at the head of the list. */
+struct session_cache_entry
+{
+    struct list         entry;
+    schan_credentials  *cred;
+    char               *target;
+    void               *data;     /* gnutls session data */
+    size_t              size;
+    ULONGLONG           expires;
+};
+
+/* per-session data, attached with gnutls_session_set_ptr */
+struct session_info
+{
+    schan_credentials  *cred;
+    char               *target;
+};
+
+static struct list session_cache = LIST_INIT( session_cache );
+static unsigned int session_cache_count;
+static DWORD session_cache_time = 10 * 60 * 60 * 1000;  /* ClientCacheTime, in ms */
+static DWORD session_cache_max = 20000;                 /* MaximumCacheSize */
+
+static CRITICAL_SECTION session_cache_cs;
+static CRITICAL_SECTION_DEBUG session_cache_cs_debug =
+{
+    0, 0, &session_cache_cs,
+    { &session_cache_cs_debug.ProcessLocksList, &session_cache_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": session_cache_cs") }
+};
+static CRITICAL_SECTION session_cache_cs = { &session_cache_cs_debug, -1, 0, 0, 0, 0 };
+
+static void load_session_cache_settings(void)
+{
+    static const WCHAR schannelW[] =
+        {'S','y','s','t','e','m','\\','C','u','r','r','e','n','t','C','o','n','t','r','o','l','S','e','t','\\',
+         'C','o','n','t','r','o','l','\\','S','e','c','u','r','i','t','y','P','r','o','v','i','d','e','r','s','\\',
+         'S','C','H','A','N','N','E','L',0};
+    static const WCHAR cache_timeW[] = {'C','l','i','e','n','t','C','a','c','h','e','T','i','m','e',0};
+    static const WCHAR cache_sizeW[] = {'M','a','x','i','m','u','m','C','a','c','h','e','S','i','z','e',0};
+    DWORD type, size, value;
+    HKEY key;
+
+    if (RegOpenKeyExW( HKEY_LOCAL_MACHINE, schannelW, 0, KEY_READ, &key )) return;
+
+    size = sizeof(value);
+    if (!RegQueryValueExW( key, cache_timeW, NULL, &type, (BYTE *)&value, &size ) && type == REG_DWORD)
+        session_cache_time = value;
+    size = sizeof(value);
+    if (!RegQueryValueExW( key, cache_sizeW, NULL, &type, (BYTE *)&value, &size ) && type == REG_DWORD)
+        session_cache_max = value;
+    RegCloseKey( key );
+
+    TRACE( "cache time %u, max size %u\n", session_cache_time, session_cache_max );
+}
+
+static void free_session_cache_entry( struct session_cache_entry *entry )
+{
+    list_remove( &entry->entry );
+    session_cache_count--;
+    heap_free( entry->target );
+    heap_free( entry->data );
+    heap_free( entry );
+}
+
+/* find the entry for a target, the cache section must be held */
+static struct session_cache_entry *find_session_cache_entry( schan_credentials *cred, const char *target )
+{
+    struct session_cache_entry *entry, *next;
+    ULONGLONG now = GetTickCount64();
+
+    LIST_FOR_EACH_ENTRY_SAFE( entry, next, &session_cache, struct session_cache_entry, entry )
+    {
+        if (entry->expires < now)
+        {
+            free_session_cache_entry( entry );
+            continue;
+        }
+        if (entry->cred == cred && !strcmp( entry->target, target )) return entry;
+    }
+    return NULL;
+}
+
+/* restore the session data saved by a previous connection to the same target */
+static void resume_cached_session( gnutls_session_t s, struct session_info *info )
+{
+    struct session_cache_entry *entry;
+    int err;
+
+    EnterCriticalSection( &session_cache_cs );
+    if ((entry = find_session_cache_entry( info->cred, info->target )))
+    {
+        TRACE( "resuming session for %s\n", debugstr_a(info->target) );
+        if ((err = pgnutls_session_set_data( s, entry->data, entry->size )) != GNUTLS_E_SUCCESS)
+            pgnutls_perror( err );
+        list_remove( &entry->entry );
+        list_add_head( &session_cache, &entry->entry );
+    }
+    LeaveCriticalSection( &session_cache_cs );
+}
+
+/* store the data of a completed handshake, so that the next connection can resume it */
+static void save_cached_session( gnutls_session_t s, struct session_info *info )
+{
+    struct session_cache_entry *entry;
+    size_t size = 0;
+    void *data;
+
+    if (pgnutls_session_get_data( s, NULL, &size ) != GNUTLS_E_SUCCESS || !size) return;
+    if (!(data = heap_alloc( size ))) return;
+    if (pgnutls_session_get_data( s, data, &size ) != GNUTLS_E_SUCCESS)
+    {
+        heap_free( data );
+        return;
+    }
+
+    EnterCriticalSection( &session_cache_cs );
+    if (!(entry = find_session_cache_entry( info->cred, info->target )))
+    {
+        while (session_cache_count && session_cache_count >= session_cache_max)
+            free_session_cache_entry( LIST_ENTRY( list_tail( &session_cache ), struct session_cache_entry, entry ));
+        if ((entry = heap_alloc_zero( sizeof(*entry) )) && (entry->target = heap_alloc( strlen(info->target) + 1 )))
+        {
+            strcpy( entry->target, info->target );
+            entry->cred = info->cred;
+            session_cache_count++;
+        }
+        else
+        {
+            heap_free( entry );
+            entry = NULL;
+        }
+    }
+    else list_remove( &entry->entry );
+
+    if (entry)
+    {
+        heap_free( entry->data );
+        entry->data    = data;
+        entry->size    = size;
+        entry->expires = GetTickCount64() + session_cache_time;
+        list_add_head( &session_cache, &entry->entry );
+    }
+    else heap_free( data );
+    LeaveCriticalSection( &session_cache_cs );
+}
+
+/* drop the cached sessions of a credentials handle, or all of them if cred is NULL */
+static void purge_session_cache( schan_credentials *cred )
+{
+    struct session_cache_entry *entry, *next;
+
+    EnterCriticalSection( &session_cache_cs );
+    LIST_FOR_EACH_ENTRY_SAFE( entry, next, &session_cache, struct session_cache_entry, entry )
+        if (!cred || entry->cred == cred) free_session_cache_entry( entry );
+    LeaveCriticalSection( &session_cache_cs );
+}
+
 static const struct {
     DWORD enable_flag;
     const char *gnutls_flag;
@@ -167,6 +334,7 @@ BOOL schan_imp_create_session(schan_imp_session *session, schan_credentials *cre
 {
     gnutls_session_t *s = (gnutls_session_t*)session;
     char priority[128] = "NORMAL:%LATEST_RECORD_VERSION", *p;
+    struct session_info *info;
     unsigned i;
 
     int err = pgnutls_init(s, cred->credential_use == SECPKG_CRED_INBOUND ? GNUTLS_SERVER : GNUTLS_CLIENT);
@@ -176,6 +344,14 @@ BOOL schan_imp_create_session(schan_imp_session *session, schan_credentials *cre
         return FALSE;
     }
 
+    if (!(info = heap_alloc_zero(sizeof(*info))))
+    {
+        pgnutls_deinit(*s);
+        return FALSE;
+    }
+    info->cred = cred;
+    pgnutls_session_set_ptr(*s, info);
+
     p = priority + strlen(priority);
     for(i=0; i < sizeof(protocol_priority_flags)/sizeof(*protocol_priority_flags); i++) {
         *p++ = ':';
@@ -190,6 +366,7 @@ BOOL schan_imp_create_session(schan_imp_session *session, schan_credentials *cre
     {
         pgnutls_perror(err);
         pgnutls_deinit(*s);
+        heap_free(info);
         return FALSE;
     }
 
@@ -199,6 +376,7 @@ BOOL schan_imp_create_session(schan_imp_session *session, schan_credentials *cre
     {
         pgnutls_perror(err);
         pgnutls_deinit(*s);
+        heap_free(info);
         return FALSE;
     }
 
@@ -211,7 +389,11 @@ BOOL schan_imp_create_session(schan_imp_session *session, schan_credentials *cre
 void schan_imp_dispose_session(schan_imp_session session)
 {
     gnutls_session_t s = (gnutls_session_t)session;
+    struct session_info *info = pgnutls_session_get_ptr(s);
+
     pgnutls_deinit(s);
+    heap_free(info->target);
+    heap_free(info);
 }
 
 void schan_imp_set_session_transport(schan_imp_session session,
@@ -224,8 +406,14 @@ void schan_imp_set_session_transport(schan_imp_session session,
 void schan_imp_set_session_target(schan_imp_session session, const char *target)
 {
     gnutls_session_t s = (gnutls_session_t)session;
+    struct session_info *info = pgnutls_session_get_ptr( s );
 
     pgnutls_server_name_set( s, GNUTLS_NAME_DNS, target, strlen(target) );
+
+    if (info->cred->credential_use != SECPKG_CRED_OUTBOUND || !session_cache_max) return;
+    if (!(info->target = heap_alloc( strlen(target) + 1 ))) return;
+    strcpy( info->target, target );
+    resume_cached_session( s, info );
 }
 
 SECURITY_STATUS schan_imp_handshake(schan_imp_session session)
@@ -237,8 +425,13 @@ SECURITY_STATUS schan_imp_handshake(schan_imp_session session)
         err = pgnutls_handshake(s);
         switch(err) {
         case GNUTLS_E_SUCCESS:
-            TRACE("Handshake completed\n");
+        {
+            struct session_info *info = pgnutls_session_get_ptr(s);
+
+            TRACE("Handshake completed%s\n", pgnutls_session_is_resumed(s) ? " (resumed)" : "");
+            if (info->target) save_cached_session(s, info);
             return SEC_E_OK;
+        }
 
         case GNUTLS_E_AGAIN:
             TRACE("Continue...\n");
@@ -515,6 +708,7 @@ BOOL schan_imp_allocate_certificate_credentials(schan_credentials *c)
 
 void schan_imp_free_certificate_credentials(schan_credentials *c)
 {
+    purge_session_cache(c);
     pgnutls_certificate_free_credentials(c->credentials);
 }
 
@@ -566,6 +760,11 @@ BOOL schan_imp_init(void)
     LOAD_FUNCPTR(gnutls_record_recv);
     LOAD_FUNCPTR(gnutls_record_send);
     LOAD_FUNCPTR(gnutls_server_name_set)
+    LOAD_FUNCPTR(gnutls_session_get_data)
+    LOAD_FUNCPTR(gnutls_session_get_ptr)
+    LOAD_FUNCPTR(gnutls_session_is_resumed)
+    LOAD_FUNCPTR(gnutls_session_set_data)
+    LOAD_FUNCPTR(gnutls_session_set_ptr)
     LOAD_FUNCPTR(gnutls_transport_get_ptr)
     LOAD_FUNCPTR(gnutls_transport_set_errno)
     LOAD_FUNCPTR(gnutls_transport_set_ptr)
@@ -592,6 +791,7 @@ BOOL schan_imp_init(void)
         pgnutls_global_set_log_function(schan_gnutls_log);
     }
 
+    load_session_cache_settings();
     return TRUE;
 
 fail:
@@ -602,6 +802,7 @@ fail:
 
 void schan_imp_deinit(void)
 {
+    purge_session_cache(NULL);
     pgnutls_global_deinit();
     wine_dlclose(libgnutls_handle, NULL, 0);
     libgnutls_handle = NULL;
@@ -189,9 +189,10 @@ failed:
     return FALSE;
 }
 
-/* read in the contents of a file into the global file buffer */
+/* read in the contents of a file into the given buffer, growing it as needed */
 /* return 1 on success, 0 on nonexistent file, -1 on other error */
-static int read_file( const char *name, void **data, SIZE_T *size )
+static int read_file_buffer( const char *name, void **data, SIZE_T *size,
+                             void **buffer, SIZE_T *buffer_size )
 {
     struct stat st;
     int fd, ret = -1;
@@ -204,12 +205,12 @@ static int read_file( const char *name, void **data, SIZE_T *size )
     if ((fd = open( name, O_RDONLY | O_BINARY )) == -1) return 0;
     if (fstat( fd, &st ) == -1) goto done;
     *size = st.st_size;
-    if (!file_buffer || st.st_size > file_buffer_size)
+    if (!*buffer || st.st_size > *buffer_size)
     {
-        VirtualFree( file_buffer, 0, MEM_RELEASE );
-        file_buffer = NULL;
-        file_buffer_size = st.st_size;
-        if (NtAllocateVirtualMemory( GetCurrentProcess(), &file_buffer, 0, &file_buffer_size,
+        if (*buffer) VirtualFree( *buffer, 0, MEM_RELEASE );
+        *buffer = NULL;
+        *buffer_size = st.st_size;
+        if (NtAllocateVirtualMemory( GetCurrentProcess(), buffer, 0, buffer_size,
                                      MEM_COMMIT, PAGE_READWRITE )) goto done;
     }
 
@@ -217,14 +218,14 @@ static int read_file( const char *name, void **data, SIZE_T *size )
 
     if (st.st_size < min_size) goto done;
     header_size = min( st.st_size, 4096 );
-    if (pread( fd, file_buffer, header_size, 0 ) != header_size) goto done;
-    dos = file_buffer;
+    if (pread( fd, *buffer, header_size, 0 ) != header_size) goto done;
+    dos = *buffer;
     if (dos->e_magic != IMAGE_DOS_SIGNATURE) goto done;
     if (dos->e_lfanew < sizeof(fakedll_signature)) goto done;
     if (memcmp( dos + 1, fakedll_signature, sizeof(fakedll_signature) )) goto done;
     if (dos->e_lfanew + FIELD_OFFSET(IMAGE_NT_HEADERS,OptionalHeader.MajorLinkerVersion) > header_size)
         goto done;
-    nt = (IMAGE_NT_HEADERS *)((char *)file_buffer + dos->e_lfanew);
+    nt = (IMAGE_NT_HEADERS *)((char *)*buffer + dos->e_lfanew);
     if (nt->Signature == IMAGE_NT_SIGNATURE && nt->OptionalHeader.Magic != IMAGE_NT_OPTIONAL_HDR_MAGIC)
     {
         /* wrong 32/64 type, pretend it doesn't exist */
@@ -232,10 +233,10 @@ static int read_file( const char *name, void **data, SIZE_T *size )
         goto done;
     }
     if (st.st_size == header_size ||
-        pread( fd, (char *)file_buffer + header_size,
+        pread( fd, (char *)*buffer + header_size,
                st.st_size - header_size, header_size ) == st.st_size - header_size)
     {
-        *data = file_buffer;
+        *data = *buffer;
         ret = 1;
     }
 done:
@@ -243,6 +244,12 @@ done:
     return ret;
 }
 
+/* read in the contents of a file into the global file buffer */
+static inline int read_file( const char *name, void **data, SIZE_T *size )
+{
+    return read_file_buffer( name, data, size, &file_buffer, &file_buffer_size );
+}
+
 /* build a complete fake dll from scratch */
 static BOOL build_fake_dll( HANDLE file, const WCHAR *name )
 {
@@ -841,48 +848,151 @@ static void register_fake_dll( const WCHAR *name, const void *data, size_t size
     if (FAILED(hr)) ERR( "failed to register %s: %x\n", debugstr_w(name), hr );
 }
 
-/* copy a fake dll file to the dest directory */
-static void install_fake_dll( WCHAR *dest, char *file, const char *ext )
+/* a fake dll found in a lib directory, installed in parallel with the others */
+struct fake_dll_job
 {
-    int ret;
-    SIZE_T size;
-    void *data;
-    DWORD written;
-    WCHAR *destname = dest + strlenW(dest);
-    char *name = strrchr( file, '/' ) + 1;
-    char *end = name + strlen(name);
+    char   *file;         /* unix name of the source file */
+    WCHAR  *dest;         /* destination file name */
+    WCHAR  *name;         /* dll name, pointing into dest */
+    void   *data;         /* contents of the source file */
+    SIZE_T  size;
+    void   *buffer;       /* buffer holding the contents */
+    SIZE_T  buffer_size;
+    int     status;       /* read_file status, 1 while the file still needs to be installed */
+};
+
+struct fake_dll_jobs
+{
+    struct fake_dll_job *jobs;
+    unsigned int         count;
+    unsigned int         total;
+    LONG                 next;    /* next job to run */
+    void               (*func)( struct fake_dll_job *job );
+};
+
+#define MAX_FAKE_DLL_THREADS 8
+
+/* queue a fake dll file to be copied to the dest directory */
+static void add_fake_dll_job( struct fake_dll_jobs *jobs, const WCHAR *dest, const char *file,
+                              const char *ext )
+{
+    struct fake_dll_job *job;
+    const char *name = strrchr( file, '/' ) + 1;
+    const char *end = name + strlen(name);
+    unsigned int len = strlenW( dest );
+
+    if (jobs->count >= jobs->total)
+    {
+        unsigned int new_total = max( 64, jobs->total * 2 );
+        struct fake_dll_job *new_jobs;
+
+        if (jobs->jobs) new_jobs = HeapReAlloc( GetProcessHeap(), 0, jobs->jobs, new_total * sizeof(*new_jobs) );
+        else new_jobs = HeapAlloc( GetProcessHeap(), 0, new_total * sizeof(*new_jobs) );
+        if (!new_jobs) return;
+        jobs->jobs = new_jobs;
+        jobs->total = new_total;
+    }
+    job = &jobs->jobs[jobs->count];
+    memset( job, 0, sizeof(*job) );
 
-    if (ext) strcpy( end, ext );
-    if (!(ret = read_file( file, &data, &size ))) return;
+    if (!(job->file = HeapAlloc( GetProcessHeap(), 0, strlen(file) + (ext ? strlen(ext) : 0) + 1 ))) return;
+    strcpy( job->file, file );
+    if (ext) strcat( job->file, ext );
 
     if (end > name + 2 && !strncmp( end - 2, "16", 2 )) end -= 2;  /* remove "16" suffix */
-    dll_name_AtoW( destname, name, end - name );
-    if (!add_handled_dll( destname )) ret = -1;
+    if (!(job->dest = HeapAlloc( GetProcessHeap(), 0, (len + (end - name) + 1) * sizeof(WCHAR) )))
+    {
+        HeapFree( GetProcessHeap(), 0, job->file );
+        return;
+    }
+    strcpyW( job->dest, dest );
+    job->name = job->dest + len;
+    dll_name_AtoW( job->name, name, end - name );
+    jobs->count++;
+}
+
+static void free_fake_dll_jobs( struct fake_dll_jobs *jobs )
+{
+    unsigned int i;
 
-    if (ret != -1)
+    for (i = 0; i < jobs->count; i++)
     {
-        HANDLE h = create_dest_file( dest );
+        HeapFree( GetProcessHeap(), 0, jobs->jobs[i].file );
+        HeapFree( GetProcessHeap(), 0, jobs->jobs[i].dest );
+        if (jobs->jobs[i].buffer) VirtualFree( jobs->jobs[i].buffer, 0, MEM_RELEASE );
+    }
+    HeapFree( GetProcessHeap(), 0, jobs->jobs );
+}
 
-        if (h && h != INVALID_HANDLE_VALUE)
-        {
-            TRACE( "%s -> %s\n", debugstr_a(file), debugstr_w(dest) );
+static void read_fake_dll_job( struct fake_dll_job *job )
+{
+    job->status = read_file_buffer( job->file, &job->data, &job->size, &job->buffer, &job->buffer_size );
+}
 
-            ret = (WriteFile( h, data, size, &written, NULL ) && written == size);
-            if (!ret) ERR( "failed to write to %s (error=%u)\n", debugstr_w(dest), GetLastError() );
-            CloseHandle( h );
-            if (ret) register_fake_dll( dest, data, size );
-            else DeleteFileW( dest );
-        }
+static void write_fake_dll_job( struct fake_dll_job *job )
+{
+    HANDLE h = create_dest_file( job->dest );
+    DWORD written;
+
+    if (!h || h == INVALID_HANDLE_VALUE)
+    {
+        job->status = 0;
+        return;
     }
-    *destname = 0;  /* restore it for next file */
+    TRACE( "%s -> %s\n", debugstr_a(job->file), debugstr_w(job->dest) );
+
+    if (!WriteFile( h, job->data, job->size, &written, NULL ) || written != job->size)
+    {
+        ERR( "failed to write to %s (error=%u)\n", debugstr_w(job->dest), GetLastError() );
+        job->status = 0;
+    }
+    CloseHandle( h );
+    if (!job->status) DeleteFileW( job->dest );
 }
 
-/* find and install all fake dlls in a given lib directory */
-static void install_lib_dir( WCHAR *dest, char *file, const char *default_ext )
+static DWORD WINAPI fake_dll_thread( void *arg )
+{
+    struct fake_dll_jobs *jobs = arg;
+    LONG i;
+
+    while ((i = InterlockedIncrement( &jobs->next ) - 1) < jobs->count)
+        if (jobs->jobs[i].status == 1) jobs->func( &jobs->jobs[i] );
+    return 0;
+}
+
+/* run a function on all the pending jobs, using several threads */
+static void run_fake_dll_jobs( struct fake_dll_jobs *jobs, void (*func)( struct fake_dll_job *job ) )
+{
+    HANDLE threads[MAX_FAKE_DLL_THREADS - 1];
+    SYSTEM_INFO info;
+    unsigned int i, count;
+
+    jobs->func = func;
+    jobs->next = 0;
+
+    GetSystemInfo( &info );
+    count = min( info.dwNumberOfProcessors, MAX_FAKE_DLL_THREADS );
+    for (i = 0; i + 1 < count; i++)
+        if (!(threads[i] = CreateThread( NULL, 0, fake_dll_thread, jobs, 0, NULL ))) break;
+    fake_dll_thread( jobs );  /* the current thread does its share too */
+
+    if (i) WaitForMultipleObjects( i, threads, TRUE, INFINITE );
+    while (i) CloseHandle( threads[--i] );
+}
+
+static int fake_dll_job_cmp( const void *a, const void *b )
+{
+    const struct fake_dll_job *job1 = a, *job2 = b;
+    return strcmp( job1->file, job2->file );
+}
+
+/* find all fake dlls in a given lib directory */
+static void install_lib_dir( struct fake_dll_jobs *jobs, WCHAR *dest, char *file, const char *default_ext )
 {
     DIR *dir;
     struct dirent *de;
     char *name;
+    unsigned int first = jobs->count;
 
     if (!(dir = opendir( file ))) return;
     name = file + strlen(file);
@@ -898,11 +1008,14 @@ static void install_lib_dir( WCHAR *dest, char *file, const char *default_ext )
             strcat( name, "/" );
             strcat( name, de->d_name );
             if (!strchr( de->d_name, '.' )) strcat( name, default_ext );
-            install_fake_dll( dest, file, ".fake" );
+            add_fake_dll_job( jobs, dest, file, ".fake" );
         }
-        else install_fake_dll( dest, file, NULL );
+        else add_fake_dll_job( jobs, dest, file, NULL );
     }
     closedir( dir );
+
+    /* don't depend on the directory order */
+    qsort( jobs->jobs + first, jobs->count - first, sizeof(*jobs->jobs), fake_dll_job_cmp );
 }
 
 /* create fake dlls in dirname for all the files we can find */
@@ -911,6 +1024,7 @@ static BOOL create_wildcard_dlls( const WCHAR *dirname )
     const char *build_dir = wine_get_build_dir();
     const char *path;
     unsigned int i, maxlen = 0;
+    struct fake_dll_jobs jobs;
     char *file;
     WCHAR *dest;
 
@@ -927,23 +1041,44 @@ static BOOL create_wildcard_dlls( const WCHAR *dirname )
     strcpyW( dest, dirname );
     dest[strlenW(dest) - 1] = 0;  /* remove wildcard */
 
+    memset( &jobs, 0, sizeof(jobs) );
     if (build_dir)
     {
         strcpy( file, build_dir );
         strcat( file, "/dlls" );
-        install_lib_dir( dest, file, ".dll" );
+        install_lib_dir( &jobs, dest, file, ".dll" );
         strcpy( file, build_dir );
         strcat( file, "/programs" );
-        install_lib_dir( dest, file, ".exe" );
+        install_lib_dir( &jobs, dest, file, ".exe" );
     }
     for (i = 0; (path = wine_dll_enum_load_path( i )); i++)
     {
         strcpy( file, path );
         strcat( file, "/fakedlls" );
-        install_lib_dir( dest, file, NULL );
+        install_lib_dir( &jobs, dest, file, NULL );
     }
     HeapFree( GetProcessHeap(), 0, file );
     HeapFree( GetProcessHeap(), 0, dest );
+
+    /* read all the files in parallel */
+    for (i = 0; i < jobs.count; i++) jobs.jobs[i].status = 1;
+    run_fake_dll_jobs( &jobs, read_fake_dll_job );
+
+    /* the first file found for a given dll wins */
+    for (i = 0; i < jobs.count; i++)
+    {
+        if (!jobs.jobs[i].status) continue;
+        if (!add_handled_dll( jobs.jobs[i].name ) || jobs.jobs[i].status != 1) jobs.jobs[i].status = 0;
+    }
+
+    run_fake_dll_jobs( &jobs, write_fake_dll_job );
+
+    /* register them in a fixed order to get a deterministic registry */
+    for (i = 0; i < jobs.count; i++)
+        if (jobs.jobs[i].status == 1)
+            register_fake_dll( jobs.jobs[i].dest, jobs.jobs[i].data, jobs.jobs[i].size );
+
+    free_fake_dll_jobs( &jobs );
     return TRUE;
 }
 
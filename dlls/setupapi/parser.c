@@ -39,6 +39,7 @@
 #include "setupapi_private.h"
 
 #include "wine/unicode.h"
+#include "wine/list.h"
 #include "wine/debug.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(setupapi);
@@ -86,6 +87,33 @@ struct inf_file
     WCHAR           *filename;        /* filename of the INF */
 };
 
+/* cache of parsed files, keyed by file identity and modification time */
+struct inf_cache_entry
+{
+    struct list      entry;
+    DWORD            volume;      /* volume serial number */
+    DWORD            index_high;  /* file index on the volume */
+    DWORD            index_low;
+    FILETIME         mtime;       /* last write time */
+    DWORD            size;        /* file size */
+    DWORD            crc;         /* checksum of the contents, to catch rewrites within the timestamp resolution */
+    struct inf_file *file;        /* parsed file, cloned for each open */
+};
+
+#define MAX_CACHED_FILES 8
+
+static struct list inf_cache = LIST_INIT( inf_cache );
+static unsigned int inf_cache_count;
+
+static CRITICAL_SECTION inf_cache_cs;
+static CRITICAL_SECTION_DEBUG inf_cache_cs_debug =
+{
+    0, 0, &inf_cache_cs,
+    { &inf_cache_cs_debug.ProcessLocksList, &inf_cache_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": inf_cache_cs") }
+};
+static CRITICAL_SECTION inf_cache_cs = { &inf_cache_cs_debug, -1, 0, 0, 0, 0 };
+
 /* parser definitions */
 
 enum parser_state
@@ -873,6 +901,111 @@ static void free_inf_file( struct inf_file *file )
 }
 
 
+/* duplicate the parsed contents of a file, without its filename and appended files */
+static struct inf_file *clone_inf_file( const struct inf_file *src )
+{
+    struct inf_file *file;
+    struct section *section;
+    unsigned int i, len = src->string_pos - src->strings;
+    size_t size;
+
+    if (!(file = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*file) ))) return NULL;
+    file->strings_section = src->strings_section;
+
+    if (!(file->strings = HeapAlloc( GetProcessHeap(), 0, len * sizeof(WCHAR) ))) goto failed;
+    memcpy( file->strings, src->strings, len * sizeof(WCHAR) );
+    file->string_pos = file->strings + len;
+
+    if (src->nb_fields)
+    {
+        if (!(file->fields = HeapAlloc( GetProcessHeap(), 0, src->nb_fields * sizeof(file->fields[0]) )))
+            goto failed;
+        for (i = 0; i < src->nb_fields; i++)
+            file->fields[i].text = file->strings + (src->fields[i].text - src->strings);
+        file->nb_fields = file->alloc_fields = src->nb_fields;
+    }
+
+    if (src->nb_sections)
+    {
+        if (!(file->sections = HeapAlloc( GetProcessHeap(), 0, src->nb_sections * sizeof(file->sections[0]) )))
+            goto failed;
+        file->alloc_sections = src->nb_sections;
+        for (i = 0; i < src->nb_sections; i++)
+        {
+            size = sizeof(*section) - sizeof(section->lines) +
+                   src->sections[i]->alloc_lines * sizeof(section->lines[0]);
+            if (!(section = HeapAlloc( GetProcessHeap(), 0, size ))) goto failed;
+            memcpy( section, src->sections[i], size );
+            section->name = file->strings + (src->sections[i]->name - src->strings);
+            file->sections[file->nb_sections++] = section;
+        }
+    }
+    return file;
+
+ failed:
+    free_inf_file( file );
+    return NULL;
+}
+
+
+/* retrieve a copy of a cached file matching the given file information */
+static struct inf_file *get_cached_inf_file( const BY_HANDLE_FILE_INFORMATION *info, DWORD size, DWORD crc )
+{
+    struct inf_cache_entry *cache;
+    struct inf_file *file = NULL;
+
+    EnterCriticalSection( &inf_cache_cs );
+    LIST_FOR_EACH_ENTRY( cache, &inf_cache, struct inf_cache_entry, entry )
+    {
+        if (cache->volume != info->dwVolumeSerialNumber) continue;
+        if (cache->index_high != info->nFileIndexHigh || cache->index_low != info->nFileIndexLow) continue;
+        if (CompareFileTime( &cache->mtime, &info->ftLastWriteTime )) continue;
+        if (cache->size != size || cache->crc != crc) continue;
+
+        /* move it to the front, the least recently used entry gets evicted first */
+        list_remove( &cache->entry );
+        list_add_head( &inf_cache, &cache->entry );
+        file = clone_inf_file( cache->file );
+        break;
+    }
+    LeaveCriticalSection( &inf_cache_cs );
+    return file;
+}
+
+
+/* store a copy of a newly parsed file in the cache */
+static void add_cached_inf_file( const BY_HANDLE_FILE_INFORMATION *info, DWORD size, DWORD crc,
+                                 const struct inf_file *file )
+{
+    struct inf_cache_entry *cache;
+
+    if (!(cache = HeapAlloc( GetProcessHeap(), 0, sizeof(*cache) ))) return;
+    if (!(cache->file = clone_inf_file( file )))
+    {
+        HeapFree( GetProcessHeap(), 0, cache );
+        return;
+    }
+    cache->volume     = info->dwVolumeSerialNumber;
+    cache->index_high = info->nFileIndexHigh;
+    cache->index_low  = info->nFileIndexLow;
+    cache->mtime      = info->ftLastWriteTime;
+    cache->size       = size;
+    cache->crc        = crc;
+
+    EnterCriticalSection( &inf_cache_cs );
+    list_add_head( &inf_cache, &cache->entry );
+    if (++inf_cache_count > MAX_CACHED_FILES)
+    {
+        struct inf_cache_entry *old = LIST_ENTRY( list_tail( &inf_cache ), struct inf_cache_entry, entry );
+        list_remove( &old->entry );
+        inf_cache_count--;
+        free_inf_file( old->file );
+        HeapFree( GetProcessHeap(), 0, old );
+    }
+    LeaveCriticalSection( &inf_cache_cs );
+}
+
+
 /* parse a complete buffer */
 static DWORD parse_buffer( struct inf_file *file, const WCHAR *buffer, const WCHAR *end,
                            UINT *error_line )
@@ -950,13 +1083,15 @@ static void append_inf_file( struct inf_file *parent, struct inf_file *child )
 /***********************************************************************
  *            parse_file
  *
- * parse an INF file.
+ * parse an INF file, or retrieve it from the cache if it was parsed already.
  */
 static struct inf_file *parse_file( HANDLE handle, const WCHAR *class, DWORD style, UINT *error_line )
 {
     void *buffer;
-    DWORD err = 0;
+    DWORD err = 0, crc;
     struct inf_file *file;
+    BY_HANDLE_FILE_INFORMATION info;
+    BOOL cacheable;
 
     DWORD size = GetFileSize( handle, NULL );
     HANDLE mapping = CreateFileMappingW( handle, NULL, PAGE_READONLY, 0, size, NULL );
@@ -967,6 +1102,14 @@ static struct inf_file *parse_file( HANDLE handle, const WCHAR *class, DWORD sty
 
     if (class) FIXME( "class %s not supported yet\n", debugstr_w(class) );
 
+    cacheable = GetFileInformationByHandle( handle, &info );
+    crc = cacheable ? RtlComputeCrc32( 0, buffer, size ) : 0;
+    if (cacheable && (file = get_cached_inf_file( &info, size, crc )))
+    {
+        TRACE( "using cached contents for %p\n", handle );
+        goto check_signature;
+    }
+
     if (!(file = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*file) )))
     {
         err = ERROR_NOT_ENOUGH_MEMORY;
@@ -1004,6 +1147,7 @@ static struct inf_file *parse_file( HANDLE handle, const WCHAR *class, DWORD sty
             err = parse_buffer( file, new_buff, new_buff + len, error_line );
             HeapFree( GetProcessHeap(), 0, new_buff );
         }
+        else err = ERROR_NOT_ENOUGH_MEMORY;
     }
     else
     {
@@ -1014,6 +1158,9 @@ static struct inf_file *parse_file( HANDLE handle, const WCHAR *class, DWORD sty
         err = parse_buffer( file, new_buff, (WCHAR *)((char *)buffer + size), error_line );
     }
 
+    if (!err && cacheable) add_cached_inf_file( &info, size, crc, file );
+
+ check_signature:
     if (!err)  /* now check signature */
     {
         int version_index = find_section( file, Version );
@@ -775,6 +775,34 @@ static void test_GLE(void)
     SetupCloseInfFile( hinf );
 }
 
+static void test_reopen(void)
+{
+    INFCONTEXT context;
+    HINF hinf, hinf2;
+    UINT err;
+    BOOL ret;
+
+    hinf = test_file_contents( STD_HEADER "[Test]\nkey=value1\n", &err );
+    ok( hinf != INVALID_HANDLE_VALUE, "open failed err %u\n", err );
+    hinf2 = SetupOpenInfFileA( tmpfilename, 0, INF_STYLE_WIN4, &err );
+    ok( hinf2 != INVALID_HANDLE_VALUE, "open failed err %u\n", err );
+    SetupCloseInfFile( hinf );
+
+    /* the second handle stays valid after the first one is closed */
+    ret = SetupFindFirstLineA( hinf2, "Test", "key", &context );
+    ok( ret, "key not found\n" );
+    ok( !strcmp( get_string_field( &context, 1 ), "value1" ), "wrong value %s\n", get_string_field( &context, 1 ) );
+    SetupCloseInfFile( hinf2 );
+
+    /* rewriting the file with contents of the same size is picked up */
+    hinf = test_file_contents( STD_HEADER "[Test]\nkey=value2\n", &err );
+    ok( hinf != INVALID_HANDLE_VALUE, "open failed err %u\n", err );
+    ret = SetupFindFirstLineA( hinf, "Test", "key", &context );
+    ok( ret, "key not found\n" );
+    ok( !strcmp( get_string_field( &context, 1 ), "value2" ), "wrong value %s\n", get_string_field( &context, 1 ) );
+    SetupCloseInfFile( hinf );
+}
+
 START_TEST(parser)
 {
     init_function_pointers();
@@ -786,5 +814,6 @@ START_TEST(parser)
     test_pSetupGetField();
     test_SetupGetIntField();
     test_GLE();
+    test_reopen();
     DeleteFileA( tmpfilename );
 }
@@ -41,11 +41,11 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(class);
 
-#define MAX_ATOM_LEN 255 /* from dlls/kernel32/atom.c */
 
 typedef struct tagCLASS
 {
-    struct list      entry;         /* Entry in class list */
+    struct list      entry;         /* Entry in class name hash list */
+    struct list      atom_entry;    /* Entry in class atom hash list */
     UINT             style;         /* Class style */
     BOOL             local;         /* Local class? */
     WNDPROC          winproc;       /* Window procedure */
@@ -64,7 +64,13 @@ typedef struct tagCLASS
     WCHAR           *basename;      /* Base name for redirected classes, pointer within 'name'. */
 } CLASS;
 
-static struct list class_list = LIST_INIT( class_list );
+/* Classes are hashed both by name and by atom. Local classes are added at the
+ * head of their hash lists and global ones at the tail, so that the first match
+ * in a list is the one that takes precedence. */
+#define CLASS_HASH_SIZE 128
+
+static struct list class_names[CLASS_HASH_SIZE];
+static struct list class_atoms[CLASS_HASH_SIZE];
 static INIT_ONCE init_once = INIT_ONCE_STATIC_INIT;
 
 #define CLASS_OTHER_PROCESS ((CLASS *)1)
@@ -102,6 +108,65 @@ static inline void release_class_ptr( CLASS *ptr )
 }
 
 
+/***********************************************************************
+ *           class_name_hash
+ */
+static struct list *class_name_hash( const WCHAR *name )
+{
+    unsigned int hash = 0;
+
+    while (*name) hash = hash * 31 + tolowerW( *name++ );
+    return &class_names[hash % CLASS_HASH_SIZE];
+}
+
+
+/***********************************************************************
+ *           class_atom_hash
+ */
+static inline struct list *class_atom_hash( ATOM atom )
+{
+    return &class_atoms[atom % CLASS_HASH_SIZE];
+}
+
+
+/***********************************************************************
+ *           find_class_by_name
+ *
+ * Return the class matching a name and instance. The user lock must be held.
+ */
+static CLASS *find_class_by_name( const WCHAR *name, HINSTANCE hinstance )
+{
+    struct list *hash = class_name_hash( name );
+    CLASS *class;
+
+    LIST_FOR_EACH_ENTRY( class, hash, CLASS, entry )
+    {
+        if (strcmpiW( class->name, name )) continue;
+        if (!class->local || class->hInstance == hinstance) return class;
+    }
+    return NULL;
+}
+
+
+/***********************************************************************
+ *           find_class_by_atom
+ *
+ * Return the class matching an atom and instance. The user lock must be held.
+ */
+static CLASS *find_class_by_atom( ATOM atom, HINSTANCE hinstance )
+{
+    struct list *hash = class_atom_hash( atom );
+    CLASS *class;
+
+    LIST_FOR_EACH_ENTRY( class, hash, CLASS, atom_entry )
+    {
+        if (class->atomName != atom) continue;
+        if (!class->local || class->hInstance == hinstance) return class;
+    }
+    return NULL;
+}
+
+
 /***********************************************************************
  *           get_int_atom_value
  */
@@ -312,6 +377,7 @@ static void CLASS_FreeClass( CLASS *classPtr )
 
     if (classPtr->dce) free_dce( classPtr->dce, 0 );
     list_remove( &classPtr->entry );
+    list_remove( &classPtr->atom_entry );
     if (classPtr->hbrBackground > (HBRUSH)(COLOR_GRADIENTINACTIVECAPTION + 1))
         DeleteObject( classPtr->hbrBackground );
     DestroyIcon( classPtr->hIconSmIntern );
@@ -360,22 +426,10 @@ const WCHAR *CLASS_GetVersionedName( const WCHAR *name, UINT *basename_offset, B
 
     if (register_class && hmod)
     {
-        BOOL found = FALSE;
-        struct list *ptr;
+        BOOL found;
 
         USER_Lock();
-
-        LIST_FOR_EACH( ptr, &class_list )
-        {
-            CLASS *class = LIST_ENTRY( ptr, CLASS, entry );
-            if (strcmpiW( class->name, ret )) continue;
-            if (!class->local || class->hInstance == hmod)
-            {
-                found = TRUE;
-                break;
-            }
-        }
-
+        found = find_class_by_name( ret, hmod ) != NULL;
         USER_Unlock();
 
         if (!found)
@@ -399,7 +453,7 @@ const WCHAR *CLASS_GetVersionedName( const WCHAR *name, UINT *basename_offset, B
 static CLASS *CLASS_FindClass( LPCWSTR name, HINSTANCE hinstance )
 {
     static const WCHAR comctl32W[] = {'c','o','m','c','t','l','3','2','.','d','l','l',0};
-    struct list *ptr;
+    CLASS *class;
     ATOM atom = get_int_atom_value( name );
 
     GetDesktopWindow();  /* create the desktop window to trigger builtin class registration */
@@ -412,22 +466,12 @@ static CLASS *CLASS_FindClass( LPCWSTR name, HINSTANCE hinstance )
     {
         USER_Lock();
 
-        LIST_FOR_EACH( ptr, &class_list )
+        if (atom) class = find_class_by_atom( atom, hinstance );
+        else class = find_class_by_name( name, hinstance );
+        if (class)
         {
-            CLASS *class = LIST_ENTRY( ptr, CLASS, entry );
-            if (atom)
-            {
-                if (class->atomName != atom) continue;
-            }
-            else
-            {
-                if (strcmpiW( class->name, name )) continue;
-            }
-            if (!class->local || class->hInstance == hinstance)
-            {
-                TRACE("%s %p -> %p\n", debugstr_w(name), hinstance, class);
-                return class;
-            }
+            TRACE("%s %p -> %p\n", debugstr_w(name), hinstance, class);
+            return class;
         }
         USER_Unlock();
 
@@ -504,8 +548,16 @@ static CLASS *CLASS_RegisterClass( LPCWSTR name, UINT basename_offset, HINSTANCE
     /* Other non-null values must be set by caller */
 
     USER_Lock();
-    if (local) list_add_head( &class_list, &classPtr->entry );
-    else list_add_tail( &class_list, &classPtr->entry );
+    if (local)
+    {
+        list_add_head( class_name_hash( classPtr->name ), &classPtr->entry );
+        list_add_head( class_atom_hash( classPtr->atomName ), &classPtr->atom_entry );
+    }
+    else
+    {
+        list_add_tail( class_name_hash( classPtr->name ), &classPtr->entry );
+        list_add_tail( class_atom_hash( classPtr->atomName ), &classPtr->atom_entry );
+    }
     return classPtr;
 }
 
@@ -565,6 +617,13 @@ void register_builtin_classes(void)
  */
 void register_desktop_class(void)
 {
+    unsigned int i;
+
+    for (i = 0; i < CLASS_HASH_SIZE; i++)
+    {
+        list_init( &class_names[i] );
+        list_init( &class_atoms[i] );
+    }
     register_builtin( &DESKTOP_builtin_class );
     register_builtin( &MESSAGE_builtin_class );
 }
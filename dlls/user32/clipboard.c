@@ -648,7 +648,7 @@ void CLIPBOARD_ReleaseOwner( HWND hwnd )
  */
 UINT WINAPI RegisterClipboardFormatW( LPCWSTR name )
 {
-    return GlobalAddAtomW( name );
+    return register_user_atom( name );
 }
 
 
@@ -657,7 +657,7 @@ UINT WINAPI RegisterClipboardFormatW( LPCWSTR name )
  */
 UINT WINAPI RegisterClipboardFormatA( LPCSTR name )
 {
-    return GlobalAddAtomA( name );
+    return register_user_atomA( name );
 }
 
 
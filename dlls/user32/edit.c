@@ -84,6 +84,7 @@ typedef struct tagLINEDEF {
 	INT index; 			/* line index into the buffer */
 	SCRIPT_STRING_ANALYSIS ssa;	/* Uniscribe Data */
 	struct tagLINEDEF *next;
+	struct tagLINEDEF *prev;
 } LINEDEF;
 
 typedef struct
@@ -132,6 +133,8 @@ typedef struct
 	INT tabs_count;
 	LPINT tabs;
 	LINEDEF *first_line_def;	/* linked list of (soft) linebreaks */
+	LINEDEF *cached_line_def;	/* last line def looked up, speeds up sequential access */
+	INT cached_line;		/* line number of cached_line_def */
 	HLOCAL hloc32W;			/* our unicode local memory block */
 	HLOCAL hloc32A;			/* alias for ANSI control receiving EM_GETHANDLE
 				   	   or EM_SETHANDLE */
@@ -364,6 +367,67 @@ static inline void EDIT_InvalidateUniscribeData_linedef(LINEDEF *line_def)
 	}
 }
 
+/*********************************************************************
+ *
+ *	EDIT_GetLineDef
+ *
+ *	Returns the line def of the given line, or NULL if there is no such
+ *	line. The walk starts from the last line looked up when possible,
+ *	so that sequential access doesn't rescan the whole list.
+ *
+ */
+static LINEDEF *EDIT_GetLineDef(EDITSTATE *es, INT line)
+{
+	LINEDEF *line_def = es->first_line_def;
+	INT l = 0;
+
+	if (es->cached_line_def && es->cached_line <= line)
+	{
+		line_def = es->cached_line_def;
+		l = es->cached_line;
+	}
+	while (line_def && l < line)
+	{
+		line_def = line_def->next;
+		l++;
+	}
+	if (line_def)
+	{
+		es->cached_line_def = line_def;
+		es->cached_line = l;
+	}
+	return line_def;
+}
+
+/*********************************************************************
+ *
+ *	EDIT_FindLineDef
+ *
+ *	Returns the line def containing the character at index, or the
+ *	last one if index is past the end of the text.
+ *
+ */
+static LINEDEF *EDIT_FindLineDef(EDITSTATE *es, INT index, INT *line)
+{
+	LINEDEF *line_def = es->first_line_def;
+	INT l = 0;
+
+	if (es->cached_line_def && es->cached_line_def->index <= index)
+	{
+		line_def = es->cached_line_def;
+		l = es->cached_line;
+	}
+	while (index >= line_def->index + line_def->length && line_def->next)
+	{
+		line_def = line_def->next;
+		l++;
+	}
+	es->cached_line_def = line_def;
+	es->cached_line = l;
+	if (line) *line = l;
+	return line_def;
+}
+
 static inline void EDIT_InvalidateUniscribeData(EDITSTATE *es)
 {
 	LINEDEF *line_def = es->first_line_def;
@@ -452,13 +516,7 @@ static SCRIPT_STRING_ANALYSIS EDIT_UpdateUniscribeData(EDITSTATE *es, HDC dc, IN
 	}
 	else
 	{
-		line_def = es->first_line_def;
-		while (line_def && line)
-		{
-			line_def = line_def->next;
-			line--;
-		}
-
+		line_def = EDIT_GetLineDef(es, line);
 		return EDIT_UpdateUniscribeData_linedef(es,dc,line_def);
 	}
 }
@@ -485,7 +543,7 @@ static void EDIT_BuildLineDefs_ML(EDITSTATE *es, INT istart, INT iend, INT delta
 	LINEDEF *current_line;
 	LINEDEF *previous_line;
 	LINEDEF *start_line;
-	INT line_index = 0, nstart_line, nstart_index;
+	INT line_index = 0, nstart_line, nstart_index, start_line_index;
 	INT line_count = es->line_count;
 	INT orig_net_length;
 	RECT rc;
@@ -494,26 +552,13 @@ static void EDIT_BuildLineDefs_ML(EDITSTATE *es, INT istart, INT iend, INT delta
 	if (istart == iend && delta == 0)
 		return;
 
-	previous_line = NULL;
-	current_line = es->first_line_def;
-
 	/* Find starting line. istart must lie inside an existing line or
 	 * at the end of buffer */
-	do {
-		if (istart < current_line->index + current_line->length ||
-				current_line->ending == END_0)
-			break;
+	current_line = EDIT_FindLineDef(es, istart, &line_index);
+	previous_line = current_line->prev;
 
-		previous_line = current_line;
-		current_line = current_line->next;
-		line_index++;
-	} while (current_line);
-
-	if (!current_line) /* Error occurred start is not inside previous buffer */
-	{
-		FIXME(" modification occurred outside buffer\n");
-		return;
-	}
+	/* Lines may be freed below, the cache is set again once we are done */
+	es->cached_line_def = NULL;
 
 	/* Remember start of modifications in order to calculate update region */
 	nstart_line = line_index;
@@ -527,6 +572,7 @@ static void EDIT_BuildLineDefs_ML(EDITSTATE *es, INT istart, INT iend, INT delta
 		current_line = previous_line;
 	}
 	start_line = current_line;
+	start_line_index = line_index;
 
 	fw = es->format_rect.right - es->format_rect.left;
 	current_position = es->text + current_line->index;
@@ -540,6 +586,8 @@ static void EDIT_BuildLineDefs_ML(EDITSTATE *es, INT istart, INT iend, INT delta
 				   insert it into the link list */
 				LINEDEF *new_line = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(LINEDEF));
 				new_line->next = previous_line->next;
+				new_line->prev = previous_line;
+				if (new_line->next) new_line->next->prev = new_line;
 				previous_line->next = new_line;
 				current_line = new_line;
 				es->line_count++;
@@ -548,6 +596,7 @@ static void EDIT_BuildLineDefs_ML(EDITSTATE *es, INT istart, INT iend, INT delta
 			{
 				/* The previous line merged with this line so we delete this extra entry */
 				previous_line->next = current_line->next;
+				if (current_line->next) current_line->next->prev = previous_line;
 				HeapFree(GetProcessHeap(), 0, current_line);
 				current_line = previous_line->next;
 				es->line_count--;
@@ -761,6 +810,10 @@ static void EDIT_BuildLineDefs_ML(EDITSTATE *es, INT istart, INT iend, INT delta
 		}
 	}
 
+	/* Lines before start_line were left alone, so its number is still valid */
+	es->cached_line_def = start_line;
+	es->cached_line = start_line_index;
+
 	/* Calculate rest of modification rectangle */
 	if (hrgn)
 	{
@@ -836,14 +889,11 @@ static INT EDIT_CharFromPos(EDITSTATE *es, INT x, INT y, LPBOOL after_wrap)
 	if (es->style & ES_MULTILINE) {
 		int trailing;
 		INT line = (y - es->format_rect.top) / es->line_height + es->y_offset;
-		INT line_index = 0;
-		LINEDEF *line_def = es->first_line_def;
+		INT line_index;
+		LINEDEF *line_def;
 		EDIT_UpdateUniscribeData(es, NULL, line);
-		while ((line > 0) && line_def->next) {
-			line_index += line_def->length;
-			line_def = line_def->next;
-			line--;
-		}
+		line_def = EDIT_GetLineDef(es, max(0, min(line, es->line_count - 1)));
+		line_index = line_def->index;
 
 		x += es->x_offset - es->format_rect.left;
 		if (es->style & ES_RIGHT)
@@ -961,7 +1011,6 @@ static void EDIT_ConfinePoint(const EDITSTATE *es, LPINT x, LPINT y)
 static INT EDIT_EM_LineFromChar(EDITSTATE *es, INT index)
 {
 	INT line;
-	LINEDEF *line_def;
 
 	if (!(es->style & ES_MULTILINE))
 		return 0;
@@ -970,14 +1019,7 @@ static INT EDIT_EM_LineFromChar(EDITSTATE *es, INT index)
 	if (index == -1)
 		index = min(es->selection_start, es->selection_end);
 
-	line = 0;
-	line_def = es->first_line_def;
-	index -= line_def->length;
-	while ((index >= 0) && line_def->next) {
-		line++;
-		line_def = line_def->next;
-		index -= line_def->length;
-	}
+	EDIT_FindLineDef(es, index, &line);
 	return line;
 }
 
@@ -987,9 +1029,8 @@ static INT EDIT_EM_LineFromChar(EDITSTATE *es, INT index)
  *	EM_LINEINDEX
  *
  */
-static INT EDIT_EM_LineIndex(const EDITSTATE *es, INT line)
+static INT EDIT_EM_LineIndex(EDITSTATE *es, INT line)
 {
-	INT line_index;
 	const LINEDEF *line_def;
 
 	if (!(es->style & ES_MULTILINE))
@@ -997,23 +1038,11 @@ static INT EDIT_EM_LineIndex(const EDITSTATE *es, INT line)
 	if (line >= es->line_count)
 		return -1;
 
-	line_index = 0;
-	line_def = es->first_line_def;
-	if (line == -1) {
-		INT index = es->selection_end - line_def->length;
-		while ((index >= 0) && line_def->next) {
-			line_index += line_def->length;
-			line_def = line_def->next;
-			index -= line_def->length;
-		}
-	} else {
-		while (line > 0) {
-			line_index += line_def->length;
-			line_def = line_def->next;
-			line--;
-		}
-	}
-	return line_index;
+	if (line == -1)
+		line_def = EDIT_FindLineDef(es, es->selection_end, NULL);
+	else
+		line_def = EDIT_GetLineDef(es, line);
+	return line_def->index;
 }
 
 
@@ -1043,12 +1072,7 @@ static INT EDIT_EM_LineLength(EDITSTATE *es, INT index)
 		count += li + EDIT_EM_LineLength(es, li) - es->selection_end;
 		return count;
 	}
-	line_def = es->first_line_def;
-	index -= line_def->length;
-	while ((index >= 0) && line_def->next) {
-		line_def = line_def->next;
-		index -= line_def->length;
-	}
+	line_def = EDIT_FindLineDef(es, index, NULL);
 	return line_def->net_length;
 }
 
@@ -1076,24 +1100,16 @@ static LRESULT EDIT_EM_PosFromChar(EDITSTATE *es, INT index, BOOL after_wrap)
 
 		y = (l - es->y_offset) * es->line_height;
 		li = EDIT_EM_LineIndex(es, l);
+		line_def = EDIT_GetLineDef(es, l);
 		if (after_wrap && (li == index) && l) {
-			INT l2 = l - 1;
-			line_def = es->first_line_def;
-			while (l2) {
-				line_def = line_def->next;
-				l2--;
-			}
-			if (line_def->ending == END_WRAP) {
+			if (line_def->prev->ending == END_WRAP) {
 				l--;
 				y -= es->line_height;
-				li = EDIT_EM_LineIndex(es, l);
+				line_def = line_def->prev;
+				li = line_def->index;
 			}
 		}
 
-		line_def = es->first_line_def;
-		while (line_def->index != li)
-			line_def = line_def->next;
-
 		lw = line_def->width;
 		w = es->format_rect.right - es->format_rect.left;
 		if (line_def->ssa)
@@ -1197,21 +1213,11 @@ static void EDIT_GetLineRect(EDITSTATE *es, INT line, INT scol, INT ecol, LPRECT
 		if (line >= es->line_count)
 			return;
 
-		line_def = es->first_line_def;
-		if (line == -1) {
-			INT index = es->selection_end - line_def->length;
-			while ((index >= 0) && line_def->next) {
-				line_index += line_def->length;
-				line_def = line_def->next;
-				index -= line_def->length;
-			}
-		} else {
-			while (line > 0) {
-				line_index += line_def->length;
-				line_def = line_def->next;
-				line--;
-			}
-		}
+		if (line == -1)
+			line_def = EDIT_FindLineDef(es, es->selection_end, NULL);
+		else
+			line_def = EDIT_GetLineDef(es, line);
+		line_index = line_def->index;
 		ssa = line_def->ssa;
 	}
 	else
@@ -2236,14 +2242,9 @@ static void EDIT_PaintLine(EDITSTATE *es, HDC dc, INT line, BOOL rev)
 		x =  -es->x_offset;
 		if (es->style & ES_RIGHT || es->style & ES_CENTER)
 		{
-			LINEDEF *line_def = es->first_line_def;
+			LINEDEF *line_def = EDIT_GetLineDef(es, line_idx);
 			int w, lw;
 
-			while (line_def && line_idx)
-			{
-				line_def = line_def->next;
-				line_idx--;
-			}
 			w = es->format_rect.right - es->format_rect.left;
 			lw = line_def->width;
 
@@ -2562,7 +2563,9 @@ static void EDIT_EM_ReplaceSel(EDITSTATE *es, BOOL can_undo, const WCHAR *lpsz_r
 	s = es->selection_start;
 	e = es->selection_end;
 
-	EDIT_InvalidateUniscribeData(es);
+	/* EDIT_BuildLineDefs_ML() invalidates the lines it rebuilds */
+	if (!(es->style & ES_MULTILINE))
+		EDIT_InvalidateUniscribeData(es);
 	if ((s == e) && !strl)
 		return;
 
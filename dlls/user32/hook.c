@@ -465,7 +465,11 @@ static LRESULT call_hook( struct hook_info *info, INT code, WPARAM wparam, LPARA
 static BOOL HOOK_IsHooked( INT id )
 {
     struct user_thread_info *thread_info = get_user_thread_info();
+    UINT chains;
 
+    /* the shared bitmap is always current, but it doesn't know which hooks apply to this thread */
+    if (get_queue_hook_chains( &chains ) && (chains & (1u << 31)) && !(chains & (1 << (id - WH_MINHOOK))))
+        return FALSE;
     if (!thread_info->active_hooks) return TRUE;
     return (thread_info->active_hooks & (1 << (id - WH_MINHOOK))) != 0;
 }
@@ -130,6 +130,20 @@ BOOL CDECL __wine_send_input( HWND hwnd, const INPUT *input )
 }
 
 
+/***********************************************************************
+ *		__wine_send_inputs  (USER32.@)
+ *
+ * Internal function to allow the graphics driver to inject a batch of real events
+ * with a single server call.
+ */
+BOOL CDECL __wine_send_inputs( UINT count, const HWND *hwnds, const INPUT *inputs )
+{
+    NTSTATUS status = send_hardware_messages( count, hwnds, inputs, 0 );
+    if (status) SetLastError( RtlNtStatusToDosError(status) );
+    return !status;
+}
+
+
 /***********************************************************************
  *		update_mouse_coords
  *
@@ -451,6 +465,7 @@ SHORT WINAPI DECLSPEC_HOTPATCH GetAsyncKeyState( INT key )
  */
 DWORD WINAPI GetQueueStatus( UINT flags )
 {
+    UINT wake_bits, changed_bits;
     DWORD ret;
 
     if (flags & ~(QS_ALLINPUT | QS_ALLPOSTMESSAGE | QS_SMRESULT))
@@ -461,6 +476,10 @@ DWORD WINAPI GetQueueStatus( UINT flags )
 
     check_for_events( flags );
 
+    /* no need to ask the server if there are no changed bits to clear */
+    if (get_queue_bits( &wake_bits, &changed_bits ) && !(changed_bits & flags))
+        return MAKELONG( 0, wake_bits & flags );
+
     SERVER_START_REQ( get_queue_status )
     {
         req->clear_bits = flags;
@@ -477,10 +496,13 @@ DWORD WINAPI GetQueueStatus( UINT flags )
  */
 BOOL WINAPI GetInputState(void)
 {
+    UINT wake_bits, changed_bits;
     DWORD ret;
 
     check_for_events( QS_INPUT );
 
+    if (get_queue_bits( &wake_bits, &changed_bits )) return wake_bits & (QS_KEY | QS_MOUSEBUTTON);
+
     SERVER_START_REQ( get_queue_status )
     {
         req->clear_bits = 0;
@@ -1817,22 +1817,31 @@ static void unpack_reply( HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam,
  *
  * Send a reply to a sent message.
  */
-static void reply_message( struct received_message_info *info, LRESULT result, BOOL remove )
+static BOOL prepare_reply( struct received_message_info *info, LRESULT result, BOOL remove,
+                           struct packed_message *data )
 {
-    struct packed_message data;
-    int i, replied = info->flags & ISMEX_REPLIED;
+    int replied = info->flags & ISMEX_REPLIED;
 
-    if (info->flags & ISMEX_NOTIFY) return;  /* notify messages don't get replies */
-    if (!remove && replied) return;  /* replied already */
+    if (info->flags & ISMEX_NOTIFY) return FALSE;  /* notify messages don't get replies */
+    if (!remove && replied) return FALSE;  /* replied already */
 
-    memset( &data, 0, sizeof(data) );
+    memset( data, 0, sizeof(*data) );
     info->flags |= ISMEX_REPLIED;
 
     if (info->type == MSG_OTHER_PROCESS && !replied)
     {
         pack_reply( info->msg.hwnd, info->msg.message, info->msg.wParam,
-                    info->msg.lParam, result, &data );
+                    info->msg.lParam, result, data );
     }
+    return TRUE;
+}
+
+static void reply_message( struct received_message_info *info, LRESULT result, BOOL remove )
+{
+    struct packed_message data;
+    int i;
+
+    if (!prepare_reply( info, result, remove, &data )) return;
 
     SERVER_START_REQ( reply_message )
     {
@@ -2725,6 +2734,87 @@ static inline void call_sendmsg_callback( SENDASYNCPROC callback, HWND hwnd, UIN
 }
 
 
+/***********************************************************************
+ *           get_queue_bits
+ *
+ * Read the queue status bits from the memory shared with the server.
+ * Return FALSE if the shared memory is not available.
+ */
+BOOL get_queue_bits( UINT *wake_bits, UINT *changed_bits )
+{
+    struct user_thread_info *thread_info = get_user_thread_info();
+    const volatile queue_shm_t *shm;
+
+    if (!thread_info->queue_shm)
+    {
+        HANDLE file = 0, mapping;
+        void *ptr = NULL;
+
+        SERVER_START_REQ( get_queue_shm )
+        {
+            if (!wine_server_call( req )) file = wine_server_ptr_handle( reply->handle );
+        }
+        SERVER_END_REQ;
+
+        if (file)
+        {
+            if ((mapping = CreateFileMappingW( file, NULL, PAGE_READONLY, 0, 0, NULL )))
+            {
+                ptr = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+                CloseHandle( mapping );
+            }
+            CloseHandle( file );
+        }
+        if (!ptr) WARN( "queue shared memory not available\n" );
+        thread_info->queue_shm = ptr ? ptr : QUEUE_SHM_UNAVAILABLE;
+    }
+    if (thread_info->queue_shm == QUEUE_SHM_UNAVAILABLE) return FALSE;
+
+    shm = thread_info->queue_shm;
+    *changed_bits = shm->changed_bits;
+    *wake_bits    = shm->wake_bits;
+    return TRUE;
+}
+
+
+/***********************************************************************
+ *           get_queue_hook_chains
+ *
+ * Read the bitmap of non-empty hook chains from the memory shared with the
+ * server. Return FALSE if the shared memory hasn't been mapped yet.
+ */
+BOOL get_queue_hook_chains( UINT *chains )
+{
+    const volatile queue_shm_t *shm = get_user_thread_info()->queue_shm;
+
+    if (!shm || shm == QUEUE_SHM_UNAVAILABLE) return FALSE;
+    *chains = shm->hook_chains;
+    return TRUE;
+}
+
+
+/***********************************************************************
+ *           queue_is_empty
+ *
+ * Check if peek_message can return without asking the server, because
+ * none of the queue bits that could lead to a message are set.
+ */
+static BOOL queue_is_empty( UINT flags )
+{
+    struct user_thread_info *thread_info = get_user_thread_info();
+    UINT filter = flags >> 16, wake_bits, changed_bits, mask;
+
+    /* the server considers the thread hung if it doesn't check for messages */
+    if (GetTickCount() - thread_info->last_get_msg > 1000) return FALSE;
+    if (!get_queue_bits( &wake_bits, &changed_bits )) return FALSE;
+
+    if (!filter) filter = QS_ALLINPUT;
+    mask = QS_SENDMESSAGE | (filter & (QS_POSTMESSAGE | QS_HOTKEY | QS_TIMER | QS_INPUT | QS_PAINT));
+    if (filter & QS_POSTMESSAGE) mask |= QS_ALLPOSTMESSAGE;
+    return !(wake_bits & mask);
+}
+
+
 /***********************************************************************
  *           peek_message
  *
@@ -2737,9 +2827,13 @@ static BOOL peek_message( MSG *msg, HWND hwnd, UINT first, UINT last, UINT flags
     struct user_thread_info *thread_info = get_user_thread_info();
     struct received_message_info info, *old_info;
     unsigned int hw_id = 0;  /* id of previous hardware message */
+    struct packed_message reply_data;  /* reply to the previous sent message */
+    BOOL reply_pending = FALSE;
+    LRESULT reply_result = 0;
     void *buffer;
     size_t buffer_size = 256;
 
+    if (queue_is_empty( flags )) return FALSE;
     if (!(buffer = HeapAlloc( GetProcessHeap(), 0, buffer_size ))) return FALSE;
 
     if (!first && !last) last = ~0;
@@ -2760,8 +2854,20 @@ static BOOL peek_message( MSG *msg, HWND hwnd, UINT first, UINT last, UINT flags
             req->hw_id     = hw_id;
             req->wake_mask = changed_mask & (QS_SENDMESSAGE | QS_SMRESULT);
             req->changed_mask = changed_mask;
+            if (reply_pending)
+            {
+                int i;
+
+                req->reply  = TRUE;
+                req->result = reply_result;
+                for (i = 0; i < reply_data.count; i++)
+                    wine_server_add_data( req, reply_data.data[i], reply_data.size[i] );
+            }
             wine_server_set_reply( req, buffer, buffer_size );
-            if (!(res = wine_server_call( req )))
+            res = wine_server_call( req );
+            reply_pending = FALSE;
+            thread_info->last_get_msg = GetTickCount();
+            if (!res)
             {
                 size = wine_server_reply_size( reply );
                 info.type        = reply->type;
@@ -2881,7 +2987,9 @@ static BOOL peek_message( MSG *msg, HWND hwnd, UINT first, UINT last, UINT flags
                        hook.pt.x, hook.pt.y, hook.mouseData, hook.flags, hook.time, hook.dwExtraInfo );
                 result = HOOK_CallHooks( WH_MOUSE_LL, HC_ACTION, info.msg.wParam, (LPARAM)&hook, TRUE );
             }
-            reply_message( &info, result, TRUE );
+            /* the reply is sent along with the next get_message request */
+            reply_pending = prepare_reply( &info, result, TRUE, &reply_data );
+            reply_result = result;
             continue;
         case MSG_OTHER_PROCESS:
             info.flags = ISMEX_SEND;
@@ -2889,7 +2997,8 @@ static BOOL peek_message( MSG *msg, HWND hwnd, UINT first, UINT last, UINT flags
                                  &info.msg.lParam, &buffer, size ))
             {
                 /* ignore it */
-                reply_message( &info, 0, TRUE );
+                reply_pending = prepare_reply( &info, 0, TRUE, &reply_data );
+                reply_result = 0;
                 continue;
             }
             break;
@@ -2952,7 +3061,8 @@ static BOOL peek_message( MSG *msg, HWND hwnd, UINT first, UINT last, UINT flags
         result = call_window_proc( info.msg.hwnd, info.msg.message, info.msg.wParam,
                                    info.msg.lParam, (info.type != MSG_ASCII), FALSE,
                                    WMCHAR_MAP_RECVMESSAGE );
-        reply_message( &info, result, TRUE );
+        reply_pending = prepare_reply( &info, result, TRUE, &reply_data );
+        reply_result = result;
         thread_info->receive_info = old_info;
 
         /* if some PM_QS* flags were specified, only handle sent messages from now on */
@@ -3002,8 +3112,9 @@ static HANDLE get_server_queue_handle(void)
  *           wait_message_reply
  *
  * Wait until a sent message gets replied to.
+ * If mask_set is TRUE, the wake mask was already set by the send_message request.
  */
-static void wait_message_reply( UINT flags )
+static void wait_message_reply( UINT flags, BOOL mask_set )
 {
     struct user_thread_info *thread_info = get_user_thread_info();
     HANDLE server_queue = get_server_queue_handle();
@@ -3011,17 +3122,26 @@ static void wait_message_reply( UINT flags )
 
     for (;;)
     {
-        unsigned int wake_bits = 0;
+        UINT wake_bits, changed_bits;
 
-        SERVER_START_REQ( set_queue_mask )
+        /* check the shared queue bits first, the server only needs
+         * to be asked if we have to set the mask before waiting */
+        if (!get_queue_bits( &wake_bits, &changed_bits )) wake_bits = 0;
+        wake_bits &= wake_mask;
+
+        if (!wake_bits && !mask_set)
         {
-            req->wake_mask    = wake_mask;
-            req->changed_mask = wake_mask;
-            req->skip_wait    = 1;
-            if (!wine_server_call( req )) wake_bits = reply->wake_bits & wake_mask;
+            SERVER_START_REQ( set_queue_mask )
+            {
+                req->wake_mask    = wake_mask;
+                req->changed_mask = wake_mask;
+                req->skip_wait    = 1;
+                if (!wine_server_call( req )) wake_bits = reply->wake_bits & wake_mask;
+            }
+            SERVER_END_REQ;
         }
-        SERVER_END_REQ;
 
+        mask_set = FALSE;
         thread_info->wake_mask = thread_info->changed_mask = 0;
 
         if (wake_bits & QS_SMRESULT) return;  /* got a result */
@@ -3134,6 +3254,8 @@ static BOOL put_message_in_queue( const struct send_message_info *info, size_t *
         req->wparam  = info->wparam;
         req->lparam  = info->lparam;
         req->timeout = timeout;
+        if (info->type != MSG_NOTIFY && info->type != MSG_CALLBACK && info->type != MSG_POSTED)
+            req->wake_mask = QS_SMRESULT | ((info->flags & SMTO_BLOCK) ? 0 : QS_SENDMESSAGE);
 
         if (info->flags & SMTO_ABORTIFHUNG) req->flags |= SEND_MSG_ABORT_IF_HUNG;
         for (i = 0; i < data.count; i++) wine_server_add_data( req, data.data[i], data.size[i] );
@@ -3210,7 +3332,7 @@ static LRESULT send_inter_thread_message( const struct send_message_info *info,
     /* there's no reply to wait for on notify/callback messages */
     if (info->type == MSG_NOTIFY || info->type == MSG_CALLBACK) return 1;
 
-    wait_message_reply( info->flags );
+    wait_message_reply( info->flags, TRUE );
     return retrieve_reply( info, reply_size, res_ptr );
 }
 
@@ -3287,6 +3409,39 @@ static BOOL send_message( struct send_message_info *info, DWORD_PTR *res_ptr, BO
 }
 
 
+/***********************************************************************
+ *		get_hw_input
+ *
+ * Convert an INPUT structure to the server format.
+ */
+static void get_hw_input( hw_input_t *hw_input, const INPUT *input )
+{
+    memset( hw_input, 0, sizeof(*hw_input) );
+    hw_input->type = input->type;
+    switch (input->type)
+    {
+    case INPUT_MOUSE:
+        hw_input->mouse.x     = input->u.mi.dx;
+        hw_input->mouse.y     = input->u.mi.dy;
+        hw_input->mouse.data  = input->u.mi.mouseData;
+        hw_input->mouse.flags = input->u.mi.dwFlags;
+        hw_input->mouse.time  = input->u.mi.time;
+        hw_input->mouse.info  = input->u.mi.dwExtraInfo;
+        break;
+    case INPUT_KEYBOARD:
+        hw_input->kbd.vkey  = input->u.ki.wVk;
+        hw_input->kbd.scan  = input->u.ki.wScan;
+        hw_input->kbd.flags = input->u.ki.dwFlags;
+        hw_input->kbd.time  = input->u.ki.time;
+        hw_input->kbd.info  = input->u.ki.dwExtraInfo;
+        break;
+    case INPUT_HARDWARE:
+        hw_input->hw.msg    = input->u.hi.uMsg;
+        hw_input->hw.lparam = MAKELONG( input->u.hi.wParamL, input->u.hi.wParamH );
+        break;
+    }
+}
+
 /***********************************************************************
  *		send_hardware_message
  */
@@ -3307,31 +3462,9 @@ NTSTATUS send_hardware_message( HWND hwnd, const INPUT *input, UINT flags )
 
     SERVER_START_REQ( send_hardware_message )
     {
-        req->win        = wine_server_user_handle( hwnd );
-        req->flags      = flags;
-        req->input.type = input->type;
-        switch (input->type)
-        {
-        case INPUT_MOUSE:
-            req->input.mouse.x     = input->u.mi.dx;
-            req->input.mouse.y     = input->u.mi.dy;
-            req->input.mouse.data  = input->u.mi.mouseData;
-            req->input.mouse.flags = input->u.mi.dwFlags;
-            req->input.mouse.time  = input->u.mi.time;
-            req->input.mouse.info  = input->u.mi.dwExtraInfo;
-            break;
-        case INPUT_KEYBOARD:
-            req->input.kbd.vkey  = input->u.ki.wVk;
-            req->input.kbd.scan  = input->u.ki.wScan;
-            req->input.kbd.flags = input->u.ki.dwFlags;
-            req->input.kbd.time  = input->u.ki.time;
-            req->input.kbd.info  = input->u.ki.dwExtraInfo;
-            break;
-        case INPUT_HARDWARE:
-            req->input.hw.msg    = input->u.hi.uMsg;
-            req->input.hw.lparam = MAKELONG( input->u.hi.wParamL, input->u.hi.wParamH );
-            break;
-        }
+        req->win   = wine_server_user_handle( hwnd );
+        req->flags = flags;
+        get_hw_input( &req->input, input );
         if (key_state_info) wine_server_set_reply( req, key_state_info->state,
                                                    sizeof(key_state_info->state) );
         ret = wine_server_call( req );
@@ -3357,13 +3490,87 @@ NTSTATUS send_hardware_message( HWND hwnd, const INPUT *input, UINT flags )
     if (wait)
     {
         LRESULT ignored;
-        wait_message_reply( 0 );
+        wait_message_reply( 0, FALSE );
         retrieve_reply( &info, 0, &ignored );
     }
     return ret;
 }
 
 
+/***********************************************************************
+ *		send_hardware_messages
+ *
+ * Send a batch of inputs with a single server call, the server coalesces
+ * consecutive mouse motions unless raw input is in use.
+ */
+NTSTATUS send_hardware_messages( UINT count, const HWND *hwnds, const INPUT *inputs, UINT flags )
+{
+    struct user_key_state_info *key_state_info = get_user_thread_info()->key_state;
+    hw_input_entry_t entries[64];
+    struct send_message_info info;
+    int prev_x, prev_y, new_x, new_y;
+    INT counter;
+    NTSTATUS ret = STATUS_SUCCESS;
+    UINT i, batch, done;
+    BOOL wait;
+
+    info.type     = MSG_HARDWARE;
+    info.dest_tid = 0;
+    info.flags    = 0;
+    info.timeout  = 0;
+
+    while (count && !ret)
+    {
+        batch = min( count, ARRAY_SIZE(entries) );
+        for (i = 0; i < batch; i++)
+        {
+            entries[i].win = wine_server_user_handle( hwnds[i] );
+            entries[i].__pad = 0;
+            get_hw_input( &entries[i].input, &inputs[i] );
+        }
+
+        counter = global_key_state_counter;
+        SERVER_START_REQ( send_hardware_messages )
+        {
+            req->flags = flags;
+            wine_server_add_data( req, entries, batch * sizeof(entries[0]) );
+            if (key_state_info) wine_server_set_reply( req, key_state_info->state,
+                                                       sizeof(key_state_info->state) );
+            ret = wine_server_call( req );
+            done   = reply->count;
+            wait   = reply->wait;
+            prev_x = reply->prev_x;
+            prev_y = reply->prev_y;
+            new_x  = reply->new_x;
+            new_y  = reply->new_y;
+        }
+        SERVER_END_REQ;
+
+        if (ret) break;
+        if (key_state_info)
+        {
+            key_state_info->time    = GetTickCount();
+            key_state_info->counter = counter;
+        }
+        if ((flags & SEND_HWMSG_INJECTED) && (prev_x != new_x || prev_y != new_y))
+            USER_Driver->pSetCursorPos( new_x, new_y );
+
+        if (wait)
+        {
+            LRESULT ignored;
+            info.hwnd = hwnds[done - 1];
+            wait_message_reply( 0, FALSE );
+            retrieve_reply( &info, 0, &ignored );
+        }
+        if (!done) break;
+        count  -= done;
+        hwnds  += done;
+        inputs += done;
+    }
+    return ret;
+}
+
+
 /***********************************************************************
  *		MSG_SendInternalMessageTimeout
  *
@@ -4221,13 +4428,49 @@ DWORD WINAPI WaitForInputIdle( HANDLE hProcess, DWORD dwTimeOut )
 }
 
 
+/* global atoms already registered by this process, indexed by atom - MAXINTATOM */
+static BYTE registered_atoms[(0x10000 - MAXINTATOM) / 8];
+
+/***********************************************************************
+ *		register_user_atom
+ *
+ * Register a window message or clipboard format name. Registered names are
+ * never deleted, so once this process holds a reference on the atom, the
+ * cached lookup in ntdll is enough and the reference count isn't bumped again.
+ */
+UINT register_user_atom( LPCWSTR name )
+{
+    RTL_ATOM atom;
+    UINT ret;
+
+    if (!IS_INTRESOURCE( name ) && !NtFindAtom( name, strlenW( name ) * sizeof(WCHAR), &atom ) &&
+        atom >= MAXINTATOM && (registered_atoms[(atom - MAXINTATOM) / 8] & (1 << (atom % 8))))
+        return atom;
+
+    /* concurrent updates may lose a bit, which only costs another server call */
+    if ((ret = GlobalAddAtomW( name )) >= MAXINTATOM)
+        registered_atoms[(ret - MAXINTATOM) / 8] |= 1 << (ret % 8);
+    return ret;
+}
+
+/* same as register_user_atom for an ANSI name */
+UINT register_user_atomA( LPCSTR name )
+{
+    WCHAR buffer[MAX_ATOM_LEN + 1];
+
+    if (IS_INTRESOURCE( name ) || !MultiByteToWideChar( CP_ACP, 0, name, -1, buffer, MAX_ATOM_LEN + 1 ))
+        return GlobalAddAtomA( name );
+    return register_user_atom( buffer );
+}
+
+
 /***********************************************************************
  *		RegisterWindowMessageA (USER32.@)
  *		RegisterWindowMessage (USER.118)
  */
 UINT WINAPI RegisterWindowMessageA( LPCSTR str )
 {
-    UINT ret = GlobalAddAtomA(str);
+    UINT ret = register_user_atomA(str);
     TRACE("%s, ret=%x\n", str, ret);
     return ret;
 }
@@ -4238,7 +4481,7 @@ UINT WINAPI RegisterWindowMessageA( LPCSTR str )
  */
 UINT WINAPI RegisterWindowMessageW( LPCWSTR str )
 {
-    UINT ret = GlobalAddAtomW(str);
+    UINT ret = register_user_atom(str);
     TRACE("%s ret=%x\n", debugstr_w(str), ret);
     return ret;
 }
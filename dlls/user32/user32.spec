@@ -827,4 +827,5 @@
 # or 'wine_' (for user-visible functions) to avoid namespace conflicts.
 #
 @ cdecl __wine_send_input(long ptr)
+@ cdecl __wine_send_inputs(long ptr ptr)
 @ cdecl __wine_set_pixel_format(long long)
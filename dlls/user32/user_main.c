@@ -379,6 +379,8 @@ static void thread_detach(void)
     HeapFree( GetProcessHeap(), 0, thread_info->wmchar_data );
     HeapFree( GetProcessHeap(), 0, thread_info->key_state );
     HeapFree( GetProcessHeap(), 0, thread_info->rawinput );
+    if (thread_info->queue_shm && thread_info->queue_shm != QUEUE_SHM_UNAVAILABLE)
+        UnmapViewOfFile( thread_info->queue_shm );
 
     exiting_thread_id = 0;
 }
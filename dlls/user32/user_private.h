@@ -38,6 +38,8 @@
 #define WINE_MOUSE_HANDLE       ((HANDLE)1)
 #define WINE_KEYBOARD_HANDLE    ((HANDLE)2)
 
+#define MAX_ATOM_LEN 255 /* from dlls/kernel32/atom.c */
+
 struct window_surface;
 
 /* internal messages codes */
@@ -168,6 +170,7 @@ struct wm_char_mapping_data
 struct user_thread_info
 {
     DPI_AWARENESS                 dpi_awareness;          /* DPI awareness */
+    DWORD                         last_get_msg;           /* Time of last get_message request */
     HANDLE                        server_queue;           /* Handle to server-side queue */
     DWORD                         wake_mask;              /* Current queue wake mask */
     DWORD                         changed_mask;           /* Current queue changed mask */
@@ -175,19 +178,22 @@ struct user_thread_info
     WORD                          message_count;          /* Get/PeekMessage loop counter */
     WORD                          hook_call_depth;        /* Number of recursively called hook procs */
     BOOL                          hook_unicode;           /* Is current hook unicode? */
+    UINT                          active_hooks;           /* Bitmap of active hooks */
     HHOOK                         hook;                   /* Current hook */
     struct received_message_info *receive_info;           /* Message being currently received */
     struct wm_char_mapping_data  *wmchar_data;            /* Data for WM_CHAR mappings */
     DWORD                         GetMessageTimeVal;      /* Value for GetMessageTime */
     DWORD                         GetMessagePosVal;       /* Value for GetMessagePos */
     ULONG_PTR                     GetMessageExtraInfoVal; /* Value for GetMessageExtraInfo */
-    UINT                          active_hooks;           /* Bitmap of active hooks */
     struct user_key_state_info   *key_state;              /* Cache of global key state */
     HWND                          top_window;             /* Desktop window */
     HWND                          msg_window;             /* HWND_MESSAGE parent window */
     RAWINPUT                     *rawinput;
+    const void                   *queue_shm;              /* Queue status bits shared with the server */
 };
 
+#define QUEUE_SHM_UNAVAILABLE ((const void *)~(ULONG_PTR)0)
+
 C_ASSERT( sizeof(struct user_thread_info) <= sizeof(((TEB *)0)->Win32ClientInfo) );
 
 extern INT global_key_state_counter DECLSPEC_HIDDEN;
@@ -243,6 +249,12 @@ extern LRESULT call_current_hook( HHOOK hhook, INT code, WPARAM wparam, LPARAM l
 extern DWORD get_input_codepage( void ) DECLSPEC_HIDDEN;
 extern BOOL map_wparam_AtoW( UINT message, WPARAM *wparam, enum wm_char_mapping mapping ) DECLSPEC_HIDDEN;
 extern NTSTATUS send_hardware_message( HWND hwnd, const INPUT *input, UINT flags ) DECLSPEC_HIDDEN;
+extern NTSTATUS send_hardware_messages( UINT count, const HWND *hwnds, const INPUT *inputs,
+                                        UINT flags ) DECLSPEC_HIDDEN;
+extern BOOL get_queue_bits( UINT *wake_bits, UINT *changed_bits ) DECLSPEC_HIDDEN;
+extern BOOL get_queue_hook_chains( UINT *chains ) DECLSPEC_HIDDEN;
+extern UINT register_user_atom( LPCWSTR name ) DECLSPEC_HIDDEN;
+extern UINT register_user_atomA( LPCSTR name ) DECLSPEC_HIDDEN;
 extern LRESULT MSG_SendInternalMessageTimeout( DWORD dest_pid, DWORD dest_tid,
                                                UINT msg, WPARAM wparam, LPARAM lparam,
                                                UINT flags, UINT timeout, PDWORD_PTR res_ptr ) DECLSPEC_HIDDEN;
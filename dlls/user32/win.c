@@ -610,6 +610,75 @@ done:
 }
 
 
+/***********************************************************************
+ *           map_window_shm
+ *
+ * Map the window information shared by the server.
+ */
+static const window_shm_t *map_window_shm(void)
+{
+    static const window_shm_t *window_shm;
+    static BOOL failed;
+    HANDLE file = 0, mapping;
+    void *ptr = NULL;
+
+    if (window_shm || failed) return window_shm;
+
+    SERVER_START_REQ( get_window_shm )
+    {
+        if (!wine_server_call( req )) file = wine_server_ptr_handle( reply->handle );
+    }
+    SERVER_END_REQ;
+
+    if (file)
+    {
+        if ((mapping = CreateFileMappingW( file, NULL, PAGE_READONLY, 0, 0, NULL )))
+        {
+            ptr = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+            CloseHandle( mapping );
+        }
+        CloseHandle( file );
+    }
+    if (!ptr)
+    {
+        WARN( "window shared memory not available\n" );
+        failed = TRUE;
+        return NULL;
+    }
+    if (InterlockedCompareExchangePointer( (void **)&window_shm, ptr, NULL )) UnmapViewOfFile( ptr );
+    return window_shm;
+}
+
+
+/***********************************************************************
+ *           get_shared_window_info
+ *
+ * Retrieve the information of a window of another process from the memory
+ * shared with the server. Return FALSE if not available.
+ */
+static BOOL get_shared_window_info( HWND hwnd, window_shm_t *info )
+{
+    const window_shm_t *window_shm;
+    const volatile window_shm_t *entry;
+    user_handle_t handle = wine_server_user_handle( hwnd );
+    unsigned int index = ((handle & 0xffff) - FIRST_USER_HANDLE) >> 1, seq;
+
+    if (index >= WINDOW_SHM_ENTRIES) return FALSE;
+    if (!(window_shm = map_window_shm())) return FALSE;
+
+    entry = &window_shm[index];
+    do
+    {
+        while ((seq = entry->seq) & 1) /* entry is being updated */;
+        *info = *entry;
+    } while (entry->seq != seq);
+
+    if (!info->handle) return FALSE;
+    if ((handle >> 16) && (handle >> 16) != 0xffff && info->handle != handle) return FALSE;
+    return TRUE;
+}
+
+
 /***********************************************************************
  *           WIN_GetPtr
  *
@@ -710,6 +779,10 @@ HWND WIN_GetFullHandle( HWND hwnd )
     }
     else  /* may belong to another process */
     {
+        window_shm_t info;
+
+        if (get_shared_window_info( hwnd, &info )) return wine_server_ptr_handle( info.handle );
+
         SERVER_START_REQ( get_window_info )
         {
             req->handle = wine_server_user_handle( hwnd );
@@ -808,6 +881,67 @@ ULONG WIN_SetStyle( HWND hwnd, ULONG set_bits, ULONG clear_bits )
 }
 
 
+/***********************************************************************
+ *           get_shared_rectangles
+ *
+ * Get the rectangles of a window of another process from the shared memory,
+ * following the same rules as the get_window_rectangles server request.
+ */
+static BOOL get_shared_rectangles( HWND hwnd, enum coords_relative relative, RECT *rectWindow, RECT *rectClient )
+{
+    window_shm_t info, parent;
+    RECT window_rect, client_rect, rect;
+    user_handle_t handle;
+    int depth = 0;
+
+    if (!get_shared_window_info( hwnd, &info )) return FALSE;
+
+    SetRect( &window_rect, info.window.left, info.window.top, info.window.right, info.window.bottom );
+    SetRect( &client_rect, info.client.left, info.client.top, info.client.right, info.client.bottom );
+
+    switch (relative)
+    {
+    case COORDS_CLIENT:
+        rect = client_rect;
+        OffsetRect( &window_rect, -rect.left, -rect.top );
+        OffsetRect( &client_rect, -rect.left, -rect.top );
+        if (info.ex_style & WS_EX_LAYOUTRTL) mirror_rect( &rect, &window_rect );
+        break;
+    case COORDS_WINDOW:
+        rect = window_rect;
+        OffsetRect( &window_rect, -rect.left, -rect.top );
+        OffsetRect( &client_rect, -rect.left, -rect.top );
+        if (info.ex_style & WS_EX_LAYOUTRTL) mirror_rect( &rect, &client_rect );
+        break;
+    case COORDS_PARENT:
+        if (!info.parent) break;
+        if (!get_shared_window_info( wine_server_ptr_handle( info.parent ), &parent )) return FALSE;
+        if (parent.ex_style & WS_EX_LAYOUTRTL)
+        {
+            SetRect( &rect, parent.client.left, parent.client.top, parent.client.right, parent.client.bottom );
+            mirror_rect( &rect, &window_rect );
+            mirror_rect( &rect, &client_rect );
+        }
+        break;
+    case COORDS_SCREEN:
+        for (handle = info.parent; handle; handle = parent.parent)
+        {
+            if (++depth > 256) return FALSE;
+            if (!get_shared_window_info( wine_server_ptr_handle( handle ), &parent )) return FALSE;
+            if (!parent.parent) break;  /* desktop window */
+            OffsetRect( &window_rect, parent.client.left, parent.client.top );
+            OffsetRect( &client_rect, parent.client.left, parent.client.top );
+        }
+        break;
+    default:
+        return FALSE;
+    }
+    if (rectWindow) *rectWindow = window_rect;
+    if (rectClient) *rectClient = client_rect;
+    return TRUE;
+}
+
+
 /***********************************************************************
  *           WIN_GetRectangles
  *
@@ -915,6 +1049,8 @@ BOOL WIN_GetRectangles( HWND hwnd, enum coords_relative relative, RECT *rectWind
     }
 
 other_process:
+    if (get_shared_rectangles( hwnd, relative, rectWindow, rectClient )) return TRUE;
+
     SERVER_START_REQ( get_window_rectangles )
     {
         req->handle = wine_server_user_handle( hwnd );
@@ -2255,11 +2391,24 @@ static LONG_PTR WIN_GetWindowLong( HWND hwnd, INT offset, UINT size, BOOL unicod
 
     if (wndPtr == WND_OTHER_PROCESS)
     {
+        window_shm_t info;
+
         if (offset == GWLP_WNDPROC)
         {
             SetLastError( ERROR_ACCESS_DENIED );
             return 0;
         }
+        if (offset < 0 && get_shared_window_info( hwnd, &info ))
+        {
+            switch(offset)
+            {
+            case GWL_STYLE:      return info.style;
+            case GWL_EXSTYLE:    return info.ex_style;
+            case GWLP_ID:        return info.id;
+            case GWLP_HINSTANCE: return (ULONG_PTR)wine_server_get_ptr( info.instance );
+            case GWLP_USERDATA:  return info.user_data;
+            }
+        }
         SERVER_START_REQ( set_window_info )
         {
             req->handle = wine_server_user_handle( hwnd );
@@ -2846,6 +2995,7 @@ INT WINAPI GetWindowTextLengthW( HWND hwnd )
  */
 BOOL WINAPI IsWindow( HWND hwnd )
 {
+    window_shm_t info;
     WND *ptr;
     BOOL ret;
 
@@ -2859,6 +3009,8 @@ BOOL WINAPI IsWindow( HWND hwnd )
     }
 
     /* check other processes */
+    if (get_shared_window_info( hwnd, &info )) return TRUE;
+
     SERVER_START_REQ( get_window_info )
     {
         req->handle = wine_server_user_handle( hwnd );
@@ -2874,6 +3026,7 @@ BOOL WINAPI IsWindow( HWND hwnd )
  */
 DWORD WINAPI GetWindowThreadProcessId( HWND hwnd, LPDWORD process )
 {
+    window_shm_t info;
     WND *ptr;
     DWORD tid = 0;
 
@@ -2893,6 +3046,12 @@ DWORD WINAPI GetWindowThreadProcessId( HWND hwnd, LPDWORD process )
     }
 
     /* check other processes */
+    if (get_shared_window_info( hwnd, &info ))
+    {
+        if (process) *process = info.pid;
+        return info.tid;
+    }
+
     SERVER_START_REQ( get_window_info )
     {
         req->handle = wine_server_user_handle( hwnd );
@@ -2923,7 +3082,16 @@ HWND WINAPI GetParent( HWND hwnd )
     if (wndPtr == WND_DESKTOP) return 0;
     if (wndPtr == WND_OTHER_PROCESS)
     {
-        LONG style = GetWindowLongW( hwnd, GWL_STYLE );
+        window_shm_t info;
+        LONG style;
+
+        if (get_shared_window_info( hwnd, &info ))
+        {
+            if (info.style & WS_POPUP) retvalue = wine_server_ptr_handle( info.owner );
+            else if (info.style & WS_CHILD) retvalue = wine_server_ptr_handle( info.parent );
+            return retvalue;
+        }
+        style = GetWindowLongW( hwnd, GWL_STYLE );
         if (style & (WS_POPUP | WS_CHILD))
         {
             SERVER_START_REQ( get_window_tree )
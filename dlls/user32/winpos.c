@@ -2208,14 +2208,31 @@ BOOL set_window_pos( HWND hwnd, HWND insert_after, UINT swp_flags,
 
 
 /***********************************************************************
- *		USER_SetWindowPos
+ *		add_erase_window
  *
- *     User32 internal function
+ * Add a window to the list of windows to erase, unless it's already in it.
  */
-BOOL USER_SetWindowPos( WINDOWPOS * winpos )
+static void add_erase_window( HWND hwnd, HWND *list, unsigned int *count )
+{
+    unsigned int i;
+
+    for (i = 0; i < *count; i++) if (list[i] == hwnd) return;
+    list[(*count)++] = hwnd;
+}
+
+
+/***********************************************************************
+ *		set_window_pos_erase
+ *
+ * Implementation of USER_SetWindowPos. If deferred is not NULL, the windows that
+ * need to be erased are added to it instead of being erased immediately.
+ */
+static BOOL set_window_pos_erase( WINDOWPOS *winpos, HWND *deferred, unsigned int *deferred_count )
 {
     RECT newWindowRect, newClientRect, valid_rects[2];
     UINT orig_flags;
+    HWND erase[2];
+    unsigned int i, erase_count = 0;
     
     orig_flags = winpos->flags;
 
@@ -2300,14 +2317,20 @@ BOOL USER_SetWindowPos( WINDOWPOS * winpos )
         {
             HWND parent = GetAncestor( winpos->hwnd, GA_PARENT );
             if (!parent || parent == GetDesktopWindow()) parent = winpos->hwnd;
-            erase_now( parent, 0 );
+            erase[erase_count++] = parent;
         }
 
         /* Give newly shown windows a chance to redraw */
         if(((winpos->flags & SWP_AGG_STATUSFLAGS) != SWP_AGG_NOPOSCHANGE)
                 && !(orig_flags & SWP_AGG_NOCLIENTCHANGE) && (orig_flags & SWP_SHOWWINDOW))
         {
-            erase_now(winpos->hwnd, 0);
+            erase[erase_count++] = winpos->hwnd;
+        }
+
+        for (i = 0; i < erase_count; i++)
+        {
+            if (deferred) add_erase_window( erase[i], deferred, deferred_count );
+            else erase_now( erase[i], 0 );
         }
     }
 
@@ -2330,6 +2353,17 @@ BOOL USER_SetWindowPos( WINDOWPOS * winpos )
     return TRUE;
 }
 
+
+/***********************************************************************
+ *		USER_SetWindowPos
+ *
+ *     User32 internal function
+ */
+BOOL USER_SetWindowPos( WINDOWPOS * winpos )
+{
+    return set_window_pos_erase( winpos, NULL, NULL );
+}
+
 /***********************************************************************
  *		SetWindowPos (USER32.@)
  */
@@ -2488,6 +2522,8 @@ BOOL WINAPI EndDeferWindowPos( HDWP hdwp )
 {
     DWP *pDWP;
     WINDOWPOS *winpos;
+    HWND *erase;
+    unsigned int erase_count = 0;
     int i;
 
     TRACE("%p\n", hdwp);
@@ -2499,6 +2535,10 @@ BOOL WINAPI EndDeferWindowPos( HDWP hdwp )
         return FALSE;
     }
 
+    /* erase the affected windows only once all the windows have been moved,
+     * instead of repainting the parent after every single child move */
+    erase = HeapAlloc( GetProcessHeap(), 0, 2 * pDWP->actualCount * sizeof(*erase) );
+
     for (i = 0, winpos = pDWP->winPos; i < pDWP->actualCount; i++, winpos++)
     {
         TRACE("hwnd %p, after %p, %d,%d (%dx%d), flags %08x\n",
@@ -2506,10 +2546,13 @@ BOOL WINAPI EndDeferWindowPos( HDWP hdwp )
                winpos->cx, winpos->cy, winpos->flags);
 
         if (WIN_IsCurrentThread( winpos->hwnd ))
-            USER_SetWindowPos( winpos );
+            set_window_pos_erase( winpos, erase, &erase_count );
         else
             SendMessageW( winpos->hwnd, WM_WINE_SETWINDOWPOS, 0, (LPARAM)winpos );
     }
+    for (i = 0; i < erase_count; i++) erase_now( erase[i], 0 );
+
+    HeapFree( GetProcessHeap(), 0, erase );
     HeapFree( GetProcessHeap(), 0, pDWP->winPos );
     HeapFree( GetProcessHeap(), 0, pDWP );
     return TRUE;
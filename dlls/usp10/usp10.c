@@ -861,6 +861,109 @@ static inline BOOL set_cache_glyph_widths(SCRIPT_CACHE *psc, WORD glyph, ABC *ab
     return TRUE;
 }
 
+/* Results of ScriptShapeOpenType() for a run, cached in the script cache
+ * since applications tend to reshape the same runs repeatedly. */
+#define MAX_SHAPED_RUNS 256
+#define MAX_SHAPED_RUN_CHARS 512
+
+struct shaped_run
+{
+    struct list entry;
+    SCRIPT_ANALYSIS sa;        /* analysis passed in */
+    SCRIPT_ANALYSIS out_sa;    /* analysis after shaping */
+    OPENTYPE_TAG script_tag;
+    OPENTYPE_TAG lang_tag;
+    int char_count;
+    int glyph_count;
+    WCHAR *chars;
+    WORD *log_clust;
+    SCRIPT_CHARPROP *char_props;
+    WORD *glyphs;
+    SCRIPT_GLYPHPROP *glyph_props;
+};
+
+static BOOL get_cache_shaped_run(ScriptCache *sc, SCRIPT_ANALYSIS *psa, OPENTYPE_TAG script_tag,
+        OPENTYPE_TAG lang_tag, const WCHAR *chars, int char_count, int max_glyphs, WORD *log_clust,
+        SCRIPT_CHARPROP *char_props, WORD *glyphs, SCRIPT_GLYPHPROP *glyph_props, int *glyph_count)
+{
+    struct shaped_run *run;
+    BOOL found = FALSE;
+
+    EnterCriticalSection(&cs_script_cache);
+    LIST_FOR_EACH_ENTRY(run, &sc->shaped_runs, struct shaped_run, entry)
+    {
+        if (run->char_count != char_count || run->script_tag != script_tag || run->lang_tag != lang_tag
+                || memcmp(&run->sa, psa, sizeof(*psa)) || memcmp(run->chars, chars, char_count * sizeof(*chars)))
+            continue;
+
+        if (run->glyph_count <= max_glyphs)
+        {
+            *psa = run->out_sa;
+            memcpy(log_clust, run->log_clust, char_count * sizeof(*log_clust));
+            memcpy(char_props, run->char_props, char_count * sizeof(*char_props));
+            memcpy(glyphs, run->glyphs, run->glyph_count * sizeof(*glyphs));
+            memcpy(glyph_props, run->glyph_props, run->glyph_count * sizeof(*glyph_props));
+            *glyph_count = run->glyph_count;
+            found = TRUE;
+        }
+        list_remove(&run->entry);
+        list_add_head(&sc->shaped_runs, &run->entry);
+        break;
+    }
+    LeaveCriticalSection(&cs_script_cache);
+
+    return found;
+}
+
+static void set_cache_shaped_run(ScriptCache *sc, const SCRIPT_ANALYSIS *sa, const SCRIPT_ANALYSIS *out_sa,
+        OPENTYPE_TAG script_tag, OPENTYPE_TAG lang_tag, const WCHAR *chars, int char_count, const WORD *log_clust,
+        const SCRIPT_CHARPROP *char_props, const WORD *glyphs, const SCRIPT_GLYPHPROP *glyph_props, int glyph_count)
+{
+    struct shaped_run *run;
+    BYTE *ptr;
+
+    if (char_count > MAX_SHAPED_RUN_CHARS)
+        return;
+
+    if (!(run = heap_alloc(sizeof(*run) + glyph_count * (sizeof(*glyphs) + sizeof(*glyph_props))
+            + char_count * (sizeof(*chars) + sizeof(*log_clust) + sizeof(*char_props)))))
+        return;
+
+    run->sa = *sa;
+    run->out_sa = *out_sa;
+    run->script_tag = script_tag;
+    run->lang_tag = lang_tag;
+    run->char_count = char_count;
+    run->glyph_count = glyph_count;
+
+    ptr = (BYTE *)(run + 1);
+    run->glyph_props = (SCRIPT_GLYPHPROP *)ptr;
+    memcpy(run->glyph_props, glyph_props, glyph_count * sizeof(*glyph_props));
+    ptr += glyph_count * sizeof(*glyph_props);
+    run->glyphs = (WORD *)ptr;
+    memcpy(run->glyphs, glyphs, glyph_count * sizeof(*glyphs));
+    ptr += glyph_count * sizeof(*glyphs);
+    run->log_clust = (WORD *)ptr;
+    memcpy(run->log_clust, log_clust, char_count * sizeof(*log_clust));
+    ptr += char_count * sizeof(*log_clust);
+    run->chars = (WCHAR *)ptr;
+    memcpy(run->chars, chars, char_count * sizeof(*chars));
+    ptr += char_count * sizeof(*chars);
+    run->char_props = (SCRIPT_CHARPROP *)ptr;
+    memcpy(run->char_props, char_props, char_count * sizeof(*char_props));
+
+    EnterCriticalSection(&cs_script_cache);
+    list_add_head(&sc->shaped_runs, &run->entry);
+    if (++sc->shaped_run_count > MAX_SHAPED_RUNS)
+    {
+        struct shaped_run *oldest = LIST_ENTRY(list_tail(&sc->shaped_runs), struct shaped_run, entry);
+        list_remove(&oldest->entry);
+        heap_free(oldest);
+        sc->shaped_run_count--;
+    }
+    LeaveCriticalSection(&cs_script_cache);
+}
+
 static HRESULT init_script_cache(const HDC hdc, SCRIPT_CACHE *psc)
 {
     ScriptCache *sc;
@@ -913,6 +1016,7 @@ static HRESULT init_script_cache(const HDC hdc, SCRIPT_CACHE *psc)
     }
     sc->lf = lf;
     sc->refcount = 1;
+    list_init(&sc->shaped_runs);
     *psc = sc;
 
     EnterCriticalSection(&cs_script_cache);
@@ -1081,6 +1185,7 @@ HRESULT WINAPI ScriptFreeCache(SCRIPT_CACHE *psc)
 
     if (psc && *psc)
     {
+        struct shaped_run *run, *next_run;
         unsigned int i;
         INT n;
 
@@ -1094,6 +1199,8 @@ HRESULT WINAPI ScriptFreeCache(SCRIPT_CACHE *psc)
         list_remove(&((ScriptCache *)*psc)->entry);
         LeaveCriticalSection(&cs_script_cache);
 
+        LIST_FOR_EACH_ENTRY_SAFE(run, next_run, &((ScriptCache *)*psc)->shaped_runs, struct shaped_run, entry)
+            heap_free(run);
         for (i = 0; i < GLYPH_MAX / GLYPH_BLOCK_SIZE; i++)
         {
             heap_free(((ScriptCache *)*psc)->widths[i]);
@@ -3180,9 +3287,14 @@ HRESULT WINAPI ScriptShapeOpenType( HDC hdc, SCRIPT_CACHE *psc,
 
     if (psa && !psa->fNoGlyphIndex && ((ScriptCache *)*psc)->sfnt)
     {
+        SCRIPT_ANALYSIS sa = *psa;
         WCHAR *rChars;
         if ((hr = SHAPE_CheckFontForRequiredFeatures(hdc, (ScriptCache *)*psc, psa)) != S_OK) return hr;
 
+        if (get_cache_shaped_run((ScriptCache *)*psc, psa, tagScript, tagLangSys, pwcChars, cChars, cMaxGlyphs,
+                pwLogClust, pCharProps, pwOutGlyphs, pOutGlyphProps, pcGlyphs))
+            return S_OK;
+
         if (!(rChars = heap_calloc(cChars, sizeof(*rChars))))
             return E_OUTOFMEMORY;
 
@@ -3255,6 +3367,9 @@ HRESULT WINAPI ScriptShapeOpenType( HDC hdc, SCRIPT_CACHE *psc,
             }
         }
         heap_free(rChars);
+
+        set_cache_shaped_run((ScriptCache *)*psc, &sa, psa, tagScript, tagLangSys, pwcChars, cChars,
+                pwLogClust, pCharProps, pwOutGlyphs, pOutGlyphProps, *pcGlyphs);
     }
     else
     {
@@ -63,6 +63,7 @@ typedef struct {
     function_t *func;
     function_t *funcs;
     function_decl_t *func_decls;
+    ident_ref_t *func_idents;
 
     class_desc_t *classes;
 } compile_ctx_t;
@@ -97,6 +98,9 @@ static void dump_instr_arg(instr_arg_type_t type, instr_arg_t *arg)
     case ARG_DOUBLE:
         TRACE_(vbscript_disas)("\t%lf", *arg->dbl);
         break;
+    case ARG_IDENT:
+        TRACE_(vbscript_disas)("\t%s", debugstr_w(arg->ident->name));
+        break;
     case ARG_NONE:
         break;
     DEFAULT_UNREACHABLE;
@@ -299,13 +303,52 @@ static HRESULT push_instr_bstr_uint(compile_ctx_t *ctx, vbsop_t op, const WCHAR
     return S_OK;
 }
 
-static HRESULT push_instr_uint_bstr(compile_ctx_t *ctx, vbsop_t op, unsigned arg1, const WCHAR *arg2)
+static ident_ref_t *alloc_ident_ref(compile_ctx_t *ctx, const WCHAR *name)
 {
+    ident_ref_t *ident;
+
+    ident = compiler_alloc(ctx->code, sizeof(*ident));
+    if(!ident)
+        return NULL;
+
+    memset(ident, 0, sizeof(*ident));
+    ident->name = alloc_bstr_arg(ctx, name);
+    if(!ident->name)
+        return NULL;
+
+    ident->bind = IDENT_UNBOUND;
+
+    /* bound in compile_func once all local declarations are known */
+    ident->next = ctx->func_idents;
+    ctx->func_idents = ident;
+    return ident;
+}
+
+static HRESULT push_instr_ident_uint(compile_ctx_t *ctx, vbsop_t op, const WCHAR *arg1, unsigned arg2)
+{
+    ident_ref_t *ident;
     unsigned instr;
-    BSTR bstr;
 
-    bstr = alloc_bstr_arg(ctx, arg2);
-    if(!bstr)
+    ident = alloc_ident_ref(ctx, arg1);
+    if(!ident)
+        return E_OUTOFMEMORY;
+
+    instr = push_instr(ctx, op);
+    if(!instr)
+        return E_OUTOFMEMORY;
+
+    instr_ptr(ctx, instr)->arg1.ident = ident;
+    instr_ptr(ctx, instr)->arg2.uint = arg2;
+    return S_OK;
+}
+
+static HRESULT push_instr_uint_ident(compile_ctx_t *ctx, vbsop_t op, unsigned arg1, const WCHAR *arg2)
+{
+    ident_ref_t *ident;
+    unsigned instr;
+
+    ident = alloc_ident_ref(ctx, arg2);
+    if(!ident)
         return E_OUTOFMEMORY;
 
     instr = push_instr(ctx, op);
@@ -313,7 +356,7 @@ static HRESULT push_instr_uint_bstr(compile_ctx_t *ctx, vbsop_t op, unsigned arg
         return E_OUTOFMEMORY;
 
     instr_ptr(ctx, instr)->arg1.uint = arg1;
-    instr_ptr(ctx, instr)->arg2.bstr = bstr;
+    instr_ptr(ctx, instr)->arg2.ident = ident;
     return S_OK;
 }
 
@@ -437,7 +480,7 @@ static HRESULT compile_member_expression(compile_ctx_t *ctx, member_expression_t
 
         hres = push_instr_bstr_uint(ctx, ret_val ? OP_mcall : OP_mcallv, expr->identifier, arg_cnt);
     }else {
-        hres = push_instr_bstr_uint(ctx, ret_val ? OP_icall : OP_icallv, expr->identifier, arg_cnt);
+        hres = push_instr_ident_uint(ctx, ret_val ? OP_icall : OP_icallv, expr->identifier, arg_cnt);
     }
 
     return hres;
@@ -719,7 +762,7 @@ static HRESULT compile_foreach_statement(compile_ctx_t *ctx, foreach_statement_t
     if(!(loop_ctx.for_end_label = alloc_label(ctx)))
         return E_OUTOFMEMORY;
 
-    hres = push_instr_uint_bstr(ctx, OP_enumnext, loop_ctx.for_end_label, stat->identifier);
+    hres = push_instr_uint_ident(ctx, OP_enumnext, loop_ctx.for_end_label, stat->identifier);
     if(FAILED(hres))
         return hres;
 
@@ -732,7 +775,7 @@ static HRESULT compile_foreach_statement(compile_ctx_t *ctx, foreach_statement_t
         return hres;
 
     /* We need a separated enumnext here, because we need to jump out of the loop on exception. */
-    hres = push_instr_uint_bstr(ctx, OP_enumnext, loop_ctx.for_end_label, stat->identifier);
+    hres = push_instr_uint_ident(ctx, OP_enumnext, loop_ctx.for_end_label, stat->identifier);
     if(FAILED(hres))
         return hres;
 
@@ -748,10 +791,10 @@ static HRESULT compile_forto_statement(compile_ctx_t *ctx, forto_statement_t *st
 {
     statement_ctx_t loop_ctx = {2};
     unsigned step_instr, instr;
-    BSTR identifier;
+    ident_ref_t *identifier;
     HRESULT hres;
 
-    identifier = alloc_bstr_arg(ctx, stat->identifier);
+    identifier = alloc_ident_ref(ctx, stat->identifier);
     if(!identifier)
         return E_OUTOFMEMORY;
 
@@ -763,7 +806,7 @@ static HRESULT compile_forto_statement(compile_ctx_t *ctx, forto_statement_t *st
     instr = push_instr(ctx, OP_assign_ident);
     if(!instr)
         return E_OUTOFMEMORY;
-    instr_ptr(ctx, instr)->arg1.bstr = identifier;
+    instr_ptr(ctx, instr)->arg1.ident = identifier;
     instr_ptr(ctx, instr)->arg2.uint = 0;
 
     hres = compile_expression(ctx, stat->to_expr);
@@ -793,7 +836,7 @@ static HRESULT compile_forto_statement(compile_ctx_t *ctx, forto_statement_t *st
     step_instr = push_instr(ctx, OP_step);
     if(!step_instr)
         return E_OUTOFMEMORY;
-    instr_ptr(ctx, step_instr)->arg2.bstr = identifier;
+    instr_ptr(ctx, step_instr)->arg2.ident = identifier;
     instr_ptr(ctx, step_instr)->arg1.uint = loop_ctx.for_end_label;
 
     if(!emit_catch(ctx, 2))
@@ -807,7 +850,7 @@ static HRESULT compile_forto_statement(compile_ctx_t *ctx, forto_statement_t *st
     instr = push_instr(ctx, OP_incc);
     if(!instr)
         return E_OUTOFMEMORY;
-    instr_ptr(ctx, instr)->arg1.bstr = identifier;
+    instr_ptr(ctx, instr)->arg1.ident = identifier;
 
     hres = push_instr_addr(ctx, OP_jmp, step_instr);
     if(FAILED(hres))
@@ -945,7 +988,10 @@ static HRESULT compile_assignment(compile_ctx_t *ctx, member_expression_t *membe
     if(FAILED(hres))
         return hres;
 
-    hres = push_instr_bstr_uint(ctx, op, member_expr->identifier, args_cnt);
+    if(member_expr->obj_expr)
+        hres = push_instr_bstr_uint(ctx, op, member_expr->identifier, args_cnt);
+    else
+        hres = push_instr_ident_uint(ctx, op, member_expr->identifier, args_cnt);
     if(FAILED(hres))
         return hres;
 
@@ -1324,6 +1370,41 @@ static HRESULT fill_array_desc(compile_ctx_t *ctx, dim_decl_t *dim_decl, array_d
     return S_OK;
 }
 
+static void bind_ident_refs(compile_ctx_t *ctx, function_t *func)
+{
+    ident_ref_t *ident;
+    unsigned i;
+
+    for(ident = ctx->func_idents; ident; ident = ident->next) {
+        ident->is_retval = (func->type == FUNC_FUNCTION || func->type == FUNC_PROPGET || func->type == FUNC_DEFGET)
+            && !strcmpiW(ident->name, func->name);
+
+        /* Globals may be redefined by later scripts, only locals are bound here. */
+        if(func->type == FUNC_GLOBAL)
+            continue;
+
+        for(i=0; i < func->var_cnt; i++) {
+            if(!strcmpiW(func->vars[i].name, ident->name)) {
+                ident->bind = IDENT_VAR;
+                ident->idx = i;
+                break;
+            }
+        }
+        if(ident->bind != IDENT_UNBOUND)
+            continue;
+
+        for(i=0; i < func->arg_cnt; i++) {
+            if(!strcmpiW(func->args[i].name, ident->name)) {
+                ident->bind = IDENT_ARG;
+                ident->idx = i;
+                break;
+            }
+        }
+    }
+
+    ctx->func_idents = NULL;
+}
+
 static HRESULT compile_func(compile_ctx_t *ctx, statement_t *stat, function_t *func)
 {
     HRESULT hres;
@@ -1360,6 +1441,7 @@ static HRESULT compile_func(compile_ctx_t *ctx, statement_t *stat, function_t *f
     ctx->func = func;
     ctx->dim_decls = ctx->dim_decls_tail = NULL;
     ctx->const_decls = NULL;
+    ctx->func_idents = NULL;
     hres = compile_statement(ctx, NULL, stat);
     ctx->func = NULL;
     if(FAILED(hres))
@@ -1417,6 +1499,8 @@ static HRESULT compile_func(compile_ctx_t *ctx, statement_t *stat, function_t *f
         }
     }
 
+    bind_ident_refs(ctx, func);
+
     if(func->array_cnt) {
         unsigned array_id = 0;
         dim_decl_t *dim_decl;
@@ -1886,6 +1970,9 @@ HRESULT compile_script(script_ctx_t *script, const WCHAR *src, const WCHAR *deli
         script->classes = ctx.classes;
     }
 
+    /* New global names may shadow previously cached identifier lookups. */
+    script->ident_gen++;
+
     if(TRACE_ON(vbscript_disas))
         dump_code(&ctx);
 
@@ -52,28 +52,6 @@ typedef struct {
 
 typedef HRESULT (*instr_func_t)(exec_ctx_t*);
 
-typedef enum {
-    REF_NONE,
-    REF_DISP,
-    REF_VAR,
-    REF_OBJ,
-    REF_CONST,
-    REF_FUNC
-} ref_type_t;
-
-typedef struct {
-    ref_type_t type;
-    union {
-        struct {
-            IDispatch *disp;
-            DISPID id;
-        } d;
-        VARIANT *v;
-        function_t *f;
-        IDispatch *obj;
-    } u;
-} ref_t;
-
 typedef struct {
     VARIANT *v;
     VARIANT store;
@@ -212,6 +190,68 @@ static HRESULT lookup_identifier(exec_ctx_t *ctx, BSTR name, vbdisp_invoke_type_
     return S_OK;
 }
 
+static BOOL can_cache_ident(exec_ctx_t *ctx)
+{
+    if(ctx->func->code_ctx->context)
+        return FALSE;
+    if(ctx->func->type == FUNC_GLOBAL)
+        return TRUE;
+
+    /* Local dynamic variables and the host global object are searched before global names. */
+    return !ctx->dynamic_vars && (ctx->vbthis || !ctx->script->host_global);
+}
+
+static HRESULT lookup_ident_ref(exec_ctx_t *ctx, ident_ref_t *ident, vbdisp_invoke_type_t invoke_type, ref_t *ref)
+{
+    const class_desc_t *desc = ctx->vbthis ? ctx->vbthis->desc : NULL;
+    BOOL cacheable;
+    HRESULT hres;
+
+    if(invoke_type == VBDISP_LET && ident->is_retval) {
+        ref->type = REF_VAR;
+        ref->u.v = &ctx->ret_val;
+        return S_OK;
+    }
+
+    switch(ident->bind) {
+    case IDENT_VAR:
+        ref->type = REF_VAR;
+        ref->u.v = ctx->vars + ident->idx;
+        return S_OK;
+    case IDENT_ARG:
+        ref->type = REF_VAR;
+        ref->u.v = ctx->args + ident->idx;
+        return S_OK;
+    case IDENT_UNBOUND:
+        break;
+    }
+
+    cacheable = can_cache_ident(ctx);
+    if(cacheable && ident->cache_gen == ctx->script->ident_gen
+            && ident->cache_invoke_type == invoke_type && ident->cache_desc == desc) {
+        *ref = ident->cache;
+        return S_OK;
+    }
+
+    hres = lookup_identifier(ctx, ident->name, invoke_type, ref);
+    if(FAILED(hres) || !cacheable || ref->type == REF_NONE)
+        return hres;
+
+    /* Members of this object instance can't be reused by other instances. */
+    if(ctx->vbthis) {
+        if(ref->type == REF_VAR && ref->u.v >= ctx->vbthis->props && ref->u.v < ctx->vbthis->props + desc->prop_cnt)
+            return S_OK;
+        if(ref->type == REF_DISP && ref->u.d.disp == ctx->this_obj)
+            return S_OK;
+    }
+
+    ident->cache_gen = ctx->script->ident_gen;
+    ident->cache_invoke_type = invoke_type;
+    ident->cache_desc = desc;
+    ident->cache = *ref;
+    return S_OK;
+}
+
 static HRESULT add_dynamic_var(exec_ctx_t *ctx, const WCHAR *name,
         BOOL is_const, VARIANT **out_var)
 {
@@ -238,6 +278,7 @@ static HRESULT add_dynamic_var(exec_ctx_t *ctx, const WCHAR *name,
     if(ctx->func->type == FUNC_GLOBAL) {
         new_var->next = ctx->script->global_vars;
         ctx->script->global_vars = new_var;
+        ctx->script->ident_gen++;
     }else {
         new_var->next = ctx->dynamic_vars;
         ctx->dynamic_vars = new_var;
@@ -516,13 +557,14 @@ static HRESULT array_access(exec_ctx_t *ctx, SAFEARRAY *array, DISPPARAMS *dp, V
 
 static HRESULT do_icall(exec_ctx_t *ctx, VARIANT *res)
 {
-    BSTR identifier = ctx->instr->arg1.bstr;
+    ident_ref_t *ident = ctx->instr->arg1.ident;
+    BSTR identifier = ident->name;
     const unsigned arg_cnt = ctx->instr->arg2.uint;
     DISPPARAMS dp;
     ref_t ref;
     HRESULT hres;
 
-    hres = lookup_identifier(ctx, identifier, VBDISP_CALLGET, &ref);
+    hres = lookup_ident_ref(ctx, ident, VBDISP_CALLGET, &ref);
     if(FAILED(hres))
         return hres;
 
@@ -708,12 +750,13 @@ static HRESULT assign_value(exec_ctx_t *ctx, VARIANT *dst, VARIANT *src, WORD fl
     return S_OK;
 }
 
-static HRESULT assign_ident(exec_ctx_t *ctx, BSTR name, WORD flags, DISPPARAMS *dp)
+static HRESULT assign_ident(exec_ctx_t *ctx, ident_ref_t *ident, WORD flags, DISPPARAMS *dp)
 {
+    BSTR name = ident->name;
     ref_t ref;
     HRESULT hres;
 
-    hres = lookup_identifier(ctx, name, VBDISP_LET, &ref);
+    hres = lookup_ident_ref(ctx, ident, VBDISP_LET, &ref);
     if(FAILED(hres))
         return hres;
 
@@ -796,12 +839,12 @@ static HRESULT assign_ident(exec_ctx_t *ctx, BSTR name, WORD flags, DISPPARAMS *
 
 static HRESULT interp_assign_ident(exec_ctx_t *ctx)
 {
-    const BSTR arg = ctx->instr->arg1.bstr;
+    ident_ref_t *arg = ctx->instr->arg1.ident;
     const unsigned arg_cnt = ctx->instr->arg2.uint;
     DISPPARAMS dp;
     HRESULT hres;
 
-    TRACE("%s\n", debugstr_w(arg));
+    TRACE("%s\n", debugstr_w(arg->name));
 
     vbstack_to_dp(ctx, arg_cnt, TRUE, &dp);
     hres = assign_ident(ctx, arg, DISPATCH_PROPERTYPUT, &dp);
@@ -814,12 +857,12 @@ static HRESULT interp_assign_ident(exec_ctx_t *ctx)
 
 static HRESULT interp_set_ident(exec_ctx_t *ctx)
 {
-    const BSTR arg = ctx->instr->arg1.bstr;
+    ident_ref_t *arg = ctx->instr->arg1.ident;
     const unsigned arg_cnt = ctx->instr->arg2.uint;
     DISPPARAMS dp;
     HRESULT hres;
 
-    TRACE("%s\n", debugstr_w(arg));
+    TRACE("%s\n", debugstr_w(arg->name));
 
     if(arg_cnt) {
         FIXME("arguments not supported\n");
@@ -831,7 +874,7 @@ static HRESULT interp_set_ident(exec_ctx_t *ctx)
         return hres;
 
     vbstack_to_dp(ctx, 0, TRUE, &dp);
-    hres = assign_ident(ctx, ctx->instr->arg1.bstr, DISPATCH_PROPERTYPUTREF, &dp);
+    hres = assign_ident(ctx, arg, DISPATCH_PROPERTYPUTREF, &dp);
     if(FAILED(hres))
         return hres;
 
@@ -1062,13 +1105,13 @@ static HRESULT interp_dim(exec_ctx_t *ctx)
 
 static HRESULT interp_step(exec_ctx_t *ctx)
 {
-    const BSTR ident = ctx->instr->arg2.bstr;
+    ident_ref_t *ident = ctx->instr->arg2.ident;
     BOOL gteq_zero;
     VARIANT zero;
     ref_t ref;
     HRESULT hres;
 
-    TRACE("%s\n", debugstr_w(ident));
+    TRACE("%s\n", debugstr_w(ident->name));
 
     V_VT(&zero) = VT_I2;
     V_I2(&zero) = 0;
@@ -1078,12 +1121,12 @@ static HRESULT interp_step(exec_ctx_t *ctx)
 
     gteq_zero = hres == VARCMP_GT || hres == VARCMP_EQ;
 
-    hres = lookup_identifier(ctx, ident, VBDISP_ANY, &ref);
+    hres = lookup_ident_ref(ctx, ident, VBDISP_ANY, &ref);
     if(FAILED(hres))
         return hres;
 
     if(ref.type != REF_VAR) {
-        FIXME("%s is not REF_VAR\n", debugstr_w(ident));
+        FIXME("%s is not REF_VAR\n", debugstr_w(ident->name));
         return E_FAIL;
     }
 
@@ -1165,7 +1208,7 @@ static HRESULT interp_newenum(exec_ctx_t *ctx)
 static HRESULT interp_enumnext(exec_ctx_t *ctx)
 {
     const unsigned loop_end = ctx->instr->arg1.uint;
-    const BSTR ident = ctx->instr->arg2.bstr;
+    ident_ref_t *ident = ctx->instr->arg2.ident;
     VARIANT v;
     DISPPARAMS dp = {&v, &propput_dispid, 1, 1};
     IEnumVARIANT *iter;
@@ -1976,14 +2019,14 @@ static HRESULT interp_neg(exec_ctx_t *ctx)
 
 static HRESULT interp_incc(exec_ctx_t *ctx)
 {
-    const BSTR ident = ctx->instr->arg1.bstr;
+    ident_ref_t *ident = ctx->instr->arg1.ident;
     VARIANT v;
     ref_t ref;
     HRESULT hres;
 
     TRACE("\n");
 
-    hres = lookup_identifier(ctx, ident, VBDISP_LET, &ref);
+    hres = lookup_ident_ref(ctx, ident, VBDISP_LET, &ref);
     if(FAILED(hres))
         return hres;
 
@@ -153,6 +153,7 @@ static void release_script(script_ctx_t *ctx)
 
     release_dynamic_vars(ctx->global_vars);
     ctx->global_vars = NULL;
+    ctx->ident_gen++;
 
     while(!list_empty(&ctx->named_items)) {
         named_item_t *iter = LIST_ENTRY(list_head(&ctx->named_items), named_item_t, entry);
@@ -476,6 +477,7 @@ static HRESULT WINAPI VBScript_AddNamedItem(IActiveScript *iface, LPCOLESTR pstr
     }
 
     list_add_tail(&This->ctx->named_items, &item->entry);
+    This->ctx->ident_gen++;
     return S_OK;
 }
 
@@ -606,6 +608,7 @@ static HRESULT WINAPI VBScriptParse_InitNew(IActiveScriptParse *iface)
     list_init(&ctx->objects);
     list_init(&ctx->code_list);
     list_init(&ctx->named_items);
+    ctx->ident_gen = 1;
 
     old_ctx = InterlockedCompareExchangePointer((void**)&This->ctx, ctx, NULL);
     if(old_ctx) {
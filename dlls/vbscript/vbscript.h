@@ -50,6 +50,7 @@ heap_pool_t *heap_pool_mark(heap_pool_t*) DECLSPEC_HIDDEN;
 
 typedef struct _function_t function_t;
 typedef struct _vbscode_t vbscode_t;
+typedef struct _ident_ref_t ident_ref_t;
 typedef struct _script_ctx_t script_ctx_t;
 typedef struct _vbdisp_t vbdisp_t;
 
@@ -193,6 +194,9 @@ struct _script_ctx_t {
 
     HRESULT err_number;
 
+    /* bumped whenever a new global name may change identifier resolution */
+    unsigned ident_gen;
+
     dynamic_var_t *global_vars;
     function_t *global_funcs;
     class_desc_t *classes;
@@ -217,13 +221,14 @@ typedef enum {
     ARG_INT,
     ARG_UINT,
     ARG_ADDR,
-    ARG_DOUBLE
+    ARG_DOUBLE,
+    ARG_IDENT
 } instr_arg_type_t;
 
 #define OP_LIST                                   \
     X(add,            1, 0,           0)          \
     X(and,            1, 0,           0)          \
-    X(assign_ident,   1, ARG_BSTR,    ARG_UINT)   \
+    X(assign_ident,   1, ARG_IDENT,   ARG_UINT)   \
     X(assign_member,  1, ARG_BSTR,    ARG_UINT)   \
     X(bool,           1, ARG_INT,     0)          \
     X(catch,          1, ARG_ADDR,    ARG_UINT)    \
@@ -234,7 +239,7 @@ typedef enum {
     X(div,            1, 0,           0)          \
     X(double,         1, ARG_DOUBLE,  0)          \
     X(empty,          1, 0,           0)          \
-    X(enumnext,       0, ARG_ADDR,    ARG_BSTR)   \
+    X(enumnext,       0, ARG_ADDR,    ARG_IDENT)  \
     X(equal,          1, 0,           0)          \
     X(hres,           1, ARG_UINT,    0)          \
     X(errmode,        1, ARG_INT,     0)          \
@@ -242,11 +247,11 @@ typedef enum {
     X(exp,            1, 0,           0)          \
     X(gt,             1, 0,           0)          \
     X(gteq,           1, 0,           0)          \
-    X(icall,          1, ARG_BSTR,    ARG_UINT)   \
-    X(icallv,         1, ARG_BSTR,    ARG_UINT)   \
+    X(icall,          1, ARG_IDENT,   ARG_UINT)   \
+    X(icallv,         1, ARG_IDENT,   ARG_UINT)   \
     X(idiv,           1, 0,           0)          \
     X(imp,            1, 0,           0)          \
-    X(incc,           1, ARG_BSTR,    0)          \
+    X(incc,           1, ARG_IDENT,   0)          \
     X(is,             1, 0,           0)          \
     X(jmp,            0, ARG_ADDR,    0)          \
     X(jmp_false,      0, ARG_ADDR,    0)          \
@@ -269,10 +274,10 @@ typedef enum {
     X(or,             1, 0,           0)          \
     X(pop,            1, ARG_UINT,    0)          \
     X(ret,            0, 0,           0)          \
-    X(set_ident,      1, ARG_BSTR,    ARG_UINT)   \
+    X(set_ident,      1, ARG_IDENT,   ARG_UINT)   \
     X(set_member,     1, ARG_BSTR,    ARG_UINT)   \
     X(short,          1, ARG_INT,     0)          \
-    X(step,           0, ARG_ADDR,    ARG_BSTR)   \
+    X(step,           0, ARG_ADDR,    ARG_IDENT)  \
     X(stop,           1, 0,           0)          \
     X(string,         1, ARG_STR,     0)          \
     X(sub,            1, 0,           0)          \
@@ -292,6 +297,7 @@ typedef union {
     unsigned uint;
     LONG lng;
     double *dbl;
+    ident_ref_t *ident;
 } instr_arg_t;
 
 typedef struct {
@@ -334,6 +340,50 @@ struct _function_t {
     function_t *next;
 };
 
+typedef enum {
+    REF_NONE,
+    REF_DISP,
+    REF_VAR,
+    REF_OBJ,
+    REF_CONST,
+    REF_FUNC
+} ref_type_t;
+
+typedef struct {
+    ref_type_t type;
+    union {
+        struct {
+            IDispatch *disp;
+            DISPID id;
+        } d;
+        VARIANT *v;
+        function_t *f;
+        IDispatch *obj;
+    } u;
+} ref_t;
+
+typedef enum {
+    IDENT_UNBOUND,
+    IDENT_VAR,
+    IDENT_ARG
+} ident_bind_t;
+
+/* Identifier referenced by an instruction. Locals are bound by the compiler,
+ * other names remember their last resolution until ident_gen changes. */
+struct _ident_ref_t {
+    BSTR name;
+    ident_bind_t bind;
+    unsigned idx;
+    BOOL is_retval;
+
+    unsigned cache_gen;
+    vbdisp_invoke_type_t cache_invoke_type;
+    const class_desc_t *cache_desc;
+    ref_t cache;
+
+    ident_ref_t *next;
+};
+
 struct _vbscode_t {
     instr_t *instrs;
     WCHAR *source;
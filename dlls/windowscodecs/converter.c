@@ -93,6 +93,42 @@ static inline float to_sRGB_component(float f)
     return 1.055f * powf(f, 1.0f/2.4f) - 0.055f;
 }
 
+static inline BYTE linear_to_sRGB_byte(float f)
+{
+    return (BYTE)floorf(to_sRGB_component(f) * 255.0f + 0.51f);
+}
+
+/* srgb_thresholds[i] is the smallest linear value converted to sRGB byte i,
+ * it allows replacing the powf() call with a binary search */
+static float srgb_thresholds[256];
+static INIT_ONCE srgb_init_once = INIT_ONCE_STATIC_INIT;
+
+static BOOL WINAPI init_srgb_thresholds(INIT_ONCE *once, void *param, void **context)
+{
+    int i;
+
+    srgb_thresholds[0] = -INFINITY;
+    for (i = 1; i < 256; i++)
+    {
+        float f = from_sRGB_component((i - 0.51f) / 255.0f);
+
+        /* adjust to the exact boundary of the floating point computation */
+        while (linear_to_sRGB_byte(f) >= i) f = nextafterf(f, -INFINITY);
+        while (linear_to_sRGB_byte(f) < i) f = nextafterf(f, INFINITY);
+        srgb_thresholds[i] = f;
+    }
+    return TRUE;
+}
+
+static inline BYTE to_sRGB_byte(float f)
+{
+    unsigned int i = 0, step;
+
+    for (step = 128; step; step >>= 1)
+        if (f >= srgb_thresholds[i + step]) i += step;
+    return i;
+}
+
 #if 0 /* FIXME: enable once needed */
 static void from_sRGB(BYTE *bgr)
 {
@@ -129,6 +165,20 @@ static void to_sRGB(BYTE *bgr)
 }
 #endif
 
+/* multiply two 8-bit channels stored in bits 0-7 and 16-23 by alpha / 255,
+ * rounding down like an integer division */
+static inline DWORD premultiply_pair(DWORD pair, DWORD alpha)
+{
+    DWORD t = pair * alpha;
+    return ((t + 0x00010001 + ((t >> 8) & 0x00ff00ff)) >> 8) & 0x00ff00ff;
+}
+
+/* value * 255 / alpha == (value * 255 * unpremultiply_factor(alpha)) >> 24 for all 8-bit values */
+static inline ULONGLONG unpremultiply_factor(BYTE alpha)
+{
+    return ((1u << 24) + alpha - 1) / alpha;
+}
+
 static inline FormatConverter *impl_from_IWICFormatConverter(IWICFormatConverter *iface)
 {
     return CONTAINING_RECORD(iface, FormatConverter, IWICFormatConverter_iface);
@@ -358,10 +408,7 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
                     srcbyte = srcrow;
                     dstpixel=(DWORD*)dstrow;
                     for (x=0; x<prc->Width; x++)
-                    {
-                        *dstpixel++ = 0xff000000|(*srcbyte<<16)|(*srcbyte<<8)|*srcbyte;
-                        srcbyte++;
-                    }
+                        *dstpixel++ = 0xff000000 | (*srcbyte++ * 0x010101);
                     srcrow += srcstride;
                     dstrow += cbStride;
                 }
@@ -454,7 +501,7 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
                     dstpixel=(DWORD*)dstrow;
                     for (x=0; x<prc->Width; x++)
                     {
-                        *dstpixel++ = 0xff000000|(*srcbyte<<16)|(*srcbyte<<8)|*srcbyte;
+                        *dstpixel++ = 0xff000000 | (*srcbyte * 0x010101);
                         srcbyte+=2;
                     }
                     srcrow += srcstride;
@@ -621,7 +668,7 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             const BYTE *srcrow;
             const BYTE *srcpixel;
             BYTE *dstrow;
-            BYTE *dstpixel;
+            DWORD *dstpixel;
 
             srcstride = 3 * prc->Width;
             srcdatasize = srcstride * prc->Height;
@@ -637,12 +684,10 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
                 dstrow = pbBuffer;
                 for (y=0; y<prc->Height; y++) {
                     srcpixel=srcrow;
-                    dstpixel=dstrow;
+                    dstpixel=(DWORD*)dstrow;
                     for (x=0; x<prc->Width; x++) {
-                        *dstpixel++=*srcpixel++; /* blue */
-                        *dstpixel++=*srcpixel++; /* green */
-                        *dstpixel++=*srcpixel++; /* red */
-                        *dstpixel++=255; /* alpha */
+                        *dstpixel++=0xff000000|srcpixel[2]<<16|srcpixel[1]<<8|srcpixel[0];
+                        srcpixel+=3;
                     }
                     srcrow += srcstride;
                     dstrow += cbStride;
@@ -664,8 +709,7 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             const BYTE *srcrow;
             const BYTE *srcpixel;
             BYTE *dstrow;
-            BYTE *dstpixel;
-            BYTE tmppixel[3];
+            DWORD *dstpixel;
 
             srcstride = 3 * prc->Width;
             srcdatasize = srcstride * prc->Height;
@@ -681,16 +725,10 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
                 dstrow = pbBuffer;
                 for (y=0; y<prc->Height; y++) {
                     srcpixel=srcrow;
-                    dstpixel=dstrow;
+                    dstpixel=(DWORD*)dstrow;
                     for (x=0; x<prc->Width; x++) {
-                        tmppixel[0]=*srcpixel++; /* red */
-                        tmppixel[1]=*srcpixel++; /* green */
-                        tmppixel[2]=*srcpixel++; /* blue */
-
-                        *dstpixel++=tmppixel[2]; /* blue */
-                        *dstpixel++=tmppixel[1]; /* green */
-                        *dstpixel++=tmppixel[0]; /* red */
-                        *dstpixel++=255; /* alpha */
+                        *dstpixel++=0xff000000|srcpixel[0]<<16|srcpixel[1]<<8|srcpixel[2];
+                        srcpixel+=3;
                     }
                     srcrow += srcstride;
                     dstrow += cbStride;
@@ -713,8 +751,11 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
 
             /* set all alpha values to 255 */
             for (y=0; y<prc->Height; y++)
+            {
+                DWORD *pixel = (DWORD *)(pbBuffer + cbStride * y);
                 for (x=0; x<prc->Width; x++)
-                    pbBuffer[cbStride*y+4*x+3] = 0xff;
+                    pixel[x] |= 0xff000000;
+            }
         }
         return S_OK;
     case format_32bppBGRA:
@@ -731,16 +772,20 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             if (FAILED(res)) return res;
 
             for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
+            {
+                BYTE *pixel = pbBuffer + cbStride * y;
+                for (x=0; x<prc->Width; x++, pixel += 4)
                 {
-                    BYTE alpha = pbBuffer[cbStride*y+4*x+3];
+                    BYTE alpha = pixel[3];
                     if (alpha != 0 && alpha != 255)
                     {
-                        pbBuffer[cbStride*y+4*x] = pbBuffer[cbStride*y+4*x] * 255 / alpha;
-                        pbBuffer[cbStride*y+4*x+1] = pbBuffer[cbStride*y+4*x+1] * 255 / alpha;
-                        pbBuffer[cbStride*y+4*x+2] = pbBuffer[cbStride*y+4*x+2] * 255 / alpha;
+                        ULONGLONG recip = unpremultiply_factor(alpha);
+                        pixel[0] = (pixel[0] * 255 * recip) >> 24;
+                        pixel[1] = (pixel[1] * 255 * recip) >> 24;
+                        pixel[2] = (pixel[2] * 255 * recip) >> 24;
                     }
                 }
+            }
         }
         return S_OK;
     case format_48bppRGB:
@@ -892,16 +937,16 @@ static HRESULT copypixels_to_32bppPBGRA(struct FormatConverter *This, const WICR
             INT x, y;
 
             for (y=0; y<prc->Height; y++)
+            {
+                DWORD *pixel = (DWORD *)(pbBuffer + cbStride * y);
                 for (x=0; x<prc->Width; x++)
                 {
-                    BYTE alpha = pbBuffer[cbStride*y+4*x+3];
+                    DWORD alpha = pixel[x] >> 24;
                     if (alpha != 255)
-                    {
-                        pbBuffer[cbStride*y+4*x] = pbBuffer[cbStride*y+4*x] * alpha / 255;
-                        pbBuffer[cbStride*y+4*x+1] = pbBuffer[cbStride*y+4*x+1] * alpha / 255;
-                        pbBuffer[cbStride*y+4*x+2] = pbBuffer[cbStride*y+4*x+2] * alpha / 255;
-                    }
+                        pixel[x] = (alpha << 24) | premultiply_pair(pixel[x] & 0x00ff00ff, alpha) |
+                                   (premultiply_pair((pixel[x] >> 8) & 0xff, alpha) << 8);
                 }
+            }
         }
         return hr;
     }
@@ -989,6 +1034,8 @@ static HRESULT copypixels_to_24bppBGR(struct FormatConverter *This, const WICRec
                 INT x, y;
                 BYTE *src = srcdata, *dst = pbBuffer;
 
+                InitOnceExecuteOnce(&srgb_init_once, init_srgb_thresholds, NULL, NULL);
+
                 for (y = 0; y < prc->Height; y++)
                 {
                     float *gray_float = (float *)src;
@@ -996,7 +1043,7 @@ static HRESULT copypixels_to_24bppBGR(struct FormatConverter *This, const WICRec
 
                     for (x = 0; x < prc->Width; x++)
                     {
-                        BYTE gray = (BYTE)floorf(to_sRGB_component(gray_float[x]) * 255.0f + 0.51f);
+                        BYTE gray = to_sRGB_byte(gray_float[x]);
                         *bgr++ = gray;
                         *bgr++ = gray;
                         *bgr++ = gray;
@@ -1167,13 +1214,15 @@ static HRESULT copypixels_to_8bppGray(struct FormatConverter *This, const WICRec
                 INT x, y;
                 BYTE *src = srcdata, *dst = pbBuffer;
 
+                InitOnceExecuteOnce(&srgb_init_once, init_srgb_thresholds, NULL, NULL);
+
                 for (y=0; y < prc->Height; y++)
                 {
                     float *srcpixel = (float*)src;
                     BYTE *dstpixel = dst;
 
                     for (x=0; x < prc->Width; x++)
-                        *dstpixel++ = (BYTE)floorf(to_sRGB_component(*srcpixel++) * 255.0f + 0.51f);
+                        *dstpixel++ = to_sRGB_byte(*srcpixel++);
 
                     src += srcstride;
                     dst += cbStride;
@@ -1198,6 +1247,8 @@ static HRESULT copypixels_to_8bppGray(struct FormatConverter *This, const WICRec
         INT x, y;
         BYTE *src = srcdata, *dst = pbBuffer;
 
+        InitOnceExecuteOnce(&srgb_init_once, init_srgb_thresholds, NULL, NULL);
+
         for (y = 0; y < prc->Height; y++)
         {
             BYTE *bgr = src;
@@ -1206,8 +1257,7 @@ static HRESULT copypixels_to_8bppGray(struct FormatConverter *This, const WICRec
             {
                 float gray = (bgr[2] * 0.2126f + bgr[1] * 0.7152f + bgr[0] * 0.0722f) / 255.0f;
 
-                gray = to_sRGB_component(gray) * 255.0f;
-                dst[x] = (BYTE)floorf(gray + 0.51f);
+                dst[x] = to_sRGB_byte(gray);
                 bgr += 3;
             }
             src += srcstride;
@@ -68,6 +68,7 @@ static const WCHAR wszJpegYCrCbSubsampling[] = {'J','p','e','g','Y','C','r','C',
 static const WCHAR wszSuppressApp0[] = {'S','u','p','p','r','e','s','s','A','p','p','0',0};
 
 #define MAKE_FUNCPTR(f) static typeof(f) * p##f
+MAKE_FUNCPTR(jpeg_abort_decompress);
 MAKE_FUNCPTR(jpeg_CreateCompress);
 MAKE_FUNCPTR(jpeg_CreateDecompress);
 MAKE_FUNCPTR(jpeg_destroy_compress);
@@ -93,6 +94,7 @@ static void *load_libjpeg(void)
         return NULL; \
     }
 
+        LOAD_FUNCPTR(jpeg_abort_decompress);
         LOAD_FUNCPTR(jpeg_CreateCompress);
         LOAD_FUNCPTR(jpeg_CreateDecompress);
         LOAD_FUNCPTR(jpeg_destroy_compress);
@@ -147,9 +149,12 @@ typedef struct {
     IWICBitmapDecoder IWICBitmapDecoder_iface;
     IWICBitmapFrameDecode IWICBitmapFrameDecode_iface;
     IWICMetadataBlockReader IWICMetadataBlockReader_iface;
+    IWICBitmapSourceTransform IWICBitmapSourceTransform_iface;
     LONG ref;
     BOOL initialized;
     BOOL cinfo_initialized;
+    UINT width, height; /* unscaled image size */
+    UINT scale_denom; /* DCT scaling of the current decompression */
     IStream *stream;
     struct jpeg_decompress_struct cinfo;
     struct jpeg_error_mgr jerr;
@@ -179,6 +184,11 @@ static inline JpegDecoder *impl_from_IWICMetadataBlockReader(IWICMetadataBlockRe
     return CONTAINING_RECORD(iface, JpegDecoder, IWICMetadataBlockReader_iface);
 }
 
+static inline JpegDecoder *impl_from_IWICBitmapSourceTransform(IWICBitmapSourceTransform *iface)
+{
+    return CONTAINING_RECORD(iface, JpegDecoder, IWICBitmapSourceTransform_iface);
+}
+
 static HRESULT WINAPI JpegDecoder_QueryInterface(IWICBitmapDecoder *iface, REFIID iid,
     void **ppv)
 {
@@ -381,6 +391,9 @@ static HRESULT WINAPI JpegDecoder_Initialize(IWICBitmapDecoder *iface, IStream *
         return E_FAIL;
     }
 
+    This->width = This->cinfo.output_width;
+    This->height = This->cinfo.output_height;
+    This->scale_denom = 1;
     This->initialized = TRUE;
 
     LeaveCriticalSection(&This->lock);
@@ -496,6 +509,10 @@ static HRESULT WINAPI JpegDecoder_Frame_QueryInterface(IWICBitmapFrameDecode *if
     {
         *ppv = &This->IWICBitmapFrameDecode_iface;
     }
+    else if (IsEqualIID(&IID_IWICBitmapSourceTransform, iid))
+    {
+        *ppv = &This->IWICBitmapSourceTransform_iface;
+    }
     else
     {
         *ppv = NULL;
@@ -522,8 +539,8 @@ static HRESULT WINAPI JpegDecoder_Frame_GetSize(IWICBitmapFrameDecode *iface,
     UINT *puiWidth, UINT *puiHeight)
 {
     JpegDecoder *This = impl_from_IWICBitmapFrameDecode(iface);
-    *puiWidth = This->cinfo.output_width;
-    *puiHeight = This->cinfo.output_height;
+    *puiWidth = This->width;
+    *puiHeight = This->height;
     TRACE("(%p)->(%u,%u)\n", iface, *puiWidth, *puiHeight);
     return S_OK;
 }
@@ -582,61 +599,63 @@ static HRESULT WINAPI JpegDecoder_Frame_CopyPalette(IWICBitmapFrameDecode *iface
     return E_NOTIMPL;
 }
 
-static HRESULT WINAPI JpegDecoder_Frame_CopyPixels(IWICBitmapFrameDecode *iface,
-    const WICRect *prc, UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
+static UINT get_output_bpp(JpegDecoder *This)
 {
-    JpegDecoder *This = impl_from_IWICBitmapFrameDecode(iface);
-    UINT bpp;
-    UINT stride;
-    UINT data_size;
-    UINT max_row_needed;
-    jmp_buf jmpbuf;
-    WICRect rect;
-    TRACE("(%p,%p,%u,%u,%p)\n", iface, prc, cbStride, cbBufferSize, pbBuffer);
+    if (This->cinfo.out_color_space == JCS_GRAYSCALE) return 8;
+    if (This->cinfo.out_color_space == JCS_CMYK) return 32;
+    return 24;
+}
 
-    if (!prc)
-    {
-        rect.X = 0;
-        rect.Y = 0;
-        rect.Width = This->cinfo.output_width;
-        rect.Height = This->cinfo.output_height;
-        prc = &rect;
-    }
-    else
-    {
-        if (prc->X < 0 || prc->Y < 0 || prc->X+prc->Width > This->cinfo.output_width ||
-            prc->Y+prc->Height > This->cinfo.output_height)
-            return E_INVALIDARG;
-    }
+/* Restart the decompression with the given DCT scaling factor, discarding
+ * the rows decoded so far.  Must be called with the lock held and a jump
+ * buffer set up. */
+static HRESULT restart_decompress(JpegDecoder *This, UINT scale_denom)
+{
+    J_COLOR_SPACE color_space = This->cinfo.out_color_space;
+    LARGE_INTEGER seek;
+    HRESULT hr;
 
-    if (This->cinfo.out_color_space == JCS_GRAYSCALE) bpp = 8;
-    else if (This->cinfo.out_color_space == JCS_CMYK) bpp = 32;
-    else bpp = 24;
+    if (This->scale_denom == scale_denom) return S_OK;
 
-    stride = (bpp * This->cinfo.output_width + 7) / 8;
-    data_size = stride * This->cinfo.output_height;
+    TRACE("(%p,%u)\n", This, scale_denom);
 
-    max_row_needed = prc->Y + prc->Height;
-    if (max_row_needed > This->cinfo.output_height) return E_INVALIDARG;
+    pjpeg_abort_decompress(&This->cinfo);
+    HeapFree(GetProcessHeap(), 0, This->image_data);
+    This->image_data = NULL;
+    This->scale_denom = 0;
 
-    EnterCriticalSection(&This->lock);
+    seek.QuadPart = 0;
+    hr = IStream_Seek(This->stream, seek, STREAM_SEEK_SET, NULL);
+    if (FAILED(hr)) return hr;
+    This->source_mgr.bytes_in_buffer = 0;
 
-    if (!This->image_data)
+    if (pjpeg_read_header(&This->cinfo, TRUE) != JPEG_HEADER_OK) return E_FAIL;
+
+    This->cinfo.out_color_space = color_space;
+    This->cinfo.scale_num = 1;
+    This->cinfo.scale_denom = scale_denom;
+
+    if (!pjpeg_start_decompress(&This->cinfo))
     {
-        This->image_data = HeapAlloc(GetProcessHeap(), 0, data_size);
-        if (!This->image_data)
-        {
-            LeaveCriticalSection(&This->lock);
-            return E_OUTOFMEMORY;
-        }
+        ERR("jpeg_start_decompress failed\n");
+        return E_FAIL;
     }
 
-    This->cinfo.client_data = jmpbuf;
+    This->scale_denom = scale_denom;
+    return S_OK;
+}
 
-    if (setjmp(jmpbuf))
+/* Decode the image up to the given row at the current scale.  Must be
+ * called with the lock held and a jump buffer set up. */
+static HRESULT decode_scanlines(JpegDecoder *This, UINT max_row_needed)
+{
+    UINT bpp = get_output_bpp(This);
+    UINT stride = (bpp * This->cinfo.output_width + 7) / 8;
+
+    if (!This->image_data)
     {
-        LeaveCriticalSection(&This->lock);
-        return E_FAIL;
+        This->image_data = HeapAlloc(GetProcessHeap(), 0, stride * This->cinfo.output_height);
+        if (!This->image_data) return E_OUTOFMEMORY;
     }
 
     while (max_row_needed > This->cinfo.output_scanline)
@@ -656,7 +675,6 @@ static HRESULT WINAPI JpegDecoder_Frame_CopyPixels(IWICBitmapFrameDecode *iface,
         if (ret == 0)
         {
             ERR("read_scanlines failed\n");
-            LeaveCriticalSection(&This->lock);
             return E_FAIL;
         }
 
@@ -680,11 +698,61 @@ static HRESULT WINAPI JpegDecoder_Frame_CopyPixels(IWICBitmapFrameDecode *iface,
 
     }
 
+    return S_OK;
+}
+
+static HRESULT WINAPI JpegDecoder_Frame_CopyPixels(IWICBitmapFrameDecode *iface,
+    const WICRect *prc, UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
+{
+    JpegDecoder *This = impl_from_IWICBitmapFrameDecode(iface);
+    UINT bpp;
+    UINT max_row_needed;
+    jmp_buf jmpbuf;
+    WICRect rect;
+    HRESULT hr;
+    TRACE("(%p,%p,%u,%u,%p)\n", iface, prc, cbStride, cbBufferSize, pbBuffer);
+
+    if (!prc)
+    {
+        rect.X = 0;
+        rect.Y = 0;
+        rect.Width = This->width;
+        rect.Height = This->height;
+        prc = &rect;
+    }
+    else
+    {
+        if (prc->X < 0 || prc->Y < 0 || prc->X+prc->Width > This->width ||
+            prc->Y+prc->Height > This->height)
+            return E_INVALIDARG;
+    }
+
+    bpp = get_output_bpp(This);
+
+    max_row_needed = prc->Y + prc->Height;
+    if (max_row_needed > This->height) return E_INVALIDARG;
+
+    EnterCriticalSection(&This->lock);
+
+    This->cinfo.client_data = jmpbuf;
+
+    if (setjmp(jmpbuf))
+    {
+        LeaveCriticalSection(&This->lock);
+        return E_FAIL;
+    }
+
+    hr = restart_decompress(This, 1);
+    if (SUCCEEDED(hr))
+        hr = decode_scanlines(This, max_row_needed);
+    if (SUCCEEDED(hr))
+        hr = copy_pixels(bpp, This->image_data,
+            This->width, This->height, (bpp * This->width + 7) / 8,
+            prc, cbStride, cbBufferSize, pbBuffer);
+
     LeaveCriticalSection(&This->lock);
 
-    return copy_pixels(bpp, This->image_data,
-        This->cinfo.output_width, This->cinfo.output_height, stride,
-        prc, cbStride, cbBufferSize, pbBuffer);
+    return hr;
 }
 
 static HRESULT WINAPI JpegDecoder_Frame_GetMetadataQueryReader(IWICBitmapFrameDecode *iface,
@@ -795,6 +863,161 @@ static const IWICMetadataBlockReaderVtbl JpegDecoder_Block_Vtbl = {
     JpegDecoder_Block_GetEnumerator,
 };
 
+static HRESULT WINAPI JpegDecoder_Transform_QueryInterface(IWICBitmapSourceTransform *iface, REFIID iid,
+    void **ppv)
+{
+    JpegDecoder *This = impl_from_IWICBitmapSourceTransform(iface);
+    return IWICBitmapFrameDecode_QueryInterface(&This->IWICBitmapFrameDecode_iface, iid, ppv);
+}
+
+static ULONG WINAPI JpegDecoder_Transform_AddRef(IWICBitmapSourceTransform *iface)
+{
+    JpegDecoder *This = impl_from_IWICBitmapSourceTransform(iface);
+    return IWICBitmapDecoder_AddRef(&This->IWICBitmapDecoder_iface);
+}
+
+static ULONG WINAPI JpegDecoder_Transform_Release(IWICBitmapSourceTransform *iface)
+{
+    JpegDecoder *This = impl_from_IWICBitmapSourceTransform(iface);
+    return IWICBitmapDecoder_Release(&This->IWICBitmapDecoder_iface);
+}
+
+/* libjpeg can scale by 1/2, 1/4 and 1/8 while decoding, at almost no cost */
+static const UINT jpeg_scale_denoms[] = { 8, 4, 2, 1 };
+
+static UINT get_scale_denom(JpegDecoder *This, UINT width, UINT height)
+{
+    UINT i, denom;
+
+    for (i = 0; i < ARRAY_SIZE(jpeg_scale_denoms); i++)
+    {
+        denom = jpeg_scale_denoms[i];
+        if (width == (This->width + denom - 1) / denom &&
+            height == (This->height + denom - 1) / denom)
+            return denom;
+    }
+
+    return 0;
+}
+
+static HRESULT WINAPI JpegDecoder_Transform_CopyPixels(IWICBitmapSourceTransform *iface,
+    const WICRect *prc, UINT width, UINT height, WICPixelFormatGUID *format,
+    WICBitmapTransformOptions transform, UINT stride, UINT size, BYTE *buffer)
+{
+    JpegDecoder *This = impl_from_IWICBitmapSourceTransform(iface);
+    WICPixelFormatGUID native_format;
+    UINT bpp, denom;
+    jmp_buf jmpbuf;
+    WICRect rect;
+    HRESULT hr;
+
+    TRACE("(%p,%p,%u,%u,%s,%u,%u,%u,%p)\n", iface, prc, width, height,
+          debugstr_guid(format), transform, stride, size, buffer);
+
+    if (transform != WICBitmapTransformRotate0)
+        return WINCODEC_ERR_UNSUPPORTEDOPERATION;
+
+    IWICBitmapFrameDecode_GetPixelFormat(&This->IWICBitmapFrameDecode_iface, &native_format);
+    if (format && !IsEqualGUID(format, &native_format))
+        return WINCODEC_ERR_UNSUPPORTEDPIXELFORMAT;
+
+    if (!(denom = get_scale_denom(This, width, height)))
+        return E_INVALIDARG;
+
+    if (!prc)
+    {
+        rect.X = 0;
+        rect.Y = 0;
+        rect.Width = width;
+        rect.Height = height;
+        prc = &rect;
+    }
+    else if (prc->X < 0 || prc->Y < 0 || prc->X+prc->Width > width || prc->Y+prc->Height > height)
+        return E_INVALIDARG;
+
+    bpp = get_output_bpp(This);
+
+    EnterCriticalSection(&This->lock);
+
+    This->cinfo.client_data = jmpbuf;
+
+    if (setjmp(jmpbuf))
+    {
+        LeaveCriticalSection(&This->lock);
+        return E_FAIL;
+    }
+
+    hr = restart_decompress(This, denom);
+    if (SUCCEEDED(hr))
+        hr = decode_scanlines(This, prc->Y + prc->Height);
+    if (SUCCEEDED(hr))
+        hr = copy_pixels(bpp, This->image_data, width, height, (bpp * width + 7) / 8,
+            prc, stride, size, buffer);
+
+    LeaveCriticalSection(&This->lock);
+
+    return hr;
+}
+
+static HRESULT WINAPI JpegDecoder_Transform_GetClosestSize(IWICBitmapSourceTransform *iface,
+    UINT *width, UINT *height)
+{
+    JpegDecoder *This = impl_from_IWICBitmapSourceTransform(iface);
+    UINT i, denom = 1;
+
+    TRACE("(%p,%p,%p)\n", iface, width, height);
+
+    if (!width || !height) return E_INVALIDARG;
+
+    /* pick the smallest size that is still at least as large as requested */
+    for (i = 0; i < ARRAY_SIZE(jpeg_scale_denoms); i++)
+    {
+        denom = jpeg_scale_denoms[i];
+        if ((This->width + denom - 1) / denom >= *width &&
+            (This->height + denom - 1) / denom >= *height)
+            break;
+    }
+
+    *width = (This->width + denom - 1) / denom;
+    *height = (This->height + denom - 1) / denom;
+
+    return S_OK;
+}
+
+static HRESULT WINAPI JpegDecoder_Transform_GetClosestPixelFormat(IWICBitmapSourceTransform *iface,
+    WICPixelFormatGUID *format)
+{
+    JpegDecoder *This = impl_from_IWICBitmapSourceTransform(iface);
+
+    TRACE("(%p,%p)\n", iface, format);
+
+    if (!format) return E_INVALIDARG;
+
+    return IWICBitmapFrameDecode_GetPixelFormat(&This->IWICBitmapFrameDecode_iface, format);
+}
+
+static HRESULT WINAPI JpegDecoder_Transform_DoesSupportTransform(IWICBitmapSourceTransform *iface,
+    WICBitmapTransformOptions transform, BOOL *supported)
+{
+    TRACE("(%p,%u,%p)\n", iface, transform, supported);
+
+    if (!supported) return E_INVALIDARG;
+
+    *supported = (transform == WICBitmapTransformRotate0);
+
+    return S_OK;
+}
+
+static const IWICBitmapSourceTransformVtbl JpegDecoder_Transform_Vtbl = {
+    JpegDecoder_Transform_QueryInterface,
+    JpegDecoder_Transform_AddRef,
+    JpegDecoder_Transform_Release,
+    JpegDecoder_Transform_CopyPixels,
+    JpegDecoder_Transform_GetClosestSize,
+    JpegDecoder_Transform_GetClosestPixelFormat,
+    JpegDecoder_Transform_DoesSupportTransform
+};
+
 HRESULT JpegDecoder_CreateInstance(REFIID iid, void** ppv)
 {
     JpegDecoder *This;
@@ -816,9 +1039,12 @@ HRESULT JpegDecoder_CreateInstance(REFIID iid, void** ppv)
     This->IWICBitmapDecoder_iface.lpVtbl = &JpegDecoder_Vtbl;
     This->IWICBitmapFrameDecode_iface.lpVtbl = &JpegDecoder_Frame_Vtbl;
     This->IWICMetadataBlockReader_iface.lpVtbl = &JpegDecoder_Block_Vtbl;
+    This->IWICBitmapSourceTransform_iface.lpVtbl = &JpegDecoder_Transform_Vtbl;
     This->ref = 1;
     This->initialized = FALSE;
     This->cinfo_initialized = FALSE;
+    This->width = This->height = 0;
+    This->scale_denom = 0;
     This->stream = NULL;
     This->image_data = NULL;
     InitializeCriticalSection(&This->lock);
@@ -19,6 +19,7 @@
 #include "config.h"
 
 #include <stdarg.h>
+#include <math.h>
 
 #define COBJMACROS
 
@@ -32,6 +33,15 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(wincodecs);
 
+#define FILTER_WEIGHT_BITS 14
+
+/* source pixels contributing to a destination pixel along one axis */
+struct filter_taps {
+    UINT start;
+    UINT count;
+    const INT *weights; /* FILTER_WEIGHT_BITS fixed point, summing to 1 */
+};
+
 typedef struct BitmapScaler {
     IWICBitmapScaler IWICBitmapScaler_iface;
     LONG ref;
@@ -40,6 +50,12 @@ typedef struct BitmapScaler {
     UINT src_width, src_height;
     WICBitmapInterpolationMode mode;
     UINT bpp;
+    UINT max_src_rows; /* maximum number of source rows needed for a scanline */
+    struct filter_taps *x_taps, *y_taps;
+    INT *filter_row; /* vertically filtered source row */
+    BYTE *window_bits; /* source rows kept between CopyPixels calls */
+    BYTE **window_rows;
+    UINT window_x, window_width, window_y, window_count;
     void (*fn_get_required_source_rect)(struct BitmapScaler*,UINT,UINT,WICRect*);
     void (*fn_copy_scanline)(struct BitmapScaler*,UINT,UINT,UINT,BYTE**,UINT,UINT,BYTE*);
     CRITICAL_SECTION lock; /* must be held when initialized */
@@ -96,6 +112,11 @@ static ULONG WINAPI BitmapScaler_Release(IWICBitmapScaler *iface)
         This->lock.DebugInfo->Spare[0] = 0;
         DeleteCriticalSection(&This->lock);
         if (This->source) IWICBitmapSource_Release(This->source);
+        HeapFree(GetProcessHeap(), 0, This->x_taps);
+        HeapFree(GetProcessHeap(), 0, This->y_taps);
+        HeapFree(GetProcessHeap(), 0, This->filter_row);
+        HeapFree(GetProcessHeap(), 0, This->window_bits);
+        HeapFree(GetProcessHeap(), 0, This->window_rows);
         HeapFree(GetProcessHeap(), 0, This);
     }
 
@@ -190,18 +211,230 @@ static void NearestNeighbor_CopyScanline(BitmapScaler *This,
     }
 }
 
+static double filter_weight(WICBitmapInterpolationMode mode, double x)
+{
+    x = fabs(x);
+
+    switch (mode)
+    {
+    case WICBitmapInterpolationModeLinear:
+        return x < 1.0 ? 1.0 - x : 0.0;
+    default:
+        /* Catmull-Rom spline */
+        if (x < 1.0) return (1.5 * x - 2.5) * x * x + 1.0;
+        if (x < 2.0) return ((-0.5 * x + 2.5) * x - 4.0) * x + 2.0;
+        return 0.0;
+    }
+}
+
+/* Compute the source pixels and weights used for each destination pixel
+ * along one axis, so that scaling can be done as two separable passes. */
+static struct filter_taps *create_filter_taps(WICBitmapInterpolationMode mode, UINT src_size,
+    UINT dst_size, UINT *max_count)
+{
+    double scale = (double)src_size / dst_size, width, support;
+    struct filter_taps *taps;
+    double *weights;
+    UINT i, j, max_taps;
+    INT *pool;
+
+    /* Fant and high quality cubic filters are widened to cover the source
+     * pixels mapped to a destination pixel when downscaling */
+    width = (mode == WICBitmapInterpolationModeFant || mode == WICBitmapInterpolationModeHighQualityCubic) ?
+            max(scale, 1.0) : 1.0;
+    if (mode == WICBitmapInterpolationModeFant) support = width / 2.0 + 0.5;
+    else if (mode == WICBitmapInterpolationModeLinear) support = width;
+    else support = 2.0 * width;
+
+    max_taps = min((UINT)ceil(support * 2.0) + 1, src_size);
+
+    weights = HeapAlloc(GetProcessHeap(), 0, max_taps * sizeof(*weights));
+    taps = HeapAlloc(GetProcessHeap(), 0, dst_size * (sizeof(*taps) + max_taps * sizeof(*pool)));
+    if (!weights || !taps)
+    {
+        HeapFree(GetProcessHeap(), 0, weights);
+        HeapFree(GetProcessHeap(), 0, taps);
+        return NULL;
+    }
+    pool = (INT *)(taps + dst_size);
+    *max_count = 1;
+
+    for (i = 0; i < dst_size; i++)
+    {
+        double center = (i + 0.5) * scale - 0.5, sum = 0.0;
+        INT first = max(0, (INT)ceil(center - support)), last = min((INT)src_size - 1, (INT)floor(center + support));
+        INT total = 0, largest = 0;
+
+        if (last < first) first = last = min(max(0, (INT)floor(center + 0.5)), (INT)src_size - 1);
+        if (last - first + 1 > max_taps) last = first + max_taps - 1;
+
+        for (j = 0; j <= last - first; j++)
+        {
+            double x = first + j - center;
+
+            if (mode == WICBitmapInterpolationModeFant)
+                /* area of the source pixel covered by the destination pixel */
+                weights[j] = max(0.0, min(x + 0.5, width / 2.0) - max(x - 0.5, -width / 2.0));
+            else
+                weights[j] = filter_weight(mode, x / width);
+            sum += weights[j];
+        }
+
+        /* drop the pixels with no weight at the edges */
+        while (first < last && weights[0] == 0.0)
+        {
+            memmove(weights, weights + 1, (last - first) * sizeof(*weights));
+            first++;
+        }
+        while (last > first && weights[last - first] == 0.0) last--;
+
+        taps[i].start = first;
+        taps[i].count = last - first + 1;
+        taps[i].weights = pool;
+        for (j = 0; j < taps[i].count; j++)
+        {
+            pool[j] = sum != 0.0 ? floor(weights[j] / sum * (1 << FILTER_WEIGHT_BITS) + 0.5) :
+                      (j == 0 ? 1 << FILTER_WEIGHT_BITS : 0);
+            total += pool[j];
+            if (pool[j] > pool[largest]) largest = j;
+        }
+        /* make sure the weights add up exactly */
+        pool[largest] += (1 << FILTER_WEIGHT_BITS) - total;
+
+        pool += taps[i].count;
+        *max_count = max(*max_count, taps[i].count);
+    }
+
+    HeapFree(GetProcessHeap(), 0, weights);
+    return taps;
+}
+
+static void Filter_GetRequiredSourceRect(BitmapScaler *This,
+    UINT x, UINT y, WICRect *src_rect)
+{
+    src_rect->X = This->x_taps[x].start;
+    src_rect->Y = This->y_taps[y].start;
+    src_rect->Width = This->x_taps[x].count;
+    src_rect->Height = This->y_taps[y].count;
+}
+
+static void Filter_CopyScanline(BitmapScaler *This,
+    UINT dst_x, UINT dst_y, UINT dst_width,
+    BYTE **src_data, UINT src_data_x, UINT src_data_y, BYTE *pbBuffer)
+{
+    const struct filter_taps *y_taps = &This->y_taps[dst_y];
+    UINT channels = This->bpp / 8;
+    UINT start = This->x_taps[dst_x].start;
+    UINT end = This->x_taps[dst_x + dst_width - 1].start + This->x_taps[dst_x + dst_width - 1].count;
+    UINT i, j, k, count = (end - start) * channels;
+    INT *row = This->filter_row;
+
+    /* vertical pass, keeping 8 more bits of precision */
+    memset(row, 0, count * sizeof(*row));
+    for (k = 0; k < y_taps->count; k++)
+    {
+        const BYTE *src = src_data[y_taps->start - src_data_y + k] + (start - src_data_x) * channels;
+        INT weight = y_taps->weights[k];
+
+        for (i = 0; i < count; i++)
+            row[i] += src[i] * weight;
+    }
+    for (i = 0; i < count; i++)
+        row[i] = (row[i] + (1 << (FILTER_WEIGHT_BITS - 9))) >> (FILTER_WEIGHT_BITS - 8);
+
+    /* horizontal pass */
+    for (i = 0; i < dst_width; i++)
+    {
+        const struct filter_taps *x_taps = &This->x_taps[dst_x + i];
+        const INT *src = row + (x_taps->start - start) * channels;
+
+        for (j = 0; j < channels; j++)
+        {
+            INT sum = 0;
+
+            for (k = 0; k < x_taps->count; k++)
+                sum += src[k * channels + j] * x_taps->weights[k];
+            sum = (sum + (1 << (FILTER_WEIGHT_BITS + 7))) >> (FILTER_WEIGHT_BITS + 8);
+            *pbBuffer++ = min(max(sum, 0), 255);
+        }
+    }
+}
+
+/* Make sure the source rows y to y+height-1 are in the row window, reusing
+ * the ones fetched by the previous scanline when possible. */
+static HRESULT fetch_source_rows(BitmapScaler *This, UINT x, UINT width, UINT y, UINT height)
+{
+    UINT stride = (width * This->bpp + 7) / 8;
+    WICRect rect;
+    HRESULT hr;
+    UINT i;
+
+    if (!This->window_rows || This->window_x != x || This->window_width != width)
+    {
+        BYTE *bits;
+
+        if (!This->window_rows &&
+            !(This->window_rows = HeapAlloc(GetProcessHeap(), 0, This->max_src_rows * sizeof(BYTE *))))
+            return E_OUTOFMEMORY;
+
+        if (This->window_bits)
+            bits = HeapReAlloc(GetProcessHeap(), 0, This->window_bits, stride * This->max_src_rows);
+        else
+            bits = HeapAlloc(GetProcessHeap(), 0, stride * This->max_src_rows);
+        if (!bits) return E_OUTOFMEMORY;
+        This->window_bits = bits;
+
+        for (i = 0; i < This->max_src_rows; i++)
+            This->window_rows[i] = bits + i * stride;
+        This->window_x = x;
+        This->window_width = width;
+        This->window_count = 0;
+    }
+
+    if (y >= This->window_y && y < This->window_y + This->window_count)
+    {
+        UINT skip = y - This->window_y;
+        BYTE *row;
+
+        /* rotate the rows that are no longer needed to the end of the window */
+        while (skip--)
+        {
+            row = This->window_rows[0];
+            memmove(This->window_rows, This->window_rows + 1, (This->max_src_rows - 1) * sizeof(BYTE *));
+            This->window_rows[This->max_src_rows - 1] = row;
+            This->window_count--;
+        }
+    }
+    else This->window_count = 0;
+    This->window_y = y;
+
+    rect.X = x;
+    rect.Width = width;
+    rect.Height = 1;
+    while (This->window_count < height)
+    {
+        rect.Y = y + This->window_count;
+        hr = IWICBitmapSource_CopyPixels(This->source, &rect, stride, stride,
+            This->window_rows[This->window_count]);
+        if (FAILED(hr))
+        {
+            This->window_count = 0;
+            return hr;
+        }
+        This->window_count++;
+    }
+
+    return S_OK;
+}
+
 static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
     const WICRect *prc, UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
 {
     BitmapScaler *This = impl_from_IWICBitmapScaler(iface);
-    HRESULT hr;
+    HRESULT hr = S_OK;
     WICRect dest_rect;
-    WICRect src_rect_ul, src_rect_br, src_rect;
-    BYTE **src_rows;
-    BYTE *src_bits;
+    WICRect src_rect_ul, src_rect_br;
     ULONG bytesperrow;
-    ULONG src_bytesperrow;
-    ULONG buffer_size;
     UINT y;
 
     TRACE("(%p,%p,%u,%u,%p)\n", iface, prc, cbStride, cbBufferSize, pbBuffer);
@@ -245,58 +478,97 @@ static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
     }
 
     /* MSDN recommends calling CopyPixels once for each scanline from top to
-     * bottom, and claims codecs optimize for this. Ideally, when called in this
-     * way, we should avoid requesting a scanline from the source more than
-     * once, by saving the data that will be useful for the next scanline after
-     * the call returns. The GetRequiredSourceRect/CopyScanline functions are
-     * designed to make it possible to do this in a generic way, but for now we
-     * just grab all the data we need in each call. */
+     * bottom, and claims codecs optimize for this. Only the source rows needed
+     * for the current scanline are kept, and the ones that are still useful
+     * for the next scanline are not requested from the source again, even
+     * across calls. */
 
-    This->fn_get_required_source_rect(This, dest_rect.X, dest_rect.Y, &src_rect_ul);
-    This->fn_get_required_source_rect(This, dest_rect.X+dest_rect.Width-1,
-        dest_rect.Y+dest_rect.Height-1, &src_rect_br);
+    for (y=0; y < dest_rect.Height && SUCCEEDED(hr); y++)
+    {
+        This->fn_get_required_source_rect(This, dest_rect.X, dest_rect.Y+y, &src_rect_ul);
+        This->fn_get_required_source_rect(This, dest_rect.X+dest_rect.Width-1, dest_rect.Y+y, &src_rect_br);
 
-    src_rect.X = src_rect_ul.X;
-    src_rect.Y = src_rect_ul.Y;
-    src_rect.Width = src_rect_br.Width + src_rect_br.X - src_rect_ul.X;
-    src_rect.Height = src_rect_br.Height + src_rect_br.Y - src_rect_ul.Y;
+        hr = fetch_source_rows(This, src_rect_ul.X, src_rect_br.X + src_rect_br.Width - src_rect_ul.X,
+            src_rect_ul.Y, src_rect_ul.Height);
 
-    src_bytesperrow = (src_rect.Width * This->bpp + 7)/8;
-    buffer_size = src_bytesperrow * src_rect.Height;
+        if (SUCCEEDED(hr))
+            This->fn_copy_scanline(This, dest_rect.X, dest_rect.Y+y, dest_rect.Width,
+                This->window_rows, This->window_x, This->window_y, pbBuffer + cbStride * y);
+    }
 
-    src_rows = HeapAlloc(GetProcessHeap(), 0, sizeof(BYTE*) * src_rect.Height);
-    src_bits = HeapAlloc(GetProcessHeap(), 0, buffer_size);
+end:
+    LeaveCriticalSection(&This->lock);
 
-    if (!src_rows || !src_bits)
-    {
-        HeapFree(GetProcessHeap(), 0, src_rows);
-        HeapFree(GetProcessHeap(), 0, src_bits);
-        hr = E_OUTOFMEMORY;
-        goto end;
-    }
+    return hr;
+}
 
-    for (y=0; y<src_rect.Height; y++)
-        src_rows[y] = src_bits + y * src_bytesperrow;
+/* Let the source do as much of the downscaling as it can natively, like the
+ * JPEG decoder does through DCT scaling, and return the reduced image. */
+static IWICBitmapSource *get_prescaled_source(IWICBitmapSource *source, UINT width, UINT height)
+{
+    IWICBitmapSourceTransform *transform;
+    UINT src_width, src_height, stride, size;
+    WICPixelFormatGUID format;
+    IWICBitmap *bitmap = NULL;
+    IWICPalette *palette;
+    IWICBitmapLock *lock;
+    BOOL supported;
+    double dpix, dpiy;
+    BYTE *data;
+    HRESULT hr;
 
-    hr = IWICBitmapSource_CopyPixels(This->source, &src_rect, src_bytesperrow,
-        buffer_size, src_bits);
+    if (!width || !height) return NULL;
+
+    if (FAILED(IWICBitmapSource_QueryInterface(source, &IID_IWICBitmapSourceTransform, (void **)&transform)))
+        return NULL;
+
+    hr = IWICBitmapSource_GetSize(source, &src_width, &src_height);
+    if (SUCCEEDED(hr))
+        hr = IWICBitmapSourceTransform_GetClosestSize(transform, &width, &height);
+    if (SUCCEEDED(hr))
+        hr = IWICBitmapSourceTransform_DoesSupportTransform(transform, WICBitmapTransformRotate0, &supported);
+    if (SUCCEEDED(hr) && (!supported || (width >= src_width && height >= src_height)))
+        hr = E_FAIL;
+    if (SUCCEEDED(hr))
+        hr = IWICBitmapSource_GetPixelFormat(source, &format);
+    if (SUCCEEDED(hr))
+        hr = BitmapImpl_Create(width, height, 0, 0, NULL, 0, &format, WICBitmapCacheOnLoad, &bitmap);
 
     if (SUCCEEDED(hr))
     {
-        for (y=0; y < dest_rect.Height; y++)
+        hr = IWICBitmap_Lock(bitmap, NULL, WICBitmapLockWrite, &lock);
+        if (SUCCEEDED(hr))
         {
-            This->fn_copy_scanline(This, dest_rect.X, dest_rect.Y+y, dest_rect.Width,
-                src_rows, src_rect.X, src_rect.Y, pbBuffer + cbStride * y);
+            hr = IWICBitmapLock_GetStride(lock, &stride);
+            if (SUCCEEDED(hr))
+                hr = IWICBitmapLock_GetDataPointer(lock, &size, &data);
+            if (SUCCEEDED(hr))
+                hr = IWICBitmapSourceTransform_CopyPixels(transform, NULL, width, height, &format,
+                    WICBitmapTransformRotate0, stride, size, data);
+            IWICBitmapLock_Release(lock);
         }
     }
 
-    HeapFree(GetProcessHeap(), 0, src_rows);
-    HeapFree(GetProcessHeap(), 0, src_bits);
+    if (SUCCEEDED(hr) && SUCCEEDED(IWICBitmapSource_GetResolution(source, &dpix, &dpiy)))
+        IWICBitmap_SetResolution(bitmap, dpix, dpiy);
 
-end:
-    LeaveCriticalSection(&This->lock);
+    if (SUCCEEDED(hr) && SUCCEEDED(PaletteImpl_Create(&palette)))
+    {
+        if (SUCCEEDED(IWICBitmapSource_CopyPalette(source, palette)))
+            IWICBitmap_SetPalette(bitmap, palette);
+        IWICPalette_Release(palette);
+    }
 
-    return hr;
+    IWICBitmapSourceTransform_Release(transform);
+
+    if (FAILED(hr))
+    {
+        if (bitmap) IWICBitmap_Release(bitmap);
+        return NULL;
+    }
+
+    TRACE("source prescaled from %ux%u to %ux%u\n", src_width, src_height, width, height);
+    return (IWICBitmapSource *)bitmap;
 }
 
 static HRESULT WINAPI BitmapScaler_Initialize(IWICBitmapScaler *iface,
@@ -304,6 +576,7 @@ static HRESULT WINAPI BitmapScaler_Initialize(IWICBitmapScaler *iface,
     WICBitmapInterpolationMode mode)
 {
     BitmapScaler *This = impl_from_IWICBitmapScaler(iface);
+    IWICBitmapSource *prescaled = NULL;
     HRESULT hr;
     GUID src_pixelformat;
 
@@ -317,6 +590,9 @@ static HRESULT WINAPI BitmapScaler_Initialize(IWICBitmapScaler *iface,
         goto end;
     }
 
+    if ((prescaled = get_prescaled_source(pISource, uiWidth, uiHeight)))
+        pISource = prescaled;
+
     This->width = uiWidth;
     This->height = uiHeight;
     This->mode = mode;
@@ -335,6 +611,53 @@ static HRESULT WINAPI BitmapScaler_Initialize(IWICBitmapScaler *iface,
     {
         switch (mode)
         {
+        case WICBitmapInterpolationModeLinear:
+        case WICBitmapInterpolationModeCubic:
+        case WICBitmapInterpolationModeFant:
+        case WICBitmapInterpolationModeHighQualityCubic:
+            /* the filters work on 8-bit channels */
+            if (IsEqualGUID(&src_pixelformat, &GUID_WICPixelFormat8bppGray) ||
+                IsEqualGUID(&src_pixelformat, &GUID_WICPixelFormat24bppBGR) ||
+                IsEqualGUID(&src_pixelformat, &GUID_WICPixelFormat24bppRGB) ||
+                IsEqualGUID(&src_pixelformat, &GUID_WICPixelFormat32bppBGR) ||
+                IsEqualGUID(&src_pixelformat, &GUID_WICPixelFormat32bppBGRA) ||
+                IsEqualGUID(&src_pixelformat, &GUID_WICPixelFormat32bppPBGRA))
+            {
+                IWICBitmapSource_AddRef(pISource);
+                This->source = pISource;
+            }
+            else
+            {
+                hr = WICConvertBitmapSource(&GUID_WICPixelFormat32bppBGRA,
+                    pISource, &This->source);
+                This->bpp = 32;
+            }
+
+            if (SUCCEEDED(hr))
+            {
+                UINT x_count, y_count;
+
+                This->x_taps = create_filter_taps(mode, This->src_width, This->width, &x_count);
+                This->y_taps = create_filter_taps(mode, This->src_height, This->height, &y_count);
+                This->filter_row = HeapAlloc(GetProcessHeap(), 0,
+                    This->src_width * (This->bpp / 8) * sizeof(*This->filter_row));
+                if (!This->x_taps || !This->y_taps || !This->filter_row)
+                {
+                    HeapFree(GetProcessHeap(), 0, This->x_taps);
+                    HeapFree(GetProcessHeap(), 0, This->y_taps);
+                    HeapFree(GetProcessHeap(), 0, This->filter_row);
+                    This->x_taps = This->y_taps = NULL;
+                    This->filter_row = NULL;
+                    IWICBitmapSource_Release(This->source);
+                    This->source = NULL;
+                    hr = E_OUTOFMEMORY;
+                    break;
+                }
+                This->max_src_rows = y_count;
+            }
+            This->fn_get_required_source_rect = Filter_GetRequiredSourceRect;
+            This->fn_copy_scanline = Filter_CopyScanline;
+            break;
         default:
             FIXME("unsupported mode %i\n", mode);
             /* fall-through */
@@ -350,6 +673,7 @@ static HRESULT WINAPI BitmapScaler_Initialize(IWICBitmapScaler *iface,
                     pISource, &This->source);
                 This->bpp = 32;
             }
+            This->max_src_rows = 1;
             This->fn_get_required_source_rect = NearestNeighbor_GetRequiredSourceRect;
             This->fn_copy_scanline = NearestNeighbor_CopyScanline;
             break;
@@ -357,6 +681,7 @@ static HRESULT WINAPI BitmapScaler_Initialize(IWICBitmapScaler *iface,
     }
 
 end:
+    if (prescaled) IWICBitmapSource_Release(prescaled);
     LeaveCriticalSection(&This->lock);
 
     return hr;
@@ -390,6 +715,12 @@ HRESULT BitmapScaler_Create(IWICBitmapScaler **scaler)
     This->src_height = 0;
     This->mode = 0;
     This->bpp = 0;
+    This->max_src_rows = 0;
+    This->x_taps = This->y_taps = NULL;
+    This->filter_row = NULL;
+    This->window_bits = NULL;
+    This->window_rows = NULL;
+    This->window_x = This->window_width = This->window_y = This->window_count = 0;
     InitializeCriticalSection(&This->lock);
     This->lock.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": BitmapScaler.lock");
 
@@ -972,6 +972,60 @@ static void test_clipper(void)
     IWICBitmapClipper_Release(clipper);
 }
 
+static void test_scaler(void)
+{
+    static const BYTE gray[] = { 0, 100, 200, 50,
+                                 0, 100, 200, 50 };
+    static const WICBitmapInterpolationMode modes[] =
+    {
+        WICBitmapInterpolationModeLinear,
+        WICBitmapInterpolationModeCubic,
+        WICBitmapInterpolationModeFant,
+    };
+    IWICBitmapScaler *scaler;
+    IWICBitmap *bitmap;
+    BYTE buffer[64];
+    UINT i, j;
+    HRESULT hr;
+
+    hr = IWICImagingFactory_CreateBitmapFromMemory(factory, 4, 2, &GUID_WICPixelFormat8bppGray,
+        4, sizeof(gray), (BYTE *)gray, &bitmap);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+
+    /* box filter averages the covered pixels */
+    hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, 2, 1, WICBitmapInterpolationModeFant);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    memset(buffer, 0xcc, sizeof(buffer));
+    hr = IWICBitmapScaler_CopyPixels(scaler, NULL, 2, sizeof(buffer), buffer);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    ok(buffer[0] == 50 && buffer[1] == 125, "got %u,%u\n", buffer[0], buffer[1]);
+    IWICBitmapScaler_Release(scaler);
+
+    /* interpolating between identical rows leaves them unchanged, one scanline at a time */
+    for (i = 0; i < ARRAY_SIZE(modes); i++)
+    {
+        WICRect rect = { 0, 0, 4, 1 };
+
+        hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+        ok(hr == S_OK, "got 0x%08x\n", hr);
+        hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, 4, 5, modes[i]);
+        ok(hr == S_OK, "%u: got 0x%08x\n", i, hr);
+
+        for (rect.Y = 0; rect.Y < 5; rect.Y++)
+        {
+            hr = IWICBitmapScaler_CopyPixels(scaler, &rect, 4, sizeof(buffer), buffer);
+            ok(hr == S_OK, "%u: got 0x%08x\n", i, hr);
+            for (j = 0; j < 4; j++)
+                ok(buffer[j] == gray[j], "%u,%d: got %u at %u\n", i, rect.Y, buffer[j], j);
+        }
+        IWICBitmapScaler_Release(scaler);
+    }
+
+    IWICBitmap_Release(bitmap);
+}
+
 static HRESULT (WINAPI *pWICCreateBitmapFromSectionEx)
     (UINT, UINT, REFWICPixelFormatGUID, HANDLE, UINT, UINT, WICSectionAccessLevel, IWICBitmap **);
 
@@ -1046,6 +1100,7 @@ START_TEST(bitmap)
     test_CreateBitmapFromHICON();
     test_CreateBitmapFromHBITMAP();
     test_clipper();
+    test_scaler();
 
     IWICImagingFactory_Release(factory);
 
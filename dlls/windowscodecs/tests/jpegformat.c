@@ -47,6 +47,7 @@ static void test_decode_adobe_cmyk(void)
 {
     IWICBitmapDecoder *decoder;
     IWICBitmapFrameDecode *framedecode;
+    IWICBitmapSourceTransform *transform;
     HRESULT hr;
     HGLOBAL hjpegdata;
     char *jpegdata;
@@ -125,6 +126,36 @@ static void test_decode_adobe_cmyk(void)
                             broken(!memcmp(imagedata, expected_imagedata_24bpp, sizeof(expected_imagedata))), /* xp/2003 */
                             "unexpected image data\n");
                 }
+
+                hr = IWICBitmapFrameDecode_QueryInterface(framedecode, &IID_IWICBitmapSourceTransform, (void **)&transform);
+                ok(hr == S_OK, "QueryInterface failed, hr=%x\n", hr);
+                if (SUCCEEDED(hr))
+                {
+                    BOOL supported = FALSE;
+
+                    hr = IWICBitmapSourceTransform_DoesSupportTransform(transform, WICBitmapTransformRotate0, &supported);
+                    ok(hr == S_OK, "DoesSupportTransform failed, hr=%x\n", hr);
+                    ok(supported, "Rotate0 is not supported\n");
+
+                    width = 1;
+                    height = 5;
+                    hr = IWICBitmapSourceTransform_GetClosestSize(transform, &width, &height);
+                    ok(hr == S_OK, "GetClosestSize failed, hr=%x\n", hr);
+                    ok(width == 1 && height == 5, "got %ux%u\n", width, height);
+
+                    /* downscaled decoding, then back to full size */
+                    memset(imagedata, 0, sizeof(imagedata));
+                    hr = IWICBitmapSourceTransform_CopyPixels(transform, NULL, 1, 3, NULL, WICBitmapTransformRotate0,
+                        4, sizeof(imagedata), imagedata);
+                    ok(hr == S_OK, "CopyPixels failed, hr=%x\n", hr);
+                    ok(!memcmp(imagedata, expected_imagedata, 3 * 4), "unexpected image data\n");
+
+                    hr = IWICBitmapFrameDecode_CopyPixels(framedecode, NULL, 4, sizeof(imagedata), imagedata);
+                    ok(hr == S_OK, "CopyPixels failed, hr=%x\n", hr);
+                    ok(!memcmp(imagedata, expected_imagedata, sizeof(imagedata)), "unexpected image data\n");
+
+                    IWICBitmapSourceTransform_Release(transform);
+                }
                 IWICBitmapFrameDecode_Release(framedecode);
             }
             IStream_Release(jpegstream);
@@ -65,6 +65,9 @@ struct pnp_device
     DEVICE_OBJECT *device;
 };
 
+/* number of input reports kept while no read request is pending */
+#define REPORT_QUEUE_LENGTH 32
+
 struct device_extension
 {
     struct pnp_device *pnp_device;
@@ -79,8 +82,10 @@ struct device_extension
 
     BYTE *last_report;
     DWORD last_report_size;
-    BOOL last_report_read;
     DWORD buffer_size;
+    BYTE *report_queue;  /* unread input reports, buffer_size bytes each */
+    DWORD report_queue_size[REPORT_QUEUE_LENGTH];
+    DWORD report_queue_head, report_queue_tail;
     LIST_ENTRY irp_queue;
     CRITICAL_SECTION report_cs;
 
@@ -241,8 +246,10 @@ DEVICE_OBJECT *bus_create_hid_device(DRIVER_OBJECT *driver, const WCHAR *busidW,
     ext->vtbl               = vtbl;
     ext->last_report        = NULL;
     ext->last_report_size   = 0;
-    ext->last_report_read   = TRUE;
     ext->buffer_size        = 0;
+    ext->report_queue       = NULL;
+    ext->report_queue_head  = 0;
+    ext->report_queue_tail  = 0;
 
     memset(ext->platform_private, 0, platform_data_size);
 
@@ -354,6 +361,7 @@ void bus_remove_hid_device(DEVICE_OBJECT *device)
 
     HeapFree(GetProcessHeap(), 0, ext->serial);
     HeapFree(GetProcessHeap(), 0, ext->last_report);
+    HeapFree(GetProcessHeap(), 0, ext->report_queue);
     IoDeleteDevice(device);
 
     /* pnp_device must be released after the device is gone */
@@ -422,18 +430,18 @@ NTSTATUS WINAPI common_pnp_dispatch(DEVICE_OBJECT *device, IRP *irp)
     return status;
 }
 
-static NTSTATUS deliver_last_report(struct device_extension *ext, DWORD buffer_length, BYTE* buffer, ULONG_PTR *out_length)
+static NTSTATUS deliver_report(const BYTE *report, DWORD report_size, DWORD buffer_length, BYTE* buffer, ULONG_PTR *out_length)
 {
-    if (buffer_length < ext->last_report_size)
+    if (buffer_length < report_size)
     {
         *out_length = 0;
         return STATUS_BUFFER_TOO_SMALL;
     }
     else
     {
-        if (ext->last_report)
-            memcpy(buffer, ext->last_report, ext->last_report_size);
-        *out_length = ext->last_report_size;
+        if (report)
+            memcpy(buffer, report, report_size);
+        *out_length = report_size;
         return STATUS_SUCCESS;
     }
 }
@@ -535,7 +543,7 @@ NTSTATUS WINAPI hid_internal_dispatch(DEVICE_OBJECT *device, IRP *irp)
                 break;
             }
 
-            irp->IoStatus.u.Status = status = deliver_last_report(ext,
+            irp->IoStatus.u.Status = status = deliver_report(ext->last_report, ext->last_report_size,
                 packet->reportBufferLen, packet->reportBuffer,
                 &irp->IoStatus.Information);
 
@@ -555,12 +563,14 @@ NTSTATUS WINAPI hid_internal_dispatch(DEVICE_OBJECT *device, IRP *irp)
                 LeaveCriticalSection(&ext->report_cs);
                 break;
             }
-            if (!ext->last_report_read)
+            if (ext->report_queue_head != ext->report_queue_tail)
             {
-                irp->IoStatus.u.Status = status = deliver_last_report(ext,
-                    irpsp->Parameters.DeviceIoControl.OutputBufferLength,
+                DWORD tail = ext->report_queue_tail;
+
+                irp->IoStatus.u.Status = status = deliver_report(ext->report_queue + tail * ext->buffer_size,
+                    ext->report_queue_size[tail], irpsp->Parameters.DeviceIoControl.OutputBufferLength,
                     irp->UserBuffer, &irp->IoStatus.Information);
-                ext->last_report_read = TRUE;
+                ext->report_queue_tail = (tail + 1) % REPORT_QUEUE_LENGTH;
             }
             else
             {
@@ -627,13 +637,20 @@ void process_hid_report(DEVICE_OBJECT *device, BYTE *report, DWORD length)
     if (length > ext->buffer_size)
     {
         HeapFree(GetProcessHeap(), 0, ext->last_report);
+        HeapFree(GetProcessHeap(), 0, ext->report_queue);
         ext->last_report = HeapAlloc(GetProcessHeap(), 0, length);
-        if (!ext->last_report)
+        ext->report_queue = HeapAlloc(GetProcessHeap(), 0, length * REPORT_QUEUE_LENGTH);
+        /* the queued reports were stored with the old size, drop them */
+        ext->report_queue_head = ext->report_queue_tail = 0;
+        if (!ext->last_report || !ext->report_queue)
         {
             ERR_(hid_report)("Failed to alloc last report\n");
+            HeapFree(GetProcessHeap(), 0, ext->last_report);
+            HeapFree(GetProcessHeap(), 0, ext->report_queue);
+            ext->last_report = NULL;
+            ext->report_queue = NULL;
             ext->buffer_size = 0;
             ext->last_report_size = 0;
-            ext->last_report_read = TRUE;
             LeaveCriticalSection(&ext->report_cs);
             return;
         }
@@ -641,12 +658,24 @@ void process_hid_report(DEVICE_OBJECT *device, BYTE *report, DWORD length)
             ext->buffer_size = length;
     }
 
-    if (!ext->last_report_read)
-        ERR_(hid_report)("Device reports coming in too fast, last report not read yet!\n");
-
     memcpy(ext->last_report, report, length);
     ext->last_report_size = length;
-    ext->last_report_read = FALSE;
+
+    if (IsListEmpty(&ext->irp_queue))
+    {
+        /* nobody is waiting, keep the report until the next read request */
+        DWORD head = ext->report_queue_head;
+        DWORD next = (head + 1) % REPORT_QUEUE_LENGTH;
+
+        if (next == ext->report_queue_tail)
+        {
+            ERR_(hid_report)("Device reports coming in too fast, dropping oldest report!\n");
+            ext->report_queue_tail = (ext->report_queue_tail + 1) % REPORT_QUEUE_LENGTH;
+        }
+        memcpy(ext->report_queue + head * ext->buffer_size, report, length);
+        ext->report_queue_size[head] = length;
+        ext->report_queue_head = next;
+    }
 
     while ((entry = RemoveHeadList(&ext->irp_queue)) != &ext->irp_queue)
     {
@@ -654,10 +683,9 @@ void process_hid_report(DEVICE_OBJECT *device, BYTE *report, DWORD length)
         TRACE_(hid_report)("Processing Request\n");
         irp = CONTAINING_RECORD(entry, IRP, Tail.Overlay.s.ListEntry);
         irpsp = IoGetCurrentIrpStackLocation(irp);
-        irp->IoStatus.u.Status = deliver_last_report(ext,
+        irp->IoStatus.u.Status = deliver_report(ext->last_report, ext->last_report_size,
             irpsp->Parameters.DeviceIoControl.OutputBufferLength,
             irp->UserBuffer, &irp->IoStatus.Information);
-        ext->last_report_read = TRUE;
         IoCompleteRequest(irp, IO_NO_INCREMENT);
     }
     LeaveCriticalSection(&ext->report_cs);
@@ -34,6 +34,9 @@ WINE_DEFAULT_DEBUG_CHANNEL(d3d);
 #define WINED3D_BUFFER_PIN_SYSMEM   0x04    /* Keep a system memory copy for this buffer. */
 #define WINED3D_BUFFER_DISCARD      0x08    /* A DISCARD lock has occurred since the last preload. */
 #define WINED3D_BUFFER_APPLESYNC    0x10    /* Using sync as in GL_APPLE_flush_buffer_range. */
+#define WINED3D_BUFFER_PERSISTENT   0x20    /* The buffer object is persistently mapped. */
+
+#define WINED3D_BUFFER_MAX_POOL_BOS 3       /* Maximum number of retired persistent BOs per buffer. */
 
 #define VB_MAXDECLCHANGES     100     /* After that number of decl changes we stop converting */
 #define VB_RESETDECLCHANGE    1000    /* Reset the decl changecount after that number of draws */
@@ -138,47 +141,53 @@ static void buffer_bind(struct wined3d_buffer *buffer, struct wined3d_context *c
     context_bind_bo(context, buffer->buffer_type_hint, buffer->buffer_object);
 }
 
+/* The stream source state handler might have read the memory of the
+ * vertex buffer already and got the memory in the vbo which is not
+ * valid any longer. Dirtify the stream source to force a reload. This
+ * happens only once per changed vertexbuffer and should occur rather
+ * rarely. */
+static void buffer_invalidate_bind_points(struct wined3d_buffer *buffer)
+{
+    struct wined3d_device *device = buffer->resource.device;
+
+    if (!buffer->resource.bind_count)
+        return;
+
+    if (buffer->bind_flags & WINED3D_BIND_VERTEX_BUFFER)
+        device_invalidate_state(device, STATE_STREAMSRC);
+    if (buffer->bind_flags & WINED3D_BIND_INDEX_BUFFER)
+        device_invalidate_state(device, STATE_INDEXBUFFER);
+    if (buffer->bind_flags & WINED3D_BIND_CONSTANT_BUFFER)
+    {
+        device_invalidate_state(device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_VERTEX));
+        device_invalidate_state(device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_HULL));
+        device_invalidate_state(device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_DOMAIN));
+        device_invalidate_state(device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_GEOMETRY));
+        device_invalidate_state(device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_PIXEL));
+        device_invalidate_state(device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_COMPUTE));
+    }
+    if (buffer->bind_flags & WINED3D_BIND_STREAM_OUTPUT)
+        device_invalidate_state(device, STATE_STREAM_OUTPUT);
+}
+
 /* Context activation is done by the caller. */
 static void buffer_destroy_buffer_object(struct wined3d_buffer *buffer, struct wined3d_context *context)
 {
     const struct wined3d_gl_info *gl_info = context->gl_info;
-    struct wined3d_resource *resource = &buffer->resource;
+    unsigned int i;
 
     if (!buffer->buffer_object)
         return;
 
-    /* The stream source state handler might have read the memory of the
-     * vertex buffer already and got the memory in the vbo which is not
-     * valid any longer. Dirtify the stream source to force a reload. This
-     * happens only once per changed vertexbuffer and should occur rather
-     * rarely. */
-    if (resource->bind_count)
-    {
-        if (buffer->bind_flags & WINED3D_BIND_VERTEX_BUFFER)
-            device_invalidate_state(resource->device, STATE_STREAMSRC);
-        if (buffer->bind_flags & WINED3D_BIND_INDEX_BUFFER)
-            device_invalidate_state(resource->device, STATE_INDEXBUFFER);
-        if (buffer->bind_flags & WINED3D_BIND_CONSTANT_BUFFER)
-        {
-            device_invalidate_state(resource->device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_VERTEX));
-            device_invalidate_state(resource->device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_HULL));
-            device_invalidate_state(resource->device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_DOMAIN));
-            device_invalidate_state(resource->device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_GEOMETRY));
-            device_invalidate_state(resource->device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_PIXEL));
-            device_invalidate_state(resource->device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_COMPUTE));
-        }
-        if (buffer->bind_flags & WINED3D_BIND_STREAM_OUTPUT)
-        {
-            device_invalidate_state(resource->device, STATE_STREAM_OUTPUT);
-            if (context->transform_feedback_active)
-            {
-                /* We have to make sure that transform feedback is not active
-                 * when deleting a potentially bound transform feedback buffer.
-                 * This may happen when the device is being destroyed. */
-                WARN("Deleting buffer object for buffer %p, disabling transform feedback.\n", buffer);
-                context_end_transform_feedback(context);
-            }
-        }
+    buffer_invalidate_bind_points(buffer);
+    if (buffer->resource.bind_count && (buffer->bind_flags & WINED3D_BIND_STREAM_OUTPUT)
+            && context->transform_feedback_active)
+    {
+        /* We have to make sure that transform feedback is not active
+         * when deleting a potentially bound transform feedback buffer.
+         * This may happen when the device is being destroyed. */
+        WARN("Deleting buffer object for buffer %p, disabling transform feedback.\n", buffer);
+        context_end_transform_feedback(context);
     }
 
     GL_EXTCALL(glDeleteBuffers(1, &buffer->buffer_object));
@@ -191,6 +200,55 @@ static void buffer_destroy_buffer_object(struct wined3d_buffer *buffer, struct w
         buffer->fence = NULL;
     }
     buffer->flags &= ~WINED3D_BUFFER_APPLESYNC;
+
+    for (i = 0; i < buffer->bo_pool_count; ++i)
+    {
+        GL_EXTCALL(glDeleteBuffers(1, &buffer->bo_pool[i].id));
+        wined3d_fence_destroy(buffer->bo_pool[i].fence);
+    }
+    checkGLcall("delete pooled buffer objects");
+    buffer->bo_pool_count = 0;
+    buffer->persistent_ptr = NULL;
+}
+
+/* Context activation is done by the caller. */
+static BOOL buffer_create_persistent_bo(struct wined3d_buffer *buffer, struct wined3d_context *context,
+        struct wined3d_buffer_bo *bo)
+{
+    const struct wined3d_gl_info *gl_info = context->gl_info;
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    GLenum error;
+    HRESULT hr;
+
+    if (buffer->resource.access & WINED3D_RESOURCE_ACCESS_MAP_R)
+        flags |= GL_MAP_READ_BIT;
+
+    if (FAILED(hr = wined3d_fence_create(buffer->resource.device, &bo->fence)))
+    {
+        WARN("Failed to create fence, hr %#x.\n", hr);
+        return FALSE;
+    }
+
+    while (gl_info->gl_ops.gl.p_glGetError() != GL_NO_ERROR);
+
+    GL_EXTCALL(glGenBuffers(1, &bo->id));
+    context_bind_bo(context, buffer->buffer_type_hint, bo->id);
+    GL_EXTCALL(glBufferStorage(buffer->buffer_type_hint, buffer->resource.size,
+            NULL, flags | GL_DYNAMIC_STORAGE_BIT));
+    bo->ptr = GL_EXTCALL(glMapBufferRange(buffer->buffer_type_hint, 0, buffer->resource.size, flags));
+    error = gl_info->gl_ops.gl.p_glGetError();
+    if (error != GL_NO_ERROR || !bo->ptr || ((DWORD_PTR)bo->ptr & (RESOURCE_ALIGNMENT - 1)))
+    {
+        WARN("Failed to create a persistently mapped BO, error %s (%#x), pointer %p.\n",
+                debug_glerror(error), error, bo->ptr);
+        GL_EXTCALL(glDeleteBuffers(1, &bo->id));
+        wined3d_fence_destroy(bo->fence);
+        return FALSE;
+    }
+
+    TRACE("Created persistently mapped BO %u at %p for buffer %p.\n", bo->id, bo->ptr, buffer);
+
+    return TRUE;
 }
 
 /* Context activation is done by the caller. */
@@ -203,6 +261,24 @@ static BOOL buffer_create_buffer_object(struct wined3d_buffer *buffer, struct wi
     TRACE("Creating an OpenGL buffer object for wined3d_buffer %p with usage %s.\n",
             buffer, debug_d3dusage(buffer->resource.usage));
 
+    if (buffer->flags & WINED3D_BUFFER_PERSISTENT)
+    {
+        struct wined3d_buffer_bo bo;
+
+        if (buffer_create_persistent_bo(buffer, context, &bo))
+        {
+            buffer->buffer_object = bo.id;
+            buffer->persistent_ptr = bo.ptr;
+            buffer->fence = bo.fence;
+            buffer->buffer_object_usage = GL_STREAM_DRAW_ARB;
+            buffer_invalidate_bo_range(buffer, 0, 0);
+            return TRUE;
+        }
+
+        WARN("Falling back to a regular BO for buffer %p.\n", buffer);
+        buffer->flags &= ~WINED3D_BUFFER_PERSISTENT;
+    }
+
     /* Make sure that the gl error is cleared. Do not use checkGLcall
      * here because checkGLcall just prints a fixme and continues. However,
      * if an error during VBO creation occurs we can fall back to non-VBO operation
@@ -781,6 +857,7 @@ static void wined3d_buffer_destroy_object(void *object)
         heap_free(buffer->conversion_map);
     }
 
+    heap_free(buffer->bo_pool);
     heap_free(buffer->maps);
     heap_free(buffer);
 }
@@ -875,6 +952,88 @@ drop_fence:
     buffer->flags &= ~WINED3D_BUFFER_APPLESYNC;
 }
 
+/* Replace the current BO with an idle one from the pool. The GPU may still
+ * be reading from the old one, so it goes to the back of the pool, where
+ * its fence tells when it can be reused. */
+static BOOL buffer_rename_persistent(struct wined3d_buffer *buffer, struct wined3d_context *context)
+{
+    struct wined3d_device *device = buffer->resource.device;
+    enum wined3d_fence_result ret;
+    struct wined3d_buffer_bo bo;
+    unsigned int i;
+
+    for (i = 0; i < buffer->bo_pool_count; ++i)
+    {
+        ret = wined3d_fence_test(buffer->bo_pool[i].fence, device, 0);
+        if (ret == WINED3D_FENCE_OK || ret == WINED3D_FENCE_NOT_STARTED)
+            break;
+    }
+
+    if (i == buffer->bo_pool_count)
+    {
+        if (buffer->bo_pool_count < WINED3D_BUFFER_MAX_POOL_BOS
+                && wined3d_array_reserve((void **)&buffer->bo_pool, &buffer->bo_pool_size,
+                buffer->bo_pool_count + 1, sizeof(*buffer->bo_pool))
+                && buffer_create_persistent_bo(buffer, context, &buffer->bo_pool[buffer->bo_pool_count]))
+        {
+            ++buffer->bo_pool_count;
+        }
+        else if (!buffer->bo_pool_count)
+        {
+            return FALSE;
+        }
+        else
+        {
+            /* The first BO in the pool is the one retired the longest time ago. */
+            TRACE("Waiting for BO %u of buffer %p.\n", buffer->bo_pool[0].id, buffer);
+            i = 0;
+            ret = wined3d_fence_wait(buffer->bo_pool[0].fence, device);
+            if (ret != WINED3D_FENCE_OK && ret != WINED3D_FENCE_NOT_STARTED)
+            {
+                WARN("wined3d_fence_wait() returned %u, calling glFinish().\n", ret);
+                context->gl_info->gl_ops.gl.p_glFinish();
+            }
+        }
+    }
+
+    bo = buffer->bo_pool[i];
+    memmove(&buffer->bo_pool[i], &buffer->bo_pool[i + 1],
+            (buffer->bo_pool_count - i - 1) * sizeof(*buffer->bo_pool));
+    buffer->bo_pool[buffer->bo_pool_count - 1].id = buffer->buffer_object;
+    buffer->bo_pool[buffer->bo_pool_count - 1].ptr = buffer->persistent_ptr;
+    buffer->bo_pool[buffer->bo_pool_count - 1].fence = buffer->fence;
+
+    TRACE("Renaming buffer %p from BO %u to BO %u.\n", buffer, buffer->buffer_object, bo.id);
+    buffer->buffer_object = bo.id;
+    buffer->persistent_ptr = bo.ptr;
+    buffer->fence = bo.fence;
+    buffer_invalidate_bind_points(buffer);
+
+    return TRUE;
+}
+
+/* Context activation is done by the caller. */
+static void buffer_sync_persistent(struct wined3d_buffer *buffer, struct wined3d_context *context, DWORD flags)
+{
+    enum wined3d_fence_result ret;
+
+    /* No fencing needs to be done if the app promises not to overwrite
+     * existing data. */
+    if (flags & WINED3D_MAP_NOOVERWRITE)
+        return;
+
+    if ((flags & WINED3D_MAP_DISCARD) && buffer_rename_persistent(buffer, context))
+        return;
+
+    TRACE("Synchronizing buffer %p.\n", buffer);
+    ret = wined3d_fence_wait(buffer->fence, buffer->resource.device);
+    if (ret != WINED3D_FENCE_OK && ret != WINED3D_FENCE_NOT_STARTED)
+    {
+        WARN("wined3d_fence_wait() returned %u, calling glFinish().\n", ret);
+        context->gl_info->gl_ops.gl.p_glFinish();
+    }
+}
+
 static void buffer_mark_used(struct wined3d_buffer *buffer)
 {
     buffer->flags &= ~WINED3D_BUFFER_DISCARD;
@@ -996,6 +1155,11 @@ struct wined3d_resource * CDECL wined3d_buffer_get_resource(struct wined3d_buffe
     return &buffer->resource;
 }
 
+BOOL wined3d_buffer_is_persistent(const struct wined3d_buffer *buffer)
+{
+    return !!(buffer->flags & WINED3D_BUFFER_PERSISTENT);
+}
+
 static HRESULT wined3d_buffer_map(struct wined3d_buffer *buffer, UINT offset, UINT size, BYTE **data, DWORD flags)
 {
     struct wined3d_device *device = buffer->resource.device;
@@ -1067,7 +1231,12 @@ static HRESULT wined3d_buffer_map(struct wined3d_buffer *buffer, UINT offset, UI
                 if (buffer->flags & WINED3D_BUFFER_DISCARD)
                     flags &= ~WINED3D_MAP_DISCARD;
 
-                if (gl_info->supported[ARB_MAP_BUFFER_RANGE])
+                if (buffer->flags & WINED3D_BUFFER_PERSISTENT)
+                {
+                    buffer_sync_persistent(buffer, context, flags);
+                    buffer->map_ptr = buffer->persistent_ptr;
+                }
+                else if (gl_info->supported[ARB_MAP_BUFFER_RANGE])
                 {
                     GLbitfield mapflags = wined3d_resource_gl_map_flags(flags);
                     buffer->map_ptr = GL_EXTCALL(glMapBufferRange(buffer->buffer_type_hint,
@@ -1149,7 +1318,13 @@ static void wined3d_buffer_unmap(struct wined3d_buffer *buffer)
         return;
     }
 
-    if (buffer->map_ptr)
+    if (buffer->map_ptr && (buffer->flags & WINED3D_BUFFER_PERSISTENT))
+    {
+        /* The mapping is coherent, so there's nothing to flush. */
+        buffer_clear_dirty_areas(buffer);
+        buffer->map_ptr = NULL;
+    }
+    else if (buffer->map_ptr)
     {
         struct wined3d_device *device = buffer->resource.device;
         const struct wined3d_gl_info *gl_info;
@@ -1206,6 +1381,12 @@ void wined3d_buffer_copy(struct wined3d_buffer *dst_buffer, unsigned int dst_off
     context = context_acquire(dst_buffer->resource.device, NULL, 0);
     context_copy_bo_address(context, &dst, dst_buffer->buffer_type_hint,
             &src, src_buffer->buffer_type_hint, size);
+    /* Draws issue the fences of persistently mapped buffers, copies need to
+     * do the same. */
+    if ((dst_buffer->flags & WINED3D_BUFFER_PERSISTENT) && dst_buffer->fence)
+        wined3d_fence_issue(dst_buffer->fence, dst_buffer->resource.device);
+    if ((src_buffer->flags & WINED3D_BUFFER_PERSISTENT) && src_buffer->fence)
+        wined3d_fence_issue(src_buffer->fence, src_buffer->resource.device);
     context_release(context);
 
     wined3d_buffer_invalidate_range(dst_buffer, ~dst_location, dst_offset, size);
@@ -1393,6 +1574,19 @@ static HRESULT buffer_init(struct wined3d_buffer *buffer, struct wined3d_device
     else
     {
         buffer->flags |= WINED3D_BUFFER_USE_BO;
+
+        /* Dynamic vertex and index buffers are only read by draws, which
+         * issue the buffer fence. That's enough to know when maps need to
+         * wait for the GPU, so map those buffers once and keep them mapped. */
+        if ((buffer->resource.usage & WINED3DUSAGE_DYNAMIC)
+                && !(buffer->flags & WINED3D_BUFFER_PIN_SYSMEM)
+                && bind_flags && !(bind_flags & ~(WINED3D_BIND_VERTEX_BUFFER | WINED3D_BIND_INDEX_BUFFER))
+                && gl_info->supported[ARB_BUFFER_STORAGE] && gl_info->supported[ARB_MAP_BUFFER_RANGE]
+                && gl_info->supported[ARB_SYNC])
+        {
+            TRACE("Using a persistently mapped BO.\n");
+            buffer->flags |= WINED3D_BUFFER_PERSISTENT;
+        }
     }
 
     if (!(buffer->maps = heap_alloc(sizeof(*buffer->maps))))
@@ -495,6 +495,29 @@ static inline void context_set_fbo_key_for_render_target(const struct wined3d_co
     }
 }
 
+/* FNV-1a over the attachment objects that are actually in use. */
+static unsigned int context_hash_fbo_key(const struct wined3d_fbo_entry_key *key, unsigned int buffers)
+{
+    const BYTE *data = (const BYTE *)key;
+    unsigned int hash = 2166136261u;
+    SIZE_T i, size;
+
+    size = FIELD_OFFSET(struct wined3d_fbo_entry_key, objects[buffers + 1]);
+    for (i = 0; i < size; ++i)
+    {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static void context_add_fbo_entry_hash(struct wined3d_context *context, struct fbo_entry *entry)
+{
+    entry->hash = context_hash_fbo_key(&entry->key, context->gl_info->limits.buffers);
+    list_add_head(&context->fbo_hash[entry->hash % WINED3D_FBO_HASH_SIZE], &entry->hash_entry);
+}
+
 static void context_generate_fbo_key(const struct wined3d_context *context,
         struct wined3d_fbo_entry_key *key, const struct wined3d_rendertarget_info *render_targets,
         const struct wined3d_rendertarget_info *depth_stencil, DWORD color_location, DWORD ds_location)
@@ -546,7 +569,9 @@ static void context_reuse_fbo_entry(struct wined3d_context *context, GLenum targ
     context_bind_fbo(context, target, entry->id);
     context_clean_fbo_attachments(gl_info, target);
 
+    list_remove(&entry->hash_entry);
     context_generate_fbo_key(context, &entry->key, render_targets, depth_stencil, color_location, ds_location);
+    context_add_fbo_entry_hash(context, entry);
     entry->flags = 0;
     if (depth_stencil->resource)
     {
@@ -567,6 +592,7 @@ static void context_destroy_fbo_entry(struct wined3d_context *context, struct fb
     }
     --context->fbo_entry_count;
     list_remove(&entry->entry);
+    list_remove(&entry->hash_entry);
     heap_free(entry);
 }
 
@@ -578,8 +604,8 @@ static struct fbo_entry *context_find_fbo_entry(struct wined3d_context *context,
     static const struct wined3d_rendertarget_info ds_null = {{0}};
     const struct wined3d_gl_info *gl_info = context->gl_info;
     struct wined3d_texture *rt_texture, *ds_texture;
+    unsigned int i, ds_level, rt_level, hash;
     struct wined3d_fbo_entry_key fbo_key;
-    unsigned int i, ds_level, rt_level;
     struct fbo_entry *entry;
 
     if (depth_stencil->resource && depth_stencil->resource->type != WINED3D_RTYPE_BUFFER
@@ -670,9 +696,10 @@ static struct fbo_entry *context_find_fbo_entry(struct wined3d_context *context,
         }
     }
 
-    LIST_FOR_EACH_ENTRY(entry, &context->fbo_list, struct fbo_entry, entry)
+    hash = context_hash_fbo_key(&fbo_key, gl_info->limits.buffers);
+    LIST_FOR_EACH_ENTRY(entry, &context->fbo_hash[hash % WINED3D_FBO_HASH_SIZE], struct fbo_entry, hash_entry)
     {
-        if (memcmp(&fbo_key, &entry->key, sizeof(fbo_key)))
+        if (entry->hash != hash || memcmp(&fbo_key, &entry->key, sizeof(fbo_key)))
             continue;
 
         list_remove(&entry->entry);
@@ -684,10 +711,12 @@ static struct fbo_entry *context_find_fbo_entry(struct wined3d_context *context,
     {
         entry = context_create_fbo_entry(context, render_targets, depth_stencil, color_location, ds_location);
         list_add_head(&context->fbo_list, &entry->entry);
+        context_add_fbo_entry_hash(context, entry);
         ++context->fbo_entry_count;
     }
     else
     {
+        /* Evict the least recently used entry. */
         entry = LIST_ENTRY(list_tail(&context->fbo_list), struct fbo_entry, entry);
         context_reuse_fbo_entry(context, target, render_targets, depth_stencil, color_location, ds_location, entry);
         list_remove(&entry->entry);
@@ -1061,6 +1090,8 @@ static void context_queue_fbo_entry_destruction(struct wined3d_context *context,
 {
     list_remove(&entry->entry);
     list_add_head(&context->fbo_destroy_list, &entry->entry);
+    list_remove(&entry->hash_entry);
+    list_init(&entry->hash_entry);
 }
 
 void context_resource_released(const struct wined3d_device *device, struct wined3d_resource *resource)
@@ -1915,6 +1946,8 @@ struct wined3d_context *context_create(struct wined3d_swapchain *swapchain,
 
     list_init(&ret->fbo_list);
     list_init(&ret->fbo_destroy_list);
+    for (i = 0; i < ARRAY_SIZE(ret->fbo_hash); ++i)
+        list_init(&ret->fbo_hash[i]);
 
     if (!device->shader_backend->shader_allocate_context_data(ret))
     {
@@ -2230,6 +2263,9 @@ struct wined3d_context *context_create(struct wined3d_swapchain *swapchain,
     }
     if (gl_info->supported[ARB_CLIP_CONTROL])
         GL_EXTCALL(glPointParameteri(GL_POINT_SPRITE_COORD_ORIGIN, GL_LOWER_LEFT));
+    /* Let the driver compile shaders in its own threads, as many as it wants. */
+    if (gl_info->supported[ARB_PARALLEL_SHADER_COMPILE])
+        GL_EXTCALL(glMaxShaderCompilerThreadsARB(~0u));
     device->shader_backend->shader_init_context_state(ret);
     ret->shader_update_mask = (1u << WINED3D_SHADER_TYPE_PIXEL)
             | (1u << WINED3D_SHADER_TYPE_VERTEX)
@@ -3961,6 +3997,9 @@ static BOOL context_apply_draw_state(struct wined3d_context *context,
             wined3d_buffer_load_sysmem(state->index_buffer, context);
     }
 
+    if (device->cs->profiler)
+        wined3d_cs_profile_state_changes(device->cs, context->numDirtyEntries);
+
     for (i = 0; i < context->numDirtyEntries; ++i)
     {
         DWORD rep = context->dirtyArray[i];
@@ -3973,6 +4012,14 @@ static BOOL context_apply_draw_state(struct wined3d_context *context,
     if (context->shader_update_mask & ~(1u << WINED3D_SHADER_TYPE_COMPUTE))
     {
         device->shader_backend->shader_select(device->shader_priv, context, state);
+        if (context->shader_compile_pending)
+        {
+            /* The shaders are selected again on the next draw. */
+            TRACE("Shaders are still compiling, skipping draw.\n");
+            context->shader_compile_pending = 0;
+            context->numDirtyEntries = 0;
+            return FALSE;
+        }
         context->shader_update_mask &= 1u << WINED3D_SHADER_TYPE_COMPUTE;
     }
 
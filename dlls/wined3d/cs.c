@@ -50,9 +50,7 @@ enum wined3d_cs_op
     WINED3D_CS_OP_SET_SHADER,
     WINED3D_CS_OP_SET_BLEND_STATE,
     WINED3D_CS_OP_SET_RASTERIZER_STATE,
-    WINED3D_CS_OP_SET_RENDER_STATE,
-    WINED3D_CS_OP_SET_TEXTURE_STATE,
-    WINED3D_CS_OP_SET_SAMPLER_STATE,
+    WINED3D_CS_OP_SET_STATES,
     WINED3D_CS_OP_SET_TRANSFORM,
     WINED3D_CS_OP_SET_CLIP_PLANE,
     WINED3D_CS_OP_SET_COLOR_KEY,
@@ -275,27 +273,11 @@ struct wined3d_cs_set_rasterizer_state
     struct wined3d_rasterizer_state *state;
 };
 
-struct wined3d_cs_set_render_state
+struct wined3d_cs_set_states
 {
     enum wined3d_cs_op opcode;
-    enum wined3d_render_state state;
-    DWORD value;
-};
-
-struct wined3d_cs_set_texture_state
-{
-    enum wined3d_cs_op opcode;
-    UINT stage;
-    enum wined3d_texture_stage_state state;
-    DWORD value;
-};
-
-struct wined3d_cs_set_sampler_state
-{
-    enum wined3d_cs_op opcode;
-    UINT sampler_idx;
-    enum wined3d_sampler_state state;
-    DWORD value;
+    unsigned int count;
+    struct wined3d_cs_state_update states[1];
 };
 
 struct wined3d_cs_set_transform
@@ -469,6 +451,30 @@ struct wined3d_cs_stop
     enum wined3d_cs_op opcode;
 };
 
+/* Wait for the CS thread to retire a packet from "queue", unless it already
+ * did so since "tail" was read. Producers are serialised by the wined3d
+ * mutex, so there's at most one thread waiting here. */
+static void wined3d_cs_wait_progress(struct wined3d_cs *cs, const struct wined3d_cs_queue *queue,
+        LONG tail, unsigned int *spin_count)
+{
+    if (++*spin_count < cs->producer_spin_count)
+    {
+        wined3d_pause();
+        return;
+    }
+
+    InterlockedExchange(&cs->waiting_for_progress, TRUE);
+
+    /* Like in wined3d_cs_wait_event(), the CS thread may have retired the
+     * packet before "waiting_for_progress" was set, or it may have reset it
+     * and called SetEvent() in the meantime. */
+    if (*(volatile LONG *)&queue->tail != tail
+            && InterlockedCompareExchange(&cs->waiting_for_progress, FALSE, TRUE))
+        return;
+
+    WaitForSingleObject(cs->progress_event, INFINITE);
+}
+
 static void wined3d_cs_exec_nop(struct wined3d_cs *cs, const void *data)
 {
 }
@@ -484,6 +490,9 @@ static void wined3d_cs_exec_present(struct wined3d_cs *cs, const void *data)
     wined3d_swapchain_set_swap_interval(swapchain, op->swap_interval);
 
     swapchain->swapchain_ops->swapchain_present(swapchain, &op->src_rect, &op->dst_rect, op->flags);
+    wined3d_upload_ring_end_frame(cs->device);
+    if (swapchain->frame_latency_semaphore)
+        ReleaseSemaphore(swapchain->frame_latency_semaphore, 1, NULL);
 
     wined3d_resource_release(&swapchain->front_buffer->resource);
     for (i = 0; i < swapchain->desc.backbuffer_count; ++i)
@@ -498,9 +507,10 @@ void wined3d_cs_emit_present(struct wined3d_cs *cs, struct wined3d_swapchain *sw
         const RECT *src_rect, const RECT *dst_rect, HWND dst_window_override,
         unsigned int swap_interval, DWORD flags)
 {
+    struct wined3d_cs_queue *queue = &cs->queue[WINED3D_CS_QUEUE_DEFAULT];
+    unsigned int i, spin_count = 0;
     struct wined3d_cs_present *op;
-    unsigned int i;
-    LONG pending;
+    LONG pending, tail, max_latency;
 
     op = cs->ops->require_space(cs, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
     op->opcode = WINED3D_CS_OP_PRESENT;
@@ -522,12 +532,14 @@ void wined3d_cs_emit_present(struct wined3d_cs *cs, struct wined3d_swapchain *sw
     cs->ops->submit(cs, WINED3D_CS_QUEUE_DEFAULT);
 
     /* Limit input latency by limiting the number of presents that we can get
-     * ahead of the worker thread. We have a constant limit here, but
-     * IDXGIDevice1 allows tuning this. */
-    while (pending > 1)
+     * ahead of the worker thread. */
+    max_latency = cs->device->max_frame_latency;
+    while (pending > max_latency)
     {
-        wined3d_pause();
-        pending = InterlockedCompareExchange(&cs->pending_presents, 0, 0);
+        tail = *(volatile LONG *)&queue->tail;
+        if ((pending = InterlockedCompareExchange(&cs->pending_presents, 0, 0)) <= max_latency)
+            break;
+        wined3d_cs_wait_progress(cs, queue, tail, &spin_count);
     }
 }
 
@@ -907,6 +919,65 @@ static void acquire_graphics_pipeline_resources(const struct wined3d_state *stat
             state->unordered_access_view[WINED3D_PIPELINE_GRAPHICS]);
 }
 
+static void wined3d_cs_flush_state_updates(struct wined3d_cs *cs);
+
+void wined3d_cs_flush_pending_draw(struct wined3d_cs *cs)
+{
+    struct wined3d_cs_draw *op;
+
+    if (!cs->has_pending_draw)
+        return;
+    cs->has_pending_draw = FALSE;
+
+    op = cs->ops->require_space(cs, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
+    op->opcode = WINED3D_CS_OP_DRAW;
+    op->primitive_type = cs->pending_draw_primitive_type;
+    op->patch_vertex_count = cs->pending_draw_patch_vertex_count;
+    op->parameters = cs->pending_draw;
+
+    cs->ops->submit(cs, WINED3D_CS_QUEUE_DEFAULT);
+}
+
+/* Draws of independent primitives can be held back and merged with the next
+ * draw if nothing is emitted in between, since the state is then the same.
+ * Merging changes primitive IDs, so don't do it when a shader may read them. */
+static BOOL wined3d_cs_can_defer_draw(const struct wined3d_cs *cs, GLenum primitive_type)
+{
+    const struct wined3d_state *state = &cs->device->state;
+    const struct wined3d_shader *ps;
+
+    if (!cs->thread || cs->thread_id == GetCurrentThreadId())
+        return FALSE;
+
+    if (primitive_type != GL_POINTS && primitive_type != GL_LINES && primitive_type != GL_TRIANGLES)
+        return FALSE;
+
+    if (state->shader[WINED3D_SHADER_TYPE_GEOMETRY] || state->shader[WINED3D_SHADER_TYPE_HULL]
+            || state->shader[WINED3D_SHADER_TYPE_DOMAIN])
+        return FALSE;
+
+    return !(ps = state->shader[WINED3D_SHADER_TYPE_PIXEL]) || ps->reg_maps.shader_version.major < 4;
+}
+
+static BOOL wined3d_cs_merge_draw(struct wined3d_cs *cs, GLenum primitive_type, unsigned int patch_vertex_count,
+        int base_vertex_idx, unsigned int start_idx, unsigned int index_count,
+        unsigned int start_instance, unsigned int instance_count, BOOL indexed)
+{
+    struct wined3d_direct_draw_parameters *direct = &cs->pending_draw.u.direct;
+
+    if (!cs->has_pending_draw || cs->pending_draw_primitive_type != primitive_type
+            || cs->pending_draw_patch_vertex_count != patch_vertex_count
+            || cs->pending_draw.indexed != indexed || direct->base_vertex_idx != base_vertex_idx
+            || direct->start_instance != start_instance || direct->instance_count != instance_count
+            || direct->start_idx + direct->index_count != start_idx)
+        return FALSE;
+
+    TRACE("Merging draw %u+%u into %u+%u.
+", start_idx, index_count, direct->start_idx, direct->index_count);
+    direct->index_count += index_count;
+    return TRUE;
+}
+
 void wined3d_cs_emit_draw(struct wined3d_cs *cs, GLenum primitive_type, unsigned int patch_vertex_count,
         int base_vertex_idx, unsigned int start_idx, unsigned int index_count,
         unsigned int start_instance, unsigned int instance_count, BOOL indexed)
@@ -915,6 +986,31 @@ void wined3d_cs_emit_draw(struct wined3d_cs *cs, GLenum primitive_type, unsigned
     const struct wined3d_state *state = &cs->device->state;
     struct wined3d_cs_draw *op;
 
+    if (wined3d_cs_merge_draw(cs, primitive_type, patch_vertex_count, base_vertex_idx,
+            start_idx, index_count, start_instance, instance_count, indexed))
+        return;
+
+    if (wined3d_cs_can_defer_draw(cs, primitive_type))
+    {
+        /* The held back draw has to stay behind any state set before it. */
+        wined3d_cs_flush_pending_draw(cs);
+        wined3d_cs_flush_state_updates(cs);
+
+        cs->pending_draw_primitive_type = primitive_type;
+        cs->pending_draw_patch_vertex_count = patch_vertex_count;
+        cs->pending_draw.indirect = FALSE;
+        cs->pending_draw.u.direct.base_vertex_idx = base_vertex_idx;
+        cs->pending_draw.u.direct.start_idx = start_idx;
+        cs->pending_draw.u.direct.index_count = index_count;
+        cs->pending_draw.u.direct.start_instance = start_instance;
+        cs->pending_draw.u.direct.instance_count = instance_count;
+        cs->pending_draw.indexed = indexed;
+        cs->has_pending_draw = TRUE;
+
+        acquire_graphics_pipeline_resources(state, indexed, gl_info);
+        return;
+    }
+
     op = cs->ops->require_space(cs, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
     op->opcode = WINED3D_CS_OP_DRAW;
     op->primitive_type = primitive_type;
@@ -1532,68 +1628,121 @@ void wined3d_cs_emit_set_rasterizer_state(struct wined3d_cs *cs,
     cs->ops->submit(cs, WINED3D_CS_QUEUE_DEFAULT);
 }
 
-static void wined3d_cs_exec_set_render_state(struct wined3d_cs *cs, const void *data)
+static void wined3d_cs_exec_set_states(struct wined3d_cs *cs, const void *data)
 {
-    const struct wined3d_cs_set_render_state *op = data;
+    const struct wined3d_cs_set_states *op = data;
+    const struct wined3d_cs_state_update *update;
+    unsigned int i;
 
-    cs->state.render_states[op->state] = op->value;
-    device_invalidate_state(cs->device, STATE_RENDER(op->state));
+    for (i = 0; i < op->count; ++i)
+    {
+        update = &op->states[i];
+        switch (update->type)
+        {
+            case WINED3D_CS_STATE_RENDER:
+                cs->state.render_states[update->state] = update->value;
+                device_invalidate_state(cs->device, STATE_RENDER(update->state));
+                break;
+
+            case WINED3D_CS_STATE_TEXTURE:
+                cs->state.texture_states[update->idx][update->state] = update->value;
+                device_invalidate_state(cs->device, STATE_TEXTURESTAGE(update->idx, update->state));
+                break;
+
+            case WINED3D_CS_STATE_SAMPLER:
+                cs->state.sampler_states[update->idx][update->state] = update->value;
+                device_invalidate_state(cs->device, STATE_SAMPLER(update->idx));
+                break;
+        }
+    }
 }
 
-void wined3d_cs_emit_set_render_state(struct wined3d_cs *cs, enum wined3d_render_state state, DWORD value)
+static void wined3d_cs_emit_set_states(struct wined3d_cs *cs,
+        const struct wined3d_cs_state_update *updates, unsigned int count)
 {
-    struct wined3d_cs_set_render_state *op;
+    struct wined3d_cs_set_states *op;
 
-    op = cs->ops->require_space(cs, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
-    op->opcode = WINED3D_CS_OP_SET_RENDER_STATE;
-    op->state = state;
-    op->value = value;
+    op = cs->ops->require_space(cs, FIELD_OFFSET(struct wined3d_cs_set_states, states[count]),
+            WINED3D_CS_QUEUE_DEFAULT);
+    op->opcode = WINED3D_CS_OP_SET_STATES;
+    op->count = count;
+    memcpy(op->states, updates, count * sizeof(*op->states));
 
     cs->ops->submit(cs, WINED3D_CS_QUEUE_DEFAULT);
 }
 
-static void wined3d_cs_exec_set_texture_state(struct wined3d_cs *cs, const void *data)
+/* Send the state updates queued by wined3d_cs_queue_state_update() to the
+ * CS. This is called before any other packet is queued, so the updates are
+ * still executed in order. */
+static void wined3d_cs_flush_state_updates(struct wined3d_cs *cs)
 {
-    const struct wined3d_cs_set_texture_state *op = data;
+    unsigned int count;
+
+    if (!(count = cs->state_update_count))
+        return;
+    cs->state_update_count = 0;
 
-    cs->state.texture_states[op->stage][op->state] = op->value;
-    device_invalidate_state(cs->device, STATE_TEXTURESTAGE(op->stage, op->state));
+    wined3d_cs_emit_set_states(cs, cs->state_updates, count);
 }
 
-void wined3d_cs_emit_set_texture_state(struct wined3d_cs *cs, UINT stage,
-        enum wined3d_texture_stage_state state, DWORD value)
+static void wined3d_cs_queue_state_update(struct wined3d_cs *cs, enum wined3d_cs_state_type type,
+        unsigned int idx, unsigned int state, DWORD value)
 {
-    struct wined3d_cs_set_texture_state *op;
+    struct wined3d_cs_state_update *update;
+    unsigned int i;
 
-    op = cs->ops->require_space(cs, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
-    op->opcode = WINED3D_CS_OP_SET_TEXTURE_STATE;
-    op->stage = stage;
-    op->state = state;
-    op->value = value;
+    /* The queued updates belong to the application thread, so don't batch
+     * the updates the CS thread emits itself. */
+    if (cs->thread_id == GetCurrentThreadId())
+    {
+        struct wined3d_cs_state_update single;
 
-    cs->ops->submit(cs, WINED3D_CS_QUEUE_DEFAULT);
+        single.type = type;
+        single.idx = idx;
+        single.state = state;
+        single.value = value;
+        wined3d_cs_emit_set_states(cs, &single, 1);
+        return;
+    }
+
+    wined3d_cs_flush_pending_draw(cs);
+
+    /* A later update of the same state replaces the earlier one. */
+    for (i = 0; i < cs->state_update_count; ++i)
+    {
+        update = &cs->state_updates[i];
+        if (update->type == type && update->idx == idx && update->state == state)
+        {
+            update->value = value;
+            return;
+        }
+    }
+
+    if (cs->state_update_count == ARRAY_SIZE(cs->state_updates))
+        wined3d_cs_flush_state_updates(cs);
+
+    update = &cs->state_updates[cs->state_update_count++];
+    update->type = type;
+    update->idx = idx;
+    update->state = state;
+    update->value = value;
 }
 
-static void wined3d_cs_exec_set_sampler_state(struct wined3d_cs *cs, const void *data)
+void wined3d_cs_emit_set_render_state(struct wined3d_cs *cs, enum wined3d_render_state state, DWORD value)
 {
-    const struct wined3d_cs_set_sampler_state *op = data;
+    wined3d_cs_queue_state_update(cs, WINED3D_CS_STATE_RENDER, 0, state, value);
+}
 
-    cs->state.sampler_states[op->sampler_idx][op->state] = op->value;
-    device_invalidate_state(cs->device, STATE_SAMPLER(op->sampler_idx));
+void wined3d_cs_emit_set_texture_state(struct wined3d_cs *cs, UINT stage,
+        enum wined3d_texture_stage_state state, DWORD value)
+{
+    wined3d_cs_queue_state_update(cs, WINED3D_CS_STATE_TEXTURE, stage, state, value);
 }
 
 void wined3d_cs_emit_set_sampler_state(struct wined3d_cs *cs, UINT sampler_idx,
         enum wined3d_sampler_state state, DWORD value)
 {
-    struct wined3d_cs_set_sampler_state *op;
-
-    op = cs->ops->require_space(cs, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
-    op->opcode = WINED3D_CS_OP_SET_SAMPLER_STATE;
-    op->sampler_idx = sampler_idx;
-    op->state = state;
-    op->value = value;
-
-    cs->ops->submit(cs, WINED3D_CS_QUEUE_DEFAULT);
+    wined3d_cs_queue_state_update(cs, WINED3D_CS_STATE_SAMPLER, sampler_idx, state, value);
 }
 
 static void wined3d_cs_exec_set_transform(struct wined3d_cs *cs, const void *data)
@@ -2227,12 +2376,29 @@ void wined3d_cs_emit_blt_sub_resource(struct wined3d_cs *cs, struct wined3d_reso
         cs->ops->finish(cs, WINED3D_CS_QUEUE_DEFAULT);
 }
 
+static unsigned int wined3d_cs_get_update_size(const struct wined3d_format *format,
+        const struct wined3d_box *box, unsigned int row_pitch, unsigned int slice_pitch)
+{
+    unsigned int width = box->right - box->left, height = box->bottom - box->top;
+    unsigned int depth = box->back - box->front;
+    unsigned int row_size, slice_size, row_count;
+
+    if (!width || !height || !depth)
+        return 0;
+
+    wined3d_format_calculate_pitch(format, 1, width, height, &row_size, &slice_size);
+    row_count = (height + format->block_height - 1) / format->block_height;
+
+    return (depth - 1) * slice_pitch + (row_count - 1) * row_pitch + row_size;
+}
+
 static void wined3d_cs_exec_update_sub_resource(struct wined3d_cs *cs, const void *data)
 {
     const struct wined3d_cs_update_sub_resource *op = data;
     struct wined3d_resource *resource = op->resource;
     const struct wined3d_box *box = &op->box;
     unsigned int width, height, depth, level;
+    const struct wined3d_format *format;
     struct wined3d_const_bo_address addr;
     struct wined3d_context *context;
     struct wined3d_texture *texture;
@@ -2262,8 +2428,16 @@ static void wined3d_cs_exec_update_sub_resource(struct wined3d_cs *cs, const voi
     height = wined3d_texture_get_level_height(texture, level);
     depth = wined3d_texture_get_level_depth(texture, level);
 
-    addr.buffer_object = 0;
-    addr.addr = op->data.data;
+    /* Stage the data in the upload ring if it can be uploaded as is. This
+     * includes compressed formats, which never need conversion. */
+    format = texture->resource.format;
+    if (format->upload || format->flags[WINED3D_GL_RES_TYPE_TEX_2D] & WINED3DFMT_FLAG_HEIGHT_SCALE
+            || !wined3d_texture_stage_upload(cs->device, context, op->data.data,
+            wined3d_cs_get_update_size(format, box, op->data.row_pitch, op->data.slice_pitch), &addr))
+    {
+        addr.buffer_object = 0;
+        addr.addr = op->data.data;
+    }
 
     /* Only load the sub-resource for partial updates. */
     if (!box->left && !box->top && !box->front
@@ -2274,7 +2448,7 @@ static void wined3d_cs_exec_update_sub_resource(struct wined3d_cs *cs, const voi
     wined3d_texture_bind_and_dirtify(texture, context, FALSE);
 
     wined3d_box_set(&src_box, 0, 0, box->right - box->left, box->bottom - box->top, 0, box->back - box->front);
-    wined3d_texture_upload_data(texture, op->sub_resource_idx, context, texture->resource.format, &src_box,
+    wined3d_texture_upload_data(texture, op->sub_resource_idx, context, format, &src_box,
             &addr, op->data.row_pitch, op->data.slice_pitch, box->left, box->top, box->front, FALSE);
 
     wined3d_texture_validate_location(texture, op->sub_resource_idx, WINED3D_LOCATION_TEXTURE_RGB);
@@ -2525,7 +2699,11 @@ static void wined3d_cs_emit_stop(struct wined3d_cs *cs)
     op->opcode = WINED3D_CS_OP_STOP;
 
     cs->ops->submit(cs, WINED3D_CS_QUEUE_DEFAULT);
-    cs->ops->finish(cs, WINED3D_CS_QUEUE_DEFAULT);
+
+    /* The CS thread doesn't signal progress for the stop packet, because
+     * "cs" may be freed as soon as the queue is empty. */
+    while (cs->queue[WINED3D_CS_QUEUE_DEFAULT].head != *(volatile LONG *)&cs->queue[WINED3D_CS_QUEUE_DEFAULT].tail)
+        wined3d_pause();
 }
 
 static void (* const wined3d_cs_op_handlers[])(struct wined3d_cs *cs, const void *data) =
@@ -2554,9 +2732,7 @@ static void (* const wined3d_cs_op_handlers[])(struct wined3d_cs *cs, const void
     /* WINED3D_CS_OP_SET_SHADER                  */ wined3d_cs_exec_set_shader,
     /* WINED3D_CS_OP_SET_BLEND_STATE             */ wined3d_cs_exec_set_blend_state,
     /* WINED3D_CS_OP_SET_RASTERIZER_STATE        */ wined3d_cs_exec_set_rasterizer_state,
-    /* WINED3D_CS_OP_SET_RENDER_STATE            */ wined3d_cs_exec_set_render_state,
-    /* WINED3D_CS_OP_SET_TEXTURE_STATE           */ wined3d_cs_exec_set_texture_state,
-    /* WINED3D_CS_OP_SET_SAMPLER_STATE           */ wined3d_cs_exec_set_sampler_state,
+    /* WINED3D_CS_OP_SET_STATES                  */ wined3d_cs_exec_set_states,
     /* WINED3D_CS_OP_SET_TRANSFORM               */ wined3d_cs_exec_set_transform,
     /* WINED3D_CS_OP_SET_CLIP_PLANE              */ wined3d_cs_exec_set_clip_plane,
     /* WINED3D_CS_OP_SET_COLOR_KEY               */ wined3d_cs_exec_set_color_key,
@@ -2582,8 +2758,325 @@ static void (* const wined3d_cs_op_handlers[])(struct wined3d_cs *cs, const void
     /* WINED3D_CS_OP_WAIT_IDLE                   */ wined3d_cs_exec_wait_idle,
 };
 
+static const char * const wined3d_cs_op_names[] =
+{
+    "nop", "present", "clear", "dispatch", "draw", "flush", "set_predication", "set_viewports",
+    "set_scissor_rects", "set_rendertarget_view", "set_depth_stencil_view", "set_vertex_declaration",
+    "set_stream_source", "set_stream_source_freq", "set_stream_output", "set_index_buffer",
+    "set_constant_buffer", "set_texture", "set_shader_resource_view", "set_unordered_access_view",
+    "set_sampler", "set_shader", "set_blend_state", "set_rasterizer_state", "set_states",
+    "set_transform", "set_clip_plane", "set_color_key",
+    "set_material", "set_light", "set_light_enable", "push_constants", "reset_state", "callback",
+    "query_issue", "preload_resource", "unload_resource", "map", "unmap", "blt_sub_resource",
+    "update_sub_resource", "add_dirty_texture_region", "clear_unordered_access_view", "copy_uav_counter",
+    "generate_mipmaps", "gl_texture_callback", "user_callback", "wait_idle",
+};
+
+#define WINED3D_PROFILER_FRAME_COUNT        4u
+#define WINED3D_PROFILER_GPU_EVENT_COUNT    512u
+
+struct wined3d_profiler_gpu_event
+{
+    enum wined3d_cs_op opcode;
+    struct wined3d_timestamp_query start, end;
+};
+
+struct wined3d_profiler_frame
+{
+    unsigned int id;
+    LONGLONG start_time, end_time;
+    LONGLONG cpu_time[WINED3D_CS_OP_STOP];
+    unsigned int op_count[WINED3D_CS_OP_STOP];
+    unsigned int state_changes;
+
+    /* GL_TIMESTAMP and the performance counter, read at the same time. */
+    GLint64 gpu_base;
+    LONGLONG cpu_base;
+
+    unsigned int gpu_event_count;
+    struct wined3d_profiler_gpu_event gpu_events[WINED3D_PROFILER_GPU_EVENT_COUNT];
+};
+
+struct wined3d_profiler
+{
+    HANDLE file;
+    LONGLONG frequency;
+    BOOL gpu_timing;
+    unsigned int frame_id;
+    unsigned int frame_idx;
+    struct wined3d_profiler_frame frames[WINED3D_PROFILER_FRAME_COUNT];
+};
+
+static BOOL wined3d_profiler_is_gpu_op(enum wined3d_cs_op opcode)
+{
+    switch (opcode)
+    {
+        case WINED3D_CS_OP_PRESENT:
+        case WINED3D_CS_OP_CLEAR:
+        case WINED3D_CS_OP_DISPATCH:
+        case WINED3D_CS_OP_DRAW:
+        case WINED3D_CS_OP_BLT_SUB_RESOURCE:
+        case WINED3D_CS_OP_CLEAR_UNORDERED_ACCESS_VIEW:
+            return TRUE;
+
+        default:
+            return FALSE;
+    }
+}
+
+static struct wined3d_profiler *wined3d_profiler_create(const struct wined3d_gl_info *gl_info)
+{
+    static const char header[] = "[\n";
+    struct wined3d_profiler *profiler;
+    LARGE_INTEGER frequency;
+    DWORD size;
+
+    if (!(profiler = heap_alloc_zero(sizeof(*profiler))))
+        return NULL;
+
+    if ((profiler->file = CreateFileA(wined3d_settings.cs_profile_file, GENERIC_WRITE,
+            FILE_SHARE_READ, NULL, CREATE_ALWAYS, 0, NULL)) == INVALID_HANDLE_VALUE)
+    {
+        WARN("Failed to create %s, error %u.\n", debugstr_a(wined3d_settings.cs_profile_file), GetLastError());
+        heap_free(profiler);
+        return NULL;
+    }
+
+    /* The trailing "]" is optional in the Chrome trace event format, which
+     * means an interrupted trace is still usable. */
+    WriteFile(profiler->file, header, sizeof(header) - 1, &size, NULL);
+
+    QueryPerformanceFrequency(&frequency);
+    profiler->frequency = frequency.QuadPart;
+    profiler->gpu_timing = gl_info->supported[ARB_TIMER_QUERY];
+    if (!profiler->gpu_timing)
+        WARN("GL_ARB_timer_query not supported, not measuring GPU time.\n");
+
+    profiler->frames[0].id = ++profiler->frame_id;
+    QueryPerformanceCounter(&frequency);
+    profiler->frames[0].start_time = frequency.QuadPart;
+
+    TRACE("Writing command stream profile to %s.\n", debugstr_a(wined3d_settings.cs_profile_file));
+
+    return profiler;
+}
+
+static double wined3d_profiler_cpu_us(const struct wined3d_profiler *profiler, LONGLONG ticks)
+{
+    return ticks * 1000000.0 / profiler->frequency;
+}
+
+static void wined3d_profiler_write(struct wined3d_profiler *profiler, const char *format, ...)
+{
+    char buffer[256];
+    va_list args;
+    DWORD size;
+    int len;
+
+    va_start(args, format);
+    len = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (len < 0 || len >= (int)sizeof(buffer))
+    {
+        ERR("Trace event too long.\n");
+        return;
+    }
+
+    WriteFile(profiler->file, buffer, len, &size, NULL);
+}
+
+/* Context activation is done by the caller. */
+static void wined3d_profiler_issue_timestamp(struct wined3d_context *context, struct wined3d_timestamp_query *query)
+{
+    const struct wined3d_gl_info *gl_info = context->gl_info;
+
+    context_alloc_timestamp_query(context, query);
+    GL_EXTCALL(glQueryCounter(query->id, GL_TIMESTAMP));
+    checkGLcall("glQueryCounter");
+}
+
+static BOOL wined3d_profiler_get_timestamp(const struct wined3d_device *device,
+        struct wined3d_timestamp_query *query, GLuint64 *timestamp)
+{
+    const struct wined3d_gl_info *gl_info;
+    struct wined3d_context *context;
+
+    if (!query->context)
+        return FALSE;
+
+    if (!(context = context_reacquire(device, query->context)))
+    {
+        WARN("Failed to acquire the context of query %u.\n", query->id);
+        context_free_timestamp_query(query);
+        return FALSE;
+    }
+    gl_info = context->gl_info;
+
+    GL_EXTCALL(glGetQueryObjectui64v(query->id, GL_QUERY_RESULT, timestamp));
+    checkGLcall("glGetQueryObjectui64v(GL_QUERY_RESULT)");
+    context_free_timestamp_query(query);
+    context_release(context);
+
+    return TRUE;
+}
+
+static void wined3d_profiler_write_frame(struct wined3d_cs *cs, struct wined3d_profiler_frame *frame)
+{
+    struct wined3d_profiler *profiler = cs->profiler;
+    double start = wined3d_profiler_cpu_us(profiler, frame->start_time);
+    double end = wined3d_profiler_cpu_us(profiler, frame->end_time);
+    struct wined3d_profiler_gpu_event *event;
+    GLuint64 gpu_start, gpu_end;
+    unsigned int i;
+    BOOL have_start;
+
+    wined3d_profiler_write(profiler, "{\"name\":\"frame %u\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+            "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"state_changes\":%u}},\n",
+            frame->id, start, end - start, frame->state_changes);
+    wined3d_profiler_write(profiler, "{\"name\":\"state changes\",\"ph\":\"C\",\"pid\":1,"
+            "\"ts\":%.3f,\"args\":{\"count\":%u}},\n", start, frame->state_changes);
+
+    for (i = 0; i < WINED3D_CS_OP_STOP; ++i)
+    {
+        if (!frame->op_count[i])
+            continue;
+        wined3d_profiler_write(profiler, "{\"name\":\"cpu %s\",\"ph\":\"C\",\"pid\":1,"
+                "\"ts\":%.3f,\"args\":{\"us\":%.3f,\"count\":%u}},\n", wined3d_cs_op_names[i],
+                start, wined3d_profiler_cpu_us(profiler, frame->cpu_time[i]), frame->op_count[i]);
+    }
+
+    for (i = 0; i < frame->gpu_event_count; ++i)
+    {
+        event = &frame->gpu_events[i];
+        have_start = wined3d_profiler_get_timestamp(cs->device, &event->start, &gpu_start);
+        if (!wined3d_profiler_get_timestamp(cs->device, &event->end, &gpu_end) || !have_start)
+            continue;
+
+        /* GPU timestamps are in nanoseconds. */
+        wined3d_profiler_write(profiler, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":2,"
+                "\"ts\":%.3f,\"dur\":%.3f},\n", wined3d_cs_op_names[event->opcode],
+                wined3d_profiler_cpu_us(profiler, frame->cpu_base) + (GLint64)(gpu_start - frame->gpu_base) / 1000.0,
+                (gpu_end - gpu_start) / 1000.0);
+    }
+}
+
+static void wined3d_profiler_end_frame(struct wined3d_cs *cs)
+{
+    struct wined3d_profiler *profiler = cs->profiler;
+    struct wined3d_profiler_frame *frame;
+    LARGE_INTEGER now;
+
+    QueryPerformanceCounter(&now);
+    profiler->frames[profiler->frame_idx].end_time = now.QuadPart;
+
+    /* The oldest frame is reused. Its results have had several frames to
+     * become available, so reading them shouldn't stall for long. */
+    profiler->frame_idx = (profiler->frame_idx + 1) % WINED3D_PROFILER_FRAME_COUNT;
+    frame = &profiler->frames[profiler->frame_idx];
+    if (frame->id)
+        wined3d_profiler_write_frame(cs, frame);
+
+    frame->id = ++profiler->frame_id;
+    frame->start_time = now.QuadPart;
+    memset(frame->cpu_time, 0, sizeof(frame->cpu_time));
+    memset(frame->op_count, 0, sizeof(frame->op_count));
+    frame->state_changes = 0;
+    frame->gpu_base = 0;
+    frame->gpu_event_count = 0;
+}
+
+/* Write out the frames that haven't been written yet, and free their queries. */
+static void wined3d_profiler_flush(struct wined3d_cs *cs)
+{
+    struct wined3d_profiler *profiler = cs->profiler;
+    struct wined3d_profiler_frame *frame;
+    LARGE_INTEGER now;
+    unsigned int i;
+
+    QueryPerformanceCounter(&now);
+    profiler->frames[profiler->frame_idx].end_time = now.QuadPart;
+
+    for (i = 1; i <= WINED3D_PROFILER_FRAME_COUNT; ++i)
+    {
+        frame = &profiler->frames[(profiler->frame_idx + i) % WINED3D_PROFILER_FRAME_COUNT];
+        if (!frame->id)
+            continue;
+        wined3d_profiler_write_frame(cs, frame);
+        frame->id = 0;
+    }
+}
+
+static void wined3d_profiler_destroy(struct wined3d_profiler *profiler)
+{
+    CloseHandle(profiler->file);
+    heap_free(profiler);
+}
+
+void wined3d_cs_profile_state_changes(struct wined3d_cs *cs, unsigned int count)
+{
+    cs->profiler->frames[cs->profiler->frame_idx].state_changes += count;
+}
+
+static void wined3d_cs_profile_op(struct wined3d_cs *cs, enum wined3d_cs_op opcode, const void *data)
+{
+    struct wined3d_profiler *profiler = cs->profiler;
+    struct wined3d_profiler_frame *frame = &profiler->frames[profiler->frame_idx];
+    struct wined3d_profiler_gpu_event *event = NULL;
+    struct wined3d_context *context;
+    LARGE_INTEGER start, end;
+
+    if (profiler->gpu_timing && wined3d_profiler_is_gpu_op(opcode) && cs->device->context_count
+            && frame->gpu_event_count < WINED3D_PROFILER_GPU_EVENT_COUNT)
+    {
+        event = &frame->gpu_events[frame->gpu_event_count++];
+        event->opcode = opcode;
+
+        context = context_acquire(cs->device, NULL, 0);
+        if (!frame->gpu_base)
+        {
+            const struct wined3d_gl_info *gl_info = context->gl_info;
+
+            GL_EXTCALL(glGetInteger64v(GL_TIMESTAMP, &frame->gpu_base));
+            checkGLcall("glGetInteger64v(GL_TIMESTAMP)");
+            QueryPerformanceCounter(&start);
+            frame->cpu_base = start.QuadPart;
+        }
+        wined3d_profiler_issue_timestamp(context, &event->start);
+        context_release(context);
+    }
+
+    QueryPerformanceCounter(&start);
+    wined3d_cs_op_handlers[opcode](cs, data);
+    QueryPerformanceCounter(&end);
+
+    frame->cpu_time[opcode] += end.QuadPart - start.QuadPart;
+    ++frame->op_count[opcode];
+
+    /* The handler may have destroyed the last context, e.g. for a reset. */
+    if (event && cs->device->context_count)
+    {
+        context = context_acquire(cs->device, NULL, 0);
+        wined3d_profiler_issue_timestamp(context, &event->end);
+        context_release(context);
+    }
+
+    if (opcode == WINED3D_CS_OP_PRESENT)
+        wined3d_profiler_end_frame(cs);
+}
+
+static void wined3d_cs_execute(struct wined3d_cs *cs, enum wined3d_cs_op opcode, const void *data)
+{
+    if (cs->profiler)
+        wined3d_cs_profile_op(cs, opcode, data);
+    else
+        wined3d_cs_op_handlers[opcode](cs, data);
+}
+
 static void *wined3d_cs_st_require_space(struct wined3d_cs *cs, size_t size, enum wined3d_cs_queue_id queue_id)
 {
+    if (!cs->thread)
+        wined3d_cs_flush_state_updates(cs);
+
     if (size > (cs->data_size - cs->end))
     {
         size_t new_size;
@@ -2621,7 +3114,7 @@ static void wined3d_cs_st_submit(struct wined3d_cs *cs, enum wined3d_cs_queue_id
     if (opcode >= WINED3D_CS_OP_STOP)
         ERR("Invalid opcode %#x.\n", opcode);
     else
-        wined3d_cs_op_handlers[opcode](cs, &data[start]);
+        wined3d_cs_execute(cs, opcode, &data[start]);
 
     if (cs->data == data)
         cs->start = cs->end = start;
@@ -2673,6 +3166,7 @@ static void *wined3d_cs_queue_require_space(struct wined3d_cs_queue *queue, size
     size_t queue_size = ARRAY_SIZE(queue->data);
     size_t header_size, packet_size, remaining;
     struct wined3d_cs_packet *packet;
+    unsigned int spin_count = 0;
 
     header_size = FIELD_OFFSET(struct wined3d_cs_packet, data[0]);
     size = (size + header_size - 1) & ~(header_size - 1);
@@ -2722,6 +3216,7 @@ static void *wined3d_cs_queue_require_space(struct wined3d_cs_queue *queue, size
 
         TRACE("Waiting for free space. Head %u, tail %u, packet size %lu.\n",
                 head, tail, (unsigned long)packet_size);
+        wined3d_cs_wait_progress(cs, queue, tail, &spin_count);
     }
 
     packet = (struct wined3d_cs_packet *)&queue->data[queue->head];
@@ -2734,16 +3229,27 @@ static void *wined3d_cs_mt_require_space(struct wined3d_cs *cs, size_t size, enu
     if (cs->thread_id == GetCurrentThreadId())
         return wined3d_cs_st_require_space(cs, size, queue_id);
 
+    /* Maps don't need to wait for the held back draw; anything that depends
+     * on its result waits for the resources to become idle first. */
+    if (queue_id == WINED3D_CS_QUEUE_DEFAULT)
+        wined3d_cs_flush_pending_draw(cs);
+    wined3d_cs_flush_state_updates(cs);
     return wined3d_cs_queue_require_space(&cs->queue[queue_id], size, cs);
 }
 
 static void wined3d_cs_mt_finish(struct wined3d_cs *cs, enum wined3d_cs_queue_id queue_id)
 {
+    struct wined3d_cs_queue *queue = &cs->queue[queue_id];
+    unsigned int spin_count = 0;
+    LONG tail;
+
     if (cs->thread_id == GetCurrentThreadId())
         return wined3d_cs_st_finish(cs, queue_id);
 
-    while (cs->queue[queue_id].head != *(volatile LONG *)&cs->queue[queue_id].tail)
-        wined3d_pause();
+    if (queue_id == WINED3D_CS_QUEUE_DEFAULT)
+        wined3d_cs_flush_pending_draw(cs);
+    while (queue->head != (tail = *(volatile LONG *)&queue->tail))
+        wined3d_cs_wait_progress(cs, queue, tail, &spin_count);
 }
 
 static const struct wined3d_cs_ops wined3d_cs_mt_ops =
@@ -2788,10 +3294,26 @@ static void wined3d_cs_wait_event(struct wined3d_cs *cs)
     WaitForSingleObject(cs->event, INFINITE);
 }
 
+/* Adapt the time the CS thread spins before parking itself to recent
+ * arrival intervals. If work showed up shortly after the thread parked,
+ * spinning a bit longer would have avoided the wakeup latency. Otherwise
+ * the thread is mostly idle, and should park sooner. */
+static void wined3d_cs_update_spin_time(struct wined3d_cs *cs, LONGLONG idle_time)
+{
+    if (idle_time < 2 * cs->spin_time)
+        cs->spin_time = min(2 * cs->spin_time, cs->max_spin_time);
+    else
+        cs->spin_time = max(cs->spin_time / 2, cs->min_spin_time);
+
+    TRACE("Idle for %s ticks, spinning for %s ticks.\n",
+            wine_dbgstr_longlong(idle_time), wine_dbgstr_longlong(cs->spin_time));
+}
+
 static DWORD WINAPI wined3d_cs_run(void *ctx)
 {
     struct wined3d_cs_packet *packet;
     struct wined3d_cs_queue *queue;
+    LARGE_INTEGER idle_start, now;
     unsigned int spin_count = 0;
     struct wined3d_cs *cs = ctx;
     enum wined3d_cs_op opcode;
@@ -2821,8 +3343,22 @@ static DWORD WINAPI wined3d_cs_run(void *ctx)
             queue = &cs->queue[WINED3D_CS_QUEUE_DEFAULT];
             if (wined3d_cs_queue_is_empty(cs, queue))
             {
-                if (++spin_count >= WINED3D_CS_SPIN_COUNT && list_empty(&cs->query_poll_list))
-                    wined3d_cs_wait_event(cs);
+                if (!spin_count++)
+                {
+                    QueryPerformanceCounter(&idle_start);
+                }
+                else if (!(spin_count % WINED3D_CS_SPIN_CHECK_INTERVAL) && list_empty(&cs->query_poll_list))
+                {
+                    QueryPerformanceCounter(&now);
+                    if (now.QuadPart - idle_start.QuadPart >= cs->spin_time)
+                    {
+                        wined3d_cs_wait_event(cs);
+                        QueryPerformanceCounter(&now);
+                        wined3d_cs_update_spin_time(cs, now.QuadPart - idle_start.QuadPart);
+                        spin_count = 0;
+                    }
+                }
+                wined3d_pause();
                 continue;
             }
         }
@@ -2838,15 +3374,21 @@ static DWORD WINAPI wined3d_cs_run(void *ctx)
             {
                 if (opcode > WINED3D_CS_OP_STOP)
                     ERR("Invalid opcode %#x.\n", opcode);
+                if (cs->profiler)
+                    wined3d_profiler_flush(cs);
                 break;
             }
 
-            wined3d_cs_op_handlers[opcode](cs, packet->data);
+            wined3d_cs_execute(cs, opcode, packet->data);
         }
 
         tail += FIELD_OFFSET(struct wined3d_cs_packet, data[packet->size]);
         tail &= (WINED3D_CS_QUEUE_SIZE - 1);
         InterlockedExchange(&queue->tail, tail);
+
+        if (*(volatile BOOL *)&cs->waiting_for_progress
+                && InterlockedCompareExchange(&cs->waiting_for_progress, FALSE, TRUE))
+            SetEvent(cs->progress_event);
     }
 
     cs->queue[WINED3D_CS_QUEUE_MAP].tail = cs->queue[WINED3D_CS_QUEUE_MAP].head;
@@ -2858,6 +3400,7 @@ static DWORD WINAPI wined3d_cs_run(void *ctx)
 struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device)
 {
     const struct wined3d_gl_info *gl_info = &device->adapter->gl_info;
+    LARGE_INTEGER frequency;
     struct wined3d_cs *cs;
 
     if (!(cs = heap_alloc_zero(sizeof(*cs))))
@@ -2873,11 +3416,25 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device)
     if (!(cs->data = heap_alloc(cs->data_size)))
         goto fail;
 
+    if (wined3d_settings.cs_profile_file)
+        cs->profiler = wined3d_profiler_create(gl_info);
+
     if (wined3d_settings.cs_multithreaded
             && !RtlIsCriticalSectionLockedByThread(NtCurrentTeb()->Peb->LoaderLock))
     {
         cs->ops = &wined3d_cs_mt_ops;
 
+        QueryPerformanceFrequency(&frequency);
+        cs->min_spin_time = frequency.QuadPart * WINED3D_CS_MIN_SPIN_TIME_US / 1000000;
+        cs->max_spin_time = frequency.QuadPart * WINED3D_CS_MAX_SPIN_TIME_US / 1000000;
+        cs->producer_spin_count = WINED3D_CS_PRODUCER_SPIN_COUNT;
+        if (wined3d_settings.cs_power_saving)
+        {
+            cs->max_spin_time = cs->min_spin_time;
+            cs->producer_spin_count = WINED3D_CS_SPIN_CHECK_INTERVAL;
+        }
+        cs->spin_time = cs->max_spin_time;
+
         if (!(cs->event = CreateEventW(NULL, FALSE, FALSE, NULL)))
         {
             ERR("Failed to create command stream event.\n");
@@ -2885,10 +3442,19 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device)
             goto fail;
         }
 
+        if (!(cs->progress_event = CreateEventW(NULL, FALSE, FALSE, NULL)))
+        {
+            ERR("Failed to create command stream progress event.\n");
+            CloseHandle(cs->event);
+            heap_free(cs->data);
+            goto fail;
+        }
+
         if (!(GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS,
                 (const WCHAR *)wined3d_cs_run, &cs->wined3d_module)))
         {
             ERR("Failed to get wined3d module handle.\n");
+            CloseHandle(cs->progress_event);
             CloseHandle(cs->event);
             heap_free(cs->data);
             goto fail;
@@ -2898,6 +3464,7 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device)
         {
             ERR("Failed to create wined3d command stream thread.\n");
             FreeLibrary(cs->wined3d_module);
+            CloseHandle(cs->progress_event);
             CloseHandle(cs->event);
             heap_free(cs->data);
             goto fail;
@@ -2907,6 +3474,8 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device)
     return cs;
 
 fail:
+    if (cs->profiler)
+        wined3d_profiler_destroy(cs->profiler);
     state_cleanup(&cs->state);
     heap_free(cs);
     return NULL;
@@ -2920,8 +3489,17 @@ void wined3d_cs_destroy(struct wined3d_cs *cs)
         CloseHandle(cs->thread);
         if (!CloseHandle(cs->event))
             ERR("Closing event failed.\n");
+        if (!CloseHandle(cs->progress_event))
+            ERR("Closing progress event failed.\n");
+    }
+    else if (cs->profiler)
+    {
+        wined3d_profiler_flush(cs);
     }
 
+    if (cs->profiler)
+        wined3d_profiler_destroy(cs->profiler);
+
     state_cleanup(&cs->state);
     heap_free(cs->data);
     heap_free(cs);
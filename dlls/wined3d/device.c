@@ -1003,6 +1003,7 @@ static void wined3d_device_delete_opengl_contexts_cs(void *object)
     device->shader_backend->shader_free_private(device);
     destroy_dummy_textures(device, context);
     destroy_default_samplers(device, context);
+    wined3d_upload_ring_destroy(device, context);
     context_release(context);
 
     while (device->context_count)
@@ -1837,6 +1838,26 @@ void CDECL wined3d_device_set_material(struct wined3d_device *device, const stru
         wined3d_cs_emit_set_material(device->cs, material);
 }
 
+void CDECL wined3d_device_set_max_frame_latency(struct wined3d_device *device, unsigned int max_frame_latency)
+{
+    TRACE("device %p, max_frame_latency %u.\n", device, max_frame_latency);
+
+    if (wined3d_settings.max_frame_latency)
+    {
+        TRACE("Ignoring, the frame latency is set in the registry.\n");
+        return;
+    }
+
+    device->max_frame_latency = max(max_frame_latency, 1);
+}
+
+unsigned int CDECL wined3d_device_get_max_frame_latency(const struct wined3d_device *device)
+{
+    TRACE("device %p.\n", device);
+
+    return device->max_frame_latency;
+}
+
 void CDECL wined3d_device_get_material(const struct wined3d_device *device, struct wined3d_material *material)
 {
     TRACE("device %p, material %p.\n", device, material);
@@ -5195,6 +5216,7 @@ HRESULT device_init(struct wined3d_device *device, struct wined3d *wined3d,
     list_init(&device->resources);
     list_init(&device->shaders);
     device->surface_alignment = surface_alignment;
+    device->max_frame_latency = wined3d_settings.max_frame_latency ? wined3d_settings.max_frame_latency : 1;
 
     /* Save the creation parameters. */
     device->create_parms.adapter_idx = adapter_idx;
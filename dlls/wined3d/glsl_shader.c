@@ -131,6 +131,11 @@ struct shader_glsl_priv
     struct wine_rb_tree ffp_fragment_shaders;
     BOOL ffp_proj_control;
     BOOL legacy_lighting;
+
+    struct wine_rb_tree program_binaries;
+    HANDLE program_cache_file;
+    ULONG64 program_cache_driver_hash;
+    BOOL program_cache_checked;
 };
 
 struct glsl_vs_program
@@ -270,6 +275,7 @@ struct glsl_context_data
     struct glsl_shader_prog_link *glsl_program;
     GLenum vertex_color_clamp;
     BOOL rasterization_disabled;
+    BOOL compile_pending;
 };
 
 struct glsl_ps_compiled_shader
@@ -590,6 +596,348 @@ void shader_glsl_validate_link(const struct wined3d_gl_info *gl_info, GLuint pro
     print_glsl_info_log(gl_info, program, TRUE);
 }
 
+/* GLSL program binaries are saved to the file named by the "ShaderCacheFile"
+ * setting, after a header identifying the GL driver that produced them.
+ * Programs are identified by a hash of the sources of their attached shaders. */
+#define GLSL_PROGRAM_CACHE_MAGIC        0x43503357 /* "W3PC" */
+#define GLSL_PROGRAM_CACHE_VERSION      1
+#define GLSL_PROGRAM_CACHE_MAX_BINARY   (16 * 1024 * 1024)
+#define GLSL_PROGRAM_CACHE_HASH_INIT    0xcbf29ce484222325ull
+
+struct glsl_program_cache_header
+{
+    DWORD magic;
+    DWORD version;
+    ULONG64 driver_hash;
+};
+
+struct glsl_program_cache_record
+{
+    ULONG64 hash;
+    DWORD format;
+    DWORD size;
+};
+
+struct glsl_program_binary
+{
+    struct wine_rb_entry entry;
+    ULONG64 hash;
+    GLenum format;
+    GLsizei size;
+    BYTE data[1];
+};
+
+/* FNV-1a */
+static ULONG64 glsl_program_cache_hash(ULONG64 hash, const void *data, SIZE_T size)
+{
+    const BYTE *ptr = data;
+    SIZE_T i;
+
+    for (i = 0; i < size; ++i)
+    {
+        hash ^= ptr[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static int glsl_program_binary_compare(const void *key, const struct wine_rb_entry *entry)
+{
+    const struct glsl_program_binary *binary = WINE_RB_ENTRY_VALUE(entry, struct glsl_program_binary, entry);
+    ULONG64 hash = *(const ULONG64 *)key;
+
+    if (hash < binary->hash)
+        return -1;
+    return hash > binary->hash;
+}
+
+static void glsl_program_binary_destroy(struct wine_rb_entry *entry, void *context)
+{
+    heap_free(WINE_RB_ENTRY_VALUE(entry, struct glsl_program_binary, entry));
+}
+
+static int compare_ulong64(const void *a, const void *b)
+{
+    ULONG64 x = *(const ULONG64 *)a, y = *(const ULONG64 *)b;
+
+    if (x < y)
+        return -1;
+    return x > y;
+}
+
+static BOOL shader_glsl_add_program_binary(struct shader_glsl_priv *priv, ULONG64 hash,
+        GLenum format, GLsizei size, const void *data)
+{
+    struct glsl_program_binary *binary;
+    struct wine_rb_entry *entry;
+
+    if (!(binary = heap_alloc(FIELD_OFFSET(struct glsl_program_binary, data[size]))))
+        return FALSE;
+    binary->hash = hash;
+    binary->format = format;
+    binary->size = size;
+    memcpy(binary->data, data, size);
+
+    /* Later records replace earlier ones. */
+    if ((entry = wine_rb_get(&priv->program_binaries, &hash)))
+    {
+        wine_rb_remove(&priv->program_binaries, entry);
+        glsl_program_binary_destroy(entry, NULL);
+    }
+    wine_rb_put(&priv->program_binaries, &binary->hash, &binary->entry);
+    return TRUE;
+}
+
+static HANDLE shader_glsl_create_program_cache(ULONG64 driver_hash)
+{
+    struct glsl_program_cache_header header;
+    HANDLE file;
+    DWORD size;
+
+    header.magic = GLSL_PROGRAM_CACHE_MAGIC;
+    header.version = GLSL_PROGRAM_CACHE_VERSION;
+    header.driver_hash = driver_hash;
+
+    if ((file = CreateFileA(wined3d_settings.shader_cache_file, GENERIC_READ | FILE_APPEND_DATA,
+            FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL))
+            == INVALID_HANDLE_VALUE)
+    {
+        WARN("Failed to create %s, error %u.\n", debugstr_a(wined3d_settings.shader_cache_file), GetLastError());
+        return INVALID_HANDLE_VALUE;
+    }
+    if (!WriteFile(file, &header, sizeof(header), &size, NULL) || size != sizeof(header))
+    {
+        WARN("Failed to write program cache header, error %u.\n", GetLastError());
+        CloseHandle(file);
+        return INVALID_HANDLE_VALUE;
+    }
+    return file;
+}
+
+/* Read the binaries saved by previous sessions. They can only be checked
+ * against the GL driver once a context is current, see
+ * shader_glsl_check_program_cache(). */
+static void shader_glsl_load_program_cache(struct shader_glsl_priv *priv)
+{
+    struct glsl_program_cache_record record;
+    struct glsl_program_cache_header header;
+    unsigned int count = 0;
+    BOOL truncated = FALSE;
+    void *data = NULL, *tmp;
+    DWORD size;
+    HANDLE file;
+
+    wine_rb_init(&priv->program_binaries, glsl_program_binary_compare);
+    priv->program_cache_file = INVALID_HANDLE_VALUE;
+
+    if (!wined3d_settings.shader_cache_file)
+        return;
+
+    if ((file = CreateFileA(wined3d_settings.shader_cache_file, GENERIC_READ | FILE_APPEND_DATA,
+            FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL))
+            == INVALID_HANDLE_VALUE)
+        return;
+
+    if (!ReadFile(file, &header, sizeof(header), &size, NULL) || size != sizeof(header)
+            || header.magic != GLSL_PROGRAM_CACHE_MAGIC || header.version != GLSL_PROGRAM_CACHE_VERSION)
+    {
+        WARN("Ignoring invalid program cache %s.\n", debugstr_a(wined3d_settings.shader_cache_file));
+        CloseHandle(file);
+        return;
+    }
+    priv->program_cache_driver_hash = header.driver_hash;
+
+    while (ReadFile(file, &record, sizeof(record), &size, NULL) && size)
+    {
+        if (size != sizeof(record) || !record.size || record.size > GLSL_PROGRAM_CACHE_MAX_BINARY
+                || !(tmp = heap_realloc(data, record.size))
+                || !ReadFile(file, (data = tmp), record.size, &size, NULL) || size != record.size)
+        {
+            truncated = TRUE;
+            break;
+        }
+        if (shader_glsl_add_program_binary(priv, record.hash, record.format, record.size, data))
+            ++count;
+    }
+    if (truncated)
+    {
+        /* Probably an interrupted write, anything appended after it would
+         * be lost. Have the file recreated. */
+        WARN("Program cache %s is truncated.\n", debugstr_a(wined3d_settings.shader_cache_file));
+        priv->program_cache_driver_hash = 0;
+    }
+    heap_free(data);
+
+    TRACE("Loaded %u program binaries from %s.\n", count, debugstr_a(wined3d_settings.shader_cache_file));
+    priv->program_cache_file = file;
+}
+
+/* Context activation is done by the caller. */
+static BOOL shader_glsl_check_program_cache(const struct wined3d_gl_info *gl_info, struct shader_glsl_priv *priv)
+{
+    static const GLenum strings[] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+    ULONG64 hash = GLSL_PROGRAM_CACHE_HASH_INIT;
+    const char *str;
+    GLint formats;
+    unsigned int i;
+
+    if (priv->program_cache_checked)
+        return priv->program_cache_file != INVALID_HANDLE_VALUE;
+    priv->program_cache_checked = TRUE;
+
+    if (!wined3d_settings.shader_cache_file)
+        return FALSE;
+
+    formats = 0;
+    if (gl_info->supported[ARB_GET_PROGRAM_BINARY])
+        gl_info->gl_ops.gl.p_glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+
+    for (i = 0; i < ARRAY_SIZE(strings); ++i)
+    {
+        if ((str = (const char *)gl_info->gl_ops.gl.p_glGetString(strings[i])))
+            hash = glsl_program_cache_hash(hash, str, strlen(str) + 1);
+    }
+
+    if (formats && priv->program_cache_file != INVALID_HANDLE_VALUE && hash == priv->program_cache_driver_hash)
+        return TRUE;
+
+    /* The saved binaries are useless with a different driver. */
+    wine_rb_clear(&priv->program_binaries, glsl_program_binary_destroy, NULL);
+    if (priv->program_cache_file != INVALID_HANDLE_VALUE)
+        CloseHandle(priv->program_cache_file);
+    priv->program_cache_file = INVALID_HANDLE_VALUE;
+
+    if (!formats)
+    {
+        WARN("Program binaries are not supported, disabling the program cache.\n");
+        return FALSE;
+    }
+
+    TRACE("Creating program cache %s.\n", debugstr_a(wined3d_settings.shader_cache_file));
+    priv->program_cache_file = shader_glsl_create_program_cache(hash);
+    priv->program_cache_driver_hash = hash;
+    return priv->program_cache_file != INVALID_HANDLE_VALUE;
+}
+
+/* Context activation is done by the caller. */
+static ULONG64 shader_glsl_get_program_hash(const struct wined3d_gl_info *gl_info, GLuint program_id)
+{
+    GLint i, shader_count, source_size = 0, length;
+    ULONG64 *hashes, hash = 0;
+    char *source = NULL;
+    GLuint *shaders;
+    GLint type;
+
+    GL_EXTCALL(glGetProgramiv(program_id, GL_ATTACHED_SHADERS, &shader_count));
+    if (!shader_count || !(shaders = heap_calloc(shader_count, sizeof(*shaders))))
+        return 0;
+    if (!(hashes = heap_calloc(shader_count, sizeof(*hashes))))
+    {
+        heap_free(shaders);
+        return 0;
+    }
+
+    GL_EXTCALL(glGetAttachedShaders(program_id, shader_count, NULL, shaders));
+    for (i = 0; i < shader_count; ++i)
+    {
+        GL_EXTCALL(glGetShaderiv(shaders[i], GL_SHADER_SOURCE_LENGTH, &length));
+        if (length > source_size)
+        {
+            heap_free(source);
+            if (!(source = heap_alloc(length)))
+                goto done;
+            source_size = length;
+        }
+        GL_EXTCALL(glGetShaderiv(shaders[i], GL_SHADER_TYPE, &type));
+        GL_EXTCALL(glGetShaderSource(shaders[i], source_size, &length, source));
+
+        hashes[i] = glsl_program_cache_hash(GLSL_PROGRAM_CACHE_HASH_INIT, &type, sizeof(type));
+        hashes[i] = glsl_program_cache_hash(hashes[i], source, length);
+    }
+    checkGLcall("get program shader sources");
+
+    /* The attachment order is up to the driver. */
+    qsort(hashes, shader_count, sizeof(*hashes), compare_ulong64);
+    hash = glsl_program_cache_hash(GLSL_PROGRAM_CACHE_HASH_INIT, hashes, shader_count * sizeof(*hashes));
+
+done:
+    heap_free(source);
+    heap_free(hashes);
+    heap_free(shaders);
+    return hash;
+}
+
+/* Context activation is done by the caller. Returns TRUE if the program was
+ * loaded from a saved binary. Otherwise, a non-zero hash is returned if the
+ * binary should be saved once the program is linked. */
+static BOOL shader_glsl_load_program_binary(const struct wined3d_gl_info *gl_info,
+        struct shader_glsl_priv *priv, GLuint program_id, const struct wined3d_shader *gshader, ULONG64 *hash)
+{
+    struct glsl_program_binary *binary;
+    struct wine_rb_entry *entry;
+    GLint status;
+
+    *hash = 0;
+    if (!shader_glsl_check_program_cache(gl_info, priv))
+        return FALSE;
+    /* Transform feedback varyings are not part of the shader sources. */
+    if (gshader && gshader->u.gs.so_desc.element_count)
+        return FALSE;
+    if (!(*hash = shader_glsl_get_program_hash(gl_info, program_id)))
+        return FALSE;
+
+    if ((entry = wine_rb_get(&priv->program_binaries, hash)))
+    {
+        binary = WINE_RB_ENTRY_VALUE(entry, struct glsl_program_binary, entry);
+        TRACE("Loading GLSL shader program %u from binary %s.\n", program_id, wine_dbgstr_longlong(*hash));
+        GL_EXTCALL(glProgramBinary(program_id, binary->format, binary->data, binary->size));
+        GL_EXTCALL(glGetProgramiv(program_id, GL_LINK_STATUS, &status));
+        checkGLcall("glProgramBinary");
+        if (status)
+            return TRUE;
+
+        WARN("Failed to load binary %s, relinking.\n", wine_dbgstr_longlong(*hash));
+        wine_rb_remove(&priv->program_binaries, entry);
+        glsl_program_binary_destroy(entry, NULL);
+    }
+
+    GL_EXTCALL(glProgramParameteri(program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+    checkGLcall("glProgramParameteri");
+    return FALSE;
+}
+
+/* Context activation is done by the caller. */
+static void shader_glsl_save_program_binary(const struct wined3d_gl_info *gl_info,
+        struct shader_glsl_priv *priv, GLuint program_id, ULONG64 hash)
+{
+    struct glsl_program_cache_record *record;
+    GLint status, length;
+    GLenum format;
+    DWORD size;
+
+    GL_EXTCALL(glGetProgramiv(program_id, GL_LINK_STATUS, &status));
+    GL_EXTCALL(glGetProgramiv(program_id, GL_PROGRAM_BINARY_LENGTH, &length));
+    if (!status || length <= 0 || length > GLSL_PROGRAM_CACHE_MAX_BINARY)
+        return;
+
+    if (!(record = heap_alloc(sizeof(*record) + length)))
+        return;
+    GL_EXTCALL(glGetProgramBinary(program_id, length, &length, &format, record + 1));
+    checkGLcall("glGetProgramBinary");
+
+    record->hash = hash;
+    record->format = format;
+    record->size = length;
+    if (shader_glsl_add_program_binary(priv, hash, format, length, record + 1))
+    {
+        /* Each record goes out in a single write, so that concurrent
+         * writers don't interleave. */
+        if (!WriteFile(priv->program_cache_file, record, sizeof(*record) + length, &size, NULL))
+            WARN("Failed to save program binary, error %u.\n", GetLastError());
+    }
+    heap_free(record);
+}
+
 static BOOL shader_glsl_use_layout_qualifier(const struct wined3d_gl_info *gl_info)
 {
     /* Layout qualifiers were introduced in GLSL 1.40. The Nvidia Legacy GPU
@@ -10113,6 +10461,18 @@ static void set_glsl_compute_shader_program(const struct wined3d_context *contex
 }
 
 /* Context activation is done by the caller. */
+/* Context activation is done by the caller. */
+static BOOL shader_glsl_is_compiled(const struct wined3d_gl_info *gl_info, GLuint shader_id)
+{
+    GLint status;
+
+    if (!shader_id)
+        return TRUE;
+
+    GL_EXTCALL(glGetShaderiv(shader_id, GL_COMPLETION_STATUS_ARB, &status));
+    return status;
+}
+
 static void set_glsl_shader_program(const struct wined3d_context *context, const struct wined3d_state *state,
         struct shader_glsl_priv *priv, struct glsl_context_data *ctx_data)
 {
@@ -10126,6 +10486,7 @@ static void set_glsl_shader_program(const struct wined3d_context *context, const
     struct wined3d_shader *pshader = NULL;
     GLuint reorder_shader_id = 0;
     struct glsl_program_key key;
+    ULONG64 program_hash;
     GLuint program_id;
     unsigned int i;
     GLuint vs_id = 0;
@@ -10245,6 +10606,16 @@ static void set_glsl_shader_program(const struct wined3d_context *context, const
         return;
     }
 
+    /* Linking would wait for the driver to finish compiling. */
+    if (wined3d_settings.async_shader_compile && gl_info->supported[ARB_PARALLEL_SHADER_COMPILE]
+            && (!shader_glsl_is_compiled(gl_info, vs_id) || !shader_glsl_is_compiled(gl_info, hs_id)
+            || !shader_glsl_is_compiled(gl_info, ds_id) || !shader_glsl_is_compiled(gl_info, gs_id)
+            || !shader_glsl_is_compiled(gl_info, ps_id)))
+    {
+        ctx_data->compile_pending = TRUE;
+        return;
+    }
+
     /* If we get to this point, then no matching program exists, so we create one */
     program_id = GL_EXTCALL(glCreateProgram());
     TRACE("Created new GLSL shader program %u.\n", program_id);
@@ -10376,9 +10747,14 @@ static void set_glsl_shader_program(const struct wined3d_context *context, const
     }
 
     /* Link the program */
-    TRACE("Linking GLSL shader program %u.\n", program_id);
-    GL_EXTCALL(glLinkProgram(program_id));
-    shader_glsl_validate_link(gl_info, program_id);
+    if (!shader_glsl_load_program_binary(gl_info, priv, program_id, gshader, &program_hash))
+    {
+        TRACE("Linking GLSL shader program %u.\n", program_id);
+        GL_EXTCALL(glLinkProgram(program_id));
+        shader_glsl_validate_link(gl_info, program_id);
+        if (program_hash)
+            shader_glsl_save_program_binary(gl_info, priv, program_id, program_hash);
+    }
 
     shader_glsl_init_vs_uniform_locations(gl_info, priv, program_id, &entry->vs,
             vshader ? vshader->limits->constant_float : 0);
@@ -10559,6 +10935,12 @@ static void shader_glsl_select(void *shader_priv, struct wined3d_context *contex
 
     prev_id = ctx_data->glsl_program ? ctx_data->glsl_program->id : 0;
     set_glsl_shader_program(context, state, priv, ctx_data);
+    if (ctx_data->compile_pending)
+    {
+        ctx_data->compile_pending = FALSE;
+        context->shader_compile_pending = 1;
+        return;
+    }
     glsl_program = ctx_data->glsl_program;
 
     if (glsl_program)
@@ -10964,6 +11346,7 @@ static HRESULT shader_glsl_alloc(struct wined3d_device *device, const struct win
     }
 
     wine_rb_init(&priv->program_lookup, glsl_program_key_compare);
+    shader_glsl_load_program_cache(priv);
 
     priv->next_constant_version = 1;
     priv->vertex_pipe = vertex_pipe;
@@ -10995,6 +11378,9 @@ static void shader_glsl_free(struct wined3d_device *device)
     struct shader_glsl_priv *priv = device->shader_priv;
 
     wine_rb_destroy(&priv->program_lookup, NULL, NULL);
+    wine_rb_destroy(&priv->program_binaries, glsl_program_binary_destroy, NULL);
+    if (priv->program_cache_file != INVALID_HANDLE_VALUE)
+        CloseHandle(priv->program_cache_file);
     constant_heap_free(&priv->pconst_heap);
     constant_heap_free(&priv->vconst_heap);
     heap_free(priv->stack);
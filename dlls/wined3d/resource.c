@@ -353,7 +353,11 @@ HRESULT CDECL wined3d_resource_map(struct wined3d_resource *resource, unsigned i
     }
 
     flags = wined3d_resource_sanitise_map_flags(resource, flags);
-    wined3d_resource_wait_idle(resource);
+    /* A NOOVERWRITE map of a persistently mapped buffer doesn't touch
+     * anything queued draws may be using, so there's no need to wait. */
+    if (!(flags & WINED3D_MAP_NOOVERWRITE) || resource->type != WINED3D_RTYPE_BUFFER
+            || !wined3d_buffer_is_persistent(buffer_from_resource(resource)))
+        wined3d_resource_wait_idle(resource);
 
     return wined3d_cs_map(resource->device->cs, resource, sub_resource_idx, map_desc, box, flags);
 }
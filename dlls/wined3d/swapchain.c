@@ -95,6 +95,9 @@ static void swapchain_cleanup(struct wined3d_swapchain *swapchain)
         wined3d_release_dc(swapchain->backup_wnd, swapchain->backup_dc);
         DestroyWindow(swapchain->backup_wnd);
     }
+
+    if (swapchain->frame_latency_semaphore)
+        CloseHandle(swapchain->frame_latency_semaphore);
 }
 
 ULONG CDECL wined3d_swapchain_incref(struct wined3d_swapchain *swapchain)
@@ -253,6 +256,13 @@ HRESULT CDECL wined3d_swapchain_get_display_mode(const struct wined3d_swapchain
     return hr;
 }
 
+HANDLE CDECL wined3d_swapchain_get_frame_latency_object(const struct wined3d_swapchain *swapchain)
+{
+    TRACE("swapchain %p.\n", swapchain);
+
+    return swapchain->frame_latency_semaphore;
+}
+
 struct wined3d_device * CDECL wined3d_swapchain_get_device(const struct wined3d_swapchain *swapchain)
 {
     TRACE("swapchain %p.\n", swapchain);
@@ -778,6 +788,15 @@ static HRESULT swapchain_init(struct wined3d_swapchain *swapchain, struct wined3
     swapchain->device_window = window;
     swapchain->swap_interval = WINED3D_SWAP_INTERVAL_DEFAULT;
 
+    /* Signalled once for every present the command stream executes, and
+     * initially for the first frame. */
+    if ((desc->flags & WINED3D_SWAPCHAIN_FRAME_LATENCY_WAITABLE)
+            && !(swapchain->frame_latency_semaphore = CreateSemaphoreW(NULL, 1, LONG_MAX, NULL)))
+    {
+        ERR("Failed to create frame latency semaphore, error %u.\n", GetLastError());
+        return E_FAIL;
+    }
+
     if (FAILED(hr = wined3d_get_adapter_display_mode(device->wined3d,
             adapter->ordinal, &swapchain->original_mode, NULL)))
     {
@@ -985,6 +1004,9 @@ err:
         wined3d_texture_decref(swapchain->front_buffer);
     }
 
+    if (swapchain->frame_latency_semaphore)
+        CloseHandle(swapchain->frame_latency_semaphore);
+
     return hr;
 }
 
@@ -2095,6 +2095,157 @@ void wined3d_texture_upload_data(struct wined3d_texture *texture, unsigned int s
     }
 }
 
+/* Context activation is done by the caller. */
+static struct wined3d_upload_ring *wined3d_upload_ring_create(struct wined3d_device *device,
+        struct wined3d_context *context)
+{
+    static const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    const struct wined3d_gl_info *gl_info = context->gl_info;
+    struct wined3d_upload_ring *ring;
+    unsigned int i, size;
+    GLenum error;
+
+    if (!(ring = heap_alloc_zero(sizeof(*ring))))
+        return NULL;
+
+    ring->segment_size = min(wined3d_settings.texture_upload_budget, 256) * 1024 * 1024;
+    size = ring->segment_size * WINED3D_UPLOAD_RING_FRAMES;
+
+    for (i = 0; i < WINED3D_UPLOAD_RING_FRAMES; ++i)
+    {
+        if (FAILED(wined3d_fence_create(device, &ring->fences[i])))
+        {
+            WARN("Failed to create fence.\n");
+            goto fail;
+        }
+    }
+
+    while (gl_info->gl_ops.gl.p_glGetError() != GL_NO_ERROR);
+
+    GL_EXTCALL(glGenBuffers(1, &ring->bo_id));
+    GL_EXTCALL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring->bo_id));
+    GL_EXTCALL(glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, NULL, flags));
+    ring->ptr = GL_EXTCALL(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags));
+    GL_EXTCALL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+    error = gl_info->gl_ops.gl.p_glGetError();
+    if (error != GL_NO_ERROR || !ring->ptr)
+    {
+        WARN("Failed to create upload ring, error %s (%#x).\n", debug_glerror(error), error);
+        GL_EXTCALL(glDeleteBuffers(1, &ring->bo_id));
+        ring->bo_id = 0;
+        ring->ptr = NULL;
+        goto fail;
+    }
+
+    TRACE("Created upload ring BO %u, %u bytes at %p.\n", ring->bo_id, size, ring->ptr);
+
+    return ring;
+
+fail:
+    /* Keep the empty ring around so that we don't retry on every update. */
+    for (i = 0; i < WINED3D_UPLOAD_RING_FRAMES; ++i)
+    {
+        if (ring->fences[i])
+            wined3d_fence_destroy(ring->fences[i]);
+        ring->fences[i] = NULL;
+    }
+    return ring;
+}
+
+/* Context activation is done by the caller. */
+void wined3d_upload_ring_destroy(struct wined3d_device *device, struct wined3d_context *context)
+{
+    struct wined3d_upload_ring *ring = device->upload_ring;
+    const struct wined3d_gl_info *gl_info = context->gl_info;
+    unsigned int i;
+
+    if (!ring)
+        return;
+
+    if (ring->bo_id)
+    {
+        GL_EXTCALL(glDeleteBuffers(1, &ring->bo_id));
+        checkGLcall("glDeleteBuffers");
+    }
+    for (i = 0; i < WINED3D_UPLOAD_RING_FRAMES; ++i)
+    {
+        if (ring->fences[i])
+            wined3d_fence_destroy(ring->fences[i]);
+    }
+    heap_free(ring);
+    device->upload_ring = NULL;
+}
+
+/* Copy "size" bytes of texture data into the current segment of the upload
+ * ring. On success "addr" is set up to source the upload from the ring BO.
+ * This never waits for the GPU; if the segment isn't idle yet, or the
+ * per-frame budget is used up, the caller uploads from client memory.
+ * Context activation is done by the caller. */
+BOOL wined3d_texture_stage_upload(struct wined3d_device *device, struct wined3d_context *context,
+        const void *data, unsigned int size, struct wined3d_const_bo_address *addr)
+{
+    const struct wined3d_gl_info *gl_info = context->gl_info;
+    struct wined3d_upload_ring *ring;
+    enum wined3d_fence_result ret;
+    unsigned int offset;
+
+    if (!size || !wined3d_settings.texture_upload_budget || !gl_info->supported[ARB_BUFFER_STORAGE]
+            || !gl_info->supported[ARB_MAP_BUFFER_RANGE] || !gl_info->supported[ARB_SYNC]
+            || !gl_info->supported[ARB_PIXEL_BUFFER_OBJECT])
+        return FALSE;
+
+    if (!(ring = device->upload_ring) && !(ring = device->upload_ring = wined3d_upload_ring_create(device, context)))
+        return FALSE;
+    if (!ring->bo_id)
+        return FALSE;
+
+    if (!ring->checked)
+    {
+        ret = wined3d_fence_test(ring->fences[ring->segment], device, 0);
+        ring->usable = ret == WINED3D_FENCE_OK || ret == WINED3D_FENCE_NOT_STARTED;
+        ring->checked = TRUE;
+        if (!ring->usable)
+            TRACE("Upload ring segment %u is still busy.\n", ring->segment);
+    }
+    if (!ring->usable)
+        return FALSE;
+
+    offset = (ring->offset + RESOURCE_ALIGNMENT - 1) & ~(RESOURCE_ALIGNMENT - 1);
+    if (offset > ring->segment_size || size > ring->segment_size - offset)
+    {
+        TRACE("Upload of %u bytes exceeds the remaining budget.\n", size);
+        return FALSE;
+    }
+
+    ring->offset = offset + size;
+    offset += ring->segment * ring->segment_size;
+    memcpy(ring->ptr + offset, data, size);
+
+    addr->buffer_object = ring->bo_id;
+    addr->addr = (const BYTE *)NULL + offset;
+
+    return TRUE;
+}
+
+/* Retire the current segment of the upload ring. Uploads recorded so far are
+ * fenced, and the next frame stages into the segment retired
+ * WINED3D_UPLOAD_RING_FRAMES - 1 frames ago. */
+void wined3d_upload_ring_end_frame(struct wined3d_device *device)
+{
+    struct wined3d_upload_ring *ring = device->upload_ring;
+
+    if (!ring || !ring->bo_id)
+        return;
+
+    if (ring->offset)
+    {
+        wined3d_fence_issue(ring->fences[ring->segment], device);
+        ring->segment = (ring->segment + 1) % WINED3D_UPLOAD_RING_FRAMES;
+        ring->offset = 0;
+    }
+    ring->checked = FALSE;
+}
+
 /* Context activation is done by the caller. Context may be NULL in ddraw-only mode. */
 static BOOL texture2d_load_location(struct wined3d_texture *texture, unsigned int sub_resource_idx,
         struct wined3d_context *context, DWORD location)
@@ -91,6 +91,12 @@ struct wined3d_settings wined3d_settings =
     ~0U,            /* No PS shader model limit by default. */
     ~0u,            /* No CS shader model limit by default. */
     FALSE,          /* 3D support enabled by default. */
+    NULL,           /* No GLSL program cache by default. */
+    FALSE,          /* Wait for shaders to be compiled by default. */
+    FALSE,          /* Spin before parking the CS thread by default. */
+    NULL,           /* No command stream profiling by default. */
+    8,              /* Stage up to 8 MiB of texture uploads per frame by default. */
+    0,              /* Let the application set the frame latency by default. */
 };
 
 struct wined3d * CDECL wined3d_create(DWORD flags)
@@ -307,6 +313,41 @@ static BOOL wined3d_dll_init(HINSTANCE hInstDLL)
             TRACE("Limiting PS shader model to %u.\n", wined3d_settings.max_sm_ps);
         if (!get_config_key_dword(hkey, appkey, "MaxShaderModelCS", &wined3d_settings.max_sm_cs))
             TRACE("Limiting CS shader model to %u.\n", wined3d_settings.max_sm_cs);
+        if (!get_config_key(hkey, appkey, "ShaderCacheFile", buffer, size))
+        {
+            size_t len = strlen(buffer) + 1;
+
+            if (!(wined3d_settings.shader_cache_file = heap_alloc(len)))
+                ERR("Failed to allocate shader cache path memory.\n");
+            else
+                memcpy(wined3d_settings.shader_cache_file, buffer, len);
+        }
+        if (!get_config_key(hkey, appkey, "AsyncShaderCompile", buffer, size)
+                && !strcmp(buffer, "enabled"))
+        {
+            ERR_(winediag)("Skipping draws while their shaders are compiling.\n");
+            wined3d_settings.async_shader_compile = TRUE;
+        }
+        if (!get_config_key(hkey, appkey, "CSPowerSaving", buffer, size)
+                && !strcmp(buffer, "enabled"))
+        {
+            TRACE("Parking the command stream thread early.\n");
+            wined3d_settings.cs_power_saving = TRUE;
+        }
+        if (!get_config_key(hkey, appkey, "CSProfileFile", buffer, size))
+        {
+            size_t len = strlen(buffer) + 1;
+
+            ERR_(winediag)("Writing a command stream profile to %s.\n", debugstr_a(buffer));
+            if (!(wined3d_settings.cs_profile_file = heap_alloc(len)))
+                ERR("Failed to allocate profile file name.\n");
+            else
+                memcpy(wined3d_settings.cs_profile_file, buffer, len);
+        }
+        if (!get_config_key_dword(hkey, appkey, "TextureUploadBudget", &wined3d_settings.texture_upload_budget))
+            TRACE("Limiting staged texture uploads to %u MiB per frame.\n", wined3d_settings.texture_upload_budget);
+        if (!get_config_key_dword(hkey, appkey, "MaxFrameLatency", &wined3d_settings.max_frame_latency))
+            TRACE("Limiting the frame latency to %u.\n", wined3d_settings.max_frame_latency);
         if (!get_config_key(hkey, appkey, "DirectDrawRenderer", buffer, size)
                 && !strcmp(buffer, "gdi"))
         {
@@ -345,6 +386,8 @@ static BOOL wined3d_dll_destroy(HINSTANCE hInstDLL)
     heap_free(wndproc_table.entries);
 
     heap_free(wined3d_settings.logo);
+    heap_free(wined3d_settings.shader_cache_file);
+    heap_free(wined3d_settings.cs_profile_file);
     UnregisterClassA(WINED3D_OPENGL_WINDOW_CLASS_NAME, hInstDLL);
 
     DeleteCriticalSection(&wined3d_wndproc_cs);
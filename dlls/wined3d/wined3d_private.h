@@ -399,6 +399,12 @@ struct wined3d_settings
     unsigned int max_sm_ps;
     unsigned int max_sm_cs;
     BOOL no_3d;
+    char *shader_cache_file;
+    BOOL async_shader_compile;
+    BOOL cs_power_saving;
+    char *cs_profile_file;
+    unsigned int texture_upload_budget;
+    unsigned int max_frame_latency;
 };
 
 extern struct wined3d_settings wined3d_settings DECLSPEC_HIDDEN;
@@ -1715,6 +1721,8 @@ struct wined3d_fence
 HRESULT wined3d_fence_create(struct wined3d_device *device, struct wined3d_fence **fence) DECLSPEC_HIDDEN;
 void wined3d_fence_destroy(struct wined3d_fence *fence) DECLSPEC_HIDDEN;
 void wined3d_fence_issue(struct wined3d_fence *fence, const struct wined3d_device *device) DECLSPEC_HIDDEN;
+enum wined3d_fence_result wined3d_fence_test(const struct wined3d_fence *fence,
+        const struct wined3d_device *device, DWORD flags) DECLSPEC_HIDDEN;
 enum wined3d_fence_result wined3d_fence_wait(const struct wined3d_fence *fence,
         const struct wined3d_device *device) DECLSPEC_HIDDEN;
 
@@ -1859,6 +1867,7 @@ struct wined3d_rendertarget_info
 };
 
 #define MAX_GL_FRAGMENT_SAMPLERS 32
+#define WINED3D_FBO_HASH_SIZE 64
 
 struct wined3d_context
 {
@@ -1923,7 +1932,8 @@ struct wined3d_context
     DWORD transform_feedback_paused : 1;
     DWORD shader_update_mask : 6; /* WINED3D_SHADER_TYPE_COUNT, 6 */
     DWORD clip_distance_mask : 8; /* MAX_CLIP_DISTANCES, 8 */
-    DWORD padding : 9;
+    DWORD shader_compile_pending : 1;
+    DWORD padding : 8;
 
     DWORD constant_update_mask;
     DWORD numbered_array_mask;
@@ -1955,6 +1965,7 @@ struct wined3d_context
     UINT                    fbo_entry_count;
     struct list             fbo_list;
     struct list             fbo_destroy_list;
+    struct list             fbo_hash[WINED3D_FBO_HASH_SIZE];
     struct fbo_entry        *current_fbo;
     GLuint                  fbo_read_binding;
     GLuint                  fbo_draw_binding;
@@ -2981,6 +2992,12 @@ struct wined3d_device
     struct wined3d_sampler *default_sampler;
     struct wined3d_sampler *null_sampler;
 
+    /* Presents the application can queue ahead of the CS thread */
+    unsigned int max_frame_latency;
+
+    /* Staging PBO for texture updates, owned by the CS thread */
+    struct wined3d_upload_ring *upload_ring;
+
     /* Command stream */
     struct wined3d_cs *cs;
 
@@ -3136,6 +3153,22 @@ struct wined3d_texture_ops
 
 #define WINED3D_TEXTURE_ASYNC_COLOR_KEY     0x00000001
 
+#define WINED3D_UPLOAD_RING_FRAMES          3
+
+/* A persistently mapped PBO split into one segment per frame in flight.
+ * Texture updates are copied into the current segment and uploaded from
+ * there, so the GL doesn't need to copy or wait on the client memory. */
+struct wined3d_upload_ring
+{
+    GLuint bo_id;
+    BYTE *ptr;
+    unsigned int segment_size;
+    unsigned int segment;
+    unsigned int offset;
+    BOOL checked, usable;
+    struct wined3d_fence *fences[WINED3D_UPLOAD_RING_FRAMES];
+};
+
 struct wined3d_texture
 {
     struct wined3d_resource resource;
@@ -3325,6 +3358,10 @@ void wined3d_texture_upload_data(struct wined3d_texture *texture, unsigned int s
         struct wined3d_context *context, const struct wined3d_format *format, const struct wined3d_box *src_box,
         const struct wined3d_const_bo_address *data, unsigned int row_pitch, unsigned int slice_pitch,
         unsigned int dst_x, unsigned int dst_y, unsigned int dst_z, BOOL srgb) DECLSPEC_HIDDEN;
+BOOL wined3d_texture_stage_upload(struct wined3d_device *device, struct wined3d_context *context,
+        const void *data, unsigned int size, struct wined3d_const_bo_address *addr) DECLSPEC_HIDDEN;
+void wined3d_upload_ring_destroy(struct wined3d_device *device, struct wined3d_context *context) DECLSPEC_HIDDEN;
+void wined3d_upload_ring_end_frame(struct wined3d_device *device) DECLSPEC_HIDDEN;
 void wined3d_texture_upload_from_texture(struct wined3d_texture *dst_texture, unsigned int dst_sub_resource_idx,
         unsigned int dst_x, unsigned int dst_y, unsigned int dst_z, struct wined3d_texture *src_texture,
         unsigned int src_sub_resource_idx, const struct wined3d_box *src_box) DECLSPEC_HIDDEN;
@@ -3365,6 +3402,8 @@ struct wined3d_fbo_resource
 struct fbo_entry
 {
     struct list entry;
+    struct list hash_entry;
+    unsigned int hash;
     DWORD flags;
     DWORD rt_mask;
     GLuint id;
@@ -3511,7 +3550,27 @@ enum wined3d_push_constants
 
 #define WINED3D_CS_QUERY_POLL_INTERVAL  10u
 #define WINED3D_CS_QUEUE_SIZE           0x100000u
-#define WINED3D_CS_SPIN_COUNT           10000000u
+#define WINED3D_CS_SPIN_CHECK_INTERVAL  64u
+#define WINED3D_CS_MIN_SPIN_TIME_US     10u
+#define WINED3D_CS_MAX_SPIN_TIME_US     2000u
+#define WINED3D_CS_PRODUCER_SPIN_COUNT  10000u
+
+#define WINED3D_CS_MAX_STATE_UPDATES    64u
+
+enum wined3d_cs_state_type
+{
+    WINED3D_CS_STATE_RENDER,
+    WINED3D_CS_STATE_TEXTURE,
+    WINED3D_CS_STATE_SAMPLER,
+};
+
+struct wined3d_cs_state_update
+{
+    enum wined3d_cs_state_type type;
+    unsigned int idx;
+    unsigned int state;
+    DWORD value;
+};
 
 struct wined3d_cs_queue
 {
@@ -3547,10 +3606,31 @@ struct wined3d_cs
     HANDLE event;
     BOOL waiting_for_event;
     LONG pending_presents;
+
+    /* Signalled when a packet is retired while a producer is waiting. */
+    HANDLE progress_event;
+    BOOL waiting_for_progress;
+    unsigned int producer_spin_count;
+
+    /* In performance counter ticks. */
+    LONGLONG spin_time, min_spin_time, max_spin_time;
+
+    struct wined3d_profiler *profiler;
+
+    /* Render, texture and sampler states set since the last packet. */
+    struct wined3d_cs_state_update state_updates[WINED3D_CS_MAX_STATE_UPDATES];
+    unsigned int state_update_count;
+
+    /* The last draw, held back so that the next one can be merged into it. */
+    struct wined3d_draw_parameters pending_draw;
+    GLenum pending_draw_primitive_type;
+    GLint pending_draw_patch_vertex_count;
+    BOOL has_pending_draw;
 };
 
 struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device) DECLSPEC_HIDDEN;
 void wined3d_cs_destroy(struct wined3d_cs *cs) DECLSPEC_HIDDEN;
+void wined3d_cs_profile_state_changes(struct wined3d_cs *cs, unsigned int count) DECLSPEC_HIDDEN;
 void wined3d_cs_destroy_object(struct wined3d_cs *cs,
         void (*callback)(void *object), void *object) DECLSPEC_HIDDEN;
 void wined3d_cs_emit_add_dirty_texture_region(struct wined3d_cs *cs,
@@ -3648,6 +3728,7 @@ void wined3d_cs_emit_gl_texture_callback(struct wined3d_cs *cs, struct wined3d_t
 void wined3d_cs_emit_user_callback(struct wined3d_cs *cs,
         wined3d_cs_callback callback, const void *data, unsigned int size) DECLSPEC_HIDDEN;
 void wined3d_cs_emit_wait_idle(struct wined3d_cs *cs) DECLSPEC_HIDDEN;
+void wined3d_cs_flush_pending_draw(struct wined3d_cs *cs) DECLSPEC_HIDDEN;
 
 static inline void wined3d_cs_push_constants(struct wined3d_cs *cs, enum wined3d_push_constants p,
         unsigned int start_idx, unsigned int count, const void *constants)
@@ -3657,11 +3738,12 @@ static inline void wined3d_cs_push_constants(struct wined3d_cs *cs, enum wined3d
 
 static inline void wined3d_resource_wait_idle(struct wined3d_resource *resource)
 {
-    const struct wined3d_cs *cs = resource->device->cs;
+    struct wined3d_cs *cs = resource->device->cs;
 
     if (!cs->thread || cs->thread_id == GetCurrentThreadId())
         return;
 
+    wined3d_cs_flush_pending_draw(cs);
     while (InterlockedCompareExchange(&resource->access_count, 0, 0))
         wined3d_pause();
 }
@@ -3681,6 +3763,13 @@ struct wined3d_map_range
     UINT size;
 };
 
+struct wined3d_buffer_bo
+{
+    GLuint id;
+    void *ptr;
+    struct wined3d_fence *fence;
+};
+
 struct wined3d_buffer
 {
     struct wined3d_resource resource;
@@ -3699,6 +3788,11 @@ struct wined3d_buffer
     SIZE_T maps_size, modified_areas;
     struct wined3d_fence *fence;
 
+    /* Persistently mapped buffer objects retired by DISCARD maps. */
+    void *persistent_ptr;
+    struct wined3d_buffer_bo *bo_pool;
+    SIZE_T bo_pool_size, bo_pool_count;
+
     /* conversion stuff */
     UINT decl_change_count, full_conversion_count;
     UINT draw_count;
@@ -3715,6 +3809,7 @@ static inline struct wined3d_buffer *buffer_from_resource(struct wined3d_resourc
 DWORD wined3d_buffer_get_memory(struct wined3d_buffer *buffer,
         struct wined3d_bo_address *data, DWORD locations) DECLSPEC_HIDDEN;
 void wined3d_buffer_invalidate_location(struct wined3d_buffer *buffer, DWORD location) DECLSPEC_HIDDEN;
+BOOL wined3d_buffer_is_persistent(const struct wined3d_buffer *buffer) DECLSPEC_HIDDEN;
 void wined3d_buffer_load(struct wined3d_buffer *buffer, struct wined3d_context *context,
         const struct wined3d_state *state) DECLSPEC_HIDDEN;
 BOOL wined3d_buffer_load_location(struct wined3d_buffer *buffer,
@@ -3835,6 +3930,8 @@ struct wined3d_swapchain
 
     HDC backup_dc;
     HWND backup_wnd;
+
+    HANDLE frame_latency_semaphore;
 };
 
 void wined3d_swapchain_activate(struct wined3d_swapchain *swapchain, BOOL activate) DECLSPEC_HIDDEN;
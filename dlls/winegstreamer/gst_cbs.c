@@ -272,3 +272,17 @@ gboolean query_sink_wrapper(GstPad *pad, GstObject *parent, GstQuery *query)
 
     return cbdata.u.query_sink_data.ret;
 }
+
+GstFlowReturn acquire_buffer_pool_wrapper(GstBufferPool *pool, GstBuffer **buffer,
+        GstBufferPoolAcquireParams *params)
+{
+    struct cb_data cbdata = { ACQUIRE_BUFFER_POOL };
+
+    cbdata.u.acquire_buffer_pool_data.pool = pool;
+    cbdata.u.acquire_buffer_pool_data.buffer = buffer;
+    cbdata.u.acquire_buffer_pool_data.params = params;
+
+    call_cb(&cbdata);
+
+    return cbdata.u.acquire_buffer_pool_data.ret;
+}
@@ -45,7 +45,8 @@ enum CB_TYPE {
     UNKNOWN_TYPE,
     RELEASE_SAMPLE,
     TRANSFORM_PAD_ADDED,
-    QUERY_SINK
+    QUERY_SINK,
+    ACQUIRE_BUFFER_POOL
 };
 
 struct cb_data {
@@ -144,6 +145,12 @@ struct cb_data {
             GstQuery *query;
             gboolean ret;
         } query_sink_data;
+        struct acquire_buffer_pool_data {
+            GstBufferPool *pool;
+            GstBuffer **buffer;
+            GstBufferPoolAcquireParams *params;
+            GstFlowReturn ret;
+        } acquire_buffer_pool_data;
     } u;
 
     int finished;
@@ -175,5 +182,6 @@ void unknown_type_wrapper(GstElement *bin, GstPad *pad, GstCaps *caps, gpointer
 void release_sample_wrapper(gpointer data) DECLSPEC_HIDDEN;
 void Gstreamer_transform_pad_added_wrapper(GstElement *filter, GstPad *pad, gpointer user) DECLSPEC_HIDDEN;
 gboolean query_sink_wrapper(GstPad *pad, GstObject *parent, GstQuery *query) DECLSPEC_HIDDEN;
+GstFlowReturn acquire_buffer_pool_wrapper(GstBufferPool *pool, GstBuffer **buffer, GstBufferPoolAcquireParams *params) DECLSPEC_HIDDEN;
 
 #endif
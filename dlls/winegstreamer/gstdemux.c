@@ -91,6 +91,21 @@ struct GSTOutPin {
 };
 
 const char* media_quark_string = "media-sample";
+static const char *pool_quark_string = "pool-sample";
+
+/* Buffer pool handing out samples from the output pin's allocator, so that
+ * decoders write their frames directly into the memory we deliver. */
+typedef struct WineSamplePool {
+    GstBufferPool parent;
+    GSTOutPin *pin;
+    guint size;
+} WineSamplePool;
+
+typedef struct WineSamplePoolClass {
+    GstBufferPoolClass parent_class;
+} WineSamplePoolClass;
+
+G_DEFINE_TYPE(WineSamplePool, wine_sample_pool, GST_TYPE_BUFFER_POOL);
 
 static const WCHAR wcsInputPinName[] = {'i','n','p','u','t',' ','p','i','n',0};
 static const IMediaSeekingVtbl GST_Seeking_Vtbl;
@@ -325,9 +340,121 @@ static gboolean setcaps_sink(GstPad *pad, GstCaps *caps)
     return TRUE;
 }
 
+/* set_config, start and release_buffer are called from GStreamer threads and
+ * must not touch anything Wine related. */
+static gboolean sample_pool_set_config(GstBufferPool *gstpool, GstStructure *config)
+{
+    WineSamplePool *pool = (WineSamplePool *)gstpool;
+    guint size, min, max;
+    GstCaps *caps;
+
+    if (!gst_buffer_pool_config_get_params(config, &caps, &size, &min, &max))
+        return FALSE;
+    pool->size = size;
+
+    return GST_BUFFER_POOL_CLASS(wine_sample_pool_parent_class)->set_config(gstpool, config);
+}
+
+static gboolean sample_pool_start(GstBufferPool *gstpool)
+{
+    /* Nothing to preallocate, buffers are created from samples on demand. */
+    return TRUE;
+}
+
+static void sample_pool_release_buffer(GstBufferPool *gstpool, GstBuffer *buffer)
+{
+    /* Never cache buffers, that would keep the samples out of the allocator. */
+    gst_buffer_unref(buffer);
+}
+
+static GstFlowReturn acquire_buffer_pool(GstBufferPool *gstpool, GstBuffer **buffer, GstBufferPoolAcquireParams *params)
+{
+    WineSamplePool *pool = (WineSamplePool *)gstpool;
+    GSTOutPin *pin = pool->pin;
+    IMediaSample *sample;
+    BYTE *data = NULL;
+    HRESULT hr;
+    LONG size;
+
+    TRACE("%p %p %p\n", gstpool, buffer, params);
+
+    hr = BaseOutputPinImpl_GetDeliveryBuffer(&pin->pin, &sample, NULL, NULL, 0);
+
+    if (hr == VFW_E_NOT_CONNECTED)
+        return GST_FLOW_NOT_LINKED;
+
+    if (FAILED(hr)) {
+        WARN("Could not get a delivery buffer (%x), returning GST_FLOW_FLUSHING\n", hr);
+        return GST_FLOW_FLUSHING;
+    }
+
+    size = IMediaSample_GetSize(sample);
+    if (size < pool->size) {
+        TRACE("Sample %p too small (%d < %u), using system memory\n", sample, size, pool->size);
+        IMediaSample_Release(sample);
+        return GST_BUFFER_POOL_CLASS(wine_sample_pool_parent_class)->acquire_buffer(gstpool, buffer, params);
+    }
+
+    IMediaSample_GetPointer(sample, &data);
+    *buffer = gst_buffer_new_wrapped_full(0, data, size, 0, pool->size, sample, release_sample_wrapper);
+    if (!*buffer) {
+        IMediaSample_Release(sample);
+        return GST_FLOW_ERROR;
+    }
+    gst_mini_object_set_qdata(GST_MINI_OBJECT(*buffer), g_quark_from_static_string(pool_quark_string), sample, NULL);
+
+    return GST_FLOW_OK;
+}
+
+static void wine_sample_pool_class_init(WineSamplePoolClass *klass)
+{
+    GstBufferPoolClass *pool_class = GST_BUFFER_POOL_CLASS(klass);
+
+    pool_class->set_config = sample_pool_set_config;
+    pool_class->start = sample_pool_start;
+    pool_class->acquire_buffer = acquire_buffer_pool_wrapper;
+    pool_class->release_buffer = sample_pool_release_buffer;
+}
+
+static void wine_sample_pool_init(WineSamplePool *pool)
+{
+}
+
+static gboolean query_allocation_sink(GstPad *pad, GstObject *parent, GstQuery *query)
+{
+    GSTOutPin *pin = gst_pad_get_element_private(pad);
+    ALLOCATOR_PROPERTIES props;
+    gboolean need_pool;
+    GstVideoInfo info;
+    GstCaps *caps;
+
+    gst_query_parse_allocation(query, &caps, &need_pool);
+
+    /* Only offer the pool when a whole frame fits into one sample. No video
+     * meta is advertised, so the frame layout matches what we used to copy. */
+    if (!caps || !pin->isvid || !pin->pin.pAllocator
+            || !gst_video_info_from_caps(&info, caps)
+            || FAILED(IMemAllocator_GetProperties(pin->pin.pAllocator, &props))
+            || props.cbBuffer < info.size)
+        return gst_pad_query_default(pad, parent, query);
+
+    if (!pin->gstpool) {
+        WineSamplePool *pool = g_object_new(wine_sample_pool_get_type(), NULL);
+        gst_object_ref_sink(pool);
+        pool->pin = pin;
+        pin->gstpool = GST_BUFFER_POOL(pool);
+    }
+
+    TRACE("Offering pool %p, frame size %u\n", pin->gstpool, (guint)info.size);
+    gst_query_add_allocation_pool(query, pin->gstpool, info.size, 0, 0);
+    return TRUE;
+}
+
 static gboolean query_sink(GstPad *pad, GstObject *parent, GstQuery *query)
 {
     switch (GST_QUERY_TYPE (query)) {
+        case GST_QUERY_ALLOCATION:
+            return query_allocation_sink(pad, parent, query);
         case GST_QUERY_ACCEPT_CAPS:
         {
             GstCaps *caps;
@@ -621,30 +748,49 @@ static GstFlowReturn got_data_sink(GstPad *pad, GstObject *parent, GstBuffer *bu
         return GST_FLOW_OK;
     }
 
-    hr = BaseOutputPinImpl_GetDeliveryBuffer(&pin->pin, &sample, NULL, NULL, 0);
+    gst_buffer_map(buf, &info, GST_MAP_READ);
 
-    if (hr == VFW_E_NOT_CONNECTED) {
-        gst_buffer_unref(buf);
-        return GST_FLOW_NOT_LINKED;
-    }
+    /* Buffers from our own pool already live in a sample, deliver it as is. */
+    sample = gst_mini_object_get_qdata(GST_MINI_OBJECT(buf), g_quark_from_static_string(pool_quark_string));
+    if (sample && buf->pool == pin->gstpool) {
+        IMediaSample_GetPointer(sample, &ptr);
+        if (ptr == info.data)
+            IMediaSample_AddRef(sample);
+        else
+            sample = NULL;
+    } else
+        sample = NULL;
 
-    if (FAILED(hr)) {
-        gst_buffer_unref(buf);
-        ERR("Could not get a delivery buffer (%x), returning GST_FLOW_FLUSHING\n", hr);
-        return GST_FLOW_FLUSHING;
-    }
+    if (!sample) {
+        hr = BaseOutputPinImpl_GetDeliveryBuffer(&pin->pin, &sample, NULL, NULL, 0);
 
-    gst_buffer_map(buf, &info, GST_MAP_READ);
+        if (hr == VFW_E_NOT_CONNECTED) {
+            gst_buffer_unmap(buf, &info);
+            gst_buffer_unref(buf);
+            return GST_FLOW_NOT_LINKED;
+        }
+
+        if (FAILED(hr)) {
+            gst_buffer_unmap(buf, &info);
+            gst_buffer_unref(buf);
+            ERR("Could not get a delivery buffer (%x), returning GST_FLOW_FLUSHING\n", hr);
+            return GST_FLOW_FLUSHING;
+        }
+
+        IMediaSample_GetPointer(sample, &ptr);
+    }
 
     hr = IMediaSample_SetActualDataLength(sample, info.size);
     if(FAILED(hr)){
         WARN("SetActualDataLength failed: %08x\n", hr);
+        gst_buffer_unmap(buf, &info);
+        gst_buffer_unref(buf);
+        IMediaSample_Release(sample);
         return GST_FLOW_FLUSHING;
     }
 
-    IMediaSample_GetPointer(sample, &ptr);
-
-    memcpy(ptr, info.data, info.size);
+    if (ptr != info.data)
+        memcpy(ptr, info.data, info.size);
 
     gst_buffer_unmap(buf, &info);
 
@@ -1828,6 +1974,8 @@ static HRESULT WINAPI GSTOutPin_DecideAllocator(BaseOutputPin *iface, IMemInputP
         {
             *pAlloc = GSTfilter->pInputPin.pAlloc;
             IMemAllocator_AddRef(*pAlloc);
+            /* Have the decoder renegotiate its allocation against the samples. */
+            gst_pad_push_event(This->my_sink, gst_event_new_reconfigure());
         }
     }
     else
@@ -2283,6 +2431,13 @@ void CALLBACK perform_cb(TP_CALLBACK_INSTANCE *instance, void *user)
                     data->query);
             break;
         }
+    case ACQUIRE_BUFFER_POOL:
+        {
+            struct acquire_buffer_pool_data *data = &cbdata->u.acquire_buffer_pool_data;
+            cbdata->u.acquire_buffer_pool_data.ret = acquire_buffer_pool(data->pool,
+                    data->buffer, data->params);
+            break;
+        }
     }
 
     pthread_mutex_lock(&cbdata->lock);
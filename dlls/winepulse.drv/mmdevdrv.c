@@ -71,6 +71,9 @@ enum DriverPriority {
 static const REFERENCE_TIME MinimumPeriod = 30000;
 static const REFERENCE_TIME DefaultPeriod = 100000;
 
+/* The timer thread sleeps with millisecond granularity */
+static const REFERENCE_TIME LowestPeriod = 10000;
+
 static pa_context *pulse_ctx;
 static pa_mainloop *pulse_ml;
 
@@ -85,6 +88,9 @@ static UINT g_phys_speakers_mask = 0;
 static WAVEFORMATEXTENSIBLE pulse_fmt[2];
 static REFERENCE_TIME pulse_min_period[2], pulse_def_period[2];
 
+/* User configured period times, 0 if not set */
+static REFERENCE_TIME pulse_cfg_min_period, pulse_cfg_def_period;
+
 static GUID pulse_render_guid =
 { 0xfd47d9cc, 0x4218, 0x4135, { 0x9c, 0xe2, 0x0c, 0x19, 0x5c, 0x87, 0x40, 0x5b } };
 static GUID pulse_capture_guid =
@@ -154,7 +160,7 @@ typedef struct _ACPacket {
 } ACPacket;
 
 struct ACImpl {
-    IAudioClient IAudioClient_iface;
+    IAudioClient3 IAudioClient3_iface;
     IAudioRenderClient IAudioRenderClient_iface;
     IAudioCaptureClient IAudioCaptureClient_iface;
     IAudioClock IAudioClock_iface;
@@ -195,7 +201,7 @@ struct ACImpl {
 
 static const WCHAR defaultW[] = {'P','u','l','s','e','a','u','d','i','o',0};
 
-static const IAudioClientVtbl AudioClient_Vtbl;
+static const IAudioClient3Vtbl AudioClient3_Vtbl;
 static const IAudioRenderClientVtbl AudioRenderClient_Vtbl;
 static const IAudioCaptureClientVtbl AudioCaptureClient_Vtbl;
 static const IAudioSessionControl2Vtbl AudioSessionControl2_Vtbl;
@@ -207,9 +213,9 @@ static const IAudioStreamVolumeVtbl AudioStreamVolume_Vtbl;
 
 static AudioSessionWrapper *AudioSessionWrapper_Create(ACImpl *client);
 
-static inline ACImpl *impl_from_IAudioClient(IAudioClient *iface)
+static inline ACImpl *impl_from_IAudioClient3(IAudioClient3 *iface)
 {
-    return CONTAINING_RECORD(iface, ACImpl, IAudioClient_iface);
+    return CONTAINING_RECORD(iface, ACImpl, IAudioClient3_iface);
 }
 
 static inline ACImpl *impl_from_IAudioRenderClient(IAudioRenderClient *iface)
@@ -431,6 +437,13 @@ static void pulse_probe_settings(int render, WAVEFORMATEXTENSIBLE *fmt) {
     if (pulse_def_period[!render] < DefaultPeriod)
         pulse_def_period[!render] = DefaultPeriod;
 
+    if (pulse_cfg_min_period)
+        pulse_min_period[!render] = pulse_cfg_min_period;
+    if (pulse_cfg_def_period)
+        pulse_def_period[!render] = pulse_cfg_def_period;
+    if (pulse_def_period[!render] < pulse_min_period[!render])
+        pulse_def_period[!render] = pulse_min_period[!render];
+
     wfx->wFormatTag = WAVE_FORMAT_EXTENSIBLE;
     wfx->cbSize = sizeof(WAVEFORMATEXTENSIBLE) - sizeof(WAVEFORMATEX);
     wfx->nChannels = ss.channels;
@@ -525,6 +538,60 @@ static void pulse_phys_speakers_cb(pa_context *c, const pa_sink_info *i, int eol
         g_phys_speakers_mask |= pulse_channel_map_to_channel_mask(&i->channel_map);
 }
 
+static BOOL pulse_config_dword(HKEY key, const WCHAR *name, DWORD *value)
+{
+    DWORD type, size = sizeof(*value);
+
+    return key && !RegQueryValueExW(key, name, 0, &type, (BYTE *)value, &size) && type == REG_DWORD;
+}
+
+static REFERENCE_TIME pulse_config_period(HKEY defkey, HKEY appkey, const WCHAR *name)
+{
+    DWORD value;
+
+    if (!pulse_config_dword(appkey, name, &value) && !pulse_config_dword(defkey, name, &value))
+        return 0;
+
+    TRACE("%s = %u\n", debugstr_w(name), value);
+    return max(value, LowestPeriod);
+}
+
+/* Period times are given in 100-nanosecond units, like REFERENCE_TIME. */
+static void pulse_read_config(void)
+{
+    static const WCHAR pulse_keyW[] = {'S','o','f','t','w','a','r','e','\\',
+        'W','i','n','e','\\','P','u','l','s','e',0};
+    static const WCHAR appdefaults_keyW[] = {'S','o','f','t','w','a','r','e','\\',
+        'W','i','n','e','\\','A','p','p','D','e','f','a','u','l','t','s',0};
+    static const WCHAR pulseW[] = {'\\','P','u','l','s','e',0};
+    static const WCHAR min_periodW[] = {'M','i','n','i','m','u','m','P','e','r','i','o','d',0};
+    static const WCHAR def_periodW[] = {'D','e','f','a','u','l','t','P','e','r','i','o','d',0};
+    WCHAR path[MAX_PATH + sizeof(pulseW) / sizeof(WCHAR)], *name;
+    HKEY hkey, appkey = 0, tmpkey;
+    DWORD len;
+
+    /* @@ Wine registry key: HKCU\Software\Wine\Pulse */
+    if (RegOpenKeyW(HKEY_CURRENT_USER, pulse_keyW, &hkey)) hkey = 0;
+
+    len = GetModuleFileNameW(NULL, path, MAX_PATH);
+    if (len && len < MAX_PATH) {
+        /* @@ Wine registry key: HKCU\Software\Wine\AppDefaults\app.exe\Pulse */
+        if (!RegOpenKeyW(HKEY_CURRENT_USER, appdefaults_keyW, &tmpkey)) {
+            name = strrchrW(path, '\\');
+            name = name ? name + 1 : path;
+            strcatW(name, pulseW);
+            if (RegOpenKeyW(tmpkey, name, &appkey)) appkey = 0;
+            RegCloseKey(tmpkey);
+        }
+    }
+
+    pulse_cfg_min_period = pulse_config_period(hkey, appkey, min_periodW);
+    pulse_cfg_def_period = pulse_config_period(hkey, appkey, def_periodW);
+
+    if (appkey) RegCloseKey(appkey);
+    if (hkey) RegCloseKey(hkey);
+}
+
 /* some poorly-behaved applications call audio functions during DllMain, so we
  * have to do as much as possible without creating a new thread. this function
  * sets up a synchronous connection to verify the server is running and query
@@ -583,6 +650,7 @@ static HRESULT pulse_test_connect(void)
         pa_context_get_server(pulse_ctx),
         pa_context_get_server_protocol_version(pulse_ctx));
 
+    pulse_read_config();
     pulse_probe_settings(1, &pulse_fmt[0]);
     pulse_probe_settings(0, &pulse_fmt[1]);
 
@@ -983,7 +1051,7 @@ HRESULT WINAPI AUDDRV_GetAudioEndpoint(GUID *guid, IMMDevice *dev, IAudioClient
     if (!This)
         return E_OUTOFMEMORY;
 
-    This->IAudioClient_iface.lpVtbl = &AudioClient_Vtbl;
+    This->IAudioClient3_iface.lpVtbl = &AudioClient3_Vtbl;
     This->IAudioRenderClient_iface.lpVtbl = &AudioRenderClient_Vtbl;
     This->IAudioCaptureClient_iface.lpVtbl = &AudioCaptureClient_Vtbl;
     This->IAudioClock_iface.lpVtbl = &AudioClock_Vtbl;
@@ -994,23 +1062,23 @@ HRESULT WINAPI AUDDRV_GetAudioEndpoint(GUID *guid, IMMDevice *dev, IAudioClient
     for (i = 0; i < PA_CHANNELS_MAX; ++i)
         This->vol[i] = 1.f;
 
-    hr = CoCreateFreeThreadedMarshaler((IUnknown*)&This->IAudioClient_iface, &This->marshal);
+    hr = CoCreateFreeThreadedMarshaler((IUnknown*)&This->IAudioClient3_iface, &This->marshal);
     if (hr) {
         HeapFree(GetProcessHeap(), 0, This);
         return hr;
     }
     IMMDevice_AddRef(This->parent);
 
-    *out = &This->IAudioClient_iface;
-    IAudioClient_AddRef(&This->IAudioClient_iface);
+    *out = (IAudioClient *)&This->IAudioClient3_iface;
+    IAudioClient3_AddRef(&This->IAudioClient3_iface);
 
     return S_OK;
 }
 
-static HRESULT WINAPI AudioClient_QueryInterface(IAudioClient *iface,
+static HRESULT WINAPI AudioClient_QueryInterface(IAudioClient3 *iface,
         REFIID riid, void **ppv)
 {
-    ACImpl *This = impl_from_IAudioClient(iface);
+    ACImpl *This = impl_from_IAudioClient3(iface);
 
     TRACE("(%p)->(%s, %p)\n", iface, debugstr_guid(riid), ppv);
 
@@ -1018,7 +1086,10 @@ static HRESULT WINAPI AudioClient_QueryInterface(IAudioClient *iface,
         return E_POINTER;
 
     *ppv = NULL;
-    if (IsEqualIID(riid, &IID_IUnknown) || IsEqualIID(riid, &IID_IAudioClient))
+    if (IsEqualIID(riid, &IID_IUnknown) ||
+            IsEqualIID(riid, &IID_IAudioClient) ||
+            IsEqualIID(riid, &IID_IAudioClient2) ||
+            IsEqualIID(riid, &IID_IAudioClient3))
         *ppv = iface;
     if (*ppv) {
         IUnknown_AddRef((IUnknown*)*ppv);
@@ -1032,18 +1103,18 @@ static HRESULT WINAPI AudioClient_QueryInterface(IAudioClient *iface,
     return E_NOINTERFACE;
 }
 
-static ULONG WINAPI AudioClient_AddRef(IAudioClient *iface)
+static ULONG WINAPI AudioClient_AddRef(IAudioClient3 *iface)
 {
-    ACImpl *This = impl_from_IAudioClient(iface);
+    ACImpl *This = impl_from_IAudioClient3(iface);
     ULONG ref;
     ref = InterlockedIncrement(&This->ref);
     TRACE("(%p) Refcount now %u\n", This, ref);
     return ref;
 }
 
-static ULONG WINAPI AudioClient_Release(IAudioClient *iface)
+static ULONG WINAPI AudioClient_Release(IAudioClient3 *iface)
 {
-    ACImpl *This = impl_from_IAudioClient(iface);
+    ACImpl *This = impl_from_IAudioClient3(iface);
     ULONG ref;
     ref = InterlockedDecrement(&This->ref);
     TRACE("(%p) Refcount now %u\n", This, ref);
@@ -1342,18 +1413,13 @@ static HRESULT pulse_spec_from_waveformat(ACImpl *This, const WAVEFORMATEX *fmt)
     return S_OK;
 }
 
-static HRESULT WINAPI AudioClient_Initialize(IAudioClient *iface,
-        AUDCLNT_SHAREMODE mode, DWORD flags, REFERENCE_TIME duration,
-        REFERENCE_TIME period, const WAVEFORMATEX *fmt,
+static HRESULT pulse_initialize(ACImpl *This, AUDCLNT_SHAREMODE mode, DWORD flags,
+        REFERENCE_TIME duration, REFERENCE_TIME period, const WAVEFORMATEX *fmt,
         const GUID *sessionguid)
 {
-    ACImpl *This = impl_from_IAudioClient(iface);
     HRESULT hr = S_OK;
     UINT32 bufsize_bytes;
 
-    TRACE("(%p)->(%x, %x, %s, %s, %p, %s)\n", This, mode, flags,
-          wine_dbgstr_longlong(duration), wine_dbgstr_longlong(period), fmt, debugstr_guid(sessionguid));
-
     if (!fmt)
         return E_POINTER;
 
@@ -1394,7 +1460,6 @@ static HRESULT WINAPI AudioClient_Initialize(IAudioClient *iface,
     if (FAILED(hr))
         goto exit;
 
-    period = pulse_def_period[This->dataflow == eCapture];
     if (duration < 3 * period)
         duration = 3 * period;
 
@@ -1464,10 +1529,26 @@ exit:
     return hr;
 }
 
-static HRESULT WINAPI AudioClient_GetBufferSize(IAudioClient *iface,
+static HRESULT WINAPI AudioClient_Initialize(IAudioClient3 *iface,
+        AUDCLNT_SHAREMODE mode, DWORD flags, REFERENCE_TIME duration,
+        REFERENCE_TIME period, const WAVEFORMATEX *fmt,
+        const GUID *sessionguid)
+{
+    ACImpl *This = impl_from_IAudioClient3(iface);
+
+    TRACE("(%p)->(%x, %x, %s, %s, %p, %s)\n", This, mode, flags,
+          wine_dbgstr_longlong(duration), wine_dbgstr_longlong(period), fmt, debugstr_guid(sessionguid));
+
+    /* The period is ignored in shared mode, use InitializeSharedAudioStream
+     * to request a specific one. */
+    return pulse_initialize(This, mode, flags, duration,
+            pulse_def_period[This->dataflow == eCapture], fmt, sessionguid);
+}
+
+static HRESULT WINAPI AudioClient_GetBufferSize(IAudioClient3 *iface,
         UINT32 *out)
 {
-    ACImpl *This = impl_from_IAudioClient(iface);
+    ACImpl *This = impl_from_IAudioClient3(iface);
     HRESULT hr;
 
     TRACE("(%p)->(%p)\n", This, out);
@@ -1484,10 +1565,10 @@ static HRESULT WINAPI AudioClient_GetBufferSize(IAudioClient *iface,
     return hr;
 }
 
-static HRESULT WINAPI AudioClient_GetStreamLatency(IAudioClient *iface,
+static HRESULT WINAPI AudioClient_GetStreamLatency(IAudioClient3 *iface,
         REFERENCE_TIME *latency)
 {
-    ACImpl *This = impl_from_IAudioClient(iface);
+    ACImpl *This = impl_from_IAudioClient3(iface);
     const pa_buffer_attr *attr;
     REFERENCE_TIME lat;
     HRESULT hr;
@@ -1511,7 +1592,7 @@ static HRESULT WINAPI AudioClient_GetStreamLatency(IAudioClient *iface,
     *latency = 10000000;
     *latency *= lat;
     *latency /= This->ss.rate;
-    *latency += pulse_def_period[0];
+    *latency += This->mmdev_period_usec * 10;
     pthread_mutex_unlock(&pulse_lock);
     TRACE("Latency: %u ms\n", (DWORD)(*latency / 10000));
     return S_OK;
@@ -1534,10 +1615,10 @@ static void ACImpl_GetCapturePad(ACImpl *This, UINT32 *out)
         *out = This->held_bytes / pa_frame_size(&This->ss);
 }
 
-static HRESULT WINAPI AudioClient_GetCurrentPadding(IAudioClient *iface,
+static HRESULT WINAPI AudioClient_GetCurrentPadding(IAudioClient3 *iface,
         UINT32 *out)
 {
-    ACImpl *This = impl_from_IAudioClient(iface);
+    ACImpl *This = impl_from_IAudioClient3(iface);
     HRESULT hr;
 
     TRACE("(%p)->(%p)\n", This, out);
@@ -1562,11 +1643,11 @@ static HRESULT WINAPI AudioClient_GetCurrentPadding(IAudioClient *iface,
     return S_OK;
 }
 
-static HRESULT WINAPI AudioClient_IsFormatSupported(IAudioClient *iface,
+static HRESULT WINAPI AudioClient_IsFormatSupported(IAudioClient3 *iface,
         AUDCLNT_SHAREMODE mode, const WAVEFORMATEX *fmt,
         WAVEFORMATEX **out)
 {
-    ACImpl *This = impl_from_IAudioClient(iface);
+    ACImpl *This = impl_from_IAudioClient3(iface);
     HRESULT hr = S_OK;
     WAVEFORMATEX *closest = NULL;
     BOOL exclusive;
@@ -1715,10 +1796,10 @@ static HRESULT WINAPI AudioClient_IsFormatSupported(IAudioClient *iface,
     return hr;
 }
 
-static HRESULT WINAPI AudioClient_GetMixFormat(IAudioClient *iface,
+static HRESULT WINAPI AudioClient_GetMixFormat(IAudioClient3 *iface,
         WAVEFORMATEX **pwfx)
 {
-    ACImpl *This = impl_from_IAudioClient(iface);
+    ACImpl *This = impl_from_IAudioClient3(iface);
     WAVEFORMATEXTENSIBLE *fmt = &pulse_fmt[This->dataflow == eCapture];
 
     TRACE("(%p)->(%p)\n", This, pwfx);
@@ -1733,10 +1814,10 @@ static HRESULT WINAPI AudioClient_GetMixFormat(IAudioClient *iface,
     return S_OK;
 }
 
-static HRESULT WINAPI AudioClient_GetDevicePeriod(IAudioClient *iface,
+static HRESULT WINAPI AudioClient_GetDevicePeriod(IAudioClient3 *iface,
         REFERENCE_TIME *defperiod, REFERENCE_TIME *minperiod)
 {
-    ACImpl *This = impl_from_IAudioClient(iface);
+    ACImpl *This = impl_from_IAudioClient3(iface);
 
     TRACE("(%p)->(%p, %p)\n", This, defperiod, minperiod);
 
@@ -1751,9 +1832,9 @@ static HRESULT WINAPI AudioClient_GetDevicePeriod(IAudioClient *iface,
     return S_OK;
 }
 
-static HRESULT WINAPI AudioClient_Start(IAudioClient *iface)
+static HRESULT WINAPI AudioClient_Start(IAudioClient3 *iface)
 {
-    ACImpl *This = impl_from_IAudioClient(iface);
+    ACImpl *This = impl_from_IAudioClient3(iface);
     HRESULT hr = S_OK;
     int success;
     pa_operation *o;
@@ -1795,16 +1876,18 @@ static HRESULT WINAPI AudioClient_Start(IAudioClient *iface)
         This->started = TRUE;
         This->just_started = TRUE;
 
-        if(!This->timer)
+        if(!This->timer) {
             This->timer = CreateThread(NULL, 0, pulse_timer_cb, This, 0, NULL);
+            SetThreadPriority(This->timer, THREAD_PRIORITY_TIME_CRITICAL);
+        }
     }
     pthread_mutex_unlock(&pulse_lock);
     return hr;
 }
 
-static HRESULT WINAPI AudioClient_Stop(IAudioClient *iface)
+static HRESULT WINAPI AudioClient_Stop(IAudioClient3 *iface)
 {
-    ACImpl *This = impl_from_IAudioClient(iface);
+    ACImpl *This = impl_from_IAudioClient3(iface);
     HRESULT hr = S_OK;
     pa_operation *o;
     int success;
@@ -1841,9 +1924,9 @@ static HRESULT WINAPI AudioClient_Stop(IAudioClient *iface)
     return hr;
 }
 
-static HRESULT WINAPI AudioClient_Reset(IAudioClient *iface)
+static HRESULT WINAPI AudioClient_Reset(IAudioClient3 *iface)
 {
-    ACImpl *This = impl_from_IAudioClient(iface);
+    ACImpl *This = impl_from_IAudioClient3(iface);
     HRESULT hr = S_OK;
 
     TRACE("(%p)\n", This);
@@ -1896,10 +1979,10 @@ static HRESULT WINAPI AudioClient_Reset(IAudioClient *iface)
     return hr;
 }
 
-static HRESULT WINAPI AudioClient_SetEventHandle(IAudioClient *iface,
+static HRESULT WINAPI AudioClient_SetEventHandle(IAudioClient3 *iface,
         HANDLE event)
 {
-    ACImpl *This = impl_from_IAudioClient(iface);
+    ACImpl *This = impl_from_IAudioClient3(iface);
     HRESULT hr;
 
     TRACE("(%p)->(%p)\n", This, event);
@@ -1924,10 +2007,10 @@ static HRESULT WINAPI AudioClient_SetEventHandle(IAudioClient *iface,
     return hr;
 }
 
-static HRESULT WINAPI AudioClient_GetService(IAudioClient *iface, REFIID riid,
+static HRESULT WINAPI AudioClient_GetService(IAudioClient3 *iface, REFIID riid,
         void **ppv)
 {
-    ACImpl *This = impl_from_IAudioClient(iface);
+    ACImpl *This = impl_from_IAudioClient3(iface);
     HRESULT hr;
 
     TRACE("(%p)->(%s, %p)\n", This, debugstr_guid(riid), ppv);
@@ -1979,7 +2062,134 @@ static HRESULT WINAPI AudioClient_GetService(IAudioClient *iface, REFIID riid,
     return E_NOINTERFACE;
 }
 
-static const IAudioClientVtbl AudioClient_Vtbl =
+static HRESULT WINAPI AudioClient_IsOffloadCapable(IAudioClient3 *iface,
+        AUDIO_STREAM_CATEGORY category, BOOL *offload_capable)
+{
+    ACImpl *This = impl_from_IAudioClient3(iface);
+
+    TRACE("(%p)->(0x%x, %p)\n", This, category, offload_capable);
+
+    if (!offload_capable)
+        return E_INVALIDARG;
+
+    *offload_capable = FALSE;
+
+    return S_OK;
+}
+
+static HRESULT WINAPI AudioClient_SetClientProperties(IAudioClient3 *iface,
+        const AudioClientProperties *prop)
+{
+    ACImpl *This = impl_from_IAudioClient3(iface);
+
+    TRACE("(%p)->(%p)\n", This, prop);
+
+    if (!prop)
+        return E_POINTER;
+
+    /* Windows 8 clients pass the structure without Options */
+    if (prop->cbSize != sizeof(AudioClientProperties) &&
+            prop->cbSize != FIELD_OFFSET(AudioClientProperties, Options)) {
+        WARN("Unsupported size %u\n", prop->cbSize);
+        return E_INVALIDARG;
+    }
+
+    TRACE("Offload: %u, category: %u\n", prop->bIsOffload, prop->eCategory);
+
+    if (prop->bIsOffload)
+        return AUDCLNT_E_ENDPOINT_OFFLOAD_NOT_CAPABLE;
+
+    return S_OK;
+}
+
+static HRESULT WINAPI AudioClient_GetBufferSizeLimits(IAudioClient3 *iface,
+        const WAVEFORMATEX *format, BOOL event_driven, REFERENCE_TIME *min_duration,
+        REFERENCE_TIME *max_duration)
+{
+    ACImpl *This = impl_from_IAudioClient3(iface);
+
+    FIXME("(%p)->(%p, %u, %p, %p)\n", This, format, event_driven, min_duration, max_duration);
+
+    return E_NOTIMPL;
+}
+
+static HRESULT WINAPI AudioClient_GetSharedModeEnginePeriod(IAudioClient3 *iface,
+        const WAVEFORMATEX *format, UINT32 *default_period_frames, UINT32 *unit_period_frames,
+        UINT32 *min_period_frames, UINT32 *max_period_frames)
+{
+    ACImpl *This = impl_from_IAudioClient3(iface);
+    int cap = This->dataflow == eCapture;
+
+    TRACE("(%p)->(%p, %p, %p, %p, %p)\n", This, format, default_period_frames,
+          unit_period_frames, min_period_frames, max_period_frames);
+
+    if (!format || !default_period_frames || !unit_period_frames ||
+            !min_period_frames || !max_period_frames)
+        return E_POINTER;
+
+    if (!format->nSamplesPerSec)
+        return E_INVALIDARG;
+
+    *default_period_frames = MulDiv(pulse_def_period[cap], format->nSamplesPerSec, 10000000);
+    *min_period_frames = MulDiv(pulse_min_period[cap], format->nSamplesPerSec, 10000000);
+    *max_period_frames = *default_period_frames;
+    *unit_period_frames = 1;
+
+    return S_OK;
+}
+
+static HRESULT WINAPI AudioClient_GetCurrentSharedModeEnginePeriod(IAudioClient3 *iface,
+        WAVEFORMATEX **format, UINT32 *cur_period_frames)
+{
+    ACImpl *This = impl_from_IAudioClient3(iface);
+    HRESULT hr;
+
+    TRACE("(%p)->(%p, %p)\n", This, format, cur_period_frames);
+
+    if (!format || !cur_period_frames)
+        return E_POINTER;
+
+    hr = AudioClient_GetMixFormat(iface, format);
+    if (FAILED(hr))
+        return hr;
+
+    pthread_mutex_lock(&pulse_lock);
+    if (This->stream)
+        *cur_period_frames = MulDiv(This->mmdev_period_usec, (*format)->nSamplesPerSec, 1000000);
+    else
+        *cur_period_frames = MulDiv(pulse_def_period[This->dataflow == eCapture],
+                (*format)->nSamplesPerSec, 10000000);
+    pthread_mutex_unlock(&pulse_lock);
+
+    return S_OK;
+}
+
+static HRESULT WINAPI AudioClient_InitializeSharedAudioStream(IAudioClient3 *iface,
+        DWORD flags, UINT32 period_frames, const WAVEFORMATEX *format,
+        const GUID *session_guid)
+{
+    ACImpl *This = impl_from_IAudioClient3(iface);
+    int cap = This->dataflow == eCapture;
+    REFERENCE_TIME period;
+
+    TRACE("(%p)->(0x%x, %u, %p, %s)\n", This, flags, period_frames, format, debugstr_guid(session_guid));
+
+    if (!format)
+        return E_POINTER;
+
+    if (!format->nSamplesPerSec)
+        return AUDCLNT_E_UNSUPPORTED_FORMAT;
+
+    if (period_frames < MulDiv(pulse_min_period[cap], format->nSamplesPerSec, 10000000) ||
+            period_frames > MulDiv(pulse_def_period[cap], format->nSamplesPerSec, 10000000))
+        return AUDCLNT_E_INVALID_DEVICE_PERIOD;
+
+    period = (REFERENCE_TIME)period_frames * 10000000 / format->nSamplesPerSec;
+
+    return pulse_initialize(This, AUDCLNT_SHAREMODE_SHARED, flags, 0, period, format, session_guid);
+}
+
+static const IAudioClient3Vtbl AudioClient3_Vtbl =
 {
     AudioClient_QueryInterface,
     AudioClient_AddRef,
@@ -1995,7 +2205,13 @@ static const IAudioClientVtbl AudioClient_Vtbl =
     AudioClient_Stop,
     AudioClient_Reset,
     AudioClient_SetEventHandle,
-    AudioClient_GetService
+    AudioClient_GetService,
+    AudioClient_IsOffloadCapable,
+    AudioClient_SetClientProperties,
+    AudioClient_GetBufferSizeLimits,
+    AudioClient_GetSharedModeEnginePeriod,
+    AudioClient_GetCurrentSharedModeEnginePeriod,
+    AudioClient_InitializeSharedAudioStream
 };
 
 static HRESULT WINAPI AudioRenderClient_QueryInterface(
@@ -2026,13 +2242,13 @@ static HRESULT WINAPI AudioRenderClient_QueryInterface(
 static ULONG WINAPI AudioRenderClient_AddRef(IAudioRenderClient *iface)
 {
     ACImpl *This = impl_from_IAudioRenderClient(iface);
-    return AudioClient_AddRef(&This->IAudioClient_iface);
+    return AudioClient_AddRef(&This->IAudioClient3_iface);
 }
 
 static ULONG WINAPI AudioRenderClient_Release(IAudioRenderClient *iface)
 {
     ACImpl *This = impl_from_IAudioRenderClient(iface);
-    return AudioClient_Release(&This->IAudioClient_iface);
+    return AudioClient_Release(&This->IAudioClient3_iface);
 }
 
 static void alloc_tmp_buffer(ACImpl *This, UINT32 bytes)
@@ -2186,13 +2402,13 @@ static HRESULT WINAPI AudioCaptureClient_QueryInterface(
 static ULONG WINAPI AudioCaptureClient_AddRef(IAudioCaptureClient *iface)
 {
     ACImpl *This = impl_from_IAudioCaptureClient(iface);
-    return IAudioClient_AddRef(&This->IAudioClient_iface);
+    return IAudioClient3_AddRef(&This->IAudioClient3_iface);
 }
 
 static ULONG WINAPI AudioCaptureClient_Release(IAudioCaptureClient *iface)
 {
     ACImpl *This = impl_from_IAudioCaptureClient(iface);
-    return IAudioClient_Release(&This->IAudioClient_iface);
+    return IAudioClient3_Release(&This->IAudioClient3_iface);
 }
 
 static HRESULT WINAPI AudioCaptureClient_GetBuffer(IAudioCaptureClient *iface,
@@ -2329,13 +2545,13 @@ static HRESULT WINAPI AudioClock_QueryInterface(IAudioClock *iface,
 static ULONG WINAPI AudioClock_AddRef(IAudioClock *iface)
 {
     ACImpl *This = impl_from_IAudioClock(iface);
-    return IAudioClient_AddRef(&This->IAudioClient_iface);
+    return IAudioClient3_AddRef(&This->IAudioClient3_iface);
 }
 
 static ULONG WINAPI AudioClock_Release(IAudioClock *iface)
 {
     ACImpl *This = impl_from_IAudioClock(iface);
-    return IAudioClient_Release(&This->IAudioClient_iface);
+    return IAudioClient3_Release(&This->IAudioClient3_iface);
 }
 
 static HRESULT WINAPI AudioClock_GetFrequency(IAudioClock *iface, UINT64 *freq)
@@ -2440,13 +2656,13 @@ static HRESULT WINAPI AudioClock2_QueryInterface(IAudioClock2 *iface,
 static ULONG WINAPI AudioClock2_AddRef(IAudioClock2 *iface)
 {
     ACImpl *This = impl_from_IAudioClock2(iface);
-    return IAudioClient_AddRef(&This->IAudioClient_iface);
+    return IAudioClient3_AddRef(&This->IAudioClient3_iface);
 }
 
 static ULONG WINAPI AudioClock2_Release(IAudioClock2 *iface)
 {
     ACImpl *This = impl_from_IAudioClock2(iface);
-    return IAudioClient_Release(&This->IAudioClient_iface);
+    return IAudioClient3_Release(&This->IAudioClient3_iface);
 }
 
 static HRESULT WINAPI AudioClock2_GetDevicePosition(IAudioClock2 *iface,
@@ -2496,13 +2712,13 @@ static HRESULT WINAPI AudioStreamVolume_QueryInterface(
 static ULONG WINAPI AudioStreamVolume_AddRef(IAudioStreamVolume *iface)
 {
     ACImpl *This = impl_from_IAudioStreamVolume(iface);
-    return IAudioClient_AddRef(&This->IAudioClient_iface);
+    return IAudioClient3_AddRef(&This->IAudioClient3_iface);
 }
 
 static ULONG WINAPI AudioStreamVolume_Release(IAudioStreamVolume *iface)
 {
     ACImpl *This = impl_from_IAudioStreamVolume(iface);
-    return IAudioClient_Release(&This->IAudioClient_iface);
+    return IAudioClient3_Release(&This->IAudioClient3_iface);
 }
 
 static HRESULT WINAPI AudioStreamVolume_GetChannelCount(
@@ -2654,7 +2870,7 @@ static AudioSessionWrapper *AudioSessionWrapper_Create(ACImpl *client)
     ret->client = client;
     if (client) {
         ret->session = client->session;
-        AudioClient_AddRef(&client->IAudioClient_iface);
+        AudioClient_AddRef(&client->IAudioClient3_iface);
     }
 
     return ret;
@@ -2700,7 +2916,7 @@ static ULONG WINAPI AudioSessionControl_Release(IAudioSessionControl2 *iface)
     if (!ref) {
         if (This->client) {
             This->client->session_wrapper = NULL;
-            AudioClient_Release(&This->client->IAudioClient_iface);
+            AudioClient_Release(&This->client->IAudioClient3_iface);
         }
         HeapFree(GetProcessHeap(), 0, This);
     }
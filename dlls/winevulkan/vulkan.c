@@ -35,6 +35,10 @@ WINE_DEFAULT_DEBUG_CHANNEL(vulkan);
  */
 #define WINE_VULKAN_ICD_VERSION 4
 
+/* Sizes of the on-stack arrays used to unwrap handles on hot paths. */
+#define WINE_VK_STACK_ARRAY_SIZE 64
+#define WINE_VK_STACK_SUBMIT_COUNT 8
+
 /* All Vulkan structures use this structure for the first elements. */
 struct wine_vk_structure_header
 {
@@ -545,7 +549,8 @@ VkResult WINAPI wine_vkAllocateCommandBuffers(VkDevice device,
 void WINAPI wine_vkCmdExecuteCommands(VkCommandBuffer buffer, uint32_t count,
         const VkCommandBuffer *buffers)
 {
-    VkCommandBuffer *tmp_buffers;
+    VkCommandBuffer stack_buffers[WINE_VK_STACK_ARRAY_SIZE];
+    VkCommandBuffer *tmp_buffers = stack_buffers;
     unsigned int i;
 
     TRACE("%p %u %p\n", buffer, count, buffers);
@@ -554,11 +559,8 @@ void WINAPI wine_vkCmdExecuteCommands(VkCommandBuffer buffer, uint32_t count,
         return;
 
     /* Unfortunately we need a temporary buffer as our command buffers are wrapped.
-     * This call is called often and if a performance concern, we may want to use
-     * alloca as we shouldn't need much memory and it needs to be cleaned up after
-     * the call anyway.
-     */
-    if (!(tmp_buffers = heap_alloc(count * sizeof(*tmp_buffers))))
+     * This call is made often, so avoid the heap for the common small counts. */
+    if (count > ARRAY_SIZE(stack_buffers) && !(tmp_buffers = heap_alloc(count * sizeof(*tmp_buffers))))
     {
         ERR("Failed to allocate memory for temporary command buffers\n");
         return;
@@ -569,7 +571,8 @@ void WINAPI wine_vkCmdExecuteCommands(VkCommandBuffer buffer, uint32_t count,
 
     buffer->device->funcs.p_vkCmdExecuteCommands(buffer->command_buffer, count, tmp_buffers);
 
-    heap_free(tmp_buffers);
+    if (tmp_buffers != stack_buffers)
+        heap_free(tmp_buffers);
 }
 
 VkResult WINAPI wine_vkCreateDevice(VkPhysicalDevice phys_dev,
@@ -1011,10 +1014,12 @@ VkResult WINAPI wine_vk_icdNegotiateLoaderICDInterfaceVersion(uint32_t *supporte
 VkResult WINAPI wine_vkQueueSubmit(VkQueue queue, uint32_t count,
         const VkSubmitInfo *submits, VkFence fence)
 {
-    VkSubmitInfo *submits_host;
-    VkResult res;
-    VkCommandBuffer *command_buffers;
+    VkCommandBuffer stack_command_buffers[WINE_VK_STACK_ARRAY_SIZE];
+    VkSubmitInfo stack_submits[WINE_VK_STACK_SUBMIT_COUNT];
+    VkCommandBuffer *command_buffers = stack_command_buffers;
+    VkSubmitInfo *submits_host = stack_submits;
     unsigned int i, j, num_command_buffers;
+    VkResult res;
 
     TRACE("%p %u %p 0x%s\n", queue, count, submits, wine_dbgstr_longlong(fence));
 
@@ -1023,41 +1028,41 @@ VkResult WINAPI wine_vkQueueSubmit(VkQueue queue, uint32_t count,
         return queue->device->funcs.p_vkQueueSubmit(queue->queue, 0, NULL, fence);
     }
 
-    submits_host = heap_calloc(count, sizeof(*submits_host));
-    if (!submits_host)
+    /* Most submissions only carry a handful of command buffers; unwrap them
+     * into a single flat array, which only needs the heap for large batches. */
+    for (i = 0, num_command_buffers = 0; i < count; i++)
+        num_command_buffers += submits[i].commandBufferCount;
+
+    if (count > ARRAY_SIZE(stack_submits) && !(submits_host = heap_alloc(count * sizeof(*submits_host))))
     {
         ERR("Unable to allocate memory for submit buffers!\n");
         return VK_ERROR_OUT_OF_HOST_MEMORY;
     }
 
-    for (i = 0; i < count; i++)
+    if (num_command_buffers > ARRAY_SIZE(stack_command_buffers)
+            && !(command_buffers = heap_alloc(num_command_buffers * sizeof(*command_buffers))))
     {
-        memcpy(&submits_host[i], &submits[i], sizeof(*submits_host));
+        ERR("Unable to allocate memory for command buffers!\n");
+        res = VK_ERROR_OUT_OF_HOST_MEMORY;
+        goto done;
+    }
 
-        num_command_buffers = submits[i].commandBufferCount;
-        command_buffers = heap_calloc(num_command_buffers, sizeof(*submits_host));
-        if (!command_buffers)
-        {
-            ERR("Unable to allocate memory for comman buffers!\n");
-            res = VK_ERROR_OUT_OF_HOST_MEMORY;
-            goto err;
-        }
+    for (i = 0, num_command_buffers = 0; i < count; i++)
+    {
+        submits_host[i] = submits[i];
+        submits_host[i].pCommandBuffers = &command_buffers[num_command_buffers];
 
-        for (j = 0; j < num_command_buffers; j++)
-        {
-            command_buffers[j] = submits[i].pCommandBuffers[j]->command_buffer;
-        }
-        submits_host[i].pCommandBuffers = command_buffers;
+        for (j = 0; j < submits[i].commandBufferCount; j++)
+            command_buffers[num_command_buffers++] = submits[i].pCommandBuffers[j]->command_buffer;
     }
 
     res = queue->device->funcs.p_vkQueueSubmit(queue->queue, count, submits_host, fence);
 
-err:
-    for (i = 0; i < count; i++)
-    {
-        heap_free((void *)submits_host[i].pCommandBuffers);
-    }
-    heap_free(submits_host);
+    if (command_buffers != stack_command_buffers)
+        heap_free(command_buffers);
+done:
+    if (submits_host != stack_submits)
+        heap_free(submits_host);
 
     TRACE("Returning %d\n", res);
     return res;
@@ -1556,13 +1556,20 @@ DWORD get_pixmap_image( Pixmap pixmap, int width, int height, const XVisualInfo
 }
 
 
+#define MAX_DIRTY_RECTS 8     /* damage rectangles tracked before merging them */
+#define SURFACE_FLUSH_PERIOD 50  /* time in ms since drawing started for forcing a surface flush */
+
 struct x11drv_window_surface
 {
     struct window_surface header;
     Window                window;
     GC                    gc;
     XImage               *image;
-    RECT                  bounds;
+    RECT                  bounds;  /* damage accumulated by the current drawing operation */
+    RECT                  dirty[MAX_DIRTY_RECTS];  /* damage accumulated since the last flush */
+    unsigned int          dirty_count;
+    DWORD                 dirty_ticks;
+    int                   lock_count;
     BOOL                  byteswap;
     BOOL                  is_argb;
     DWORD                 alpha_bits;
@@ -1821,6 +1828,54 @@ static void x11drv_surface_lock( struct window_surface *window_surface )
     struct x11drv_window_surface *surface = get_x11_surface( window_surface );
 
     EnterCriticalSection( &surface->crit );
+    surface->lock_count++;
+}
+
+static inline int get_rect_area( const RECT *rect )
+{
+    return (rect->right - rect->left) * (rect->bottom - rect->top);
+}
+
+/***********************************************************************
+ *           add_dirty_rect
+ *
+ * Move the bounds of a drawing operation to the list of rectangles to flush.
+ */
+static void add_dirty_rect( struct x11drv_window_surface *surface, const RECT *rect )
+{
+    unsigned int i, best = 0;
+    int growth, best_growth = INT_MAX;
+    RECT tmp;
+
+    if (IsRectEmpty( rect )) return;
+    if (!surface->dirty_count) surface->dirty_ticks = GetTickCount();
+
+    for (i = 0; i < surface->dirty_count; i++)
+    {
+        if (IntersectRect( &tmp, &surface->dirty[i], rect ))
+        {
+            best = i;
+            break;
+        }
+    }
+    if (i == surface->dirty_count)
+    {
+        if (i < MAX_DIRTY_RECTS)
+        {
+            surface->dirty[surface->dirty_count++] = *rect;
+            return;
+        }
+        /* out of slots, merge with the rectangle that grows the least */
+        for (i = 0; i < surface->dirty_count; i++)
+        {
+            UnionRect( &tmp, &surface->dirty[i], rect );
+            growth = get_rect_area( &tmp ) - get_rect_area( &surface->dirty[i] );
+            if (growth >= best_growth) continue;
+            best_growth = growth;
+            best = i;
+        }
+    }
+    UnionRect( &surface->dirty[best], &surface->dirty[best], rect );
 }
 
 /***********************************************************************
@@ -1830,6 +1885,14 @@ static void x11drv_surface_unlock( struct window_surface *window_surface )
 {
     struct x11drv_window_surface *surface = get_x11_surface( window_surface );
 
+    if (!--surface->lock_count)
+    {
+        add_dirty_rect( surface, &surface->bounds );
+        reset_bounds( &surface->bounds );
+        /* bounds are now empty between operations, so gdi32 can't time the flush for us */
+        if (surface->dirty_count && GetTickCount() - surface->dirty_ticks > SURFACE_FLUSH_PERIOD)
+            window_surface->funcs->flush( window_surface );
+    }
     LeaveCriticalSection( &surface->crit );
 }
 
@@ -1891,67 +1954,67 @@ static void x11drv_surface_set_region( struct window_surface *window_surface, HR
 static void x11drv_surface_flush( struct window_surface *window_surface )
 {
     struct x11drv_window_surface *surface = get_x11_surface( window_surface );
-    unsigned char *src = surface->bits;
-    unsigned char *dst = (unsigned char *)surface->image->data;
-    struct bitblt_coords coords;
+    int width_bytes = surface->image->bytes_per_line;
+    unsigned char *src, *dst;
+    unsigned int i;
+    RECT rect, visrect;
 
     window_surface->funcs->lock( window_surface );
-    coords.x = 0;
-    coords.y = 0;
-    coords.width  = surface->header.rect.right - surface->header.rect.left;
-    coords.height = surface->header.rect.bottom - surface->header.rect.top;
-    SetRect( &coords.visrect, 0, 0, coords.width, coords.height );
-    if (IntersectRect( &coords.visrect, &coords.visrect, &surface->bounds ))
+    add_dirty_rect( surface, &surface->bounds );
+    reset_bounds( &surface->bounds );
+    SetRect( &visrect, 0, 0, surface->header.rect.right - surface->header.rect.left,
+             surface->header.rect.bottom - surface->header.rect.top );
+
+    if (surface->dirty_count && (surface->is_argb || surface->color_key != CLR_INVALID))
+        update_surface_region( surface );
+
+    for (i = 0; i < surface->dirty_count; i++)
     {
-        TRACE( "flushing %p %dx%d bounds %s bits %p\n",
-               surface, coords.width, coords.height,
-               wine_dbgstr_rect( &surface->bounds ), surface->bits );
+        if (!IntersectRect( &rect, &visrect, &surface->dirty[i] )) continue;
 
-        if (surface->is_argb || surface->color_key != CLR_INVALID) update_surface_region( surface );
+        TRACE( "flushing %p %dx%d rect %s bits %p\n", surface, visrect.right, visrect.bottom,
+               wine_dbgstr_rect( &rect ), surface->bits );
 
+        src = (unsigned char *)surface->bits + rect.top * width_bytes;
+        dst = (unsigned char *)surface->image->data + rect.top * width_bytes;
         if (src != dst)
         {
             const int *mapping = NULL;
-            int width_bytes = surface->image->bytes_per_line;
 
             if (surface->image->bits_per_pixel == 4 || surface->image->bits_per_pixel == 8)
                 mapping = X11DRV_PALETTE_PaletteToXPixel;
 
-            src += coords.visrect.top * width_bytes;
-            dst += coords.visrect.top * width_bytes;
             copy_image_byteswap( &surface->info, src, dst, width_bytes, width_bytes,
-                                 coords.visrect.bottom - coords.visrect.top,
+                                 rect.bottom - rect.top,
                                  surface->byteswap, mapping, ~0u, surface->alpha_bits );
         }
         else if (surface->alpha_bits)
         {
-            int x, y, stride = surface->image->bytes_per_line / sizeof(ULONG);
-            ULONG *ptr = (ULONG *)dst + coords.visrect.top * stride;
+            int x, y, stride = width_bytes / sizeof(ULONG);
+            ULONG *ptr = (ULONG *)dst;
 
-            for (y = coords.visrect.top; y < coords.visrect.bottom; y++, ptr += stride)
-                for (x = coords.visrect.left; x < coords.visrect.right; x++)
+            for (y = rect.top; y < rect.bottom; y++, ptr += stride)
+                for (x = rect.left; x < rect.right; x++)
                     ptr[x] |= surface->alpha_bits;
         }
 
 #ifdef HAVE_LIBXXSHM
         if (surface->shminfo.shmid != -1)
             XShmPutImage( gdi_display, surface->window, surface->gc, surface->image,
-                          coords.visrect.left, coords.visrect.top,
-                          surface->header.rect.left + coords.visrect.left,
-                          surface->header.rect.top + coords.visrect.top,
-                          coords.visrect.right - coords.visrect.left,
-                          coords.visrect.bottom - coords.visrect.top, False );
+                          rect.left, rect.top,
+                          surface->header.rect.left + rect.left,
+                          surface->header.rect.top + rect.top,
+                          rect.right - rect.left, rect.bottom - rect.top, False );
         else
 #endif
         XPutImage( gdi_display, surface->window, surface->gc, surface->image,
-                   coords.visrect.left, coords.visrect.top,
-                   surface->header.rect.left + coords.visrect.left,
-                   surface->header.rect.top + coords.visrect.top,
-                   coords.visrect.right - coords.visrect.left,
-                   coords.visrect.bottom - coords.visrect.top );
-        XFlush( gdi_display );
+                   rect.left, rect.top,
+                   surface->header.rect.left + rect.left,
+                   surface->header.rect.top + rect.top,
+                   rect.right - rect.left, rect.bottom - rect.top );
     }
-    reset_bounds( &surface->bounds );
+    if (surface->dirty_count) XFlush( gdi_display );
+    surface->dirty_count = 0;
     window_surface->funcs->unlock( window_surface );
 }
 
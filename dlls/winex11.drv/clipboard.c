@@ -73,6 +73,12 @@
 #ifdef HAVE_UNISTD_H
 # include <unistd.h>
 #endif
+#ifdef HAVE_POLL_H
+#include <poll.h>
+#endif
+#ifdef HAVE_SYS_POLL_H
+#include <sys/poll.h>
+#endif
 #include <fcntl.h>
 #include <limits.h>
 #include <time.h>
@@ -99,6 +105,7 @@ WINE_DEFAULT_DEBUG_CHANNEL(clipboard);
 #define SELECTION_WAIT    1000 /* us */
 
 #define SELECTION_UPDATE_DELAY 2000   /* delay between checks of the X11 selection */
+#define SELECTION_INCR_TIMEOUT 10000  /* delay before dropping an INCR transfer abandoned by the requestor */
 
 typedef BOOL (*EXPORTFUNC)( Display *display, Window win, Atom prop, Atom target, HANDLE handle );
 typedef HANDLE (*IMPORTFUNC)( Atom type, const void *data, size_t size );
@@ -202,6 +209,37 @@ static struct clipboard_format **current_x11_formats;
 static unsigned int nb_current_x11_formats;
 static BOOL use_xfixes;
 
+/* converted data of an exported target, shared by the export cache and INCR transfers */
+struct selection_data
+{
+    unsigned int  refcount;
+    Atom          type;
+    int           format;
+    size_t        count;    /* number of items of the property format */
+    unsigned char data[1];
+};
+
+struct export_cache_entry
+{
+    struct list            entry;
+    Atom                   target;
+    struct selection_data *data;
+};
+
+struct incr_transfer
+{
+    struct list            entry;
+    Window                 requestor;
+    Atom                   prop;
+    struct selection_data *data;
+    size_t                 pos;     /* number of items already sent */
+    ULONG64                time;    /* time of the last chunk */
+};
+
+static struct list export_cache = LIST_INIT( export_cache );
+static struct list incr_transfers = LIST_INIT( incr_transfers );
+static struct selection_data **export_capture;
+
 Display *clipboard_display = NULL;
 
 static const char *debugstr_format( UINT id )
@@ -260,6 +298,11 @@ static int is_atom_error( Display *display, XErrorEvent *event, void *arg )
     return (event->error_code == BadAtom);
 }
 
+static int is_window_error( Display *display, XErrorEvent *event, void *arg )
+{
+    return (event->error_code == BadWindow);
+}
+
 
 /**************************************************************************
  *		find_win32_format
@@ -413,32 +456,254 @@ static void register_x11_formats( const Atom *atoms, UINT size )
 
 
 /**************************************************************************
- *		put_property
+ *		get_max_property_count
  *
- * Put data as a property on the specified window.
+ * Get the number of items of the specified format that fit in a single request.
  */
-static void put_property( Display *display, Window win, Atom prop, Atom type, int format,
-                          const void *ptr, size_t size )
+static size_t get_max_property_count( Display *display, int format )
 {
-    const unsigned char *data = ptr;
-    int mode = PropModeReplace;
-    size_t width = (format == 32) ? sizeof(long) : format / 8;
     size_t max_size = XExtendedMaxRequestSize( display ) * 4;
 
     if (!max_size) max_size = XMaxRequestSize( display ) * 4;
     max_size -= 64; /* request overhead */
+    return max_size / get_property_size( format, 1 );
+}
+
+
+/**************************************************************************
+ *		write_property
+ *
+ * Write data as a property on the specified window, appending as many requests as needed.
+ */
+static void write_property( Display *display, Window win, Atom prop, Atom type, int format,
+                            const void *ptr, size_t size )
+{
+    const unsigned char *data = ptr;
+    int mode = PropModeReplace;
+    size_t max_count = get_max_property_count( display, format );
 
     do
     {
-        size_t count = min( size, max_size / width );
+        size_t count = min( size, max_count );
         XChangeProperty( display, win, prop, type, format, mode, data, count );
         mode = PropModeAppend;
         size -= count;
-        data += count * width;
+        data += get_property_size( format, count );
     } while (size > 0);
 }
 
 
+/**************************************************************************
+ *		alloc_selection_data
+ */
+static struct selection_data *alloc_selection_data( Atom type, int format, const void *ptr, size_t count )
+{
+    size_t size = get_property_size( format, count );
+    struct selection_data *data;
+
+    if (!(data = HeapAlloc( GetProcessHeap(), 0, FIELD_OFFSET( struct selection_data, data[size] ))))
+        return NULL;
+    data->refcount = 1;
+    data->type = type;
+    data->format = format;
+    data->count = count;
+    memcpy( data->data, ptr, size );
+    return data;
+}
+
+
+/**************************************************************************
+ *		release_selection_data
+ */
+static void release_selection_data( struct selection_data *data )
+{
+    if (!--data->refcount) HeapFree( GetProcessHeap(), 0, data );
+}
+
+
+/**************************************************************************
+ *		free_incr_transfer
+ */
+static void free_incr_transfer( struct incr_transfer *transfer )
+{
+    list_remove( &transfer->entry );
+    release_selection_data( transfer->data );
+    HeapFree( GetProcessHeap(), 0, transfer );
+}
+
+
+/**************************************************************************
+ *		start_incr_transfer
+ *
+ * Start an INCR transfer for data that doesn't fit in a single request. The
+ * chunks are sent by selection_property_notify as the requestor deletes them.
+ */
+static void start_incr_transfer( Display *display, Window win, Atom prop, struct selection_data *data )
+{
+    struct incr_transfer *transfer, *next;
+    ULONG64 now = GetTickCount64();
+    long size = min( data->count * (data->format / 8), (size_t)LONG_MAX );
+
+    LIST_FOR_EACH_ENTRY_SAFE( transfer, next, &incr_transfers, struct incr_transfer, entry )
+    {
+        /* drop the transfers replaced by this one or abandoned by their requestor */
+        if ((transfer->requestor == win && transfer->prop == prop) ||
+            now - transfer->time > SELECTION_INCR_TIMEOUT)
+            free_incr_transfer( transfer );
+    }
+
+    if (!(transfer = HeapAlloc( GetProcessHeap(), 0, sizeof(*transfer) )))
+    {
+        write_property( display, win, prop, data->type, data->format, data->data, data->count );
+        return;
+    }
+    transfer->requestor = win;
+    transfer->prop = prop;
+    transfer->data = data;
+    transfer->pos = 0;
+    transfer->time = now;
+    data->refcount++;
+    list_add_tail( &incr_transfers, &transfer->entry );
+
+    TRACE( "win %lx prop %s type %s size %ld\n", win, debugstr_xatom( prop ), debugstr_xatom( data->type ), size );
+    XSelectInput( display, win, PropertyChangeMask );
+    XChangeProperty( display, win, prop, x11drv_atom(INCR), 32, PropModeReplace, (unsigned char *)&size, 1 );
+}
+
+
+/**************************************************************************
+ *		selection_property_notify
+ *
+ * Send the next chunk of an INCR transfer once the requestor has deleted the previous one.
+ */
+void selection_property_notify( XPropertyEvent *event )
+{
+    struct incr_transfer *transfer, *other;
+    struct selection_data *data;
+    size_t count;
+    BOOL done;
+
+    if (GetCurrentThreadId() != clipboard_thread_id) return;
+    if (event->state != PropertyDelete) return;
+
+    LIST_FOR_EACH_ENTRY( transfer, &incr_transfers, struct incr_transfer, entry )
+    {
+        if (transfer->requestor != event->window || transfer->prop != event->atom) continue;
+
+        /* an empty chunk marks the end of the transfer */
+        data = transfer->data;
+        count = min( data->count - transfer->pos, get_max_property_count( event->display, data->format ));
+        TRACE( "win %lx prop %s sending %lu items at %lu\n", transfer->requestor,
+               debugstr_xatom( transfer->prop ), (unsigned long)count, (unsigned long)transfer->pos );
+
+        X11DRV_expect_error( event->display, is_window_error, NULL );
+        XChangeProperty( event->display, transfer->requestor, transfer->prop, data->type, data->format,
+                         PropModeReplace, data->data + get_property_size( data->format, transfer->pos ), count );
+        done = X11DRV_check_error() || !count;
+        transfer->pos += count;
+        transfer->time = GetTickCount64();
+        if (!done) return;
+
+        free_incr_transfer( transfer );
+        LIST_FOR_EACH_ENTRY( other, &incr_transfers, struct incr_transfer, entry )
+            if (other->requestor == event->window) return;
+        X11DRV_expect_error( event->display, is_window_error, NULL );
+        XSelectInput( event->display, event->window, NoEventMask );
+        X11DRV_check_error();
+        return;
+    }
+}
+
+
+/**************************************************************************
+ *		put_selection_data
+ */
+static void put_selection_data( Display *display, Window win, Atom prop, struct selection_data *data )
+{
+    if (data->count > get_max_property_count( display, data->format ))
+        start_incr_transfer( display, win, prop, data );
+    else
+        write_property( display, win, prop, data->type, data->format, data->data, data->count );
+}
+
+
+/**************************************************************************
+ *		put_property
+ *
+ * Put data as a property on the specified window.
+ */
+static void put_property( Display *display, Window win, Atom prop, Atom type, int format,
+                          const void *ptr, size_t size )
+{
+    struct selection_data *data;
+
+    if ((!export_capture && size <= get_max_property_count( display, format )) ||
+        !(data = alloc_selection_data( type, format, ptr, size )))
+    {
+        write_property( display, win, prop, type, format, ptr, size );
+        return;
+    }
+    if (export_capture)
+    {
+        /* keep the converted data for further requests of the same target */
+        data->refcount++;
+        *export_capture = data;
+        export_capture = NULL;
+    }
+    put_selection_data( display, win, prop, data );
+    release_selection_data( data );
+}
+
+
+/**************************************************************************
+ *		get_cached_export
+ */
+static struct selection_data *get_cached_export( Atom target )
+{
+    struct export_cache_entry *cache;
+
+    LIST_FOR_EACH_ENTRY( cache, &export_cache, struct export_cache_entry, entry )
+        if (cache->target == target) return cache->data;
+    return NULL;
+}
+
+
+/**************************************************************************
+ *		add_cached_export
+ */
+static void add_cached_export( Atom target, struct selection_data *data )
+{
+    struct export_cache_entry *cache;
+
+    if (!(cache = HeapAlloc( GetProcessHeap(), 0, sizeof(*cache) )))
+    {
+        release_selection_data( data );
+        return;
+    }
+    cache->target = target;
+    cache->data = data;
+    list_add_tail( &export_cache, &cache->entry );
+}
+
+
+/**************************************************************************
+ *		flush_export_cache
+ *
+ * Discard the exported data when the selection contents change.
+ */
+static void flush_export_cache(void)
+{
+    struct export_cache_entry *cache, *next;
+
+    LIST_FOR_EACH_ENTRY_SAFE( cache, next, &export_cache, struct export_cache_entry, entry )
+    {
+        list_remove( &cache->entry );
+        release_selection_data( cache->data );
+        HeapFree( GetProcessHeap(), 0, cache );
+    }
+}
+
+
 /**************************************************************************
  *		convert_selection
  */
@@ -1485,9 +1750,19 @@ static BOOL export_targets( Display *display, Window win, Atom prop, Atom target
 static BOOL export_selection( Display *display, Window win, Atom prop, Atom target )
 {
     struct clipboard_format *format;
+    struct selection_data *data;
     HANDLE handle = 0;
     BOOL open = FALSE, ret = FALSE;
 
+    /* the selection contents don't change while we own it, reuse the previous conversion */
+    if ((data = get_cached_export( target )))
+    {
+        TRACE( "win %lx prop %s target %s using cached data\n",
+               win, debugstr_xatom( prop ), debugstr_xatom( target ));
+        put_selection_data( display, win, prop, data );
+        return TRUE;
+    }
+
     LIST_FOR_EACH_ENTRY( format, &format_list, struct clipboard_format, entry )
     {
         if (format->atom != target) continue;
@@ -1509,7 +1784,15 @@ static BOOL export_selection( Display *display, Window win, Atom prop, Atom targ
                    win, debugstr_xatom( prop ), debugstr_xatom( target ),
                    debugstr_format( format->id ), handle );
 
+            data = NULL;
+            export_capture = &data;
             ret = format->export( display, win, prop, target, handle );
+            export_capture = NULL;
+            if (data)
+            {
+                if (ret) add_cached_export( target, data );
+                else release_selection_data( data );
+            }
             break;
         }
         /* keep looking for another Win32 format mapping to the same target */
@@ -1639,11 +1922,30 @@ static BOOL X11DRV_CLIPBOARD_GetProperty(Display *display, Window w, Atom prop,
 }
 
 
-struct clipboard_data_packet {
-    struct list entry;
-    unsigned long size;
-    unsigned char *data;
-};
+/**************************************************************************
+ *		wait_for_property
+ *
+ *  Wait for the selection owner to store the next chunk of an INCR transfer.
+ */
+static BOOL wait_for_property( Display *display, Window w, Atom prop )
+{
+    ULONG64 end = GetTickCount64() + SELECTION_RETRIES * SELECTION_WAIT / 1000;
+    struct pollfd pfd;
+    XEvent xe;
+    int timeout;
+
+    for (;;)
+    {
+        while (XCheckTypedWindowEvent( display, w, PropertyNotify, &xe ))
+            if (xe.xproperty.atom == prop && xe.xproperty.state == PropertyNewValue) return TRUE;
+
+        if ((timeout = (LONG64)(end - GetTickCount64())) <= 0) return FALSE;
+        pfd.fd = ConnectionNumber( display );
+        pfd.events = POLLIN;
+        poll( &pfd, 1, timeout );
+    }
+}
+
 
 /**************************************************************************
  *		read_property
@@ -1666,90 +1968,59 @@ static BOOL read_property( Display *display, Window w, Atom prop,
 
     if (*type == x11drv_atom(INCR))
     {
-        unsigned char *buf;
-        unsigned long bufsize = 0;
-        struct list packets;
-        struct clipboard_data_packet *packet, *packet2;
-        BOOL res;
+        unsigned char *buf, *chunk;
+        unsigned long bufsize, size = 0, chunk_size;
 
+        /* the INCR property holds a lower bound of the total size,
+         * use it to append the chunks directly to a single buffer */
+        bufsize = (*datasize >= sizeof(long)) ? *(unsigned long *)*data : 0;
+        if (bufsize > INT_MAX) bufsize = 0;
         HeapFree(GetProcessHeap(), 0, *data);
         *data = NULL;
 
-        list_init(&packets);
+        if (!(buf = HeapAlloc( GetProcessHeap(), 0, bufsize + 1 )))
+        {
+            bufsize = 0x10000;
+            if (!(buf = HeapAlloc( GetProcessHeap(), 0, bufsize + 1 ))) return FALSE;
+        }
 
         for (;;)
         {
-            int i;
-            unsigned char *prop_data;
-            unsigned long prop_size;
-
-            /* Wait until PropertyNotify is received */
-            for (i = 0; i < SELECTION_RETRIES; i++)
-            {
-                Bool res;
-
-                res = XCheckTypedWindowEvent(display, w, PropertyNotify, &xe);
-                if (res && xe.xproperty.atom == prop &&
-                    xe.xproperty.state == PropertyNewValue)
-                    break;
-                usleep(SELECTION_WAIT);
-            }
-
-            if (i >= SELECTION_RETRIES ||
-                !X11DRV_CLIPBOARD_GetProperty(display, w, prop, type, &prop_data, &prop_size))
-            {
-                res = FALSE;
+            if (!wait_for_property( display, w, prop ) ||
+                !X11DRV_CLIPBOARD_GetProperty( display, w, prop, type, &chunk, &chunk_size ))
                 break;
-            }
 
             /* Retrieved entire data. */
-            if (prop_size == 0)
+            if (!chunk_size)
             {
-                HeapFree(GetProcessHeap(), 0, prop_data);
-                res = TRUE;
-                break;
+                HeapFree( GetProcessHeap(), 0, chunk );
+                buf[size] = 0;
+                *data = buf;
+                *datasize = size;
+                return TRUE;
             }
 
-            packet = HeapAlloc(GetProcessHeap(), 0, sizeof(*packet));
-            if (!packet)
+            if (chunk_size > bufsize - size)
             {
-                HeapFree(GetProcessHeap(), 0, prop_data);
-                res = FALSE;
-                break;
-            }
+                unsigned long new_size = max( bufsize * 2, size + chunk_size );
+                unsigned char *new_buf = HeapReAlloc( GetProcessHeap(), 0, buf, new_size + 1 );
 
-            packet->size = prop_size;
-            packet->data = prop_data;
-            list_add_tail(&packets, &packet->entry);
-            bufsize += prop_size;
-        }
-
-        if (res)
-        {
-            buf = HeapAlloc(GetProcessHeap(), 0, bufsize + 1);
-            if (buf)
-            {
-                unsigned long bytes_copied = 0;
-                *datasize = bufsize;
-                LIST_FOR_EACH_ENTRY( packet, &packets, struct clipboard_data_packet, entry)
+                if (!new_buf)
                 {
-                    memcpy(&buf[bytes_copied], packet->data, packet->size);
-                    bytes_copied += packet->size;
+                    HeapFree( GetProcessHeap(), 0, chunk );
+                    break;
                 }
-                buf[bufsize] = 0;
-                *data = buf;
+                buf = new_buf;
+                bufsize = new_size;
             }
-            else
-                res = FALSE;
+            memcpy( buf + size, chunk, chunk_size );
+            size += chunk_size;
+            HeapFree( GetProcessHeap(), 0, chunk );
         }
 
-        LIST_FOR_EACH_ENTRY_SAFE( packet, packet2, &packets, struct clipboard_data_packet, entry)
-        {
-            HeapFree(GetProcessHeap(), 0, packet->data);
-            HeapFree(GetProcessHeap(), 0, packet);
-        }
-
-        return res;
+        WARN( "INCR transfer of %s failed after %lu bytes\n", debugstr_xatom( prop ), size );
+        HeapFree( GetProcessHeap(), 0, buf );
+        return FALSE;
     }
 
     return TRUE;
@@ -1764,6 +2035,7 @@ static BOOL read_property( Display *display, Window w, Atom prop,
 static void acquire_selection( Display *display )
 {
     if (selection_window) XDestroyWindow( display, selection_window );
+    flush_export_cache();
 
     selection_window = XCreateWindow( display, root_window, 0, 0, 1, 1, 0, CopyFromParent,
                                       InputOutput, CopyFromParent, 0, NULL );
@@ -1792,6 +2064,7 @@ static void release_selection( Display *display, Time time )
 
     XDestroyWindow( display, selection_window );
     selection_window = 0;
+    flush_export_cache();
 }
 
 
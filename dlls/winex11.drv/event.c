@@ -402,16 +402,65 @@ static inline BOOL call_event_handler( Display *display, XEvent *event )
 }
 
 
+/***********************************************************************
+ *           flush_inputs
+ *
+ * Send the batched inputs to the server in a single request.
+ */
+static void flush_inputs( struct x11drv_thread_data *data )
+{
+    HWND hwnds[MAX_BATCHED_INPUTS];
+    INPUT inputs[MAX_BATCHED_INPUTS];
+    UINT count = data->input_count;
+
+    if (!count) return;
+    /* sending may wait for a hook and process events recursively */
+    memcpy( hwnds, data->input_hwnds, count * sizeof(hwnds[0]) );
+    memcpy( inputs, data->inputs, count * sizeof(inputs[0]) );
+    data->input_count = 0;
+    __wine_send_inputs( count, hwnds, inputs );
+}
+
+
+/***********************************************************************
+ *           x11drv_send_input
+ *
+ * Send a hardware input to the server. Mouse motions are batched while
+ * events are processed, and sent along with the next other input or once
+ * all the pending events have been handled.
+ */
+void x11drv_send_input( HWND hwnd, const INPUT *input )
+{
+    static const DWORD move_flags = MOUSEEVENTF_MOVE | MOUSEEVENTF_ABSOLUTE | MOUSEEVENTF_VIRTUALDESK;
+    struct x11drv_thread_data *data = x11drv_thread_data();
+
+    if (!data || !data->input_batch)
+    {
+        if (data) flush_inputs( data );
+        __wine_send_input( hwnd, input );
+        return;
+    }
+
+    data->input_hwnds[data->input_count] = hwnd;
+    data->inputs[data->input_count] = *input;
+    if (++data->input_count == MAX_BATCHED_INPUTS || input->type != INPUT_MOUSE ||
+        (input->mi.dwFlags & ~move_flags))
+        flush_inputs( data );
+}
+
+
 /***********************************************************************
  *           process_events
  */
 static BOOL process_events( Display *display, Bool (*filter)(Display*, XEvent*,XPointer), ULONG_PTR arg )
 {
+    struct x11drv_thread_data *thread_data = x11drv_thread_data();
     XEvent event, prev_event;
     int count = 0;
     BOOL queued = FALSE;
     enum event_merge_action action = MERGE_DISCARD;
 
+    thread_data->input_batch++;
     prev_event.type = 0;
     while (XCheckIfEvent( display, &event, filter, (char *)arg ))
     {
@@ -467,6 +516,8 @@ static BOOL process_events( Display *display, Bool (*filter)(Display*, XEvent*,X
     }
     if (prev_event.type) queued |= call_event_handler( display, &prev_event );
     free_event_data( &prev_event );
+    thread_data->input_batch--;
+    flush_inputs( thread_data );
     XFlush( gdi_display );
     if (count) TRACE( "processed %d events, returning %d\n", count, queued );
     return queued;
@@ -1326,7 +1377,11 @@ static BOOL X11DRV_PropertyNotify( HWND hwnd, XEvent *xev )
 {
     XPropertyEvent *event = &xev->xproperty;
 
-    if (!hwnd) return FALSE;
+    if (!hwnd)
+    {
+        selection_property_notify( event );  /* incremental transfer of a selection we own */
+        return FALSE;
+    }
     if (event->atom == x11drv_atom(WM_STATE)) handle_wm_state_notify( hwnd, event, TRUE );
     return TRUE;
 }
@@ -319,6 +319,8 @@ struct x11drv_valuator_data
     int number;
 };
 
+#define MAX_BATCHED_INPUTS 64
+
 struct x11drv_thread_data
 {
     Display *display;
@@ -341,6 +343,10 @@ struct x11drv_thread_data
     struct x11drv_valuator_data y_rel_valuator;
     int      xi2_core_pointer;     /* XInput2 core pointer id */
     int      xi2_current_slave;    /* Current slave driving the Core pointer */
+    int      input_batch;          /* inputs are batched while events are processed */
+    UINT     input_count;          /* number of batched inputs */
+    HWND     input_hwnds[MAX_BATCHED_INPUTS];
+    INPUT    inputs[MAX_BATCHED_INPUTS]; /* inputs waiting to be sent to the server */
 };
 
 extern struct x11drv_thread_data *x11drv_init_thread_data(void) DECLSPEC_HIDDEN;
@@ -524,6 +530,7 @@ extern Bool (*pXGetEventData)( Display *display, XEvent /*XGenericEventCookie*/
 extern void (*pXFreeEventData)( Display *display, XEvent /*XGenericEventCookie*/ *event ) DECLSPEC_HIDDEN;
 
 extern DWORD EVENT_x11_time_to_win32_time(Time time) DECLSPEC_HIDDEN;
+extern void x11drv_send_input( HWND hwnd, const INPUT *input ) DECLSPEC_HIDDEN;
 
 /* X11 driver private messages, must be in the range 0x80001000..0x80001fff */
 enum x11drv_window_messages
@@ -601,6 +608,7 @@ extern void change_systray_owner( Display *display, Window systray_window ) DECL
 extern void update_systray_balloon_position(void) DECLSPEC_HIDDEN;
 extern HWND create_foreign_window( Display *display, Window window ) DECLSPEC_HIDDEN;
 extern BOOL update_clipboard( HWND hwnd ) DECLSPEC_HIDDEN;
+extern void selection_property_notify( XPropertyEvent *event ) DECLSPEC_HIDDEN;
 
 extern void set_wm_hints( struct x11drv_win_data *data ) DECLSPEC_HIDDEN;
 extern BOOL fs_hack_enabled(void) DECLSPEC_HIDDEN;
@@ -195,6 +195,20 @@ static BOOL session_set_option( object_header_t *hdr, DWORD option, LPVOID buffe
         TRACE("0x%x\n", session->secure_protocols);
         return TRUE;
     }
+    case WINHTTP_OPTION_ENABLE_HTTP_PROTOCOL:
+        if (buflen != sizeof(DWORD))
+        {
+            set_last_error( ERROR_INSUFFICIENT_BUFFER );
+            return FALSE;
+        }
+        if (*(DWORD *)buffer & ~WINHTTP_PROTOCOL_MASK)
+        {
+            set_last_error( ERROR_INVALID_PARAMETER );
+            return FALSE;
+        }
+        session->http_protocols = *(DWORD *)buffer;
+        if (session->http_protocols) FIXME("HTTP/2 not supported, using HTTP/1.1\n");
+        return TRUE;
     case WINHTTP_OPTION_DISABLE_FEATURE:
         set_last_error( ERROR_WINHTTP_INCORRECT_HANDLE_TYPE );
         return FALSE;
@@ -836,6 +850,17 @@ static BOOL request_query_option( object_header_t *hdr, DWORD option, LPVOID buf
         info->cbSize = sizeof(*info);
         return TRUE;
     }
+    case WINHTTP_OPTION_HTTP_PROTOCOL_USED:
+        if (!buffer || *buflen < sizeof(DWORD))
+        {
+            *buflen = sizeof(DWORD);
+            set_last_error( ERROR_INSUFFICIENT_BUFFER );
+            return FALSE;
+        }
+        /* HTTP/2 is never negotiated, requests always go out as HTTP/1.x */
+        *(DWORD *)buffer = 0;
+        *buflen = sizeof(DWORD);
+        return TRUE;
     case WINHTTP_OPTION_RESOLVE_TIMEOUT:
         *(DWORD *)buffer = request->resolve_timeout;
         *buflen = sizeof(DWORD);
@@ -969,6 +994,20 @@ static BOOL request_set_option( object_header_t *hdr, DWORD option, LPVOID buffe
         request->security_flags = flags;
         return TRUE;
     }
+    case WINHTTP_OPTION_ENABLE_HTTP_PROTOCOL:
+        if (buflen != sizeof(DWORD))
+        {
+            set_last_error( ERROR_INSUFFICIENT_BUFFER );
+            return FALSE;
+        }
+        if (*(DWORD *)buffer & ~WINHTTP_PROTOCOL_MASK)
+        {
+            set_last_error( ERROR_INVALID_PARAMETER );
+            return FALSE;
+        }
+        request->http_protocols = *(DWORD *)buffer;
+        if (request->http_protocols) FIXME("HTTP/2 not supported, using HTTP/1.1\n");
+        return TRUE;
     case WINHTTP_OPTION_RESOLVE_TIMEOUT:
         request->resolve_timeout = *(DWORD *)buffer;
         return TRUE;
@@ -1123,6 +1162,7 @@ HINTERNET WINAPI WinHttpOpenRequest( HINTERNET hconnect, LPCWSTR verb, LPCWSTR o
 
     request->resolve_timeout = connect->session->resolve_timeout;
     request->connect_timeout = connect->session->connect_timeout;
+    request->http_protocols = connect->session->http_protocols;
     request->send_timeout = connect->session->send_timeout;
     request->recv_timeout = connect->session->recv_timeout;
 
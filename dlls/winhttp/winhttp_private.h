@@ -124,6 +124,7 @@ typedef struct
     CredHandle cred_handle;
     BOOL cred_handle_initialized;
     DWORD secure_protocols;
+    DWORD http_protocols; /* WINHTTP_PROTOCOL_FLAG_* enabled by the application */
 } session_t;
 
 typedef struct
@@ -209,6 +210,7 @@ typedef struct
     DWORD optional_len;
     netconn_t *netconn;
     DWORD security_flags;
+    DWORD http_protocols;
     int resolve_timeout;
     int connect_timeout;
     int send_timeout;
@@ -143,8 +143,6 @@ static const WCHAR emptyW[] = {0};
 #define HTTP_ADDHDR_FLAG_REPLACE			0x80000000
 #define HTTP_ADDHDR_FLAG_REQ				0x02000000
 
-#define COLLECT_TIME 60000
-
 #define ARRAYSIZE(array) (sizeof(array)/sizeof((array)[0]))
 
 struct HttpAuthInfo
@@ -1935,15 +1933,29 @@ static void http_release_netconn(http_request_t *req, BOOL reuse)
     if(!is_valid_netconn(req->netconn))
         return;
 
-    if(reuse && req->netconn->keep_alive) {
+    if(reuse && req->netconn->keep_alive && keep_alive_timeout) {
+        server_t *server = req->netconn->server;
+        DWORD timeout = keep_alive_timeout;
         BOOL run_collector;
 
+        if(req->netconn->keep_alive_timeout && req->netconn->keep_alive_timeout < timeout)
+            timeout = req->netconn->keep_alive_timeout;
+
         EnterCriticalSection(&connection_pool_cs);
 
-        list_add_head(&req->netconn->server->conn_pool, &req->netconn->pool_entry);
-        req->netconn->keep_until = GetTickCount64() + COLLECT_TIME;
+        list_add_head(&server->conn_pool, &req->netconn->pool_entry);
+        req->netconn->keep_until = GetTickCount64() + timeout;
         req->netconn = NULL;
 
+        /* the most recently used connections are at the head, drop the oldest idle ones */
+        while(list_count(&server->conn_pool) > max(max_conns, max_1_0_conns)) {
+            netconn_t *netconn = LIST_ENTRY(list_tail(&server->conn_pool), netconn_t, pool_entry);
+
+            TRACE("pool full, freeing %p\n", netconn);
+            list_remove(&netconn->pool_entry);
+            free_netconn(netconn);
+        }
+
         run_collector = !collector_running;
         collector_running = TRUE;
 
@@ -4723,6 +4735,24 @@ static void HTTP_ProcessLastModified(http_request_t *request)
     LeaveCriticalSection( &request->headers_section );
 }
 
+/* parse the timeout parameter of a Keep-Alive header, returns the idle time to keep the connection in ms */
+static DWORD get_keep_alive_timeout(const WCHAR *value)
+{
+    static const WCHAR timeoutW[] = {'t','i','m','e','o','u','t','=',0};
+    const WCHAR *p;
+    DWORD timeout;
+
+    for (p = value; *p; p++)
+    {
+        if (strncmpiW(p, timeoutW, ARRAYSIZE(timeoutW) - 1)) continue;
+        timeout = atoiW(p + ARRAYSIZE(timeoutW) - 1);
+        if (!timeout) return 0;
+        /* leave some margin so that we don't race with the server closing it */
+        return timeout > 1 ? (timeout - 1) * 1000 : 500;
+    }
+    return 0;
+}
+
 static void http_process_keep_alive(http_request_t *req)
 {
     int index;
@@ -4736,6 +4766,10 @@ static void http_process_keep_alive(http_request_t *req)
     else
         req->netconn->keep_alive = !strcmpiW(req->version, g_szHttp1_1);
 
+    req->netconn->keep_alive_timeout = 0;
+    if (req->netconn->keep_alive && (index = HTTP_GetCustomHeaderIndex(req, szKeepAlive, 0, FALSE)) != -1)
+        req->netconn->keep_alive_timeout = get_keep_alive_timeout(req->custHeaders[index].lpszValue);
+
     LeaveCriticalSection( &req->headers_section );
 }
 
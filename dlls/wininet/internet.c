@@ -98,7 +98,8 @@ typedef struct
     LPWSTR proxyPassword;
 } proxyinfo_t;
 
-static ULONG max_conns = 2, max_1_0_conns = 4;
+ULONG max_conns = 2, max_1_0_conns = 4;
+ULONG keep_alive_timeout = 60000;
 static ULONG connect_timeout = 60000;
 
 static const WCHAR szInternetSettings[] =
@@ -259,6 +260,37 @@ BOOL WININET_Release( object_header_t *info )
     return TRUE;
 }
 
+/* read the connection pool limits from the Internet Settings key */
+static void load_connection_settings(void)
+{
+    static const WCHAR szMaxConnectionsPerServer[] =
+        {'M','a','x','C','o','n','n','e','c','t','i','o','n','s','P','e','r','S','e','r','v','e','r',0};
+    static const WCHAR szMaxConnectionsPer1_0Server[] =
+        {'M','a','x','C','o','n','n','e','c','t','i','o','n','s','P','e','r','1','_','0','S','e','r','v','e','r',0};
+    static const WCHAR szKeepAliveTimeout[] =
+        {'K','e','e','p','A','l','i','v','e','T','i','m','e','o','u','t',0};
+    DWORD type, len, val;
+    HKEY key;
+
+    if (RegOpenKeyW( HKEY_CURRENT_USER, szInternetSettings, &key )) return;
+
+    len = sizeof(val);
+    if (!RegQueryValueExW( key, szMaxConnectionsPerServer, NULL, &type, (BYTE *)&val, &len )
+        && type == REG_DWORD && val)
+        max_conns = val;
+    len = sizeof(val);
+    if (!RegQueryValueExW( key, szMaxConnectionsPer1_0Server, NULL, &type, (BYTE *)&val, &len )
+        && type == REG_DWORD && val)
+        max_1_0_conns = val;
+    len = sizeof(val);
+    if (!RegQueryValueExW( key, szKeepAliveTimeout, NULL, &type, (BYTE *)&val, &len )
+        && type == REG_DWORD)
+        keep_alive_timeout = val;
+
+    RegCloseKey( key );
+    TRACE( "max conns %u, 1.0 %u, keep-alive timeout %u\n", max_conns, max_1_0_conns, keep_alive_timeout );
+}
+
 /***********************************************************************
  * DllMain [Internal] Initializes the internal 'WININET.DLL'.
  *
@@ -291,6 +323,7 @@ BOOL WINAPI DllMain (HINSTANCE hinstDLL, DWORD fdwReason, LPVOID lpvReserved)
             }
 
             WININET_hModule = hinstDLL;
+            load_connection_settings();
             break;
 
         case DLL_THREAD_ATTACH:
@@ -32,6 +32,9 @@
 #include "winineti.h"
 
 extern HMODULE WININET_hModule DECLSPEC_HIDDEN;
+extern ULONG max_conns DECLSPEC_HIDDEN;
+extern ULONG max_1_0_conns DECLSPEC_HIDDEN;
+extern ULONG keep_alive_timeout DECLSPEC_HIDDEN;
 
 typedef struct {
     WCHAR *name;
@@ -83,6 +86,7 @@ typedef struct
     BOOL mask_errors;
 
     BOOL keep_alive;
+    DWORD keep_alive_timeout; /* idle timeout announced by the server, 0 if none */
     DWORD64 keep_until;
     struct list pool_entry;
 } netconn_t;
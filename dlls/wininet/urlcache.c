@@ -186,6 +186,7 @@ typedef struct
     char *cache_prefix; /* string that has to be prefixed for this container to be used */
     LPWSTR path; /* path to url container directory */
     HANDLE mapping; /* handle of file mapping */
+    urlcache_header *header; /* view of the mapping, kept until the index is closed */
     DWORD file_size; /* size of file when mapping was opened */
     HANDLE mutex; /* handle of mutex */
     DWORD default_entry_type;
@@ -684,6 +685,9 @@ static DWORD cache_container_open_index(cache_container *container, DWORD blocks
  */
 static void cache_container_close_index(cache_container *pContainer)
 {
+    if (pContainer->header)
+        UnmapViewOfFile(pContainer->header);
+    pContainer->header = NULL;
     CloseHandle(pContainer->mapping);
     pContainer->mapping = NULL;
 }
@@ -700,6 +704,7 @@ static BOOL cache_containers_add(const char *cache_prefix, LPCWSTR path,
     }
 
     pContainer->mapping = NULL;
+    pContainer->header = NULL;
     pContainer->file_size = 0;
     pContainer->default_entry_type = default_entry_type;
 
@@ -895,32 +900,39 @@ static BOOL cache_containers_enum(char *search_pattern, DWORD index, cache_conta
  *  Cache file header if successful
  *  NULL if failed and calls SetLastError.
  */
+static urlcache_header *cache_container_map_view(cache_container *pContainer)
+{
+    if (!pContainer->header)
+    {
+        pContainer->header = MapViewOfFile(pContainer->mapping, FILE_MAP_WRITE, 0, 0, 0);
+        if (!pContainer->header)
+            ERR("Couldn't MapViewOfFile. Error: %d\n", GetLastError());
+    }
+    return pContainer->header;
+}
+
 static urlcache_header* cache_container_lock_index(cache_container *pContainer)
 {
     BYTE index;
-    LPVOID pIndexData;
     urlcache_header* pHeader;
     DWORD error;
 
     /* acquire mutex */
     WaitForSingleObject(pContainer->mutex, INFINITE);
 
-    pIndexData = MapViewOfFile(pContainer->mapping, FILE_MAP_WRITE, 0, 0, 0);
-
-    if (!pIndexData)
+    /* the view stays mapped between locks, so that index lookups don't
+     * pay for a map/unmap pair every time */
+    if (!(pHeader = cache_container_map_view(pContainer)))
     {
         ReleaseMutex(pContainer->mutex);
-        ERR("Couldn't MapViewOfFile. Error: %d\n", GetLastError());
         return NULL;
     }
-    pHeader = (urlcache_header*)pIndexData;
 
     /* file has grown - we need to remap to prevent us getting
      * access violations when we try and access beyond the end
      * of the memory mapped file */
     if (pHeader->size != pContainer->file_size)
     {
-        UnmapViewOfFile( pHeader );
         cache_container_close_index(pContainer);
         error = cache_container_open_index(pContainer, MIN_BLOCK_NO);
         if (error != ERROR_SUCCESS)
@@ -929,15 +941,12 @@ static urlcache_header* cache_container_lock_index(cache_container *pContainer)
             SetLastError(error);
             return NULL;
         }
-        pIndexData = MapViewOfFile(pContainer->mapping, FILE_MAP_WRITE, 0, 0, 0);
 
-        if (!pIndexData)
+        if (!(pHeader = cache_container_map_view(pContainer)))
         {
             ReleaseMutex(pContainer->mutex);
-            ERR("Couldn't MapViewOfFile. Error: %d\n", GetLastError());
             return NULL;
         }
-        pHeader = (urlcache_header*)pIndexData;
     }
 
     TRACE("Signature: %s, file size: %d bytes\n", pHeader->signature, pHeader->size);
@@ -956,9 +965,8 @@ static urlcache_header* cache_container_lock_index(cache_container *pContainer)
  */
 static BOOL cache_container_unlock_index(cache_container *pContainer, urlcache_header *pHeader)
 {
-    /* release mutex */
-    ReleaseMutex(pContainer->mutex);
-    return UnmapViewOfFile(pHeader);
+    /* release mutex, the view is unmapped when the index is closed */
+    return ReleaseMutex(pContainer->mutex);
 }
 
 /***********************************************************************
@@ -1175,7 +1183,7 @@ static BOOL urlcache_clean_leaked_entries(cache_container *container, urlcache_h
 static DWORD cache_container_clean_index(cache_container *container, urlcache_header **file_view)
 {
     urlcache_header *header = *file_view;
-    DWORD ret;
+    DWORD blocks_no, ret;
 
     TRACE("(%s %s)\n", debugstr_a(container->cache_prefix), debugstr_w(container->path));
 
@@ -1187,15 +1195,15 @@ static DWORD cache_container_clean_index(cache_container *container, urlcache_he
         return ERROR_NOT_ENOUGH_MEMORY;
     }
 
+    blocks_no = header->capacity_in_blocks*2;
     cache_container_close_index(container);
-    ret = cache_container_open_index(container, header->capacity_in_blocks*2);
+    ret = cache_container_open_index(container, blocks_no);
     if(ret != ERROR_SUCCESS)
         return ret;
-    header = MapViewOfFile(container->mapping, FILE_MAP_WRITE, 0, 0, 0);
+    header = cache_container_map_view(container);
     if(!header)
         return GetLastError();
 
-    UnmapViewOfFile(*file_view);
     *file_view = header;
     return ERROR_SUCCESS;
 }
@@ -41,6 +41,7 @@
 
 #include "windef.h"
 #include "winbase.h"
+#include "winternl.h"
 #include "mmsystem.h"
 
 #include "winemm.h"
@@ -415,6 +416,28 @@ MMRESULT WINAPI timeGetDevCaps(LPTIMECAPS lpCaps, UINT wSize)
     return TIMERR_NOERROR;
 }
 
+/* periods coarser than this are coarser than the default timer resolution */
+#define MMSYSTIME_MAXPERIODREF 16
+
+/* number of active timeBeginPeriod() calls for each period, in ms */
+static LONG TIME_PeriodRefs[MMSYSTIME_MAXPERIODREF];
+
+/* pass the finest requested period down to ntdll, WINMM_cs must be held */
+static void TIME_UpdateResolution(void)
+{
+    ULONG current;
+    UINT i;
+
+    for (i = 0; i < MMSYSTIME_MAXPERIODREF; i++)
+        if (TIME_PeriodRefs[i]) break;
+
+    if (i < MMSYSTIME_MAXPERIODREF)
+        NtSetTimerResolution( (i + 1) * 10000, TRUE, &current );
+    else
+        NtSetTimerResolution( 0, FALSE, &current );
+    TRACE("timer resolution now %u\n", current);
+}
+
 /**************************************************************************
  * 				timeBeginPeriod		[WINMM.@]
  */
@@ -423,9 +446,12 @@ MMRESULT WINAPI timeBeginPeriod(UINT wPeriod)
     if (wPeriod < MMSYSTIME_MININTERVAL || wPeriod > MMSYSTIME_MAXINTERVAL)
 	return TIMERR_NOCANDO;
 
-    if (wPeriod > MMSYSTIME_MININTERVAL)
+    if (wPeriod <= MMSYSTIME_MAXPERIODREF)
     {
-        WARN("Stub; we set our timer resolution at minimum\n");
+        EnterCriticalSection(&WINMM_cs);
+        TIME_PeriodRefs[wPeriod - 1]++;
+        TIME_UpdateResolution();
+        LeaveCriticalSection(&WINMM_cs);
     }
 
     return 0;
@@ -436,12 +462,21 @@ MMRESULT WINAPI timeBeginPeriod(UINT wPeriod)
  */
 MMRESULT WINAPI timeEndPeriod(UINT wPeriod)
 {
+    MMRESULT ret = 0;
+
     if (wPeriod < MMSYSTIME_MININTERVAL || wPeriod > MMSYSTIME_MAXINTERVAL)
 	return TIMERR_NOCANDO;
 
-    if (wPeriod > MMSYSTIME_MININTERVAL)
+    if (wPeriod <= MMSYSTIME_MAXPERIODREF)
     {
-        WARN("Stub; we set our timer resolution at minimum\n");
+        EnterCriticalSection(&WINMM_cs);
+        if (TIME_PeriodRefs[wPeriod - 1])
+        {
+            TIME_PeriodRefs[wPeriod - 1]--;
+            TIME_UpdateResolution();
+        }
+        else ret = TIMERR_NOCANDO;
+        LeaveCriticalSection(&WINMM_cs);
     }
-    return 0;
+    return ret;
 }
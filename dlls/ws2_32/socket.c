@@ -128,6 +128,12 @@
 #ifdef HAVE_SYS_POLL_H
 # include <sys/poll.h>
 #endif
+#ifdef HAVE_SYS_EPOLL_H
+# include <sys/epoll.h>
+#endif
+#ifdef HAVE_SYS_SENDFILE_H
+# include <sys/sendfile.h>
+#endif
 #ifdef HAVE_SYS_TIME_H
 # include <sys/time.h>
 #endif
@@ -157,6 +163,7 @@
 #include "wine/server.h"
 #include "wine/debug.h"
 #include "wine/exception.h"
+#include "wine/list.h"
 #include "wine/unicode.h"
 
 #if defined(linux) && !defined(IP_UNICAST_IF)
@@ -606,6 +613,12 @@ typedef struct          /* WSAAsyncSelect() control struct */
 #define WS_MAX_UDP_DATAGRAM             1024
 static INT WINAPI WSA_DefaultBlockingHook( FARPROC x );
 
+struct epoll_entry
+{
+    int   fd;       /* unix fd registered in the epoll set */
+    short events;   /* poll events it is registered for */
+};
+
 /* hostent's, servent's and protent's are stored in one buffer per thread,
  * as documented on MSDN for the functions that return any of the buffers */
 struct per_thread_data
@@ -616,6 +629,11 @@ struct per_thread_data
     struct WS_protoent *pe_buffer;
     struct pollfd *fd_cache;
     unsigned int fd_count;
+    int epoll_fd;                       /* persistent epoll set for large polls, -1 if none */
+    struct epoll_entry *epoll_entries;  /* fds registered in the epoll set, sorted by fd */
+    unsigned int epoll_count;
+    unsigned int epoll_size;
+    unsigned int epoll_serial;          /* closed_fd_serial when the set was last updated */
     int he_len;
     int se_len;
     int pe_len;
@@ -642,7 +660,8 @@ static int ws_protocol_info(SOCKET s, int unicode, WSAPROTOCOL_INFOW *buffer, in
 int WSAIOCTL_GetInterfaceCount(void);
 int WSAIOCTL_GetInterfaceName(int intNumber, char *intName);
 
-static void WS_AddCompletion( SOCKET sock, ULONG_PTR CompletionValue, NTSTATUS CompletionStatus, ULONG Information );
+static void WS_AddCompletion( SOCKET sock, ULONG_PTR CompletionValue, NTSTATUS CompletionStatus,
+                              ULONG Information, BOOL async );
 
 #define MAP_OPTION(opt) { WS_##opt, opt }
 
@@ -1288,6 +1307,7 @@ static struct per_thread_data *get_per_thread_data(void)
     if (!ptb)
     {
         ptb = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*ptb) );
+        ptb->epoll_fd = -1;
         NtCurrentTeb()->WinSockData = ptb;
     }
     return ptb;
@@ -1304,11 +1324,263 @@ static void free_per_thread_data(void)
     HeapFree( GetProcessHeap(), 0, ptb->se_buffer );
     HeapFree( GetProcessHeap(), 0, ptb->pe_buffer );
     HeapFree( GetProcessHeap(), 0, ptb->fd_cache );
+    HeapFree( GetProcessHeap(), 0, ptb->epoll_entries );
+    if (ptb->epoll_fd != -1) close( ptb->epoll_fd );
 
     HeapFree( GetProcessHeap(), 0, ptb );
     NtCurrentTeb()->WinSockData = NULL;
 }
 
+#if defined(HAVE_SYS_EPOLL_H) && defined(HAVE_EPOLL_CREATE)
+
+/* Large polls go through a persistent per-thread epoll set, so that only the
+ * fds that changed since the previous call have to be passed to the kernel.
+ * The unix fds of closed sockets are kept in a small ring, since a new socket
+ * may get both the handle and the fd number of a closed one. */
+#define EPOLL_MIN_FDS       64
+#define CLOSED_FD_RING_SIZE 64
+
+struct epoll_slot
+{
+    int          fd;      /* unix fd */
+    unsigned int index;   /* index in the poll array */
+};
+
+struct epoll_wait_info
+{
+    struct epoll_slot  *slots;      /* poll array entries sorted by fd */
+    unsigned int        nb_slots;
+    struct epoll_event  events[1];  /* events returned by epoll_wait */
+};
+
+static int closed_fds[CLOSED_FD_RING_SIZE];
+static unsigned int closed_fd_serial;
+
+static CRITICAL_SECTION closed_fd_section;
+static CRITICAL_SECTION_DEBUG closed_fd_debug =
+{
+    0, 0, &closed_fd_section,
+    { &closed_fd_debug.ProcessLocksList, &closed_fd_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": closed_fd_section") }
+};
+static CRITICAL_SECTION closed_fd_section = { &closed_fd_debug, -1, 0, 0, 0, 0 };
+
+/* close a socket handle, and remember its unix fd for the epoll sets */
+static BOOL close_socket_handle( SOCKET s, int fd )
+{
+    BOOL ret;
+
+    EnterCriticalSection( &closed_fd_section );
+    if ((ret = CloseHandle( SOCKET2HANDLE(s) )))
+        closed_fds[closed_fd_serial++ % CLOSED_FD_RING_SIZE] = fd;
+    LeaveCriticalSection( &closed_fd_section );
+    return ret;
+}
+
+static int epoll_slot_cmp( const void *a, const void *b )
+{
+    const struct epoll_slot *slot1 = a, *slot2 = b;
+    return slot1->fd < slot2->fd ? -1 : slot1->fd > slot2->fd;
+}
+
+static int epoll_entry_cmp( const void *a, const void *b )
+{
+    const struct epoll_entry *entry1 = a, *entry2 = b;
+    return entry1->fd < entry2->fd ? -1 : entry1->fd > entry2->fd;
+}
+
+/* drop the entries of the fds that have been closed since the last update */
+static void forget_closed_fds( struct per_thread_data *ptb )
+{
+    struct epoll_entry key, *entry;
+    unsigned int serial;
+
+    EnterCriticalSection( &closed_fd_section );
+    if (closed_fd_serial - ptb->epoll_serial > CLOSED_FD_RING_SIZE) ptb->epoll_count = 0;
+    for (serial = ptb->epoll_serial; serial != closed_fd_serial && ptb->epoll_count; serial++)
+    {
+        key.fd = closed_fds[serial % CLOSED_FD_RING_SIZE];
+        if (!(entry = bsearch( &key, ptb->epoll_entries, ptb->epoll_count,
+                               sizeof(*entry), epoll_entry_cmp ))) continue;
+        ptb->epoll_count--;
+        memmove( entry, entry + 1, (ptb->epoll_entries + ptb->epoll_count - entry) * sizeof(*entry) );
+    }
+    ptb->epoll_serial = closed_fd_serial;
+    LeaveCriticalSection( &closed_fd_section );
+}
+
+/* add or modify an fd in the epoll set; the EPOLL* flags have the same values as the POLL* ones */
+static BOOL set_epoll_events( int epoll_fd, int fd, short events, BOOL registered )
+{
+    struct epoll_event ev;
+
+    ev.events = events;
+    ev.data.fd = fd;
+    if (registered)
+        return !epoll_ctl( epoll_fd, EPOLL_CTL_MOD, fd, &ev ) ||
+               (errno == ENOENT && !epoll_ctl( epoll_fd, EPOLL_CTL_ADD, fd, &ev ));
+    return !epoll_ctl( epoll_fd, EPOLL_CTL_ADD, fd, &ev ) ||
+           (errno == EEXIST && !epoll_ctl( epoll_fd, EPOLL_CTL_MOD, fd, &ev ));
+}
+
+static void remove_epoll_fd( int epoll_fd, int fd )
+{
+    struct epoll_event ev;
+    epoll_ctl( epoll_fd, EPOLL_CTL_DEL, fd, &ev );
+}
+
+/* make the thread epoll set match the poll array; return NULL if poll should be used instead */
+static struct epoll_wait_info *update_epoll_set( const struct pollfd *fds, int count )
+{
+    struct per_thread_data *ptb = get_per_thread_data();
+    struct epoll_wait_info *info;
+    struct epoll_entry *entries;
+    unsigned int i, j, nb_entries = 0;
+
+    if (count < EPOLL_MIN_FDS) return NULL;
+    if (ptb->epoll_fd == -1)
+    {
+        if ((ptb->epoll_fd = epoll_create( EPOLL_MIN_FDS )) == -1) return NULL;
+        fcntl( ptb->epoll_fd, F_SETFD, FD_CLOEXEC );
+        ptb->epoll_count = 0;
+    }
+
+    if (!(info = HeapAlloc( GetProcessHeap(), 0, offsetof( struct epoll_wait_info, events[count] ) +
+                            count * (sizeof(*info->slots) + sizeof(*entries)) )))
+        return NULL;
+    info->slots = (struct epoll_slot *)&info->events[count];
+    entries = (struct epoll_entry *)(info->slots + count);
+
+    info->nb_slots = 0;
+    for (i = 0; i < count; i++)
+    {
+        if (fds[i].fd == -1) continue;
+        info->slots[info->nb_slots].fd = fds[i].fd;
+        info->slots[info->nb_slots].index = i;
+        info->nb_slots++;
+    }
+    qsort( info->slots, info->nb_slots, sizeof(*info->slots), epoll_slot_cmp );
+
+    /* the same socket may be in several fd sets */
+    for (i = 0; i < info->nb_slots; i++)
+    {
+        short events = fds[info->slots[i].index].events;
+
+        if (nb_entries && entries[nb_entries - 1].fd == info->slots[i].fd)
+            entries[nb_entries - 1].events |= events;
+        else
+        {
+            entries[nb_entries].fd = info->slots[i].fd;
+            entries[nb_entries].events = events;
+            nb_entries++;
+        }
+    }
+
+    if (ptb->epoll_size < nb_entries)
+    {
+        struct epoll_entry *new_entries;
+        unsigned int new_size = max( nb_entries, 2 * ptb->epoll_size );
+
+        if (ptb->epoll_entries)
+            new_entries = HeapReAlloc( GetProcessHeap(), 0, ptb->epoll_entries, new_size * sizeof(*new_entries) );
+        else
+            new_entries = HeapAlloc( GetProcessHeap(), 0, new_size * sizeof(*new_entries) );
+        if (!new_entries) goto failed;
+        ptb->epoll_entries = new_entries;
+        ptb->epoll_size = new_size;
+    }
+
+    forget_closed_fds( ptb );
+
+    /* only pass on the differences with the previous call */
+    for (i = j = 0; i < nb_entries; i++)
+    {
+        while (j < ptb->epoll_count && ptb->epoll_entries[j].fd < entries[i].fd)
+            remove_epoll_fd( ptb->epoll_fd, ptb->epoll_entries[j++].fd );
+
+        if (j < ptb->epoll_count && ptb->epoll_entries[j].fd == entries[i].fd)
+        {
+            if (ptb->epoll_entries[j++].events == entries[i].events) continue;
+            if (!set_epoll_events( ptb->epoll_fd, entries[i].fd, entries[i].events, TRUE )) goto failed;
+        }
+        else if (!set_epoll_events( ptb->epoll_fd, entries[i].fd, entries[i].events, FALSE )) goto failed;
+    }
+    while (j < ptb->epoll_count) remove_epoll_fd( ptb->epoll_fd, ptb->epoll_entries[j++].fd );
+
+    memcpy( ptb->epoll_entries, entries, nb_entries * sizeof(*entries) );
+    ptb->epoll_count = nb_entries;
+    return info;
+
+failed:
+    /* start over with a new set next time */
+    close( ptb->epoll_fd );
+    ptb->epoll_fd = -1;
+    HeapFree( GetProcessHeap(), 0, info );
+    return NULL;
+}
+
+static int wait_epoll_set( struct epoll_wait_info *info, int count, int timeout )
+{
+    return epoll_wait( get_per_thread_data()->epoll_fd, info->events, count, timeout );
+}
+
+/* copy the epoll_wait events to the poll array, and return the poll result */
+static int get_epoll_results( struct pollfd *fds, int count, struct epoll_wait_info *info, int nb_events )
+{
+    unsigned int pos, start, end;
+    int i, fd, ret = 0;
+
+    for (i = 0; i < count; i++) fds[i].revents = 0;
+
+    for (i = 0; i < nb_events; i++)
+    {
+        /* find the first slot for that fd */
+        fd = info->events[i].data.fd;
+        start = 0;
+        end = info->nb_slots;
+        while (start < end)
+        {
+            pos = (start + end) / 2;
+            if (info->slots[pos].fd < fd) start = pos + 1;
+            else end = pos;
+        }
+
+        for (pos = start; pos < info->nb_slots && info->slots[pos].fd == fd; pos++)
+        {
+            struct epoll_slot *slot = &info->slots[pos];
+            struct pollfd *pfd = &fds[slot->index];
+            if ((pfd->revents = info->events[i].events & (pfd->events | POLLERR | POLLHUP))) ret++;
+        }
+    }
+    return ret;
+}
+
+#else  /* HAVE_SYS_EPOLL_H */
+
+struct epoll_wait_info;
+
+static BOOL close_socket_handle( SOCKET s, int fd )
+{
+    return CloseHandle( SOCKET2HANDLE(s) );
+}
+
+static inline struct epoll_wait_info *update_epoll_set( const struct pollfd *fds, int count )
+{
+    return NULL;
+}
+
+static inline int wait_epoll_set( struct epoll_wait_info *info, int count, int timeout )
+{
+    return -1;
+}
+
+static inline int get_epoll_results( struct pollfd *fds, int count, struct epoll_wait_info *info, int nb_events )
+{
+    return 0;
+}
+
+#endif  /* HAVE_SYS_EPOLL_H */
+
 /***********************************************************************
  *		DllMain (WS2_32.init)
  */
@@ -2459,7 +2731,7 @@ static NTSTATUS WS2_async_accept_recv( void *user, IO_STATUS_BLOCK *iosb, NTSTAT
         return status;
 
     if (wsa->cvalue)
-        WS_AddCompletion( HANDLE2SOCKET(wsa->listen_socket), wsa->cvalue, iosb->u.Status, iosb->Information );
+        WS_AddCompletion( HANDLE2SOCKET(wsa->listen_socket), wsa->cvalue, iosb->u.Status, iosb->Information, TRUE );
 
     release_async_io( &wsa->io );
     return status;
@@ -2922,6 +3194,51 @@ static NTSTATUS WS2_ReadFile(HANDLE hFile, PIO_STATUS_BLOCK io_status, char* buf
     return status;
 }
 
+/***********************************************************************
+ *     WS2_transmitfile_sendfile        (INTERNAL)
+ *
+ * Let the kernel copy the file data straight to the socket.
+ * Returns STATUS_NOT_SUPPORTED if the data needs to go through a buffer instead.
+ */
+static NTSTATUS WS2_transmitfile_sendfile( int fd, struct ws2_transmitfile_async *wsa )
+{
+#ifdef HAVE_SYS_SENDFILE_H
+    IO_STATUS_BLOCK *iosb = (IO_STATUS_BLOCK *)wsa->write.user_overlapped;
+    off_t offset = wsa->offset.QuadPart;
+    size_t count = 0x40000000;
+    ssize_t ret;
+    int file_fd;
+
+    if (wsa->file_bytes != 0) count = min( count, wsa->file_bytes - wsa->file_read );
+    if (wine_server_handle_to_fd( wsa->file, FILE_READ_DATA, &file_fd, NULL )) return STATUS_NOT_SUPPORTED;
+
+    if (wsa->offset.QuadPart == FILE_USE_FILE_POINTER_POSITION)
+        ret = sendfile( fd, file_fd, NULL, count );
+    else
+        ret = sendfile( fd, file_fd, &offset, count );
+    wine_server_release_fd( wsa->file, file_fd );
+
+    if (ret == -1)
+    {
+        if (errno == EAGAIN || errno == EINTR) return STATUS_PENDING;
+        if (errno == EINVAL || errno == ENOSYS) return STATUS_NOT_SUPPORTED;
+        return wsaErrStatus();
+    }
+
+    if (wsa->offset.QuadPart != FILE_USE_FILE_POINTER_POSITION)
+        wsa->offset.QuadPart += ret;
+    wsa->file_read += ret;
+    if (iosb) iosb->Information += ret;
+
+    if (ret && (wsa->file_bytes == 0 || wsa->file_read < wsa->file_bytes))
+        return STATUS_PENDING;
+    wsa->file = NULL;
+    return STATUS_SUCCESS;
+#else
+    return STATUS_NOT_SUPPORTED;
+#endif
+}
+
 /***********************************************************************
  *     WS2_transmitfile_getbuffer       (INTERNAL)
  *
@@ -2929,6 +3246,8 @@ static NTSTATUS WS2_ReadFile(HANDLE hFile, PIO_STATUS_BLOCK io_status, char* buf
  */
 static NTSTATUS WS2_transmitfile_getbuffer( int fd, struct ws2_transmitfile_async *wsa )
 {
+    NTSTATUS status;
+
     /* send any incomplete writes from a previous iteration */
     if (wsa->write.first_iovec < wsa->write.n_iovecs)
         return STATUS_PENDING;
@@ -2945,11 +3264,15 @@ static NTSTATUS WS2_transmitfile_getbuffer( int fd, struct ws2_transmitfile_asyn
     }
 
     /* process the main file */
-    if (wsa->file)
+    if (wsa->file && (status = WS2_transmitfile_sendfile( fd, wsa )) != STATUS_NOT_SUPPORTED)
+    {
+        if (status != STATUS_SUCCESS) return status;
+        /* continue on to the footer */
+    }
+    else if (wsa->file)
     {
         DWORD bytes_per_send = wsa->bytes_per_send;
         IO_STATUS_BLOCK iosb;
-        NTSTATUS status;
 
         iosb.Information = 0;
         /* when the size of the transfer is limited ensure that we don't go past that limit */
@@ -3004,7 +3327,7 @@ static NTSTATUS WS2_transmitfile_base( int fd, struct ws2_transmitfile_async *ws
     NTSTATUS status;
 
     status = WS2_transmitfile_getbuffer( fd, wsa );
-    if (status == STATUS_PENDING)
+    if (status == STATUS_PENDING && wsa->write.first_iovec < wsa->write.n_iovecs)
     {
         IO_STATUS_BLOCK *iosb = (IO_STATUS_BLOCK *)wsa->write.user_overlapped;
         int n;
@@ -3215,6 +3538,629 @@ static int WINAPI WS2_WSARecvMsg( SOCKET s, LPWSAMSG msg, LPDWORD lpNumberOfByte
                           lpOverlapped, lpCompletionRoutine, &msg->Control );
 }
 
+/***********************************************************************
+ *     Registered I/O
+ *
+ * Request queues are layered on top of the regular overlapped receive and
+ * send paths: each RIO request is an ordinary socket async whose completion
+ * is delivered through the thread pool completion port, and then stored in
+ * the completion queue ring where RIODequeueCompletion polls it without
+ * going to the server.  Requests that complete immediately are stored in
+ * the ring directly, using FILE_SKIP_COMPLETION_PORT_ON_SUCCESS.  Deferred
+ * requests are not batched, they are simply started right away.
+ */
+
+struct rio_buffer
+{
+    char   *data;
+    DWORD   length;
+};
+
+struct rio_cq
+{
+    CRITICAL_SECTION             cs;
+    RIORESULT                   *results;      /* ring of completed requests */
+    ULONG                        size;         /* size of the ring */
+    ULONG                        head;         /* index of the oldest result */
+    ULONG                        count;        /* number of results in the ring */
+    ULONG                        reserved;     /* slots reserved by request queues */
+    BOOL                         notify_armed; /* RIONotify called and not signaled yet */
+    RIO_NOTIFICATION_COMPLETION  notify;       /* notification method, Type is 0 if none */
+};
+
+struct rio_rq
+{
+    struct list     entry;            /* entry in rio_queues */
+    LONG            refs;             /* one for the socket, one per outstanding request */
+    SOCKET          socket;
+    ULONGLONG       context;
+    struct rio_cq  *recv_cq;
+    struct rio_cq  *send_cq;
+    ULONG           max_recv;         /* maximum outstanding receives */
+    ULONG           max_recv_bufs;
+    ULONG           max_send;         /* maximum outstanding sends */
+    ULONG           max_send_bufs;
+    LONG            recv_count;       /* outstanding receives */
+    LONG            send_count;       /* outstanding sends */
+    BOOL            skip_on_success;  /* immediate completions are not posted to the port */
+};
+
+struct rio_request
+{
+    OVERLAPPED      ov;
+    struct rio_rq  *rq;
+    ULONGLONG       context;
+    DWORD           rio_flags;
+    BOOL            send;
+    DWORD           flags;            /* receive flags, must stay valid until completion */
+    INT             addrlen;          /* address length, must stay valid until completion */
+    WSABUF          control;
+    WSABUF          bufs[1];
+};
+
+static struct list rio_queues = LIST_INIT( rio_queues );
+
+static CRITICAL_SECTION rio_section;
+static CRITICAL_SECTION_DEBUG rio_section_debug =
+{
+    0, 0, &rio_section,
+    { &rio_section_debug.ProcessLocksList, &rio_section_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": rio_section") }
+};
+static CRITICAL_SECTION rio_section = { &rio_section_debug, -1, 0, 0, 0, 0 };
+
+static void rio_signal_cq( struct rio_cq *cq )
+{
+    if (cq->notify.Type == RIO_EVENT_COMPLETION)
+        SetEvent( cq->notify.u.Event.EventHandle );
+    else
+        PostQueuedCompletionStatus( cq->notify.u.Iocp.IocpHandle, 0,
+                                    (ULONG_PTR)cq->notify.u.Iocp.CompletionKey,
+                                    cq->notify.u.Iocp.Overlapped );
+}
+
+static void rio_release_rq( struct rio_rq *rq )
+{
+    if (InterlockedDecrement( &rq->refs )) return;
+    HeapFree( GetProcessHeap(), 0, rq );
+}
+
+/* store the result of a finished request in its completion queue */
+static void rio_complete_request( struct rio_request *req, NTSTATUS status, ULONG bytes )
+{
+    struct rio_rq *rq = req->rq;
+    struct rio_cq *cq = req->send ? rq->send_cq : rq->recv_cq;
+    RIORESULT *result;
+
+    TRACE( "rq %p request %s status %08x bytes %u\n", rq, wine_dbgstr_longlong(req->context), status, bytes );
+
+    EnterCriticalSection( &cq->cs );
+    if (cq->count < cq->size)
+    {
+        result = &cq->results[(cq->head + cq->count) % cq->size];
+        result->Status           = NtStatusToWSAError( status );
+        result->BytesTransferred = bytes;
+        result->SocketContext    = rq->context;
+        result->RequestContext   = req->context;
+        cq->count++;
+    }
+    else ERR( "completion queue %p overflow\n", cq );
+
+    if (cq->notify_armed && !(req->rio_flags & RIO_MSG_DONT_NOTIFY))
+    {
+        cq->notify_armed = FALSE;
+        rio_signal_cq( cq );
+    }
+    LeaveCriticalSection( &cq->cs );
+
+    InterlockedDecrement( req->send ? &rq->send_count : &rq->recv_count );
+    HeapFree( GetProcessHeap(), 0, req );
+    rio_release_rq( rq );
+}
+
+static void CALLBACK rio_io_completion( DWORD error, DWORD bytes, LPOVERLAPPED ov )
+{
+    struct rio_request *req = CONTAINING_RECORD( ov, struct rio_request, ov );
+
+    rio_complete_request( req, ov->Internal, ov->InternalHigh );
+}
+
+/* reserve completion queue slots for the outstanding requests of a request queue,
+ * a negative count releases them */
+static BOOL rio_reserve( struct rio_cq *cq, LONG count )
+{
+    BOOL ret;
+
+    EnterCriticalSection( &cq->cs );
+    if ((ret = (count <= 0 || cq->size - cq->reserved >= count))) cq->reserved += count;
+    LeaveCriticalSection( &cq->cs );
+    return ret;
+}
+
+/* called when the socket of a request queue is closed */
+static void rio_close_socket( SOCKET s )
+{
+    struct rio_rq *rq;
+
+    EnterCriticalSection( &rio_section );
+    LIST_FOR_EACH_ENTRY( rq, &rio_queues, struct rio_rq, entry )
+    {
+        if (rq->socket != s) continue;
+        list_remove( &rq->entry );
+
+        rio_reserve( rq->recv_cq, -(LONG)rq->max_recv );
+        rio_reserve( rq->send_cq, -(LONG)rq->max_send );
+
+        rio_release_rq( rq );
+        break;
+    }
+    LeaveCriticalSection( &rio_section );
+}
+
+static BOOL rio_get_wsabuf( const RIO_BUF *buf, WSABUF *wsabuf )
+{
+    const struct rio_buffer *buffer = (const struct rio_buffer *)buf->BufferId;
+
+    if (!buffer || buf->BufferId == RIO_INVALID_BUFFERID) return FALSE;
+    if (buf->Offset > buffer->length || buf->Length > buffer->length - buf->Offset) return FALSE;
+    wsabuf->buf = buffer->data + buf->Offset;
+    wsabuf->len = buf->Length;
+    return TRUE;
+}
+
+static struct rio_request *rio_alloc_request( struct rio_rq *rq, BOOL send, const RIO_BUF *data,
+                                              ULONG count, DWORD flags, void *context )
+{
+    struct rio_request *req;
+    LONG *outstanding = send ? &rq->send_count : &rq->recv_count;
+    ULONG i;
+
+    if (count > (send ? rq->max_send_bufs : rq->max_recv_bufs) || (count && !data))
+    {
+        SetLastError( WSAEINVAL );
+        return NULL;
+    }
+    if (InterlockedIncrement( outstanding ) > (send ? rq->max_send : rq->max_recv))
+    {
+        InterlockedDecrement( outstanding );
+        SetLastError( WSAENOBUFS );
+        return NULL;
+    }
+    if (!(req = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                           offsetof( struct rio_request, bufs[count ? count : 1] ))))
+    {
+        InterlockedDecrement( outstanding );
+        SetLastError( WSAENOBUFS );
+        return NULL;
+    }
+    for (i = 0; i < count; i++)
+    {
+        if (!rio_get_wsabuf( &data[i], &req->bufs[i] ))
+        {
+            HeapFree( GetProcessHeap(), 0, req );
+            InterlockedDecrement( outstanding );
+            SetLastError( WSAEINVAL );
+            return NULL;
+        }
+    }
+    InterlockedIncrement( &rq->refs );
+    req->rq        = rq;
+    req->context   = (ULONG_PTR)context;
+    req->rio_flags = flags;
+    req->send      = send;
+    return req;
+}
+
+/* finish starting a request, depending on what the receive or send call returned */
+static BOOL rio_start_request( struct rio_request *req, int ret )
+{
+    struct rio_rq *rq = req->rq;
+    DWORD err;
+
+    if (!ret)
+    {
+        /* without the skip flag, the completion port delivers the result */
+        if (rq->skip_on_success) rio_complete_request( req, STATUS_SUCCESS, req->ov.InternalHigh );
+        return TRUE;
+    }
+    if ((err = WSAGetLastError()) == WSA_IO_PENDING) return TRUE;
+
+    InterlockedDecrement( req->send ? &rq->send_count : &rq->recv_count );
+    HeapFree( GetProcessHeap(), 0, req );
+    rio_release_rq( rq );
+    SetLastError( err );
+    return FALSE;
+}
+
+/***********************************************************************
+ *     RIORegisterBuffer
+ */
+static RIO_BUFFERID WINAPI WS2_RIORegisterBuffer( PCHAR data, DWORD length )
+{
+    struct rio_buffer *buffer;
+
+    TRACE( "(%p, %u)\n", data, length );
+
+    if (!data || !length)
+    {
+        SetLastError( WSAEINVAL );
+        return RIO_INVALID_BUFFERID;
+    }
+    if (!(buffer = HeapAlloc( GetProcessHeap(), 0, sizeof(*buffer) )))
+    {
+        SetLastError( WSAENOBUFS );
+        return RIO_INVALID_BUFFERID;
+    }
+    buffer->data   = data;
+    buffer->length = length;
+    return (RIO_BUFFERID)buffer;
+}
+
+/***********************************************************************
+ *     RIODeregisterBuffer
+ */
+static void WINAPI WS2_RIODeregisterBuffer( RIO_BUFFERID id )
+{
+    TRACE( "(%p)\n", id );
+
+    if (id == RIO_INVALID_BUFFERID) return;
+    HeapFree( GetProcessHeap(), 0, id );
+}
+
+/***********************************************************************
+ *     RIOCreateCompletionQueue
+ */
+static RIO_CQ WINAPI WS2_RIOCreateCompletionQueue( DWORD size, PRIO_NOTIFICATION_COMPLETION notify )
+{
+    struct rio_cq *cq;
+
+    TRACE( "(%u, %p)\n", size, notify );
+
+    if (!size || size > RIO_MAX_CQ_SIZE ||
+        (notify && notify->Type != RIO_EVENT_COMPLETION && notify->Type != RIO_IOCP_COMPLETION))
+    {
+        SetLastError( WSAEINVAL );
+        return RIO_INVALID_CQ;
+    }
+    if (!(cq = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*cq) )) ||
+        !(cq->results = HeapAlloc( GetProcessHeap(), 0, size * sizeof(*cq->results) )))
+    {
+        HeapFree( GetProcessHeap(), 0, cq );
+        SetLastError( WSAENOBUFS );
+        return RIO_INVALID_CQ;
+    }
+    cq->size = size;
+    if (notify) cq->notify = *notify;
+    InitializeCriticalSection( &cq->cs );
+    cq->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": rio_cq.cs");
+    return (RIO_CQ)cq;
+}
+
+/***********************************************************************
+ *     RIOCloseCompletionQueue
+ */
+static void WINAPI WS2_RIOCloseCompletionQueue( RIO_CQ queue )
+{
+    struct rio_cq *cq = (struct rio_cq *)queue;
+
+    TRACE( "(%p)\n", queue );
+
+    if (!cq) return;
+    cq->cs.DebugInfo->Spare[0] = 0;
+    DeleteCriticalSection( &cq->cs );
+    HeapFree( GetProcessHeap(), 0, cq->results );
+    HeapFree( GetProcessHeap(), 0, cq );
+}
+
+/***********************************************************************
+ *     RIOResizeCompletionQueue
+ */
+static BOOL WINAPI WS2_RIOResizeCompletionQueue( RIO_CQ queue, DWORD size )
+{
+    struct rio_cq *cq = (struct rio_cq *)queue;
+    RIORESULT *results;
+    ULONG i;
+
+    TRACE( "(%p, %u)\n", queue, size );
+
+    if (!cq || !size || size > RIO_MAX_CQ_SIZE)
+    {
+        SetLastError( WSAEINVAL );
+        return FALSE;
+    }
+
+    EnterCriticalSection( &cq->cs );
+    if (size < cq->reserved || size < cq->count)
+    {
+        LeaveCriticalSection( &cq->cs );
+        SetLastError( WSAEINVAL );
+        return FALSE;
+    }
+    if (!(results = HeapAlloc( GetProcessHeap(), 0, size * sizeof(*results) )))
+    {
+        LeaveCriticalSection( &cq->cs );
+        SetLastError( WSAENOBUFS );
+        return FALSE;
+    }
+    for (i = 0; i < cq->count; i++) results[i] = cq->results[(cq->head + i) % cq->size];
+    HeapFree( GetProcessHeap(), 0, cq->results );
+    cq->results = results;
+    cq->size    = size;
+    cq->head    = 0;
+    LeaveCriticalSection( &cq->cs );
+    return TRUE;
+}
+
+/***********************************************************************
+ *     RIODequeueCompletion
+ */
+static ULONG WINAPI WS2_RIODequeueCompletion( RIO_CQ queue, PRIORESULT array, ULONG size )
+{
+    struct rio_cq *cq = (struct rio_cq *)queue;
+    ULONG i, count;
+
+    TRACE( "(%p, %p, %u)\n", queue, array, size );
+
+    if (!cq || !array)
+    {
+        SetLastError( WSAEINVAL );
+        return RIO_CORRUPT_CQ;
+    }
+
+    EnterCriticalSection( &cq->cs );
+    count = min( size, cq->count );
+    for (i = 0; i < count; i++)
+    {
+        array[i] = cq->results[cq->head];
+        if (++cq->head == cq->size) cq->head = 0;
+    }
+    cq->count -= count;
+    LeaveCriticalSection( &cq->cs );
+    return count;
+}
+
+/***********************************************************************
+ *     RIONotify
+ */
+static int WINAPI WS2_RIONotify( RIO_CQ queue )
+{
+    struct rio_cq *cq = (struct rio_cq *)queue;
+    int ret = 0;
+
+    TRACE( "(%p)\n", queue );
+
+    if (!cq || !cq->notify.Type) return WSAEINVAL;
+
+    EnterCriticalSection( &cq->cs );
+    if (cq->notify_armed) ret = WSAEALREADY;
+    else
+    {
+        if (cq->notify.Type == RIO_EVENT_COMPLETION && cq->notify.u.Event.NotifyReset)
+            ResetEvent( cq->notify.u.Event.EventHandle );
+        if (cq->count) rio_signal_cq( cq );
+        else cq->notify_armed = TRUE;
+    }
+    LeaveCriticalSection( &cq->cs );
+    return ret;
+}
+
+/***********************************************************************
+ *     RIOCreateRequestQueue
+ */
+static RIO_RQ WINAPI WS2_RIOCreateRequestQueue( SOCKET s, ULONG max_recv, ULONG max_recv_bufs,
+                                                ULONG max_send, ULONG max_send_bufs,
+                                                RIO_CQ recv_cq, RIO_CQ send_cq, PVOID context )
+{
+    struct rio_rq *rq, *other;
+    unsigned int options;
+    int fd;
+
+    TRACE( "(%04lx, %u, %u, %u, %u, %p, %p, %p)\n", s, max_recv, max_recv_bufs,
+           max_send, max_send_bufs, recv_cq, send_cq, context );
+
+    if (!recv_cq || !send_cq || (!max_recv && !max_send))
+    {
+        SetLastError( WSAEINVAL );
+        return RIO_INVALID_RQ;
+    }
+    if ((fd = get_sock_fd( s, 0, &options )) == -1) return RIO_INVALID_RQ;
+    release_sock_fd( s, fd );
+    if (options & (FILE_SYNCHRONOUS_IO_ALERT | FILE_SYNCHRONOUS_IO_NONALERT))
+    {
+        SetLastError( WSAEINVAL );
+        return RIO_INVALID_RQ;
+    }
+
+    if (!(rq = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*rq) )))
+    {
+        SetLastError( WSAENOBUFS );
+        return RIO_INVALID_RQ;
+    }
+    rq->refs          = 1;
+    rq->socket        = s;
+    rq->context       = (ULONG_PTR)context;
+    rq->recv_cq       = (struct rio_cq *)recv_cq;
+    rq->send_cq       = (struct rio_cq *)send_cq;
+    rq->max_recv      = max_recv;
+    rq->max_recv_bufs = max_recv_bufs;
+    rq->max_send      = max_send;
+    rq->max_send_bufs = max_send_bufs;
+
+    EnterCriticalSection( &rio_section );
+    LIST_FOR_EACH_ENTRY( other, &rio_queues, struct rio_rq, entry )
+    {
+        if (other->socket != s) continue;
+        SetLastError( WSAEINVAL );
+        goto failed;
+    }
+    /* the socket completions go to the thread pool, and from there to the queue ring */
+    if (!BindIoCompletionCallback( SOCKET2HANDLE(s), rio_io_completion, 0 ))
+    {
+        SetLastError( WSAEINVAL );
+        goto failed;
+    }
+    rq->skip_on_success = SetFileCompletionNotificationModes( SOCKET2HANDLE(s),
+                                                              FILE_SKIP_COMPLETION_PORT_ON_SUCCESS );
+    if (!rio_reserve( rq->recv_cq, max_recv ))
+    {
+        SetLastError( WSAENOBUFS );
+        goto failed;
+    }
+    if (!rio_reserve( rq->send_cq, max_send ))
+    {
+        rio_reserve( rq->recv_cq, -(LONG)max_recv );
+        SetLastError( WSAENOBUFS );
+        goto failed;
+    }
+    list_add_tail( &rio_queues, &rq->entry );
+    LeaveCriticalSection( &rio_section );
+    return (RIO_RQ)rq;
+
+failed:
+    LeaveCriticalSection( &rio_section );
+    HeapFree( GetProcessHeap(), 0, rq );
+    return RIO_INVALID_RQ;
+}
+
+/***********************************************************************
+ *     RIOResizeRequestQueue
+ */
+static BOOL WINAPI WS2_RIOResizeRequestQueue( RIO_RQ queue, DWORD max_recv, DWORD max_send )
+{
+    struct rio_rq *rq = (struct rio_rq *)queue;
+
+    TRACE( "(%p, %u, %u)\n", queue, max_recv, max_send );
+
+    if (!rq || max_recv < rq->recv_count || max_send < rq->send_count)
+    {
+        SetLastError( WSAEINVAL );
+        return FALSE;
+    }
+    if (!rio_reserve( rq->recv_cq, (LONG)(max_recv - rq->max_recv) ))
+    {
+        SetLastError( WSAENOBUFS );
+        return FALSE;
+    }
+    if (!rio_reserve( rq->send_cq, (LONG)(max_send - rq->max_send) ))
+    {
+        rio_reserve( rq->recv_cq, (LONG)(rq->max_recv - max_recv) );
+        SetLastError( WSAENOBUFS );
+        return FALSE;
+    }
+    rq->max_recv = max_recv;
+    rq->max_send = max_send;
+    return TRUE;
+}
+
+/***********************************************************************
+ *     RIOReceiveEx
+ */
+static int WINAPI WS2_RIOReceiveEx( RIO_RQ queue, PRIO_BUF data, ULONG count, PRIO_BUF local_addr,
+                                    PRIO_BUF remote_addr, PRIO_BUF control, PRIO_BUF flags_buf,
+                                    DWORD flags, PVOID context )
+{
+    struct rio_rq *rq = (struct rio_rq *)queue;
+    struct rio_request *req;
+    struct WS_sockaddr *addr = NULL;
+    WSABUF buf;
+    int ret;
+
+    TRACE( "(%p, %p, %u, %p, %p, %p, %p, %#x, %p)\n", queue, data, count, local_addr,
+           remote_addr, control, flags_buf, flags, context );
+
+    if (!rq || (flags & ~(RIO_MSG_DONT_NOTIFY | RIO_MSG_DEFER | RIO_MSG_WAITALL | RIO_MSG_COMMIT_ONLY)))
+    {
+        SetLastError( WSAEINVAL );
+        return FALSE;
+    }
+    /* deferred requests have already been started */
+    if (flags & RIO_MSG_COMMIT_ONLY)
+    {
+        if (!data && !count) return TRUE;
+        SetLastError( WSAEINVAL );
+        return FALSE;
+    }
+    if (local_addr || flags_buf) FIXME( "local address and flags buffers not supported\n" );
+
+    if (!(req = rio_alloc_request( rq, FALSE, data, count, flags, context ))) return FALSE;
+    if (remote_addr)
+    {
+        if (!rio_get_wsabuf( remote_addr, &buf )) goto invalid;
+        addr = (struct WS_sockaddr *)buf.buf;
+        req->addrlen = buf.len;
+    }
+    if (control && !rio_get_wsabuf( control, &req->control )) goto invalid;
+    if (flags & RIO_MSG_WAITALL) req->flags |= WS_MSG_WAITALL;
+
+    ret = WS2_recv_base( rq->socket, req->bufs, count, NULL, &req->flags, addr,
+                         addr ? &req->addrlen : NULL, &req->ov, NULL, control ? &req->control : NULL );
+    return rio_start_request( req, ret );
+
+invalid:
+    WSASetLastError( WSAEINVAL );
+    rio_start_request( req, SOCKET_ERROR );
+    return FALSE;
+}
+
+/***********************************************************************
+ *     RIOReceive
+ */
+static BOOL WINAPI WS2_RIOReceive( RIO_RQ queue, PRIO_BUF data, ULONG count, DWORD flags, PVOID context )
+{
+    return WS2_RIOReceiveEx( queue, data, count, NULL, NULL, NULL, NULL, flags, context );
+}
+
+/***********************************************************************
+ *     RIOSendEx
+ */
+static BOOL WINAPI WS2_RIOSendEx( RIO_RQ queue, PRIO_BUF data, ULONG count, PRIO_BUF local_addr,
+                                  PRIO_BUF remote_addr, PRIO_BUF control, PRIO_BUF flags_buf,
+                                  DWORD flags, PVOID context )
+{
+    struct rio_rq *rq = (struct rio_rq *)queue;
+    struct rio_request *req;
+    WSABUF addr = { 0, NULL };
+    int ret;
+
+    TRACE( "(%p, %p, %u, %p, %p, %p, %p, %#x, %p)\n", queue, data, count, local_addr,
+           remote_addr, control, flags_buf, flags, context );
+
+    if (!rq || (flags & ~(RIO_MSG_DONT_NOTIFY | RIO_MSG_DEFER | RIO_MSG_COMMIT_ONLY)))
+    {
+        SetLastError( WSAEINVAL );
+        return FALSE;
+    }
+    /* deferred requests have already been started */
+    if (flags & RIO_MSG_COMMIT_ONLY)
+    {
+        if (!data && !count) return TRUE;
+        SetLastError( WSAEINVAL );
+        return FALSE;
+    }
+    if (local_addr || control || flags_buf)
+        FIXME( "local address, control and flags buffers not supported\n" );
+
+    if (!(req = rio_alloc_request( rq, TRUE, data, count, flags, context ))) return FALSE;
+    if (remote_addr && !rio_get_wsabuf( remote_addr, &addr ))
+    {
+        WSASetLastError( WSAEINVAL );
+        rio_start_request( req, SOCKET_ERROR );
+        return FALSE;
+    }
+
+    ret = WS2_sendto( rq->socket, req->bufs, count, NULL, 0, (struct WS_sockaddr *)addr.buf,
+                      addr.len, &req->ov, NULL );
+    return rio_start_request( req, ret );
+}
+
+/***********************************************************************
+ *     RIOSend
+ */
+static BOOL WINAPI WS2_RIOSend( RIO_RQ queue, PRIO_BUF data, ULONG count, DWORD flags, PVOID context )
+{
+    return WS2_RIOSendEx( queue, data, count, NULL, NULL, NULL, NULL, flags, context );
+}
+
 /***********************************************************************
  *               interface_bind         (INTERNAL)
  *
@@ -3391,7 +4337,8 @@ int WINAPI WS_closesocket(SOCKET s)
         if (fd >= 0)
         {
             release_sock_fd(s, fd);
-            if (CloseHandle(SOCKET2HANDLE(s)))
+            rio_close_socket(s);
+            if (close_socket_handle(s, fd))
                 res = 0;
         }
         else
@@ -3598,7 +4545,7 @@ static BOOL WINAPI WS2_ConnectEx(SOCKET s, const struct WS_sockaddr* name, int n
             {
                 ov->Internal = _get_sock_error(s, FD_CONNECT_BIT);
                 ov->InternalHigh = 0;
-                if (cvalue) WS_AddCompletion( s, cvalue, ov->Internal, ov->InternalHigh );
+                if (cvalue) WS_AddCompletion( s, cvalue, ov->Internal, ov->InternalHigh, TRUE );
                 if (ov->hEvent) NtSetEvent( ov->hEvent, NULL );
                 status = STATUS_PENDING;
             }
@@ -4483,6 +5430,7 @@ static const char *debugstr_wsaioctl(DWORD code)
         IOCTL_NAME(WS_SIO_GET_EXTENSION_FUNCTION_POINTER);
         IOCTL_NAME(WS_SIO_GET_GROUP_QOS);
         IOCTL_NAME(WS_SIO_GET_INTERFACE_LIST);
+        IOCTL_NAME(WS_SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER);
         /* IOCTL_NAME(WS_SIO_GET_INTERFACE_LIST_EX); */
         IOCTL_NAME(WS_SIO_GET_QOS);
         /* IOCTL_NAME(WS_SIO_IDEAL_SEND_BACKLOG_CHANGE);
@@ -4942,6 +5890,48 @@ INT WINAPI WSAIoctl(SOCKET s, DWORD code, LPVOID in_buff, DWORD in_size, LPVOID
         status = WSAEOPNOTSUPP;
         break;
     }
+    case WS_SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER:
+    {
+        static const GUID rio_guid = WSAID_MULTIPLE_RIO;
+        static const RIO_EXTENSION_FUNCTION_TABLE rio_funcs =
+        {
+            sizeof(RIO_EXTENSION_FUNCTION_TABLE),
+            WS2_RIOReceive,
+            WS2_RIOReceiveEx,
+            WS2_RIOSend,
+            WS2_RIOSendEx,
+            WS2_RIOCloseCompletionQueue,
+            WS2_RIOCreateCompletionQueue,
+            WS2_RIOCreateRequestQueue,
+            WS2_RIODequeueCompletion,
+            WS2_RIODeregisterBuffer,
+            WS2_RIONotify,
+            WS2_RIORegisterBuffer,
+            WS2_RIOResizeCompletionQueue,
+            WS2_RIOResizeRequestQueue
+        };
+
+        if (!in_buff || in_size < sizeof(GUID))
+        {
+            status = WSAEFAULT;
+            break;
+        }
+        if (!IsEqualGUID(&rio_guid, in_buff))
+        {
+            FIXME("SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER %s: stub\n", debugstr_guid(in_buff));
+            status = WSAEOPNOTSUPP;
+            break;
+        }
+        if (!out_buff || out_size < sizeof(rio_funcs))
+        {
+            status = WSAEFAULT;
+            break;
+        }
+        TRACE("-> got RIO function table\n");
+        memcpy(out_buff, &rio_funcs, sizeof(rio_funcs));
+        total = sizeof(rio_funcs);
+        break;
+    }
     case WS_SIO_KEEPALIVE_VALS:
     {
         struct tcp_keepalive *k;
@@ -5089,7 +6079,7 @@ INT WINAPI WSAIoctl(SOCKET s, DWORD code, LPVOID in_buff, DWORD in_size, LPVOID
         overlapped->Internal = status;
         overlapped->InternalHigh = total;
         if (overlapped->hEvent) NtSetEvent( overlapped->hEvent, NULL );
-        if (cvalue) WS_AddCompletion( HANDLE2SOCKET(s), cvalue, status, total );
+        if (cvalue) WS_AddCompletion( HANDLE2SOCKET(s), cvalue, status, total, FALSE );
     }
 
     if (!status)
@@ -5325,16 +6315,21 @@ static void release_poll_fds( const WS_fd_set *readfds, const WS_fd_set *writefd
 
 static int do_poll(struct pollfd *pollfds, int count, int timeout)
 {
+    struct epoll_wait_info *info = update_epoll_set( pollfds, count );
     struct timeval tv1, tv2;
     int ret, torig = timeout;
 
     if (timeout > 0) gettimeofday( &tv1, 0 );
 
-    while ((ret = poll( pollfds, count, timeout )) < 0)
+    while ((ret = info ? wait_epoll_set( info, count, timeout ) : poll( pollfds, count, timeout )) < 0)
     {
         if (errno != EINTR) break;
         if (timeout < 0) continue;
-        if (timeout == 0) return 0;
+        if (timeout == 0)
+        {
+            ret = 0;
+            break;
+        }
 
         gettimeofday( &tv2, 0 );
 
@@ -5347,7 +6342,17 @@ static int do_poll(struct pollfd *pollfds, int count, int timeout)
         }
 
         timeout = torig - (tv2.tv_sec * 1000) - (tv2.tv_usec + 999) / 1000;
-        if (timeout <= 0) return 0;
+        if (timeout <= 0)
+        {
+            ret = 0;
+            break;
+        }
+    }
+
+    if (info)
+    {
+        if (ret > 0) ret = get_epoll_results( pollfds, count, info, ret );
+        HeapFree( GetProcessHeap(), 0, info );
     }
     return ret;
 }
@@ -5484,14 +6489,27 @@ int WINAPI WSAPoll(WSAPOLLFD *wfds, ULONG count, int timeout)
 
 /* helper to send completion messages for client-only i/o operation case */
 static void WS_AddCompletion( SOCKET sock, ULONG_PTR CompletionValue, NTSTATUS CompletionStatus,
-                              ULONG Information )
+                              ULONG Information, BOOL async )
 {
+    if (!async)
+    {
+        FILE_IO_COMPLETION_NOTIFICATION_INFORMATION info;
+        IO_STATUS_BLOCK io;
+
+        /* the flags are cached along with the fd, so this doesn't need a server call */
+        if (!NtQueryInformationFile( SOCKET2HANDLE(sock), &io, &info, sizeof(info),
+                                     FileIoCompletionNotificationInformation ) &&
+            (info.Flags & FILE_SKIP_COMPLETION_PORT_ON_SUCCESS))
+            return;
+    }
+
     SERVER_START_REQ( add_fd_completion )
     {
         req->handle      = wine_server_obj_handle( SOCKET2HANDLE(sock) );
         req->cvalue      = CompletionValue;
         req->status      = CompletionStatus;
         req->information = Information;
+        req->async       = async;
         wine_server_call( req );
     }
     SERVER_END_REQ;
@@ -5636,7 +6654,7 @@ static int WS2_sendto( SOCKET s, LPWSABUF lpBuffers, DWORD dwBufferCount,
         if (lpNumberOfBytesSent) *lpNumberOfBytesSent = n;
         if (!wsa->completion_func)
         {
-            if (cvalue) WS_AddCompletion( s, cvalue, STATUS_SUCCESS, n );
+            if (cvalue) WS_AddCompletion( s, cvalue, STATUS_SUCCESS, n, FALSE );
             if (lpOverlapped->hEvent) SetEvent( lpOverlapped->hEvent );
             HeapFree( GetProcessHeap(), 0, wsa );
         }
@@ -7982,7 +9000,7 @@ static int WS2_recv_base( SOCKET s, LPWSABUF lpBuffers, DWORD dwBufferCount,
             iosb->Information = n;
             if (!wsa->completion_func)
             {
-                if (cvalue) WS_AddCompletion( s, cvalue, STATUS_SUCCESS, n );
+                if (cvalue) WS_AddCompletion( s, cvalue, STATUS_SUCCESS, n, FALSE );
                 if (lpOverlapped->hEvent) SetEvent( lpOverlapped->hEvent );
                 HeapFree( GetProcessHeap(), 0, wsa );
             }
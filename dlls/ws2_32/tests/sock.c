@@ -7078,7 +7078,8 @@ static void test_WSAPoll(void)
     struct sockaddr_in address;
     socklen_t len;
     static char tmp_buf[1024];
-    WSAPOLLFD fds[16];
+    WSAPOLLFD fds[16], many_fds[100];
+    SOCKET many[100];
     HANDLE thread_handle;
     DWORD id;
 
@@ -7276,6 +7277,49 @@ todo_wine
     ok(POLL_ISSET(fdWrite, POLLNVAL), "fdWrite socket events incorrect\n");
     WaitForSingleObject (thread_handle, 1000);
     closesocket(fdRead);
+
+    /* Test a large number of sockets, polled several times */
+    address.sin_port = 0;
+    for (ix = 0; ix < sizeof(many) / sizeof(many[0]); ix++)
+    {
+        many[ix] = socket(AF_INET, SOCK_DGRAM, 0);
+        ok(many[ix] != INVALID_SOCKET, "socket failed: %d\n", WSAGetLastError());
+        ret = bind(many[ix], (struct sockaddr *)&address, sizeof(address));
+        ok(!ret, "bind failed: %d\n", WSAGetLastError());
+        many_fds[ix].fd = many[ix];
+        many_fds[ix].events = POLLRDNORM;
+        many_fds[ix].revents = 0xdead;
+    }
+    ret = pWSAPoll(many_fds, ix, 0);
+    ok(ret == 0, "expected 0, got %d\n", ret);
+    ok(!many_fds[50].revents, "got events %x\n", many_fds[50].revents);
+
+    len = sizeof(address);
+    getsockname(many[50], (struct sockaddr *)&address, &len);
+    ret = sendto(many[0], "x", 1, 0, (struct sockaddr *)&address, len);
+    ok(ret == 1, "sendto failed: %d\n", WSAGetLastError());
+    ret = pWSAPoll(many_fds, ix, 1000);
+    ok(ret == 1, "expected 1, got %d\n", ret);
+    ok(many_fds[50].revents == POLLRDNORM, "got events %x\n", many_fds[50].revents);
+    ok(!many_fds[49].revents, "got events %x\n", many_fds[49].revents);
+
+    /* a new socket may reuse the handle of a closed one */
+    closesocket(many[50]);
+    many[50] = socket(AF_INET, SOCK_DGRAM, 0);
+    ok(many[50] != INVALID_SOCKET, "socket failed: %d\n", WSAGetLastError());
+    address.sin_port = 0;
+    ret = bind(many[50], (struct sockaddr *)&address, sizeof(address));
+    ok(!ret, "bind failed: %d\n", WSAGetLastError());
+    many_fds[50].fd = many[50];
+    len = sizeof(address);
+    getsockname(many[50], (struct sockaddr *)&address, &len);
+    ret = sendto(many[0], "x", 1, 0, (struct sockaddr *)&address, len);
+    ok(ret == 1, "sendto failed: %d\n", WSAGetLastError());
+    ret = pWSAPoll(many_fds, ix, 1000);
+    ok(ret == 1, "expected 1, got %d\n", ret);
+    ok(many_fds[50].revents == POLLRDNORM, "got events %x\n", many_fds[50].revents);
+
+    for (ix = 0; ix < sizeof(many) / sizeof(many[0]); ix++) closesocket(many[ix]);
 }
 #undef POLL_SET
 #undef POLL_ISSET
@@ -10379,6 +10423,214 @@ static void test_completion_port(void)
     CloseHandle(previous_port);
 }
 
+static void test_completion_port_skip_on_success(void)
+{
+    BOOL (WINAPI *pSetFileCompletionNotificationModes)(HANDLE,UCHAR);
+    HANDLE port;
+    WSAOVERLAPPED ov, *olp;
+    SOCKET src, dest;
+    char buf[16];
+    WSABUF bufs;
+    DWORD num_bytes, flags;
+    ULONG_PTR key;
+    int iret;
+    BOOL bret;
+
+    pSetFileCompletionNotificationModes = (void *)GetProcAddress( GetModuleHandleA("kernel32.dll"),
+                                                                  "SetFileCompletionNotificationModes" );
+    if (!pSetFileCompletionNotificationModes)
+    {
+        win_skip("SetFileCompletionNotificationModes not available\n");
+        return;
+    }
+
+    tcp_socketpair(&src, &dest);
+    if (src == INVALID_SOCKET || dest == INVALID_SOCKET)
+    {
+        skip("failed to create sockets\n");
+        return;
+    }
+
+    port = CreateIoCompletionPort( (HANDLE)dest, NULL, 125, 0 );
+    ok(port != NULL, "failed to create completion port %u\n", GetLastError());
+    bret = pSetFileCompletionNotificationModes( (HANDLE)dest, FILE_SKIP_COMPLETION_PORT_ON_SUCCESS );
+    ok(bret, "SetFileCompletionNotificationModes failed %u\n", GetLastError());
+
+    iret = send(src, "data", 4, 0);
+    ok(iret == 4, "send returned %d\n", iret);
+    Sleep(100);
+
+    /* an immediate success doesn't queue a completion */
+    memset(&ov, 0, sizeof(ov));
+    bufs.len = sizeof(buf);
+    bufs.buf = buf;
+    flags = 0;
+    num_bytes = 0xdeadbeef;
+    iret = WSARecv(dest, &bufs, 1, &num_bytes, &flags, &ov, NULL);
+    ok(!iret, "WSARecv failed %d\n", WSAGetLastError());
+    ok(num_bytes == 4, "got %u bytes\n", num_bytes);
+
+    SetLastError(0xdeadbeef);
+    olp = (WSAOVERLAPPED *)0xdeadbeef;
+    bret = GetQueuedCompletionStatus( port, &num_bytes, &key, &olp, 100 );
+    ok(!bret, "GetQueuedCompletionStatus returned %d\n", bret);
+    ok(GetLastError() == WAIT_TIMEOUT, "Last error was %d\n", GetLastError());
+    ok(!olp, "Overlapped structure is at %p\n", olp);
+
+    /* a pending request still does */
+    iret = WSARecv(dest, &bufs, 1, &num_bytes, &flags, &ov, NULL);
+    ok(iret == SOCKET_ERROR, "WSARecv returned %d\n", iret);
+    ok(WSAGetLastError() == WSA_IO_PENDING, "Last error was %d\n", WSAGetLastError());
+    iret = send(src, "data", 4, 0);
+    ok(iret == 4, "send returned %d\n", iret);
+
+    key = 0xdeadbeef;
+    olp = NULL;
+    bret = GetQueuedCompletionStatus( port, &num_bytes, &key, &olp, 1000 );
+    ok(bret, "GetQueuedCompletionStatus failed %u\n", GetLastError());
+    ok(key == 125, "Key is %lu\n", key);
+    ok(num_bytes == 4, "got %u bytes\n", num_bytes);
+    ok(olp == &ov, "Overlapped structure is at %p\n", olp);
+
+    closesocket(src);
+    closesocket(dest);
+    CloseHandle(port);
+}
+
+static void test_rio(void)
+{
+    GUID rio_guid = WSAID_MULTIPLE_RIO;
+    RIO_EXTENSION_FUNCTION_TABLE rio;
+    RIO_NOTIFICATION_COMPLETION notify;
+    RIO_BUFFERID id;
+    RIO_BUF rbuf;
+    RIORESULT results[4];
+    RIO_CQ cq;
+    RIO_RQ rq;
+    SOCKET s, server, peer;
+    struct sockaddr_in addr;
+    char buffer[64], data[16];
+    HANDLE event;
+    DWORD size, wait;
+    ULONG count;
+    int ret, len;
+    BOOL bret;
+
+    s = WSASocketW(AF_INET, SOCK_STREAM, IPPROTO_TCP, NULL, 0, WSA_FLAG_REGISTERED_IO);
+    ok(s != INVALID_SOCKET, "failed to create socket, error %d\n", WSAGetLastError());
+
+    memset(&rio, 0, sizeof(rio));
+    size = 0xdeadbeef;
+    ret = WSAIoctl(s, SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER, &rio_guid, sizeof(rio_guid),
+                   &rio, sizeof(rio), &size, NULL, NULL);
+    if (ret)
+    {
+        win_skip("RIO not supported, error %d\n", WSAGetLastError());
+        closesocket(s);
+        return;
+    }
+    ok(size == sizeof(rio), "got size %u\n", size);
+    ok(rio.cbSize == sizeof(rio), "got cbSize %u\n", rio.cbSize);
+
+    server = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    ok(server != INVALID_SOCKET, "failed to create socket, error %d\n", WSAGetLastError());
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    ret = bind(server, (struct sockaddr *)&addr, sizeof(addr));
+    ok(!ret, "bind failed, error %d\n", WSAGetLastError());
+    len = sizeof(addr);
+    ret = getsockname(server, (struct sockaddr *)&addr, &len);
+    ok(!ret, "getsockname failed, error %d\n", WSAGetLastError());
+    ret = listen(server, 1);
+    ok(!ret, "listen failed, error %d\n", WSAGetLastError());
+    ret = connect(s, (struct sockaddr *)&addr, sizeof(addr));
+    ok(!ret, "connect failed, error %d\n", WSAGetLastError());
+    len = sizeof(addr);
+    peer = accept(server, (struct sockaddr *)&addr, &len);
+    ok(peer != INVALID_SOCKET, "accept failed, error %d\n", WSAGetLastError());
+    closesocket(server);
+
+    id = rio.RIORegisterBuffer(buffer, sizeof(buffer));
+    ok(id != RIO_INVALID_BUFFERID, "RIORegisterBuffer failed, error %d\n", WSAGetLastError());
+
+    event = CreateEventW(NULL, FALSE, FALSE, NULL);
+    notify.Type = RIO_EVENT_COMPLETION;
+    notify.Event.EventHandle = event;
+    notify.Event.NotifyReset = FALSE;
+    cq = rio.RIOCreateCompletionQueue(8, &notify);
+    ok(cq != RIO_INVALID_CQ, "RIOCreateCompletionQueue failed, error %d\n", WSAGetLastError());
+
+    rq = rio.RIOCreateRequestQueue(s, 1, 1, 1, 1, cq, cq, (void *)0x1234);
+    ok(rq != RIO_INVALID_RQ, "RIOCreateRequestQueue failed, error %d\n", WSAGetLastError());
+
+    count = rio.RIODequeueCompletion(cq, results, ARRAY_SIZE(results));
+    ok(!count, "got %u results\n", count);
+
+    /* send from a registered buffer */
+    memcpy(buffer, "hello", 5);
+    rbuf.BufferId = id;
+    rbuf.Offset = 0;
+    rbuf.Length = 5;
+    bret = rio.RIOSend(rq, &rbuf, 1, 0, (void *)1);
+    ok(bret, "RIOSend failed, error %d\n", WSAGetLastError());
+
+    ret = rio.RIONotify(cq);
+    ok(!ret, "RIONotify returned %d\n", ret);
+    wait = WaitForSingleObject(event, 1000);
+    ok(!wait, "wait returned %u\n", wait);
+
+    memset(results, 0, sizeof(results));
+    count = rio.RIODequeueCompletion(cq, results, ARRAY_SIZE(results));
+    ok(count == 1, "got %u results\n", count);
+    ok(!results[0].Status, "got status %d\n", results[0].Status);
+    ok(results[0].BytesTransferred == 5, "got %u bytes\n", results[0].BytesTransferred);
+    ok(results[0].SocketContext == 0x1234, "got socket context %s\n",
+       wine_dbgstr_longlong(results[0].SocketContext));
+    ok(results[0].RequestContext == 1, "got request context %s\n",
+       wine_dbgstr_longlong(results[0].RequestContext));
+
+    ret = recv(peer, data, sizeof(data), 0);
+    ok(ret == 5, "recv returned %d\n", ret);
+    ok(!memcmp(data, "hello", 5), "got unexpected data\n");
+
+    /* pending receive into a registered buffer */
+    rbuf.Offset = 16;
+    rbuf.Length = 16;
+    bret = rio.RIOReceive(rq, &rbuf, 1, 0, (void *)2);
+    ok(bret, "RIOReceive failed, error %d\n", WSAGetLastError());
+
+    /* only one receive may be outstanding */
+    bret = rio.RIOReceive(rq, &rbuf, 1, 0, (void *)3);
+    ok(!bret, "RIOReceive succeeded\n");
+    ok(WSAGetLastError() == WSAENOBUFS, "got error %d\n", WSAGetLastError());
+
+    ret = rio.RIONotify(cq);
+    ok(!ret, "RIONotify returned %d\n", ret);
+    ret = rio.RIONotify(cq);
+    ok(ret == WSAEALREADY, "RIONotify returned %d\n", ret);
+
+    ret = send(peer, "world", 5, 0);
+    ok(ret == 5, "send returned %d\n", ret);
+    wait = WaitForSingleObject(event, 1000);
+    ok(!wait, "wait returned %u\n", wait);
+
+    memset(results, 0, sizeof(results));
+    count = rio.RIODequeueCompletion(cq, results, ARRAY_SIZE(results));
+    ok(count == 1, "got %u results\n", count);
+    ok(!results[0].Status, "got status %d\n", results[0].Status);
+    ok(results[0].BytesTransferred == 5, "got %u bytes\n", results[0].BytesTransferred);
+    ok(results[0].RequestContext == 2, "got request context %s\n",
+       wine_dbgstr_longlong(results[0].RequestContext));
+    ok(!memcmp(buffer + 16, "world", 5), "got unexpected data\n");
+
+    closesocket(s);
+    closesocket(peer);
+    rio.RIOCloseCompletionQueue(cq);
+    rio.RIODeregisterBuffer(id);
+    CloseHandle(event);
+}
+
 static void test_address_list_query(void)
 {
     SOCKET_ADDRESS_LIST *address_list;
@@ -11515,6 +11767,8 @@ START_TEST( sock )
     test_WSAAsyncGetServByName();
 
     test_completion_port();
+    test_completion_port_skip_on_success();
+    test_rio();
     test_address_list_query();
 
     /* this is an io heavy test, do it at the end so the kernel doesn't start dropping packets */
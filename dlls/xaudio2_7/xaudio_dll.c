@@ -46,6 +46,7 @@ static ALCboolean (ALC_APIENTRY *palcSetThreadContext)(ALCcontext*);
 static HINSTANCE instance;
 
 #define IN_AL_PERIODS 4
+#define MAX_WORKERS 3
 
 #if XAUDIO2_VER == 0
 #define COMPAT_E_INVALID_CALL E_INVALIDARG
@@ -60,6 +61,13 @@ static HINSTANCE instance;
         tag == WAVE_FORMAT_WMAUDIO3 || \
         tag == WAVE_FORMAT_WMAUDIO_LOSSLESS)
 
+static LONGLONG get_ticks(void)
+{
+    LARGE_INTEGER ticks;
+    QueryPerformanceCounter(&ticks);
+    return ticks.QuadPart;
+}
+
 static void dump_fmt(const WAVEFORMATEX *fmt)
 {
     TRACE("wFormatTag: 0x%x (", fmt->wFormatTag);
@@ -464,6 +472,7 @@ static void WINAPI XA2SRC_DestroyVoice(IXAudio2SourceVoice *iface)
     This->first_buf = 0;
     This->cur_buf = 0;
     This->abandoned_albufs = 0;
+    This->npending_cbs = 0;
 
 #if HAVE_FFMPEG
     if(This->conv_ctx){
@@ -1425,6 +1434,8 @@ static ULONG WINAPI IXAudio2Impl_AddRef(IXAudio2 *iface)
     return ref;
 }
 
+static void engine_stop_workers(IXAudio2Impl *This);
+
 static ULONG WINAPI IXAudio2Impl_Release(IXAudio2 *iface)
 {
     IXAudio2Impl *This = impl_from_IXAudio2(iface);
@@ -1444,8 +1455,11 @@ static ULONG WINAPI IXAudio2Impl_Release(IXAudio2 *iface)
             CloseHandle(This->engine);
         }
 
+        engine_stop_workers(This);
+
         LIST_FOR_EACH_ENTRY_SAFE(src, src2, &This->source_voices, XA2SourceImpl, entry){
             HeapFree(GetProcessHeap(), 0, src->sends);
+            HeapFree(GetProcessHeap(), 0, src->pending_cbs);
             IXAudio2SourceVoice_DestroyVoice(&src->IXAudio2SourceVoice_iface);
             src->lock.DebugInfo->Spare[0] = 0;
             DeleteCriticalSection(&src->lock);
@@ -2107,6 +2121,7 @@ exit:
 }
 
 static DWORD WINAPI engine_threadproc(void *arg);
+static void engine_start_workers(IXAudio2Impl *This);
 
 static HRESULT WINAPI IXAudio2Impl_StartEngine(IXAudio2 *iface)
 {
@@ -2116,8 +2131,10 @@ static HRESULT WINAPI IXAudio2Impl_StartEngine(IXAudio2 *iface)
 
     This->running = TRUE;
 
-    if(!This->engine)
+    if(!This->engine){
+        engine_start_workers(This);
         This->engine = CreateThread(NULL, 0, engine_threadproc, This, 0, NULL);
+    }
 
     return S_OK;
 }
@@ -2145,10 +2162,53 @@ static void WINAPI IXAudio2Impl_GetPerformanceData(IXAudio2 *iface,
         XAUDIO2_PERFORMANCE_DATA *pPerfData)
 {
     IXAudio2Impl *This = impl_from_IXAudio2(iface);
+    XA2SourceImpl *src;
+    XA2SubmixImpl *sub;
+    LONGLONG now;
+    UINT32 pad;
 
-    TRACE("(%p)->(%p): stub!\n", This, pPerfData);
+    TRACE("(%p)->(%p)\n", This, pPerfData);
 
     memset(pPerfData, 0, sizeof(*pPerfData));
+
+    EnterCriticalSection(&This->lock);
+
+    now = get_ticks();
+
+    /* Cycles are reported in performance counter ticks. The time spent
+     * on each voice is summed over all threads. */
+    pPerfData->AudioCyclesSinceLastQuery = This->audio_cycles;
+    pPerfData->TotalCyclesSinceLastQuery = now - This->last_query_time;
+    pPerfData->MinimumCyclesPerQuantum = This->min_cycles;
+    pPerfData->MaximumCyclesPerQuantum = This->max_cycles;
+
+    This->audio_cycles = 0;
+    This->last_query_time = now;
+    This->min_cycles = This->max_cycles = 0;
+
+    if(This->aclient && SUCCEEDED(IAudioClient_GetCurrentPadding(This->aclient, &pad)))
+        pPerfData->CurrentLatencyInSamples = pad;
+
+    LIST_FOR_EACH_ENTRY(src, &This->source_voices, XA2SourceImpl, entry){
+        EnterCriticalSection(&src->lock);
+        if(src->in_use){
+            ++pPerfData->TotalSourceVoiceCount;
+            if(src->running)
+                ++pPerfData->ActiveSourceVoiceCount;
+            TRACE("source voice %p: %s ticks\n", src, wine_dbgstr_longlong(src->cycles));
+        }
+        src->cycles = 0;
+        LeaveCriticalSection(&src->lock);
+    }
+
+    LIST_FOR_EACH_ENTRY(sub, &This->submix_voices, XA2SubmixImpl, entry){
+        EnterCriticalSection(&sub->lock);
+        if(sub->in_use)
+            ++pPerfData->ActiveSubmixVoiceCount;
+        LeaveCriticalSection(&sub->lock);
+    }
+
+    LeaveCriticalSection(&This->lock);
 }
 
 static void WINAPI IXAudio2Impl_SetDebugConfiguration(IXAudio2 *iface,
@@ -2335,6 +2395,7 @@ static HRESULT WINAPI XAudio2CF_CreateInstance(IClassFactory *iface, IUnknown *p
     list_init(&object->submix_voices);
 
     object->mmevt = CreateEventW(NULL, FALSE, FALSE, NULL);
+    object->last_query_time = get_ticks();
     InitializeCriticalSection(&object->lock);
     object->lock.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": IXAudio2Impl.lock");
 
@@ -2669,11 +2730,57 @@ static UINT32 get_underrun_warning(XA2SourceImpl *src)
  *
  * For corner cases and version differences, see tests.
  */
-static void update_source_state(XA2SourceImpl *src)
+static void defer_callback(XA2SourceImpl *src, int type, void *context)
+{
+    if(!src->cb)
+        return;
+
+    if(src->npending_cbs == src->pending_cbs_size){
+        UINT32 new_size = max(src->pending_cbs_size * 2, 8);
+        XA2PendingCallback *new_cbs;
+
+        if(src->pending_cbs)
+            new_cbs = HeapReAlloc(GetProcessHeap(), 0, src->pending_cbs, new_size * sizeof(*new_cbs));
+        else
+            new_cbs = HeapAlloc(GetProcessHeap(), 0, new_size * sizeof(*new_cbs));
+        if(!new_cbs){
+            ERR("Out of memory, dropping callback\n");
+            return;
+        }
+
+        src->pending_cbs = new_cbs;
+        src->pending_cbs_size = new_size;
+    }
+
+    src->pending_cbs[src->npending_cbs].type = type;
+    src->pending_cbs[src->npending_cbs].context = context;
+    src->npending_cbs++;
+}
+
+static void deliver_callbacks(XA2SourceImpl *src)
+{
+    UINT32 i;
+
+    for(i = 0; i < src->npending_cbs; ++i){
+        switch(src->pending_cbs[i].type){
+        case XA2_CB_BUFFER_START:
+            IXAudio2VoiceCallback_OnBufferStart(src->cb, src->pending_cbs[i].context);
+            break;
+        case XA2_CB_LOOP_END:
+            IXAudio2VoiceCallback_OnLoopEnd(src->cb, src->pending_cbs[i].context);
+            break;
+        }
+    }
+
+    src->npending_cbs = 0;
+}
+
+/* Returns the buffers AL has finished playing to the application. Runs on
+ * the engine thread, so callbacks are raised directly. */
+static void unqueue_source_buffers(XA2SourceImpl *src)
 {
     int i;
     ALint processed;
-    ALint bufpos;
 
     alGetSourcei(src->al_src, AL_BUFFERS_PROCESSED, &processed);
 
@@ -2724,6 +2831,18 @@ static void update_source_state(XA2SourceImpl *src)
             }
         }
     }
+}
+
+static BOOL source_has_data(XA2SourceImpl *src)
+{
+    return src->cur_buf != (src->first_buf + src->nbufs) % XAUDIO2_MAX_QUEUED_BUFFERS;
+}
+
+/* Feeds AL with the next periods of the application's buffers, decoding them
+ * if needed. This may run on a worker thread, so callbacks are deferred. */
+static void queue_source_periods(XA2SourceImpl *src)
+{
+    ALint bufpos;
 
     if(!src->running)
         return;
@@ -2731,13 +2850,13 @@ static void update_source_state(XA2SourceImpl *src)
     alGetSourcei(src->al_src, AL_BYTE_OFFSET, &bufpos);
 
     /* maintain IN_AL_PERIODS periods in AL */
-    while(src->cur_buf != (src->first_buf + src->nbufs) % XAUDIO2_MAX_QUEUED_BUFFERS &&
+    while(source_has_data(src) &&
             src->in_al_bytes - bufpos < IN_AL_PERIODS * src->xa2->period_frames * src->submit_blocksize){
         TRACE("%p: going to queue a period from buffer %u\n", src, src->cur_buf);
 
         /* starting from an empty buffer */
-        if(src->cb && src->cur_buf == src->first_buf && src->buffers[src->cur_buf].offs_bytes == 0 && !src->buffers[src->cur_buf].looped)
-            IXAudio2VoiceCallback_OnBufferStart(src->cb,
+        if(src->cur_buf == src->first_buf && src->buffers[src->cur_buf].offs_bytes == 0 && !src->buffers[src->cur_buf].looped)
+            defer_callback(src, XA2_CB_BUFFER_START,
                     src->buffers[src->first_buf].xa2buffer.pContext);
 
         if(!xa2buffer_queue_period(src, &src->buffers[src->cur_buf],
@@ -2756,9 +2875,8 @@ static void update_source_state(XA2SourceImpl *src)
                 else
                     cur->cur_end_bytes = cur->loop_end_bytes;
 
-                if(src->cb)
-                    IXAudio2VoiceCallback_OnLoopEnd(src->cb,
-                            src->buffers[src->cur_buf].xa2buffer.pContext);
+                defer_callback(src, XA2_CB_LOOP_END,
+                        src->buffers[src->cur_buf].xa2buffer.pContext);
 
             }else{
                 /* buffer is spent, move on */
@@ -2769,12 +2887,163 @@ static void update_source_state(XA2SourceImpl *src)
     }
 }
 
+static void process_work_queue(IXAudio2Impl *This)
+{
+    LONG i, cycles = 0;
+
+    palcSetThreadContext(This->al_ctx);
+
+    while((i = InterlockedIncrement(&This->work_next) - 1) < (LONG)This->nwork_srcs){
+        XA2SourceImpl *src = This->work_srcs[i];
+        LONGLONG start = get_ticks(), elapsed;
+
+        EnterCriticalSection(&src->lock);
+
+        if(src->in_use)
+            queue_source_periods(src);
+
+        elapsed = get_ticks() - start;
+        src->cycles += elapsed;
+        cycles += elapsed;
+
+        LeaveCriticalSection(&src->lock);
+    }
+
+    InterlockedExchangeAdd(&This->work_cycles, cycles);
+}
+
+static DWORD WINAPI engine_workerproc(void *arg)
+{
+    IXAudio2Impl *This = arg;
+
+    while(1){
+        WaitForSingleObject(This->work_sem, INFINITE);
+
+        if(This->stop_workers)
+            break;
+
+        process_work_queue(This);
+
+        if(!InterlockedDecrement(&This->work_active))
+            SetEvent(This->work_done);
+    }
+
+    return 0;
+}
+
+/* Queueing, and decoding, of independent source voices is shared between the
+ * engine thread and the workers. Voices are distributed one at a time, so a
+ * single expensive voice does not hold back the others. */
+static void run_work_queue(IXAudio2Impl *This)
+{
+    UINT32 nwake = 0;
+
+    if(This->nwork_srcs > 1)
+        nwake = min(This->nworkers, This->nwork_srcs - 1);
+
+    This->work_next = 0;
+    This->work_cycles = 0;
+    This->work_active = nwake;
+
+    if(nwake)
+        ReleaseSemaphore(This->work_sem, nwake, NULL);
+
+    process_work_queue(This);
+
+    /* wait for every woken worker, so none of them picks up the next quantum
+     * half way */
+    if(nwake)
+        WaitForSingleObject(This->work_done, INFINITE);
+}
+
+static BOOL add_work(IXAudio2Impl *This, XA2SourceImpl *src)
+{
+    if(This->nwork_srcs == This->work_srcs_size){
+        UINT32 new_size = max(This->work_srcs_size * 2, 16);
+        XA2SourceImpl **new_srcs;
+
+        if(This->work_srcs)
+            new_srcs = HeapReAlloc(GetProcessHeap(), 0, This->work_srcs, new_size * sizeof(*new_srcs));
+        else
+            new_srcs = HeapAlloc(GetProcessHeap(), 0, new_size * sizeof(*new_srcs));
+        if(!new_srcs)
+            return FALSE;
+
+        This->work_srcs = new_srcs;
+        This->work_srcs_size = new_size;
+    }
+
+    This->work_srcs[This->nwork_srcs++] = src;
+
+    return TRUE;
+}
+
+static void engine_start_workers(IXAudio2Impl *This)
+{
+    SYSTEM_INFO info;
+    UINT32 i;
+
+    GetSystemInfo(&info);
+
+    This->nworkers = min(info.dwNumberOfProcessors, MAX_WORKERS + 1) - 1;
+    if(!This->nworkers)
+        return;
+
+    This->workers = HeapAlloc(GetProcessHeap(), 0, This->nworkers * sizeof(*This->workers));
+    This->work_sem = CreateSemaphoreW(NULL, 0, This->nworkers, NULL);
+    This->work_done = CreateEventW(NULL, FALSE, FALSE, NULL);
+    if(!This->workers || !This->work_sem || !This->work_done){
+        WARN("Failed to set up worker threads\n");
+        engine_stop_workers(This);
+        return;
+    }
+
+    for(i = 0; i < This->nworkers; ++i){
+        This->workers[i] = CreateThread(NULL, 0, engine_workerproc, This, 0, NULL);
+        if(!This->workers[i]){
+            WARN("Failed to create worker thread\n");
+            This->nworkers = i;
+            break;
+        }
+    }
+
+    TRACE("%p: using %u worker threads\n", This, This->nworkers);
+}
+
+static void engine_stop_workers(IXAudio2Impl *This)
+{
+    UINT32 i;
+
+    if(This->nworkers && This->work_sem){
+        This->stop_workers = TRUE;
+        ReleaseSemaphore(This->work_sem, This->nworkers, NULL);
+        for(i = 0; i < This->nworkers; ++i){
+            WaitForSingleObject(This->workers[i], INFINITE);
+            CloseHandle(This->workers[i]);
+        }
+    }
+
+    HeapFree(GetProcessHeap(), 0, This->workers);
+    This->workers = NULL;
+    This->nworkers = 0;
+    if(This->work_sem)
+        CloseHandle(This->work_sem);
+    This->work_sem = NULL;
+    if(This->work_done)
+        CloseHandle(This->work_done);
+    This->work_done = NULL;
+    HeapFree(GetProcessHeap(), 0, This->work_srcs);
+    This->work_srcs = NULL;
+    This->nwork_srcs = This->work_srcs_size = 0;
+}
+
 static void do_engine_tick(IXAudio2Impl *This)
 {
     BYTE *buf;
     XA2SourceImpl *src;
     HRESULT hr;
     UINT32 nframes, i, pad;
+    LONGLONG start, elapsed, cycles = 0;
 
     /* maintain up to 3 periods in mmdevapi */
     hr = IAudioClient_GetCurrentPadding(This->aclient, &pad);
@@ -2796,16 +3065,41 @@ static void do_engine_tick(IXAudio2Impl *This)
     for(i = 0; i < This->ncbs && This->cbs[i]; ++i)
         IXAudio2EngineCallback_OnProcessingPassStart(This->cbs[i]);
 
+    /* queue the next periods of all voices first, so the per-voice work can
+     * run in parallel while the callbacks below still come from this thread
+     * in voice order */
+    This->nwork_srcs = 0;
+
+    LIST_FOR_EACH_ENTRY(src, &This->source_voices, XA2SourceImpl, entry){
+        EnterCriticalSection(&src->lock);
+
+        if(src->in_use && src->running && source_has_data(src) && !add_work(This, src)){
+            start = get_ticks();
+            queue_source_periods(src);
+            elapsed = get_ticks() - start;
+            src->cycles += elapsed;
+            cycles += elapsed;
+        }
+
+        LeaveCriticalSection(&src->lock);
+    }
+
+    run_work_queue(This);
+    cycles += This->work_cycles;
+
     LIST_FOR_EACH_ENTRY(src, &This->source_voices, XA2SourceImpl, entry){
         ALint st = 0;
 
         EnterCriticalSection(&src->lock);
 
         if(!src->in_use){
+            src->npending_cbs = 0;
             LeaveCriticalSection(&src->lock);
             continue;
         }
 
+        start = get_ticks();
+
         if(src->cb && This->running){
 #if XAUDIO2_VER == 0
             IXAudio20VoiceCallback_OnVoiceProcessingPassStart((IXAudio20VoiceCallback*)src->cb);
@@ -2818,7 +3112,9 @@ static void do_engine_tick(IXAudio2Impl *This)
 #endif
         }
 
-        update_source_state(src);
+        unqueue_source_buffers(src);
+
+        deliver_callbacks(src);
 
         if(This->running){
             alGetSourcei(src->al_src, AL_SOURCE_STATE, &st);
@@ -2829,9 +3125,15 @@ static void do_engine_tick(IXAudio2Impl *This)
                 IXAudio2VoiceCallback_OnVoiceProcessingPassEnd(src->cb);
         }
 
+        elapsed = get_ticks() - start;
+        src->cycles += elapsed;
+        cycles += elapsed;
+
         LeaveCriticalSection(&src->lock);
     }
 
+    start = get_ticks();
+
     hr = IAudioRenderClient_GetBuffer(This->render, nframes, &buf);
     if(FAILED(hr))
         WARN("GetBuffer failed: %08x\n", hr);
@@ -2842,6 +3144,14 @@ static void do_engine_tick(IXAudio2Impl *This)
     if(FAILED(hr))
         WARN("ReleaseBuffer failed: %08x\n", hr);
 
+    cycles += get_ticks() - start;
+
+    This->audio_cycles += cycles;
+    if(!This->min_cycles || cycles < This->min_cycles)
+        This->min_cycles = (UINT32)cycles;
+    if(cycles > This->max_cycles)
+        This->max_cycles = (UINT32)cycles;
+
     for(i = 0; i < This->ncbs && This->cbs[i]; ++i)
         IXAudio2EngineCallback_OnProcessingPassEnd(This->cbs[i]);
 }
@@ -45,6 +45,16 @@ typedef struct _XA2Buffer {
 
 typedef struct _IXAudio2Impl IXAudio2Impl;
 
+/* voice callbacks raised while queueing data on a worker thread, delivered
+ * later from the engine thread */
+typedef struct _XA2PendingCallback {
+    enum {
+        XA2_CB_BUFFER_START,
+        XA2_CB_LOOP_END
+    } type;
+    void *context;
+} XA2PendingCallback;
+
 typedef struct _XA2SourceImpl {
     IXAudio2SourceVoice IXAudio2SourceVoice_iface;
 
@@ -92,6 +102,13 @@ typedef struct _XA2SourceImpl {
     AVFrame *conv_frame;
 #endif
 
+    XA2PendingCallback *pending_cbs;
+    UINT32 npending_cbs, pending_cbs_size;
+
+    /* performance counter ticks spent processing this voice since the last
+     * GetPerformanceData call */
+    UINT64 cycles;
+
     struct list entry;
 } XA2SourceImpl;
 
@@ -166,6 +183,18 @@ struct _IXAudio2Impl {
     IXAudio2EngineCallback **cbs;
 
     BOOL running;
+
+    /* worker threads sharing the per-voice work of each quantum */
+    UINT32 nworkers;
+    HANDLE *workers, work_sem, work_done;
+    BOOL stop_workers;
+    XA2SourceImpl **work_srcs;
+    UINT32 nwork_srcs, work_srcs_size;
+    LONG work_next, work_active, work_cycles;
+
+    /* performance data, in performance counter ticks */
+    UINT64 audio_cycles, last_query_time;
+    UINT32 min_cycles, max_cycles;
 };
 
 #if XAUDIO2_VER == 0
@@ -71,6 +71,13 @@ struct hid_platform_private {
     BYTE current_report;
     CHAR *reports[2];
 
+    /* background thread reading the input reports as they arrive */
+    HANDLE read_device;
+    HANDLE read_thread;
+    HANDLE stop_event;
+    HMODULE module;
+    BOOL disconnected;
+
     LONG ThumbLXRange[3];
     LONG ThumbLYRange[3];
     LONG LeftTriggerRange[3];
@@ -81,6 +88,8 @@ struct hid_platform_private {
 
 static DWORD last_check = 0;
 
+static void start_read_thread(xinput_controller *device);
+
 static void MarkUsage(struct hid_platform_private *private, WORD usage, LONG min, LONG max, USHORT bits)
 {
     switch (usage)
@@ -287,6 +296,8 @@ void HID_find_gamepads(xinput_controller *devices)
                 devices[didx].connected = TRUE;
                 build_private(private, ppd, &Caps, device, data->DevicePath);
                 devices[didx].platform_private = private;
+                HID_update_state(&devices[didx], NULL);
+                start_read_thread(&devices[didx]);
                 didx++;
             }
             else
@@ -309,12 +320,27 @@ void HID_find_gamepads(xinput_controller *devices)
     return;
 }
 
+static void stop_read_thread(struct hid_platform_private *private)
+{
+    if (!private->read_thread) return;
+
+    SetEvent(private->stop_event);
+    WaitForSingleObject(private->read_thread, INFINITE);
+    CloseHandle(private->read_thread);
+    CloseHandle(private->stop_event);
+    CloseHandle(private->read_device);
+    private->read_thread = NULL;
+}
+
 static void remove_gamepad(xinput_controller *device)
 {
     if (device->connected)
     {
         struct hid_platform_private *private = device->platform_private;
 
+        /* the thread takes the device lock, stop it before acquiring it */
+        stop_read_thread(private);
+
         EnterCriticalSection(&private->crit);
         CloseHandle(private->device);
         HeapFree(GetProcessHeap(), 0, private->reports[0]);
@@ -342,7 +368,8 @@ void HID_destroy_gamepads(xinput_controller *devices)
 #define SCALE_SHORT(v,r) (SHORT)((((0xffff)*(SIGN(v,r[1]) - r[0]))/r[2])-32767)
 #define SCALE_BYTE(v,r) (BYTE)((((0xff)*(SIGN(v,r[1]) - r[0]))/r[2]))
 
-void HID_update_state(xinput_controller* device)
+/* update the state from the report in the target buffer; called with the device lock held */
+static void process_report(xinput_controller *device)
 {
     struct hid_platform_private *private = device->platform_private;
     int i;
@@ -353,24 +380,8 @@ void HID_update_state(xinput_controller* device)
     ULONG button_length;
     ULONG value;
 
-    if (!private->enabled)
-        return;
-
-    EnterCriticalSection(&private->crit);
-    if (!HidD_GetInputReport(private->device, target_report, private->report_length))
-    {
-        if (GetLastError() == ERROR_ACCESS_DENIED || GetLastError() == ERROR_INVALID_HANDLE)
-            remove_gamepad(device);
-        else
-            ERR("Failed to get Input Report (%x)\n", GetLastError());
-        LeaveCriticalSection(&private->crit);
-        return;
-    }
     if (memcmp(report, target_report, private->report_length) == 0)
-    {
-        LeaveCriticalSection(&private->crit);
         return;
-    }
 
     private->current_report = (private->current_report+1)%2;
 
@@ -419,7 +430,124 @@ void HID_update_state(xinput_controller* device)
 
     HidP_GetUsageValue(HidP_Input, HID_USAGE_PAGE_GENERIC, 0, HID_USAGE_GENERIC_Z, &value, private->ppd, target_report, private->report_length);
     device->state.Gamepad.bLeftTrigger = SCALE_BYTE(value, private->LeftTriggerRange);
+}
+
+static DWORD WINAPI read_thread_proc(void *param)
+{
+    xinput_controller *device = param;
+    struct hid_platform_private *private = device->platform_private;
+    HMODULE module = private->module;
+    HANDLE events[2];
+    OVERLAPPED ovl;
+    CHAR *buffer;
+    DWORD size;
+
+    TRACE("starting for %s\n", debugstr_w(private->device_path));
+
+    memset(&ovl, 0, sizeof(ovl));
+    ovl.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    events[0] = private->stop_event;
+    events[1] = ovl.hEvent;
+    buffer = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, private->report_length);
+
+    while (ovl.hEvent && buffer)
+    {
+        if (!ReadFile(private->read_device, buffer, private->report_length, &size, &ovl) &&
+            GetLastError() != ERROR_IO_PENDING)
+        {
+            WARN("Failed to read report (%u)\n", GetLastError());
+            private->disconnected = TRUE;
+            break;
+        }
+        if (WaitForMultipleObjects(2, events, FALSE, INFINITE) != WAIT_OBJECT_0 + 1)
+        {
+            CancelIoEx(private->read_device, &ovl);
+            GetOverlappedResult(private->read_device, &ovl, &size, TRUE);
+            break;
+        }
+        if (!GetOverlappedResult(private->read_device, &ovl, &size, FALSE))
+        {
+            WARN("Failed to read report (%u)\n", GetLastError());
+            private->disconnected = TRUE;
+            break;
+        }
+
+        EnterCriticalSection(&private->crit);
+        if (private->enabled)
+        {
+            memcpy(private->reports[(private->current_report+1)%2], buffer, private->report_length);
+            process_report(device);
+        }
+        LeaveCriticalSection(&private->crit);
+    }
+
+    HeapFree(GetProcessHeap(), 0, buffer);
+    if (ovl.hEvent) CloseHandle(ovl.hEvent);
+    TRACE("exiting\n");
+    FreeLibraryAndExitThread(module, 0);
+}
+
+static void start_read_thread(xinput_controller *device)
+{
+    struct hid_platform_private *private = device->platform_private;
+
+    private->read_device = CreateFileW(private->device_path, GENERIC_READ, FILE_SHARE_READ|FILE_SHARE_WRITE,
+                                       NULL, OPEN_EXISTING, FILE_FLAG_OVERLAPPED, 0);
+    if (private->read_device == INVALID_HANDLE_VALUE)
+    {
+        WARN("Failed to open %s for reading, polling instead\n", debugstr_w(private->device_path));
+        return;
+    }
+
+    /* the thread keeps the module loaded until it exits */
+    GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS, (const WCHAR *)read_thread_proc, &private->module);
+    if (!(private->stop_event = CreateEventW(NULL, TRUE, FALSE, NULL)) ||
+        !(private->read_thread = CreateThread(NULL, 0, read_thread_proc, device, 0, NULL)))
+    {
+        WARN("Failed to start read thread, polling instead\n");
+        if (private->stop_event) CloseHandle(private->stop_event);
+        CloseHandle(private->read_device);
+        FreeLibrary(private->module);
+    }
+}
+
+void HID_update_state(xinput_controller* device, XINPUT_STATE *state)
+{
+    struct hid_platform_private *private = device->platform_private;
+    CHAR *target_report = private->reports[(private->current_report+1)%2];
+
+    if (!private->enabled)
+        goto done;
+
+    /* the read thread keeps the state up to date */
+    if (private->read_thread)
+    {
+        if (private->disconnected)
+        {
+            remove_gamepad(device);
+            goto done;
+        }
+        EnterCriticalSection(&private->crit);
+        if (state) memcpy(state, &device->state, sizeof(*state));
+        LeaveCriticalSection(&private->crit);
+        return;
+    }
+
+    EnterCriticalSection(&private->crit);
+    if (!HidD_GetInputReport(private->device, target_report, private->report_length))
+    {
+        if (GetLastError() == ERROR_ACCESS_DENIED || GetLastError() == ERROR_INVALID_HANDLE)
+            remove_gamepad(device);
+        else
+            ERR("Failed to get Input Report (%x)\n", GetLastError());
+        LeaveCriticalSection(&private->crit);
+        goto done;
+    }
+    process_report(device);
     LeaveCriticalSection(&private->crit);
+
+done:
+    if (state) memcpy(state, &device->state, sizeof(*state));
 }
 
 DWORD HID_set_state(xinput_controller* device, XINPUT_VIBRATION* state)
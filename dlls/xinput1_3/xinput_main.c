@@ -112,8 +112,7 @@ DWORD WINAPI DECLSPEC_HOTPATCH XInputGetStateEx(DWORD index, XINPUT_STATE* state
     if (!controllers[index].connected)
         return ERROR_DEVICE_NOT_CONNECTED;
 
-    HID_update_state(&controllers[index]);
-    memcpy(state, &controllers[index].state, sizeof(XINPUT_STATE));
+    HID_update_state(&controllers[index], state);
 
     return ERROR_SUCCESS;
 }
@@ -65,6 +65,8 @@
 #define MF_E_INVALID_POSITION               _HRESULT_TYPEDEF_(0xc00d36e5)
 #define MF_E_ATTRIBUTENOTFOUND              _HRESULT_TYPEDEF_(0xc00d36e6)
 #define MF_E_PROPERTY_TYPE_NOT_ALLOWED      _HRESULT_TYPEDEF_(0xc00d36e7)
+#define MF_E_INVALID_WORKQUEUE              _HRESULT_TYPEDEF_(0xc00d36ff)
+#define MF_E_SHUTDOWN                       _HRESULT_TYPEDEF_(0xc00d3e85)
 
 #define MF_E_TOPO_INVALID_OPTIONAL_NODE             _HRESULT_TYPEDEF_(0xc00d520e)
 #define MF_E_TOPO_CANNOT_FIND_DECRYPTOR             _HRESULT_TYPEDEF_(0xc00d5211)
@@ -55,6 +55,18 @@ extern int CDECL wine_server_fd_to_handle( int fd, unsigned int access, unsigned
 extern int CDECL wine_server_handle_to_fd( HANDLE handle, unsigned int access, int *unix_fd, unsigned int *options );
 extern void CDECL wine_server_release_fd( HANDLE handle, int unix_fd );
 
+/* header of the data sent by CreateProcess to a pre-started process stub */
+struct process_stub_info
+{
+    unsigned int flags;    /* PROCESS_STUB_* flags */
+    unsigned int nb_fds;   /* number of file descriptors that follow */
+    unsigned int argc;     /* number of arguments after the current directory */
+    unsigned int size;     /* size of the strings that follow the file descriptors */
+};
+
+#define PROCESS_STUB_DETACH  0x01  /* detach from the console and process group */
+#define PROCESS_STUB_SERVER  (-1)  /* target of the server socket file descriptor */
+
 /* do a server call and set the last error code */
 static inline unsigned int wine_server_call_err( void *req_ptr )
 {
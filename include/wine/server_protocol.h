@@ -334,6 +334,44 @@ typedef union
     } hw;
 } hw_input_t;
 
+typedef struct
+{
+    user_handle_t   win;
+    int             __pad;
+    hw_input_t      input;
+} hw_input_entry_t;
+
+/* process information returned by list_processes, followed by the exe name
+ * padded to a multiple of 8 bytes and by the process threads */
+typedef struct
+{
+    timeout_t       start_time;
+    timeout_t       user_time;
+    timeout_t       kernel_time;
+    mem_size_t      peak_virtual_size;
+    mem_size_t      virtual_size;
+    mem_size_t      peak_working_set_size;
+    mem_size_t      working_set_size;
+    mem_size_t      pagefile_usage;
+    process_id_t    pid;
+    process_id_t    parent_pid;
+    int             unix_pid;
+    int             priority;
+    int             handle_count;
+    int             thread_count;
+    data_size_t     name_len;
+    int             __pad;
+} process_info_t;
+
+typedef struct
+{
+    timeout_t       start_time;
+    thread_id_t     tid;
+    int             base_priority;
+    int             current_priority;
+    int             unix_tid;
+} thread_info_t;
+
 typedef union
 {
     unsigned char            bytes[1];
@@ -343,6 +381,35 @@ typedef union
 } message_data_t;
 
 
+typedef struct
+{
+    unsigned int   wake_bits;
+    unsigned int   changed_bits;
+    unsigned int   hook_chains;
+} queue_shm_t;
+
+
+typedef struct
+{
+    unsigned int   seq;
+    user_handle_t  handle;
+    mod_handle_t   instance;
+    lparam_t       user_data;
+    user_handle_t  parent;
+    user_handle_t  owner;
+    process_id_t   pid;
+    thread_id_t    tid;
+    unsigned int   style;
+    unsigned int   ex_style;
+    unsigned int   id;
+    int            __pad;
+    rectangle_t    window;
+    rectangle_t    client;
+} window_shm_t;
+
+#define WINDOW_SHM_ENTRIES ((LAST_USER_HANDLE - FIRST_USER_HANDLE + 1) >> 1)
+
+
 typedef struct
 {
     WCHAR          ch;
@@ -363,6 +430,16 @@ typedef struct
     int          high_part;
 } luid_t;
 
+
+typedef struct
+{
+    apc_param_t   ckey;
+    apc_param_t   cvalue;
+    apc_param_t   information;
+    unsigned int  status;
+    int           __pad;
+} completion_msg_t;
+
 #define MAX_ACL_LEN 65535
 
 struct security_descriptor
@@ -478,6 +555,7 @@ typedef union
         mem_size_t       size;
         unsigned int     zero_bits;
         unsigned int     prot;
+        unsigned int     node;
     } virtual_alloc;
     struct
     {
@@ -977,16 +1055,19 @@ struct set_thread_info_request
     affinity_t   affinity;
     client_ptr_t entry_point;
     obj_handle_t token;
-    char __pad_44[4];
+    int          ideal_processor;
 };
 struct set_thread_info_reply
 {
     struct reply_header __header;
+    int          prev_ideal;
+    char __pad_12[4];
 };
 #define SET_THREAD_INFO_PRIORITY   0x01
 #define SET_THREAD_INFO_AFFINITY   0x02
 #define SET_THREAD_INFO_TOKEN      0x04
 #define SET_THREAD_INFO_ENTRYPOINT 0x08
+#define SET_THREAD_INFO_IDEAL      0x10
 
 
 
@@ -1499,6 +1580,8 @@ struct get_handle_fd_reply
     int          cacheable;
     unsigned int access;
     unsigned int options;
+    unsigned int comp_flags;
+    char __pad_28[4];
 };
 enum server_fd_type
 {
@@ -2255,7 +2338,9 @@ struct get_mapping_info_reply
     mem_size_t   size;
     unsigned int flags;
     obj_handle_t shared_file;
+    obj_handle_t copy_file;
     /* VARARG(image,pe_image_info); */
+    char __pad_28[4];
 };
 
 
@@ -2354,6 +2439,21 @@ struct create_snapshot_reply
 
 
 
+struct list_processes_request
+{
+    struct request_header __header;
+    char __pad_12[4];
+};
+struct list_processes_reply
+{
+    struct reply_header __header;
+    data_size_t     info_size;
+    int             process_count;
+    /* VARARG(data,process_info,info_size); */
+};
+
+
+
 struct next_process_request
 {
     struct request_header __header;
@@ -2517,6 +2617,22 @@ struct read_process_memory_reply
 
 
 
+struct get_process_vm_pid_request
+{
+    struct request_header __header;
+    obj_handle_t handle;
+    unsigned int access;
+    char __pad_20[4];
+};
+struct get_process_vm_pid_reply
+{
+    struct reply_header __header;
+    int          unix_pid;
+    char __pad_12[4];
+};
+
+
+
 struct write_process_memory_request
 {
     struct request_header __header;
@@ -2734,6 +2850,18 @@ struct set_registry_notification_reply
 
 
 
+struct get_registry_generation_request
+{
+    struct request_header __header;
+    char __pad_12[4];
+};
+struct get_registry_generation_reply
+{
+    struct reply_header __header;
+};
+
+
+
 struct create_timer_request
 {
     struct request_header __header;
@@ -2956,6 +3084,18 @@ struct empty_atom_table_reply
 
 
 
+struct get_atom_generation_request
+{
+    struct request_header __header;
+    char __pad_12[4];
+};
+struct get_atom_generation_reply
+{
+    struct reply_header __header;
+};
+
+
+
 struct init_atom_table_request
 {
     struct request_header __header;
@@ -3026,6 +3166,20 @@ struct get_queue_status_reply
 
 
 
+struct get_queue_shm_request
+{
+    struct request_header __header;
+    char __pad_12[4];
+};
+struct get_queue_shm_reply
+{
+    struct reply_header __header;
+    obj_handle_t handle;
+    char __pad_12[4];
+};
+
+
+
 struct get_process_idle_event_request
 {
     struct request_header __header;
@@ -3051,7 +3205,9 @@ struct send_message_request
     lparam_t        wparam;
     lparam_t        lparam;
     timeout_t       timeout;
+    unsigned int    wake_mask;
     /* VARARG(data,message_data); */
+    char __pad_60[4];
 };
 struct send_message_reply
 {
@@ -3108,6 +3264,26 @@ struct send_hardware_message_reply
 
 
 
+struct send_hardware_messages_request
+{
+    struct request_header __header;
+    unsigned int    flags;
+    /* VARARG(inputs,hw_inputs); */
+};
+struct send_hardware_messages_reply
+{
+    struct reply_header __header;
+    unsigned int    count;
+    int             wait;
+    int             prev_x;
+    int             prev_y;
+    int             new_x;
+    int             new_y;
+    /* VARARG(keystate,bytes); */
+};
+
+
+
 struct get_message_request
 {
     struct request_header __header;
@@ -3118,6 +3294,10 @@ struct get_message_request
     unsigned int    hw_id;
     unsigned int    wake_mask;
     unsigned int    changed_mask;
+    int             reply;
+    char __pad_44[4];
+    lparam_t        result;
+    /* VARARG(reply_data,bytes); */
 };
 struct get_message_reply
 {
@@ -3517,6 +3697,20 @@ struct get_window_info_reply
 
 
 
+struct get_window_shm_request
+{
+    struct request_header __header;
+    char __pad_12[4];
+};
+struct get_window_shm_reply
+{
+    struct reply_header __header;
+    obj_handle_t   handle;
+    char __pad_12[4];
+};
+
+
+
 struct set_window_info_request
 {
     struct request_header __header;
@@ -5196,6 +5390,10 @@ struct get_next_device_request_request
     obj_handle_t manager;
     obj_handle_t prev;
     unsigned int status;
+    data_size_t  result;
+    char __pad_28[4];
+    client_ptr_t file_ptr;
+    /* VARARG(prev_data,bytes); */
 };
 struct get_next_device_request_reply
 {
@@ -5312,6 +5510,21 @@ struct remove_completion_reply
 
 
 
+struct remove_completions_request
+{
+    struct request_header __header;
+    obj_handle_t handle;
+};
+struct remove_completions_reply
+{
+    struct reply_header __header;
+    unsigned int  count;
+    /* VARARG(msgs,completion_msgs); */
+    char __pad_12[4];
+};
+
+
+
 struct query_completion_request
 {
     struct request_header __header;
@@ -5348,7 +5561,7 @@ struct add_fd_completion_request
     apc_param_t    cvalue;
     apc_param_t    information;
     unsigned int   status;
-    char __pad_36[4];
+    int            async;
 };
 struct add_fd_completion_reply
 {
@@ -5357,6 +5570,22 @@ struct add_fd_completion_reply
 
 
 
+struct set_fd_completion_mode_request
+{
+    struct request_header __header;
+    obj_handle_t   handle;
+    unsigned int   flags;
+    char __pad_20[4];
+};
+struct set_fd_completion_mode_reply
+{
+    struct reply_header __header;
+    unsigned int   flags;
+    char __pad_12[4];
+};
+
+
+
 struct set_fd_disp_info_request
 {
     struct request_header __header;
@@ -5787,6 +6016,7 @@ enum request
     REQ_add_mapping_committed_range,
     REQ_is_same_mapping,
     REQ_create_snapshot,
+    REQ_list_processes,
     REQ_next_process,
     REQ_next_thread,
     REQ_wait_debug_event,
@@ -5797,6 +6027,7 @@ enum request
     REQ_debug_break,
     REQ_set_debugger_kill_on_exit,
     REQ_read_process_memory,
+    REQ_get_process_vm_pid,
     REQ_write_process_memory,
     REQ_create_key,
     REQ_open_key,
@@ -5811,6 +6042,7 @@ enum request
     REQ_unload_registry,
     REQ_save_registry,
     REQ_set_registry_notification,
+    REQ_get_registry_generation,
     REQ_create_timer,
     REQ_open_timer,
     REQ_set_timer,
@@ -5825,15 +6057,18 @@ enum request
     REQ_get_atom_information,
     REQ_set_atom_information,
     REQ_empty_atom_table,
+    REQ_get_atom_generation,
     REQ_init_atom_table,
     REQ_get_msg_queue,
     REQ_set_queue_fd,
     REQ_set_queue_mask,
     REQ_get_queue_status,
+    REQ_get_queue_shm,
     REQ_get_process_idle_event,
     REQ_send_message,
     REQ_post_quit_message,
     REQ_send_hardware_message,
+    REQ_send_hardware_messages,
     REQ_get_message,
     REQ_reply_message,
     REQ_accept_hardware_message,
@@ -5858,6 +6093,7 @@ enum request
     REQ_get_desktop_window,
     REQ_set_window_owner,
     REQ_get_window_info,
+    REQ_get_window_shm,
     REQ_set_window_info,
     REQ_set_parent,
     REQ_get_window_parents,
@@ -5964,9 +6200,11 @@ enum request
     REQ_open_completion,
     REQ_add_completion,
     REQ_remove_completion,
+    REQ_remove_completions,
     REQ_query_completion,
     REQ_set_completion_info,
     REQ_add_fd_completion,
+    REQ_set_fd_completion_mode,
     REQ_set_fd_disp_info,
     REQ_set_fd_name_info,
     REQ_get_window_layered_info,
@@ -6087,6 +6325,7 @@ union generic_request
     struct add_mapping_committed_range_request add_mapping_committed_range_request;
     struct is_same_mapping_request is_same_mapping_request;
     struct create_snapshot_request create_snapshot_request;
+    struct list_processes_request list_processes_request;
     struct next_process_request next_process_request;
     struct next_thread_request next_thread_request;
     struct wait_debug_event_request wait_debug_event_request;
@@ -6097,6 +6336,7 @@ union generic_request
     struct debug_break_request debug_break_request;
     struct set_debugger_kill_on_exit_request set_debugger_kill_on_exit_request;
     struct read_process_memory_request read_process_memory_request;
+    struct get_process_vm_pid_request get_process_vm_pid_request;
     struct write_process_memory_request write_process_memory_request;
     struct create_key_request create_key_request;
     struct open_key_request open_key_request;
@@ -6111,6 +6351,7 @@ union generic_request
     struct unload_registry_request unload_registry_request;
     struct save_registry_request save_registry_request;
     struct set_registry_notification_request set_registry_notification_request;
+    struct get_registry_generation_request get_registry_generation_request;
     struct create_timer_request create_timer_request;
     struct open_timer_request open_timer_request;
     struct set_timer_request set_timer_request;
@@ -6125,15 +6366,18 @@ union generic_request
     struct get_atom_information_request get_atom_information_request;
     struct set_atom_information_request set_atom_information_request;
     struct empty_atom_table_request empty_atom_table_request;
+    struct get_atom_generation_request get_atom_generation_request;
     struct init_atom_table_request init_atom_table_request;
     struct get_msg_queue_request get_msg_queue_request;
     struct set_queue_fd_request set_queue_fd_request;
     struct set_queue_mask_request set_queue_mask_request;
     struct get_queue_status_request get_queue_status_request;
+    struct get_queue_shm_request get_queue_shm_request;
     struct get_process_idle_event_request get_process_idle_event_request;
     struct send_message_request send_message_request;
     struct post_quit_message_request post_quit_message_request;
     struct send_hardware_message_request send_hardware_message_request;
+    struct send_hardware_messages_request send_hardware_messages_request;
     struct get_message_request get_message_request;
     struct reply_message_request reply_message_request;
     struct accept_hardware_message_request accept_hardware_message_request;
@@ -6158,6 +6402,7 @@ union generic_request
     struct get_desktop_window_request get_desktop_window_request;
     struct set_window_owner_request set_window_owner_request;
     struct get_window_info_request get_window_info_request;
+    struct get_window_shm_request get_window_shm_request;
     struct set_window_info_request set_window_info_request;
     struct set_parent_request set_parent_request;
     struct get_window_parents_request get_window_parents_request;
@@ -6264,9 +6509,11 @@ union generic_request
     struct open_completion_request open_completion_request;
     struct add_completion_request add_completion_request;
     struct remove_completion_request remove_completion_request;
+    struct remove_completions_request remove_completions_request;
     struct query_completion_request query_completion_request;
     struct set_completion_info_request set_completion_info_request;
     struct add_fd_completion_request add_fd_completion_request;
+    struct set_fd_completion_mode_request set_fd_completion_mode_request;
     struct set_fd_disp_info_request set_fd_disp_info_request;
     struct set_fd_name_info_request set_fd_name_info_request;
     struct get_window_layered_info_request get_window_layered_info_request;
@@ -6385,6 +6632,7 @@ union generic_reply
     struct add_mapping_committed_range_reply add_mapping_committed_range_reply;
     struct is_same_mapping_reply is_same_mapping_reply;
     struct create_snapshot_reply create_snapshot_reply;
+    struct list_processes_reply list_processes_reply;
     struct next_process_reply next_process_reply;
     struct next_thread_reply next_thread_reply;
     struct wait_debug_event_reply wait_debug_event_reply;
@@ -6395,6 +6643,7 @@ union generic_reply
     struct debug_break_reply debug_break_reply;
     struct set_debugger_kill_on_exit_reply set_debugger_kill_on_exit_reply;
     struct read_process_memory_reply read_process_memory_reply;
+    struct get_process_vm_pid_reply get_process_vm_pid_reply;
     struct write_process_memory_reply write_process_memory_reply;
     struct create_key_reply create_key_reply;
     struct open_key_reply open_key_reply;
@@ -6409,6 +6658,7 @@ union generic_reply
     struct unload_registry_reply unload_registry_reply;
     struct save_registry_reply save_registry_reply;
     struct set_registry_notification_reply set_registry_notification_reply;
+    struct get_registry_generation_reply get_registry_generation_reply;
     struct create_timer_reply create_timer_reply;
     struct open_timer_reply open_timer_reply;
     struct set_timer_reply set_timer_reply;
@@ -6423,15 +6673,18 @@ union generic_reply
     struct get_atom_information_reply get_atom_information_reply;
     struct set_atom_information_reply set_atom_information_reply;
     struct empty_atom_table_reply empty_atom_table_reply;
+    struct get_atom_generation_reply get_atom_generation_reply;
     struct init_atom_table_reply init_atom_table_reply;
     struct get_msg_queue_reply get_msg_queue_reply;
     struct set_queue_fd_reply set_queue_fd_reply;
     struct set_queue_mask_reply set_queue_mask_reply;
     struct get_queue_status_reply get_queue_status_reply;
+    struct get_queue_shm_reply get_queue_shm_reply;
     struct get_process_idle_event_reply get_process_idle_event_reply;
     struct send_message_reply send_message_reply;
     struct post_quit_message_reply post_quit_message_reply;
     struct send_hardware_message_reply send_hardware_message_reply;
+    struct send_hardware_messages_reply send_hardware_messages_reply;
     struct get_message_reply get_message_reply;
     struct reply_message_reply reply_message_reply;
     struct accept_hardware_message_reply accept_hardware_message_reply;
@@ -6456,6 +6709,7 @@ union generic_reply
     struct get_desktop_window_reply get_desktop_window_reply;
     struct set_window_owner_reply set_window_owner_reply;
     struct get_window_info_reply get_window_info_reply;
+    struct get_window_shm_reply get_window_shm_reply;
     struct set_window_info_reply set_window_info_reply;
     struct set_parent_reply set_parent_reply;
     struct get_window_parents_reply get_window_parents_reply;
@@ -6562,9 +6816,11 @@ union generic_reply
     struct open_completion_reply open_completion_reply;
     struct add_completion_reply add_completion_reply;
     struct remove_completion_reply remove_completion_reply;
+    struct remove_completions_reply remove_completions_reply;
     struct query_completion_reply query_completion_reply;
     struct set_completion_info_reply set_completion_info_reply;
     struct add_fd_completion_reply add_fd_completion_reply;
+    struct set_fd_completion_mode_reply set_fd_completion_mode_reply;
     struct set_fd_disp_info_reply set_fd_disp_info_reply;
     struct set_fd_name_info_reply set_fd_name_info_reply;
     struct get_window_layered_info_reply get_window_layered_info_reply;
@@ -6588,6 +6844,6 @@ union generic_reply
     struct get_esync_apc_fd_reply get_esync_apc_fd_reply;
 };
 
-#define SERVER_PROTOCOL_VERSION 557
+#define SERVER_PROTOCOL_VERSION 573
 
 #endif /* __WINE_WINE_SERVER_PROTOCOL_H */
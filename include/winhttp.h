@@ -141,7 +141,9 @@ typedef int INTERNET_SCHEME, *LPINTERNET_SCHEME;
 #define WINHTTP_OPTION_UNLOAD_NOTIFY_EVENT           99
 #define WINHTTP_OPTION_REJECT_USERPWD_IN_URL         100
 #define WINHTTP_OPTION_USE_GLOBAL_SERVER_CREDENTIALS 101
-#define WINHTTP_LAST_OPTION                          WINHTTP_OPTION_USE_GLOBAL_SERVER_CREDENTIALS
+#define WINHTTP_OPTION_ENABLE_HTTP_PROTOCOL          133
+#define WINHTTP_OPTION_HTTP_PROTOCOL_USED            134
+#define WINHTTP_LAST_OPTION                          WINHTTP_OPTION_HTTP_PROTOCOL_USED
 #define WINHTTP_OPTION_USERNAME                      0x1000
 #define WINHTTP_OPTION_PASSWORD                      0x1001
 #define WINHTTP_OPTION_PROXY_USERNAME                0x1002
@@ -149,6 +151,9 @@ typedef int INTERNET_SCHEME, *LPINTERNET_SCHEME;
 
 #define WINHTTP_CONNS_PER_SERVER_UNLIMITED 0xFFFFFFFF
 
+#define WINHTTP_PROTOCOL_FLAG_HTTP2 0x1
+#define WINHTTP_PROTOCOL_MASK       WINHTTP_PROTOCOL_FLAG_HTTP2
+
 #define WINHTTP_AUTOLOGON_SECURITY_LEVEL_MEDIUM   0
 #define WINHTTP_AUTOLOGON_SECURITY_LEVEL_LOW      1
 #define WINHTTP_AUTOLOGON_SECURITY_LEVEL_HIGH     2
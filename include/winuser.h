@@ -4272,6 +4272,7 @@ WORD        WINAPI SYSTEM_KillSystemTimer( WORD );
 
 #ifdef __WINESRC__
 WINUSERAPI BOOL CDECL __wine_send_input( HWND hwnd, const INPUT *input );
+WINUSERAPI BOOL CDECL __wine_send_inputs( UINT count, const HWND *hwnds, const INPUT *inputs );
 #endif
 
 #ifdef __cplusplus
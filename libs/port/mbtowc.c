@@ -23,6 +23,7 @@
 #include "wine/unicode.h"
 
 extern unsigned int wine_decompose( WCHAR ch, WCHAR *dst, unsigned int dstlen ) DECLSPEC_HIDDEN;
+extern unsigned int wine_ascii_mbstowcs( const unsigned char *src, WCHAR *dst, unsigned int len ) DECLSPEC_HIDDEN;
 
 /* check the code whether it is in Unicode Private Use Area (PUA). */
 /* MB_ERR_INVALID_CHARS raises an error converting from 1-byte character to PUA. */
@@ -49,6 +50,18 @@ static inline int check_invalid_chars_sbcs( const struct sbcs_table *table, int
     return srclen;
 }
 
+/* check whether the code page maps 7-bit ASCII to itself */
+static int is_ascii_compatible( const WCHAR *cp2uni )
+{
+    static const WCHAR *last_ascii_table;
+    unsigned int i;
+
+    if (cp2uni == last_ascii_table) return 1;
+    for (i = 0; i < 0x80; i++) if (cp2uni[i] != i) return 0;
+    last_ascii_table = cp2uni;
+    return 1;
+}
+
 /* mbstowcs for single-byte code page */
 /* all lengths are in characters, not bytes */
 static inline int mbstowcs_sbcs( const struct sbcs_table *table, int flags,
@@ -56,7 +69,8 @@ static inline int mbstowcs_sbcs( const struct sbcs_table *table, int flags,
                                  WCHAR *dst, unsigned int dstlen )
 {
     const WCHAR * const cp2uni = (flags & MB_USEGLYPHCHARS) ? table->cp2uni_glyphs : table->cp2uni;
-    int ret = srclen;
+    int ret = srclen, ascii;
+    unsigned int len;
 
     if (dstlen < srclen)
     {
@@ -65,8 +79,18 @@ static inline int mbstowcs_sbcs( const struct sbcs_table *table, int flags,
         ret = -1;
     }
 
+    ascii = srclen >= 32 && is_ascii_compatible( cp2uni );
+
     for (;;)
     {
+        /* ASCII runs don't need the table */
+        if (ascii && srclen >= 16 && (len = wine_ascii_mbstowcs( src, dst, srclen )))
+        {
+            dst += len;
+            src += len;
+            srclen -= len;
+            continue;
+        }
         switch(srclen)
         {
         default:
@@ -19,6 +19,12 @@
  */
 
 #include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __aarch64__
+#include <arm_neon.h>
+#endif
 
 #include "wine/unicode.h"
 
@@ -44,6 +50,64 @@ static const unsigned char utf8_mask[4] = { 0x7f, 0x1f, 0x0f, 0x07 };
 static const unsigned int utf8_minval[4] = { 0x0, 0x80, 0x800, 0x10000 };
 
 
+/* widen the leading 7-bit ASCII chars of src, 16 at a time */
+/* return the number of chars converted, the remainder is left to the caller */
+unsigned int wine_ascii_mbstowcs( const unsigned char *src, WCHAR *dst, unsigned int len )
+{
+    unsigned int pos = 0;
+
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+
+    for ( ; pos + 16 <= len; pos += 16)
+    {
+        __m128i chars = _mm_loadu_si128( (const __m128i *)(src + pos) );
+        if (_mm_movemask_epi8( chars )) break;
+        _mm_storeu_si128( (__m128i *)(dst + pos), _mm_unpacklo_epi8( chars, zero ));
+        _mm_storeu_si128( (__m128i *)(dst + pos + 8), _mm_unpackhi_epi8( chars, zero ));
+    }
+#elif defined(__aarch64__)
+    for ( ; pos + 16 <= len; pos += 16)
+    {
+        uint8x16_t chars = vld1q_u8( src + pos );
+        if (vmaxvq_u8( chars ) >= 0x80) break;
+        vst1q_u16( dst + pos, vmovl_u8( vget_low_u8( chars )));
+        vst1q_u16( dst + pos + 8, vmovl_high_u8( chars ));
+    }
+#endif
+    return pos;
+}
+
+/* narrow the leading 7-bit ASCII chars of src, 16 at a time */
+/* return the number of chars converted, the remainder is left to the caller */
+unsigned int wine_ascii_wcstombs( const WCHAR *src, unsigned char *dst, unsigned int len )
+{
+    unsigned int pos = 0;
+
+#ifdef __SSE2__
+    const __m128i mask = _mm_set1_epi16( 0xff80 );
+    const __m128i zero = _mm_setzero_si128();
+
+    for ( ; pos + 16 <= len; pos += 16)
+    {
+        __m128i low = _mm_loadu_si128( (const __m128i *)(src + pos) );
+        __m128i high = _mm_loadu_si128( (const __m128i *)(src + pos + 8) );
+        __m128i bits = _mm_and_si128( _mm_or_si128( low, high ), mask );
+        if (_mm_movemask_epi8( _mm_cmpeq_epi16( bits, zero )) != 0xffff) break;
+        _mm_storeu_si128( (__m128i *)(dst + pos), _mm_packus_epi16( low, high ));
+    }
+#elif defined(__aarch64__)
+    for ( ; pos + 16 <= len; pos += 16)
+    {
+        uint16x8_t low = vld1q_u16( src + pos );
+        uint16x8_t high = vld1q_u16( src + pos + 8 );
+        if (vmaxvq_u16( vorrq_u16( low, high )) >= 0x80) break;
+        vst1q_u8( dst + pos, vcombine_u8( vmovn_u16( low ), vmovn_u16( high )));
+    }
+#endif
+    return pos;
+}
+
 /* get the next char value taking surrogates into account */
 static inline unsigned int get_surrogate_value( const WCHAR *src, unsigned int srclen )
 {
@@ -108,8 +172,16 @@ int wine_utf8_wcstombs( int flags, const WCHAR *src, int srclen, char *dst, int
 
         if (ch < 0x80)  /* 0x00-0x7f: 1 byte */
         {
+            unsigned int count;
+
             if (!len--) return -1;  /* overflow */
             *dst++ = ch;
+            /* convert the rest of the ASCII run in bulk */
+            count = wine_ascii_wcstombs( src + 1, (unsigned char *)dst, min( srclen - 1, len ));
+            src += count;
+            srclen -= count;
+            dst += count;
+            len -= count;
             continue;
         }
 
@@ -316,7 +388,13 @@ int wine_utf8_mbstowcs( int flags, const char *src, int srclen, WCHAR *dst, int
         unsigned char ch = *src++;
         if (ch < 0x80)  /* special fast case for 7-bit ASCII */
         {
+            unsigned int count;
+
             *dst++ = ch;
+            /* convert the rest of the ASCII run in bulk */
+            count = wine_ascii_mbstowcs( (const unsigned char *)src, dst, min( srcend - src, dstend - dst ));
+            src += count;
+            dst += count;
             continue;
         }
         if ((res = decode_utf8_char( ch, &src, srcend )) <= 0xffff)
@@ -17,6 +17,8 @@
  * License along with this library; if not, write to the Free Software
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
  */
+#include <string.h>
+
 #include "wine/unicode.h"
 
 extern unsigned int wine_decompose( WCHAR ch, WCHAR *dst, unsigned int dstlen );
@@ -352,10 +354,88 @@ static inline int compare_case_weights(int flags, const WCHAR *str1, int len1,
     return len1 - len2;
 }
 
+/* length of the common prefix of two strings, which compares equal in all
+ * the passes; memcmp is used to check a block of characters at a time */
+static inline int common_prefix_len(const WCHAR *str1, const WCHAR *str2, int len)
+{
+    int i = 0;
+
+    while (i + 8 <= len && !memcmp(str1 + i, str2 + i, 8 * sizeof(WCHAR))) i += 8;
+    while (i < len && str1[i] == str2[i]) i++;
+    return i;
+}
+
+/* Compare all three weights in a single pass for the common case of ASCII
+ * strings, returning at the first primary difference. Returns 0 if some
+ * character needs the generic passes, which may skip it in only one of
+ * the strings.
+ */
+static inline int compare_ascii_weights(int flags, const WCHAR *str1, int len1,
+                                        const WCHAR *str2, int len2, int *ret)
+{
+    const unsigned int *ascii_table = collation_table + collation_table[0];
+    int i, len = len1 < len2 ? len1 : len2;
+    int diacritic = 0, case_weight = 0;
+
+    if (flags & NORM_IGNORESYMBOLS) return 0;
+
+    for (i = 0; i < len; i++)
+    {
+        WCHAR ch1 = str1[i], ch2 = str2[i];
+        unsigned int ce1, ce2;
+
+        if ((ch1 | ch2) >= 0x80) return 0;
+        if (!(flags & SORT_STRINGSORT) &&
+            (ch1 == '-' || ch1 == '\'' || ch2 == '-' || ch2 == '\'')) return 0;
+
+        ce1 = ascii_table[ch1];
+        ce2 = ascii_table[ch2];
+        if (ce1 == (unsigned int)-1 || ce2 == (unsigned int)-1)
+        {
+            /* all the passes compare the character codes */
+            if ((*ret = ch1 - ch2)) return 1;
+            continue;
+        }
+        if ((*ret = (ce1 >> 16) - (ce2 >> 16))) return 1;
+        if (!diacritic) diacritic = ((ce1 >> 8) & 0xff) - ((ce2 >> 8) & 0xff);
+        if (!case_weight) case_weight = ((ce1 >> 4) & 0x0f) - ((ce2 >> 4) & 0x0f);
+    }
+
+    str1 += len;
+    str2 += len;
+    len1 -= len;
+    len2 -= len;
+    while (len1 && !*str1)
+    {
+        str1++;
+        len1--;
+    }
+    while (len2 && !*str2)
+    {
+        str2++;
+        len2--;
+    }
+
+    if (!(*ret = len1 - len2))
+    {
+        if (!(flags & NORM_IGNORENONSPACE)) *ret = diacritic;
+        if (!*ret && !(flags & NORM_IGNORECASE)) *ret = case_weight;
+    }
+    return 1;
+}
+
 int wine_compare_string(int flags, const WCHAR *str1, int len1,
                         const WCHAR *str2, int len2)
 {
-    int ret;
+    int ret, prefix;
+
+    prefix = common_prefix_len(str1, str2, len1 < len2 ? len1 : len2);
+    str1 += prefix;
+    str2 += prefix;
+    len1 -= prefix;
+    len2 -= prefix;
+
+    if (compare_ascii_weights(flags, str1, len1, str2, len2, &ret)) return ret;
 
     ret = compare_unicode_weights(flags, str1, len1, str2, len2);
     if (!ret)
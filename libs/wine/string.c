@@ -26,30 +26,98 @@
 #define WINE_UNICODE_INLINE  /* nothing */
 #include "wine/unicode.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+
+/* check that 8 WCHARs can be loaded without crossing a page boundary */
+static inline int can_load8( const WCHAR *str )
+{
+    return ((ULONG_PTR)str & 0xfff) <= 0x1000 - 8 * sizeof(WCHAR);
+}
+
+/* convert ASCII uppercase letters to lowercase, leave everything else alone */
+static inline __m128i ascii_tolower8( __m128i v )
+{
+    __m128i upper = _mm_and_si128( _mm_cmpgt_epi16( v, _mm_set1_epi16( 'A' - 1 )),
+                                   _mm_cmplt_epi16( v, _mm_set1_epi16( 'Z' + 1 )));
+    return _mm_add_epi16( v, _mm_and_si128( upper, _mm_set1_epi16( 0x20 )));
+}
+
+/* Returns non-zero if the next 8 characters are equal ignoring ASCII case (and
+ * thus equal for tolowerW too); with check_null, also if none of them is 0.
+ * Mismatches, including non-ASCII case differences, are left to the caller. */
+static inline int equal8i( const WCHAR *str1, const WCHAR *str2, int check_null )
+{
+    __m128i a = _mm_loadu_si128( (const __m128i *)str1 );
+    __m128i b = _mm_loadu_si128( (const __m128i *)str2 );
+    __m128i eq = _mm_cmpeq_epi16( ascii_tolower8( a ), ascii_tolower8( b ));
+
+    if (check_null) eq = _mm_andnot_si128( _mm_cmpeq_epi16( a, _mm_setzero_si128() ), eq );
+    return _mm_movemask_epi8( eq ) == 0xffff;
+}
+#endif
+
 int strcmpiW( const WCHAR *str1, const WCHAR *str2 )
 {
+    int i, ret;
+
     for (;;)
     {
-        int ret = tolowerW(*str1) - tolowerW(*str2);
-        if (ret || !*str1) return ret;
-        str1++;
-        str2++;
+#ifdef __SSE2__
+        if (can_load8( str1 ) && can_load8( str2 ) && equal8i( str1, str2, 1 ))
+        {
+            str1 += 8;
+            str2 += 8;
+            continue;
+        }
+#endif
+        for (i = 0; i < 8; i++, str1++, str2++)
+        {
+            ret = tolowerW(*str1) - tolowerW(*str2);
+            if (ret || !*str1) return ret;
+        }
     }
 }
 
 int strncmpiW( const WCHAR *str1, const WCHAR *str2, int n )
 {
-    int ret = 0;
-    for ( ; n > 0; n--, str1++, str2++)
-        if ((ret = tolowerW(*str1) - tolowerW(*str2)) || !*str1) break;
+    int i, ret = 0;
+
+    while (n > 0)
+    {
+#ifdef __SSE2__
+        if (n >= 8 && can_load8( str1 ) && can_load8( str2 ) && equal8i( str1, str2, 1 ))
+        {
+            str1 += 8;
+            str2 += 8;
+            n -= 8;
+            continue;
+        }
+#endif
+        for (i = 0; i < 8 && n > 0; i++, n--, str1++, str2++)
+            if ((ret = tolowerW(*str1) - tolowerW(*str2)) || !*str1) return ret;
+    }
     return ret;
 }
 
 int memicmpW( const WCHAR *str1, const WCHAR *str2, int n )
 {
-    int ret = 0;
-    for ( ; n > 0; n--, str1++, str2++)
-        if ((ret = tolowerW(*str1) - tolowerW(*str2))) break;
+    int i, ret = 0;
+
+    while (n > 0)
+    {
+#ifdef __SSE2__
+        if (n >= 8 && equal8i( str1, str2, 0 ))
+        {
+            str1 += 8;
+            str2 += 8;
+            n -= 8;
+            continue;
+        }
+#endif
+        for (i = 0; i < 8 && n > 0; i++, n--, str1++, str2++)
+            if ((ret = tolowerW(*str1) - tolowerW(*str2))) return ret;
+    }
     return ret;
 }
 
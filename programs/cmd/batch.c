@@ -302,6 +302,174 @@ WCHAR *WCMD_fgets(WCHAR *buf, DWORD noChars, HANDLE h)
   return buf;
 }
 
+/****************************************************************************
+ * WCMD_get_label
+ *
+ * Checks whether a batch file line declares a label.
+ * Returns:
+ *       a pointer to the label name inside line, terminated at the first
+ *       whitespace or redirection character
+ *       NULL if the line is not a label
+ */
+
+WCHAR *WCMD_get_label(WCHAR *line)
+{
+  static const WCHAR labelEndsW[] = {'>','<','|','&',' ',':','\t','\0'};
+  WCHAR *str = line, *labelend;
+
+  /* Ignore leading whitespace or no-echo character */
+  while (*str=='@' || isspaceW (*str)) str++;
+
+  /* If the first real character is a : then this is a label */
+  if (*str != ':') return NULL;
+  str++;
+
+  /* Skip spaces between : and label */
+  while (isspaceW (*str)) str++;
+  WINE_TRACE("str before brk %s\n", wine_dbgstr_w(str));
+
+  /* Label ends at whitespace or redirection characters */
+  labelend = strpbrkW(str, labelEndsW);
+  if (labelend) *labelend = 0x00;
+  return str;
+}
+
+/* Label index of the most recently searched batch file. It is rebuilt
+   whenever the contents of the file differ, so that batch files which
+   modify themselves keep working. */
+struct batch_label
+{
+  WCHAR *name;
+  LONGLONG pos;       /* offset of the line following the label */
+};
+
+static struct
+{
+  char *data;         /* file contents the index was built from */
+  DWORD size;
+  UINT cp;
+  struct batch_label *labels;
+  DWORD count;
+} label_index;
+
+#define MAX_INDEXED_BATCH_SIZE (16 * 1024 * 1024)
+
+static int WCMD_compare_labels(const void *a, const void *b)
+{
+  const struct batch_label *label1 = a, *label2 = b;
+  int ret = lstrcmpiW(label1->name, label2->name);
+
+  /* Keep duplicate labels in file order, the first one wins */
+  if (!ret) ret = (label1->pos > label2->pos) - (label1->pos < label2->pos);
+  return ret;
+}
+
+static int WCMD_compare_label_name(const void *key, const void *entry)
+{
+  const struct batch_label *label = entry;
+  return lstrcmpiW(key, label->name);
+}
+
+static void WCMD_build_label_index(char *data, DWORD size, UINT cp)
+{
+  WCHAR string[MAX_PATH], *name;
+  DWORD offset = 0, alloc = 0, i;
+
+  for (i = 0; i < label_index.count; i++) heap_free(label_index.labels[i].name);
+  heap_free(label_index.labels);
+  heap_free(label_index.data);
+  label_index.data = data;
+  label_index.size = size;
+  label_index.cp = cp;
+  label_index.labels = NULL;
+  label_index.count = 0;
+
+  /* Split the lines the same way as reading them with WCMD_fgets does */
+  while (offset < size) {
+    const char *line = data + offset, *end = line + min(size - offset, MAX_PATH), *p;
+
+    for (p = line; p < end; p = CharNextExA(cp, p, 0)) {
+        if (*p == '\n' || *p == '\r')
+            break;
+    }
+    if (p > end) p = end;
+
+    i = MultiByteToWideChar(cp, 0, line, p - line, string, MAX_PATH);
+    if (i == MAX_PATH) i--;
+    string[i] = '\0';
+    offset += p - line + 1 + (p < end && *p == '\r' ? 1 : 0);
+
+    if (!(name = WCMD_get_label(string)) || !*name) continue;
+
+    if (label_index.count == alloc) {
+      struct batch_label *labels;
+
+      alloc = max(alloc * 2, 64);
+      labels = heap_alloc(alloc * sizeof(*labels));
+      if (label_index.count) memcpy(labels, label_index.labels, label_index.count * sizeof(*labels));
+      heap_free(label_index.labels);
+      label_index.labels = labels;
+    }
+    label_index.labels[label_index.count].name = heap_strdupW(name);
+    label_index.labels[label_index.count].pos = offset;
+    label_index.count++;
+  }
+
+  if (label_index.count)
+    qsort(label_index.labels, label_index.count, sizeof(*label_index.labels), WCMD_compare_labels);
+  WINE_TRACE("indexed %u labels\n", label_index.count);
+}
+
+/****************************************************************************
+ * WCMD_find_label
+ *
+ * Finds the first line declaring a label in a batch file. The whole file is
+ * read at once and its labels are indexed, the index is reused as long as the
+ * contents of the file don't change.
+ * Returns:
+ *       TRUE with pos set to the offset of the line following the label, or
+ *            to -1 if the label doesn't exist
+ *       FALSE if the file couldn't be read at once, the caller then needs to
+ *             scan it line by line
+ */
+
+BOOL WCMD_find_label(HANDLE h, const WCHAR *label, LARGE_INTEGER *pos)
+{
+  LARGE_INTEGER size;
+  struct batch_label *found;
+  DWORD read;
+  char *data;
+  UINT cp;
+
+  if (WCMD_is_console_handle(h)) return FALSE;
+  if (!GetFileSizeEx(h, &size) || size.QuadPart > MAX_INDEXED_BATCH_SIZE) return FALSE;
+
+  data = heap_alloc(size.QuadPart + 1);
+  pos->QuadPart = 0;
+  if (!SetFilePointerEx(h, *pos, NULL, FILE_BEGIN) ||
+      !ReadFile(h, data, size.QuadPart, &read, NULL)) {
+    heap_free(data);
+    return FALSE;
+  }
+
+  cp = GetConsoleCP();
+  if (!label_index.data || label_index.size != read || label_index.cp != cp ||
+      memcmp(label_index.data, data, read))
+    WCMD_build_label_index(data, read, cp);
+  else
+    heap_free(data);
+
+  found = bsearch(label, label_index.labels, label_index.count,
+                  sizeof(*label_index.labels), WCMD_compare_label_name);
+  if (!found) {
+    pos->QuadPart = -1;
+    return TRUE;
+  }
+  while (found > label_index.labels && !lstrcmpiW(found[-1].name, label)) found--;
+  pos->QuadPart = found->pos;
+  return TRUE;
+}
+
 /* WCMD_splitpath - copied from winefile as no obvious way to use it otherwise */
 void WCMD_splitpath(const WCHAR* path, WCHAR* drv, WCHAR* dir, WCHAR* name, WCHAR* ext)
 {
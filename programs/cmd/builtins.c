@@ -2551,6 +2551,7 @@ void WCMD_goto (CMD_LIST **cmdList) {
   WCHAR string[MAX_PATH];
   WCHAR *labelend = NULL;
   const WCHAR labelEndsW[] = {'>','<','|','&',' ',':','\t','\0'};
+  LARGE_INTEGER pos;
 
   /* Do not process any more parts of a processed multipart or multilines command */
   if (cmdList) *cmdList = NULL;
@@ -2576,25 +2577,17 @@ void WCMD_goto (CMD_LIST **cmdList) {
     if (labelend) *labelend = 0x00;
     WINE_TRACE("goto label: '%s'\n", wine_dbgstr_w(paramStart));
 
-    SetFilePointer (context -> h, 0, NULL, FILE_BEGIN);
-    while (*paramStart &&
-           WCMD_fgets (string, sizeof(string)/sizeof(WCHAR), context -> h)) {
-      str = string;
-
-      /* Ignore leading whitespace or no-echo character */
-      while (*str=='@' || isspaceW (*str)) str++;
-
-      /* If the first real character is a : then this is a label */
-      if (*str == ':') {
-        str++;
-
-        /* Skip spaces between : and label */
-        while (isspaceW (*str)) str++;
-        WINE_TRACE("str before brk %s\n", wine_dbgstr_w(str));
-
-        /* Label ends at whitespace or redirection characters */
-        labelend = strpbrkW(str, labelEndsW);
-        if (labelend) *labelend = 0x00;
+    if (*paramStart && WCMD_find_label (context -> h, paramStart, &pos)) {
+      if (pos.QuadPart != -1) {
+        SetFilePointerEx (context -> h, pos, NULL, FILE_BEGIN);
+        return;
+      }
+    }
+    else {
+      SetFilePointer (context -> h, 0, NULL, FILE_BEGIN);
+      while (*paramStart &&
+             WCMD_fgets (string, sizeof(string)/sizeof(WCHAR), context -> h)) {
+        if (!(str = WCMD_get_label (string))) continue;
         WINE_TRACE("comparing found label %s\n", wine_dbgstr_w(str));
 
         if (lstrcmpiW (str, paramStart) == 0) return;
@@ -2977,6 +2977,26 @@ echo FAILURE at dest 10
 :dest10:this is also ignored
 echo Correctly ignored trailing information
 
+rem the first of duplicate labels is used, and labels are looked up
+rem again when the batch file is rewritten
+del testgoto.bat >nul 2>&1
+echo @goto :dest11>> testgoto.bat
+echo :dest11>> testgoto.bat
+echo @echo goto used the first of duplicate labels>> testgoto.bat
+echo @goto :eof>> testgoto.bat
+echo :dest11>> testgoto.bat
+echo @echo FAILURE at dest 11 - went to the second label>> testgoto.bat
+call testgoto.bat
+del testgoto.bat >nul 2>&1
+echo @goto :dest11>> testgoto.bat
+echo :dest12>> testgoto.bat
+echo @echo FAILURE at dest 11 - used labels of the previous file>> testgoto.bat
+echo @goto :eof>> testgoto.bat
+echo :dest11>> testgoto.bat
+echo @echo goto found the label after the file was rewritten>> testgoto.bat
+call testgoto.bat
+del testgoto.bat >nul 2>&1
+
 echo ------------ Testing PATH ------------
 set WINE_backup_path=%path%
 set path=original
@@ -326,12 +326,96 @@ static int compare_tags(const void *a, const void *b)
     return service_a->config.dwTagId - service_b->config.dwTagId;
 }
 
+enum autostart_state
+{
+    AUTOSTART_WAITING,
+    AUTOSTART_RUNNING,
+    AUTOSTART_DONE
+};
+
+struct autostart_job
+{
+    struct service_entry *service;
+    volatile LONG state;
+    DWORD start_time;
+    HANDLE done_event;  /* signaled each time a job is done */
+};
+
+static BOOL is_driver(const struct service_entry *service)
+{
+    return service->config.dwServiceType == SERVICE_KERNEL_DRIVER ||
+           service->config.dwServiceType == SERVICE_FILE_SYSTEM_DRIVER;
+}
+
+static BOOL service_depends_on(const struct service_entry *service, const struct service_entry *other)
+{
+    const WCHAR *ptr;
+
+    if (service->dependOnServices)
+    {
+        for (ptr = service->dependOnServices; *ptr; ptr += strlenW(ptr) + 1)
+            if (!strcmpiW(ptr, other->name)) return TRUE;
+    }
+    if (service->dependOnGroups && other->config.lpLoadOrderGroup)
+    {
+        for (ptr = service->dependOnGroups; *ptr; ptr += strlenW(ptr) + 1)
+            if (!strcmpiW(ptr, other->config.lpLoadOrderGroup)) return TRUE;
+    }
+    return FALSE;
+}
+
+/* check whether everything a service has to wait for has been started */
+static BOOL autostart_job_ready(const struct autostart_job *jobs, unsigned int count, unsigned int index)
+{
+    const struct service_entry *service = jobs[index].service, *other;
+    unsigned int i;
+
+    for (i = 0; i < count; i++)
+    {
+        if (i == index || jobs[i].state == AUTOSTART_DONE) continue;
+        other = jobs[i].service;
+
+        /* services of the same load order group start in tag order */
+        if (i < index && service->config.lpLoadOrderGroup && other->config.lpLoadOrderGroup &&
+            !strcmpiW(service->config.lpLoadOrderGroup, other->config.lpLoadOrderGroup))
+            return FALSE;
+
+        /* drivers share winedevice processes, start them one at a time */
+        if (is_driver(service) && is_driver(other) && jobs[i].state == AUTOSTART_RUNNING)
+            return FALSE;
+
+        if (service_depends_on(service, other)) return FALSE;
+    }
+    return TRUE;
+}
+
+static DWORD CALLBACK autostart_thread(void *arg)
+{
+    struct autostart_job *job = arg;
+    DWORD err;
+
+    err = service_start(job->service, 0, NULL);
+    if (err != ERROR_SUCCESS)
+        WINE_FIXME("Auto-start service %s failed to start: %d\n",
+                   wine_dbgstr_w(job->service->name), err);
+    else
+        WINE_TRACE("Auto-start service %s started in %u ms\n",
+                   wine_dbgstr_w(job->service->name), GetTickCount() - job->start_time);
+
+    InterlockedExchange(&job->state, AUTOSTART_DONE);
+    SetEvent(job->done_event);
+    return 0;
+}
+
 static void scmdatabase_autostart_services(struct scmdatabase *db)
 {
     struct service_entry **services_list;
-    unsigned int i = 0;
+    struct autostart_job *jobs;
+    unsigned int i = 0, done, running;
     unsigned int size = 32;
     struct service_entry *service;
+    HANDLE done_event;
+    DWORD start_time;
 
     services_list = HeapAlloc(GetProcessHeap(), 0, size * sizeof(services_list[0]));
     if (!services_list)
@@ -361,20 +445,83 @@ static void scmdatabase_autostart_services(struct scmdatabase *db)
 
     scmdatabase_unlock(db);
     qsort(services_list, size, sizeof(services_list[0]), compare_tags);
+
+    done_event = CreateEventW(NULL, FALSE, FALSE, NULL);
+    jobs = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, max(size, 1) * sizeof(jobs[0]));
+    for (i = 0; jobs && i < size; i++)
+    {
+        jobs[i].service = services_list[i];
+        jobs[i].state = AUTOSTART_WAITING;
+        jobs[i].done_event = done_event;
+    }
+
     scmdatabase_lock_startup(db, INFINITE);
+    start_time = GetTickCount();
 
-    for (i = 0; i < size; i++)
+    /* start the services whose dependencies are satisfied concurrently, and
+     * schedule the remaining ones each time one of them is done */
+    for (done = 0; jobs && done_event && done < size;)
     {
-        DWORD err;
-        service = services_list[i];
-        err = service_start(service, 0, NULL);
-        if (err != ERROR_SUCCESS)
-            WINE_FIXME("Auto-start service %s failed to start: %d\n",
-                       wine_dbgstr_w(service->name), err);
-        release_service(service);
+        BOOL started = FALSE;
+
+        scmdatabase_lock(db);
+        for (i = 0, done = 0, running = 0; i < size; i++)
+        {
+            if (jobs[i].state == AUTOSTART_DONE) done++;
+            else if (jobs[i].state == AUTOSTART_RUNNING) running++;
+        }
+        for (i = 0; i < size; i++)
+        {
+            if (jobs[i].state != AUTOSTART_WAITING) continue;
+            if (!autostart_job_ready(jobs, size, i)) continue;
+            jobs[i].state = AUTOSTART_RUNNING;
+            jobs[i].start_time = GetTickCount();
+            started = TRUE;
+            running++;
+            if (!QueueUserWorkItem(autostart_thread, &jobs[i], WT_EXECUTELONGFUNCTION))
+            {
+                scmdatabase_unlock(db);
+                autostart_thread(&jobs[i]);
+                scmdatabase_lock(db);
+            }
+        }
+        if (!started && !running && done < size)
+        {
+            /* circular dependencies, start the first remaining service anyway */
+            for (i = 0; i < size; i++) if (jobs[i].state == AUTOSTART_WAITING) break;
+            WINE_WARN("Auto-start service %s has circular dependencies\n",
+                      wine_dbgstr_w(jobs[i].service->name));
+            jobs[i].state = AUTOSTART_RUNNING;
+            jobs[i].start_time = GetTickCount();
+            scmdatabase_unlock(db);
+            autostart_thread(&jobs[i]);
+            continue;
+        }
+        scmdatabase_unlock(db);
+
+        if (running) WaitForSingleObject(done_event, INFINITE);
     }
 
+    if (!jobs || !done_event)
+    {
+        /* start them one after the other */
+        for (i = 0; i < size; i++)
+        {
+            DWORD err;
+            service = services_list[i];
+            err = service_start(service, 0, NULL);
+            if (err != ERROR_SUCCESS)
+                WINE_FIXME("Auto-start service %s failed to start: %d\n",
+                           wine_dbgstr_w(service->name), err);
+        }
+    }
+    else WINE_TRACE("Started %u services in %u ms\n", size, GetTickCount() - start_time);
+
     scmdatabase_unlock_startup(db);
+
+    for (i = 0; i < size; i++) release_service(services_list[i]);
+    HeapFree(GetProcessHeap(), 0, jobs);
+    if (done_event) CloseHandle(done_event);
     HeapFree(GetProcessHeap(), 0, services_list);
 }
 
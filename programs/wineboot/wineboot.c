@@ -1123,6 +1123,31 @@ done:
     return ret;
 }
 
+/* prepare the caches that are normally built by the first process of a session */
+static void warm_up_caches(void)
+{
+    static const WCHAR fonts_keyW[] = {'S','o','f','t','w','a','r','e','\\','W','i','n','e','\\','F','o','n','t','s',0};
+    static const WCHAR cacheW[] = {'C','a','c','h','e',0};
+    static const WCHAR snapshotW[] = {'C','a','c','h','e',' ','S','n','a','p','s','h','o','t',0};
+    static const WCHAR gdi32W[] = {'g','d','i','3','2','.','d','l','l',0};
+    HMODULE module;
+    HKEY hkey;
+
+    /* enable the font list snapshot, and drop the volatile font cache so that
+     * gdi32 scans the fonts again and saves the snapshot while initializing */
+    if (RegCreateKeyExW( HKEY_CURRENT_USER, fonts_keyW, 0, NULL, 0, KEY_ALL_ACCESS, NULL, &hkey, NULL ))
+    {
+        WINE_ERR( "failed to open the fonts key\n" );
+        return;
+    }
+    RegSetValueExW( hkey, snapshotW, 0, REG_BINARY, NULL, 0 );
+    RegDeleteTreeW( hkey, cacheW );
+    RegCloseKey( hkey );
+
+    if ((module = LoadLibraryW( gdi32W ))) FreeLibrary( module );
+    else WINE_ERR( "failed to load gdi32, err %d\n", GetLastError() );
+}
+
 static void usage(void)
 {
     WINE_MESSAGE( "Usage: wineboot [options]\n" );
@@ -1135,9 +1160,10 @@ static void usage(void)
     WINE_MESSAGE( "    -r,--restart      Restart only, don't do normal startup operations\n" );
     WINE_MESSAGE( "    -s,--shutdown     Shutdown only, don't reboot\n" );
     WINE_MESSAGE( "    -u,--update       Update the wineprefix directory\n" );
+    WINE_MESSAGE( "    -w,--warm-up      Save the caches that speed up the first start of a session\n" );
 }
 
-static const char short_options[] = "efhikrsu";
+static const char short_options[] = "efhikrsuw";
 
 static const struct option long_options[] =
 {
@@ -1149,6 +1175,7 @@ static const struct option long_options[] =
     { "restart",     0, 0, 'r' },
     { "shutdown",    0, 0, 's' },
     { "update",      0, 0, 'u' },
+    { "warm-up",     0, 0, 'w' },
     { NULL,          0, 0, 0 }
 };
 
@@ -1162,12 +1189,12 @@ int main( int argc, char *argv[] )
 
     /* First, set the current directory to SystemRoot */
     int optc;
-    BOOL end_session, force, init, kill, restart, shutdown, update;
+    BOOL end_session, force, init, kill, restart, shutdown, update, warm_up;
     HANDLE event;
     SECURITY_ATTRIBUTES sa;
     BOOL is_wow64;
 
-    end_session = force = init = kill = restart = shutdown = update = FALSE;
+    end_session = force = init = kill = restart = shutdown = update = warm_up = FALSE;
     GetWindowsDirectoryW( windowsdir, MAX_PATH );
     if( !SetCurrentDirectoryW( windowsdir ) )
         WINE_ERR("Cannot set the dir to %s (%d)\n", wine_dbgstr_w(windowsdir), GetLastError() );
@@ -1207,6 +1234,7 @@ int main( int argc, char *argv[] )
         case 'r': restart = TRUE; break;
         case 's': shutdown = TRUE; break;
         case 'u': update = TRUE; break;
+        case 'w': warm_up = TRUE; break;
         case 'h': usage(); return 0;
         case '?': usage(); return 1;
         }
@@ -1225,6 +1253,8 @@ int main( int argc, char *argv[] )
 
     if (shutdown) return 0;
 
+    if (warm_up) warm_up_caches();
+
     sa.nLength = sizeof(sa);
     sa.lpSecurityDescriptor = NULL;
     sa.bInheritHandle = TRUE;  /* so that services.exe inherits it */
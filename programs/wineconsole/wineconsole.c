@@ -286,9 +286,9 @@ void	WINECON_GrabChanges(struct inner_data* data)
 	    continue;
 	}
 
-	if (ev_found != -1 &&  /* Only 2 cases where they CANNOT merge */
-	    !(evts[i       ].u.update.bottom + 1 < evts[ev_found].u.update.top ||
-	      evts[ev_found].u.update.bottom + 1 < evts[i       ].u.update.top))
+	/* merge even disjoint updates, so that each batch of output gets
+	 * fetched and redrawn at once instead of row by row */
+	if (ev_found != -1)
 	{
 	    WINE_TRACE("%u/%u: update(%d,%d) merging with %u\n", ev_found+1, num, evts[i].u.update.top, evts[i].u.update.bottom, i+1);
 	    evts[i].u.update.top    = min(evts[i       ].u.update.top,
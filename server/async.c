@@ -310,6 +310,12 @@ obj_handle_t async_handoff( struct async *async, int success, data_size_t *resul
     {
         if (result) *result = async->iosb->result;
         async->signaled = 1;
+
+        /* nobody but the caller can see the completion of a successful synchronous call,
+         * so complete it right away instead of having the client wait on the async */
+        if (async->iosb->status == STATUS_SUCCESS && async_is_blocking( async ) && async->fd &&
+            (get_fd_options( async->fd ) & (FILE_SYNCHRONOUS_IO_ALERT | FILE_SYNCHRONOUS_IO_NONALERT)))
+            async_satisfied( &async->obj, NULL );
     }
     else
     {
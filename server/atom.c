@@ -26,11 +26,14 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
 
 #include "unicode.h"
+#include "file.h"
 #include "request.h"
 #include "object.h"
 #include "process.h"
@@ -97,6 +100,15 @@ static const struct object_ops atom_table_ops =
 
 static struct atom_table *global_table;
 
+static int generation_fd = -1;                  /* fd of the shared generation counter */
+static volatile unsigned int *atom_generation;  /* counter bumped when a global atom is freed or pinned */
+
+/* let the clients know that their cached global atoms may no longer be valid */
+static void atoms_changed( struct atom_table *table )
+{
+    if (table == global_table && atom_generation) (*atom_generation)++;
+}
+
 /* create an atom table */
 static struct atom_table *create_table(int entries_count)
 {
@@ -275,6 +287,7 @@ static void delete_atom( struct atom_table *table, atom_t atom, int if_pinned )
         else table->entries[entry->hash] = entry->next;
         table->handles[atom - MIN_STR_ATOM] = NULL;
         free( entry );
+        atoms_changed( table );
     }
 }
 
@@ -449,12 +462,37 @@ DECL_HANDLER(set_atom_information)
 
         if ((entry = get_atom_entry( table, req->atom )))
         {
-            if (req->pinned) entry->pinned = 1;
+            if (req->pinned && !entry->pinned)
+            {
+                entry->pinned = 1;
+                atoms_changed( table );
+            }
         }
         release_object( table );
     }
 }
 
+/* retrieve the fd of the global atom generation counter */
+DECL_HANDLER(get_atom_generation)
+{
+    void *ptr;
+
+    if (generation_fd == -1)
+    {
+        if ((generation_fd = create_temp_file( get_page_size() )) == -1) return;
+        ptr = mmap( NULL, get_page_size(), PROT_READ | PROT_WRITE, MAP_SHARED, generation_fd, 0 );
+        if (ptr == MAP_FAILED)
+        {
+            file_set_error();
+            close( generation_fd );
+            generation_fd = -1;
+            return;
+        }
+        atom_generation = ptr;
+    }
+    send_client_fd( current->process, generation_fd, 0 );
+}
+
 /* init a (local) atom table */
 DECL_HANDLER(init_atom_table)
 {
@@ -488,6 +526,7 @@ DECL_HANDLER(empty_atom_table)
                 free( entry );
             }
         }
+        atoms_changed( table );
         release_object( table );
     }
 }
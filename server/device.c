@@ -727,7 +727,8 @@ DECL_HANDLER(get_next_device_request)
     {
         if ((irp = (struct irp_call *)get_handle_obj( current->process, req->prev, 0, &irp_call_ops )))
         {
-            set_irp_result( irp, req->status, NULL, 0, 0 );
+            if (irp->file && req->file_ptr) set_file_user_ptr( irp->file, req->file_ptr );
+            set_irp_result( irp, req->status, get_req_data(), get_req_data_size(), req->result );
             close_handle( current->process, req->prev );  /* avoid an extra round-trip for close */
             release_object( irp );
         }
@@ -22,6 +22,7 @@
 #include "wine/port.h"
 
 #include <fcntl.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdarg.h>
 #ifdef HAVE_SYS_EVENTFD_H
@@ -33,6 +34,9 @@
 #ifdef HAVE_SYS_STAT_H
 # include <sys/stat.h>
 #endif
+#ifdef HAVE_SYS_SYSCALL_H
+# include <sys/syscall.h>
+#endif
 #include <unistd.h>
 
 #include "ntstatus.h"
@@ -60,6 +64,29 @@ int do_esync(void)
 #endif
 }
 
+/* clients that set WINEFSYNC sleep on the shm state, so they need a futex
+ * wakeup whenever we signal an object */
+int do_fsync(void)
+{
+#if defined(__linux__) && defined(__NR_futex)
+    static int do_fsync_cached = -1;
+
+    if (do_fsync_cached == -1)
+        do_fsync_cached = do_esync() && getenv("WINEFSYNC") != NULL;
+
+    return do_fsync_cached;
+#else
+    return 0;
+#endif
+}
+
+static inline void futex_wake( int *addr )
+{
+#if defined(__linux__) && defined(__NR_futex)
+    if (do_fsync()) syscall( __NR_futex, addr, 1 /* FUTEX_WAKE */, INT_MAX, NULL, 0, 0 );
+#endif
+}
+
 static char shm_name[29];
 static int shm_fd;
 static off_t shm_size;
@@ -353,6 +380,7 @@ void esync_set_event( struct esync *esync )
     {
         if (write( esync->fd, &value, sizeof(value) ) == -1)
             perror( "esync: write" );
+        futex_wake( &event->signaled );
     }
 
     /* Release the spinlock. */
@@ -195,6 +195,7 @@ struct fd
     struct async_queue   wait_q;      /* other async waiters of this fd */
     struct completion   *completion;  /* completion object attached to this fd */
     apc_param_t          comp_key;    /* completion key to set in completion events */
+    unsigned int         comp_flags;  /* completion notification flags (FILE_SKIP_*) */
     int                  esync_fd;    /* esync file descriptor */
 };
 
@@ -227,7 +228,7 @@ static const struct object_ops fd_ops =
 /* device object */
 
 #define DEVICE_HASH_SIZE 7
-#define INODE_HASH_SIZE 17
+#define INODE_HASH_MIN_SIZE 16  /* initial size of the inode hash table, must be a power of 2 */
 
 struct device
 {
@@ -235,7 +236,9 @@ struct device
     struct list         entry;      /* entry in device hash list */
     dev_t               dev;        /* device number */
     int                 removable;  /* removable device? (or -1 if unknown) */
-    struct list         inode_hash[INODE_HASH_SIZE];  /* inodes hash table */
+    struct list        *inode_hash; /* inodes hash table */
+    unsigned int        hash_size;  /* size of the inodes hash table */
+    unsigned int        nb_inodes;  /* number of inodes in the hash table */
 };
 
 static void device_dump( struct object *obj, int verbose );
@@ -273,7 +276,7 @@ struct inode
     struct device      *device;     /* device containing this inode */
     ino_t               ino;        /* inode number */
     struct list         open;       /* list of open file descriptors */
-    struct list         locks;      /* list of file locks */
+    struct file_lock   *locks;      /* tree of file locks */
     struct list         closed;     /* list of file descriptors to close at destroy time */
 };
 
@@ -310,7 +313,10 @@ struct file_lock
     struct object       obj;         /* object header */
     struct fd          *fd;          /* fd owning this lock */
     struct list         fd_entry;    /* entry in list of locks on a given fd */
-    struct list         inode_entry; /* entry in inode list of locks */
+    struct file_lock   *left;        /* children in the inode tree of locks */
+    struct file_lock   *right;
+    unsigned int        priority;    /* random priority to keep the tree balanced */
+    file_pos_t          max_end;     /* highest end of the locks in this subtree */
     int                 shared;      /* shared lock? */
     file_pos_t          start;       /* locked region is interval [start;end) */
     file_pos_t          end;
@@ -364,13 +370,16 @@ static file_pos_t max_unix_offset = OFF_T_MAX;
 
 struct timeout_user
 {
-    struct list           entry;      /* entry in sorted timeout list */
+    struct list           entry;      /* entry in expired list */
+    int                   index;      /* index in timeout heap, -1 once expired */
     timeout_t             when;       /* timeout expiry (absolute time) */
     timeout_callback      callback;   /* callback function */
     void                 *private;    /* callback private data */
 };
 
-static struct list timeout_list = LIST_INIT(timeout_list);   /* sorted timeouts list */
+static struct timeout_user **timeout_heap;  /* binary min-heap of pending timeouts */
+static int timeout_count;                   /* number of timeouts in the heap */
+static int timeout_size;                    /* allocated size of the heap */
 timeout_t current_time;
 
 static inline void set_current_time(void)
@@ -381,32 +390,88 @@ static inline void set_current_time(void)
     current_time = (timeout_t)now.tv_sec * TICKS_PER_SEC + now.tv_usec * 10 + ticks_1601_to_1970;
 }
 
+static inline void set_timeout_slot( int index, struct timeout_user *user )
+{
+    timeout_heap[index] = user;
+    user->index = index;
+}
+
+/* move a timeout towards the top of the heap until its parent expires earlier */
+static void sift_timeout_up( int index, struct timeout_user *user )
+{
+    while (index)
+    {
+        int parent = (index - 1) / 2;
+        if (timeout_heap[parent]->when <= user->when) break;
+        set_timeout_slot( index, timeout_heap[parent] );
+        index = parent;
+    }
+    set_timeout_slot( index, user );
+}
+
+/* move a timeout towards the bottom of the heap until its children expire later */
+static void sift_timeout_down( int index, struct timeout_user *user )
+{
+    for (;;)
+    {
+        int child = 2 * index + 1;
+
+        if (child >= timeout_count) break;
+        if (child + 1 < timeout_count && timeout_heap[child + 1]->when < timeout_heap[child]->when)
+            child++;
+        if (user->when <= timeout_heap[child]->when) break;
+        set_timeout_slot( index, timeout_heap[child] );
+        index = child;
+    }
+    set_timeout_slot( index, user );
+}
+
+static void remove_timeout_from_heap( struct timeout_user *user )
+{
+    int index = user->index;
+    struct timeout_user *last = timeout_heap[--timeout_count];
+
+    user->index = -1;
+    if (last == user) return;
+    if (index && timeout_heap[(index - 1) / 2]->when > last->when) sift_timeout_up( index, last );
+    else sift_timeout_down( index, last );
+}
+
 /* add a timeout user */
 struct timeout_user *add_timeout_user( timeout_t when, timeout_callback func, void *private )
 {
     struct timeout_user *user;
-    struct list *ptr;
+
+    if (timeout_count == timeout_size)
+    {
+        int new_size = timeout_size ? timeout_size * 2 : 64;
+        struct timeout_user **new_heap;
+
+        if (!(new_heap = realloc( timeout_heap, new_size * sizeof(*new_heap) )))
+        {
+            set_error( STATUS_NO_MEMORY );
+            return NULL;
+        }
+        timeout_heap = new_heap;
+        timeout_size = new_size;
+    }
 
     if (!(user = mem_alloc( sizeof(*user) ))) return NULL;
     user->when     = (when > 0) ? when : current_time - when;
     user->callback = func;
     user->private  = private;
 
-    /* Now insert it in the linked list */
+    /* Now insert it in the heap */
 
-    LIST_FOR_EACH( ptr, &timeout_list )
-    {
-        struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
-        if (timeout->when >= user->when) break;
-    }
-    list_add_before( ptr, &user->entry );
+    sift_timeout_up( timeout_count++, user );
     return user;
 }
 
 /* remove a timeout user */
 void remove_timeout_user( struct timeout_user *user )
 {
-    list_remove( &user->entry );
+    if (user->index != -1) remove_timeout_from_heap( user );
+    else list_remove( &user->entry );  /* already expired but callback not called yet */
     free( user );
 }
 
@@ -852,23 +917,18 @@ static void remove_poll_user( struct fd *fd, int user )
 /* process pending timeouts and return the time until the next timeout, in milliseconds */
 static int get_next_timeout(void)
 {
-    if (!list_empty( &timeout_list ))
+    if (timeout_count)
     {
         struct list expired_list, *ptr;
 
-        /* first remove all expired timers from the list */
+        /* first remove all expired timers from the heap */
 
         list_init( &expired_list );
-        while ((ptr = list_head( &timeout_list )) != NULL)
+        while (timeout_count && timeout_heap[0]->when <= current_time)
         {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
-
-            if (timeout->when <= current_time)
-            {
-                list_remove( &timeout->entry );
-                list_add_tail( &expired_list, &timeout->entry );
-            }
-            else break;
+            struct timeout_user *timeout = timeout_heap[0];
+            remove_timeout_from_heap( timeout );
+            list_add_tail( &expired_list, &timeout->entry );
         }
 
         /* now call the callback for all the removed timers */
@@ -881,9 +941,9 @@ static int get_next_timeout(void)
             free( timeout );
         }
 
-        if ((ptr = list_head( &timeout_list )) != NULL)
+        if (timeout_count)
         {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
+            struct timeout_user *timeout = timeout_heap[0];
             int diff = (timeout->when - current_time + 9999) / 10000;
             if (diff < 0) diff = 0;
             return diff;
@@ -989,7 +1049,15 @@ static struct device *get_device( dev_t dev, int unix_fd )
     {
         device->dev = dev;
         device->removable = is_device_removable( dev, unix_fd );
-        for (i = 0; i < INODE_HASH_SIZE; i++) list_init( &device->inode_hash[i] );
+        device->hash_size = INODE_HASH_MIN_SIZE;
+        device->nb_inodes = 0;
+        list_init( &device->entry );
+        if (!(device->inode_hash = mem_alloc( device->hash_size * sizeof(*device->inode_hash) )))
+        {
+            release_object( device );
+            return NULL;
+        }
+        for (i = 0; i < device->hash_size; i++) list_init( &device->inode_hash[i] );
         list_add_head( &device_hash[hash], &device->entry );
     }
     return device;
@@ -1008,12 +1076,40 @@ static void device_destroy( struct object *obj )
     struct device *device = (struct device *)obj;
     unsigned int i;
 
-    for (i = 0; i < INODE_HASH_SIZE; i++)
-        assert( list_empty(&device->inode_hash[i]) );
+    if (device->inode_hash)
+    {
+        for (i = 0; i < device->hash_size; i++)
+            assert( list_empty(&device->inode_hash[i]) );
+        free( device->inode_hash );
+    }
 
     list_remove( &device->entry );  /* remove it from the hash table */
 }
 
+/* double the size of the inodes hash table to keep the chains short */
+static void grow_inode_hash( struct device *device )
+{
+    unsigned int i, size = device->hash_size * 2;
+    struct list *hash;
+    struct inode *inode, *next;
+
+    /* not a fatal error, the chains just get longer */
+    if (!(hash = malloc( size * sizeof(*hash) ))) return;
+    for (i = 0; i < size; i++) list_init( &hash[i] );
+
+    for (i = 0; i < device->hash_size; i++)
+    {
+        LIST_FOR_EACH_ENTRY_SAFE( inode, next, &device->inode_hash[i], struct inode, entry )
+        {
+            list_remove( &inode->entry );
+            list_add_tail( &hash[inode->ino & (size - 1)], &inode->entry );
+        }
+    }
+    free( device->inode_hash );
+    device->inode_hash = hash;
+    device->hash_size = size;
+}
+
 
 /****************************************************************/
 /* inode functions */
@@ -1057,9 +1153,10 @@ static void inode_destroy( struct object *obj )
     struct list *ptr;
 
     assert( list_empty(&inode->open) );
-    assert( list_empty(&inode->locks) );
+    assert( !inode->locks );
 
     list_remove( &inode->entry );
+    inode->device->nb_inodes--;
 
     while ((ptr = list_head( &inode->closed )))
     {
@@ -1087,10 +1184,11 @@ static struct inode *get_inode( dev_t dev, ino_t ino, int unix_fd )
 {
     struct device *device;
     struct inode *inode;
-    unsigned int hash = ino % INODE_HASH_SIZE;
+    unsigned int hash;
 
     if (!(device = get_device( dev, unix_fd ))) return NULL;
 
+    hash = ino & (device->hash_size - 1);
     LIST_FOR_EACH_ENTRY( inode, &device->inode_hash[hash], struct inode, entry )
     {
         if (inode->ino == ino)
@@ -1106,9 +1204,10 @@ static struct inode *get_inode( dev_t dev, ino_t ino, int unix_fd )
         inode->device = device;
         inode->ino    = ino;
         list_init( &inode->open );
-        list_init( &inode->locks );
+        inode->locks = NULL;
         list_init( &inode->closed );
-        list_add_head( &device->inode_hash[hash], &inode->entry );
+        if (++device->nb_inodes > device->hash_size) grow_inode_hash( device );
+        list_add_head( &device->inode_hash[ino & (device->hash_size - 1)], &inode->entry );
     }
     else release_object( device );
 
@@ -1118,7 +1217,7 @@ static struct inode *get_inode( dev_t dev, ino_t ino, int unix_fd )
 /* add fd to the inode list of file descriptors to close */
 static void inode_add_closed_fd( struct inode *inode, struct closed_fd *fd )
 {
-    if (!list_empty( &inode->locks ))
+    if (inode->locks)
     {
         list_add_head( &inode->closed, &fd->entry );
     }
@@ -1223,6 +1322,16 @@ static int set_unix_lock( struct fd *fd, file_pos_t start, file_pos_t end, int t
     }
 }
 
+/* The locks of an inode are kept in a treap ordered by start offset, where each node
+ * also stores the highest end offset of its subtree, so that the locks overlapping a
+ * given interval can be found without looking at all the others. */
+
+/* end offset of a lock, where 0 means the end of the file */
+static inline file_pos_t lock_end( file_pos_t end )
+{
+    return end ? end : FILE_POS_T_MAX;
+}
+
 /* check if interval [start;end) overlaps the lock */
 static inline int lock_overlaps( struct file_lock *lock, file_pos_t start, file_pos_t end )
 {
@@ -1231,8 +1340,123 @@ static inline int lock_overlaps( struct file_lock *lock, file_pos_t start, file_
     return 1;
 }
 
-/* remove Unix locks for all bytes in the specified area that are no longer locked */
-static void remove_unix_locks( struct fd *fd, file_pos_t start, file_pos_t end )
+/* order of the locks in the tree: by start offset, then by address to make them unique */
+static inline int lock_less( const struct file_lock *lock1, const struct file_lock *lock2 )
+{
+    if (lock1->start != lock2->start) return lock1->start < lock2->start;
+    return lock1 < lock2;
+}
+
+static void update_lock_node( struct file_lock *lock )
+{
+    lock->max_end = lock_end( lock->end );
+    if (lock->left && lock->left->max_end > lock->max_end) lock->max_end = lock->left->max_end;
+    if (lock->right && lock->right->max_end > lock->max_end) lock->max_end = lock->right->max_end;
+}
+
+/* split a subtree in the locks ordered before the given one, and the others */
+static void split_lock_tree( struct file_lock *root, const struct file_lock *lock,
+                             struct file_lock **before, struct file_lock **after )
+{
+    if (!root)
+    {
+        *before = *after = NULL;
+        return;
+    }
+    if (lock_less( root, lock ))
+    {
+        split_lock_tree( root->right, lock, &root->right, after );
+        *before = root;
+    }
+    else
+    {
+        split_lock_tree( root->left, lock, before, &root->left );
+        *after = root;
+    }
+    update_lock_node( root );
+}
+
+/* merge two subtrees, all the locks in the first one being ordered before the second one */
+static struct file_lock *merge_lock_trees( struct file_lock *before, struct file_lock *after )
+{
+    if (!before) return after;
+    if (!after) return before;
+    if (before->priority > after->priority)
+    {
+        before->right = merge_lock_trees( before->right, after );
+        update_lock_node( before );
+        return before;
+    }
+    after->left = merge_lock_trees( before, after->left );
+    update_lock_node( after );
+    return after;
+}
+
+static struct file_lock *insert_lock_node( struct file_lock *root, struct file_lock *lock )
+{
+    if (!root || lock->priority > root->priority)
+    {
+        split_lock_tree( root, lock, &lock->left, &lock->right );
+        update_lock_node( lock );
+        return lock;
+    }
+    if (lock_less( lock, root )) root->left = insert_lock_node( root->left, lock );
+    else root->right = insert_lock_node( root->right, lock );
+    update_lock_node( root );
+    return root;
+}
+
+static struct file_lock *remove_lock_node( struct file_lock *root, struct file_lock *lock )
+{
+    if (root == lock) return merge_lock_trees( lock->left, lock->right );
+    if (lock_less( lock, root )) root->left = remove_lock_node( root->left, lock );
+    else root->right = remove_lock_node( root->right, lock );
+    update_lock_node( root );
+    return root;
+}
+
+typedef int (*lock_callback)( struct file_lock *lock, void *arg );
+
+/* call the callback for all the locks overlapping [start;end), until it returns non-zero */
+static struct file_lock *find_overlapping_locks( struct file_lock *root, file_pos_t start, file_pos_t end,
+                                                 lock_callback func, void *arg )
+{
+    struct file_lock *ret;
+
+    while (root)
+    {
+        /* no lock in this subtree ends after start */
+        if (root->max_end <= start && root->max_end != FILE_POS_T_MAX) return NULL;
+        if (root->left && (ret = find_overlapping_locks( root->left, start, end, func, arg ))) return ret;
+        /* the following locks all start after the end */
+        if (end && root->start >= end) return NULL;
+        if (lock_overlaps( root, start, end ) && func( root, arg )) return root;
+        root = root->right;
+    }
+    return NULL;
+}
+
+/* find a lock of the fd with the exact same interval */
+static struct file_lock *find_lock( struct file_lock *root, struct fd *fd, file_pos_t start, file_pos_t end )
+{
+    struct file_lock *ret;
+
+    while (root)
+    {
+        if (start < root->start) root = root->left;
+        else if (start > root->start) root = root->right;
+        else
+        {
+            /* locks with the same start can be on both sides */
+            if (root->fd == fd && root->end == end) return root;
+            if ((ret = find_lock( root->left, fd, start, end ))) return ret;
+            root = root->right;
+        }
+    }
+    return NULL;
+}
+
+struct unlock_holes
 {
     struct hole
     {
@@ -1240,9 +1464,68 @@ static void remove_unix_locks( struct fd *fd, file_pos_t start, file_pos_t end )
         struct hole *prev;
         file_pos_t   start;
         file_pos_t   end;
-    } *first, *cur, *next, *buffer;
+    } *first, *next;
+};
 
-    struct list *ptr;
+static int count_unix_lock( struct file_lock *lock, void *arg )
+{
+    int *count = arg;
+    if (lock->start != lock->end) (*count)++;
+    return 0;
+}
+
+/* remove the interval covered by a lock from the list of holes */
+static int remove_lock_from_holes( struct file_lock *lock, void *arg )
+{
+    struct unlock_holes *holes = arg;
+    struct hole *cur, *next;
+
+    if (lock->start == lock->end) return 0;
+
+    /* go through all the holes touched by this lock */
+    for (cur = holes->first; cur; cur = cur->next)
+    {
+        if (cur->end <= lock->start) continue; /* hole is before start of lock */
+        if (lock->end && cur->start >= lock->end) break;  /* hole is after end of lock */
+
+        /* now we know that lock is overlapping hole */
+
+        if (cur->start >= lock->start)  /* lock starts before hole, shrink from start */
+        {
+            cur->start = lock->end;
+            if (cur->start && cur->start < cur->end) break;  /* done with this lock */
+            /* now hole is empty, remove it */
+            if (cur->next) cur->next->prev = cur->prev;
+            if (cur->prev) cur->prev->next = cur->next;
+            else if (!(holes->first = cur->next)) return 1;  /* no more holes at all */
+        }
+        else if (!lock->end || cur->end <= lock->end)  /* lock larger than hole, shrink from end */
+        {
+            cur->end = lock->start;
+            assert( cur->start < cur->end );
+        }
+        else  /* lock is in the middle of hole, split hole in two */
+        {
+            next = holes->next++;
+            next->prev = cur;
+            next->next = cur->next;
+            cur->next = next;
+            next->start = lock->end;
+            next->end = cur->end;
+            cur->end = lock->start;
+            assert( next->start < next->end );
+            assert( cur->end < next->start );
+            break;  /* done with this lock */
+        }
+    }
+    return 0;
+}
+
+/* remove Unix locks for all bytes in the specified area that are no longer locked */
+static void remove_unix_locks( struct fd *fd, file_pos_t start, file_pos_t end )
+{
+    struct unlock_holes holes;
+    struct hole *cur, *buffer;
     int count = 0;
 
     if (!fd->inode) return;
@@ -1252,12 +1535,7 @@ static void remove_unix_locks( struct fd *fd, file_pos_t start, file_pos_t end )
 
     /* count the number of locks overlapping the specified area */
 
-    LIST_FOR_EACH( ptr, &fd->inode->locks )
-    {
-        struct file_lock *lock = LIST_ENTRY( ptr, struct file_lock, inode_entry );
-        if (lock->start == lock->end) continue;
-        if (lock_overlaps( lock, start, end )) count++;
-    }
+    find_overlapping_locks( fd->inode->locks, start, end, count_unix_lock, &count );
 
     if (!count)  /* no locks at all, we can unlock everything */
     {
@@ -1269,71 +1547,29 @@ static void remove_unix_locks( struct fd *fd, file_pos_t start, file_pos_t end )
     /* max. number of holes is number of locks + 1 */
 
     if (!(buffer = malloc( sizeof(*buffer) * (count+1) ))) return;
-    first = buffer;
-    first->next  = NULL;
-    first->prev  = NULL;
-    first->start = start;
-    first->end   = end;
-    next = first + 1;
+    holes.first = buffer;
+    holes.first->next  = NULL;
+    holes.first->prev  = NULL;
+    holes.first->start = start;
+    holes.first->end   = end;
+    holes.next = buffer + 1;
 
     /* build a sorted list of unlocked holes in the specified area */
 
-    LIST_FOR_EACH( ptr, &fd->inode->locks )
-    {
-        struct file_lock *lock = LIST_ENTRY( ptr, struct file_lock, inode_entry );
-        if (lock->start == lock->end) continue;
-        if (!lock_overlaps( lock, start, end )) continue;
-
-        /* go through all the holes touched by this lock */
-        for (cur = first; cur; cur = cur->next)
-        {
-            if (cur->end <= lock->start) continue; /* hole is before start of lock */
-            if (lock->end && cur->start >= lock->end) break;  /* hole is after end of lock */
-
-            /* now we know that lock is overlapping hole */
-
-            if (cur->start >= lock->start)  /* lock starts before hole, shrink from start */
-            {
-                cur->start = lock->end;
-                if (cur->start && cur->start < cur->end) break;  /* done with this lock */
-                /* now hole is empty, remove it */
-                if (cur->next) cur->next->prev = cur->prev;
-                if (cur->prev) cur->prev->next = cur->next;
-                else if (!(first = cur->next)) goto done;  /* no more holes at all */
-            }
-            else if (!lock->end || cur->end <= lock->end)  /* lock larger than hole, shrink from end */
-            {
-                cur->end = lock->start;
-                assert( cur->start < cur->end );
-            }
-            else  /* lock is in the middle of hole, split hole in two */
-            {
-                next->prev = cur;
-                next->next = cur->next;
-                cur->next = next;
-                next->start = lock->end;
-                next->end = cur->end;
-                cur->end = lock->start;
-                assert( next->start < next->end );
-                assert( cur->end < next->start );
-                next++;
-                break;  /* done with this lock */
-            }
-        }
-    }
+    find_overlapping_locks( fd->inode->locks, start, end, remove_lock_from_holes, &holes );
 
     /* clear Unix locks for all the holes */
 
-    for (cur = first; cur; cur = cur->next)
+    for (cur = holes.first; cur; cur = cur->next)
         set_unix_lock( fd, cur->start, cur->end, F_UNLCK );
 
- done:
     free( buffer );
 }
 
 /* create a new lock on a fd */
 static struct file_lock *add_lock( struct fd *fd, int shared, file_pos_t start, file_pos_t end )
 {
+    static unsigned int seed = 0x12345678;
     struct file_lock *lock;
 
     if (!(lock = alloc_object( &file_lock_ops ))) return NULL;
@@ -1349,8 +1585,10 @@ static struct file_lock *add_lock( struct fd *fd, int shared, file_pos_t start,
         release_object( lock );
         return NULL;
     }
+    seed = seed * 1103515245 + 12345;
+    lock->priority = seed;
     list_add_tail( &fd->locks, &lock->fd_entry );
-    list_add_tail( &fd->inode->locks, &lock->inode_entry );
+    fd->inode->locks = insert_lock_node( fd->inode->locks, lock );
     list_add_tail( &lock->process->locks, &lock->proc_entry );
     return lock;
 }
@@ -1361,10 +1599,10 @@ static void remove_lock( struct file_lock *lock, int remove_unix )
     struct inode *inode = lock->fd->inode;
 
     list_remove( &lock->fd_entry );
-    list_remove( &lock->inode_entry );
+    inode->locks = remove_lock_node( inode->locks, lock );
     list_remove( &lock->proc_entry );
     if (remove_unix) remove_unix_locks( lock->fd, lock->start, lock->end );
-    if (list_empty( &inode->locks )) inode_close_pending( inode, 1 );
+    if (!inode->locks) inode_close_pending( inode, 1 );
     lock->process = NULL;
     wake_up( &lock->obj, 0 );
     release_object( lock );
@@ -1398,11 +1636,24 @@ static void remove_fd_locks( struct fd *fd )
     if (start < end) remove_unix_locks( fd, start, end + 1 );
 }
 
+struct lock_request
+{
+    struct fd *fd;
+    int        shared;
+};
+
+static int lock_conflicts( struct file_lock *lock, void *arg )
+{
+    struct lock_request *req = arg;
+    return !req->shared || (!lock->shared && lock->fd != req->fd);
+}
+
 /* add a lock on an fd */
 /* returns handle to wait on */
 obj_handle_t lock_fd( struct fd *fd, file_pos_t start, file_pos_t count, int shared, int wait )
 {
-    struct list *ptr;
+    struct lock_request req;
+    struct file_lock *lock;
     file_pos_t end = start + count;
 
     if (!fd->inode)  /* not a regular file */
@@ -1419,12 +1670,10 @@ obj_handle_t lock_fd( struct fd *fd, file_pos_t start, file_pos_t count, int sha
     }
 
     /* check if another lock on that file overlaps the area */
-    LIST_FOR_EACH( ptr, &fd->inode->locks )
+    req.fd = fd;
+    req.shared = shared;
+    if ((lock = find_overlapping_locks( fd->inode->locks, start, end, lock_conflicts, &req )))
     {
-        struct file_lock *lock = LIST_ENTRY( ptr, struct file_lock, inode_entry );
-        if (!lock_overlaps( lock, start, end )) continue;
-        if (shared && (lock->shared || lock->fd == fd)) continue;
-        /* found one */
         if (!wait)
         {
             set_error( STATUS_FILE_LOCK_CONFLICT );
@@ -1447,20 +1696,14 @@ obj_handle_t lock_fd( struct fd *fd, file_pos_t start, file_pos_t count, int sha
 /* remove a lock on an fd */
 void unlock_fd( struct fd *fd, file_pos_t start, file_pos_t count )
 {
-    struct list *ptr;
+    struct file_lock *lock;
     file_pos_t end = start + count;
 
     /* find an existing lock with the exact same parameters */
-    LIST_FOR_EACH( ptr, &fd->locks )
-    {
-        struct file_lock *lock = LIST_ENTRY( ptr, struct file_lock, fd_entry );
-        if ((lock->start == start) && (lock->end == end))
-        {
-            remove_lock( lock, 1 );
-            return;
-        }
-    }
-    set_error( STATUS_FILE_LOCK_CONFLICT );
+    if (fd->inode && (lock = find_lock( fd->inode->locks, fd, start, end )))
+        remove_lock( lock, 1 );
+    else
+        set_error( STATUS_FILE_LOCK_CONFLICT );
 }
 
 
@@ -1613,6 +1856,7 @@ static struct fd *alloc_fd_object(void)
     fd->fs_locks   = 1;
     fd->poll_index = -1;
     fd->completion = NULL;
+    fd->comp_flags = 0;
     fd->esync_fd   = -1;
     init_async_queue( &fd->read_q );
     init_async_queue( &fd->write_q );
@@ -1649,6 +1893,7 @@ struct fd *alloc_pseudo_fd( const struct fd_ops *fd_user_ops, struct object *use
     fd->fs_locks   = 0;
     fd->poll_index = -1;
     fd->completion = NULL;
+    fd->comp_flags = 0;
     fd->no_fd_status = STATUS_BAD_DEVICE_TYPE;
     fd->esync_fd   = -1;
     init_async_queue( &fd->read_q );
@@ -1760,6 +2005,28 @@ char *dup_fd_name( struct fd *root, const char *name )
     return ret;
 }
 
+/* tell the host page cache how a regular file is going to be accessed */
+static void set_unix_fd_cache_hints( int unix_fd, unsigned int options )
+{
+#ifdef O_DIRECT
+    if (options & FILE_NO_INTERMEDIATE_BUFFERING)
+    {
+        int flags = fcntl( unix_fd, F_GETFL );
+
+        /* not all filesystems support direct I/O, drop the cached pages instead */
+        if (flags != -1 && !fcntl( unix_fd, F_SETFL, flags | O_DIRECT )) return;
+    }
+#endif
+#ifdef HAVE_POSIX_FADVISE
+    if (options & FILE_NO_INTERMEDIATE_BUFFERING)
+        posix_fadvise( unix_fd, 0, 0, POSIX_FADV_DONTNEED );
+    else if (options & FILE_SEQUENTIAL_ONLY)
+        posix_fadvise( unix_fd, 0, 0, POSIX_FADV_SEQUENTIAL );
+    else if (options & FILE_RANDOM_ACCESS)
+        posix_fadvise( unix_fd, 0, 0, POSIX_FADV_RANDOM );
+#endif
+}
+
 /* open() wrapper that returns a struct fd with no fd user set */
 struct fd *open_fd( struct fd *root, const char *name, int flags, mode_t *mode, unsigned int access,
                     unsigned int sharing, unsigned int options )
@@ -1815,6 +2082,9 @@ struct fd *open_fd( struct fd *root, const char *name, int flags, mode_t *mode,
     {
         if (access & FILE_UNIX_READ_ACCESS) rw_mode = O_RDWR;
         else rw_mode = O_WRONLY;
+#ifdef O_DSYNC
+        if (options & FILE_WRITE_THROUGH) rw_mode |= O_DSYNC;
+#endif
     }
     else rw_mode = O_RDONLY;
 
@@ -1896,6 +2166,7 @@ struct fd *open_fd( struct fd *root, const char *name, int flags, mode_t *mode,
             }
             ftruncate( fd->unix_fd, 0 );
         }
+        if (S_ISREG(st.st_mode)) set_unix_fd_cache_hints( fd->unix_fd, options );
     }
     else  /* special file */
     {
@@ -2163,7 +2434,7 @@ static void unmount_device( struct fd *device_fd )
 
     if (!(device = get_device( st.st_rdev, -1 ))) return;
 
-    for (i = 0; i < INODE_HASH_SIZE; i++)
+    for (i = 0; i < device->hash_size; i++)
     {
         LIST_FOR_EACH_ENTRY( inode, &device->inode_hash[i], struct inode, entry )
         {
@@ -2398,6 +2669,7 @@ void fd_copy_completion( struct fd *src, struct fd *dst )
 {
     assert( !dst->completion );
     dst->completion = fd_get_completion( src, &dst->comp_key );
+    dst->comp_flags = src->comp_flags;
 }
 
 /* flush a file buffers */
@@ -2492,6 +2764,7 @@ DECL_HANDLER(get_handle_fd)
         {
             reply->type = fd->fd_ops->get_fd_type( fd );
             reply->options = fd->options;
+            reply->comp_flags = fd->comp_flags;
             reply->access = get_handle_access( current->process, req->handle );
             send_client_fd( current->process, unix_fd, req->handle );
         }
@@ -2605,12 +2878,30 @@ DECL_HANDLER(add_fd_completion)
     struct fd *fd = get_handle_fd_obj( current->process, req->handle, 0 );
     if (fd)
     {
-        if (fd->completion)
+        if (fd->completion && (req->async || !(fd->comp_flags & FILE_SKIP_COMPLETION_PORT_ON_SUCCESS)))
             add_completion( fd->completion, fd->comp_key, req->cvalue, req->status, req->information );
         release_object( fd );
     }
 }
 
+/* set fd completion notification flags */
+DECL_HANDLER(set_fd_completion_mode)
+{
+    struct fd *fd = get_handle_fd_obj( current->process, req->handle, 0 );
+
+    if (fd)
+    {
+        /* the flags can't be cleared once they are set */
+        if (!(req->flags & ~(FILE_SKIP_COMPLETION_PORT_ON_SUCCESS | FILE_SKIP_SET_EVENT_ON_HANDLE |
+                             FILE_SKIP_SET_USER_EVENT_ON_FAST_IO)))
+            fd->comp_flags |= req->flags;
+        else
+            set_error( STATUS_INVALID_PARAMETER );
+        reply->flags = fd->comp_flags;
+        release_object( fd );
+    }
+}
+
 /* set fd disposition information */
 DECL_HANDLER(set_fd_disp_info)
 {
@@ -292,10 +292,63 @@ static int file_get_poll_events( struct fd *fd )
     return events;
 }
 
+struct flush_work
+{
+    struct async *async;     /* async waiting for the flush */
+    int           unix_fd;   /* private copy of the file descriptor */
+    int           error;     /* errno of the fsync call */
+};
+
+/* runs in a worker thread */
+static void flush_work_run( void *private )
+{
+    struct flush_work *work = private;
+    work->error = fsync( work->unix_fd ) == -1 ? errno : 0;
+}
+
+static void flush_work_done( void *private )
+{
+    struct flush_work *work = private;
+    unsigned int status = STATUS_SUCCESS;
+
+    if (work->error)
+    {
+        errno = work->error;
+        file_set_error();
+        status = get_error();
+        clear_error();
+    }
+    async_terminate( work->async, status );
+    release_object( work->async );
+    close( work->unix_fd );
+    free( work );
+}
+
 static int file_flush( struct fd *fd, struct async *async )
 {
+    struct flush_work *work;
     int unix_fd = get_unix_fd( fd );
-    if (unix_fd != -1 && fsync( unix_fd ) == -1)
+
+    if (unix_fd == -1) return 1;
+
+    /* only blocking flushes are deferred, so the caller still sees a synchronous result */
+    if (async_is_blocking( async ) && (work = mem_alloc( sizeof(*work) )))
+    {
+        if ((work->unix_fd = dup( unix_fd )) != -1)
+        {
+            work->async = (struct async *)grab_object( async );
+            if (queue_worker_item( flush_work_run, flush_work_done, work ))
+            {
+                set_error( STATUS_PENDING );
+                return 1;
+            }
+            release_object( async );
+            close( work->unix_fd );
+        }
+        free( work );
+    }
+
+    if (fsync( unix_fd ) == -1)
     {
         file_set_error();
         return 0;
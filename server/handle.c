@@ -42,7 +42,7 @@
 struct handle_entry
 {
     struct object *ptr;       /* object */
-    unsigned int   access;    /* access rights */
+    unsigned int   access;    /* access rights, or index of the next free entry */
 };
 
 struct handle_table
@@ -51,7 +51,7 @@ struct handle_table
     struct process      *process;     /* process owning this table */
     int                  count;       /* number of allocated entries */
     int                  last;        /* last used entry */
-    int                  free;        /* first entry that may be free */
+    int                  free;        /* head of the free entries list, -1 if empty */
     struct handle_entry *entries;     /* handle entries */
 };
 
@@ -209,7 +209,7 @@ struct handle_table *alloc_handle_table( struct process *process, int count )
     table->process = process;
     table->count   = count;
     table->last    = -1;
-    table->free    = 0;
+    table->free    = -1;
     if ((table->entries = mem_alloc( count * sizeof(*table->entries) ))) return table;
     release_object( table );
     return NULL;
@@ -232,21 +232,41 @@ static int grow_handle_table( struct handle_table *table )
     return 1;
 }
 
-/* allocate the first free entry in the handle table */
+/* rebuild the list of free entries up to the last used one */
+static void rebuild_free_list( struct handle_table *table )
+{
+    int i;
+
+    table->free = -1;
+    for (i = table->last; i >= 0; i--)
+    {
+        if (table->entries[i].ptr) continue;
+        table->entries[i].access = table->free;
+        table->free = i;
+    }
+}
+
+/* allocate a free entry in the handle table */
+/* every free entry below the highest one ever used is on the free list, */
+/* so when the list is empty the table is full up to table->last */
 static obj_handle_t alloc_entry( struct handle_table *table, void *obj, unsigned int access )
 {
-    struct handle_entry *entry = table->entries + table->free;
+    struct handle_entry *entry;
     int i;
 
-    for (i = table->free; i <= table->last; i++, entry++) if (!entry->ptr) goto found;
-    if (i >= table->count)
+    if ((i = table->free) != -1)
+    {
+        entry = table->entries + i;
+        table->free = entry->access;
+        if (i > table->last) table->last = i;
+    }
+    else
     {
-        if (!grow_handle_table( table )) return 0;
-        entry = table->entries + i;  /* the entries may have moved */
+        i = table->last + 1;
+        if (i >= table->count && !grow_handle_table( table )) return 0;
+        entry = table->entries + i;
+        table->last = i;
     }
-    table->last = i;
- found:
-    table->free = i + 1;
     entry->ptr    = grab_object_for_handle( obj );
     entry->access = access;
     return index_to_handle(i);
@@ -339,6 +359,7 @@ static void shrink_handle_table( struct handle_table *table )
     struct handle_entry *new_entries;
     int count = table->count;
 
+    /* the trailing entries stay on the free list as long as the array isn't reallocated */
     while (table->last >= 0)
     {
         if (entry->ptr) break;
@@ -351,6 +372,7 @@ static void shrink_handle_table( struct handle_table *table )
     if (!(new_entries = realloc( table->entries, count * sizeof(*new_entries) ))) return;
     table->count   = count;
     table->entries = new_entries;
+    rebuild_free_list( table );
 }
 
 /* copy the handle table of the parent process */
@@ -377,6 +399,7 @@ struct handle_table *copy_handle_table( struct process *process, struct process
             if (ptr->access & RESERVED_INHERIT) grab_object_for_handle( ptr->ptr );
             else ptr->ptr = NULL; /* don't inherit this entry */
         }
+        rebuild_free_list( table );
     }
     /* attempt to shrink the table */
     shrink_handle_table( table );
@@ -396,7 +419,8 @@ unsigned int close_handle( struct process *process, obj_handle_t handle )
     if (!obj->ops->close_handle( obj, process, handle )) return STATUS_HANDLE_NOT_CLOSABLE;
     entry->ptr = NULL;
     table = handle_is_global(handle) ? global_table : process->handles;
-    if (entry < table->entries + table->free) table->free = entry - table->entries;
+    entry->access = table->free;
+    table->free = entry - table->entries;
     if (entry == table->entries + table->last) shrink_handle_table( table );
     release_object_from_handle( obj );
     return STATUS_SUCCESS;
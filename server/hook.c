@@ -150,6 +150,7 @@ static struct hook *add_hook( struct desktop *desktop, struct thread *thread, in
     hook->index  = index;
     list_add_head( &table->hooks[index], &hook->chain );
     if (thread) thread->desktop_users++;
+    update_hooks_shm();
     return hook;
 }
 
@@ -168,6 +169,7 @@ static void free_hook( struct hook *hook )
     release_object( hook->owner );
     list_remove( &hook->chain );
     free( hook );
+    update_hooks_shm();
 }
 
 /* find a hook from its index and proc */
@@ -371,6 +373,21 @@ unsigned int get_active_hooks(void)
     return ret;
 }
 
+/* get a bitmap of the non-empty hook chains, without checking which hooks apply to a thread */
+unsigned int get_hook_chains( struct hook_table *table, struct hook_table *global_hooks )
+{
+    unsigned int ret = 1u << 31;  /* set high bit to indicate that the bitmap is valid */
+    int index;
+
+    for (index = 0; index < NB_HOOKS; index++)
+    {
+        if ((table && !list_empty( &table->hooks[index] )) ||
+            (global_hooks && !list_empty( &global_hooks->hooks[index] )))
+            ret |= 1 << index;
+    }
+    return ret;
+}
+
 /* return the thread that owns the first global hook */
 struct thread *get_first_global_hook( int id )
 {
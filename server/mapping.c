@@ -118,6 +118,7 @@ static const struct object_ops shared_map_ops =
 };
 
 static struct list shared_map_list = LIST_INIT( shared_map_list );
+static struct list image_copy_list = LIST_INIT( image_copy_list );
 
 /* memory view mapped in client address space */
 struct memory_view
@@ -126,6 +127,7 @@ struct memory_view
     struct fd      *fd;              /* fd for mapped file */
     struct ranges  *committed;       /* list of committed ranges in this mapping */
     struct shared_map *shared;       /* temp file for shared PE mapping */
+    struct shared_map *copy;         /* temp file for the unaligned sections of a PE mapping */
     unsigned int    flags;           /* SEC_* flags */
     client_ptr_t    base;            /* view base address (in process addr space) */
     mem_size_t      size;            /* view size */
@@ -141,6 +143,7 @@ struct mapping
     pe_image_info_t image;           /* image info (for PE image mapping) */
     struct ranges  *committed;       /* list of committed ranges in this mapping */
     struct shared_map *shared;       /* temp file for shared PE mapping */
+    struct shared_map *copy;         /* temp file for the unaligned sections of a PE mapping */
 };
 
 static void mapping_dump( struct object *obj, int verbose );
@@ -262,7 +265,7 @@ static int check_current_dir_for_exec(void)
 }
 
 /* create a temp file for anonymous mappings */
-static int create_temp_file( file_pos_t size )
+int create_temp_file( file_pos_t size )
 {
     static int temp_dir_fd = -1;
     char tmpfn[] = "anonmap.XXXXXX";
@@ -316,6 +319,7 @@ static void free_memory_view( struct memory_view *view )
     if (view->fd) release_object( view->fd );
     if (view->committed) release_object( view->committed );
     if (view->shared) release_object( view->shared );
+    if (view->copy) release_object( view->copy );
     list_remove( &view->entry );
     free( view );
 }
@@ -330,11 +334,11 @@ void free_mapped_views( struct process *process )
 }
 
 /* find the shared PE mapping for a given mapping */
-static struct shared_map *get_shared_file( struct fd *fd )
+static struct shared_map *get_shared_file( struct list *list, struct fd *fd )
 {
     struct shared_map *ptr;
 
-    LIST_FOR_EACH_ENTRY( ptr, &shared_map_list, struct shared_map, entry )
+    LIST_FOR_EACH_ENTRY( ptr, list, struct shared_map, entry )
         if (is_same_file_fd( ptr->fd, fd ))
             return (struct shared_map *)grab_object( ptr );
     return NULL;
@@ -446,6 +450,26 @@ static int find_committed_range( struct memory_view *view, file_pos_t start, mem
     return 0;
 }
 
+/* read the raw data of a section, a partial sector at EOF is not an error */
+static int read_section_data( int fd, char *buffer, size_t *size, off_t pos )
+{
+    size_t toread = *size;
+
+    while (toread)
+    {
+        long res = pread( fd, buffer + *size - toread, toread, pos );
+        if (!res && toread < 0x200)
+        {
+            *size -= toread;
+            break;
+        }
+        if (res <= 0) return 0;
+        toread -= res;
+        pos += res;
+    }
+    return 1;
+}
+
 /* allocate and fill the temp file for a shared PE image mapping */
 static int build_shared_mapping( struct mapping *mapping, int fd,
                                  IMAGE_SECTION_HEADER *sec, unsigned int nb_sec )
@@ -458,7 +482,6 @@ static int build_shared_mapping( struct mapping *mapping, int fd,
     off_t shared_pos, read_pos, write_pos;
     char *buffer = NULL;
     int shared_fd;
-    long toread;
 
     /* compute the total size of the shared mapping */
 
@@ -475,7 +498,7 @@ static int build_shared_mapping( struct mapping *mapping, int fd,
     }
     if (!total_size) return 1;  /* nothing to do */
 
-    if ((mapping->shared = get_shared_file( mapping->fd ))) return 1;
+    if ((mapping->shared = get_shared_file( &shared_map_list, mapping->fd ))) return 1;
 
     /* create a temp file for the mapping */
 
@@ -495,19 +518,7 @@ static int build_shared_mapping( struct mapping *mapping, int fd,
         write_pos = shared_pos;
         shared_pos += map_size;
         if (!sec[i].PointerToRawData || !file_size) continue;
-        toread = file_size;
-        while (toread)
-        {
-            long res = pread( fd, buffer + file_size - toread, toread, read_pos );
-            if (!res && toread < 0x200)  /* partial sector at EOF is not an error */
-            {
-                file_size -= toread;
-                break;
-            }
-            if (res <= 0) goto error;
-            toread -= res;
-            read_pos += res;
-        }
+        if (!read_section_data( fd, buffer, &file_size, read_pos )) goto error;
         if (pwrite( shared_fd, buffer, file_size, write_pos ) != file_size) goto error;
     }
 
@@ -525,6 +536,64 @@ static int build_shared_mapping( struct mapping *mapping, int fd,
     return 0;
 }
 
+/* the sections whose raw data is not page-aligned in the file can't be mapped
+ * directly, so they are copied to a temp file at their virtual address; this
+ * lets them be shared between all the processes mapping the same image */
+static void build_image_copy( struct mapping *mapping, int fd,
+                              IMAGE_SECTION_HEADER *sec, unsigned int nb_sec )
+{
+    struct shared_map *copy;
+    struct file *file;
+    unsigned int i;
+    size_t file_size, map_size, max_size = 0;
+    off_t read_pos;
+    char *buffer = NULL;
+    int copy_fd;
+
+    if (mapping->image.image_flags & IMAGE_FLAGS_ImageMappedFlat) return;
+
+    for (i = 0; i < nb_sec; i++)
+    {
+        if ((sec[i].Characteristics & IMAGE_SCN_MEM_SHARED) &&
+            (sec[i].Characteristics & IMAGE_SCN_MEM_WRITE)) continue;
+        get_section_sizes( &sec[i], &map_size, &read_pos, &file_size );
+        if (!sec[i].PointerToRawData || !file_size || !(read_pos & page_mask)) continue;
+        if (sec[i].VirtualAddress & page_mask) return;
+        if (sec[i].VirtualAddress + file_size > mapping->image.map_size) return;
+        if (file_size > max_size) max_size = file_size;
+    }
+    if (!max_size) return;  /* nothing to do */
+
+    if ((mapping->copy = get_shared_file( &image_copy_list, mapping->fd ))) return;
+
+    if ((copy_fd = create_temp_file( mapping->image.map_size )) == -1) return;
+    if (!(file = create_file_for_fd( copy_fd, FILE_GENERIC_READ|FILE_GENERIC_WRITE, 0 ))) return;
+
+    if (!(buffer = malloc( max_size ))) goto error;
+
+    for (i = 0; i < nb_sec; i++)
+    {
+        if ((sec[i].Characteristics & IMAGE_SCN_MEM_SHARED) &&
+            (sec[i].Characteristics & IMAGE_SCN_MEM_WRITE)) continue;
+        get_section_sizes( &sec[i], &map_size, &read_pos, &file_size );
+        if (!sec[i].PointerToRawData || !file_size || !(read_pos & page_mask)) continue;
+        if (!read_section_data( fd, buffer, &file_size, read_pos )) goto error;
+        if (pwrite( copy_fd, buffer, file_size, sec[i].VirtualAddress ) != file_size) goto error;
+    }
+
+    if (!(copy = alloc_object( &shared_map_ops ))) goto error;
+    copy->fd = (struct fd *)grab_object( mapping->fd );
+    copy->file = file;
+    list_add_head( &image_copy_list, &copy->entry );
+    mapping->copy = copy;
+    free( buffer );
+    return;
+
+ error:
+    release_object( file );
+    free( buffer );
+}
+
 /* load the CLR header from its section */
 static int load_clr_header( IMAGE_COR20_HEADER *hdr, size_t va, size_t size, int unix_fd,
                             IMAGE_SECTION_HEADER *sec, unsigned int nb_sec )
@@ -712,6 +781,7 @@ static unsigned int get_image_params( struct mapping *mapping, file_pos_t file_s
 
     if (!build_shared_mapping( mapping, unix_fd, sec, nt.FileHeader.NumberOfSections ))
         return STATUS_INVALID_FILE_FOR_SECTION;
+    build_image_copy( mapping, unix_fd, sec, nt.FileHeader.NumberOfSections );
 
     return STATUS_SUCCESS;
 }
@@ -774,6 +844,7 @@ static struct object *create_mapping( struct object *root, const struct unicode_
     mapping->size        = size;
     mapping->fd          = NULL;
     mapping->shared      = NULL;
+    mapping->copy        = NULL;
     mapping->committed   = NULL;
 
     if (!(mapping->flags = get_mapping_flags( handle, flags ))) goto error;
@@ -904,6 +975,7 @@ static void mapping_destroy( struct object *obj )
     if (mapping->fd) release_object( mapping->fd );
     if (mapping->committed) release_object( mapping->committed );
     if (mapping->shared) release_object( mapping->shared );
+    if (mapping->copy) release_object( mapping->copy );
 }
 
 static enum server_fd_type mapping_get_fd_type( struct fd *fd )
@@ -972,6 +1044,8 @@ DECL_HANDLER(get_mapping_info)
     if (mapping->shared)
         reply->shared_file = alloc_handle( current->process, mapping->shared->file,
                                            GENERIC_READ|GENERIC_WRITE, 0 );
+    if (mapping->copy)
+        reply->copy_file = alloc_handle( current->process, mapping->copy->file, GENERIC_READ, 0 );
     release_object( mapping );
 }
 
@@ -1023,6 +1097,7 @@ DECL_HANDLER(map_view)
         view->fd        = !is_fd_removable( mapping->fd ) ? (struct fd *)grab_object( mapping->fd ) : NULL;
         view->committed = mapping->committed ? (struct ranges *)grab_object( mapping->committed ) : NULL;
         view->shared    = mapping->shared ? (struct shared_map *)grab_object( mapping->shared ) : NULL;
+        view->copy      = mapping->copy ? (struct shared_map *)grab_object( mapping->copy ) : NULL;
         list_add_tail( &current->process->views, &view->entry );
     }
 
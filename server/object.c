@@ -43,10 +43,13 @@
 #include "security.h"
 
 
+#define NAMESPACE_MAX_LOAD 2  /* average chain length that triggers a resize check */
+
 struct namespace
 {
-    unsigned int        hash_size;       /* size of hash table */
-    struct list         names[1];        /* array of hash entry lists */
+    unsigned int        hash_size;       /* size of hash table, a power of 2 */
+    unsigned int        count;           /* upper bound of the number of names, exact after a resize check */
+    struct list        *names;           /* array of hash entry lists */
 };
 
 
@@ -127,19 +130,56 @@ void *memdup( const void *data, size_t len )
 
 /*****************************************************************/
 
-static int get_name_hash( const struct namespace *namespace, const WCHAR *name, data_size_t len )
+static unsigned int hash_name( const WCHAR *name, data_size_t len )
 {
-    WCHAR hash = 0;
+    unsigned int hash = 0x811c9dc5;  /* FNV-1a */
+
     len /= sizeof(WCHAR);
-    while (len--) hash ^= tolowerW(*name++);
-    return hash % namespace->hash_size;
+    while (len--) hash = (hash ^ tolowerW(*name++)) * 0x01000193;
+    return hash ^ (hash >> 16);
+}
+
+static unsigned int get_name_hash( const struct namespace *namespace, const WCHAR *name, data_size_t len )
+{
+    return hash_name( name, len ) & (namespace->hash_size - 1);
+}
+
+/* grow the hash table as names get added to keep the chains short; names are unlinked
+ * without the namespace being notified, so the actual count is only known here */
+static void resize_namespace( struct namespace *namespace )
+{
+    unsigned int i, count = 0, size = namespace->hash_size;
+    struct object_name *ptr, *next;
+    struct list *names;
+
+    for (i = 0; i < namespace->hash_size; i++) count += list_count( &namespace->names[i] );
+    namespace->count = count;
+    if (count <= namespace->hash_size) return;
+
+    while (size < count) size *= 2;
+    /* not a fatal error, the chains just get longer */
+    if (!(names = malloc( size * sizeof(*names) ))) return;
+    for (i = 0; i < size; i++) list_init( &names[i] );
+
+    for (i = 0; i < namespace->hash_size; i++)
+    {
+        LIST_FOR_EACH_ENTRY_SAFE( ptr, next, &namespace->names[i], struct object_name, entry )
+        {
+            list_remove( &ptr->entry );
+            list_add_tail( &names[hash_name( ptr->name, ptr->len ) & (size - 1)], &ptr->entry );
+        }
+    }
+    free( namespace->names );
+    namespace->names = names;
+    namespace->hash_size = size;
 }
 
 void namespace_add( struct namespace *namespace, struct object_name *ptr )
 {
-    int hash = get_name_hash( namespace, ptr->name, ptr->len );
+    unsigned int hash = get_name_hash( namespace, ptr->name, ptr->len );
 
     list_add_head( &namespace->names[hash], &ptr->entry );
+    if (++namespace->count > namespace->hash_size * NAMESPACE_MAX_LOAD) resize_namespace( namespace );
 }
 
 /* allocate a name for an object */
@@ -477,21 +517,33 @@ struct object *find_object_index( const struct namespace *namespace, unsigned in
     return NULL;
 }
 
-/* allocate a namespace */
+/* allocate a namespace; the hash size is only a hint, the table grows as needed */
 struct namespace *create_namespace( unsigned int hash_size )
 {
     struct namespace *namespace;
-    unsigned int i;
+    unsigned int i, size = 1;
 
-    namespace = mem_alloc( sizeof(*namespace) + (hash_size - 1) * sizeof(namespace->names[0]) );
-    if (namespace)
+    while (size < hash_size) size *= 2;
+    if (!(namespace = mem_alloc( sizeof(*namespace) ))) return NULL;
+    if (!(namespace->names = mem_alloc( size * sizeof(*namespace->names) )))
     {
-        namespace->hash_size      = hash_size;
-        for (i = 0; i < hash_size; i++) list_init( &namespace->names[i] );
+        free( namespace );
+        return NULL;
     }
+    namespace->hash_size = size;
+    namespace->count     = 0;
+    for (i = 0; i < size; i++) list_init( &namespace->names[i] );
     return namespace;
 }
 
+/* free a namespace, the names must have been unlinked already */
+void free_namespace( struct namespace *namespace )
+{
+    if (!namespace) return;
+    free( namespace->names );
+    free( namespace );
+}
+
 /* functions for unimplemented/default object operations */
 
 struct object_type *no_get_type( struct object *obj )
@@ -539,6 +539,8 @@ struct thread *create_process( int fd, struct thread *parent_thread, int inherit
     process->rawinput_mouse  = NULL;
     process->rawinput_kbd    = NULL;
     process->esync_fd        = -1;
+    process->req_count       = 0;
+    process->req_time        = 0;
     list_init( &process->thread_list );
     list_init( &process->locks );
     list_init( &process->asyncs );
@@ -1393,45 +1395,171 @@ DECL_HANDLER(get_process_info)
     }
 }
 
+#ifdef linux
+/* read the memory usage of a process from /proc, return 0 if not available */
+static int read_process_vm_counters( struct process *process, process_info_t *info )
+{
+    FILE *f;
+    char proc_path[32], line[256];
+    unsigned long value;
+
+    if (process->unix_pid == -1) return 0;
+    sprintf( proc_path, "/proc/%u/status", process->unix_pid );
+    if (!(f = fopen( proc_path, "r" ))) return 0;
+    while (fgets( line, sizeof(line), f ))
+    {
+        if (sscanf( line, "VmPeak: %lu", &value ))
+            info->peak_virtual_size = (mem_size_t)value * 1024;
+        else if (sscanf( line, "VmSize: %lu", &value ))
+            info->virtual_size = (mem_size_t)value * 1024;
+        else if (sscanf( line, "VmHWM: %lu", &value ))
+            info->peak_working_set_size = (mem_size_t)value * 1024;
+        else if (sscanf( line, "VmRSS: %lu", &value ))
+            info->working_set_size = (mem_size_t)value * 1024;
+        else if (sscanf( line, "RssAnon: %lu", &value ))
+            info->pagefile_usage += (mem_size_t)value * 1024;
+        else if (sscanf( line, "VmSwap: %lu", &value ))
+            info->pagefile_usage += (mem_size_t)value * 1024;
+    }
+    fclose( f );
+    return 1;
+}
+
+/* read the cpu times of a process from /proc */
+static void read_process_times( struct process *process, process_info_t *info )
+{
+    static long clock_ticks;
+    FILE *f;
+    char proc_path[32], line[1024], *p;
+    unsigned long utime, stime;
+
+    if (process->unix_pid == -1) return;
+    if (!clock_ticks && (clock_ticks = sysconf( _SC_CLK_TCK )) <= 0) clock_ticks = 100;
+    sprintf( proc_path, "/proc/%u/stat", process->unix_pid );
+    if (!(f = fopen( proc_path, "r" ))) return;
+    /* the command name may contain spaces, skip to its closing parenthesis */
+    if (fgets( line, sizeof(line), f ) && (p = strrchr( line, ')' )) &&
+        sscanf( p + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime, &stime ) == 2)
+    {
+        info->user_time   = (timeout_t)utime * TICKS_PER_SEC / clock_ticks;
+        info->kernel_time = (timeout_t)stime * TICKS_PER_SEC / clock_ticks;
+    }
+    fclose( f );
+}
+#else
+static int read_process_vm_counters( struct process *process, process_info_t *info )
+{
+    return 0;
+}
+
+static void read_process_times( struct process *process, process_info_t *info )
+{
+}
+#endif
+
 /* retrieve information about a process memory usage */
 DECL_HANDLER(get_process_vm_counters)
 {
     struct process *process = get_process_from_handle( req->handle, PROCESS_QUERY_LIMITED_INFORMATION );
+    process_info_t info;
 
     if (!process) return;
+    memset( &info, 0, sizeof(info) );
+    if (read_process_vm_counters( process, &info ))
+    {
+        reply->peak_virtual_size     = info.peak_virtual_size;
+        reply->virtual_size          = info.virtual_size;
+        reply->peak_working_set_size = info.peak_working_set_size;
+        reply->working_set_size      = info.working_set_size;
+        reply->pagefile_usage        = info.pagefile_usage;
+        reply->peak_pagefile_usage   = info.pagefile_usage;
+    }
 #ifdef linux
-    if (process->unix_pid != -1)
+    else set_error( STATUS_ACCESS_DENIED );
+#endif
+    release_object( process );
+}
+
+/* number of threads of a process that are not terminated */
+static int get_process_thread_count( struct process *process )
+{
+    struct thread *thread;
+    int count = 0;
+
+    LIST_FOR_EACH_ENTRY( thread, &process->thread_list, struct thread, proc_entry )
+        if (thread->state != TERMINATED) count++;
+    return count;
+}
+
+/* length of the exe name of a process returned by list_processes */
+static data_size_t get_process_name_len( struct process *process )
+{
+    struct process_dll *exe_module = get_process_exe_module( process );
+
+    if (!exe_module || !exe_module->filename) return 0;
+    return exe_module->namelen;
+}
+
+/* retrieve all the running processes and their threads */
+DECL_HANDLER(list_processes)
+{
+    struct process *process;
+    struct thread *thread;
+    data_size_t pos = 0;
+    char *buffer;
+
+    reply->info_size = 0;
+    reply->process_count = 0;
+    LIST_FOR_EACH_ENTRY( process, &process_list, struct process, entry )
+    {
+        if (!process->running_threads) continue;
+        reply->info_size += sizeof(process_info_t) + ((get_process_name_len( process ) + 7) & ~7) +
+                            get_process_thread_count( process ) * sizeof(thread_info_t);
+        reply->process_count++;
+    }
+
+    if (reply->info_size > get_reply_max_size())
+    {
+        set_error( STATUS_INFO_LENGTH_MISMATCH );
+        return;
+    }
+    if (!(buffer = set_reply_data_size( reply->info_size ))) return;
+    memset( buffer, 0, reply->info_size );
+
+    LIST_FOR_EACH_ENTRY( process, &process_list, struct process, entry )
     {
-        FILE *f;
-        char proc_path[32], line[256];
-        unsigned long value;
+        process_info_t *info = (process_info_t *)(buffer + pos);
+        struct process_dll *exe_module = get_process_exe_module( process );
 
-        sprintf( proc_path, "/proc/%u/status", process->unix_pid );
-        if ((f = fopen( proc_path, "r" )))
+        if (!process->running_threads) continue;
+        info->start_time   = process->start_time;
+        info->pid          = get_process_id( process );
+        info->parent_pid   = process->parent_id;
+        info->unix_pid     = process->unix_pid;
+        info->priority     = process->priority;
+        info->handle_count = get_handle_table_count( process );
+        info->thread_count = get_process_thread_count( process );
+        info->name_len     = get_process_name_len( process );
+        read_process_vm_counters( process, info );
+        read_process_times( process, info );
+        pos += sizeof(*info);
+
+        if (info->name_len) memcpy( buffer + pos, exe_module->filename, info->name_len );
+        pos += (info->name_len + 7) & ~7;
+
+        LIST_FOR_EACH_ENTRY( thread, &process->thread_list, struct thread, proc_entry )
         {
-            while (fgets( line, sizeof(line), f ))
-            {
-                if (sscanf( line, "VmPeak: %lu", &value ))
-                    reply->peak_virtual_size = (mem_size_t)value * 1024;
-                else if (sscanf( line, "VmSize: %lu", &value ))
-                    reply->virtual_size = (mem_size_t)value * 1024;
-                else if (sscanf( line, "VmHWM: %lu", &value ))
-                    reply->peak_working_set_size = (mem_size_t)value * 1024;
-                else if (sscanf( line, "VmRSS: %lu", &value ))
-                    reply->working_set_size = (mem_size_t)value * 1024;
-                else if (sscanf( line, "RssAnon: %lu", &value ))
-                    reply->pagefile_usage += (mem_size_t)value * 1024;
-                else if (sscanf( line, "VmSwap: %lu", &value ))
-                    reply->pagefile_usage += (mem_size_t)value * 1024;
-            }
-            reply->peak_pagefile_usage = reply->pagefile_usage;
-            fclose( f );
+            thread_info_t *thread_info = (thread_info_t *)(buffer + pos);
+
+            if (thread->state == TERMINATED) continue;
+            thread_info->start_time       = thread->creation_time;
+            thread_info->tid              = get_thread_id( thread );
+            thread_info->base_priority    = thread->priority;
+            thread_info->current_priority = thread->priority;
+            thread_info->unix_tid         = thread->unix_tid;
+            pos += sizeof(*thread_info);
         }
-        else set_error( STATUS_ACCESS_DENIED );
     }
-    else set_error( STATUS_ACCESS_DENIED );
-#endif
-    release_object( process );
 }
 
 static void set_process_affinity( struct process *process, affinity_t affinity )
@@ -1487,6 +1615,21 @@ DECL_HANDLER(read_process_memory)
     release_object( process );
 }
 
+/* get the Unix pid of a process for direct memory access */
+DECL_HANDLER(get_process_vm_pid)
+{
+    struct process *process;
+
+    if (!req->access || (req->access & ~(PROCESS_VM_READ | PROCESS_VM_WRITE)))
+    {
+        set_error( STATUS_INVALID_PARAMETER );
+        return;
+    }
+    if (!(process = get_process_from_handle( req->handle, req->access ))) return;
+    reply->unix_pid = process->running_threads ? process->unix_pid : -1;
+    release_object( process );
+}
+
 /* write data to a process address space */
 DECL_HANDLER(write_process_memory)
 {
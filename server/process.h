@@ -96,6 +96,8 @@ struct process
     const struct rawinput_device *rawinput_mouse; /* rawinput mouse device, if any */
     const struct rawinput_device *rawinput_kbd;   /* rawinput keyboard device, if any */
     int                  esync_fd;        /* esync file descriptor (signaled on exit) */
+    unsigned int         req_count;       /* number of server requests made by the process */
+    unsigned long long   req_time;        /* time spent handling them, in nanoseconds */
 };
 
 struct process_snapshot
@@ -25,6 +25,9 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
 #ifdef HAVE_POLL_H
 # include <poll.h>
 #endif
@@ -142,6 +145,9 @@ struct msg_queue
     struct hook_table     *hooks;           /* hook table */
     timeout_t              last_get_msg;    /* time of last get message call */
     int                    esync_fd;        /* esync file descriptor (signalled on message) */
+    struct file           *shm_file;        /* file backing the shared status bits */
+    queue_shm_t           *shm;             /* status bits shared with the client */
+    struct list            shm_entry;       /* entry in the list of queues with shared memory */
 };
 
 struct hotkey
@@ -165,6 +171,9 @@ static void msg_queue_poll_event( struct fd *fd, int event );
 static void thread_input_dump( struct object *obj, int verbose );
 static void thread_input_destroy( struct object *obj );
 static void timer_callback( void *private );
+static void update_queue_hooks_shm( struct msg_queue *queue );
+
+static struct list shm_queues = LIST_INIT(shm_queues);
 
 static const struct object_ops msg_queue_ops =
 {
@@ -304,6 +313,8 @@ static struct msg_queue *create_msg_queue( struct thread *thread, struct thread_
         queue->hooks           = NULL;
         queue->last_get_msg    = current_time;
         queue->esync_fd        = -1;
+        queue->shm_file        = NULL;
+        queue->shm             = NULL;
         list_init( &queue->send_result );
         list_init( &queue->callback_result );
         list_init( &queue->pending_timers );
@@ -332,19 +343,23 @@ void free_msg_queue( struct thread *thread )
 static int assign_thread_input( struct thread *thread, struct thread_input *new_input )
 {
     struct msg_queue *queue = thread->queue;
+    struct thread_input *old_input;
 
     if (!queue)
     {
         thread->queue = create_msg_queue( thread, new_input );
         return thread->queue != NULL;
     }
-    if (queue->input)
-    {
-        queue->input->cursor_count -= queue->cursor_count;
-        release_object( queue->input );
-    }
+    old_input = queue->input;
     queue->input = (struct thread_input *)grab_object( new_input );
     new_input->cursor_count += queue->cursor_count;
+    if (old_input)
+    {
+        old_input->cursor_count -= queue->cursor_count;
+        release_object( old_input );
+    }
+    /* the global hooks come from the desktop of the input */
+    update_queue_hooks_shm( queue );
     return 1;
 }
 
@@ -433,9 +448,29 @@ struct hook_table *get_queue_hooks( struct thread *thread )
 void set_queue_hooks( struct thread *thread, struct hook_table *hooks )
 {
     struct msg_queue *queue = thread->queue;
+    struct hook_table *old_hooks;
+
     if (!queue && !(queue = create_msg_queue( thread, NULL ))) return;
-    if (queue->hooks) release_object( queue->hooks );
+    old_hooks = queue->hooks;
     queue->hooks = hooks;
+    update_queue_hooks_shm( queue );
+    if (old_hooks) release_object( old_hooks );
+}
+
+/* update the bitmap of hook chains shared with the client */
+static void update_queue_hooks_shm( struct msg_queue *queue )
+{
+    if (!queue->shm) return;
+    queue->shm->hook_chains = get_hook_chains( queue->hooks, queue->input->desktop->global_hooks );
+}
+
+/* update the hook chains bitmap of all the queues, called when a hook is added or freed */
+void update_hooks_shm(void)
+{
+    struct msg_queue *queue;
+
+    LIST_FOR_EACH_ENTRY( queue, &shm_queues, struct msg_queue, shm_entry )
+        update_queue_hooks_shm( queue );
 }
 
 /* check the queue status */
@@ -444,11 +479,20 @@ static inline int is_signaled( struct msg_queue *queue )
     return ((queue->wake_bits & queue->wake_mask) || (queue->changed_bits & queue->changed_mask));
 }
 
+/* publish the queue bits to the client */
+static inline void update_queue_shm( struct msg_queue *queue )
+{
+    if (!queue->shm) return;
+    queue->shm->wake_bits    = queue->wake_bits;
+    queue->shm->changed_bits = queue->changed_bits;
+}
+
 /* set some queue bits */
 static inline void set_queue_bits( struct msg_queue *queue, unsigned int bits )
 {
     queue->wake_bits |= bits;
     queue->changed_bits |= bits;
+    update_queue_shm( queue );
     if (is_signaled( queue )) wake_up( &queue->obj, 0 );
 }
 
@@ -457,6 +501,7 @@ static inline void clear_queue_bits( struct msg_queue *queue, unsigned int bits
 {
     queue->wake_bits &= ~bits;
     queue->changed_bits &= ~bits;
+    update_queue_shm( queue );
 
     if (do_esync() && !is_signaled( queue ))
         esync_clear( queue->esync_fd );
@@ -981,6 +1026,7 @@ static void msg_queue_destroy( struct object *obj )
     struct hotkey *hotkey, *hotkey2;
     int i;
 
+    if (queue->shm) list_remove( &queue->shm_entry );
     cleanup_results( queue );
     for (i = 0; i < NB_MSG_KINDS; i++) empty_msg_list( &queue->msg_list[i] );
 
@@ -1010,6 +1056,8 @@ static void msg_queue_destroy( struct object *obj )
     release_object( queue->input );
     if (queue->hooks) release_object( queue->hooks );
     if (queue->fd) release_object( queue->fd );
+    if (queue->shm_file) release_object( queue->shm_file );
+    if (queue->shm) munmap( queue->shm, sizeof(*queue->shm) );
 
     if (do_esync())
         close( queue->esync_fd );
@@ -2294,6 +2342,7 @@ DECL_HANDLER(get_queue_status)
         reply->wake_bits    = queue->wake_bits;
         reply->changed_bits = queue->changed_bits;
         queue->changed_bits &= ~req->clear_bits;
+        update_queue_shm( queue );
 
         if (do_esync() && !is_signaled( queue ))
             esync_clear( queue->esync_fd );
@@ -2302,6 +2351,38 @@ DECL_HANDLER(get_queue_status)
 }
 
 
+/* get a handle to the shared memory holding the current message queue status */
+DECL_HANDLER(get_queue_shm)
+{
+    struct msg_queue *queue = get_current_queue();
+    void *ptr;
+    int fd;
+
+    if (!queue) return;
+    if (!queue->shm_file)
+    {
+        if ((fd = create_temp_file( sizeof(*queue->shm) )) == -1) return;
+        ptr = mmap( NULL, sizeof(*queue->shm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+        if (ptr == MAP_FAILED)
+        {
+            file_set_error();
+            close( fd );
+            return;
+        }
+        if (!(queue->shm_file = create_file_for_fd( fd, FILE_GENERIC_READ, FILE_SHARE_READ )))
+        {
+            munmap( ptr, sizeof(*queue->shm) );
+            return;
+        }
+        queue->shm = ptr;
+        list_add_tail( &shm_queues, &queue->shm_entry );
+        update_queue_shm( queue );
+        update_queue_hooks_shm( queue );
+    }
+    reply->handle = alloc_handle( current->process, queue->shm_file, FILE_GENERIC_READ, 0 );
+}
+
+
 /* send a message to a thread queue */
 DECL_HANDLER(send_message)
 {
@@ -2356,6 +2437,12 @@ DECL_HANDLER(send_message)
                 free_message( msg );
                 break;
             }
+            if (req->wake_mask && send_queue && msg->type != MSG_CALLBACK)
+            {
+                /* same as a set_queue_mask request with skip_wait, saves a round trip for the sender */
+                send_queue->wake_mask = send_queue->changed_mask = req->wake_mask;
+                if (is_signaled( send_queue )) send_queue->wake_mask = send_queue->changed_mask = 0;
+            }
             /* fall through */
         case MSG_NOTIFY:
             list_add_tail( &recv_queue->msg_list[SEND_MESSAGE], &msg->entry );
@@ -2382,45 +2469,123 @@ DECL_HANDLER(send_message)
     release_object( thread );
 }
 
-/* send a hardware message to a thread queue */
-DECL_HANDLER(send_hardware_message)
+/* queue a hardware input, return nonzero if the sender has to wait for a low-level hook */
+static int queue_hardware_input( struct desktop *desktop, user_handle_t win, const hw_input_t *input,
+                                 unsigned int flags, struct msg_queue *sender )
 {
     struct thread *thread = NULL;
-    struct desktop *desktop;
-    struct msg_queue *sender = get_current_queue();
-    data_size_t size = min( 256, get_reply_max_size() );
+    int wait = 0;
 
-    if (!(desktop = get_thread_desktop( current, 0 ))) return;
-
-    if (req->win)
+    if (win)
     {
-        if (!(thread = get_window_thread( req->win ))) return;
+        if (!(thread = get_window_thread( win ))) return 0;
         if (desktop != thread->queue->input->desktop)
         {
             /* don't allow queuing events to a different desktop */
-            release_object( desktop );
-            return;
+            release_object( thread );
+            return 0;
         }
     }
 
-    reply->prev_x = desktop->cursor.x;
-    reply->prev_y = desktop->cursor.y;
-
-    switch (req->input.type)
+    switch (input->type)
     {
     case INPUT_MOUSE:
-        reply->wait = queue_mouse_message( desktop, req->win, &req->input, req->flags, sender );
+        wait = queue_mouse_message( desktop, win, input, flags, sender );
         break;
     case INPUT_KEYBOARD:
-        reply->wait = queue_keyboard_message( desktop, req->win, &req->input, req->flags, sender );
+        wait = queue_keyboard_message( desktop, win, input, flags, sender );
         break;
     case INPUT_HARDWARE:
-        queue_custom_hardware_message( desktop, req->win, &req->input );
+        queue_custom_hardware_message( desktop, win, input );
         break;
     default:
         set_error( STATUS_INVALID_PARAMETER );
     }
     if (thread) release_object( thread );
+    return wait;
+}
+
+/* check if a plain mouse motion can be merged into the next input of a batch */
+static int can_coalesce_motion( const hw_input_entry_t *entry, const hw_input_entry_t *next )
+{
+    const unsigned int move_flags = MOUSEEVENTF_MOVE | MOUSEEVENTF_ABSOLUTE | MOUSEEVENTF_VIRTUALDESK;
+
+    /* raw input clients want to see every motion */
+    if (current->process->rawinput_mouse) return 0;
+    if (entry->input.type != INPUT_MOUSE || next->input.type != INPUT_MOUSE) return 0;
+    if (entry->win != next->win) return 0;
+    if (!(entry->input.mouse.flags & MOUSEEVENTF_MOVE)) return 0;
+    if (entry->input.mouse.flags & ~move_flags) return 0;
+    return entry->input.mouse.flags == next->input.mouse.flags;
+}
+
+/* send a hardware message to a thread queue */
+DECL_HANDLER(send_hardware_message)
+{
+    struct desktop *desktop;
+    struct msg_queue *sender = get_current_queue();
+    data_size_t size = min( 256, get_reply_max_size() );
+
+    if (!(desktop = get_thread_desktop( current, 0 ))) return;
+
+    reply->prev_x = desktop->cursor.x;
+    reply->prev_y = desktop->cursor.y;
+
+    reply->wait = queue_hardware_input( desktop, req->win, &req->input, req->flags, sender );
+
+    reply->new_x = desktop->cursor.x;
+    reply->new_y = desktop->cursor.y;
+    set_reply_data( desktop->keystate, size );
+    release_object( desktop );
+}
+
+/* send a batch of hardware messages to the thread queues */
+DECL_HANDLER(send_hardware_messages)
+{
+    const hw_input_entry_t *entries = get_req_data();
+    unsigned int i, count = get_req_data_size() / sizeof(*entries);
+    struct desktop *desktop;
+    struct msg_queue *sender = get_current_queue();
+    data_size_t size = min( 256, get_reply_max_size() );
+    int dx = 0, dy = 0, wait = 0;
+    hw_input_t input;
+
+    if (!(desktop = get_thread_desktop( current, 0 ))) return;
+
+    reply->prev_x = desktop->cursor.x;
+    reply->prev_y = desktop->cursor.y;
+
+    /* stop after an input that has to wait for a hook, the client sends the rest again */
+    for (i = 0; i < count && !wait; i++)
+    {
+        input = entries[i].input;
+        if (input.type == INPUT_MOUSE && !(input.mouse.flags & MOUSEEVENTF_ABSOLUTE))
+        {
+            input.mouse.x += dx;
+            input.mouse.y += dy;
+        }
+        dx = dy = 0;
+
+        if (i + 1 < count && can_coalesce_motion( &entries[i], &entries[i + 1] ))
+        {
+            /* an absolute position is superseded by the next one, a relative one is accumulated */
+            if (!(input.mouse.flags & MOUSEEVENTF_ABSOLUTE))
+            {
+                dx = input.mouse.x;
+                dy = input.mouse.y;
+            }
+            continue;
+        }
+
+        wait = queue_hardware_input( desktop, entries[i].win, &input, req->flags, sender );
+        if (get_error())
+        {
+            i++;
+            break;
+        }
+    }
+    reply->count = i;
+    reply->wait  = wait;
 
     reply->new_x = desktop->cursor.x;
     reply->new_y = desktop->cursor.y;
@@ -2456,6 +2621,10 @@ DECL_HANDLER(get_message)
     queue->last_get_msg = current_time;
     if (!filter) filter = QS_ALLINPUT;
 
+    /* reply to the previous sent message first */
+    if (req->reply && queue->recv_result)
+        reply_message( queue, req->result, 0, 1, get_req_data(), get_req_data_size() );
+
     /* first check for sent messages */
     if ((ptr = list_head( &queue->msg_list[SEND_MESSAGE] )))
     {
@@ -2472,6 +2641,7 @@ DECL_HANDLER(get_message)
     }
     if (filter & QS_INPUT) queue->changed_bits &= ~QS_INPUT;
     if (filter & QS_PAINT) queue->changed_bits &= ~QS_PAINT;
+    update_queue_shm( queue );
 
     /* then check for posted messages */
     if ((filter & QS_POSTMESSAGE) &&
@@ -35,6 +35,9 @@
 #include <string.h>
 #include <stdlib.h>
 #include <sys/stat.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 #include <unistd.h>
 
 #include "ntstatus.h"
@@ -87,6 +90,7 @@ struct key
 #define KEY_SYMLINK  0x0008  /* key is a symbolic link */
 #define KEY_WOW64    0x0010  /* key contains a Wow6432Node subkey */
 #define KEY_WOWSHARE 0x0020  /* key is a Wow64 shared key (used for Software\Classes) */
+#define KEY_CHANGED  0x0040  /* key contents have changed since the last journal write */
 
 /* a key value */
 struct key_value
@@ -117,7 +121,11 @@ static const WCHAR wow6432node[] = {'W','o','w','6','4','3','2','N','o','d','e'}
 static const WCHAR symlink_value[] = {'S','y','m','b','o','l','i','c','L','i','n','k','V','a','l','u','e'};
 static const struct unicode_str symlink_str = { symlink_value, sizeof(symlink_value) };
 
+static int generation_fd = -1;                        /* fd of the shared generation counter */
+static volatile unsigned int *registry_generation;    /* counter bumped on every change */
+
 static void set_periodic_save_timer(void);
+static void journal_key_deletion( const struct key *key );
 static struct key_value *find_value( const struct key *key, const struct unicode_str *name, int *index );
 
 /* information about where to save a registry branch */
@@ -125,6 +133,10 @@ struct save_branch_info
 {
     struct key  *key;
     const char  *path;
+    char        *journal_path;  /* journal of changes since the file was last saved */
+    FILE        *journal;       /* journal file opened for appending */
+    int          need_save;     /* a change couldn't be journaled, the file must be rewritten */
+    off_t        size;          /* size of the file when it was last saved */
 };
 
 #define MAX_SAVE_BRANCH_INFO 3
@@ -256,6 +268,22 @@ static void dump_value( const struct key_value *value, FILE *f )
     fputc( '\n', f );
 }
 
+/* save the header of a key section to a text file */
+static void save_key_header( const struct key *key, const struct key *base, FILE *f )
+{
+    fprintf( f, "\n[" );
+    if (key != base) dump_path( key, base, f );
+    fprintf( f, "] %u\n", (unsigned int)((key->modif - ticks_1601_to_1970) / TICKS_PER_SEC) );
+    fprintf( f, "#time=%x%08x\n", (unsigned int)(key->modif >> 32), (unsigned int)key->modif );
+    if (key->class)
+    {
+        fprintf( f, "#class=\"" );
+        dump_strW( key->class, key->classlen / sizeof(WCHAR), f, "\"\"" );
+        fprintf( f, "\"\n" );
+    }
+    if (key->flags & KEY_SYMLINK) fputs( "#link\n", f );
+}
+
 /* save a registry and all its subkeys to a text file */
 static void save_subkeys( const struct key *key, const struct key *base, FILE *f )
 {
@@ -266,22 +294,29 @@ static void save_subkeys( const struct key *key, const struct key *base, FILE *f
     /* keys with no values but subkeys are saved implicitly by saving the subkeys */
     if ((key->last_value >= 0) || (key->last_subkey == -1) || key->class || (key->flags & KEY_SYMLINK))
     {
-        fprintf( f, "\n[" );
-        if (key != base) dump_path( key, base, f );
-        fprintf( f, "] %u\n", (unsigned int)((key->modif - ticks_1601_to_1970) / TICKS_PER_SEC) );
-        fprintf( f, "#time=%x%08x\n", (unsigned int)(key->modif >> 32), (unsigned int)key->modif );
-        if (key->class)
-        {
-            fprintf( f, "#class=\"" );
-            dump_strW( key->class, key->classlen / sizeof(WCHAR), f, "\"\"" );
-            fprintf( f, "\"\n" );
-        }
-        if (key->flags & KEY_SYMLINK) fputs( "#link\n", f );
+        save_key_header( key, base, f );
         for (i = 0; i <= key->last_value; i++) dump_value( &key->values[i], f );
     }
     for (i = 0; i <= key->last_subkey; i++) save_subkeys( key->subkeys[i], base, f );
 }
 
+/* append the keys that changed since the last journal write to the journal */
+/* each key is saved with all its values, replacing the existing ones on replay */
+static void save_journal_keys( struct key *key, const struct key *base, FILE *f )
+{
+    int i;
+
+    if (key->flags & KEY_VOLATILE) return;
+    if (!(key->flags & KEY_DIRTY)) return;
+    if (key->flags & KEY_CHANGED)
+    {
+        save_key_header( key, base, f );
+        fputs( "#clear\n", f );
+        for (i = 0; i <= key->last_value; i++) dump_value( &key->values[i], f );
+    }
+    for (i = 0; i <= key->last_subkey; i++) save_journal_keys( key->subkeys[i], base, f );
+}
+
 static void dump_operation( const struct key *key, const struct key_value *value, const char *op )
 {
     fprintf( stderr, "%s key ", op );
@@ -395,12 +430,20 @@ static struct security_descriptor *key_get_sd( struct object *obj )
     return key_default_sd;
 }
 
+/* let the clients know that their cached values are no longer valid */
+static void registry_changed(void)
+{
+    if (registry_generation) (*registry_generation)++;
+}
+
 /* close the notification associated with a handle */
 static int key_close_handle( struct object *obj, struct process *process, obj_handle_t handle )
 {
     struct key * key = (struct key *) obj;
     struct notify *notify = find_notify( key, process, handle );
     if (notify) do_notification( key, notify, 1 );
+    /* clients only track the handles they close themselves */
+    if (!current || process != current->process) registry_changed();
     return 1;  /* ok to close */
 }
 
@@ -521,7 +564,7 @@ static void make_clean( struct key *key )
 
     if (key->flags & KEY_VOLATILE) return;
     if (!(key->flags & KEY_DIRTY)) return;
-    key->flags &= ~KEY_DIRTY;
+    key->flags &= ~(KEY_DIRTY | KEY_CHANGED);
     for (i = 0; i <= key->last_subkey; i++) make_clean( key->subkeys[i] );
 }
 
@@ -545,6 +588,8 @@ static void touch_key( struct key *key, unsigned int change )
 
     key->modif = current_time;
     make_dirty( key );
+    registry_changed();
+    if (change & REG_NOTIFY_CHANGE_LAST_SET) key->flags |= KEY_CHANGED;
 
     /* do notifications */
     check_notify( key, change, 1 );
@@ -817,7 +862,7 @@ static struct key *create_key( struct key *key, const struct unicode_str *name,
 
     if (options & REG_OPTION_CREATE_LINK) key->flags |= KEY_SYMLINK;
     if (options & REG_OPTION_VOLATILE) key->flags |= KEY_VOLATILE;
-    else key->flags |= KEY_DIRTY;
+    else key->flags |= KEY_DIRTY | KEY_CHANGED;
 
     if (sd) default_set_sd( &key->obj, sd, OWNER_SECURITY_INFORMATION | GROUP_SECURITY_INFORMATION |
                             DACL_SECURITY_INFORMATION | SACL_SECURITY_INFORMATION );
@@ -1013,6 +1058,7 @@ static int delete_key( struct key *key, int recurse )
     }
 
     if (debug_level > 1) dump_operation( key, NULL, "Delete" );
+    journal_key_deletion( key );
     free_subkey( parent, index );
     touch_key( parent, REG_NOTIFY_CHANGE_NAME );
     return 0;
@@ -1436,6 +1482,19 @@ static int load_global_option( const char *buffer, struct file_load_info *info )
     return 1;
 }
 
+/* remove all the values of a key, before loading them again from a journal */
+static void clear_values( struct key *key )
+{
+    int i;
+
+    for (i = 0; i <= key->last_value; i++)
+    {
+        free( key->values[i].name );
+        free( key->values[i].data );
+    }
+    key->last_value = -1;
+}
+
 /* load a key option from the input file */
 static int load_key_option( struct key *key, const char *buffer, struct file_load_info *info )
 {
@@ -1466,6 +1525,9 @@ static int load_key_option( struct key *key, const char *buffer, struct file_loa
         key->classlen = len;
     }
     if (!strncmp( buffer, "#link", 5 )) key->flags |= KEY_SYMLINK;
+    /* options used by the journal */
+    if (!strncmp( buffer, "#clear", 6 )) clear_values( key );
+    if (!strncmp( buffer, "#deleted", 8 ) && key->parent) delete_key( key, 1 );
     /* ignore unknown options */
     return 1;
 }
@@ -1715,28 +1777,327 @@ static void load_registry( struct key *key, obj_handle_t handle )
     }
 }
 
+/* binary registry snapshots
+ *
+ * Every time a registry branch is saved, a binary copy of it is written
+ * next to the text file, tagged with the identity of the text file it
+ * matches. At startup the snapshot is loaded instead of parsing the text
+ * file, as long as the text file hasn't been modified in the meantime.
+ */
+
+#define SNAPSHOT_MAGIC      "WINEREG\001"
+#define SNAPSHOT_BYTE_ORDER 0x01020304
+#define SNAPSHOT_MAX_DEPTH  512
+
+struct snapshot_header
+{
+    char               magic[8];    /* SNAPSHOT_MAGIC */
+    unsigned long long text_size;   /* size of the matching text file */
+    unsigned long long text_mtime;  /* modification time of the matching text file */
+    unsigned long long text_ino;    /* inode of the matching text file */
+    unsigned int       arch;        /* prefix type */
+    unsigned int       byte_order;  /* SNAPSHOT_BYTE_ORDER in native byte order */
+};
+
+/* followed by the name, class, values and subkeys, each padded to 4 bytes */
+struct snapshot_key
+{
+    timeout_t          modif;       /* last modification time */
+    unsigned int       namelen;     /* length of key name */
+    unsigned int       classlen;    /* length of class name */
+    unsigned int       flags;       /* KEY_SYMLINK */
+    unsigned int       nb_values;   /* number of values */
+    unsigned int       nb_subkeys;  /* number of subkeys */
+    unsigned int       reserved;
+};
+
+/* followed by the name and the data, each padded to 4 bytes */
+struct snapshot_value
+{
+    unsigned int       namelen;     /* length of value name */
+    unsigned int       type;        /* value type */
+    unsigned int       len;         /* value data length */
+};
+
+struct snapshot_info
+{
+    const char        *ptr;         /* current read position */
+    const char        *end;         /* end of the mapping */
+};
+
+static inline size_t snapshot_pad( size_t len )
+{
+    return (len + 3) & ~3;
+}
+
+static char *get_snapshot_path( const char *path )
+{
+    char *ret;
+
+    if ((ret = malloc( strlen(path) + sizeof(".bin") ))) sprintf( ret, "%s.bin", path );
+    return ret;
+}
+
+static void write_snapshot_data( const void *data, size_t len, FILE *f )
+{
+    static const char padding[4];
+
+    if (!len) return;
+    fwrite( data, len, 1, f );
+    fwrite( padding, snapshot_pad( len ) - len, 1, f );
+}
+
+static void save_snapshot_key( const struct key *key, FILE *f )
+{
+    struct snapshot_key sk;
+    struct snapshot_value sv;
+    int i;
+
+    memset( &sk, 0, sizeof(sk) );
+    sk.modif     = key->modif;
+    sk.namelen   = key->namelen;
+    sk.classlen  = key->classlen;
+    sk.flags     = key->flags & KEY_SYMLINK;
+    sk.nb_values = key->last_value + 1;
+    for (i = 0; i <= key->last_subkey; i++)
+        if (!(key->subkeys[i]->flags & KEY_VOLATILE)) sk.nb_subkeys++;
+
+    fwrite( &sk, sizeof(sk), 1, f );
+    write_snapshot_data( key->name, key->namelen, f );
+    write_snapshot_data( key->class, key->classlen, f );
+    for (i = 0; i <= key->last_value; i++)
+    {
+        sv.namelen = key->values[i].namelen;
+        sv.type    = key->values[i].type;
+        sv.len     = key->values[i].len;
+        fwrite( &sv, sizeof(sv), 1, f );
+        write_snapshot_data( key->values[i].name, sv.namelen, f );
+        write_snapshot_data( key->values[i].data, sv.len, f );
+    }
+    for (i = 0; i <= key->last_subkey; i++)
+        if (!(key->subkeys[i]->flags & KEY_VOLATILE)) save_snapshot_key( key->subkeys[i], f );
+}
+
+/* write the binary snapshot of a branch that was just saved to a text file */
+static void save_snapshot( struct key *key, const char *path )
+{
+    struct snapshot_header header;
+    struct stat st;
+    char *snapshot, *tmp;
+    FILE *f;
+    int ret;
+
+    if (stat( path, &st ) == -1) return;
+    if (!(snapshot = get_snapshot_path( path ))) return;
+    if (!(tmp = malloc( strlen(snapshot) + sizeof(".tmp") )))
+    {
+        free( snapshot );
+        return;
+    }
+    sprintf( tmp, "%s.tmp", snapshot );
+
+    if ((f = fopen( tmp, "w" )))
+    {
+        memset( &header, 0, sizeof(header) );
+        memcpy( header.magic, SNAPSHOT_MAGIC, sizeof(header.magic) );
+        header.text_size  = st.st_size;
+        header.text_mtime = st.st_mtime;
+        header.text_ino   = st.st_ino;
+        header.arch       = prefix_type;
+        header.byte_order = SNAPSHOT_BYTE_ORDER;
+        fwrite( &header, sizeof(header), 1, f );
+        save_snapshot_key( key, f );
+        ret = !ferror( f );
+        if (fclose( f )) ret = 0;
+        if (!ret || rename( tmp, snapshot )) unlink( tmp );
+    }
+    free( tmp );
+    free( snapshot );
+}
+
+static const void *snapshot_read( struct snapshot_info *info, size_t len )
+{
+    const char *ret = info->ptr;
+
+    if (snapshot_pad( len ) > (size_t)(info->end - info->ptr)) return NULL;
+    info->ptr += snapshot_pad( len );
+    return ret;
+}
+
+/* check that a key record and everything below it is within bounds */
+static int check_snapshot_key( struct snapshot_info *info, int depth )
+{
+    const struct snapshot_key *ptr;
+    struct snapshot_key sk;
+    struct snapshot_value sv;
+    const void *p;
+    unsigned int i;
+
+    if (depth > SNAPSHOT_MAX_DEPTH) return 0;
+    if (!(ptr = snapshot_read( info, sizeof(sk) ))) return 0;
+    memcpy( &sk, ptr, sizeof(sk) );
+    if (sk.namelen > MAX_NAME_LEN * sizeof(WCHAR) || sk.namelen % sizeof(WCHAR)) return 0;
+    if (sk.classlen % sizeof(WCHAR)) return 0;
+    if (!snapshot_read( info, sk.namelen ) || !snapshot_read( info, sk.classlen )) return 0;
+    for (i = 0; i < sk.nb_values; i++)
+    {
+        if (!(p = snapshot_read( info, sizeof(sv) ))) return 0;
+        memcpy( &sv, p, sizeof(sv) );
+        if (sv.namelen > MAX_VALUE_LEN * sizeof(WCHAR) || sv.namelen % sizeof(WCHAR)) return 0;
+        if (!snapshot_read( info, sv.namelen ) || !snapshot_read( info, sv.len )) return 0;
+    }
+    for (i = 0; i < sk.nb_subkeys; i++)
+        if (!check_snapshot_key( info, depth + 1 )) return 0;
+    return 1;
+}
+
+/* load a key record that has already been checked by check_snapshot_key */
+static int load_snapshot_key( struct key *key, struct snapshot_info *info )
+{
+    struct snapshot_key sk;
+    struct snapshot_value sv;
+    struct key_value *value;
+    struct unicode_str name;
+    struct key *subkey;
+    const void *data;
+    unsigned int i;
+    int index;
+
+    memcpy( &sk, snapshot_read( info, sizeof(sk) ), sizeof(sk) );
+    snapshot_read( info, sk.namelen );
+    data = snapshot_read( info, sk.classlen );
+
+    key->modif = sk.modif;
+    key->flags |= sk.flags & KEY_SYMLINK;
+    if (sk.classlen)
+    {
+        free( key->class );
+        if (!(key->class = memdup( data, sk.classlen ))) sk.classlen = 0;
+        key->classlen = sk.classlen;
+    }
+
+    for (i = 0; i < sk.nb_values; i++)
+    {
+        memcpy( &sv, snapshot_read( info, sizeof(sv) ), sizeof(sv) );
+        name.str = snapshot_read( info, sv.namelen );
+        name.len = sv.namelen;
+        data = snapshot_read( info, sv.len );
+
+        if (!(value = find_value( key, &name, &index )) && !(value = insert_value( key, &name, index )))
+            return 0;
+        free( value->data );
+        value->type = sv.type;
+        value->len  = sv.len;
+        value->data = NULL;
+        if (sv.len && !(value->data = memdup( data, sv.len ))) value->len = 0;
+    }
+
+    for (i = 0; i < sk.nb_subkeys; i++)
+    {
+        const struct snapshot_key *ptr = (const struct snapshot_key *)info->ptr;
+
+        memcpy( &name.len, &ptr->namelen, sizeof(ptr->namelen) );
+        name.str = (const WCHAR *)(ptr + 1);
+        if (!(subkey = find_subkey( key, &name, &index )) &&
+            !(subkey = alloc_subkey( key, &name, index, 0 )))
+            return 0;
+        if (!load_snapshot_key( subkey, info )) return 0;
+    }
+    return 1;
+}
+
+/* load the binary snapshot of a branch if it's still up to date with the text file */
+static int load_snapshot( struct key *key, const char *path )
+{
+    struct snapshot_header header;
+    struct snapshot_info info;
+    struct stat st, text_st;
+    char *snapshot;
+    void *base;
+    int fd, ret = 0;
+
+#ifdef HAVE_SYS_MMAN_H
+    if (stat( path, &text_st ) == -1) return 0;
+    if (!(snapshot = get_snapshot_path( path ))) return 0;
+    fd = open( snapshot, O_RDONLY );
+    free( snapshot );
+    if (fd == -1) return 0;
+
+    if (fstat( fd, &st ) == -1 || st.st_size < sizeof(header)) goto done;
+    if ((base = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 )) == MAP_FAILED) goto done;
+
+    memcpy( &header, base, sizeof(header) );
+    info.ptr = (const char *)base + sizeof(header);
+    info.end = (const char *)base + st.st_size;
+    if (!memcmp( header.magic, SNAPSHOT_MAGIC, sizeof(header.magic) ) &&
+        header.byte_order == SNAPSHOT_BYTE_ORDER &&
+        header.text_size == text_st.st_size &&
+        header.text_mtime == text_st.st_mtime &&
+        header.text_ino == text_st.st_ino &&
+        (prefix_type == PREFIX_UNKNOWN || header.arch == PREFIX_UNKNOWN || header.arch == prefix_type) &&
+        check_snapshot_key( &info, 0 ) && info.ptr == info.end)
+    {
+        info.ptr = (const char *)base + sizeof(header);
+        ret = load_snapshot_key( key, &info );
+        if (prefix_type == PREFIX_UNKNOWN) prefix_type = header.arch;
+        if (!ret) fprintf( stderr, "wineserver: failed to load registry snapshot for %s\n", path );
+    }
+    munmap( base, st.st_size );
+done:
+    close( fd );
+#endif
+    return ret;
+}
+
 /* load one of the initial registry files */
 static int load_init_registry_from_file( const char *filename, struct key *key )
 {
+    struct save_branch_info *info;
+    struct stat st;
     FILE *f;
+    int found = 1;
 
-    if ((f = fopen( filename, "r" )))
+    /* the snapshot is only used if it matches the text file, so no need to parse it */
+    if (!load_snapshot( key, filename ))
     {
-        load_keys( key, filename, f, 0 );
-        fclose( f );
-        if (get_error() == STATUS_NOT_REGISTRY_FILE)
+        if ((f = fopen( filename, "r" )))
         {
-            fprintf( stderr, "%s is not a valid registry file\n", filename );
-            return 1;
+            load_keys( key, filename, f, 0 );
+            fclose( f );
+            if (get_error() == STATUS_NOT_REGISTRY_FILE)
+            {
+                fprintf( stderr, "%s is not a valid registry file\n", filename );
+                return 1;
+            }
+            save_snapshot( key, filename );
         }
+        else found = 0;
     }
 
     assert( save_branch_count < MAX_SAVE_BRANCH_INFO );
 
-    save_branch_info[save_branch_count].path = filename;
-    save_branch_info[save_branch_count++].key = (struct key *)grab_object( key );
+    info = &save_branch_info[save_branch_count];
+    info->path = filename;
+    info->journal = NULL;
+    info->need_save = 0;
+    info->size = stat( filename, &st ) ? 0 : st.st_size;
+    if (!(info->journal_path = malloc( strlen(filename) + sizeof(".journal") )))
+        fatal_error( "out of memory\n" );
+    sprintf( info->journal_path, "%s.journal", filename );
+
+    /* replay the changes that were made since the file was last saved */
+    if ((f = fopen( info->journal_path, "r" )))
+    {
+        load_keys( key, info->journal_path, f, 0 );
+        fclose( f );
+        clear_error();
+        found = 1;
+    }
+
+    info->key = (struct key *)grab_object( key );
+    save_branch_count++;
     make_object_static( &key->obj );
-    return (f != NULL);
+    return found;
 }
 
 static WCHAR *format_user_registry_path( const SID *sid, struct unicode_str *path )
@@ -1917,9 +2278,19 @@ static void save_registry( struct key *key, obj_handle_t handle )
     }
 }
 
+/* close and remove the journal of a branch once its changes are all saved in the file */
+static void discard_journal( struct save_branch_info *info )
+{
+    if (info->journal) fclose( info->journal );
+    info->journal = NULL;
+    unlink( info->journal_path );
+}
+
 /* save a registry branch to a file */
-static int save_branch( struct key *key, const char *path )
+static int save_branch( struct save_branch_info *info )
 {
+    struct key *key = info->key;
+    const char *path = info->path;
     struct stat st;
     char *p, *tmp = NULL;
     int fd, count = 0, ret = 0;
@@ -1987,10 +2358,82 @@ static int save_branch( struct key *key, const char *path )
 
 done:
     free( tmp );
-    if (ret) make_clean( key );
+    if (ret)
+    {
+        make_clean( key );
+        save_snapshot( key, path );
+        discard_journal( info );
+        info->need_save = 0;
+        if (!stat( path, &st )) info->size = st.st_size;
+    }
     return ret;
 }
 
+/* open the journal of a branch for appending; must be called from the config dir */
+static FILE *open_journal( struct save_branch_info *info )
+{
+    if (info->journal) return info->journal;
+    if (!(info->journal = fopen( info->journal_path, "a" ))) return NULL;
+    if (!fseek( info->journal, 0, SEEK_END ) && !ftell( info->journal ))
+        fprintf( info->journal, "WINE REGISTRY Version 2\n" );
+    return info->journal;
+}
+
+/* save the changes of a registry branch, appending them to the journal */
+/* unless it has grown big enough that rewriting the whole file is better */
+static int save_branch_changes( struct save_branch_info *info )
+{
+    FILE *f;
+    long size;
+
+    if (!(info->key->flags & KEY_DIRTY)) return 1;
+    if (info->need_save || !(f = open_journal( info ))) return save_branch( info );
+    if ((size = ftell( f )) == -1 || (size > 65536 && size > info->size / 8)) return save_branch( info );
+
+    if (debug_level > 1)
+    {
+        fprintf( stderr, "%s: ", info->journal_path );
+        dump_operation( info->key, NULL, "journaling" );
+    }
+    save_journal_keys( info->key, info->key, f );
+    if (fflush( f )) return save_branch( info );
+    make_clean( info->key );
+    return 1;
+}
+
+/* record the deletion of a key in the journal of its branch */
+static void journal_key_deletion( const struct key *key )
+{
+    struct save_branch_info *info = NULL;
+    const struct key *parent;
+    FILE *f;
+    int i;
+
+    if (key->flags & KEY_VOLATILE) return;
+    for (i = 0; i < save_branch_count && !info; i++)
+        for (parent = key->parent; parent; parent = parent->parent)
+            if (parent == save_branch_info[i].key)
+            {
+                info = &save_branch_info[i];
+                break;
+            }
+    if (!info || info->need_save) return;
+
+    if (fchdir( config_dir_fd ) == -1)
+    {
+        info->need_save = 1;
+        return;
+    }
+    if ((f = open_journal( info )))
+    {
+        fprintf( f, "\n[" );
+        dump_path( key, info->key, f );
+        fprintf( f, "]\n#deleted\n" );
+    }
+    else info->need_save = 1;
+    if (fchdir( server_dir_fd ) == -1) fatal_error( "chdir to server dir: %s\n", strerror( errno ));
+}
+
 /* periodic saving of the registry */
 static void periodic_save( void *arg )
 {
@@ -1999,7 +2442,7 @@ static void periodic_save( void *arg )
     if (fchdir( config_dir_fd ) == -1) return;
     save_timeout_user = NULL;
     for (i = 0; i < save_branch_count; i++)
-        save_branch( save_branch_info[i].key, save_branch_info[i].path );
+        save_branch_changes( &save_branch_info[i] );
     if (fchdir( server_dir_fd ) == -1) fatal_error( "chdir to server dir: %s\n", strerror( errno ));
     set_periodic_save_timer();
 }
@@ -2019,7 +2462,7 @@ void flush_registry(void)
     if (fchdir( config_dir_fd ) == -1) return;
     for (i = 0; i < save_branch_count; i++)
     {
-        if (!save_branch( save_branch_info[i].key, save_branch_info[i].path ))
+        if (!save_branch( &save_branch_info[i] ))
         {
             fprintf( stderr, "wineserver: could not save registry branch to %s",
                      save_branch_info[i].path );
@@ -2223,6 +2666,7 @@ DECL_HANDLER(load_registry)
         if ((key = create_key( parent, &name, NULL, 0, KEY_WOW64_64KEY, 0, sd, &dummy )))
         {
             load_registry( key, req->file );
+            registry_changed();
             release_object( key );
         }
         release_object( parent );
@@ -2309,3 +2753,24 @@ DECL_HANDLER(set_registry_notification)
         release_object( key );
     }
 }
+
+/* retrieve the fd of the registry generation counter */
+DECL_HANDLER(get_registry_generation)
+{
+    void *ptr;
+
+    if (generation_fd == -1)
+    {
+        if ((generation_fd = create_temp_file( get_page_size() )) == -1) return;
+        ptr = mmap( NULL, get_page_size(), PROT_READ | PROT_WRITE, MAP_SHARED, generation_fd, 0 );
+        if (ptr == MAP_FAILED)
+        {
+            file_set_error();
+            close( generation_fd );
+            generation_fd = -1;
+            return;
+        }
+        registry_generation = ptr;
+    }
+    send_client_fd( current->process, generation_fd, 0 );
+}
@@ -35,6 +35,7 @@
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <time.h>
 #ifdef HAVE_SYS_SOCKET_H
 # include <sys/socket.h>
 #endif
@@ -288,10 +289,79 @@ static void send_reply( union generic_reply *reply )
 }
 
 /* call a request handler */
+/* per-request statistics */
+
+#define STATS_HIST_SIZE 16
+
+struct request_stats
+{
+    unsigned int       count;                   /* number of calls */
+    unsigned long long time;                    /* cumulative time in nanoseconds */
+    unsigned long long max_time;                /* longest call in nanoseconds */
+    unsigned int       hist[STATS_HIST_SIZE];   /* latency histogram, in powers of 2 microseconds */
+};
+
+static struct request_stats req_stats[REQ_NB_REQUESTS];
+
+static inline unsigned long long get_stats_time(void)
+{
+#if defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+    if (!clock_gettime( CLOCK_MONOTONIC, &ts ))
+        return (unsigned long long)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+    return (unsigned long long)(current_time - server_start_time) * 100;
+}
+
+static inline void add_request_stats( enum request req, unsigned long long time )
+{
+    struct request_stats *stats = &req_stats[req];
+    unsigned int usecs = time / 1000, bucket = 0;
+
+    while (usecs && bucket < STATS_HIST_SIZE - 1)
+    {
+        usecs >>= 1;
+        bucket++;
+    }
+    stats->count++;
+    stats->time += time;
+    if (time > stats->max_time) stats->max_time = time;
+    stats->hist[bucket]++;
+}
+
+static int dump_process_stats( struct process *process, void *arg )
+{
+    if (process->req_count)
+        fprintf( stderr, "  %04x: %u requests, %llu.%06llu ms\n", process->id, process->req_count,
+                 process->req_time / 1000000, process->req_time % 1000000 );
+    return 0;
+}
+
+/* dump the request statistics to stderr */
+void dump_request_stats(void)
+{
+    unsigned int i, j;
+
+    fprintf( stderr, "wineserver request statistics (count, total ms, avg us, max us, histogram):\n" );
+    for (i = 0; i < REQ_NB_REQUESTS; i++)
+    {
+        const struct request_stats *stats = &req_stats[i];
+
+        if (!stats->count) continue;
+        fprintf( stderr, "  %-32s %10u %12llu %8llu %8llu ", get_request_name( i ), stats->count,
+                 stats->time / 1000000, stats->time / stats->count / 1000, stats->max_time / 1000 );
+        for (j = 0; j < STATS_HIST_SIZE; j++) fprintf( stderr, " %u", stats->hist[j] );
+        fputc( '\n', stderr );
+    }
+    fprintf( stderr, "per-process totals:\n" );
+    enum_processes( dump_process_stats, NULL );
+}
+
 static void call_req_handler( struct thread *thread )
 {
     union generic_reply reply;
     enum request req = thread->req.request_header.req;
+    unsigned long long start;
 
     current = thread;
     current->reply_size = 0;
@@ -301,7 +371,17 @@ static void call_req_handler( struct thread *thread )
     if (debug_level) trace_request();
 
     if (req < REQ_NB_REQUESTS)
+    {
+        start = get_stats_time();
         req_handlers[req]( &current->req, &reply );
+        start = get_stats_time() - start;
+        add_request_stats( req, start );
+        if (current)
+        {
+            current->process->req_count++;
+            current->process->req_time += start;
+        }
+    }
     else
         set_error( STATUS_NOT_IMPLEMENTED );
 
@@ -64,6 +64,8 @@ extern int server_dir_fd, config_dir_fd;
 
 extern void trace_request(void);
 extern void trace_reply( enum request req, const union generic_reply *reply );
+extern const char *get_request_name( enum request req );
+extern void dump_request_stats(void);
 
 /* get the request vararg data */
 static inline const void *get_req_data(void)
@@ -204,6 +206,7 @@ DECL_HANDLER(get_mapping_committed_range);
 DECL_HANDLER(add_mapping_committed_range);
 DECL_HANDLER(is_same_mapping);
 DECL_HANDLER(create_snapshot);
+DECL_HANDLER(list_processes);
 DECL_HANDLER(next_process);
 DECL_HANDLER(next_thread);
 DECL_HANDLER(wait_debug_event);
@@ -214,6 +217,7 @@ DECL_HANDLER(debug_process);
 DECL_HANDLER(debug_break);
 DECL_HANDLER(set_debugger_kill_on_exit);
 DECL_HANDLER(read_process_memory);
+DECL_HANDLER(get_process_vm_pid);
 DECL_HANDLER(write_process_memory);
 DECL_HANDLER(create_key);
 DECL_HANDLER(open_key);
@@ -228,6 +232,7 @@ DECL_HANDLER(load_registry);
 DECL_HANDLER(unload_registry);
 DECL_HANDLER(save_registry);
 DECL_HANDLER(set_registry_notification);
+DECL_HANDLER(get_registry_generation);
 DECL_HANDLER(create_timer);
 DECL_HANDLER(open_timer);
 DECL_HANDLER(set_timer);
@@ -242,15 +247,18 @@ DECL_HANDLER(find_atom);
 DECL_HANDLER(get_atom_information);
 DECL_HANDLER(set_atom_information);
 DECL_HANDLER(empty_atom_table);
+DECL_HANDLER(get_atom_generation);
 DECL_HANDLER(init_atom_table);
 DECL_HANDLER(get_msg_queue);
 DECL_HANDLER(set_queue_fd);
 DECL_HANDLER(set_queue_mask);
 DECL_HANDLER(get_queue_status);
+DECL_HANDLER(get_queue_shm);
 DECL_HANDLER(get_process_idle_event);
 DECL_HANDLER(send_message);
 DECL_HANDLER(post_quit_message);
 DECL_HANDLER(send_hardware_message);
+DECL_HANDLER(send_hardware_messages);
 DECL_HANDLER(get_message);
 DECL_HANDLER(reply_message);
 DECL_HANDLER(accept_hardware_message);
@@ -275,6 +283,7 @@ DECL_HANDLER(destroy_window);
 DECL_HANDLER(get_desktop_window);
 DECL_HANDLER(set_window_owner);
 DECL_HANDLER(get_window_info);
+DECL_HANDLER(get_window_shm);
 DECL_HANDLER(set_window_info);
 DECL_HANDLER(set_parent);
 DECL_HANDLER(get_window_parents);
@@ -381,9 +390,11 @@ DECL_HANDLER(create_completion);
 DECL_HANDLER(open_completion);
 DECL_HANDLER(add_completion);
 DECL_HANDLER(remove_completion);
+DECL_HANDLER(remove_completions);
 DECL_HANDLER(query_completion);
 DECL_HANDLER(set_completion_info);
 DECL_HANDLER(add_fd_completion);
+DECL_HANDLER(set_fd_completion_mode);
 DECL_HANDLER(set_fd_disp_info);
 DECL_HANDLER(set_fd_name_info);
 DECL_HANDLER(get_window_layered_info);
@@ -503,6 +514,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_add_mapping_committed_range,
     (req_handler)req_is_same_mapping,
     (req_handler)req_create_snapshot,
+    (req_handler)req_list_processes,
     (req_handler)req_next_process,
     (req_handler)req_next_thread,
     (req_handler)req_wait_debug_event,
@@ -513,6 +525,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_debug_break,
     (req_handler)req_set_debugger_kill_on_exit,
     (req_handler)req_read_process_memory,
+    (req_handler)req_get_process_vm_pid,
     (req_handler)req_write_process_memory,
     (req_handler)req_create_key,
     (req_handler)req_open_key,
@@ -527,6 +540,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_unload_registry,
     (req_handler)req_save_registry,
     (req_handler)req_set_registry_notification,
+    (req_handler)req_get_registry_generation,
     (req_handler)req_create_timer,
     (req_handler)req_open_timer,
     (req_handler)req_set_timer,
@@ -541,15 +555,18 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_get_atom_information,
     (req_handler)req_set_atom_information,
     (req_handler)req_empty_atom_table,
+    (req_handler)req_get_atom_generation,
     (req_handler)req_init_atom_table,
     (req_handler)req_get_msg_queue,
     (req_handler)req_set_queue_fd,
     (req_handler)req_set_queue_mask,
     (req_handler)req_get_queue_status,
+    (req_handler)req_get_queue_shm,
     (req_handler)req_get_process_idle_event,
     (req_handler)req_send_message,
     (req_handler)req_post_quit_message,
     (req_handler)req_send_hardware_message,
+    (req_handler)req_send_hardware_messages,
     (req_handler)req_get_message,
     (req_handler)req_reply_message,
     (req_handler)req_accept_hardware_message,
@@ -574,6 +591,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_get_desktop_window,
     (req_handler)req_set_window_owner,
     (req_handler)req_get_window_info,
+    (req_handler)req_get_window_shm,
     (req_handler)req_set_window_info,
     (req_handler)req_set_parent,
     (req_handler)req_get_window_parents,
@@ -680,9 +698,11 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_open_completion,
     (req_handler)req_add_completion,
     (req_handler)req_remove_completion,
+    (req_handler)req_remove_completions,
     (req_handler)req_query_completion,
     (req_handler)req_set_completion_info,
     (req_handler)req_add_fd_completion,
+    (req_handler)req_set_fd_completion_mode,
     (req_handler)req_set_fd_disp_info,
     (req_handler)req_set_fd_name_info,
     (req_handler)req_get_window_layered_info,
@@ -856,7 +876,10 @@ C_ASSERT( FIELD_OFFSET(struct set_thread_info_request, priority) == 20 );
 C_ASSERT( FIELD_OFFSET(struct set_thread_info_request, affinity) == 24 );
 C_ASSERT( FIELD_OFFSET(struct set_thread_info_request, entry_point) == 32 );
 C_ASSERT( FIELD_OFFSET(struct set_thread_info_request, token) == 40 );
+C_ASSERT( FIELD_OFFSET(struct set_thread_info_request, ideal_processor) == 44 );
 C_ASSERT( sizeof(struct set_thread_info_request) == 48 );
+C_ASSERT( FIELD_OFFSET(struct set_thread_info_reply, prev_ideal) == 8 );
+C_ASSERT( sizeof(struct set_thread_info_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_dll_info_request, handle) == 12 );
 C_ASSERT( FIELD_OFFSET(struct get_dll_info_request, base_address) == 16 );
 C_ASSERT( sizeof(struct get_dll_info_request) == 24 );
@@ -1033,7 +1056,8 @@ C_ASSERT( FIELD_OFFSET(struct get_handle_fd_reply, type) == 8 );
 C_ASSERT( FIELD_OFFSET(struct get_handle_fd_reply, cacheable) == 12 );
 C_ASSERT( FIELD_OFFSET(struct get_handle_fd_reply, access) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_handle_fd_reply, options) == 20 );
-C_ASSERT( sizeof(struct get_handle_fd_reply) == 24 );
+C_ASSERT( FIELD_OFFSET(struct get_handle_fd_reply, comp_flags) == 24 );
+C_ASSERT( sizeof(struct get_handle_fd_reply) == 32 );
 C_ASSERT( FIELD_OFFSET(struct get_directory_cache_entry_request, handle) == 12 );
 C_ASSERT( sizeof(struct get_directory_cache_entry_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_directory_cache_entry_reply, entry) == 8 );
@@ -1288,7 +1312,8 @@ C_ASSERT( sizeof(struct get_mapping_info_request) == 24 );
 C_ASSERT( FIELD_OFFSET(struct get_mapping_info_reply, size) == 8 );
 C_ASSERT( FIELD_OFFSET(struct get_mapping_info_reply, flags) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_mapping_info_reply, shared_file) == 20 );
-C_ASSERT( sizeof(struct get_mapping_info_reply) == 24 );
+C_ASSERT( FIELD_OFFSET(struct get_mapping_info_reply, copy_file) == 24 );
+C_ASSERT( sizeof(struct get_mapping_info_reply) == 32 );
 C_ASSERT( FIELD_OFFSET(struct map_view_request, mapping) == 12 );
 C_ASSERT( FIELD_OFFSET(struct map_view_request, access) == 16 );
 C_ASSERT( FIELD_OFFSET(struct map_view_request, base) == 24 );
@@ -1315,6 +1340,10 @@ C_ASSERT( FIELD_OFFSET(struct create_snapshot_request, flags) == 16 );
 C_ASSERT( sizeof(struct create_snapshot_request) == 24 );
 C_ASSERT( FIELD_OFFSET(struct create_snapshot_reply, handle) == 8 );
 C_ASSERT( sizeof(struct create_snapshot_reply) == 16 );
+C_ASSERT( sizeof(struct list_processes_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct list_processes_reply, info_size) == 8 );
+C_ASSERT( FIELD_OFFSET(struct list_processes_reply, process_count) == 12 );
+C_ASSERT( sizeof(struct list_processes_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct next_process_request, handle) == 12 );
 C_ASSERT( FIELD_OFFSET(struct next_process_request, reset) == 16 );
 C_ASSERT( sizeof(struct next_process_request) == 24 );
@@ -1370,6 +1399,11 @@ C_ASSERT( FIELD_OFFSET(struct read_process_memory_request, handle) == 12 );
 C_ASSERT( FIELD_OFFSET(struct read_process_memory_request, addr) == 16 );
 C_ASSERT( sizeof(struct read_process_memory_request) == 24 );
 C_ASSERT( sizeof(struct read_process_memory_reply) == 8 );
+C_ASSERT( FIELD_OFFSET(struct get_process_vm_pid_request, handle) == 12 );
+C_ASSERT( FIELD_OFFSET(struct get_process_vm_pid_request, access) == 16 );
+C_ASSERT( sizeof(struct get_process_vm_pid_request) == 24 );
+C_ASSERT( FIELD_OFFSET(struct get_process_vm_pid_reply, unix_pid) == 8 );
+C_ASSERT( sizeof(struct get_process_vm_pid_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct write_process_memory_request, handle) == 12 );
 C_ASSERT( FIELD_OFFSET(struct write_process_memory_request, addr) == 16 );
 C_ASSERT( sizeof(struct write_process_memory_request) == 24 );
@@ -1434,6 +1468,8 @@ C_ASSERT( FIELD_OFFSET(struct set_registry_notification_request, event) == 16 );
 C_ASSERT( FIELD_OFFSET(struct set_registry_notification_request, subtree) == 20 );
 C_ASSERT( FIELD_OFFSET(struct set_registry_notification_request, filter) == 24 );
 C_ASSERT( sizeof(struct set_registry_notification_request) == 32 );
+C_ASSERT( sizeof(struct get_registry_generation_request) == 16 );
+C_ASSERT( sizeof(struct get_registry_generation_reply) == 8 );
 C_ASSERT( FIELD_OFFSET(struct create_timer_request, access) == 12 );
 C_ASSERT( FIELD_OFFSET(struct create_timer_request, manual) == 16 );
 C_ASSERT( sizeof(struct create_timer_request) == 24 );
@@ -1505,6 +1541,8 @@ C_ASSERT( sizeof(struct set_atom_information_request) == 24 );
 C_ASSERT( FIELD_OFFSET(struct empty_atom_table_request, table) == 12 );
 C_ASSERT( FIELD_OFFSET(struct empty_atom_table_request, if_pinned) == 16 );
 C_ASSERT( sizeof(struct empty_atom_table_request) == 24 );
+C_ASSERT( sizeof(struct get_atom_generation_request) == 16 );
+C_ASSERT( sizeof(struct get_atom_generation_reply) == 8 );
 C_ASSERT( FIELD_OFFSET(struct init_atom_table_request, entries) == 12 );
 C_ASSERT( sizeof(struct init_atom_table_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct init_atom_table_reply, table) == 8 );
@@ -1526,6 +1564,9 @@ C_ASSERT( sizeof(struct get_queue_status_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_queue_status_reply, wake_bits) == 8 );
 C_ASSERT( FIELD_OFFSET(struct get_queue_status_reply, changed_bits) == 12 );
 C_ASSERT( sizeof(struct get_queue_status_reply) == 16 );
+C_ASSERT( sizeof(struct get_queue_shm_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_queue_shm_reply, handle) == 8 );
+C_ASSERT( sizeof(struct get_queue_shm_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_process_idle_event_request, handle) == 12 );
 C_ASSERT( sizeof(struct get_process_idle_event_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_process_idle_event_reply, event) == 8 );
@@ -1538,7 +1579,8 @@ C_ASSERT( FIELD_OFFSET(struct send_message_request, msg) == 28 );
 C_ASSERT( FIELD_OFFSET(struct send_message_request, wparam) == 32 );
 C_ASSERT( FIELD_OFFSET(struct send_message_request, lparam) == 40 );
 C_ASSERT( FIELD_OFFSET(struct send_message_request, timeout) == 48 );
-C_ASSERT( sizeof(struct send_message_request) == 56 );
+C_ASSERT( FIELD_OFFSET(struct send_message_request, wake_mask) == 56 );
+C_ASSERT( sizeof(struct send_message_request) == 64 );
 C_ASSERT( FIELD_OFFSET(struct post_quit_message_request, exit_code) == 12 );
 C_ASSERT( sizeof(struct post_quit_message_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct send_hardware_message_request, win) == 12 );
@@ -1551,6 +1593,15 @@ C_ASSERT( FIELD_OFFSET(struct send_hardware_message_reply, prev_y) == 16 );
 C_ASSERT( FIELD_OFFSET(struct send_hardware_message_reply, new_x) == 20 );
 C_ASSERT( FIELD_OFFSET(struct send_hardware_message_reply, new_y) == 24 );
 C_ASSERT( sizeof(struct send_hardware_message_reply) == 32 );
+C_ASSERT( FIELD_OFFSET(struct send_hardware_messages_request, flags) == 12 );
+C_ASSERT( sizeof(struct send_hardware_messages_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct send_hardware_messages_reply, count) == 8 );
+C_ASSERT( FIELD_OFFSET(struct send_hardware_messages_reply, wait) == 12 );
+C_ASSERT( FIELD_OFFSET(struct send_hardware_messages_reply, prev_x) == 16 );
+C_ASSERT( FIELD_OFFSET(struct send_hardware_messages_reply, prev_y) == 20 );
+C_ASSERT( FIELD_OFFSET(struct send_hardware_messages_reply, new_x) == 24 );
+C_ASSERT( FIELD_OFFSET(struct send_hardware_messages_reply, new_y) == 28 );
+C_ASSERT( sizeof(struct send_hardware_messages_reply) == 32 );
 C_ASSERT( FIELD_OFFSET(struct get_message_request, flags) == 12 );
 C_ASSERT( FIELD_OFFSET(struct get_message_request, get_win) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_message_request, get_first) == 20 );
@@ -1558,7 +1609,9 @@ C_ASSERT( FIELD_OFFSET(struct get_message_request, get_last) == 24 );
 C_ASSERT( FIELD_OFFSET(struct get_message_request, hw_id) == 28 );
 C_ASSERT( FIELD_OFFSET(struct get_message_request, wake_mask) == 32 );
 C_ASSERT( FIELD_OFFSET(struct get_message_request, changed_mask) == 36 );
-C_ASSERT( sizeof(struct get_message_request) == 40 );
+C_ASSERT( FIELD_OFFSET(struct get_message_request, reply) == 40 );
+C_ASSERT( FIELD_OFFSET(struct get_message_request, result) == 48 );
+C_ASSERT( sizeof(struct get_message_request) == 56 );
 C_ASSERT( FIELD_OFFSET(struct get_message_reply, win) == 8 );
 C_ASSERT( FIELD_OFFSET(struct get_message_reply, msg) == 12 );
 C_ASSERT( FIELD_OFFSET(struct get_message_reply, wparam) == 16 );
@@ -1698,6 +1751,9 @@ C_ASSERT( FIELD_OFFSET(struct get_window_info_reply, tid) == 20 );
 C_ASSERT( FIELD_OFFSET(struct get_window_info_reply, atom) == 24 );
 C_ASSERT( FIELD_OFFSET(struct get_window_info_reply, is_unicode) == 28 );
 C_ASSERT( sizeof(struct get_window_info_reply) == 32 );
+C_ASSERT( sizeof(struct get_window_shm_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_window_shm_reply, handle) == 8 );
+C_ASSERT( sizeof(struct get_window_shm_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct set_window_info_request, flags) == 12 );
 C_ASSERT( FIELD_OFFSET(struct set_window_info_request, is_unicode) == 14 );
 C_ASSERT( FIELD_OFFSET(struct set_window_info_request, handle) == 16 );
@@ -2271,7 +2327,9 @@ C_ASSERT( sizeof(struct delete_device_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_next_device_request_request, manager) == 12 );
 C_ASSERT( FIELD_OFFSET(struct get_next_device_request_request, prev) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_next_device_request_request, status) == 20 );
-C_ASSERT( sizeof(struct get_next_device_request_request) == 24 );
+C_ASSERT( FIELD_OFFSET(struct get_next_device_request_request, result) == 24 );
+C_ASSERT( FIELD_OFFSET(struct get_next_device_request_request, file_ptr) == 32 );
+C_ASSERT( sizeof(struct get_next_device_request_request) == 40 );
 C_ASSERT( FIELD_OFFSET(struct get_next_device_request_reply, params) == 8 );
 C_ASSERT( FIELD_OFFSET(struct get_next_device_request_reply, next) == 32 );
 C_ASSERT( FIELD_OFFSET(struct get_next_device_request_reply, client_pid) == 36 );
@@ -2315,6 +2373,10 @@ C_ASSERT( FIELD_OFFSET(struct remove_completion_reply, cvalue) == 16 );
 C_ASSERT( FIELD_OFFSET(struct remove_completion_reply, information) == 24 );
 C_ASSERT( FIELD_OFFSET(struct remove_completion_reply, status) == 32 );
 C_ASSERT( sizeof(struct remove_completion_reply) == 40 );
+C_ASSERT( FIELD_OFFSET(struct remove_completions_request, handle) == 12 );
+C_ASSERT( sizeof(struct remove_completions_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct remove_completions_reply, count) == 8 );
+C_ASSERT( sizeof(struct remove_completions_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct query_completion_request, handle) == 12 );
 C_ASSERT( sizeof(struct query_completion_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct query_completion_reply, depth) == 8 );
@@ -2327,7 +2389,13 @@ C_ASSERT( FIELD_OFFSET(struct add_fd_completion_request, handle) == 12 );
 C_ASSERT( FIELD_OFFSET(struct add_fd_completion_request, cvalue) == 16 );
 C_ASSERT( FIELD_OFFSET(struct add_fd_completion_request, information) == 24 );
 C_ASSERT( FIELD_OFFSET(struct add_fd_completion_request, status) == 32 );
+C_ASSERT( FIELD_OFFSET(struct add_fd_completion_request, async) == 36 );
 C_ASSERT( sizeof(struct add_fd_completion_request) == 40 );
+C_ASSERT( FIELD_OFFSET(struct set_fd_completion_mode_request, handle) == 12 );
+C_ASSERT( FIELD_OFFSET(struct set_fd_completion_mode_request, flags) == 16 );
+C_ASSERT( sizeof(struct set_fd_completion_mode_request) == 24 );
+C_ASSERT( FIELD_OFFSET(struct set_fd_completion_mode_reply, flags) == 8 );
+C_ASSERT( sizeof(struct set_fd_completion_mode_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct set_fd_disp_info_request, handle) == 12 );
 C_ASSERT( FIELD_OFFSET(struct set_fd_disp_info_request, unlink) == 16 );
 C_ASSERT( sizeof(struct set_fd_disp_info_request) == 24 );
@@ -675,6 +675,8 @@ static struct object *create_socket( int family, int type, int protocol, unsigne
         close( sockfd );
         return NULL;
     }
+    /* registered I/O is built on overlapped requests */
+    if (flags & WSA_FLAG_REGISTERED_IO) flags |= WSA_FLAG_OVERLAPPED;
     init_sock( sock );
     sock->state  = (type != SOCK_STREAM) ? (FD_READ|FD_WRITE) : 0;
     sock->flags  = flags;
@@ -200,6 +200,7 @@ static inline void init_thread_structure( struct thread *thread )
     thread->state           = RUNNING;
     thread->exit_code       = 0;
     thread->priority        = 0;
+    thread->ideal_processor = 0;
     thread->suspend         = 0;
     thread->desktop_users   = 0;
     thread->token           = NULL;
@@ -530,6 +531,8 @@ static void set_thread_info( struct thread *thread,
         security_set_thread_token( thread, req->token );
     if (req->mask & SET_THREAD_INFO_ENTRYPOINT)
         thread->entry_point = req->entry_point;
+    if (req->mask & SET_THREAD_INFO_IDEAL)
+        thread->ideal_processor = req->ideal_processor;
 }
 
 /* stop a thread (at the Unix level) */
@@ -1459,6 +1462,7 @@ DECL_HANDLER(set_thread_info)
 
     if ((thread = get_thread_from_handle( req->handle, THREAD_SET_INFORMATION )))
     {
+        reply->prev_ideal = thread->ideal_processor;
         set_thread_info( thread, req );
         release_object( thread );
     }
@@ -43,6 +43,7 @@
 
 #define MAX_SUBAUTH_COUNT 1
 
+const LUID SeLockMemoryPrivilege           = {  4, 0 };
 const LUID SeIncreaseQuotaPrivilege        = {  5, 0 };
 const LUID SeSecurityPrivilege             = {  8, 0 };
 const LUID SeTakeOwnershipPrivilege        = {  9, 0 };
@@ -797,6 +798,7 @@ struct token *token_create_admin( void )
         {
             { SeChangeNotifyPrivilege        , SE_PRIVILEGE_ENABLED },
             { SeSecurityPrivilege            , 0                    },
+            { SeLockMemoryPrivilege          , 0                    },
             { SeBackupPrivilege              , 0                    },
             { SeRestorePrivilege             , 0                    },
             { SeSystemtimePrivilege          , 0                    },
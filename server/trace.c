@@ -171,9 +171,9 @@ static void dump_apc_call( const char *prefix, const apc_call_t *call )
     case APC_VIRTUAL_ALLOC:
         dump_uint64( "APC_VIRTUAL_ALLOC,addr==", &call->virtual_alloc.addr );
         dump_uint64( ",size=", &call->virtual_alloc.size );
-        fprintf( stderr, ",zero_bits=%u,op_type=%x,prot=%x",
+        fprintf( stderr, ",zero_bits=%u,op_type=%x,prot=%x,node=%d",
                  call->virtual_alloc.zero_bits, call->virtual_alloc.op_type,
-                 call->virtual_alloc.prot );
+                 call->virtual_alloc.prot, call->virtual_alloc.node );
         break;
     case APC_VIRTUAL_FREE:
         dump_uint64( "APC_VIRTUAL_FREE,addr=", &call->virtual_free.addr );
@@ -870,6 +870,82 @@ static void dump_varargs_rectangles( const char *prefix, data_size_t size )
     remove_data( size );
 }
 
+static void dump_varargs_hw_inputs( const char *prefix, data_size_t size )
+{
+    const hw_input_entry_t *entry = cur_data;
+    data_size_t len = size / sizeof(*entry);
+
+    fprintf( stderr,"%s{", prefix );
+    while (len > 0)
+    {
+        fprintf( stderr, "{win=%08x", entry->win );
+        dump_hw_input( ",input=", &entry->input );
+        fputc( '}', stderr );
+        entry++;
+        if (--len) fputc( ',', stderr );
+    }
+    fputc( '}', stderr );
+    remove_data( size );
+}
+
+static void dump_varargs_process_info( const char *prefix, data_size_t size )
+{
+    data_size_t pos = 0;
+    unsigned int i;
+
+    fprintf( stderr,"%s{", prefix );
+    while (size - pos >= sizeof(process_info_t))
+    {
+        process_info_t process;
+        thread_info_t thread;
+
+        memcpy( &process, (const char *)cur_data + pos, sizeof(process) );
+        fprintf( stderr, "{pid=%04x,parent_pid=%04x,unix_pid=%d,priority=%d,handles=%d",
+                 process.pid, process.parent_pid, process.unix_pid, process.priority,
+                 process.handle_count );
+        dump_timeout( ",start_time=", &process.start_time );
+        dump_uint64( ",working_set=", &process.working_set_size );
+        pos += sizeof(process);
+        if (size - pos < process.name_len) break;
+        fprintf( stderr, ",name=L\"" );
+        dump_strW( (const WCHAR *)((const char *)cur_data + pos), process.name_len / sizeof(WCHAR),
+                   stderr, "\"\"" );
+        fprintf( stderr, "\",threads={" );
+        pos += (process.name_len + 7) & ~7;
+        for (i = 0; i < process.thread_count && size - pos >= sizeof(thread); i++)
+        {
+            memcpy( &thread, (const char *)cur_data + pos, sizeof(thread) );
+            fprintf( stderr, "%s{tid=%04x,base_priority=%d,current_priority=%d,unix_tid=%d}",
+                     i ? "," : "", thread.tid, thread.base_priority, thread.current_priority,
+                     thread.unix_tid );
+            pos += sizeof(thread);
+        }
+        fprintf( stderr, "}}" );
+        if (size - pos >= sizeof(process_info_t)) fputc( ',', stderr );
+    }
+    fputc( '}', stderr );
+    remove_data( size );
+}
+
+static void dump_varargs_completion_msgs( const char *prefix, data_size_t size )
+{
+    const completion_msg_t *msg = cur_data;
+    data_size_t len = size / sizeof(*msg);
+
+    fprintf( stderr,"%s{", prefix );
+    while (len > 0)
+    {
+        dump_uint64( "{ckey=", &msg->ckey );
+        dump_uint64( ",cvalue=", &msg->cvalue );
+        dump_uint64( ",information=", &msg->information );
+        fprintf( stderr, ",status=%08x}", msg->status );
+        msg++;
+        if (--len) fputc( ',', stderr );
+    }
+    fputc( '}', stderr );
+    remove_data( size );
+}
+
 static void dump_varargs_message_data( const char *prefix, data_size_t size )
 {
     /* FIXME: dump the structured data */
@@ -1425,6 +1501,12 @@ static void dump_set_thread_info_request( const struct set_thread_info_request *
     dump_uint64( ", affinity=", &req->affinity );
     dump_uint64( ", entry_point=", &req->entry_point );
     fprintf( stderr, ", token=%04x", req->token );
+    fprintf( stderr, ", ideal_processor=%d", req->ideal_processor );
+}
+
+static void dump_set_thread_info_reply( const struct set_thread_info_reply *req )
+{
+    fprintf( stderr, " prev_ideal=%d", req->prev_ideal );
 }
 
 static void dump_get_dll_info_request( const struct get_dll_info_request *req )
@@ -1798,6 +1880,7 @@ static void dump_get_handle_fd_reply( const struct get_handle_fd_reply *req )
     fprintf( stderr, ", cacheable=%d", req->cacheable );
     fprintf( stderr, ", access=%08x", req->access );
     fprintf( stderr, ", options=%08x", req->options );
+    fprintf( stderr, ", comp_flags=%08x", req->comp_flags );
 }
 
 static void dump_get_directory_cache_entry_request( const struct get_directory_cache_entry_request *req )
@@ -2272,6 +2355,7 @@ static void dump_get_mapping_info_reply( const struct get_mapping_info_reply *re
     dump_uint64( " size=", &req->size );
     fprintf( stderr, ", flags=%08x", req->flags );
     fprintf( stderr, ", shared_file=%04x", req->shared_file );
+    fprintf( stderr, ", copy_file=%04x", req->copy_file );
     dump_varargs_pe_image_info( ", image=", cur_size );
 }
 
@@ -2325,6 +2409,17 @@ static void dump_create_snapshot_reply( const struct create_snapshot_reply *req
     fprintf( stderr, " handle=%04x", req->handle );
 }
 
+static void dump_list_processes_request( const struct list_processes_request *req )
+{
+}
+
+static void dump_list_processes_reply( const struct list_processes_reply *req )
+{
+    fprintf( stderr, " info_size=%u", req->info_size );
+    fprintf( stderr, ", process_count=%d", req->process_count );
+    dump_varargs_process_info( ", data=", min(cur_size,req->info_size) );
+}
+
 static void dump_next_process_request( const struct next_process_request *req )
 {
     fprintf( stderr, " handle=%04x", req->handle );
@@ -2437,6 +2532,17 @@ static void dump_read_process_memory_reply( const struct read_process_memory_rep
     dump_varargs_bytes( " data=", cur_size );
 }
 
+static void dump_get_process_vm_pid_request( const struct get_process_vm_pid_request *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+    fprintf( stderr, ", access=%08x", req->access );
+}
+
+static void dump_get_process_vm_pid_reply( const struct get_process_vm_pid_reply *req )
+{
+    fprintf( stderr, " unix_pid=%d", req->unix_pid );
+}
+
 static void dump_write_process_memory_request( const struct write_process_memory_request *req )
 {
     fprintf( stderr, " handle=%04x", req->handle );
@@ -2572,6 +2678,10 @@ static void dump_set_registry_notification_request( const struct set_registry_no
     fprintf( stderr, ", filter=%08x", req->filter );
 }
 
+static void dump_get_registry_generation_request( const struct get_registry_generation_request *req )
+{
+}
+
 static void dump_create_timer_request( const struct create_timer_request *req )
 {
     fprintf( stderr, " access=%08x", req->access );
@@ -2725,6 +2835,10 @@ static void dump_empty_atom_table_request( const struct empty_atom_table_request
     fprintf( stderr, ", if_pinned=%d", req->if_pinned );
 }
 
+static void dump_get_atom_generation_request( const struct get_atom_generation_request *req )
+{
+}
+
 static void dump_init_atom_table_request( const struct init_atom_table_request *req )
 {
     fprintf( stderr, " entries=%d", req->entries );
@@ -2773,6 +2887,15 @@ static void dump_get_queue_status_reply( const struct get_queue_status_reply *re
     fprintf( stderr, ", changed_bits=%08x", req->changed_bits );
 }
 
+static void dump_get_queue_shm_request( const struct get_queue_shm_request *req )
+{
+}
+
+static void dump_get_queue_shm_reply( const struct get_queue_shm_reply *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+}
+
 static void dump_get_process_idle_event_request( const struct get_process_idle_event_request *req )
 {
     fprintf( stderr, " handle=%04x", req->handle );
@@ -2793,6 +2916,7 @@ static void dump_send_message_request( const struct send_message_request *req )
     dump_uint64( ", wparam=", &req->wparam );
     dump_uint64( ", lparam=", &req->lparam );
     dump_timeout( ", timeout=", &req->timeout );
+    fprintf( stderr, ", wake_mask=%08x", req->wake_mask );
     dump_varargs_message_data( ", data=", cur_size );
 }
 
@@ -2818,6 +2942,23 @@ static void dump_send_hardware_message_reply( const struct send_hardware_message
     dump_varargs_bytes( ", keystate=", cur_size );
 }
 
+static void dump_send_hardware_messages_request( const struct send_hardware_messages_request *req )
+{
+    fprintf( stderr, " flags=%08x", req->flags );
+    dump_varargs_hw_inputs( ", inputs=", cur_size );
+}
+
+static void dump_send_hardware_messages_reply( const struct send_hardware_messages_reply *req )
+{
+    fprintf( stderr, " count=%08x", req->count );
+    fprintf( stderr, ", wait=%d", req->wait );
+    fprintf( stderr, ", prev_x=%d", req->prev_x );
+    fprintf( stderr, ", prev_y=%d", req->prev_y );
+    fprintf( stderr, ", new_x=%d", req->new_x );
+    fprintf( stderr, ", new_y=%d", req->new_y );
+    dump_varargs_bytes( ", keystate=", cur_size );
+}
+
 static void dump_get_message_request( const struct get_message_request *req )
 {
     fprintf( stderr, " flags=%08x", req->flags );
@@ -2827,6 +2968,9 @@ static void dump_get_message_request( const struct get_message_request *req )
     fprintf( stderr, ", hw_id=%08x", req->hw_id );
     fprintf( stderr, ", wake_mask=%08x", req->wake_mask );
     fprintf( stderr, ", changed_mask=%08x", req->changed_mask );
+    fprintf( stderr, ", reply=%d", req->reply );
+    dump_uint64( ", result=", &req->result );
+    dump_varargs_bytes( ", reply_data=", cur_size );
 }
 
 static void dump_get_message_reply( const struct get_message_reply *req )
@@ -3093,6 +3237,15 @@ static void dump_get_window_info_reply( const struct get_window_info_reply *req
     fprintf( stderr, ", is_unicode=%d", req->is_unicode );
 }
 
+static void dump_get_window_shm_request( const struct get_window_shm_request *req )
+{
+}
+
+static void dump_get_window_shm_reply( const struct get_window_shm_reply *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+}
+
 static void dump_set_window_info_request( const struct set_window_info_request *req )
 {
     fprintf( stderr, " flags=%04x", req->flags );
@@ -4266,6 +4419,9 @@ static void dump_get_next_device_request_request( const struct get_next_device_r
     fprintf( stderr, " manager=%04x", req->manager );
     fprintf( stderr, ", prev=%04x", req->prev );
     fprintf( stderr, ", status=%08x", req->status );
+    fprintf( stderr, ", result=%u", req->result );
+    dump_uint64( ", file_ptr=", &req->file_ptr );
+    dump_varargs_bytes( ", prev_data=", cur_size );
 }
 
 static void dump_get_next_device_request_reply( const struct get_next_device_request_reply *req )
@@ -4350,6 +4506,17 @@ static void dump_remove_completion_reply( const struct remove_completion_reply *
     fprintf( stderr, ", status=%08x", req->status );
 }
 
+static void dump_remove_completions_request( const struct remove_completions_request *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+}
+
+static void dump_remove_completions_reply( const struct remove_completions_reply *req )
+{
+    fprintf( stderr, " count=%08x", req->count );
+    dump_varargs_completion_msgs( ", msgs=", cur_size );
+}
+
 static void dump_query_completion_request( const struct query_completion_request *req )
 {
     fprintf( stderr, " handle=%04x", req->handle );
@@ -4373,6 +4540,18 @@ static void dump_add_fd_completion_request( const struct add_fd_completion_reque
     dump_uint64( ", cvalue=", &req->cvalue );
     dump_uint64( ", information=", &req->information );
     fprintf( stderr, ", status=%08x", req->status );
+    fprintf( stderr, ", async=%d", req->async );
+}
+
+static void dump_set_fd_completion_mode_request( const struct set_fd_completion_mode_request *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+    fprintf( stderr, ", flags=%08x", req->flags );
+}
+
+static void dump_set_fd_completion_mode_reply( const struct set_fd_completion_mode_reply *req )
+{
+    fprintf( stderr, " flags=%08x", req->flags );
 }
 
 static void dump_set_fd_disp_info_request( const struct set_fd_disp_info_request *req )
@@ -4660,6 +4839,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_add_mapping_committed_range_request,
     (dump_func)dump_is_same_mapping_request,
     (dump_func)dump_create_snapshot_request,
+    (dump_func)dump_list_processes_request,
     (dump_func)dump_next_process_request,
     (dump_func)dump_next_thread_request,
     (dump_func)dump_wait_debug_event_request,
@@ -4670,6 +4850,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_debug_break_request,
     (dump_func)dump_set_debugger_kill_on_exit_request,
     (dump_func)dump_read_process_memory_request,
+    (dump_func)dump_get_process_vm_pid_request,
     (dump_func)dump_write_process_memory_request,
     (dump_func)dump_create_key_request,
     (dump_func)dump_open_key_request,
@@ -4684,6 +4865,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_unload_registry_request,
     (dump_func)dump_save_registry_request,
     (dump_func)dump_set_registry_notification_request,
+    (dump_func)dump_get_registry_generation_request,
     (dump_func)dump_create_timer_request,
     (dump_func)dump_open_timer_request,
     (dump_func)dump_set_timer_request,
@@ -4698,15 +4880,18 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_get_atom_information_request,
     (dump_func)dump_set_atom_information_request,
     (dump_func)dump_empty_atom_table_request,
+    (dump_func)dump_get_atom_generation_request,
     (dump_func)dump_init_atom_table_request,
     (dump_func)dump_get_msg_queue_request,
     (dump_func)dump_set_queue_fd_request,
     (dump_func)dump_set_queue_mask_request,
     (dump_func)dump_get_queue_status_request,
+    (dump_func)dump_get_queue_shm_request,
     (dump_func)dump_get_process_idle_event_request,
     (dump_func)dump_send_message_request,
     (dump_func)dump_post_quit_message_request,
     (dump_func)dump_send_hardware_message_request,
+    (dump_func)dump_send_hardware_messages_request,
     (dump_func)dump_get_message_request,
     (dump_func)dump_reply_message_request,
     (dump_func)dump_accept_hardware_message_request,
@@ -4731,6 +4916,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_get_desktop_window_request,
     (dump_func)dump_set_window_owner_request,
     (dump_func)dump_get_window_info_request,
+    (dump_func)dump_get_window_shm_request,
     (dump_func)dump_set_window_info_request,
     (dump_func)dump_set_parent_request,
     (dump_func)dump_get_window_parents_request,
@@ -4837,9 +5023,11 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_open_completion_request,
     (dump_func)dump_add_completion_request,
     (dump_func)dump_remove_completion_request,
+    (dump_func)dump_remove_completions_request,
     (dump_func)dump_query_completion_request,
     (dump_func)dump_set_completion_info_request,
     (dump_func)dump_add_fd_completion_request,
+    (dump_func)dump_set_fd_completion_mode_request,
     (dump_func)dump_set_fd_disp_info_request,
     (dump_func)dump_set_fd_name_info_request,
     (dump_func)dump_get_window_layered_info_request,
@@ -4877,7 +5065,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     NULL,
     (dump_func)dump_get_thread_info_reply,
     (dump_func)dump_get_thread_times_reply,
-    NULL,
+    (dump_func)dump_set_thread_info_reply,
     (dump_func)dump_get_dll_info_reply,
     (dump_func)dump_suspend_thread_reply,
     (dump_func)dump_resume_thread_reply,
@@ -4956,6 +5144,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     NULL,
     NULL,
     (dump_func)dump_create_snapshot_reply,
+    (dump_func)dump_list_processes_reply,
     (dump_func)dump_next_process_reply,
     (dump_func)dump_next_thread_reply,
     (dump_func)dump_wait_debug_event_reply,
@@ -4966,6 +5155,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_debug_break_reply,
     NULL,
     (dump_func)dump_read_process_memory_reply,
+    (dump_func)dump_get_process_vm_pid_reply,
     NULL,
     (dump_func)dump_create_key_reply,
     (dump_func)dump_open_key_reply,
@@ -4980,6 +5170,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     NULL,
     NULL,
     NULL,
+    NULL,
     (dump_func)dump_create_timer_reply,
     (dump_func)dump_open_timer_reply,
     (dump_func)dump_set_timer_reply,
@@ -4994,15 +5185,18 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_get_atom_information_reply,
     NULL,
     NULL,
+    NULL,
     (dump_func)dump_init_atom_table_reply,
     (dump_func)dump_get_msg_queue_reply,
     NULL,
     (dump_func)dump_set_queue_mask_reply,
     (dump_func)dump_get_queue_status_reply,
+    (dump_func)dump_get_queue_shm_reply,
     (dump_func)dump_get_process_idle_event_reply,
     NULL,
     NULL,
     (dump_func)dump_send_hardware_message_reply,
+    (dump_func)dump_send_hardware_messages_reply,
     (dump_func)dump_get_message_reply,
     NULL,
     NULL,
@@ -5027,6 +5221,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_get_desktop_window_reply,
     (dump_func)dump_set_window_owner_reply,
     (dump_func)dump_get_window_info_reply,
+    (dump_func)dump_get_window_shm_reply,
     (dump_func)dump_set_window_info_reply,
     (dump_func)dump_set_parent_reply,
     (dump_func)dump_get_window_parents_reply,
@@ -5133,9 +5328,11 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_open_completion_reply,
     NULL,
     (dump_func)dump_remove_completion_reply,
+    (dump_func)dump_remove_completions_reply,
     (dump_func)dump_query_completion_reply,
     NULL,
     NULL,
+    (dump_func)dump_set_fd_completion_mode_reply,
     NULL,
     NULL,
     (dump_func)dump_get_window_layered_info_reply,
@@ -5252,6 +5449,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "add_mapping_committed_range",
     "is_same_mapping",
     "create_snapshot",
+    "list_processes",
     "next_process",
     "next_thread",
     "wait_debug_event",
@@ -5262,6 +5460,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "debug_break",
     "set_debugger_kill_on_exit",
     "read_process_memory",
+    "get_process_vm_pid",
     "write_process_memory",
     "create_key",
     "open_key",
@@ -5276,6 +5475,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "unload_registry",
     "save_registry",
     "set_registry_notification",
+    "get_registry_generation",
     "create_timer",
     "open_timer",
     "set_timer",
@@ -5290,15 +5490,18 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "get_atom_information",
     "set_atom_information",
     "empty_atom_table",
+    "get_atom_generation",
     "init_atom_table",
     "get_msg_queue",
     "set_queue_fd",
     "set_queue_mask",
     "get_queue_status",
+    "get_queue_shm",
     "get_process_idle_event",
     "send_message",
     "post_quit_message",
     "send_hardware_message",
+    "send_hardware_messages",
     "get_message",
     "reply_message",
     "accept_hardware_message",
@@ -5323,6 +5526,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "get_desktop_window",
     "set_window_owner",
     "get_window_info",
+    "get_window_shm",
     "set_window_info",
     "set_parent",
     "get_window_parents",
@@ -5429,9 +5633,11 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "open_completion",
     "add_completion",
     "remove_completion",
+    "remove_completions",
     "query_completion",
     "set_completion_info",
     "add_fd_completion",
+    "set_fd_completion_mode",
     "set_fd_disp_info",
     "set_fd_name_info",
     "get_window_layered_info",
@@ -5520,6 +5726,7 @@ static const struct
     { "INVALID_LOCK_SEQUENCE",       STATUS_INVALID_LOCK_SEQUENCE },
     { "INVALID_OWNER",               STATUS_INVALID_OWNER },
     { "INVALID_PARAMETER",           STATUS_INVALID_PARAMETER },
+    { "INVALID_PARAMETER_4",         STATUS_INVALID_PARAMETER_4 },
     { "INVALID_READ_MODE",           STATUS_INVALID_READ_MODE },
     { "INVALID_SECURITY_DESCR",      STATUS_INVALID_SECURITY_DESCR },
     { "IO_TIMEOUT",                  STATUS_IO_TIMEOUT },
@@ -5598,6 +5805,12 @@ static const char *get_status_name( unsigned int status )
     return buffer;
 }
 
+const char *get_request_name( enum request req )
+{
+    if (req < REQ_NB_REQUESTS) return req_names[req];
+    return "?";
+}
+
 void trace_request(void)
 {
     enum request req = current->req.request_header.req;
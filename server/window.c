@@ -23,6 +23,9 @@
 
 #include <assert.h>
 #include <stdarg.h>
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -33,6 +36,8 @@
 #include "winternl.h"
 
 #include "object.h"
+#include "file.h"
+#include "handle.h"
 #include "request.h"
 #include "thread.h"
 #include "process.h"
@@ -124,6 +129,9 @@ static struct window *taskman_window;
 #define WINPTR_TOPMOST   ((struct window *)3L)
 #define WINPTR_NOTOPMOST ((struct window *)4L)
 
+static window_shm_t *window_shm;       /* window information shared with the clients */
+static struct file *window_shm_file;   /* file backing the shared window information */
+
 /* retrieve a pointer to a window from its handle */
 static inline struct window *get_window( user_handle_t handle )
 {
@@ -174,6 +182,62 @@ static inline void update_pixel_format_flags( struct window *win )
         win->paint_flags |= PAINT_PIXEL_FORMAT_CHILD;
 }
 
+/* create the shared window information; return 0 if not available */
+static int init_window_shm(void)
+{
+    static int failed;
+    const size_t size = WINDOW_SHM_ENTRIES * sizeof(*window_shm);
+    void *ptr;
+    int fd;
+
+    if (window_shm) return 1;
+    if (failed) return 0;
+    failed = 1;
+
+    if ((fd = create_temp_file( size )) == -1) goto error;
+    if ((ptr = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 )) == MAP_FAILED)
+    {
+        close( fd );
+        goto error;
+    }
+    if (!(window_shm_file = create_file_for_fd( fd, FILE_GENERIC_READ, FILE_SHARE_READ )))
+    {
+        munmap( ptr, size );
+        goto error;
+    }
+    make_object_static( (struct object *)window_shm_file );
+    window_shm = ptr;
+    return 1;
+
+error:
+    clear_error();  /* not a fatal error, the clients will ask us instead */
+    return 0;
+}
+
+/* publish the information of a window to the clients */
+static void update_window_shm( struct window *win, int destroyed )
+{
+    window_shm_t *entry;
+
+    if (!init_window_shm()) return;
+    entry = &window_shm[((win->handle & 0xffff) - FIRST_USER_HANDLE) >> 1];
+
+    interlocked_xchg_add( (int *)&entry->seq, 1 );
+    entry->handle    = destroyed ? 0 : win->handle;
+    entry->instance  = win->instance;
+    entry->user_data = win->user_data;
+    entry->parent    = win->parent ? win->parent->handle : 0;
+    entry->owner     = win->owner;
+    entry->pid       = win->thread ? get_process_id( win->thread->process ) : 0;
+    entry->tid       = win->thread ? get_thread_id( win->thread ) : 0;
+    entry->style     = win->style;
+    entry->ex_style  = win->ex_style;
+    entry->id        = win->id;
+    entry->window    = win->window_rect;
+    entry->client    = win->client_rect;
+    interlocked_xchg_add( (int *)&entry->seq, 1 );
+}
+
 /* link a window at the right place in the siblings list */
 static void link_window( struct window *win, struct window *previous )
 {
@@ -227,6 +291,7 @@ static void link_window( struct window *win, struct window *previous )
     }
 
     win->is_linked = 1;
+    update_window_shm( win, 0 );
 }
 
 /* change the parent of a window (or unlink the window if the new parent is NULL) */
@@ -401,6 +466,7 @@ static void detach_window_thread( struct window *win )
     /* destroyed when the desktop ref count reaches zero */
     release_object( win->desktop );
     win->thread = NULL;
+    update_window_shm( win, 0 );
 }
 
 /* get the process owning the top window of a given desktop */
@@ -527,6 +593,7 @@ static struct window *create_window( struct window *parent, struct window *owner
     }
 
     current->desktop_users++;
+    update_window_shm( win, 0 );
     return win;
 
 failed:
@@ -1657,6 +1724,7 @@ static void set_window_pos( struct window *win, struct window *previous,
     if (!(swp_flags & SWP_NOZORDER) && win->parent) link_window( win, previous );
     if (swp_flags & SWP_SHOWWINDOW) win->style |= WS_VISIBLE;
     else if (swp_flags & SWP_HIDEWINDOW) win->style &= ~WS_VISIBLE;
+    update_window_shm( win, 0 );
 
     /* keep children at the same position relative to top right corner when the parent is mirrored */
     if (win->ex_style & WS_EX_LAYOUTRTL)
@@ -1856,6 +1924,7 @@ void destroy_window( struct window *win )
     if (win == taskman_window) taskman_window = NULL;
     free_hotkeys( win->desktop, win->handle );
     cleanup_clipboard_window( win->desktop, win->handle );
+    update_window_shm( win, 1 );
     free_user_handle( win->handle );
     destroy_properties( win );
     list_remove( &win->entry );
@@ -1967,6 +2036,7 @@ DECL_HANDLER(get_desktop_window)
         {
             detach_window_thread( desktop->top_window );
             desktop->top_window->style  = WS_POPUP | WS_VISIBLE | WS_CLIPSIBLINGS | WS_CLIPCHILDREN;
+            update_window_shm( desktop->top_window, 0 );
         }
     }
 
@@ -1979,6 +2049,7 @@ DECL_HANDLER(get_desktop_window)
         {
             detach_window_thread( desktop->msg_window );
             desktop->msg_window->style = WS_POPUP | WS_CLIPSIBLINGS | WS_CLIPCHILDREN;
+            update_window_shm( desktop->msg_window, 0 );
         }
     }
 
@@ -2014,6 +2085,7 @@ DECL_HANDLER(set_window_owner)
 
     reply->prev_owner = win->owner;
     reply->full_owner = win->owner = owner ? owner->handle : 0;
+    update_window_shm( win, 0 );
 }
 
 
@@ -2040,6 +2112,16 @@ DECL_HANDLER(get_window_info)
 }
 
 
+/* get a handle to the shared memory holding the window information */
+DECL_HANDLER(get_window_shm)
+{
+    if (init_window_shm())
+        reply->handle = alloc_handle( current->process, window_shm_file, FILE_GENERIC_READ, 0 );
+    else
+        set_error( STATUS_NOT_SUPPORTED );
+}
+
+
 /* set some information in a window */
 DECL_HANDLER(set_window_info)
 {
@@ -2089,6 +2171,7 @@ DECL_HANDLER(set_window_info)
 
     /* changing window style triggers a non-client paint */
     if (req->flags & SET_WIN_STYLE) win->paint_flags |= PAINT_NONCLIENT;
+    if (req->flags) update_window_shm( win, 0 );
 }
 
 
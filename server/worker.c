@@ -0,0 +1,276 @@
+/*
+ * Server-side worker threads
+ *
+ * Copyright (C) 2018 Wine project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/*
+ * The server state is not thread-safe, so all requests are still
+ * dispatched from the main loop.  Worker threads are only used to run
+ * blocking system calls (like fsync) that would otherwise stall every
+ * client; the work function must not touch any server object, and the
+ * completion callback is invoked back in the main loop once it's done.
+ */
+
+#include "config.h"
+#include "wine/port.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_POLL_H
+#include <poll.h>
+#endif
+#ifdef HAVE_SYS_POLL_H
+#include <sys/poll.h>
+#endif
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+#include <unistd.h>
+
+#include "wine/list.h"
+
+#include "file.h"
+#include "object.h"
+#include "request.h"
+
+#ifdef HAVE_PTHREAD_H
+
+#define MAX_WORKERS 16
+
+struct work_item
+{
+    struct list        entry;      /* entry in pending or done list */
+    work_callback      work;       /* function to run in the worker thread */
+    work_callback      done;       /* function to run in the main loop once finished */
+    void              *private;    /* callback private data */
+};
+
+struct worker_pool
+{
+    struct object      obj;        /* object header */
+    struct fd         *fd;         /* file descriptor for the pipe read side */
+    int                pipe_write; /* unix fd for the pipe write side */
+};
+
+static void worker_pool_dump( struct object *obj, int verbose );
+static void worker_pool_destroy( struct object *obj );
+
+static const struct object_ops worker_pool_ops =
+{
+    sizeof(struct worker_pool),   /* size */
+    worker_pool_dump,             /* dump */
+    no_get_type,                  /* get_type */
+    no_add_queue,                 /* add_queue */
+    NULL,                         /* remove_queue */
+    NULL,                         /* signaled */
+    NULL,                         /* get_esync_fd */
+    NULL,                         /* satisfied */
+    no_signal,                    /* signal */
+    no_get_fd,                    /* get_fd */
+    no_map_access,                /* map_access */
+    default_get_sd,               /* get_sd */
+    default_set_sd,               /* set_sd */
+    no_lookup_name,               /* lookup_name */
+    no_link_name,                 /* link_name */
+    NULL,                         /* unlink_name */
+    no_open_file,                 /* open_file */
+    no_close_handle,              /* close_handle */
+    worker_pool_destroy           /* destroy */
+};
+
+static void worker_pool_poll_event( struct fd *fd, int event );
+
+static const struct fd_ops worker_pool_fd_ops =
+{
+    NULL,                         /* get_poll_events */
+    worker_pool_poll_event,       /* poll_event */
+    NULL,                         /* flush */
+    NULL,                         /* get_fd_type */
+    NULL,                         /* ioctl */
+    NULL,                         /* queue_async */
+    NULL                          /* reselect_async */
+};
+
+static struct worker_pool *pool;
+static int max_workers = -1;       /* maximum number of worker threads, 0 if disabled */
+static int nb_workers;             /* number of running worker threads */
+static int idle_workers;           /* number of workers waiting for work */
+static struct list pending_list = LIST_INIT(pending_list);
+static struct list done_list = LIST_INIT(done_list);
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_cond = PTHREAD_COND_INITIALIZER;
+
+static void worker_pool_dump( struct object *obj, int verbose )
+{
+    fprintf( stderr, "Worker pool threads=%d idle=%d\n", nb_workers, idle_workers );
+}
+
+static void worker_pool_destroy( struct object *obj )
+{
+    struct worker_pool *pool = (struct worker_pool *)obj;
+    if (pool->fd) release_object( pool->fd );
+    close( pool->pipe_write );
+}
+
+/* run the completion callbacks of all finished work items */
+static void worker_pool_poll_event( struct fd *fd, int event )
+{
+    struct list list = LIST_INIT(list), *ptr;
+    char buffer[64];
+
+    if (event & (POLLERR | POLLHUP))
+    {
+        /* this is not supposed to happen */
+        fprintf( stderr, "wineserver: Error on worker pool pipe\n" );
+        set_fd_events( fd, -1 );
+        return;
+    }
+
+    read( get_unix_fd( fd ), buffer, sizeof(buffer) );
+
+    pthread_mutex_lock( &pool_mutex );
+    list_move_tail( &list, &done_list );
+    pthread_mutex_unlock( &pool_mutex );
+
+    while ((ptr = list_head( &list )))
+    {
+        struct work_item *item = LIST_ENTRY( ptr, struct work_item, entry );
+        list_remove( &item->entry );
+        item->done( item->private );
+        free( item );
+    }
+}
+
+static void *worker_thread( void *arg )
+{
+    struct work_item *item;
+    struct list *ptr;
+    sigset_t set;
+    char dummy = 0;
+
+    /* signals are handled by the main thread */
+    sigfillset( &set );
+    pthread_sigmask( SIG_BLOCK, &set, NULL );
+
+    pthread_mutex_lock( &pool_mutex );
+    for (;;)
+    {
+        while (!(ptr = list_head( &pending_list )))
+        {
+            idle_workers++;
+            pthread_cond_wait( &pool_cond, &pool_mutex );
+            idle_workers--;
+        }
+        item = LIST_ENTRY( ptr, struct work_item, entry );
+        list_remove( &item->entry );
+        pthread_mutex_unlock( &pool_mutex );
+
+        item->work( item->private );
+
+        pthread_mutex_lock( &pool_mutex );
+        if (list_empty( &done_list )) write( pool->pipe_write, &dummy, 1 );
+        list_add_tail( &done_list, &item->entry );
+    }
+    return NULL;
+}
+
+/* create the pool object; return 0 if worker threads are not available */
+static int init_worker_pool(void)
+{
+    const char *env;
+    int fd[2];
+
+    if (max_workers == -1)
+    {
+        max_workers = 0;
+        if ((env = getenv( "WINESERVER_WORKERS" ))) max_workers = atoi( env );
+        if (max_workers > MAX_WORKERS) max_workers = MAX_WORKERS;
+        if (max_workers < 0) max_workers = 0;
+    }
+    if (!max_workers) return 0;
+    if (pool) return 1;
+
+    if (pipe( fd ) == -1) goto failed;
+    fcntl( fd[0], F_SETFL, O_NONBLOCK );
+    if (!(pool = alloc_object( &worker_pool_ops )))
+    {
+        close( fd[0] );
+        close( fd[1] );
+        goto failed;
+    }
+    pool->pipe_write = fd[1];
+    if (!(pool->fd = create_anonymous_fd( &worker_pool_fd_ops, fd[0], &pool->obj, 0 )))
+    {
+        release_object( pool );
+        pool = NULL;
+        goto failed;
+    }
+    set_fd_events( pool->fd, POLLIN );
+    make_object_static( &pool->obj );
+    return 1;
+
+failed:
+    max_workers = 0;
+    return 0;
+}
+
+/* queue a work item to be run in a worker thread, return 0 if the caller should run it itself */
+int queue_worker_item( work_callback work, work_callback done, void *private )
+{
+    struct work_item *item;
+    pthread_t thread;
+
+    if (!init_worker_pool()) return 0;
+    if (!(item = malloc( sizeof(*item) ))) return 0;
+    item->work    = work;
+    item->done    = done;
+    item->private = private;
+
+    pthread_mutex_lock( &pool_mutex );
+    if (idle_workers <= (int)list_count( &pending_list ) && nb_workers < max_workers)
+    {
+        if (!pthread_create( &thread, NULL, worker_thread, NULL ))
+        {
+            pthread_detach( thread );
+            nb_workers++;
+        }
+    }
+    if (!nb_workers)
+    {
+        pthread_mutex_unlock( &pool_mutex );
+        free( item );
+        return 0;
+    }
+    list_add_tail( &pending_list, &item->entry );
+    pthread_cond_signal( &pool_cond );
+    pthread_mutex_unlock( &pool_mutex );
+    return 1;
+}
+
+#else  /* HAVE_PTHREAD_H */
+
+int queue_worker_item( work_callback work, work_callback done, void *private )
+{
+    return 0;
+}
+
+#endif  /* HAVE_PTHREAD_H */